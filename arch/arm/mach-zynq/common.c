@@ -137,6 +137,11 @@ static void __init zynq_init_machine(void)
 	 */
 	of_platform_default_populate(NULL, NULL, parent);
 
+#if defined(CONFIG_SMP) && defined(CONFIG_ARM_CPU_SUSPEND)
+	/* Restarting CPU1 from idle can't ioremap the trampoline at 0x0 */
+	if (!__pa(PAGE_OFFSET))
+		zynq_cpuidle_device.dev.platform_data = &zynq_cpuidle_data;
+#endif
 	platform_device_register(&zynq_cpuidle_device);
 }
 
@@ -26,6 +26,9 @@ extern char zynq_secondary_trampoline_jump;
 extern char zynq_secondary_trampoline_end;
 extern int zynq_cpun_start(u32 address, int cpu);
 extern const struct smp_operations zynq_smp_ops;
+#ifdef CONFIG_ARM_CPU_SUSPEND
+extern struct cpuidle_zynq_data zynq_cpuidle_data;
+#endif
 #endif
 
 extern void zynq_slcr_init_preload_fpga(void);
@@ -10,13 +10,16 @@
  * Copyright (C) 2002 ARM Ltd.
  */
 
+#include <linux/cpu_pm.h>
 #include <linux/export.h>
 #include <linux/jiffies.h>
 #include <linux/init.h>
 #include <linux/io.h>
+#include <linux/platform_data/cpuidle-zynq.h>
 #include <asm/cacheflush.h>
 #include <asm/smp_plat.h>
 #include <asm/smp_scu.h>
+#include <asm/suspend.h>
 #include <linux/irqchip/arm-gic.h>
 #include "common.h"
 
@@ -154,6 +157,71 @@ static void zynq_cpu_die(unsigned int cpu)
 }
 #endif
 
+#ifdef CONFIG_ARM_CPU_SUSPEND
+static int zynq_cpu1_finisher(unsigned long arg)
+{
+	/* Leave coherency with clean caches and let CPU0 reset us */
+	v7_exit_coherency_flush(louis);
+	zynq_slcr_cpu_state_write(1, true);
+
+	for (;;)
+		cpu_do_idle();
+
+	return 1;
+}
+
+/**
+ * zynq_cpu1_powerdown - Save CPU1 context and wait for CPU0 to reset it
+ *
+ * Called on CPU1 with IRQs disabled from the coupled cpuidle state. The
+ * core is reset and clock stopped through the SLCR, which is as close to
+ * powered down as it gets on this platform.
+ *
+ * Return: 0 once CPU1 has been restarted and has resumed its context
+ */
+static int zynq_cpu1_powerdown(void)
+{
+	int ret;
+
+	cpu_pm_enter();
+	ret = cpu_suspend(0, zynq_cpu1_finisher);
+	/* The reset cleared the A9 power control register */
+	zynq_core_pm_init();
+	cpu_pm_exit();
+
+	return ret;
+}
+
+/**
+ * zynq_cpu0_enter - Put CPU1 into reset and idle CPU0
+ *
+ * Called on CPU0 with IRQs disabled from the coupled cpuidle state. CPU1 is
+ * restarted into cpu_resume once CPU0 is woken up.
+ *
+ * Return: 0 on success, negative errno otherwise
+ */
+static int zynq_cpu0_enter(void)
+{
+	/* CPU1 flags itself as going to die once its caches are clean */
+	while (zynq_slcr_cpu_state_read(1))
+		cpu_relax();
+
+	zynq_slcr_cpu_stop(cpu_logical_map(1));
+
+	cpu_do_idle();
+
+	if (zynq_cpun_start(__pa_symbol(cpu_resume_arm), 1))
+		return -EIO;
+
+	return 0;
+}
+
+struct cpuidle_zynq_data zynq_cpuidle_data = {
+	.cpu1_powerdown	= zynq_cpu1_powerdown,
+	.cpu0_enter	= zynq_cpu0_enter,
+};
+#endif
+
 const struct smp_operations zynq_smp_ops __initconst = {
 	.smp_init_cpus		= zynq_smp_init_cpus,
 	.smp_prepare_cpus	= zynq_smp_prepare_cpus,
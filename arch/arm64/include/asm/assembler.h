@@ -547,6 +547,16 @@ alternative_endif
 	b.ne	9998b
 	.endm
 
+/*
+ * copy_prefetch_src - prefetch the source of a large copy ahead of the
+ * loads on CPUs whose hardware prefetcher falls behind, nop otherwise
+ */
+	.macro	copy_prefetch_src, src:req
+alternative_cb ARM64_ALWAYS_SYSTEM, arm64_patch_copy_prefetch
+	mov	\src, \src
+alternative_cb_end
+	.endm
+
 /*
  * Annotate a function as being unsuitable for kprobes.
  */
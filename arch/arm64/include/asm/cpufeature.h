@@ -917,6 +917,10 @@ extern struct arm64_ftr_override id_aa64isar2_override;
 u32 get_kvm_ipa_limit(void);
 void dump_cpu_features(void);
 
+struct alt_instr;
+void arm64_patch_copy_prefetch(struct alt_instr *alt, __le32 *origptr,
+			       __le32 *updptr, int nr_inst);
+
 #endif /* __ASSEMBLY__ */
 
 #endif
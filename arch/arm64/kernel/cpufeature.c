@@ -1520,6 +1520,50 @@ static bool has_no_hw_prefetch(const struct arm64_cpu_capabilities *entry, int _
 		MIDR_CPU_VAR_REV(1, MIDR_REVISION_MASK));
 }
 
+/*
+ * The hardware prefetchers of the in-order cores don't run far enough ahead
+ * of a streaming copy, the copy loops prefetch the source themselves there.
+ */
+static const struct midr_range copy_prefetch_cpus[] = {
+	MIDR_ALL_VERSIONS(MIDR_CORTEX_A53),
+	MIDR_ALL_VERSIONS(MIDR_CORTEX_A55),
+	{},
+};
+
+/* Bytes ahead of the current source pointer, a multiple of 8 below 32K */
+#define COPY_PREFETCH_DIST	256
+
+/*
+ * Patches the "mov reg, reg" of copy_prefetch_src into a streaming prefetch
+ * of [reg, #COPY_PREFETCH_DIST] when all the CPUs up at boot are listed in
+ * copy_prefetch_cpus. A CPU brought up later only misses the tuning.
+ */
+void noinstr arm64_patch_copy_prefetch(struct alt_instr *alt,
+				       __le32 *origptr, __le32 *updptr,
+				       int nr_inst)
+{
+	enum aarch64_insn_register reg;
+	int cpu;
+	u32 insn;
+
+	BUG_ON(nr_inst != 1);
+
+	for_each_online_cpu(cpu) {
+		if (!is_midr_in_range_list(per_cpu(cpu_data, cpu).reg_midr,
+					   copy_prefetch_cpus))
+			return;
+	}
+
+	insn = le32_to_cpu(*origptr);
+	reg = aarch64_insn_decode_register(AARCH64_INSN_REGTYPE_RD, insn);
+	insn = aarch64_insn_gen_prefetch(reg, AARCH64_INSN_PRFM_TYPE_PLD,
+					 AARCH64_INSN_PRFM_TARGET_L1,
+					 AARCH64_INSN_PRFM_POLICY_STRM);
+	insn = aarch64_insn_encode_immediate(AARCH64_INSN_IMM_12, insn,
+					     COPY_PREFETCH_DIST >> 3);
+	*updptr = cpu_to_le32(insn);
+}
+
 static bool has_no_fpsimd(const struct arm64_cpu_capabilities *entry, int __unused)
 {
 	u64 pfr0 = read_sanitised_ftr_reg(SYS_ID_AA64PFR0_EL1);
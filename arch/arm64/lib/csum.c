@@ -4,6 +4,8 @@
 #include <linux/compiler.h>
 #include <linux/kasan-checks.h>
 #include <linux/kernel.h>
+#include <linux/string.h>
+#include <linux/uaccess.h>
 
 #include <net/checksum.h>
 
@@ -129,6 +131,115 @@ unsigned int __no_sanitize_address do_csum(const unsigned char *buff, int len)
 	return sum >> 16;
 }
 
+/*
+ * Add @len bytes at @src to @sum and store them at @dst if @copy. The words
+ * are counted from @src rather than from an aligned address, which keeps
+ * the sum independent of the alignment of either buffer, and the loads are
+ * exact so that no byte is read or written out of bounds.
+ */
+static __always_inline u64 csum_copy(const u8 *src, u8 *dst, int len,
+				     u64 sum, bool copy)
+{
+	while (len >= 64) {
+		__uint128_t tmp1, tmp2, tmp3, tmp4;
+
+		memcpy(&tmp1, src, 16);
+		memcpy(&tmp2, src + 16, 16);
+		memcpy(&tmp3, src + 32, 16);
+		memcpy(&tmp4, src + 48, 16);
+		if (copy) {
+			memcpy(dst, &tmp1, 16);
+			memcpy(dst + 16, &tmp2, 16);
+			memcpy(dst + 32, &tmp3, 16);
+			memcpy(dst + 48, &tmp4, 16);
+			dst += 64;
+		}
+
+		len -= 64;
+		src += 64;
+
+		/* Same reduction as the main loop of do_csum() */
+		tmp1 += (tmp1 >> 64) | (tmp1 << 64);
+		tmp2 += (tmp2 >> 64) | (tmp2 << 64);
+		tmp3 += (tmp3 >> 64) | (tmp3 << 64);
+		tmp4 += (tmp4 >> 64) | (tmp4 << 64);
+		tmp1 = ((tmp1 >> 64) << 64) | (tmp2 >> 64);
+		tmp1 += (tmp1 >> 64) | (tmp1 << 64);
+		tmp3 = ((tmp3 >> 64) << 64) | (tmp4 >> 64);
+		tmp3 += (tmp3 >> 64) | (tmp3 << 64);
+		tmp1 = ((tmp1 >> 64) << 64) | (tmp3 >> 64);
+		tmp1 += (tmp1 >> 64) | (tmp1 << 64);
+		tmp1 = ((tmp1 >> 64) << 64) | sum;
+		tmp1 += (tmp1 >> 64) | (tmp1 << 64);
+		sum = tmp1 >> 64;
+	}
+	while (len >= 8) {
+		u64 data;
+
+		memcpy(&data, src, 8);
+		if (copy) {
+			memcpy(dst, &data, 8);
+			dst += 8;
+		}
+		sum = accumulate(sum, data);
+		len -= 8;
+		src += 8;
+	}
+	if (len > 0) {
+		/* The bytes land at the same end of the word in either order */
+		u64 data = 0;
+
+		memcpy(&data, src, len);
+		if (copy)
+			memcpy(dst, src, len);
+		sum = accumulate(sum, data);
+	}
+
+	return sum;
+}
+
+static __wsum csum_fold64(u64 sum)
+{
+	sum += (sum >> 32) | (sum << 32);
+	return (__force __wsum)(sum >> 32);
+}
+
+__wsum csum_partial_copy_nocheck(const void *src, void *dst, int len)
+{
+	return csum_fold64(csum_copy(src, dst, len, 0, true));
+}
+EXPORT_SYMBOL(csum_partial_copy_nocheck);
+
+/*
+ * Chunk of a user copy summed right after it is copied, while it is still
+ * in the L1 cache. A multiple of 8 bytes to keep the words of csum_copy()
+ * counted from the start of the buffer.
+ */
+#define CSUM_COPY_USER_CHUNK	512
+
+__wsum csum_and_copy_from_user(const void __user *src, void *dst, int len)
+{
+	u64 sum = ~0U;
+
+	if (!access_ok(src, len))
+		return 0;
+
+	while (len > 0) {
+		int n = min(len, CSUM_COPY_USER_CHUNK);
+
+		if (__copy_from_user(dst, src, n))
+			return 0;
+
+		sum = csum_copy(dst, NULL, n, sum, false);
+		src += n;
+		dst += n;
+		len -= n;
+	}
+
+	return csum_fold64(sum);
+}
+EXPORT_SYMBOL(csum_and_copy_from_user);
+
 __sum16 csum_ipv6_magic(const struct in6_addr *saddr,
 			const struct in6_addr *daddr,
 			__u32 len, __u8 proto, __wsum csum)
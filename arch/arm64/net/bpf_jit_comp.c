@@ -102,6 +102,21 @@ static inline void emit_a64_mov_i(const int is64, const int reg,
 {
 	u16 hi = val >> 16;
 	u16 lo = val & 0xffff;
+	bool need_movk;
+	u32 insn;
+
+	/*
+	 * Anything that would need a MOVK may still be a bitmask immediate,
+	 * in which case a single ORR does the job.
+	 */
+	need_movk = (hi & 0x8000) ? hi != 0xffff && lo != 0xffff : hi && lo;
+	if (need_movk) {
+		insn = A64_ORR_I(is64, reg, A64_ZR, val);
+		if (insn != AARCH64_BREAK_FAULT) {
+			emit(insn, ctx);
+			return;
+		}
+	}
 
 	if (hi & 0x8000) {
 		if (hi == 0xffff) {
@@ -132,11 +147,19 @@ static inline void emit_a64_mov_i64(const int reg, const u64 val,
 	u64 nrm_tmp = val, rev_tmp = ~val;
 	bool inverse;
 	int shift;
+	u32 insn;
 
 	if (!(nrm_tmp >> 32))
 		return emit_a64_mov_i(0, reg, (u32)val, ctx);
 
 	inverse = i64_i16_blocks(nrm_tmp, true) < i64_i16_blocks(nrm_tmp, false);
+	if (i64_i16_blocks(nrm_tmp, inverse) > 1) {
+		insn = A64_ORR_I(1, reg, A64_ZR, val);
+		if (insn != AARCH64_BREAK_FAULT) {
+			emit(insn, ctx);
+			return;
+		}
+	}
 	shift = max(round_down((inverse ? (fls64(rev_tmp) - 1) :
 					  (fls64(nrm_tmp) - 1)), 16), 0);
 	if (inverse)
@@ -929,18 +952,34 @@ static int build_insn(const struct bpf_insn *insn, struct jit_ctx *ctx,
 			emit(A64_EOR(is64, dst, dst, tmp), ctx);
 		}
 		break;
+	/*
+	 * Powers of two are common and shifts or masks are much cheaper than
+	 * the multiplier or divider, in particular on in-order cores.
+	 */
 	case BPF_ALU | BPF_MUL | BPF_K:
 	case BPF_ALU64 | BPF_MUL | BPF_K:
+		if (imm > 0 && is_power_of_2(imm)) {
+			emit(A64_LSL(is64, dst, dst, ilog2(imm)), ctx);
+			break;
+		}
 		emit_a64_mov_i(is64, tmp, imm, ctx);
 		emit(A64_MUL(is64, dst, dst, tmp), ctx);
 		break;
 	case BPF_ALU | BPF_DIV | BPF_K:
 	case BPF_ALU64 | BPF_DIV | BPF_K:
+		if (imm > 0 && is_power_of_2(imm)) {
+			emit(A64_LSR(is64, dst, dst, ilog2(imm)), ctx);
+			break;
+		}
 		emit_a64_mov_i(is64, tmp, imm, ctx);
 		emit(A64_UDIV(is64, dst, dst, tmp), ctx);
 		break;
 	case BPF_ALU | BPF_MOD | BPF_K:
 	case BPF_ALU64 | BPF_MOD | BPF_K:
+		if (imm > 1 && is_power_of_2(imm)) {
+			emit(A64_AND_I(is64, dst, dst, imm - 1), ctx);
+			break;
+		}
 		emit_a64_mov_i(is64, tmp2, imm, ctx);
 		emit(A64_UDIV(is64, tmp, dst, tmp2), ctx);
 		emit(A64_MSUB(is64, dst, dst, tmp, tmp2), ctx);
@@ -1081,6 +1120,25 @@ static int build_insn(const struct bpf_insn *insn, struct jit_ctx *ctx,
 					    &func_addr, &func_addr_fixed);
 		if (ret < 0)
 			return ret;
+
+		/*
+		 * bpf_get_smp_processor_id() only reads the CPU number from
+		 * the thread_info of current, which lives in SP_EL0.
+		 */
+		if (insn->src_reg == 0 && func_addr_fixed &&
+		    func_addr == (u64)bpf_get_smp_processor_id_proto.func) {
+			const int cpu_off = offsetof(struct thread_info, cpu);
+
+			emit(A64_MRS_SP_EL0(tmp), ctx);
+			if (is_lsi_offset(cpu_off, 2)) {
+				emit(A64_LDR32I(r0, tmp, cpu_off), ctx);
+			} else {
+				emit_a64_mov_i(1, tmp2, cpu_off, ctx);
+				emit(A64_LDR32(r0, tmp, tmp2), ctx);
+			}
+			break;
+		}
+
 		emit_call(func_addr, ctx);
 		emit(A64_MOV(1, r0, A64_R(0)), ctx);
 		break;
@@ -108,6 +108,13 @@ static inline void activate_mm(struct mm_struct *active_mm,
 
 extern void mmu_context_init(void);
 
+#ifdef CONFIG_SMP
+/*
+ * Compute the other CPUs that must flush the TLB of an mm immediately
+ */
+extern void mmu_context_flush_mask(struct mm_struct *mm, struct cpumask *mask);
+#endif
+
 #include <asm-generic/mmu_context.h>
 
 #endif /* _ASM_MICROBLAZE_MMU_CONTEXT_H */
@@ -37,10 +37,18 @@ static inline void local_flush_tlb_range(struct vm_area_struct *vma,
 
 #define update_mmu_cache(vma, addr, ptep)	do { } while (0)
 
+#ifdef CONFIG_SMP
+extern void flush_tlb_all(void);
+extern void flush_tlb_mm(struct mm_struct *mm);
+extern void flush_tlb_page(struct vm_area_struct *vma, unsigned long vmaddr);
+extern void flush_tlb_range(struct vm_area_struct *vma, unsigned long start,
+			    unsigned long end);
+#else
 #define flush_tlb_all local_flush_tlb_all
 #define flush_tlb_mm local_flush_tlb_mm
 #define flush_tlb_page local_flush_tlb_page
 #define flush_tlb_range local_flush_tlb_range
+#endif
 
 /*
  * This is called in munmap when we have freed up some page-table
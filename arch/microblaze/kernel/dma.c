@@ -12,11 +12,43 @@
 #include <linux/gfp.h>
 #include <linux/export.h>
 #include <linux/bug.h>
+#include <linux/percpu.h>
 #include <asm/cacheflush.h>
+#include <asm/cpuinfo.h>
+
+/*
+ * Buffers of at least this size are synced with a flush of the whole data
+ * cache, 0 == the data cache size. The range loops touch every line of the
+ * range while the whole cache loop touches every line of the cache once, so
+ * from the cache size on the range loop can't be cheaper.
+ */
+static unsigned long dma_flush_all_size;
+
+static int __init dma_flush_all_setup(char *s)
+{
+	return !kstrtoul(s, 0, &dma_flush_all_size);
+}
+__setup("dma_flush_all=", dma_flush_all_setup);
 
 static void __dma_sync(phys_addr_t paddr, size_t size,
 		enum dma_data_direction direction)
 {
+	unsigned long threshold = dma_flush_all_size;
+
+	if (!threshold)
+		threshold = per_cpu_ptr(&cpu_info,
+					smp_processor_id())->dcache_size;
+
+	/*
+	 * Writing back and invalidating the whole cache is also correct for
+	 * DMA_FROM_DEVICE: the buffer has no dirty lines while it belongs to
+	 * the device.
+	 */
+	if (threshold && size >= threshold) {
+		flush_dcache();
+		return;
+	}
+
 	switch (direction) {
 	case DMA_TO_DEVICE:
 	case DMA_BIDIRECTIONAL:
@@ -20,6 +20,7 @@
 #include <asm/barrier.h>
 #include <asm/cacheflush.h>
 #include <asm/cpuinfo.h>
+#include <asm/mmu_context.h>
 #include <asm/tlbflush.h>
 
 struct thread_info *secondary_ti;
@@ -39,6 +40,11 @@ static volatile unsigned int cpu_callin_map[NR_CPUS];
 
 static void (*crash_ipi_function_ptr)(struct pt_regs *);
 
+/* Messages raised on a CPU which it has not started to handle yet */
+static DEFINE_PER_CPU_SHARED_ALIGNED(unsigned long, ipi_pending);
+
+static DEFINE_PER_CPU(cpumask_t, tlb_flush_mask);
+
 static const char * const smp_ipi_name[] = {
 	[MICROBLAZE_MSG_RESCHEDULE] = "ipi reschedule",
 	[MICROBLAZE_MSG_CALL_FUNCTION] = "ipi call function",
@@ -101,6 +107,13 @@ void handle_IPI(int ipinr, struct pt_regs *regs)
 
 	__inc_irq_stat(cpu, ipi_irqs[ipinr]);
 
+	/*
+	 * Let the next sender raise a new IPI before the message is handled,
+	 * so that nothing queued from now on gets lost.
+	 */
+	clear_bit(ipinr, this_cpu_ptr(&ipi_pending));
+	smp_mb__after_atomic();
+
 	switch (ipinr) {
 	case MICROBLAZE_MSG_RESCHEDULE:
 		scheduler_ipi();
@@ -122,16 +135,31 @@ void handle_IPI(int ipinr, struct pt_regs *regs)
 	set_irq_regs(old_regs);
 }
 
+/*
+ * Raise @msg on @cpu unless the same message is already pending there. The
+ * generic call function code queues all the work before sending the IPI
+ * and the handlers drain the whole queue, so one interrupt serves all the
+ * requests made until the target starts handling it.
+ */
+static void smp_cross_call_coalesce(unsigned int cpu, unsigned int msg)
+{
+	/* Pairs with the barrier in handle_IPI() */
+	smp_mb__before_atomic();
+	if (!test_and_set_bit(msg, &per_cpu(ipi_pending, cpu)))
+		__smp_cross_call(cpu, msg);
+}
+
 void smp_send_reschedule(int cpu)
 {
 	if (cpu_online(cpu))
-		__smp_cross_call(cpu, MICROBLAZE_MSG_RESCHEDULE);
+		smp_cross_call_coalesce(cpu, MICROBLAZE_MSG_RESCHEDULE);
 }
 
 void arch_send_call_function_single_ipi(int cpu)
 {
 	if (cpu_online(cpu))
-		__smp_cross_call(cpu, MICROBLAZE_MSG_CALL_FUNCTION_SINGLE);
+		smp_cross_call_coalesce(cpu,
+					MICROBLAZE_MSG_CALL_FUNCTION_SINGLE);
 }
 
 void arch_send_call_function_ipi_mask(const struct cpumask *mask)
@@ -139,7 +167,87 @@ void arch_send_call_function_ipi_mask(const struct cpumask *mask)
 	unsigned int cpu;
 
 	for_each_cpu(cpu, mask)
-		__smp_cross_call(cpu, MICROBLAZE_MSG_CALL_FUNCTION);
+		smp_cross_call_coalesce(cpu, MICROBLAZE_MSG_CALL_FUNCTION);
+}
+
+struct tlb_args {
+	struct vm_area_struct *vma;
+	unsigned long start;
+	unsigned long end;
+};
+
+static void ipi_flush_tlb_all(void *ignored)
+{
+	local_flush_tlb_all();
+}
+
+static void ipi_flush_tlb_mm(void *arg)
+{
+	local_flush_tlb_mm(arg);
+}
+
+static void ipi_flush_tlb_page(void *arg)
+{
+	struct tlb_args *ta = arg;
+
+	local_flush_tlb_page(ta->vma, ta->start);
+}
+
+static void ipi_flush_tlb_range(void *arg)
+{
+	struct tlb_args *ta = arg;
+
+	local_flush_tlb_range(ta->vma, ta->start, ta->end);
+}
+
+/*
+ * Run @func on this CPU and on the CPUs which have @mm loaded, the others
+ * only get the context of @mm marked stale.
+ */
+static void flush_tlb_mm_cpus(struct mm_struct *mm, smp_call_func_t func,
+			      void *info)
+{
+	struct cpumask *mask;
+
+	preempt_disable();
+	mask = this_cpu_ptr(&tlb_flush_mask);
+	mmu_context_flush_mask(mm, mask);
+	if (!cpumask_empty(mask))
+		smp_call_function_many(mask, func, info, 1);
+	func(info);
+	preempt_enable();
+}
+
+void flush_tlb_all(void)
+{
+	on_each_cpu(ipi_flush_tlb_all, NULL, 1);
+}
+
+void flush_tlb_mm(struct mm_struct *mm)
+{
+	flush_tlb_mm_cpus(mm, ipi_flush_tlb_mm, mm);
+}
+
+void flush_tlb_page(struct vm_area_struct *vma, unsigned long vmaddr)
+{
+	struct tlb_args ta = {
+		.vma = vma,
+		.start = vmaddr,
+	};
+
+	flush_tlb_mm_cpus(vma->vm_mm, ipi_flush_tlb_page, &ta);
+}
+
+void flush_tlb_range(struct vm_area_struct *vma, unsigned long start,
+		     unsigned long end)
+{
+	struct tlb_args ta = {
+		.vma = vma,
+		.start = start,
+		.end = end,
+	};
+
+	flush_tlb_mm_cpus(vma->vm_mm, ipi_flush_tlb_range, &ta);
 }
 
 #ifdef CONFIG_KGDB
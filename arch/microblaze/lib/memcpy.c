@@ -73,6 +73,29 @@ void *memcpy(void *v_dst, const void *v_src, __kernel_size_t c)
 		case 0x0:	/* Both byte offsets are aligned */
 			i_src  = (const void *)src;
 
+			/*
+			 * Copy 32 bytes, the longest data cache line, per
+			 * iteration. All the loads are issued before the
+			 * stores so that they overlap on the bus.
+			 */
+			for (; c >= 32; c -= 32) {
+				uint32_t t0 = i_src[0], t1 = i_src[1];
+				uint32_t t2 = i_src[2], t3 = i_src[3];
+				uint32_t t4 = i_src[4], t5 = i_src[5];
+				uint32_t t6 = i_src[6], t7 = i_src[7];
+
+				i_dst[0] = t0;
+				i_dst[1] = t1;
+				i_dst[2] = t2;
+				i_dst[3] = t3;
+				i_dst[4] = t4;
+				i_dst[5] = t5;
+				i_dst[6] = t6;
+				i_dst[7] = t7;
+				i_src += 8;
+				i_dst += 8;
+			}
+
 			for (; c >= 4; c -= 4)
 				*i_dst++ = *i_src++;
 
@@ -84,6 +84,30 @@ void *memmove(void *v_dst, const void *v_src, __kernel_size_t c)
 
 			i_src  = (const void *)src;
 
+			/* Same 32 byte blocks as memcpy(), descending */
+			for (; c >= 32; c -= 32) {
+				uint32_t t0, t1, t2, t3, t4, t5, t6, t7;
+
+				i_src -= 8;
+				i_dst -= 8;
+				t0 = i_src[0];
+				t1 = i_src[1];
+				t2 = i_src[2];
+				t3 = i_src[3];
+				t4 = i_src[4];
+				t5 = i_src[5];
+				t6 = i_src[6];
+				t7 = i_src[7];
+				i_dst[7] = t7;
+				i_dst[6] = t6;
+				i_dst[5] = t5;
+				i_dst[4] = t4;
+				i_dst[3] = t3;
+				i_dst[2] = t2;
+				i_dst[1] = t1;
+				i_dst[0] = t0;
+			}
+
 			for (; c >= 4; c -= 4)
 				*--i_dst = *--i_src;
 
@@ -37,7 +37,9 @@
 static unsigned int next_context, nr_free_contexts;
 static unsigned long context_map[LAST_CONTEXT / BITS_PER_LONG + 1];
 #ifdef CONFIG_SMP
-static unsigned long stale_map[LAST_CONTEXT / BITS_PER_LONG + 1][NR_CPUS];
+static unsigned long stale_map[NR_CPUS][LAST_CONTEXT / BITS_PER_LONG + 1];
+/* The mm each CPU has currently loaded in its PID register */
+static struct mm_struct *cpu_context_mm[NR_CPUS];
 #endif
 static struct mm_struct *context_mm[LAST_CONTEXT + 1];
 static DEFINE_RAW_SPINLOCK(context_lock);
@@ -207,11 +209,56 @@ void switch_mmu_context(struct mm_struct *prev, struct mm_struct *next)
 	}
 #endif
 
+#ifdef CONFIG_SMP
+	cpu_context_mm[cpu] = next;
+#endif
+
 	/* Flick the MMU and release lock */
 	set_context(id, next->pgd);
 	raw_spin_unlock(&context_lock);
 }
 
+#ifdef CONFIG_SMP
+/*
+ * Work out which other CPUs have to flush the TLB entries of @mm right
+ * away. Only CPUs that have @mm loaded at the moment need an IPI, the
+ * context is just marked stale on CPUs that ran @mm before and have
+ * switched to something else since, switch_mmu_context() flushes it
+ * there if they ever switch back to @mm.
+ */
+void mmu_context_flush_mask(struct mm_struct *mm, struct cpumask *mask)
+{
+	unsigned int cpu, self = smp_processor_id();
+	unsigned long flags;
+	unsigned int id;
+
+	cpumask_clear(mask);
+
+	/* Kernel mappings are shared by all contexts */
+	if (mm == &init_mm) {
+		cpumask_andnot(mask, cpu_online_mask, cpumask_of(self));
+		return;
+	}
+
+	raw_spin_lock_irqsave(&context_lock, flags);
+	id = mm->context.id;
+	/* Stealing the context already marked it stale everywhere */
+	if (id == MMU_NO_CONTEXT)
+		goto out;
+
+	for_each_cpu(cpu, mm_cpumask(mm)) {
+		if (cpu == self)
+			continue;
+		if (cpu_context_mm[cpu] == mm)
+			cpumask_set_cpu(cpu, mask);
+		else
+			__set_bit(id, stale_map[cpu]);
+	}
+ out:
+	raw_spin_unlock_irqrestore(&context_lock, flags);
+}
+#endif /* CONFIG_SMP */
+
 /*
  * Set up the context for a new address space.
  */
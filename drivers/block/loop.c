@@ -96,6 +96,8 @@ static DEFINE_IDR(loop_index_idr);
 static DEFINE_MUTEX(loop_ctl_mutex);
 static DEFINE_MUTEX(loop_validate_mutex);
 
+static void loop_queue_work(struct loop_device *lo, struct loop_cmd *cmd);
+
 /**
  * loop_global_lock_killable() - take locks for safe loop_validate_file() test
  *
@@ -379,6 +381,17 @@ static void lo_rw_aio_do_completion(struct loop_cmd *cmd)
 		return;
 	kfree(cmd->bvec);
 	cmd->bvec = NULL;
+
+	/*
+	 * The backing file would have blocked on a nowait submission from
+	 * loop_queue_rq(), hand it over to the worker which is allowed to.
+	 */
+	if (cmd->ret == -EAGAIN && (cmd->iocb.ki_flags & IOCB_NOWAIT)) {
+		cmd->iocb.ki_flags &= ~IOCB_NOWAIT;
+		loop_queue_work(rq->q->queuedata, cmd);
+		return;
+	}
+
 	if (likely(!blk_should_fake_timeout(rq->q)))
 		blk_mq_complete_request(rq);
 }
@@ -392,7 +405,7 @@ static void lo_rw_aio_complete(struct kiocb *iocb, long ret)
 }
 
 static int lo_rw_aio(struct loop_device *lo, struct loop_cmd *cmd,
-		     loff_t pos, bool rw)
+		     loff_t pos, bool rw, bool nowait)
 {
 	struct iov_iter iter;
 	struct req_iterator rq_iter;
@@ -446,6 +459,8 @@ static int lo_rw_aio(struct loop_device *lo, struct loop_cmd *cmd,
 	cmd->iocb.ki_filp = file;
 	cmd->iocb.ki_complete = lo_rw_aio_complete;
 	cmd->iocb.ki_flags = IOCB_DIRECT;
+	if (nowait)
+		cmd->iocb.ki_flags |= IOCB_NOWAIT;
 	cmd->iocb.ki_ioprio = IOPRIO_PRIO_VALUE(IOPRIO_CLASS_NONE, 0);
 
 	if (rw == WRITE)
@@ -490,12 +505,12 @@ static int do_req_filebacked(struct loop_device *lo, struct request *rq)
 		return lo_fallocate(lo, rq, pos, FALLOC_FL_PUNCH_HOLE);
 	case REQ_OP_WRITE:
 		if (cmd->use_aio)
-			return lo_rw_aio(lo, cmd, pos, WRITE);
+			return lo_rw_aio(lo, cmd, pos, WRITE, false);
 		else
 			return lo_write_simple(lo, rq, pos);
 	case REQ_OP_READ:
 		if (cmd->use_aio)
-			return lo_rw_aio(lo, cmd, pos, READ);
+			return lo_rw_aio(lo, cmd, pos, READ, false);
 		else
 			return lo_read_simple(lo, rq, pos);
 	default:
@@ -834,8 +849,10 @@ static void loop_queue_work(struct loop_device *lo, struct loop_cmd *cmd)
 	struct loop_worker *cur_worker, *worker = NULL;
 	struct work_struct *work;
 	struct list_head *cmd_list;
+	unsigned long flags;
 
-	spin_lock_irq(&lo->lo_work_lock);
+	/* Nowait submissions fall back to the worker from their completion */
+	spin_lock_irqsave(&lo->lo_work_lock, flags);
 
 	if (queue_on_root_worker(cmd->blkcg_css))
 		goto queue_work;
@@ -895,7 +912,7 @@ static void loop_queue_work(struct loop_device *lo, struct loop_cmd *cmd)
 	}
 	list_add_tail(&cmd->list_entry, cmd_list);
 	queue_work(lo->workqueue, work);
-	spin_unlock_irq(&lo->lo_work_lock);
+	spin_unlock_irqrestore(&lo->lo_work_lock, flags);
 }
 
 static void loop_set_timer(struct loop_device *lo)
@@ -1805,9 +1822,48 @@ static const struct kernel_param_ops loop_hw_qdepth_param_ops = {
 device_param_cb(hw_queue_depth, &loop_hw_qdepth_param_ops, &hw_queue_depth, 0444);
 MODULE_PARM_DESC(hw_queue_depth, "Queue depth for each hardware queue. Default: 128");
 
+static bool nowait_aio;
+module_param(nowait_aio, bool, 0444);
+MODULE_PARM_DESC(nowait_aio, "Submit direct I/O without waiting from the queue context first. Default: false");
+
 MODULE_LICENSE("GPL");
 MODULE_ALIAS_BLOCKDEV_MAJOR(LOOP_MAJOR);
 
+/*
+ * Direct I/O of the root cgroup is submitted from the queue context with
+ * IOCB_NOWAIT first, which saves the switch to the worker whenever the
+ * backing file doesn't have to block. The other cgroups need the worker to
+ * charge their I/O.
+ *
+ * Returns true if the command was submitted, even if it is then retried by
+ * the worker.
+ */
+static bool loop_queue_rq_nowait(struct loop_device *lo, struct loop_cmd *cmd)
+{
+	struct request *rq = blk_mq_rq_from_pdu(cmd);
+	const bool write = op_is_write(req_op(rq));
+	loff_t pos = ((loff_t) blk_rq_pos(rq) << 9) + lo->lo_offset;
+	unsigned int noio_flags;
+	int ret;
+
+	if (!nowait_aio || !cmd->use_aio ||
+	    !queue_on_root_worker(cmd->blkcg_css) ||
+	    !(lo->lo_backing_file->f_mode & FMODE_NOWAIT) ||
+	    (write && (lo->lo_flags & LO_FLAGS_READ_ONLY)))
+		return false;
+
+	noio_flags = memalloc_noio_save();
+	ret = lo_rw_aio(lo, cmd, pos, write ? WRITE : READ, true);
+	memalloc_noio_restore(noio_flags);
+
+	if (ret) {
+		cmd->ret = -EIO;
+		if (likely(!blk_should_fake_timeout(rq->q)))
+			blk_mq_complete_request(rq);
+	}
+	return true;
+}
+
 static blk_status_t loop_queue_rq(struct blk_mq_hw_ctx *hctx,
 		const struct blk_mq_queue_data *bd)
 {
@@ -1835,16 +1891,20 @@ static blk_status_t loop_queue_rq(struct blk_mq_hw_ctx *hctx,
 	cmd->blkcg_css = NULL;
 	cmd->memcg_css = NULL;
 #ifdef CONFIG_BLK_CGROUP
-	if (rq->bio) {
+	if (rq->bio)
 		cmd->blkcg_css = bio_blkcg_css(rq->bio);
-#ifdef CONFIG_MEMCG
-		if (cmd->blkcg_css) {
-			cmd->memcg_css =
-				cgroup_get_e_css(cmd->blkcg_css->cgroup,
-						&memory_cgrp_subsys);
-		}
 #endif
+	if (loop_queue_rq_nowait(lo, cmd))
+		return BLK_STS_OK;
+
+#ifdef CONFIG_BLK_CGROUP
+#ifdef CONFIG_MEMCG
+	if (cmd->blkcg_css) {
+		cmd->memcg_css =
+			cgroup_get_e_css(cmd->blkcg_css->cgroup,
+					&memory_cgrp_subsys);
 	}
+#endif
 #endif
 	loop_queue_work(lo, cmd);
 
@@ -1983,6 +2043,9 @@ static int loop_add(int i)
 	lo->tag_set.cmd_size = sizeof(struct loop_cmd);
 	lo->tag_set.flags = BLK_MQ_F_SHOULD_MERGE | BLK_MQ_F_STACKING |
 		BLK_MQ_F_NO_SCHED_BY_DEFAULT;
+	/* The backing file may still sleep on a nowait submission */
+	if (nowait_aio)
+		lo->tag_set.flags |= BLK_MQ_F_BLOCKING;
 	lo->tag_set.driver_data = lo;
 
 	err = blk_mq_alloc_tag_set(&lo->tag_set);
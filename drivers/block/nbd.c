@@ -62,6 +62,7 @@ struct nbd_sock {
 	bool dead;
 	int fallback_index;
 	int cookie;
+	int recv_cpu;
 };
 
 struct recv_thread_args {
@@ -121,6 +122,7 @@ struct nbd_device {
 	struct mutex config_lock;
 	struct gendisk *disk;
 	struct workqueue_struct *recv_workq;
+	struct workqueue_struct *recv_pinned_workq;
 	struct work_struct remove_work;
 
 	struct list_head list;
@@ -260,6 +262,7 @@ static void nbd_dev_remove(struct nbd_device *nbd)
 	mutex_lock(&nbd_index_mutex);
 	idr_remove(&nbd_index_idr, nbd->index);
 	mutex_unlock(&nbd_index_mutex);
+	destroy_workqueue(nbd->recv_pinned_workq);
 	destroy_workqueue(nbd->recv_workq);
 	kfree(nbd);
 }
@@ -818,6 +821,32 @@ static struct nbd_cmd *nbd_handle_reply(struct nbd_device *nbd, int index,
 	return ret ? ERR_PTR(ret) : cmd;
 }
 
+/* Max replies completed together before the batch is flushed */
+#define NBD_COMP_BATCH_MAX	32
+
+static void nbd_complete_batch(struct io_comp_batch *iob)
+{
+	struct request *req;
+
+	rq_list_for_each(&iob->req_list, req) {
+		struct nbd_cmd *cmd = blk_mq_rq_to_pdu(req);
+
+		dev_dbg(nbd_to_dev(cmd->nbd), "request %p: done\n", req);
+	}
+
+	blk_mq_end_request_batch(iob);
+}
+
+static void nbd_flush_batch(struct io_comp_batch *iob, unsigned int *nr)
+{
+	if (!rq_list_empty(iob->req_list))
+		iob->complete(iob);
+	iob->req_list = NULL;
+	iob->complete = NULL;
+	iob->need_ts = false;
+	*nr = 0;
+}
+
 static void recv_work(struct work_struct *work)
 {
 	struct recv_thread_args *args = container_of(work,
@@ -826,6 +855,9 @@ static void recv_work(struct work_struct *work)
 	struct nbd_device *nbd = args->nbd;
 	struct nbd_config *config = nbd->config;
 	struct request_queue *q = nbd->disk->queue;
+	struct sock *sk = config->socks[args->index]->sock->sk;
+	DEFINE_IO_COMP_BATCH(iob);
+	unsigned int nr_batched = 0;
 	struct nbd_sock *nsock;
 	struct nbd_cmd *cmd;
 	struct request *rq;
@@ -862,11 +894,26 @@ static void recv_work(struct work_struct *work)
 			complete = __test_and_clear_bit(NBD_CMD_INFLIGHT,
 							&cmd->flags);
 			mutex_unlock(&cmd->lock);
-			if (complete)
-				blk_mq_complete_request(rq);
+			if (complete) {
+				if (blk_mq_add_to_batch(rq, &iob,
+							cmd->status != BLK_STS_OK,
+							nbd_complete_batch))
+					nr_batched++;
+				else
+					blk_mq_complete_request(rq);
+			}
 		}
 		percpu_ref_put(&q->q_usage_counter);
+
+		/*
+		 * Complete what we have before we may block waiting for the
+		 * next reply, so batching never adds latency.
+		 */
+		if (nr_batched >= NBD_COMP_BATCH_MAX ||
+		    skb_queue_empty_lockless(&sk->sk_receive_queue))
+			nbd_flush_batch(&iob, &nr_batched);
 	}
+	nbd_flush_batch(&iob, &nr_batched);
 
 	nsock = config->socks[args->index];
 	mutex_lock(&nsock->tx_lock);
@@ -1101,8 +1148,25 @@ static struct socket *nbd_get_socket(struct nbd_device *nbd, unsigned long fd,
 	return sock;
 }
 
+static void nbd_queue_recv_work(struct nbd_device *nbd,
+				struct nbd_sock *nsock,
+				struct recv_thread_args *args)
+{
+	if (nsock->recv_cpu >= 0 && cpu_online(nsock->recv_cpu))
+		queue_work_on(nsock->recv_cpu, nbd->recv_pinned_workq,
+			      &args->work);
+	else
+		queue_work(nbd->recv_workq, &args->work);
+}
+
+static void nbd_flush_recv_work(struct nbd_device *nbd)
+{
+	flush_workqueue(nbd->recv_workq);
+	flush_workqueue(nbd->recv_pinned_workq);
+}
+
 static int nbd_add_socket(struct nbd_device *nbd, unsigned long arg,
-			  bool netlink)
+			  int recv_cpu, bool netlink)
 {
 	struct nbd_config *config = nbd->config;
 	struct socket *sock;
@@ -1156,6 +1220,7 @@ static int nbd_add_socket(struct nbd_device *nbd, unsigned long arg,
 	nsock->pending = NULL;
 	nsock->sent = 0;
 	nsock->cookie = 0;
+	nsock->recv_cpu = recv_cpu;
 	socks[config->num_connections++] = nsock;
 	atomic_inc(&config->live_connections);
 	blk_mq_unfreeze_queue(nbd->disk->queue);
@@ -1218,7 +1283,7 @@ static int nbd_reconnect_socket(struct nbd_device *nbd, unsigned long arg)
 		/* We take the tx_mutex in an error path in the recv_work, so we
 		 * need to queue_work outside of the tx_mutex.
 		 */
-		queue_work(nbd->recv_workq, &args->work);
+		nbd_queue_recv_work(nbd, nsock, args);
 
 		atomic_inc(&config->live_connections);
 		wake_up(&config->conn_wait);
@@ -1380,7 +1445,7 @@ static int nbd_start_device(struct nbd_device *nbd)
 			 * the workqueue from inside the workqueue.
 			 */
 			if (i)
-				flush_workqueue(nbd->recv_workq);
+				nbd_flush_recv_work(nbd);
 			return -ENOMEM;
 		}
 		sk_set_memalloc(config->socks[i]->sock->sk);
@@ -1392,7 +1457,7 @@ static int nbd_start_device(struct nbd_device *nbd)
 		INIT_WORK(&args->work, recv_work);
 		args->nbd = nbd;
 		args->index = i;
-		queue_work(nbd->recv_workq, &args->work);
+		nbd_queue_recv_work(nbd, config->socks[i], args);
 	}
 	return nbd_set_size(nbd, config->bytesize, nbd_blksize(config));
 }
@@ -1416,7 +1481,7 @@ static int nbd_start_device_ioctl(struct nbd_device *nbd)
 		nbd_clear_que(nbd);
 	}
 
-	flush_workqueue(nbd->recv_workq);
+	nbd_flush_recv_work(nbd);
 	mutex_lock(&nbd->config_lock);
 	nbd_bdev_reset(nbd);
 	/* user requested, ignore socket errors */
@@ -1461,7 +1526,7 @@ static int __nbd_ioctl(struct block_device *bdev, struct nbd_device *nbd,
 		nbd_clear_sock_ioctl(nbd, bdev);
 		return 0;
 	case NBD_SET_SOCK:
-		return nbd_add_socket(nbd, arg, false);
+		return nbd_add_socket(nbd, arg, -1, false);
 	case NBD_SET_BLKSIZE:
 		return nbd_set_size(nbd, config->bytesize, arg);
 	case NBD_SET_SIZE:
@@ -1794,6 +1859,17 @@ static struct nbd_device *nbd_dev_add(int index, unsigned int refs)
 		goto out_err_disk;
 	}
 
+	/* for connections whose receive worker is pinned to a CPU */
+	nbd->recv_pinned_workq = alloc_workqueue("nbd%d-recv-pinned",
+						 WQ_MEM_RECLAIM | WQ_HIGHPRI |
+						 WQ_CPU_INTENSIVE, 0,
+						 nbd->index);
+	if (!nbd->recv_pinned_workq) {
+		dev_err(disk_to_dev(nbd->disk), "Could not allocate knbd recv work queue.\n");
+		err = -ENOMEM;
+		goto out_free_recv_workq;
+	}
+
 	/*
 	 * Tell the block layer that we are not a rotational device
 	 */
@@ -1832,6 +1908,8 @@ static struct nbd_device *nbd_dev_add(int index, unsigned int refs)
 	return nbd;
 
 out_free_work:
+	destroy_workqueue(nbd->recv_pinned_workq);
+out_free_recv_workq:
 	destroy_workqueue(nbd->recv_workq);
 out_err_disk:
 	put_disk(disk);
@@ -1881,6 +1959,7 @@ static const struct nla_policy nbd_attr_policy[NBD_ATTR_MAX + 1] = {
 
 static const struct nla_policy nbd_sock_policy[NBD_SOCK_MAX + 1] = {
 	[NBD_SOCK_FD]			=	{ .type = NLA_U32 },
+	[NBD_SOCK_CPU]			=	{ .type = NLA_U32 },
 };
 
 /* We don't use this right now since we don't parse the incoming list, but we
@@ -2035,7 +2114,7 @@ static int nbd_genl_connect(struct sk_buff *skb, struct genl_info *info)
 
 	if (info->attrs[NBD_ATTR_SOCKETS]) {
 		struct nlattr *attr;
-		int rem, fd;
+		int rem, fd, recv_cpu;
 
 		nla_for_each_nested(attr, info->attrs[NBD_ATTR_SOCKETS],
 				    rem) {
@@ -2058,7 +2137,18 @@ static int nbd_genl_connect(struct sk_buff *skb, struct genl_info *info)
 			if (!socks[NBD_SOCK_FD])
 				continue;
 			fd = (int)nla_get_u32(socks[NBD_SOCK_FD]);
-			ret = nbd_add_socket(nbd, fd, true);
+			recv_cpu = -1;
+			if (socks[NBD_SOCK_CPU]) {
+				recv_cpu = nla_get_u32(socks[NBD_SOCK_CPU]);
+				if (recv_cpu >= nr_cpu_ids ||
+				    !cpu_possible(recv_cpu)) {
+					pr_err("invalid recv cpu %d\n",
+					       recv_cpu);
+					ret = -EINVAL;
+					goto out;
+				}
+			}
+			ret = nbd_add_socket(nbd, fd, recv_cpu, true);
 			if (ret)
 				goto out;
 		}
@@ -2104,7 +2194,7 @@ static void nbd_disconnect_and_put(struct nbd_device *nbd)
 	 * Make sure recv thread has finished, we can safely call nbd_clear_que()
 	 * to cancel the inflight I/Os.
 	 */
-	flush_workqueue(nbd->recv_workq);
+	nbd_flush_recv_work(nbd);
 	nbd_clear_que(nbd);
 	nbd->task_setup = NULL;
 	mutex_unlock(&nbd->config_lock);
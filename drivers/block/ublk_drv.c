@@ -51,7 +51,8 @@
 		| UBLK_F_URING_CMD_COMP_IN_TASK \
 		| UBLK_F_NEED_GET_DATA \
 		| UBLK_F_USER_RECOVERY \
-		| UBLK_F_USER_RECOVERY_REISSUE)
+		| UBLK_F_USER_RECOVERY_REISSUE \
+		| UBLK_F_USER_COPY)
 
 /* All UBLK_PARAM_TYPE_* should be included here */
 #define UBLK_PARAM_TYPE_ALL (UBLK_PARAM_TYPE_BASIC | UBLK_PARAM_TYPE_DISCARD)
@@ -286,6 +287,13 @@ static inline bool ublk_need_get_data(const struct ublk_queue *ubq)
 	return false;
 }
 
+static inline bool ublk_support_user_copy(const struct ublk_queue *ubq)
+{
+	if (ubq->flags & UBLK_F_USER_COPY)
+		return true;
+	return false;
+}
+
 static struct ublk_device *ublk_get_device(struct ublk_device *ub)
 {
 	if (kobject_get_unless_zero(&ub->cdev_dev.kobj))
@@ -470,6 +478,11 @@ static int ublk_map_io(const struct ublk_queue *ubq, const struct request *req,
 		struct ublk_io *io)
 {
 	const unsigned int rq_bytes = blk_rq_bytes(req);
+
+	/* ublk server reads the data itself via ublk_ch_read_iter() */
+	if (ublk_support_user_copy(ubq))
+		return rq_bytes;
+
 	/*
 	 * no zero copy, we delay copy WRITE request data into ublksrv
 	 * context and the big benefit is that pinning pages in current
@@ -499,6 +512,10 @@ static int ublk_unmap_io(const struct ublk_queue *ubq,
 {
 	const unsigned int rq_bytes = blk_rq_bytes(req);
 
+	/* data has been written by ublk server via ublk_ch_write_iter() */
+	if (ublk_support_user_copy(ubq))
+		return rq_bytes;
+
 	if (req_op(req) == REQ_OP_READ && ublk_rq_has_data(req)) {
 		struct ublk_map_data data = {
 			.ubq	=	ubq,
@@ -1253,8 +1270,8 @@ static int ublk_ch_uring_cmd(struct io_uring_cmd *cmd, unsigned int issue_flags)
 		 */
 		if (io->flags & UBLK_IO_FLAG_OWNED_BY_SRV)
 			goto out;
-		/* FETCH_RQ has to provide IO buffer */
-		if (!ub_cmd->addr)
+		/* FETCH_RQ has to provide IO buffer unless user copy is used */
+		if (!ub_cmd->addr && !ublk_support_user_copy(ubq))
 			goto out;
 		io->cmd = cmd;
 		io->flags |= UBLK_IO_FLAG_ACTIVE;
@@ -1263,8 +1280,8 @@ static int ublk_ch_uring_cmd(struct io_uring_cmd *cmd, unsigned int issue_flags)
 		ublk_mark_io_ready(ub, ubq);
 		break;
 	case UBLK_IO_COMMIT_AND_FETCH_REQ:
-		/* FETCH_RQ has to provide IO buffer */
-		if (!ub_cmd->addr)
+		/* FETCH_RQ has to provide IO buffer unless user copy is used */
+		if (!ub_cmd->addr && !ublk_support_user_copy(ubq))
 			goto out;
 		if (!(io->flags & UBLK_IO_FLAG_OWNED_BY_SRV))
 			goto out;
@@ -1293,11 +1310,128 @@ static int ublk_ch_uring_cmd(struct io_uring_cmd *cmd, unsigned int issue_flags)
 	return -EIOCBQUEUED;
 }
 
+/*
+ * Copy between the request pages and @uiter, starting @offset bytes into
+ * the request data. Returns the number of bytes copied.
+ */
+static size_t ublk_copy_rq_iter(const struct request *req, size_t offset,
+		struct iov_iter *uiter, bool to_user)
+{
+	struct req_iterator iter;
+	struct bio_vec bv;
+	size_t done = 0;
+
+	rq_for_each_segment(bv, req, iter) {
+		size_t len, copied;
+		void *bv_buf;
+
+		if (offset >= bv.bv_len) {
+			offset -= bv.bv_len;
+			continue;
+		}
+
+		len = bv.bv_len - offset;
+		bv_buf = kmap_local_page(bv.bv_page) + bv.bv_offset + offset;
+		if (to_user)
+			copied = copy_to_iter(bv_buf, len, uiter);
+		else
+			copied = copy_from_iter(bv_buf, len, uiter);
+		kunmap_local(bv_buf);
+
+		done += copied;
+		if (copied < len || !iov_iter_count(uiter))
+			break;
+		offset = 0;
+	}
+
+	return done;
+}
+
+/*
+ * Decode the file position into queue, tag and buffer offset and return
+ * the request the ublk server may access. The request stays valid as long
+ * as the server holds the io, i.e. until it commits it.
+ */
+static struct request *ublk_check_and_get_req(struct kiocb *iocb,
+		size_t *off, bool to_user)
+{
+	struct ublk_device *ub = iocb->ki_filp->private_data;
+	struct ublk_queue *ubq;
+	struct request *req;
+	size_t buf_off;
+	u16 tag, q_id;
+	u64 pos;
+
+	if (!(ub->dev_info.flags & UBLK_F_USER_COPY))
+		return ERR_PTR(-EACCES);
+
+	if (iocb->ki_pos < UBLKSRV_IO_BUF_OFFSET)
+		return ERR_PTR(-EINVAL);
+
+	pos = iocb->ki_pos - UBLKSRV_IO_BUF_OFFSET;
+	if (pos >= UBLKSRV_IO_BUF_TOTAL_SIZE)
+		return ERR_PTR(-EINVAL);
+
+	q_id = (pos >> UBLK_QID_OFF) & UBLK_QID_BITS_MASK;
+	tag = (pos >> UBLK_TAG_OFF) & UBLK_TAG_BITS_MASK;
+	buf_off = pos & UBLK_IO_BUF_BITS_MASK;
+
+	if (q_id >= ub->dev_info.nr_hw_queues)
+		return ERR_PTR(-EINVAL);
+
+	ubq = ublk_get_queue(ub, q_id);
+	if (tag >= ubq->q_depth)
+		return ERR_PTR(-EINVAL);
+
+	if (!(ubq->ios[tag].flags & UBLK_IO_FLAG_OWNED_BY_SRV))
+		return ERR_PTR(-EINVAL);
+
+	req = blk_mq_tag_to_rq(ub->tag_set.tags[q_id], tag);
+	if (!req || !ublk_rq_has_data(req))
+		return ERR_PTR(-EINVAL);
+
+	/* WRITE data is read by the server, READ data is written by it */
+	if (to_user != (req_op(req) == REQ_OP_WRITE))
+		return ERR_PTR(-EINVAL);
+
+	if (buf_off > blk_rq_bytes(req))
+		return ERR_PTR(-EINVAL);
+
+	*off = buf_off;
+	return req;
+}
+
+static ssize_t ublk_ch_read_iter(struct kiocb *iocb, struct iov_iter *to)
+{
+	struct request *req;
+	size_t buf_off;
+
+	req = ublk_check_and_get_req(iocb, &buf_off, true);
+	if (IS_ERR(req))
+		return PTR_ERR(req);
+
+	return ublk_copy_rq_iter(req, buf_off, to, true);
+}
+
+static ssize_t ublk_ch_write_iter(struct kiocb *iocb, struct iov_iter *from)
+{
+	struct request *req;
+	size_t buf_off;
+
+	req = ublk_check_and_get_req(iocb, &buf_off, false);
+	if (IS_ERR(req))
+		return PTR_ERR(req);
+
+	return ublk_copy_rq_iter(req, buf_off, from, false);
+}
+
 static const struct file_operations ublk_ch_fops = {
 	.owner = THIS_MODULE,
 	.open = ublk_ch_open,
 	.release = ublk_ch_release,
 	.llseek = no_llseek,
+	.read_iter = ublk_ch_read_iter,
+	.write_iter = ublk_ch_write_iter,
 	.uring_cmd = ublk_ch_uring_cmd,
 	.mmap = ublk_ch_mmap,
 };
@@ -1676,6 +1810,14 @@ static int ublk_ctrl_add_dev(struct io_uring_cmd *cmd)
 	/* We are not ready to support zero copy */
 	ub->dev_info.flags &= ~UBLK_F_SUPPORT_ZERO_COPY;
 
+	/* the server copies write data itself, nothing to get */
+	if (ub->dev_info.flags & UBLK_F_USER_COPY) {
+		ub->dev_info.flags &= ~UBLK_F_NEED_GET_DATA;
+		ub->dev_info.max_io_buf_bytes = min_t(u32,
+				ub->dev_info.max_io_buf_bytes,
+				UBLK_IO_BUF_BITS_MASK + 1);
+	}
+
 	ub->dev_info.nr_hw_queues = min_t(unsigned int,
 			ub->dev_info.nr_hw_queues, nr_cpu_ids);
 	ublk_align_max_io_size(ub);
@@ -30,6 +30,12 @@
  *
  *****************************************************************************/
 
+#include <linux/completion.h>
+#include <linux/dma-mapping.h>
+#include <linux/dmaengine.h>
+#include <linux/sizes.h>
+#include <linux/string.h>
+
 #include "fifo_icap.h"
 
 /* Register offsets for the XHwIcap device. */
@@ -82,6 +88,13 @@
    at once, in bytes. */
 #define XHI_MAX_READ_TRANSACTION_WORDS 0xFFF
 
+/* DMA bounce buffer, split in two halves that are filled in turn */
+#define XHI_DMA_BUF_SIZE SZ_128K
+#define XHI_DMA_HALF_WORDS (XHI_DMA_BUF_SIZE / 2 / 4)
+/* Below this many words the FIFO is faster than setting up a transfer */
+#define XHI_DMA_MIN_WORDS 256
+#define XHI_DMA_TIMEOUT_MS 1000
+
 
 /**
  * fifo_icap_fifo_write - Write data to the write FIFO.
@@ -198,6 +211,115 @@ static inline u32 fifo_icap_read_fifo_occupancy(
 	return in_be32(drvdata->base_address + XHI_RFO_OFFSET);
 }
 
+static void fifo_icap_dma_done(void *arg)
+{
+	complete(arg);
+}
+
+/**
+ * fifo_icap_dma_submit - Queue one half of the bounce buffer.
+ * @drvdata: a pointer to the drvdata.
+ * @half: the half of the bounce buffer to send.
+ * @num_words: the number of words in that half.
+ * @done: completion signalled when the transfer is done.
+ **/
+static int fifo_icap_dma_submit(struct hwicap_drvdata *drvdata,
+		unsigned int half, u32 num_words, struct completion *done)
+{
+	struct dma_async_tx_descriptor *desc;
+	dma_cookie_t cookie;
+
+	desc = dmaengine_prep_slave_single(drvdata->tx_chan,
+			drvdata->dma_addr + half * XHI_DMA_BUF_SIZE / 2,
+			num_words * 4, DMA_MEM_TO_DEV,
+			DMA_PREP_INTERRUPT | DMA_CTRL_ACK);
+	if (!desc)
+		return -ENOMEM;
+
+	reinit_completion(done);
+	desc->callback = fifo_icap_dma_done;
+	desc->callback_param = done;
+
+	cookie = dmaengine_submit(desc);
+	if (dma_submit_error(cookie))
+		return -EIO;
+
+	dma_async_issue_pending(drvdata->tx_chan);
+
+	return 0;
+}
+
+/**
+ * fifo_icap_dma_write - Send configuration data through the DMA channel.
+ * @drvdata: a pointer to the drvdata.
+ * @frame_buffer: a pointer to the data to be written to the
+ *		ICAP device.
+ * @num_words: the number of words (32 bit) to write to the ICAP
+ *		device.
+ *
+ * The data is copied into one half of the bounce buffer while the other
+ * half is being transferred, so the stream into the ICAP never waits for
+ * the CPU for long.
+ **/
+static int fifo_icap_dma_write(struct hwicap_drvdata *drvdata,
+		u32 *frame_buffer, u32 num_words)
+{
+	struct completion done[2];
+	bool busy[2] = { false, false };
+	unsigned int half = 0;
+	u32 *buf;
+	u32 words, i;
+	int status = 0;
+
+	init_completion(&done[0]);
+	init_completion(&done[1]);
+
+	while (num_words > 0) {
+		if (busy[half]) {
+			if (!wait_for_completion_timeout(&done[half],
+					msecs_to_jiffies(XHI_DMA_TIMEOUT_MS))) {
+				status = -ETIMEDOUT;
+				goto error;
+			}
+			busy[half] = false;
+		}
+
+		words = min_t(u32, num_words, XHI_DMA_HALF_WORDS);
+		buf = drvdata->dma_buf + half * XHI_DMA_HALF_WORDS;
+
+		/*
+		 * The FIFO register takes each word by value, the stream gets
+		 * the same values from the little endian buffer.
+		 */
+		memcpy(buf, frame_buffer, words * sizeof(*buf));
+
+		status = fifo_icap_dma_submit(drvdata, half, words,
+					      &done[half]);
+		if (status)
+			goto error;
+
+		busy[half] = true;
+		frame_buffer += words;
+		num_words -= words;
+		half ^= 1;
+	}
+
+	for (i = 0; i < 2; i++) {
+		if (busy[i] && !wait_for_completion_timeout(&done[i],
+				msecs_to_jiffies(XHI_DMA_TIMEOUT_MS))) {
+			status = -ETIMEDOUT;
+			goto error;
+		}
+	}
+
+	return 0;
+
+ error:
+	dev_err(drvdata->dev, "DMA write failed: %d\n", status);
+	dmaengine_terminate_sync(drvdata->tx_chan);
+	return status;
+}
+
 /**
  * fifo_icap_set_configuration - Send configuration data to the ICAP.
  * @drvdata: a pointer to the drvdata.
@@ -208,7 +330,8 @@ static inline u32 fifo_icap_read_fifo_occupancy(
 
  * This function writes the given user data to the Write FIFO in
  * polled mode and starts the transfer of the data to
- * the ICAP device.
+ * the ICAP device. Large writes go through the DMA channel instead
+ * when there is one.
  **/
 int fifo_icap_set_configuration(struct hwicap_drvdata *drvdata,
 		u32 *frame_buffer, u32 num_words)
@@ -220,6 +343,9 @@ int fifo_icap_set_configuration(struct hwicap_drvdata *drvdata,
 
 	dev_dbg(drvdata->dev, "fifo_set_configuration\n");
 
+	if (drvdata->tx_chan && num_words >= XHI_DMA_MIN_WORDS)
+		return fifo_icap_dma_write(drvdata, frame_buffer, num_words);
+
 	/*
 	 * Check if the ICAP device is Busy with the last Read/Write
 	 */
@@ -391,3 +517,51 @@ void fifo_icap_flush_fifo(struct hwicap_drvdata *drvdata)
 				reg_data & (~XHI_CR_FIFO_CLR_MASK));
 }
 
+/**
+ * fifo_icap_init - Set up the optional DMA write path.
+ * @drvdata: a pointer to the drvdata.
+ *
+ * A "tx" DMA channel feeding the ICAP stream interface is used for large
+ * writes when the device tree provides one.
+ *
+ * Return: 0 on success, negative errno otherwise
+ */
+int fifo_icap_init(struct hwicap_drvdata *drvdata)
+{
+	struct dma_chan *chan;
+
+	chan = dma_request_chan(drvdata->dev, "tx");
+	if (IS_ERR(chan)) {
+		if (PTR_ERR(chan) == -EPROBE_DEFER)
+			return -EPROBE_DEFER;
+		return 0;
+	}
+
+	drvdata->dma_buf = dma_alloc_coherent(chan->device->dev,
+					      XHI_DMA_BUF_SIZE,
+					      &drvdata->dma_addr, GFP_KERNEL);
+	if (!drvdata->dma_buf) {
+		dma_release_channel(chan);
+		return -ENOMEM;
+	}
+
+	drvdata->tx_chan = chan;
+	dev_info(drvdata->dev, "using DMA channel %s\n", dma_chan_name(chan));
+
+	return 0;
+}
+
+/**
+ * fifo_icap_exit - Release the DMA write path.
+ * @drvdata: a pointer to the drvdata.
+ */
+void fifo_icap_exit(struct hwicap_drvdata *drvdata)
+{
+	if (!drvdata->tx_chan)
+		return;
+
+	dma_free_coherent(drvdata->tx_chan->device->dev, XHI_DMA_BUF_SIZE,
+			  drvdata->dma_buf, drvdata->dma_addr);
+	dma_release_channel(drvdata->tx_chan);
+	drvdata->tx_chan = NULL;
+}
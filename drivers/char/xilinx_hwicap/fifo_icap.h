@@ -55,5 +55,7 @@ int fifo_icap_set_configuration(
 u32 fifo_icap_get_status(struct hwicap_drvdata *drvdata);
 void fifo_icap_reset(struct hwicap_drvdata *drvdata);
 void fifo_icap_flush_fifo(struct hwicap_drvdata *drvdata);
+int fifo_icap_init(struct hwicap_drvdata *drvdata);
+void fifo_icap_exit(struct hwicap_drvdata *drvdata);
 
 #endif
@@ -84,6 +84,7 @@
 #include <linux/sysctl.h>
 #include <linux/fs.h>
 #include <linux/cdev.h>
+#include <linux/fpga/fpga-mgr.h>
 #include <linux/platform_device.h>
 #include <linux/slab.h>
 #include <linux/io.h>
@@ -599,6 +600,155 @@ static const struct file_operations hwicap_fops = {
 	.llseek = noop_llseek,
 };
 
+/*
+ * The FPGA manager core doesn't call write_complete after a failed write,
+ * so a failed load desyncs the ICAP and gives it back here. Called with
+ * drvdata->sem held.
+ */
+static void hwicap_fpga_abort(struct hwicap_drvdata *drvdata)
+{
+	hwicap_command_desync(drvdata);
+	drvdata->write_buffer_in_use = 0;
+	drvdata->is_open = 0;
+}
+
+static int hwicap_fpga_write_init(struct fpga_manager *mgr,
+				  struct fpga_image_info *info,
+				  const char *buf, size_t count)
+{
+	struct hwicap_drvdata *drvdata = mgr->priv;
+	int status;
+
+	/* A full reconfiguration would also wipe out this processor */
+	if (!(info->flags & FPGA_MGR_PARTIAL_RECONFIG)) {
+		dev_err(&mgr->dev, "only partial reconfiguration is supported\n");
+		return -EINVAL;
+	}
+
+	mutex_lock(&drvdata->sem);
+
+	if (drvdata->is_open) {
+		status = -EBUSY;
+		goto error;
+	}
+
+	status = hwicap_initialize_hwicap(drvdata);
+	if (status)
+		goto error;
+
+	drvdata->write_buffer_in_use = 0;
+	drvdata->is_open = 1;
+
+ error:
+	mutex_unlock(&drvdata->sem);
+	return status;
+}
+
+static int hwicap_fpga_write(struct fpga_manager *mgr, const char *buf,
+			     size_t count)
+{
+	struct hwicap_drvdata *drvdata = mgr->priv;
+	u32 *kbuf = NULL;
+	size_t len;
+	int status = 0;
+
+	mutex_lock(&drvdata->sem);
+
+	/* Complete the word left over by the previous chunk first */
+	while (drvdata->write_buffer_in_use && count) {
+		drvdata->write_buffer[drvdata->write_buffer_in_use++] = *buf++;
+		count--;
+		if (drvdata->write_buffer_in_use == 4) {
+			status = drvdata->config->set_configuration(drvdata,
+					(u32 *)drvdata->write_buffer, 1);
+			if (status)
+				goto error;
+			drvdata->write_buffer_in_use = 0;
+		}
+	}
+
+	/* Large aligned chunks go to the ICAP as they are */
+	if (IS_ALIGNED((unsigned long)buf, 4) && count > 3) {
+		len = count & ~3;
+		status = drvdata->config->set_configuration(drvdata,
+				(u32 *)buf, len >> 2);
+		if (status)
+			goto error;
+		buf += len;
+		count -= len;
+	} else if (count > 3) {
+		kbuf = (u32 *)__get_free_page(GFP_KERNEL);
+		if (!kbuf) {
+			status = -ENOMEM;
+			goto error;
+		}
+	}
+
+	while (count > 3) {
+		len = min_t(size_t, count, PAGE_SIZE) & ~3;
+		memcpy(kbuf, buf, len);
+		status = drvdata->config->set_configuration(drvdata,
+				kbuf, len >> 2);
+		if (status)
+			goto error;
+		buf += len;
+		count -= len;
+	}
+
+	memcpy(drvdata->write_buffer, buf, count);
+	drvdata->write_buffer_in_use = count;
+
+ error:
+	if (kbuf)
+		free_page((unsigned long)kbuf);
+	if (status)
+		hwicap_fpga_abort(drvdata);
+	mutex_unlock(&drvdata->sem);
+	return status;
+}
+
+static int hwicap_fpga_write_complete(struct fpga_manager *mgr,
+				      struct fpga_image_info *info)
+{
+	struct hwicap_drvdata *drvdata = mgr->priv;
+	int status = 0;
+	int i;
+
+	mutex_lock(&drvdata->sem);
+
+	if (drvdata->write_buffer_in_use) {
+		/* Flush write buffer. */
+		for (i = drvdata->write_buffer_in_use; i < 4; i++)
+			drvdata->write_buffer[i] = 0;
+
+		status = drvdata->config->set_configuration(drvdata,
+				(u32 *) drvdata->write_buffer, 1);
+		if (status)
+			goto error;
+		drvdata->write_buffer_in_use = 0;
+	}
+
+	status = hwicap_command_desync(drvdata);
+	if (status)
+		goto error;
+
+	if (!(drvdata->config->get_status(drvdata) & XHI_SR_CFGERR_N_MASK)) {
+		dev_err(&mgr->dev, "configuration error\n");
+		status = -EIO;
+	}
+
+ error:
+	drvdata->is_open = 0;
+	mutex_unlock(&drvdata->sem);
+	return status;
+}
+
+static const struct fpga_manager_ops hwicap_fpga_ops = {
+	.write_init = hwicap_fpga_write_init,
+	.write = hwicap_fpga_write,
+	.write_complete = hwicap_fpga_write_complete,
+};
+
 static int hwicap_setup(struct device *dev, int id,
 		const struct resource *regs_res,
 		const struct hwicap_driver_config *config,
@@ -679,17 +829,42 @@ static int hwicap_setup(struct device *dev, int id,
 		 drvdata->base_address,
 		 (unsigned long long) drvdata->mem_size);
 
+	if (config->init) {
+		retval = config->init(drvdata);
+		if (retval)
+			goto failed3;
+	}
+
+	if (IS_ENABLED(CONFIG_FPGA)) {
+		drvdata->mgr = fpga_mgr_register(dev,
+				"Xilinx HWICAP FPGA Manager",
+				&hwicap_fpga_ops, drvdata);
+		if (IS_ERR(drvdata->mgr)) {
+			retval = PTR_ERR(drvdata->mgr);
+			dev_err(dev, "unable to register FPGA manager\n");
+			goto failed4;
+		}
+	}
+
 	cdev_init(&drvdata->cdev, &hwicap_fops);
 	drvdata->cdev.owner = THIS_MODULE;
 	retval = cdev_add(&drvdata->cdev, devt, 1);
 	if (retval) {
 		dev_err(dev, "cdev_add() failed\n");
-		goto failed3;
+		goto failed5;
 	}
 
 	device_create(icap_class, dev, devt, NULL, "%s%d", DRIVER_NAME, id);
 	return 0;		/* success */
 
+ failed5:
+	if (drvdata->mgr)
+		fpga_mgr_unregister(drvdata->mgr);
+
+ failed4:
+	if (config->exit)
+		config->exit(drvdata);
+
  failed3:
 	iounmap(drvdata->base_address);
 
@@ -719,6 +894,8 @@ static struct hwicap_driver_config fifo_icap_config = {
 	.set_configuration = fifo_icap_set_configuration,
 	.get_status = fifo_icap_get_status,
 	.reset = fifo_icap_reset,
+	.init = fifo_icap_init,
+	.exit = fifo_icap_exit,
 };
 
 static int hwicap_remove(struct device *dev)
@@ -732,6 +909,10 @@ static int hwicap_remove(struct device *dev)
 
 	device_destroy(icap_class, drvdata->devt);
 	cdev_del(&drvdata->cdev);
+	if (drvdata->mgr)
+		fpga_mgr_unregister(drvdata->mgr);
+	if (drvdata->config->exit)
+		drvdata->config->exit(drvdata);
 	iounmap(drvdata->base_address);
 	release_mem_region(drvdata->mem_start, drvdata->mem_size);
 	kfree(drvdata);
@@ -35,6 +35,7 @@
 
 #include <linux/types.h>
 #include <linux/cdev.h>
+#include <linux/dmaengine.h>
 #include <linux/platform_device.h>
 
 #include <linux/io.h>
@@ -58,6 +59,11 @@ struct hwicap_drvdata {
 	void *private_data;
 	bool is_open;
 	struct mutex sem;
+
+	struct dma_chan *tx_chan;	/* Optional DMA channel for writes */
+	u32 *dma_buf;		/* DMA bounce buffer */
+	dma_addr_t dma_addr;
+	struct fpga_manager *mgr;
 };
 
 struct hwicap_driver_config {
@@ -85,6 +91,11 @@ struct hwicap_driver_config {
 	u32 (*get_status)(struct hwicap_drvdata *drvdata);
 	/* Reset the hw */
 	void (*reset)(struct hwicap_drvdata *drvdata);
+	/* Optional setup and teardown of additional resources.
+	 * init returns 0 if successful.
+	 */
+	int (*init)(struct hwicap_drvdata *drvdata);
+	void (*exit)(struct hwicap_drvdata *drvdata);
 };
 
 /* Number of times to poll the done register. This has to be large
@@ -18,6 +18,7 @@
 #include <linux/module.h>
 #include <linux/of_platform.h>
 #include <linux/platform_device.h>
+#include <linux/pm_runtime.h>
 #include <linux/regmap.h>
 
 #include <dt-bindings/clock/xlnx-vcu.h>
@@ -47,6 +48,18 @@
 #define FVCO_MIN			(1500U * MHZ)
 #define FVCO_MAX			(3000U * MHZ)
 
+#define VCU_AUTOSUSPEND_DELAY_MS	1000
+
+/* Lost while the VCU is held in reset, restored on runtime resume */
+static const u32 xvcu_slcr_ctx_regs[VCU_SLCR_CTX_NUM_REGS] = {
+	VCU_PLL_CTRL,
+	VCU_PLL_CFG,
+	VCU_ENC_CORE_CTRL,
+	VCU_ENC_MCU_CTRL,
+	VCU_DEC_CORE_CTRL,
+	VCU_DEC_MCU_CTRL,
+};
+
 static struct regmap_config vcu_settings_regmap_config = {
 	.name = "regmap",
 	.reg_bits = 32,
@@ -202,6 +215,34 @@ static inline void xvcu_write(void __iomem *iomem, u32 offset, u32 value)
 	iowrite32(value, iomem + offset);
 }
 
+/**
+ * xvcu_read_logicore - Read a LogiCORE register of a resumed VCU
+ * @xvcu:	Pointer to the xvcu_device structure
+ * @offset:	LogiCORE register offset
+ * @value:	Pointer to the read value
+ *
+ * The registers are only accessible with aclk running, which runtime
+ * suspend gates.
+ *
+ * Return:	0 on success, or a negative error code
+ */
+static int xvcu_read_logicore(struct xvcu_device *xvcu, u32 offset,
+			      u32 *value)
+{
+	int ret;
+
+	ret = pm_runtime_resume_and_get(xvcu->dev);
+	if (ret < 0)
+		return ret;
+
+	ret = regmap_read(xvcu->logicore_reg_ba, offset, value);
+
+	pm_runtime_mark_last_busy(xvcu->dev);
+	pm_runtime_put_autosuspend(xvcu->dev);
+
+	return ret;
+}
+
 /**
  * xvcu_get_color_depth - read the color depth register
  * @xvcu:	Pointer to the xvcu_device structure
@@ -213,7 +254,7 @@ u32 xvcu_get_color_depth(struct xvcu_device *xvcu)
 {
 	u32 value;
 
-	if (!regmap_read(xvcu->logicore_reg_ba, VCU_ENC_COLOR_DEPTH, &value))
+	if (!xvcu_read_logicore(xvcu, VCU_ENC_COLOR_DEPTH, &value))
 		return value;
 	else
 		return 0;
@@ -231,7 +272,7 @@ u32 xvcu_get_memory_depth(struct xvcu_device *xvcu)
 {
 	u32 value;
 
-	if (!regmap_read(xvcu->logicore_reg_ba, VCU_MEMORY_DEPTH, &value))
+	if (!xvcu_read_logicore(xvcu, VCU_MEMORY_DEPTH, &value))
 		return value;
 	else
 		return 0;
@@ -249,7 +290,7 @@ u32 xvcu_get_clock_frequency(struct xvcu_device *xvcu)
 {
 	u32 value;
 
-	if (!regmap_read(xvcu->logicore_reg_ba, VCU_CORE_CLK, &value))
+	if (!xvcu_read_logicore(xvcu, VCU_CORE_CLK, &value))
 		return value * MHZ;
 	else
 		return 0;
@@ -267,7 +308,7 @@ u32 xvcu_get_num_cores(struct xvcu_device *xvcu)
 {
 	u32 value;
 
-	if (!regmap_read(xvcu->logicore_reg_ba, VCU_NUM_CORE, &value))
+	if (!xvcu_read_logicore(xvcu, VCU_NUM_CORE, &value))
 		return value;
 	else
 		return 0;
@@ -276,13 +317,42 @@ EXPORT_SYMBOL_GPL(xvcu_get_num_cores);
 
 #define to_vcu_pll(_hw) container_of(_hw, struct vcu_pll, hw)
 
+/**
+ * struct vcu_pll - VCU PLL
+ * @hw: handle between common and hardware-specific interfaces
+ * @dev: VCU device, used to check whether runtime PM gates the PLL
+ * @reg_base: vcu_slcr register base address
+ * @fvco_min: minimum VCO frequency
+ * @fvco_max: maximum VCO frequency
+ * @locked: the PLL is powered and locked to the current feedback divider
+ *
+ * With runtime PM the PLL is only bypassed when its last consumer goes
+ * away and stays locked until the VCU suspends, so that a codec
+ * restarting a session shortly after stopping doesn't wait for a relock.
+ */
 struct vcu_pll {
 	struct clk_hw hw;
+	struct device *dev;
 	void __iomem *reg_base;
 	unsigned long fvco_min;
 	unsigned long fvco_max;
+	bool locked;
 };
 
+static void xvcu_pll_power_down(struct vcu_pll *pll)
+{
+	void __iomem *base = pll->reg_base;
+	u32 vcu_pll_ctrl;
+
+	vcu_pll_ctrl = xvcu_read(base, VCU_PLL_CTRL);
+	vcu_pll_ctrl |= VCU_PLL_CTRL_POR_IN;
+	vcu_pll_ctrl |= VCU_PLL_CTRL_PWR_POR;
+	vcu_pll_ctrl |= VCU_PLL_CTRL_RESET;
+	xvcu_write(base, VCU_PLL_CTRL, vcu_pll_ctrl);
+
+	pll->locked = false;
+}
+
 static int xvcu_pll_wait_for_lock(struct vcu_pll *pll)
 {
 	void __iomem *base = pll->reg_base;
@@ -345,6 +415,8 @@ static int xvcu_pll_set_div(struct vcu_pll *pll, int div)
 		return -EINVAL;
 
 	vcu_pll_ctrl = xvcu_read(base, VCU_PLL_CTRL);
+	if (FIELD_GET(VCU_PLL_CTRL_FBDIV, vcu_pll_ctrl) != cfg->fbdiv)
+		pll->locked = false;
 	vcu_pll_ctrl &= ~VCU_PLL_CTRL_FBDIV;
 	vcu_pll_ctrl |= FIELD_PREP(VCU_PLL_CTRL_FBDIV, cfg->fbdiv);
 	xvcu_write(base, VCU_PLL_CTRL, vcu_pll_ctrl);
@@ -402,10 +474,18 @@ static int xvcu_pll_enable(struct clk_hw *hw)
 	u32 vcu_pll_ctrl;
 	int ret;
 
+	/* Still locked from a previous user, just leave bypass */
+	if (pll->locked)
+		goto bypass_off;
+
 	vcu_pll_ctrl = xvcu_read(base, VCU_PLL_CTRL);
 	vcu_pll_ctrl |= VCU_PLL_CTRL_BYPASS;
 	xvcu_write(base, VCU_PLL_CTRL, vcu_pll_ctrl);
 
+	/* Relock from reset if the divider changed while it was idle */
+	if (!(vcu_pll_ctrl & VCU_PLL_CTRL_RESET))
+		xvcu_pll_power_down(pll);
+
 	vcu_pll_ctrl = xvcu_read(base, VCU_PLL_CTRL);
 	vcu_pll_ctrl &= ~VCU_PLL_CTRL_POR_IN;
 	vcu_pll_ctrl &= ~VCU_PLL_CTRL_PWR_POR;
@@ -417,7 +497,9 @@ static int xvcu_pll_enable(struct clk_hw *hw)
 		pr_err("VCU PLL is not locked\n");
 		goto err;
 	}
+	pll->locked = true;
 
+bypass_off:
 	vcu_pll_ctrl = xvcu_read(base, VCU_PLL_CTRL);
 	vcu_pll_ctrl &= ~VCU_PLL_CTRL_BYPASS;
 	xvcu_write(base, VCU_PLL_CTRL, vcu_pll_ctrl);
@@ -432,10 +514,14 @@ static void xvcu_pll_disable(struct clk_hw *hw)
 	void __iomem *base = pll->reg_base;
 	u32 vcu_pll_ctrl;
 
+	if (!pm_runtime_enabled(pll->dev)) {
+		xvcu_pll_power_down(pll);
+		return;
+	}
+
+	/* Powered down once the VCU runtime suspends */
 	vcu_pll_ctrl = xvcu_read(base, VCU_PLL_CTRL);
-	vcu_pll_ctrl |= VCU_PLL_CTRL_POR_IN;
-	vcu_pll_ctrl |= VCU_PLL_CTRL_PWR_POR;
-	vcu_pll_ctrl |= VCU_PLL_CTRL_RESET;
+	vcu_pll_ctrl |= VCU_PLL_CTRL_BYPASS;
 	xvcu_write(base, VCU_PLL_CTRL, vcu_pll_ctrl);
 }
 
@@ -468,7 +554,9 @@ static struct clk_hw *xvcu_register_pll(struct device *dev,
 		return ERR_PTR(-ENOMEM);
 
 	pll->hw.init = &init;
+	pll->dev = dev;
 	pll->reg_base = reg_base;
+	pll->locked = false;
 	pll->fvco_min = FVCO_MIN;
 	pll->fvco_max = FVCO_MAX;
 
@@ -642,6 +730,19 @@ static void xvcu_unregister_clock_provider(struct xvcu_device *xvcu)
 		clk_hw_unregister_fixed_factor(xvcu->pll_post);
 }
 
+/**
+ * xvcu_reset - Pulse the VCU reset gpio
+ * @xvcu:	Pointer to the xvcu_device structure
+ */
+static void xvcu_reset(struct xvcu_device *xvcu)
+{
+	gpiod_set_value(xvcu->reset_gpio, 0);
+	/* min 2 clock cycle of vcu pll_ref, slowest freq is 33.33KHz */
+	usleep_range(60, 120);
+	gpiod_set_value(xvcu->reset_gpio, 1);
+	usleep_range(60, 120);
+}
+
 /**
  * xvcu_probe - Probe existence of the logicoreIP
  *			and initialize PLL
@@ -735,18 +836,24 @@ static int xvcu_probe(struct platform_device *pdev)
 		goto error_get_gpio;
 	}
 
-	if (xvcu->reset_gpio) {
-		gpiod_set_value(xvcu->reset_gpio, 0);
-		/* min 2 clock cycle of vcu pll_ref, slowest freq is 33.33KHz */
-		usleep_range(60, 120);
-		gpiod_set_value(xvcu->reset_gpio, 1);
-		usleep_range(60, 120);
-	} else {
+	if (xvcu->reset_gpio)
+		xvcu_reset(xvcu);
+	else
 		dev_warn(&pdev->dev, "No reset gpio info from dts for vcu. This may lead to incorrect functionality if VCU isolation is removed post initialization.\n");
-	}
 
 	regmap_write(xvcu->logicore_reg_ba, VCU_GASKET_INIT, VCU_GASKET_VALUE);
 
+	/*
+	 * The clock core resumes the VCU while any of its clocks are
+	 * prepared, and the codecs populated below keep it active while
+	 * they are. Stay up until probing is done.
+	 */
+	pm_runtime_set_active(&pdev->dev);
+	pm_runtime_get_noresume(&pdev->dev);
+	pm_runtime_set_autosuspend_delay(&pdev->dev, VCU_AUTOSUSPEND_DELAY_MS);
+	pm_runtime_use_autosuspend(&pdev->dev);
+	pm_runtime_enable(&pdev->dev);
+
 	ret = xvcu_register_clock_provider(xvcu);
 	if (ret) {
 		dev_err(&pdev->dev, "failed to register clock provider\n");
@@ -761,10 +868,17 @@ static int xvcu_probe(struct platform_device *pdev)
 		goto error_clk_provider;
 	}
 
+	pm_runtime_mark_last_busy(&pdev->dev);
+	pm_runtime_put_autosuspend(&pdev->dev);
+
 	return 0;
 
 error_clk_provider:
 	xvcu_unregister_clock_provider(xvcu);
+	pm_runtime_disable(&pdev->dev);
+	pm_runtime_put_noidle(&pdev->dev);
+	pm_runtime_dont_use_autosuspend(&pdev->dev);
+	pm_runtime_set_suspended(&pdev->dev);
 error_get_gpio:
 	clk_disable_unprepare(xvcu->aclk);
 	return ret;
@@ -786,23 +900,85 @@ static int xvcu_remove(struct platform_device *pdev)
 	if (!xvcu)
 		return -ENODEV;
 
+	pm_runtime_get_sync(&pdev->dev);
+
 	xvcu_unregister_clock_provider(xvcu);
+	xvcu_pll_power_down(to_vcu_pll(xvcu->pll));
 
 	/* Add the Gasket isolation and put the VCU in reset. */
-	if (xvcu->reset_gpio) {
-		gpiod_set_value(xvcu->reset_gpio, 0);
-		/* min 2 clock cycle of vcu pll_ref, slowest freq is 33.33KHz */
-		usleep_range(60, 120);
-		gpiod_set_value(xvcu->reset_gpio, 1);
-		usleep_range(60, 120);
-	}
+	if (xvcu->reset_gpio)
+		xvcu_reset(xvcu);
 	regmap_write(xvcu->logicore_reg_ba, VCU_GASKET_INIT, 0);
 
 	clk_disable_unprepare(xvcu->aclk);
 
+	pm_runtime_disable(&pdev->dev);
+	pm_runtime_put_noidle(&pdev->dev);
+	pm_runtime_dont_use_autosuspend(&pdev->dev);
+	pm_runtime_set_suspended(&pdev->dev);
+
+	return 0;
+}
+
+/**
+ * xvcu_runtime_suspend - Power down the PLL, isolate and reset the VCU
+ * @dev:	Pointer to the VCU device
+ *
+ * Return:	Returns 0
+ */
+static int xvcu_runtime_suspend(struct device *dev)
+{
+	struct xvcu_device *xvcu = dev_get_drvdata(dev);
+	unsigned int i;
+
+	xvcu_pll_power_down(to_vcu_pll(xvcu->pll));
+
+	for (i = 0; i < ARRAY_SIZE(xvcu_slcr_ctx_regs); i++)
+		xvcu->slcr_ctx[i] = xvcu_read(xvcu->vcu_slcr_ba,
+					      xvcu_slcr_ctx_regs[i]);
+
+	regmap_write(xvcu->logicore_reg_ba, VCU_GASKET_INIT, 0);
+	clk_disable_unprepare(xvcu->aclk);
+
 	return 0;
 }
 
+/**
+ * xvcu_runtime_resume - Take the VCU out of reset and restore its clocks
+ * @dev:	Pointer to the VCU device
+ *
+ * The PLL and clock dividers are restored from the values saved at
+ * suspend, the PLL only locks once a codec enables its clocks again.
+ *
+ * Return:	Returns 0 on success
+ *		Negative error code otherwise
+ */
+static int xvcu_runtime_resume(struct device *dev)
+{
+	struct xvcu_device *xvcu = dev_get_drvdata(dev);
+	unsigned int i;
+	int ret;
+
+	ret = clk_prepare_enable(xvcu->aclk);
+	if (ret) {
+		dev_err(dev, "aclk clock enable failed\n");
+		return ret;
+	}
+
+	if (xvcu->reset_gpio)
+		xvcu_reset(xvcu);
+	regmap_write(xvcu->logicore_reg_ba, VCU_GASKET_INIT, VCU_GASKET_VALUE);
+
+	for (i = 0; i < ARRAY_SIZE(xvcu_slcr_ctx_regs); i++)
+		xvcu_write(xvcu->vcu_slcr_ba, xvcu_slcr_ctx_regs[i],
+			   xvcu->slcr_ctx[i]);
+
+	return 0;
+}
+
+static DEFINE_RUNTIME_DEV_PM_OPS(xvcu_pm_ops, xvcu_runtime_suspend,
+				 xvcu_runtime_resume, NULL);
+
 static const struct of_device_id xvcu_of_id_table[] = {
 	{ .compatible = "xlnx,vcu" },
 	{ .compatible = "xlnx,vcu-logicoreip-1.0" },
@@ -814,6 +990,7 @@ static struct platform_driver xvcu_driver = {
 	.driver = {
 		.name           = "xilinx-vcu",
 		.of_match_table = xvcu_of_id_table,
+		.pm             = pm_ptr(&xvcu_pm_ops),
 	},
 	.probe                  = xvcu_probe,
 	.remove                 = xvcu_remove,
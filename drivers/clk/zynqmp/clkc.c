@@ -721,8 +721,14 @@ static void zynqmp_get_clock_info(void)
 		 */
 		name.name[sizeof(name.name) - 1] = '\0';
 
-		if (!strcmp(name.name, RESERVED_CLK_NAME))
+		/*
+		 * Reserved IDs have no name and are never registered, drop them
+		 * here so that their topology and parents are not queried.
+		 */
+		if (!strcmp(name.name, RESERVED_CLK_NAME)) {
+			clock[i].valid = 0;
 			continue;
+		}
 		strscpy(clock[i].clk_name, name.name, MAX_NAME_LEN);
 	}
 
@@ -798,6 +804,12 @@ static struct platform_driver zynqmp_clock_driver = {
 	.driver = {
 		.name = "zynqmp_clock",
 		.of_match_table = zynqmp_clock_of_match,
+		/*
+		 * Discovering the clock tree takes several firmware calls per
+		 * clock. Do it off the boot critical path, consumers are held
+		 * back by their device links until the provider is registered.
+		 */
+		.probe_type = PROBE_PREFER_ASYNCHRONOUS,
 	},
 	.probe = zynqmp_clock_probe,
 };
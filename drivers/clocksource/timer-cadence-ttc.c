@@ -11,6 +11,7 @@
 #include <linux/interrupt.h>
 #include <linux/clockchips.h>
 #include <linux/clocksource.h>
+#include <linux/cpuhotplug.h>
 #include <linux/of_address.h>
 #include <linux/of_irq.h>
 #include <linux/slab.h>
@@ -25,6 +26,10 @@
  * T2: Timer 2, clockevent source for hrtimers
  * T3: Timer 3, <unused>
  *
+ * With percpu_clockevents set, T2, T3 and the counters of any further TTC
+ * instead serve as one clockevent per CPU. This lets SoCs without local
+ * timers avoid the broadcast tick.
+ *
  * The input frequency to the timer module for emulation is 2.5MHz which is
  * common to all the timer channels (T1, T2, and T3). With a pre-scaler of 32,
  * the timers are clocked at 78.125KHz (12.8 us resolution).
@@ -58,6 +63,12 @@
 #define PRESCALE		2048	/* The exponent must match this */
 #define CLK_CNTRL_PRESCALE	((PRESCALE_EXPONENT - 1) << 1)
 #define CLK_CNTRL_PRESCALE_EN	1
+/*
+ * 32-bit counters take minutes to wrap even when barely pre-scaled, so
+ * their clocksource runs much finer while leaving the prescaler range for
+ * rate changes.
+ */
+#define PRESCALE_EXPONENT_32BIT	5
 #define CNT_CNTRL_RESET		(1 << 4)
 
 #define MAX_F_ERR 50
@@ -100,6 +111,13 @@ struct ttc_timer_clockevent {
 
 static void __iomem *ttc_sched_clock_val_reg;
 
+static DEFINE_PER_CPU(struct ttc_timer_clockevent *, ttc_percpu_ce);
+
+static bool percpu_clockevents;
+module_param(percpu_clockevents, bool, 0444);
+MODULE_PARM_DESC(percpu_clockevents,
+		 "Use spare TTC counters as per-CPU clockevents (default: 0)");
+
 /**
  * ttc_set_interval - Set the timer interval value
  *
@@ -321,7 +339,8 @@ static int __init ttc_setup_clocksource(struct clk *clk, void __iomem *base,
 					 u32 timer_width)
 {
 	struct ttc_timer_clocksource *ttccs;
-	int err;
+	unsigned long rate;
+	int err, exp;
 
 	ttccs = kzalloc(sizeof(*ttccs), GFP_KERNEL);
 	if (!ttccs)
@@ -353,26 +372,32 @@ static int __init ttc_setup_clocksource(struct clk *clk, void __iomem *base,
 	ttccs->cs.mask = CLOCKSOURCE_MASK(timer_width);
 	ttccs->cs.flags = CLOCK_SOURCE_IS_CONTINUOUS;
 
+	exp = timer_width > 16 ? PRESCALE_EXPONENT_32BIT : PRESCALE_EXPONENT;
+	rate = ttccs->ttc.freq >> exp;
+
 	/*
 	 * Setup the clock source counter to be an incrementing counter
-	 * with no interrupt and it rolls over at 0xFFFF. Pre-scale
-	 * it by 32 also. Let it start running now.
+	 * with no interrupt and it rolls over at its width. Pre-scale
+	 * it by 2^exp also. Let it start running now.
 	 */
 	writel_relaxed(0x0,  ttccs->ttc.base_addr + TTC_IER_OFFSET);
-	writel_relaxed(CLK_CNTRL_PRESCALE | CLK_CNTRL_PRESCALE_EN,
+	writel_relaxed(((exp - 1) << 1) | CLK_CNTRL_PRESCALE_EN,
 		     ttccs->ttc.base_addr + TTC_CLK_CNTRL_OFFSET);
 	writel_relaxed(CNT_CNTRL_RESET,
 		     ttccs->ttc.base_addr + TTC_CNT_CNTRL_OFFSET);
 
-	err = clocksource_register_hz(&ttccs->cs, ttccs->ttc.freq / PRESCALE);
+	err = clocksource_register_hz(&ttccs->cs, rate);
 	if (err) {
 		kfree(ttccs);
 		return err;
 	}
 
+	/*
+	 * sched_clock sticks with the fastest counter registered, so where
+	 * a 64-bit one such as the ARM global timer exists it stays in use.
+	 */
 	ttc_sched_clock_val_reg = base + TTC_COUNT_VAL_OFFSET;
-	sched_clock_register(ttc_sched_clock_read, timer_width,
-			     ttccs->ttc.freq / PRESCALE);
+	sched_clock_register(ttc_sched_clock_read, timer_width, rate);
 
 	return 0;
 }
@@ -400,15 +425,15 @@ static int ttc_rate_change_clockevent_cb(struct notifier_block *nb,
 	}
 }
 
-static int __init ttc_setup_clockevent(struct clk *clk,
-				       void __iomem *base, u32 irq)
+static struct ttc_timer_clockevent * __init
+ttc_init_clockevent(struct clk *clk, void __iomem *base, u32 irq, bool percpu)
 {
 	struct ttc_timer_clockevent *ttcce;
 	int err;
 
 	ttcce = kzalloc(sizeof(*ttcce), GFP_KERNEL);
 	if (!ttcce)
-		return -ENOMEM;
+		return ERR_PTR(-ENOMEM);
 
 	ttcce->ttc.clk = clk;
 
@@ -424,7 +449,7 @@ static int __init ttc_setup_clockevent(struct clk *clk,
 				    &ttcce->ttc.clk_rate_change_nb);
 	if (err) {
 		pr_warn("Unable to register clock notifier.\n");
-		goto out_kfree;
+		goto out_clk_disable;
 	}
 
 	ttcce->ttc.freq = clk_get_rate(ttcce->ttc.clk);
@@ -440,6 +465,8 @@ static int __init ttc_setup_clockevent(struct clk *clk,
 	ttcce->ce.rating = 200;
 	ttcce->ce.irq = irq;
 	ttcce->ce.cpumask = cpu_possible_mask;
+	if (percpu)
+		ttcce->ce.features |= CLOCK_EVT_FEAT_PERCPU;
 
 	/*
 	 * Setup the clock event timer to be an interval timer which
@@ -451,18 +478,222 @@ static int __init ttc_setup_clockevent(struct clk *clk,
 		     ttcce->ttc.base_addr + TTC_CLK_CNTRL_OFFSET);
 	writel_relaxed(0x1,  ttcce->ttc.base_addr + TTC_IER_OFFSET);
 
+	/* Per-CPU counters get their IRQ routed when their CPU comes up */
+	if (percpu)
+		irq_set_status_flags(irq, IRQ_NOAUTOEN);
 	err = request_irq(irq, ttc_clock_event_interrupt,
-			  IRQF_TIMER, ttcce->ce.name, ttcce);
+			  IRQF_TIMER | (percpu ? IRQF_NOBALANCING : 0),
+			  ttcce->ce.name, ttcce);
 	if (err)
-		goto out_kfree;
+		goto out_notifier_unregister;
+
+	return ttcce;
+
+out_notifier_unregister:
+	irq_clear_status_flags(irq, IRQ_NOAUTOEN);
+	clk_notifier_unregister(ttcce->ttc.clk, &ttcce->ttc.clk_rate_change_nb);
+out_clk_disable:
+	clk_disable_unprepare(ttcce->ttc.clk);
+out_kfree:
+	kfree(ttcce);
+	return ERR_PTR(err);
+}
+
+static void __init ttc_free_clockevent(struct ttc_timer_clockevent *ttcce)
+{
+	free_irq(ttcce->ce.irq, ttcce);
+	irq_clear_status_flags(ttcce->ce.irq, IRQ_NOAUTOEN);
+	clk_notifier_unregister(ttcce->ttc.clk, &ttcce->ttc.clk_rate_change_nb);
+	clk_disable_unprepare(ttcce->ttc.clk);
+	kfree(ttcce);
+}
+
+static int __init ttc_setup_clockevent(struct clk *clk,
+				       void __iomem *base, u32 irq)
+{
+	struct ttc_timer_clockevent *ttcce;
+
+	ttcce = ttc_init_clockevent(clk, base, irq, false);
+	if (IS_ERR(ttcce))
+		return PTR_ERR(ttcce);
 
 	clockevents_config_and_register(&ttcce->ce,
 			ttcce->ttc.freq / PRESCALE, 1, 0xfffe);
 
 	return 0;
+}
+
+static int ttc_clockevent_starting_cpu(unsigned int cpu)
+{
+	struct ttc_timer_clockevent *ttcce = per_cpu(ttc_percpu_ce, cpu);
+
+	if (!ttcce)
+		return 0;
+
+	ttcce->ce.cpumask = cpumask_of(cpu);
+	irq_force_affinity(ttcce->ce.irq, cpumask_of(cpu));
+	enable_irq(ttcce->ce.irq);
+
+	clockevents_config_and_register(&ttcce->ce,
+			ttcce->ttc.freq / PRESCALE, 1, 0xfffe);
+
+	return 0;
+}
+
+static int ttc_clockevent_dying_cpu(unsigned int cpu)
+{
+	struct ttc_timer_clockevent *ttcce = per_cpu(ttc_percpu_ce, cpu);
+
+	if (!ttcce)
+		return 0;
+
+	ttc_shutdown(&ttcce->ce);
+	disable_irq_nosync(ttcce->ce.irq);
+
+	return 0;
+}
+
+static struct ttc_timer_clockevent * __init
+ttc_init_percpu_counter(struct device_node *np, void __iomem *base, int idx)
+{
+	struct ttc_timer_clockevent *ttcce;
+	struct clk *clk;
+	int clksel, irq;
+
+	irq = irq_of_parse_and_map(np, idx);
+	if (irq <= 0)
+		return ERR_PTR(-EINVAL);
+
+	clksel = readl_relaxed(base + 4 * idx + TTC_CLK_CNTRL_OFFSET);
+	clksel = !!(clksel & TTC_CLK_CNTRL_CSRC_MASK);
+	clk = of_clk_get(np, clksel);
+	if (IS_ERR(clk)) {
+		irq_dispose_mapping(irq);
+		return ERR_CAST(clk);
+	}
+
+	ttcce = ttc_init_clockevent(clk, base + 4 * idx, irq, true);
+	if (IS_ERR(ttcce)) {
+		clk_put(clk);
+		irq_dispose_mapping(irq);
+	}
+
+	return ttcce;
+}
+
+static void __init ttc_free_percpu_counter(struct ttc_timer_clockevent *ttcce)
+{
+	unsigned int irq = ttcce->ce.irq;
+	struct clk *clk = ttcce->ttc.clk;
+
+	ttc_free_clockevent(ttcce);
+	clk_put(clk);
+	irq_dispose_mapping(irq);
+}
+
+/*
+ * Hand out T2 and T3 of the timekeeping TTC, then the counters of the
+ * other TTCs not used as PWM, one per possible CPU. Falls back to the
+ * single shared clockevent unless every CPU gets its own.
+ */
+static int __init ttc_setup_percpu_clockevents(struct device_node *timer,
+					       void __iomem *base,
+					       struct clk *clk_ce, u32 irq)
+{
+	struct device_node *np = NULL, *next = NULL;
+	struct ttc_timer_clockevent *ttcce;
+	unsigned int cpu, n, avail = 2;
+	int idx = 2, err;
+
+	for_each_compatible_node(np, NULL, "cdns,ttc")
+		if (np != timer && of_device_is_available(np) &&
+		    !of_property_read_bool(np, "#pwm-cells"))
+			avail += 3;
+	if (avail < num_possible_cpus())
+		return -ENODEV;
+
+	cpu = cpumask_first(cpu_possible_mask);
+	ttcce = ttc_init_clockevent(clk_ce, base + 4, irq, true);
+	if (IS_ERR(ttcce))
+		return PTR_ERR(ttcce);
+	per_cpu(ttc_percpu_ce, cpu) = ttcce;
+
+	/* T3 of the timekeeping TTC comes next */
+	np = of_node_get(timer);
+	while ((cpu = cpumask_next(cpu, cpu_possible_mask)) < nr_cpu_ids) {
+		if (idx == 3) {
+			do {
+				next = of_find_compatible_node(next, NULL,
+							       "cdns,ttc");
+			} while (next && (next == timer ||
+					  !of_device_is_available(next) ||
+					  of_property_read_bool(next,
+								"#pwm-cells")));
+			if (!next) {
+				err = -EINVAL;
+				goto err_put;
+			}
+			of_node_put(np);
+			np = of_node_get(next);
+
+			base = of_iomap(np, 0);
+			if (!base) {
+				err = -ENXIO;
+				goto err_put;
+			}
+			idx = 0;
+		}
+
+		ttcce = ttc_init_percpu_counter(np, base, idx);
+		if (IS_ERR(ttcce)) {
+			if (!idx)
+				iounmap(base);
+			err = PTR_ERR(ttcce);
+			goto err_put;
+		}
+		per_cpu(ttc_percpu_ce, cpu) = ttcce;
+		idx++;
+	}
+	of_node_put(next);
+	of_node_put(np);
+
+	err = cpuhp_setup_state(CPUHP_AP_CADENCE_TTC_TIMER_STARTING,
+				"clockevents/cadence/ttc:starting",
+				ttc_clockevent_starting_cpu,
+				ttc_clockevent_dying_cpu);
+	if (!err)
+		return 0;
+
+	pr_err("Unable to set up per-CPU clockevents\n");
+	goto err_free;
+
+err_put:
+	of_node_put(next);
+	of_node_put(np);
+err_free:
+	/*
+	 * The first CPU has T2 of the timekeeping TTC with the clock and IRQ
+	 * owned by the caller, the next one T3. The others have the counters
+	 * of a TTC mapped here, three CPUs each.
+	 */
+	n = 0;
+	for_each_possible_cpu(cpu) {
+		ttcce = per_cpu(ttc_percpu_ce, cpu);
+		if (!ttcce)
+			break;
+		per_cpu(ttc_percpu_ce, cpu) = NULL;
+
+		if (!n) {
+			ttc_free_clockevent(ttcce);
+		} else {
+			base = ttcce->ttc.base_addr;
+			ttc_free_percpu_counter(ttcce);
+			if (n >= 2 && !((n - 2) % 3))
+				iounmap(base);
+		}
+		n++;
+	}
 
-out_kfree:
-	kfree(ttcce);
 	return err;
 }
 
@@ -523,10 +754,22 @@ static int __init ttc_timer_probe(struct platform_device *pdev)
 	if (ret)
 		return ret;
 
+	if (percpu_clockevents) {
+		ret = ttc_setup_percpu_clockevents(timer, timer_baseaddr,
+						   clk_ce, irq);
+		if (!ret)
+			goto out;
+		if (ret != -ENODEV)
+			return ret;
+		pr_warn("Not enough counters for per-CPU clockevents\n");
+	}
+
 	ret = ttc_setup_clockevent(clk_ce, timer_baseaddr + 4, irq);
 	if (ret)
 		return ret;
 
+out:
+
 	pr_info("%pOFn #0 at %p, irq=%d\n", timer, timer_baseaddr, irq);
 
 	return 0;
@@ -11,15 +11,27 @@
  * #1 wait-for-interrupt
  * #2 wait-for-interrupt and RAM self refresh
  *
+ * On SMP systems a third, coupled state keeps CPU1 in reset while both
+ * CPUs are idle -
+ * #3 CPU1 off, CPU0 wait-for-interrupt
+ *
  * Maintainer: Michal Simek <michal.simek@xilinx.com>
  */
 
 #include <linux/init.h>
 #include <linux/cpuidle.h>
+#include <linux/of.h>
+#include <linux/platform_data/cpuidle-zynq.h>
 #include <linux/platform_device.h>
 #include <asm/cpuidle.h>
 
-#define ZYNQ_MAX_STATES		2
+#include "dt_idle_states.h"
+
+#define ZYNQ_MAX_STATES		3
+#define ZYNQ_CPU1_OFF_STATE	2
+
+static struct cpuidle_zynq_data *zynq_cpuidle_pdata;
+static atomic_t zynq_idle_barrier;
 
 /* Actual code that puts the SoC in different idle states */
 static int zynq_enter_idle(struct cpuidle_device *dev,
@@ -31,6 +43,37 @@ static int zynq_enter_idle(struct cpuidle_device *dev,
 	return index;
 }
 
+static int zynq_enter_cpu1_off(struct cpuidle_device *dev,
+			       struct cpuidle_driver *drv, int index)
+{
+	int ret;
+
+	/* With CPU1 offline the coupled state is entered by CPU0 alone */
+	if (num_online_cpus() == 1)
+		return zynq_enter_idle(dev, drv, index);
+
+	/*
+	 * Waiting all cpus to reach this point at the same moment
+	 */
+	cpuidle_coupled_parallel_barrier(dev, &zynq_idle_barrier);
+
+	/*
+	 * Interrupts targeted at CPU1 only stay pending until CPU0 wakes up
+	 * and restarts it, the local timer is covered by the broadcast timer.
+	 */
+	ret = dev->cpu ? zynq_cpuidle_pdata->cpu1_powerdown()
+		       : zynq_cpuidle_pdata->cpu0_enter();
+	if (ret)
+		index = drv->safe_state_index;
+
+	/*
+	 * Waiting all cpus to finish the power sequence before going further
+	 */
+	cpuidle_coupled_parallel_barrier(dev, &zynq_idle_barrier);
+
+	return index;
+}
+
 static struct cpuidle_driver zynq_idle_driver = {
 	.name = "zynq_idle",
 	.owner = THIS_MODULE,
@@ -43,17 +86,60 @@ static struct cpuidle_driver zynq_idle_driver = {
 			.name			= "RAM_SR",
 			.desc			= "WFI and RAM Self Refresh",
 		},
+		{
+			.enter			= zynq_enter_cpu1_off,
+			.exit_latency		= 500,
+			.target_residency	= 20000,
+			.flags			= CPUIDLE_FLAG_COUPLED |
+						  CPUIDLE_FLAG_TIMER_STOP,
+			.name			= "CPU1_OFF",
+			.desc			= "CPU1 reset and clock stopped",
+		},
 	},
 	.safe_state_index = 0,
-	.state_count = ZYNQ_MAX_STATES,
+	.state_count = ZYNQ_MAX_STATES - 1,
+};
+
+static const struct of_device_id zynq_idle_state_match[] = {
+	{ .compatible = "arm,idle-state", .data = zynq_enter_cpu1_off },
+	{ },
 };
 
 /* Initialize CPU idle by registering the idle states */
 static int zynq_cpuidle_probe(struct platform_device *pdev)
 {
+	const struct cpumask *coupled_cpus = NULL;
+	struct cpuidle_state *state;
+	struct cpuidle_state def;
+	int ret;
+
+	zynq_cpuidle_pdata = dev_get_platdata(&pdev->dev);
+	if (IS_ENABLED(CONFIG_SMP) && zynq_cpuidle_pdata &&
+	    num_possible_cpus() == 2) {
+		state = &zynq_idle_driver.states[ZYNQ_CPU1_OFF_STATE];
+		def = *state;
+		coupled_cpus = cpu_possible_mask;
+
+		/*
+		 * Exit latency and residency of the CPU1 off state depend on
+		 * the board, let an idle state node carry measured values.
+		 */
+		ret = dt_init_idle_driver(&zynq_idle_driver,
+					  zynq_idle_state_match,
+					  ZYNQ_CPU1_OFF_STATE);
+		if (ret < 0) {
+			dev_warn(&pdev->dev,
+				 "invalid idle states, using defaults\n");
+			*state = def;
+		}
+		/* Whatever DT says, CPU1 loses its timer and needs CPU0 */
+		state->flags |= CPUIDLE_FLAG_COUPLED | CPUIDLE_FLAG_TIMER_STOP;
+		zynq_idle_driver.state_count = ZYNQ_MAX_STATES;
+	}
+
 	pr_info("Xilinx Zynq CpuIdle Driver started\n");
 
-	return cpuidle_register(&zynq_idle_driver, NULL);
+	return cpuidle_register(&zynq_idle_driver, coupled_cpus);
 }
 
 static struct platform_driver zynq_cpuidle_driver = {
@@ -0,0 +1,261 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * KUnit benchmarks of the Xilinx crypto accelerators
+ *
+ * Copyright (C) 2023 Xilinx, Inc.
+ *
+ * Every case times the requests of one accelerator over a range of sizes
+ * and reports the latency of a request and the throughput in the test log,
+ * to compare the results of two kernels on the same board. The algorithms
+ * are allocated by driver name, so a case is skipped on a board without the
+ * accelerator instead of timing the generic implementation.
+ */
+
+#include <crypto/aead.h>
+#include <crypto/aes.h>
+#include <crypto/gcm.h>
+#include <crypto/hash.h>
+#include <crypto/sha3.h>
+#include <kunit/test.h>
+#include <linux/ktime.h>
+#include <linux/math64.h>
+#include <linux/module.h>
+#include <linux/random.h>
+#include <linux/scatterlist.h>
+#include <linux/sizes.h>
+
+#define XILINX_BENCH_AUTH_SIZE	16U
+
+static unsigned int iterations = 64;
+module_param(iterations, uint, 0444);
+MODULE_PARM_DESC(iterations, "Requests timed for every size (default: 64)");
+
+static const unsigned int xilinx_bench_sizes[] = {
+	64, 256, SZ_1K, SZ_4K, SZ_16K, SZ_64K,
+};
+
+static void xilinx_bench_size_desc(const unsigned int *size, char *desc)
+{
+	snprintf(desc, KUNIT_PARAM_DESC_SIZE, "%u bytes", *size);
+}
+
+KUNIT_ARRAY_PARAM(xilinx_bench_size, xilinx_bench_sizes,
+		  xilinx_bench_size_desc);
+
+static const char * const xilinx_bench_sha3_drivers[] = {
+	"zynqmp-sha3-384",
+	"versal-sha3-384",
+};
+
+static const char * const xilinx_bench_aes_gcm_drivers[] = {
+	"zynqmp-aes-gcm",
+	"versal-aes-gcm",
+};
+
+/**
+ * struct xilinx_bench_result - Timing of the requests of one size
+ * @driver: driver name of the algorithm
+ * @size: size of a request in bytes
+ * @nr: number of timed requests
+ * @min_ns: latency of the fastest request
+ * @max_ns: latency of the slowest request
+ * @total_ns: latency of all the requests
+ */
+struct xilinx_bench_result {
+	const char *driver;
+	unsigned int size;
+	unsigned int nr;
+	u64 min_ns;
+	u64 max_ns;
+	u64 total_ns;
+};
+
+static void xilinx_bench_init_result(struct xilinx_bench_result *res,
+				     const char *driver, unsigned int size)
+{
+	res->driver = driver;
+	res->size = size;
+	res->nr = 0;
+	res->min_ns = U64_MAX;
+	res->max_ns = 0;
+	res->total_ns = 0;
+}
+
+static void xilinx_bench_account(struct xilinx_bench_result *res,
+				 ktime_t start)
+{
+	u64 ns = ktime_to_ns(ktime_sub(ktime_get(), start));
+
+	res->min_ns = min(res->min_ns, ns);
+	res->max_ns = max(res->max_ns, ns);
+	res->total_ns += ns;
+	res->nr++;
+}
+
+static void xilinx_bench_report(struct kunit *test,
+				const struct xilinx_bench_result *res)
+{
+	u64 total_ns = max_t(u64, res->total_ns, 1);
+
+	/* bytes per microsecond is MB/s */
+	kunit_info(test,
+		   "%s: %u bytes, latency min %llu avg %llu max %llu ns, %llu MB/s\n",
+		   res->driver, res->size, res->min_ns,
+		   div_u64(res->total_ns, res->nr), res->max_ns,
+		   div64_u64((u64)res->size * res->nr * NSEC_PER_USEC,
+			     total_ns));
+}
+
+static int xilinx_bench_hash(struct crypto_ahash *tfm, u8 *buf,
+			     unsigned int size, struct xilinx_bench_result *res)
+{
+	u8 digest[SHA3_384_DIGEST_SIZE];
+	struct ahash_request *req;
+	struct scatterlist sg;
+	DECLARE_CRYPTO_WAIT(wait);
+	unsigned int i, nr = max(iterations, 1U);
+	ktime_t start;
+	int ret;
+
+	req = ahash_request_alloc(tfm, GFP_KERNEL);
+	if (!req)
+		return -ENOMEM;
+
+	sg_init_one(&sg, buf, size);
+	ahash_request_set_callback(req, CRYPTO_TFM_REQ_MAY_BACKLOG |
+				   CRYPTO_TFM_REQ_MAY_SLEEP,
+				   crypto_req_done, &wait);
+	ahash_request_set_crypt(req, &sg, digest, size);
+
+	/* The first request isn't timed, it warms the caches up */
+	ret = crypto_wait_req(crypto_ahash_digest(req), &wait);
+	for (i = 0; i < nr && !ret; i++) {
+		start = ktime_get();
+		ret = crypto_wait_req(crypto_ahash_digest(req), &wait);
+		xilinx_bench_account(res, start);
+	}
+
+	ahash_request_free(req);
+
+	return ret;
+}
+
+static void xilinx_bench_sha3_384(struct kunit *test)
+{
+	const unsigned int *size = test->param_value;
+	struct xilinx_bench_result res;
+	struct crypto_ahash *tfm = ERR_PTR(-ENOENT);
+	unsigned int i;
+	u8 *buf;
+	int ret;
+
+	buf = kunit_kzalloc(test, *size, GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, buf);
+	get_random_bytes(buf, *size);
+
+	for (i = 0; i < ARRAY_SIZE(xilinx_bench_sha3_drivers); i++) {
+		tfm = crypto_alloc_ahash(xilinx_bench_sha3_drivers[i], 0, 0);
+		if (!IS_ERR(tfm))
+			break;
+	}
+	if (IS_ERR(tfm))
+		kunit_skip(test, "no SHA3 accelerator");
+
+	xilinx_bench_init_result(&res, xilinx_bench_sha3_drivers[i], *size);
+	ret = xilinx_bench_hash(tfm, buf, *size, &res);
+	crypto_free_ahash(tfm);
+
+	KUNIT_ASSERT_EQ(test, ret, 0);
+	xilinx_bench_report(test, &res);
+}
+
+static int xilinx_bench_aead(struct crypto_aead *tfm, u8 *buf,
+			     unsigned int size, struct xilinx_bench_result *res)
+{
+	u8 iv[GCM_AES_IV_SIZE] = { 0 };
+	struct aead_request *req;
+	struct scatterlist sg;
+	DECLARE_CRYPTO_WAIT(wait);
+	unsigned int i, nr = max(iterations, 1U);
+	ktime_t start;
+	int ret;
+
+	req = aead_request_alloc(tfm, GFP_KERNEL);
+	if (!req)
+		return -ENOMEM;
+
+	sg_init_one(&sg, buf, size + XILINX_BENCH_AUTH_SIZE);
+	aead_request_set_callback(req, CRYPTO_TFM_REQ_MAY_BACKLOG |
+				  CRYPTO_TFM_REQ_MAY_SLEEP,
+				  crypto_req_done, &wait);
+	aead_request_set_crypt(req, &sg, &sg, size, iv);
+	aead_request_set_ad(req, 0);
+
+	/* The first request isn't timed, it warms the caches up */
+	ret = crypto_wait_req(crypto_aead_encrypt(req), &wait);
+	for (i = 0; i < nr && !ret; i++) {
+		start = ktime_get();
+		ret = crypto_wait_req(crypto_aead_encrypt(req), &wait);
+		xilinx_bench_account(res, start);
+	}
+
+	aead_request_free(req);
+
+	return ret;
+}
+
+static void xilinx_bench_aes_gcm(struct kunit *test)
+{
+	const unsigned int *size = test->param_value;
+	struct crypto_aead *tfm = ERR_PTR(-ENOENT);
+	struct xilinx_bench_result res;
+	u8 key[AES_KEYSIZE_256];
+	unsigned int i;
+	u8 *buf;
+	int ret;
+
+	buf = kunit_kzalloc(test, *size + XILINX_BENCH_AUTH_SIZE, GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, buf);
+	get_random_bytes(buf, *size);
+
+	for (i = 0; i < ARRAY_SIZE(xilinx_bench_aes_gcm_drivers); i++) {
+		tfm = crypto_alloc_aead(xilinx_bench_aes_gcm_drivers[i], 0, 0);
+		if (!IS_ERR(tfm))
+			break;
+	}
+	if (IS_ERR(tfm))
+		kunit_skip(test, "no AES-GCM accelerator");
+
+	get_random_bytes(key, sizeof(key));
+
+	ret = crypto_aead_setkey(tfm, key, sizeof(key));
+	if (!ret)
+		ret = crypto_aead_setauthsize(tfm, XILINX_BENCH_AUTH_SIZE);
+	if (!ret) {
+		xilinx_bench_init_result(&res, xilinx_bench_aes_gcm_drivers[i],
+					 *size);
+		ret = xilinx_bench_aead(tfm, buf, *size, &res);
+	}
+	crypto_free_aead(tfm);
+	memzero_explicit(key, sizeof(key));
+
+	KUNIT_ASSERT_EQ(test, ret, 0);
+	xilinx_bench_report(test, &res);
+}
+
+static struct kunit_case xilinx_bench_cases[] = {
+	KUNIT_CASE_PARAM(xilinx_bench_sha3_384, xilinx_bench_size_gen_params),
+	KUNIT_CASE_PARAM(xilinx_bench_aes_gcm, xilinx_bench_size_gen_params),
+	{}
+};
+
+static struct kunit_suite xilinx_bench_suite = {
+	.name = "xilinx-crypto-bench",
+	.test_cases = xilinx_bench_cases,
+};
+
+kunit_test_suite(xilinx_bench_suite);
+
+MODULE_DESCRIPTION("Xilinx crypto accelerators KUnit benchmarks");
+MODULE_AUTHOR("Xilinx, Inc.");
+MODULE_LICENSE("GPL");
@@ -0,0 +1,517 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Xilinx PL compression engine driver
+ *
+ * The engine sits in the PL between the MM2S and S2MM streams of an AXI DMA
+ * and has a small AXI-Lite register block. Software programs the mode and
+ * the lengths of one request, streams the input on MM2S and receives the
+ * output on S2MM, the engine reports the produced length and the status in
+ * its registers once the S2MM stream has been closed.
+ *
+ * The engines are exposed as acomp algorithms. Requests below the size the
+ * engine pays off at, or that the engine cannot take, are passed to the
+ * software implementation of the same format.
+ *
+ * Copyright (C) 2022 Xilinx, Inc.
+ */
+#include <crypto/algapi.h>
+#include <crypto/internal/acompress.h>
+#include <linux/bitfield.h>
+#include <linux/dma-mapping.h>
+#include <linux/dmaengine.h>
+#include <linux/io.h>
+#include <linux/kernel.h>
+#include <linux/module.h>
+#include <linux/of_device.h>
+#include <linux/platform_device.h>
+#include <linux/scatterlist.h>
+#include <linux/sizes.h>
+
+/* Register offsets */
+#define XCOMP_CTRL_OFFSET		0x00
+#define XCOMP_SRC_LEN_OFFSET		0x04
+#define XCOMP_DST_LEN_OFFSET		0x08
+#define XCOMP_STATUS_OFFSET		0x0c
+#define XCOMP_OUT_LEN_OFFSET		0x10
+#define XCOMP_ID_OFFSET			0x14
+
+/* Control register bit field definitions */
+#define XCOMP_CTRL_DECOMPRESS		BIT(0)
+#define XCOMP_CTRL_RESET		BIT(31)
+
+/* Status register bit field definitions */
+#define XCOMP_STATUS_DONE		BIT(0)
+#define XCOMP_STATUS_ERR		GENMASK(7, 4)
+
+/* Error codes of the status register */
+#define XCOMP_ERR_NONE			0
+#define XCOMP_ERR_OVERFLOW		1
+#define XCOMP_ERR_CORRUPT		2
+
+/* Identification register bit field definitions */
+#define XCOMP_ID_FORMAT			GENMASK(7, 0)
+
+#define XCOMP_DEF_MIN_LEN		SZ_1K
+#define XCOMP_DEF_MAX_LEN		SZ_64K
+#define XCOMP_QUEUE_LEN			64
+#define XCOMP_PRIORITY			300
+
+/**
+ * struct xilinx_comp_format - Compression format of an engine
+ * @id: Format field of the identification register
+ * @name: Crypto API name of the format
+ * @driver_name: Crypto API driver name of the algorithm
+ */
+struct xilinx_comp_format {
+	u32 id;
+	const char *name;
+	const char *driver_name;
+};
+
+/**
+ * struct xilinx_comp_dev - Driver specific device structure
+ * @alg: Asynchronous compression algorithm of the engine
+ * @dev: Device structure
+ * @regs: I/O mapped base address of the engine registers
+ * @tx_chan: AXI DMA MM2S channel feeding the engine
+ * @rx_chan: AXI DMA S2MM channel draining the engine
+ * @lock: Protects @queue and @req
+ * @queue: Requests waiting for the engine
+ * @req: Request being processed by the engine, NULL when the engine is idle
+ * @src_nents: Number of entries of the mapped source of @req
+ * @dst_nents: Number of entries of the mapped destination of @req
+ * @min_len: Inputs below this size are handled in software
+ * @max_len: Largest input and output the engine can take
+ *
+ * The engine works on one request at a time, the next request is started
+ * from the completion of the previous one.
+ */
+struct xilinx_comp_dev {
+	struct acomp_alg alg;
+	struct device *dev;
+	void __iomem *regs;
+	struct dma_chan *tx_chan;
+	struct dma_chan *rx_chan;
+	spinlock_t lock;
+	struct crypto_queue queue;
+	struct acomp_req *req;
+	int src_nents;
+	int dst_nents;
+	u32 min_len;
+	u32 max_len;
+};
+
+struct xilinx_comp_tfm_ctx {
+	struct xilinx_comp_dev *xdev;
+	struct crypto_acomp *fbk_tfm;
+};
+
+struct xilinx_comp_req_ctx {
+	bool decompress;
+	/* Must be last, the fallback request context follows it */
+	struct acomp_req fbk_req;
+};
+
+static inline u32 xcomp_read(struct xilinx_comp_dev *xdev, u32 reg)
+{
+	return ioread32(xdev->regs + reg);
+}
+
+static inline void xcomp_write(struct xilinx_comp_dev *xdev, u32 reg, u32 val)
+{
+	iowrite32(val, xdev->regs + reg);
+}
+
+/**
+ * xilinx_comp_fallback - Process a request in software
+ * @req: Compression request
+ * @decompress: Decompress instead of compress
+ *
+ * The fallback is synchronous, the request is completed on return.
+ *
+ * Return: 0 on success, negative error code otherwise
+ */
+static int xilinx_comp_fallback(struct acomp_req *req, bool decompress)
+{
+	struct xilinx_comp_tfm_ctx *ctx =
+		acomp_tfm_ctx(crypto_acomp_reqtfm(req));
+	struct xilinx_comp_req_ctx *rctx = acomp_request_ctx(req);
+	struct acomp_req *fbk_req = &rctx->fbk_req;
+	int ret;
+
+	acomp_request_set_tfm(fbk_req, ctx->fbk_tfm);
+	acomp_request_set_callback(fbk_req, req->base.flags, NULL, NULL);
+	acomp_request_set_params(fbk_req, req->src, req->dst, req->slen,
+				 req->dlen);
+
+	if (decompress)
+		ret = crypto_acomp_decompress(fbk_req);
+	else
+		ret = crypto_acomp_compress(fbk_req);
+
+	req->dst = fbk_req->dst;
+	req->dlen = fbk_req->dlen;
+
+	return ret;
+}
+
+static void xilinx_comp_unmap(struct xilinx_comp_dev *xdev,
+			      struct acomp_req *req)
+{
+	dma_unmap_sg(dmaengine_get_dma_device(xdev->tx_chan), req->src,
+		     xdev->src_nents, DMA_TO_DEVICE);
+	dma_unmap_sg(dmaengine_get_dma_device(xdev->rx_chan), req->dst,
+		     xdev->dst_nents, DMA_FROM_DEVICE);
+}
+
+static void xilinx_comp_dma_done(void *data,
+				 const struct dmaengine_result *result);
+
+/**
+ * xilinx_comp_start - Hand a request to the engine
+ * @xdev: Driver specific device structure
+ * @req: Compression request
+ *
+ * The S2MM transfer is queued before the MM2S one, the engine stalls its
+ * input otherwise once its output FIFO is full.
+ *
+ * Return: 0 on success, negative error code otherwise
+ */
+static int xilinx_comp_start(struct xilinx_comp_dev *xdev,
+			     struct acomp_req *req)
+{
+	struct xilinx_comp_req_ctx *rctx = acomp_request_ctx(req);
+	struct dma_async_tx_descriptor *txd, *rxd;
+	int src_cnt, dst_cnt;
+	dma_cookie_t cookie;
+
+	xdev->src_nents = sg_nents_for_len(req->src, req->slen);
+	xdev->dst_nents = sg_nents_for_len(req->dst, req->dlen);
+	if (xdev->src_nents < 0 || xdev->dst_nents < 0)
+		return -EINVAL;
+
+	src_cnt = dma_map_sg(dmaengine_get_dma_device(xdev->tx_chan), req->src,
+			     xdev->src_nents, DMA_TO_DEVICE);
+	if (!src_cnt)
+		return -ENOMEM;
+
+	dst_cnt = dma_map_sg(dmaengine_get_dma_device(xdev->rx_chan), req->dst,
+			     xdev->dst_nents, DMA_FROM_DEVICE);
+	if (!dst_cnt) {
+		dma_unmap_sg(dmaengine_get_dma_device(xdev->tx_chan), req->src,
+			     xdev->src_nents, DMA_TO_DEVICE);
+		return -ENOMEM;
+	}
+
+	rxd = dmaengine_prep_slave_sg(xdev->rx_chan, req->dst, dst_cnt,
+				      DMA_DEV_TO_MEM, DMA_PREP_INTERRUPT);
+	if (!rxd)
+		goto err_unmap;
+
+	rxd->callback_result = xilinx_comp_dma_done;
+	rxd->callback_param = xdev;
+	cookie = dmaengine_submit(rxd);
+	if (dma_submit_error(cookie))
+		goto err_unmap;
+
+	/* Nothing is issued yet, terminating drops the submitted S2MM */
+	txd = dmaengine_prep_slave_sg(xdev->tx_chan, req->src, src_cnt,
+				      DMA_MEM_TO_DEV, 0);
+	if (!txd)
+		goto err_terminate;
+
+	cookie = dmaengine_submit(txd);
+	if (dma_submit_error(cookie))
+		goto err_terminate;
+
+	xcomp_write(xdev, XCOMP_CTRL_OFFSET,
+		    rctx->decompress ? XCOMP_CTRL_DECOMPRESS : 0);
+	xcomp_write(xdev, XCOMP_SRC_LEN_OFFSET, req->slen);
+	xcomp_write(xdev, XCOMP_DST_LEN_OFFSET, req->dlen);
+
+	dma_async_issue_pending(xdev->rx_chan);
+	dma_async_issue_pending(xdev->tx_chan);
+
+	return 0;
+
+err_terminate:
+	dmaengine_terminate_async(xdev->rx_chan);
+err_unmap:
+	xilinx_comp_unmap(xdev, req);
+	return -EIO;
+}
+
+/**
+ * xilinx_comp_handle_queue - Queue a request and start the engine if idle
+ * @xdev: Driver specific device structure
+ * @new_req: Request to queue, NULL to only start the next queued request
+ *
+ * Requests that cannot be started are completed in software.
+ *
+ * Return: Status of queueing @new_req
+ */
+static int xilinx_comp_handle_queue(struct xilinx_comp_dev *xdev,
+				    struct acomp_req *new_req)
+{
+	struct crypto_async_request *areq, *backlog;
+	struct xilinx_comp_req_ctx *rctx;
+	struct acomp_req *req;
+	unsigned long flags;
+	int ret = 0, err;
+
+	spin_lock_irqsave(&xdev->lock, flags);
+	if (new_req)
+		ret = crypto_enqueue_request(&xdev->queue, &new_req->base);
+	if (xdev->req) {
+		spin_unlock_irqrestore(&xdev->lock, flags);
+		return ret;
+	}
+
+	for (;;) {
+		backlog = crypto_get_backlog(&xdev->queue);
+		areq = crypto_dequeue_request(&xdev->queue);
+		if (!areq)
+			break;
+
+		req = container_of(areq, struct acomp_req, base);
+		xdev->req = req;
+		spin_unlock_irqrestore(&xdev->lock, flags);
+
+		if (backlog)
+			backlog->complete(backlog, -EINPROGRESS);
+
+		err = xilinx_comp_start(xdev, req);
+		if (!err)
+			return ret;
+
+		dev_dbg(xdev->dev, "engine start failed (%d), using software\n",
+			err);
+		rctx = acomp_request_ctx(req);
+		err = xilinx_comp_fallback(req, rctx->decompress);
+		acomp_request_complete(req, err);
+
+		spin_lock_irqsave(&xdev->lock, flags);
+		xdev->req = NULL;
+	}
+	spin_unlock_irqrestore(&xdev->lock, flags);
+
+	return ret;
+}
+
+/**
+ * xilinx_comp_dma_done - S2MM completion callback
+ * @data: Driver specific device structure
+ * @result: Transfer result reported by the AXI DMA
+ */
+static void xilinx_comp_dma_done(void *data,
+				 const struct dmaengine_result *result)
+{
+	struct xilinx_comp_dev *xdev = data;
+	struct acomp_req *req = xdev->req;
+	u32 status, err;
+	int ret = 0;
+
+	xilinx_comp_unmap(xdev, req);
+
+	status = xcomp_read(xdev, XCOMP_STATUS_OFFSET);
+	err = FIELD_GET(XCOMP_STATUS_ERR, status);
+	if (result->result != DMA_TRANS_NOERROR ||
+	    !(status & XCOMP_STATUS_DONE)) {
+		dev_err_ratelimited(xdev->dev, "transfer failed, status 0x%x\n",
+				    status);
+		xcomp_write(xdev, XCOMP_CTRL_OFFSET, XCOMP_CTRL_RESET);
+		dmaengine_terminate_async(xdev->tx_chan);
+		ret = -EIO;
+	} else if (err == XCOMP_ERR_OVERFLOW) {
+		ret = -ENOSPC;
+	} else if (err != XCOMP_ERR_NONE) {
+		ret = -EINVAL;
+	} else {
+		req->dlen = xcomp_read(xdev, XCOMP_OUT_LEN_OFFSET);
+	}
+
+	spin_lock(&xdev->lock);
+	xdev->req = NULL;
+	spin_unlock(&xdev->lock);
+
+	acomp_request_complete(req, ret);
+
+	xilinx_comp_handle_queue(xdev, NULL);
+}
+
+static int xilinx_comp_do_req(struct acomp_req *req, bool decompress)
+{
+	struct xilinx_comp_tfm_ctx *ctx =
+		acomp_tfm_ctx(crypto_acomp_reqtfm(req));
+	struct xilinx_comp_req_ctx *rctx = acomp_request_ctx(req);
+	struct xilinx_comp_dev *xdev = ctx->xdev;
+
+	/* The engine needs a destination and gains nothing on small inputs */
+	if (!req->dst || req->slen < xdev->min_len ||
+	    req->slen > xdev->max_len || req->dlen > xdev->max_len)
+		return xilinx_comp_fallback(req, decompress);
+
+	rctx->decompress = decompress;
+
+	return xilinx_comp_handle_queue(xdev, req);
+}
+
+static int xilinx_comp_compress(struct acomp_req *req)
+{
+	return xilinx_comp_do_req(req, false);
+}
+
+static int xilinx_comp_decompress(struct acomp_req *req)
+{
+	return xilinx_comp_do_req(req, true);
+}
+
+static int xilinx_comp_init_tfm(struct crypto_acomp *tfm)
+{
+	struct xilinx_comp_tfm_ctx *ctx = acomp_tfm_ctx(tfm);
+	struct acomp_alg *alg = crypto_acomp_alg(tfm);
+	const char *name = crypto_tfm_alg_name(crypto_acomp_tfm(tfm));
+
+	ctx->xdev = container_of(alg, struct xilinx_comp_dev, alg);
+	ctx->fbk_tfm = crypto_alloc_acomp(name, 0, CRYPTO_ALG_ASYNC |
+					  CRYPTO_ALG_NEED_FALLBACK);
+	if (IS_ERR(ctx->fbk_tfm)) {
+		dev_err(ctx->xdev->dev, "failed to allocate fallback for %s\n",
+			name);
+		return PTR_ERR(ctx->fbk_tfm);
+	}
+
+	tfm->reqsize = sizeof(struct xilinx_comp_req_ctx) +
+		       crypto_acomp_reqsize(ctx->fbk_tfm);
+
+	return 0;
+}
+
+static void xilinx_comp_exit_tfm(struct crypto_acomp *tfm)
+{
+	struct xilinx_comp_tfm_ctx *ctx = acomp_tfm_ctx(tfm);
+
+	crypto_free_acomp(ctx->fbk_tfm);
+}
+
+static const struct xilinx_comp_format xilinx_comp_842 = {
+	.id = 0x42,
+	.name = "842",
+	.driver_name = "xilinx-842-acomp",
+};
+
+static const struct of_device_id xilinx_comp_of_ids[] = {
+	{ .compatible = "xlnx,pl-842-1.0", .data = &xilinx_comp_842 },
+	{ /* sentinel */ }
+};
+MODULE_DEVICE_TABLE(of, xilinx_comp_of_ids);
+
+static int xilinx_comp_probe(struct platform_device *pdev)
+{
+	const struct xilinx_comp_format *fmt;
+	struct device *dev = &pdev->dev;
+	struct xilinx_comp_dev *xdev;
+	struct acomp_alg *alg;
+	u32 id;
+	int err;
+
+	fmt = of_device_get_match_data(dev);
+	if (!fmt)
+		return -ENODEV;
+
+	xdev = devm_kzalloc(dev, sizeof(*xdev), GFP_KERNEL);
+	if (!xdev)
+		return -ENOMEM;
+
+	xdev->dev = dev;
+	spin_lock_init(&xdev->lock);
+	crypto_init_queue(&xdev->queue, XCOMP_QUEUE_LEN);
+
+	xdev->regs = devm_platform_ioremap_resource(pdev, 0);
+	if (IS_ERR(xdev->regs))
+		return PTR_ERR(xdev->regs);
+
+	id = FIELD_GET(XCOMP_ID_FORMAT, xcomp_read(xdev, XCOMP_ID_OFFSET));
+	if (id != fmt->id) {
+		dev_err(dev, "unexpected engine format 0x%x\n", id);
+		return -ENODEV;
+	}
+
+	xdev->min_len = XCOMP_DEF_MIN_LEN;
+	of_property_read_u32(dev->of_node, "xlnx,min-len", &xdev->min_len);
+	xdev->max_len = XCOMP_DEF_MAX_LEN;
+	of_property_read_u32(dev->of_node, "xlnx,max-len", &xdev->max_len);
+
+	xdev->tx_chan = dma_request_chan(dev, "tx");
+	if (IS_ERR(xdev->tx_chan))
+		return dev_err_probe(dev, PTR_ERR(xdev->tx_chan),
+				     "failed to get tx channel\n");
+
+	xdev->rx_chan = dma_request_chan(dev, "rx");
+	if (IS_ERR(xdev->rx_chan)) {
+		err = dev_err_probe(dev, PTR_ERR(xdev->rx_chan),
+				    "failed to get rx channel\n");
+		goto err_tx_chan;
+	}
+
+	xcomp_write(xdev, XCOMP_CTRL_OFFSET, XCOMP_CTRL_RESET);
+
+	alg = &xdev->alg;
+	alg->init = xilinx_comp_init_tfm;
+	alg->exit = xilinx_comp_exit_tfm;
+	alg->compress = xilinx_comp_compress;
+	alg->decompress = xilinx_comp_decompress;
+	/* The software fallback may allocate the destination */
+	alg->dst_free = sgl_free;
+	strscpy(alg->base.cra_name, fmt->name, CRYPTO_MAX_ALG_NAME);
+	strscpy(alg->base.cra_driver_name, fmt->driver_name,
+		CRYPTO_MAX_ALG_NAME);
+	alg->base.cra_flags = CRYPTO_ALG_ASYNC | CRYPTO_ALG_NEED_FALLBACK;
+	alg->base.cra_priority = XCOMP_PRIORITY;
+	alg->base.cra_ctxsize = sizeof(struct xilinx_comp_tfm_ctx);
+	alg->base.cra_module = THIS_MODULE;
+
+	platform_set_drvdata(pdev, xdev);
+
+	err = crypto_register_acomp(alg);
+	if (err) {
+		dev_err(dev, "failed to register %s\n", fmt->driver_name);
+		goto err_rx_chan;
+	}
+
+	dev_info(dev, "Xilinx %s compression engine\n", fmt->name);
+
+	return 0;
+
+err_rx_chan:
+	dma_release_channel(xdev->rx_chan);
+err_tx_chan:
+	dma_release_channel(xdev->tx_chan);
+	return err;
+}
+
+static int xilinx_comp_remove(struct platform_device *pdev)
+{
+	struct xilinx_comp_dev *xdev = platform_get_drvdata(pdev);
+
+	crypto_unregister_acomp(&xdev->alg);
+	dmaengine_terminate_sync(xdev->rx_chan);
+	dmaengine_terminate_sync(xdev->tx_chan);
+	dma_release_channel(xdev->rx_chan);
+	dma_release_channel(xdev->tx_chan);
+
+	return 0;
+}
+
+static struct platform_driver xilinx_comp_driver = {
+	.probe = xilinx_comp_probe,
+	.remove = xilinx_comp_remove,
+	.driver = {
+		.name = "xilinx-comp",
+		.of_match_table = xilinx_comp_of_ids,
+	},
+};
+module_platform_driver(xilinx_comp_driver);
+
+MODULE_DESCRIPTION("Xilinx PL compression engine driver");
+MODULE_LICENSE("GPL");
@@ -12,9 +12,13 @@
 #include <crypto/scatterwalk.h>
 
 #include <linux/dma-mapping.h>
+#include <linux/ktime.h>
 #include <linux/module.h>
 #include <linux/of_device.h>
 #include <linux/platform_device.h>
+#include <linux/random.h>
+#include <linux/sizes.h>
+#include <linux/slab.h>
 
 #include <linux/firmware/xlnx-zynqmp.h>
 
@@ -27,6 +31,16 @@
 #define ZYNQMP_AES_MIN_INPUT_BLK_SIZE	4U
 #define ZYNQMP_AES_WORD_LEN		4U
 #define VERSAL_AES_QWORD_LEN		16U
+#define ZYNQMP_AES_DMA_BUF_SIZE		SZ_64K
+
+#define ZYNQMP_AES_CALIB_MIN_SIZE	64U
+#define ZYNQMP_AES_CALIB_MAX_SIZE	SZ_64K
+#define ZYNQMP_AES_CALIB_LOOPS		8U
+
+static int cpu_threshold = -1;
+module_param(cpu_threshold, int, 0444);
+MODULE_PARM_DESC(cpu_threshold,
+		 "Requests smaller than this many bytes use the CPU (-1: calibrate at probe, 0: always use the hardware)");
 
 #define ZYNQMP_AES_GCM_TAG_MISMATCH_ERR		0x01
 #define ZYNQMP_AES_WRONG_KEY_SRC_ERR		0x13
@@ -89,15 +103,6 @@ struct zynqmp_aead_tfm_ctx {
 	struct crypto_aead *fbk_cipher;
 };
 
-struct xilinx_aead_drv_ctx {
-	struct aead_alg aead;
-	struct device *dev;
-	struct crypto_engine *engine;
-	int (*aes_aead_cipher)(struct aead_request *areq);
-	int (*fallback_check)(struct zynqmp_aead_tfm_ctx *ctx,
-			      struct aead_request *areq);
-};
-
 struct zynqmp_aead_hw_req {
 	u64 src;
 	u64 iv;
@@ -108,10 +113,6 @@ struct zynqmp_aead_hw_req {
 	u64 keysrc;
 };
 
-struct zynqmp_aead_req_ctx {
-	enum zynqmp_aead_op op;
-};
-
 struct versal_init_ops {
 	u64 iv;
 	u32 op;
@@ -125,45 +126,176 @@ struct versal_in_params {
 	u32 is_last;
 };
 
+/**
+ * struct zynqmp_aead_desc - Firmware request descriptor
+ * @zynqmp: ZynqMP AES request
+ * @versal: Versal AES init operations and input parameters
+ * @iv: Initialization vector
+ * @key: User key
+ */
+struct zynqmp_aead_desc {
+	union {
+		struct zynqmp_aead_hw_req zynqmp;
+		struct {
+			struct versal_init_ops init;
+			struct versal_in_params in;
+		} versal;
+	};
+	u8 iv[GCM_AES_IV_SIZE];
+	u8 key[ZYNQMP_AES_KEY_SIZE];
+};
+
+/**
+ * struct xilinx_aead_drv_ctx - AES driver context
+ * @aead: AEAD algorithm
+ * @dev: Device
+ * @engine: Crypto engine serializing the requests to the firmware
+ * @aes_aead_cipher: Run one request on the firmware
+ * @fallback_check: Check if a request has to use the fallback
+ * @desc: Firmware request descriptor
+ * @desc_dma_addr: DMA address of @desc
+ * @buf: Bounce buffer used for requests up to ZYNQMP_AES_DMA_BUF_SIZE
+ * @buf_dma_addr: DMA address of @buf
+ * @cpu_threshold: Requests smaller than this use the fallback on the CPU
+ *
+ * The buffers are allocated once at probe, the engine runs only one
+ * request at a time.
+ */
+struct xilinx_aead_drv_ctx {
+	struct aead_alg aead;
+	struct device *dev;
+	struct crypto_engine *engine;
+	int (*aes_aead_cipher)(struct aead_request *areq);
+	int (*fallback_check)(struct zynqmp_aead_tfm_ctx *ctx,
+			      struct aead_request *areq);
+	struct zynqmp_aead_desc *desc;
+	dma_addr_t desc_dma_addr;
+	void *buf;
+	dma_addr_t buf_dma_addr;
+	unsigned int cpu_threshold;
+};
+
+struct zynqmp_aead_req_ctx {
+	enum zynqmp_aead_op op;
+};
+
+static struct xilinx_aead_drv_ctx *
+zynqmp_aes_drv_ctx(struct crypto_aead *aead)
+{
+	return container_of(crypto_aead_alg(aead), struct xilinx_aead_drv_ctx,
+			    aead);
+}
+
+/*
+ * An in-place request whose data is in the first scatterlist entry is
+ * passed to the firmware directly, other requests go through a bounce
+ * buffer.
+ */
+static bool zynqmp_aes_can_dma(struct aead_request *req, unsigned int len)
+{
+	return req->src == req->dst && req->src->length >= len &&
+	       IS_ALIGNED(req->src->offset, ZYNQMP_AES_WORD_LEN);
+}
+
+static void *zynqmp_aes_get_buf(struct xilinx_aead_drv_ctx *drv_ctx,
+				size_t size, dma_addr_t *dma_addr)
+{
+	if (size <= ZYNQMP_AES_DMA_BUF_SIZE) {
+		*dma_addr = drv_ctx->buf_dma_addr;
+		return drv_ctx->buf;
+	}
+
+	return dma_alloc_coherent(drv_ctx->dev, size, dma_addr, GFP_KERNEL);
+}
+
+static void zynqmp_aes_put_buf(struct xilinx_aead_drv_ctx *drv_ctx,
+			       void *buf, size_t size, dma_addr_t dma_addr)
+{
+	memzero_explicit(buf, size);
+	if (buf != drv_ctx->buf)
+		dma_free_coherent(drv_ctx->dev, size, buf, dma_addr);
+}
+
+/*
+ * Map the request data for the firmware, either the caller pages or a
+ * bounce buffer holding a copy of the first @in_len bytes of the source.
+ * Returns the bounce buffer, NULL for the caller pages or an error pointer.
+ */
+static void *zynqmp_aes_map_data(struct xilinx_aead_drv_ctx *drv_ctx,
+				 struct aead_request *req, size_t size,
+				 unsigned int in_len, dma_addr_t *dma_addr)
+{
+	void *kbuf;
+
+	if (zynqmp_aes_can_dma(req, size)) {
+		if (!dma_map_sg(drv_ctx->dev, req->src, 1, DMA_BIDIRECTIONAL))
+			return ERR_PTR(-ENOMEM);
+		*dma_addr = sg_dma_address(req->src);
+		return NULL;
+	}
+
+	kbuf = zynqmp_aes_get_buf(drv_ctx, size, dma_addr);
+	if (!kbuf)
+		return ERR_PTR(-ENOMEM);
+
+	scatterwalk_map_and_copy(kbuf, req->src, 0, in_len, 0);
+
+	return kbuf;
+}
+
+static void zynqmp_aes_unmap_data(struct xilinx_aead_drv_ctx *drv_ctx,
+				  struct aead_request *req, void *kbuf,
+				  size_t size, unsigned int out_len,
+				  dma_addr_t dma_addr, bool copy)
+{
+	if (!kbuf) {
+		dma_unmap_sg(drv_ctx->dev, req->src, 1, DMA_BIDIRECTIONAL);
+		return;
+	}
+
+	if (copy)
+		sg_copy_from_buffer(req->dst, sg_nents(req->dst), kbuf,
+				    out_len);
+	zynqmp_aes_put_buf(drv_ctx, kbuf, size, dma_addr);
+}
+
 static int zynqmp_aes_aead_cipher(struct aead_request *req)
 {
 	struct crypto_aead *aead = crypto_aead_reqtfm(req);
 	struct zynqmp_aead_tfm_ctx *tfm_ctx = crypto_aead_ctx(aead);
 	struct zynqmp_aead_req_ctx *rq_ctx = aead_request_ctx(req);
+	struct xilinx_aead_drv_ctx *drv_ctx = zynqmp_aes_drv_ctx(aead);
+	struct zynqmp_aead_desc *desc = drv_ctx->desc;
+	struct zynqmp_aead_hw_req *hwreq = &desc->zynqmp;
 	struct device *dev = tfm_ctx->dev;
-	struct zynqmp_aead_hw_req *hwreq;
-	dma_addr_t dma_addr_data, dma_addr_hw_req;
-	unsigned int data_size;
+	unsigned int data_size, out_size;
+	dma_addr_t dma_addr_data;
 	unsigned int status;
-	int ret;
 	size_t dma_size;
 	char *kbuf;
+	int ret;
 	int err;
 
-	if (tfm_ctx->keysrc == ZYNQMP_AES_KUP_KEY)
-		dma_size = req->cryptlen + ZYNQMP_AES_KEY_SIZE
-			   + GCM_AES_IV_SIZE;
-	else
-		dma_size = req->cryptlen + GCM_AES_IV_SIZE;
-
-	kbuf = dma_alloc_coherent(dev, dma_size, &dma_addr_data, GFP_KERNEL);
-	if (!kbuf)
-		return -ENOMEM;
-
-	hwreq = dma_alloc_coherent(dev, sizeof(struct zynqmp_aead_hw_req),
-				   &dma_addr_hw_req, GFP_KERNEL);
-	if (!hwreq) {
-		dma_free_coherent(dev, dma_size, kbuf, dma_addr_data);
-		return -ENOMEM;
+	data_size = req->cryptlen;
+	if (rq_ctx->op == ZYNQMP_AES_ENCRYPT) {
+		out_size = data_size + ZYNQMP_AES_AUTH_SIZE;
+		dma_size = out_size;
+	} else {
+		out_size = data_size - ZYNQMP_AES_AUTH_SIZE;
+		dma_size = data_size;
 	}
 
-	data_size = req->cryptlen;
-	scatterwalk_map_and_copy(kbuf, req->src, 0, req->cryptlen, 0);
-	memcpy(kbuf + data_size, req->iv, GCM_AES_IV_SIZE);
+	kbuf = zynqmp_aes_map_data(drv_ctx, req, dma_size, data_size,
+				   &dma_addr_data);
+	if (IS_ERR(kbuf))
+		return PTR_ERR(kbuf);
+
+	memcpy(desc->iv, req->iv, GCM_AES_IV_SIZE);
 
 	hwreq->src = dma_addr_data;
 	hwreq->dst = dma_addr_data;
-	hwreq->iv = hwreq->src + data_size;
+	hwreq->iv = drv_ctx->desc_dma_addr +
+		    offsetof(struct zynqmp_aead_desc, iv);
 	hwreq->keysrc = tfm_ctx->keysrc;
 	hwreq->op = rq_ctx->op;
 
@@ -173,15 +305,15 @@ static int zynqmp_aes_aead_cipher(struct aead_request *req)
 		hwreq->size = data_size - ZYNQMP_AES_AUTH_SIZE;
 
 	if (hwreq->keysrc == ZYNQMP_AES_KUP_KEY) {
-		memcpy(kbuf + data_size + GCM_AES_IV_SIZE,
-		       tfm_ctx->key, ZYNQMP_AES_KEY_SIZE);
+		memcpy(desc->key, tfm_ctx->key, ZYNQMP_AES_KEY_SIZE);
 
-		hwreq->key = hwreq->src + data_size + GCM_AES_IV_SIZE;
+		hwreq->key = drv_ctx->desc_dma_addr +
+			     offsetof(struct zynqmp_aead_desc, key);
 	} else {
 		hwreq->key = 0;
 	}
 
-	ret = zynqmp_pm_aes_engine(dma_addr_hw_req, &status);
+	ret = zynqmp_pm_aes_engine(drv_ctx->desc_dma_addr, &status);
 
 	if (ret) {
 		dev_err(dev, "ERROR: AES PM API failed\n");
@@ -203,25 +335,13 @@ static int zynqmp_aes_aead_cipher(struct aead_request *req)
 		}
 		err = -status;
 	} else {
-		if (hwreq->op == ZYNQMP_AES_ENCRYPT)
-			data_size = data_size + ZYNQMP_AES_AUTH_SIZE;
-		else
-			data_size = data_size - ZYNQMP_AES_AUTH_SIZE;
-
-		sg_copy_from_buffer(req->dst, sg_nents(req->dst),
-				    kbuf, data_size);
 		err = 0;
 	}
 
-	if (kbuf) {
-		memzero_explicit(kbuf, dma_size);
-		dma_free_coherent(dev, dma_size, kbuf, dma_addr_data);
-	}
-	if (hwreq) {
-		memzero_explicit(hwreq, sizeof(struct zynqmp_aead_hw_req));
-		dma_free_coherent(dev, sizeof(struct zynqmp_aead_hw_req),
-				  hwreq, dma_addr_hw_req);
-	}
+	zynqmp_aes_unmap_data(drv_ctx, req, kbuf, dma_size, out_size,
+			      dma_addr_data, !err);
+	memzero_explicit(desc, sizeof(*desc));
+
 	return err;
 }
 
@@ -230,59 +350,40 @@ static int versal_aes_aead_cipher(struct aead_request *req)
 	struct crypto_aead *aead = crypto_aead_reqtfm(req);
 	struct zynqmp_aead_tfm_ctx *tfm_ctx = crypto_aead_ctx(aead);
 	struct zynqmp_aead_req_ctx *rq_ctx = aead_request_ctx(req);
-	dma_addr_t dma_addr_data, dma_addr_hw_req, dma_addr_in;
+	struct xilinx_aead_drv_ctx *drv_ctx = zynqmp_aes_drv_ctx(aead);
+	struct zynqmp_aead_desc *desc = drv_ctx->desc;
+	struct versal_init_ops *hwreq = &desc->versal.init;
+	struct versal_in_params *in = &desc->versal.in;
 	u32 total_len = req->assoclen + req->cryptlen;
-	u32 key_offset = total_len + GCM_AES_IV_SIZE;
-	struct device *dev = tfm_ctx->dev;
-	struct versal_init_ops *hwreq;
-	struct versal_in_params *in;
+	dma_addr_t desc_addr = drv_ctx->desc_dma_addr;
+	dma_addr_t dma_addr_data;
 	u32 gcm_offset, out_len;
 	size_t dma_size;
 	char *kbuf;
 	int ret;
 
-	dma_size = key_offset + tfm_ctx->keylen;
-
-	kbuf = dma_alloc_coherent(dev, dma_size, &dma_addr_data, GFP_KERNEL);
-	if (!kbuf) {
-		ret = -ENOMEM;
-		goto err;
+	if (rq_ctx->op == ZYNQMP_AES_ENCRYPT) {
+		out_len = total_len + ZYNQMP_AES_AUTH_SIZE;
+		dma_size = out_len;
+	} else {
+		out_len = total_len - ZYNQMP_AES_AUTH_SIZE;
+		dma_size = total_len;
 	}
 
-	/*
-	 * Allocated separate memory as separate structure for init ops
-	 * Also to avoid big continuous memory allocation
-	 */
-	hwreq = dma_alloc_coherent(dev, sizeof(struct versal_init_ops),
-				   &dma_addr_hw_req, GFP_KERNEL);
-	if (!hwreq) {
-		ret = -ENOMEM;
-		goto hwreq_fail;
-	}
+	kbuf = zynqmp_aes_map_data(drv_ctx, req, dma_size, total_len,
+				   &dma_addr_data);
+	if (IS_ERR(kbuf))
+		return PTR_ERR(kbuf);
 
-	/*
-	 * Allocated separate memory as separate structure for in params
-	 * Also to avoid big continuous memory allocation
-	 */
-	in = dma_alloc_coherent(dev, sizeof(struct versal_in_params),
-				&dma_addr_in, GFP_KERNEL);
-	if (!in) {
-		ret = -ENOMEM;
-		goto in_fail;
-	}
-
-	scatterwalk_map_and_copy(kbuf, req->src, 0, total_len, 0);
-	memcpy(kbuf + total_len, req->iv, GCM_AES_IV_SIZE);
-	hwreq->iv = dma_addr_data + total_len;
+	memcpy(desc->iv, req->iv, GCM_AES_IV_SIZE);
+	hwreq->iv = desc_addr + offsetof(struct zynqmp_aead_desc, iv);
 	hwreq->keysrc = tfm_ctx->keysrc;
 
 	if (rq_ctx->op == ZYNQMP_AES_ENCRYPT) {
 		hwreq->op = VERSAL_AES_ENCRYPT;
-		out_len = total_len + ZYNQMP_AES_AUTH_SIZE;
 		in->size = req->cryptlen;
 	} else {
 		hwreq->op = VERSAL_AES_DECRYPT;
-		out_len = total_len - ZYNQMP_AES_AUTH_SIZE;
 		in->size = req->cryptlen - ZYNQMP_AES_AUTH_SIZE;
 	}
 
@@ -291,23 +392,25 @@ static int versal_aes_aead_cipher(struct aead_request *req)
 	else if (tfm_ctx->keylen == XSECURE_AES_KEY_SIZE_256)
 		hwreq->size = AES_KEY_SIZE_256;
 
-	memcpy(kbuf + key_offset,
-	       tfm_ctx->key, tfm_ctx->keylen);
+	memcpy(desc->key, tfm_ctx->key, tfm_ctx->keylen);
 
 	ret = versal_pm_aes_key_write(hwreq->size, hwreq->keysrc,
-				      dma_addr_data + key_offset);
+				      desc_addr +
+				      offsetof(struct zynqmp_aead_desc, key));
 	if (ret)
-		goto in_fail;
+		goto err;
 
-	ret = versal_pm_aes_op_init(dma_addr_hw_req);
+	ret = versal_pm_aes_op_init(desc_addr +
+				    offsetof(struct zynqmp_aead_desc,
+					     versal.init));
 	if (ret)
-		goto in_fail;
+		goto err;
 
 	if (req->assoclen > 0) {
 		/* Currently GMAC is OFF by default */
 		ret = versal_pm_aes_update_aad(dma_addr_data, req->assoclen);
 		if (ret)
-			goto in_fail;
+			goto err;
 	}
 
 	in->in_data_addr = dma_addr_data + req->assoclen;
@@ -315,35 +418,34 @@ static int versal_aes_aead_cipher(struct aead_request *req)
 	gcm_offset = req->assoclen + in->size;
 
 	if (rq_ctx->op == ZYNQMP_AES_ENCRYPT) {
-		ret = versal_pm_aes_enc_update(dma_addr_in,
+		ret = versal_pm_aes_enc_update(desc_addr +
+					       offsetof(struct zynqmp_aead_desc,
+							versal.in),
 					       dma_addr_data + req->assoclen);
 		if (ret)
-			goto in_fail;
+			goto err;
 
 		ret = versal_pm_aes_enc_final(dma_addr_data + gcm_offset);
 		if (ret)
-			goto in_fail;
+			goto err;
 	} else {
-		ret = versal_pm_aes_dec_update(dma_addr_in,
+		ret = versal_pm_aes_dec_update(desc_addr +
+					       offsetof(struct zynqmp_aead_desc,
+							versal.in),
 					       dma_addr_data + req->assoclen);
 		if (ret)
-			goto in_fail;
+			goto err;
 
 		ret = versal_pm_aes_dec_final(dma_addr_data + gcm_offset);
 		if (ret)
-			goto in_fail;
+			goto err;
 	}
 
-	sg_copy_from_buffer(req->dst, sg_nents(req->dst),
-			    kbuf, out_len);
-
-in_fail:
-	memzero_explicit(hwreq, sizeof(struct zynqmp_aead_hw_req));
-	dma_free_coherent(dev, sizeof(struct versal_init_ops), hwreq, dma_addr_hw_req);
-hwreq_fail:
-	memzero_explicit(kbuf, dma_size);
-	dma_free_coherent(dev, dma_size, kbuf, dma_addr_data);
 err:
+	zynqmp_aes_unmap_data(drv_ctx, req, kbuf, dma_size, out_len,
+			      dma_addr_data, !ret);
+	memzero_explicit(desc, sizeof(*desc));
+
 	return ret;
 }
 
@@ -410,39 +512,57 @@ static int handle_aes_req(struct crypto_engine *engine, void *req)
 {
 	struct aead_request *areq =
 				container_of(req, struct aead_request, base);
-	struct crypto_aead *aead = crypto_aead_reqtfm(req);
-	struct zynqmp_aead_tfm_ctx *tfm_ctx = crypto_aead_ctx(aead);
-	struct aead_alg *alg = crypto_aead_alg(aead);
-	struct xilinx_aead_drv_ctx *drv_ctx;
-
-	struct zynqmp_aead_req_ctx *rq_ctx = aead_request_ctx(areq);
-	struct aead_request *subreq = aead_request_ctx(req);
-	int need_fallback;
+	struct crypto_aead *aead = crypto_aead_reqtfm(areq);
+	struct xilinx_aead_drv_ctx *drv_ctx = zynqmp_aes_drv_ctx(aead);
 	int err;
 
-	drv_ctx = container_of(alg, struct xilinx_aead_drv_ctx, aead);
-	need_fallback = drv_ctx->fallback_check(tfm_ctx, areq);
-
-	if (need_fallback) {
-		aead_request_set_tfm(subreq, tfm_ctx->fbk_cipher);
-
-		aead_request_set_callback(subreq, areq->base.flags,
-					  NULL, NULL);
-		aead_request_set_crypt(subreq, areq->src, areq->dst,
-				       areq->cryptlen, areq->iv);
-		aead_request_set_ad(subreq, areq->assoclen);
-		if (rq_ctx->op == ZYNQMP_AES_ENCRYPT)
-			err = crypto_aead_encrypt(subreq);
-		else
-			err = crypto_aead_decrypt(subreq);
-	} else {
-		err = drv_ctx->aes_aead_cipher(areq);
-	}
+	err = drv_ctx->aes_aead_cipher(areq);
 
 	crypto_finalize_aead_request(engine, areq, err);
 	return 0;
 }
 
+static int zynqmp_aes_aead_fallback(struct aead_request *req,
+				    enum zynqmp_aead_op op)
+{
+	struct crypto_aead *aead = crypto_aead_reqtfm(req);
+	struct zynqmp_aead_tfm_ctx *tfm_ctx = crypto_aead_ctx(aead);
+	struct aead_request *subreq = aead_request_ctx(req);
+
+	aead_request_set_tfm(subreq, tfm_ctx->fbk_cipher);
+	aead_request_set_callback(subreq, req->base.flags,
+				  req->base.complete, req->base.data);
+	aead_request_set_crypt(subreq, req->src, req->dst,
+			       req->cryptlen, req->iv);
+	aead_request_set_ad(subreq, req->assoclen);
+	if (op == ZYNQMP_AES_ENCRYPT)
+		return crypto_aead_encrypt(subreq);
+
+	return crypto_aead_decrypt(subreq);
+}
+
+/*
+ * Requests the hardware cannot handle, and small requests for which the
+ * firmware round trip costs more than the CPU, run on the fallback right
+ * away instead of waiting for the engine.
+ */
+static int zynqmp_aes_aead_queue(struct aead_request *req,
+				 enum zynqmp_aead_op op)
+{
+	struct crypto_aead *aead = crypto_aead_reqtfm(req);
+	struct zynqmp_aead_tfm_ctx *tfm_ctx = crypto_aead_ctx(aead);
+	struct zynqmp_aead_req_ctx *rq_ctx = aead_request_ctx(req);
+	struct xilinx_aead_drv_ctx *drv_ctx = zynqmp_aes_drv_ctx(aead);
+
+	/* The request context is reused by the fallback request */
+	rq_ctx->op = op;
+	if (drv_ctx->fallback_check(tfm_ctx, req) ||
+	    req->assoclen + req->cryptlen < READ_ONCE(drv_ctx->cpu_threshold))
+		return zynqmp_aes_aead_fallback(req, op);
+
+	return crypto_transfer_aead_request_to_engine(drv_ctx->engine, req);
+}
+
 static int zynqmp_aes_aead_setkey(struct crypto_aead *aead, const u8 *key,
 				  unsigned int keylen)
 {
@@ -525,28 +645,12 @@ static int zynqmp_aes_aead_setauthsize(struct crypto_aead *aead,
 
 static int zynqmp_aes_aead_encrypt(struct aead_request *req)
 {
-	struct xilinx_aead_drv_ctx *drv_ctx;
-	struct crypto_aead *aead = crypto_aead_reqtfm(req);
-	struct aead_alg *alg = crypto_aead_alg(aead);
-	struct zynqmp_aead_req_ctx *rq_ctx = aead_request_ctx(req);
-
-	rq_ctx->op = ZYNQMP_AES_ENCRYPT;
-	drv_ctx = container_of(alg, struct xilinx_aead_drv_ctx, aead);
-
-	return crypto_transfer_aead_request_to_engine(drv_ctx->engine, req);
+	return zynqmp_aes_aead_queue(req, ZYNQMP_AES_ENCRYPT);
 }
 
 static int zynqmp_aes_aead_decrypt(struct aead_request *req)
 {
-	struct xilinx_aead_drv_ctx *drv_ctx;
-	struct crypto_aead *aead = crypto_aead_reqtfm(req);
-	struct aead_alg *alg = crypto_aead_alg(aead);
-	struct zynqmp_aead_req_ctx *rq_ctx = aead_request_ctx(req);
-
-	rq_ctx->op = ZYNQMP_AES_DECRYPT;
-	drv_ctx = container_of(alg, struct xilinx_aead_drv_ctx, aead);
-
-	return crypto_transfer_aead_request_to_engine(drv_ctx->engine, req);
+	return zynqmp_aes_aead_queue(req, ZYNQMP_AES_DECRYPT);
 }
 
 static int aes_aead_init(struct crypto_aead *aead)
@@ -666,6 +770,95 @@ static struct xlnx_feature aes_feature_map[] = {
 	{ /* sentinel */ }
 };
 
+static s64 zynqmp_aes_time(struct crypto_aead *tfm, u8 *buf, unsigned int len)
+{
+	u8 iv[GCM_AES_IV_SIZE] = { 0 };
+	struct aead_request *req;
+	struct scatterlist sg;
+	DECLARE_CRYPTO_WAIT(wait);
+	unsigned int i;
+	ktime_t start;
+	int ret = 0;
+
+	req = aead_request_alloc(tfm, GFP_KERNEL);
+	if (!req)
+		return -ENOMEM;
+
+	sg_init_one(&sg, buf, len + ZYNQMP_AES_AUTH_SIZE);
+	aead_request_set_callback(req, CRYPTO_TFM_REQ_MAY_BACKLOG |
+				  CRYPTO_TFM_REQ_MAY_SLEEP,
+				  crypto_req_done, &wait);
+	aead_request_set_crypt(req, &sg, &sg, len, iv);
+	aead_request_set_ad(req, 0);
+
+	start = ktime_get();
+	for (i = 0; i < ZYNQMP_AES_CALIB_LOOPS && !ret; i++)
+		ret = crypto_wait_req(crypto_aead_encrypt(req), &wait);
+
+	aead_request_free(req);
+
+	return ret ? ret : ktime_to_ns(ktime_sub(ktime_get(), start));
+}
+
+/*
+ * Find the smallest request size for which the hardware is faster than the
+ * fallback. The fallback uses the ARMv8 crypto extensions when they are
+ * available, which beat the firmware round trip for small requests.
+ */
+static unsigned int zynqmp_aes_calibrate(struct xilinx_aead_drv_ctx *drv_ctx)
+{
+	unsigned int len, threshold = 0;
+	struct crypto_aead *hw, *sw;
+	u8 key[ZYNQMP_AES_KEY_SIZE];
+	s64 hw_ns, sw_ns;
+	u8 *buf;
+
+	hw = crypto_alloc_aead(drv_ctx->aead.base.cra_driver_name, 0, 0);
+	if (IS_ERR(hw))
+		return 0;
+
+	sw = crypto_alloc_aead(drv_ctx->aead.base.cra_name, 0,
+			       CRYPTO_ALG_NEED_FALLBACK);
+	if (IS_ERR(sw))
+		goto free_hw;
+
+	buf = kzalloc(ZYNQMP_AES_CALIB_MAX_SIZE + ZYNQMP_AES_AUTH_SIZE,
+		      GFP_KERNEL);
+	if (!buf)
+		goto free_sw;
+
+	get_random_bytes(key, sizeof(key));
+	if (crypto_aead_setkey(hw, key, sizeof(key)) ||
+	    crypto_aead_setkey(sw, key, sizeof(key)) ||
+	    crypto_aead_setauthsize(hw, ZYNQMP_AES_AUTH_SIZE) ||
+	    crypto_aead_setauthsize(sw, ZYNQMP_AES_AUTH_SIZE))
+		goto free_buf;
+
+	for (len = ZYNQMP_AES_CALIB_MIN_SIZE; len <= ZYNQMP_AES_CALIB_MAX_SIZE;
+	     len <<= 1) {
+		hw_ns = zynqmp_aes_time(hw, buf, len);
+		sw_ns = zynqmp_aes_time(sw, buf, len);
+		if (hw_ns < 0 || sw_ns < 0) {
+			threshold = 0;
+			break;
+		}
+
+		threshold = len;
+		if (hw_ns <= sw_ns)
+			break;
+	}
+
+free_buf:
+	kfree_sensitive(buf);
+free_sw:
+	crypto_free_aead(sw);
+free_hw:
+	crypto_free_aead(hw);
+	memzero_explicit(key, sizeof(key));
+
+	return threshold;
+}
+
 static int zynqmp_aes_aead_probe(struct platform_device *pdev)
 {
 	struct xilinx_aead_drv_ctx *aes_drv_ctx;
@@ -693,6 +886,16 @@ static int zynqmp_aes_aead_probe(struct platform_device *pdev)
 		return err;
 	}
 
+	aes_drv_ctx->desc = dmam_alloc_coherent(dev,
+						sizeof(*aes_drv_ctx->desc),
+						&aes_drv_ctx->desc_dma_addr,
+						GFP_KERNEL);
+	aes_drv_ctx->buf = dmam_alloc_coherent(dev, ZYNQMP_AES_DMA_BUF_SIZE,
+					       &aes_drv_ctx->buf_dma_addr,
+					       GFP_KERNEL);
+	if (!aes_drv_ctx->desc || !aes_drv_ctx->buf)
+		return -ENOMEM;
+
 	aes_drv_ctx->engine = crypto_engine_alloc_init(dev, 1);
 	if (!aes_drv_ctx->engine) {
 		dev_err(dev, "Cannot alloc AES engine\n");
@@ -711,6 +914,14 @@ static int zynqmp_aes_aead_probe(struct platform_device *pdev)
 		dev_err(dev, "Failed to register AEAD alg.\n");
 		goto err_engine;
 	}
+
+	if (cpu_threshold < 0)
+		aes_drv_ctx->cpu_threshold = zynqmp_aes_calibrate(aes_drv_ctx);
+	else
+		aes_drv_ctx->cpu_threshold = cpu_threshold;
+	dev_info(dev, "Requests below %u bytes use the CPU\n",
+		 aes_drv_ctx->cpu_threshold);
+
 	return 0;
 
 err_engine:
@@ -4,7 +4,7 @@
  * Copyright (c) 2022 Xilinx Inc.
  * Copyright (C) 2022-2023, Advanced Micro Devices, Inc.
  */
-#include <linux/cacheflush.h>
+#include <crypto/engine.h>
 #include <crypto/hash.h>
 #include <crypto/internal/hash.h>
 #include <crypto/sha3.h>
@@ -18,6 +18,7 @@
 #include <linux/module.h>
 #include <linux/of_device.h>
 #include <linux/platform_device.h>
+#include <linux/scatterlist.h>
 
 #define CONTINUE_PACKET		BIT(31)
 #define FIRST_PACKET		BIT(30)
@@ -26,6 +27,7 @@
 
 #define ZYNQMP_DMA_BIT_MASK		32U
 #define ZYNQMP_DMA_ALLOC_FIXED_SIZE	0x1000U
+#define ZYNQMP_SHA_DMA_ALIGN		4U
 
 enum zynqmp_sha_op {
 	ZYNQMP_SHA3_INIT = 1,
@@ -33,181 +35,305 @@ enum zynqmp_sha_op {
 	ZYNQMP_SHA3_FINAL = 4,
 };
 
+/**
+ * struct xilinx_sha_drv_ctx - SHA3 driver context
+ * @sha3_384: SHA3-384 algorithm
+ * @dev: device
+ * @engine: crypto engine serializing the requests to the firmware
+ * @sha_update: pass one data buffer to the firmware
+ * @sha_final: read the digest from the firmware
+ * @ubuf: bounce buffer for data the firmware cannot access directly
+ * @update_dma_addr: DMA address of @ubuf
+ * @fbuf: digest buffer
+ * @final_dma_addr: DMA address of @fbuf
+ *
+ * The buffers are allocated once at probe, the engine runs only one
+ * request at a time.
+ */
 struct xilinx_sha_drv_ctx {
-	struct shash_alg sha3_384;
+	struct ahash_alg sha3_384;
 	struct device *dev;
+	struct crypto_engine *engine;
+	int (*sha_update)(dma_addr_t addr, u32 len, bool first);
+	int (*sha_final)(dma_addr_t addr, bool first);
+	char *ubuf;
+	dma_addr_t update_dma_addr;
+	char *fbuf;
+	dma_addr_t final_dma_addr;
 };
 
 struct zynqmp_sha_tfm_ctx {
-	struct device *dev;
-	struct crypto_shash *fbk_tfm;
+	struct crypto_engine_ctx engine_ctx;
+	struct xilinx_sha_drv_ctx *drv_ctx;
+	struct crypto_ahash *fbk_tfm;
 };
 
-struct zynqmp_sha_desc_ctx {
-	struct shash_desc fbk_req;
+struct zynqmp_sha_req_ctx {
+	/* Must be last, the fallback request context follows it */
+	struct ahash_request fbk_req;
 };
 
-static dma_addr_t update_dma_addr, final_dma_addr;
-static char *ubuf, *fbuf;
-
-static int zynqmp_sha_init_tfm(struct crypto_shash *hash)
+static int zynqmp_sha_update_hw(dma_addr_t addr, u32 len, bool first)
 {
-	const char *fallback_driver_name = crypto_shash_alg_name(hash);
-	struct zynqmp_sha_tfm_ctx *tfm_ctx = crypto_shash_ctx(hash);
-	struct shash_alg *alg = crypto_shash_alg(hash);
-	struct crypto_shash *fallback_tfm;
-	struct xilinx_sha_drv_ctx *drv_ctx;
-
-	drv_ctx = container_of(alg, struct xilinx_sha_drv_ctx, sha3_384);
-	tfm_ctx->dev = drv_ctx->dev;
-
-	/* Allocate a fallback and abort if it failed. */
-	fallback_tfm = crypto_alloc_shash(fallback_driver_name, 0,
-					  CRYPTO_ALG_NEED_FALLBACK);
-	if (IS_ERR(fallback_tfm))
-		return PTR_ERR(fallback_tfm);
+	int ret;
 
-	tfm_ctx->fbk_tfm = fallback_tfm;
-	hash->descsize += crypto_shash_descsize(tfm_ctx->fbk_tfm);
+	if (first) {
+		ret = zynqmp_pm_sha_hash(0, 0, ZYNQMP_SHA3_INIT);
+		if (ret)
+			return ret;
+	}
 
-	return 0;
+	return zynqmp_pm_sha_hash(addr, len, ZYNQMP_SHA3_UPDATE);
 }
 
-static void zynqmp_sha_exit_tfm(struct crypto_shash *hash)
+static int zynqmp_sha_final_hw(dma_addr_t addr, bool first)
 {
-	struct zynqmp_sha_tfm_ctx *tfm_ctx = crypto_shash_ctx(hash);
+	int ret;
 
-	if (tfm_ctx->fbk_tfm) {
-		crypto_free_shash(tfm_ctx->fbk_tfm);
-		tfm_ctx->fbk_tfm = NULL;
+	if (first) {
+		ret = zynqmp_pm_sha_hash(0, 0, ZYNQMP_SHA3_INIT);
+		if (ret)
+			return ret;
 	}
 
-	memzero_explicit(tfm_ctx, sizeof(struct zynqmp_sha_tfm_ctx));
+	return zynqmp_pm_sha_hash(addr, SHA3_384_DIGEST_SIZE,
+				  ZYNQMP_SHA3_FINAL);
 }
 
-static int zynqmp_sha_init(struct shash_desc *desc)
+static int versal_sha_update_hw(dma_addr_t addr, u32 len, bool first)
 {
-	struct zynqmp_sha_desc_ctx *dctx = shash_desc_ctx(desc);
-	struct zynqmp_sha_tfm_ctx *tctx = crypto_shash_ctx(desc->tfm);
+	u32 flag = CONTINUE_PACKET;
+
+	if (first)
+		flag |= FIRST_PACKET;
 
-	dctx->fbk_req.tfm = tctx->fbk_tfm;
-	return crypto_shash_init(&dctx->fbk_req);
+	return versal_pm_sha_hash(addr, 0, len | flag);
 }
 
-static int zynqmp_sha_update(struct shash_desc *desc, const u8 *data, unsigned int length)
+static int versal_sha_final_hw(dma_addr_t addr, bool first)
 {
-	struct zynqmp_sha_desc_ctx *dctx = shash_desc_ctx(desc);
-
-	return crypto_shash_update(&dctx->fbk_req, data, length);
+	return versal_pm_sha_hash(0, addr, first ? FIRST_PACKET : FINAL_PACKET);
 }
 
-static int zynqmp_sha_final(struct shash_desc *desc, u8 *out)
+/*
+ * The firmware reads the data in words, so every buffer has to start on a
+ * word boundary and all but the last one have to be a multiple of words.
+ */
+static bool zynqmp_sha_can_dma(struct ahash_request *req)
 {
-	struct zynqmp_sha_desc_ctx *dctx = shash_desc_ctx(desc);
+	unsigned int remaining = req->nbytes;
+	struct scatterlist *sg;
+
+	for (sg = req->src; sg && remaining; sg = sg_next(sg)) {
+		if (!IS_ALIGNED(sg->offset, ZYNQMP_SHA_DMA_ALIGN))
+			return false;
+		if (sg->length >= remaining)
+			return true;
+		if (!IS_ALIGNED(sg->length, ZYNQMP_SHA_DMA_ALIGN))
+			return false;
+		remaining -= sg->length;
+	}
 
-	return crypto_shash_final(&dctx->fbk_req, out);
+	return !remaining;
 }
 
-static int zynqmp_sha_finup(struct shash_desc *desc, const u8 *data, unsigned int length, u8 *out)
+static int zynqmp_sha_digest_sg(struct xilinx_sha_drv_ctx *drv_ctx,
+				struct ahash_request *req, int nents)
 {
-	struct zynqmp_sha_desc_ctx *dctx = shash_desc_ctx(desc);
+	unsigned int remaining = req->nbytes;
+	struct scatterlist *sg;
+	bool first = true;
+	int i, mapped, ret;
+
+	if (!nents)
+		return drv_ctx->sha_final(drv_ctx->final_dma_addr, true);
+
+	mapped = dma_map_sg(drv_ctx->dev, req->src, nents, DMA_TO_DEVICE);
+	if (!mapped)
+		return -ENOMEM;
+
+	for_each_sg(req->src, sg, mapped, i) {
+		unsigned int len = min(sg_dma_len(sg), remaining);
+
+		if (!len)
+			continue;
+
+		ret = drv_ctx->sha_update(sg_dma_address(sg), len, first);
+		if (ret)
+			goto unmap;
 
-	return crypto_shash_finup(&dctx->fbk_req, data, length, out);
+		first = false;
+		remaining -= len;
+	}
+
+	ret = drv_ctx->sha_final(drv_ctx->final_dma_addr, first);
+
+unmap:
+	dma_unmap_sg(drv_ctx->dev, req->src, nents, DMA_TO_DEVICE);
+
+	return ret;
 }
 
-static int zynqmp_sha_import(struct shash_desc *desc, const void *in)
+static int zynqmp_sha_digest_bounce(struct xilinx_sha_drv_ctx *drv_ctx,
+				    struct ahash_request *req, int nents)
 {
-	struct zynqmp_sha_desc_ctx *dctx = shash_desc_ctx(desc);
-	struct zynqmp_sha_tfm_ctx *tctx = crypto_shash_ctx(desc->tfm);
+	unsigned int update_size, offset = 0;
+	bool first = true;
+	int ret = 0;
+
+	while (offset < req->nbytes) {
+		update_size = min(req->nbytes - offset,
+				  ZYNQMP_DMA_ALLOC_FIXED_SIZE);
+		sg_pcopy_to_buffer(req->src, nents, drv_ctx->ubuf,
+				   update_size, offset);
+
+		ret = drv_ctx->sha_update(drv_ctx->update_dma_addr,
+					  update_size, first);
+		if (ret)
+			break;
 
-	dctx->fbk_req.tfm = tctx->fbk_tfm;
-	return crypto_shash_import(&dctx->fbk_req, in);
+		first = false;
+		offset += update_size;
+	}
+
+	memzero_explicit(drv_ctx->ubuf, ZYNQMP_DMA_ALLOC_FIXED_SIZE);
+	if (ret)
+		return ret;
+
+	return drv_ctx->sha_final(drv_ctx->final_dma_addr, first);
 }
 
-static int zynqmp_sha_export(struct shash_desc *desc, void *out)
+static int zynqmp_sha_handle_req(struct crypto_engine *engine, void *areq)
 {
-	struct zynqmp_sha_desc_ctx *dctx = shash_desc_ctx(desc);
+	struct ahash_request *req =
+		container_of(areq, struct ahash_request, base);
+	struct crypto_ahash *tfm = crypto_ahash_reqtfm(req);
+	struct zynqmp_sha_tfm_ctx *tfm_ctx = crypto_ahash_ctx(tfm);
+	struct xilinx_sha_drv_ctx *drv_ctx = tfm_ctx->drv_ctx;
+	int nents, ret;
+
+	nents = sg_nents_for_len(req->src, req->nbytes);
+	if (nents < 0) {
+		ret = nents;
+		goto finalize;
+	}
+
+	if (zynqmp_sha_can_dma(req))
+		ret = zynqmp_sha_digest_sg(drv_ctx, req, nents);
+	else
+		ret = zynqmp_sha_digest_bounce(drv_ctx, req, nents);
 
-	return crypto_shash_export(&dctx->fbk_req, out);
+	if (!ret)
+		memcpy(req->result, drv_ctx->fbuf, SHA3_384_DIGEST_SIZE);
+	memzero_explicit(drv_ctx->fbuf, SHA3_384_DIGEST_SIZE);
+
+finalize:
+	crypto_finalize_hash_request(engine, req, ret);
+
+	return 0;
 }
 
-static int zynqmp_sha_digest(struct shash_desc *desc, const u8 *data, unsigned int len, u8 *out)
+static int zynqmp_sha_init_tfm(struct crypto_ahash *hash)
 {
-	unsigned int remaining_len = len;
-	int update_size;
-	int ret;
+	const char *fallback_driver_name = crypto_ahash_alg_name(hash);
+	struct zynqmp_sha_tfm_ctx *tfm_ctx = crypto_ahash_ctx(hash);
+	struct crypto_ahash *fallback_tfm;
+	struct ahash_alg *alg;
+
+	alg = __crypto_ahash_alg(crypto_ahash_tfm(hash)->__crt_alg);
+	tfm_ctx->drv_ctx = container_of(alg, struct xilinx_sha_drv_ctx,
+					sha3_384);
+	tfm_ctx->engine_ctx.op.do_one_request = zynqmp_sha_handle_req;
+	tfm_ctx->engine_ctx.op.prepare_request = NULL;
+	tfm_ctx->engine_ctx.op.unprepare_request = NULL;
 
-	ret = zynqmp_pm_sha_hash(0, 0, ZYNQMP_SHA3_INIT);
-	if (ret)
-		return ret;
+	/* Allocate a fallback and abort if it failed. */
+	fallback_tfm = crypto_alloc_ahash(fallback_driver_name, 0,
+					  CRYPTO_ALG_NEED_FALLBACK);
+	if (IS_ERR(fallback_tfm))
+		return PTR_ERR(fallback_tfm);
 
-	while (remaining_len != 0) {
-		memzero_explicit(ubuf, ZYNQMP_DMA_ALLOC_FIXED_SIZE);
-		if (remaining_len >= ZYNQMP_DMA_ALLOC_FIXED_SIZE) {
-			update_size = ZYNQMP_DMA_ALLOC_FIXED_SIZE;
-			remaining_len -= ZYNQMP_DMA_ALLOC_FIXED_SIZE;
-		} else {
-			update_size = remaining_len;
-			remaining_len = 0;
-		}
-		memcpy(ubuf, data, update_size);
-		flush_icache_range((unsigned long)ubuf, (unsigned long)ubuf + update_size);
-		ret = zynqmp_pm_sha_hash(update_dma_addr, update_size, ZYNQMP_SHA3_UPDATE);
-		if (ret)
-			return ret;
+	tfm_ctx->fbk_tfm = fallback_tfm;
+	crypto_ahash_set_reqsize(hash, sizeof(struct zynqmp_sha_req_ctx) +
+				 crypto_ahash_reqsize(fallback_tfm));
+
+	return 0;
+}
 
-		data += update_size;
+static void zynqmp_sha_exit_tfm(struct crypto_ahash *hash)
+{
+	struct zynqmp_sha_tfm_ctx *tfm_ctx = crypto_ahash_ctx(hash);
+
+	if (tfm_ctx->fbk_tfm) {
+		crypto_free_ahash(tfm_ctx->fbk_tfm);
+		tfm_ctx->fbk_tfm = NULL;
 	}
 
-	ret = zynqmp_pm_sha_hash(final_dma_addr, SHA3_384_DIGEST_SIZE, ZYNQMP_SHA3_FINAL);
-	memcpy(out, fbuf, SHA3_384_DIGEST_SIZE);
-	memzero_explicit(fbuf, SHA3_384_DIGEST_SIZE);
+	memzero_explicit(tfm_ctx, sizeof(struct zynqmp_sha_tfm_ctx));
+}
 
-	return ret;
+/*
+ * The firmware cannot save and restore a partial hash, so the incremental
+ * operations are done by the fallback and only the one shot digest is
+ * offloaded.
+ */
+static struct ahash_request *zynqmp_sha_fbk_req(struct ahash_request *req)
+{
+	struct zynqmp_sha_req_ctx *rctx = ahash_request_ctx(req);
+	struct zynqmp_sha_tfm_ctx *tfm_ctx =
+		crypto_ahash_ctx(crypto_ahash_reqtfm(req));
+
+	ahash_request_set_tfm(&rctx->fbk_req, tfm_ctx->fbk_tfm);
+	ahash_request_set_callback(&rctx->fbk_req, req->base.flags,
+				   req->base.complete, req->base.data);
+	ahash_request_set_crypt(&rctx->fbk_req, req->src, req->result,
+				req->nbytes);
+
+	return &rctx->fbk_req;
 }
 
-static int versal_sha_digest(struct shash_desc *desc, const u8 *data,
-			     unsigned int len, u8 *out)
+static int zynqmp_sha_init(struct ahash_request *req)
 {
-	int update_size, ret, flag = FIRST_PACKET;
-	unsigned int remaining_len = len;
-
-	while (remaining_len != 0) {
-		memzero_explicit(ubuf, ZYNQMP_DMA_ALLOC_FIXED_SIZE);
-		if (remaining_len >= ZYNQMP_DMA_ALLOC_FIXED_SIZE) {
-			update_size = ZYNQMP_DMA_ALLOC_FIXED_SIZE;
-			remaining_len -= ZYNQMP_DMA_ALLOC_FIXED_SIZE;
-		} else {
-			update_size = remaining_len;
-			remaining_len = 0;
-		}
+	return crypto_ahash_init(zynqmp_sha_fbk_req(req));
+}
 
-		memcpy(ubuf, data, update_size);
-		flush_icache_range((unsigned long)ubuf,
-				   (unsigned long)ubuf + update_size);
+static int zynqmp_sha_update(struct ahash_request *req)
+{
+	return crypto_ahash_update(zynqmp_sha_fbk_req(req));
+}
 
-		flag |= CONTINUE_PACKET;
-		ret = versal_pm_sha_hash(update_dma_addr, 0,
-					 update_size | flag);
-		if (ret)
-			return ret;
+static int zynqmp_sha_final(struct ahash_request *req)
+{
+	return crypto_ahash_final(zynqmp_sha_fbk_req(req));
+}
 
-		data += update_size;
-		flag = RESET;
-	}
+static int zynqmp_sha_finup(struct ahash_request *req)
+{
+	return crypto_ahash_finup(zynqmp_sha_fbk_req(req));
+}
 
-	flag |= FINAL_PACKET;
-	ret = versal_pm_sha_hash(0, final_dma_addr, flag);
-	if (ret)
-		return ret;
+static int zynqmp_sha_import(struct ahash_request *req, const void *in)
+{
+	return crypto_ahash_import(zynqmp_sha_fbk_req(req), in);
+}
+
+static int zynqmp_sha_export(struct ahash_request *req, void *out)
+{
+	return crypto_ahash_export(zynqmp_sha_fbk_req(req), out);
+}
 
-	memcpy(out, fbuf, SHA3_384_DIGEST_SIZE);
-	memzero_explicit(fbuf, SHA3_384_DIGEST_SIZE);
+static int zynqmp_sha_digest(struct ahash_request *req)
+{
+	struct zynqmp_sha_tfm_ctx *tfm_ctx =
+		crypto_ahash_ctx(crypto_ahash_reqtfm(req));
 
-	return 0;
+	return crypto_transfer_hash_request_to_engine(tfm_ctx->drv_ctx->engine,
+						      req);
 }
 
 static struct xilinx_sha_drv_ctx zynqmp_sha3_drv_ctx = {
+	.sha_update = zynqmp_sha_update_hw,
+	.sha_final = zynqmp_sha_final_hw,
 	.sha3_384 = {
 		.init = zynqmp_sha_init,
 		.update = zynqmp_sha_update,
@@ -218,25 +344,28 @@ static struct xilinx_sha_drv_ctx zynqmp_sha3_drv_ctx = {
 		.import = zynqmp_sha_import,
 		.init_tfm = zynqmp_sha_init_tfm,
 		.exit_tfm = zynqmp_sha_exit_tfm,
-		.descsize = sizeof(struct zynqmp_sha_desc_ctx),
-		.statesize = sizeof(struct sha3_state),
-		.digestsize = SHA3_384_DIGEST_SIZE,
-		.base = {
-			.cra_name = "sha3-384",
-			.cra_driver_name = "zynqmp-sha3-384",
-			.cra_priority = 300,
-			.cra_flags = CRYPTO_ALG_KERN_DRIVER_ONLY |
-				     CRYPTO_ALG_ALLOCATES_MEMORY |
-				     CRYPTO_ALG_NEED_FALLBACK,
-			.cra_blocksize = SHA3_384_BLOCK_SIZE,
-			.cra_ctxsize = sizeof(struct zynqmp_sha_tfm_ctx),
-			.cra_alignmask = 3,
-			.cra_module = THIS_MODULE,
+		.halg = {
+			.statesize = sizeof(struct sha3_state),
+			.digestsize = SHA3_384_DIGEST_SIZE,
+			.base = {
+				.cra_name = "sha3-384",
+				.cra_driver_name = "zynqmp-sha3-384",
+				.cra_priority = 300,
+				.cra_flags = CRYPTO_ALG_ASYNC |
+					     CRYPTO_ALG_KERN_DRIVER_ONLY |
+					     CRYPTO_ALG_ALLOCATES_MEMORY |
+					     CRYPTO_ALG_NEED_FALLBACK,
+				.cra_blocksize = SHA3_384_BLOCK_SIZE,
+				.cra_ctxsize = sizeof(struct zynqmp_sha_tfm_ctx),
+				.cra_module = THIS_MODULE,
+			}
 		}
 	}
 };
 
 static struct xilinx_sha_drv_ctx versal_sha3_drv_ctx = {
+	.sha_update = versal_sha_update_hw,
+	.sha_final = versal_sha_final_hw,
 	.sha3_384 = {
 		.init = zynqmp_sha_init,
 		.update = zynqmp_sha_update,
@@ -244,23 +373,24 @@ static struct xilinx_sha_drv_ctx versal_sha3_drv_ctx = {
 		.finup = zynqmp_sha_finup,
 		.export = zynqmp_sha_export,
 		.import = zynqmp_sha_import,
-		.digest = versal_sha_digest,
+		.digest = zynqmp_sha_digest,
 		.init_tfm = zynqmp_sha_init_tfm,
 		.exit_tfm = zynqmp_sha_exit_tfm,
-		.descsize = sizeof(struct zynqmp_sha_desc_ctx),
-		.statesize = sizeof(struct sha3_state),
-		.digestsize = SHA3_384_DIGEST_SIZE,
-		.base = {
-			.cra_name = "sha3-384",
-			.cra_driver_name = "versal-sha3-384",
-			.cra_priority = 300,
-			.cra_flags = CRYPTO_ALG_KERN_DRIVER_ONLY |
-				CRYPTO_ALG_ALLOCATES_MEMORY |
-				CRYPTO_ALG_NEED_FALLBACK,
-			.cra_blocksize = SHA3_384_BLOCK_SIZE,
-			.cra_ctxsize = sizeof(struct zynqmp_sha_tfm_ctx),
-			.cra_alignmask = 3,
-			.cra_module = THIS_MODULE,
+		.halg = {
+			.statesize = sizeof(struct sha3_state),
+			.digestsize = SHA3_384_DIGEST_SIZE,
+			.base = {
+				.cra_name = "sha3-384",
+				.cra_driver_name = "versal-sha3-384",
+				.cra_priority = 300,
+				.cra_flags = CRYPTO_ALG_ASYNC |
+					     CRYPTO_ALG_KERN_DRIVER_ONLY |
+					     CRYPTO_ALG_ALLOCATES_MEMORY |
+					     CRYPTO_ALG_NEED_FALLBACK,
+				.cra_blocksize = SHA3_384_BLOCK_SIZE,
+				.cra_ctxsize = sizeof(struct zynqmp_sha_tfm_ctx),
+				.cra_module = THIS_MODULE,
+			}
 		}
 	}
 };
@@ -303,30 +433,50 @@ static int zynqmp_sha_probe(struct platform_device *pdev)
 	sha3_drv_ctx->dev = dev;
 	platform_set_drvdata(pdev, sha3_drv_ctx);
 
-	ubuf = dma_alloc_coherent(dev, ZYNQMP_DMA_ALLOC_FIXED_SIZE, &update_dma_addr, GFP_KERNEL);
-	if (!ubuf) {
+	sha3_drv_ctx->ubuf = dma_alloc_coherent(dev, ZYNQMP_DMA_ALLOC_FIXED_SIZE,
+						&sha3_drv_ctx->update_dma_addr,
+						GFP_KERNEL);
+	if (!sha3_drv_ctx->ubuf)
+		return -ENOMEM;
+
+	sha3_drv_ctx->fbuf = dma_alloc_coherent(dev, SHA3_384_DIGEST_SIZE,
+						&sha3_drv_ctx->final_dma_addr,
+						GFP_KERNEL);
+	if (!sha3_drv_ctx->fbuf) {
 		err = -ENOMEM;
-		return err;
+		goto err_mem;
 	}
 
-	fbuf = dma_alloc_coherent(dev, SHA3_384_DIGEST_SIZE, &final_dma_addr, GFP_KERNEL);
-	if (!fbuf) {
+	sha3_drv_ctx->engine = crypto_engine_alloc_init(dev, 1);
+	if (!sha3_drv_ctx->engine) {
+		dev_err(dev, "Cannot alloc SHA engine\n");
 		err = -ENOMEM;
-		goto err_mem;
+		goto err_mem1;
+	}
+
+	err = crypto_engine_start(sha3_drv_ctx->engine);
+	if (err) {
+		dev_err(dev, "Cannot start SHA engine\n");
+		goto err_engine;
 	}
 
-	err = crypto_register_shash(&sha3_drv_ctx->sha3_384);
+	err = crypto_register_ahash(&sha3_drv_ctx->sha3_384);
 	if (err < 0) {
-		dev_err(dev, "Failed to register shash alg.\n");
-		goto err_mem1;
+		dev_err(dev, "Failed to register ahash alg.\n");
+		goto err_engine;
 	}
 	return 0;
 
+err_engine:
+	crypto_engine_exit(sha3_drv_ctx->engine);
+
 err_mem1:
-	dma_free_coherent(dev, SHA3_384_DIGEST_SIZE, fbuf, final_dma_addr);
+	dma_free_coherent(dev, SHA3_384_DIGEST_SIZE, sha3_drv_ctx->fbuf,
+			  sha3_drv_ctx->final_dma_addr);
 
 err_mem:
-	dma_free_coherent(dev, ZYNQMP_DMA_ALLOC_FIXED_SIZE, ubuf, update_dma_addr);
+	dma_free_coherent(dev, ZYNQMP_DMA_ALLOC_FIXED_SIZE, sha3_drv_ctx->ubuf,
+			  sha3_drv_ctx->update_dma_addr);
 
 	return err;
 }
@@ -337,11 +487,12 @@ static int zynqmp_sha_remove(struct platform_device *pdev)
 
 	sha3_drv_ctx = platform_get_drvdata(pdev);
 
-	dma_free_coherent(sha3_drv_ctx->dev,
-			  ZYNQMP_DMA_ALLOC_FIXED_SIZE, ubuf, update_dma_addr);
-	dma_free_coherent(sha3_drv_ctx->dev,
-			  SHA3_384_DIGEST_SIZE, fbuf, final_dma_addr);
-	crypto_unregister_shash(&sha3_drv_ctx->sha3_384);
+	crypto_unregister_ahash(&sha3_drv_ctx->sha3_384);
+	crypto_engine_exit(sha3_drv_ctx->engine);
+	dma_free_coherent(sha3_drv_ctx->dev, ZYNQMP_DMA_ALLOC_FIXED_SIZE,
+			  sha3_drv_ctx->ubuf, sha3_drv_ctx->update_dma_addr);
+	dma_free_coherent(sha3_drv_ctx->dev, SHA3_384_DIGEST_SIZE,
+			  sha3_drv_ctx->fbuf, sha3_drv_ctx->final_dma_addr);
 
 	return 0;
 }
@@ -10,6 +10,7 @@
 #include <linux/debugfs.h>
 #include <linux/device.h>
 #include <linux/dma-buf.h>
+#include <linux/dma-mapping.h>
 #include <linux/err.h>
 #include <linux/xarray.h>
 #include <linux/list.h>
@@ -216,6 +217,38 @@ const char *dma_heap_get_name(struct dma_heap *heap)
 	return heap->name;
 }
 
+void dma_heap_sync_sgtable_range(struct device *dev, struct sg_table *sgt,
+				 size_t offset, size_t len,
+				 enum dma_data_direction dir, bool for_cpu)
+{
+	struct scatterlist *sg;
+	size_t seg_off, seg_len;
+	int i;
+
+	/* DMA segments cover the buffer in order, whatever the merging */
+	for_each_sgtable_dma_sg(sgt, sg, i) {
+		if (!len)
+			break;
+
+		if (offset >= sg_dma_len(sg)) {
+			offset -= sg_dma_len(sg);
+			continue;
+		}
+
+		seg_off = offset;
+		seg_len = min_t(size_t, len, sg_dma_len(sg) - seg_off);
+		if (for_cpu)
+			dma_sync_single_range_for_cpu(dev, sg_dma_address(sg),
+						      seg_off, seg_len, dir);
+		else
+			dma_sync_single_range_for_device(dev,
+							 sg_dma_address(sg),
+							 seg_off, seg_len, dir);
+		offset = 0;
+		len -= seg_len;
+	}
+}
+
 struct dma_heap *dma_heap_add(const struct dma_heap_export_info *exp_info)
 {
 	struct dma_heap *heap, *h, *err_ret;
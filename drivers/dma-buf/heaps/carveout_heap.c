@@ -0,0 +1,464 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * DMABUF carveout heap exporter
+ *
+ * Copyright (C) 2023 Xilinx, Inc.
+ *
+ * Based on the DMABUF CMA heap exporter:
+ * Copyright (C) 2012, 2019, 2020 Linaro Ltd.
+ *
+ * Exposes each reserved-memory region compatible with
+ * "xlnx,dma-heap-carveout" as a heap named after the region, so PL-DDR
+ * and other dedicated carveouts can be shared between V4L2, DRM and
+ * accelerator drivers without each having its own allocator. Buffers are
+ * CPU cached; DMA_BUF_IOCTL_SYNC does the cache maintenance.
+ */
+#include <linux/dma-buf.h>
+#include <linux/dma-heap.h>
+#include <linux/dma-mapping.h>
+#include <linux/err.h>
+#include <linux/genalloc.h>
+#include <linux/highmem.h>
+#include <linux/mm.h>
+#include <linux/module.h>
+#include <linux/of_fdt.h>
+#include <linux/of_reserved_mem.h>
+#include <linux/scatterlist.h>
+#include <linux/slab.h>
+#include <linux/vmalloc.h>
+
+#define MAX_CARVEOUT_HEAPS	8
+
+static struct reserved_mem *carveout_regions[MAX_CARVEOUT_HEAPS] __initdata;
+static unsigned int carveout_num_regions __initdata;
+
+struct carveout_heap {
+	struct dma_heap *heap;
+	struct gen_pool *pool;
+};
+
+struct carveout_heap_buffer {
+	struct carveout_heap *heap;
+	struct list_head attachments;
+	struct mutex lock;
+	unsigned long len;
+	phys_addr_t paddr;
+	struct page **pages;
+	pgoff_t pagecount;
+	int vmap_cnt;
+	void *vaddr;
+};
+
+struct dma_heap_attachment {
+	struct device *dev;
+	struct sg_table table;
+	struct list_head list;
+	bool mapped;
+};
+
+static int carveout_heap_attach(struct dma_buf *dmabuf,
+				struct dma_buf_attachment *attachment)
+{
+	struct carveout_heap_buffer *buffer = dmabuf->priv;
+	struct dma_heap_attachment *a;
+	int ret;
+
+	a = kzalloc(sizeof(*a), GFP_KERNEL);
+	if (!a)
+		return -ENOMEM;
+
+	/* Buffers are physically contiguous, one entry is enough */
+	ret = sg_alloc_table(&a->table, 1, GFP_KERNEL);
+	if (ret) {
+		kfree(a);
+		return ret;
+	}
+	sg_set_page(a->table.sgl, buffer->pages[0], buffer->len, 0);
+
+	a->dev = attachment->dev;
+	INIT_LIST_HEAD(&a->list);
+	a->mapped = false;
+
+	attachment->priv = a;
+
+	mutex_lock(&buffer->lock);
+	list_add(&a->list, &buffer->attachments);
+	mutex_unlock(&buffer->lock);
+
+	return 0;
+}
+
+static void carveout_heap_detach(struct dma_buf *dmabuf,
+				 struct dma_buf_attachment *attachment)
+{
+	struct carveout_heap_buffer *buffer = dmabuf->priv;
+	struct dma_heap_attachment *a = attachment->priv;
+
+	mutex_lock(&buffer->lock);
+	list_del(&a->list);
+	mutex_unlock(&buffer->lock);
+
+	sg_free_table(&a->table);
+	kfree(a);
+}
+
+static struct sg_table *
+carveout_heap_map_dma_buf(struct dma_buf_attachment *attachment,
+			  enum dma_data_direction direction)
+{
+	struct dma_heap_attachment *a = attachment->priv;
+	struct sg_table *table = &a->table;
+	int ret;
+
+	ret = dma_map_sgtable(attachment->dev, table, direction, 0);
+	if (ret)
+		return ERR_PTR(-ENOMEM);
+	a->mapped = true;
+	return table;
+}
+
+static void carveout_heap_unmap_dma_buf(struct dma_buf_attachment *attachment,
+					struct sg_table *table,
+					enum dma_data_direction direction)
+{
+	struct dma_heap_attachment *a = attachment->priv;
+
+	a->mapped = false;
+	dma_unmap_sgtable(attachment->dev, table, direction, 0);
+}
+
+static int
+carveout_heap_dma_buf_begin_cpu_access_partial(struct dma_buf *dmabuf,
+					       enum dma_data_direction direction,
+					       size_t offset, size_t len)
+{
+	struct carveout_heap_buffer *buffer = dmabuf->priv;
+	struct dma_heap_attachment *a;
+
+	mutex_lock(&buffer->lock);
+
+	if (buffer->vmap_cnt)
+		invalidate_kernel_vmap_range(buffer->vaddr + offset, len);
+
+	list_for_each_entry(a, &buffer->attachments, list) {
+		if (!a->mapped)
+			continue;
+		dma_heap_sync_sgtable_range(a->dev, &a->table, offset, len,
+					    direction, true);
+	}
+	mutex_unlock(&buffer->lock);
+
+	return 0;
+}
+
+static int
+carveout_heap_dma_buf_end_cpu_access_partial(struct dma_buf *dmabuf,
+					     enum dma_data_direction direction,
+					     size_t offset, size_t len)
+{
+	struct carveout_heap_buffer *buffer = dmabuf->priv;
+	struct dma_heap_attachment *a;
+
+	mutex_lock(&buffer->lock);
+
+	if (buffer->vmap_cnt)
+		flush_kernel_vmap_range(buffer->vaddr + offset, len);
+
+	list_for_each_entry(a, &buffer->attachments, list) {
+		if (!a->mapped)
+			continue;
+		dma_heap_sync_sgtable_range(a->dev, &a->table, offset, len,
+					    direction, false);
+	}
+	mutex_unlock(&buffer->lock);
+
+	return 0;
+}
+
+static int
+carveout_heap_dma_buf_begin_cpu_access(struct dma_buf *dmabuf,
+				       enum dma_data_direction direction)
+{
+	return carveout_heap_dma_buf_begin_cpu_access_partial(dmabuf, direction,
+							      0, dmabuf->size);
+}
+
+static int
+carveout_heap_dma_buf_end_cpu_access(struct dma_buf *dmabuf,
+				     enum dma_data_direction direction)
+{
+	return carveout_heap_dma_buf_end_cpu_access_partial(dmabuf, direction,
+							    0, dmabuf->size);
+}
+
+static vm_fault_t carveout_heap_vm_fault(struct vm_fault *vmf)
+{
+	struct vm_area_struct *vma = vmf->vma;
+	struct carveout_heap_buffer *buffer = vma->vm_private_data;
+
+	if (vmf->pgoff >= buffer->pagecount)
+		return VM_FAULT_SIGBUS;
+
+	vmf->page = buffer->pages[vmf->pgoff];
+	get_page(vmf->page);
+
+	return 0;
+}
+
+static const struct vm_operations_struct dma_heap_vm_ops = {
+	.fault = carveout_heap_vm_fault,
+};
+
+static int carveout_heap_mmap(struct dma_buf *dmabuf,
+			      struct vm_area_struct *vma)
+{
+	struct carveout_heap_buffer *buffer = dmabuf->priv;
+
+	if ((vma->vm_flags & (VM_SHARED | VM_MAYSHARE)) == 0)
+		return -EINVAL;
+
+	vma->vm_ops = &dma_heap_vm_ops;
+	vma->vm_private_data = buffer;
+
+	return 0;
+}
+
+static int carveout_heap_vmap(struct dma_buf *dmabuf, struct iosys_map *map)
+{
+	struct carveout_heap_buffer *buffer = dmabuf->priv;
+	void *vaddr;
+	int ret = 0;
+
+	mutex_lock(&buffer->lock);
+	if (buffer->vmap_cnt) {
+		buffer->vmap_cnt++;
+		iosys_map_set_vaddr(map, buffer->vaddr);
+		goto out;
+	}
+
+	vaddr = vmap(buffer->pages, buffer->pagecount, VM_MAP, PAGE_KERNEL);
+	if (!vaddr) {
+		ret = -ENOMEM;
+		goto out;
+	}
+	buffer->vaddr = vaddr;
+	buffer->vmap_cnt++;
+	iosys_map_set_vaddr(map, buffer->vaddr);
+out:
+	mutex_unlock(&buffer->lock);
+
+	return ret;
+}
+
+static void carveout_heap_vunmap(struct dma_buf *dmabuf, struct iosys_map *map)
+{
+	struct carveout_heap_buffer *buffer = dmabuf->priv;
+
+	mutex_lock(&buffer->lock);
+	if (!--buffer->vmap_cnt) {
+		vunmap(buffer->vaddr);
+		buffer->vaddr = NULL;
+	}
+	mutex_unlock(&buffer->lock);
+	iosys_map_clear(map);
+}
+
+static void carveout_heap_dma_buf_release(struct dma_buf *dmabuf)
+{
+	struct carveout_heap_buffer *buffer = dmabuf->priv;
+	struct carveout_heap *carveout_heap = buffer->heap;
+
+	if (buffer->vmap_cnt > 0) {
+		WARN(1, "%s: buffer still mapped in the kernel\n", __func__);
+		vunmap(buffer->vaddr);
+		buffer->vaddr = NULL;
+	}
+
+	kfree(buffer->pages);
+	gen_pool_free(carveout_heap->pool, buffer->paddr, buffer->len);
+	kfree(buffer);
+}
+
+static const struct dma_buf_ops carveout_heap_buf_ops = {
+	.attach = carveout_heap_attach,
+	.detach = carveout_heap_detach,
+	.map_dma_buf = carveout_heap_map_dma_buf,
+	.unmap_dma_buf = carveout_heap_unmap_dma_buf,
+	.begin_cpu_access = carveout_heap_dma_buf_begin_cpu_access,
+	.end_cpu_access = carveout_heap_dma_buf_end_cpu_access,
+	.begin_cpu_access_partial =
+		carveout_heap_dma_buf_begin_cpu_access_partial,
+	.end_cpu_access_partial = carveout_heap_dma_buf_end_cpu_access_partial,
+	.mmap = carveout_heap_mmap,
+	.vmap = carveout_heap_vmap,
+	.vunmap = carveout_heap_vunmap,
+	.release = carveout_heap_dma_buf_release,
+};
+
+static struct dma_buf *carveout_heap_allocate(struct dma_heap *heap,
+					      unsigned long len,
+					      unsigned long fd_flags,
+					      unsigned long heap_flags)
+{
+	struct carveout_heap *carveout_heap = dma_heap_get_drvdata(heap);
+	struct carveout_heap_buffer *buffer;
+	DEFINE_DMA_BUF_EXPORT_INFO(exp_info);
+	size_t size = PAGE_ALIGN(len);
+	pgoff_t pagecount = size >> PAGE_SHIFT;
+	struct page *page;
+	struct dma_buf *dmabuf;
+	int ret = -ENOMEM;
+	pgoff_t pg;
+
+	buffer = kzalloc(sizeof(*buffer), GFP_KERNEL);
+	if (!buffer)
+		return ERR_PTR(-ENOMEM);
+
+	INIT_LIST_HEAD(&buffer->attachments);
+	mutex_init(&buffer->lock);
+	buffer->len = size;
+
+	buffer->paddr = gen_pool_alloc(carveout_heap->pool, size);
+	if (!buffer->paddr)
+		goto free_buffer;
+
+	buffer->pages = kmalloc_array(pagecount, sizeof(*buffer->pages),
+				      GFP_KERNEL);
+	if (!buffer->pages)
+		goto free_carveout;
+
+	page = pfn_to_page(PHYS_PFN(buffer->paddr));
+	for (pg = 0; pg < pagecount; pg++) {
+		buffer->pages[pg] = nth_page(page, pg);
+		clear_highpage(buffer->pages[pg]);
+		/*
+		 * Avoid wasting time zeroing memory if the process
+		 * has been killed by SIGKILL
+		 */
+		if (fatal_signal_pending(current))
+			goto free_pages;
+	}
+
+	buffer->heap = carveout_heap;
+	buffer->pagecount = pagecount;
+
+	/* create the dmabuf */
+	exp_info.exp_name = dma_heap_get_name(heap);
+	exp_info.ops = &carveout_heap_buf_ops;
+	exp_info.size = buffer->len;
+	exp_info.flags = fd_flags;
+	exp_info.priv = buffer;
+	dmabuf = dma_buf_export(&exp_info);
+	if (IS_ERR(dmabuf)) {
+		ret = PTR_ERR(dmabuf);
+		goto free_pages;
+	}
+	return dmabuf;
+
+free_pages:
+	kfree(buffer->pages);
+free_carveout:
+	gen_pool_free(carveout_heap->pool, buffer->paddr, size);
+free_buffer:
+	kfree(buffer);
+
+	return ERR_PTR(ret);
+}
+
+static const struct dma_heap_ops carveout_heap_ops = {
+	.allocate = carveout_heap_allocate,
+};
+
+static int __init __add_carveout_heap(struct reserved_mem *rmem)
+{
+	struct carveout_heap *carveout_heap;
+	struct dma_heap_export_info exp_info;
+	int ret;
+
+	carveout_heap = kzalloc(sizeof(*carveout_heap), GFP_KERNEL);
+	if (!carveout_heap)
+		return -ENOMEM;
+
+	carveout_heap->pool = gen_pool_create(PAGE_SHIFT, NUMA_NO_NODE);
+	if (!carveout_heap->pool) {
+		ret = -ENOMEM;
+		goto free_heap;
+	}
+
+	ret = gen_pool_add(carveout_heap->pool, rmem->base, rmem->size,
+			   NUMA_NO_NODE);
+	if (ret)
+		goto destroy_pool;
+
+	/* Node names carry the unit address, the heap name doesn't need it */
+	exp_info.name = kstrndup(rmem->name, strcspn(rmem->name, "@"),
+				 GFP_KERNEL);
+	if (!exp_info.name) {
+		ret = -ENOMEM;
+		goto destroy_pool;
+	}
+	exp_info.ops = &carveout_heap_ops;
+	exp_info.priv = carveout_heap;
+
+	carveout_heap->heap = dma_heap_add(&exp_info);
+	if (IS_ERR(carveout_heap->heap)) {
+		ret = PTR_ERR(carveout_heap->heap);
+		kfree(exp_info.name);
+		goto destroy_pool;
+	}
+
+	return 0;
+
+destroy_pool:
+	gen_pool_destroy(carveout_heap->pool);
+free_heap:
+	kfree(carveout_heap);
+
+	return ret;
+}
+
+static int __init add_carveout_heaps(void)
+{
+	unsigned int i;
+	int ret;
+
+	for (i = 0; i < carveout_num_regions; i++) {
+		ret = __add_carveout_heap(carveout_regions[i]);
+		if (ret)
+			pr_err("carveout heap: failed to add %s: %d\n",
+			       carveout_regions[i]->name, ret);
+	}
+
+	return 0;
+}
+module_init(add_carveout_heaps);
+
+static int __init rmem_carveout_heap_setup(struct reserved_mem *rmem)
+{
+	unsigned long node = rmem->fdt_node;
+
+	/* begin/end_cpu_access and mmap need the region in the linear map */
+	if (of_get_flat_dt_prop(node, "no-map", NULL)) {
+		pr_err("carveout heap: %s can't be no-map\n", rmem->name);
+		return -EINVAL;
+	}
+
+	if (!PAGE_ALIGNED(rmem->base) || !PAGE_ALIGNED(rmem->size)) {
+		pr_err("carveout heap: %s isn't page aligned\n", rmem->name);
+		return -EINVAL;
+	}
+
+	if (carveout_num_regions == MAX_CARVEOUT_HEAPS) {
+		pr_err("carveout heap: too many regions, ignoring %s\n",
+		       rmem->name);
+		return -ENOSPC;
+	}
+
+	carveout_regions[carveout_num_regions++] = rmem;
+
+	return 0;
+}
+RESERVEDMEM_OF_DECLARE(dma_heap_carveout, "xlnx,dma-heap-carveout",
+		       rmem_carveout_heap_setup);
+MODULE_DESCRIPTION("DMA-BUF Carveout Heap");
+MODULE_LICENSE("GPL");
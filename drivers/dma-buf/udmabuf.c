@@ -2,6 +2,7 @@
 #include <linux/cred.h>
 #include <linux/device.h>
 #include <linux/dma-buf.h>
+#include <linux/dma-mapping.h>
 #include <linux/highmem.h>
 #include <linux/init.h>
 #include <linux/kernel.h>
@@ -61,15 +62,24 @@ static struct sg_table *get_sg_table(struct device *dev, struct dma_buf *buf,
 				     enum dma_data_direction direction)
 {
 	struct udmabuf *ubuf = buf->priv;
+	size_t max_segment;
 	struct sg_table *sg;
 	int ret;
 
+	/*
+	 * Physically contiguous pages, e.g. the subpages of a hugetlb memfd,
+	 * are merged into one entry as long as the device can map it: a
+	 * bounce buffered mapping can't be larger than the bounce buffer.
+	 */
+	max_segment = min_t(size_t, dma_max_mapping_size(dev), UINT_MAX);
+
 	sg = kzalloc(sizeof(*sg), GFP_KERNEL);
 	if (!sg)
 		return ERR_PTR(-ENOMEM);
-	ret = sg_alloc_table_from_pages(sg, ubuf->pages, ubuf->pagecount,
-					0, ubuf->pagecount << PAGE_SHIFT,
-					GFP_KERNEL);
+	ret = sg_alloc_table_from_pages_segment(sg, ubuf->pages,
+						ubuf->pagecount, 0,
+						ubuf->pagecount << PAGE_SHIFT,
+						max_segment, GFP_KERNEL);
 	if (ret < 0)
 		goto err;
 	ret = dma_map_sgtable(dev, sg, direction, 0);
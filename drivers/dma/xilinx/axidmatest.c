@@ -10,6 +10,7 @@
  * it under the terms of the GNU General Public License version 2 as
  * published by the Free Software Foundation.
  */
+#include <linux/debugfs.h>
 #include <linux/delay.h>
 #include <linux/dmaengine.h>
 #include <linux/init.h>
@@ -23,6 +24,8 @@
 #include <linux/sched/task.h>
 #include <linux/dma/xilinx_dma.h>
 
+#include "xilinx_dmatest_bench.h"
+
 static unsigned int test_buf_size = 16384;
 module_param(test_buf_size, uint, 0444);
 MODULE_PARM_DESC(test_buf_size, "Size of the memcpy test buffer");
@@ -32,6 +35,20 @@ module_param(iterations, uint, 0444);
 MODULE_PARM_DESC(iterations,
 		 "Iterations before stopping test (default: infinite)");
 
+static unsigned int sg_len = 11;
+module_param(sg_len, uint, 0444);
+MODULE_PARM_DESC(sg_len, "Number of SG entries per transfer (default: 11)");
+
+static bool benchmark;
+module_param(benchmark, bool, 0444);
+MODULE_PARM_DESC(benchmark,
+		 "Skip data verification and report throughput and latency in debugfs");
+
+static unsigned int bench_samples = 4096;
+module_param(bench_samples, uint, 0444);
+MODULE_PARM_DESC(bench_samples,
+		 "Number of latency samples kept per thread (default: 4096)");
+
 /*
  * Initialization patterns. All bytes in the source buffer has bit 7
  * set, all bytes in the destination buffer has bit 7 cleared.
@@ -49,8 +66,6 @@ MODULE_PARM_DESC(iterations,
 #define PATTERN_OVERWRITE	0x20
 #define PATTERN_COUNT_MASK	0x1f
 
-#define XILINX_DMATEST_BD_CNT	11
-
 struct dmatest_slave_thread {
 	struct list_head node;
 	struct task_struct *task;
@@ -60,6 +75,7 @@ struct dmatest_slave_thread {
 	u8 **dsts;
 	enum dma_transaction_type type;
 	bool done;
+	struct xilinx_dmatest_bench bench;
 };
 
 struct dmatest_chan {
@@ -75,6 +91,7 @@ struct dmatest_chan {
 static DECLARE_WAIT_QUEUE_HEAD(thread_wait);
 static LIST_HEAD(dmatest_channels);
 static unsigned int nr_channels;
+static struct dentry *dmatest_debugfs_dir;
 
 static unsigned long long dmatest_persec(s64 runtime, unsigned int val)
 {
@@ -242,8 +259,12 @@ static int dmatest_slave_func(void *data)
 	int ret;
 	int src_cnt;
 	int dst_cnt;
-	int bd_cnt = XILINX_DMATEST_BD_CNT;
+	int bd_cnt = max(sg_len, 1U);
 	int i;
+	dma_addr_t *dma_srcs;
+	dma_addr_t *dma_dsts;
+	struct scatterlist *tx_sg;
+	struct scatterlist *rx_sg;
 
 	ktime_t	ktime, start, diff;
 	ktime_t	filltime = 0;
@@ -281,27 +302,32 @@ static int dmatest_slave_func(void *data)
 	}
 	thread->dsts[i] = NULL;
 
+	dma_srcs = kcalloc(src_cnt, sizeof(*dma_srcs), GFP_KERNEL);
+	dma_dsts = kcalloc(dst_cnt, sizeof(*dma_dsts), GFP_KERNEL);
+	tx_sg = kcalloc(bd_cnt, sizeof(*tx_sg), GFP_KERNEL);
+	rx_sg = kcalloc(bd_cnt, sizeof(*rx_sg), GFP_KERNEL);
+	if (!dma_srcs || !dma_dsts || !tx_sg || !rx_sg)
+		goto err_sg;
+
 	set_user_nice(current, 10);
 
 	flags = DMA_CTRL_ACK | DMA_PREP_INTERRUPT;
 
 	ktime = ktime_get();
+	xilinx_dmatest_bench_start(&thread->bench);
 	while (!kthread_should_stop() &&
 	       !(iterations && total_tests >= iterations)) {
 		struct dma_device *tx_dev = tx_chan->device;
 		struct dma_device *rx_dev = rx_chan->device;
 		struct dma_async_tx_descriptor *txd = NULL;
 		struct dma_async_tx_descriptor *rxd = NULL;
-		dma_addr_t dma_srcs[XILINX_DMATEST_BD_CNT];
-		dma_addr_t dma_dsts[XILINX_DMATEST_BD_CNT];
 		struct completion rx_cmp;
 		struct completion tx_cmp;
 		unsigned long rx_tmo =
 				msecs_to_jiffies(300000); /* RX takes longer */
 		unsigned long tx_tmo = msecs_to_jiffies(30000);
 		u8 align = 0;
-		struct scatterlist tx_sg[XILINX_DMATEST_BD_CNT];
-		struct scatterlist rx_sg[XILINX_DMATEST_BD_CNT];
+		ktime_t issued;
 
 		total_tests++;
 
@@ -316,21 +342,28 @@ static int dmatest_slave_func(void *data)
 			break;
 		}
 
-		len = dmatest_random() % test_buf_size + 1;
-		len = (len >> align) << align;
-		if (!len)
-			len = 1 << align;
-		src_off = dmatest_random() % (test_buf_size - len + 1);
-		dst_off = dmatest_random() % (test_buf_size - len + 1);
-
-		src_off = (src_off >> align) << align;
-		dst_off = (dst_off >> align) << align;
-
-		start = ktime_get();
-		dmatest_init_srcs(thread->srcs, src_off, len);
-		dmatest_init_dsts(thread->dsts, dst_off, len);
-		diff = ktime_sub(ktime_get(), start);
-		filltime = ktime_add(filltime, diff);
+		if (benchmark) {
+			/* Fixed size, aligned transfers without data checks */
+			len = (test_buf_size >> align) << align;
+			src_off = 0;
+			dst_off = 0;
+		} else {
+			len = dmatest_random() % test_buf_size + 1;
+			len = (len >> align) << align;
+			if (!len)
+				len = 1 << align;
+			src_off = dmatest_random() % (test_buf_size - len + 1);
+			dst_off = dmatest_random() % (test_buf_size - len + 1);
+
+			src_off = (src_off >> align) << align;
+			dst_off = (dst_off >> align) << align;
+
+			start = ktime_get();
+			dmatest_init_srcs(thread->srcs, src_off, len);
+			dmatest_init_dsts(thread->dsts, dst_off, len);
+			diff = ktime_sub(ktime_get(), start);
+			filltime = ktime_add(filltime, diff);
+		}
 
 		for (i = 0; i < src_cnt; i++) {
 			u8 *buf = thread->srcs[i] + src_off;
@@ -402,6 +435,7 @@ static int dmatest_slave_func(void *data)
 			failed_tests++;
 			continue;
 		}
+		issued = ktime_get();
 		dma_async_issue_pending(rx_chan);
 		dma_async_issue_pending(tx_chan);
 
@@ -449,6 +483,12 @@ static int dmatest_slave_func(void *data)
 			dma_unmap_single(rx_dev->dev, dma_dsts[i],
 					 test_buf_size, DMA_BIDIRECTIONAL);
 
+		if (benchmark) {
+			xilinx_dmatest_bench_record(&thread->bench,
+						    (u64)len * bd_cnt, issued);
+			continue;
+		}
+
 		error_count = 0;
 		start = ktime_get();
 		pr_debug("%s: verifying source buffer...\n", thread_name);
@@ -494,6 +534,11 @@ static int dmatest_slave_func(void *data)
 	runtime = ktime_to_us(ktime);
 
 	ret = 0;
+err_sg:
+	kfree(rx_sg);
+	kfree(tx_sg);
+	kfree(dma_dsts);
+	kfree(dma_srcs);
 	for (i = 0; thread->dsts[i]; i++)
 		kfree(thread->dsts[i]);
 err_dstbuf:
@@ -509,6 +554,7 @@ static int dmatest_slave_func(void *data)
 		  dmatest_persec(runtime, total_tests),
 		  dmatest_KBs(runtime, total_len), ret);
 
+	xilinx_dmatest_bench_done(&thread->bench);
 	thread->done = true;
 	wake_up(&thread_wait);
 
@@ -527,6 +573,7 @@ static void dmatest_cleanup_channel(struct dmatest_chan *dtc)
 			 thread->task->comm, ret);
 		list_del(&thread->node);
 		put_task_struct(thread->task);
+		xilinx_dmatest_bench_free(&thread->bench);
 		kfree(thread);
 	}
 	kfree(dtc);
@@ -550,6 +597,13 @@ static int dmatest_add_slave_threads(struct dmatest_chan *tx_dtc,
 	thread->rx_chan = rx_chan;
 	thread->type = (enum dma_transaction_type)DMA_SLAVE;
 
+	ret = xilinx_dmatest_bench_init(&thread->bench,
+					benchmark ? bench_samples : 1);
+	if (ret) {
+		kfree(thread);
+		return ret;
+	}
+
 	/* Ensure that all previous writes are complete */
 	smp_wmb();
 	thread->task = kthread_run(dmatest_slave_func, thread, "%s-%s",
@@ -559,12 +613,16 @@ static int dmatest_add_slave_threads(struct dmatest_chan *tx_dtc,
 	if (IS_ERR(thread->task)) {
 		pr_warn("dmatest: Failed to run thread %s-%s\n",
 			dma_chan_name(tx_chan), dma_chan_name(rx_chan));
+		xilinx_dmatest_bench_free(&thread->bench);
 		kfree(thread);
 		return ret;
 	}
 
 	/* srcbuf and dstbuf are allocated by the thread itself */
 	get_task_struct(thread->task);
+	if (benchmark)
+		xilinx_dmatest_bench_add(&thread->bench, dmatest_debugfs_dir,
+					 dma_chan_name(tx_chan));
 	list_add_tail(&thread->node, &tx_dtc->threads);
 
 	/* Added one thread with 2 channels */
@@ -607,7 +665,8 @@ static int dmatest_add_slave_channels(struct dma_chan *tx_chan,
 	list_add_tail(&rx_dtc->node, &dmatest_channels);
 	nr_channels += 2;
 
-	if (iterations)
+	/* Benchmark threads of all channel pairs run concurrently */
+	if (iterations && !benchmark)
 		wait_event(thread_wait, !is_threaded_test_run(tx_dtc, rx_dtc));
 
 	return 0;
@@ -683,13 +742,23 @@ static struct platform_driver xilinx_axidmatest_driver = {
 
 static int __init axidma_init(void)
 {
-	return platform_driver_register(&xilinx_axidmatest_driver);
+	int ret;
+
+	if (benchmark)
+		dmatest_debugfs_dir = debugfs_create_dir("axidmatest", NULL);
+
+	ret = platform_driver_register(&xilinx_axidmatest_driver);
+	if (ret)
+		debugfs_remove_recursive(dmatest_debugfs_dir);
+
+	return ret;
 }
 late_initcall(axidma_init);
 
 static void __exit axidma_exit(void)
 {
 	platform_driver_unregister(&xilinx_axidmatest_driver);
+	debugfs_remove_recursive(dmatest_debugfs_dir);
 }
 module_exit(axidma_exit)
 
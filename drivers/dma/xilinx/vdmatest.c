@@ -19,6 +19,7 @@
  */
 
 #include <linux/dma/xilinx_dma.h>
+#include <linux/debugfs.h>
 #include <linux/delay.h>
 #include <linux/init.h>
 #include <linux/kthread.h>
@@ -30,6 +31,8 @@
 #include <linux/sched/task.h>
 #include <linux/wait.h>
 
+#include "xilinx_dmatest_bench.h"
+
 static unsigned int test_buf_size = 64;
 module_param(test_buf_size, uint, 0444);
 MODULE_PARM_DESC(test_buf_size, "Size of the memcpy test buffer");
@@ -47,6 +50,16 @@ static unsigned int vsize = 32;
 module_param(vsize, uint, 0444);
 MODULE_PARM_DESC(vsize, "Vertical size in bytes");
 
+static bool benchmark;
+module_param(benchmark, bool, 0444);
+MODULE_PARM_DESC(benchmark,
+		 "Skip data verification and report throughput and latency in debugfs");
+
+static unsigned int bench_samples = 4096;
+module_param(bench_samples, uint, 0444);
+MODULE_PARM_DESC(bench_samples,
+		 "Number of latency samples kept per thread (default: 4096)");
+
 /*
  * Initialization patterns. All bytes in the source buffer has bit 7
  * set, all bytes in the destination buffer has bit 7 cleared.
@@ -76,6 +89,12 @@ MODULE_PARM_DESC(vsize, "Vertical size in bytes");
  * @srcs: Source buffer
  * @dsts: Destination buffer
  * @type: DMA transaction type
+ * @done: Test thread has terminated
+ * @frm_cnt: Number of frame buffers
+ * @dma_srcs: DMA addresses of the source frames
+ * @dma_dsts: DMA addresses of the destination frames
+ * @xt: Interleaved template used to prepare the frames
+ * @bench: Benchmark results
  */
 struct xilinx_vdmatest_slave_thread {
 	struct list_head node;
@@ -86,6 +105,11 @@ struct xilinx_vdmatest_slave_thread {
 	u8 **dsts;
 	enum dma_transaction_type type;
 	bool done;
+	unsigned int frm_cnt;
+	dma_addr_t dma_srcs[MAX_NUM_FRAMES];
+	dma_addr_t dma_dsts[MAX_NUM_FRAMES];
+	struct dma_interleaved_template *xt;
+	struct xilinx_dmatest_bench bench;
 };
 
 /**
@@ -104,10 +128,7 @@ struct xilinx_vdmatest_chan {
 static DECLARE_WAIT_QUEUE_HEAD(thread_wait);
 static LIST_HEAD(xilinx_vdmatest_channels);
 static unsigned int nr_channels;
-static unsigned int frm_cnt;
-static dma_addr_t dma_srcs[MAX_NUM_FRAMES];
-static dma_addr_t dma_dsts[MAX_NUM_FRAMES];
-static struct dma_interleaved_template xt;
+static struct dentry *xilinx_vdmatest_debugfs_dir;
 
 static bool is_threaded_test_run(struct xilinx_vdmatest_chan *tx_dtc,
 					struct xilinx_vdmatest_chan *rx_dtc)
@@ -247,6 +268,11 @@ static int xilinx_vdmatest_slave_func(void *data)
 	enum dma_ctrl_flags flags;
 	int ret = -ENOMEM, i;
 	struct xilinx_vdma_config config;
+	unsigned int frm_cnt = thread->frm_cnt;
+	dma_addr_t *dma_srcs = thread->dma_srcs;
+	dma_addr_t *dma_dsts = thread->dma_dsts;
+	struct dma_interleaved_template *xt = thread->xt;
+	ktime_t issued;
 
 	thread_name = current->comm;
 
@@ -282,6 +308,8 @@ static int xilinx_vdmatest_slave_func(void *data)
 
 	flags = DMA_CTRL_ACK | DMA_PREP_INTERRUPT;
 
+	xilinx_dmatest_bench_start(&thread->bench);
+
 	while (!kthread_should_stop()
 		&& !(iterations && total_tests >= iterations)) {
 		struct dma_device *tx_dev = tx_chan->device;
@@ -308,8 +336,10 @@ static int xilinx_vdmatest_slave_func(void *data)
 		}
 
 		len = test_buf_size;
-		xilinx_vdmatest_init_srcs(thread->srcs, 0, len);
-		xilinx_vdmatest_init_dsts(thread->dsts, 0, len);
+		if (!benchmark) {
+			xilinx_vdmatest_init_srcs(thread->srcs, 0, len);
+			xilinx_vdmatest_init_dsts(thread->dsts, 0, len);
+		}
 
 		/* Zero out configuration */
 		memset(&config, 0, sizeof(struct xilinx_vdma_config));
@@ -332,14 +362,14 @@ static int xilinx_vdmatest_slave_func(void *data)
 				failed_tests++;
 				continue;
 			}
-			xt.dst_start = dma_dsts[i];
-			xt.dir = DMA_DEV_TO_MEM;
-			xt.numf = vsize;
-			xt.sgl[0].size = hsize;
-			xt.sgl[0].icg = 0;
-			xt.frame_size = 1;
+			xt->dst_start = dma_dsts[i];
+			xt->dir = DMA_DEV_TO_MEM;
+			xt->numf = vsize;
+			xt->sgl[0].size = hsize;
+			xt->sgl[0].icg = 0;
+			xt->frame_size = 1;
 			rxd = rx_dev->device_prep_interleaved_dma(rx_chan,
-								  &xt, flags);
+								  xt, flags);
 			rx_cookie = rxd->tx_submit(rxd);
 		}
 
@@ -353,14 +383,14 @@ static int xilinx_vdmatest_slave_func(void *data)
 				failed_tests++;
 				continue;
 			}
-			xt.src_start = dma_srcs[i];
-			xt.dir = DMA_MEM_TO_DEV;
-			xt.numf = vsize;
-			xt.sgl[0].size = hsize;
-			xt.sgl[0].icg = 0;
-			xt.frame_size = 1;
+			xt->src_start = dma_srcs[i];
+			xt->dir = DMA_MEM_TO_DEV;
+			xt->numf = vsize;
+			xt->sgl[0].size = hsize;
+			xt->sgl[0].icg = 0;
+			xt->frame_size = 1;
 			txd = tx_dev->device_prep_interleaved_dma(tx_chan,
-								  &xt, flags);
+								  xt, flags);
 			tx_cookie = txd->tx_submit(txd);
 		}
 
@@ -396,6 +426,7 @@ static int xilinx_vdmatest_slave_func(void *data)
 			failed_tests++;
 			continue;
 		}
+		issued = ktime_get();
 		dma_async_issue_pending(tx_chan);
 		dma_async_issue_pending(rx_chan);
 
@@ -445,6 +476,12 @@ static int xilinx_vdmatest_slave_func(void *data)
 			dma_unmap_single(rx_dev->dev, dma_dsts[i],
 					 test_buf_size, DMA_DEV_TO_MEM);
 
+		if (benchmark) {
+			xilinx_dmatest_bench_record(&thread->bench,
+						    (u64)len * frm_cnt, issued);
+			continue;
+		}
+
 		error_count = 0;
 
 		pr_debug("%s: verifying source buffer...\n", thread_name);
@@ -488,6 +525,7 @@ static int xilinx_vdmatest_slave_func(void *data)
 	pr_notice("%s: terminating after %u tests, %u failures (status %d)\n",
 			thread_name, total_tests, failed_tests, ret);
 
+	xilinx_dmatest_bench_done(&thread->bench);
 	thread->done = true;
 	wake_up(&thread_wait);
 
@@ -506,6 +544,8 @@ static void xilinx_vdmatest_cleanup_channel(struct xilinx_vdmatest_chan *dtc)
 				thread->task->comm, ret);
 		list_del(&thread->node);
 		put_task_struct(thread->task);
+		xilinx_dmatest_bench_free(&thread->bench);
+		kfree(thread->xt);
 		kfree(thread);
 	}
 	kfree(dtc);
@@ -513,11 +553,13 @@ static void xilinx_vdmatest_cleanup_channel(struct xilinx_vdmatest_chan *dtc)
 
 static int
 xilinx_vdmatest_add_slave_threads(struct xilinx_vdmatest_chan *tx_dtc,
-					struct xilinx_vdmatest_chan *rx_dtc)
+					struct xilinx_vdmatest_chan *rx_dtc,
+					unsigned int frm_cnt)
 {
 	struct xilinx_vdmatest_slave_thread *thread;
 	struct dma_chan *tx_chan = tx_dtc->chan;
 	struct dma_chan *rx_chan = rx_dtc->chan;
+	int ret;
 
 	thread = kzalloc(sizeof(struct xilinx_vdmatest_slave_thread),
 			GFP_KERNEL);
@@ -528,6 +570,20 @@ xilinx_vdmatest_add_slave_threads(struct xilinx_vdmatest_chan *tx_dtc,
 	thread->tx_chan = tx_chan;
 	thread->rx_chan = rx_chan;
 	thread->type = (enum dma_transaction_type)DMA_SLAVE;
+	thread->frm_cnt = frm_cnt;
+
+	thread->xt = kzalloc(struct_size(thread->xt, sgl, 1), GFP_KERNEL);
+	if (!thread->xt) {
+		kfree(thread);
+		return -ENOMEM;
+	}
+
+	if (xilinx_dmatest_bench_init(&thread->bench,
+				      benchmark ? bench_samples : 1)) {
+		kfree(thread->xt);
+		kfree(thread);
+		return -ENOMEM;
+	}
 
 	/* This barrier ensures the DMA channels in the 'thread'
 	 * are initialized
@@ -538,11 +594,18 @@ xilinx_vdmatest_add_slave_threads(struct xilinx_vdmatest_chan *tx_dtc,
 	if (IS_ERR(thread->task)) {
 		pr_warn("xilinx_vdmatest: Failed to run thread %s-%s\n",
 				dma_chan_name(tx_chan), dma_chan_name(rx_chan));
+		ret = PTR_ERR(thread->task);
+		xilinx_dmatest_bench_free(&thread->bench);
+		kfree(thread->xt);
 		kfree(thread);
-		return PTR_ERR(thread->task);
+		return ret;
 	}
 
 	get_task_struct(thread->task);
+	if (benchmark)
+		xilinx_dmatest_bench_add(&thread->bench,
+					 xilinx_vdmatest_debugfs_dir,
+					 dma_chan_name(tx_chan));
 	list_add_tail(&thread->node, &tx_dtc->threads);
 
 	/* Added one thread with 2 channels */
@@ -550,7 +613,8 @@ xilinx_vdmatest_add_slave_threads(struct xilinx_vdmatest_chan *tx_dtc,
 }
 
 static int xilinx_vdmatest_add_slave_channels(struct dma_chan *tx_chan,
-					struct dma_chan *rx_chan)
+					struct dma_chan *rx_chan,
+					unsigned int frm_cnt)
 {
 	struct xilinx_vdmatest_chan *tx_dtc, *rx_dtc;
 	unsigned int thread_count = 0;
@@ -568,7 +632,7 @@ static int xilinx_vdmatest_add_slave_channels(struct dma_chan *tx_chan,
 	INIT_LIST_HEAD(&tx_dtc->threads);
 	INIT_LIST_HEAD(&rx_dtc->threads);
 
-	xilinx_vdmatest_add_slave_threads(tx_dtc, rx_dtc);
+	xilinx_vdmatest_add_slave_threads(tx_dtc, rx_dtc, frm_cnt);
 	thread_count += 1;
 
 	pr_info("xilinx_vdmatest: Started %u threads using %s %s\n",
@@ -578,7 +642,8 @@ static int xilinx_vdmatest_add_slave_channels(struct dma_chan *tx_chan,
 	list_add_tail(&rx_dtc->node, &xilinx_vdmatest_channels);
 	nr_channels += 2;
 
-	if (iterations)
+	/* Benchmark threads of all channel pairs run concurrently */
+	if (iterations && !benchmark)
 		wait_event(thread_wait, !is_threaded_test_run(tx_dtc, rx_dtc));
 
 	return 0;
@@ -587,6 +652,7 @@ static int xilinx_vdmatest_add_slave_channels(struct dma_chan *tx_chan,
 static int xilinx_vdmatest_probe(struct platform_device *pdev)
 {
 	struct dma_chan *chan, *rx_chan;
+	unsigned int frm_cnt;
 	int err;
 
 	err = of_property_read_u32(pdev->dev.of_node,
@@ -596,6 +662,11 @@ static int xilinx_vdmatest_probe(struct platform_device *pdev)
 		return err;
 	}
 
+	if (frm_cnt > MAX_NUM_FRAMES) {
+		pr_err("xilinx_vdmatest: too many frame stores %u\n", frm_cnt);
+		return -EINVAL;
+	}
+
 	chan = dma_request_chan(&pdev->dev, "vdma0");
 	if (IS_ERR(chan)) {
 		err = PTR_ERR(chan);
@@ -612,7 +683,7 @@ static int xilinx_vdmatest_probe(struct platform_device *pdev)
 		goto free_tx;
 	}
 
-	err = xilinx_vdmatest_add_slave_channels(chan, rx_chan);
+	err = xilinx_vdmatest_add_slave_channels(chan, rx_chan, frm_cnt);
 	if (err) {
 		pr_err("xilinx_vdmatest: Unable to add channels\n");
 		goto free_rx;
@@ -659,7 +730,28 @@ static struct platform_driver xilinx_vdmatest_driver = {
 	.remove = xilinx_vdmatest_remove,
 };
 
-module_platform_driver(xilinx_vdmatest_driver);
+static int __init xilinx_vdmatest_init(void)
+{
+	int ret;
+
+	if (benchmark)
+		xilinx_vdmatest_debugfs_dir = debugfs_create_dir("vdmatest",
+								  NULL);
+
+	ret = platform_driver_register(&xilinx_vdmatest_driver);
+	if (ret)
+		debugfs_remove_recursive(xilinx_vdmatest_debugfs_dir);
+
+	return ret;
+}
+module_init(xilinx_vdmatest_init);
+
+static void __exit xilinx_vdmatest_exit(void)
+{
+	platform_driver_unregister(&xilinx_vdmatest_driver);
+	debugfs_remove_recursive(xilinx_vdmatest_debugfs_dir);
+}
+module_exit(xilinx_vdmatest_exit);
 
 MODULE_AUTHOR("Xilinx, Inc.");
 MODULE_DESCRIPTION("Xilinx AXI VDMA Test Client");
@@ -34,22 +34,28 @@
  */
 
 #include <linux/bitops.h>
+#include <linux/dma-buf.h>
+#include <linux/dma-fence.h>
+#include <linux/dma-resv.h>
 #include <linux/dmapool.h>
 #include <linux/dma/xilinx_dma.h>
 #include <linux/init.h>
 #include <linux/interrupt.h>
 #include <linux/io.h>
 #include <linux/iopoll.h>
+#include <linux/local_lock.h>
 #include <linux/module.h>
 #include <linux/of_address.h>
 #include <linux/of_dma.h>
 #include <linux/of_platform.h>
 #include <linux/of_irq.h>
+#include <linux/percpu.h>
 #include <linux/slab.h>
 #include <linux/clk.h>
 #include <linux/io-64-nonatomic-lo-hi.h>
 
 #include "../dmaengine.h"
+#include "xilinx_dma_trace.h"
 
 /* Register/Descriptor Offsets */
 #define XILINX_DMA_MM2S_CTRL_OFFSET		0x0000
@@ -126,6 +132,8 @@
 
 /* HW specific definitions */
 #define XILINX_MCDMA_MAX_CHANS_PER_DEVICE	0x20
+/* Bound on the serviced channel rescans of one MCDMA interrupt */
+#define XILINX_MCDMA_IRQ_MAX_PASSES		4
 #define XILINX_DMA_MAX_CHANS_PER_DEVICE		0x2
 #define XILINX_CDMA_MAX_CHANS_PER_DEVICE	0x1
 
@@ -177,8 +185,16 @@
 #define XILINX_DMA_CR_COALESCE_SHIFT	16
 #define XILINX_DMA_BD_SOP		BIT(27)
 #define XILINX_DMA_BD_EOP		BIT(26)
+#define XILINX_DMA_BD_COMP_MASK		BIT(31)
 #define XILINX_DMA_COALESCE_MAX		255
 #define XILINX_DMA_NUM_DESCS		255
+/* Segment pool growth limit, in chunks of XILINX_DMA_NUM_DESCS segments */
+#define XILINX_DMA_MAX_SEG_CHUNKS	16
+/* Segments moved between a per-CPU cache and the channel pool at once */
+#define XILINX_DMA_SEG_CACHE_BATCH	16
+#define XILINX_DMA_SEG_CACHE_HIGH	(2 * XILINX_DMA_SEG_CACHE_BATCH)
+/* Completed descriptors handled by one tasklet run */
+#define XILINX_DMA_CLEANUP_BUDGET	64
 #define XILINX_DMA_NUM_APP_WORDS	5
 
 /* AXI CDMA Specific Registers/Offsets */
@@ -354,6 +370,32 @@ struct xilinx_cdma_tx_segment {
 	dma_addr_t phys;
 } __aligned(64);
 
+/**
+ * struct xilinx_dma_seg_cache - Per-CPU cache of free segments
+ * @lock: Protects the cache against preemption and interrupts
+ * @segs: Free segments, linked through their node member
+ * @count: Number of segments on @segs
+ */
+struct xilinx_dma_seg_cache {
+	local_lock_t lock;
+	struct list_head segs;
+	unsigned int count;
+};
+
+/**
+ * struct xilinx_dma_seg_chunk - Coherent memory backing AXI DMA/MCDMA segments
+ * @node: Node in the channel chunk list
+ * @virt: CPU address of the chunk
+ * @phys: DMA address of the chunk
+ * @size: Size of the chunk in bytes
+ */
+struct xilinx_dma_seg_chunk {
+	struct list_head node;
+	void *virt;
+	dma_addr_t phys;
+	size_t size;
+};
+
 /**
  * struct xilinx_dma_tx_descriptor - Per Transaction structure
  * @async_tx: Async transaction descriptor
@@ -362,6 +404,8 @@ struct xilinx_cdma_tx_segment {
  * @cyclic: Check for cyclic transfers.
  * @err: Whether the descriptor has an error.
  * @residue: Residue of the completed descriptor
+ * @period_len: Period length of a cyclic transfer
+ * @num_periods: Number of periods of a cyclic transfer
  */
 struct xilinx_dma_tx_descriptor {
 	struct dma_async_tx_descriptor async_tx;
@@ -370,6 +414,8 @@ struct xilinx_dma_tx_descriptor {
 	bool cyclic;
 	bool err;
 	u32 residue;
+	u32 period_len;
+	u32 num_periods;
 };
 
 /**
@@ -381,7 +427,11 @@ struct xilinx_dma_tx_descriptor {
  * @pending_list: Descriptors waiting
  * @active_list: Descriptors ready to submit
  * @done_list: Complete descriptors
- * @free_seg_list: Free descriptors
+ * @free_seg_list: Free descriptors shared by all CPUs
+ * @seg_lock: Protects @free_seg_list and the chunk bookkeeping
+ * @seg_cache: Per-CPU caches of free descriptors
+ * @seg_chunks: Coherent chunks backing AXI DMA/MCDMA descriptors
+ * @nr_seg_chunks: Number of entries on @seg_chunks
  * @common: DMA common channel
  * @desc_pool: Descriptors pool
  * @dev: The dma device
@@ -401,15 +451,22 @@ struct xilinx_dma_tx_descriptor {
  * @desc_pendingcount: Descriptor pending count
  * @ext_addr: Indicates 64 bit addressing is supported by dma channel
  * @desc_submitcount: Descriptor h/w submitted count
- * @seg_v: Statically allocated segments base
- * @seg_mv: Statically allocated segments base for MCDMA
- * @seg_p: Physical allocated segments base
  * @cyclic_seg_v: Statically allocated segment base for cyclic transfers
  * @cyclic_seg_p: Physical allocated segments base for cyclic dma
+ * @cyclic_desc: Submitted cyclic transaction
+ * @cyclic_cur: Next BD of @cyclic_desc expected to complete
+ * @cyclic_period_bytes: Bytes completed in the current period
+ * @cyclic_period: Index of the last completed period, -1 before the first
+ * @cyclic_residue: Residue of the cyclic buffer, updated by the irq handler
  * @start_transfer: Differentiate b/w DMA IP's transfer
  * @stop_transfer: Differentiate b/w DMA IP's quiesce
  * @tdest: TDEST value for mcdma
  * @has_vflip: S2MM vertical flip
+ * @polled: Completions are found by xilinx_dma_tx_status() polling the BDs
+ * @dropped_frames: S2MM frames overwritten in VDMA drop-oldest mode
+ * @fence_lock: Orders the dma-buf fence seqnos like the submissions
+ * @fence_context: DMA fence context of the dma-buf transfers
+ * @fence_seqno: Seqno of the last dma-buf transfer fence
  */
 struct xilinx_dma_chan {
 	struct xilinx_dma_device *xdev;
@@ -420,6 +477,10 @@ struct xilinx_dma_chan {
 	struct list_head active_list;
 	struct list_head done_list;
 	struct list_head free_seg_list;
+	spinlock_t seg_lock;
+	struct xilinx_dma_seg_cache __percpu *seg_cache;
+	struct list_head seg_chunks;
+	unsigned int nr_seg_chunks;
 	struct dma_chan common;
 	struct dma_pool *desc_pool;
 	struct device *dev;
@@ -439,15 +500,22 @@ struct xilinx_dma_chan {
 	u32 desc_pendingcount;
 	bool ext_addr;
 	u32 desc_submitcount;
-	struct xilinx_axidma_tx_segment *seg_v;
-	struct xilinx_aximcdma_tx_segment *seg_mv;
-	dma_addr_t seg_p;
 	struct xilinx_axidma_tx_segment *cyclic_seg_v;
 	dma_addr_t cyclic_seg_p;
+	struct xilinx_dma_tx_descriptor *cyclic_desc;
+	struct xilinx_axidma_tx_segment *cyclic_cur;
+	u32 cyclic_period_bytes;
+	int cyclic_period;
+	u32 cyclic_residue;
 	void (*start_transfer)(struct xilinx_dma_chan *chan);
 	int (*stop_transfer)(struct xilinx_dma_chan *chan);
 	u16 tdest;
 	bool has_vflip;
+	bool polled;
+	u64 dropped_frames;
+	spinlock_t fence_lock;
+	u64 fence_context;
+	u64 fence_seqno;
 };
 
 /**
@@ -627,6 +695,183 @@ static inline void xilinx_aximcdma_buf(struct xilinx_dma_chan *chan,
  * Descriptors and segments alloc and free
  */
 
+/**
+ * xilinx_dma_seg_get - Take a free segment from the channel segment pool
+ * @chan: Driver specific DMA channel
+ *
+ * Segments are handed out from the local CPU cache, which is refilled in
+ * batches from the shared free list so that concurrent submitters only meet
+ * on @chan->seg_lock once every XILINX_DMA_SEG_CACHE_BATCH segments.
+ *
+ * Return: The node of the segment on success and NULL if the pool is empty.
+ */
+static struct list_head *xilinx_dma_seg_get(struct xilinx_dma_chan *chan)
+{
+	struct xilinx_dma_seg_cache *cache;
+	struct list_head *node = NULL;
+	unsigned long flags;
+	unsigned int i;
+
+	local_lock_irqsave(&chan->seg_cache->lock, flags);
+	cache = this_cpu_ptr(chan->seg_cache);
+
+	if (!cache->count) {
+		spin_lock(&chan->seg_lock);
+		for (i = 0; i < XILINX_DMA_SEG_CACHE_BATCH &&
+		     !list_empty(&chan->free_seg_list); i++) {
+			list_move(chan->free_seg_list.next, &cache->segs);
+			cache->count++;
+		}
+		spin_unlock(&chan->seg_lock);
+	}
+
+	if (cache->count) {
+		node = cache->segs.next;
+		list_del(node);
+		cache->count--;
+	}
+
+	local_unlock_irqrestore(&chan->seg_cache->lock, flags);
+
+	return node;
+}
+
+/**
+ * xilinx_dma_seg_put - Return a segment to the channel segment pool
+ * @chan: Driver specific DMA channel
+ * @node: Node of the segment, the hardware descriptor must already be clean
+ */
+static void xilinx_dma_seg_put(struct xilinx_dma_chan *chan,
+			       struct list_head *node)
+{
+	struct xilinx_dma_seg_cache *cache;
+	unsigned long flags;
+	unsigned int i;
+
+	local_lock_irqsave(&chan->seg_cache->lock, flags);
+	cache = this_cpu_ptr(chan->seg_cache);
+
+	list_add(node, &cache->segs);
+	if (++cache->count >= XILINX_DMA_SEG_CACHE_HIGH) {
+		spin_lock(&chan->seg_lock);
+		for (i = 0; i < XILINX_DMA_SEG_CACHE_BATCH; i++) {
+			list_move_tail(cache->segs.prev, &chan->free_seg_list);
+			cache->count--;
+		}
+		spin_unlock(&chan->seg_lock);
+	}
+
+	local_unlock_irqrestore(&chan->seg_cache->lock, flags);
+}
+
+/**
+ * xilinx_dma_seg_pool_grow - Add a chunk of segments to the channel pool
+ * @chan: Driver specific DMA channel
+ * @gfp: Allocation flags
+ *
+ * Carves XILINX_DMA_NUM_DESCS AXI DMA or MCDMA segments out of one coherent
+ * allocation. Segments are chained at prep time, so they need not be
+ * contiguous with those of earlier chunks.
+ *
+ * Return: '0' on success and failure value on error
+ */
+static int xilinx_dma_seg_pool_grow(struct xilinx_dma_chan *chan, gfp_t gfp)
+{
+	struct xilinx_axidma_tx_segment *axidma_segment;
+	struct xilinx_aximcdma_tx_segment *aximcdma_segment;
+	struct xilinx_dma_seg_chunk *chunk;
+	unsigned long flags;
+	LIST_HEAD(segs);
+	size_t seg_size;
+	int i;
+
+	/* Racing growers may both pass this check, the limit is advisory */
+	if (READ_ONCE(chan->nr_seg_chunks) >= XILINX_DMA_MAX_SEG_CHUNKS)
+		return -ENOMEM;
+
+	if (chan->xdev->dma_config->dmatype == XDMA_TYPE_AXIDMA)
+		seg_size = sizeof(*axidma_segment);
+	else
+		seg_size = sizeof(*aximcdma_segment);
+
+	chunk = kzalloc(sizeof(*chunk), gfp);
+	if (!chunk)
+		return -ENOMEM;
+
+	chunk->size = seg_size * XILINX_DMA_NUM_DESCS;
+	chunk->virt = dma_alloc_coherent(chan->dev, chunk->size, &chunk->phys,
+					 gfp);
+	if (!chunk->virt) {
+		kfree(chunk);
+		return -ENOMEM;
+	}
+
+	for (i = 0; i < XILINX_DMA_NUM_DESCS; i++) {
+		if (chan->xdev->dma_config->dmatype == XDMA_TYPE_AXIDMA) {
+			axidma_segment = chunk->virt + seg_size * i;
+			axidma_segment->phys = chunk->phys + seg_size * i;
+			list_add_tail(&axidma_segment->node, &segs);
+		} else {
+			aximcdma_segment = chunk->virt + seg_size * i;
+			aximcdma_segment->phys = chunk->phys + seg_size * i;
+			list_add_tail(&aximcdma_segment->node, &segs);
+		}
+	}
+
+	spin_lock_irqsave(&chan->seg_lock, flags);
+	list_add_tail(&chunk->node, &chan->seg_chunks);
+	chan->nr_seg_chunks++;
+	list_splice_tail(&segs, &chan->free_seg_list);
+	spin_unlock_irqrestore(&chan->seg_lock, flags);
+
+	return 0;
+}
+
+/**
+ * xilinx_dma_seg_pool_drain - Pull every free segment out of the pool
+ * @chan: Driver specific DMA channel
+ * @segs: List receiving the segments
+ *
+ * Must only be called once the channel no longer has segments in flight.
+ */
+static void xilinx_dma_seg_pool_drain(struct xilinx_dma_chan *chan,
+				      struct list_head *segs)
+{
+	struct xilinx_dma_seg_cache *cache;
+	unsigned long flags;
+	int cpu;
+
+	for_each_possible_cpu(cpu) {
+		cache = per_cpu_ptr(chan->seg_cache, cpu);
+		list_splice_init(&cache->segs, segs);
+		cache->count = 0;
+	}
+
+	spin_lock_irqsave(&chan->seg_lock, flags);
+	list_splice_init(&chan->free_seg_list, segs);
+	spin_unlock_irqrestore(&chan->seg_lock, flags);
+}
+
+/**
+ * xilinx_dma_seg_pool_destroy - Release the AXI DMA/MCDMA segment chunks
+ * @chan: Driver specific DMA channel
+ */
+static void xilinx_dma_seg_pool_destroy(struct xilinx_dma_chan *chan)
+{
+	struct xilinx_dma_seg_chunk *chunk, *next;
+	LIST_HEAD(segs);
+
+	xilinx_dma_seg_pool_drain(chan, &segs);
+
+	list_for_each_entry_safe(chunk, next, &chan->seg_chunks, node) {
+		list_del(&chunk->node);
+		dma_free_coherent(chan->dev, chunk->size, chunk->virt,
+				  chunk->phys);
+		kfree(chunk);
+	}
+	chan->nr_seg_chunks = 0;
+}
+
 /**
  * xilinx_vdma_alloc_tx_segment - Allocate transaction segment
  * @chan: Driver specific DMA channel
@@ -658,8 +903,13 @@ static struct xilinx_cdma_tx_segment *
 xilinx_cdma_alloc_tx_segment(struct xilinx_dma_chan *chan)
 {
 	struct xilinx_cdma_tx_segment *segment;
+	struct list_head *node;
 	dma_addr_t phys;
 
+	node = xilinx_dma_seg_get(chan);
+	if (node)
+		return list_entry(node, struct xilinx_cdma_tx_segment, node);
+
 	segment = dma_pool_zalloc(chan->desc_pool, GFP_ATOMIC, &phys);
 	if (!segment)
 		return NULL;
@@ -678,22 +928,18 @@ xilinx_cdma_alloc_tx_segment(struct xilinx_dma_chan *chan)
 static struct xilinx_axidma_tx_segment *
 xilinx_axidma_alloc_tx_segment(struct xilinx_dma_chan *chan)
 {
-	struct xilinx_axidma_tx_segment *segment = NULL;
-	unsigned long flags;
+	struct list_head *node;
 
-	spin_lock_irqsave(&chan->lock, flags);
-	if (!list_empty(&chan->free_seg_list)) {
-		segment = list_first_entry(&chan->free_seg_list,
-					   struct xilinx_axidma_tx_segment,
-					   node);
-		list_del(&segment->node);
-	}
-	spin_unlock_irqrestore(&chan->lock, flags);
+	node = xilinx_dma_seg_get(chan);
+	if (!node && !xilinx_dma_seg_pool_grow(chan, GFP_NOWAIT))
+		node = xilinx_dma_seg_get(chan);
 
-	if (!segment)
+	if (!node) {
 		dev_dbg(chan->dev, "Could not find free tx segment\n");
+		return NULL;
+	}
 
-	return segment;
+	return list_entry(node, struct xilinx_axidma_tx_segment, node);
 }
 
 /**
@@ -705,19 +951,16 @@ xilinx_axidma_alloc_tx_segment(struct xilinx_dma_chan *chan)
 static struct xilinx_aximcdma_tx_segment *
 xilinx_aximcdma_alloc_tx_segment(struct xilinx_dma_chan *chan)
 {
-	struct xilinx_aximcdma_tx_segment *segment = NULL;
-	unsigned long flags;
+	struct list_head *node;
 
-	spin_lock_irqsave(&chan->lock, flags);
-	if (!list_empty(&chan->free_seg_list)) {
-		segment = list_first_entry(&chan->free_seg_list,
-					   struct xilinx_aximcdma_tx_segment,
-					   node);
-		list_del(&segment->node);
-	}
-	spin_unlock_irqrestore(&chan->lock, flags);
+	node = xilinx_dma_seg_get(chan);
+	if (!node && !xilinx_dma_seg_pool_grow(chan, GFP_NOWAIT))
+		node = xilinx_dma_seg_get(chan);
 
-	return segment;
+	if (!node)
+		return NULL;
+
+	return list_entry(node, struct xilinx_aximcdma_tx_segment, node);
 }
 
 static void xilinx_dma_clean_hw_desc(struct xilinx_axidma_desc_hw *hw)
@@ -752,7 +995,7 @@ static void xilinx_dma_free_tx_segment(struct xilinx_dma_chan *chan,
 {
 	xilinx_dma_clean_hw_desc(&segment->hw);
 
-	list_add_tail(&segment->node, &chan->free_seg_list);
+	xilinx_dma_seg_put(chan, &segment->node);
 }
 
 /**
@@ -766,7 +1009,7 @@ static void xilinx_mcdma_free_tx_segment(struct xilinx_dma_chan *chan,
 {
 	xilinx_mcdma_clean_hw_desc(&segment->hw);
 
-	list_add_tail(&segment->node, &chan->free_seg_list);
+	xilinx_dma_seg_put(chan, &segment->node);
 }
 
 /**
@@ -777,7 +1020,9 @@ static void xilinx_mcdma_free_tx_segment(struct xilinx_dma_chan *chan,
 static void xilinx_cdma_free_tx_segment(struct xilinx_dma_chan *chan,
 				struct xilinx_cdma_tx_segment *segment)
 {
-	dma_pool_free(chan->desc_pool, segment, segment->phys);
+	memset(&segment->hw, 0, sizeof(segment->hw));
+
+	xilinx_dma_seg_put(chan, &segment->node);
 }
 
 /**
@@ -856,8 +1101,86 @@ xilinx_dma_free_tx_descriptor(struct xilinx_dma_chan *chan,
 	kfree(desc);
 }
 
+/**
+ * xilinx_dma_release_tx_descriptor - Release a finished descriptor
+ * @chan: Driver specific DMA channel
+ * @desc: DMA transaction descriptor
+ *
+ * Descriptors marked for reuse stay allocated, with their BD chain, until
+ * the client resubmits them or calls dmaengine_desc_free().
+ */
+static void
+xilinx_dma_release_tx_descriptor(struct xilinx_dma_chan *chan,
+				  struct xilinx_dma_tx_descriptor *desc)
+{
+	if (dmaengine_desc_test_reuse(&desc->async_tx))
+		return;
+
+	xilinx_dma_free_tx_descriptor(chan, desc);
+}
+
+/**
+ * xilinx_dma_desc_free - Free a reusable descriptor
+ * @tx: Async transaction descriptor
+ *
+ * Return: '0' always.
+ */
+static int xilinx_dma_desc_free(struct dma_async_tx_descriptor *tx)
+{
+	struct xilinx_dma_tx_descriptor *desc = to_dma_tx_descriptor(tx);
+	struct xilinx_dma_chan *chan = to_xilinx_chan(tx->chan);
+	unsigned long flags;
+
+	spin_lock_irqsave(&chan->lock, flags);
+	xilinx_dma_free_tx_descriptor(chan, desc);
+	spin_unlock_irqrestore(&chan->lock, flags);
+
+	return 0;
+}
+
+/**
+ * xilinx_dma_rearm_tx_descriptor - Prepare a reused descriptor for submission
+ * @chan: Driver specific DMA channel
+ * @desc: DMA transaction descriptor
+ *
+ * The BD chain is kept as built by the prep call, only the status words
+ * written back by the hardware are cleared. The link to the following
+ * descriptor is set again when the descriptor is queued.
+ */
+static void
+xilinx_dma_rearm_tx_descriptor(struct xilinx_dma_chan *chan,
+			       struct xilinx_dma_tx_descriptor *desc)
+{
+	struct xilinx_axidma_tx_segment *axidma_segment;
+	struct xilinx_aximcdma_tx_segment *aximcdma_segment;
+
+	if (chan->xdev->dma_config->dmatype == XDMA_TYPE_AXIDMA) {
+		list_for_each_entry(axidma_segment, &desc->segments, node)
+			axidma_segment->hw.status = 0;
+	} else {
+		list_for_each_entry(aximcdma_segment, &desc->segments, node) {
+			aximcdma_segment->hw.status = 0;
+			aximcdma_segment->hw.sideband_status = 0;
+		}
+	}
+
+	desc->err = false;
+	desc->residue = 0;
+}
+
 /* Required functions */
 
+#if IS_REACHABLE(CONFIG_DMA_SHARED_BUFFER)
+static void xilinx_dma_buf_cancel(struct xilinx_dma_tx_descriptor *desc,
+				  enum dmaengine_tx_result result);
+#else
+static inline void
+xilinx_dma_buf_cancel(struct xilinx_dma_tx_descriptor *desc,
+		      enum dmaengine_tx_result result)
+{
+}
+#endif
+
 /**
  * xilinx_dma_free_desc_list - Free descriptors list
  * @chan: Driver specific DMA channel
@@ -870,7 +1193,7 @@ static void xilinx_dma_free_desc_list(struct xilinx_dma_chan *chan,
 
 	list_for_each_entry_safe(desc, next, list, node) {
 		list_del(&desc->node);
-		xilinx_dma_free_tx_descriptor(chan, desc);
+		xilinx_dma_release_tx_descriptor(chan, desc);
 	}
 }
 
@@ -880,15 +1203,35 @@ static void xilinx_dma_free_desc_list(struct xilinx_dma_chan *chan,
  */
 static void xilinx_dma_free_descriptors(struct xilinx_dma_chan *chan)
 {
+	struct xilinx_dma_tx_descriptor *desc;
 	unsigned long flags;
+	LIST_HEAD(aborted);
+	LIST_HEAD(done);
 
 	spin_lock_irqsave(&chan->lock, flags);
 
-	xilinx_dma_free_desc_list(chan, &chan->pending_list);
-	xilinx_dma_free_desc_list(chan, &chan->done_list);
-	xilinx_dma_free_desc_list(chan, &chan->active_list);
+	list_splice_tail_init(&chan->active_list, &aborted);
+	list_splice_tail_init(&chan->pending_list, &aborted);
+	list_splice_tail_init(&chan->done_list, &done);
+	chan->cyclic_desc = NULL;
+	chan->cyclic_cur = NULL;
 
 	spin_unlock_irqrestore(&chan->lock, flags);
+
+	/*
+	 * Client callbacks aren't called for dropped descriptors, but the
+	 * fences of dma-buf transfers must still signal. This is done
+	 * without the lock, a fence callback may submit a new transfer.
+	 */
+	list_for_each_entry(desc, &done, node)
+		xilinx_dma_buf_cancel(desc, DMA_TRANS_NOERROR);
+	list_for_each_entry(desc, &aborted, node)
+		xilinx_dma_buf_cancel(desc, DMA_TRANS_ABORTED);
+
+	spin_lock_irqsave(&chan->lock, flags);
+	xilinx_dma_free_desc_list(chan, &done);
+	xilinx_dma_free_desc_list(chan, &aborted);
+	spin_unlock_irqrestore(&chan->lock, flags);
 }
 
 /**
@@ -898,21 +1241,17 @@ static void xilinx_dma_free_descriptors(struct xilinx_dma_chan *chan)
 static void xilinx_dma_free_chan_resources(struct dma_chan *dchan)
 {
 	struct xilinx_dma_chan *chan = to_xilinx_chan(dchan);
-	unsigned long flags;
+	struct xilinx_cdma_tx_segment *segment, *next;
+	LIST_HEAD(segs);
 
 	dev_dbg(chan->dev, "Free all channel resources.\n");
 
 	xilinx_dma_free_descriptors(chan);
+	chan->polled = false;
 
 	if (chan->xdev->dma_config->dmatype == XDMA_TYPE_AXIDMA) {
-		spin_lock_irqsave(&chan->lock, flags);
-		INIT_LIST_HEAD(&chan->free_seg_list);
-		spin_unlock_irqrestore(&chan->lock, flags);
-
 		/* Free memory that is allocated for BD */
-		dma_free_coherent(chan->dev, sizeof(*chan->seg_v) *
-				  XILINX_DMA_NUM_DESCS, chan->seg_v,
-				  chan->seg_p);
+		xilinx_dma_seg_pool_destroy(chan);
 
 		/* Free Memory that is allocated for cyclic DMA Mode */
 		dma_free_coherent(chan->dev, sizeof(*chan->cyclic_seg_v),
@@ -920,14 +1259,17 @@ static void xilinx_dma_free_chan_resources(struct dma_chan *dchan)
 	}
 
 	if (chan->xdev->dma_config->dmatype == XDMA_TYPE_AXIMCDMA) {
-		spin_lock_irqsave(&chan->lock, flags);
-		INIT_LIST_HEAD(&chan->free_seg_list);
-		spin_unlock_irqrestore(&chan->lock, flags);
-
 		/* Free memory that is allocated for BD */
-		dma_free_coherent(chan->dev, sizeof(*chan->seg_mv) *
-				  XILINX_DMA_NUM_DESCS, chan->seg_mv,
-				  chan->seg_p);
+		xilinx_dma_seg_pool_destroy(chan);
+	}
+
+	if (chan->xdev->dma_config->dmatype == XDMA_TYPE_CDMA) {
+		/* Hand the cached segments back before destroying the pool */
+		xilinx_dma_seg_pool_drain(chan, &segs);
+		list_for_each_entry_safe(segment, next, &segs, node) {
+			list_del(&segment->node);
+			dma_pool_free(chan->desc_pool, segment, segment->phys);
+		}
 	}
 
 	if (chan->xdev->dma_config->dmatype != XDMA_TYPE_AXIDMA &&
@@ -1000,6 +1342,7 @@ static void xilinx_dma_chan_handle_cyclic(struct xilinx_dma_chan *chan,
 {
 	struct dmaengine_desc_callback cb;
 
+	trace_xilinx_dma_complete(&desc->async_tx);
 	dmaengine_desc_get_callback(&desc->async_tx, &cb);
 	if (dmaengine_desc_callback_valid(&cb)) {
 		spin_unlock_irqrestore(&chan->lock, *flags);
@@ -1011,24 +1354,47 @@ static void xilinx_dma_chan_handle_cyclic(struct xilinx_dma_chan *chan,
 /**
  * xilinx_dma_chan_desc_cleanup - Clean channel descriptors
  * @chan: Driver specific DMA channel
+ *
+ * Completed descriptors are taken off the done list in one go and their
+ * callbacks run without the channel lock, which is then taken once more
+ * to free the whole batch. At most XILINX_DMA_CLEANUP_BUDGET descriptors
+ * are handled per run, the tasklet reschedules itself for the rest so a
+ * busy channel cannot monopolise the softirq.
  */
 static void xilinx_dma_chan_desc_cleanup(struct xilinx_dma_chan *chan)
 {
 	struct xilinx_dma_tx_descriptor *desc, *next;
+	int budget = XILINX_DMA_CLEANUP_BUDGET;
 	unsigned long flags;
+	bool cyclic = false;
+	bool more = false;
+	LIST_HEAD(done);
 
 	spin_lock_irqsave(&chan->lock, flags);
 
 	list_for_each_entry_safe(desc, next, &chan->done_list, node) {
-		struct dmaengine_result result;
-
 		if (desc->cyclic) {
-			xilinx_dma_chan_handle_cyclic(chan, desc, &flags);
+			cyclic = true;
+			break;
+		}
+		if (!budget--) {
+			more = true;
 			break;
 		}
+		list_move_tail(&desc->node, &done);
+	}
 
-		/* Remove from the list of running transactions */
-		list_del(&desc->node);
+	spin_unlock_irqrestore(&chan->lock, flags);
+
+	list_for_each_entry(desc, &done, node) {
+		struct dmaengine_result result;
+
+		/*
+		 * While we ran a callback the user called a terminate
+		 * function, the remaining descriptors are only freed.
+		 */
+		if (READ_ONCE(chan->terminating))
+			break;
 
 		if (unlikely(desc->err)) {
 			if (chan->direction == DMA_DEV_TO_MEM)
@@ -1042,23 +1408,32 @@ static void xilinx_dma_chan_desc_cleanup(struct xilinx_dma_chan *chan)
 		result.residue = desc->residue;
 
 		/* Run the link descriptor callback function */
-		spin_unlock_irqrestore(&chan->lock, flags);
+		trace_xilinx_dma_complete(&desc->async_tx);
 		dmaengine_desc_get_callback_invoke(&desc->async_tx, &result);
-		spin_lock_irqsave(&chan->lock, flags);
 
-		/* Run any dependencies, then free the descriptor */
+		/* Run any dependencies */
 		dma_run_dependencies(&desc->async_tx);
-		xilinx_dma_free_tx_descriptor(chan, desc);
+	}
 
-		/*
-		 * While we ran a callback the user called a terminate function,
-		 * which takes care of cleaning up any remaining descriptors
-		 */
-		if (chan->terminating)
-			break;
+	spin_lock_irqsave(&chan->lock, flags);
+
+	list_for_each_entry_safe(desc, next, &done, node) {
+		list_del(&desc->node);
+		xilinx_dma_release_tx_descriptor(chan, desc);
+	}
+
+	if (cyclic && !chan->terminating) {
+		desc = list_first_entry_or_null(&chan->done_list,
+						struct xilinx_dma_tx_descriptor,
+						node);
+		if (desc && desc->cyclic)
+			xilinx_dma_chan_handle_cyclic(chan, desc, &flags);
 	}
 
 	spin_unlock_irqrestore(&chan->lock, flags);
+
+	if (more && !READ_ONCE(chan->terminating))
+		tasklet_schedule(&chan->tasklet);
 }
 
 /**
@@ -1081,22 +1456,23 @@ static void xilinx_dma_do_tasklet(struct tasklet_struct *t)
 static int xilinx_dma_alloc_chan_resources(struct dma_chan *dchan)
 {
 	struct xilinx_dma_chan *chan = to_xilinx_chan(dchan);
-	int i;
 
 	/* Has this channel already been allocated? */
 	if (chan->desc_pool)
 		return 0;
 
+	chan->dropped_frames = 0;
+
 	/*
 	 * We need the descriptor to be aligned to 64bytes
 	 * for meeting Xilinx VDMA specification requirement.
 	 */
 	if (chan->xdev->dma_config->dmatype == XDMA_TYPE_AXIDMA) {
-		/* Allocate the buffer descriptors. */
-		chan->seg_v = dma_alloc_coherent(chan->dev,
-						 sizeof(*chan->seg_v) * XILINX_DMA_NUM_DESCS,
-						 &chan->seg_p, GFP_KERNEL);
-		if (!chan->seg_v) {
+		/*
+		 * Allocate the buffer descriptors. The pool grows on demand
+		 * once this first chunk is exhausted.
+		 */
+		if (xilinx_dma_seg_pool_grow(chan, GFP_KERNEL)) {
 			dev_err(chan->dev,
 				"unable to allocate channel %d descriptors\n",
 				chan->id);
@@ -1115,49 +1491,18 @@ static int xilinx_dma_alloc_chan_resources(struct dma_chan *dchan)
 		if (!chan->cyclic_seg_v) {
 			dev_err(chan->dev,
 				"unable to allocate desc segment for cyclic DMA\n");
-			dma_free_coherent(chan->dev, sizeof(*chan->seg_v) *
-				XILINX_DMA_NUM_DESCS, chan->seg_v,
-				chan->seg_p);
+			xilinx_dma_seg_pool_destroy(chan);
 			return -ENOMEM;
 		}
 		chan->cyclic_seg_v->phys = chan->cyclic_seg_p;
-
-		for (i = 0; i < XILINX_DMA_NUM_DESCS; i++) {
-			chan->seg_v[i].hw.next_desc =
-			lower_32_bits(chan->seg_p + sizeof(*chan->seg_v) *
-				((i + 1) % XILINX_DMA_NUM_DESCS));
-			chan->seg_v[i].hw.next_desc_msb =
-			upper_32_bits(chan->seg_p + sizeof(*chan->seg_v) *
-				((i + 1) % XILINX_DMA_NUM_DESCS));
-			chan->seg_v[i].phys = chan->seg_p +
-				sizeof(*chan->seg_v) * i;
-			list_add_tail(&chan->seg_v[i].node,
-				      &chan->free_seg_list);
-		}
 	} else if (chan->xdev->dma_config->dmatype == XDMA_TYPE_AXIMCDMA) {
 		/* Allocate the buffer descriptors. */
-		chan->seg_mv = dma_alloc_coherent(chan->dev,
-						  sizeof(*chan->seg_mv) *
-						  XILINX_DMA_NUM_DESCS,
-						  &chan->seg_p, GFP_KERNEL);
-		if (!chan->seg_mv) {
+		if (xilinx_dma_seg_pool_grow(chan, GFP_KERNEL)) {
 			dev_err(chan->dev,
 				"unable to allocate channel %d descriptors\n",
 				chan->id);
 			return -ENOMEM;
 		}
-		for (i = 0; i < XILINX_DMA_NUM_DESCS; i++) {
-			chan->seg_mv[i].hw.next_desc =
-			lower_32_bits(chan->seg_p + sizeof(*chan->seg_mv) *
-				((i + 1) % XILINX_DMA_NUM_DESCS));
-			chan->seg_mv[i].hw.next_desc_msb =
-			upper_32_bits(chan->seg_p + sizeof(*chan->seg_mv) *
-				((i + 1) % XILINX_DMA_NUM_DESCS));
-			chan->seg_mv[i].phys = chan->seg_p +
-				sizeof(*chan->seg_mv) * i;
-			list_add_tail(&chan->seg_mv[i].node,
-				      &chan->free_seg_list);
-		}
 	} else if (chan->xdev->dma_config->dmatype == XDMA_TYPE_CDMA) {
 		chan->desc_pool = dma_pool_create("xilinx_cdma_desc_pool",
 				   chan->dev,
@@ -1226,6 +1571,53 @@ static int xilinx_dma_calc_copysize(struct xilinx_dma_chan *chan,
 	return copy;
 }
 
+/**
+ * xilinx_dma_poll_complete - Complete the active descriptors done by hardware
+ * @chan: Driver specific DMA channel
+ *
+ * Used in polled mode, the complete bit of the last BD of each active
+ * descriptor is checked. With the whole active list done the pending
+ * descriptors are started. Called with the channel lock held.
+ *
+ * Return: true if descriptors were moved to the done list.
+ */
+static bool xilinx_dma_poll_complete(struct xilinx_dma_chan *chan)
+{
+	struct xilinx_dma_tx_descriptor *desc, *next;
+	struct xilinx_aximcdma_tx_segment *mcdma_seg;
+	struct xilinx_axidma_tx_segment *axidma_seg;
+	bool done = false;
+	u32 status;
+
+	list_for_each_entry_safe(desc, next, &chan->active_list, node) {
+		if (chan->xdev->dma_config->dmatype == XDMA_TYPE_AXIMCDMA) {
+			mcdma_seg = list_last_entry(&desc->segments,
+					struct xilinx_aximcdma_tx_segment, node);
+			status = READ_ONCE(mcdma_seg->hw.status);
+		} else {
+			axidma_seg = list_last_entry(&desc->segments,
+					struct xilinx_axidma_tx_segment, node);
+			status = READ_ONCE(axidma_seg->hw.status);
+		}
+		if (!(status & XILINX_DMA_BD_COMP_MASK))
+			break;
+
+		desc->residue = xilinx_dma_get_residue(chan, desc);
+		desc->err = chan->err;
+		list_del(&desc->node);
+		dma_cookie_complete(&desc->async_tx);
+		list_add_tail(&desc->node, &chan->done_list);
+		done = true;
+	}
+
+	if (done && list_empty(&chan->active_list)) {
+		chan->idle = true;
+		chan->start_transfer(chan);
+	}
+
+	return done;
+}
+
 /**
  * xilinx_dma_tx_status - Get DMA transaction status
  * @dchan: DMA channel
@@ -1245,7 +1637,32 @@ static enum dma_status xilinx_dma_tx_status(struct dma_chan *dchan,
 	u32 residue = 0;
 
 	ret = dma_cookie_status(dchan, cookie, txstate);
-	if (ret == DMA_COMPLETE || !txstate)
+	if (ret == DMA_COMPLETE)
+		return ret;
+
+	/* The irq handler keeps the cyclic position, no need to walk BDs */
+	if (chan->cyclic) {
+		dma_set_residue(txstate, READ_ONCE(chan->cyclic_residue));
+		return ret;
+	}
+
+	if (chan->polled) {
+		bool done;
+
+		spin_lock_irqsave(&chan->lock, flags);
+		done = xilinx_dma_poll_complete(chan);
+		spin_unlock_irqrestore(&chan->lock, flags);
+
+		/* Callbacks and freeing are left to the tasklet */
+		if (done) {
+			tasklet_schedule(&chan->tasklet);
+			ret = dma_cookie_status(dchan, cookie, txstate);
+		}
+		if (ret == DMA_COMPLETE)
+			return ret;
+	}
+
+	if (!txstate)
 		return ret;
 
 	spin_lock_irqsave(&chan->lock, flags);
@@ -1299,6 +1716,21 @@ static int xilinx_cdma_stop_transfer(struct xilinx_dma_chan *chan)
 				       XILINX_DMA_LOOP_COUNT);
 }
 
+/**
+ * xilinx_dma_trace_start - Trace the start of the pending descriptors
+ * @chan: Driver specific DMA channel
+ */
+static void xilinx_dma_trace_start(struct xilinx_dma_chan *chan)
+{
+	struct xilinx_dma_tx_descriptor *desc;
+
+	if (!trace_xilinx_dma_start_enabled())
+		return;
+
+	list_for_each_entry(desc, &chan->pending_list, node)
+		trace_xilinx_dma_start(&desc->async_tx);
+}
+
 /**
  * xilinx_dma_start - Start DMA channel
  * @chan: Driver specific DMA channel
@@ -1416,6 +1848,7 @@ static void xilinx_vdma_start_transfer(struct xilinx_dma_chan *chan)
 			last->hw.stride);
 	vdma_desc_write(chan, XILINX_DMA_REG_VSIZE, last->hw.vsize);
 
+	trace_xilinx_dma_start(&desc->async_tx);
 	chan->desc_submitcount++;
 	chan->desc_pendingcount--;
 	list_move_tail(&desc->node, &chan->active_list);
@@ -1492,6 +1925,7 @@ static void xilinx_cdma_start_transfer(struct xilinx_dma_chan *chan)
 				hw->control & chan->xdev->max_buffer_len);
 	}
 
+	xilinx_dma_trace_start(chan);
 	list_splice_tail_init(&chan->pending_list, &chan->active_list);
 	chan->desc_pendingcount = 0;
 	chan->idle = false;
@@ -1529,9 +1963,14 @@ static void xilinx_dma_start_transfer(struct xilinx_dma_chan *chan)
 		reg &= ~XILINX_DMA_CR_COALESCE_MAX;
 		reg |= chan->desc_pendingcount <<
 				  XILINX_DMA_CR_COALESCE_SHIFT;
-		dma_ctrl_write(chan, XILINX_DMA_REG_DMACR, reg);
 	}
 
+	/* Only errors interrupt a polled channel */
+	if (chan->polled)
+		reg &= ~(XILINX_DMA_DMASR_FRM_CNT_IRQ |
+			 XILINX_DMA_DMASR_DLY_CNT_IRQ);
+	dma_ctrl_write(chan, XILINX_DMA_REG_DMACR, reg);
+
 	if (chan->has_sg)
 		xilinx_write(chan, XILINX_DMA_REG_CURDESC,
 			     head_desc->async_tx.phys);
@@ -1566,6 +2005,7 @@ static void xilinx_dma_start_transfer(struct xilinx_dma_chan *chan)
 			       hw->control & chan->xdev->max_buffer_len);
 	}
 
+	xilinx_dma_trace_start(chan);
 	list_splice_tail_init(&chan->pending_list, &chan->active_list);
 	chan->desc_pendingcount = 0;
 	chan->idle = false;
@@ -1611,6 +2051,9 @@ static void xilinx_mcdma_start_transfer(struct xilinx_dma_chan *chan)
 	}
 
 	reg |= XILINX_MCDMA_IRQ_ALL_MASK;
+	/* Only errors interrupt a polled channel */
+	if (chan->polled)
+		reg &= ~(XILINX_MCDMA_IRQ_IOC_MASK | XILINX_MCDMA_IRQ_DELAY_MASK);
 	dma_ctrl_write(chan, XILINX_MCDMA_CHAN_CR_OFFSET(chan->tdest), reg);
 
 	/* Program current descriptor */
@@ -1636,6 +2079,7 @@ static void xilinx_mcdma_start_transfer(struct xilinx_dma_chan *chan)
 	xilinx_write(chan, XILINX_MCDMA_CHAN_TDESC_OFFSET(chan->tdest),
 		     tail_segment->phys);
 
+	xilinx_dma_trace_start(chan);
 	list_splice_tail_init(&chan->pending_list, &chan->active_list);
 	chan->desc_pendingcount = 0;
 	chan->idle = false;
@@ -1695,6 +2139,36 @@ static void xilinx_dma_complete_descriptor(struct xilinx_dma_chan *chan)
 	}
 }
 
+/**
+ * xilinx_vdma_recycle_oldest - Keep capturing into the oldest frame store
+ * @chan : xilinx DMA channel
+ *
+ * A S2MM channel in drop-oldest mode which has no fresh buffer pending when
+ * a frame completes doesn't complete its oldest active descriptor, it moves
+ * it back to the pending list to be programmed as the next frame store. The
+ * frame it holds is overwritten by the next one and counted as dropped, so
+ * the channel keeps capturing while the client is late returning buffers
+ * and the client gets the latest frames once it catches up.
+ *
+ * CONTEXT: hardirq
+ */
+static void xilinx_vdma_recycle_oldest(struct xilinx_dma_chan *chan)
+{
+	struct xilinx_dma_tx_descriptor *desc;
+
+	/* This function was invoked with lock held */
+	if (!chan->config.drop_oldest || chan->err ||
+	    !list_empty(&chan->pending_list) ||
+	    list_empty(&chan->active_list))
+		return;
+
+	desc = list_first_entry(&chan->active_list,
+				struct xilinx_dma_tx_descriptor, node);
+	list_move(&desc->node, &chan->pending_list);
+	chan->desc_pendingcount++;
+	chan->dropped_frames++;
+}
+
 /**
  * xilinx_dma_reset - Reset DMA channel
  * @chan: Driver specific DMA channel
@@ -1751,38 +2225,21 @@ static int xilinx_dma_chan_reset(struct xilinx_dma_chan *chan)
 }
 
 /**
- * xilinx_mcdma_irq_handler - MCDMA Interrupt handler
- * @irq: IRQ number
- * @data: Pointer to the Xilinx MCDMA channel structure
+ * xilinx_mcdma_chan_irq - Service the interrupt of one MCDMA channel
+ * @chan: Driver specific DMA channel
  *
- * Return: IRQ_HANDLED/IRQ_NONE
+ * Return: true if the channel had an interrupt pending
  */
-static irqreturn_t xilinx_mcdma_irq_handler(int irq, void *data)
+static bool xilinx_mcdma_chan_irq(struct xilinx_dma_chan *chan)
 {
-	struct xilinx_dma_chan *chan = data;
-	u32 status, ser_offset, chan_sermask, chan_offset = 0, chan_id;
-
-	if (chan->direction == DMA_DEV_TO_MEM)
-		ser_offset = XILINX_MCDMA_RXINT_SER_OFFSET;
-	else
-		ser_offset = XILINX_MCDMA_TXINT_SER_OFFSET;
-
-	/* Read the channel id raising the interrupt*/
-	chan_sermask = dma_ctrl_read(chan, ser_offset);
-	chan_id = ffs(chan_sermask);
-
-	if (!chan_id)
-		return IRQ_NONE;
-
-	if (chan->direction == DMA_DEV_TO_MEM)
-		chan_offset = chan->xdev->dma_config->max_channels / 2;
+	u32 status;
 
-	chan_offset = chan_offset + (chan_id - 1);
-	chan = chan->xdev->chan[chan_offset];
 	/* Read the status and ack the interrupts. */
 	status = dma_ctrl_read(chan, XILINX_MCDMA_CHAN_SR_OFFSET(chan->tdest));
 	if (!(status & XILINX_MCDMA_IRQ_ALL_MASK))
-		return IRQ_NONE;
+		return false;
+
+	trace_xilinx_dma_irq(&chan->common, status);
 
 	dma_ctrl_write(chan, XILINX_MCDMA_CHAN_SR_OFFSET(chan->tdest),
 		       status & XILINX_MCDMA_IRQ_ALL_MASK);
@@ -1815,7 +2272,100 @@ static irqreturn_t xilinx_mcdma_irq_handler(int irq, void *data)
 	}
 
 	tasklet_schedule(&chan->tasklet);
-	return IRQ_HANDLED;
+	return true;
+}
+
+/**
+ * xilinx_mcdma_irq_handler - MCDMA Interrupt handler
+ * @irq: IRQ number
+ * @data: Pointer to the Xilinx MCDMA channel structure
+ *
+ * Return: IRQ_HANDLED/IRQ_NONE
+ */
+static irqreturn_t xilinx_mcdma_irq_handler(int irq, void *data)
+{
+	struct xilinx_dma_chan *chan = data;
+	struct xilinx_dma_device *xdev = chan->xdev;
+	u32 nr_chans = xdev->dma_config->max_channels / 2;
+	u32 ser_offset, chan_offset = 0;
+	unsigned long chan_sermask;
+	unsigned int bit, pass;
+	bool handled = false;
+
+	if (chan->direction == DMA_DEV_TO_MEM) {
+		ser_offset = XILINX_MCDMA_RXINT_SER_OFFSET;
+		chan_offset = nr_chans;
+	} else {
+		ser_offset = XILINX_MCDMA_TXINT_SER_OFFSET;
+	}
+
+	/*
+	 * Service every channel raising the interrupt, and the ones which
+	 * raised it meanwhile, instead of taking one interrupt per channel.
+	 */
+	for (pass = 0; pass < XILINX_MCDMA_IRQ_MAX_PASSES; pass++) {
+		bool serviced = false;
+
+		chan_sermask = dma_ctrl_read(chan, ser_offset);
+		for_each_set_bit(bit, &chan_sermask, nr_chans) {
+			struct xilinx_dma_chan *ichan;
+
+			ichan = xdev->chan[chan_offset + bit];
+			if (ichan && xilinx_mcdma_chan_irq(ichan))
+				serviced = true;
+		}
+		if (!serviced)
+			break;
+		handled = true;
+	}
+
+	return handled ? IRQ_HANDLED : IRQ_NONE;
+}
+
+/**
+ * xilinx_dma_cyclic_update - Advance the position of a cyclic transfer
+ * @chan: Driver specific DMA channel
+ *
+ * Consume the BDs completed since the last interrupt and publish the new
+ * residue and last completed period. The hardware does not look at the
+ * complete bit in cyclic mode, so it is cleared here to spot the next lap.
+ * Called with the channel lock held.
+ */
+static void xilinx_dma_cyclic_update(struct xilinx_dma_chan *chan)
+{
+	struct xilinx_dma_tx_descriptor *desc = chan->cyclic_desc;
+	struct xilinx_axidma_tx_segment *seg = chan->cyclic_cur;
+	u32 period;
+
+	if (!seg)
+		return;
+
+	while (READ_ONCE(seg->hw.status) & XILINX_DMA_BD_COMP_MASK) {
+		WRITE_ONCE(seg->hw.status, 0);
+
+		chan->cyclic_period_bytes += seg->hw.control &
+					     chan->xdev->max_buffer_len;
+		if (chan->cyclic_period_bytes >= desc->period_len) {
+			chan->cyclic_period_bytes = 0;
+			WRITE_ONCE(chan->cyclic_period,
+				   (chan->cyclic_period + 1) %
+				   desc->num_periods);
+		}
+
+		if (list_is_last(&seg->node, &desc->segments))
+			seg = list_first_entry(&desc->segments,
+					       struct xilinx_axidma_tx_segment,
+					       node);
+		else
+			seg = list_next_entry(seg, node);
+	}
+	chan->cyclic_cur = seg;
+
+	/* Period still in progress and the bytes already done in it */
+	period = (chan->cyclic_period + 1) % desc->num_periods;
+	WRITE_ONCE(chan->cyclic_residue,
+		   (desc->num_periods - period) * desc->period_len -
+		   chan->cyclic_period_bytes);
 }
 
 /**
@@ -1835,6 +2385,8 @@ static irqreturn_t xilinx_dma_irq_handler(int irq, void *data)
 	if (!(status & XILINX_DMA_DMAXR_ALL_IRQ_MASK))
 		return IRQ_NONE;
 
+	trace_xilinx_dma_irq(&chan->common, status);
+
 	dma_ctrl_write(chan, XILINX_DMA_REG_DMASR,
 			status & XILINX_DMA_DMAXR_ALL_IRQ_MASK);
 
@@ -1872,6 +2424,9 @@ static irqreturn_t xilinx_dma_irq_handler(int irq, void *data)
 
 	if (status & XILINX_DMA_DMASR_FRM_CNT_IRQ) {
 		spin_lock(&chan->lock);
+		if (chan->cyclic)
+			xilinx_dma_cyclic_update(chan);
+		xilinx_vdma_recycle_oldest(chan);
 		xilinx_dma_complete_descriptor(chan);
 		chan->idle = true;
 		chan->start_transfer(chan);
@@ -1919,13 +2474,19 @@ static void append_desc_queue(struct xilinx_dma_chan *chan,
 		axidma_tail_segment = list_last_entry(&tail_desc->segments,
 					       struct xilinx_axidma_tx_segment,
 					       node);
-		axidma_tail_segment->hw.next_desc = (u32)desc->async_tx.phys;
+		axidma_tail_segment->hw.next_desc =
+			lower_32_bits(desc->async_tx.phys);
+		axidma_tail_segment->hw.next_desc_msb =
+			upper_32_bits(desc->async_tx.phys);
 	} else {
 		aximcdma_tail_segment =
 			list_last_entry(&tail_desc->segments,
 					struct xilinx_aximcdma_tx_segment,
 					node);
-		aximcdma_tail_segment->hw.next_desc = (u32)desc->async_tx.phys;
+		aximcdma_tail_segment->hw.next_desc =
+			lower_32_bits(desc->async_tx.phys);
+		aximcdma_tail_segment->hw.next_desc_msb =
+			upper_32_bits(desc->async_tx.phys);
 	}
 
 	/*
@@ -1958,7 +2519,7 @@ static dma_cookie_t xilinx_dma_tx_submit(struct dma_async_tx_descriptor *tx)
 	int err;
 
 	if (chan->cyclic) {
-		xilinx_dma_free_tx_descriptor(chan, desc);
+		xilinx_dma_release_tx_descriptor(chan, desc);
 		return -EBUSY;
 	}
 
@@ -1974,13 +2535,26 @@ static dma_cookie_t xilinx_dma_tx_submit(struct dma_async_tx_descriptor *tx)
 
 	spin_lock_irqsave(&chan->lock, flags);
 
+	if (dmaengine_desc_test_reuse(tx))
+		xilinx_dma_rearm_tx_descriptor(chan, desc);
+
 	cookie = dma_cookie_assign(tx);
+	trace_xilinx_dma_submit(tx);
 
 	/* Put this transaction onto the tail of the pending queue */
 	append_desc_queue(chan, desc);
 
-	if (desc->cyclic)
+	if (desc->cyclic) {
 		chan->cyclic = true;
+		chan->cyclic_desc = desc;
+		chan->cyclic_cur =
+			list_first_entry(&desc->segments,
+					 struct xilinx_axidma_tx_segment, node);
+		chan->cyclic_period_bytes = 0;
+		WRITE_ONCE(chan->cyclic_period, -1);
+		WRITE_ONCE(chan->cyclic_residue,
+			   desc->num_periods * desc->period_len);
+	}
 
 	chan->terminating = false;
 
@@ -2064,6 +2638,7 @@ xilinx_vdma_dma_prep_interleaved(struct dma_chan *dchan,
 				   struct xilinx_vdma_tx_segment, node);
 	desc->async_tx.phys = segment->phys;
 
+	trace_xilinx_dma_prep(&desc->async_tx);
 	return &desc->async_tx;
 
 error:
@@ -2120,6 +2695,7 @@ xilinx_cdma_prep_memcpy(struct dma_chan *dchan, dma_addr_t dma_dst,
 	desc->async_tx.phys = segment->phys;
 	hw->next_desc = segment->phys;
 
+	trace_xilinx_dma_prep(&desc->async_tx);
 	return &desc->async_tx;
 
 error:
@@ -2145,7 +2721,7 @@ static struct dma_async_tx_descriptor *xilinx_dma_prep_slave_sg(
 {
 	struct xilinx_dma_chan *chan = to_xilinx_chan(dchan);
 	struct xilinx_dma_tx_descriptor *desc;
-	struct xilinx_axidma_tx_segment *segment = NULL;
+	struct xilinx_axidma_tx_segment *segment = NULL, *prev = NULL;
 	u32 *app_w = (u32 *)context;
 	struct scatterlist *sg;
 	size_t copy;
@@ -2162,6 +2738,7 @@ static struct dma_async_tx_descriptor *xilinx_dma_prep_slave_sg(
 
 	dma_async_tx_descriptor_init(&desc->async_tx, &chan->common);
 	desc->async_tx.tx_submit = xilinx_dma_tx_submit;
+	desc->async_tx.desc_free = xilinx_dma_desc_free;
 
 	/* Build transactions using information in the scatter gather list */
 	for_each_sg(sgl, sg, sg_len, i) {
@@ -2196,6 +2773,13 @@ static struct dma_async_tx_descriptor *xilinx_dma_prep_slave_sg(
 					       XILINX_DMA_NUM_APP_WORDS);
 			}
 
+			if (prev) {
+				prev->hw.next_desc = lower_32_bits(segment->phys);
+				prev->hw.next_desc_msb =
+					upper_32_bits(segment->phys);
+			}
+
+			prev = segment;
 			sg_used += copy;
 
 			/*
@@ -2219,6 +2803,7 @@ static struct dma_async_tx_descriptor *xilinx_dma_prep_slave_sg(
 		segment->hw.control |= XILINX_DMA_BD_EOP;
 	}
 
+	trace_xilinx_dma_prep(&desc->async_tx);
 	return &desc->async_tx;
 
 error:
@@ -2269,6 +2854,7 @@ static struct dma_async_tx_descriptor *xilinx_dma_prep_dma_cyclic(
 	chan->direction = direction;
 	dma_async_tx_descriptor_init(&desc->async_tx, &chan->common);
 	desc->async_tx.tx_submit = xilinx_dma_tx_submit;
+	desc->async_tx.desc_free = xilinx_dma_desc_free;
 
 	for (i = 0; i < num_periods; ++i) {
 		sg_used = 0;
@@ -2292,8 +2878,11 @@ static struct dma_async_tx_descriptor *xilinx_dma_prep_dma_cyclic(
 					  period_len * i);
 			hw->control = copy;
 
-			if (prev)
-				prev->hw.next_desc = segment->phys;
+			if (prev) {
+				prev->hw.next_desc = lower_32_bits(segment->phys);
+				prev->hw.next_desc_msb =
+					upper_32_bits(segment->phys);
+			}
 
 			prev = segment;
 			sg_used += copy;
@@ -2311,6 +2900,8 @@ static struct dma_async_tx_descriptor *xilinx_dma_prep_dma_cyclic(
 	desc->async_tx.phys = head_segment->phys;
 
 	desc->cyclic = true;
+	desc->period_len = period_len;
+	desc->num_periods = num_periods;
 	reg = dma_ctrl_read(chan, XILINX_DMA_REG_DMACR);
 	reg |= XILINX_DMA_CR_CYCLIC_BD_EN_MASK;
 	dma_ctrl_write(chan, XILINX_DMA_REG_DMACR, reg);
@@ -2318,7 +2909,8 @@ static struct dma_async_tx_descriptor *xilinx_dma_prep_dma_cyclic(
 	segment = list_last_entry(&desc->segments,
 				  struct xilinx_axidma_tx_segment,
 				  node);
-	segment->hw.next_desc = (u32) head_segment->phys;
+	segment->hw.next_desc = lower_32_bits(head_segment->phys);
+	segment->hw.next_desc_msb = upper_32_bits(head_segment->phys);
 
 	/* For the last DMA_MEM_TO_DEV transfer, set EOP */
 	if (direction == DMA_MEM_TO_DEV) {
@@ -2326,6 +2918,7 @@ static struct dma_async_tx_descriptor *xilinx_dma_prep_dma_cyclic(
 		segment->hw.control |= XILINX_DMA_BD_EOP;
 	}
 
+	trace_xilinx_dma_prep(&desc->async_tx);
 	return &desc->async_tx;
 
 error:
@@ -2352,7 +2945,7 @@ xilinx_mcdma_prep_slave_sg(struct dma_chan *dchan, struct scatterlist *sgl,
 {
 	struct xilinx_dma_chan *chan = to_xilinx_chan(dchan);
 	struct xilinx_dma_tx_descriptor *desc;
-	struct xilinx_aximcdma_tx_segment *segment = NULL;
+	struct xilinx_aximcdma_tx_segment *segment = NULL, *prev = NULL;
 	u32 *app_w = (u32 *)context;
 	struct scatterlist *sg;
 	size_t copy;
@@ -2369,6 +2962,7 @@ xilinx_mcdma_prep_slave_sg(struct dma_chan *dchan, struct scatterlist *sgl,
 
 	dma_async_tx_descriptor_init(&desc->async_tx, &chan->common);
 	desc->async_tx.tx_submit = xilinx_dma_tx_submit;
+	desc->async_tx.desc_free = xilinx_dma_desc_free;
 
 	/* Build transactions using information in the scatter gather list */
 	for_each_sg(sgl, sg, sg_len, i) {
@@ -2401,6 +2995,13 @@ xilinx_mcdma_prep_slave_sg(struct dma_chan *dchan, struct scatterlist *sgl,
 				       XILINX_DMA_NUM_APP_WORDS);
 			}
 
+			if (prev) {
+				prev->hw.next_desc = lower_32_bits(segment->phys);
+				prev->hw.next_desc_msb =
+					upper_32_bits(segment->phys);
+			}
+
+			prev = segment;
 			sg_used += copy;
 			/*
 			 * Insert the segment into the descriptor segments
@@ -2423,6 +3024,7 @@ xilinx_mcdma_prep_slave_sg(struct dma_chan *dchan, struct scatterlist *sgl,
 		segment->hw.control |= XILINX_MCDMA_BD_EOP;
 	}
 
+	trace_xilinx_dma_prep(&desc->async_tx);
 	return &desc->async_tx;
 
 error:
@@ -2487,6 +3089,7 @@ static void xilinx_dma_synchronize(struct dma_chan *dchan)
  * . configure interrupt coalescing and inter-packet delay threshold
  * . start/stop parking
  * . enable genlock
+ * . drop the oldest frame instead of stalling S2MM
  *
  * @dchan: DMA channel
  * @cfg: VDMA device configuration pointer
@@ -2520,6 +3123,8 @@ int xilinx_vdma_channel_set_config(struct dma_chan *dchan,
 
 	chan->config.frm_cnt_en = cfg->frm_cnt_en;
 	chan->config.vflip_en = cfg->vflip_en;
+	chan->config.drop_oldest = cfg->drop_oldest &&
+				   chan->direction == DMA_DEV_TO_MEM;
 
 	if (cfg->park)
 		chan->config.park_frm = cfg->park_frm;
@@ -2551,6 +3156,292 @@ int xilinx_vdma_channel_set_config(struct dma_chan *dchan,
 }
 EXPORT_SYMBOL(xilinx_vdma_channel_set_config);
 
+/**
+ * xilinx_vdma_channel_get_dropped - Get the frames dropped by a channel
+ * @dchan: DMA channel
+ * @dropped: returns the number of frames dropped in drop-oldest mode since
+ *	     the channel resources were allocated
+ *
+ * Return: '0' on success
+ */
+int xilinx_vdma_channel_get_dropped(struct dma_chan *dchan, u64 *dropped)
+{
+	struct xilinx_dma_chan *chan = to_xilinx_chan(dchan);
+	unsigned long flags;
+
+	spin_lock_irqsave(&chan->lock, flags);
+	*dropped = chan->dropped_frames;
+	spin_unlock_irqrestore(&chan->lock, flags);
+
+	return 0;
+}
+EXPORT_SYMBOL(xilinx_vdma_channel_get_dropped);
+
+/**
+ * xilinx_dma_channel_set_polled - Select polled completion for a channel
+ * @dchan: DMA channel
+ * @polled: true to poll for completions, false to go back to interrupts
+ *
+ * In polled mode the channel no longer raises completion interrupts.
+ * dmaengine_tx_status() checks the BD complete bits itself and reports
+ * finished transfers immediately, callbacks still run from the tasklet.
+ * Error interrupts stay enabled. Only AXI DMA and MCDMA channels in
+ * scatter gather mode support this, cyclic transfers are not allowed.
+ *
+ * Return: '0' on success and -EINVAL if the channel cannot be polled
+ */
+int xilinx_dma_channel_set_polled(struct dma_chan *dchan, bool polled)
+{
+	struct xilinx_dma_chan *chan = to_xilinx_chan(dchan);
+	enum xdma_ip_type dmatype = chan->xdev->dma_config->dmatype;
+	unsigned long flags;
+
+	if ((dmatype != XDMA_TYPE_AXIDMA && dmatype != XDMA_TYPE_AXIMCDMA) ||
+	    !chan->has_sg || chan->cyclic)
+		return -EINVAL;
+
+	spin_lock_irqsave(&chan->lock, flags);
+	chan->polled = polled;
+	if (dmatype == XDMA_TYPE_AXIMCDMA) {
+		u32 reg = dma_ctrl_read(chan,
+					XILINX_MCDMA_CHAN_CR_OFFSET(chan->tdest));
+
+		if (polled)
+			reg &= ~(XILINX_MCDMA_IRQ_IOC_MASK |
+				 XILINX_MCDMA_IRQ_DELAY_MASK);
+		else
+			reg |= XILINX_MCDMA_IRQ_IOC_MASK |
+			       XILINX_MCDMA_IRQ_DELAY_MASK;
+		dma_ctrl_write(chan, XILINX_MCDMA_CHAN_CR_OFFSET(chan->tdest),
+			       reg);
+	} else if (polled) {
+		dma_ctrl_clr(chan, XILINX_DMA_REG_DMACR,
+			     XILINX_DMA_DMASR_FRM_CNT_IRQ |
+			     XILINX_DMA_DMASR_DLY_CNT_IRQ);
+	} else {
+		dma_ctrl_set(chan, XILINX_DMA_REG_DMACR,
+			     XILINX_DMA_DMASR_FRM_CNT_IRQ |
+			     XILINX_DMA_DMASR_DLY_CNT_IRQ);
+	}
+
+	/* Transfers finished before the switch are picked up here */
+	if (!polled && xilinx_dma_poll_complete(chan))
+		tasklet_schedule(&chan->tasklet);
+	spin_unlock_irqrestore(&chan->lock, flags);
+
+	return 0;
+}
+EXPORT_SYMBOL(xilinx_dma_channel_set_polled);
+
+/**
+ * xilinx_dma_cyclic_get_period - Get the last completed period of a channel
+ * @dchan: DMA channel
+ * @period: returns the index of the last completed period
+ *
+ * Lockless alternative to dmaengine_tx_status() for clients that track a
+ * cyclic buffer in periods. The index is taken from the position cached by
+ * the interrupt handler, it wraps after the last period of the buffer.
+ *
+ * Return: '0' on success, -EINVAL if no cyclic transfer runs on the channel
+ * and -EAGAIN if no period has completed yet
+ */
+int xilinx_dma_cyclic_get_period(struct dma_chan *dchan, unsigned int *period)
+{
+	struct xilinx_dma_chan *chan = to_xilinx_chan(dchan);
+	int last;
+
+	if (!READ_ONCE(chan->cyclic))
+		return -EINVAL;
+
+	last = READ_ONCE(chan->cyclic_period);
+	if (last < 0)
+		return -EAGAIN;
+
+	*period = last;
+
+	return 0;
+}
+EXPORT_SYMBOL(xilinx_dma_cyclic_get_period);
+
+#if IS_REACHABLE(CONFIG_DMA_SHARED_BUFFER)
+/**
+ * struct xilinx_dma_buf_fence - Fence of a dma-buf transfer
+ * @base: DMA fence
+ * @lock: Fence lock
+ * @chan: DMA channel running the transfer
+ * @callback: Client completion callback
+ * @callback_param: Parameter of @callback
+ */
+struct xilinx_dma_buf_fence {
+	struct dma_fence base;
+	spinlock_t lock;
+	struct dma_chan *chan;
+	dma_async_tx_callback_result callback;
+	void *callback_param;
+};
+
+static const char *xilinx_dma_buf_fence_driver_name(struct dma_fence *fence)
+{
+	return "xilinx_dma";
+}
+
+static const char *xilinx_dma_buf_fence_timeline_name(struct dma_fence *fence)
+{
+	struct xilinx_dma_buf_fence *f =
+		container_of(fence, struct xilinx_dma_buf_fence, base);
+
+	return dma_chan_name(f->chan);
+}
+
+static const struct dma_fence_ops xilinx_dma_buf_fence_ops = {
+	.get_driver_name = xilinx_dma_buf_fence_driver_name,
+	.get_timeline_name = xilinx_dma_buf_fence_timeline_name,
+};
+
+static void xilinx_dma_buf_complete(void *param,
+				    const struct dmaengine_result *result)
+{
+	struct xilinx_dma_buf_fence *f = param;
+
+	if (result && result->result != DMA_TRANS_NOERROR)
+		dma_fence_set_error(&f->base, -EIO);
+	dma_fence_signal(&f->base);
+
+	if (f->callback)
+		f->callback(f->callback_param, result);
+
+	dma_fence_put(&f->base);
+}
+
+/*
+ * Signal the fence of a dma-buf transfer whose descriptor is dropped by
+ * terminate_all or free_chan_resources.
+ */
+static void xilinx_dma_buf_cancel(struct xilinx_dma_tx_descriptor *desc,
+				  enum dmaengine_tx_result result)
+{
+	struct dmaengine_result res = { .result = result };
+
+	if (desc->async_tx.callback_result != xilinx_dma_buf_complete)
+		return;
+
+	desc->async_tx.callback_result = NULL;
+	xilinx_dma_buf_complete(desc->async_tx.callback_param, &res);
+}
+
+/**
+ * xilinx_dma_submit_dmabuf - Submit a slave transfer on a dma-buf
+ * @dchan: DMA channel
+ * @attach: dma-buf attachment of the channel device
+ * @sgt: Mapping of @attach, from dma_buf_map_attachment()
+ * @direction: DMA_MEM_TO_DEV to read the buffer, DMA_DEV_TO_MEM to fill it
+ * @callback: Optional completion callback
+ * @callback_param: Parameter of @callback
+ *
+ * Build a scatter gather transfer straight from the dma-buf mapping, so
+ * buffers shared with other devices need no bounce copy. The transfer
+ * waits for the fences already attached to the buffer, its own fence is
+ * then added to the buffer reservation object and signalled from the
+ * completion callback, with an error if the transfer failed.
+ *
+ * The caller keeps @sgt mapped until the fence signals and still has to
+ * call dma_async_issue_pending().
+ *
+ * Return: A reference to the transfer fence on success, to be released
+ * with dma_fence_put(), or an ERR_PTR() on failure
+ */
+struct dma_fence *xilinx_dma_submit_dmabuf(struct dma_chan *dchan,
+					   struct dma_buf_attachment *attach,
+					   struct sg_table *sgt,
+					   enum dma_transfer_direction direction,
+					   dma_async_tx_callback_result callback,
+					   void *callback_param)
+{
+	struct xilinx_dma_chan *chan = to_xilinx_chan(dchan);
+	struct dma_resv *resv = attach->dmabuf->resv;
+	bool write = direction == DMA_DEV_TO_MEM;
+	struct dma_async_tx_descriptor *txd;
+	struct xilinx_dma_buf_fence *f;
+	dma_cookie_t cookie;
+	long timeout;
+	int err;
+
+	if (!is_slave_direction(direction))
+		return ERR_PTR(-EINVAL);
+
+	f = kzalloc(sizeof(*f), GFP_KERNEL);
+	if (!f)
+		return ERR_PTR(-ENOMEM);
+
+	spin_lock_init(&f->lock);
+	f->chan = dchan;
+	f->callback = callback;
+	f->callback_param = callback_param;
+
+	err = dma_resv_lock_interruptible(resv, NULL);
+	if (err)
+		goto err_free;
+
+	/* Writers wait for all users, readers only for the last writer */
+	timeout = dma_resv_wait_timeout(resv, dma_resv_usage_rw(write), true,
+					MAX_SCHEDULE_TIMEOUT);
+	if (timeout < 0) {
+		err = timeout;
+		goto err_unlock;
+	}
+
+	err = dma_resv_reserve_fences(resv, 1);
+	if (err)
+		goto err_unlock;
+
+	txd = dmaengine_prep_slave_sg(dchan, sgt->sgl, sgt->nents, direction,
+				      DMA_PREP_INTERRUPT | DMA_CTRL_ACK);
+	if (!txd) {
+		err = -ENOMEM;
+		goto err_unlock;
+	}
+
+	txd->callback_result = xilinx_dma_buf_complete;
+	txd->callback_param = f;
+
+	/*
+	 * The channel completes transfers in submission order, so the fences
+	 * of its context get their seqnos in that order too.
+	 */
+	spin_lock(&chan->fence_lock);
+	dma_fence_init(&f->base, &xilinx_dma_buf_fence_ops, &f->lock,
+		       chan->fence_context, ++chan->fence_seqno);
+	/* One reference for the caller, one dropped at completion */
+	dma_fence_get(&f->base);
+	cookie = dmaengine_submit(txd);
+	spin_unlock(&chan->fence_lock);
+
+	err = dma_submit_error(cookie);
+	if (err) {
+		dma_fence_put(&f->base);
+		goto err_put;
+	}
+
+	dma_resv_add_fence(resv, &f->base, write ? DMA_RESV_USAGE_WRITE :
+						   DMA_RESV_USAGE_READ);
+	dma_resv_unlock(resv);
+
+	return &f->base;
+
+err_put:
+	dma_resv_unlock(resv);
+	dma_fence_put(&f->base);
+	return ERR_PTR(err);
+
+err_unlock:
+	dma_resv_unlock(resv);
+err_free:
+	kfree(f);
+	return ERR_PTR(err);
+}
+EXPORT_SYMBOL(xilinx_dma_submit_dmabuf);
+#endif
+
 /* -----------------------------------------------------------------------------
  * Probe and remove
  */
@@ -2767,6 +3658,7 @@ static int xilinx_dma_chan_probe(struct xilinx_dma_device *xdev,
 	struct xilinx_dma_chan *chan;
 	bool has_dre = false;
 	u32 value, width;
+	int cpu;
 	int err;
 
 	/* Allocate and initialize the channel structure */
@@ -2786,10 +3678,27 @@ static int xilinx_dma_chan_probe(struct xilinx_dma_device *xdev,
 	chan->idle = true;
 
 	spin_lock_init(&chan->lock);
+	spin_lock_init(&chan->fence_lock);
+	chan->fence_context = dma_fence_context_alloc(1);
 	INIT_LIST_HEAD(&chan->pending_list);
 	INIT_LIST_HEAD(&chan->done_list);
 	INIT_LIST_HEAD(&chan->active_list);
 	INIT_LIST_HEAD(&chan->free_seg_list);
+	spin_lock_init(&chan->seg_lock);
+	INIT_LIST_HEAD(&chan->seg_chunks);
+
+	chan->seg_cache = devm_alloc_percpu(xdev->dev,
+					    struct xilinx_dma_seg_cache);
+	if (!chan->seg_cache)
+		return -ENOMEM;
+
+	for_each_possible_cpu(cpu) {
+		struct xilinx_dma_seg_cache *cache;
+
+		cache = per_cpu_ptr(chan->seg_cache, cpu);
+		local_lock_init(&cache->lock);
+		INIT_LIST_HEAD(&cache->segs);
+	}
 
 	/* Retrieve the channel properties from the device tree */
 	has_dre = of_property_read_bool(node, "xlnx,include-dre");
@@ -3118,6 +4027,7 @@ static int xilinx_dma_probe(struct platform_device *pdev)
 	if (xdev->dma_config->dmatype == XDMA_TYPE_AXIDMA) {
 		dma_cap_set(DMA_CYCLIC, xdev->common.cap_mask);
 		xdev->common.device_prep_slave_sg = xilinx_dma_prep_slave_sg;
+		xdev->common.descriptor_reuse = true;
 		xdev->common.device_prep_dma_cyclic =
 					  xilinx_dma_prep_dma_cyclic;
 		/* Residue calculation is supported by only AXI DMA and CDMA */
@@ -3131,6 +4041,7 @@ static int xilinx_dma_probe(struct platform_device *pdev)
 					  DMA_RESIDUE_GRANULARITY_SEGMENT;
 	} else if (xdev->dma_config->dmatype == XDMA_TYPE_AXIMCDMA) {
 		xdev->common.device_prep_slave_sg = xilinx_mcdma_prep_slave_sg;
+		xdev->common.descriptor_reuse = true;
 	} else {
 		xdev->common.device_prep_interleaved_dma =
 				xilinx_vdma_dma_prep_interleaved;
@@ -0,0 +1,21 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Xilinx DMA engines tracepoints
+ *
+ * Copyright (C) 2023 Xilinx, Inc.
+ */
+
+#include <linux/module.h>
+
+#define CREATE_TRACE_POINTS
+#include "xilinx_dma_trace.h"
+
+EXPORT_TRACEPOINT_SYMBOL_GPL(xilinx_dma_prep);
+EXPORT_TRACEPOINT_SYMBOL_GPL(xilinx_dma_submit);
+EXPORT_TRACEPOINT_SYMBOL_GPL(xilinx_dma_start);
+EXPORT_TRACEPOINT_SYMBOL_GPL(xilinx_dma_complete);
+EXPORT_TRACEPOINT_SYMBOL_GPL(xilinx_dma_irq);
+
+MODULE_AUTHOR("Xilinx, Inc.");
+MODULE_DESCRIPTION("Xilinx DMA engines tracepoints");
+MODULE_LICENSE("GPL");
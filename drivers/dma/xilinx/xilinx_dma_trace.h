@@ -0,0 +1,86 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/*
+ * Xilinx DMA engines tracepoints
+ *
+ * Copyright (C) 2023 Xilinx, Inc.
+ *
+ * The events are shared by the Xilinx DMA engine drivers, so that the
+ * latency of a descriptor can be followed from its preparation to its
+ * completion callback the same way on all of them. Events of the same
+ * descriptor have the same tx pointer, and the same cookie once the
+ * descriptor is submitted.
+ */
+
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM xilinx_dma
+
+#if !defined(_XILINX_DMA_TRACE_H_) || defined(TRACE_HEADER_MULTI_READ)
+#define _XILINX_DMA_TRACE_H_
+
+#include <linux/dmaengine.h>
+#include <linux/tracepoint.h>
+#include <linux/types.h>
+
+DECLARE_EVENT_CLASS(xilinx_dma_tx,
+	TP_PROTO(struct dma_async_tx_descriptor *tx),
+	TP_ARGS(tx),
+	TP_STRUCT__entry(
+		__string(chan, dma_chan_name(tx->chan))
+		__field(const void *, tx)
+		__field(dma_cookie_t, cookie)
+	),
+	TP_fast_assign(
+		__assign_str(chan, dma_chan_name(tx->chan));
+		__entry->tx = tx;
+		__entry->cookie = tx->cookie;
+	),
+	TP_printk("chan=%s tx=%p cookie=%d", __get_str(chan), __entry->tx,
+		  __entry->cookie)
+);
+
+/* The descriptor is prepared */
+DEFINE_EVENT(xilinx_dma_tx, xilinx_dma_prep,
+	TP_PROTO(struct dma_async_tx_descriptor *tx),
+	TP_ARGS(tx)
+);
+
+/* The descriptor is submitted and has a cookie */
+DEFINE_EVENT(xilinx_dma_tx, xilinx_dma_submit,
+	TP_PROTO(struct dma_async_tx_descriptor *tx),
+	TP_ARGS(tx)
+);
+
+/* The descriptor is handed to the hardware */
+DEFINE_EVENT(xilinx_dma_tx, xilinx_dma_start,
+	TP_PROTO(struct dma_async_tx_descriptor *tx),
+	TP_ARGS(tx)
+);
+
+/* The descriptor is complete, its callback runs next */
+DEFINE_EVENT(xilinx_dma_tx, xilinx_dma_complete,
+	TP_PROTO(struct dma_async_tx_descriptor *tx),
+	TP_ARGS(tx)
+);
+
+TRACE_EVENT(xilinx_dma_irq,
+	TP_PROTO(struct dma_chan *chan, u32 status),
+	TP_ARGS(chan, status),
+	TP_STRUCT__entry(
+		__string(chan, dma_chan_name(chan))
+		__field(u32, status)
+	),
+	TP_fast_assign(
+		__assign_str(chan, dma_chan_name(chan));
+		__entry->status = status;
+	),
+	TP_printk("chan=%s status=0x%x", __get_str(chan), __entry->status)
+);
+
+#endif /* _XILINX_DMA_TRACE_H_ */
+
+/* This part must be outside protection */
+#undef TRACE_INCLUDE_PATH
+#undef TRACE_INCLUDE_FILE
+#define TRACE_INCLUDE_PATH .
+#define TRACE_INCLUDE_FILE xilinx_dma_trace
+#include <trace/define_trace.h>
@@ -0,0 +1,189 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Benchmark helpers shared by the Xilinx DMA test clients
+ *
+ * Copyright (C) 2010 Xilinx, Inc. All rights reserved.
+ */
+
+#ifndef __XILINX_DMATEST_BENCH_H
+#define __XILINX_DMATEST_BENCH_H
+
+#include <linux/debugfs.h>
+#include <linux/ktime.h>
+#include <linux/math64.h>
+#include <linux/mutex.h>
+#include <linux/seq_file.h>
+#include <linux/slab.h>
+#include <linux/sort.h>
+
+/**
+ * struct xilinx_dmatest_bench - Benchmark results of a test thread
+ * @lock: Protects the fields below against the debugfs reader
+ * @samples: Ring of completion latencies in nanoseconds
+ * @max_samples: Size of the @samples ring
+ * @nr_samples: Number of valid entries in @samples
+ * @head: Next entry of @samples to be written
+ * @xfers: Number of completed transfers
+ * @bytes: Number of bytes moved by the completed transfers
+ * @start: Time the benchmark started
+ * @runtime: Elapsed time in nanoseconds, updated after every transfer
+ * @done: The test thread has terminated
+ * @dentry: debugfs file exposing the results
+ */
+struct xilinx_dmatest_bench {
+	struct mutex lock;
+	u64 *samples;
+	unsigned int max_samples;
+	unsigned int nr_samples;
+	unsigned int head;
+	u64 xfers;
+	u64 bytes;
+	ktime_t start;
+	u64 runtime;
+	bool done;
+	struct dentry *dentry;
+};
+
+static inline int xilinx_dmatest_bench_init(struct xilinx_dmatest_bench *bench,
+					    unsigned int max_samples)
+{
+	mutex_init(&bench->lock);
+
+	bench->max_samples = max_samples ? : 1;
+	bench->samples = kcalloc(bench->max_samples, sizeof(*bench->samples),
+				 GFP_KERNEL);
+	if (!bench->samples)
+		return -ENOMEM;
+
+	return 0;
+}
+
+static inline void xilinx_dmatest_bench_free(struct xilinx_dmatest_bench *bench)
+{
+	debugfs_remove(bench->dentry);
+	kfree(bench->samples);
+	mutex_destroy(&bench->lock);
+}
+
+static inline void xilinx_dmatest_bench_start(struct xilinx_dmatest_bench *bench)
+{
+	mutex_lock(&bench->lock);
+	bench->start = ktime_get();
+	mutex_unlock(&bench->lock);
+}
+
+/**
+ * xilinx_dmatest_bench_record - Account one completed transfer
+ * @bench: Benchmark results
+ * @len: Number of bytes moved by the transfer
+ * @issued: Time the transfer was issued to the hardware
+ */
+static inline void xilinx_dmatest_bench_record(struct xilinx_dmatest_bench *bench,
+					       u64 len, ktime_t issued)
+{
+	ktime_t now = ktime_get();
+
+	mutex_lock(&bench->lock);
+	bench->samples[bench->head] = ktime_to_ns(ktime_sub(now, issued));
+	bench->head = (bench->head + 1) % bench->max_samples;
+	if (bench->nr_samples < bench->max_samples)
+		bench->nr_samples++;
+	bench->xfers++;
+	bench->bytes += len;
+	bench->runtime = ktime_to_ns(ktime_sub(now, bench->start));
+	mutex_unlock(&bench->lock);
+}
+
+static inline void xilinx_dmatest_bench_done(struct xilinx_dmatest_bench *bench)
+{
+	mutex_lock(&bench->lock);
+	bench->done = true;
+	mutex_unlock(&bench->lock);
+}
+
+static inline int xilinx_dmatest_bench_cmp(const void *a, const void *b)
+{
+	u64 x = *(const u64 *)a, y = *(const u64 *)b;
+
+	return x < y ? -1 : x > y;
+}
+
+static inline u64 xilinx_dmatest_bench_pct(const u64 *sorted, unsigned int nr,
+					   unsigned int permille)
+{
+	return sorted[div_u64((u64)(nr - 1) * permille, 1000)];
+}
+
+static inline int xilinx_dmatest_bench_show(struct seq_file *s, void *unused)
+{
+	struct xilinx_dmatest_bench *bench = s->private;
+	unsigned int nr;
+	u64 *sorted;
+	u64 mbps = 0, xps = 0;
+
+	mutex_lock(&bench->lock);
+
+	nr = bench->nr_samples;
+	sorted = kmemdup(bench->samples, nr * sizeof(*sorted), GFP_KERNEL);
+	if (nr && !sorted) {
+		mutex_unlock(&bench->lock);
+		return -ENOMEM;
+	}
+
+	if (bench->runtime) {
+		/* bytes per microsecond is MB/s */
+		mbps = div64_u64(bench->bytes * NSEC_PER_USEC, bench->runtime);
+		xps = div64_u64(bench->xfers * NSEC_PER_SEC, bench->runtime);
+	}
+
+	seq_printf(s, "state: %s\n", bench->done ? "done" : "running");
+	seq_printf(s, "transfers: %llu\n", bench->xfers);
+	seq_printf(s, "bytes: %llu\n", bench->bytes);
+	seq_printf(s, "runtime_us: %llu\n", div_u64(bench->runtime,
+						    NSEC_PER_USEC));
+	seq_printf(s, "throughput_MBps: %llu\n", mbps);
+	seq_printf(s, "transfers_per_sec: %llu\n", xps);
+
+	mutex_unlock(&bench->lock);
+
+	if (nr) {
+		sort(sorted, nr, sizeof(*sorted), xilinx_dmatest_bench_cmp,
+		     NULL);
+		seq_printf(s, "latency_samples: %u\n", nr);
+		seq_printf(s, "latency_p50_ns: %llu\n",
+			   xilinx_dmatest_bench_pct(sorted, nr, 500));
+		seq_printf(s, "latency_p99_ns: %llu\n",
+			   xilinx_dmatest_bench_pct(sorted, nr, 990));
+		seq_printf(s, "latency_p999_ns: %llu\n",
+			   xilinx_dmatest_bench_pct(sorted, nr, 999));
+		seq_printf(s, "latency_max_ns: %llu\n", sorted[nr - 1]);
+	}
+
+	kfree(sorted);
+
+	return 0;
+}
+
+static inline int xilinx_dmatest_bench_open(struct inode *inode,
+					    struct file *file)
+{
+	return single_open(file, xilinx_dmatest_bench_show, inode->i_private);
+}
+
+static const struct file_operations xilinx_dmatest_bench_fops = {
+	.owner = THIS_MODULE,
+	.open = xilinx_dmatest_bench_open,
+	.read = seq_read,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
+static inline void xilinx_dmatest_bench_add(struct xilinx_dmatest_bench *bench,
+					    struct dentry *dir,
+					    const char *name)
+{
+	bench->dentry = debugfs_create_file(name, 0444, dir, bench,
+					    &xilinx_dmatest_bench_fops);
+}
+
+#endif /* __XILINX_DMATEST_BENCH_H */
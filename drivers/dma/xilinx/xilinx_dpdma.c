@@ -29,6 +29,7 @@
 
 #include "../dmaengine.h"
 #include "../virt-dma.h"
+#include "xilinx_dma_trace.h"
 
 /* DPDMA registers */
 #define XILINX_DPDMA_ERR_CTRL				0x000
@@ -194,12 +195,14 @@ struct xilinx_dpdma_sw_desc {
  * @chan: DMA channel
  * @descriptors: list of software descriptors
  * @error: an error has been detected with this descriptor
+ * @reusable: the descriptor may be recycled by the interleaved fast path
  */
 struct xilinx_dpdma_tx_desc {
 	struct virt_dma_desc vdesc;
 	struct xilinx_dpdma_chan *chan;
 	struct list_head descriptors;
 	bool error;
+	bool reusable;
 };
 
 #define to_dpdma_tx_desc(_desc) \
@@ -220,6 +223,7 @@ struct xilinx_dpdma_tx_desc {
  * @desc: References to descriptors being processed
  * @desc.pending: Descriptor schedule to the hardware, pending execution
  * @desc.active: Descriptor being executed by the hardware
+ * @desc.cache: Last released interleaved descriptor, kept for reuse
  * @xdev: DPDMA device
  */
 struct xilinx_dpdma_chan {
@@ -239,6 +243,7 @@ struct xilinx_dpdma_chan {
 	struct {
 		struct xilinx_dpdma_tx_desc *pending;
 		struct xilinx_dpdma_tx_desc *active;
+		struct xilinx_dpdma_tx_desc *cache;
 	} desc;
 
 	struct xilinx_dpdma_device *xdev;
@@ -541,6 +546,26 @@ static void xilinx_dpdma_sw_desc_set_dma_addrs(struct xilinx_dpdma_device *xdev,
 				   upper_32_bits(sw_desc->dma_addr));
 }
 
+/**
+ * xilinx_dpdma_xt_geometry - Compute the frame geometry of a hw descriptor
+ * @xt: dma interleaved template
+ * @xfer_size: returns the transfer size field
+ * @hsize_stride: returns the horizontal size and stride field
+ */
+static void xilinx_dpdma_xt_geometry(struct dma_interleaved_template *xt,
+				     u32 *xfer_size, u32 *hsize_stride)
+{
+	size_t hsize = xt->sgl[0].size;
+	size_t stride = hsize + xt->sgl[0].icg;
+
+	hsize = ALIGN(hsize, XILINX_DPDMA_LINESIZE_ALIGN_BITS / 8);
+	*xfer_size = hsize * xt->numf;
+	*hsize_stride =
+		FIELD_PREP(XILINX_DPDMA_DESC_HSIZE_STRIDE_HSIZE_MASK, hsize) |
+		FIELD_PREP(XILINX_DPDMA_DESC_HSIZE_STRIDE_STRIDE_MASK,
+			   stride / 16);
+}
+
 /**
  * xilinx_dpdma_chan_alloc_sw_desc - Allocate a software descriptor
  * @chan: DPDMA channel
@@ -645,15 +670,37 @@ xilinx_dpdma_chan_alloc_tx_desc(struct xilinx_dpdma_chan *chan)
 	return tx_desc;
 }
 
+/**
+ * __xilinx_dpdma_chan_free_tx_desc - Free a transaction descriptor
+ * @desc: tx descriptor
+ *
+ * Free the tx descriptor @desc including its software descriptors.
+ */
+static void __xilinx_dpdma_chan_free_tx_desc(struct xilinx_dpdma_tx_desc *desc)
+{
+	struct xilinx_dpdma_sw_desc *sw_desc, *next;
+
+	if (!desc)
+		return;
+
+	list_for_each_entry_safe(sw_desc, next, &desc->descriptors, node) {
+		list_del(&sw_desc->node);
+		xilinx_dpdma_chan_free_sw_desc(desc->chan, sw_desc);
+	}
+
+	kfree(desc);
+}
+
 /**
  * xilinx_dpdma_chan_free_tx_desc - Free a virtual DMA descriptor
  * @vdesc: virtual DMA descriptor
  *
  * Free the virtual DMA descriptor @vdesc including its software descriptors.
+ * A released interleaved descriptor is parked in the channel cache instead,
+ * when the cache is empty, so that the next frame can reuse it.
  */
 static void xilinx_dpdma_chan_free_tx_desc(struct virt_dma_desc *vdesc)
 {
-	struct xilinx_dpdma_sw_desc *sw_desc, *next;
 	struct xilinx_dpdma_tx_desc *desc;
 
 	if (!vdesc)
@@ -661,12 +708,93 @@ static void xilinx_dpdma_chan_free_tx_desc(struct virt_dma_desc *vdesc)
 
 	desc = to_dpdma_tx_desc(vdesc);
 
-	list_for_each_entry_safe(sw_desc, next, &desc->descriptors, node) {
-		list_del(&sw_desc->node);
-		xilinx_dpdma_chan_free_sw_desc(desc->chan, sw_desc);
+	if (desc->reusable && !desc->error &&
+	    !cmpxchg(&desc->chan->desc.cache, NULL, desc))
+		return;
+
+	__xilinx_dpdma_chan_free_tx_desc(desc);
+}
+
+/**
+ * xilinx_dpdma_chan_reuse_tx_desc - Reuse a cached interleaved descriptor
+ * @chan: DPDMA channel
+ * @xt: dma interleaved template
+ *
+ * Take the descriptor from the channel cache and, if its frame geometry
+ * matches @xt, only swap the payload address. This skips the descriptor
+ * allocations and the full hardware descriptor setup on page flips.
+ *
+ * Return: A DPDMA TX descriptor on success, or NULL if nothing can be reused.
+ */
+static struct xilinx_dpdma_tx_desc *
+xilinx_dpdma_chan_reuse_tx_desc(struct xilinx_dpdma_chan *chan,
+				struct dma_interleaved_template *xt)
+{
+	struct xilinx_dpdma_tx_desc *tx_desc;
+	struct xilinx_dpdma_sw_desc *sw_desc;
+	struct xilinx_dpdma_hw_desc *hw_desc;
+	u32 xfer_size, hsize_stride;
+
+	tx_desc = xchg(&chan->desc.cache, NULL);
+	if (!tx_desc)
+		return NULL;
+
+	xilinx_dpdma_xt_geometry(xt, &xfer_size, &hsize_stride);
+
+	sw_desc = list_first_entry(&tx_desc->descriptors,
+				   struct xilinx_dpdma_sw_desc, node);
+	hw_desc = &sw_desc->hw;
+	if (hw_desc->xfer_size != xfer_size ||
+	    hw_desc->hsize_stride != hsize_stride) {
+		__xilinx_dpdma_chan_free_tx_desc(tx_desc);
+		return NULL;
 	}
 
-	kfree(desc);
+	/* The descriptor still points to itself, only replace the payload */
+	hw_desc->addr_ext &= ~XILINX_DPDMA_DESC_ADDR_EXT_SRC_ADDR_MASK;
+	xilinx_dpdma_sw_desc_set_dma_addrs(chan->xdev, sw_desc, NULL,
+					   &xt->src_start, 1);
+
+	memset(&tx_desc->vdesc, 0, sizeof(tx_desc->vdesc));
+
+	return tx_desc;
+}
+
+/**
+ * xilinx_dpdma_tx_submit - Submit a tx descriptor to the virtual channel
+ * @tx: dma async tx descriptor
+ *
+ * Return: The cookie assigned to @tx.
+ */
+static dma_cookie_t xilinx_dpdma_tx_submit(struct dma_async_tx_descriptor *tx)
+{
+	dma_cookie_t cookie = vchan_tx_submit(tx);
+
+	trace_xilinx_dma_submit(tx);
+
+	return cookie;
+}
+
+/**
+ * xilinx_dpdma_chan_tx_prep - Prepare a tx descriptor for the virtual channel
+ * @chan: DPDMA channel
+ * @tx_desc: DPDMA TX descriptor
+ * @flags: tx flags argument passed in to prepare function
+ *
+ * Return: The dma async tx descriptor of @tx_desc.
+ */
+static struct dma_async_tx_descriptor *
+xilinx_dpdma_chan_tx_prep(struct xilinx_dpdma_chan *chan,
+			  struct xilinx_dpdma_tx_desc *tx_desc,
+			  unsigned long flags)
+{
+	struct dma_async_tx_descriptor *tx;
+
+	tx = vchan_tx_prep(&chan->vchan, &tx_desc->vdesc, flags);
+	tx->tx_submit = xilinx_dpdma_tx_submit;
+	trace_xilinx_dma_prep(tx);
+
+	return tx;
 }
 
 /**
@@ -739,7 +867,7 @@ xilinx_dpdma_chan_prep_cyclic(struct xilinx_dpdma_chan *chan,
 
 	last->hw.control |= XILINX_DPDMA_DESC_CONTROL_LAST_OF_FRAME;
 
-	return vchan_tx_prep(&chan->vchan, &tx_desc->vdesc, flags);
+	return xilinx_dpdma_chan_tx_prep(chan, tx_desc, flags);
 
 error:
 	xilinx_dpdma_chan_free_tx_desc(&tx_desc->vdesc);
@@ -765,8 +893,6 @@ xilinx_dpdma_chan_prep_interleaved_dma(struct xilinx_dpdma_chan *chan,
 	struct xilinx_dpdma_tx_desc *tx_desc;
 	struct xilinx_dpdma_sw_desc *sw_desc;
 	struct xilinx_dpdma_hw_desc *hw_desc;
-	size_t hsize = xt->sgl[0].size;
-	size_t stride = hsize + xt->sgl[0].icg;
 
 	if (!IS_ALIGNED(xt->src_start, XILINX_DPDMA_ALIGN_BYTES)) {
 		dev_err(chan->xdev->dev,
@@ -775,6 +901,10 @@ xilinx_dpdma_chan_prep_interleaved_dma(struct xilinx_dpdma_chan *chan,
 		return NULL;
 	}
 
+	tx_desc = xilinx_dpdma_chan_reuse_tx_desc(chan, xt);
+	if (tx_desc)
+		return tx_desc;
+
 	tx_desc = xilinx_dpdma_chan_alloc_tx_desc(chan);
 	if (!tx_desc)
 		return NULL;
@@ -789,18 +919,15 @@ xilinx_dpdma_chan_prep_interleaved_dma(struct xilinx_dpdma_chan *chan,
 					   &xt->src_start, 1);
 
 	hw_desc = &sw_desc->hw;
-	hsize = ALIGN(hsize, XILINX_DPDMA_LINESIZE_ALIGN_BITS / 8);
-	hw_desc->xfer_size = hsize * xt->numf;
-	hw_desc->hsize_stride =
-		FIELD_PREP(XILINX_DPDMA_DESC_HSIZE_STRIDE_HSIZE_MASK, hsize) |
-		FIELD_PREP(XILINX_DPDMA_DESC_HSIZE_STRIDE_STRIDE_MASK,
-			   stride / 16);
+	xilinx_dpdma_xt_geometry(xt, &hw_desc->xfer_size,
+				 &hw_desc->hsize_stride);
 	hw_desc->control |= XILINX_DPDMA_DESC_CONTROL_PREEMBLE;
 	hw_desc->control |= XILINX_DPDMA_DESC_CONTROL_COMPLETE_INTR;
 	hw_desc->control |= XILINX_DPDMA_DESC_CONTROL_IGNORE_DONE;
 	hw_desc->control |= XILINX_DPDMA_DESC_CONTROL_LAST_OF_FRAME;
 
 	list_add_tail(&sw_desc->node, &tx_desc->descriptors);
+	tx_desc->reusable = true;
 
 	return tx_desc;
 }
@@ -946,6 +1073,8 @@ static void xilinx_dpdma_chan_queue_transfer(struct xilinx_dpdma_chan *chan)
 			    FIELD_PREP(XILINX_DPDMA_CH_DESC_START_ADDRE_MASK,
 				       upper_32_bits(sw_desc->dma_addr)));
 
+	trace_xilinx_dma_start(&desc->vdesc.tx);
+
 	first_frame = chan->first_frame;
 	chan->first_frame = false;
 
@@ -1127,12 +1256,14 @@ static void xilinx_dpdma_chan_done_irq(struct xilinx_dpdma_chan *chan)
 	xilinx_dpdma_debugfs_desc_done_irq(chan);
 
 	active = chan->desc.active;
-	if (active)
+	if (active) {
+		trace_xilinx_dma_complete(&active->vdesc.tx);
 		vchan_cyclic_callback(&active->vdesc);
-	else
+	} else {
 		dev_warn(chan->xdev->dev,
 			 "chan%u: DONE IRQ with no active descriptor!\n",
 			 chan->id);
+	}
 
 	spin_unlock_irqrestore(&chan->lock, flags);
 }
@@ -1175,8 +1306,10 @@ static void xilinx_dpdma_chan_vsync_irq(struct  xilinx_dpdma_chan *chan)
 	 * Complete the active descriptor, if any, promote the pending
 	 * descriptor to active, and queue the next transfer, if any.
 	 */
-	if (chan->desc.active)
+	if (chan->desc.active) {
+		trace_xilinx_dma_complete(&chan->desc.active->vdesc.tx);
 		vchan_cookie_complete(&chan->desc.active->vdesc);
+	}
 	chan->desc.active = pending;
 	chan->desc.pending = NULL;
 
@@ -1307,9 +1440,7 @@ xilinx_dpdma_prep_interleaved_dma(struct dma_chan *dchan,
 	if (!desc)
 		return NULL;
 
-	vchan_tx_prep(&chan->vchan, &desc->vdesc, flags | DMA_CTRL_ACK);
-
-	return &desc->vdesc.tx;
+	return xilinx_dpdma_chan_tx_prep(chan, desc, flags | DMA_CTRL_ACK);
 }
 
 /**
@@ -1351,6 +1482,7 @@ static void xilinx_dpdma_free_chan_resources(struct dma_chan *dchan)
 	struct xilinx_dpdma_chan *chan = to_xilinx_chan(dchan);
 
 	vchan_free_chan_resources(&chan->vchan);
+	__xilinx_dpdma_chan_free_tx_desc(xchg(&chan->desc.cache, NULL));
 
 	dma_pool_destroy(chan->desc_pool);
 	chan->desc_pool = NULL;
@@ -1614,6 +1746,16 @@ static irqreturn_t xilinx_dpdma_irq_handler(int irq, void *data)
 	dpdma_write(xdev->reg, XILINX_DPDMA_ISR, status);
 	dpdma_write(xdev->reg, XILINX_DPDMA_EISR, error);
 
+	/* The interrupt is shared by the channels, trace it on the running ones */
+	if (trace_xilinx_dma_irq_enabled()) {
+		for (i = 0; i < ARRAY_SIZE(xdev->chan); i++) {
+			struct xilinx_dpdma_chan *chan = xdev->chan[i];
+
+			if (chan && chan->running)
+				trace_xilinx_dma_irq(&chan->vchan.chan, status);
+		}
+	}
+
 	if (status & XILINX_DPDMA_INTR_VSYNC) {
 		/*
 		 * There's a single VSYNC interrupt that needs to be processed
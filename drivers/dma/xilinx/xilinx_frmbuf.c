@@ -26,6 +26,7 @@
 #include <linux/interrupt.h>
 #include <linux/io.h>
 #include <linux/iopoll.h>
+#include <linux/ktime.h>
 #include <linux/module.h>
 #include <linux/of_address.h>
 #include <linux/of_dma.h>
@@ -37,6 +38,7 @@
 #include <drm/drm_fourcc.h>
 
 #include "../dmaengine.h"
+#include "xilinx_dma_trace.h"
 
 /* Register/Descriptor Offsets */
 #define XILINX_FRMBUF_CTRL_OFFSET		0x00
@@ -148,6 +150,7 @@ struct xilinx_frmbuf_desc_hw {
  * @node: Node in the channel descriptors list
  * @fid: Field ID of buffer
  * @earlycb: Whether the callback should be called when in staged state
+ * @meta: Completion metadata handed out through the metadata ops
  */
 struct xilinx_frmbuf_tx_descriptor {
 	struct dma_async_tx_descriptor async_tx;
@@ -155,6 +158,7 @@ struct xilinx_frmbuf_tx_descriptor {
 	struct list_head node;
 	u32 fid;
 	u32 earlycb;
+	struct xilinx_frmbuf_metadata meta;
 };
 
 /**
@@ -179,6 +183,8 @@ struct xilinx_frmbuf_tx_descriptor {
  * @fid_err_flag: Field id error detection flag
  * @fid_out_val: Field id out val
  * @fid_mode: Select fid mode
+ * @dropped_frames: Frames restarted into a buffer that was already active
+ * @sequence: Number of frame done interrupts since the last reset
  */
 struct xilinx_frmbuf_chan {
 	struct xilinx_frmbuf_device *xdev;
@@ -203,6 +209,8 @@ struct xilinx_frmbuf_chan {
 	u8 fid_err_flag;
 	u8 fid_out_val;
 	enum fid_modes fid_mode;
+	unsigned long dropped_frames;
+	u32 sequence;
 };
 
 /**
@@ -940,6 +948,21 @@ int xilinx_xdma_get_fid_out(struct dma_chan *chan,
 }
 EXPORT_SYMBOL(xilinx_xdma_get_fid_out);
 
+int xilinx_xdma_get_dropped_frames(struct dma_chan *chan,
+				   unsigned long *dropped)
+{
+	struct xilinx_frmbuf_device *xdev;
+
+	xdev = frmbuf_find_dev(chan);
+	if (IS_ERR(xdev))
+		return PTR_ERR(xdev);
+
+	*dropped = READ_ONCE(xdev->chan.dropped_frames);
+
+	return 0;
+}
+EXPORT_SYMBOL(xilinx_xdma_get_dropped_frames);
+
 int xilinx_xdma_get_width_align(struct dma_chan *chan, u32 *width_align)
 {
 	struct xilinx_frmbuf_device *xdev;
@@ -1107,6 +1130,7 @@ static void xilinx_frmbuf_chan_desc_cleanup(struct xilinx_frmbuf_chan *chan)
 		callback = desc->async_tx.callback;
 		callback_param = desc->async_tx.callback_param;
 		if (callback) {
+			trace_xilinx_dma_complete(&desc->async_tx);
 			spin_unlock_irqrestore(&chan->lock, flags);
 			callback(callback_param);
 			spin_lock_irqsave(&chan->lock, flags);
@@ -1185,10 +1209,12 @@ static void xilinx_frmbuf_start(struct xilinx_frmbuf_chan *chan)
  * xilinx_frmbuf_complete_descriptor - Mark the active descriptor as complete
  * This function is invoked with spinlock held
  * @chan : xilinx frmbuf channel
+ * @timestamp: Time the frame done interrupt was taken, in ns
  *
  * CONTEXT: hardirq
  */
-static void xilinx_frmbuf_complete_descriptor(struct xilinx_frmbuf_chan *chan)
+static void xilinx_frmbuf_complete_descriptor(struct xilinx_frmbuf_chan *chan,
+					      u64 timestamp)
 {
 	struct xilinx_frmbuf_tx_descriptor *desc = chan->active_desc;
 
@@ -1200,6 +1226,10 @@ static void xilinx_frmbuf_complete_descriptor(struct xilinx_frmbuf_chan *chan)
 		desc->fid = frmbuf_read(chan, XILINX_FRMBUF_FID_OFFSET) &
 			    XILINX_FRMBUF_FID_MASK;
 
+	desc->meta.timestamp = timestamp;
+	desc->meta.sequence = chan->sequence;
+	desc->meta.fid = desc->fid;
+
 	dma_cookie_complete(&desc->async_tx);
 	list_add_tail(&desc->node, &chan->done_list);
 }
@@ -1237,6 +1267,7 @@ static void xilinx_frmbuf_start_transfer(struct xilinx_frmbuf_chan *chan)
 		callback = desc->async_tx.callback;
 		callback_param = desc->async_tx.callback_param;
 		if (callback) {
+			trace_xilinx_dma_complete(&desc->async_tx);
 			callback(callback_param);
 			desc->async_tx.callback = NULL;
 			chan->active_desc = desc;
@@ -1269,6 +1300,7 @@ static void xilinx_frmbuf_start_transfer(struct xilinx_frmbuf_chan *chan)
 
 	/* Start the hardware */
 	xilinx_frmbuf_start(chan);
+	trace_xilinx_dma_start(&desc->async_tx);
 	list_del(&desc->node);
 
 	/* No staging descriptor required when auto restart is disabled */
@@ -1315,6 +1347,7 @@ static void xilinx_frmbuf_chan_reset(struct xilinx_frmbuf_chan *chan)
 	frmbuf_write(chan, XILINX_FRMBUF_GIE_OFFSET, XILINX_FRMBUF_GIE_EN);
 	chan->fid_err_flag = 0;
 	chan->fid_out_val = 0;
+	chan->sequence = 0;
 }
 
 /**
@@ -1336,6 +1369,8 @@ static irqreturn_t xilinx_frmbuf_irq_handler(int irq, void *data)
 	if (!(status & XILINX_FRMBUF_ISR_ALL_IRQ_MASK))
 		return IRQ_NONE;
 
+	trace_xilinx_dma_irq(&chan->common, status);
+
 	frmbuf_write(chan, XILINX_FRMBUF_ISR_OFFSET,
 		     status & XILINX_FRMBUF_ISR_ALL_IRQ_MASK);
 
@@ -1345,17 +1380,32 @@ static irqreturn_t xilinx_frmbuf_irq_handler(int irq, void *data)
 		callback = desc->async_tx.callback;
 		callback_param = desc->async_tx.callback_param;
 		if (callback) {
+			trace_xilinx_dma_complete(&desc->async_tx);
 			callback(callback_param);
 			desc->async_tx.callback = NULL;
 		}
 	}
 
 	if (status & XILINX_FRMBUF_ISR_AP_DONE_IRQ) {
+		u64 timestamp = ktime_get_ns();
+
 		spin_lock(&chan->lock);
 		chan->idle = true;
+		chan->sequence++;
 		if (chan->active_desc) {
-			xilinx_frmbuf_complete_descriptor(chan);
-			chan->active_desc = NULL;
+			/*
+			 * With nothing staged, the auto restarted frame reuses
+			 * the address of the active buffer. Keep that buffer
+			 * rather than handing back memory the IP is still
+			 * accessing, and account the frame as dropped.
+			 */
+			if (chan->mode == AUTO_RESTART && !chan->staged_desc) {
+				chan->dropped_frames++;
+			} else {
+				xilinx_frmbuf_complete_descriptor(chan,
+								  timestamp);
+				chan->active_desc = NULL;
+			}
 		}
 
 		/* Update fid err detect flag and out value */
@@ -1390,6 +1440,33 @@ static irqreturn_t xilinx_frmbuf_irq_handler(int irq, void *data)
 	return IRQ_HANDLED;
 }
 
+/**
+ * xilinx_frmbuf_metadata_get_ptr - Get the completion metadata of a descriptor
+ * @tx: Async transaction descriptor
+ * @payload_len: Output param - Length of the valid metadata
+ * @max_len: Output param - Size of the metadata area
+ *
+ * The metadata is filled in when the frame completes and stays valid until
+ * the descriptor callback returns.
+ *
+ * Return: Pointer to the struct xilinx_frmbuf_metadata of the descriptor
+ */
+static void *xilinx_frmbuf_metadata_get_ptr(struct dma_async_tx_descriptor *tx,
+					    size_t *payload_len,
+					    size_t *max_len)
+{
+	struct xilinx_frmbuf_tx_descriptor *desc = to_dma_tx_descriptor(tx);
+
+	*payload_len = sizeof(desc->meta);
+	*max_len = sizeof(desc->meta);
+
+	return &desc->meta;
+}
+
+static struct dma_descriptor_metadata_ops xilinx_frmbuf_metadata_ops = {
+	.get_ptr = xilinx_frmbuf_metadata_get_ptr,
+};
+
 /**
  * xilinx_frmbuf_tx_submit - Submit DMA transaction
  * @tx: Async transaction descriptor
@@ -1405,6 +1482,7 @@ static dma_cookie_t xilinx_frmbuf_tx_submit(struct dma_async_tx_descriptor *tx)
 
 	spin_lock_irqsave(&chan->lock, flags);
 	cookie = dma_cookie_assign(tx);
+	trace_xilinx_dma_submit(tx);
 	list_add_tail(&desc->node, &chan->pending_list);
 	spin_unlock_irqrestore(&chan->lock, flags);
 
@@ -1461,6 +1539,7 @@ xilinx_frmbuf_dma_prep_interleaved(struct dma_chan *dchan,
 
 	dma_async_tx_descriptor_init(&desc->async_tx, &chan->common);
 	desc->async_tx.tx_submit = xilinx_frmbuf_tx_submit;
+	desc->async_tx.metadata_ops = &xilinx_frmbuf_metadata_ops;
 	async_tx_ack(&desc->async_tx);
 
 	hw = &desc->hw;
@@ -1499,6 +1578,7 @@ xilinx_frmbuf_dma_prep_interleaved(struct dma_chan *dchan,
 				xt->sgl[0].dst_icg;
 	}
 
+	trace_xilinx_dma_prep(&desc->async_tx);
 	return &desc->async_tx;
 
 error:
@@ -1783,6 +1863,7 @@ static int xilinx_frmbuf_probe(struct platform_device *pdev)
 	INIT_LIST_HEAD(&xdev->common.channels);
 	dma_cap_set(DMA_SLAVE, xdev->common.cap_mask);
 	dma_cap_set(DMA_PRIVATE, xdev->common.cap_mask);
+	xdev->common.desc_metadata_modes = DESC_METADATA_ENGINE;
 
 	/* Initialize the channels */
 	err = xilinx_frmbuf_chan_probe(xdev, node);
@@ -1886,10 +1967,26 @@ static int xilinx_frmbuf_remove(struct platform_device *pdev)
 
 MODULE_DEVICE_TABLE(of, xilinx_frmbuf_of_ids);
 
+static ssize_t dropped_frames_show(struct device *dev,
+				   struct device_attribute *attr, char *buf)
+{
+	struct xilinx_frmbuf_device *xdev = dev_get_drvdata(dev);
+
+	return sysfs_emit(buf, "%lu\n", READ_ONCE(xdev->chan.dropped_frames));
+}
+static DEVICE_ATTR_RO(dropped_frames);
+
+static struct attribute *xilinx_frmbuf_attrs[] = {
+	&dev_attr_dropped_frames.attr,
+	NULL,
+};
+ATTRIBUTE_GROUPS(xilinx_frmbuf);
+
 static struct platform_driver xilinx_frmbuf_driver = {
 	.driver = {
 		.name = "xilinx-frmbuf",
 		.of_match_table = xilinx_frmbuf_of_ids,
+		.dev_groups = xilinx_frmbuf_groups,
 	},
 	.probe = xilinx_frmbuf_probe,
 	.remove = xilinx_frmbuf_remove,
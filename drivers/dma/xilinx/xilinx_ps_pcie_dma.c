@@ -0,0 +1,811 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Xilinx ZynqMP PS PCIe bridge DMA driver
+ *
+ * Copyright (C) 2023 Xilinx, Inc.
+ *
+ * The NWL PCIe bridge of the ZynqMP PS integrates four DMA channels.
+ * Each channel moves data between a source and a destination element
+ * queue, either side of an element addressing AXI memory or the PCIe
+ * address space, and reports completions through a status queue per
+ * side. The channels are exposed as memcpy channels for AXI to AXI
+ * copies and as slave channels for transfers to or from a PCIe window
+ * given through dma_slave_config.
+ */
+
+#include <linux/bitfield.h>
+#include <linux/bits.h>
+#include <linux/clk.h>
+#include <linux/delay.h>
+#include <linux/dma-mapping.h>
+#include <linux/dmaengine.h>
+#include <linux/interrupt.h>
+#include <linux/io.h>
+#include <linux/iopoll.h>
+#include <linux/module.h>
+#include <linux/of.h>
+#include <linux/of_dma.h>
+#include <linux/platform_device.h>
+#include <linux/slab.h>
+
+#include "../dmaengine.h"
+#include "../virt-dma.h"
+
+/* Channel register offsets */
+#define PS_PCIE_DMA_SRC_Q_PTR_LO	0x00
+#define PS_PCIE_DMA_SRC_Q_PTR_HI	0x04
+#define PS_PCIE_DMA_SRC_Q_SIZE		0x08
+#define PS_PCIE_DMA_SRC_Q_LIMIT		0x0C
+#define PS_PCIE_DMA_DST_Q_PTR_LO	0x10
+#define PS_PCIE_DMA_DST_Q_PTR_HI	0x14
+#define PS_PCIE_DMA_DST_Q_SIZE		0x18
+#define PS_PCIE_DMA_DST_Q_LIMIT		0x1C
+#define PS_PCIE_DMA_STAS_Q_PTR_LO	0x20
+#define PS_PCIE_DMA_STAS_Q_PTR_HI	0x24
+#define PS_PCIE_DMA_STAS_Q_SIZE		0x28
+#define PS_PCIE_DMA_STAS_Q_LIMIT	0x2C
+#define PS_PCIE_DMA_STAD_Q_PTR_LO	0x30
+#define PS_PCIE_DMA_STAD_Q_PTR_HI	0x34
+#define PS_PCIE_DMA_STAD_Q_SIZE		0x38
+#define PS_PCIE_DMA_STAD_Q_LIMIT	0x3C
+#define PS_PCIE_DMA_SRC_Q_NEXT		0x40
+#define PS_PCIE_DMA_DST_Q_NEXT		0x44
+#define PS_PCIE_DMA_STAS_Q_NEXT		0x48
+#define PS_PCIE_DMA_STAD_Q_NEXT		0x4C
+#define PS_PCIE_DMA_AXI_INTR_CNTRL	0x68
+#define PS_PCIE_DMA_AXI_INTR_STATUS	0x6C
+#define PS_PCIE_DMA_CNTRL		0x78
+#define PS_PCIE_DMA_STATUS		0x7C
+
+/* Queue pointer low register */
+#define PS_PCIE_DMA_Q_LOC_AXI		BIT(0)
+#define PS_PCIE_DMA_Q_ENABLE		BIT(1)
+
+/* Interrupt control and status registers */
+#define PS_PCIE_DMA_INTR_ENABLE		BIT(0)
+#define PS_PCIE_DMA_INTR_ERR_ENABLE	BIT(1)
+#define PS_PCIE_DMA_INTR_SGL_ENABLE	BIT(3)
+#define PS_PCIE_DMA_INTR_ERR		BIT(1)
+#define PS_PCIE_DMA_INTR_SGL		BIT(2)
+#define PS_PCIE_DMA_INTR_SW		BIT(3)
+#define PS_PCIE_DMA_INTR_ALL		(PS_PCIE_DMA_INTR_ERR | \
+					 PS_PCIE_DMA_INTR_SGL | \
+					 PS_PCIE_DMA_INTR_SW)
+
+/* Channel control and status registers */
+#define PS_PCIE_DMA_CNTRL_ENABLE	BIT(0)
+#define PS_PCIE_DMA_CNTRL_RST		BIT(1)
+#define PS_PCIE_DMA_CNTRL_64BIT_STAQ	BIT(2)
+#define PS_PCIE_DMA_STATUS_RUNNING	BIT(0)
+
+/* Source and destination element control word */
+#define PS_PCIE_DMA_ELEM_BYTE_COUNT	GENMASK(23, 0)
+#define PS_PCIE_DMA_ELEM_LOC_AXI	BIT(24)
+#define PS_PCIE_DMA_ELEM_EOP		BIT(25)
+#define PS_PCIE_DMA_ELEM_INTR		BIT(26)
+
+/* Status element status word */
+#define PS_PCIE_DMA_STA_COMPLETED	BIT(0)
+#define PS_PCIE_DMA_STA_SRC_ERR		BIT(1)
+#define PS_PCIE_DMA_STA_DST_ERR		BIT(2)
+#define PS_PCIE_DMA_STA_INTERNAL_ERR	BIT(3)
+#define PS_PCIE_DMA_STA_ERR		(PS_PCIE_DMA_STA_SRC_ERR | \
+					 PS_PCIE_DMA_STA_DST_ERR | \
+					 PS_PCIE_DMA_STA_INTERNAL_ERR)
+
+#define PS_PCIE_DMA_CHAN_OFFSET		0x80
+#define PS_PCIE_DMA_MAX_CHANS		4
+#define PS_PCIE_DMA_RING_SIZE		256
+#define PS_PCIE_DMA_MAX_SEG_LEN		SZ_8M
+#define PS_PCIE_DMA_RESET_TIMEOUT_US	1000
+
+/**
+ * struct ps_pcie_dma_elem - Source or destination queue element
+ * @addr: Buffer address
+ * @ctrl: Byte count and control flags
+ * @handle: Software handle echoed in the status element
+ * @user_id: Software id echoed in the status element
+ */
+struct ps_pcie_dma_elem {
+	__le64 addr;
+	__le32 ctrl;
+	__le16 handle;
+	__le16 user_id;
+} __packed;
+
+/**
+ * struct ps_pcie_dma_sta - Status queue element
+ * @status: Completion, error flags and completed byte count
+ * @handle: Handle of the element this status belongs to
+ * @user_id: User id of the element this status belongs to
+ */
+struct ps_pcie_dma_sta {
+	__le32 status;
+	__le16 handle;
+	__le16 user_id;
+} __packed;
+
+/**
+ * struct ps_pcie_dma_seg - One contiguous copy of a transfer
+ * @src: Source address
+ * @dst: Destination address
+ * @len: Length in bytes
+ */
+struct ps_pcie_dma_seg {
+	dma_addr_t src;
+	dma_addr_t dst;
+	u32 len;
+};
+
+/**
+ * struct ps_pcie_dma_desc - Transfer descriptor
+ * @vdesc: Virtual DMA descriptor
+ * @src_axi: Source addresses are AXI addresses
+ * @dst_axi: Destination addresses are AXI addresses
+ * @num_segs: Number of segments in @segs
+ * @done: Segments completed so far
+ * @error: A segment completed with an error
+ * @segs: Transfer segments
+ */
+struct ps_pcie_dma_desc {
+	struct virt_dma_desc vdesc;
+	bool src_axi;
+	bool dst_axi;
+	unsigned int num_segs;
+	unsigned int done;
+	bool error;
+	struct ps_pcie_dma_seg segs[];
+};
+
+/**
+ * struct ps_pcie_dma_ring - Element or status queue
+ * @cpu_addr: CPU address of the queue
+ * @dma_addr: DMA address of the queue
+ * @head: Next element the driver fills or consumes
+ */
+struct ps_pcie_dma_ring {
+	void *cpu_addr;
+	dma_addr_t dma_addr;
+	unsigned int head;
+};
+
+/**
+ * struct ps_pcie_dma_chan - Driver specific DMA channel structure
+ * @vchan: Virtual DMA channel
+ * @xdev: Driver specific device structure
+ * @regs: Channel register base
+ * @id: Channel index
+ * @src: Source element queue
+ * @dst: Destination element queue
+ * @stas: Source status queue
+ * @stad: Destination status queue
+ * @active: Descriptor being transferred
+ * @config: Slave configuration, its addresses are PCIe addresses
+ */
+struct ps_pcie_dma_chan {
+	struct virt_dma_chan vchan;
+	struct ps_pcie_dma_device *xdev;
+	void __iomem *regs;
+	unsigned int id;
+	struct ps_pcie_dma_ring src;
+	struct ps_pcie_dma_ring dst;
+	struct ps_pcie_dma_ring stas;
+	struct ps_pcie_dma_ring stad;
+	struct ps_pcie_dma_desc *active;
+	struct dma_slave_config config;
+};
+
+/**
+ * struct ps_pcie_dma_device - DMA device structure
+ * @common: DMA device structure
+ * @dev: Device structure
+ * @regs: Register base of the first channel
+ * @clk: Bus clock
+ * @irq: Interrupt shared by all channels
+ * @num_chans: Number of channels
+ * @chan: Driver specific DMA channel structures
+ */
+struct ps_pcie_dma_device {
+	struct dma_device common;
+	struct device *dev;
+	void __iomem *regs;
+	struct clk *clk;
+	int irq;
+	unsigned int num_chans;
+	struct ps_pcie_dma_chan chan[PS_PCIE_DMA_MAX_CHANS];
+};
+
+#define to_chan(c)	container_of(c, struct ps_pcie_dma_chan, vchan.chan)
+#define to_desc(d)	container_of(d, struct ps_pcie_dma_desc, vdesc)
+
+static inline u32 ps_pcie_dma_read(struct ps_pcie_dma_chan *chan, u32 reg)
+{
+	return readl(chan->regs + reg);
+}
+
+static inline void ps_pcie_dma_write(struct ps_pcie_dma_chan *chan, u32 reg,
+				     u32 val)
+{
+	writel(val, chan->regs + reg);
+}
+
+static void ps_pcie_dma_write_q(struct ps_pcie_dma_chan *chan, u32 reg,
+				struct ps_pcie_dma_ring *ring)
+{
+	/* Queues are 64 byte aligned, the low bits carry the queue flags */
+	ps_pcie_dma_write(chan, reg + 4, upper_32_bits(ring->dma_addr));
+	ps_pcie_dma_write(chan, reg, lower_32_bits(ring->dma_addr) |
+			  PS_PCIE_DMA_Q_LOC_AXI | PS_PCIE_DMA_Q_ENABLE);
+	ps_pcie_dma_write(chan, reg + 8, PS_PCIE_DMA_RING_SIZE);
+}
+
+static int ps_pcie_dma_reset(struct ps_pcie_dma_chan *chan)
+{
+	u32 val;
+	int ret;
+
+	ps_pcie_dma_write(chan, PS_PCIE_DMA_CNTRL, 0);
+	ret = readl_poll_timeout_atomic(chan->regs + PS_PCIE_DMA_STATUS, val,
+					!(val & PS_PCIE_DMA_STATUS_RUNNING), 1,
+					PS_PCIE_DMA_RESET_TIMEOUT_US);
+	if (ret)
+		dev_warn(chan->xdev->dev, "chan%u: failed to stop\n", chan->id);
+
+	ps_pcie_dma_write(chan, PS_PCIE_DMA_CNTRL, PS_PCIE_DMA_CNTRL_RST);
+	ps_pcie_dma_write(chan, PS_PCIE_DMA_CNTRL, 0);
+
+	return ret;
+}
+
+/**
+ * ps_pcie_dma_hw_init - Program the queues and enable the channel
+ * @chan: Driver specific DMA channel
+ *
+ * Must be called with the channel stopped. Element and status queues
+ * are cleared, the status queue limits hand every status slot but one
+ * to the hardware.
+ */
+static void ps_pcie_dma_hw_init(struct ps_pcie_dma_chan *chan)
+{
+	size_t elems = PS_PCIE_DMA_RING_SIZE * sizeof(struct ps_pcie_dma_elem);
+	size_t stas = PS_PCIE_DMA_RING_SIZE * sizeof(struct ps_pcie_dma_sta);
+
+	memset(chan->src.cpu_addr, 0, elems);
+	memset(chan->dst.cpu_addr, 0, elems);
+	memset(chan->stas.cpu_addr, 0, stas);
+	memset(chan->stad.cpu_addr, 0, stas);
+	chan->src.head = 0;
+	chan->dst.head = 0;
+	chan->stas.head = 0;
+	chan->stad.head = 0;
+
+	ps_pcie_dma_write_q(chan, PS_PCIE_DMA_SRC_Q_PTR_LO, &chan->src);
+	ps_pcie_dma_write_q(chan, PS_PCIE_DMA_DST_Q_PTR_LO, &chan->dst);
+	ps_pcie_dma_write_q(chan, PS_PCIE_DMA_STAS_Q_PTR_LO, &chan->stas);
+	ps_pcie_dma_write_q(chan, PS_PCIE_DMA_STAD_Q_PTR_LO, &chan->stad);
+
+	ps_pcie_dma_write(chan, PS_PCIE_DMA_SRC_Q_LIMIT, 0);
+	ps_pcie_dma_write(chan, PS_PCIE_DMA_DST_Q_LIMIT, 0);
+	ps_pcie_dma_write(chan, PS_PCIE_DMA_STAS_Q_LIMIT,
+			  PS_PCIE_DMA_RING_SIZE - 1);
+	ps_pcie_dma_write(chan, PS_PCIE_DMA_STAD_Q_LIMIT,
+			  PS_PCIE_DMA_RING_SIZE - 1);
+
+	ps_pcie_dma_write(chan, PS_PCIE_DMA_AXI_INTR_STATUS,
+			  PS_PCIE_DMA_INTR_ALL);
+	ps_pcie_dma_write(chan, PS_PCIE_DMA_AXI_INTR_CNTRL,
+			  PS_PCIE_DMA_INTR_ENABLE | PS_PCIE_DMA_INTR_ERR_ENABLE |
+			  PS_PCIE_DMA_INTR_SGL_ENABLE);
+	ps_pcie_dma_write(chan, PS_PCIE_DMA_CNTRL,
+			  PS_PCIE_DMA_CNTRL_ENABLE |
+			  PS_PCIE_DMA_CNTRL_64BIT_STAQ);
+}
+
+static void ps_pcie_dma_fill_elem(struct ps_pcie_dma_ring *ring,
+				  dma_addr_t addr, u32 len, bool axi,
+				  bool last)
+{
+	struct ps_pcie_dma_elem *elem = ring->cpu_addr;
+	u32 ctrl;
+
+	elem += ring->head;
+	ctrl = FIELD_PREP(PS_PCIE_DMA_ELEM_BYTE_COUNT, len) |
+	       PS_PCIE_DMA_ELEM_EOP;
+	if (axi)
+		ctrl |= PS_PCIE_DMA_ELEM_LOC_AXI;
+	if (last)
+		ctrl |= PS_PCIE_DMA_ELEM_INTR;
+
+	elem->addr = cpu_to_le64(addr);
+	elem->handle = cpu_to_le16(ring->head);
+	elem->user_id = 0;
+	elem->ctrl = cpu_to_le32(ctrl);
+
+	ring->head = (ring->head + 1) % PS_PCIE_DMA_RING_SIZE;
+}
+
+/**
+ * ps_pcie_dma_start - Queue the next descriptor to the hardware
+ * @chan: Driver specific DMA channel
+ *
+ * Called with the vchan lock held. A descriptor never exceeds the
+ * queues, so only one is handed to the hardware at a time.
+ */
+static void ps_pcie_dma_start(struct ps_pcie_dma_chan *chan)
+{
+	struct virt_dma_desc *vdesc;
+	struct ps_pcie_dma_desc *desc;
+	unsigned int i;
+
+	if (chan->active)
+		return;
+
+	vdesc = vchan_next_desc(&chan->vchan);
+	if (!vdesc)
+		return;
+
+	list_del(&vdesc->node);
+	desc = to_desc(vdesc);
+	chan->active = desc;
+
+	for (i = 0; i < desc->num_segs; i++) {
+		struct ps_pcie_dma_seg *seg = &desc->segs[i];
+		bool last = i == desc->num_segs - 1;
+
+		ps_pcie_dma_fill_elem(&chan->src, seg->src, seg->len,
+				      desc->src_axi, last);
+		ps_pcie_dma_fill_elem(&chan->dst, seg->dst, seg->len,
+				      desc->dst_axi, last);
+	}
+
+	/* Make the elements visible before moving the queue limits */
+	dma_wmb();
+	ps_pcie_dma_write(chan, PS_PCIE_DMA_SRC_Q_LIMIT, chan->src.head);
+	ps_pcie_dma_write(chan, PS_PCIE_DMA_DST_Q_LIMIT, chan->dst.head);
+}
+
+/*
+ * Consume the completed entries of a status queue and give the slots back
+ * to the hardware. Returns the number of entries consumed.
+ */
+static unsigned int ps_pcie_dma_reap(struct ps_pcie_dma_chan *chan,
+				     struct ps_pcie_dma_ring *ring,
+				     u32 limit_reg, bool *error)
+{
+	struct ps_pcie_dma_sta *sta = ring->cpu_addr;
+	unsigned int count = 0;
+	u32 status;
+
+	for (;;) {
+		status = le32_to_cpu(READ_ONCE(sta[ring->head].status));
+		if (!(status & PS_PCIE_DMA_STA_COMPLETED))
+			break;
+
+		dma_rmb();
+		if (status & PS_PCIE_DMA_STA_ERR) {
+			dev_err(chan->xdev->dev,
+				"chan%u: element %u status %#x\n", chan->id,
+				le16_to_cpu(sta[ring->head].handle), status);
+			*error = true;
+		}
+
+		sta[ring->head].status = 0;
+		ring->head = (ring->head + 1) % PS_PCIE_DMA_RING_SIZE;
+		count++;
+	}
+
+	if (count)
+		ps_pcie_dma_write(chan, limit_reg,
+				  (ring->head + PS_PCIE_DMA_RING_SIZE - 1) %
+				  PS_PCIE_DMA_RING_SIZE);
+
+	return count;
+}
+
+static void ps_pcie_dma_chan_irq(struct ps_pcie_dma_chan *chan)
+{
+	struct ps_pcie_dma_desc *desc;
+	bool error = false;
+	unsigned int done;
+	u32 status;
+
+	status = ps_pcie_dma_read(chan, PS_PCIE_DMA_AXI_INTR_STATUS);
+	if (!(status & PS_PCIE_DMA_INTR_ALL))
+		return;
+	ps_pcie_dma_write(chan, PS_PCIE_DMA_AXI_INTR_STATUS, status);
+
+	spin_lock(&chan->vchan.lock);
+
+	ps_pcie_dma_reap(chan, &chan->stas, PS_PCIE_DMA_STAS_Q_LIMIT, &error);
+	done = ps_pcie_dma_reap(chan, &chan->stad, PS_PCIE_DMA_STAD_Q_LIMIT,
+				&error);
+
+	desc = chan->active;
+	if (!desc)
+		goto out;
+
+	desc->done += done;
+	if (error || status & PS_PCIE_DMA_INTR_ERR)
+		desc->error = true;
+
+	if (desc->error) {
+		/* The queues can't be trusted past an error, start over */
+		ps_pcie_dma_reset(chan);
+		ps_pcie_dma_hw_init(chan);
+		desc->vdesc.tx_result.result = DMA_TRANS_ABORTED;
+	} else if (desc->done < desc->num_segs) {
+		goto out;
+	}
+
+	chan->active = NULL;
+	vchan_cookie_complete(&desc->vdesc);
+	ps_pcie_dma_start(chan);
+out:
+	spin_unlock(&chan->vchan.lock);
+}
+
+static irqreturn_t ps_pcie_dma_irq_handler(int irq, void *data)
+{
+	struct ps_pcie_dma_device *xdev = data;
+	unsigned int i;
+
+	for (i = 0; i < xdev->num_chans; i++)
+		ps_pcie_dma_chan_irq(&xdev->chan[i]);
+
+	return IRQ_HANDLED;
+}
+
+static struct ps_pcie_dma_desc *
+ps_pcie_dma_alloc_desc(unsigned int num_segs, bool src_axi, bool dst_axi)
+{
+	struct ps_pcie_dma_desc *desc;
+
+	if (!num_segs || num_segs > PS_PCIE_DMA_RING_SIZE - 1)
+		return NULL;
+
+	desc = kzalloc(struct_size(desc, segs, num_segs), GFP_NOWAIT);
+	if (!desc)
+		return NULL;
+
+	desc->num_segs = num_segs;
+	desc->src_axi = src_axi;
+	desc->dst_axi = dst_axi;
+
+	return desc;
+}
+
+static void ps_pcie_dma_desc_free(struct virt_dma_desc *vdesc)
+{
+	kfree(to_desc(vdesc));
+}
+
+static struct dma_async_tx_descriptor *
+ps_pcie_dma_prep_memcpy(struct dma_chan *dchan, dma_addr_t dst,
+			dma_addr_t src, size_t len, unsigned long flags)
+{
+	struct ps_pcie_dma_chan *chan = to_chan(dchan);
+	struct ps_pcie_dma_desc *desc;
+	unsigned int i;
+	size_t copy;
+
+	desc = ps_pcie_dma_alloc_desc(DIV_ROUND_UP(len,
+						   PS_PCIE_DMA_MAX_SEG_LEN),
+				      true, true);
+	if (!desc)
+		return NULL;
+
+	for (i = 0; i < desc->num_segs; i++) {
+		copy = min_t(size_t, len, PS_PCIE_DMA_MAX_SEG_LEN);
+		desc->segs[i].src = src;
+		desc->segs[i].dst = dst;
+		desc->segs[i].len = copy;
+		src += copy;
+		dst += copy;
+		len -= copy;
+	}
+
+	return vchan_tx_prep(&chan->vchan, &desc->vdesc, flags);
+}
+
+static struct dma_async_tx_descriptor *
+ps_pcie_dma_prep_slave_sg(struct dma_chan *dchan, struct scatterlist *sgl,
+			  unsigned int sg_len,
+			  enum dma_transfer_direction direction,
+			  unsigned long flags, void *context)
+{
+	struct ps_pcie_dma_chan *chan = to_chan(dchan);
+	struct ps_pcie_dma_desc *desc;
+	struct scatterlist *sg;
+	unsigned int num_segs = 0, i, n = 0;
+	dma_addr_t pcie_addr, mem_addr;
+	size_t len, copy;
+
+	if (direction == DMA_MEM_TO_DEV)
+		pcie_addr = chan->config.dst_addr;
+	else if (direction == DMA_DEV_TO_MEM)
+		pcie_addr = chan->config.src_addr;
+	else
+		return NULL;
+
+	for_each_sg(sgl, sg, sg_len, i)
+		num_segs += DIV_ROUND_UP(sg_dma_len(sg),
+					 PS_PCIE_DMA_MAX_SEG_LEN);
+
+	desc = ps_pcie_dma_alloc_desc(num_segs, direction == DMA_MEM_TO_DEV,
+				      direction == DMA_DEV_TO_MEM);
+	if (!desc)
+		return NULL;
+
+	/* The PCIe side is a window, it advances along the scatterlist */
+	for_each_sg(sgl, sg, sg_len, i) {
+		mem_addr = sg_dma_address(sg);
+		len = sg_dma_len(sg);
+
+		while (len) {
+			struct ps_pcie_dma_seg *seg = &desc->segs[n++];
+
+			copy = min_t(size_t, len, PS_PCIE_DMA_MAX_SEG_LEN);
+			seg->src = direction == DMA_MEM_TO_DEV ? mem_addr :
+								 pcie_addr;
+			seg->dst = direction == DMA_MEM_TO_DEV ? pcie_addr :
+								 mem_addr;
+			seg->len = copy;
+			mem_addr += copy;
+			pcie_addr += copy;
+			len -= copy;
+		}
+	}
+
+	return vchan_tx_prep(&chan->vchan, &desc->vdesc, flags);
+}
+
+static int ps_pcie_dma_slave_config(struct dma_chan *dchan,
+				    struct dma_slave_config *config)
+{
+	struct ps_pcie_dma_chan *chan = to_chan(dchan);
+
+	chan->config = *config;
+
+	return 0;
+}
+
+static void ps_pcie_dma_issue_pending(struct dma_chan *dchan)
+{
+	struct ps_pcie_dma_chan *chan = to_chan(dchan);
+	unsigned long flags;
+
+	spin_lock_irqsave(&chan->vchan.lock, flags);
+	if (vchan_issue_pending(&chan->vchan))
+		ps_pcie_dma_start(chan);
+	spin_unlock_irqrestore(&chan->vchan.lock, flags);
+}
+
+static int ps_pcie_dma_terminate_all(struct dma_chan *dchan)
+{
+	struct ps_pcie_dma_chan *chan = to_chan(dchan);
+	unsigned long flags;
+	LIST_HEAD(descriptors);
+
+	spin_lock_irqsave(&chan->vchan.lock, flags);
+	ps_pcie_dma_reset(chan);
+	if (chan->active) {
+		vchan_terminate_vdesc(&chan->active->vdesc);
+		chan->active = NULL;
+	}
+	vchan_get_all_descriptors(&chan->vchan, &descriptors);
+	ps_pcie_dma_hw_init(chan);
+	spin_unlock_irqrestore(&chan->vchan.lock, flags);
+
+	vchan_dma_desc_free_list(&chan->vchan, &descriptors);
+
+	return 0;
+}
+
+static void ps_pcie_dma_synchronize(struct dma_chan *dchan)
+{
+	struct ps_pcie_dma_chan *chan = to_chan(dchan);
+
+	vchan_synchronize(&chan->vchan);
+}
+
+static int ps_pcie_dma_alloc_ring(struct ps_pcie_dma_chan *chan,
+				  struct ps_pcie_dma_ring *ring, size_t size)
+{
+	ring->cpu_addr = dma_alloc_coherent(chan->xdev->dev,
+					    PS_PCIE_DMA_RING_SIZE * size,
+					    &ring->dma_addr, GFP_KERNEL);
+
+	return ring->cpu_addr ? 0 : -ENOMEM;
+}
+
+static void ps_pcie_dma_free_ring(struct ps_pcie_dma_chan *chan,
+				  struct ps_pcie_dma_ring *ring, size_t size)
+{
+	if (!ring->cpu_addr)
+		return;
+
+	dma_free_coherent(chan->xdev->dev, PS_PCIE_DMA_RING_SIZE * size,
+			  ring->cpu_addr, ring->dma_addr);
+	ring->cpu_addr = NULL;
+}
+
+static void ps_pcie_dma_free_rings(struct ps_pcie_dma_chan *chan)
+{
+	ps_pcie_dma_free_ring(chan, &chan->src, sizeof(struct ps_pcie_dma_elem));
+	ps_pcie_dma_free_ring(chan, &chan->dst, sizeof(struct ps_pcie_dma_elem));
+	ps_pcie_dma_free_ring(chan, &chan->stas, sizeof(struct ps_pcie_dma_sta));
+	ps_pcie_dma_free_ring(chan, &chan->stad, sizeof(struct ps_pcie_dma_sta));
+}
+
+static int ps_pcie_dma_alloc_chan_resources(struct dma_chan *dchan)
+{
+	struct ps_pcie_dma_chan *chan = to_chan(dchan);
+	unsigned long flags;
+
+	if (ps_pcie_dma_alloc_ring(chan, &chan->src,
+				   sizeof(struct ps_pcie_dma_elem)) ||
+	    ps_pcie_dma_alloc_ring(chan, &chan->dst,
+				   sizeof(struct ps_pcie_dma_elem)) ||
+	    ps_pcie_dma_alloc_ring(chan, &chan->stas,
+				   sizeof(struct ps_pcie_dma_sta)) ||
+	    ps_pcie_dma_alloc_ring(chan, &chan->stad,
+				   sizeof(struct ps_pcie_dma_sta))) {
+		ps_pcie_dma_free_rings(chan);
+		return -ENOMEM;
+	}
+
+	spin_lock_irqsave(&chan->vchan.lock, flags);
+	ps_pcie_dma_reset(chan);
+	ps_pcie_dma_hw_init(chan);
+	spin_unlock_irqrestore(&chan->vchan.lock, flags);
+
+	return 0;
+}
+
+static void ps_pcie_dma_free_chan_resources(struct dma_chan *dchan)
+{
+	struct ps_pcie_dma_chan *chan = to_chan(dchan);
+	unsigned long flags;
+
+	spin_lock_irqsave(&chan->vchan.lock, flags);
+	ps_pcie_dma_write(chan, PS_PCIE_DMA_AXI_INTR_CNTRL, 0);
+	ps_pcie_dma_reset(chan);
+	spin_unlock_irqrestore(&chan->vchan.lock, flags);
+
+	vchan_free_chan_resources(&chan->vchan);
+	ps_pcie_dma_free_rings(chan);
+}
+
+static int ps_pcie_dma_probe(struct platform_device *pdev)
+{
+	struct ps_pcie_dma_device *xdev;
+	struct dma_device *ddev;
+	unsigned int i;
+	u32 num_chans = PS_PCIE_DMA_MAX_CHANS;
+	int ret;
+
+	xdev = devm_kzalloc(&pdev->dev, sizeof(*xdev), GFP_KERNEL);
+	if (!xdev)
+		return -ENOMEM;
+
+	xdev->dev = &pdev->dev;
+	xdev->regs = devm_platform_ioremap_resource(pdev, 0);
+	if (IS_ERR(xdev->regs))
+		return PTR_ERR(xdev->regs);
+
+	xdev->irq = platform_get_irq(pdev, 0);
+	if (xdev->irq < 0)
+		return xdev->irq;
+
+	xdev->clk = devm_clk_get_optional_enabled(&pdev->dev, NULL);
+	if (IS_ERR(xdev->clk))
+		return dev_err_probe(&pdev->dev, PTR_ERR(xdev->clk),
+				     "failed to enable clock\n");
+
+	of_property_read_u32(pdev->dev.of_node, "dma-channels", &num_chans);
+	if (!num_chans || num_chans > PS_PCIE_DMA_MAX_CHANS) {
+		dev_err(&pdev->dev, "invalid number of channels %u\n",
+			num_chans);
+		return -EINVAL;
+	}
+	xdev->num_chans = num_chans;
+
+	ret = dma_set_mask_and_coherent(&pdev->dev, DMA_BIT_MASK(64));
+	if (ret)
+		return ret;
+
+	ddev = &xdev->common;
+	ddev->dev = &pdev->dev;
+	INIT_LIST_HEAD(&ddev->channels);
+	dma_cap_set(DMA_MEMCPY, ddev->cap_mask);
+	dma_cap_set(DMA_SLAVE, ddev->cap_mask);
+	ddev->src_addr_widths = BIT(DMA_SLAVE_BUSWIDTH_UNDEFINED);
+	ddev->dst_addr_widths = BIT(DMA_SLAVE_BUSWIDTH_UNDEFINED);
+	ddev->directions = BIT(DMA_MEM_TO_DEV) | BIT(DMA_DEV_TO_MEM);
+	ddev->residue_granularity = DMA_RESIDUE_GRANULARITY_DESCRIPTOR;
+	ddev->device_alloc_chan_resources = ps_pcie_dma_alloc_chan_resources;
+	ddev->device_free_chan_resources = ps_pcie_dma_free_chan_resources;
+	ddev->device_prep_dma_memcpy = ps_pcie_dma_prep_memcpy;
+	ddev->device_prep_slave_sg = ps_pcie_dma_prep_slave_sg;
+	ddev->device_config = ps_pcie_dma_slave_config;
+	ddev->device_issue_pending = ps_pcie_dma_issue_pending;
+	ddev->device_terminate_all = ps_pcie_dma_terminate_all;
+	ddev->device_synchronize = ps_pcie_dma_synchronize;
+	ddev->device_tx_status = dma_cookie_status;
+
+	for (i = 0; i < num_chans; i++) {
+		struct ps_pcie_dma_chan *chan = &xdev->chan[i];
+
+		chan->xdev = xdev;
+		chan->id = i;
+		chan->regs = xdev->regs + i * PS_PCIE_DMA_CHAN_OFFSET;
+		chan->vchan.desc_free = ps_pcie_dma_desc_free;
+		vchan_init(&chan->vchan, ddev);
+
+		/* Quiesce whatever the boot firmware left running */
+		ps_pcie_dma_write(chan, PS_PCIE_DMA_AXI_INTR_CNTRL, 0);
+		ps_pcie_dma_reset(chan);
+	}
+
+	ret = devm_request_irq(&pdev->dev, xdev->irq, ps_pcie_dma_irq_handler,
+			       IRQF_SHARED, dev_name(&pdev->dev), xdev);
+	if (ret)
+		return ret;
+
+	ret = dma_async_device_register(ddev);
+	if (ret) {
+		dev_err(&pdev->dev, "failed to register the dma device\n");
+		return ret;
+	}
+
+	ret = of_dma_controller_register(pdev->dev.of_node,
+					 of_dma_xlate_by_chan_id, ddev);
+	if (ret) {
+		dev_err(&pdev->dev, "failed to register DMA to DT DMA helper\n");
+		dma_async_device_unregister(ddev);
+		return ret;
+	}
+
+	platform_set_drvdata(pdev, xdev);
+
+	dev_info(&pdev->dev, "PS PCIe DMA with %u channels\n", num_chans);
+
+	return 0;
+}
+
+static int ps_pcie_dma_remove(struct platform_device *pdev)
+{
+	struct ps_pcie_dma_device *xdev = platform_get_drvdata(pdev);
+	unsigned int i;
+
+	of_dma_controller_free(pdev->dev.of_node);
+	dma_async_device_unregister(&xdev->common);
+	devm_free_irq(&pdev->dev, xdev->irq, xdev);
+
+	for (i = 0; i < xdev->num_chans; i++) {
+		tasklet_kill(&xdev->chan[i].vchan.task);
+		list_del(&xdev->chan[i].vchan.chan.device_node);
+	}
+
+	return 0;
+}
+
+static const struct of_device_id ps_pcie_dma_of_match[] = {
+	{ .compatible = "xlnx,zynqmp-ps-pcie-dma", },
+	{ /* end of table */ }
+};
+MODULE_DEVICE_TABLE(of, ps_pcie_dma_of_match);
+
+static struct platform_driver ps_pcie_dma_driver = {
+	.driver = {
+		.name = "xilinx-ps-pcie-dma",
+		.of_match_table = ps_pcie_dma_of_match,
+	},
+	.probe = ps_pcie_dma_probe,
+	.remove = ps_pcie_dma_remove,
+};
+module_platform_driver(ps_pcie_dma_driver);
+
+MODULE_AUTHOR("Xilinx, Inc.");
+MODULE_DESCRIPTION("Xilinx ZynqMP PS PCIe bridge DMA driver");
+MODULE_LICENSE("GPL");
@@ -0,0 +1,804 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * DMA driver for Xilinx RAID XOR/PQ accelerator behind AXI DMA
+ *
+ * The accelerator sits in the PL between the MM2S and S2MM streams of an
+ * AXI DMA. It has no register interface of its own, every operation is
+ * described by a command at the head of the MM2S stream:
+ *
+ *   command | block 0 of src 0 .. src N-1 | block 1 of src 0 .. src N-1 | ...
+ *
+ * For each block the accelerator accumulates the sources and then emits
+ * P and/or Q for that block on the S2MM stream. Sources are read completely
+ * before the results are written, so a destination may also be a source.
+ *
+ * The streams are driven through the dmaengine slave API of the AXI DMA
+ * channels, this driver only exposes them as a DMA_XOR/DMA_PQ capable
+ * device to the async_tx API.
+ *
+ * Copyright (C) 2022 Xilinx, Inc. All rights reserved.
+ */
+
+#include <linux/bitfield.h>
+#include <linux/dma-mapping.h>
+#include <linux/dmapool.h>
+#include <linux/init.h>
+#include <linux/interrupt.h>
+#include <linux/log2.h>
+#include <linux/module.h>
+#include <linux/of_platform.h>
+#include <linux/scatterlist.h>
+#include <linux/sizes.h>
+#include <linux/slab.h>
+
+#include "../dmaengine.h"
+
+/* Command control word bit field definitions */
+#define XILINX_RAID_CMD_GEN_P		BIT(0)
+#define XILINX_RAID_CMD_GEN_Q		BIT(1)
+#define XILINX_RAID_CMD_SRC_CNT		GENMASK(15, 8)
+#define XILINX_RAID_CMD_BLOCK_SHIFT	GENMASK(23, 16)
+
+/* Hardware limits */
+#define XILINX_RAID_MAX_SRCS		16
+#define XILINX_RAID_DEF_BLOCK_SIZE	SZ_4K
+#define XILINX_RAID_MAX_BLOCK_SIZE	SZ_64K
+
+/* Extra sources needed to continue a PQ operation, see prep_dma_pq */
+#define XILINX_RAID_PQ_CONT_SRCS	3
+
+/**
+ * struct xilinx_raid_cmd - Command at the head of the MM2S stream
+ * @ctrl: Control word
+ * @len: Length of each source in bytes
+ * @coefs: GF(2^8) Q coefficients of the sources
+ */
+struct xilinx_raid_cmd {
+	__le32 ctrl;
+	__le32 len;
+	u8 coefs[XILINX_RAID_MAX_SRCS];
+};
+
+/**
+ * struct xilinx_raid_desc - Per Transaction structure
+ * @async_tx: Async transaction descriptor
+ * @node: Node in the channel descriptor lists
+ * @cmd: Command of the transaction
+ * @cmd_phys: DMA address of @cmd
+ * @src: Source addresses
+ * @dst: P and Q destination addresses
+ * @src_cnt: Number of sources
+ * @dst_cnt: Number of destinations
+ * @len: Length of each source in bytes
+ * @rx_queued: The S2MM transfer has been submitted to the AXI DMA
+ * @complete: Both transfers have completed
+ * @result: Transfer result reported by the AXI DMA
+ */
+struct xilinx_raid_desc {
+	struct dma_async_tx_descriptor async_tx;
+	struct list_head node;
+	struct xilinx_raid_cmd *cmd;
+	dma_addr_t cmd_phys;
+	dma_addr_t src[XILINX_RAID_MAX_SRCS];
+	dma_addr_t dst[2];
+	unsigned int src_cnt;
+	unsigned int dst_cnt;
+	size_t len;
+	bool rx_queued;
+	bool complete;
+	enum dmaengine_tx_result result;
+};
+
+/**
+ * struct xilinx_raid_dma - Driver specific DMA device structure
+ * @dev: Device Structure
+ * @common: DMA device structure
+ * @chan: The only DMA channel of the device
+ * @tx_chan: AXI DMA MM2S channel feeding the accelerator
+ * @rx_chan: AXI DMA S2MM channel draining the accelerator
+ * @cmd_pool: Pool of stream commands
+ * @lock: Descriptor operation lock
+ * @pending_list: Descriptors submitted, not yet handed to the AXI DMA
+ * @active_list: Descriptors handed to the AXI DMA, in stream order
+ * @done_list: Descriptors completed, waiting for the client to ack them
+ * @terminated_list: Descriptors aborted, freed once the AXI DMA is quiet
+ * @tasklet: Cleanup work after completion
+ * @block_size: Size of the accelerator block buffer
+ * @max_srcs: Maximum number of sources of an operation
+ */
+struct xilinx_raid_dma {
+	struct device *dev;
+	struct dma_device common;
+	struct dma_chan chan;
+	struct dma_chan *tx_chan;
+	struct dma_chan *rx_chan;
+	struct dma_pool *cmd_pool;
+	spinlock_t lock;
+	struct list_head pending_list;
+	struct list_head active_list;
+	struct list_head done_list;
+	struct list_head terminated_list;
+	struct tasklet_struct tasklet;
+	u32 block_size;
+	u32 max_srcs;
+};
+
+#define to_xdev(chan)	container_of(chan, struct xilinx_raid_dma, chan)
+#define tx_to_desc(tx)	container_of(tx, struct xilinx_raid_desc, async_tx)
+
+/**
+ * xilinx_raid_free_desc - Free a descriptor
+ * @xdev: Driver specific device structure
+ * @desc: Transaction descriptor pointer
+ */
+static void xilinx_raid_free_desc(struct xilinx_raid_dma *xdev,
+				  struct xilinx_raid_desc *desc)
+{
+	dma_pool_free(xdev->cmd_pool, desc->cmd, desc->cmd_phys);
+	kfree(desc);
+}
+
+/**
+ * xilinx_raid_free_desc_list - Free descriptors list
+ * @xdev: Driver specific device structure
+ * @list: List to parse and delete the descriptor
+ */
+static void xilinx_raid_free_desc_list(struct xilinx_raid_dma *xdev,
+				       struct list_head *list)
+{
+	struct xilinx_raid_desc *desc, *next;
+
+	list_for_each_entry_safe(desc, next, list, node) {
+		list_del(&desc->node);
+		xilinx_raid_free_desc(xdev, desc);
+	}
+}
+
+/**
+ * xilinx_raid_rx_done - S2MM transfer completion callback
+ * @param: Transaction descriptor pointer
+ * @result: Transfer result
+ *
+ * The results are the last thing the accelerator produces, so the
+ * completion of the S2MM transfer completes the whole transaction.
+ */
+static void xilinx_raid_rx_done(void *param,
+				const struct dmaengine_result *result)
+{
+	struct xilinx_raid_desc *desc = param;
+	struct xilinx_raid_dma *xdev = to_xdev(desc->async_tx.chan);
+	unsigned long irqflags;
+
+	spin_lock_irqsave(&xdev->lock, irqflags);
+	desc->complete = true;
+	if (result)
+		desc->result = result->result;
+	spin_unlock_irqrestore(&xdev->lock, irqflags);
+
+	tasklet_schedule(&xdev->tasklet);
+}
+
+/**
+ * xilinx_raid_queue_rx - Hand the S2MM transfer of a descriptor to AXI DMA
+ * @xdev: Driver specific device structure
+ * @desc: Transaction descriptor pointer
+ *
+ * Return: '0' on success and -ENOMEM if the transfer can't be prepared
+ */
+static int xilinx_raid_queue_rx(struct xilinx_raid_dma *xdev,
+				struct xilinx_raid_desc *desc)
+{
+	struct dma_async_tx_descriptor *tx;
+	struct scatterlist *sgl, *sg;
+	unsigned int nents, i;
+	size_t off, len;
+
+	nents = DIV_ROUND_UP(desc->len, xdev->block_size) * desc->dst_cnt;
+	sgl = kmalloc_array(nents, sizeof(*sgl), GFP_ATOMIC);
+	if (!sgl)
+		return -ENOMEM;
+
+	sg_init_table(sgl, nents);
+	sg = sgl;
+	for (off = 0; off < desc->len; off += len) {
+		len = min_t(size_t, desc->len - off, xdev->block_size);
+		for (i = 0; i < desc->dst_cnt; i++) {
+			sg_dma_address(sg) = desc->dst[i] + off;
+			sg_dma_len(sg) = len;
+			sg = sg_next(sg);
+		}
+	}
+
+	tx = dmaengine_prep_slave_sg(xdev->rx_chan, sgl, nents, DMA_DEV_TO_MEM,
+				     DMA_PREP_INTERRUPT | DMA_CTRL_ACK);
+	kfree(sgl);
+	if (!tx)
+		return -ENOMEM;
+
+	tx->callback_result = xilinx_raid_rx_done;
+	tx->callback_param = desc;
+	dmaengine_submit(tx);
+
+	return 0;
+}
+
+/**
+ * xilinx_raid_queue_tx - Hand the MM2S transfer of a descriptor to AXI DMA
+ * @xdev: Driver specific device structure
+ * @desc: Transaction descriptor pointer
+ *
+ * Return: '0' on success and -ENOMEM if the transfer can't be prepared
+ */
+static int xilinx_raid_queue_tx(struct xilinx_raid_dma *xdev,
+				struct xilinx_raid_desc *desc)
+{
+	struct dma_async_tx_descriptor *tx;
+	struct scatterlist *sgl, *sg;
+	unsigned int nents, i;
+	size_t off, len;
+
+	nents = 1 + DIV_ROUND_UP(desc->len, xdev->block_size) * desc->src_cnt;
+	sgl = kmalloc_array(nents, sizeof(*sgl), GFP_ATOMIC);
+	if (!sgl)
+		return -ENOMEM;
+
+	sg_init_table(sgl, nents);
+	sg_dma_address(sgl) = desc->cmd_phys;
+	sg_dma_len(sgl) = sizeof(*desc->cmd);
+	sg = sg_next(sgl);
+	for (off = 0; off < desc->len; off += len) {
+		len = min_t(size_t, desc->len - off, xdev->block_size);
+		for (i = 0; i < desc->src_cnt; i++) {
+			sg_dma_address(sg) = desc->src[i] + off;
+			sg_dma_len(sg) = len;
+			sg = sg_next(sg);
+		}
+	}
+
+	tx = dmaengine_prep_slave_sg(xdev->tx_chan, sgl, nents, DMA_MEM_TO_DEV,
+				     DMA_CTRL_ACK);
+	kfree(sgl);
+	if (!tx)
+		return -ENOMEM;
+
+	dmaengine_submit(tx);
+
+	return 0;
+}
+
+/**
+ * xilinx_raid_start - Hand pending descriptors to the AXI DMA
+ * @xdev: Driver specific device structure
+ *
+ * Called with the lock held. Descriptors that can't be handed over yet stay
+ * on the pending list and are retried when an active descriptor completes.
+ */
+static void xilinx_raid_start(struct xilinx_raid_dma *xdev)
+{
+	struct xilinx_raid_desc *desc, *last;
+	bool queued = false;
+
+	while (!list_empty(&xdev->pending_list)) {
+		/* Later operations depend on the result of a fenced one */
+		last = list_last_entry_or_null(&xdev->active_list,
+					       struct xilinx_raid_desc, node);
+		if (last && (last->async_tx.flags & DMA_PREP_FENCE))
+			break;
+
+		desc = list_first_entry(&xdev->pending_list,
+					struct xilinx_raid_desc, node);
+
+		if (!desc->src_cnt) {
+			/* Interrupt only, completes after the ones before it */
+			desc->complete = true;
+			list_move_tail(&desc->node, &xdev->active_list);
+			tasklet_schedule(&xdev->tasklet);
+			continue;
+		}
+
+		/*
+		 * The S2MM transfer goes first, it just waits for the stream.
+		 * If the MM2S transfer then can't be prepared it is retried
+		 * later and the streams still line up.
+		 */
+		if (!desc->rx_queued) {
+			if (xilinx_raid_queue_rx(xdev, desc))
+				break;
+			desc->rx_queued = true;
+		}
+		if (xilinx_raid_queue_tx(xdev, desc))
+			break;
+
+		list_move_tail(&desc->node, &xdev->active_list);
+		queued = true;
+	}
+
+	if (queued) {
+		dma_async_issue_pending(xdev->rx_chan);
+		dma_async_issue_pending(xdev->tx_chan);
+	}
+}
+
+/**
+ * xilinx_raid_do_tasklet - Complete the finished descriptors in order
+ * @t: Pointer to the tasklet
+ */
+static void xilinx_raid_do_tasklet(struct tasklet_struct *t)
+{
+	struct xilinx_raid_dma *xdev = from_tasklet(xdev, t, tasklet);
+	struct xilinx_raid_desc *desc, *next;
+	unsigned long irqflags;
+	LIST_HEAD(done);
+
+	spin_lock_irqsave(&xdev->lock, irqflags);
+	list_for_each_entry_safe(desc, next, &xdev->active_list, node) {
+		if (!desc->complete)
+			break;
+		dma_cookie_complete(&desc->async_tx);
+		list_move_tail(&desc->node, &done);
+	}
+	/* The active list may have lost a fenced descriptor */
+	xilinx_raid_start(xdev);
+	spin_unlock_irqrestore(&xdev->lock, irqflags);
+
+	list_for_each_entry(desc, &done, node) {
+		struct dmaengine_result res = {
+			.result = desc->result,
+		};
+
+		if (desc->result != DMA_TRANS_NOERROR)
+			dev_err_ratelimited(xdev->dev,
+					    "transfer failed, cookie %d\n",
+					    desc->async_tx.cookie);
+
+		dmaengine_desc_get_callback_invoke(&desc->async_tx, &res);
+		dma_descriptor_unmap(&desc->async_tx);
+
+		/*
+		 * Run any dependencies, they may be issued on this very
+		 * channel so the lock must not be held.
+		 */
+		dma_run_dependencies(&desc->async_tx);
+	}
+
+	/* Free what the clients are done with, keep the rest for later */
+	spin_lock_irqsave(&xdev->lock, irqflags);
+	list_splice_tail(&done, &xdev->done_list);
+	list_for_each_entry_safe(desc, next, &xdev->done_list, node) {
+		if (!async_tx_test_ack(&desc->async_tx))
+			continue;
+		list_del(&desc->node);
+		xilinx_raid_free_desc(xdev, desc);
+	}
+	spin_unlock_irqrestore(&xdev->lock, irqflags);
+}
+
+/**
+ * xilinx_raid_tx_submit - Submit DMA transaction
+ * @tx: Async transaction descriptor pointer
+ *
+ * Return: cookie value
+ */
+static dma_cookie_t xilinx_raid_tx_submit(struct dma_async_tx_descriptor *tx)
+{
+	struct xilinx_raid_dma *xdev = to_xdev(tx->chan);
+	struct xilinx_raid_desc *desc = tx_to_desc(tx);
+	dma_cookie_t cookie;
+	unsigned long irqflags;
+
+	spin_lock_irqsave(&xdev->lock, irqflags);
+	cookie = dma_cookie_assign(tx);
+	list_add_tail(&desc->node, &xdev->pending_list);
+	spin_unlock_irqrestore(&xdev->lock, irqflags);
+
+	return cookie;
+}
+
+/**
+ * xilinx_raid_alloc_desc - Allocate a transaction descriptor
+ * @xdev: Driver specific device structure
+ * @flags: transfer ack flags
+ *
+ * Return: The descriptor, NULL if it can't be allocated
+ */
+static struct xilinx_raid_desc *
+xilinx_raid_alloc_desc(struct xilinx_raid_dma *xdev, unsigned long flags)
+{
+	struct xilinx_raid_desc *desc;
+
+	desc = kzalloc(sizeof(*desc), GFP_NOWAIT);
+	if (!desc)
+		return NULL;
+
+	desc->cmd = dma_pool_zalloc(xdev->cmd_pool, GFP_NOWAIT,
+				    &desc->cmd_phys);
+	if (!desc->cmd) {
+		kfree(desc);
+		return NULL;
+	}
+
+	dma_async_tx_descriptor_init(&desc->async_tx, &xdev->chan);
+	desc->async_tx.tx_submit = xilinx_raid_tx_submit;
+	desc->async_tx.flags = flags;
+	desc->result = DMA_TRANS_NOERROR;
+
+	return desc;
+}
+
+/**
+ * xilinx_raid_add_src - Add a source to a transaction descriptor
+ * @desc: Transaction descriptor pointer
+ * @src: Source address
+ * @coef: Q coefficient of the source
+ */
+static void xilinx_raid_add_src(struct xilinx_raid_desc *desc, dma_addr_t src,
+				u8 coef)
+{
+	desc->cmd->coefs[desc->src_cnt] = coef;
+	desc->src[desc->src_cnt++] = src;
+}
+
+/**
+ * xilinx_raid_set_cmd - Fill the stream command of a descriptor
+ * @xdev: Driver specific device structure
+ * @desc: Transaction descriptor pointer
+ * @ctrl: Operation bits of the control word
+ */
+static void xilinx_raid_set_cmd(struct xilinx_raid_dma *xdev,
+				struct xilinx_raid_desc *desc, u32 ctrl)
+{
+	ctrl |= FIELD_PREP(XILINX_RAID_CMD_SRC_CNT, desc->src_cnt);
+	ctrl |= FIELD_PREP(XILINX_RAID_CMD_BLOCK_SHIFT,
+			   ilog2(xdev->block_size));
+	desc->cmd->ctrl = cpu_to_le32(ctrl);
+	desc->cmd->len = cpu_to_le32(desc->len);
+}
+
+/**
+ * xilinx_raid_prep_xor - prepare descriptors for a XOR transaction
+ * @dchan: DMA channel
+ * @dst: Destination address
+ * @src: Source addresses
+ * @src_cnt: Number of sources
+ * @len: Transfer length
+ * @flags: transfer ack flags
+ *
+ * Return: Async transaction descriptor on success and NULL on failure
+ */
+static struct dma_async_tx_descriptor *
+xilinx_raid_prep_xor(struct dma_chan *dchan, dma_addr_t dst, dma_addr_t *src,
+		     unsigned int src_cnt, size_t len, unsigned long flags)
+{
+	struct xilinx_raid_dma *xdev = to_xdev(dchan);
+	struct xilinx_raid_desc *desc;
+	unsigned int i;
+
+	if (src_cnt > xdev->max_srcs || len > U32_MAX)
+		return NULL;
+
+	desc = xilinx_raid_alloc_desc(xdev, flags);
+	if (!desc)
+		return NULL;
+
+	for (i = 0; i < src_cnt; i++)
+		xilinx_raid_add_src(desc, src[i], 0);
+	desc->dst[desc->dst_cnt++] = dst;
+	desc->len = len;
+	xilinx_raid_set_cmd(xdev, desc, XILINX_RAID_CMD_GEN_P);
+
+	return &desc->async_tx;
+}
+
+/**
+ * xilinx_raid_prep_pq - prepare descriptors for a PQ transaction
+ * @dchan: DMA channel
+ * @dst: P and Q destination addresses
+ * @src: Source addresses
+ * @src_cnt: Number of sources
+ * @scf: Q coefficients of the sources
+ * @len: Transfer length
+ * @flags: transfer ack flags
+ *
+ * Return: Async transaction descriptor on success and NULL on failure
+ */
+static struct dma_async_tx_descriptor *
+xilinx_raid_prep_pq(struct dma_chan *dchan, dma_addr_t *dst, dma_addr_t *src,
+		    unsigned int src_cnt, const unsigned char *scf, size_t len,
+		    unsigned long flags)
+{
+	struct xilinx_raid_dma *xdev = to_xdev(dchan);
+	struct xilinx_raid_desc *desc;
+	u32 ctrl = 0;
+	unsigned int i;
+
+	if (src_cnt > dma_maxpq(&xdev->common, flags) || len > U32_MAX)
+		return NULL;
+
+	desc = xilinx_raid_alloc_desc(xdev, flags);
+	if (!desc)
+		return NULL;
+
+	for (i = 0; i < src_cnt; i++)
+		xilinx_raid_add_src(desc, src[i], scf[i]);
+
+	/*
+	 * The accelerator can't start from existing P and Q, so continuing
+	 * an operation feeds them back as extra sources. P with coefficient
+	 * 0 only adds to P. Q with coefficient 1 adds to both P and Q, and Q
+	 * with coefficient 0 cancels it again from P.
+	 */
+	if (flags & DMA_PREP_CONTINUE) {
+		if (flags & DMA_PREP_PQ_DISABLE_P) {
+			xilinx_raid_add_src(desc, dst[1], 1);
+		} else if (flags & DMA_PREP_PQ_DISABLE_Q) {
+			xilinx_raid_add_src(desc, dst[0], 0);
+		} else {
+			xilinx_raid_add_src(desc, dst[0], 0);
+			xilinx_raid_add_src(desc, dst[1], 1);
+			xilinx_raid_add_src(desc, dst[1], 0);
+		}
+	}
+
+	if (!(flags & DMA_PREP_PQ_DISABLE_P)) {
+		desc->dst[desc->dst_cnt++] = dst[0];
+		ctrl |= XILINX_RAID_CMD_GEN_P;
+	}
+	if (!(flags & DMA_PREP_PQ_DISABLE_Q)) {
+		desc->dst[desc->dst_cnt++] = dst[1];
+		ctrl |= XILINX_RAID_CMD_GEN_Q;
+	}
+	desc->len = len;
+	xilinx_raid_set_cmd(xdev, desc, ctrl);
+
+	return &desc->async_tx;
+}
+
+/**
+ * xilinx_raid_prep_interrupt - prepare an interrupt only descriptor
+ * @dchan: DMA channel
+ * @flags: transfer ack flags
+ *
+ * Return: Async transaction descriptor on success and NULL on failure
+ */
+static struct dma_async_tx_descriptor *
+xilinx_raid_prep_interrupt(struct dma_chan *dchan, unsigned long flags)
+{
+	struct xilinx_raid_desc *desc;
+
+	desc = xilinx_raid_alloc_desc(to_xdev(dchan), flags);
+	if (!desc)
+		return NULL;
+
+	return &desc->async_tx;
+}
+
+/**
+ * xilinx_raid_issue_pending - Issue pending transactions
+ * @dchan: DMA channel pointer
+ */
+static void xilinx_raid_issue_pending(struct dma_chan *dchan)
+{
+	struct xilinx_raid_dma *xdev = to_xdev(dchan);
+	unsigned long irqflags;
+
+	spin_lock_irqsave(&xdev->lock, irqflags);
+	xilinx_raid_start(xdev);
+	spin_unlock_irqrestore(&xdev->lock, irqflags);
+}
+
+/**
+ * xilinx_raid_terminate_all - Aborts all transfers on a channel
+ * @dchan: DMA channel pointer
+ *
+ * Return: '0' on success and failure value on error
+ */
+static int xilinx_raid_terminate_all(struct dma_chan *dchan)
+{
+	struct xilinx_raid_dma *xdev = to_xdev(dchan);
+	unsigned long irqflags;
+	int ret;
+
+	ret = dmaengine_terminate_async(xdev->tx_chan);
+	if (!ret)
+		ret = dmaengine_terminate_async(xdev->rx_chan);
+	if (ret)
+		return ret;
+
+	spin_lock_irqsave(&xdev->lock, irqflags);
+	xilinx_raid_free_desc_list(xdev, &xdev->pending_list);
+	xilinx_raid_free_desc_list(xdev, &xdev->done_list);
+	/* A S2MM callback may still be running for the active ones */
+	list_splice_tail_init(&xdev->active_list, &xdev->terminated_list);
+	spin_unlock_irqrestore(&xdev->lock, irqflags);
+
+	return 0;
+}
+
+/**
+ * xilinx_raid_synchronize - Synchronizes the termination of a transfers to the current context.
+ * @dchan: DMA channel pointer
+ */
+static void xilinx_raid_synchronize(struct dma_chan *dchan)
+{
+	struct xilinx_raid_dma *xdev = to_xdev(dchan);
+	unsigned long irqflags;
+
+	dmaengine_synchronize(xdev->tx_chan);
+	dmaengine_synchronize(xdev->rx_chan);
+	tasklet_kill(&xdev->tasklet);
+
+	spin_lock_irqsave(&xdev->lock, irqflags);
+	xilinx_raid_free_desc_list(xdev, &xdev->terminated_list);
+	spin_unlock_irqrestore(&xdev->lock, irqflags);
+}
+
+/**
+ * xilinx_raid_free_chan_resources - Free channel resources
+ * @dchan: DMA channel pointer
+ */
+static void xilinx_raid_free_chan_resources(struct dma_chan *dchan)
+{
+	xilinx_raid_terminate_all(dchan);
+	xilinx_raid_synchronize(dchan);
+}
+
+/**
+ * xilinx_raid_probe - Driver probe function
+ * @pdev: Pointer to the platform_device structure
+ *
+ * Return: '0' on success and failure value on error
+ */
+static int xilinx_raid_probe(struct platform_device *pdev)
+{
+	struct device_node *node = pdev->dev.of_node;
+	struct xilinx_raid_dma *xdev;
+	struct device *dma_dev;
+	struct dma_device *p;
+	int ret;
+
+	xdev = devm_kzalloc(&pdev->dev, sizeof(*xdev), GFP_KERNEL);
+	if (!xdev)
+		return -ENOMEM;
+
+	xdev->dev = &pdev->dev;
+	spin_lock_init(&xdev->lock);
+	INIT_LIST_HEAD(&xdev->pending_list);
+	INIT_LIST_HEAD(&xdev->active_list);
+	INIT_LIST_HEAD(&xdev->done_list);
+	INIT_LIST_HEAD(&xdev->terminated_list);
+	tasklet_setup(&xdev->tasklet, xilinx_raid_do_tasklet);
+
+	xdev->block_size = XILINX_RAID_DEF_BLOCK_SIZE;
+	of_property_read_u32(node, "xlnx,block-size", &xdev->block_size);
+	if (!is_power_of_2(xdev->block_size) ||
+	    xdev->block_size > XILINX_RAID_MAX_BLOCK_SIZE) {
+		dev_err(&pdev->dev, "invalid xlnx,block-size value\n");
+		return -EINVAL;
+	}
+
+	/* Continuing a PQ operation needs room for three sources */
+	xdev->max_srcs = XILINX_RAID_MAX_SRCS;
+	of_property_read_u32(node, "xlnx,max-sources", &xdev->max_srcs);
+	if (xdev->max_srcs <= XILINX_RAID_PQ_CONT_SRCS ||
+	    xdev->max_srcs > XILINX_RAID_MAX_SRCS) {
+		dev_err(&pdev->dev, "invalid xlnx,max-sources value\n");
+		return -EINVAL;
+	}
+
+	xdev->tx_chan = dma_request_chan(&pdev->dev, "tx");
+	if (IS_ERR(xdev->tx_chan))
+		return dev_err_probe(&pdev->dev, PTR_ERR(xdev->tx_chan),
+				     "tx channel not found\n");
+
+	xdev->rx_chan = dma_request_chan(&pdev->dev, "rx");
+	if (IS_ERR(xdev->rx_chan)) {
+		ret = dev_err_probe(&pdev->dev, PTR_ERR(xdev->rx_chan),
+				    "rx channel not found\n");
+		goto err_release_tx;
+	}
+
+	/*
+	 * The AXI DMA is the bus master of both streams, the commands and
+	 * the buffers async_tx maps for this device must be mapped for it.
+	 */
+	dma_dev = xdev->tx_chan->device->dev;
+	if (xdev->rx_chan->device->dev != dma_dev) {
+		dev_err(&pdev->dev, "tx and rx channels of different DMAs\n");
+		ret = -EINVAL;
+		goto err_release_rx;
+	}
+
+	xdev->cmd_pool = dma_pool_create("xilinx_raid_cmd", dma_dev,
+					 sizeof(struct xilinx_raid_cmd),
+					 SMP_CACHE_BYTES, 0);
+	if (!xdev->cmd_pool) {
+		ret = -ENOMEM;
+		goto err_release_rx;
+	}
+
+	p = &xdev->common;
+	INIT_LIST_HEAD(&p->channels);
+	dma_cap_set(DMA_XOR, p->cap_mask);
+	dma_cap_set(DMA_PQ, p->cap_mask);
+	dma_cap_set(DMA_INTERRUPT, p->cap_mask);
+	p->max_xor = xdev->max_srcs;
+	dma_set_maxpq(p, xdev->max_srcs, 0);
+	/* The AXI DMA may be built without data realignment */
+	p->xor_align = DMAENGINE_ALIGN_64_BYTES;
+	p->pq_align = DMAENGINE_ALIGN_64_BYTES;
+
+	p->device_prep_dma_xor = xilinx_raid_prep_xor;
+	p->device_prep_dma_pq = xilinx_raid_prep_pq;
+	p->device_prep_dma_interrupt = xilinx_raid_prep_interrupt;
+	p->device_terminate_all = xilinx_raid_terminate_all;
+	p->device_synchronize = xilinx_raid_synchronize;
+	p->device_issue_pending = xilinx_raid_issue_pending;
+	p->device_free_chan_resources = xilinx_raid_free_chan_resources;
+	p->device_tx_status = dma_cookie_status;
+	p->dev = dma_dev;
+
+	dma_cookie_init(&xdev->chan);
+	xdev->chan.device = p;
+	list_add_tail(&xdev->chan.device_node, &p->channels);
+
+	platform_set_drvdata(pdev, xdev);
+
+	ret = dma_async_device_register(p);
+	if (ret) {
+		dev_err(&pdev->dev, "failed to register the dma device\n");
+		goto err_destroy_pool;
+	}
+
+	dev_info(&pdev->dev, "Xilinx RAID DMA, %u sources, %u byte blocks\n",
+		 xdev->max_srcs, xdev->block_size);
+
+	return 0;
+
+err_destroy_pool:
+	dma_pool_destroy(xdev->cmd_pool);
+err_release_rx:
+	dma_release_channel(xdev->rx_chan);
+err_release_tx:
+	dma_release_channel(xdev->tx_chan);
+	return ret;
+}
+
+/**
+ * xilinx_raid_remove - Driver remove function
+ * @pdev: Pointer to the platform_device structure
+ *
+ * Return: Always '0'
+ */
+static int xilinx_raid_remove(struct platform_device *pdev)
+{
+	struct xilinx_raid_dma *xdev = platform_get_drvdata(pdev);
+
+	dma_async_device_unregister(&xdev->common);
+	tasklet_kill(&xdev->tasklet);
+	dma_pool_destroy(xdev->cmd_pool);
+	dma_release_channel(xdev->rx_chan);
+	dma_release_channel(xdev->tx_chan);
+
+	return 0;
+}
+
+static const struct of_device_id xilinx_raid_of_match[] = {
+	{ .compatible = "xlnx,raid-pq-accel-1.0", },
+	{}
+};
+MODULE_DEVICE_TABLE(of, xilinx_raid_of_match);
+
+static struct platform_driver xilinx_raid_driver = {
+	.driver = {
+		.name = "xilinx-raid-dma",
+		.of_match_table = xilinx_raid_of_match,
+	},
+	.probe = xilinx_raid_probe,
+	.remove = xilinx_raid_remove,
+};
+
+module_platform_driver(xilinx_raid_driver);
+
+MODULE_LICENSE("GPL");
+MODULE_AUTHOR("Xilinx, Inc.");
+MODULE_DESCRIPTION("Xilinx RAID XOR/PQ accelerator DMA driver");
@@ -5,11 +5,13 @@
  * Copyright (C) 2016 Xilinx, Inc. All rights reserved.
  */
 
+#include <linux/bitfield.h>
 #include <linux/bitops.h>
 #include <linux/dma-mapping.h>
 #include <linux/init.h>
 #include <linux/interrupt.h>
 #include <linux/io.h>
+#include <linux/iopoll.h>
 #include <linux/module.h>
 #include <linux/of_dma.h>
 #include <linux/of_platform.h>
@@ -19,6 +21,7 @@
 #include <linux/pm_runtime.h>
 
 #include "../dmaengine.h"
+#include "xilinx_dma_trace.h"
 
 /* Register Offsets */
 #define ZYNQMP_DMA_ISR			0x100
@@ -27,6 +30,7 @@
 #define ZYNQMP_DMA_IDS			0x10C
 #define ZYNQMP_DMA_CTRL0		0x110
 #define ZYNQMP_DMA_CTRL1		0x114
+#define ZYNQMP_DMA_STATUS		0x11C
 #define ZYNQMP_DMA_DATA_ATTR		0x120
 #define ZYNQMP_DMA_DSCR_ATTR		0x124
 #define ZYNQMP_DMA_SRC_DSCR_WRD0	0x128
@@ -37,6 +41,10 @@
 #define ZYNQMP_DMA_DST_DSCR_WRD1	0x13C
 #define ZYNQMP_DMA_DST_DSCR_WRD2	0x140
 #define ZYNQMP_DMA_DST_DSCR_WRD3	0x144
+#define ZYNQMP_DMA_WR_ONLY_WORD0	0x148
+#define ZYNQMP_DMA_WR_ONLY_WORD1	0x14C
+#define ZYNQMP_DMA_WR_ONLY_WORD2	0x150
+#define ZYNQMP_DMA_WR_ONLY_WORD3	0x154
 #define ZYNQMP_DMA_SRC_START_LSB	0x158
 #define ZYNQMP_DMA_SRC_START_MSB	0x15C
 #define ZYNQMP_DMA_DST_START_LSB	0x160
@@ -62,11 +70,17 @@
 /* Control 0 register bit field definitions */
 #define ZYNQMP_DMA_OVR_FETCH		BIT(7)
 #define ZYNQMP_DMA_POINT_TYPE_SG	BIT(6)
+#define ZYNQMP_DMA_MODE			GENMASK(5, 4)
+#define ZYNQMP_DMA_MODE_WR_ONLY		BIT(4)
 #define ZYNQMP_DMA_RATE_CTRL_EN		BIT(3)
 
 /* Control 1 register bit field definitions */
 #define ZYNQMP_DMA_SRC_ISSUE		GENMASK(4, 0)
 
+/* Status register bit field definitions */
+#define ZYNQMP_DMA_STATE		GENMASK(1, 0)
+#define ZYNQMP_DMA_STATE_BUSY		2
+
 /* Data Attribute register bit field definitions */
 #define ZYNQMP_DMA_ARBURST		GENMASK(27, 26)
 #define ZYNQMP_DMA_ARCACHE		GENMASK(25, 22)
@@ -114,8 +128,11 @@
 					ZYNQMP_DMA_INT_OVRFL | \
 					ZYNQMP_DMA_DST_DSCR_DONE)
 
-/* Max number of descriptors per channel */
-#define ZYNQMP_DMA_NUM_DESCS	32
+/* Time a released peer is given to finish the transfer it was running */
+#define ZYNQMP_DMA_IDLE_TIMEOUT_US	1000
+
+/* Max number of descriptors per channel, one per row of a 2D transfer */
+#define ZYNQMP_DMA_NUM_DESCS	128
 
 /* Max transfer size per descriptor */
 #define ZYNQMP_DMA_MAX_TRANS_LEN	0x40000000
@@ -139,6 +156,11 @@
 
 #define ZYNQMP_DMA_DESC_SIZE(chan)	(chan->desc_size)
 
+static bool spread_channels;
+module_param(spread_channels, bool, 0444);
+MODULE_PARM_DESC(spread_channels,
+		 "Run the transfers of a busy channel on idle channels of the same kind (default: off)");
+
 #define to_chan(chan)		container_of(chan, struct zynqmp_dma_chan, \
 					     common)
 #define tx_to_desc(tx)		container_of(tx, struct zynqmp_dma_desc_sw, \
@@ -172,6 +194,10 @@ struct zynqmp_dma_desc_ll {
  * @src_p: Physical address of the src descriptor
  * @dst_v: Virtual address of the dst descriptor
  * @dst_p: Physical address of the dst descriptor
+ * @memset: Transfer uses the write-only (memset) mode
+ * @memset_val: Fill pattern of a memset transfer
+ * @hw: Channel running the transfer
+ * @done: The transfer completed, possibly ahead of earlier ones
  */
 struct zynqmp_dma_desc_sw {
 	u64 src;
@@ -184,6 +210,10 @@ struct zynqmp_dma_desc_sw {
 	dma_addr_t src_p;
 	struct zynqmp_dma_desc_ll *dst_v;
 	dma_addr_t dst_p;
+	bool memset;
+	u32 memset_val;
+	struct zynqmp_dma_chan *hw;
+	bool done;
 };
 
 /**
@@ -210,6 +240,10 @@ struct zynqmp_dma_desc_sw {
  * @bus_width: Bus width
  * @src_burst_len: Source burst length
  * @dst_burst_len: Dest burst length
+ * @node: Node in the list of ZynqMP DMA channels
+ * @peers: Channels the transfers may run on when this one is busy
+ * @nr_peers: Number of @peers
+ * @borrowed_by: Channel whose transfers this one runs, NULL for its own
  */
 struct zynqmp_dma_chan {
 	struct zynqmp_dma_device *zdev;
@@ -234,6 +268,10 @@ struct zynqmp_dma_chan {
 	u32 bus_width;
 	u32 src_burst_len;
 	u32 dst_burst_len;
+	struct list_head node;
+	struct zynqmp_dma_chan **peers;
+	unsigned int nr_peers;
+	struct zynqmp_dma_chan *borrowed_by;
 };
 
 /**
@@ -252,6 +290,10 @@ struct zynqmp_dma_device {
 	struct clk *clk_apb;
 };
 
+/* All the probed channels, the peers of a spreading channel are among them */
+static LIST_HEAD(zynqmp_dma_chans);
+static DEFINE_MUTEX(zynqmp_dma_chans_lock);
+
 static inline void zynqmp_dma_writeq(struct zynqmp_dma_chan *chan, u32 reg,
 				     u64 value)
 {
@@ -359,6 +401,43 @@ static void zynqmp_dma_init(struct zynqmp_dma_chan *chan)
 	chan->idle = true;
 }
 
+/**
+ * zynqmp_dma_desc_compatible - Check whether two transfers can be chained
+ * @a: Transaction descriptor pointer
+ * @b: Transaction descriptor pointer
+ *
+ * The transfer mode and the memset fill pattern are channel registers, so
+ * only transfers programmed alike may run from one hw descriptor chain.
+ *
+ * Return: true if @b may follow @a in the same chain
+ */
+static bool zynqmp_dma_desc_compatible(struct zynqmp_dma_desc_sw *a,
+				       struct zynqmp_dma_desc_sw *b)
+{
+	if (a->memset != b->memset)
+		return false;
+
+	return !a->memset || a->memset_val == b->memset_val;
+}
+
+/**
+ * zynqmp_dma_desc_chained - Check whether a transfer runs in the chain of another
+ * @chan: ZynqMP DMA channel pointer
+ * @a: Transaction descriptor pointer
+ * @b: Transaction descriptor pointer
+ *
+ * A channel with peers runs every transfer on its own, on whichever of the
+ * channel and its peers is idle.
+ *
+ * Return: true if @b follows @a in the same hw descriptor chain
+ */
+static bool zynqmp_dma_desc_chained(struct zynqmp_dma_chan *chan,
+				    struct zynqmp_dma_desc_sw *a,
+				    struct zynqmp_dma_desc_sw *b)
+{
+	return !chan->nr_peers && zynqmp_dma_desc_compatible(a, b);
+}
+
 /**
  * zynqmp_dma_tx_submit - Submit DMA transaction
  * @tx: Async transaction descriptor pointer
@@ -375,10 +454,11 @@ static dma_cookie_t zynqmp_dma_tx_submit(struct dma_async_tx_descriptor *tx)
 	new = tx_to_desc(tx);
 	spin_lock_irqsave(&chan->lock, irqflags);
 	cookie = dma_cookie_assign(tx);
+	trace_xilinx_dma_submit(tx);
 
-	if (!list_empty(&chan->pending_list)) {
-		desc = list_last_entry(&chan->pending_list,
-				     struct zynqmp_dma_desc_sw, node);
+	desc = list_last_entry_or_null(&chan->pending_list,
+				       struct zynqmp_dma_desc_sw, node);
+	if (desc && zynqmp_dma_desc_chained(chan, desc, new)) {
 		if (!list_empty(&desc->tx_list))
 			desc = list_last_entry(&desc->tx_list,
 					       struct zynqmp_dma_desc_sw, node);
@@ -413,6 +493,8 @@ zynqmp_dma_get_descriptor(struct zynqmp_dma_chan *chan)
 	spin_unlock_irqrestore(&chan->lock, irqflags);
 
 	INIT_LIST_HEAD(&desc->tx_list);
+	desc->memset = false;
+	desc->memset_val = 0;
 	/* Clear the src and dst descriptor memory */
 	memset((void *)desc->src_v, 0, ZYNQMP_DMA_DESC_SIZE(chan));
 	memset((void *)desc->dst_v, 0, ZYNQMP_DMA_DESC_SIZE(chan));
@@ -452,6 +534,102 @@ static void zynqmp_dma_free_desc_list(struct zynqmp_dma_chan *chan,
 		zynqmp_dma_free_descriptor(chan, desc);
 }
 
+/**
+ * zynqmp_dma_release_peers - Release the peers running transfers of a channel
+ * @chan: ZynqMP DMA channel pointer
+ *
+ * A peer may still be fetching the hw descriptors of @chan, it is only
+ * returned once it has gone idle.
+ */
+static void zynqmp_dma_release_peers(struct zynqmp_dma_chan *chan)
+{
+	struct zynqmp_dma_chan *peer;
+	unsigned long irqflags;
+	unsigned int i;
+	u32 val;
+	int ret;
+
+	for (i = 0; i < chan->nr_peers; i++) {
+		peer = chan->peers[i];
+		spin_lock_irqsave(&peer->lock, irqflags);
+		if (peer->borrowed_by == chan) {
+			writel(ZYNQMP_DMA_IDS_DEFAULT_MASK,
+			       peer->regs + ZYNQMP_DMA_IDS);
+			ret = readl_poll_timeout_atomic(peer->regs +
+							ZYNQMP_DMA_STATUS, val,
+							FIELD_GET(ZYNQMP_DMA_STATE, val) !=
+							ZYNQMP_DMA_STATE_BUSY, 1,
+							ZYNQMP_DMA_IDLE_TIMEOUT_US);
+			if (ret)
+				dev_err(peer->dev, "Channel %p failed to go idle\n",
+					peer);
+			zynqmp_dma_init(peer);
+			peer->borrowed_by = NULL;
+		}
+		spin_unlock_irqrestore(&peer->lock, irqflags);
+	}
+}
+
+/**
+ * zynqmp_dma_get_peers - Collect the channels the transfers may run on
+ * @chan: ZynqMP DMA channel pointer
+ *
+ * A peer fetches the hw descriptors of @chan and moves buffers mapped for
+ * it, so only channels of the same bus width, coherency and without an
+ * IOMMU qualify. A device link keeps the peers powered while @chan is in
+ * use and unbinds @chan before any of them.
+ */
+static void zynqmp_dma_get_peers(struct zynqmp_dma_chan *chan)
+{
+	struct zynqmp_dma_chan *peer;
+	unsigned int nr = 0;
+
+	if (!spread_channels || device_iommu_mapped(chan->dev))
+		return;
+
+	mutex_lock(&zynqmp_dma_chans_lock);
+	list_for_each_entry(peer, &zynqmp_dma_chans, node)
+		nr++;
+
+	chan->peers = kcalloc(nr, sizeof(*chan->peers), GFP_KERNEL);
+	if (!chan->peers)
+		goto unlock;
+
+	list_for_each_entry(peer, &zynqmp_dma_chans, node) {
+		if (peer == chan || peer->bus_width != chan->bus_width ||
+		    peer->is_dmacoherent != chan->is_dmacoherent ||
+		    device_iommu_mapped(peer->dev))
+			continue;
+
+		if (!device_link_add(chan->dev, peer->dev,
+				     DL_FLAG_AUTOREMOVE_CONSUMER |
+				     DL_FLAG_PM_RUNTIME | DL_FLAG_RPM_ACTIVE))
+			continue;
+
+		chan->peers[chan->nr_peers++] = peer;
+	}
+
+unlock:
+	mutex_unlock(&zynqmp_dma_chans_lock);
+}
+
+/**
+ * zynqmp_dma_put_peers - Drop the channels the transfers may run on
+ * @chan: ZynqMP DMA channel pointer
+ */
+static void zynqmp_dma_put_peers(struct zynqmp_dma_chan *chan)
+{
+	unsigned int i;
+
+	zynqmp_dma_release_peers(chan);
+	for (i = 0; i < chan->nr_peers; i++)
+		device_link_remove(chan->dev, chan->peers[i]->dev);
+
+	kfree(chan->peers);
+	chan->peers = NULL;
+	chan->nr_peers = 0;
+}
+
 /**
  * zynqmp_dma_alloc_chan_resources - Allocate channel resources
  * @dchan: DMA channel
@@ -502,6 +680,8 @@ static int zynqmp_dma_alloc_chan_resources(struct dma_chan *dchan)
 		desc->dst_p = desc->src_p + ZYNQMP_DMA_DESC_SIZE(chan);
 	}
 
+	zynqmp_dma_get_peers(chan);
+
 	return ZYNQMP_DMA_NUM_DESCS;
 }
 
@@ -532,22 +712,50 @@ static void zynqmp_dma_handle_ovfl_int(struct zynqmp_dma_chan *chan, u32 status)
 		readl(chan->regs + ZYNQMP_DMA_IRQ_SRC_ACCT);
 }
 
-static void zynqmp_dma_config(struct zynqmp_dma_chan *chan)
+/**
+ * zynqmp_dma_config - Program the burst lengths of a channel
+ * @chan: ZynqMP DMA channel pointer whose burst lengths apply
+ * @hw: ZynqMP DMA channel pointer to program
+ */
+static void zynqmp_dma_config(struct zynqmp_dma_chan *chan,
+			      struct zynqmp_dma_chan *hw)
 {
 	u32 val, burst_val;
 
-	val = readl(chan->regs + ZYNQMP_DMA_CTRL0);
+	val = readl(hw->regs + ZYNQMP_DMA_CTRL0);
 	val |= ZYNQMP_DMA_POINT_TYPE_SG;
-	writel(val, chan->regs + ZYNQMP_DMA_CTRL0);
+	writel(val, hw->regs + ZYNQMP_DMA_CTRL0);
 
-	val = readl(chan->regs + ZYNQMP_DMA_DATA_ATTR);
+	val = readl(hw->regs + ZYNQMP_DMA_DATA_ATTR);
 	burst_val = __ilog2_u32(chan->src_burst_len);
 	val = (val & ~ZYNQMP_DMA_ARLEN) |
 		((burst_val << ZYNQMP_DMA_ARLEN_OFST) & ZYNQMP_DMA_ARLEN);
 	burst_val = __ilog2_u32(chan->dst_burst_len);
 	val = (val & ~ZYNQMP_DMA_AWLEN) |
 		((burst_val << ZYNQMP_DMA_AWLEN_OFST) & ZYNQMP_DMA_AWLEN);
-	writel(val, chan->regs + ZYNQMP_DMA_DATA_ATTR);
+	writel(val, hw->regs + ZYNQMP_DMA_DATA_ATTR);
+}
+
+/**
+ * zynqmp_dma_config_mode - Program the transfer mode of the next chain
+ * @chan: ZynqMP DMA channel pointer
+ * @desc: First transaction descriptor of the chain
+ */
+static void zynqmp_dma_config_mode(struct zynqmp_dma_chan *chan,
+				   struct zynqmp_dma_desc_sw *desc)
+{
+	u32 val;
+
+	val = readl(chan->regs + ZYNQMP_DMA_CTRL0);
+	val &= ~ZYNQMP_DMA_MODE;
+	if (desc->memset) {
+		val |= ZYNQMP_DMA_MODE_WR_ONLY;
+		writel(desc->memset_val, chan->regs + ZYNQMP_DMA_WR_ONLY_WORD0);
+		writel(desc->memset_val, chan->regs + ZYNQMP_DMA_WR_ONLY_WORD1);
+		writel(desc->memset_val, chan->regs + ZYNQMP_DMA_WR_ONLY_WORD2);
+		writel(desc->memset_val, chan->regs + ZYNQMP_DMA_WR_ONLY_WORD3);
+	}
+	writel(val, chan->regs + ZYNQMP_DMA_CTRL0);
 }
 
 /**
@@ -570,27 +778,90 @@ static int zynqmp_dma_device_config(struct dma_chan *dchan,
 	return 0;
 }
 
+/**
+ * zynqmp_dma_claim_peer - Find an idle peer to run the transfers of a channel
+ * @chan: ZynqMP DMA channel pointer
+ *
+ * The caller holds the lock of @chan. The lock of a peer is only tried, as
+ * two channels may be looking for each other.
+ *
+ * Return: The claimed peer with its lock held, NULL if none is idle
+ */
+static struct zynqmp_dma_chan *zynqmp_dma_claim_peer(struct zynqmp_dma_chan *chan)
+{
+	struct zynqmp_dma_chan *peer;
+	unsigned int i;
+
+	for (i = 0; i < chan->nr_peers; i++) {
+		peer = chan->peers[i];
+		if (!spin_trylock(&peer->lock))
+			continue;
+
+		if (peer->idle && !peer->borrowed_by && !peer->err &&
+		    list_empty(&peer->pending_list) &&
+		    list_empty(&peer->active_list)) {
+			peer->borrowed_by = chan;
+			return peer;
+		}
+
+		spin_unlock(&peer->lock);
+	}
+
+	return NULL;
+}
+
+/**
+ * zynqmp_dma_start_run - Start the leading run of pending transfers
+ * @chan: ZynqMP DMA channel pointer owning the transfers
+ * @hw: ZynqMP DMA channel pointer running them, @chan or one of its peers
+ */
+static void zynqmp_dma_start_run(struct zynqmp_dma_chan *chan,
+				 struct zynqmp_dma_chan *hw)
+{
+	struct zynqmp_dma_desc_sw *desc, *run, *next;
+
+	desc = list_first_entry(&chan->pending_list,
+				struct zynqmp_dma_desc_sw, node);
+
+	/* Only the leading run of compatible transfers is chained in hw */
+	list_for_each_entry_safe(run, next, &chan->pending_list, node) {
+		if (run != desc && !zynqmp_dma_desc_chained(chan, desc, run))
+			break;
+		run->hw = hw;
+		run->done = false;
+		trace_xilinx_dma_start(&run->async_tx);
+		list_move_tail(&run->node, &chan->active_list);
+	}
+
+	zynqmp_dma_config(chan, hw);
+	zynqmp_dma_config_mode(hw, desc);
+	zynqmp_dma_update_desc_to_ctrlr(hw, desc);
+	zynqmp_dma_start(hw);
+}
+
 /**
  * zynqmp_dma_start_transfer - Initiate the new transfer
  * @chan: ZynqMP DMA channel pointer
+ *
+ * The pending transfers which don't fit on @chan run on its idle peers.
  */
 static void zynqmp_dma_start_transfer(struct zynqmp_dma_chan *chan)
 {
-	struct zynqmp_dma_desc_sw *desc;
-
-	if (!chan->idle)
-		return;
+	struct zynqmp_dma_chan *peer;
 
-	zynqmp_dma_config(chan);
+	while (!list_empty(&chan->pending_list)) {
+		if (chan->idle && !chan->borrowed_by) {
+			zynqmp_dma_start_run(chan, chan);
+			continue;
+		}
 
-	desc = list_first_entry_or_null(&chan->pending_list,
-					struct zynqmp_dma_desc_sw, node);
-	if (!desc)
-		return;
+		peer = zynqmp_dma_claim_peer(chan);
+		if (!peer)
+			return;
 
-	list_splice_tail_init(&chan->pending_list, &chan->active_list);
-	zynqmp_dma_update_desc_to_ctrlr(chan, desc);
-	zynqmp_dma_start(chan);
+		zynqmp_dma_start_run(chan, peer);
+		spin_unlock(&peer->lock);
+	}
 }
 
 
@@ -609,13 +880,19 @@ static void zynqmp_dma_chan_desc_cleanup(struct zynqmp_dma_chan *chan)
 		struct dmaengine_desc_callback cb;
 
 		dmaengine_desc_get_callback(&desc->async_tx, &cb);
-		if (dmaengine_desc_callback_valid(&cb)) {
-			spin_unlock_irqrestore(&chan->lock, irqflags);
-			dmaengine_desc_callback_invoke(&cb, NULL);
-			spin_lock_irqsave(&chan->lock, irqflags);
-		}
+		spin_unlock_irqrestore(&chan->lock, irqflags);
+		trace_xilinx_dma_complete(&desc->async_tx);
+		dmaengine_desc_callback_invoke(&cb, NULL);
+		dma_descriptor_unmap(&desc->async_tx);
+
+		/*
+		 * Run any dependencies, they may be issued on this very
+		 * channel so the lock must not be held.
+		 */
+		dma_run_dependencies(&desc->async_tx);
+		spin_lock_irqsave(&chan->lock, irqflags);
 
-		/* Run any dependencies, then free the descriptor */
+		/* Then free the descriptor */
 		zynqmp_dma_free_descriptor(chan, desc);
 	}
 
@@ -625,18 +902,30 @@ static void zynqmp_dma_chan_desc_cleanup(struct zynqmp_dma_chan *chan)
 /**
  * zynqmp_dma_complete_descriptor - Mark the active descriptor as complete
  * @chan: ZynqMP DMA channel pointer
+ * @hw: ZynqMP DMA channel pointer which ran the descriptor
+ *
+ * The transfers run by the peers of @chan may finish out of order, they are
+ * completed in submission order.
  */
-static void zynqmp_dma_complete_descriptor(struct zynqmp_dma_chan *chan)
+static void zynqmp_dma_complete_descriptor(struct zynqmp_dma_chan *chan,
+					   struct zynqmp_dma_chan *hw)
 {
-	struct zynqmp_dma_desc_sw *desc;
+	struct zynqmp_dma_desc_sw *desc, *next;
 
-	desc = list_first_entry_or_null(&chan->active_list,
-					struct zynqmp_dma_desc_sw, node);
-	if (!desc)
-		return;
-	list_del(&desc->node);
-	dma_cookie_complete(&desc->async_tx);
-	list_add_tail(&desc->node, &chan->done_list);
+	list_for_each_entry(desc, &chan->active_list, node) {
+		if (desc->hw == hw && !desc->done) {
+			desc->done = true;
+			break;
+		}
+	}
+
+	list_for_each_entry_safe(desc, next, &chan->active_list, node) {
+		if (!desc->done)
+			break;
+		list_del(&desc->node);
+		dma_cookie_complete(&desc->async_tx);
+		list_add_tail(&desc->node, &chan->done_list);
+	}
 }
 
 /**
@@ -676,6 +965,7 @@ static void zynqmp_dma_free_chan_resources(struct dma_chan *dchan)
 {
 	struct zynqmp_dma_chan *chan = to_chan(dchan);
 
+	zynqmp_dma_put_peers(chan);
 	zynqmp_dma_free_descriptors(chan);
 	dma_free_coherent(chan->dev,
 		(2 * ZYNQMP_DMA_DESC_SIZE(chan) * ZYNQMP_DMA_NUM_DESCS),
@@ -696,9 +986,10 @@ static void zynqmp_dma_reset(struct zynqmp_dma_chan *chan)
 	writel(ZYNQMP_DMA_IDS_DEFAULT_MASK, chan->regs + ZYNQMP_DMA_IDS);
 
 	spin_lock_irqsave(&chan->lock, irqflags);
-	zynqmp_dma_complete_descriptor(chan);
+	zynqmp_dma_complete_descriptor(chan, chan);
 	spin_unlock_irqrestore(&chan->lock, irqflags);
 	zynqmp_dma_chan_desc_cleanup(chan);
+	zynqmp_dma_release_peers(chan);
 	zynqmp_dma_free_descriptors(chan);
 
 	zynqmp_dma_init(chan);
@@ -722,6 +1013,7 @@ static irqreturn_t zynqmp_dma_irq_handler(int irq, void *data)
 	status = isr & ~imr;
 
 	writel(isr, chan->regs + ZYNQMP_DMA_ISR);
+	trace_xilinx_dma_irq(&chan->common, status);
 	if (status & ZYNQMP_DMA_INT_DONE) {
 		tasklet_schedule(&chan->tasklet);
 		ret = IRQ_HANDLED;
@@ -753,30 +1045,49 @@ static irqreturn_t zynqmp_dma_irq_handler(int irq, void *data)
 static void zynqmp_dma_do_tasklet(struct tasklet_struct *t)
 {
 	struct zynqmp_dma_chan *chan = from_tasklet(chan, t, tasklet);
+	struct zynqmp_dma_chan *owner;
 	u32 count;
 	unsigned long irqflags;
 
-	if (chan->err) {
+	spin_lock_irqsave(&chan->lock, irqflags);
+	owner = chan->borrowed_by ? : chan;
+	spin_unlock_irqrestore(&chan->lock, irqflags);
+
+	if (chan->err && owner == chan) {
 		zynqmp_dma_reset(chan);
 		chan->err = false;
 		return;
 	}
 
-	spin_lock_irqsave(&chan->lock, irqflags);
+	spin_lock_irqsave(&owner->lock, irqflags);
 	count = readl(chan->regs + ZYNQMP_DMA_IRQ_DST_ACCT);
+	if (chan->err)
+		count = 1;
 	while (count) {
-		zynqmp_dma_complete_descriptor(chan);
+		zynqmp_dma_complete_descriptor(owner, chan);
 		count--;
 	}
-	spin_unlock_irqrestore(&chan->lock, irqflags);
+
+	/* The owner is always locked first, the peers only try theirs */
+	if (owner != chan && (chan->idle || chan->err)) {
+		spin_lock_nested(&chan->lock, SINGLE_DEPTH_NESTING);
+		if (chan->err)
+			zynqmp_dma_init(chan);
+		chan->borrowed_by = NULL;
+		chan->err = false;
+		spin_unlock(&chan->lock);
+	}
+	spin_unlock_irqrestore(&owner->lock, irqflags);
+
+	/* The callbacks of a channel only run from its own tasklet */
+	if (owner != chan)
+		tasklet_schedule(&owner->tasklet);
 
 	zynqmp_dma_chan_desc_cleanup(chan);
 
-	if (chan->idle) {
-		spin_lock_irqsave(&chan->lock, irqflags);
-		zynqmp_dma_start_transfer(chan);
-		spin_unlock_irqrestore(&chan->lock, irqflags);
-	}
+	spin_lock_irqsave(&chan->lock, irqflags);
+	zynqmp_dma_start_transfer(chan);
+	spin_unlock_irqrestore(&chan->lock, irqflags);
 }
 
 /**
@@ -790,6 +1101,7 @@ static int zynqmp_dma_device_terminate_all(struct dma_chan *dchan)
 	struct zynqmp_dma_chan *chan = to_chan(dchan);
 
 	writel(ZYNQMP_DMA_IDS_DEFAULT_MASK, chan->regs + ZYNQMP_DMA_IDS);
+	zynqmp_dma_release_peers(chan);
 	zynqmp_dma_free_descriptors(chan);
 
 	return 0;
@@ -802,44 +1114,61 @@ static int zynqmp_dma_device_terminate_all(struct dma_chan *dchan)
 static void zynqmp_dma_synchronize(struct dma_chan *dchan)
 {
 	struct zynqmp_dma_chan *chan = to_chan(dchan);
+	unsigned int i;
+
+	/* A peer may still be handing over the last completed transfers */
+	for (i = 0; i < chan->nr_peers; i++)
+		tasklet_kill(&chan->peers[i]->tasklet);
 
 	tasklet_kill(&chan->tasklet);
 }
 
 /**
- * zynqmp_dma_prep_memcpy - prepare descriptors for memcpy transaction
- * @dchan: DMA channel
- * @dma_dst: Destination buffer address
- * @dma_src: Source buffer address
- * @len: Transfer length
- * @flags: transfer ack flags
+ * zynqmp_dma_reserve_descs - Reserve sw descriptors for a new transfer
+ * @chan: ZynqMP DMA channel pointer
+ * @desc_cnt: Number of descriptors the transfer needs
  *
- * Return: Async transaction descriptor on success and NULL on failure
+ * Return: '0' on success and -ENOMEM if not enough descriptors are free
  */
-static struct dma_async_tx_descriptor *zynqmp_dma_prep_memcpy(
-				struct dma_chan *dchan, dma_addr_t dma_dst,
-				dma_addr_t dma_src, size_t len, ulong flags)
+static int zynqmp_dma_reserve_descs(struct zynqmp_dma_chan *chan,
+				    size_t desc_cnt)
 {
-	struct zynqmp_dma_chan *chan;
-	struct zynqmp_dma_desc_sw *new, *first = NULL;
-	void *desc = NULL, *prev = NULL;
-	size_t copy;
-	u32 desc_cnt;
 	unsigned long irqflags;
 
-	chan = to_chan(dchan);
-
-	desc_cnt = DIV_ROUND_UP(len, ZYNQMP_DMA_MAX_TRANS_LEN);
-
 	spin_lock_irqsave(&chan->lock, irqflags);
 	if (desc_cnt > chan->desc_free_cnt) {
 		spin_unlock_irqrestore(&chan->lock, irqflags);
 		dev_dbg(chan->dev, "chan %p descs are not available\n", chan);
-		return NULL;
+		return -ENOMEM;
 	}
 	chan->desc_free_cnt = chan->desc_free_cnt - desc_cnt;
 	spin_unlock_irqrestore(&chan->lock, irqflags);
 
+	return 0;
+}
+
+/**
+ * zynqmp_dma_prep_linear - prepare a chain of descriptors for a linear transfer
+ * @chan: ZynqMP DMA channel pointer
+ * @dma_dst: Destination buffer address
+ * @dma_src: Source buffer address, unused by memset transfers
+ * @len: Transfer length
+ * @flags: transfer ack flags
+ *
+ * Return: First sw descriptor of the chain on success and NULL on failure
+ */
+static struct zynqmp_dma_desc_sw *
+zynqmp_dma_prep_linear(struct zynqmp_dma_chan *chan, dma_addr_t dma_dst,
+		       dma_addr_t dma_src, size_t len, ulong flags)
+{
+	struct zynqmp_dma_desc_sw *new, *first = NULL;
+	void *desc = NULL, *prev = NULL;
+	size_t copy;
+
+	if (zynqmp_dma_reserve_descs(chan, DIV_ROUND_UP(len,
+					ZYNQMP_DMA_MAX_TRANS_LEN)))
+		return NULL;
+
 	do {
 		/* Allocate and populate the descriptor */
 		new = zynqmp_dma_get_descriptor(chan);
@@ -861,6 +1190,140 @@ static struct dma_async_tx_descriptor *zynqmp_dma_prep_memcpy(
 	zynqmp_dma_desc_config_eod(chan, desc);
 	async_tx_ack(&first->async_tx);
 	first->async_tx.flags = (enum dma_ctrl_flags)flags;
+	trace_xilinx_dma_prep(&first->async_tx);
+	return first;
+}
+
+/**
+ * zynqmp_dma_prep_memcpy - prepare descriptors for memcpy transaction
+ * @dchan: DMA channel
+ * @dma_dst: Destination buffer address
+ * @dma_src: Source buffer address
+ * @len: Transfer length
+ * @flags: transfer ack flags
+ *
+ * Return: Async transaction descriptor on success and NULL on failure
+ */
+static struct dma_async_tx_descriptor *zynqmp_dma_prep_memcpy(
+				struct dma_chan *dchan, dma_addr_t dma_dst,
+				dma_addr_t dma_src, size_t len, ulong flags)
+{
+	struct zynqmp_dma_desc_sw *first;
+
+	first = zynqmp_dma_prep_linear(to_chan(dchan), dma_dst, dma_src, len,
+				       flags);
+	if (!first)
+		return NULL;
+
+	return &first->async_tx;
+}
+
+/**
+ * zynqmp_dma_prep_memset - prepare descriptors for memset transaction
+ * @dchan: DMA channel
+ * @dma_dst: Destination buffer address
+ * @value: Byte value to fill the buffer with
+ * @len: Transfer length
+ * @flags: transfer ack flags
+ *
+ * The channel runs in write-only mode for the transfer and replicates
+ * the pattern from the WR_ONLY_WORD registers over the destination.
+ *
+ * Return: Async transaction descriptor on success and NULL on failure
+ */
+static struct dma_async_tx_descriptor *zynqmp_dma_prep_memset(
+				struct dma_chan *dchan, dma_addr_t dma_dst,
+				int value, size_t len, ulong flags)
+{
+	struct zynqmp_dma_desc_sw *first;
+
+	first = zynqmp_dma_prep_linear(to_chan(dchan), dma_dst, 0, len, flags);
+	if (!first)
+		return NULL;
+
+	first->memset = true;
+	first->memset_val = (value & 0xff) * 0x01010101;
+
+	return &first->async_tx;
+}
+
+/**
+ * zynqmp_dma_prep_interleaved - prepare descriptors for a 2D transaction
+ * @dchan: DMA channel
+ * @xt: Interleaved template pointer
+ * @flags: transfer ack flags
+ *
+ * Every chunk of every frame gets its own hw descriptor pair, and the whole
+ * pattern is linked into one chain that completes with a single interrupt.
+ *
+ * Return: Async transaction descriptor on success and NULL on failure
+ */
+static struct dma_async_tx_descriptor *
+zynqmp_dma_prep_interleaved(struct dma_chan *dchan,
+			    struct dma_interleaved_template *xt,
+			    unsigned long flags)
+{
+	struct zynqmp_dma_chan *chan = to_chan(dchan);
+	struct zynqmp_dma_desc_sw *new, *first = NULL;
+	void *desc = NULL, *prev = NULL;
+	dma_addr_t src, dst;
+	size_t desc_cnt = 0, len, copy, i, frame;
+
+	if (xt->dir != DMA_MEM_TO_MEM || !xt->numf || !xt->frame_size)
+		return NULL;
+
+	for (i = 0; i < xt->frame_size; i++) {
+		if (!xt->sgl[i].size)
+			return NULL;
+		desc_cnt += DIV_ROUND_UP(xt->sgl[i].size,
+					 ZYNQMP_DMA_MAX_TRANS_LEN);
+	}
+
+	if (desc_cnt > ZYNQMP_DMA_NUM_DESCS / xt->numf)
+		return NULL;
+
+	if (zynqmp_dma_reserve_descs(chan, desc_cnt * xt->numf))
+		return NULL;
+
+	src = xt->src_start;
+	dst = xt->dst_start;
+
+	for (frame = 0; frame < xt->numf; frame++) {
+		for (i = 0; i < xt->frame_size; i++) {
+			struct data_chunk *chunk = &xt->sgl[i];
+			dma_addr_t chunk_src = src, chunk_dst = dst;
+
+			for (len = chunk->size; len; len -= copy) {
+				new = zynqmp_dma_get_descriptor(chan);
+
+				copy = min_t(size_t, len,
+					     ZYNQMP_DMA_MAX_TRANS_LEN);
+				desc = (struct zynqmp_dma_desc_ll *)new->src_v;
+				zynqmp_dma_config_sg_ll_desc(chan, desc,
+							     chunk_src,
+							     chunk_dst, copy,
+							     prev);
+				prev = desc;
+				if (xt->src_inc)
+					chunk_src += copy;
+				if (xt->dst_inc)
+					chunk_dst += copy;
+				if (!first)
+					first = new;
+				else
+					list_add_tail(&new->node,
+						      &first->tx_list);
+			}
+
+			src = chunk_src + dmaengine_get_src_icg(xt, chunk);
+			dst = chunk_dst + dmaengine_get_dst_icg(xt, chunk);
+		}
+	}
+
+	zynqmp_dma_desc_config_eod(chan, desc);
+	async_tx_ack(&first->async_tx);
+	first->async_tx.flags = (enum dma_ctrl_flags)flags;
+	trace_xilinx_dma_prep(&first->async_tx);
 	return &first->async_tx;
 }
 
@@ -1068,9 +1531,13 @@ static int zynqmp_dma_probe(struct platform_device *pdev)
 		return ret;
 	}
 	dma_cap_set(DMA_MEMCPY, zdev->common.cap_mask);
+	dma_cap_set(DMA_MEMSET, zdev->common.cap_mask);
+	dma_cap_set(DMA_INTERLEAVE, zdev->common.cap_mask);
 
 	p = &zdev->common;
 	p->device_prep_dma_memcpy = zynqmp_dma_prep_memcpy;
+	p->device_prep_dma_memset = zynqmp_dma_prep_memset;
+	p->device_prep_interleaved_dma = zynqmp_dma_prep_interleaved;
 	p->device_terminate_all = zynqmp_dma_device_terminate_all;
 	p->device_synchronize = zynqmp_dma_synchronize;
 	p->device_issue_pending = zynqmp_dma_issue_pending;
@@ -1128,6 +1595,10 @@ static int zynqmp_dma_probe(struct platform_device *pdev)
 		goto free_chan_resources;
 	}
 
+	mutex_lock(&zynqmp_dma_chans_lock);
+	list_add_tail(&zdev->chan->node, &zynqmp_dma_chans);
+	mutex_unlock(&zynqmp_dma_chans_lock);
+
 	pm_runtime_mark_last_busy(zdev->dev);
 	pm_runtime_put_sync_autosuspend(zdev->dev);
 
@@ -1152,6 +1623,10 @@ static int zynqmp_dma_remove(struct platform_device *pdev)
 {
 	struct zynqmp_dma_device *zdev = platform_get_drvdata(pdev);
 
+	mutex_lock(&zynqmp_dma_chans_lock);
+	list_del(&zdev->chan->node);
+	mutex_unlock(&zynqmp_dma_chans_lock);
+
 	of_dma_controller_free(pdev->dev.of_node);
 	dma_async_device_unregister(&zdev->common);
 
@@ -21,7 +21,9 @@
 #include <linux/module.h>
 #include <linux/of.h>
 #include <linux/of_platform.h>
+#include <linux/rculist.h>
 #include <linux/slab.h>
+#include <linux/spinlock.h>
 #include <linux/uaccess.h>
 #include <linux/hashtable.h>
 
@@ -49,6 +51,8 @@
 
 static bool feature_check_enabled;
 static DEFINE_HASHTABLE(pm_api_features_map, PM_API_FEATURE_CHECK_MAX_ORDER);
+/* Serializes the pm_api_features_map updates, lookups only need RCU */
+static DEFINE_SPINLOCK(pm_api_features_lock);
 static u32 ioctl_features[FEATURE_PAYLOAD_SIZE];
 static u32 query_features[FEATURE_PAYLOAD_SIZE];
 static u32 get_op_char_features[FEATURE_PAYLOAD_SIZE];
@@ -73,11 +77,13 @@ struct zynqmp_devinfo {
  * @pm_api_id:		PM API Id, used as key to index into hashmap
  * @feature_status:	status of PM API feature: valid, invalid
  * @hentry:		hlist_node that hooks this entry into hashtable
+ * @rcu:		RCU head used to free the entry
  */
 struct pm_api_feature_data {
 	u32 pm_api_id;
 	int feature_status;
 	struct hlist_node hentry;
+	struct rcu_head rcu;
 };
 
 static const struct mfd_cell firmware_devs[] = {
@@ -230,18 +236,35 @@ static int __do_feature_check_call(const u32 api_id, u32 *ret_payload)
 	return ret;
 }
 
+static struct pm_api_feature_data *feature_check_lookup(const u32 api_id)
+{
+	struct pm_api_feature_data *feature_data;
+
+	hash_for_each_possible_rcu(pm_api_features_map, feature_data, hentry,
+				   api_id) {
+		if (feature_data->pm_api_id == api_id)
+			return feature_data;
+	}
+
+	return NULL;
+}
+
 static int do_feature_check_call(const u32 api_id)
 {
 	int ret;
 	u32 ret_payload[PAYLOAD_ARG_CNT];
-	struct pm_api_feature_data *feature_data;
+	struct pm_api_feature_data *feature_data, *old;
+	unsigned long flags;
 
 	/* Check for existing entry in hash table for given api */
-	hash_for_each_possible(pm_api_features_map, feature_data, hentry,
-			       api_id) {
-		if (feature_data->pm_api_id == api_id)
-			return feature_data->feature_status;
+	rcu_read_lock();
+	feature_data = feature_check_lookup(api_id);
+	if (feature_data) {
+		ret = feature_data->feature_status;
+		rcu_read_unlock();
+		return ret;
 	}
+	rcu_read_unlock();
 
 	/* Add new entry if not present */
 	feature_data = kmalloc(sizeof(*feature_data), GFP_KERNEL);
@@ -252,8 +275,18 @@ static int do_feature_check_call(const u32 api_id)
 	ret = __do_feature_check_call(api_id, ret_payload);
 
 	feature_data->feature_status = ret;
-	hash_add(pm_api_features_map, &feature_data->hentry, api_id);
 
+	spin_lock_irqsave(&pm_api_features_lock, flags);
+	/* Another caller may have added the entry meanwhile */
+	old = feature_check_lookup(api_id);
+	if (old) {
+		ret = old->feature_status;
+		spin_unlock_irqrestore(&pm_api_features_lock, flags);
+		kfree(feature_data);
+		return ret;
+	}
+
+	/* Store the masks before the entry is visible to lockless readers */
 	if (api_id == PM_IOCTL)
 		/* Store supported IOCTL IDs mask */
 		memcpy(ioctl_features, &ret_payload[2], FEATURE_PAYLOAD_SIZE * 4);
@@ -264,6 +297,9 @@ static int do_feature_check_call(const u32 api_id)
 		/* Store supported GET_OP_CHAR IDs mask */
 		memcpy(get_op_char_features, &ret_payload[2], FEATURE_PAYLOAD_SIZE * 4);
 
+	hash_add_rcu(pm_api_features_map, &feature_data->hentry, api_id);
+	spin_unlock_irqrestore(&pm_api_features_lock, flags);
+
 	return ret;
 }
 
@@ -344,6 +380,25 @@ int zynqmp_pm_is_function_supported(const u32 api_id, const u32 id)
 }
 EXPORT_SYMBOL_GPL(zynqmp_pm_is_function_supported);
 
+static int __zynqmp_pm_invoke_fn(u32 pm_api_id, u32 arg0, u32 arg1,
+				 u32 arg2, u32 arg3, u32 arg4,
+				 u32 *ret_payload)
+{
+	/*
+	 * Added SIP service call Function Identifier
+	 * Make sure to stay in x0 register
+	 */
+	u64 smc_arg[4];
+
+	smc_arg[0] = PM_SIP_SVC | pm_api_id;
+	smc_arg[1] = ((u64)arg1 << 32) | arg0;
+	smc_arg[2] = ((u64)arg3 << 32) | arg2;
+	smc_arg[3] = ((u64)arg4);
+
+	return do_fw_call(smc_arg[0], smc_arg[1], smc_arg[2], smc_arg[3],
+			  ret_payload);
+}
+
 /**
  * zynqmp_pm_invoke_fn() - Invoke the system-level platform management layer
  *			   caller function depending on the configuration
@@ -374,11 +429,6 @@ int zynqmp_pm_invoke_fn(u32 pm_api_id, u32 arg0, u32 arg1,
 			u32 arg2, u32 arg3, u32 arg4,
 			u32 *ret_payload)
 {
-	/*
-	 * Added SIP service call Function Identifier
-	 * Make sure to stay in x0 register
-	 */
-	u64 smc_arg[4];
 	int ret;
 
 	/* Check if feature is supported or not */
@@ -386,14 +436,52 @@ int zynqmp_pm_invoke_fn(u32 pm_api_id, u32 arg0, u32 arg1,
 	if (ret < 0)
 		return ret;
 
-	smc_arg[0] = PM_SIP_SVC | pm_api_id;
-	smc_arg[1] = ((u64)arg1 << 32) | arg0;
-	smc_arg[2] = ((u64)arg3 << 32) | arg2;
-	smc_arg[3] = ((u64)arg4);
+	return __zynqmp_pm_invoke_fn(pm_api_id, arg0, arg1, arg2, arg3, arg4,
+				     ret_payload);
+}
 
-	return do_fw_call(smc_arg[0], smc_arg[1], smc_arg[2], smc_arg[3],
-			  ret_payload);
+/**
+ * zynqmp_pm_invoke_batch() - Invoke a sequence of PM-API calls
+ * @calls:		PM-API calls, in the order they are issued
+ * @num_calls:		Number of PM-API calls
+ *
+ * All the calls are checked against the supported features before the
+ * first one is issued, so an unsupported call does not leave the sequence
+ * half done. The calls are then issued back to back, the calls after a
+ * failing one are not issued.
+ *
+ * The firmware interface takes one PM-API call per SMC, there is no call
+ * packing multiple operations into a single IPI payload, so each call still
+ * traps to the firmware.
+ *
+ * Return: Returns status of the first failing call or 0 if all succeeded
+ */
+int zynqmp_pm_invoke_batch(const struct zynqmp_pm_call *calls,
+			   unsigned int num_calls)
+{
+	const struct zynqmp_pm_call *call;
+	unsigned int i;
+	int ret;
+
+	for (i = 0; i < num_calls; i++) {
+		ret = zynqmp_pm_feature(calls[i].pm_api_id);
+		if (ret < 0)
+			return ret;
+	}
+
+	for (i = 0; i < num_calls; i++) {
+		call = &calls[i];
+		ret = __zynqmp_pm_invoke_fn(call->pm_api_id, call->args[0],
+					    call->args[1], call->args[2],
+					    call->args[3], call->args[4],
+					    call->ret_payload);
+		if (ret)
+			return ret;
+	}
+
+	return 0;
 }
+EXPORT_SYMBOL_GPL(zynqmp_pm_invoke_batch);
 
 static u32 pm_api_version;
 static u32 pm_tz_version;
@@ -3282,10 +3370,12 @@ static int zynqmp_firmware_remove(struct platform_device *pdev)
 	mfd_remove_devices(&pdev->dev);
 	zynqmp_pm_api_debugfs_exit();
 
+	spin_lock_irq(&pm_api_features_lock);
 	hash_for_each_safe(pm_api_features_map, i, tmp, feature_data, hentry) {
-		hash_del(&feature_data->hentry);
-		kfree(feature_data);
+		hash_del_rcu(&feature_data->hentry);
+		kfree_rcu(feature_data, rcu);
 	}
+	spin_unlock_irq(&pm_api_features_lock);
 
 	platform_device_unregister(em_dev);
 
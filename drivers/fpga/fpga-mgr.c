@@ -141,6 +141,7 @@ void fpga_image_info_free(struct fpga_image_info *info)
 		return;
 
 	dev = info->dev;
+	release_firmware(info->fw);
 	if (info->firmware_name)
 		devm_kfree(dev, info->firmware_name);
 
@@ -462,42 +463,23 @@ static int fpga_mgr_buf_load_mapped(struct fpga_manager *mgr,
 }
 
 /**
- * fpga_mgr_buf_load - load fpga from image in buffer
- * @mgr:	fpga manager
- * @info:	fpga image info
- * @buf:	buffer contain fpga image
+ * fpga_mgr_buf_to_sgt - describe a kernel buffer with a scatter list
+ * @buf:	linear or vmalloc kernel buffer
  * @count:	byte count of buf
+ * @sgt:	scatterlist table to fill, to be freed with sg_free_table()
  *
- * Step the low level fpga manager through the device-specific steps of getting
- * an FPGA ready to be configured, writing the image to it, then doing whatever
- * post-configuration steps necessary.  This code assumes the caller got the
- * mgr pointer from of_fpga_mgr_get() and checked that it is not an error code.
+ * Physically contiguous pages of @buf are merged in a single entry.
  *
  * Return: 0 on success, negative error code otherwise.
  */
-static int fpga_mgr_buf_load(struct fpga_manager *mgr,
-			     struct fpga_image_info *info,
-			     const char *buf, size_t count)
+int fpga_mgr_buf_to_sgt(const char *buf, size_t count, struct sg_table *sgt)
 {
 	struct page **pages;
-	struct sg_table sgt;
 	const void *p;
 	int nr_pages;
 	int index;
 	int rc;
 
-	/*
-	 * This is just a fast path if the caller has already created a
-	 * contiguous kernel buffer and the driver doesn't require SG, non-SG
-	 * drivers will still work on the slow path.
-	 */
-	if (mgr->mops->write)
-		return fpga_mgr_buf_load_mapped(mgr, info, buf, count);
-
-	/*
-	 * Convert the linear kernel pointer into a sg_table of pages for use
-	 * by the driver.
-	 */
 	nr_pages = DIV_ROUND_UP((unsigned long)buf + count, PAGE_SIZE) -
 		   (unsigned long)buf / PAGE_SIZE;
 	pages = kmalloc_array(nr_pages, sizeof(struct page *), GFP_KERNEL);
@@ -521,9 +503,48 @@ static int fpga_mgr_buf_load(struct fpga_manager *mgr,
 	 * The temporary pages list is used to code share the merging algorithm
 	 * in sg_alloc_table_from_pages
 	 */
-	rc = sg_alloc_table_from_pages(&sgt, pages, index, offset_in_page(buf),
+	rc = sg_alloc_table_from_pages(sgt, pages, index, offset_in_page(buf),
 				       count, GFP_KERNEL);
 	kfree(pages);
+
+	return rc;
+}
+EXPORT_SYMBOL_GPL(fpga_mgr_buf_to_sgt);
+
+/**
+ * fpga_mgr_buf_load - load fpga from image in buffer
+ * @mgr:	fpga manager
+ * @info:	fpga image info
+ * @buf:	buffer contain fpga image
+ * @count:	byte count of buf
+ *
+ * Step the low level fpga manager through the device-specific steps of getting
+ * an FPGA ready to be configured, writing the image to it, then doing whatever
+ * post-configuration steps necessary.  This code assumes the caller got the
+ * mgr pointer from of_fpga_mgr_get() and checked that it is not an error code.
+ *
+ * Return: 0 on success, negative error code otherwise.
+ */
+static int fpga_mgr_buf_load(struct fpga_manager *mgr,
+			     struct fpga_image_info *info,
+			     const char *buf, size_t count)
+{
+	struct sg_table sgt;
+	int rc;
+
+	/*
+	 * This is just a fast path if the caller has already created a
+	 * contiguous kernel buffer and the driver doesn't require SG, non-SG
+	 * drivers will still work on the slow path.
+	 */
+	if (mgr->mops->write)
+		return fpga_mgr_buf_load_mapped(mgr, info, buf, count);
+
+	/*
+	 * Convert the linear kernel pointer into a sg_table of pages for use
+	 * by the driver.
+	 */
+	rc = fpga_mgr_buf_to_sgt(buf, count, &sgt);
 	if (rc)
 		return rc;
 
@@ -597,6 +618,11 @@ static int fpga_mgr_firmware_load(struct fpga_manager *mgr,
 	info->flags = mgr->flags;
 	memcpy(info->key, mgr->key, ENCRYPTED_KEY_LEN);
 
+	/* A preloaded image is already in memory */
+	if (info->fw)
+		return fpga_mgr_buf_load(mgr, info, info->fw->data,
+					 info->fw->size);
+
 	ret = request_firmware(&fw, image_name, dev);
 	if (ret) {
 		mgr->state = FPGA_MGR_STATE_FIRMWARE_REQ_ERR;
@@ -612,6 +638,57 @@ static int fpga_mgr_firmware_load(struct fpga_manager *mgr,
 	return ret;
 }
 
+/**
+ * fpga_mgr_preload - read and check an FPGA image ahead of loading it
+ * @mgr:	fpga manager
+ * @info:	fpga image information, with firmware_name set
+ *
+ * Request the image named by @info and check its header, then keep the image
+ * in @info until fpga_image_info_free(). A later fpga_mgr_load() of @info
+ * writes it out without going to the filesystem. It does not touch the FPGA,
+ * so it can be called while the manager is busy programming another image.
+ *
+ * Return: 0 on success, negative error code otherwise.
+ */
+int fpga_mgr_preload(struct fpga_manager *mgr, struct fpga_image_info *info)
+{
+	struct device *dev = &mgr->dev;
+	const struct firmware *fw;
+	size_t header_size;
+	int ret;
+
+	if (!info->firmware_name || mgr->flags & FPGA_MGR_CONFIG_DMA_BUF)
+		return -EINVAL;
+
+	if (info->fw)
+		return 0;
+
+	ret = request_firmware(&fw, info->firmware_name, dev);
+	if (ret) {
+		dev_err(dev, "Error requesting firmware %s\n",
+			info->firmware_name);
+		return ret;
+	}
+
+	/* The header is parsed again on load, only check it here */
+	header_size = info->header_size;
+	info->header_size = mgr->mops->initial_header_size;
+	ret = fpga_mgr_parse_header(mgr, info, fw->data, fw->size);
+	if (!ret && info->header_size + info->data_size > fw->size)
+		ret = -EINVAL;
+	info->header_size = header_size;
+	if (ret) {
+		dev_err(dev, "Error while parsing FPGA image header\n");
+		release_firmware(fw);
+		return ret;
+	}
+
+	info->fw = fw;
+
+	return 0;
+}
+EXPORT_SYMBOL_GPL(fpga_mgr_preload);
+
 /**
  * fpga_mgr_load - load FPGA from scatter/gather table, buffer, or firmware
  * @mgr:	fpga manager
@@ -911,7 +988,13 @@ static int fpga_mgr_read(struct seq_file *s, void *data)
 
 static int fpga_mgr_read_open(struct inode *inode, struct file *file)
 {
-	return single_open(file, fpga_mgr_read, inode->i_private);
+	struct fpga_manager *mgr = inode->i_private;
+	size_t size = PAGE_SIZE;
+
+	if (mgr->mops->read_size)
+		size = max(size, mgr->mops->read_size(mgr));
+
+	return single_open_size(file, fpga_mgr_read, mgr, size);
 }
 
 static const struct file_operations fpga_mgr_ops_image = {
@@ -0,0 +1,484 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * FPGA Region - perf PMU support for counters inside regions
+ *
+ * Copyright (C) 2023 Xilinx, Inc.
+ *
+ * Accelerators loaded into a region often carry free running counters of
+ * their own, or sit behind a bus monitor. A provider describes those
+ * counters and gets a perf PMU named after the region holding it, so all
+ * of them are profiled the same way with perf stat. Like the DFL FME perf
+ * counters they are shared system wide: events are counting only, bound
+ * to one CPU, and narrow counters are polled to fold in their wraps.
+ */
+
+#include <linux/cpuhotplug.h>
+#include <linux/fpga/fpga-region.h>
+#include <linux/fpga/fpga-region-perf.h>
+#include <linux/hrtimer.h>
+#include <linux/module.h>
+#include <linux/of.h>
+#include <linux/perf_event.h>
+#include <linux/slab.h>
+
+static unsigned int region_perf_poll_ms = 100;
+module_param_named(poll_period_ms, region_perf_poll_ms, uint, 0644);
+MODULE_PARM_DESC(poll_period_ms, "Polling period of narrow counters in milliseconds");
+
+static enum cpuhp_state region_perf_cpuhp_state;
+
+/**
+ * struct fpga_region_perf - region perf instance
+ * @pmu: perf PMU
+ * @dev: provider device
+ * @info: provider description
+ * @cpu: active CPU to which the PMU is bound for accesses
+ * @node: node for CPU hotplug notifier link
+ * @hrtimer: timer polling the narrow counters
+ * @active: events on counters narrower than 64 bits
+ * @attrs: NULL terminated event attributes, one per counter
+ * @events_group: "events" attribute group
+ * @groups: attribute groups of the PMU
+ */
+struct fpga_region_perf {
+	struct pmu pmu;
+	struct device *dev;
+	struct fpga_region_perf_info info;
+	unsigned int cpu;
+	struct hlist_node node;
+	struct hrtimer hrtimer;
+	struct list_head active;
+	struct attribute **attrs;
+	struct attribute_group events_group;
+	const struct attribute_group *groups[4];
+};
+
+#define to_region_perf(_pmu)	container_of(_pmu, struct fpga_region_perf, pmu)
+
+static ssize_t cpumask_show(struct device *dev,
+			    struct device_attribute *attr, char *buf)
+{
+	struct pmu *pmu = dev_get_drvdata(dev);
+	struct fpga_region_perf *perf = to_region_perf(pmu);
+
+	return cpumap_print_to_pagebuf(true, buf, cpumask_of(perf->cpu));
+}
+static DEVICE_ATTR_RO(cpumask);
+
+static struct attribute *region_perf_cpumask_attrs[] = {
+	&dev_attr_cpumask.attr,
+	NULL,
+};
+
+static const struct attribute_group region_perf_cpumask_group = {
+	.attrs = region_perf_cpumask_attrs,
+};
+
+PMU_FORMAT_ATTR(event, "config:0-15");
+
+static struct attribute *region_perf_format_attrs[] = {
+	&format_attr_event.attr,
+	NULL,
+};
+
+static const struct attribute_group region_perf_format_group = {
+	.name = "format",
+	.attrs = region_perf_format_attrs,
+};
+
+/**
+ * fpga_region_perf_priv - get the private data of a region counter provider
+ * @perf: region perf instance
+ *
+ * Return: the @priv passed at registration.
+ */
+void *fpga_region_perf_priv(struct fpga_region_perf *perf)
+{
+	return perf->info.priv;
+}
+EXPORT_SYMBOL_GPL(fpga_region_perf_priv);
+
+static u64 region_perf_mask(struct fpga_region_perf *perf, unsigned int idx)
+{
+	u32 width = perf->info.counters[idx].width;
+
+	return width < 64 ? GENMASK_ULL(width - 1, 0) : U64_MAX;
+}
+
+static void region_perf_event_update(struct perf_event *event)
+{
+	struct fpga_region_perf *perf = to_region_perf(event->pmu);
+	struct hw_perf_event *hwc = &event->hw;
+	u64 prev, now;
+
+	do {
+		prev = local64_read(&hwc->prev_count);
+		now = perf->info.ops->read_counter(perf, hwc->idx);
+	} while (local64_xchg(&hwc->prev_count, now) != prev);
+
+	local64_add((now - prev) & region_perf_mask(perf, hwc->idx),
+		    &event->count);
+}
+
+static ktime_t region_perf_period(void)
+{
+	return ms_to_ktime(max(region_perf_poll_ms, 1U));
+}
+
+static enum hrtimer_restart region_perf_hrtimer(struct hrtimer *hrtimer)
+{
+	struct fpga_region_perf *perf;
+	struct perf_event *event;
+	unsigned long flags;
+
+	perf = container_of(hrtimer, struct fpga_region_perf, hrtimer);
+
+	local_irq_save(flags);
+	list_for_each_entry(event, &perf->active, active_entry)
+		if (!(event->hw.state & PERF_HES_STOPPED))
+			region_perf_event_update(event);
+	local_irq_restore(flags);
+
+	hrtimer_forward_now(hrtimer, region_perf_period());
+
+	return HRTIMER_RESTART;
+}
+
+static void region_perf_event_destroy(struct perf_event *event)
+{
+	struct fpga_region_perf *perf = to_region_perf(event->pmu);
+
+	if (perf->info.ops->event_destroy)
+		perf->info.ops->event_destroy(perf, event->hw.idx);
+}
+
+static int region_perf_event_init(struct perf_event *event)
+{
+	struct fpga_region_perf *perf = to_region_perf(event->pmu);
+	struct hw_perf_event *hwc = &event->hw;
+	u64 idx = event->attr.config;
+	int ret;
+
+	/* test the event attr type check for PMU enumeration */
+	if (event->attr.type != event->pmu->type)
+		return -ENOENT;
+
+	/*
+	 * region counters are shared across all cores.
+	 * Therefore, it does not support per-process mode.
+	 * Also, it does not support event sampling mode.
+	 */
+	if (is_sampling_event(event) || event->attach_state & PERF_ATTACH_TASK)
+		return -EINVAL;
+
+	if (event->cpu < 0)
+		return -EINVAL;
+
+	if (idx >= perf->info.num_counters)
+		return -EINVAL;
+
+	if (perf->info.ops->event_init) {
+		ret = perf->info.ops->event_init(perf, idx);
+		if (ret)
+			return ret;
+	}
+
+	event->cpu = perf->cpu;
+	event->destroy = region_perf_event_destroy;
+	hwc->idx = idx;
+
+	return 0;
+}
+
+static void region_perf_event_start(struct perf_event *event, int flags)
+{
+	struct fpga_region_perf *perf = to_region_perf(event->pmu);
+	struct hw_perf_event *hwc = &event->hw;
+
+	local64_set(&hwc->prev_count, perf->info.ops->read_counter(perf, hwc->idx));
+	hwc->state = 0;
+}
+
+static void region_perf_event_stop(struct perf_event *event, int flags)
+{
+	struct hw_perf_event *hwc = &event->hw;
+
+	if (hwc->state & PERF_HES_STOPPED)
+		return;
+
+	region_perf_event_update(event);
+	hwc->state |= PERF_HES_STOPPED | PERF_HES_UPTODATE;
+}
+
+static int region_perf_event_add(struct perf_event *event, int flags)
+{
+	struct fpga_region_perf *perf = to_region_perf(event->pmu);
+	struct hw_perf_event *hwc = &event->hw;
+
+	hwc->state = PERF_HES_STOPPED | PERF_HES_UPTODATE;
+
+	if (region_perf_mask(perf, hwc->idx) != U64_MAX) {
+		if (list_empty(&perf->active))
+			hrtimer_start(&perf->hrtimer, region_perf_period(),
+				      HRTIMER_MODE_REL_PINNED);
+		list_add_tail(&event->active_entry, &perf->active);
+	}
+
+	if (flags & PERF_EF_START)
+		region_perf_event_start(event, flags);
+
+	return 0;
+}
+
+static void region_perf_event_del(struct perf_event *event, int flags)
+{
+	struct fpga_region_perf *perf = to_region_perf(event->pmu);
+
+	region_perf_event_stop(event, PERF_EF_UPDATE);
+
+	if (region_perf_mask(perf, event->hw.idx) != U64_MAX) {
+		list_del(&event->active_entry);
+		if (list_empty(&perf->active))
+			hrtimer_cancel(&perf->hrtimer);
+	}
+}
+
+static int region_perf_offline_cpu(unsigned int cpu, struct hlist_node *node)
+{
+	struct fpga_region_perf *perf;
+	int target;
+
+	perf = hlist_entry_safe(node, struct fpga_region_perf, node);
+
+	if (cpu != perf->cpu)
+		return 0;
+
+	target = cpumask_any_but(cpu_online_mask, cpu);
+	if (target >= nr_cpu_ids)
+		return 0;
+
+	perf->cpu = target;
+	perf_pmu_migrate_context(&perf->pmu, cpu, target);
+
+	return 0;
+}
+
+static int region_perf_create_events(struct fpga_region_perf *perf)
+{
+	struct perf_pmu_events_attr *attr;
+	unsigned int i;
+
+	perf->attrs = devm_kcalloc(perf->dev, perf->info.num_counters + 1,
+				   sizeof(*perf->attrs), GFP_KERNEL);
+	attr = devm_kcalloc(perf->dev, perf->info.num_counters, sizeof(*attr),
+			    GFP_KERNEL);
+	if (!perf->attrs || !attr)
+		return -ENOMEM;
+
+	for (i = 0; i < perf->info.num_counters; i++, attr++) {
+		const struct fpga_region_perf_counter *cnt = &perf->info.counters[i];
+
+		if (!cnt->name || !cnt->width || cnt->width > 64)
+			return -EINVAL;
+
+		sysfs_attr_init(&attr->attr.attr);
+		attr->attr.attr.name = cnt->name;
+		attr->attr.attr.mode = 0444;
+		attr->attr.show = perf_event_sysfs_show;
+		attr->id = i;
+		attr->event_str = devm_kasprintf(perf->dev, GFP_KERNEL,
+						 "event=0x%x", i);
+		if (!attr->event_str)
+			return -ENOMEM;
+		perf->attrs[i] = &attr->attr.attr;
+	}
+
+	perf->events_group.name = "events";
+	perf->events_group.attrs = perf->attrs;
+
+	perf->groups[0] = &region_perf_format_group;
+	perf->groups[1] = &region_perf_cpumask_group;
+	perf->groups[2] = &perf->events_group;
+
+	return 0;
+}
+
+static int region_perf_match(struct device *dev, const void *data)
+{
+	return dev->of_node == data;
+}
+
+/*
+ * Name the PMU after the closest region above the provider; overlays place
+ * the nodes of an accelerator below the region they program.
+ */
+static const char *region_perf_pmu_name(struct fpga_region_perf *perf)
+{
+	struct device_node *np = of_node_get(perf->dev->of_node);
+	struct fpga_region *region = NULL;
+	const char *name;
+
+	while (np && !region) {
+		np = of_get_next_parent(np);
+		if (np)
+			region = fpga_region_class_find(NULL, np,
+							region_perf_match);
+	}
+	of_node_put(np);
+
+	if (!region)
+		return devm_kasprintf(perf->dev, GFP_KERNEL, "fpga_%s",
+				      perf->info.name);
+
+	name = devm_kasprintf(perf->dev, GFP_KERNEL, "fpga_%s_%s",
+			      dev_name(&region->dev), perf->info.name);
+	put_device(&region->dev);
+
+	return name;
+}
+
+/**
+ * fpga_region_perf_register - register a perf PMU for region counters
+ * @dev:	provider device, usually a device inside an FPGA region
+ * @info:	counters and ops of the provider
+ *
+ * The PMU is named fpga_<region>_<info->name>, or fpga_<info->name> when
+ * @dev isn't inside a region. Perf event ids are the indexes of
+ * @info->counters.
+ *
+ * Return: region perf pointer on success, negative error code otherwise.
+ */
+struct fpga_region_perf *
+fpga_region_perf_register(struct device *dev,
+			  const struct fpga_region_perf_info *info)
+{
+	struct fpga_region_perf *perf;
+	const char *name;
+	int ret;
+
+	if (!info->name || !info->num_counters || !info->ops ||
+	    !info->ops->read_counter || info->num_counters > U16_MAX) {
+		dev_err(dev, "Attempt to register invalid region counters\n");
+		return ERR_PTR(-EINVAL);
+	}
+
+	perf = devm_kzalloc(dev, sizeof(*perf), GFP_KERNEL);
+	if (!perf)
+		return ERR_PTR(-ENOMEM);
+
+	perf->dev = dev;
+	perf->info = *info;
+	perf->cpu = raw_smp_processor_id();
+	INIT_LIST_HEAD(&perf->active);
+	hrtimer_init(&perf->hrtimer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+	perf->hrtimer.function = region_perf_hrtimer;
+
+	ret = region_perf_create_events(perf);
+	if (ret)
+		return ERR_PTR(ret);
+
+	name = region_perf_pmu_name(perf);
+	if (!name)
+		return ERR_PTR(-ENOMEM);
+
+	perf->pmu = (struct pmu) {
+		.module		= info->owner,
+		.task_ctx_nr	= perf_invalid_context,
+		.attr_groups	= perf->groups,
+		.event_init	= region_perf_event_init,
+		.add		= region_perf_event_add,
+		.del		= region_perf_event_del,
+		.start		= region_perf_event_start,
+		.stop		= region_perf_event_stop,
+		.read		= region_perf_event_update,
+		.capabilities	= PERF_PMU_CAP_NO_INTERRUPT |
+				  PERF_PMU_CAP_NO_EXCLUDE,
+	};
+
+	ret = cpuhp_state_add_instance_nocalls(region_perf_cpuhp_state,
+					       &perf->node);
+	if (ret)
+		return ERR_PTR(ret);
+
+	ret = perf_pmu_register(&perf->pmu, name, -1);
+	if (ret) {
+		cpuhp_state_remove_instance_nocalls(region_perf_cpuhp_state,
+						    &perf->node);
+		return ERR_PTR(ret);
+	}
+
+	return perf;
+}
+EXPORT_SYMBOL_GPL(fpga_region_perf_register);
+
+/**
+ * fpga_region_perf_unregister - unregister a region perf PMU
+ * @perf:	region perf instance from fpga_region_perf_register()
+ */
+void fpga_region_perf_unregister(struct fpga_region_perf *perf)
+{
+	perf_pmu_unregister(&perf->pmu);
+	cpuhp_state_remove_instance_nocalls(region_perf_cpuhp_state,
+					    &perf->node);
+}
+EXPORT_SYMBOL_GPL(fpga_region_perf_unregister);
+
+static void devm_fpga_region_perf_unregister(void *perf)
+{
+	fpga_region_perf_unregister(perf);
+}
+
+/**
+ * devm_fpga_region_perf_register - resource managed variant of
+ *				     fpga_region_perf_register()
+ * @dev:	provider device, usually a device inside an FPGA region
+ * @info:	counters and ops of the provider
+ *
+ * Return: region perf pointer on success, negative error code otherwise.
+ */
+struct fpga_region_perf *
+devm_fpga_region_perf_register(struct device *dev,
+			       const struct fpga_region_perf_info *info)
+{
+	struct fpga_region_perf *perf;
+	int ret;
+
+	perf = fpga_region_perf_register(dev, info);
+	if (IS_ERR(perf))
+		return perf;
+
+	ret = devm_add_action_or_reset(dev, devm_fpga_region_perf_unregister,
+				       perf);
+	if (ret)
+		return ERR_PTR(ret);
+
+	return perf;
+}
+EXPORT_SYMBOL_GPL(devm_fpga_region_perf_register);
+
+static int __init fpga_region_perf_init(void)
+{
+	int ret;
+
+	ret = cpuhp_setup_state_multi(CPUHP_AP_ONLINE_DYN,
+				      "perf/fpga/region:online",
+				      NULL, region_perf_offline_cpu);
+	if (ret < 0)
+		return ret;
+
+	region_perf_cpuhp_state = ret;
+
+	return 0;
+}
+
+static void __exit fpga_region_perf_exit(void)
+{
+	cpuhp_remove_multi_state(region_perf_cpuhp_state);
+}
+
+subsys_initcall(fpga_region_perf_init);
+module_exit(fpga_region_perf_exit);
+
+MODULE_DESCRIPTION("FPGA Region perf PMU support");
+MODULE_AUTHOR("Xilinx, Inc.");
+MODULE_LICENSE("GPL");
@@ -158,6 +158,29 @@ int fpga_region_program_fpga(struct fpga_region *region)
 }
 EXPORT_SYMBOL_GPL(fpga_region_program_fpga);
 
+/**
+ * fpga_region_preload - read an FPGA image ahead of programming a region
+ *
+ * @region: FPGA region
+ * @info: fpga image info to be programmed later as region->info
+ *
+ * Read and check the image of @info with the manager of @region, see
+ * fpga_mgr_preload(). This can be done while the region or its manager are
+ * in use, so the next fpga_region_program_fpga() is left with disabling the
+ * bridges, programming and enabling them again.
+ *
+ * Return 0 for success or negative error code.
+ */
+int fpga_region_preload(struct fpga_region *region,
+			struct fpga_image_info *info)
+{
+	if (!region->mgr)
+		return -ENODEV;
+
+	return fpga_mgr_preload(region->mgr, info);
+}
+EXPORT_SYMBOL_GPL(fpga_region_preload);
+
 static ssize_t compat_id_show(struct device *dev,
 			      struct device_attribute *attr, char *buf)
 {
@@ -9,6 +9,7 @@
 #include <linux/kernel.h>
 #include <linux/module.h>
 #include <linux/of_address.h>
+#include <linux/scatterlist.h>
 #include <linux/string.h>
 #include <linux/firmware/xlnx-zynqmp.h>
 
@@ -31,20 +32,69 @@ static int versal_fpga_ops_write_sg(struct fpga_manager *mgr,
 	return ret;
 }
 
+/**
+ * versal_fpga_map_buf - map a PDI to a single DMA segment
+ * @dev:	device doing the DMA
+ * @buf:	PDI image
+ * @size:	size of the PDI image
+ * @sgt:	scatterlist table describing the mapped PDI image
+ *
+ * Return: 0 with @sgt mapped, negative error code otherwise.
+ */
+static int versal_fpga_map_buf(struct device *dev, const char *buf,
+			       size_t size, struct sg_table *sgt)
+{
+	int ret;
+
+	ret = fpga_mgr_buf_to_sgt(buf, size, sgt);
+	if (ret)
+		return ret;
+
+	ret = dma_map_sgtable(dev, sgt, DMA_TO_DEVICE, 0);
+	if (ret)
+		goto free_sgt;
+
+	if (sgt->nents != 1) {
+		dma_unmap_sgtable(dev, sgt, DMA_TO_DEVICE, 0);
+		ret = -EINVAL;
+		goto free_sgt;
+	}
+
+	return 0;
+
+free_sgt:
+	sg_free_table(sgt);
+	return ret;
+}
+
 static int versal_fpga_ops_write(struct fpga_manager *mgr,
 				 const char *buf, size_t size)
 {
+	struct device *dev = mgr->dev.parent;
 	dma_addr_t dma_addr = 0;
+	struct sg_table sgt;
 	char *kbuf;
 	int ret;
 
-	kbuf = dma_alloc_coherent(mgr->dev.parent, size, &dma_addr, GFP_KERNEL);
+	/*
+	 * Give the PDI to the firmware in place when it maps to a single DMA
+	 * segment, which is the case behind an IOMMU. This avoids a large
+	 * contiguous allocation and the copy into it.
+	 */
+	if (!versal_fpga_map_buf(dev, buf, size, &sgt)) {
+		ret = versal_fpga_ops_write_sg(mgr, &sgt);
+		dma_unmap_sgtable(dev, &sgt, DMA_TO_DEVICE, 0);
+		sg_free_table(&sgt);
+		return ret;
+	}
+
+	kbuf = dma_alloc_coherent(dev, size, &dma_addr, GFP_KERNEL);
 	if (!kbuf)
 		return -ENOMEM;
 
 	memcpy(kbuf, buf, size);
 	ret = zynqmp_pm_load_pdi(PDI_SRC_DDR, dma_addr);
-	dma_free_coherent(mgr->dev.parent, size, kbuf, dma_addr);
+	dma_free_coherent(dev, size, kbuf, dma_addr);
 
 	return ret;
 }
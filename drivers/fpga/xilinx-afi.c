@@ -6,6 +6,8 @@
 
 #include <linux/err.h>
 #include <linux/firmware/xlnx-zynqmp.h>
+#include <linux/fpga/fpga-bridge.h>
+#include <linux/fpga/fpga-mgr.h>
 #include <linux/io.h>
 #include <linux/module.h>
 #include <linux/of.h>
@@ -18,36 +20,31 @@
  * @value: value to be written to the register
  * @regid: Register id for the register to be written
  * @resets: Pointer to the reset control for ps-pl resets.
+ * @dev: device
+ * @enabled: bridge state
  */
 struct afi_fpga {
 	u32 value;
 	u32 regid;
 	struct reset_control *resets;
+	struct device *dev;
+	bool enabled;
 };
 
-static int afi_fpga_probe(struct platform_device *pdev)
+/*
+ * Write the <register-id value> pairs of a config-afi property through the
+ * firmware. The caller handles the PS-PL resets.
+ */
+static int afi_fpga_write_config(struct afi_fpga *afi_fpga,
+				 struct device_node *np)
 {
-	struct afi_fpga *afi_fpga;
-	struct device_node *np = pdev->dev.of_node;
 	int ret;
 	int i, entries, pairs;
 	u32 reg, val;
 
-	afi_fpga = devm_kzalloc(&pdev->dev, sizeof(*afi_fpga), GFP_KERNEL);
-	if (!afi_fpga)
-		return -ENOMEM;
-	platform_set_drvdata(pdev, afi_fpga);
-
-	/* Reset PL */
-	afi_fpga->resets = devm_reset_control_array_get_optional_exclusive(&pdev->dev);
-	if (IS_ERR(afi_fpga->resets))
-		return PTR_ERR(afi_fpga->resets);
-
-	reset_control_deassert(afi_fpga->resets);
-
 	entries = of_property_count_u32_elems(np, "config-afi");
 	if (!entries || (entries % 2)) {
-		dev_err(&pdev->dev, "Invalid number of registers\n");
+		dev_err(afi_fpga->dev, "Invalid number of registers\n");
 		return -EINVAL;
 	}
 	pairs = entries / 2;
@@ -56,24 +53,105 @@ static int afi_fpga_probe(struct platform_device *pdev)
 		ret = of_property_read_u32_index(np, "config-afi", i * 2,
 						 &reg);
 		if (ret) {
-			dev_err(&pdev->dev, "failed to read register\n");
+			dev_err(afi_fpga->dev, "failed to read register\n");
 			return -EINVAL;
 		}
 		ret = of_property_read_u32_index(np, "config-afi", i * 2 + 1,
 						 &val);
 		if (ret) {
-			dev_err(&pdev->dev, "failed to read value\n");
+			dev_err(afi_fpga->dev, "failed to read value\n");
 			return -EINVAL;
 		}
 		ret = zynqmp_pm_afi(reg, val);
 		if (ret < 0) {
-			dev_err(&pdev->dev, "AFI register write error %d\n",
+			dev_err(afi_fpga->dev, "AFI register write error %d\n",
 				ret);
 			return ret;
 		}
 	}
 
+	return 0;
+}
+
+static int afi_fpga_enable_set(struct fpga_bridge *bridge, bool enable)
+{
+	struct afi_fpga *afi_fpga = bridge->priv;
+	struct device_node *np = afi_fpga->dev->of_node;
+	int ret;
+
+	if (enable) {
+		/*
+		 * An overlay programming a region may carry the interface
+		 * setup its design needs. Otherwise restore ours, which a
+		 * previous design might have changed. The PS-PL resets are
+		 * left alone here, they are only pulsed once at probe.
+		 */
+		if (bridge->info && bridge->info->overlay &&
+		    of_find_property(bridge->info->overlay, "config-afi", NULL))
+			np = bridge->info->overlay;
+
+		ret = afi_fpga_write_config(afi_fpga, np);
+		if (ret)
+			return ret;
+	}
+
+	afi_fpga->enabled = enable;
+
+	return 0;
+}
+
+static int afi_fpga_enable_show(struct fpga_bridge *bridge)
+{
+	struct afi_fpga *afi_fpga = bridge->priv;
+
+	return afi_fpga->enabled;
+}
+
+static const struct fpga_bridge_ops afi_fpga_br_ops = {
+	.enable_set = afi_fpga_enable_set,
+	.enable_show = afi_fpga_enable_show,
+};
+
+static int afi_fpga_probe(struct platform_device *pdev)
+{
+	struct afi_fpga *afi_fpga;
+	struct fpga_bridge *br;
+	int ret;
+
+	afi_fpga = devm_kzalloc(&pdev->dev, sizeof(*afi_fpga), GFP_KERNEL);
+	if (!afi_fpga)
+		return -ENOMEM;
+	afi_fpga->dev = &pdev->dev;
+
+	/* Reset PL */
+	afi_fpga->resets = devm_reset_control_array_get_optional_exclusive(&pdev->dev);
+	if (IS_ERR(afi_fpga->resets))
+		return PTR_ERR(afi_fpga->resets);
+
+	reset_control_deassert(afi_fpga->resets);
+	ret = afi_fpga_write_config(afi_fpga, pdev->dev.of_node);
 	reset_control_assert(afi_fpga->resets);
+	if (ret)
+		return ret;
+	afi_fpga->enabled = true;
+
+	br = fpga_bridge_register(&pdev->dev, "Xilinx AFI bridge",
+				  &afi_fpga_br_ops, afi_fpga);
+	if (IS_ERR(br)) {
+		dev_err(&pdev->dev, "unable to register AFI bridge\n");
+		return PTR_ERR(br);
+	}
+
+	platform_set_drvdata(pdev, br);
+
+	return 0;
+}
+
+static int afi_fpga_remove(struct platform_device *pdev)
+{
+	struct fpga_bridge *br = platform_get_drvdata(pdev);
+
+	fpga_bridge_unregister(br);
 
 	return 0;
 }
@@ -90,6 +168,7 @@ static struct platform_driver afi_fpga_driver = {
 		.of_match_table = afi_fpga_ids,
 	},
 	.probe = afi_fpga_probe,
+	.remove = afi_fpga_remove,
 };
 module_platform_driver(afi_fpga_driver);
 
@@ -0,0 +1,146 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Xilinx PL counters as FPGA region perf events
+ *
+ * Copyright (C) 2023 Xilinx, Inc.
+ *
+ * HLS kernels and other PL accelerators commonly expose free running
+ * counters (cycles, stalls, transferred bytes) through their AXI-Lite
+ * register map. Their node, loaded by the region overlay, names the
+ * counters and their offsets, and each becomes a perf event of the
+ * region.
+ */
+
+#include <linux/clk.h>
+#include <linux/fpga/fpga-region-perf.h>
+#include <linux/io.h>
+#include <linux/io-64-nonatomic-lo-hi.h>
+#include <linux/module.h>
+#include <linux/of.h>
+#include <linux/platform_device.h>
+
+/**
+ * struct xlnx_pl_perf - PL counter block
+ * @base: IOmapped base address
+ * @offsets: register offset of each counter
+ */
+struct xlnx_pl_perf {
+	void __iomem *base;
+	u32 *offsets;
+};
+
+static u64 xlnx_pl_perf_read_counter(struct fpga_region_perf *perf,
+				     unsigned int idx)
+{
+	struct xlnx_pl_perf *pl = fpga_region_perf_priv(perf);
+
+	return readl(pl->base + pl->offsets[idx]);
+}
+
+static u64 xlnx_pl_perf_read_counter64(struct fpga_region_perf *perf,
+				       unsigned int idx)
+{
+	struct xlnx_pl_perf *pl = fpga_region_perf_priv(perf);
+	u32 hi;
+	u64 lo;
+
+	/* The low word may carry into the high one between the reads */
+	do {
+		hi = readl(pl->base + pl->offsets[idx] + 4);
+		lo = lo_hi_readq(pl->base + pl->offsets[idx]);
+	} while (hi != upper_32_bits(lo));
+
+	return lo;
+}
+
+static const struct fpga_region_perf_ops xlnx_pl_perf_ops = {
+	.read_counter = xlnx_pl_perf_read_counter,
+};
+
+static const struct fpga_region_perf_ops xlnx_pl_perf_ops64 = {
+	.read_counter = xlnx_pl_perf_read_counter64,
+};
+
+static int xlnx_pl_perf_probe(struct platform_device *pdev)
+{
+	struct device_node *np = pdev->dev.of_node;
+	struct fpga_region_perf_counter *counters;
+	struct fpga_region_perf_info info = { };
+	struct xlnx_pl_perf *pl;
+	struct fpga_region_perf *perf;
+	struct clk *clk;
+	u32 width = 32;
+	int i, num;
+
+	pl = devm_kzalloc(&pdev->dev, sizeof(*pl), GFP_KERNEL);
+	if (!pl)
+		return -ENOMEM;
+
+	pl->base = devm_platform_ioremap_resource(pdev, 0);
+	if (IS_ERR(pl->base))
+		return PTR_ERR(pl->base);
+
+	clk = devm_clk_get_optional_enabled(&pdev->dev, NULL);
+	if (IS_ERR(clk))
+		return dev_err_probe(&pdev->dev, PTR_ERR(clk),
+				     "failed to enable clock\n");
+
+	num = of_property_count_strings(np, "counter-names");
+	if (num <= 0 ||
+	    of_property_count_u32_elems(np, "xlnx,counter-offsets") != num) {
+		dev_err(&pdev->dev, "counter-names and offsets don't match\n");
+		return -EINVAL;
+	}
+
+	of_property_read_u32(np, "xlnx,counter-width", &width);
+	if (!width || width > 64) {
+		dev_err(&pdev->dev, "invalid counter width %u\n", width);
+		return -EINVAL;
+	}
+
+	counters = devm_kcalloc(&pdev->dev, num, sizeof(*counters), GFP_KERNEL);
+	pl->offsets = devm_kcalloc(&pdev->dev, num, sizeof(*pl->offsets),
+				   GFP_KERNEL);
+	if (!counters || !pl->offsets)
+		return -ENOMEM;
+
+	of_property_read_u32_array(np, "xlnx,counter-offsets", pl->offsets,
+				   num);
+	for (i = 0; i < num; i++) {
+		of_property_read_string_index(np, "counter-names", i,
+					      &counters[i].name);
+		counters[i].width = width;
+	}
+
+	info.name = devm_kasprintf(&pdev->dev, GFP_KERNEL, "%pOFn", np);
+	if (!info.name)
+		return -ENOMEM;
+	info.counters = counters;
+	info.num_counters = num;
+	info.ops = width > 32 ? &xlnx_pl_perf_ops64 : &xlnx_pl_perf_ops;
+	info.priv = pl;
+	info.owner = THIS_MODULE;
+
+	perf = devm_fpga_region_perf_register(&pdev->dev, &info);
+
+	return PTR_ERR_OR_ZERO(perf);
+}
+
+static const struct of_device_id xlnx_pl_perf_of_match[] = {
+	{ .compatible = "xlnx,pl-perf-counters" },
+	{ /* end of table */ }
+};
+MODULE_DEVICE_TABLE(of, xlnx_pl_perf_of_match);
+
+static struct platform_driver xlnx_pl_perf_driver = {
+	.driver = {
+		.name = "xlnx-pl-perf",
+		.of_match_table = xlnx_pl_perf_of_match,
+	},
+	.probe = xlnx_pl_perf_probe,
+};
+module_platform_driver(xlnx_pl_perf_driver);
+
+MODULE_DESCRIPTION("Xilinx PL counters perf support");
+MODULE_AUTHOR("Xilinx, Inc.");
+MODULE_LICENSE("GPL");
@@ -5,6 +5,8 @@
  */
 
 #include <linux/err.h>
+#include <linux/fpga/fpga-bridge.h>
+#include <linux/fpga/fpga-mgr.h>
 #include <linux/io.h>
 #include <linux/module.h>
 #include <linux/of.h>
@@ -12,31 +14,132 @@
 
 /* Registers and special values for doing register-based operations */
 #define AFI_RDCHAN_CTRL_OFFSET	0x00
+#define AFI_RDQOS_OFFSET	0x08
 #define AFI_WRCHAN_CTRL_OFFSET	0x14
+#define AFI_WRQOS_OFFSET	0x1C
 
 #define AFI_BUSWIDTH_MASK	0x01
+#define AFI_FABRIC_QOS_EN	0x02
+#define AFI_QOS_MASK		0x0F
+
+/* Width, read QoS and write QoS following the AFI phandle */
+#define AFI_CONFIG_ARGS		3
+#define AFI_QOS_FABRIC		0xFFFFFFFF
 
 /**
- * struct afi_fpga - AFI register description
+ * struct zynq_afi_fpga - AFI register description
  * @membase:	pointer to register struct
+ * @dev:	device
  * @afi_width:	AFI bus width to be written
+ * @rd_qos:	static read QoS, or AFI_QOS_FABRIC to use the fabric AxQOS
+ * @wr_qos:	static write QoS, or AFI_QOS_FABRIC to use the fabric AxQOS
+ * @enabled:	bridge state
  */
 struct zynq_afi_fpga {
 	void __iomem	*membase;
+	struct device	*dev;
 	u32		afi_width;
+	u32		rd_qos;
+	u32		wr_qos;
+	bool		enabled;
+};
+
+static void zynq_afi_fpga_write_chan(struct zynq_afi_fpga *afi_fpga,
+				     u32 ctrl_offset, u32 qos_offset, u32 width,
+				     u32 qos)
+{
+	u32 reg_val;
+
+	reg_val = readl(afi_fpga->membase + ctrl_offset);
+	reg_val &= ~(AFI_BUSWIDTH_MASK | AFI_FABRIC_QOS_EN);
+	reg_val |= width & AFI_BUSWIDTH_MASK;
+	if (qos == AFI_QOS_FABRIC)
+		reg_val |= AFI_FABRIC_QOS_EN;
+	else
+		writel(qos & AFI_QOS_MASK, afi_fpga->membase + qos_offset);
+	writel(reg_val, afi_fpga->membase + ctrl_offset);
+}
+
+static void zynq_afi_fpga_apply(struct zynq_afi_fpga *afi_fpga, u32 width,
+				u32 rd_qos, u32 wr_qos)
+{
+	zynq_afi_fpga_write_chan(afi_fpga, AFI_RDCHAN_CTRL_OFFSET,
+				 AFI_RDQOS_OFFSET, width, rd_qos);
+	zynq_afi_fpga_write_chan(afi_fpga, AFI_WRCHAN_CTRL_OFFSET,
+				 AFI_WRQOS_OFFSET, width, wr_qos);
+}
+
+/*
+ * An overlay programming a region can carry its own port setup as
+ * xlnx,afi-config = <&afi width rd-qos wr-qos>, ... entries. Ports it
+ * doesn't mention fall back to the configuration from their own node.
+ */
+static void zynq_afi_fpga_overlay_config(struct zynq_afi_fpga *afi_fpga,
+					 struct device_node *overlay,
+					 u32 *width, u32 *rd_qos, u32 *wr_qos)
+{
+	struct of_phandle_args args;
+	int i;
+
+	for (i = 0; !of_parse_phandle_with_fixed_args(overlay, "xlnx,afi-config",
+						      AFI_CONFIG_ARGS, i, &args);
+	     i++) {
+		of_node_put(args.np);
+		if (args.np != afi_fpga->dev->of_node)
+			continue;
+
+		*width = args.args[0];
+		*rd_qos = args.args[1];
+		*wr_qos = args.args[2];
+		break;
+	}
+}
+
+static int zynq_afi_fpga_enable_set(struct fpga_bridge *bridge, bool enable)
+{
+	struct zynq_afi_fpga *afi_fpga = bridge->priv;
+	u32 width = afi_fpga->afi_width;
+	u32 rd_qos = afi_fpga->rd_qos;
+	u32 wr_qos = afi_fpga->wr_qos;
+
+	if (enable) {
+		if (bridge->info && bridge->info->overlay)
+			zynq_afi_fpga_overlay_config(afi_fpga,
+						     bridge->info->overlay,
+						     &width, &rd_qos, &wr_qos);
+		zynq_afi_fpga_apply(afi_fpga, width, rd_qos, wr_qos);
+	}
+
+	afi_fpga->enabled = enable;
+
+	return 0;
+}
+
+static int zynq_afi_fpga_enable_show(struct fpga_bridge *bridge)
+{
+	struct zynq_afi_fpga *afi_fpga = bridge->priv;
+
+	return afi_fpga->enabled;
+}
+
+static const struct fpga_bridge_ops zynq_afi_fpga_br_ops = {
+	.enable_set = zynq_afi_fpga_enable_set,
+	.enable_show = zynq_afi_fpga_enable_show,
 };
 
 static int zynq_afi_fpga_probe(struct platform_device *pdev)
 {
 	struct zynq_afi_fpga *afi_fpga;
+	struct fpga_bridge *br;
 	struct resource *res;
-	u32 reg_val;
 	u32 val;
 
 	afi_fpga = devm_kzalloc(&pdev->dev, sizeof(*afi_fpga), GFP_KERNEL);
 	if (!afi_fpga)
 		return -ENOMEM;
 
+	afi_fpga->dev = &pdev->dev;
+
 	res = platform_get_resource(pdev, IORESOURCE_MEM, 0);
 	afi_fpga->membase = devm_ioremap_resource(&pdev->dev, res);
 	if (IS_ERR(afi_fpga->membase))
@@ -49,14 +152,34 @@ static int zynq_afi_fpga_probe(struct platform_device *pdev)
 		return -EINVAL;
 	}
 
-	reg_val = readl(afi_fpga->membase + AFI_RDCHAN_CTRL_OFFSET);
-	reg_val &= ~AFI_BUSWIDTH_MASK;
-	writel(reg_val | afi_fpga->afi_width,
-	       afi_fpga->membase + AFI_RDCHAN_CTRL_OFFSET);
-	reg_val = readl(afi_fpga->membase + AFI_WRCHAN_CTRL_OFFSET);
-	reg_val &= ~AFI_BUSWIDTH_MASK;
-	writel(reg_val | afi_fpga->afi_width,
-	       afi_fpga->membase + AFI_WRCHAN_CTRL_OFFSET);
+	afi_fpga->rd_qos = AFI_QOS_FABRIC;
+	afi_fpga->wr_qos = AFI_QOS_FABRIC;
+	device_property_read_u32(&pdev->dev, "xlnx,afi-rd-qos",
+				 &afi_fpga->rd_qos);
+	device_property_read_u32(&pdev->dev, "xlnx,afi-wr-qos",
+				 &afi_fpga->wr_qos);
+
+	zynq_afi_fpga_apply(afi_fpga, afi_fpga->afi_width, afi_fpga->rd_qos,
+			    afi_fpga->wr_qos);
+	afi_fpga->enabled = true;
+
+	br = fpga_bridge_register(&pdev->dev, "Zynq AFI bridge",
+				  &zynq_afi_fpga_br_ops, afi_fpga);
+	if (IS_ERR(br)) {
+		dev_err(&pdev->dev, "unable to register AFI bridge\n");
+		return PTR_ERR(br);
+	}
+
+	platform_set_drvdata(pdev, br);
+
+	return 0;
+}
+
+static int zynq_afi_fpga_remove(struct platform_device *pdev)
+{
+	struct fpga_bridge *br = platform_get_drvdata(pdev);
+
+	fpga_bridge_unregister(br);
 
 	return 0;
 }
@@ -73,6 +196,7 @@ static struct platform_driver zynq_afi_fpga_driver = {
 		.of_match_table = zynq_afi_fpga_ids,
 	},
 	.probe = zynq_afi_fpga_probe,
+	.remove = zynq_afi_fpga_remove,
 };
 module_platform_driver(zynq_afi_fpga_driver);
 
@@ -3,12 +3,14 @@
  * Copyright (C) 2019 Xilinx, Inc.
  */
 
+#include <linux/crc32.h>
 #include <linux/dma-mapping.h>
 #include <linux/fpga/fpga-mgr.h>
 #include <linux/io.h>
 #include <linux/kernel.h>
 #include <linux/module.h>
 #include <linux/of_address.h>
+#include <linux/scatterlist.h>
 #include <linux/seq_file.h>
 #include <linux/string.h>
 #include <linux/firmware/xlnx-zynqmp.h>
@@ -52,6 +54,16 @@ MODULE_PARM_DESC(readback_type,
 		 "readback_type 0-configuration register read "
 		 "1- configuration data read (default: 0)");
 
+static bool readback_crc;
+module_param(readback_crc, bool, 0644);
+MODULE_PARM_DESC(readback_crc,
+		 "report the CRC32 of the configuration data read instead of "
+		 "the data (default: 0)");
+
+/* Headers printed ahead of the configuration data read */
+#define CFGDATA_HDR	"zynqMP FPGA Configuration data contents are\n"
+#define CFGDATA_CRC_HDR	"zynqMP FPGA Configuration data CRC32 is "
+
 /**
  * struct zynqmp_configreg - Configuration register offsets
  * @reg:	Name of the configuration register.
@@ -132,6 +144,44 @@ static int zynqmp_fpga_ops_write_init(struct fpga_manager *mgr,
 	return 0;
 }
 
+static int zynqmp_fpga_ops_write_sg(struct fpga_manager *mgr,
+				    struct sg_table *sgt);
+
+/**
+ * zynqmp_fpga_map_buf - map a bitstream to a single DMA segment
+ * @dev:	device doing the DMA
+ * @buf:	bitstream
+ * @size:	size of the bitstream
+ * @sgt:	scatterlist table describing the mapped bitstream
+ *
+ * Return: 0 with @sgt mapped, negative error code otherwise.
+ */
+static int zynqmp_fpga_map_buf(struct device *dev, const char *buf,
+			       size_t size, struct sg_table *sgt)
+{
+	int ret;
+
+	ret = fpga_mgr_buf_to_sgt(buf, size, sgt);
+	if (ret)
+		return ret;
+
+	ret = dma_map_sgtable(dev, sgt, DMA_TO_DEVICE, 0);
+	if (ret)
+		goto free_sgt;
+
+	if (sgt->nents != 1) {
+		dma_unmap_sgtable(dev, sgt, DMA_TO_DEVICE, 0);
+		ret = -EINVAL;
+		goto free_sgt;
+	}
+
+	return 0;
+
+free_sgt:
+	sg_free_table(sgt);
+	return ret;
+}
+
 static int zynqmp_fpga_ops_write(struct fpga_manager *mgr,
 				 const char *buf, size_t size)
 {
@@ -140,6 +190,7 @@ static int zynqmp_fpga_ops_write(struct fpga_manager *mgr,
 	dma_addr_t dma_addr;
 	u32 eemi_flags = 0;
 	size_t dma_size;
+	struct sg_table sgt;
 	u32 status;
 	char *kbuf;
 
@@ -151,6 +202,18 @@ static int zynqmp_fpga_ops_write(struct fpga_manager *mgr,
 	size = size + word_align;
 	priv->size = size;
 
+	/*
+	 * An aligned bitstream is given to the firmware in place when it maps
+	 * to a single DMA segment, which is the case behind an IOMMU. This
+	 * avoids a large contiguous allocation and the copy into it.
+	 */
+	if (!word_align && !zynqmp_fpga_map_buf(priv->dev, buf, size, &sgt)) {
+		ret = zynqmp_fpga_ops_write_sg(mgr, &sgt);
+		dma_unmap_sgtable(priv->dev, &sgt, DMA_TO_DEVICE, 0);
+		sg_free_table(&sgt);
+		return ret;
+	}
+
 	if (priv->flags & FPGA_MGR_USERKEY_ENCRYPTED_BITSTREAM)
 		dma_size = size + ENCRYPTED_KEY_LEN;
 	else
@@ -214,6 +277,18 @@ static unsigned long zynqmp_fpga_get_contiguous_size(struct sg_table *sgt)
 	return size;
 }
 
+static unsigned long zynqmp_fpga_get_dma_size(struct sg_table *sgt)
+{
+	unsigned long size = 0;
+	struct scatterlist *s;
+	unsigned int i;
+
+	for_each_sg(sgt->sgl, s, sgt->nents, i)
+		size += sg_dma_len(s);
+
+	return size;
+}
+
 static int zynqmp_fpga_ops_write_sg(struct fpga_manager *mgr,
 				    struct sg_table *sgt)
 {
@@ -230,6 +305,12 @@ static int zynqmp_fpga_ops_write_sg(struct fpga_manager *mgr,
 	dma_addr = sg_dma_address(sgt->sgl);
 	contig_size = zynqmp_fpga_get_contiguous_size(sgt);
 
+	/* The firmware takes the bitstream as a single buffer */
+	if (contig_size != zynqmp_fpga_get_dma_size(sgt)) {
+		dev_err(priv->dev, "bitstream is not contiguous in DMA space\n");
+		return -EINVAL;
+	}
+
 	if (priv->flags & FPGA_MGR_PARTIAL_RECONFIG)
 		eemi_flags |= XILINX_ZYNQMP_PM_FPGA_PARTIAL;
 	if (priv->flags & FPGA_MGR_USERKEY_ENCRYPTED_BITSTREAM)
@@ -370,13 +451,22 @@ static int zynqmp_fpga_read_cfgdata(struct fpga_manager *mgr,
 	if (!buf)
 		return -ENOMEM;
 
-	seq_puts(s, "zynqMP FPGA Configuration data contents are\n");
 	ret = zynqmp_pm_fpga_read((priv->size + DUMMY_FRAMES_SIZE) / 4,
 				  dma_addr, readback_type, &data_offset);
 	if (ret)
 		goto free_dmabuf;
 
-	seq_write(s, &buf[data_offset], priv->size);
+	/*
+	 * The CRC of a known good readback is the reference for scrubbing,
+	 * comparing it saves copying the whole configuration to user space.
+	 */
+	if (readback_crc) {
+		seq_printf(s, CFGDATA_CRC_HDR "%08x\n",
+			   ~crc32_le(~0, (u8 *)&buf[data_offset], priv->size));
+	} else {
+		seq_puts(s, CFGDATA_HDR);
+		seq_write(s, &buf[data_offset], priv->size);
+	}
 
 free_dmabuf:
 	dma_free_coherent(mgr->dev.parent, size, buf, dma_addr);
@@ -396,6 +486,16 @@ static int zynqmp_fpga_ops_read(struct fpga_manager *mgr, struct seq_file *s)
 	return ret;
 }
 
+static size_t zynqmp_fpga_ops_read_size(struct fpga_manager *mgr)
+{
+	struct zynqmp_fpga_priv *priv = mgr->priv;
+
+	if (!readback_type || readback_crc)
+		return 0;
+
+	return sizeof(CFGDATA_HDR) + priv->size;
+}
+
 static const struct fpga_manager_ops zynqmp_fpga_ops = {
 	.state = zynqmp_fpga_ops_state,
 	.status = zynqmp_fpga_ops_status,
@@ -403,6 +503,7 @@ static const struct fpga_manager_ops zynqmp_fpga_ops = {
 	.write = zynqmp_fpga_ops_write,
 	.write_sg = zynqmp_fpga_ops_write_sg,
 	.read = zynqmp_fpga_ops_read,
+	.read_size = zynqmp_fpga_ops_read_size,
 };
 
 static int zynqmp_fpga_probe(struct platform_device *pdev)
@@ -17,6 +17,7 @@
  * https://www.digital-cp.com/sites/default/files/HDCP%20on%20DisplayPort%20Specification%20Rev2_3.pdf
  */
 
+#include <crypto/sha2.h>
 #include <linux/xlnx/xlnx_hdcp2x_cipher.h>
 #include <linux/xlnx/xlnx_hdcp_common.h>
 #include <linux/xlnx/xlnx_hdcp_rng.h>
@@ -600,6 +601,7 @@ static enum hdcp2x_tx_state hdcp2x_tx_wait_for_ack(struct xlnx_hdcp2x_config *xh
 	struct xhdcp2x_tx_msg *xhdcp2x_msg = (struct xhdcp2x_tx_msg *)xhdcp2x_tx->msg_buffer;
 	struct hdcp2x_tx_pairing_info  *xhdcp2x_pairing_info = NULL;
 	struct hdcp2x_tx_pairing_info xhdcp2x_new_pairing_info;
+	u8 cert_digest[HDCP2X_TX_SHA256_HASH_SIZE];
 	const u8 *kpubdpcptr = NULL;
 	int result;
 
@@ -621,12 +623,29 @@ static enum hdcp2x_tx_state hdcp2x_tx_wait_for_ack(struct xlnx_hdcp2x_config *xh
 	if (!kpubdpcptr)
 		return A0_HDCP2X_TX_AKE_INIT;
 
-	result = xlnx_hdcp2x_tx_verify_certificate(&xhdcp2x_msg->msg_type.ake_send_cert.cert_rx,
-						   kpubdpcptr, HDCP2X_TX_KPUB_DCP_LLC_N_SIZE,
-						   &kpubdpcptr[HDCP2X_TX_KPUB_DCP_LLC_N_SIZE],
-						   HDCP2X_TX_KPUB_DCP_LLC_E_SIZE);
-	if (result < 0)
-		return A0_HDCP2X_TX_AKE_INIT;
+	/*
+	 * The certificate of a receiver never changes, so re-authenticating
+	 * the same receiver, e.g. after a hot plug bounce, can skip the 3072
+	 * bit signature check when the certificate is the one verified last.
+	 */
+	sha256((u8 *)&xhdcp2x_msg->msg_type.ake_send_cert.cert_rx,
+	       sizeof(xhdcp2x_msg->msg_type.ake_send_cert.cert_rx), cert_digest);
+	if (!xhdcp2x_tx->xhdcp2x_info.is_cert_digest_valid ||
+	    memcmp(cert_digest, xhdcp2x_tx->xhdcp2x_info.cert_digest,
+		   sizeof(cert_digest))) {
+		xhdcp2x_tx->xhdcp2x_info.is_cert_digest_valid = 0;
+		result = xlnx_hdcp2x_tx_verify_certificate(&xhdcp2x_msg->msg_type.ake_send_cert.cert_rx,
+							   kpubdpcptr,
+							   HDCP2X_TX_KPUB_DCP_LLC_N_SIZE,
+							   &kpubdpcptr[HDCP2X_TX_KPUB_DCP_LLC_N_SIZE],
+							   HDCP2X_TX_KPUB_DCP_LLC_E_SIZE);
+		if (result < 0)
+			return A0_HDCP2X_TX_AKE_INIT;
+
+		memcpy(xhdcp2x_tx->xhdcp2x_info.cert_digest, cert_digest,
+		       sizeof(cert_digest));
+		xhdcp2x_tx->xhdcp2x_info.is_cert_digest_valid = 1;
+	}
 
 	if (xhdcp2x_tx->xhdcp2x_hw.tx_mode == XHDCP2X_TX_TRANSMITTER) {
 		u8 *rcv_id = xhdcp2x_msg->msg_type.ake_send_cert.cert_rx.rcvid;
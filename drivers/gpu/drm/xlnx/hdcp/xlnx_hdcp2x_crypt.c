@@ -16,11 +16,21 @@
  */
 
 #include <crypto/aes.h>
+#include <crypto/akcipher.h>
 #include <crypto/sha2.h>
+#include <linux/scatterlist.h>
+#include <linux/slab.h>
 #include <linux/xlnx/xlnx_hdcp_common.h>
 #include "xlnx_hdcp2x_tx.h"
 
-#define BD_MAX_MOD_SIZE  (HDCP2X_TX_CERT_RSA_PARAMETER_SIZE / sizeof(u32))
+#define XHDCP2X_TX_BER_INTEGER		0x02
+#define XHDCP2X_TX_BER_SEQUENCE		0x30
+/* Tag and up to 3 length bytes */
+#define XHDCP2X_TX_BER_HDR_MAX_SIZE	4
+/* Sequence header, then a header and a sign byte for each of n and e */
+#define XHDCP2X_TX_RSA_BER_KEY_SIZE	(HDCP2X_TX_CERT_SIGNATURE_SIZE + \
+					 HDCP2X_TX_CERT_PUB_KEY_E_SIZE + \
+					 3 * (XHDCP2X_TX_BER_HDR_MAX_SIZE + 1))
 
 #define XHDCP2X_TX_SHA256_SIZE		(256 / 8)
 #define XHDCP2X_TX_INNER_PADDING_BYTE	0x36
@@ -125,25 +135,132 @@ static void xlnx_hdcp2x_tx_pkcs1_eme_oaep_encode(const u8 *message, const u32 me
 	       HDCP2X_TX_CERT_PUB_KEY_N_SIZE - HDCP2X_TX_SHA256_HASH_SIZE - 1);
 }
 
+/* Encode a BER length field, returns the number of bytes written */
+static int xlnx_hdcp2x_tx_ber_put_len(u8 *buf, u32 len)
+{
+	if (len < 0x80) {
+		buf[0] = len;
+		return 1;
+	}
+	if (len <= 0xff) {
+		buf[0] = 0x81;
+		buf[1] = len;
+		return 2;
+	}
+	buf[0] = 0x82;
+	buf[1] = len >> BITS_PER_BYTE;
+	buf[2] = len;
+	return 3;
+}
+
+/* Encode an unsigned big endian integer as a BER INTEGER */
+static int xlnx_hdcp2x_tx_ber_put_int(u8 *buf, const u8 *val, u32 len)
+{
+	bool pad = val[0] & BIT(7);
+	int idx = 0;
+
+	buf[idx++] = XHDCP2X_TX_BER_INTEGER;
+	idx += xlnx_hdcp2x_tx_ber_put_len(&buf[idx], len + pad);
+	if (pad)
+		buf[idx++] = 0;
+	memcpy(&buf[idx], val, len);
+
+	return idx + len;
+}
+
+/*
+ * Build the RSAPublicKey (SEQUENCE { n INTEGER, e INTEGER }) blob expected
+ * by crypto_akcipher_set_pub_key(), returns the size of the blob.
+ */
+static int xlnx_hdcp2x_tx_rsa_ber_pub_key(u8 *buf, const u8 *n, u32 n_size,
+					  const u8 *e, u32 e_size)
+{
+	u8 *ints = &buf[XHDCP2X_TX_BER_HDR_MAX_SIZE];
+	int len, idx = 0;
+
+	/* Encode the integers first, the sequence header depends on their size */
+	len = xlnx_hdcp2x_tx_ber_put_int(ints, n, n_size);
+	len += xlnx_hdcp2x_tx_ber_put_int(&ints[len], e, e_size);
+
+	buf[idx++] = XHDCP2X_TX_BER_SEQUENCE;
+	idx += xlnx_hdcp2x_tx_ber_put_len(&buf[idx], len);
+	memmove(&buf[idx], ints, len);
+
+	return idx + len;
+}
+
+/*
+ * Raw RSA public key operation, encrypted_msg = msg ^ e mod n.
+ *
+ * This goes through the akcipher API so the modular exponentiation runs on
+ * the highest priority "rsa" implementation registered with the crypto
+ * subsystem, which is an accelerator when one is available.
+ */
 static int xlnx_hdcp2x_tx_rsa_encrypt(const u8 *rsa_public_key, int public_key_size,
 				      const u8 *exponent_key, int exponent_key_size,
 				      const u8 *msg, int msg_size, u8 *encrypted_msg)
 {
-	unsigned int n[BD_MAX_MOD_SIZE], e[BD_MAX_MOD_SIZE],
-			m[BD_MAX_MOD_SIZE], s[BD_MAX_MOD_SIZE];
-	unsigned int mod_size = public_key_size / sizeof(unsigned int);
-
-	if (msg_size != public_key_size)
+	struct crypto_akcipher *tfm;
+	struct akcipher_request *req;
+	struct scatterlist src, dst;
+	DECLARE_CRYPTO_WAIT(wait);
+	u8 *key, *buf;
+	int key_size, ret;
+
+	if (msg_size != public_key_size ||
+	    public_key_size > HDCP2X_TX_CERT_SIGNATURE_SIZE ||
+	    exponent_key_size > HDCP2X_TX_CERT_PUB_KEY_E_SIZE)
 		return -EINVAL;
 
-	mp_conv_from_octets(n, mod_size, rsa_public_key, public_key_size);
-	mp_conv_from_octets(e, mod_size, exponent_key, exponent_key_size);
+	tfm = crypto_alloc_akcipher("rsa", 0, 0);
+	if (IS_ERR(tfm))
+		return PTR_ERR(tfm);
 
-	mp_conv_from_octets(m, mod_size, msg, msg_size);
-	mp_mod_exp(s, m, e, n, mod_size);
-	mp_conv_to_octets(s, mod_size, encrypted_msg, msg_size);
+	/* Scatterlists can't point to the stack, keep everything in one buffer */
+	buf = kmalloc(2 * public_key_size + XHDCP2X_TX_RSA_BER_KEY_SIZE,
+		      GFP_KERNEL);
+	if (!buf) {
+		ret = -ENOMEM;
+		goto free_tfm;
+	}
+	key = buf + 2 * public_key_size;
+
+	key_size = xlnx_hdcp2x_tx_rsa_ber_pub_key(key, rsa_public_key,
+						  public_key_size, exponent_key,
+						  exponent_key_size);
+	ret = crypto_akcipher_set_pub_key(tfm, key, key_size);
+	if (ret)
+		goto free_buf;
+
+	req = akcipher_request_alloc(tfm, GFP_KERNEL);
+	if (!req) {
+		ret = -ENOMEM;
+		goto free_buf;
+	}
 
-	return 0;
+	memcpy(buf, msg, msg_size);
+	sg_init_one(&src, buf, msg_size);
+	sg_init_one(&dst, buf + public_key_size, public_key_size);
+	akcipher_request_set_crypt(req, &src, &dst, msg_size, public_key_size);
+	akcipher_request_set_callback(req, CRYPTO_TFM_REQ_MAY_SLEEP |
+				      CRYPTO_TFM_REQ_MAY_BACKLOG,
+				      crypto_req_done, &wait);
+
+	ret = crypto_wait_req(crypto_akcipher_encrypt(req), &wait);
+	if (!ret) {
+		/* The result may come back without its leading zero bytes */
+		memset(encrypted_msg, 0, public_key_size - req->dst_len);
+		memcpy(encrypted_msg + public_key_size - req->dst_len,
+		       buf + public_key_size, req->dst_len);
+	}
+
+	akcipher_request_free(req);
+free_buf:
+	kfree_sensitive(buf);
+free_tfm:
+	crypto_free_akcipher(tfm);
+
+	return ret;
 }
 
 /* Reference: PKCS#1 v2.1, Section 7.1. */
@@ -1023,6 +1023,7 @@ int xlnx_hdcp2x_tx_write_akenostored_km(struct xlnx_hdcp2x_config *xhdcp2x_tx,
 	struct xhdcp2x_tx_msg *tx_msg = (struct xhdcp2x_tx_msg *)xhdcp2x_tx->msg_buffer;
 	u8 masking_seed[HDCP2X_TX_KM_MSK_SEED_SIZE];
 	u8 ek_pubkm[HDCP_2_2_E_KPUB_KM_LEN];
+	int ret;
 
 	tx_msg->msg = (xhdcp2x_tx->xhdcp2x_hw.protocol != XHDCP2X_TX_DP) ?
 				HDCP_2_2_HDMI_REG_WR_MSG_OFFSET :
@@ -1032,8 +1033,10 @@ int xlnx_hdcp2x_tx_write_akenostored_km(struct xlnx_hdcp2x_config *xhdcp2x_tx,
 	xlnx_hdcp2x_rng_get_random_number(&xhdcp2x_tx->xhdcp2x_hw.xlnxhdcp2x_rng,
 					  masking_seed, HDCP2X_TX_KM_MSK_SEED_SIZE,
 					  HDCP2X_TX_KM_MSK_SEED_SIZE);
-	xlnx_hdcp2x_tx_encryptedkm((const struct hdcp2x_tx_cert_rx *)cert_ptr,
-				   pairing_info->km, masking_seed, ek_pubkm);
+	ret = xlnx_hdcp2x_tx_encryptedkm((const struct hdcp2x_tx_cert_rx *)cert_ptr,
+					 pairing_info->km, masking_seed, ek_pubkm);
+	if (ret)
+		return ret;
 
 	memcpy(tx_msg->msg_type.ake_nostored_km.ek_pubkm, ek_pubkm,
 	       sizeof(tx_msg->msg_type.ake_nostored_km.ek_pubkm));
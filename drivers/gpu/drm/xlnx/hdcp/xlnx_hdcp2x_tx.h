@@ -130,6 +130,7 @@ struct xhdcp2x_tx_msg {
  * @r_tx: Internal used rtx
  * @r_rx: Internal used rrx
  * @rn: Internal used rn
+ * @cert_digest: SHA256 digest of the last receiver certificate verified
  * @txcaps: HDCP tx capabilities
  * @seq_num_v: Sequence number V used with Received Id list
  * @seq_num_m: Sequence number M used with Content Stream Management
@@ -146,6 +147,7 @@ struct xhdcp2x_tx_msg {
  * @is_revoc_list_valid: Is revocation list valid
  * @is_device_revoked: Is a device listed in the revocation list
  * @msg_available: Message is available for reading
+ * @is_cert_digest_valid: Is cert_digest a successfully verified certificate
  */
 struct xhdcp2x_tx_internal_info {
 	struct hdcp2x_tx_pairing_info pairing_info[XHDCP2X_TX_MAX_STORED_PAIRINGINFO];
@@ -158,6 +160,7 @@ struct xhdcp2x_tx_internal_info {
 	u8 r_tx[8];
 	u8 r_rx[8];
 	u8 rn[8];
+	u8 cert_digest[HDCP2X_TX_SHA256_HASH_SIZE];
 	u8 txcaps[3];
 	u32 seq_num_v;
 	u32 seq_num_m;
@@ -174,6 +177,7 @@ struct xhdcp2x_tx_internal_info {
 	bool is_revoc_list_valid;
 	bool is_device_revoked;
 	bool msg_available;
+	bool is_cert_digest_valid;
 };
 
 struct xhdcp2x_tx_callbacks {
@@ -61,23 +61,32 @@ struct videomode;
  * xlnx_bridge_enable - Enable the bridge
  * @bridge: bridge to enable
  *
- * Enable bridge.
+ * Enable bridge. The input and output staged by a bridge with a commit
+ * callback are written before it's enabled.
  *
  * Return: 0 on success. -ENOENT if no callback, -EFAULT in error state,
  * or return code from callback.
  */
 int xlnx_bridge_enable(struct xlnx_bridge *bridge)
 {
+	int ret;
+
 	if (!bridge)
 		return 0;
 
 	if (helper.error)
 		return -EFAULT;
 
-	if (bridge->enable)
-		return bridge->enable(bridge);
+	if (!bridge->enable)
+		return -ENOENT;
 
-	return -ENOENT;
+	if (bridge->commit) {
+		ret = bridge->commit(bridge);
+		if (ret)
+			return ret;
+	}
+
+	return bridge->enable(bridge);
 }
 EXPORT_SYMBOL(xlnx_bridge_enable);
 
@@ -238,6 +247,36 @@ int xlnx_bridge_set_timing(struct xlnx_bridge *bridge, struct videomode *vm)
 }
 EXPORT_SYMBOL(xlnx_bridge_set_timing);
 
+/**
+ * xlnx_bridge_commit - Apply the staged input and output of the bridge
+ * @bridge: bridge to commit
+ *
+ * Write the input and output set with xlnx_bridge_set_input() and
+ * xlnx_bridge_set_output() to a running bridge. The IPs latch their
+ * registers at the start of every frame, so a client reconfiguring the
+ * pipeline sets up all of its bridges first and commits them together from
+ * the vertical blanking, instead of disabling and enabling the whole chain.
+ * A bridge without a commit callback applies its input and output when they
+ * are set.
+ *
+ * Return: 0 on success. -EFAULT if in error state, or return code from
+ * callback.
+ */
+int xlnx_bridge_commit(struct xlnx_bridge *bridge)
+{
+	if (!bridge)
+		return 0;
+
+	if (helper.error)
+		return -EFAULT;
+
+	if (bridge->commit)
+		return bridge->commit(bridge);
+
+	return 0;
+}
+EXPORT_SYMBOL(xlnx_bridge_commit);
+
 /**
  * of_xlnx_bridge_get - Get the corresponding Xlnx bridge instance
  * @bridge_np: The device node of the bridge device
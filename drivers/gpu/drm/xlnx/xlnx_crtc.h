@@ -30,6 +30,8 @@
  * @get_format: Get the current format of CRTC device
  * @get_cursor_width: Get the cursor width
  * @get_cursor_height: Get the cursor height
+ * @mode_seamless: Optional check if a mode change of an active CRTC can be
+ *	done without a modeset
  */
 struct xlnx_crtc {
 	struct drm_crtc crtc;
@@ -41,6 +43,9 @@ struct xlnx_crtc {
 	uint32_t (*get_format)(struct xlnx_crtc *crtc);
 	uint32_t (*get_cursor_width)(struct xlnx_crtc *crtc);
 	uint32_t (*get_cursor_height)(struct xlnx_crtc *crtc);
+	bool (*mode_seamless)(struct xlnx_crtc *crtc,
+			      struct drm_crtc_state *old_state,
+			      struct drm_crtc_state *new_state);
 };
 
 /*
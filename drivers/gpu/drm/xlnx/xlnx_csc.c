@@ -66,6 +66,9 @@
 #define XCSC_MIN_HEIGHT			(64)
 #define XCSC_MAX_HEIGHT			(4320)
 
+/* Number of configuration registers, they are 8 bytes apart */
+#define XCSC_NUM_REGS			(XV_CSC_CLIPMAX / 8 + 1)
+
 static const u32 xilinx_csc_video_fmts[] = {
 	MEDIA_BUS_FMT_RGB888_1X24,
 	MEDIA_BUS_FMT_VUY8_1X24,
@@ -81,6 +84,53 @@ enum vpss_csc_color_fmt {
 	XVIDC_CSF_YCRCB_420,
 };
 
+/* xcsc_conv - Conversion applied by the coefficients */
+enum xcsc_conv {
+	XCSC_CONV_IDENTITY = 0,
+	XCSC_CONV_YCRCB_TO_RGB,
+	XCSC_CONV_RGB_TO_YCRCB,
+};
+
+/*
+ * See http://graficaobscura.com/matrix/index.html for how these numbers
+ * are derived. The VPSS CSC IP is derived from this Matrix style algorithm.
+ * And the 'magic' numbers here are derived from the algorithm.
+ *
+ * XV_CSC_DIVISOR is used to help with floating constants while performing
+ * multiplicative operations. The offsets in the last column are for 8 bits
+ * per component and are scaled to the color depth of the core.
+ *
+ * Coefficients valid only for BT 709
+ */
+static const s32 xcsc_coeffs[][3][4] = {
+	/* This represents an identity matrix mutliped by 2^12 */
+	[XCSC_CONV_IDENTITY] = {
+		{ XV_CSC_SCALE_FACTOR, 0, 0, 0 },
+		{ 0, XV_CSC_SCALE_FACTOR, 0, 0 },
+		{ 0, 0, XV_CSC_SCALE_FACTOR, 0 },
+	},
+	[XCSC_CONV_YCRCB_TO_RGB] = {
+		{ 11644 * XV_CSC_SCALE_FACTOR / XV_CSC_DIVISOR, 0,
+		  17927 * XV_CSC_SCALE_FACTOR / XV_CSC_DIVISOR, -248 },
+		{ 11644 * XV_CSC_SCALE_FACTOR / XV_CSC_DIVISOR,
+		  -2132 * XV_CSC_SCALE_FACTOR / XV_CSC_DIVISOR,
+		  -5329 * XV_CSC_SCALE_FACTOR / XV_CSC_DIVISOR, 77 },
+		{ 11644 * XV_CSC_SCALE_FACTOR / XV_CSC_DIVISOR,
+		  21124 * XV_CSC_SCALE_FACTOR / XV_CSC_DIVISOR, 0, -289 },
+	},
+	[XCSC_CONV_RGB_TO_YCRCB] = {
+		{ 1826 * XV_CSC_SCALE_FACTOR / XV_CSC_DIVISOR,
+		  6142 * XV_CSC_SCALE_FACTOR / XV_CSC_DIVISOR,
+		  620 * XV_CSC_SCALE_FACTOR / XV_CSC_DIVISOR, 16 },
+		{ -1006 * XV_CSC_SCALE_FACTOR / XV_CSC_DIVISOR,
+		  -3386 * XV_CSC_SCALE_FACTOR / XV_CSC_DIVISOR,
+		  4392 * XV_CSC_SCALE_FACTOR / XV_CSC_DIVISOR, 128 },
+		{ 4392 * XV_CSC_SCALE_FACTOR / XV_CSC_DIVISOR,
+		  -3989 * XV_CSC_SCALE_FACTOR / XV_CSC_DIVISOR,
+		  -403 * XV_CSC_SCALE_FACTOR / XV_CSC_DIVISOR, 128 },
+	},
+};
+
 /**
  * struct xilinx_csc - Core configuration of csc device structure
  * @base: pointer to register base address
@@ -90,6 +140,7 @@ enum vpss_csc_color_fmt {
  * @cft_out: output color format
  * @color_depth: color depth
  * @k_hw: array of hardware values
+ * @conv: conversion of @k_hw
  * @clip_max: clipping maximum value
  * @width: width of the video
  * @height: height of video
@@ -97,6 +148,8 @@ enum vpss_csc_color_fmt {
  * @max_height: maximum number of lines per frame
  * @rst_gpio: Handle to GPIO specifier to assert/de-assert the reset line
  * @aclk: IP clock struct
+ * @regs: last values written to the configuration registers
+ * @regs_valid: @regs match the registers
  */
 struct xilinx_csc {
 	void __iomem *base;
@@ -106,6 +159,7 @@ struct xilinx_csc {
 	enum vpss_csc_color_fmt cft_out;
 	u32 color_depth;
 	s32 k_hw[3][4];
+	enum xcsc_conv conv;
 	s32 clip_max;
 	u32 width;
 	u32 height;
@@ -113,6 +167,8 @@ struct xilinx_csc {
 	u32 max_height;
 	struct gpio_desc *rst_gpio;
 	struct clk *aclk;
+	u32 regs[XCSC_NUM_REGS];
+	bool regs_valid;
 };
 
 static inline void xilinx_csc_write(void __iomem *base, u32 offset, u32 val)
@@ -120,6 +176,25 @@ static inline void xilinx_csc_write(void __iomem *base, u32 offset, u32 val)
 	writel(val, base + offset);
 }
 
+/*
+ * Only the registers whose value changes are written. The clients commit
+ * through xlnx_bridge_enable() from their modeset, before the core is
+ * started, so there is no vertical blanking to align the writes with. The
+ * core has no double-buffered register set, a client committing to a
+ * running core would have to do it from its vertical blanking.
+ */
+static void xilinx_csc_write_cached(struct xilinx_csc *csc, u32 offset,
+				    u32 val)
+{
+	u32 *reg = &csc->regs[offset / 8];
+
+	if (csc->regs_valid && *reg == val)
+		return;
+
+	*reg = val;
+	xilinx_csc_write(csc->base, offset, val);
+}
+
 static inline u32 xilinx_csc_read(void __iomem *base, u32 offset)
 {
 	return readl(base + offset);
@@ -138,22 +213,22 @@ static inline struct xilinx_csc *bridge_to_layer(struct xlnx_bridge *bridge)
 
 static void xilinx_csc_write_rgb_3x3(struct xilinx_csc *csc)
 {
-	xilinx_csc_write(csc->base, XV_CSC_K11, csc->k_hw[0][0]);
-	xilinx_csc_write(csc->base, XV_CSC_K12, csc->k_hw[0][1]);
-	xilinx_csc_write(csc->base, XV_CSC_K13, csc->k_hw[0][2]);
-	xilinx_csc_write(csc->base, XV_CSC_K21, csc->k_hw[1][0]);
-	xilinx_csc_write(csc->base, XV_CSC_K22, csc->k_hw[1][1]);
-	xilinx_csc_write(csc->base, XV_CSC_K23, csc->k_hw[1][2]);
-	xilinx_csc_write(csc->base, XV_CSC_K31, csc->k_hw[2][0]);
-	xilinx_csc_write(csc->base, XV_CSC_K32, csc->k_hw[2][1]);
-	xilinx_csc_write(csc->base, XV_CSC_K33, csc->k_hw[2][2]);
+	xilinx_csc_write_cached(csc, XV_CSC_K11, csc->k_hw[0][0]);
+	xilinx_csc_write_cached(csc, XV_CSC_K12, csc->k_hw[0][1]);
+	xilinx_csc_write_cached(csc, XV_CSC_K13, csc->k_hw[0][2]);
+	xilinx_csc_write_cached(csc, XV_CSC_K21, csc->k_hw[1][0]);
+	xilinx_csc_write_cached(csc, XV_CSC_K22, csc->k_hw[1][1]);
+	xilinx_csc_write_cached(csc, XV_CSC_K23, csc->k_hw[1][2]);
+	xilinx_csc_write_cached(csc, XV_CSC_K31, csc->k_hw[2][0]);
+	xilinx_csc_write_cached(csc, XV_CSC_K32, csc->k_hw[2][1]);
+	xilinx_csc_write_cached(csc, XV_CSC_K33, csc->k_hw[2][2]);
 }
 
 static void xilinx_csc_write_rgb_offset(struct xilinx_csc *csc)
 {
-	xilinx_csc_write(csc->base, XV_CSC_ROFFSET, csc->k_hw[0][3]);
-	xilinx_csc_write(csc->base, XV_CSC_GOFFSET, csc->k_hw[1][3]);
-	xilinx_csc_write(csc->base, XV_CSC_BOFFSET, csc->k_hw[2][3]);
+	xilinx_csc_write_cached(csc, XV_CSC_ROFFSET, csc->k_hw[0][3]);
+	xilinx_csc_write_cached(csc, XV_CSC_GOFFSET, csc->k_hw[1][3]);
+	xilinx_csc_write_cached(csc, XV_CSC_BOFFSET, csc->k_hw[2][3]);
 }
 
 static void xilinx_csc_write_coeff(struct xilinx_csc *csc)
@@ -162,88 +237,35 @@ static void xilinx_csc_write_coeff(struct xilinx_csc *csc)
 	xilinx_csc_write_rgb_offset(csc);
 }
 
-static void xcsc_set_default_state(struct xilinx_csc *csc)
+/**
+ * xcsc_select_coeff - Selects the coefficients of a conversion
+ * @csc: Pointer to csc device structure
+ * @conv: conversion to apply
+ *
+ * This function copies the precomputed coefficients of @conv, scaling the
+ * offsets to the color depth. The coefficients aren't recomputed if they
+ * already are the ones of @conv.
+ */
+static void xcsc_select_coeff(struct xilinx_csc *csc, enum xcsc_conv conv)
 {
-	csc->cft_in = XVIDC_CSF_YCRCB_422;
-	csc->cft_out = XVIDC_CSF_YCRCB_422;
+	u16 bpc_scale = (1 << (csc->color_depth - 8));
+	int i;
 
-	/* This represents an identity matrix mutliped by 2^12 */
-	csc->k_hw[0][0] = XV_CSC_SCALE_FACTOR;
-	csc->k_hw[0][1] = 0;
-	csc->k_hw[0][2] = 0;
-	csc->k_hw[1][0] = 0;
-	csc->k_hw[1][1] = XV_CSC_SCALE_FACTOR;
-	csc->k_hw[1][2] = 0;
-	csc->k_hw[2][0] = 0;
-	csc->k_hw[2][1] = 0;
-	csc->k_hw[2][2] = XV_CSC_SCALE_FACTOR;
-	csc->k_hw[0][3] = 0;
-	csc->k_hw[1][3] = 0;
-	csc->k_hw[2][3] = 0;
 	csc->clip_max = ((1 << csc->color_depth) - 1);
-	xilinx_csc_write(csc->base, XV_CSC_INVIDEOFORMAT, csc->cft_in);
-	xilinx_csc_write(csc->base, XV_CSC_OUTVIDEOFORMAT, csc->cft_out);
-	xilinx_csc_write_coeff(csc);
-	xilinx_csc_write(csc->base, XV_CSC_CLIPMAX, csc->clip_max);
-	xilinx_csc_write(csc->base, XV_CSC_CLAMPMIN, XCSC_CLAMP_MIN_ZERO);
-}
+	if (csc->conv == conv)
+		return;
 
-static void xcsc_ycrcb_to_rgb(struct xilinx_csc *csc, s32 *clip_max)
-{
-	u16 bpc_scale = (1 << (csc->color_depth - 8));
-	/*
-	 * See http://graficaobscura.com/matrix/index.html for
-	 * how these numbers are derived. The VPSS CSC IP is
-	 * derived from this Matrix style algorithm. And the
-	 * 'magic' numbers here are derived from the algorithm.
-	 *
-	 * XV_CSC_DIVISOR is used to help with floating constants
-	 * while performing multiplicative operations.
-	 *
-	 * Coefficients valid only for BT 709
-	 */
-	csc->k_hw[0][0] = 11644 * XV_CSC_SCALE_FACTOR / XV_CSC_DIVISOR;
-	csc->k_hw[0][1] = 0;
-	csc->k_hw[0][2] = 17927 * XV_CSC_SCALE_FACTOR / XV_CSC_DIVISOR;
-	csc->k_hw[1][0] = 11644 * XV_CSC_SCALE_FACTOR / XV_CSC_DIVISOR;
-	csc->k_hw[1][1] = -2132 * XV_CSC_SCALE_FACTOR / XV_CSC_DIVISOR;
-	csc->k_hw[1][2] = -5329 * XV_CSC_SCALE_FACTOR / XV_CSC_DIVISOR;
-	csc->k_hw[2][0] = 11644 * XV_CSC_SCALE_FACTOR / XV_CSC_DIVISOR;
-	csc->k_hw[2][1] = 21124 * XV_CSC_SCALE_FACTOR / XV_CSC_DIVISOR;
-	csc->k_hw[2][2] = 0;
-	csc->k_hw[0][3] = -248 * bpc_scale;
-	csc->k_hw[1][3] = 77 * bpc_scale;
-	csc->k_hw[2][3] = -289 * bpc_scale;
-	*clip_max = ((1 << csc->color_depth) - 1);
+	memcpy(csc->k_hw, xcsc_coeffs[conv], sizeof(csc->k_hw));
+	for (i = 0; i < 3; i++)
+		csc->k_hw[i][3] *= bpc_scale;
+	csc->conv = conv;
 }
 
-static void xcsc_rgb_to_ycrcb(struct xilinx_csc *csc, s32 *clip_max)
+static void xcsc_set_default_state(struct xilinx_csc *csc)
 {
-	u16 bpc_scale = (1 << (csc->color_depth - 8));
-	/*
-	 * See http://graficaobscura.com/matrix/index.html for
-	 * how these numbers are derived. The VPSS CSC
-	 * derived from this Matrix style algorithm. And the
-	 * 'magic' numbers here are derived from the algorithm.
-	 *
-	 * XV_CSC_DIVISOR is used to help with floating constants
-	 * while performing multiplicative operations.
-	 *
-	 * Coefficients valid only for BT 709
-	 */
-	csc->k_hw[0][0] = 1826 * XV_CSC_SCALE_FACTOR / XV_CSC_DIVISOR;
-	csc->k_hw[0][1] = 6142 * XV_CSC_SCALE_FACTOR / XV_CSC_DIVISOR;
-	csc->k_hw[0][2] = 620 * XV_CSC_SCALE_FACTOR / XV_CSC_DIVISOR;
-	csc->k_hw[1][0] = -1006 * XV_CSC_SCALE_FACTOR / XV_CSC_DIVISOR;
-	csc->k_hw[1][1] = -3386 * XV_CSC_SCALE_FACTOR / XV_CSC_DIVISOR;
-	csc->k_hw[1][2] = 4392 * XV_CSC_SCALE_FACTOR / XV_CSC_DIVISOR;
-	csc->k_hw[2][0] = 4392 * XV_CSC_SCALE_FACTOR / XV_CSC_DIVISOR;
-	csc->k_hw[2][1] = -3989 * XV_CSC_SCALE_FACTOR / XV_CSC_DIVISOR;
-	csc->k_hw[2][2] = -403 * XV_CSC_SCALE_FACTOR / XV_CSC_DIVISOR;
-	csc->k_hw[0][3] = 16 * bpc_scale;
-	csc->k_hw[1][3] = 128 * bpc_scale;
-	csc->k_hw[2][3] = 128 * bpc_scale;
-	*clip_max = ((1 << csc->color_depth) - 1);
+	csc->cft_in = XVIDC_CSF_YCRCB_422;
+	csc->cft_out = XVIDC_CSF_YCRCB_422;
+	xcsc_select_coeff(csc, XCSC_CONV_IDENTITY);
 }
 
 /**
@@ -255,11 +277,12 @@ static void xcsc_rgb_to_ycrcb(struct xilinx_csc *csc, s32 *clip_max)
  */
 static void xcsc_set_coeff(struct xilinx_csc *csc)
 {
-	xilinx_csc_write(csc->base, XV_CSC_INVIDEOFORMAT, csc->cft_in);
-	xilinx_csc_write(csc->base, XV_CSC_OUTVIDEOFORMAT, csc->cft_out);
+	xilinx_csc_write_cached(csc, XV_CSC_INVIDEOFORMAT, csc->cft_in);
+	xilinx_csc_write_cached(csc, XV_CSC_OUTVIDEOFORMAT, csc->cft_out);
 	xilinx_csc_write_coeff(csc);
-	xilinx_csc_write(csc->base, XV_CSC_CLIPMAX, csc->clip_max);
-	xilinx_csc_write(csc->base, XV_CSC_CLAMPMIN, XCSC_CLAMP_MIN_ZERO);
+	xilinx_csc_write_cached(csc, XV_CSC_CLIPMAX, csc->clip_max);
+	xilinx_csc_write_cached(csc, XV_CSC_CLAMPMIN, XCSC_CLAMP_MIN_ZERO);
+	csc->regs_valid = true;
 }
 
 /**
@@ -294,6 +317,7 @@ static void xilinx_csc_bridge_disable(struct xlnx_bridge *bridge)
 	/* Reset the Global IP Reset through GPIO */
 	gpiod_set_value_cansleep(csc->rst_gpio, XCSC_RESET_ASSERT);
 	gpiod_set_value_cansleep(csc->rst_gpio, XCSC_RESET_DEASSERT);
+	csc->regs_valid = false;
 }
 
 /**
@@ -303,7 +327,8 @@ static void xilinx_csc_bridge_disable(struct xlnx_bridge *bridge)
  * @height: height of video
  * @bus_fmt: video bus format
  *
- * This function sets the input parameters of csc
+ * This function sets the input parameters of csc, they are written by
+ * xilinx_csc_bridge_commit()
  * Return: 0 on success. -EINVAL for invalid parameters.
  */
 static int xilinx_csc_bridge_set_input(struct xlnx_bridge *bridge, u32 width,
@@ -340,9 +365,6 @@ static int xilinx_csc_bridge_set_input(struct xlnx_bridge *bridge, u32 width,
 		return -EINVAL;
 	}
 
-	xilinx_csc_write(csc->base, XV_CSC_WIDTH, width);
-	xilinx_csc_write(csc->base, XV_CSC_HEIGHT, height);
-
 	return 0;
 }
 
@@ -371,7 +393,8 @@ static int xilinx_csc_bridge_get_input_fmts(struct xlnx_bridge *bridge,
  * @height: height of video
  * @bus_fmt: video bus format
  *
- * This function sets the output parameters of csc
+ * This function sets the output parameters of csc, they are written by
+ * xilinx_csc_bridge_commit()
  * Return: 0 on success. -EINVAL for invalid parameters.
  */
 static int xilinx_csc_bridge_set_output(struct xlnx_bridge *bridge, u32 width,
@@ -386,31 +409,48 @@ static int xilinx_csc_bridge_set_output(struct xlnx_bridge *bridge, u32 width,
 	case MEDIA_BUS_FMT_RGB888_1X24:
 		csc->cft_out = XVIDC_CSF_RGB;
 		dev_dbg(csc->dev, "Media Format Out : RGB");
-		if (csc->cft_in != MEDIA_BUS_FMT_RBG888_1X24)
-			xcsc_ycrcb_to_rgb(csc, &csc->clip_max);
 		break;
 	case MEDIA_BUS_FMT_VUY8_1X24:
 		csc->cft_out = XVIDC_CSF_YCRCB_444;
 		dev_dbg(csc->dev, "Media Format Out : YUV 444");
-		if (csc->cft_in == MEDIA_BUS_FMT_RBG888_1X24)
-			xcsc_rgb_to_ycrcb(csc, &csc->clip_max);
 		break;
 	case MEDIA_BUS_FMT_UYVY8_1X16:
 		csc->cft_out = XVIDC_CSF_YCRCB_422;
 		dev_dbg(csc->dev, "Media Format Out : YUV 422");
-		if (csc->cft_in == MEDIA_BUS_FMT_RBG888_1X24)
-			xcsc_rgb_to_ycrcb(csc, &csc->clip_max);
 		break;
 	case MEDIA_BUS_FMT_VYYUYY8_1X24:
 		csc->cft_out = XVIDC_CSF_YCRCB_420;
 		dev_dbg(csc->dev, "Media Format Out : YUV 420");
-		if (csc->cft_in == MEDIA_BUS_FMT_RBG888_1X24)
-			xcsc_rgb_to_ycrcb(csc, &csc->clip_max);
 		break;
 	default:
 		dev_info(csc->dev, "unsupported output video format\n");
 		return -EINVAL;
 	}
+
+	if ((csc->cft_in == XVIDC_CSF_RGB) == (csc->cft_out == XVIDC_CSF_RGB))
+		xcsc_select_coeff(csc, XCSC_CONV_IDENTITY);
+	else if (csc->cft_out == XVIDC_CSF_RGB)
+		xcsc_select_coeff(csc, XCSC_CONV_YCRCB_TO_RGB);
+	else
+		xcsc_select_coeff(csc, XCSC_CONV_RGB_TO_YCRCB);
+
+	return 0;
+}
+
+/**
+ * xilinx_csc_bridge_commit - Writes the parameters of csc
+ * @bridge: bridge instance
+ *
+ * This function writes the input and output parameters of csc. It's called
+ * by xlnx_bridge_enable() before the core is started.
+ * Return: 0 on success.
+ */
+static int xilinx_csc_bridge_commit(struct xlnx_bridge *bridge)
+{
+	struct xilinx_csc *csc = bridge_to_layer(bridge);
+
+	xilinx_csc_write_cached(csc, XV_CSC_WIDTH, csc->width);
+	xilinx_csc_write_cached(csc, XV_CSC_HEIGHT, csc->height);
 	xcsc_set_coeff(csc);
 
 	return 0;
@@ -509,6 +549,9 @@ static int xilinx_csc_probe(struct platform_device *pdev)
 	if (ret < 0)
 		return ret;
 
+	memcpy(csc->k_hw, xcsc_coeffs[XCSC_CONV_IDENTITY], sizeof(csc->k_hw));
+	csc->conv = XCSC_CONV_IDENTITY;
+
 	ret = clk_prepare_enable(csc->aclk);
 	if (ret) {
 		dev_err(csc->dev, "failed to enable clock %d\n", ret);
@@ -522,6 +565,7 @@ static int xilinx_csc_probe(struct platform_device *pdev)
 	csc->bridge.get_input_fmts = &xilinx_csc_bridge_get_input_fmts;
 	csc->bridge.set_output = &xilinx_csc_bridge_set_output;
 	csc->bridge.get_output_fmts = &xilinx_csc_bridge_get_output_fmts;
+	csc->bridge.commit = &xilinx_csc_bridge_commit;
 	csc->bridge.of_node = dev->of_node;
 
 	ret = xlnx_bridge_register(&csc->bridge);
@@ -450,6 +450,28 @@ struct xlnx_dp_tx_link_config {
 	u8 pe_level;
 };
 
+/**
+ * struct xlnx_dp_train_cache - Result of the last successful link training
+ * @link_rate: link rate requested when the link was trained
+ * @lane_count: lane count requested when the link was trained
+ * @bw_code: trained link rate
+ * @lane_cnt: trained number of lanes
+ * @vs_level: trained voltage swing level
+ * @pe_level: trained pre emphasis level
+ * @valid: the cache holds a result for the connected sink
+ * @restore: the link is being restored from the cache
+ */
+struct xlnx_dp_train_cache {
+	int link_rate;
+	u8 lane_count;
+	u8 bw_code;
+	u8 lane_cnt;
+	u8 vs_level;
+	u8 pe_level;
+	bool valid;
+	bool restore;
+};
+
 /**
  * struct xlnx_dp_mode - Configured mode of DisplayPort
  * @pclock: pixel clock frequency of current mode
@@ -536,6 +558,7 @@ enum xlnx_dp_train_state {
  * @vtc_off: VTC sub-core offset address
  * @dpcd: DP configuration data from currently connected sink device
  * @train_set: set of training data
+ * @train_cache: last successful training, used to restore the link quickly
  * @num_lanes: number of enabled phy lanes
  * @enabled: flag to indicate if the device is enabled
  * @audio_init: flag to indicate audio is initialized
@@ -576,6 +599,7 @@ struct xlnx_dp {
 	u32 vtc_off;
 	u8 dpcd[DP_RECEIVER_CAP_SIZE];
 	u8 train_set[XDPTX_MAX_LANES];
+	struct xlnx_dp_train_cache train_cache;
 	u8 num_lanes;
 	unsigned int enabled : 1;
 	bool audio_init;
@@ -1579,9 +1603,17 @@ static int xlnx_dp_link_train_cr(struct xlnx_dp *dp)
 	u8 lane_cnt = dp->mode.lane_cnt;
 	bool cr_done = 0;
 
-	/* start from minimal vs and pe levels */
-	dp->tx_link_config.vs_level = 0;
-	dp->tx_link_config.pe_level = 0;
+	/*
+	 * start from minimal vs and pe levels, or from the trained ones when
+	 * restoring a link, which normally locks on the first attempt.
+	 */
+	if (dp->train_cache.restore) {
+		dp->tx_link_config.vs_level = dp->train_cache.vs_level;
+		dp->tx_link_config.pe_level = dp->train_cache.pe_level;
+	} else {
+		dp->tx_link_config.vs_level = 0;
+		dp->tx_link_config.pe_level = 0;
+	}
 
 	ret = xlnx_dp_set_train_patttern(dp, DP_TRAINING_PATTERN_1);
 	if (ret < 0)
@@ -1856,7 +1888,9 @@ static int xlnx_dp_link_train_ce(struct xlnx_dp *dp)
  * channel equalization sequence failed, the link rate or the number of lanes
  * used will be reduced and training will be re-attempted. If training fails
  * at the minimal data rate, 1.62 Gbps with a single lane, training will no
- * longer re-attempt and fail.
+ * longer re-attempt and fail. A link restore from the cached training values
+ * doesn't reduce the link rate or lane count, it fails instead so the link
+ * can be fully retrained.
  *
  * Return: 0 if the training process succeeded.
  * error value on training failure.
@@ -1904,6 +1938,11 @@ static int xlnx_dp_run_training(struct xlnx_dp *dp)
 					"failed to disable training pattern\n");
 				goto err_out;
 			}
+			if (dp->train_cache.restore) {
+				config->cr_done_oldstate = config->max_lanes;
+				config->cr_done_cnt = config->max_lanes;
+				return -EAGAIN;
+			}
 		}
 	}
 
@@ -2422,6 +2461,7 @@ static void xlnx_dp_start(struct xlnx_dp *dp)
 {
 	struct xlnx_dp_mode *mode = &dp->mode;
 	struct xlnx_hdcptx *dptxhdcp = &dp->tx_hdcp;
+	struct xlnx_dp_train_cache *cache = &dp->train_cache;
 	int link_rate = dp->link_config.link_rate;
 	int ret = 0;
 	u32 val, intr_mask;
@@ -2432,6 +2472,14 @@ static void xlnx_dp_start(struct xlnx_dp *dp)
 	mode->lane_cnt = dp->link_config.lane_count;
 	dp->link_config.cr_done_oldstate = dp->link_config.max_lanes;
 
+	/* Restore the link trained last time for the same configuration */
+	cache->restore = cache->valid && cache->link_rate == link_rate &&
+			 cache->lane_count == mode->lane_cnt;
+	if (cache->restore) {
+		mode->bw_code = cache->bw_code;
+		mode->lane_cnt = cache->lane_cnt;
+	}
+
 	xlnx_dp_init_aux(dp);
 	if (dp->status != connector_status_connected) {
 		dev_info(dp->dev, "Display not connected\n");
@@ -2519,6 +2567,18 @@ static void xlnx_dp_start(struct xlnx_dp *dp)
 	memset(dp->train_set, 0, XDPTX_MAX_LANES);
 
 	ret = xlnx_dp_run_training(dp);
+	if (ret < 0 && cache->restore) {
+		dev_dbg(dp->dev, "link restore failed, retraining the link\n");
+		cache->restore = false;
+		cache->valid = false;
+		mode->lane_cnt = dp->link_config.lane_count;
+		ret = xlnx_dp_set_linkrate(dp, drm_dp_link_rate_to_bw_code(link_rate));
+		if (!ret)
+			ret = xlnx_dp_set_lanecount(dp, mode->lane_cnt);
+		if (!ret)
+			ret = xlnx_dp_run_training(dp);
+	}
+	cache->restore = false;
 	if (ret < 0) {
 		dev_err(dp->dev, "DP Link Training Failed\n");
 		return;
@@ -2530,6 +2590,14 @@ static void xlnx_dp_start(struct xlnx_dp *dp)
 		return;
 	}
 
+	cache->link_rate = link_rate;
+	cache->lane_count = dp->link_config.lane_count;
+	cache->bw_code = mode->bw_code;
+	cache->lane_cnt = mode->lane_cnt;
+	cache->vs_level = dp->tx_link_config.vs_level;
+	cache->pe_level = dp->tx_link_config.pe_level;
+	cache->valid = true;
+
 	/* re-enable main link after training if required */
 	if (val)
 		xlnx_dp_mainlink_en(dp, 0x1);
@@ -2769,6 +2837,8 @@ xlnx_dp_connector_detect(struct drm_connector *connector, bool force)
 	return connector_status_connected;
 disconnected:
 	dp->status = connector_status_disconnected;
+	/* The next sink may need different training values */
+	dp->train_cache.valid = false;
 	if (dp->enabled)
 		xlnx_dp_stop(dp);
 
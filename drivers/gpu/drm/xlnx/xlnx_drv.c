@@ -22,6 +22,7 @@
 #include <drm/drm_atomic.h>
 #include <drm/drm_atomic_helper.h>
 #include <drm/drm_crtc_helper.h>
+#include <drm/drm_fb_dma_helper.h>
 #include <drm/drm_fb_helper.h>
 #include <drm/drm_gem_dma_helper.h>
 #include <drm/drm_of.h>
@@ -119,13 +120,62 @@ static void xlnx_output_poll_changed(struct drm_device *drm)
 		drm_fb_helper_hotplug_event(xlnx_drm->fb);
 }
 
+/*
+ * A CRTC may take some mode changes on the fly. Their mode_changed has to be
+ * dropped before drm_atomic_helper_check_modeset(), which pulls the encoders
+ * and connectors of a modeset into the state and runs their checks. The mode
+ * fixups only run for a modeset, so the requested mode is used as is.
+ */
+static int xlnx_atomic_check(struct drm_device *drm,
+			     struct drm_atomic_state *state)
+{
+	struct drm_crtc_state *old_state, *new_state;
+	struct drm_crtc *crtc;
+	int i;
+
+	for_each_oldnew_crtc_in_state(state, crtc, old_state, new_state, i) {
+		struct xlnx_crtc *xlnx_crtc = to_xlnx_crtc(crtc);
+
+		if (!xlnx_crtc->mode_seamless || !new_state->mode_changed ||
+		    new_state->active_changed || !new_state->active)
+			continue;
+
+		if (!xlnx_crtc->mode_seamless(xlnx_crtc, old_state, new_state))
+			continue;
+
+		new_state->mode_changed = false;
+		drm_mode_copy(&new_state->adjusted_mode, &new_state->mode);
+	}
+
+	return drm_atomic_helper_check(drm, state);
+}
+
 static const struct drm_mode_config_funcs xlnx_mode_config_funcs = {
 	.fb_create		= xlnx_fb_create,
 	.output_poll_changed	= xlnx_output_poll_changed,
-	.atomic_check		= drm_atomic_helper_check,
+	.atomic_check		= xlnx_atomic_check,
 	.atomic_commit		= drm_atomic_helper_commit,
 };
 
+static void xlnx_atomic_commit_tail(struct drm_atomic_state *state)
+{
+	struct drm_plane_state *old_state, *new_state;
+	struct drm_plane *plane;
+	int i;
+
+	/* Flush the CPU writes to cached buffers before they are scanned out */
+	for_each_oldnew_plane_in_state(state, plane, old_state, new_state, i)
+		if (new_state->fb)
+			drm_fb_dma_sync_non_coherent(state->dev, old_state,
+						     new_state);
+
+	drm_atomic_helper_commit_tail(state);
+}
+
+static const struct drm_mode_config_helper_funcs xlnx_mode_config_helper_funcs = {
+	.atomic_commit_tail	= xlnx_atomic_commit_tail,
+};
+
 static void xlnx_mode_config_init(struct drm_device *drm)
 {
 	struct xlnx_drm *xlnx_drm = drm->dev_private;
@@ -199,6 +249,7 @@ static struct drm_driver xlnx_drm_driver = {
 	.lastclose			= xlnx_lastclose,
 
 	DRM_GEM_DMA_DRIVER_OPS_VMAP_WITH_DUMB_CREATE(xlnx_gem_cma_dumb_create),
+	.gem_prime_import		= xlnx_gem_prime_import,
 
 	.fops				= &xlnx_fops,
 
@@ -231,6 +282,7 @@ static int xlnx_bind(struct device *dev)
 
 	drm_mode_config_init(drm);
 	drm->mode_config.funcs = &xlnx_mode_config_funcs;
+	drm->mode_config.helper_private = &xlnx_mode_config_helper_funcs;
 
 	ret = drm_vblank_init(drm, MAX_CRTC);
 	if (ret) {
@@ -492,6 +492,24 @@ static ssize_t xlnx_dsi_host_transfer(struct mipi_dsi_host *host,
 	return msg->tx_len;
 }
 
+/**
+ * xlnx_dsi_set_panel_defaults - Set the video mode requested by the panel
+ * @dsi: DSI structure
+ *
+ * A panel flagged for burst mode gets the burst video mode by default, the
+ * pixels of a line are sent in a shorter HS burst and the lanes are in LP
+ * mode for the rest of the line instead of sending blanking packets in HS.
+ * The user can still override both from the connector properties.
+ */
+static void xlnx_dsi_set_panel_defaults(struct xlnx_dsi *dsi)
+{
+	if (!(dsi->mode_flags & MIPI_DSI_MODE_VIDEO_BURST))
+		return;
+
+	dsi->video_mode_prop_val = XDSI_VIDEO_MODE_BURST;
+	dsi->bllp_mode_prop_val = true;
+}
+
 static int xlnx_dsi_host_attach(struct mipi_dsi_host *host,
 				struct mipi_dsi_device *device)
 {
@@ -520,6 +538,8 @@ static int xlnx_dsi_host_attach(struct mipi_dsi_host *host,
 		return -EINVAL;
 	}
 
+	xlnx_dsi_set_panel_defaults(dsi);
+
 	if (dsi->connector.dev)
 		drm_helper_hpd_irq_event(dsi->connector.dev);
 
@@ -688,7 +708,8 @@ static void xlnx_dsi_connector_attach_property(struct drm_connector *connector)
 		drm_object_attach_property(obj, dsi->eotp_prop, 1);
 
 	if (dsi->video_mode_prop)
-		drm_object_attach_property(obj, dsi->video_mode_prop, 0);
+		drm_object_attach_property(obj, dsi->video_mode_prop,
+					   dsi->video_mode_prop_val);
 
 	if (dsi->bllp_burst_time_prop)
 		drm_object_attach_property(&connector->base,
@@ -696,7 +717,8 @@ static void xlnx_dsi_connector_attach_property(struct drm_connector *connector)
 
 	if (dsi->bllp_mode_prop)
 		drm_object_attach_property(&connector->base,
-					   dsi->bllp_mode_prop, 0);
+					   dsi->bllp_mode_prop,
+					   dsi->bllp_mode_prop_val);
 
 	if (dsi->bllp_type_prop)
 		drm_object_attach_property(&connector->base,
@@ -24,11 +24,15 @@
 #include <drm/drm_fourcc.h>
 #include <drm/drm_crtc.h>
 #include <drm/drm_crtc_helper.h>
+#include <drm/drm_fb_dma_helper.h>
 #include <drm/drm_fb_helper.h>
 #include <drm/drm_framebuffer.h>
 #include <drm/drm_gem_dma_helper.h>
 #include <drm/drm_gem_framebuffer_helper.h>
 
+#include <linux/module.h>
+#include <linux/vmalloc.h>
+
 #include "xlnx_crtc.h"
 #include "xlnx_drv.h"
 #include "xlnx_fb.h"
@@ -61,9 +65,24 @@ xlnx_fb_create(struct drm_device *drm, struct drm_file *file_priv,
 
 #ifdef CONFIG_DRM_FBDEV_EMULATION
 
+static bool xlnx_fbdev_shadow;
+module_param_named(fbdev_shadow, xlnx_fbdev_shadow, bool, 0444);
+MODULE_PARM_DESC(fbdev_shadow,
+		 "fbdev draws in a cached shadow buffer, copied to the scanout buffer on damage (default: 0)");
+
+/**
+ * struct xlnx_fbdev - Xilinx fbdev emulation
+ * @fb_helper: fb helper structure
+ * @fb: scanout framebuffer
+ * @shadow: cached shadow buffer fbdev clients draw in, or NULL if they draw
+ *	    in the scanout buffer
+ * @align: alignment value for pitch
+ * @vres_mult: multiplier for virtual resolution
+ */
 struct xlnx_fbdev {
 	struct drm_fb_helper fb_helper;
 	struct drm_framebuffer *fb;
+	void *shadow;
 	unsigned int align;
 	unsigned int vres_mult;
 };
@@ -113,6 +132,124 @@ static struct fb_ops xlnx_fbdev_ops = {
 	.fb_ioctl	= xlnx_fb_ioctl,
 };
 
+/*
+ * The fb helper accumulates the damage of the drawing ops and of the pages
+ * written through the deferred I/O mapping, and flushes it here.
+ */
+static int xlnx_fbdev_fb_dirty(struct drm_framebuffer *fb,
+			       struct drm_file *file_priv, unsigned int flags,
+			       unsigned int color, struct drm_clip_rect *clips,
+			       unsigned int num_clips)
+{
+	struct xlnx_fbdev *fbdev = to_fbdev(fb->dev->fb_helper);
+	struct drm_gem_dma_object *obj = drm_fb_dma_get_gem_obj(fb, 0);
+	unsigned int cpp = fb->format->cpp[0];
+	unsigned int i, x1, x2, y;
+	size_t offset;
+
+	for (i = 0; i < num_clips; i++) {
+		x1 = min_t(unsigned int, clips[i].x1, fb->width);
+		x2 = min_t(unsigned int, clips[i].x2, fb->width);
+		if (x1 >= x2)
+			continue;
+
+		for (y = clips[i].y1; y < min_t(unsigned int, clips[i].y2,
+						fb->height); y++) {
+			offset = (size_t)y * fb->pitches[0] + x1 * cpp;
+			memcpy(obj->vaddr + offset, fbdev->shadow + offset,
+			       (x2 - x1) * cpp);
+		}
+	}
+
+	return 0;
+}
+
+static struct drm_framebuffer_funcs xlnx_fbdev_shadow_fb_funcs = {
+	.destroy	= drm_gem_fb_destroy,
+	.create_handle	= drm_gem_fb_create_handle,
+	.dirty		= xlnx_fbdev_fb_dirty,
+};
+
+static int xlnx_fb_shadow_pan_display(struct fb_var_screeninfo *var,
+				      struct fb_info *info)
+{
+	struct drm_fb_helper *fb_helper = info->par;
+
+	/* Clients panning to flip buffers expect the new one to be shown */
+	flush_delayed_work(&info->deferred_work);
+	flush_work(&fb_helper->damage_work);
+
+	return drm_fb_helper_pan_display(var, info);
+}
+
+static struct fb_ops xlnx_fbdev_shadow_ops = {
+	.owner		= THIS_MODULE,
+	.fb_read	= drm_fb_helper_sys_read,
+	.fb_write	= drm_fb_helper_sys_write,
+	.fb_fillrect	= drm_fb_helper_sys_fillrect,
+	.fb_copyarea	= drm_fb_helper_sys_copyarea,
+	.fb_imageblit	= drm_fb_helper_sys_imageblit,
+	.fb_check_var	= drm_fb_helper_check_var,
+	.fb_set_par	= drm_fb_helper_set_par,
+	.fb_blank	= drm_fb_helper_blank,
+	.fb_pan_display	= xlnx_fb_shadow_pan_display,
+	.fb_setcmap	= drm_fb_helper_setcmap,
+	.fb_ioctl	= xlnx_fb_ioctl,
+	.fb_mmap	= fb_deferred_io_mmap,
+};
+
+/**
+ * xlnx_fbdev_shadow_init - Make the fbdev clients draw in a shadow buffer
+ * @fbdev: Xilinx fbdev
+ * @fbi: fb_info struct
+ * @bytes: size of the scanout buffer
+ *
+ * The scanout buffer is write-combined, so the pixel reads of the drawing
+ * ops and mmap clients are very slow. They work on a cached copy instead,
+ * and the damaged areas are copied to the scanout buffer.
+ *
+ * Return: 0 if successful, or the error code.
+ */
+static int xlnx_fbdev_shadow_init(struct xlnx_fbdev *fbdev,
+				  struct fb_info *fbi, size_t bytes)
+{
+	struct fb_deferred_io *fbdefio;
+	int ret;
+
+	fbdev->shadow = vzalloc(bytes);
+	if (!fbdev->shadow)
+		return -ENOMEM;
+
+	fbdefio = kzalloc(sizeof(*fbdefio), GFP_KERNEL);
+	if (!fbdefio) {
+		ret = -ENOMEM;
+		goto err_vfree;
+	}
+
+	fbdefio->delay = HZ / 20;
+	fbdefio->deferred_io = drm_fb_helper_deferred_io;
+	fbi->fbdefio = fbdefio;
+	fbi->fbops = &xlnx_fbdev_shadow_ops;
+	fbi->flags |= FBINFO_VIRTFB;
+	fbi->screen_buffer = fbdev->shadow;
+	/* The physical address of the scanout buffer isn't what is mapped */
+	fbi->fix.smem_start = 0;
+
+	ret = fb_deferred_io_init(fbi);
+	if (ret)
+		goto err_kfree;
+
+	return 0;
+
+err_kfree:
+	fbi->fbdefio = NULL;
+	kfree(fbdefio);
+err_vfree:
+	vfree(fbdev->shadow);
+	fbdev->shadow = NULL;
+	return ret;
+}
+
 static struct drm_framebuffer *
 xlnx_fb_gem_fb_alloc(struct drm_device *drm,
 		     const struct drm_mode_fb_cmd2 *mode_cmd,
@@ -216,7 +353,9 @@ static int xlnx_fbdev_create(struct drm_fb_helper *fb_helper,
 		size->surface_depth = info->depth;
 
 	fbdev->fb = xlnx_fb_gem_fbdev_fb_create(drm, size, fbdev->align,
-						&obj->base, &xlnx_fb_funcs);
+						&obj->base, xlnx_fbdev_shadow ?
+						&xlnx_fbdev_shadow_fb_funcs :
+						&xlnx_fb_funcs);
 	if (IS_ERR(fbdev->fb)) {
 		dev_err(drm->dev, "Failed to allocate DRM framebuffer.\n");
 		ret = PTR_ERR(fbdev->fb);
@@ -247,8 +386,18 @@ static int xlnx_fbdev_create(struct drm_fb_helper *fb_helper,
 	fbi->screen_size = bytes;
 	fbi->fix.smem_len = bytes;
 
+	if (xlnx_fbdev_shadow) {
+		ret = xlnx_fbdev_shadow_init(fbdev, fbi, bytes);
+		if (ret) {
+			dev_err(drm->dev, "Failed to set up shadow buffer.\n");
+			goto err_dealloc_cmap;
+		}
+	}
+
 	return 0;
 
+err_dealloc_cmap:
+	fb_dealloc_cmap(&fbi->cmap);
 err_fb_destroy:
 	drm_framebuffer_unregister_private(fb);
 	drm_gem_fb_destroy(fb);
@@ -327,7 +476,6 @@ static void xlnx_fbdev_defio_fini(struct fb_info *fbi)
 
 	fb_deferred_io_cleanup(fbi);
 	kfree(fbi->fbdefio);
-	kfree(fbi->fbops);
 }
 
 /**
@@ -344,10 +492,14 @@ void xlnx_fb_fini(struct drm_fb_helper *fb_helper)
 	if (fbdev->fb_helper.fbdev)
 		xlnx_fbdev_defio_fini(fbdev->fb_helper.fbdev);
 
+	/* The damage flush copies from the shadow to the framebuffer */
+	cancel_work_sync(&fbdev->fb_helper.damage_work);
+
 	if (fbdev->fb_helper.fb)
 		drm_framebuffer_remove(fbdev->fb_helper.fb);
 
 	drm_fb_helper_fini(&fbdev->fb_helper);
+	vfree(fbdev->shadow);
 	kfree(fbdev);
 }
 
@@ -17,11 +17,189 @@
  */
 
 #include <drm/drm_drv.h>
+#include <drm/drm_gem.h>
 #include <drm/drm_gem_dma_helper.h>
+#include <drm/drm_prime.h>
+#include <drm/drm_print.h>
+
+#include <linux/dma-buf.h>
+#include <linux/dma-mapping.h>
+#include <linux/module.h>
+#include <linux/slab.h>
 
 #include "xlnx_drv.h"
 #include "xlnx_gem.h"
 
+static bool xlnx_gem_cached;
+module_param_named(gem_cached, xlnx_gem_cached, bool, 0444);
+MODULE_PARM_DESC(gem_cached,
+		 "CPU cached dumb buffers, synced before scanout (default: 0)");
+
+static int xlnx_gem_begin_cpu_access_partial(struct dma_buf *dmabuf,
+					     enum dma_data_direction dir,
+					     size_t offset, size_t len)
+{
+	struct drm_gem_object *obj = dmabuf->priv;
+	struct drm_gem_dma_object *dma_obj = to_drm_gem_dma_obj(obj);
+
+	dma_sync_single_range_for_cpu(obj->dev->dev, dma_obj->dma_addr, offset,
+				      len, dir);
+
+	return 0;
+}
+
+static int xlnx_gem_end_cpu_access_partial(struct dma_buf *dmabuf,
+					   enum dma_data_direction dir,
+					   size_t offset, size_t len)
+{
+	struct drm_gem_object *obj = dmabuf->priv;
+	struct drm_gem_dma_object *dma_obj = to_drm_gem_dma_obj(obj);
+
+	dma_sync_single_range_for_device(obj->dev->dev, dma_obj->dma_addr,
+					 offset, len, dir);
+
+	return 0;
+}
+
+static int xlnx_gem_begin_cpu_access(struct dma_buf *dmabuf,
+				     enum dma_data_direction dir)
+{
+	return xlnx_gem_begin_cpu_access_partial(dmabuf, dir, 0, dmabuf->size);
+}
+
+static int xlnx_gem_end_cpu_access(struct dma_buf *dmabuf,
+				   enum dma_data_direction dir)
+{
+	return xlnx_gem_end_cpu_access_partial(dmabuf, dir, 0, dmabuf->size);
+}
+
+/*
+ * The PRIME helpers with CPU access hooks, so that user space mapping a
+ * cached buffer through its dma-buf can sync the range it touched.
+ */
+static const struct dma_buf_ops xlnx_gem_cached_dmabuf_ops = {
+	.cache_sgt_mapping	= true,
+	.attach			= drm_gem_map_attach,
+	.detach			= drm_gem_map_detach,
+	.map_dma_buf		= drm_gem_map_dma_buf,
+	.unmap_dma_buf		= drm_gem_unmap_dma_buf,
+	.release		= drm_gem_dmabuf_release,
+	.mmap			= drm_gem_dmabuf_mmap,
+	.vmap			= drm_gem_dmabuf_vmap,
+	.vunmap			= drm_gem_dmabuf_vunmap,
+	.begin_cpu_access	= xlnx_gem_begin_cpu_access,
+	.end_cpu_access		= xlnx_gem_end_cpu_access,
+	.begin_cpu_access_partial = xlnx_gem_begin_cpu_access_partial,
+	.end_cpu_access_partial	= xlnx_gem_end_cpu_access_partial,
+};
+
+static struct dma_buf *xlnx_gem_cached_export(struct drm_gem_object *obj,
+					      int flags)
+{
+	struct drm_device *drm = obj->dev;
+	struct dma_buf_export_info exp_info = {
+		.exp_name = KBUILD_MODNAME,
+		.owner = drm->driver->fops->owner,
+		.ops = &xlnx_gem_cached_dmabuf_ops,
+		.size = obj->size,
+		.flags = flags,
+		.priv = obj,
+		.resv = obj->resv,
+	};
+
+	return drm_gem_dmabuf_export(drm, &exp_info);
+}
+
+/*
+ * xlnx_gem_prime_import - (struct drm_driver)->gem_prime_import callback
+ * @drm: DRM object
+ * @dma_buf: dma-buf to import
+ *
+ * Cached objects are exported with their own dma_buf_ops, which
+ * drm_gem_prime_import() doesn't recognize as its own. Take a reference on
+ * the object instead of importing our own buffer as a new one.
+ *
+ * Return: The GEM object, or an error pointer
+ */
+struct drm_gem_object *xlnx_gem_prime_import(struct drm_device *drm,
+					     struct dma_buf *dma_buf)
+{
+	struct drm_gem_object *obj = dma_buf->priv;
+
+	if (dma_buf->ops == &xlnx_gem_cached_dmabuf_ops && obj->dev == drm) {
+		drm_gem_object_get(obj);
+		return obj;
+	}
+
+	return drm_gem_prime_import(drm, dma_buf);
+}
+
+static const struct drm_gem_object_funcs xlnx_gem_cached_funcs = {
+	.free		= drm_gem_dma_object_free,
+	.print_info	= drm_gem_dma_object_print_info,
+	.get_sg_table	= drm_gem_dma_object_get_sg_table,
+	.vmap		= drm_gem_dma_object_vmap,
+	.mmap		= drm_gem_dma_object_mmap,
+	.vm_ops		= &drm_gem_dma_vm_ops,
+	.export		= xlnx_gem_cached_export,
+};
+
+/*
+ * xlnx_gem_create_cached - Allocate a CPU cached DMA GEM object
+ * @drm: DRM object
+ * @size: size of the buffer
+ *
+ * The object is a regular DMA GEM object with map_noncoherent set, so it is
+ * mapped cached to user space and freed by the DMA GEM helpers. It is only
+ * used for dumb buffers, whose updates go through an atomic commit that
+ * syncs them for the device.
+ *
+ * Return: The DMA GEM object, or an error pointer
+ */
+static struct drm_gem_dma_object *
+xlnx_gem_create_cached(struct drm_device *drm, size_t size)
+{
+	struct drm_gem_dma_object *dma_obj;
+	struct drm_gem_object *obj;
+	int ret;
+
+	size = round_up(size, PAGE_SIZE);
+
+	dma_obj = kzalloc(sizeof(*dma_obj), GFP_KERNEL);
+	if (!dma_obj)
+		return ERR_PTR(-ENOMEM);
+
+	obj = &dma_obj->base;
+	obj->funcs = &xlnx_gem_cached_funcs;
+	dma_obj->map_noncoherent = true;
+
+	ret = drm_gem_object_init(drm, obj, size);
+	if (ret) {
+		kfree(dma_obj);
+		return ERR_PTR(ret);
+	}
+
+	ret = drm_gem_create_mmap_offset(obj);
+	if (ret)
+		goto err_put;
+
+	dma_obj->vaddr = dma_alloc_noncoherent(drm->dev, size,
+					       &dma_obj->dma_addr,
+					       DMA_TO_DEVICE,
+					       GFP_KERNEL | __GFP_NOWARN);
+	if (!dma_obj->vaddr) {
+		drm_dbg(drm, "failed to allocate buffer with size %zu\n", size);
+		ret = -ENOMEM;
+		goto err_put;
+	}
+
+	return dma_obj;
+
+err_put:
+	drm_gem_object_put(obj);
+	return ERR_PTR(ret);
+}
+
 /*
  * xlnx_gem_cma_dumb_create - (struct drm_driver)->dumb_create callback
  * @file_priv: drm_file object
@@ -30,7 +208,8 @@
  *
  * This function is for dumb_create callback of drm_driver struct. Simply
  * it wraps around drm_gem_dma_dumb_create() and sets the pitch value
- * by retrieving the value from the device.
+ * by retrieving the value from the device. With the gem_cached parameter,
+ * the buffer is allocated CPU cached instead of write-combined.
  *
  * Return: The return value from drm_gem_dma_dumb_create()
  */
@@ -39,9 +218,25 @@ int xlnx_gem_cma_dumb_create(struct drm_file *file_priv, struct drm_device *drm,
 {
 	int pitch = DIV_ROUND_UP(args->width * args->bpp, 8);
 	unsigned int align = xlnx_get_align(drm);
+	struct drm_gem_dma_object *dma_obj;
+	int ret;
 
 	if (!args->pitch || !IS_ALIGNED(args->pitch, align))
 		args->pitch = ALIGN(pitch, align);
 
-	return drm_gem_dma_dumb_create_internal(file_priv, drm, args);
+	if (!xlnx_gem_cached)
+		return drm_gem_dma_dumb_create_internal(file_priv, drm, args);
+
+	if (args->size < (u64)args->pitch * args->height)
+		args->size = (u64)args->pitch * args->height;
+
+	dma_obj = xlnx_gem_create_cached(drm, args->size);
+	if (IS_ERR(dma_obj))
+		return PTR_ERR(dma_obj);
+
+	ret = drm_gem_handle_create(file_priv, &dma_obj->base, &args->handle);
+	/* drop the reference from allocation, the handle holds it now */
+	drm_gem_object_put(&dma_obj->base);
+
+	return ret;
 }
@@ -22,5 +22,7 @@
 int xlnx_gem_cma_dumb_create(struct drm_file *file_priv,
 			     struct drm_device *drm,
 			     struct drm_mode_create_dumb *args);
+struct drm_gem_object *xlnx_gem_prime_import(struct drm_device *drm,
+					     struct dma_buf *dma_buf);
 
 #endif /* _XLNX_GEM_H_ */
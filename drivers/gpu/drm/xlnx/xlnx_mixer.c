@@ -320,6 +320,10 @@ enum xlnx_mix_layer_id {
  * @scale_fact: Current scaling factor applied to layer
  * @id: The logical layer id identifies which layer this struct describes
  *  (e.g. 0 = master, 1-15 = overlay).
+ * @regs_valid: Indicates layer_regs matches the hardware, so unchanged
+ *  window and buffer values are not written again
+ * @addr_pending: Indicates buff_addr1/buff_addr2 are not yet written to the
+ *  hardware and will be on the next crtc flush
  *
  * All mixer layers are reprsented by an instance of this struct:
  * output streaming, overlay, logo.
@@ -357,6 +361,8 @@ struct xlnx_mix_layer_data {
 	} layer_regs;
 
 	enum xlnx_mix_layer_id id;
+	bool regs_valid;
+	bool addr_pending;
 };
 
 /**
@@ -385,6 +391,10 @@ struct xlnx_mix_layer_data {
  * @reset_gpio: GPIO line used to reset IP between modesetting operations
  * @intrpt_handler_fn: Interrupt handler function called when frame is completed
  * @intrpt_data: Data pointer passed to interrupt handler
+ * @layer_enable: Cached value of the layer enable register
+ * @csc_enc: Colorimetry encoding currently programmed in the csc coefficients
+ * @csc_range: Colorimetry range currently programmed in the csc coefficients
+ * @csc_valid: Indicates csc_enc and csc_range match the hardware
  *
  * Used as the primary data structure for many L2 driver functions. Logo layer
  * data, if enabled within the IP, is described in this structure.  All other
@@ -416,6 +426,10 @@ struct xlnx_mix_hw {
 	struct gpio_desc *reset_gpio;
 	void (*intrpt_handler_fn)(void *);
 	void *intrpt_data;
+	u32 layer_enable;
+	enum drm_color_encoding csc_enc;
+	enum drm_color_range csc_range;
+	bool csc_valid;
 };
 
 /**
@@ -736,11 +750,15 @@ static int xlnx_mix_set_active_area(struct xlnx_mix_hw *mixer,
 		DRM_ERROR("Invalid layer dimension\n");
 		return -EINVAL;
 	}
+	if (ld->regs_valid && ld->layer_regs.width == hactive &&
+	    ld->layer_regs.height == vactive)
+		return 0;
 	/* set resolution */
 	reg_writel(mixer->base, XVMIX_HEIGHT_DATA, vactive);
 	reg_writel(mixer->base, XVMIX_WIDTH_DATA, hactive);
 	ld->layer_regs.width  = hactive;
 	ld->layer_regs.height = vactive;
+	ld->regs_valid = true;
 
 	return 0;
 }
@@ -820,20 +838,23 @@ static void xlnx_mix_layer_enable(struct xlnx_mix_hw *mixer,
 
 	/* Check if request is to enable all layers or single layer */
 	if (id == mixer->max_layers) {
-		reg_writel(mixer->base, XVMIX_LAYERENABLE_DATA,
-			   mixer->enable_all_mask);
-
+		curr_state = mixer->enable_all_mask;
 	} else if ((id < mixer->layer_cnt) || ((id == mixer->logo_layer_id) &&
 		   mixer->logo_layer_en)) {
-		curr_state = reg_readl(mixer->base, XVMIX_LAYERENABLE_DATA);
+		curr_state = mixer->layer_enable;
 		if (id == mixer->logo_layer_id)
 			curr_state |= mixer->logo_en_mask;
 		else
 			curr_state |= BIT(id);
-		reg_writel(mixer->base, XVMIX_LAYERENABLE_DATA, curr_state);
 	} else {
 		DRM_ERROR("Can't enable requested layer %d\n", id);
+		return;
 	}
+	/* Layers already on are left alone, each flip calls in here */
+	if (curr_state == mixer->layer_enable)
+		return;
+	reg_writel(mixer->base, XVMIX_LAYERENABLE_DATA, curr_state);
+	mixer->layer_enable = curr_state;
 }
 
 /**
@@ -881,19 +902,20 @@ static void xlnx_mix_layer_disable(struct xlnx_mix_hw *mixer,
 	num_layers = mixer->layer_cnt;
 
 	if (id == mixer->max_layers) {
-		reg_writel(mixer->base, XVMIX_LAYERENABLE_DATA,
-			   XVMIX_MASK_DISABLE_ALL_LAYERS);
+		curr_state = XVMIX_MASK_DISABLE_ALL_LAYERS;
 	} else if ((id < num_layers) ||
 		   ((id == mixer->logo_layer_id) && (mixer->logo_layer_en))) {
-		curr_state = reg_readl(mixer->base, XVMIX_LAYERENABLE_DATA);
+		curr_state = mixer->layer_enable;
 		if (id == mixer->logo_layer_id)
 			curr_state &= ~(mixer->logo_en_mask);
 		else
 			curr_state &= ~(BIT(id));
-		reg_writel(mixer->base, XVMIX_LAYERENABLE_DATA, curr_state);
 	} else {
 		DRM_ERROR("Can't disable requested layer %d\n", id);
+		return;
 	}
+	reg_writel(mixer->base, XVMIX_LAYERENABLE_DATA, curr_state);
+	mixer->layer_enable = curr_state;
 }
 
 /**
@@ -1163,10 +1185,20 @@ static int xlnx_mix_set_layer_window(struct xlnx_mix_hw *mixer,
 	if (!l_data)
 		return status;
 
-	scale = xlnx_mix_get_layer_scaling(mixer, id);
+	/* scale_fact is kept in sync by xlnx_mix_set_layer_scaling() */
+	scale = l_data->layer_regs.scale_fact;
 	if (!is_window_valid(mixer, x_pos, y_pos, width, height, scale))
 		return status;
 
+	if (l_data->regs_valid &&
+	    l_data->layer_regs.x_pos == x_pos &&
+	    l_data->layer_regs.y_pos == y_pos &&
+	    l_data->layer_regs.width == width &&
+	    l_data->layer_regs.height == height &&
+	    (l_data->hw_config.is_streaming ||
+	     l_data->layer_regs.stride == stride))
+		return 0;
+
 	if (id == mixer->logo_layer_id) {
 		if (!(mixer->logo_layer_en &&
 		      width <= l_data->hw_config.max_width &&
@@ -1194,6 +1226,8 @@ static int xlnx_mix_set_layer_window(struct xlnx_mix_hw *mixer,
 		l_data->layer_regs.y_pos = y_pos;
 		l_data->layer_regs.width = width;
 		l_data->layer_regs.height = height;
+		l_data->layer_regs.stride = stride;
+		l_data->regs_valid = true;
 		status = 0;
 	} else {
 		 /*Layer1-Layer15*/
@@ -1218,8 +1252,11 @@ static int xlnx_mix_set_layer_window(struct xlnx_mix_hw *mixer,
 		l_data->layer_regs.width = width;
 		l_data->layer_regs.height = height;
 
-		if (!l_data->hw_config.is_streaming)
+		if (!l_data->hw_config.is_streaming) {
 			reg_writel(mixer->base, (s_reg + off), stride);
+			l_data->layer_regs.stride = stride;
+		}
+		l_data->regs_valid = true;
 		status = 0;
 	}
 	return status;
@@ -1440,6 +1477,30 @@ static int xlnx_mix_disp_set_layer_alpha(struct xlnx_mix_plane *plane,
 	return xlnx_mix_set_layer_alpha(mixer_hw, layer->id, val);
 }
 
+/**
+ * xlnx_mix_write_layer_buff_addr - Write the cached buff addr of a layer
+ * @mixer: Instance of mixer controlling layer to modify
+ * @layer_data: Layer data holding the buffer addresses to program
+ */
+static void xlnx_mix_write_layer_buff_addr(struct xlnx_mix_hw *mixer,
+					   struct xlnx_mix_layer_data *layer_data)
+{
+	u32 offset = (layer_data->id - 1) * XVMIX_REG_OFFSET;
+	u32 reg1 = XVMIX_LAYER1_BUF1_V_DATA + offset;
+	u32 reg2 = XVMIX_LAYER1_BUF2_V_DATA + offset;
+
+	if (mixer->dma_addr_size == 64 && sizeof(dma_addr_t) == 8) {
+		reg_writeq(mixer->base, reg1, layer_data->layer_regs.buff_addr1);
+		reg_writeq(mixer->base, reg2, layer_data->layer_regs.buff_addr2);
+	} else {
+		reg_writel(mixer->base, reg1,
+			   (u32)layer_data->layer_regs.buff_addr1);
+		reg_writel(mixer->base, reg2,
+			   (u32)layer_data->layer_regs.buff_addr2);
+	}
+	layer_data->addr_pending = false;
+}
+
 /**
  * xlnx_mix_set_layer_buff_addr - Set buff addr for layer
  * @mixer: Instance of mixer controlling layer to modify
@@ -1447,7 +1508,12 @@ static int xlnx_mix_disp_set_layer_alpha(struct xlnx_mix_plane *plane,
  * @luma_addr: Start address of plane 1 of frame buffer for layer 1
  * @chroma_addr: Start address of plane 2 of frame buffer for layer 1
  *
- * Sets the buffer address of the specified layer
+ * Sets the buffer address of the specified layer. Nothing is written when
+ * the addresses are unchanged. If the layer is already scanning out, the
+ * write is deferred to xlnx_mix_flush_layer_buff_addrs() so the addresses
+ * of all layers flipped in a commit are programmed back to back and latch
+ * on the same frame.
+ *
  * Return:
  * Zero on success, -EINVAL on failure
  */
@@ -1457,8 +1523,8 @@ static int xlnx_mix_set_layer_buff_addr(struct xlnx_mix_hw *mixer,
 					dma_addr_t chroma_addr)
 {
 	struct xlnx_mix_layer_data *layer_data;
-	u32 align, offset;
-	u32 reg1, reg2;
+	u32 align;
+	bool flip;
 
 	if (id >= mixer->layer_cnt)
 		return -EINVAL;
@@ -1468,23 +1534,40 @@ static int xlnx_mix_set_layer_buff_addr(struct xlnx_mix_hw *mixer,
 	if ((luma_addr % align) != 0 || (chroma_addr % align) != 0)
 		return -EINVAL;
 
-	offset = (id - 1) * XVMIX_REG_OFFSET;
-	reg1 = XVMIX_LAYER1_BUF1_V_DATA + offset;
-	reg2 = XVMIX_LAYER1_BUF2_V_DATA + offset;
 	layer_data = &mixer->layer_data[id];
-	if (mixer->dma_addr_size == 64 && sizeof(dma_addr_t) == 8) {
-		reg_writeq(mixer->base, reg1, luma_addr);
-		reg_writeq(mixer->base, reg2, chroma_addr);
-	} else {
-		reg_writel(mixer->base, reg1, (u32)luma_addr);
-		reg_writel(mixer->base, reg2, (u32)chroma_addr);
-	}
+	if (layer_data->regs_valid &&
+	    layer_data->layer_regs.buff_addr1 == luma_addr &&
+	    layer_data->layer_regs.buff_addr2 == chroma_addr)
+		return 0;
+
+	/* Only a flip of a buffer already on screen can wait for the flush */
+	flip = layer_data->regs_valid && layer_data->layer_regs.buff_addr1 &&
+	       (mixer->layer_enable & BIT(id));
 	layer_data->layer_regs.buff_addr1 = luma_addr;
 	layer_data->layer_regs.buff_addr2 = chroma_addr;
+	if (flip)
+		layer_data->addr_pending = true;
+	else
+		xlnx_mix_write_layer_buff_addr(mixer, layer_data);
 
 	return 0;
 }
 
+/**
+ * xlnx_mix_flush_layer_buff_addrs - Write all deferred layer buff addrs
+ * @mixer: Instance of mixer to flush
+ */
+static void xlnx_mix_flush_layer_buff_addrs(struct xlnx_mix_hw *mixer)
+{
+	u32 i;
+
+	for (i = 0; i < mixer->layer_cnt; i++) {
+		if (mixer->layer_data[i].addr_pending)
+			xlnx_mix_write_layer_buff_addr(mixer,
+						       &mixer->layer_data[i]);
+	}
+}
+
 /**
  * xlnx_mix_hw_plane_dpms - Implementation of display power management
  * system call (dpms).
@@ -1899,7 +1982,9 @@ static int xlnx_mix_set_plane(struct xlnx_mix_plane *plane,
 		if (!plane->mixer_layer->hw_config.is_streaming)
 			xlnx_mix_mark_layer_inactive(plane);
 		if (mixer->drm_primary_layer == mixer->hw_master_layer) {
-			xlnx_mix_layer_disable(mixer_hw, layer_id);
+			if (src_w != active_area_width ||
+			    src_h != active_area_height)
+				xlnx_mix_layer_disable(mixer_hw, layer_id);
 			ret = xlnx_mix_set_active_area(mixer_hw, src_w, src_h);
 			if (ret)
 				return ret;
@@ -1997,12 +2082,17 @@ static int xlnx_mix_plane_mode_set(struct drm_plane *base_plane,
 		 * coefficient table supports BT601 / BT709 / BT2020 encoding
 		 * schemes and 16-235(limited) / 16-240(full) range.
 		 */
-		xlnx_mix_set_yuv2_rgb_coeff(plane,
-					    base_plane->state->color_encoding,
-					    base_plane->state->color_range);
-		xlnx_mix_set_rgb2_yuv_coeff(plane,
-					    base_plane->state->color_encoding,
-					    base_plane->state->color_range);
+		enum drm_color_encoding enc = base_plane->state->color_encoding;
+		enum drm_color_range range = base_plane->state->color_range;
+
+		if (!mixer_hw->csc_valid || mixer_hw->csc_enc != enc ||
+		    mixer_hw->csc_range != range) {
+			xlnx_mix_set_yuv2_rgb_coeff(plane, enc, range);
+			xlnx_mix_set_rgb2_yuv_coeff(plane, enc, range);
+			mixer_hw->csc_enc = enc;
+			mixer_hw->csc_range = range;
+			mixer_hw->csc_valid = true;
+		}
 	}
 
 	ret = xlnx_mix_set_plane(plane, fb, crtc_x, crtc_y, src_x, src_y,
@@ -2118,6 +2208,8 @@ xlnx_mix_plane_atomic_async_update(struct drm_plane *plane,
 	plane->state->state = new_state->state;
 
 	xlnx_mix_plane_atomic_update(plane, state);
+	/* No crtc flush follows an async update */
+	xlnx_mix_flush_layer_buff_addrs(to_mixer_hw(to_xlnx_plane(plane)));
 }
 
 static const struct drm_plane_helper_funcs xlnx_mix_plane_helper_funcs = {
@@ -2680,6 +2772,27 @@ static void xlnx_mix_set_bkg_col(struct xlnx_mix_hw *mixer, u64 rgb_value)
 	mixer->bg_color = rgb_value;
 }
 
+/**
+ * xlnx_mix_invalidate_regs - Forget the cached register values
+ * @mixer: Mixer core instance whose registers were reset
+ *
+ * After a reset of the IP every register has to be written again, even when
+ * the requested value matches the cached one.
+ */
+static void xlnx_mix_invalidate_regs(struct xlnx_mix_hw *mixer)
+{
+	u32 i;
+
+	for (i = 0; i < mixer->layer_cnt; i++) {
+		mixer->layer_data[i].regs_valid = false;
+		mixer->layer_data[i].addr_pending = false;
+		mixer->layer_data[i].layer_regs.buff_addr1 = 0;
+		mixer->layer_data[i].layer_regs.buff_addr2 = 0;
+	}
+	mixer->layer_enable = 0;
+	mixer->csc_valid = false;
+}
+
 /**
  * xlnx_mix_reset - Reset the mixer core video generator
  * @mixer: Mixer core instance for which to start video output
@@ -2692,6 +2805,7 @@ static void xlnx_mix_reset(struct xlnx_mix *mixer)
 
 	gpiod_set_raw_value(mixer_hw->reset_gpio, 0);
 	gpiod_set_raw_value(mixer_hw->reset_gpio, 1);
+	xlnx_mix_invalidate_regs(mixer_hw);
 	/* restore layer properties and bg color after reset */
 	xlnx_mix_set_bkg_col(mixer_hw, mixer_hw->bg_color);
 	xlnx_mix_plane_restore(mixer);
@@ -2931,12 +3045,22 @@ xlnx_mix_crtc_atomic_begin(struct drm_crtc *crtc,
 	}
 }
 
+static void
+xlnx_mix_crtc_atomic_flush(struct drm_crtc *crtc,
+			   struct drm_atomic_state *state)
+{
+	struct xlnx_mix *mixer = to_xlnx_mixer(to_xlnx_crtc(crtc));
+
+	xlnx_mix_flush_layer_buff_addrs(&mixer->mixer_hw);
+}
+
 static struct drm_crtc_helper_funcs xlnx_mix_crtc_helper_funcs = {
 	.atomic_enable	= xlnx_mix_crtc_atomic_enable,
 	.atomic_disable	= xlnx_mix_crtc_atomic_disable,
 	.mode_set_nofb	= xlnx_mix_crtc_mode_set_nofb,
 	.atomic_check	= xlnx_mix_crtc_atomic_check,
 	.atomic_begin	= xlnx_mix_crtc_atomic_begin,
+	.atomic_flush	= xlnx_mix_crtc_atomic_flush,
 };
 
 /**
@@ -30,6 +30,9 @@
 #include "xlnx_crtc.h"
 #include "xlnx_drv.h"
 
+#define CREATE_TRACE_POINTS
+#include "xlnx_pl_disp_trace.h"
+
 #define XLNX_PL_DISP_MAX_NUM_PLANES	3
 #define XLNX_PL_DISP_VFMT_SIZE		4
 /*
@@ -72,6 +75,8 @@ struct xlnx_dma_chan {
  * @fid_err_val: field id error value
  * @fid_out_prop: field id out property
  * @fid_out_val: field out value
+ * @async_flip: The dma engine is a framebuffer read IP, which picks up a
+ *  queued descriptor at the next frame start on its own
  */
 struct xlnx_pl_disp {
 	struct device *dev;
@@ -90,6 +95,7 @@ struct xlnx_pl_disp {
 	u32 fid_err_val;
 	struct drm_property *fid_out_prop;
 	u32 fid_out_val;
+	bool async_flip;
 };
 
 /*
@@ -112,6 +118,9 @@ static void xlnx_pl_disp_complete(void *param)
 	struct xlnx_pl_disp *xlnx_pl_disp = param;
 	struct drm_device *drm = xlnx_pl_disp->drm;
 	struct xlnx_dma_chan *xlnx_dma_chan = xlnx_pl_disp->chan;
+	struct drm_crtc *crtc = &xlnx_pl_disp->xlnx_crtc.crtc;
+	ktime_t vblank_time;
+	u64 seq;
 	int ret;
 
 	/* Get fid err flag and fid out val */
@@ -125,7 +134,16 @@ static void xlnx_pl_disp_complete(void *param)
 	if (ret)
 		dev_dbg(xlnx_pl_disp->dev, "failed to get fid_out info\n");
 
+	trace_xlnx_pl_disp_dma_complete(xlnx_pl_disp->plane.base.id,
+					xlnx_pl_disp->fid_err_val,
+					xlnx_pl_disp->fid_out_val);
+
 	drm_handle_vblank(drm, 0);
+
+	if (trace_xlnx_pl_disp_vblank_enabled()) {
+		seq = drm_crtc_vblank_count_and_time(crtc, &vblank_time);
+		trace_xlnx_pl_disp_vblank(crtc->base.id, seq, vblank_time);
+	}
 }
 
 /**
@@ -190,6 +208,7 @@ static void xlnx_pl_disp_plane_enable(struct drm_plane *plane)
 {
 	struct xlnx_pl_disp *xlnx_pl_disp = plane_to_dma(plane);
 	struct dma_async_tx_descriptor *desc;
+	dma_cookie_t cookie;
 	unsigned long flags;
 	struct xlnx_dma_chan *xlnx_dma_chan = xlnx_pl_disp->chan;
 	struct dma_chan *dma_chan = xlnx_dma_chan->dma_chan;
@@ -231,7 +250,8 @@ static void xlnx_pl_disp_plane_enable(struct drm_plane *plane)
 				    xlnx_pl_disp->fid);
 	}
 
-	dmaengine_submit(desc);
+	cookie = dmaengine_submit(desc);
+	trace_xlnx_pl_disp_dma_submit(plane->base.id, cookie, xt->src_start);
 	dma_async_issue_pending(xlnx_dma_chan->dma_chan);
 }
 
@@ -395,10 +415,58 @@ static inline struct xlnx_pl_disp *drm_crtc_to_dma(struct drm_crtc *crtc)
 	return crtc_to_dma(xlnx_crtc);
 }
 
+/**
+ * xlnx_pl_disp_mode_seamless - Check if a mode change can skip the modeset
+ * @old: mode currently programmed
+ * @new: requested mode
+ *
+ * The VTC can move the vertical front porch of a running timing at a frame
+ * boundary. A mode that only differs that way, i.e. the same active area and
+ * pixel clock at a different refresh rate, is switched without stopping the
+ * DMA and the timing generator.
+ *
+ * Return: true if @new can replace @old on the fly
+ */
+static bool xlnx_pl_disp_mode_seamless(const struct drm_display_mode *old,
+				       const struct drm_display_mode *new)
+{
+	return old->clock == new->clock &&
+	       old->hdisplay == new->hdisplay &&
+	       old->hsync_start == new->hsync_start &&
+	       old->hsync_end == new->hsync_end &&
+	       old->htotal == new->htotal &&
+	       old->vdisplay == new->vdisplay &&
+	       old->vsync_end - old->vsync_start ==
+	       new->vsync_end - new->vsync_start &&
+	       old->vtotal - old->vsync_end == new->vtotal - new->vsync_end &&
+	       old->flags == new->flags;
+}
+
 static void xlnx_pl_disp_crtc_atomic_begin(struct drm_crtc *crtc,
 					   struct drm_atomic_state *state)
 {
+	struct drm_crtc_state *old_state =
+		drm_atomic_get_old_crtc_state(state, crtc);
+	struct xlnx_pl_disp *xlnx_pl_disp = drm_crtc_to_dma(crtc);
+
+	trace_xlnx_pl_disp_atomic_begin(crtc->base.id, crtc->state->async_flip);
+
+	/* Seamless mode change accepted by atomic_check, retime the VTC live */
+	if (xlnx_pl_disp->vtc_bridge && old_state->active &&
+	    !drm_atomic_crtc_needs_modeset(crtc->state) &&
+	    !drm_mode_equal(&old_state->adjusted_mode,
+			    &crtc->state->adjusted_mode)) {
+		struct videomode vm;
+
+		drm_display_mode_to_videomode(&crtc->state->adjusted_mode, &vm);
+		xlnx_bridge_set_timing(xlnx_pl_disp->vtc_bridge, &vm);
+	}
+
 	drm_crtc_vblank_on(crtc);
+	/* An async flip completes in atomic_flush, once the dma is queued */
+	if (crtc->state->async_flip)
+		return;
+
 	spin_lock_irq(&crtc->dev->event_lock);
 	if (crtc->state->event) {
 		/* Consume the flip_done event from atomic helper */
@@ -410,6 +478,23 @@ static void xlnx_pl_disp_crtc_atomic_begin(struct drm_crtc *crtc,
 	spin_unlock_irq(&crtc->dev->event_lock);
 }
 
+/*
+ * The framebuffer read IP latches a queued descriptor at the next frame start
+ * without any help from the driver, so an async flip is complete as soon as
+ * the descriptor is issued and does not have to wait for the vblank.
+ */
+static void xlnx_pl_disp_crtc_atomic_flush(struct drm_crtc *crtc,
+					   struct drm_atomic_state *state)
+{
+	if (!crtc->state->async_flip || !crtc->state->event)
+		return;
+
+	spin_lock_irq(&crtc->dev->event_lock);
+	drm_crtc_send_vblank_event(crtc, crtc->state->event);
+	crtc->state->event = NULL;
+	spin_unlock_irq(&crtc->dev->event_lock);
+}
+
 static void xlnx_pl_disp_clear_event(struct drm_crtc *crtc)
 {
 	if (crtc->state->event) {
@@ -458,14 +543,64 @@ static void xlnx_pl_disp_crtc_atomic_disable(struct drm_crtc *crtc,
 static int xlnx_pl_disp_crtc_atomic_check(struct drm_crtc *crtc,
 					  struct drm_atomic_state *state)
 {
+	struct drm_crtc_state *crtc_state =
+		drm_atomic_get_new_crtc_state(state, crtc);
+	struct xlnx_pl_disp *xlnx_pl_disp = drm_crtc_to_dma(crtc);
+
+	if (crtc_state->async_flip &&
+	    (!xlnx_pl_disp->async_flip ||
+	     drm_atomic_crtc_needs_modeset(crtc_state)))
+		return -EINVAL;
+
 	return drm_atomic_add_affected_planes(state, crtc);
 }
 
+/**
+ * xlnx_pl_disp_crtc_mode_seamless - Check if a mode change skips the modeset
+ * @xlnx_crtc: xlnx crtc object
+ * @old_state: current CRTC state
+ * @new_state: requested CRTC state
+ *
+ * With VRR enabled, a refresh rate change the VTC can take on the fly isn't
+ * a modeset. A color format change of the plane still needs one, and so
+ * does a current mode that was fixed up by the encoder, as the fixups only
+ * run for a modeset.
+ *
+ * Return: true if the mode of @new_state can be set without a modeset
+ */
+static bool xlnx_pl_disp_crtc_mode_seamless(struct xlnx_crtc *xlnx_crtc,
+					    struct drm_crtc_state *old_state,
+					    struct drm_crtc_state *new_state)
+{
+	struct xlnx_pl_disp *xlnx_pl_disp = crtc_to_dma(xlnx_crtc);
+	struct drm_plane *plane = &xlnx_pl_disp->plane;
+	struct drm_plane_state *old_plane_state, *new_plane_state;
+
+	if (!new_state->vrr_enabled || !xlnx_pl_disp->vtc_bridge ||
+	    !old_state->active)
+		return false;
+
+	old_plane_state = drm_atomic_get_old_plane_state(new_state->state,
+							 plane);
+	new_plane_state = drm_atomic_get_new_plane_state(new_state->state,
+							 plane);
+	if (new_plane_state && old_plane_state->fb && new_plane_state->fb &&
+	    old_plane_state->fb->format != new_plane_state->fb->format)
+		return false;
+
+	if (!drm_mode_equal(&old_state->mode, &old_state->adjusted_mode))
+		return false;
+
+	return xlnx_pl_disp_mode_seamless(&old_state->adjusted_mode,
+					  &new_state->mode);
+}
+
 static struct drm_crtc_helper_funcs xlnx_pl_disp_crtc_helper_funcs = {
 	.atomic_enable = xlnx_pl_disp_crtc_atomic_enable,
 	.atomic_disable = xlnx_pl_disp_crtc_atomic_disable,
 	.atomic_check = xlnx_pl_disp_crtc_atomic_check,
 	.atomic_begin = xlnx_pl_disp_crtc_atomic_begin,
+	.atomic_flush = xlnx_pl_disp_crtc_atomic_flush,
 };
 
 static void xlnx_pl_disp_crtc_destroy(struct drm_crtc *crtc)
@@ -546,6 +681,8 @@ static int xlnx_pl_disp_bind(struct device *dev, struct device *master,
 			    &xlnx_pl_disp_crtc_helper_funcs);
 	xlnx_pl_disp->xlnx_crtc.get_format = &xlnx_pl_disp_get_format;
 	xlnx_pl_disp->xlnx_crtc.get_align = &xlnx_pl_disp_get_align;
+	xlnx_pl_disp->xlnx_crtc.mode_seamless =
+		&xlnx_pl_disp_crtc_mode_seamless;
 	xlnx_pl_disp->drm = drm;
 
 	xlnx_pl_disp->fid_err_prop = drm_property_create_bool(xlnx_pl_disp->drm,
@@ -554,6 +691,14 @@ static int xlnx_pl_disp_bind(struct device *dev, struct device *master,
 							      0, "fid_out");
 	drm_object_attach_property(obj, xlnx_pl_disp->fid_err_prop, 0);
 	drm_object_attach_property(obj, xlnx_pl_disp->fid_out_prop, 0);
+	drm_object_attach_property(&xlnx_pl_disp->xlnx_crtc.crtc.base,
+				   drm->mode_config.prop_vrr_enabled, 0);
+
+	/* Only the framebuffer read IP reports its formats */
+	if (fmts) {
+		xlnx_pl_disp->async_flip = true;
+		drm->mode_config.async_page_flip = true;
+	}
 
 	xlnx_crtc_register(xlnx_pl_disp->drm, &xlnx_pl_disp->xlnx_crtc);
 
@@ -0,0 +1,90 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/*
+ * Xilinx DRM CRTC DMA engine driver tracepoints
+ *
+ * Copyright (C) 2017 - 2018 Xilinx, Inc.
+ */
+
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM xlnx_pl_disp
+
+#if !defined(_XLNX_PL_DISP_TRACE_H_) || defined(TRACE_HEADER_MULTI_READ)
+#define _XLNX_PL_DISP_TRACE_H_
+
+#include <linux/dmaengine.h>
+#include <linux/ktime.h>
+#include <linux/tracepoint.h>
+#include <linux/types.h>
+
+TRACE_EVENT(xlnx_pl_disp_atomic_begin,
+	TP_PROTO(unsigned int crtc_id, bool async),
+	TP_ARGS(crtc_id, async),
+	TP_STRUCT__entry(
+		__field(unsigned int, crtc_id)
+		__field(bool, async)
+	),
+	TP_fast_assign(
+		__entry->crtc_id = crtc_id;
+		__entry->async = async;
+	),
+	TP_printk("crtc=%u async=%d", __entry->crtc_id, __entry->async)
+);
+
+TRACE_EVENT(xlnx_pl_disp_dma_submit,
+	TP_PROTO(unsigned int plane_id, dma_cookie_t cookie, dma_addr_t addr),
+	TP_ARGS(plane_id, cookie, addr),
+	TP_STRUCT__entry(
+		__field(unsigned int, plane_id)
+		__field(dma_cookie_t, cookie)
+		__field(u64, addr)
+	),
+	TP_fast_assign(
+		__entry->plane_id = plane_id;
+		__entry->cookie = cookie;
+		__entry->addr = addr;
+	),
+	TP_printk("plane=%u cookie=%d addr=0x%llx", __entry->plane_id,
+		  __entry->cookie, __entry->addr)
+);
+
+TRACE_EVENT(xlnx_pl_disp_dma_complete,
+	TP_PROTO(unsigned int plane_id, u32 fid_err, u32 fid_out),
+	TP_ARGS(plane_id, fid_err, fid_out),
+	TP_STRUCT__entry(
+		__field(unsigned int, plane_id)
+		__field(u32, fid_err)
+		__field(u32, fid_out)
+	),
+	TP_fast_assign(
+		__entry->plane_id = plane_id;
+		__entry->fid_err = fid_err;
+		__entry->fid_out = fid_out;
+	),
+	TP_printk("plane=%u fid_err=%u fid_out=%u", __entry->plane_id,
+		  __entry->fid_err, __entry->fid_out)
+);
+
+TRACE_EVENT(xlnx_pl_disp_vblank,
+	TP_PROTO(unsigned int crtc_id, u64 seq, ktime_t time),
+	TP_ARGS(crtc_id, seq, time),
+	TP_STRUCT__entry(
+		__field(unsigned int, crtc_id)
+		__field(u64, seq)
+		__field(s64, time)
+	),
+	TP_fast_assign(
+		__entry->crtc_id = crtc_id;
+		__entry->seq = seq;
+		__entry->time = ktime_to_ns(time);
+	),
+	TP_printk("crtc=%u seq=%llu time=%lld", __entry->crtc_id,
+		  __entry->seq, __entry->time)
+);
+
+#endif /* _XLNX_PL_DISP_TRACE_H_ */
+
+#undef TRACE_INCLUDE_PATH
+#define TRACE_INCLUDE_PATH .
+#undef TRACE_INCLUDE_FILE
+#define TRACE_INCLUDE_FILE xlnx_pl_disp_trace
+#include <trace/define_trace.h>
@@ -949,6 +949,11 @@ struct xscaler_feature {
  * @ctrl_clk: AXI Lite clock
  * @axis_clk: Video Clock
  * @cfg: Pointer to scaler config structure
+ * @hcoeff: H-scaler coefficient table loaded in the IP, NULL if none
+ * @vcoeff: V-scaler coefficient table loaded in the IP, NULL if none
+ * @phases_width_in: Input width the H-scaler phases are programmed for
+ * @phases_width_out: Output width the H-scaler phases are programmed for
+ * @streaming: Track if the scaler sub-cores are started
  */
 struct xilinx_scaler {
 	void __iomem *base;
@@ -974,6 +979,11 @@ struct xilinx_scaler {
 	struct clk *ctrl_clk;
 	struct clk *axis_clk;
 	const struct xscaler_feature *cfg;
+	const short *hcoeff;
+	const short *vcoeff;
+	u32 phases_width_in;
+	u32 phases_width_out;
+	bool streaming;
 };
 
 static inline void xilinx_scaler_write(void __iomem *base, u32 offset, u32 val)
@@ -1025,6 +1035,21 @@ static inline struct xilinx_scaler *bridge_to_layer(struct xlnx_bridge *bridge)
 	return container_of(bridge, struct xilinx_scaler, bridge);
 }
 
+/**
+ * xilinx_scaler_invalidate - Forgets the programmed scaler configuration
+ * @scaler: Pointer to scaler device structure
+ *
+ * Everything has to be programmed again once the sub-cores are reset.
+ */
+static void xilinx_scaler_invalidate(struct xilinx_scaler *scaler)
+{
+	scaler->streaming = false;
+	scaler->hcoeff = NULL;
+	scaler->vcoeff = NULL;
+	scaler->phases_width_in = 0;
+	scaler->phases_width_out = 0;
+}
+
 /**
  * xilinx_scaler_reset - Resets scaler block
  * @scaler: Pointer to scaler device structure
@@ -1037,6 +1062,7 @@ static void xilinx_scaler_reset(struct xilinx_scaler *scaler)
 				    XGPIO_RESET_MASK_ALL_BLOCKS);
 	xilinx_scaler_enable_block(scaler, XGPIO_CH_RESET_SEL,
 				   XGPIO_RESET_MASK_IP_AXIS);
+	xilinx_scaler_invalidate(scaler);
 }
 
 /**
@@ -1064,6 +1090,7 @@ xv_hscaler_calculate_phases(struct xilinx_scaler *scaler,
 	unsigned int nppc = scaler->pix_per_clk;
 	unsigned int shift = XHSC_STEP_PRECISION_SHIFT - ilog2(nphases);
 
+	memset(scaler->H_phases, 0, sizeof(scaler->H_phases));
 	loop_width = max_t(u32, width_in, width_out);
 	loop_width = ALIGN(loop_width + nppc - 1, nppc);
 
@@ -1249,8 +1276,12 @@ static const short *xv_select_coeff(struct xilinx_scaler *scaler,
  * This selection is adopted by the as it gives optimal
  * video output determined by repeated testing of the IP
  *
- * Return: Will return 0 if successful. Returns -EINVAL on an unsupported
- * H-scaler number of taps.
+ * The coefficients are only reloaded when the scaling ratio selects a
+ * different table than the one already programmed in the IP.
+ *
+ * Return: Will return 1 if new coefficients were loaded, 0 if the loaded
+ * ones still apply. Returns -EINVAL on an unsupported H-scaler number of
+ * taps.
  */
 static int
 xv_hscaler_select_coeff(struct xilinx_scaler *scaler,
@@ -1262,9 +1293,12 @@ xv_hscaler_select_coeff(struct xilinx_scaler *scaler,
 	coeff = xv_select_coeff(scaler, width_in, width_out, &ntaps);
 	if (!coeff)
 		return -EINVAL;
+	if (coeff == scaler->hcoeff)
+		return 0;
 
 	xv_hscaler_load_ext_coeff(scaler, coeff, ntaps);
-	return 0;
+	scaler->hcoeff = coeff;
+	return 1;
 }
 
 /**
@@ -1382,8 +1416,12 @@ static void xv_vscaler_set_coeff(struct xilinx_scaler *scaler)
  * This selection is adopted by the as it gives optimal
  * video output determined by repeated testing of the IP
  *
- * Return: Will return 0 if successful. Returns -EINVAL on an unsupported
- * V-scaler number of taps.
+ * The coefficients are only reloaded when the scaling ratio selects a
+ * different table than the one already programmed in the IP.
+ *
+ * Return: Will return 1 if new coefficients were loaded, 0 if the loaded
+ * ones still apply. Returns -EINVAL on an unsupported V-scaler number of
+ * taps.
  */
 static int
 xv_vscaler_select_coeff(struct xilinx_scaler *scaler,
@@ -1395,9 +1433,12 @@ xv_vscaler_select_coeff(struct xilinx_scaler *scaler,
 	coeff = xv_select_coeff(scaler, height_in, height_out, &ntaps);
 	if (!coeff)
 		return -EINVAL;
+	if (coeff == scaler->vcoeff)
+		return 0;
 
 	xv_vscaler_load_ext_coeff(scaler, coeff, ntaps);
-	return 0;
+	scaler->vcoeff = coeff;
+	return 1;
 }
 
 /**
@@ -1682,7 +1723,8 @@ static int xilinx_scaler_stream(struct xilinx_scaler *scaler)
 			dev_info(scaler->dev, "Failed: vscaler select coeff\n");
 			return ret;
 		}
-		xv_vscaler_set_coeff(scaler);
+		if (ret)
+			xv_vscaler_set_coeff(scaler);
 	}
 	xilinx_scaler_write(scaler->base, V_VSCALER_OFF +
 			    XV_VSCALER_CTRL_ADDR_HWREG_LINERATE_DATA,
@@ -1708,11 +1750,18 @@ static int xilinx_scaler_stream(struct xilinx_scaler *scaler)
 			dev_info(scaler->dev, "Failed: hscaler select coeff\n");
 			return ret;
 		}
-		xv_hscaler_set_coeff(scaler);
+		if (ret)
+			xv_hscaler_set_coeff(scaler);
+	}
+	/* The phases only depend on the widths, the pixel rate follows them */
+	if (scaler->phases_width_in != scaler->width_in ||
+	    scaler->phases_width_out != scaler->width_out) {
+		xv_hscaler_calculate_phases(scaler, scaler->width_in,
+					    scaler->width_out, pixel_rate);
+		xv_hscaler_set_phases(scaler);
+		scaler->phases_width_in = scaler->width_in;
+		scaler->phases_width_out = scaler->width_out;
 	}
-	xv_hscaler_calculate_phases(scaler, scaler->width_in,
-				    scaler->width_out, pixel_rate);
-	xv_hscaler_set_phases(scaler);
 	return 0;
 }
 
@@ -1727,12 +1776,14 @@ static int xilinx_scaler_stream(struct xilinx_scaler *scaler)
  */
 static int xilinx_scaler_bridge_enable(struct xlnx_bridge *bridge)
 {
-	int ret;
 	struct xilinx_scaler *scaler = bridge_to_layer(bridge);
 
-	ret = xilinx_scaler_stream(scaler);
-	if (ret)
-		return ret;
+	/*
+	 * A reconfiguration of a running scaler is picked up by the
+	 * auto-restarting sub-cores at the next frame
+	 */
+	if (scaler->streaming)
+		return 0;
 
 	xilinx_scaler_write(scaler->base, V_HSCALER_OFF +
 			    XV_HSCALER_CTRL_ADDR_AP_CTRL, XSCALER_STREAM_ON);
@@ -1740,7 +1791,8 @@ static int xilinx_scaler_bridge_enable(struct xlnx_bridge *bridge)
 			    XV_VSCALER_CTRL_ADDR_AP_CTRL, XSCALER_STREAM_ON);
 	xilinx_scaler_enable_block(scaler, XGPIO_CH_RESET_SEL,
 				   XGPIO_RESET_MASK_IP_AXIS);
-	return ret;
+	scaler->streaming = true;
+	return 0;
 }
 
 /**
@@ -1755,6 +1807,7 @@ static void xilinx_scaler_bridge_disable(struct xlnx_bridge *bridge)
 
 	xilinx_scaler_disable_block(scaler, XGPIO_CH_RESET_SEL,
 				    XGPIO_RESET_MASK_ALL_BLOCKS);
+	xilinx_scaler_invalidate(scaler);
 }
 
 /**
@@ -1764,7 +1817,10 @@ static void xilinx_scaler_bridge_disable(struct xlnx_bridge *bridge)
  * @height: height of video
  * @bus_fmt: video bus format
  *
- * This function sets the input parameters of scaler
+ * This function sets the input parameters of scaler. The IP is reset
+ * unless it is already streaming the same input, in which case only the
+ * output side changes and the running scaler is reconfigured in place.
+ *
  * Return: 0 on success. -EINVAL for invalid parameters.
  */
 static int xilinx_scaler_bridge_set_input(struct xlnx_bridge *bridge,
@@ -1775,6 +1831,10 @@ static int xilinx_scaler_bridge_set_input(struct xlnx_bridge *bridge,
 	if (width > scaler->max_pixels || height > scaler->max_lines)
 		return -EINVAL;
 
+	if (scaler->streaming && scaler->height_in == height &&
+	    scaler->width_in == width && scaler->fmt_in == bus_fmt)
+		return 0;
+
 	scaler->height_in = height;
 	scaler->width_in = width;
 	scaler->fmt_in = bus_fmt;
@@ -1783,7 +1843,6 @@ static int xilinx_scaler_bridge_set_input(struct xlnx_bridge *bridge,
 	gpiod_set_value_cansleep(scaler->rst_gpio, XSCALER_RESET_ASSERT);
 	gpiod_set_value_cansleep(scaler->rst_gpio, XSCALER_RESET_DEASSERT);
 	xilinx_scaler_reset(scaler);
-	memset(scaler->H_phases, 0, sizeof(scaler->H_phases));
 
 	xilinx_scaler_write(scaler->base, V_VSCALER_OFF +
 			    XV_VSCALER_CTRL_ADDR_HWREG_HEIGHTIN_DATA, height);
@@ -1819,7 +1878,8 @@ static int xilinx_scaler_bridge_get_input_fmts(struct xlnx_bridge *bridge,
  * @height: height of video
  * @bus_fmt: video bus format
  *
- * This function sets the output parameters of scaler
+ * This function sets the output parameters of scaler, they are written by
+ * xilinx_scaler_bridge_commit()
  * Return: 0 on success. -EINVAL for invalid parameters.
  */
 static int xilinx_scaler_bridge_set_output(struct xlnx_bridge *bridge,
@@ -1834,13 +1894,34 @@ static int xilinx_scaler_bridge_set_output(struct xlnx_bridge *bridge,
 	scaler->width_out = width;
 	scaler->fmt_out = bus_fmt;
 
+	return 0;
+}
+
+/**
+ * xilinx_scaler_bridge_commit - Writes the output parameters of scaler
+ * @bridge: bridge instance
+ *
+ * This function writes the output parameters of scaler and sets the
+ * sub-cores up for them, together so that a running scaler picks up a
+ * consistent configuration at the next frame.
+ *
+ * Return: 0 on success. -EINVAL for invalid parameters.
+ */
+static int xilinx_scaler_bridge_commit(struct xlnx_bridge *bridge)
+{
+	struct xilinx_scaler *scaler = bridge_to_layer(bridge);
+
 	xilinx_scaler_write(scaler->base, V_VSCALER_OFF +
-			    XV_VSCALER_CTRL_ADDR_HWREG_HEIGHTOUT_DATA, height);
+			    XV_VSCALER_CTRL_ADDR_HWREG_HEIGHTOUT_DATA,
+			    scaler->height_out);
 	xilinx_scaler_write(scaler->base, V_HSCALER_OFF +
-			    XV_HSCALER_CTRL_ADDR_HWREG_HEIGHT_DATA, height);
+			    XV_HSCALER_CTRL_ADDR_HWREG_HEIGHT_DATA,
+			    scaler->height_out);
 	xilinx_scaler_write(scaler->base, V_HSCALER_OFF +
-			    XV_HSCALER_CTRL_ADDR_HWREG_WIDTHOUT_DATA, width);
-	return 0;
+			    XV_HSCALER_CTRL_ADDR_HWREG_WIDTHOUT_DATA,
+			    scaler->width_out);
+
+	return xilinx_scaler_stream(scaler);
 }
 
 /**
@@ -1936,6 +2017,7 @@ static int xilinx_scaler_probe(struct platform_device *pdev)
 	scaler->bridge.get_input_fmts = &xilinx_scaler_bridge_get_input_fmts;
 	scaler->bridge.set_output = &xilinx_scaler_bridge_set_output;
 	scaler->bridge.get_output_fmts = &xilinx_scaler_bridge_get_output_fmts;
+	scaler->bridge.commit = &xilinx_scaler_bridge_commit;
 	scaler->bridge.of_node = dev->of_node;
 
 	ret = xlnx_bridge_register(&scaler->bridge);
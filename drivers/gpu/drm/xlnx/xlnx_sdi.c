@@ -21,6 +21,7 @@
 #include <linux/of_device.h>
 #include <linux/of_graph.h>
 #include <linux/phy/phy.h>
+#include <linux/sort.h>
 #include <media/hdr-ctrls.h>
 #include <video/videomode.h>
 #include "xlnx_sdi_modes.h"
@@ -152,6 +153,20 @@ enum payload_line_2 {
 	PAYLD_LN2_SDNTSC = 276
 };
 
+/* Number of real modes in xlnx_sdi_modes, entry 0 is a dummy */
+#define XSDI_NUM_MODES		(ARRAY_SIZE(xlnx_sdi_modes) - 1)
+#define XSDI_MODE_KEY_LEN	4
+
+/**
+ * struct xlnx_sdi_mode_key - Sorted index entry of the SDI modes table
+ * @key: mode values the index is sorted on
+ * @id: index of the mode in xlnx_sdi_modes
+ */
+struct xlnx_sdi_mode_key {
+	u32 key[XSDI_MODE_KEY_LEN];
+	u32 id;
+};
+
 /**
  * struct xlnx_sdi - Core configuration SDI Tx subsystem device structure
  * @encoder: DRM encoder structure
@@ -206,6 +221,9 @@ enum payload_line_2 {
  * @picxo_enabled: indicates picxo core presence
  * @prev_eotf: previous end of transfer function
  * @is_hfr: Indicates HFR video streaming
+ * @timing_idx: modes table index sorted on the total size, clock and flags
+ * @display_idx: modes table index sorted on the active size, refresh rate
+ *		 and flags
  */
 struct xlnx_sdi {
 	struct drm_encoder encoder;
@@ -253,6 +271,8 @@ struct xlnx_sdi {
 	bool picxo_enabled;
 	u8 prev_eotf;
 	u8 is_hfr;
+	struct xlnx_sdi_mode_key timing_idx[XSDI_NUM_MODES];
+	struct xlnx_sdi_mode_key display_idx[XSDI_NUM_MODES];
 };
 
 #define connector_to_sdi(c) container_of(c, struct xlnx_sdi, connector)
@@ -688,24 +708,108 @@ xlnx_sdi_atomic_get_property(struct drm_connector *connector,
 	return 0;
 }
 
+static void xlnx_sdi_timing_key(const struct drm_display_mode *mode, u32 *key)
+{
+	key[0] = mode->htotal;
+	key[1] = mode->vtotal;
+	key[2] = mode->clock;
+	key[3] = mode->flags;
+}
+
+static void xlnx_sdi_display_key(const struct drm_display_mode *mode, u32 *key)
+{
+	key[0] = mode->hdisplay;
+	key[1] = mode->vdisplay;
+	key[2] = drm_mode_vrefresh(mode);
+	key[3] = mode->flags;
+}
+
+static int xlnx_sdi_key_cmp(const u32 *a, const u32 *b)
+{
+	unsigned int i;
+
+	for (i = 0; i < XSDI_MODE_KEY_LEN; i++)
+		if (a[i] != b[i])
+			return a[i] < b[i] ? -1 : 1;
+	return 0;
+}
+
+static int xlnx_sdi_mode_key_cmp(const void *a, const void *b)
+{
+	const struct xlnx_sdi_mode_key *ka = a, *kb = b;
+	int ret;
+
+	ret = xlnx_sdi_key_cmp(ka->key, kb->key);
+	if (ret)
+		return ret;
+
+	/* Keep table order for equal keys, the first match wins */
+	return ka->id < kb->id ? -1 : ka->id > kb->id;
+}
+
+/**
+ * xlnx_sdi_build_mode_index - Build a sorted index of the modes table
+ * @idx: index to fill, XSDI_NUM_MODES entries
+ * @get_key: function computing the key of a mode
+ */
+static void
+xlnx_sdi_build_mode_index(struct xlnx_sdi_mode_key *idx,
+			  void (*get_key)(const struct drm_display_mode *mode,
+					  u32 *key))
+{
+	unsigned int i;
+
+	for (i = 0; i < XSDI_NUM_MODES; i++) {
+		get_key(&xlnx_sdi_modes[i + 1].mode, idx[i].key);
+		idx[i].id = i + 1;
+	}
+
+	sort(idx, XSDI_NUM_MODES, sizeof(*idx), xlnx_sdi_mode_key_cmp, NULL);
+}
+
+/**
+ * xlnx_sdi_find_mode - Binary search a sorted index of the modes table
+ * @idx: index built by xlnx_sdi_build_mode_index()
+ * @key: key of the mode being searched
+ *
+ * Return: id of the first mode of the table matching @key OR -EINVAL
+ */
+static int xlnx_sdi_find_mode(const struct xlnx_sdi_mode_key *idx,
+			      const u32 *key)
+{
+	unsigned int lo = 0, hi = XSDI_NUM_MODES;
+
+	while (lo < hi) {
+		unsigned int mid = lo + (hi - lo) / 2;
+
+		if (xlnx_sdi_key_cmp(idx[mid].key, key) < 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	if (lo == XSDI_NUM_MODES || xlnx_sdi_key_cmp(idx[lo].key, key))
+		return -EINVAL;
+
+	return idx[lo].id;
+}
+
 /**
  * xlnx_sdi_get_mode_id - Search for a video mode in the supported modes table
  *
+ * @sdi: Pointer to SDI Tx structure
  * @mode: mode being searched
  *
  * Return: mode id if mode is found OR -EINVAL otherwise
  */
-static int xlnx_sdi_get_mode_id(struct drm_display_mode *mode)
+static int xlnx_sdi_get_mode_id(struct xlnx_sdi *sdi,
+				struct drm_display_mode *mode)
 {
-	unsigned int i;
+	u32 key[XSDI_MODE_KEY_LEN];
 
-	for (i = 0; i < ARRAY_SIZE(xlnx_sdi_modes); i++)
-		if (xlnx_sdi_modes[i].mode.htotal == mode->htotal &&
-		    xlnx_sdi_modes[i].mode.vtotal == mode->vtotal &&
-		    xlnx_sdi_modes[i].mode.clock == mode->clock &&
-		    xlnx_sdi_modes[i].mode.flags == mode->flags)
-			return i;
-	return -EINVAL;
+	xlnx_sdi_timing_key(mode, key);
+
+	return xlnx_sdi_find_mode(sdi->timing_idx, key);
 }
 
 /**
@@ -723,7 +827,8 @@ static int xlnx_sdi_drm_add_modes(struct drm_connector *connector)
 	struct drm_display_mode *mode;
 	struct drm_device *dev = connector->dev;
 
-	for (i = 0; i < ARRAY_SIZE(xlnx_sdi_modes); i++) {
+	/* Skip the dummy entry, it isn't a valid mode */
+	for (i = 1; i < ARRAY_SIZE(xlnx_sdi_modes); i++) {
 		const struct drm_display_mode *ptr = &xlnx_sdi_modes[i].mode;
 
 		mode = drm_mode_duplicate(dev, ptr);
@@ -948,8 +1053,11 @@ static u32 xlnx_sdi_calc_st352_payld(struct xlnx_sdi *sdi,
 	bool is_frac = sdi->is_frac_prop_val;
 	u32 byt3 = ST352_BYTE3;
 
-	id = xlnx_sdi_get_mode_id(mode);
+	id = xlnx_sdi_get_mode_id(sdi, mode);
 	dev_dbg(sdi->dev, "mode id: %d\n", id);
+	/* Unknown modes get the zero payload bytes of the dummy entry */
+	if (id < 0)
+		id = 0;
 	if (mode->hdisplay == 2048 || mode->hdisplay == 4096)
 		byt3 |= XST352_2048_SHIFT;
 	if (sdi->sdi_420_in_val)
@@ -1063,22 +1171,17 @@ static void xlnx_sdi_encoder_atomic_mode_set(struct drm_encoder *encoder,
 	xlnx_bridge_enable(sdi->bridge);
 
 	if (sdi->bridge) {
-		for (i = 0; i < ARRAY_SIZE(xlnx_sdi_modes); i++) {
-			if (xlnx_sdi_modes[i].mode.hdisplay ==
-			    sdi->width_out_prop_val &&
-			    xlnx_sdi_modes[i].mode.vdisplay ==
-			    sdi->height_out_prop_val &&
-			    adjusted_mode->flags == xlnx_sdi_modes[i].mode.flags &&
-			    drm_mode_vrefresh(&xlnx_sdi_modes[i].mode) ==
-			    drm_mode_vrefresh(adjusted_mode)) {
-				memcpy((char *)adjusted_mode +
-				       offsetof(struct drm_display_mode,
-						clock),
-				       &xlnx_sdi_modes[i].mode.clock,
-				       SDI_TIMING_PARAMS_SIZE);
-				break;
-			}
-		}
+		u32 key[XSDI_MODE_KEY_LEN] = {
+			sdi->width_out_prop_val, sdi->height_out_prop_val,
+			drm_mode_vrefresh(adjusted_mode), adjusted_mode->flags,
+		};
+
+		ret = xlnx_sdi_find_mode(sdi->display_idx, key);
+		if (ret > 0)
+			memcpy((char *)adjusted_mode +
+			       offsetof(struct drm_display_mode, clock),
+			       &xlnx_sdi_modes[ret].mode.clock,
+			       SDI_TIMING_PARAMS_SIZE);
 	}
 
 	/* If HFR video is streaming */
@@ -1264,6 +1367,9 @@ static int xlnx_sdi_probe(struct platform_device *pdev)
 		return -ENOMEM;
 
 	sdi->dev = dev;
+	xlnx_sdi_build_mode_index(sdi->timing_idx, xlnx_sdi_timing_key);
+	xlnx_sdi_build_mode_index(sdi->display_idx, xlnx_sdi_display_key);
+
 	res = platform_get_resource(pdev, IORESOURCE_MEM, 0);
 	sdi->base = devm_ioremap_resource(dev, res);
 	if (IS_ERR(sdi->base)) {
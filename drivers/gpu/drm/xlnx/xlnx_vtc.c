@@ -100,6 +100,9 @@
  * @ppc: pixels per clock
  * @axi_clk: AXI Lite clock
  * @vid_clk: Video clock
+ * @vm: programmed timing, horizontal values in clock cycles
+ * @vm_valid: @vm matches the generator registers
+ * @enabled: the generator is running
  */
 struct xlnx_vtc {
 	struct xlnx_bridge bridge;
@@ -108,6 +111,9 @@ struct xlnx_vtc {
 	u32 ppc;
 	struct clk *axi_clk;
 	struct clk *vid_clk;
+	struct videomode vm;
+	bool vm_valid;
+	bool enabled;
 };
 
 static inline void xlnx_vtc_writel(void __iomem *base, int offset, u32 val)
@@ -130,6 +136,7 @@ static void xlnx_vtc_reset(struct xlnx_vtc *vtc)
 	u32 reg;
 
 	xlnx_vtc_writel(vtc->base, XVTC_CTL, XVTC_CTL_SWRESET);
+	vtc->vm_valid = false;
 
 	/* enable register update */
 	reg = xlnx_vtc_readl(vtc->base, XVTC_CTL);
@@ -153,6 +160,7 @@ static int xlnx_vtc_enable(struct xlnx_bridge *bridge)
 	/* enable generator */
 	reg = xlnx_vtc_readl(vtc->base, XVTC_CTL);
 	xlnx_vtc_writel(vtc->base, XVTC_CTL, reg | XVTC_CTL_GE);
+	vtc->enabled = true;
 	dev_dbg(vtc->dev, "enabled\n");
 	return 0;
 }
@@ -171,10 +179,79 @@ static void xlnx_vtc_disable(struct xlnx_bridge *bridge)
 	/* disable generator and reset */
 	reg = xlnx_vtc_readl(vtc->base, XVTC_CTL);
 	xlnx_vtc_writel(vtc->base, XVTC_CTL, reg & ~XVTC_CTL_GE);
+	vtc->enabled = false;
 	xlnx_vtc_reset(vtc);
 	dev_dbg(vtc->dev, "disabled\n");
 }
 
+/**
+ * xlnx_vtc_only_vfp_changed - Check if only the vertical front porch changed
+ * @vtc: VTC structure pointer
+ * @vm: new timing, horizontal values in clock cycles
+ *
+ * Return:
+ * True if @vm only differs from the programmed timing by its vertical
+ * front porch, which is how the refresh rate of a mode is varied at a
+ * fixed pixel clock.
+ */
+static bool xlnx_vtc_only_vfp_changed(struct xlnx_vtc *vtc,
+				      const struct videomode *vm)
+{
+	const struct videomode *cur = &vtc->vm;
+
+	return vtc->vm_valid &&
+	       cur->pixelclock == vm->pixelclock &&
+	       cur->hactive == vm->hactive &&
+	       cur->hfront_porch == vm->hfront_porch &&
+	       cur->hback_porch == vm->hback_porch &&
+	       cur->hsync_len == vm->hsync_len &&
+	       cur->vactive == vm->vactive &&
+	       cur->vback_porch == vm->vback_porch &&
+	       cur->vsync_len == vm->vsync_len &&
+	       cur->flags == vm->flags;
+}
+
+/**
+ * xlnx_vtc_set_vfp - Update the vertical front porch of the running VTC
+ * @vtc: VTC structure pointer
+ * @vm: new timing, horizontal values in clock cycles
+ *
+ * Only the vertical size and vertical sync registers depend on the front
+ * porch. They are written with register update disabled, and the generator
+ * picks them up at the start of the next frame without losing sync.
+ */
+static void xlnx_vtc_set_vfp(struct xlnx_vtc *vtc, const struct videomode *vm)
+{
+	u32 reg, vtotal, vsync_start, vbackporch_start;
+
+	reg = xlnx_vtc_readl(vtc->base, XVTC_CTL);
+	xlnx_vtc_writel(vtc->base, XVTC_CTL, reg & ~XVTC_CTL_RU);
+
+	vtotal = vm->vactive + vm->vfront_porch + vm->vsync_len +
+		 vm->vback_porch;
+	vsync_start = vm->vactive + vm->vfront_porch;
+	vbackporch_start = vsync_start + vm->vsync_len;
+
+	dev_dbg(vtc->dev, "vt: %d, vs: %d, vb: %d\n", vtotal, vsync_start,
+		vbackporch_start);
+
+	reg = vtotal & XVTC_GVFRAME_HSIZE_F1;
+	reg |= reg << XVTC_GV1_BPSTART_SHIFT;
+	xlnx_vtc_writel(vtc->base, XVTC_GVSIZE, reg);
+
+	reg = vsync_start & XVTC_GV1_SYNCSTART_MASK;
+	reg |= (vbackporch_start << XVTC_GV1_BPSTART_SHIFT) &
+	       XVTC_GV1_BPSTART_MASK;
+	xlnx_vtc_writel(vtc->base, XVTC_GVSYNC_F0, reg);
+	if (vm->flags & DISPLAY_FLAGS_INTERLACED)
+		xlnx_vtc_writel(vtc->base, XVTC_GVSYNC_F1, reg);
+
+	reg = xlnx_vtc_readl(vtc->base, XVTC_CTL);
+	xlnx_vtc_writel(vtc->base, XVTC_CTL, reg | XVTC_CTL_RU);
+
+	vtc->vm.vfront_porch = vm->vfront_porch;
+}
+
 /**
  * xlnx_vtc_set_timing - Configures the VTC
  * @bridge: xilinx bridge structure pointer
@@ -184,7 +261,10 @@ static void xlnx_vtc_disable(struct xlnx_bridge *bridge)
  * Zero on success.
  *
  * This function calculates the timing values from the video mode
- * structure passed from the CRTC and configures the VTC.
+ * structure passed from the CRTC and configures the VTC. The registers
+ * are latched at a frame start, so the VTC can be reprogrammed while it
+ * is running. When only the vertical front porch changes, only the
+ * registers depending on it are written.
  */
 static int xlnx_vtc_set_timing(struct xlnx_bridge *bridge,
 			       struct videomode *vm)
@@ -194,14 +274,19 @@ static int xlnx_vtc_set_timing(struct xlnx_bridge *bridge,
 	u32 vtotal, vactive, vsync_start, vbackporch_start;
 	struct xlnx_vtc *vtc = bridge_to_vtc(bridge);
 
-	reg = xlnx_vtc_readl(vtc->base, XVTC_CTL);
-	xlnx_vtc_writel(vtc->base, XVTC_CTL, reg & ~XVTC_CTL_RU);
-
 	vm->hactive /= vtc->ppc;
 	vm->hfront_porch /= vtc->ppc;
 	vm->hback_porch /= vtc->ppc;
 	vm->hsync_len /= vtc->ppc;
 
+	if (vtc->enabled && xlnx_vtc_only_vfp_changed(vtc, vm)) {
+		xlnx_vtc_set_vfp(vtc, vm);
+		return 0;
+	}
+
+	reg = xlnx_vtc_readl(vtc->base, XVTC_CTL);
+	xlnx_vtc_writel(vtc->base, XVTC_CTL, reg & ~XVTC_CTL_RU);
+
 	htotal = vm->hactive + vm->hfront_porch + vm->hsync_len +
 		 vm->hback_porch;
 	vtotal = vm->vactive + vm->vfront_porch + vm->vsync_len +
@@ -321,6 +406,8 @@ static int xlnx_vtc_set_timing(struct xlnx_bridge *bridge,
 
 	reg = xlnx_vtc_readl(vtc->base, XVTC_CTL);
 	xlnx_vtc_writel(vtc->base, XVTC_CTL, reg | XVTC_CTL_RU);
+	vtc->vm = *vm;
+	vtc->vm_valid = true;
 	dev_dbg(vtc->dev, "set timing done\n");
 
 	return 0;
@@ -278,6 +278,20 @@ struct zynqmp_dp_mode {
 	const char *fmt;
 };
 
+/**
+ * struct zynqmp_dp_train_cache - Result of the last successful link training
+ * @bw_code: trained link rate
+ * @lane_cnt: trained number of lanes
+ * @train_set: trained voltage swing and pre-emphasis of each lane
+ * @valid: the cache holds a result for the connected sink
+ */
+struct zynqmp_dp_train_cache {
+	u8 bw_code;
+	u8 lane_cnt;
+	u8 train_set[ZYNQMP_DP_MAX_LANES];
+	bool valid;
+};
+
 /**
  * struct zynqmp_dp_config - Configuration of DisplayPort from DTS
  * @misc0: misc0 configuration (per DP v1.2 spec)
@@ -318,6 +332,7 @@ struct zynqmp_dp_config {
  * @link_config: common link configuration between IP core and sink device
  * @mode: current mode between IP core and sink device
  * @train_set: set of training data
+ * @train_cache: last successful training, used to restore the link quickly
  */
 struct zynqmp_dp {
 	struct drm_encoder encoder;
@@ -344,6 +359,7 @@ struct zynqmp_dp {
 	struct zynqmp_dp_link_config link_config;
 	struct zynqmp_dp_mode mode;
 	u8 train_set[ZYNQMP_DP_MAX_LANES];
+	struct zynqmp_dp_train_cache train_cache;
 };
 
 static inline struct zynqmp_dp *encoder_to_dp(struct drm_encoder *encoder)
@@ -923,10 +939,15 @@ static int zynqmp_dp_link_train_ce(struct zynqmp_dp *dp)
 /**
  * zynqmp_dp_train - Train the link
  * @dp: DisplayPort IP core structure
+ * @restore: start from the cached training values
+ *
+ * When the link was trained at the same rate and lane count before, e.g.
+ * before a DPMS off, starting from the trained voltage swing and pre-emphasis
+ * levels normally lets both training phases pass on their first iteration.
  *
  * Return: 0 if all trains are done successfully, or corresponding error code.
  */
-static int zynqmp_dp_train(struct zynqmp_dp *dp)
+static int zynqmp_dp_train(struct zynqmp_dp *dp, bool restore)
 {
 	u32 reg;
 	u8 bw_code = dp->mode.bw_code;
@@ -991,7 +1012,11 @@ static int zynqmp_dp_train(struct zynqmp_dp *dp)
 		return ret;
 
 	zynqmp_dp_write(dp->iomem, ZYNQMP_DP_TX_SCRAMBLING_DISABLE, 1);
-	memset(dp->train_set, 0, ARRAY_SIZE(dp->train_set));
+	if (restore)
+		memcpy(dp->train_set, dp->train_cache.train_set,
+		       sizeof(dp->train_set));
+	else
+		memset(dp->train_set, 0, ARRAY_SIZE(dp->train_set));
 	ret = zynqmp_dp_link_train_cr(dp);
 	if (ret)
 		return ret;
@@ -1011,6 +1036,12 @@ static int zynqmp_dp_train(struct zynqmp_dp *dp)
 
 	zynqmp_dp_write(dp->iomem, ZYNQMP_DP_TX_SCRAMBLING_DISABLE, 0);
 
+	dp->train_cache.bw_code = bw_code;
+	dp->train_cache.lane_cnt = lane_cnt;
+	memcpy(dp->train_cache.train_set, dp->train_set,
+	       sizeof(dp->train_cache.train_set));
+	dp->train_cache.valid = true;
+
 	return 0;
 }
 
@@ -1019,19 +1050,36 @@ static int zynqmp_dp_train(struct zynqmp_dp *dp)
  * @dp: DisplayPort IP core structure
  *
  * Train the link by downshifting the link rate if training is not successful.
+ * A link trained before at the same rate and lane count is first restored
+ * from the cached training values, and fully retrained only if that fails.
  */
 static void zynqmp_dp_train_loop(struct zynqmp_dp *dp)
 {
 	struct zynqmp_dp_mode *mode = &dp->mode;
+	struct zynqmp_dp_train_cache *cache = &dp->train_cache;
 	u8 bw = mode->bw_code;
 	int ret;
 
+	if (cache->valid && cache->bw_code == bw &&
+	    cache->lane_cnt == mode->lane_cnt) {
+		if (dp->status == connector_status_disconnected ||
+		    !dp->enabled)
+			return;
+
+		ret = zynqmp_dp_train(dp, true);
+		if (!ret)
+			return;
+
+		dev_dbg(dp->dev, "link restore failed, retraining the link\n");
+	}
+	cache->valid = false;
+
 	do {
 		if (dp->status == connector_status_disconnected ||
 		    !dp->enabled)
 			return;
 
-		ret = zynqmp_dp_train(dp);
+		ret = zynqmp_dp_train(dp, false);
 		if (!ret)
 			return;
 
@@ -1479,6 +1527,8 @@ zynqmp_dp_connector_detect(struct drm_connector *connector, bool force)
 
 disconnected:
 	dp->status = connector_status_disconnected;
+	/* The next sink may need different training values */
+	dp->train_cache.valid = false;
 	return connector_status_disconnected;
 }
 
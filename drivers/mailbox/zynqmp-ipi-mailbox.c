@@ -11,6 +11,7 @@
 #include <linux/interrupt.h>
 #include <linux/io.h>
 #include <linux/kernel.h>
+#include <linux/log2.h>
 #include <linux/mailbox_controller.h>
 #include <linux/mailbox/zynqmp-ipi-message.h>
 #include <linux/module.h>
@@ -54,6 +55,23 @@
 #define IPI_MB_CHNL_TX	0 /* IPI mailbox TX channel */
 #define IPI_MB_CHNL_RX	1 /* IPI mailbox RX channel */
 
+/* Default slot size of the shared memory rings */
+#define IPI_RING_DEFAULT_SLOT_SIZE	64U
+
+/**
+ * struct zynqmp_ipi_ring - Description of a ZynqMP IPI shared memory ring
+ * @hdr: ring header, NULL if the channel uses the IPI buffers
+ * @slots: first slot of the ring
+ * @mask: mask to get the slot of a free running index
+ * @slot_size: size of a slot in bytes
+ */
+struct zynqmp_ipi_ring {
+	struct zynqmp_ipi_ring_hdr *hdr;
+	void *slots;
+	u32 mask;
+	u32 slot_size;
+};
+
 /**
  * struct zynqmp_ipi_mchan - Description of a Xilinx ZynqMP IPI mailbox channel
  * @is_opened: indicate if the IPI channel is opened
@@ -63,6 +81,10 @@
  * @resp_buf_size: response buffer size
  * @rx_buf: receive buffer to pass received message to client
  * @chan_type: channel type
+ * @ring: shared memory ring of the channel direction
+ * @ring_lock: serializes the readers of the RX ring
+ * @txdone_tasklet: ticks the TX state machine once a message is in the ring
+ * @chan: mailbox channel
  */
 struct zynqmp_ipi_mchan {
 	int is_opened;
@@ -72,6 +94,10 @@ struct zynqmp_ipi_mchan {
 	size_t req_buf_size;
 	size_t resp_buf_size;
 	unsigned int chan_type;
+	struct zynqmp_ipi_ring ring;
+	spinlock_t ring_lock;
+	struct tasklet_struct txdone_tasklet;
+	struct mbox_chan *chan;
 };
 
 /**
@@ -133,6 +159,178 @@ static void zynqmp_ipi_fw_call(struct zynqmp_ipi_mbox *ipi_mbox,
 		arm_smccc_hvc(a0, a1, a2, a3, 0, 0, 0, 0, res);
 }
 
+static inline bool zynqmp_ipi_has_ring(struct zynqmp_ipi_mbox *ipi_mbox)
+{
+	return ipi_mbox->mchans[IPI_MB_CHNL_TX].ring.hdr;
+}
+
+static inline void *zynqmp_ipi_ring_slot(struct zynqmp_ipi_ring *ring,
+					 u32 idx)
+{
+	return ring->slots + (idx & ring->mask) * ring->slot_size;
+}
+
+static inline bool zynqmp_ipi_ring_full(struct zynqmp_ipi_ring *ring)
+{
+	struct zynqmp_ipi_ring_hdr *hdr = ring->hdr;
+
+	return READ_ONCE(hdr->head) - READ_ONCE(hdr->tail) > ring->mask;
+}
+
+static void zynqmp_ipi_ring_reset(struct zynqmp_ipi_ring *ring)
+{
+	struct zynqmp_ipi_ring_hdr *hdr = ring->hdr;
+
+	WRITE_ONCE(hdr->head, 0);
+	WRITE_ONCE(hdr->tail, 0);
+	WRITE_ONCE(hdr->idle, 1);
+	WRITE_ONCE(hdr->wait, 0);
+	WRITE_ONCE(hdr->num_slots, ring->mask + 1);
+	WRITE_ONCE(hdr->slot_size, ring->slot_size);
+	wmb();
+}
+
+/**
+ * zynqmp_ipi_ring_send - Write a message to the TX ring
+ *
+ * @ipi_mbox: ZynqMP IPI mailbox
+ * @mchan: TX channel
+ * @msg: message, NULL for an empty message
+ *
+ * The doorbell is only rung if the remote has gone idle, a remote which is
+ * still reading the ring picks the message up without another interrupt.
+ *
+ * Return: 0 if the message is in the ring, -EBUSY if the ring is full, the
+ * remote kicks us once it has freed a slot.
+ */
+static int zynqmp_ipi_ring_send(struct zynqmp_ipi_mbox *ipi_mbox,
+				struct zynqmp_ipi_mchan *mchan,
+				struct zynqmp_ipi_message *msg)
+{
+	struct zynqmp_ipi_ring *ring = &mchan->ring;
+	struct zynqmp_ipi_ring_hdr *hdr = ring->hdr;
+	struct arm_smccc_res res;
+	u32 head, len, *slot;
+
+	len = msg ? msg->len : 0;
+	if (len > ring->slot_size - sizeof(*slot)) {
+		dev_err(&ipi_mbox->dev, "ring message length %u > max %zu\n",
+			len, ring->slot_size - sizeof(*slot));
+		return -EINVAL;
+	}
+
+	if (zynqmp_ipi_ring_full(ring)) {
+		WRITE_ONCE(hdr->wait, 1);
+		/* Order the wait flag against the tail read */
+		mb();
+		if (zynqmp_ipi_ring_full(ring))
+			return -EBUSY;
+		WRITE_ONCE(hdr->wait, 0);
+	}
+
+	head = hdr->head;
+	slot = zynqmp_ipi_ring_slot(ring, head);
+	slot[0] = len;
+	if (len)
+		memcpy(&slot[1], msg->data, len);
+	/* Make the slot visible before the head moves past it */
+	wmb();
+	WRITE_ONCE(hdr->head, head + 1);
+	/* Order the head update against the idle flag read */
+	mb();
+	if (READ_ONCE(hdr->idle))
+		zynqmp_ipi_fw_call(ipi_mbox, SMC_IPI_MAILBOX_NOTIFY, 0, &res);
+
+	tasklet_schedule(&mchan->txdone_tasklet);
+	return 0;
+}
+
+/**
+ * zynqmp_ipi_ring_recv - Pass the messages of the RX ring to the client
+ *
+ * @ipi_mbox: ZynqMP IPI mailbox
+ *
+ * The remote does not ring the doorbell while the idle flag is clear, so
+ * the ring is checked once more after the flag is set again.
+ */
+static void zynqmp_ipi_ring_recv(struct zynqmp_ipi_mbox *ipi_mbox)
+{
+	struct zynqmp_ipi_mchan *mchan = &ipi_mbox->mchans[IPI_MB_CHNL_RX];
+	struct zynqmp_ipi_ring *ring = &mchan->ring;
+	struct zynqmp_ipi_ring_hdr *hdr = ring->hdr;
+	struct zynqmp_ipi_message *msg = mchan->rx_buf;
+	struct arm_smccc_res res;
+	unsigned long flags;
+	bool consumed = false;
+	u32 tail, *slot;
+
+	spin_lock_irqsave(&mchan->ring_lock, flags);
+	tail = hdr->tail;
+	WRITE_ONCE(hdr->idle, 0);
+	for (;;) {
+		while (tail != READ_ONCE(hdr->head)) {
+			/* Read the slot only after the head covers it */
+			rmb();
+			slot = zynqmp_ipi_ring_slot(ring, tail);
+			msg->len = min_t(u32, READ_ONCE(slot[0]),
+					 ring->slot_size - sizeof(*slot));
+			memcpy(msg->data, &slot[1], msg->len);
+			/* Finish reading the slot before handing it back */
+			mb();
+			WRITE_ONCE(hdr->tail, ++tail);
+			consumed = true;
+			mbox_chan_received_data(mchan->chan, msg);
+		}
+
+		WRITE_ONCE(hdr->idle, 1);
+		/* Order the idle flag against the head read */
+		mb();
+		if (READ_ONCE(hdr->head) == tail)
+			break;
+		WRITE_ONCE(hdr->idle, 0);
+	}
+	spin_unlock_irqrestore(&mchan->ring_lock, flags);
+
+	if (consumed && READ_ONCE(hdr->wait))
+		zynqmp_ipi_fw_call(ipi_mbox, SMC_IPI_MAILBOX_NOTIFY, 0, &res);
+}
+
+/**
+ * zynqmp_ipi_ring_notify - Handle a doorbell of a mailbox with rings
+ *
+ * @ipi_mbox: ZynqMP IPI mailbox
+ *
+ * The remote rings the doorbell either because there are new messages in
+ * the RX ring, or because it has freed slots of the TX ring we wait for.
+ */
+static void zynqmp_ipi_ring_notify(struct zynqmp_ipi_mbox *ipi_mbox)
+{
+	struct zynqmp_ipi_mchan *mchan;
+	struct arm_smccc_res res;
+
+	mchan = &ipi_mbox->mchans[IPI_MB_CHNL_RX];
+	if (mchan->is_opened)
+		zynqmp_ipi_ring_recv(ipi_mbox);
+
+	mchan = &ipi_mbox->mchans[IPI_MB_CHNL_TX];
+	if (mchan->is_opened && READ_ONCE(mchan->ring.hdr->wait) &&
+	    !zynqmp_ipi_ring_full(&mchan->ring)) {
+		WRITE_ONCE(mchan->ring.hdr->wait, 0);
+		mbox_chan_txdone(mchan->chan, 0);
+	}
+
+	zynqmp_ipi_fw_call(ipi_mbox, SMC_IPI_MAILBOX_ACK,
+			   IPI_SMC_ACK_EIRQ_MASK, &res);
+}
+
+static void zynqmp_ipi_txdone_tasklet(struct tasklet_struct *t)
+{
+	struct zynqmp_ipi_mchan *mchan = from_tasklet(mchan, t,
+						      txdone_tasklet);
+
+	mbox_chan_txdone(mchan->chan, 0);
+}
+
 /**
  * zynqmp_ipi_interrupt - Interrupt handler for IPI notification
  *
@@ -164,6 +362,10 @@ static irqreturn_t zynqmp_ipi_interrupt(int irq, void *data)
 		zynqmp_ipi_fw_call(ipi_mbox, arg0, arg3, &res);
 		ret = (int)(res.a0 & 0xFFFFFFFF);
 		if (ret > 0 && ret & IPI_MB_STATUS_RECV_PENDING) {
+			if (zynqmp_ipi_has_ring(ipi_mbox)) {
+				zynqmp_ipi_ring_notify(ipi_mbox);
+				return IRQ_HANDLED;
+			}
 			if (mchan->is_opened) {
 				msg = mchan->rx_buf;
 				msg->len = mchan->req_buf_size;
@@ -198,6 +400,13 @@ static bool zynqmp_ipi_peek_data(struct mbox_chan *chan)
 		return false;
 	}
 
+	if (mchan->ring.hdr) {
+		if (mchan->chan_type == IPI_MB_CHNL_TX)
+			return !zynqmp_ipi_ring_full(&mchan->ring);
+		return READ_ONCE(mchan->ring.hdr->head) !=
+		       READ_ONCE(mchan->ring.hdr->tail);
+	}
+
 	arg0 = SMC_IPI_MAILBOX_STATUS_ENQUIRY;
 	zynqmp_ipi_fw_call(ipi_mbox, arg0, 0, &res);
 	ret = (int)(res.a0 & 0xFFFFFFFF);
@@ -276,6 +485,14 @@ static int zynqmp_ipi_send_data(struct mbox_chan *chan, void *data)
 		return -EINVAL;
 	}
 
+	if (mchan->ring.hdr) {
+		if (mchan->chan_type == IPI_MB_CHNL_TX)
+			return zynqmp_ipi_ring_send(ipi_mbox, mchan, msg);
+		/* The rings have no responses, reply through the TX ring */
+		dev_err(dev, "no response message with a shared memory ring\n");
+		return -EINVAL;
+	}
+
 	if (mchan->chan_type == IPI_MB_CHNL_TX) {
 		/* Send request message */
 		if (msg && msg->len > mchan->req_buf_size) {
@@ -329,6 +546,10 @@ static int zynqmp_ipi_startup(struct mbox_chan *chan)
 	/* If no channel has been opened, open the IPI mailbox */
 	nchan_type = (mchan->chan_type + 1) % 2;
 	if (!ipi_mbox->mchans[nchan_type].is_opened) {
+		if (zynqmp_ipi_has_ring(ipi_mbox)) {
+			zynqmp_ipi_ring_reset(&ipi_mbox->mchans[IPI_MB_CHNL_TX].ring);
+			zynqmp_ipi_ring_reset(&ipi_mbox->mchans[IPI_MB_CHNL_RX].ring);
+		}
 		arg0 = SMC_IPI_MAILBOX_OPEN;
 		zynqmp_ipi_fw_call(ipi_mbox, arg0, 0, &res);
 		/* Check the SMC call status, a0 of the result */
@@ -340,8 +561,13 @@ static int zynqmp_ipi_startup(struct mbox_chan *chan)
 		ret = 0;
 	}
 
-	/* If it is RX channel, enable the IPI notification interrupt */
-	if (mchan->chan_type == IPI_MB_CHNL_RX) {
+	/*
+	 * If it is RX channel, enable the IPI notification interrupt. With
+	 * rings the TX channel needs it as well to learn about freed slots.
+	 */
+	if (mchan->chan_type == IPI_MB_CHNL_RX ||
+	    (zynqmp_ipi_has_ring(ipi_mbox) &&
+	     !ipi_mbox->mchans[nchan_type].is_opened)) {
 		arg0 = SMC_IPI_MAILBOX_ENABLE_IRQ;
 		zynqmp_ipi_fw_call(ipi_mbox, arg0, 0, &res);
 	}
@@ -367,12 +593,19 @@ static void zynqmp_ipi_shutdown(struct mbox_chan *chan)
 	if (!mchan->is_opened)
 		return;
 
-	/* If it is RX channel, disable notification interrupt */
+	/*
+	 * If it is RX channel, disable notification interrupt. With rings it
+	 * stays enabled until both channels are closed.
+	 */
 	chan_type = mchan->chan_type;
-	if (chan_type == IPI_MB_CHNL_RX) {
+	if (zynqmp_ipi_has_ring(ipi_mbox) ?
+	    !ipi_mbox->mchans[(chan_type + 1) % 2].is_opened :
+	    chan_type == IPI_MB_CHNL_RX) {
 		arg0 = SMC_IPI_MAILBOX_DISABLE_IRQ;
 		zynqmp_ipi_fw_call(ipi_mbox, arg0, 0, &res);
 	}
+	if (mchan->ring.hdr && chan_type == IPI_MB_CHNL_TX)
+		tasklet_kill(&mchan->txdone_tasklet);
 	/* Release IPI mailbox if no other channel is opened */
 	chan_type = (chan_type + 1) % 2;
 	if (!ipi_mbox->mchans[chan_type].is_opened) {
@@ -449,6 +682,105 @@ static int zynqmp_ipi_mbox_get_buf_res(struct device_node *node,
 	return -ENODEV;
 }
 
+/**
+ * zynqmp_ipi_ring_init - Set up a shared memory ring
+ *
+ * @ring: ring to set up
+ * @base: start of the ring memory
+ * @size: size of the ring memory
+ * @slot_size: size of a slot in bytes
+ *
+ * Return: 0 for success, -EINVAL if the memory cannot hold two slots
+ */
+static int zynqmp_ipi_ring_init(struct zynqmp_ipi_ring *ring, void *base,
+				size_t size, u32 slot_size)
+{
+	size_t num_slots;
+
+	if (size < ZYNQMP_IPI_RING_HDR_SIZE + 2 * slot_size)
+		return -EINVAL;
+
+	num_slots = (size - ZYNQMP_IPI_RING_HDR_SIZE) / slot_size;
+	ring->hdr = base;
+	ring->slots = base + ZYNQMP_IPI_RING_HDR_SIZE;
+	ring->mask = rounddown_pow_of_two(num_slots) - 1;
+	ring->slot_size = slot_size;
+
+	return 0;
+}
+
+/**
+ * zynqmp_ipi_mbox_get_rings - Get the shared memory rings of an IPI mailbox
+ *
+ * @ipi_mbox: pointer to IPI mailbox private data structure
+ * @node: IPI mailbox device node
+ *
+ * The rings are optional, they live in the region the "memory-region"
+ * phandle points to. The local to remote ring takes the first half of the
+ * region and the remote to local ring the second half.
+ *
+ * Return: 0 for success or no rings, negative value for failure
+ */
+static int zynqmp_ipi_mbox_get_rings(struct zynqmp_ipi_mbox *ipi_mbox,
+				     struct device_node *node)
+{
+	struct zynqmp_ipi_mchan *tx = &ipi_mbox->mchans[IPI_MB_CHNL_TX];
+	struct zynqmp_ipi_mchan *rx = &ipi_mbox->mchans[IPI_MB_CHNL_RX];
+	struct device *mdev = &ipi_mbox->dev;
+	u32 slot_size = IPI_RING_DEFAULT_SLOT_SIZE;
+	struct device_node *np;
+	struct resource res;
+	size_t size;
+	void *base;
+	int ret;
+
+	np = of_parse_phandle(node, "memory-region", 0);
+	if (!np)
+		return 0;
+	ret = of_address_to_resource(np, 0, &res);
+	of_node_put(np);
+	if (ret) {
+		dev_err(mdev, "Unable to get IPI ring memory region.\n");
+		return ret;
+	}
+
+	of_property_read_u32(node, "xlnx,ipi-ring-slot-size", &slot_size);
+	if (slot_size < 2 * sizeof(u32) || !IS_ALIGNED(slot_size, sizeof(u32))) {
+		dev_err(mdev, "Invalid IPI ring slot size %u.\n", slot_size);
+		return -EINVAL;
+	}
+
+	size = resource_size(&res);
+	base = devm_memremap(mdev, res.start, size, MEMREMAP_WC);
+	if (IS_ERR(base)) {
+		dev_err(mdev, "Unable to map IPI ring memory\n");
+		return PTR_ERR(base);
+	}
+
+	size /= 2;
+	if (zynqmp_ipi_ring_init(&tx->ring, base, size, slot_size) ||
+	    zynqmp_ipi_ring_init(&rx->ring, base + size, size, slot_size)) {
+		dev_err(mdev, "IPI ring memory too small for slot size %u.\n",
+			slot_size);
+		tx->ring.hdr = NULL;
+		return -EINVAL;
+	}
+
+	/* Messages from the ring can be longer than the IPI buffer */
+	if (slot_size - sizeof(u32) > rx->resp_buf_size) {
+		rx->rx_buf = devm_kzalloc(mdev, slot_size +
+					  sizeof(struct zynqmp_ipi_message),
+					  GFP_KERNEL);
+		if (!rx->rx_buf)
+			return -ENOMEM;
+	}
+
+	spin_lock_init(&rx->ring_lock);
+	tasklet_setup(&tx->txdone_tasklet, zynqmp_ipi_txdone_tasklet);
+
+	return 0;
+}
+
 /**
  * zynqmp_ipi_mbox_dev_release() - release the existence of a ipi mbox dev
  *
@@ -579,13 +911,23 @@ static int zynqmp_ipi_mbox_probe(struct zynqmp_ipi_mbox *ipi_mbox,
 		return ret;
 	}
 
+	ret = zynqmp_ipi_mbox_get_rings(ipi_mbox, node);
+	if (ret)
+		return ret;
+
 	mbox = &ipi_mbox->mbox;
 	mbox->dev = mdev;
 	mbox->ops = &zynqmp_ipi_chan_ops;
 	mbox->num_chans = 2;
-	mbox->txdone_irq = false;
-	mbox->txdone_poll = true;
-	mbox->txpoll_period = 5;
+	if (zynqmp_ipi_has_ring(ipi_mbox)) {
+		/* TX is done as soon as the message is in the ring */
+		mbox->txdone_irq = true;
+		mbox->txdone_poll = false;
+	} else {
+		mbox->txdone_irq = false;
+		mbox->txdone_poll = true;
+		mbox->txpoll_period = 5;
+	}
 	mbox->of_xlate = zynqmp_ipi_of_xlate;
 	chans = devm_kzalloc(mdev, 2 * sizeof(*chans), GFP_KERNEL);
 	if (!chans)
@@ -593,6 +935,8 @@ static int zynqmp_ipi_mbox_probe(struct zynqmp_ipi_mbox *ipi_mbox,
 	mbox->chans = chans;
 	chans[IPI_MB_CHNL_TX].con_priv = &ipi_mbox->mchans[IPI_MB_CHNL_TX];
 	chans[IPI_MB_CHNL_RX].con_priv = &ipi_mbox->mchans[IPI_MB_CHNL_RX];
+	ipi_mbox->mchans[IPI_MB_CHNL_TX].chan = &chans[IPI_MB_CHNL_TX];
+	ipi_mbox->mchans[IPI_MB_CHNL_RX].chan = &chans[IPI_MB_CHNL_RX];
 	ipi_mbox->mchans[IPI_MB_CHNL_TX].chan_type = IPI_MB_CHNL_TX;
 	ipi_mbox->mchans[IPI_MB_CHNL_RX].chan_type = IPI_MB_CHNL_RX;
 	ret = devm_mbox_controller_register(mdev, mbox);
@@ -389,6 +389,12 @@ struct cached_dev {
 	unsigned int		writeback_rate_fp_term_mid;
 	unsigned int		writeback_rate_fp_term_high;
 	unsigned int		writeback_rate_minimum;
+	/* usec, 0 disables throttling on backing device write latency */
+	unsigned int		writeback_latency_target_us;
+
+	/* ewma of writeback write latency in usec, left shifted by 8 */
+	uint64_t		writeback_latency;
+	uint64_t		writeback_latency_last;
 
 	enum stop_on_failure	stop_when_cache_set_failed;
 #define DEFAULT_CACHED_DEV_ERROR_LIMIT	64
@@ -126,6 +126,8 @@ rw_attribute(writeback_rate_fp_term_low);
 rw_attribute(writeback_rate_fp_term_mid);
 rw_attribute(writeback_rate_fp_term_high);
 rw_attribute(writeback_rate_minimum);
+rw_attribute(writeback_latency_target_us);
+read_attribute(writeback_latency_us);
 read_attribute(writeback_rate_debug);
 
 read_attribute(stripe_size);
@@ -213,6 +215,9 @@ SHOW(__bch_cached_dev)
 	var_print(writeback_rate_fp_term_mid);
 	var_print(writeback_rate_fp_term_high);
 	var_print(writeback_rate_minimum);
+	var_print(writeback_latency_target_us);
+	sysfs_print(writeback_latency_us,
+		    READ_ONCE(dc->writeback_latency) >> 8);
 
 	if (attr == &sysfs_writeback_rate_debug) {
 		char rate[20];
@@ -351,6 +356,9 @@ STORE(__cached_dev)
 	sysfs_strtoul_clamp(writeback_rate_minimum,
 			    dc->writeback_rate_minimum,
 			    1, UINT_MAX);
+	sysfs_strtoul_clamp(writeback_latency_target_us,
+			    dc->writeback_latency_target_us,
+			    0, UINT_MAX);
 
 	sysfs_strtoul_clamp(io_error_limit, dc->error_limit, 0, INT_MAX);
 
@@ -523,6 +531,8 @@ static struct attribute *bch_cached_dev_attrs[] = {
 	&sysfs_writeback_rate_fp_term_mid,
 	&sysfs_writeback_rate_fp_term_high,
 	&sysfs_writeback_rate_minimum,
+	&sysfs_writeback_latency_target_us,
+	&sysfs_writeback_latency_us,
 	&sysfs_writeback_rate_debug,
 	&sysfs_io_errors,
 	&sysfs_io_error_limit,
@@ -58,6 +58,28 @@ static uint64_t __calc_target_rate(struct cached_dev *dc)
 	return (cache_dirty_target * bdev_share) >> WRITEBACK_SHARE_SHIFT;
 }
 
+/*
+ * Average latency of writeback writes to the backing device, in usec, or 0
+ * if throttling on it is disabled. Slow flash backing devices stall
+ * foreground reads behind writeback bursts long before the dirty target
+ * says to slow down, so their write latency is what we throttle on.
+ */
+static uint64_t writeback_latency_excess(struct cached_dev *dc)
+{
+	uint64_t latency = READ_ONCE(dc->writeback_latency);
+
+	if (!dc->writeback_latency_target_us)
+		return 0;
+
+	/* No writes completed since the last update, let it decay */
+	if (time_after64(local_clock(), READ_ONCE(dc->writeback_latency_last) +
+			 (u64)dc->writeback_rate_update_seconds * NSEC_PER_SEC))
+		WRITE_ONCE(dc->writeback_latency, latency >> 1);
+
+	latency >>= 8;
+	return latency > dc->writeback_latency_target_us ? latency : 0;
+}
+
 static void __update_writeback_rate(struct cached_dev *dc)
 {
 	/*
@@ -86,6 +108,7 @@ static void __update_writeback_rate(struct cached_dev *dc)
 	int64_t proportional_scaled =
 		div_s64(error, dc->writeback_rate_p_term_inverse);
 	int64_t integral_scaled;
+	uint64_t latency = writeback_latency_excess(dc);
 	uint32_t new_rate;
 
 	/*
@@ -127,13 +150,14 @@ static void __update_writeback_rate(struct cached_dev *dc)
 	}
 
 	if ((error < 0 && dc->writeback_rate_integral > 0) ||
-	    (error > 0 && time_before64(local_clock(),
+	    (error > 0 && !latency && time_before64(local_clock(),
 			 dc->writeback_rate.next + NSEC_PER_MSEC))) {
 		/*
 		 * Only decrease the integral term if it's more than
 		 * zero.  Only increase the integral term if the device
-		 * is keeping up.  (Don't wind up the integral
-		 * ineffectively in either case).
+		 * is keeping up, and we aren't throttling on its latency.
+		 * (Don't wind up the integral ineffectively in either
+		 * case).
 		 *
 		 * It's necessary to scale this by
 		 * writeback_rate_update_seconds to keep the integral
@@ -149,6 +173,13 @@ static void __update_writeback_rate(struct cached_dev *dc)
 	new_rate = clamp_t(int32_t, (proportional_scaled + integral_scaled),
 			dc->writeback_rate_minimum, NSEC_PER_SEC);
 
+	/* Scale down by how far the backing device is over its target */
+	if (latency)
+		new_rate = max_t(uint64_t, dc->writeback_rate_minimum,
+				 div64_u64((uint64_t)new_rate *
+					   dc->writeback_latency_target_us,
+					   latency));
+
 	dc->writeback_rate_proportional = proportional_scaled;
 	dc->writeback_rate_integral_scaled = integral_scaled;
 	dc->writeback_rate_change = new_rate -
@@ -323,6 +354,7 @@ struct dirty_io {
 	struct closure		cl;
 	struct cached_dev	*dc;
 	uint16_t		sequence;
+	uint64_t		submit_time;
 	struct bio		bio;
 };
 
@@ -400,6 +432,24 @@ static void dirty_endio(struct bio *bio)
 	closure_put(&io->cl);
 }
 
+static void write_dirty_endio(struct bio *bio)
+{
+	struct keybuf_key *w = bio->bi_private;
+	struct dirty_io *io = w->private;
+	struct cached_dev *dc = io->dc;
+	uint64_t now = local_clock();
+	uint64_t latency = READ_ONCE(dc->writeback_latency);
+
+	if (!bio->bi_status && now > io->submit_time) {
+		ewma_add(latency, div_u64(now - io->submit_time,
+					  NSEC_PER_USEC), 8, 8);
+		WRITE_ONCE(dc->writeback_latency, latency);
+		WRITE_ONCE(dc->writeback_latency_last, now);
+	}
+
+	dirty_endio(bio);
+}
+
 static void write_dirty(struct closure *cl)
 {
 	struct dirty_io *io = container_of(cl, struct dirty_io, cl);
@@ -437,7 +487,8 @@ static void write_dirty(struct closure *cl)
 		bio_set_op_attrs(&io->bio, REQ_OP_WRITE, 0);
 		io->bio.bi_iter.bi_sector = KEY_START(&w->key);
 		bio_set_dev(&io->bio, io->dc->bdev);
-		io->bio.bi_end_io	= dirty_endio;
+		io->bio.bi_end_io	= write_dirty_endio;
+		io->submit_time		= local_clock();
 
 		/* I/O request sent to backing device */
 		closure_bio_submit(io->dc->disk.c, &io->bio, cl);
@@ -102,6 +102,15 @@
 #define AIE_PART_SYSFS_ERROR_BINA_SIZE		0x4000		/* 16KB */
 #define AIE_PART_SYSFS_STATUS_BINA_SIZE		0x3c000		/* 240KB */
 
+/* Lock request registers, reading one returns whether it is granted */
+#define AIE_SHIMPL_LOCK_REQ_REGOFF		0x00014000U
+#define AIE_TILE_MEM_LOCK_REQ_REGOFF		0x0001E000U
+#define AIE_LOCK_REQ_ID_OFF			0x80U
+#define AIE_LOCK_REQ_RELEASE_OFF		0x20U
+#define AIE_LOCK_REQ_ACQUIRE_OFF		0x60U
+#define AIE_LOCK_REQ_VAL_OFF			0x10U
+#define AIE_LOCK_REQ_GRANTED			BIT(0)
+
 static const struct aie_tile_regs aie_kernel_regs[] = {
 	/* SHIM AXI MM Config */
 	{.attribute = AIE_TILE_TYPE_MASK_SHIMNOC << AIE_REGS_ATTR_TILE_TYPE_SHIFT,
@@ -258,6 +267,7 @@ static const struct aie_dma_attr aie_shimdma = {
 	.num_mm2s_chan = 2U,
 	.num_s2mm_chan = 2U,
 	.bd_len = 0x14U,
+	.bd_done_event = 16U,
 };
 
 static const struct aie_dma_attr aie_tiledma = {
@@ -372,6 +382,22 @@ static const struct aie_l1_intr_ctrl_attr aie_l1_intr_ctrl = {
 		.mask = GENMASK(6, 0),
 		.regoff = 0x44U,
 	},
+	.swa_enable = {
+		.mask = GENMASK(19, 0),
+		.regoff = 0x4U,
+	},
+	.swb_enable = {
+		.mask = GENMASK(19, 0),
+		.regoff = 0x34U,
+	},
+	.swa_disable = {
+		.mask = GENMASK(19, 0),
+		.regoff = 0x8U,
+	},
+	.swb_disable = {
+		.mask = GENMASK(19, 0),
+		.regoff = 0x38U,
+	},
 	.regoff = 0x35000U,
 	.event_lsb = 8,
 	.num_broadcasts = 0x14U,
@@ -1328,6 +1354,39 @@ static u32 aie_get_lock_status(struct aie_partition *apart,
 	return ioread32(apart->aperture->base + regoff);
 }
 
+/**
+ * aie_lock_request() - acquire or release a lock with a value.
+ * @apart: AI engine partition.
+ * @loc: location of AI engine lock.
+ * @lock: lock ID.
+ * @val: lock value, 0 or 1.
+ * @acquire: true to acquire the lock, false to release it.
+ * @return: 1 if the request is granted, 0 if it isn't, negative value for
+ *	    an invalid lock or value.
+ */
+static int aie_lock_request(struct aie_partition *apart,
+			    struct aie_location *loc, u32 lock, s32 val,
+			    bool acquire)
+{
+	u32 ttype, regoff;
+
+	if (lock >= aie_mem_lock.num_locks || val < 0 || val > 1)
+		return -EINVAL;
+
+	ttype = aie_get_tile_type(apart->adev, loc);
+	if (ttype != AIE_TILE_TYPE_TILE)
+		regoff = AIE_SHIMPL_LOCK_REQ_REGOFF;
+	else
+		regoff = AIE_TILE_MEM_LOCK_REQ_REGOFF;
+
+	regoff += lock * AIE_LOCK_REQ_ID_OFF + val * AIE_LOCK_REQ_VAL_OFF;
+	regoff += acquire ? AIE_LOCK_REQ_ACQUIRE_OFF : AIE_LOCK_REQ_RELEASE_OFF;
+	regoff = aie_cal_regoff(apart->adev, *loc, regoff);
+
+	return !!(ioread32(apart->aperture->base + regoff) &
+		  AIE_LOCK_REQ_GRANTED);
+}
+
 /**
  * aie_get_lock_status_str() - returns the string value corresponding to
  *			       lock status value.
@@ -1874,6 +1933,39 @@ static ssize_t aie_get_tile_sysfs_dma_status(struct aie_partition *apart,
 	return len;
 }
 
+/**
+ * aie_dma_active() - check if a DMA channel of a tile is busy
+ * @apart: AI engine partition.
+ * @loc: location of AI engine DMA.
+ * @return: true if a channel is not idle, false otherwise.
+ */
+static bool aie_dma_active(struct aie_partition *apart,
+			   struct aie_location *loc)
+{
+	const struct aie_dma_attr *attr;
+	u32 mm2s, s2mm;
+	u8 i;
+
+	if (aie_get_tile_type(apart->adev, loc) != AIE_TILE_TYPE_TILE)
+		attr = &aie_shimdma;
+	else
+		attr = &aie_tiledma;
+
+	mm2s = aie_get_dma_mm2s_status(apart, loc);
+	for (i = 0; i < attr->num_mm2s_chan; i++) {
+		if (aie_get_chan_status(apart, loc, mm2s, i))
+			return true;
+	}
+
+	s2mm = aie_get_dma_s2mm_status(apart, loc);
+	for (i = 0; i < attr->num_s2mm_chan; i++) {
+		if (aie_get_chan_status(apart, loc, s2mm, i))
+			return true;
+	}
+
+	return false;
+}
+
 static const struct aie_tile_operations aie_ops = {
 	.get_tile_type = aie_get_tile_type,
 	.get_mem_info = aie_get_mem_info,
@@ -1887,6 +1979,8 @@ static const struct aie_tile_operations aie_ops = {
 	.set_part_clocks = aie_set_part_clocks,
 	.set_tile_isolation = aie_set_tile_isolation,
 	.mem_clear = aie_part_clear_mems,
+	.lock_request = aie_lock_request,
+	.dma_active = aie_dma_active,
 };
 
 /**
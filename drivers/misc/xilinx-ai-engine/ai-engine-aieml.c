@@ -100,6 +100,7 @@
 #define AIEML_MEMORY_MODCLOCKCTRL_REGOFF		0x000fff00U
 #define AIEML_MEMORY_MODRESETCTRL_REGOFF		0x000fff10U
 #define AIEML_MEMORY_LOCK_REGOFF			0x000C0000U
+#define AIEML_MEMORY_BD0_0_REGOFF			0x000A0000U
 #define AIEML_MEMORY_LOCK_OVERFLOW_REGOFF		0x000C0420U
 #define AIEML_MEMORY_LOCK_UNDERFLOW_REGOFF		0x000C0428U
 #define AIEML_MEMORY_DMA_S2MM_STATUS_REGOFF		0x000A0660U
@@ -147,6 +148,52 @@
 #define AIEML_PART_SYSFS_DMA_BINA_SIZE		0xC800		/* 50KB */
 #define AIEML_PART_SYSFS_STATUS_BINA_SIZE	0x3c000		/* 240KB */
 
+/* Lock request registers, reading one returns whether it is granted */
+#define AIEML_SHIMNOC_LOCK_REQ_REGOFF			0x00040000U
+#define AIEML_MEMORY_LOCK_REQ_REGOFF			0x000D0000U
+#define AIEML_TILE_MEMMOD_LOCK_REQ_REGOFF		0x00040000U
+#define AIEML_LOCK_REQ_ID_SHIFT				10U
+#define AIEML_LOCK_REQ_ACQUIRE				BIT(9)
+#define AIEML_LOCK_REQ_VAL_MASK				GENMASK(8, 2)
+#define AIEML_LOCK_REQ_GRANTED				BIT(0)
+#define AIEML_LOCK_VAL_MIN				(-64)
+#define AIEML_LOCK_VAL_MAX				63
+
+/* SHIM NOC DMA buffer descriptor fields */
+#define AIEML_SHIMBD_HADDR			GENMASK(15, 0)
+#define AIEML_SHIMBD_WRAP			GENMASK(29, 20)
+#define AIEML_SHIMBD_STEPSIZE			GENMASK(19, 0)
+#define AIEML_SHIMBD_ITER_WRAP			GENMASK(22, 17)
+#define AIEML_SHIMBD_ITER_STEPSIZE		GENMASK(16, 0)
+#define AIEML_SHIMBD_TLAST_SUPPRESS		BIT(31)
+#define AIEML_SHIMBD_NEXT_BD			GENMASK(30, 27)
+#define AIEML_SHIMBD_USE_NEXT_BD		BIT(26)
+#define AIEML_SHIMBD_VALID			BIT(25)
+#define AIEML_SHIMBD_LOCK_REL_VAL		GENMASK(24, 18)
+#define AIEML_SHIMBD_LOCK_REL_ID		GENMASK(16, 13)
+#define AIEML_SHIMBD_LOCK_ACQ_EN		BIT(12)
+#define AIEML_SHIMBD_LOCK_ACQ_VAL		GENMASK(11, 5)
+#define AIEML_SHIMBD_LOCK_ACQ_ID		GENMASK(3, 0)
+#define AIEML_SHIMBD_NUM_WRAPS			2U
+
+/* Memory tile DMA buffer descriptor fields */
+#define AIEML_MEMBD_LEN				GENMASK(16, 0)
+#define AIEML_MEMBD_NEXT_BD			GENMASK(25, 20)
+#define AIEML_MEMBD_USE_NEXT_BD			BIT(19)
+#define AIEML_MEMBD_ADDR			GENMASK(18, 0)
+#define AIEML_MEMBD_TLAST_SUPPRESS		BIT(31)
+#define AIEML_MEMBD_WRAP			GENMASK(26, 17)
+#define AIEML_MEMBD_STEPSIZE			GENMASK(16, 0)
+#define AIEML_MEMBD_ITER_WRAP			GENMASK(22, 17)
+#define AIEML_MEMBD_ITER_STEPSIZE		GENMASK(16, 0)
+#define AIEML_MEMBD_VALID			BIT(31)
+#define AIEML_MEMBD_LOCK_REL_VAL		GENMASK(30, 24)
+#define AIEML_MEMBD_LOCK_REL_ID			GENMASK(23, 16)
+#define AIEML_MEMBD_LOCK_ACQ_EN			BIT(15)
+#define AIEML_MEMBD_LOCK_ACQ_VAL		GENMASK(14, 8)
+#define AIEML_MEMBD_LOCK_ACQ_ID			GENMASK(7, 0)
+#define AIEML_MEMBD_NUM_WRAPS			3U
+
 static const struct aie_tile_regs aieml_kernel_regs[] = {
 	/* SHIM AXI MM Config */
 	{.attribute = AIE_TILE_TYPE_MASK_SHIMNOC << AIE_REGS_ATTR_TILE_TYPE_SHIFT,
@@ -962,6 +1009,9 @@ static const struct aie_dma_attr aieml_memtiledma = {
 		.mask = GENMASK(29, 24),
 		.regoff = 0x0,
 	},
+	.bd_regoff = AIEML_MEMORY_BD0_0_REGOFF,
+	.num_bds = 48U,
+	.bd_len = 0x20U,
 	.num_mm2s_chan = 6U,
 	.num_s2mm_chan = 6U,
 	.mm2s_sts_regoff = AIEML_MEMORY_DMA_MM2S_STATUS_REGOFF,
@@ -1114,6 +1164,22 @@ static const struct aie_l1_intr_ctrl_attr aieml_l1_intr_ctrl = {
 		.mask = GENMASK(6, 0),
 		.regoff = 0x44U,
 	},
+	.swa_enable = {
+		.mask = GENMASK(19, 0),
+		.regoff = 0x4U,
+	},
+	.swb_enable = {
+		.mask = GENMASK(19, 0),
+		.regoff = 0x34U,
+	},
+	.swa_disable = {
+		.mask = GENMASK(19, 0),
+		.regoff = 0x8U,
+	},
+	.swb_disable = {
+		.mask = GENMASK(19, 0),
+		.regoff = 0x38U,
+	},
 	.regoff = 0x35000U,
 	.event_lsb = 8,
 	.num_broadcasts = 0x14U,
@@ -1268,6 +1334,245 @@ static u32 aieml_get_lock_status(struct aie_partition *apart,
 	return aie_get_reg_field(&attr->sts, value);
 }
 
+/**
+ * aieml_lock_request() - acquire or release a semaphore lock with a value.
+ * @apart: AI engine partition.
+ * @loc: location of AI engine lock.
+ * @lock: lock ID.
+ * @val: signed lock value.
+ * @acquire: true to acquire the lock, false to release it.
+ * @return: 1 if the request is granted, 0 if it isn't, negative value for
+ *	    an invalid lock or value.
+ */
+static int aieml_lock_request(struct aie_partition *apart,
+			      struct aie_location *loc, u32 lock, s32 val,
+			      bool acquire)
+{
+	const struct aie_lock_attr *attr;
+	u32 ttype, regoff;
+
+	ttype = aieml_get_tile_type(apart->adev, loc);
+	if (ttype == AIE_TILE_TYPE_TILE) {
+		attr = &aieml_mem_lock;
+		regoff = AIEML_TILE_MEMMOD_LOCK_REQ_REGOFF;
+	} else if (ttype == AIE_TILE_TYPE_MEMORY) {
+		attr = &aieml_memtile_lock;
+		regoff = AIEML_MEMORY_LOCK_REQ_REGOFF;
+	} else {
+		attr = &aieml_pl_lock;
+		regoff = AIEML_SHIMNOC_LOCK_REQ_REGOFF;
+	}
+
+	if (lock >= attr->num_locks || val < AIEML_LOCK_VAL_MIN ||
+	    val > AIEML_LOCK_VAL_MAX)
+		return -EINVAL;
+
+	regoff += lock << AIEML_LOCK_REQ_ID_SHIFT;
+	regoff += FIELD_PREP(AIEML_LOCK_REQ_VAL_MASK, val);
+	if (acquire)
+		regoff += AIEML_LOCK_REQ_ACQUIRE;
+	regoff = aie_cal_regoff(apart->adev, *loc, regoff);
+
+	return !!(ioread32(apart->aperture->base + regoff) &
+		  AIEML_LOCK_REQ_GRANTED);
+}
+
+/*
+ * Lock values are 7 bit two's complement fields, the ids and values are
+ * checked against the field widths by the callers.
+ */
+#define AIEML_BD_LOCK_VAL(v)	((u32)(v) & GENMASK(6, 0))
+
+/**
+ * aieml_bd_fits() - check the fields of a generic buffer descriptor fit
+ * @args: generic buffer descriptor
+ * @num_wraps: number of dimensions with a wrap field, the next dimension
+ *	       only has a step size
+ * @wrap: wrap field mask
+ * @step: step size field mask
+ * @iter_wrap: iteration wrap field mask
+ * @iter_step: iteration step size field mask
+ * @lock_id: lock id field mask
+ * @return: true if every field fits the buffer descriptor format
+ */
+static bool aieml_bd_fits(const struct aie_dma_nd_bd_args *args,
+			  u32 num_wraps, u32 wrap, u32 step, u32 iter_wrap,
+			  u32 iter_step, u32 lock_id)
+{
+	u32 i;
+
+	if (args->num_dims > num_wraps + 1)
+		return false;
+
+	for (i = 0; i < args->num_dims; i++) {
+		/* The step sizes are programmed minus one */
+		if (args->dims[i].stepsize - 1 > field_max(step))
+			return false;
+		/* The outermost wrap follows from the length */
+		if (i < num_wraps && i + 1 < args->num_dims &&
+		    args->dims[i].wrap > field_max(wrap))
+			return false;
+	}
+
+	if (args->iter_wrap &&
+	    (args->iter_wrap - 1 > field_max(iter_wrap) ||
+	     !args->iter_stepsize ||
+	     args->iter_stepsize - 1 > field_max(iter_step)))
+		return false;
+
+	if (args->lock_acq_id > field_max(lock_id) ||
+	    args->lock_rel_id > field_max(lock_id) ||
+	    args->lock_acq_val < AIEML_LOCK_VAL_MIN ||
+	    args->lock_acq_val > AIEML_LOCK_VAL_MAX ||
+	    args->lock_rel_val < AIEML_LOCK_VAL_MIN ||
+	    args->lock_rel_val > AIEML_LOCK_VAL_MAX)
+		return false;
+
+	return true;
+}
+
+/**
+ * aieml_encode_shim_nd_bd() - encode a SHIM NOC DMA buffer descriptor
+ * @args: generic buffer descriptor
+ * @addr: DMA address of the buffer
+ * @bd: buffer descriptor words
+ * @return: 0 for success, negative value if the descriptor doesn't fit
+ */
+static int aieml_encode_shim_nd_bd(const struct aie_dma_nd_bd_args *args,
+				   u64 addr, u32 *bd)
+{
+	const struct aie_dma_dim *dims = args->dims;
+	u32 i;
+
+	if (!aieml_bd_fits(args, AIEML_SHIMBD_NUM_WRAPS, AIEML_SHIMBD_WRAP,
+			   AIEML_SHIMBD_STEPSIZE, AIEML_SHIMBD_ITER_WRAP,
+			   AIEML_SHIMBD_ITER_STEPSIZE,
+			   AIEML_SHIMBD_LOCK_ACQ_ID) ||
+	    (addr & 0x3) || upper_32_bits(addr) > field_max(AIEML_SHIMBD_HADDR))
+		return -EINVAL;
+
+	bd[0] = args->len / sizeof(u32);
+	bd[1] = lower_32_bits(addr);
+	bd[2] = FIELD_PREP(AIEML_SHIMBD_HADDR, upper_32_bits(addr));
+
+	/* Words 3 to 5 hold D0 to D2, the outermost one has no wrap */
+	for (i = 0; i < args->num_dims; i++) {
+		bd[3 + i] |= FIELD_PREP(AIEML_SHIMBD_STEPSIZE,
+					dims[i].stepsize - 1);
+		if (i < AIEML_SHIMBD_NUM_WRAPS && i + 1 < args->num_dims)
+			bd[3 + i] |= FIELD_PREP(AIEML_SHIMBD_WRAP,
+						dims[i].wrap);
+	}
+
+	if (args->iter_wrap)
+		bd[6] = FIELD_PREP(AIEML_SHIMBD_ITER_WRAP, args->iter_wrap - 1) |
+			FIELD_PREP(AIEML_SHIMBD_ITER_STEPSIZE,
+				   args->iter_stepsize - 1);
+
+	bd[7] = AIEML_SHIMBD_VALID;
+	if (args->flags & AIE_DMA_BD_TLAST_SUPPRESS)
+		bd[7] |= AIEML_SHIMBD_TLAST_SUPPRESS;
+	if (args->flags & AIE_DMA_BD_USE_NEXT)
+		bd[7] |= AIEML_SHIMBD_USE_NEXT_BD |
+			 FIELD_PREP(AIEML_SHIMBD_NEXT_BD, args->next_bd);
+	if (args->flags & AIE_DMA_BD_LOCK_ACQ)
+		bd[7] |= AIEML_SHIMBD_LOCK_ACQ_EN |
+			 FIELD_PREP(AIEML_SHIMBD_LOCK_ACQ_ID,
+				    args->lock_acq_id) |
+			 FIELD_PREP(AIEML_SHIMBD_LOCK_ACQ_VAL,
+				    AIEML_BD_LOCK_VAL(args->lock_acq_val));
+	if (args->flags & AIE_DMA_BD_LOCK_REL)
+		bd[7] |= FIELD_PREP(AIEML_SHIMBD_LOCK_REL_ID,
+				    args->lock_rel_id) |
+			 FIELD_PREP(AIEML_SHIMBD_LOCK_REL_VAL,
+				    AIEML_BD_LOCK_VAL(args->lock_rel_val));
+
+	return 0;
+}
+
+/**
+ * aieml_encode_mem_nd_bd() - encode a memory tile DMA buffer descriptor
+ * @args: generic buffer descriptor
+ * @addr: byte address in the memory tile address space
+ * @bd: buffer descriptor words
+ * @return: 0 for success, negative value if the descriptor doesn't fit
+ */
+static int aieml_encode_mem_nd_bd(const struct aie_dma_nd_bd_args *args,
+				  u64 addr, u32 *bd)
+{
+	const struct aie_dma_dim *dims = args->dims;
+	u32 i, len = args->len / sizeof(u32);
+
+	if (!aieml_bd_fits(args, AIEML_MEMBD_NUM_WRAPS, AIEML_MEMBD_WRAP,
+			   AIEML_MEMBD_STEPSIZE, AIEML_MEMBD_ITER_WRAP,
+			   AIEML_MEMBD_ITER_STEPSIZE,
+			   AIEML_MEMBD_LOCK_ACQ_ID) ||
+	    (addr & 0x3) ||
+	    addr / sizeof(u32) > field_max(AIEML_MEMBD_ADDR) ||
+	    len > field_max(AIEML_MEMBD_LEN))
+		return -EINVAL;
+
+	/* Lengths, addresses and step sizes are in 32bit words */
+	bd[0] = FIELD_PREP(AIEML_MEMBD_LEN, len);
+	bd[1] = FIELD_PREP(AIEML_MEMBD_ADDR, addr / sizeof(u32));
+	if (args->flags & AIE_DMA_BD_USE_NEXT)
+		bd[1] |= AIEML_MEMBD_USE_NEXT_BD |
+			 FIELD_PREP(AIEML_MEMBD_NEXT_BD, args->next_bd);
+
+	/* Words 2 to 5 hold D0 to D3, the outermost one has no wrap */
+	for (i = 0; i < args->num_dims; i++) {
+		bd[2 + i] |= FIELD_PREP(AIEML_MEMBD_STEPSIZE,
+					dims[i].stepsize - 1);
+		if (i < AIEML_MEMBD_NUM_WRAPS && i + 1 < args->num_dims)
+			bd[2 + i] |= FIELD_PREP(AIEML_MEMBD_WRAP,
+						dims[i].wrap);
+	}
+	if (args->flags & AIE_DMA_BD_TLAST_SUPPRESS)
+		bd[2] |= AIEML_MEMBD_TLAST_SUPPRESS;
+
+	if (args->iter_wrap)
+		bd[6] = FIELD_PREP(AIEML_MEMBD_ITER_WRAP, args->iter_wrap - 1) |
+			FIELD_PREP(AIEML_MEMBD_ITER_STEPSIZE,
+				   args->iter_stepsize - 1);
+
+	bd[7] = AIEML_MEMBD_VALID;
+	if (args->flags & AIE_DMA_BD_LOCK_ACQ)
+		bd[7] |= AIEML_MEMBD_LOCK_ACQ_EN |
+			 FIELD_PREP(AIEML_MEMBD_LOCK_ACQ_ID,
+				    args->lock_acq_id) |
+			 FIELD_PREP(AIEML_MEMBD_LOCK_ACQ_VAL,
+				    AIEML_BD_LOCK_VAL(args->lock_acq_val));
+	if (args->flags & AIE_DMA_BD_LOCK_REL)
+		bd[7] |= FIELD_PREP(AIEML_MEMBD_LOCK_REL_ID,
+				    args->lock_rel_id) |
+			 FIELD_PREP(AIEML_MEMBD_LOCK_REL_VAL,
+				    AIEML_BD_LOCK_VAL(args->lock_rel_val));
+
+	return 0;
+}
+
+/**
+ * aieml_encode_nd_bd() - encode a generic buffer descriptor for AIEML
+ * @apart: AI engine partition.
+ * @loc: location of the SHIM NOC or memory tile.
+ * @args: generic buffer descriptor, its outermost wrap is derived.
+ * @addr: DMA address for SHIM NOC tiles, local address for memory tiles.
+ * @bd: zeroed buffer descriptor words.
+ * @return: 0 for success, negative value if the descriptor doesn't fit.
+ */
+static int aieml_encode_nd_bd(struct aie_partition *apart,
+			      struct aie_location *loc,
+			      const struct aie_dma_nd_bd_args *args, u64 addr,
+			      u32 *bd)
+{
+	u32 ttype = aieml_get_tile_type(apart->adev, loc);
+
+	if (ttype == AIE_TILE_TYPE_MEMORY)
+		return aieml_encode_mem_nd_bd(args, addr, bd);
+
+	return aieml_encode_shim_nd_bd(args, addr, bd);
+}
+
 static u64 aieml_get_lock_overflow_status(struct aie_partition *apart,
 					  struct aie_location *loc)
 {
@@ -1971,6 +2276,36 @@ static int aieml_set_tile_isolation(struct aie_partition *apart,
 	return 0;
 }
 
+/**
+ * aieml_dma_active() - check if a DMA channel of a tile is busy
+ * @apart: AI engine partition.
+ * @loc: location of AI engine DMA.
+ * @return: true if a channel is not idle, false otherwise.
+ */
+static bool aieml_dma_active(struct aie_partition *apart,
+			     struct aie_location *loc)
+{
+	const struct aie_dma_attr *attr;
+	u32 status;
+	u8 i;
+
+	aieml_get_tile_dma_attr(apart, loc, &attr);
+
+	for (i = 0; i < attr->num_mm2s_chan; i++) {
+		status = aieml_get_dma_mm2s_status(apart, loc, i);
+		if (aieml_get_chan_status(apart, loc, status))
+			return true;
+	}
+
+	for (i = 0; i < attr->num_s2mm_chan; i++) {
+		status = aieml_get_dma_s2mm_status(apart, loc, i);
+		if (aieml_get_chan_status(apart, loc, status))
+			return true;
+	}
+
+	return false;
+}
+
 static const struct aie_tile_operations aieml_ops = {
 	.get_tile_type = aieml_get_tile_type,
 	.get_mem_info = aieml_get_mem_info,
@@ -1988,6 +2323,9 @@ static const struct aie_tile_operations aieml_ops = {
 	.get_dma_mm2s_status = aieml_get_dma_mm2s_status,
 	.get_chan_status = aieml_get_chan_status,
 	.get_lock_status = aieml_get_lock_status,
+	.lock_request = aieml_lock_request,
+	.encode_nd_bd = aieml_encode_nd_bd,
+	.dma_active = aieml_dma_active,
 };
 
 /**
@@ -10,8 +10,11 @@
 #include <linux/firmware/xlnx-zynqmp.h>
 #include <linux/slab.h>
 #include <linux/uaccess.h>
+#include <linux/workqueue.h>
 #include <linux/xlnx-ai-engine.h>
 
+#define AIE_CORE_STS_ENABLE_MASK	BIT(0)
+
 /**
  * aie_part_get_clk_state_bit() - return bit position of the clock state of a
  *				  tile
@@ -64,6 +67,23 @@ bool aie_part_check_clk_enable_loc(struct aie_partition *apart,
 	return aie_resource_testbit(&apart->cores_clk_state, bit);
 }
 
+/**
+ * aie_part_check_tile_inuse_loc() - return if a tile is in use
+ * @apart: AI engine partition
+ * @loc: AI engine tile location
+ * @return: true if the tile has been requested, false otherwise
+ */
+bool aie_part_check_tile_inuse_loc(struct aie_partition *apart,
+				   struct aie_location *loc)
+{
+	int bit = aie_part_get_clk_state_bit(apart, loc);
+
+	if (bit < 0)
+		return false;
+
+	return aie_resource_testbit(&apart->tiles_inuse, bit);
+}
+
 /**
  * aie_part_request_tiles() - request tiles from an AI engine partition.
  * @apart: AI engine partition
@@ -334,6 +354,167 @@ int aie_part_set_column_clock_from_user(struct aie_partition *apart,
 	return ret;
 }
 
+/**
+ * aie_part_core_enabled() - check if the core of a tile is enabled
+ * @apart: AI engine partition
+ * @loc: absolute tile location
+ * @return: true if the tile is an ungated AIE tile with its core enabled
+ */
+static bool aie_part_core_enabled(struct aie_partition *apart,
+				  struct aie_location *loc)
+{
+	u32 ttype = apart->adev->ops->get_tile_type(apart->adev, loc);
+
+	if (ttype != AIE_TILE_TYPE_TILE ||
+	    !aie_part_check_clk_enable_loc(apart, loc))
+		return false;
+
+	return apart->adev->ops->get_core_status(apart, loc) &
+	       AIE_CORE_STS_ENABLE_MASK;
+}
+
+/**
+ * aie_part_col_is_idle() - check if a column of a partition can be gated
+ * @apart: AI engine partition
+ * @col: absolute column
+ * @return: true if the column has tiles in use but none of them is used
+ *
+ * A column is idle if none of its tiles has resources allocated or a DMA
+ * channel running, and no core of it or of its neighbour columns, which can
+ * access its memories, is enabled. No column is idle while the memories or
+ * the registers of the partition are mapped to user space, an access to a
+ * gated tile would raise a decode error.
+ */
+static bool aie_part_col_is_idle(struct aie_partition *apart, u32 col)
+{
+	const struct aie_tile_operations *ops = apart->adev->ops;
+	struct aie_range *range = &apart->range;
+	u32 sbit, scol, ecol, nrows = range->size.row - 1;
+	struct aie_location loc;
+
+	/* Nothing to gate if no tile of the column is in use */
+	sbit = (col - range->start.col) * nrows;
+	if (!nrows || find_next_bit(apart->tiles_inuse.bitmap, sbit + nrows,
+				    sbit) >= sbit + nrows)
+		return false;
+
+	if (aie_part_has_mem_mmapped(apart) || aie_part_has_regs_mmapped(apart))
+		return false;
+
+	scol = col > range->start.col ? col - 1 : col;
+	ecol = col + 1 < range->start.col + range->size.col ? col + 1 : col;
+	for (loc.row = range->start.row + 1;
+	     loc.row < range->start.row + range->size.row; loc.row++) {
+		loc.col = col;
+		if (aie_part_check_clk_enable_loc(apart, &loc) &&
+		    (aie_part_rscmgr_tile_in_use(apart, loc) ||
+		     (ops->dma_active && ops->dma_active(apart, &loc))))
+			return false;
+
+		for (loc.col = scol; loc.col <= ecol; loc.col++) {
+			if (aie_part_core_enabled(apart, &loc))
+				return false;
+		}
+	}
+
+	return true;
+}
+
+/**
+ * aie_part_autogate_work() - gate the columns which stay idle
+ * @work: automatic gating work of an AI engine partition
+ *
+ * This function checks the activity of the columns of the partition. The
+ * tiles of the columns found idle @autogate_idle_periods consecutive times
+ * are released, which gates them. A column used again restarts its count,
+ * so that columns switching between busy and idle are not gated.
+ */
+void aie_part_autogate_work(struct work_struct *work)
+{
+	struct aie_partition *apart = container_of(to_delayed_work(work),
+						   struct aie_partition,
+						   autogate_work);
+	struct aie_range *range = &apart->range;
+	u32 c, nrows = range->size.row - 1;
+	bool gate = false;
+
+	mutex_lock(&apart->mlock);
+
+	for (c = 0; c < range->size.col; c++) {
+		if (!aie_part_col_is_idle(apart, range->start.col + c)) {
+			apart->autogate_idle[c] = 0;
+			continue;
+		}
+
+		if (++apart->autogate_idle[c] < apart->autogate_idle_periods)
+			continue;
+
+		apart->autogate_idle[c] = 0;
+		aie_resource_clear(&apart->tiles_inuse, c * nrows, nrows);
+		gate = true;
+	}
+
+	if (gate && apart->adev->ops->set_part_clocks(apart))
+		dev_warn(&apart->dev, "failed to gate idle columns.\n");
+
+	mutex_unlock(&apart->mlock);
+
+	schedule_delayed_work(&apart->autogate_work, apart->autogate_period);
+}
+
+/**
+ * aie_part_set_auto_gate_from_user() - set automatic column clock gating of
+ *					an AI engine partition from user
+ * @apart: AI engine partition
+ * @user_args: user AI engine automatic gating argument
+ * @return: 0 for success, negative value for failure.
+ */
+int aie_part_set_auto_gate_from_user(struct aie_partition *apart,
+				     void __user *user_args)
+{
+	struct aie_auto_gate_args args;
+	int ret;
+
+	if (copy_from_user(&args, user_args, sizeof(args)))
+		return -EFAULT;
+
+	/* The work takes the partition lock */
+	cancel_delayed_work_sync(&apart->autogate_work);
+	if (!args.period_ms)
+		return 0;
+
+	if (!args.idle_periods) {
+		dev_err(&apart->dev, "invalid automatic gating idle periods.\n");
+		return -EINVAL;
+	}
+
+	ret = mutex_lock_interruptible(&apart->mlock);
+	if (ret)
+		return ret;
+
+	if (!apart->autogate_idle) {
+		apart->autogate_idle = devm_kcalloc(&apart->dev,
+						    apart->range.size.col,
+						    sizeof(*apart->autogate_idle),
+						    GFP_KERNEL);
+		if (!apart->autogate_idle) {
+			mutex_unlock(&apart->mlock);
+			return -ENOMEM;
+		}
+	} else {
+		memset(apart->autogate_idle, 0, apart->range.size.col *
+		       sizeof(*apart->autogate_idle));
+	}
+
+	apart->autogate_period = msecs_to_jiffies(args.period_ms);
+	apart->autogate_idle_periods = args.idle_periods;
+	mutex_unlock(&apart->mlock);
+
+	schedule_delayed_work(&apart->autogate_work, apart->autogate_period);
+
+	return 0;
+}
+
 /**
  * aie_aperture_get_freq_req() - get current required frequency of aperture
  * @aperture: AI engine aperture
@@ -0,0 +1,222 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Xilinx AI Engine partition devfreq support
+ *
+ * Copyright (C) 2023 Xilinx, Inc.
+ */
+#include <linux/devfreq.h>
+#include <linux/ktime.h>
+#include <linux/slab.h>
+#include "ai-engine-internal.h"
+
+/* Frequency levels are the full frequency divided by 1 up to this value */
+#define AIE_DEVFREQ_NUM_LEVELS	4U
+#define AIE_DEVFREQ_POLLING_MS	50U
+
+/*
+ * A core runs if the enable bit is the only bit set in its status, any other
+ * bit reports it in reset, stalled, halted or done.
+ */
+#define AIE_DEVFREQ_CORE_STS_ENABLE	BIT(0)
+
+/**
+ * struct aie_part_devfreq - AI engine partition devfreq
+ * @profile: devfreq profile of the partition
+ * @freq_table: frequency levels in ascending order
+ * @devfreq: devfreq device of the partition
+ * @last_time: time of the last utilisation sample
+ */
+struct aie_part_devfreq {
+	struct devfreq_dev_profile profile;
+	unsigned long freq_table[AIE_DEVFREQ_NUM_LEVELS];
+	struct devfreq *devfreq;
+	ktime_t last_time;
+};
+
+/**
+ * aie_part_devfreq_target() - set the frequency requirement of a partition
+ * @dev: AI engine partition device
+ * @freq: recommended frequency, returns the frequency requirement set
+ * @flags: devfreq flags
+ * @return: 0 for success, negative value for failure
+ *
+ * The frequency level is rounded up to meet the recommended frequency,
+ * unless the governor asks for the least upper bound. The aperture runs at
+ * the highest requirement of its partitions.
+ */
+static int aie_part_devfreq_target(struct device *dev, unsigned long *freq,
+				   u32 flags)
+{
+	struct aie_partition *apart = dev_to_aiepart(dev);
+	unsigned long *table = apart->pdevfreq->freq_table;
+	int i, ret;
+
+	if (flags & DEVFREQ_FLAG_LEAST_UPPER_BOUND) {
+		for (i = AIE_DEVFREQ_NUM_LEVELS - 1; i > 0; i--) {
+			if (table[i] <= *freq)
+				break;
+		}
+	} else {
+		for (i = 0; i < AIE_DEVFREQ_NUM_LEVELS - 1; i++) {
+			if (table[i] >= *freq)
+				break;
+		}
+	}
+
+	ret = aie_part_set_freq(apart, table[i]);
+	if (ret)
+		return ret;
+
+	*freq = table[i];
+	return 0;
+}
+
+/**
+ * aie_part_devfreq_get_dev_status() - get the utilisation of a partition
+ * @dev: AI engine partition device
+ * @stat: returns the utilisation of the partition since the last call
+ * @return: 0 for success, negative value for failure
+ *
+ * The utilisation is the ratio of the enabled cores of the partition which
+ * are running, that is not stalled on memories, locks or streams, halted or
+ * done. A partition without enabled cores is idle.
+ */
+static int aie_part_devfreq_get_dev_status(struct device *dev,
+					   struct devfreq_dev_status *stat)
+{
+	struct aie_partition *apart = dev_to_aiepart(dev);
+	struct aie_part_devfreq *pdevfreq = apart->pdevfreq;
+	u32 i, busy = 0, active = 0;
+	ktime_t now = ktime_get();
+	s64 elapsed;
+	u64 freq;
+	int ret;
+
+	ret = aie_part_get_freq(apart, &freq);
+	if (ret)
+		return ret;
+
+	ret = mutex_lock_interruptible(&apart->mlock);
+	if (ret)
+		return ret;
+
+	for (i = 0; i < apart->range.size.col * apart->range.size.row; i++) {
+		struct aie_location *loc = &apart->atiles[i].loc;
+		u32 status;
+
+		if (apart->adev->ops->get_tile_type(apart->adev, loc) !=
+		    AIE_TILE_TYPE_TILE ||
+		    !aie_part_check_clk_enable_loc(apart, loc))
+			continue;
+
+		status = apart->adev->ops->get_core_status(apart, loc);
+		if (!(status & AIE_DEVFREQ_CORE_STS_ENABLE))
+			continue;
+
+		active++;
+		if (status == AIE_DEVFREQ_CORE_STS_ENABLE)
+			busy++;
+	}
+
+	mutex_unlock(&apart->mlock);
+
+	elapsed = max_t(s64, ktime_us_delta(now, pdevfreq->last_time), 1);
+	pdevfreq->last_time = now;
+
+	stat->current_frequency = freq;
+	stat->busy_time = elapsed * busy;
+	stat->total_time = elapsed * max_t(u32, active, 1);
+
+	return 0;
+}
+
+static int aie_part_devfreq_get_cur_freq(struct device *dev,
+					 unsigned long *freq)
+{
+	struct aie_partition *apart = dev_to_aiepart(dev);
+	u64 cur_freq;
+	int ret;
+
+	ret = aie_part_get_freq(apart, &cur_freq);
+	if (ret)
+		return ret;
+
+	*freq = cur_freq;
+	return 0;
+}
+
+/**
+ * aie_part_devfreq_init() - add the devfreq device of a partition
+ * @apart: AI engine partition
+ * @return: 0 for success, negative value for failure
+ *
+ * The simple ondemand governor scales the frequency requirement of the
+ * partition with the utilisation of its cores. The requirement set by the
+ * governor replaces the one set with aie_partition_set_freq_req(), the
+ * governor can be changed from the devfreq sysfs to pin the frequency.
+ */
+int aie_part_devfreq_init(struct aie_partition *apart)
+{
+	struct aie_part_devfreq *pdevfreq;
+	unsigned long clk_rate;
+	u64 freq;
+	int i, ret;
+
+	clk_rate = clk_get_rate(apart->adev->clk);
+	if (!clk_rate)
+		return -EINVAL;
+
+	ret = aie_part_get_freq(apart, &freq);
+	if (ret)
+		return ret;
+
+	pdevfreq = kzalloc(sizeof(*pdevfreq), GFP_KERNEL);
+	if (!pdevfreq)
+		return -ENOMEM;
+
+	for (i = 0; i < AIE_DEVFREQ_NUM_LEVELS; i++)
+		pdevfreq->freq_table[i] = clk_rate /
+					  (AIE_DEVFREQ_NUM_LEVELS - i);
+
+	pdevfreq->profile.initial_freq = freq;
+	pdevfreq->profile.polling_ms = AIE_DEVFREQ_POLLING_MS;
+	pdevfreq->profile.target = aie_part_devfreq_target;
+	pdevfreq->profile.get_dev_status = aie_part_devfreq_get_dev_status;
+	pdevfreq->profile.get_cur_freq = aie_part_devfreq_get_cur_freq;
+	pdevfreq->profile.freq_table = pdevfreq->freq_table;
+	pdevfreq->profile.max_state = AIE_DEVFREQ_NUM_LEVELS;
+	pdevfreq->last_time = ktime_get();
+
+	/* The governor starts polling the partition as soon as it is added */
+	apart->pdevfreq = pdevfreq;
+	pdevfreq->devfreq = devfreq_add_device(&apart->dev, &pdevfreq->profile,
+					       DEVFREQ_GOV_SIMPLE_ONDEMAND,
+					       NULL);
+	if (IS_ERR(pdevfreq->devfreq)) {
+		ret = PTR_ERR(pdevfreq->devfreq);
+		apart->pdevfreq = NULL;
+		kfree(pdevfreq);
+		return ret;
+	}
+
+	return 0;
+}
+
+/**
+ * aie_part_devfreq_exit() - remove the devfreq device of a partition
+ * @apart: AI engine partition
+ *
+ * It must be called without the partition lock, the utilisation sampling of
+ * the governor takes it.
+ */
+void aie_part_devfreq_exit(struct aie_partition *apart)
+{
+	struct aie_part_devfreq *pdevfreq = apart->pdevfreq;
+
+	if (!pdevfreq)
+		return;
+
+	devfreq_remove_device(pdevfreq->devfreq);
+	apart->pdevfreq = NULL;
+	kfree(pdevfreq);
+}
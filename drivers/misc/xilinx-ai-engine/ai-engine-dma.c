@@ -9,6 +9,7 @@
 #include <linux/dma-buf.h>
 #include <linux/kernel.h>
 #include <linux/mm.h>
+#include <linux/overflow.h>
 #include <linux/refcount.h>
 #include <linux/slab.h>
 #include <linux/types.h>
@@ -28,6 +29,21 @@ struct aie_dmabuf {
 	struct list_head node;
 };
 
+/**
+ * struct aie_dmabuf_bd - SHIM DMA buffer descriptor set from a dmabuf
+ * @adbuf: dmabuf the buffer descriptor points to, NULL if it is not set
+ * @bd: buffer descriptor content as last written to the hardware
+ *
+ * Buffer descriptors set from a dmabuf are kept per SHIM DMA BD slot, so that
+ * applications running the same graph iteration after iteration can re-arm
+ * them with a new address and length only, instead of copying and validating
+ * the whole buffer descriptor again.
+ */
+struct aie_dmabuf_bd {
+	struct aie_dmabuf *adbuf;
+	u32 *bd;
+};
+
 /**
  * aie_part_find_dmabuf() - find a attached dmabuf
  * @apart: AI engine partition
@@ -136,6 +152,7 @@ static dma_addr_t aie_part_get_dmabuf_da(struct aie_partition *apart,
  * @dmabuf_fd: dmabuf file descriptor
  * @off: offset to the start of a dmabuf
  * @len: memory length
+ * @adbufp: if not NULL, returns the AI engine dmabuf of @dmabuf_fd
  * @return: dma address, or 0 if @off or @len is invalid, or if @dmabuf_fd is
  *	    not attached.
  *
@@ -144,7 +161,7 @@ static dma_addr_t aie_part_get_dmabuf_da(struct aie_partition *apart,
  */
 static dma_addr_t
 aie_part_get_dmabuf_da_from_off(struct aie_partition *apart, int dmabuf_fd,
-				u64 off, size_t len)
+				u64 off, size_t len, struct aie_dmabuf **adbufp)
 {
 	struct dma_buf *dbuf = dma_buf_get(dmabuf_fd);
 	struct aie_dmabuf *adbuf;
@@ -172,9 +189,34 @@ aie_part_get_dmabuf_da_from_off(struct aie_partition *apart, int dmabuf_fd,
 		return 0;
 	}
 
+	if (adbufp)
+		*adbufp = adbuf;
+
 	return sg_dma_address(adbuf->sgt->sgl) + off;
 }
 
+/**
+ * aie_part_shimdma_bd_regoff() - get the register offset of a SHIM DMA buffer
+ *				  descriptor
+ * @apart: AI engine partition
+ * @loc: AI engine tile location relative in partition
+ * @bd_id: buffer descriptor ID
+ * @return: register offset of the first word of the buffer descriptor
+ */
+static u32 aie_part_shimdma_bd_regoff(struct aie_partition *apart,
+				      struct aie_location loc, u32 bd_id)
+{
+	const struct aie_dma_attr *shim_dma = apart->adev->shim_dma;
+	struct aie_location loc_adjust;
+
+	loc_adjust.col = loc.col + apart->range.start.col;
+	loc_adjust.row = loc.row + apart->range.start.row;
+
+	return aie_aperture_cal_regoff(apart->aperture, loc_adjust,
+				       shim_dma->bd_regoff +
+				       shim_dma->bd_len * bd_id);
+}
+
 /**
  * aie_part_set_shimdma_bd() - Set the buffer descriptor to AI engine partition
  *			       hardware
@@ -192,20 +234,79 @@ static int aie_part_set_shimdma_bd(struct aie_partition *apart,
 {
 	struct aie_aperture *aperture = apart->aperture;
 	const struct aie_dma_attr *shim_dma = apart->adev->shim_dma;
-	struct aie_location loc_adjust;
-	u32 i, regoff, intile_regoff;
-
-	intile_regoff = shim_dma->bd_regoff + shim_dma->bd_len * bd_id;
-	loc_adjust.col = loc.col + apart->range.start.col;
-	loc_adjust.row = loc.row + apart->range.start.row;
-	regoff = aie_aperture_cal_regoff(aperture, loc_adjust, intile_regoff);
+	u32 i, regoff;
 
+	regoff = aie_part_shimdma_bd_regoff(apart, loc, bd_id);
 	for (i = 0; i < shim_dma->bd_len / (sizeof(*bd));
 	     i++, regoff += sizeof(*bd))
 		iowrite32(bd[i], aperture->base + regoff);
 	return 0;
 }
 
+/**
+ * aie_part_get_dmabuf_bd() - get the dmabuf record of a SHIM DMA buffer
+ *			      descriptor
+ * @apart: AI engine partition
+ * @loc: AI engine tile location relative in partition, it has to be validated
+ *	 with aie_part_validate_bdloc()
+ * @bd_id: buffer descriptor ID
+ * @return: pointer to the dmabuf buffer descriptor record
+ */
+static struct aie_dmabuf_bd *
+aie_part_get_dmabuf_bd(struct aie_partition *apart, struct aie_location loc,
+		       u32 bd_id)
+{
+	/* There is only one row of SHIM NOC tiles, index with column only */
+	return &apart->dbuf_bds[loc.col * apart->adev->shim_dma->num_bds +
+				bd_id];
+}
+
+/**
+ * aie_part_release_dmabuf_bds() - forget the buffer descriptors of a dmabuf
+ * @apart: AI engine partition
+ * @adbuf: AI engine dmabuf, NULL for all the dmabufs
+ *
+ * This function needs to be called before @adbuf is freed, the buffer
+ * descriptors pointing to it cannot be re-armed anymore.
+ */
+void aie_part_release_dmabuf_bds(struct aie_partition *apart,
+				 struct aie_dmabuf *adbuf)
+{
+	u32 i, num_bds;
+
+	if (!apart->dbuf_bds)
+		return;
+
+	num_bds = apart->range.size.col * apart->adev->shim_dma->num_bds;
+	for (i = 0; i < num_bds; i++) {
+		if (!adbuf || apart->dbuf_bds[i].adbuf == adbuf)
+			apart->dbuf_bds[i].adbuf = NULL;
+	}
+}
+
+/**
+ * aie_part_patch_shimdma_bd_addr() - set the address of a SHIM DMA buffer
+ *				      descriptor
+ * @shim_dma: SHIM DMA attributes
+ * @bd: buffer descriptor content
+ * @addr: DMA address to set
+ */
+static void aie_part_patch_shimdma_bd_addr(const struct aie_dma_attr *shim_dma,
+					   u32 *bd, dma_addr_t addr)
+{
+	u32 *tmpbd;
+
+	/* Set low 32bit address */
+	tmpbd = (u32 *)((char *)bd + shim_dma->laddr.regoff);
+	*tmpbd &= ~shim_dma->laddr.mask;
+	*tmpbd |= aie_get_field_val(&shim_dma->laddr, lower_32_bits(addr));
+
+	/* Set high 32bit address */
+	tmpbd = (u32 *)((char *)bd + shim_dma->haddr.regoff);
+	*tmpbd &= ~shim_dma->haddr.mask;
+	*tmpbd |= aie_get_field_val(&shim_dma->haddr, upper_32_bits(addr));
+}
+
 /**
  * aie_part_validate_bdloc() - Validate SHIM DMA buffer descriptor location
  * @apart: AI engine partition
@@ -346,6 +447,7 @@ static void aie_part_dmabuf_attach_put(struct aie_dmabuf *adbuf)
 		return;
 
 	apart = dev_to_aiepart(adbuf->attach->dev);
+	aie_part_release_dmabuf_bds(apart, adbuf);
 	dbuf = adbuf->attach->dmabuf;
 	dma_buf_unmap_attachment(adbuf->attach, adbuf->sgt, adbuf->attach->dir);
 	dma_buf_detach(dbuf, adbuf->attach);
@@ -362,6 +464,7 @@ void aie_part_release_dmabufs(struct aie_partition *apart)
 {
 	struct aie_dmabuf *adbuf, *tmpadbuf;
 
+	aie_part_release_dmabuf_bds(apart, NULL);
 	list_for_each_entry_safe(adbuf, tmpadbuf, &apart->dbufs, node) {
 		struct dma_buf *dbuf = adbuf->attach->dmabuf;
 
@@ -488,7 +591,7 @@ long aie_part_set_bd(struct aie_partition *apart, struct aie_dma_bd_args *args)
 {
 	struct aie_device *adev = apart->adev;
 	const struct aie_dma_attr *shim_dma = adev->shim_dma;
-	u32 *bd, *tmpbd, buf_len, laddr, haddr, regval;
+	u32 *bd, buf_len, regval;
 	dma_addr_t addr;
 	int ret;
 
@@ -520,22 +623,15 @@ long aie_part_set_bd(struct aie_partition *apart, struct aie_dma_bd_args *args)
 		return -EINVAL;
 	}
 
-	/* Set low 32bit address */
-	laddr = lower_32_bits(addr);
-	tmpbd = (u32 *)((char *)bd + shim_dma->laddr.regoff);
-	*tmpbd &= ~shim_dma->laddr.mask;
-	*tmpbd |= aie_get_field_val(&shim_dma->laddr, laddr);
-
-	/* Set high 32bit address */
-	haddr = upper_32_bits(addr);
-	tmpbd = (u32 *)((char *)bd + shim_dma->haddr.regoff);
-	*tmpbd &= ~shim_dma->haddr.mask;
-	*tmpbd |= aie_get_field_val(&shim_dma->haddr, haddr);
+	aie_part_patch_shimdma_bd_addr(shim_dma, bd, addr);
 
 	ret = aie_part_set_shimdma_bd(apart, args->loc, args->bd_id, bd);
 	if (ret)
 		dev_err(&apart->dev, "failed to set to shim dma bd.\n");
 
+	/* The slot doesn't point to a dmabuf anymore */
+	aie_part_get_dmabuf_bd(apart, args->loc, args->bd_id)->adbuf = NULL;
+
 	kfree(bd);
 	return ret;
 }
@@ -584,6 +680,8 @@ long aie_part_set_dmabuf_bd(struct aie_partition *apart,
 {
 	struct aie_device *adev = apart->adev;
 	const struct aie_dma_attr *shim_dma = adev->shim_dma;
+	struct aie_dmabuf_bd *dbd;
+	struct aie_dmabuf *adbuf;
 	u32 *bd, *tmpbd, len, laddr, haddr, regval;
 	u64 off;
 	dma_addr_t addr;
@@ -616,7 +714,8 @@ long aie_part_set_dmabuf_bd(struct aie_partition *apart,
 	off = laddr | ((u64)haddr << 32);
 
 	/* Get device address from offset */
-	addr = aie_part_get_dmabuf_da_from_off(apart, args->buf_fd, off, len);
+	addr = aie_part_get_dmabuf_da_from_off(apart, args->buf_fd, off, len,
+					       &adbuf);
 	if (!addr) {
 		dev_err(&apart->dev, "invalid buffer 0x%llx, 0x%x.\n",
 			off, len);
@@ -624,24 +723,22 @@ long aie_part_set_dmabuf_bd(struct aie_partition *apart,
 		return -EINVAL;
 	}
 
-	/* Set low 32bit address */
-	laddr = lower_32_bits(addr);
-	tmpbd = (u32 *)((char *)bd + shim_dma->laddr.regoff);
-	*tmpbd &= ~shim_dma->laddr.mask;
-	*tmpbd |= aie_get_field_val(&shim_dma->laddr, laddr);
-
-	/* Set high 32bit address */
-	haddr = upper_32_bits(addr);
-	tmpbd = (u32 *)((char *)bd + shim_dma->haddr.regoff);
-	*tmpbd &= ~shim_dma->haddr.mask;
-	*tmpbd |= aie_get_field_val(&shim_dma->haddr, haddr);
+	aie_part_patch_shimdma_bd_addr(shim_dma, bd, addr);
 
 	ret = aie_part_set_shimdma_bd(apart, args->loc, args->bd_id, bd);
-	if (ret)
+	if (ret) {
 		dev_err(&apart->dev, "failed to set to shim dma bd.\n");
+		kfree(bd);
+		return ret;
+	}
+
+	/* Keep the buffer descriptor so that it can be re-armed later */
+	dbd = aie_part_get_dmabuf_bd(apart, args->loc, args->bd_id);
+	memcpy(dbd->bd, bd, shim_dma->bd_len);
+	dbd->adbuf = adbuf;
 
 	kfree(bd);
-	return ret;
+	return 0;
 }
 
 /**
@@ -674,6 +771,289 @@ long aie_part_set_dmabuf_bd_from_user(struct aie_partition *apart,
 	return ret;
 }
 
+/**
+ * aie_dma_nd_footprint() - validate a generic buffer descriptor access
+ *			    pattern and get its footprint
+ * @args: generic buffer descriptor, a linear transfer is turned into a one
+ *	  dimension pattern and the outermost wrap is derived from the length
+ * @return: number of bytes spanned by the pattern, 0 if it is invalid
+ */
+static u64 aie_dma_nd_footprint(struct aie_dma_nd_bd_args *args)
+{
+	u64 words = args->len / sizeof(u32), inner = 1, span = 1, reach;
+	u32 i;
+
+	if (!words || args->len % sizeof(u32) ||
+	    args->num_dims > AIE_DMA_MAX_DIMS)
+		return 0;
+
+	if (!args->num_dims) {
+		args->num_dims = 1;
+		args->dims[0].stepsize = 1;
+		args->dims[0].wrap = 0;
+	}
+
+	for (i = 0; i < args->num_dims; i++) {
+		struct aie_dma_dim *dim = &args->dims[i];
+
+		if (!dim->stepsize)
+			return 0;
+
+		if (i == args->num_dims - 1) {
+			/* The outermost dimension runs to the end of the length */
+			if (words % inner ||
+			    (dim->wrap && dim->wrap != words / inner))
+				return 0;
+			dim->wrap = words / inner;
+		} else if (!dim->wrap || dim->wrap > words / inner) {
+			return 0;
+		}
+
+		inner *= dim->wrap;
+		reach = (u64)(dim->wrap - 1) * dim->stepsize;
+		if (check_add_overflow(span, reach, &span))
+			return 0;
+	}
+
+	if (args->iter_wrap) {
+		reach = (u64)(args->iter_wrap - 1) * args->iter_stepsize;
+		if (check_add_overflow(span, reach, &span))
+			return 0;
+	}
+
+	if (span > U64_MAX / sizeof(u32))
+		return 0;
+
+	return span * sizeof(u32);
+}
+
+/**
+ * aie_part_set_nd_bd() - Set AI engine generic N-dimensional buffer
+ *			  descriptor
+ * @apart: AI engine partition
+ * @args: generic buffer descriptor
+ *
+ * @return: 0 for success, negative value for failure
+ *
+ * This function validates the access pattern, encodes it in the buffer
+ * descriptor format of the device generation and sets it to the SHIM NOC or
+ * memory tile DMA. For SHIM NOC tiles, every address the pattern reaches is
+ * checked to be within the dmabuf.
+ */
+static long aie_part_set_nd_bd(struct aie_partition *apart,
+			       struct aie_dma_nd_bd_args *args)
+{
+	struct aie_device *adev = apart->adev;
+	const struct aie_dma_attr *attr;
+	struct aie_location loc;
+	u32 *bd, ttype, i, regoff;
+	u64 footprint, addr;
+	int ret;
+
+	if (!adev->ops->encode_nd_bd)
+		return -EOPNOTSUPP;
+
+	if (aie_validate_location(apart, args->loc) < 0) {
+		dev_err(&apart->dev, "invalid loc (%u,%u) in (%u,%u).\n",
+			args->loc.col, args->loc.row,
+			apart->range.size.col, apart->range.size.row);
+		return -EINVAL;
+	}
+
+	loc.col = args->loc.col + apart->range.start.col;
+	loc.row = args->loc.row + apart->range.start.row;
+	ttype = adev->ops->get_tile_type(adev, &loc);
+	if (ttype == AIE_TILE_TYPE_SHIMNOC) {
+		attr = adev->shim_dma;
+	} else if (ttype == AIE_TILE_TYPE_MEMORY) {
+		attr = adev->memtile_dma;
+	} else {
+		dev_err(&apart->dev,
+			"failed to set bd, (%u,%u) is not SHIM NOC or memory tile.\n",
+			args->loc.col, args->loc.row);
+		return -EINVAL;
+	}
+
+	if (args->bd_id >= attr->num_bds ||
+	    (args->flags & AIE_DMA_BD_USE_NEXT &&
+	     args->next_bd >= attr->num_bds)) {
+		dev_err(&apart->dev, "invalid DMA bd id: %u, next %u.\n",
+			args->bd_id, args->next_bd);
+		return -EINVAL;
+	}
+
+	footprint = aie_dma_nd_footprint(args);
+	if (!footprint) {
+		dev_err(&apart->dev, "invalid DMA access pattern.\n");
+		return -EINVAL;
+	}
+
+	if (ttype == AIE_TILE_TYPE_SHIMNOC) {
+		addr = aie_part_get_dmabuf_da_from_off(apart, args->buf_fd,
+						       args->addr, footprint,
+						       NULL);
+		if (!addr)
+			return -EINVAL;
+	} else {
+		addr = args->addr;
+	}
+
+	bd = kzalloc(attr->bd_len, GFP_KERNEL);
+	if (!bd)
+		return -ENOMEM;
+
+	ret = adev->ops->encode_nd_bd(apart, &loc, args, addr, bd);
+	if (ret) {
+		dev_err(&apart->dev,
+			"DMA access pattern not supported by (%u,%u).\n",
+			args->loc.col, args->loc.row);
+		goto out;
+	}
+
+	regoff = aie_aperture_cal_regoff(apart->aperture, loc,
+					 attr->bd_regoff +
+					 attr->bd_len * args->bd_id);
+	for (i = 0; i < attr->bd_len / sizeof(*bd); i++, regoff += sizeof(*bd))
+		iowrite32(bd[i], apart->aperture->base + regoff);
+
+	/* Re-arming would only update the address and length of the pattern */
+	if (ttype == AIE_TILE_TYPE_SHIMNOC)
+		aie_part_get_dmabuf_bd(apart, args->loc, args->bd_id)->adbuf =
+			NULL;
+
+out:
+	kfree(bd);
+	return ret;
+}
+
+/**
+ * aie_part_set_nd_bd_from_user() - Set AI engine generic N-dimensional
+ *				    buffer descriptor from user
+ * @apart: AI engine partition
+ * @user_args: user generic buffer descriptor
+ *
+ * @return: 0 for success, negative value for failure
+ */
+long aie_part_set_nd_bd_from_user(struct aie_partition *apart,
+				  void __user *user_args)
+{
+	struct aie_dma_nd_bd_args args;
+	int ret;
+
+	if (copy_from_user(&args, user_args, sizeof(args)))
+		return -EFAULT;
+
+	ret = mutex_lock_interruptible(&apart->mlock);
+	if (ret)
+		return ret;
+
+	ret = aie_part_set_nd_bd(apart, &args);
+
+	mutex_unlock(&apart->mlock);
+	return ret;
+}
+
+/**
+ * aie_part_rearm_dmabuf_bd() - Re-arm AI engine SHIM DMA dmabuf buffer
+ *				descriptor
+ * @apart: AI engine partition
+ * @args: user AI engine dmabuf buffer descriptor re-arm argument
+ *
+ * @return: 0 for success, negative value for failure
+ *
+ * This function updates the address and the length of a buffer descriptor
+ * previously set with aie_part_set_dmabuf_bd(). The rest of the buffer
+ * descriptor was validated when it was set, only the words holding the
+ * address and the length are written to the hardware.
+ */
+long aie_part_rearm_dmabuf_bd(struct aie_partition *apart,
+			      struct aie_dmabuf_bd_rearm_args *args)
+{
+	const struct aie_dma_attr *shim_dma = apart->adev->shim_dma;
+	struct aie_aperture *aperture = apart->aperture;
+	struct aie_dmabuf_bd *dbd;
+	u32 *tmpbd, regoff;
+	size_t size;
+	int ret;
+
+	ret = aie_part_validate_bdloc(apart, args->loc, args->bd_id);
+	if (ret) {
+		dev_err(&apart->dev, "invalid SHIM DMA BD reg address.\n");
+		return -EINVAL;
+	}
+
+	dbd = aie_part_get_dmabuf_bd(apart, args->loc, args->bd_id);
+	if (!dbd->adbuf) {
+		dev_err(&apart->dev,
+			"SHIM DMA bd %u of (%u,%u) is not set from a dmabuf.\n",
+			args->bd_id, args->loc.col, args->loc.row);
+		return -EINVAL;
+	}
+
+	if (!args->len ||
+	    aie_get_reg_field(&shim_dma->buflen,
+			      aie_get_field_val(&shim_dma->buflen,
+						args->len)) != args->len) {
+		dev_err(&apart->dev, "invalid buf length 0x%x.\n", args->len);
+		return -EINVAL;
+	}
+
+	size = dbd->adbuf->attach->dmabuf->size;
+	if (args->off >= size || args->off + args->len >= size) {
+		dev_err(&apart->dev,
+			"invalid buffer 0x%llx, 0x%x.\n", args->off, args->len);
+		return -EINVAL;
+	}
+
+	tmpbd = (u32 *)((char *)dbd->bd + shim_dma->buflen.regoff);
+	*tmpbd &= ~shim_dma->buflen.mask;
+	*tmpbd |= aie_get_field_val(&shim_dma->buflen, args->len);
+
+	aie_part_patch_shimdma_bd_addr(shim_dma, dbd->bd,
+				       sg_dma_address(dbd->adbuf->sgt->sgl) +
+				       args->off);
+
+	regoff = aie_part_shimdma_bd_regoff(apart, args->loc, args->bd_id);
+	iowrite32(dbd->bd[shim_dma->laddr.regoff / sizeof(u32)],
+		  aperture->base + regoff + shim_dma->laddr.regoff);
+	if (shim_dma->haddr.regoff != shim_dma->laddr.regoff)
+		iowrite32(dbd->bd[shim_dma->haddr.regoff / sizeof(u32)],
+			  aperture->base + regoff + shim_dma->haddr.regoff);
+	if (shim_dma->buflen.regoff != shim_dma->laddr.regoff &&
+	    shim_dma->buflen.regoff != shim_dma->haddr.regoff)
+		iowrite32(dbd->bd[shim_dma->buflen.regoff / sizeof(u32)],
+			  aperture->base + regoff + shim_dma->buflen.regoff);
+
+	return 0;
+}
+
+/**
+ * aie_part_rearm_dmabuf_bd_from_user() - Re-arm AI engine SHIM DMA dmabuf
+ *					  buffer descriptor
+ * @apart: AI engine partition
+ * @user_args: user AI engine dmabuf buffer descriptor re-arm argument
+ *
+ * @return: 0 for success, negative value for failure
+ */
+long aie_part_rearm_dmabuf_bd_from_user(struct aie_partition *apart,
+					void __user *user_args)
+{
+	struct aie_dmabuf_bd_rearm_args args;
+	int ret;
+
+	if (copy_from_user(&args, user_args, sizeof(args)))
+		return -EFAULT;
+
+	ret = mutex_lock_interruptible(&apart->mlock);
+	if (ret)
+		return ret;
+
+	ret = aie_part_rearm_dmabuf_bd(apart, &args);
+
+	mutex_unlock(&apart->mlock);
+	return ret;
+}
+
 /**
  * aie_part_prealloc_dbufs_cache() - Preallocate dmabuf descriptors memory
  *
@@ -683,13 +1063,26 @@ long aie_part_set_dmabuf_bd_from_user(struct aie_partition *apart,
  *
  * This function preallocate memories to save dmabuf descriptors. When dmabuf
  * is attached to the partition at runtime, it can get the descriptor memory
- * from this preallocated memory pool.
+ * from this preallocated memory pool. It also allocates the records of the
+ * SHIM DMA buffer descriptors set from dmabufs.
  */
 int aie_part_prealloc_dbufs_cache(struct aie_partition *apart)
 {
+	const struct aie_dma_attr *shim_dma = apart->adev->shim_dma;
 	struct kmem_cache *dbufs_cache;
+	u32 i, num_bds, *bds;
 	char name[64];
 
+	num_bds = apart->range.size.col * shim_dma->num_bds;
+	apart->dbuf_bds = devm_kcalloc(&apart->dev, num_bds,
+				       sizeof(*apart->dbuf_bds), GFP_KERNEL);
+	bds = devm_kcalloc(&apart->dev, num_bds, shim_dma->bd_len, GFP_KERNEL);
+	if (!apart->dbuf_bds || !bds)
+		return -ENOMEM;
+
+	for (i = 0; i < num_bds; i++)
+		apart->dbuf_bds[i].bd = bds + i * shim_dma->bd_len / sizeof(u32);
+
 	sprintf(name, "%s_dbufs", dev_name(&apart->dev));
 	dbufs_cache = kmem_cache_create(name, sizeof(struct aie_dmabuf),
 					0, 0, NULL);
@@ -254,6 +254,9 @@ struct aie_single_reg_field {
 
 struct aie_device;
 struct aie_partition;
+struct aie_dmabuf;
+struct aie_dmabuf_bd;
+struct aie_part_devfreq;
 
 /**
  * struct aie_part_mem - AI engine partition memory information structure
@@ -288,7 +291,7 @@ struct aie_part_mem {
  * @curbd: current buffer descriptor field attributes
  * @qsts: queue status field attributes
  * @fifo_cnt: FIFO counter field attributes
- * @bd_regoff: SHIM DMA buffer descriptors register offset
+ * @bd_regoff: buffer descriptors register offset
  * @mm2s_sts_regoff: MM2S status register offset
  * @s2mm_sts_regoff: S2MM status register offset
  * @fifo_cnt_regoff: FIFO counter register offset
@@ -296,6 +299,10 @@ struct aie_part_mem {
  * @num_s2mm_chan: number of S2MM channels
  * @num_bds: number of buffer descriptors
  * @bd_len: length of a buffer descriptor in bytes
+ * @bd_done_event: event ID of the S2MM channel 0 finished buffer descriptor
+ *		   event, the events of the other S2MM channels and then of
+ *		   the MM2S channels follow. 0 if the events are not
+ *		   supported.
  */
 struct aie_dma_attr {
 	struct aie_single_reg_field laddr;
@@ -316,6 +323,7 @@ struct aie_dma_attr {
 	u32 num_s2mm_chan;
 	u32 num_bds;
 	u32 bd_len;
+	u32 bd_done_event;
 };
 
 /**
@@ -360,6 +368,14 @@ struct aie_aperture;
  * @get_dma_mm2s_status: get dma mm2s status
  * @get_chan_status: get dma channel status
  * @get_lock_status: get tile, shimdma and memtile lock status
+ * @lock_request: acquire or release a lock with a value, returns 1 if the
+ *		  request is granted, 0 if it isn't, negative value for an
+ *		  invalid lock or value
+ * @encode_nd_bd: encode a generic buffer descriptor, whose outermost wrap
+ *		  has been derived from its length, in the SHIM NOC or memory
+ *		  tile buffer descriptor format. Returns -EINVAL if the
+ *		  descriptor doesn't fit the format.
+ * @dma_active: return whether a DMA channel of an ungated tile isn't idle
  *
  * Different AI engine device version has its own device
  * operation.
@@ -401,6 +417,15 @@ struct aie_tile_operations {
 	u32 (*get_lock_status)(struct aie_partition *apart,
 			       struct aie_location *loc,
 			       u8 lock);
+	int (*lock_request)(struct aie_partition *apart,
+			    struct aie_location *loc, u32 lock, s32 val,
+			    bool acquire);
+	int (*encode_nd_bd)(struct aie_partition *apart,
+			    struct aie_location *loc,
+			    const struct aie_dma_nd_bd_args *args, u64 addr,
+			    u32 *bd);
+	bool (*dma_active)(struct aie_partition *apart,
+			   struct aie_location *loc);
 };
 
 /**
@@ -447,6 +472,10 @@ struct aie_event_attr {
  * @swb_status: switch A level 1 interrupt controller status attribute.
  * @swa_event: switch A level 1 interrupt controller event attribute.
  * @swb_event: switch A level 1 interrupt controller event attribute.
+ * @swa_enable: switch A level 1 interrupt controller enable attribute.
+ * @swb_enable: switch B level 1 interrupt controller enable attribute.
+ * @swa_disable: switch A level 1 interrupt controller disable attribute.
+ * @swb_disable: switch B level 1 interrupt controller disable attribute.
  * @regoff: base level 1 interrupt controller register offset.
  * @event_lsb: lsb of IRQ event within IRQ event switch register.
  * @num_broadcasts: total number of broadcast signals to level 1 interrupt
@@ -457,6 +486,10 @@ struct aie_l1_intr_ctrl_attr {
 	struct aie_single_reg_field swb_status;
 	struct aie_single_reg_field swa_event;
 	struct aie_single_reg_field swb_event;
+	struct aie_single_reg_field swa_enable;
+	struct aie_single_reg_field swb_enable;
+	struct aie_single_reg_field swa_disable;
+	struct aie_single_reg_field swb_disable;
 	u32 regoff;
 	u32 event_lsb;
 	u32 num_broadcasts;
@@ -492,6 +525,24 @@ struct aie_error_cb {
 	void *priv;
 };
 
+/**
+ * struct aie_dma_notify - AI engine SHIM DMA channel completion notification
+ * @node: list node
+ * @trigger: eventfd to signal when the channel finishes a buffer descriptor
+ * @loc: absolute location of the SHIM NOC tile
+ * @sw: level 1 interrupt controller switch the event is routed to
+ * @irq_id: level 1 interrupt controller IRQ ID the event is routed to
+ * @event: finished buffer descriptor event of the channel
+ */
+struct aie_dma_notify {
+	struct list_head node;
+	struct eventfd_ctx *trigger;
+	struct aie_location loc;
+	enum aie_shim_switch_type sw;
+	u8 irq_id;
+	u8 event;
+};
+
 /**
  * struct aie_event_prop - AI engine event property.
  * @event: error event ID.
@@ -852,17 +903,25 @@ struct aie_aperture {
  * struct aie_partition - AI engine partition structure
  * @node: list node
  * @dbufs: dmabufs list
+ * @dma_notifiers: SHIM DMA channel completion notifications list
  * @aperture: pointer to AI engine aperture
  * @adev: pointer to AI device instance
  * @filep: pointer to file for refcount on the users of the partition
  * @pmems: pointer to partition memories types
  * @dbufs_cache: memory management object for preallocated dmabuf descriptors
+ * @dbuf_bds: SHIM DMA buffer descriptors set from dmabufs, indexed by column
+ *	      and buffer descriptor ID
  * @trscs: resources bitmaps for each tile
  * @freq_req: required frequency
  * @range: range of partition
  * @mlock: protection for AI engine partition operations
  * @dev: device for the AI engine partition
  * @atiles: pointer to an array of AIE tile structure.
+ * @autogate_work: work checking the columns activity for automatic gating
+ * @autogate_idle: number of consecutive idle checks of each column
+ * @autogate_period: period of the columns activity check in jiffies
+ * @autogate_idle_periods: number of idle checks before a column is gated
+ * @pdevfreq: devfreq scaling the partition frequency with its utilisation
  * @cores_clk_state: bitmap to indicate the power state of core modules
  * @tiles_inuse: bitmap to indicate if a tile is in use
  * @error_cb: error callback
@@ -883,17 +942,24 @@ struct aie_aperture {
 struct aie_partition {
 	struct list_head node;
 	struct list_head dbufs;
+	struct list_head dma_notifiers;
 	struct aie_aperture *aperture;
 	struct aie_device *adev;
 	struct file *filep;
 	struct aie_part_mem *pmems;
 	struct kmem_cache *dbufs_cache;
+	struct aie_dmabuf_bd *dbuf_bds;
 	struct aie_tile_rscs trscs[AIE_TILE_TYPE_MAX];
 	u64 freq_req;
 	struct aie_range range;
 	struct mutex mlock; /* protection for AI engine partition operations */
 	struct device dev;
 	struct aie_tile *atiles;
+	struct delayed_work autogate_work;
+	u32 *autogate_idle;
+	unsigned long autogate_period;
+	u32 autogate_idle_periods;
+	struct aie_part_devfreq *pdevfreq;
 	struct aie_resource cores_clk_state;
 	struct aie_resource tiles_inuse;
 	struct aie_error_cb error_cb;
@@ -1107,17 +1173,23 @@ int xilinx_ai_engine_probe_v1(struct platform_device *pdev);
 
 void aie_part_remove(struct aie_partition *apart);
 int aie_part_clear_context(struct aie_partition *apart);
+int aie_part_fast_clean(struct aie_partition *apart);
 int aie_part_clean(struct aie_partition *apart);
 int aie_part_open(struct aie_partition *apart, void *rsc_metadata);
 int aie_part_initialize(struct aie_partition *apart, void __user *user_args);
 int aie_part_teardown(struct aie_partition *apart);
 
 int aie_mem_get_info(struct aie_partition *apart, unsigned long arg);
+int aie_mem_load_from_user(struct aie_partition *apart, void __user *user_args);
+int aie_part_reg_validation(struct aie_partition *apart, size_t offset,
+			    size_t len, u8 is_write);
 
 long aie_part_attach_dmabuf_req(struct aie_partition *apart,
 				void __user *user_args);
 long aie_part_detach_dmabuf_req(struct aie_partition *apart,
 				void __user *user_args);
+long aie_part_set_nd_bd_from_user(struct aie_partition *apart,
+				  void __user *user_args);
 long aie_part_set_bd_from_user(struct aie_partition *apart,
 					void __user *user_args);
 long aie_part_set_bd(struct aie_partition *apart,
@@ -1126,12 +1198,20 @@ long aie_part_set_dmabuf_bd_from_user(struct aie_partition *apart,
 			    void __user *user_args);
 long aie_part_set_dmabuf_bd(struct aie_partition *apart,
 					struct aie_dmabuf_bd_args *args);
+long aie_part_rearm_dmabuf_bd_from_user(struct aie_partition *apart,
+					void __user *user_args);
+long aie_part_rearm_dmabuf_bd(struct aie_partition *apart,
+			      struct aie_dmabuf_bd_rearm_args *args);
 void aie_part_release_dmabufs(struct aie_partition *apart);
+void aie_part_release_dmabuf_bds(struct aie_partition *apart,
+				 struct aie_dmabuf *adbuf);
 int aie_part_prealloc_dbufs_cache(struct aie_partition *apart);
 
 int aie_part_scan_clk_state(struct aie_partition *apart);
 bool aie_part_check_clk_enable_loc(struct aie_partition *apart,
 				   struct aie_location *loc);
+bool aie_part_check_tile_inuse_loc(struct aie_partition *apart,
+				   struct aie_location *loc);
 int aie_part_set_freq(struct aie_partition *apart, u64 freq);
 int aie_part_get_freq(struct aie_partition *apart, u64 *freq);
 
@@ -1165,6 +1245,16 @@ int aie_aperture_create_l2_mask(struct aie_aperture *aperture);
 bool aie_part_has_error(struct aie_partition *apart);
 void aie_part_clear_cached_events(struct aie_partition *apart);
 int aie_part_set_intr_rscs(struct aie_partition *apart);
+long aie_part_set_dma_notify_from_user(struct aie_partition *apart,
+				       void __user *user_args);
+void aie_part_release_dma_notifiers(struct aie_partition *apart);
+
+long aie_part_perf_sampler_from_user(struct aie_partition *apart,
+				     void __user *user_args);
+
+long aie_part_lock_from_user(struct aie_partition *apart,
+			     void __user *user_args, bool acquire,
+			     bool nonblock);
 
 struct aie_aperture *
 of_aie_aperture_probe(struct aie_device *adev, struct device_node *nc);
@@ -1201,6 +1291,8 @@ int aie_part_rscmgr_set_static(struct aie_partition *apart, void *meta);
 int aie_part_rscmgr_set_tile_broadcast(struct aie_partition *apart,
 				       struct aie_location loc,
 				       enum aie_module_type mod, uint32_t id);
+bool aie_part_rscmgr_tile_in_use(struct aie_partition *apart,
+				 struct aie_location loc);
 
 int aie_aperture_sysfs_create_entries(struct aie_aperture *aperture);
 void aie_aperture_sysfs_remove_entries(struct aie_aperture *aperture);
@@ -1264,6 +1356,23 @@ long aie_part_rscmgr_get_statistics(struct aie_partition *apart,
 				    void __user *user_args);
 int  aie_part_set_column_clock_from_user(struct aie_partition *apart,
 					 void __user *user_args);
+void aie_part_autogate_work(struct work_struct *work);
+int aie_part_set_auto_gate_from_user(struct aie_partition *apart,
+				     void __user *user_args);
+
+#if IS_ENABLED(CONFIG_XILINX_AIE_DEVFREQ)
+int aie_part_devfreq_init(struct aie_partition *apart);
+void aie_part_devfreq_exit(struct aie_partition *apart);
+#else
+static inline int aie_part_devfreq_init(struct aie_partition *apart)
+{
+	return 0;
+}
+
+static inline void aie_part_devfreq_exit(struct aie_partition *apart)
+{
+}
+#endif
 
 int aie_overlay_register_notifier(void);
 void aie_overlay_unregister_notifier(void);
@@ -5,10 +5,12 @@
  * Copyright (C) 2020 Xilinx, Inc.
  */
 #include <linux/bitmap.h>
+#include <linux/eventfd.h>
 #include <linux/firmware/xlnx-zynqmp.h>
 #include <linux/interrupt.h>
 #include <linux/io.h>
 #include <linux/slab.h>
+#include <linux/uaccess.h>
 #include <linux/workqueue.h>
 
 #include "ai-engine-internal.h"
@@ -16,6 +18,8 @@
 
 #define AIE_ARRAY_TILE_ERROR_BC_ID		0U
 #define AIE_SHIM_TILE_ERROR_IRQ_ID		16U
+#define AIE_SHIM_DMA_NOTIFY_IRQ_ID_START	17U
+#define AIE_SHIM_DMA_NOTIFY_IRQ_ID_END		19U
 #define AIE_SHIM_INTR_BC_MAX			5U
 #define AIE_L2_MASK_REG_BITS			32U
 
@@ -565,6 +569,33 @@ static void aie_map_l2_to_l1(struct aie_partition *apart, u32 set_pos,
 	}
 }
 
+/**
+ * aie_part_dma_notify() - signal SHIM DMA channel completions
+ * @apart: AIE partition pointer.
+ * @loc: pointer to level 1 interrupt controller tile location.
+ * @sw: switch type.
+ * @status: level 1 interrupt controller status value.
+ *
+ * This function clears the level 1 interrupts of the DMA finished buffer
+ * descriptor events set in @status, and signals the eventfds registered for
+ * them. It is called with the partition lock held.
+ */
+static void aie_part_dma_notify(struct aie_partition *apart,
+				struct aie_location *loc,
+				enum aie_shim_switch_type sw, u32 status)
+{
+	struct aie_dma_notify *notify;
+
+	list_for_each_entry(notify, &apart->dma_notifiers, node) {
+		if (notify->loc.col != loc->col || notify->sw != sw ||
+		    !(status & BIT(notify->irq_id)))
+			continue;
+
+		aie_clear_l1_intr(apart, loc, sw, notify->irq_id);
+		eventfd_signal(notify->trigger, 1);
+	}
+}
+
 /**
  * aie_l1_backtrack() - backtrack AIE array tiles or shim tile based on
  *			the level 2 status bit set.
@@ -611,6 +642,10 @@ static bool aie_l1_backtrack(struct aie_partition *apart,
 
 	status = aie_get_l1_status(apart, &l1_ctrl, sw);
 
+	if (status & GENMASK(AIE_SHIM_DMA_NOTIFY_IRQ_ID_END,
+			     AIE_SHIM_DMA_NOTIFY_IRQ_ID_START))
+		aie_part_dma_notify(apart, &l1_ctrl, sw, status);
+
 	if (status & BIT(AIE_SHIM_TILE_ERROR_IRQ_ID)) {
 		u32 status[AIE_NUM_EVENT_STS_SHIMTILE] = {0};
 
@@ -1232,6 +1267,282 @@ int aie_part_set_intr_rscs(struct aie_partition *apart)
 	return 0;
 }
 
+/**
+ * aie_part_set_l1_irq_event() - set the event of a level 1 interrupt
+ *				 controller IRQ.
+ * @apart: AIE partition pointer.
+ * @loc: pointer to tile location.
+ * @sw: switch type.
+ * @irq_id: IRQ ID, one of the IRQ events after the broadcast signals.
+ * @event: event ID, 0 to clear the IRQ event.
+ */
+static void aie_part_set_l1_irq_event(struct aie_partition *apart,
+				      struct aie_location *loc,
+				      enum aie_shim_switch_type sw, u8 irq_id,
+				      u8 event)
+{
+	const struct aie_l1_intr_ctrl_attr *intr_ctrl = apart->adev->l1_ctrl;
+	u32 l1off, l1mask, shift, regoff, reg_value;
+
+	if (sw == AIE_SHIM_SWITCH_A) {
+		l1off = intr_ctrl->regoff + intr_ctrl->swa_event.regoff;
+		l1mask = intr_ctrl->swa_event.mask;
+	} else {
+		l1off = intr_ctrl->regoff + intr_ctrl->swb_event.regoff;
+		l1mask = intr_ctrl->swb_event.mask;
+	}
+
+	shift = (irq_id - AIE_SHIM_TILE_ERROR_IRQ_ID) * intr_ctrl->event_lsb;
+	regoff = aie_aperture_cal_regoff(apart->aperture, *loc, l1off);
+	reg_value = ioread32(apart->aperture->base + regoff);
+	reg_value &= ~(l1mask << shift);
+	reg_value |= (event & l1mask) << shift;
+	iowrite32(reg_value, apart->aperture->base + regoff);
+}
+
+/**
+ * aie_part_enable_l1_irq() - enable or disable a level 1 interrupt
+ *			      controller IRQ.
+ * @apart: AIE partition pointer.
+ * @loc: pointer to tile location.
+ * @sw: switch type.
+ * @irq_id: IRQ ID.
+ * @enable: true to enable the IRQ, false to disable it.
+ */
+static void aie_part_enable_l1_irq(struct aie_partition *apart,
+				   struct aie_location *loc,
+				   enum aie_shim_switch_type sw, u8 irq_id,
+				   bool enable)
+{
+	const struct aie_l1_intr_ctrl_attr *intr_ctrl = apart->adev->l1_ctrl;
+	const struct aie_single_reg_field *field;
+	u32 regoff;
+
+	if (sw == AIE_SHIM_SWITCH_A)
+		field = enable ? &intr_ctrl->swa_enable :
+				 &intr_ctrl->swa_disable;
+	else
+		field = enable ? &intr_ctrl->swb_enable :
+				 &intr_ctrl->swb_disable;
+
+	regoff = aie_aperture_cal_regoff(apart->aperture, *loc,
+					 intr_ctrl->regoff + field->regoff);
+	iowrite32(BIT(irq_id) & field->mask, apart->aperture->base + regoff);
+}
+
+/**
+ * aie_part_free_dma_notify() - stop a SHIM DMA channel completion
+ *				notification.
+ * @apart: AIE partition pointer.
+ * @notify: notification to free.
+ */
+static void aie_part_free_dma_notify(struct aie_partition *apart,
+				     struct aie_dma_notify *notify)
+{
+	aie_part_enable_l1_irq(apart, &notify->loc, notify->sw,
+			       notify->irq_id, false);
+	aie_part_set_l1_irq_event(apart, &notify->loc, notify->sw,
+				  notify->irq_id, 0);
+	aie_clear_l1_intr(apart, &notify->loc, notify->sw, notify->irq_id);
+	eventfd_ctx_put(notify->trigger);
+	list_del(&notify->node);
+	kfree(notify);
+}
+
+/**
+ * aie_part_alloc_l1_irq() - find a free level 1 interrupt controller IRQ event
+ *			     of a SHIM tile.
+ * @apart: AIE partition pointer.
+ * @loc: pointer to tile location.
+ * @sw: pointer to return the switch type.
+ * @irq_id: pointer to return the IRQ ID.
+ * @return: 0 for success, -EBUSY if all the IRQ events are in use.
+ *
+ * The first IRQ event of each switch is used for the SHIM tile errors, the
+ * others are shared by the DMA channels notification of the tile.
+ */
+static int aie_part_alloc_l1_irq(struct aie_partition *apart,
+				 struct aie_location *loc,
+				 enum aie_shim_switch_type *sw, u8 *irq_id)
+{
+	enum aie_shim_switch_type s;
+	u8 i;
+
+	for (s = AIE_SHIM_SWITCH_A; s <= AIE_SHIM_SWITCH_B; s++) {
+		for (i = AIE_SHIM_DMA_NOTIFY_IRQ_ID_START;
+		     i <= AIE_SHIM_DMA_NOTIFY_IRQ_ID_END; i++) {
+			struct aie_dma_notify *notify;
+			bool used = false;
+
+			list_for_each_entry(notify, &apart->dma_notifiers,
+					    node) {
+				if (notify->loc.col == loc->col &&
+				    notify->sw == s && notify->irq_id == i) {
+					used = true;
+					break;
+				}
+			}
+
+			if (!used) {
+				*sw = s;
+				*irq_id = i;
+				return 0;
+			}
+		}
+	}
+
+	return -EBUSY;
+}
+
+/**
+ * aie_part_set_dma_notify() - set SHIM DMA channel completion notification
+ * @apart: AIE partition pointer.
+ * @args: SHIM DMA channel notification arguments.
+ * @return: 0 for success, and negative value for failure.
+ *
+ * This function routes the finished buffer descriptor event of the SHIM DMA
+ * channel to a free IRQ event of the SHIM tile level 1 interrupt controller.
+ * The level 1 interrupt controllers outputs are routed to the level 2
+ * interrupt controllers by the application CDO in the same way as for the
+ * errors, the events are handled by the partition backtracking. Setting the
+ * notification of a channel which already has one replaces its eventfd.
+ */
+static int aie_part_set_dma_notify(struct aie_partition *apart,
+				   struct aie_dma_notify_args *args)
+{
+	const struct aie_dma_attr *shim_dma = apart->adev->shim_dma;
+	struct aie_dma_notify *notify, *found = NULL;
+	struct eventfd_ctx *trigger;
+	struct aie_location loc;
+	u32 ttype, event;
+	int ret;
+
+	if (!shim_dma->bd_done_event) {
+		dev_err(&apart->dev,
+			"DMA notification is not supported.\n");
+		return -EOPNOTSUPP;
+	}
+
+	if (aie_validate_location(apart, args->loc) < 0) {
+		dev_err(&apart->dev, "invalid loc (%u,%u).\n",
+			args->loc.col, args->loc.row);
+		return -EINVAL;
+	}
+
+	loc.col = args->loc.col + apart->range.start.col;
+	loc.row = args->loc.row + apart->range.start.row;
+	ttype = apart->adev->ops->get_tile_type(apart->adev, &loc);
+	if (ttype != AIE_TILE_TYPE_SHIMNOC) {
+		dev_err(&apart->dev, "(%u,%u) is not SHIM NOC.\n",
+			args->loc.col, args->loc.row);
+		return -EINVAL;
+	}
+
+	if (args->dir == AIE_DMA_S2MM && args->chan < shim_dma->num_s2mm_chan) {
+		event = shim_dma->bd_done_event + args->chan;
+	} else if (args->dir == AIE_DMA_MM2S &&
+		   args->chan < shim_dma->num_mm2s_chan) {
+		event = shim_dma->bd_done_event + shim_dma->num_s2mm_chan +
+			args->chan;
+	} else {
+		dev_err(&apart->dev, "invalid DMA channel %u, %u.\n",
+			args->dir, args->chan);
+		return -EINVAL;
+	}
+
+	list_for_each_entry(notify, &apart->dma_notifiers, node) {
+		if (notify->loc.col == loc.col && notify->event == event) {
+			found = notify;
+			break;
+		}
+	}
+
+	if (args->eventfd < 0) {
+		if (found)
+			aie_part_free_dma_notify(apart, found);
+		return 0;
+	}
+
+	trigger = eventfd_ctx_fdget(args->eventfd);
+	if (IS_ERR(trigger))
+		return PTR_ERR(trigger);
+
+	if (found) {
+		eventfd_ctx_put(found->trigger);
+		found->trigger = trigger;
+		return 0;
+	}
+
+	notify = kzalloc(sizeof(*notify), GFP_KERNEL);
+	if (!notify) {
+		eventfd_ctx_put(trigger);
+		return -ENOMEM;
+	}
+
+	ret = aie_part_alloc_l1_irq(apart, &loc, &notify->sw, &notify->irq_id);
+	if (ret) {
+		dev_err(&apart->dev,
+			"no free interrupt for DMA notification at (%u,%u).\n",
+			args->loc.col, args->loc.row);
+		eventfd_ctx_put(trigger);
+		kfree(notify);
+		return ret;
+	}
+
+	notify->trigger = trigger;
+	notify->loc = loc;
+	notify->event = event;
+
+	aie_part_set_l1_irq_event(apart, &loc, notify->sw, notify->irq_id,
+				  event);
+	aie_clear_l1_intr(apart, &loc, notify->sw, notify->irq_id);
+	aie_part_enable_l1_irq(apart, &loc, notify->sw, notify->irq_id, true);
+	list_add_tail(&notify->node, &apart->dma_notifiers);
+
+	return 0;
+}
+
+/**
+ * aie_part_set_dma_notify_from_user() - set SHIM DMA channel completion
+ *					 notification from user
+ * @apart: AIE partition pointer.
+ * @user_args: user SHIM DMA channel notification arguments.
+ * @return: 0 for success, and negative value for failure.
+ */
+long aie_part_set_dma_notify_from_user(struct aie_partition *apart,
+				       void __user *user_args)
+{
+	struct aie_dma_notify_args args;
+	int ret;
+
+	if (copy_from_user(&args, user_args, sizeof(args)))
+		return -EFAULT;
+
+	ret = mutex_lock_interruptible(&apart->mlock);
+	if (ret)
+		return ret;
+
+	ret = aie_part_set_dma_notify(apart, &args);
+
+	mutex_unlock(&apart->mlock);
+	return ret;
+}
+
+/**
+ * aie_part_release_dma_notifiers() - stop all the SHIM DMA channel completion
+ *				      notifications of a partition.
+ * @apart: AIE partition pointer.
+ *
+ * It is called with the partition lock held.
+ */
+void aie_part_release_dma_notifiers(struct aie_partition *apart)
+{
+	struct aie_dma_notify *notify, *tmp;
+
+	list_for_each_entry_safe(notify, tmp, &apart->dma_notifiers, node)
+		aie_part_free_dma_notify(apart, notify);
+}
+
 /**
  * aie_register_error_notification() - register a callback for error
  *				       notification.
@@ -0,0 +1,114 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Xilinx AI Engine lock acquire and release
+ *
+ * Copyright (C) 2023 Xilinx, Inc.
+ */
+#include <linux/delay.h>
+#include <linux/ktime.h>
+#include <linux/sched/signal.h>
+#include <linux/uaccess.h>
+#include <uapi/linux/xlnx-ai-engine.h>
+#include "ai-engine-internal.h"
+
+/* Bounds of the sleep between two attempts to get a lock */
+#define AIE_LOCK_RETRY_MIN_US	2U
+#define AIE_LOCK_RETRY_MAX_US	1000U
+
+/**
+ * aie_part_lock_try() - try once to acquire or release a lock
+ * @apart: AI engine partition
+ * @args: lock request arguments
+ * @acquire: true to acquire the lock, false to release it
+ * @return: 1 if the request is granted, 0 if it isn't, negative value for
+ *	    failure
+ *
+ * The lock must belong to a tile which is in use and has resources
+ * allocated by the resource manager, so that applications can't take the
+ * locks of the tiles of another application in the same partition.
+ */
+static int aie_part_lock_try(struct aie_partition *apart,
+			     struct aie_lock_args *args, bool acquire)
+{
+	struct aie_location loc;
+	int ret;
+
+	if (aie_validate_location(apart, args->loc)) {
+		dev_err(&apart->dev, "Invalid lock tile (%u,%u).\n",
+			args->loc.col, args->loc.row);
+		return -EINVAL;
+	}
+
+	loc.col = args->loc.col + apart->range.start.col;
+	loc.row = args->loc.row;
+
+	ret = mutex_lock_interruptible(&apart->mlock);
+	if (ret)
+		return ret;
+
+	if (!aie_part_check_clk_enable_loc(apart, &loc) ||
+	    !aie_part_rscmgr_tile_in_use(apart, loc)) {
+		dev_err(&apart->dev, "Lock tile (%u,%u) is not in use.\n",
+			args->loc.col, args->loc.row);
+		ret = -EPERM;
+		goto out;
+	}
+
+	ret = apart->adev->ops->lock_request(apart, &loc, args->lock_id,
+					     args->lock_val, acquire);
+	if (ret < 0)
+		dev_err(&apart->dev, "Invalid lock %u value %d.\n",
+			args->lock_id, args->lock_val);
+
+out:
+	mutex_unlock(&apart->mlock);
+	return ret;
+}
+
+/**
+ * aie_part_lock_from_user() - acquire or release a lock from user
+ * @apart: AI engine partition
+ * @user_args: user lock request arguments
+ * @acquire: true to acquire the lock, false to release it
+ * @nonblock: return -EAGAIN instead of sleeping for the lock
+ * @return: 0 for success, negative value for failure
+ *
+ * A lock which isn't granted is retried with a sleep, doubled after every
+ * attempt, until the timeout of the request expires. This keeps host and
+ * AI engine kernels synchronized without the host spinning on the lock
+ * registers.
+ */
+long aie_part_lock_from_user(struct aie_partition *apart,
+			     void __user *user_args, bool acquire,
+			     bool nonblock)
+{
+	unsigned int delay = AIE_LOCK_RETRY_MIN_US;
+	struct aie_lock_args args;
+	ktime_t deadline;
+	int ret;
+
+	if (!apart->adev->ops->lock_request)
+		return -EOPNOTSUPP;
+
+	if (copy_from_user(&args, user_args, sizeof(args)))
+		return -EFAULT;
+
+	deadline = ktime_add_us(ktime_get(), args.timeout_us);
+	for (;;) {
+		ret = aie_part_lock_try(apart, &args, acquire);
+		if (ret)
+			return ret < 0 ? ret : 0;
+
+		if (!args.timeout_us)
+			return -EBUSY;
+		if (ktime_after(ktime_get(), deadline))
+			return -ETIMEDOUT;
+		if (nonblock)
+			return -EAGAIN;
+		if (signal_pending(current))
+			return -ERESTARTSYS;
+
+		usleep_range(delay, delay * 2);
+		delay = min(delay * 2, AIE_LOCK_RETRY_MAX_US);
+	}
+}
@@ -6,6 +6,10 @@
  */
 
 #include <linux/dma-buf.h>
+#include <linux/dma-mapping.h>
+#include <linux/dmaengine.h>
+#include <linux/overflow.h>
+#include <linux/sizes.h>
 #include <linux/slab.h>
 #include <linux/types.h>
 #include <linux/uaccess.h>
@@ -13,6 +17,12 @@
 
 #include "ai-engine-internal.h"
 
+/* Segments smaller than this are written by the CPU */
+#define AIE_MEM_LOAD_DMA_MIN		SZ_4K
+/* Size of the bounce buffer used to feed the DMA channel */
+#define AIE_MEM_LOAD_CHUNK		SZ_1M
+#define AIE_MEM_LOAD_TIMEOUT_MS		1000U
+
 #define aie_cal_reg_goffset(adev, loc, regoff) ({ \
 	struct aie_device *_adev = (adev); \
 	struct aie_location *_loc = &(loc); \
@@ -301,3 +311,233 @@ bool aie_part_has_mem_mmapped(struct aie_partition *apart)
 	}
 	return false;
 }
+
+/**
+ * struct aie_mem_loader - AI engine memory loader state
+ * @chan: DMA memcpy channel, NULL to load with CPU writes only
+ * @buf: bounce buffer for the DMA channel
+ * @buf_dma: DMA address of @buf
+ */
+struct aie_mem_loader {
+	struct dma_chan *chan;
+	void *buf;
+	dma_addr_t buf_dma;
+};
+
+static void aie_mem_load_dma_done(void *arg)
+{
+	complete(arg);
+}
+
+/**
+ * aie_mem_loader_init() - get a DMA channel to load AI engine memories
+ * @apart: AI engine partition
+ * @loader: memory loader
+ *
+ * Any DMA memcpy channel of the system will do. Without one, or if the
+ * bounce buffer cannot be allocated, the loader falls back to CPU writes.
+ */
+static void aie_mem_loader_init(struct aie_partition *apart,
+				struct aie_mem_loader *loader)
+{
+	dma_cap_mask_t mask;
+
+	dma_cap_zero(mask);
+	dma_cap_set(DMA_MEMCPY, mask);
+
+	loader->chan = dma_request_chan_by_mask(&mask);
+	if (IS_ERR(loader->chan)) {
+		dev_dbg(&apart->dev, "no DMA channel, load with CPU.\n");
+		loader->chan = NULL;
+		return;
+	}
+
+	loader->buf = dma_alloc_coherent(loader->chan->device->dev,
+					 AIE_MEM_LOAD_CHUNK, &loader->buf_dma,
+					 GFP_KERNEL);
+	if (!loader->buf) {
+		dma_release_channel(loader->chan);
+		loader->chan = NULL;
+	}
+}
+
+static void aie_mem_loader_finish(struct aie_mem_loader *loader)
+{
+	if (!loader->chan)
+		return;
+
+	dma_free_coherent(loader->chan->device->dev, AIE_MEM_LOAD_CHUNK,
+			  loader->buf, loader->buf_dma);
+	dma_release_channel(loader->chan);
+}
+
+/**
+ * aie_mem_load_dma() - load a segment with the DMA channel
+ * @apart: AI engine partition
+ * @loader: memory loader with a DMA channel
+ * @pa: physical address of the tile memory
+ * @data: user data to load
+ * @len: length of the data in bytes
+ * @return: 0 for success, and negative value for failure.
+ */
+static int aie_mem_load_dma(struct aie_partition *apart,
+			    struct aie_mem_loader *loader, phys_addr_t pa,
+			    const void __user *data, size_t len)
+{
+	struct device *dmadev = loader->chan->device->dev;
+	dma_addr_t dst, dst_base;
+	size_t remain = len;
+	int ret = 0;
+
+	dst_base = dma_map_resource(dmadev, pa, len, DMA_FROM_DEVICE, 0);
+	if (dma_mapping_error(dmadev, dst_base))
+		return -ENOMEM;
+
+	dst = dst_base;
+	while (remain) {
+		struct dma_async_tx_descriptor *tx;
+		size_t copy = min_t(size_t, remain, AIE_MEM_LOAD_CHUNK);
+		DECLARE_COMPLETION_ONSTACK(done);
+		dma_cookie_t cookie;
+
+		if (copy_from_user(loader->buf, data, copy)) {
+			ret = -EFAULT;
+			break;
+		}
+
+		tx = dmaengine_prep_dma_memcpy(loader->chan, dst,
+					       loader->buf_dma, copy,
+					       DMA_PREP_INTERRUPT |
+					       DMA_CTRL_ACK);
+		if (!tx) {
+			ret = -ENOMEM;
+			break;
+		}
+
+		tx->callback = aie_mem_load_dma_done;
+		tx->callback_param = &done;
+		cookie = dmaengine_submit(tx);
+		ret = dma_submit_error(cookie);
+		if (ret)
+			break;
+
+		dma_async_issue_pending(loader->chan);
+		if (!wait_for_completion_timeout(&done,
+				msecs_to_jiffies(AIE_MEM_LOAD_TIMEOUT_MS))) {
+			dev_err(&apart->dev, "memory load DMA timed out.\n");
+			dmaengine_terminate_sync(loader->chan);
+			ret = -ETIMEDOUT;
+			break;
+		}
+
+		dst += copy;
+		data += copy;
+		remain -= copy;
+	}
+
+	dma_unmap_resource(dmadev, dst_base, len, DMA_FROM_DEVICE, 0);
+
+	return ret;
+}
+
+/**
+ * aie_mem_load_cpu() - load a segment with CPU writes
+ * @va: mapped address of the tile memory
+ * @data: user data to load
+ * @len: length of the data in bytes
+ * @return: 0 for success, and negative value for failure.
+ */
+static int aie_mem_load_cpu(void __iomem *va, const void __user *data,
+			    size_t len)
+{
+	u32 buf[256];
+
+	while (len) {
+		size_t copy = min(len, sizeof(buf));
+
+		if (copy_from_user(buf, data, copy))
+			return -EFAULT;
+
+		__iowrite32_copy(va, buf, copy / sizeof(u32));
+
+		va += copy;
+		data += copy;
+		len -= copy;
+	}
+
+	return 0;
+}
+
+/**
+ * aie_mem_load_from_user() - load AI engine tile memories
+ * @apart: AI engine partition
+ * @user_args: user AI engine memory load arguments
+ * @return: 0 for success, and negative value for failure.
+ *
+ * This function validates all the segments first, and then copies them to
+ * the tile memories. Segments of at least AIE_MEM_LOAD_DMA_MIN bytes go
+ * through a DMA memcpy channel if the system has one.
+ */
+int aie_mem_load_from_user(struct aie_partition *apart, void __user *user_args)
+{
+	struct aie_aperture *aperture = apart->aperture;
+	struct aie_mem_loader loader = {};
+	struct aie_mem_load_args args;
+	struct aie_mem_load_seg *segs;
+	bool use_dma = false;
+	u32 partoff, i;
+	int ret;
+
+	if (copy_from_user(&args, user_args, sizeof(args)))
+		return -EFAULT;
+
+	if (!args.num_segs)
+		return 0;
+
+	segs = memdup_user(u64_to_user_ptr(args.segsptr),
+			   array_size(args.num_segs, sizeof(*segs)));
+	if (IS_ERR(segs))
+		return PTR_ERR(segs);
+
+	ret = mutex_lock_interruptible(&apart->mlock);
+	if (ret)
+		goto out;
+
+	for (i = 0; i < args.num_segs; i++) {
+		ret = aie_part_reg_validation(apart, segs[i].offset,
+					      segs[i].len, 1);
+		if (ret) {
+			dev_err(&apart->dev,
+				"invalid memory load segment %u.\n", i);
+			goto out_unlock;
+		}
+		if (segs[i].len >= AIE_MEM_LOAD_DMA_MIN)
+			use_dma = true;
+	}
+
+	if (use_dma)
+		aie_mem_loader_init(apart, &loader);
+
+	partoff = aie_aperture_cal_regoff(aperture, apart->range.start, 0);
+	for (i = 0; i < args.num_segs; i++) {
+		const void __user *data = u64_to_user_ptr(segs[i].dataptr);
+		size_t off = partoff + segs[i].offset;
+
+		if (loader.chan && segs[i].len >= AIE_MEM_LOAD_DMA_MIN)
+			ret = aie_mem_load_dma(apart, &loader,
+					       aperture->res.start + off, data,
+					       segs[i].len);
+		else
+			ret = aie_mem_load_cpu(aperture->base + off, data,
+					       segs[i].len);
+		if (ret)
+			break;
+	}
+
+	aie_mem_loader_finish(&loader);
+out_unlock:
+	mutex_unlock(&apart->mlock);
+out:
+	kfree(segs);
+	return ret;
+}
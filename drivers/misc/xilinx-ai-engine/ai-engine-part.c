@@ -11,14 +11,18 @@
 #include <linux/dma-mapping.h>
 #include <linux/dma-map-ops.h>
 #include <linux/fs.h>
+#include <linux/iopoll.h>
+#include <linux/io_uring.h>
 #include <linux/kernel.h>
 #include <linux/list.h>
 #include <linux/mm.h>
 #include <linux/mman.h>
 #include <linux/mmu_context.h>
+#include <linux/moduleparam.h>
 #include <linux/mutex.h>
 #include <linux/of.h>
 #include <linux/of_device.h>
+#include <linux/sizes.h>
 #include <linux/slab.h>
 #include <linux/uaccess.h>
 #include <linux/uio.h>
@@ -26,6 +30,22 @@
 
 #include "ai-engine-internal.h"
 
+/* Largest buffer accepted by AIE_TRANSACTION_BATCH_IOCTL */
+#define AIE_TXN_BATCH_MAX_SIZE		SZ_64M
+/* Number of contiguous single word writes merged into one burst */
+#define AIE_TXN_BATCH_RUN_WORDS		64U
+/* Upper limit of the timeout of a batched mask poll */
+#define AIE_TXN_BATCH_POLL_MAX_US	1000000U
+
+/*
+ * The tile devices only carry the tile sysfs, registering several hundred
+ * of them dominates the creation of a full array partition.
+ */
+static bool tile_sysfs = true;
+module_param(tile_sysfs, bool, 0644);
+MODULE_PARM_DESC(tile_sysfs,
+		 "Create tile devices and sysfs for new partitions (default: true)");
+
 /**
  * aie_cal_loc() - calculate tile location from register offset to the AI
  *		   engine device
@@ -55,8 +75,8 @@ static void aie_cal_loc(struct aie_device *adev,
  * This function validate if the register to access is within the AI engine
  * partition. If it is write access, if the register is writable by user.
  */
-static int aie_part_reg_validation(struct aie_partition *apart, size_t offset,
-				   size_t len, u8 is_write)
+int aie_part_reg_validation(struct aie_partition *apart, size_t offset,
+			    size_t len, u8 is_write)
 {
 	struct aie_device *adev;
 	u32 regend32, ttype;
@@ -457,6 +477,201 @@ static int aie_part_execute_transaction_from_user(struct aie_partition *apart,
 	return ret;
 }
 
+/**
+ * aie_part_txn_batch_validate() - validate a batched transaction
+ * @apart: AI engine partition
+ * @buf: packed operations
+ * @size: size of @buf in bytes
+ * @return: 0 for success, and negative value for failure.
+ *
+ * This function checks the layout of the whole buffer and the registers
+ * accessed by every operation, before any of them is applied.
+ */
+static int aie_part_txn_batch_validate(struct aie_partition *apart,
+				       const void *buf, size_t size)
+{
+	size_t pos = 0;
+
+	while (pos < size) {
+		const struct aie_txn_op *op = buf + pos;
+		size_t dlen;
+		int ret;
+
+		if (size - pos < sizeof(*op))
+			goto err_layout;
+
+		dlen = op->len * sizeof(u32);
+		if (size - pos - sizeof(*op) < dlen)
+			goto err_layout;
+
+		switch (op->op) {
+		case AIE_TXN_OP_WRITE:
+			if (op->len != 1)
+				goto err_layout;
+			ret = aie_part_reg_validation(apart, op->offset,
+						      sizeof(u32), 1);
+			break;
+		case AIE_TXN_OP_MASKWRITE:
+			if (op->len != 2)
+				goto err_layout;
+			ret = aie_part_reg_validation(apart, op->offset,
+						      sizeof(u32), 1);
+			break;
+		case AIE_TXN_OP_BLOCKWRITE:
+			if (!op->len)
+				goto err_layout;
+			ret = aie_part_reg_validation(apart, op->offset, dlen,
+						      1);
+			break;
+		case AIE_TXN_OP_MASKPOLL:
+			if (op->len != 3)
+				goto err_layout;
+			ret = aie_part_reg_validation(apart, op->offset,
+						      sizeof(u32), 0);
+			break;
+		default:
+			dev_err(&apart->dev,
+				"Invalid transaction op %u at 0x%zx.\n",
+				op->op, pos);
+			return -EINVAL;
+		}
+
+		if (ret < 0)
+			return ret;
+
+		pos += sizeof(*op) + dlen;
+	}
+
+	return 0;
+
+err_layout:
+	dev_err(&apart->dev, "Invalid transaction layout at 0x%zx.\n", pos);
+	return -EINVAL;
+}
+
+/**
+ * aie_part_txn_batch_apply() - apply a validated batched transaction
+ * @apart: AI engine partition
+ * @buf: packed operations, validated by aie_part_txn_batch_validate()
+ * @size: size of @buf in bytes
+ * @return: 0 for success, and negative value for failure.
+ *
+ * Single word writes to contiguous registers are gathered and written as
+ * one burst, block writes are copied in one go. The copies use 32bit
+ * accesses as the registers do not accept wider ones.
+ */
+static int aie_part_txn_batch_apply(struct aie_partition *apart,
+				    const void *buf, size_t size)
+{
+	struct aie_aperture *aperture = apart->aperture;
+	u32 run[AIE_TXN_BATCH_RUN_WORDS];
+	u32 run_off = 0, run_len = 0;
+	void __iomem *base;
+	size_t pos = 0;
+
+	base = aperture->base +
+	       aie_aperture_cal_regoff(aperture, apart->range.start, 0);
+
+	while (pos < size) {
+		const struct aie_txn_op *op = buf + pos;
+		const u32 *data = (const u32 *)(op + 1);
+		void __iomem *va = base + op->offset;
+		u32 val;
+		int ret;
+
+		pos += sizeof(*op) + op->len * sizeof(u32);
+
+		if (op->op == AIE_TXN_OP_WRITE) {
+			if (run_len && (run_len == ARRAY_SIZE(run) ||
+					op->offset != run_off +
+						      run_len * sizeof(u32))) {
+				__iowrite32_copy(base + run_off, run, run_len);
+				run_len = 0;
+			}
+			if (!run_len)
+				run_off = op->offset;
+			run[run_len++] = data[0];
+			continue;
+		}
+
+		if (run_len) {
+			__iowrite32_copy(base + run_off, run, run_len);
+			run_len = 0;
+		}
+
+		switch (op->op) {
+		case AIE_TXN_OP_MASKWRITE:
+			val = ioread32(va);
+			val &= ~data[1];
+			val |= data[0] & data[1];
+			iowrite32(val, va);
+			break;
+		case AIE_TXN_OP_BLOCKWRITE:
+			__iowrite32_copy(va, data, op->len);
+			break;
+		case AIE_TXN_OP_MASKPOLL:
+			ret = read_poll_timeout(ioread32, val,
+						(val & data[1]) == data[0],
+						10, min(data[2],
+							AIE_TXN_BATCH_POLL_MAX_US),
+						false, va);
+			if (ret) {
+				dev_err(&apart->dev,
+					"mask poll 0x%x timed out, 0x%x.\n",
+					op->offset, val);
+				return ret;
+			}
+			break;
+		}
+	}
+
+	if (run_len)
+		__iowrite32_copy(base + run_off, run, run_len);
+
+	return 0;
+}
+
+/**
+ * aie_part_execute_txn_batch_from_user() - AI engine batched transaction
+ * @apart: AI engine partition
+ * @user_args: user AI engine batched transaction arguments
+ * @return: 0 for success, and negative value for failure.
+ *
+ * This function copies the packed operations from user once, validates them
+ * all and then applies them with the partition locked.
+ */
+static int aie_part_execute_txn_batch_from_user(struct aie_partition *apart,
+						void __user *user_args)
+{
+	struct aie_txn_batch batch;
+	void *buf;
+	int ret;
+
+	if (copy_from_user(&batch, user_args, sizeof(batch)))
+		return -EFAULT;
+
+	if (!batch.size || batch.size > AIE_TXN_BATCH_MAX_SIZE ||
+	    batch.size % sizeof(u32))
+		return -EINVAL;
+
+	buf = vmemdup_user(u64_to_user_ptr(batch.bufptr), batch.size);
+	if (IS_ERR(buf))
+		return PTR_ERR(buf);
+
+	ret = mutex_lock_interruptible(&apart->mlock);
+	if (ret)
+		goto out;
+
+	ret = aie_part_txn_batch_validate(apart, buf, batch.size);
+	if (!ret)
+		ret = aie_part_txn_batch_apply(apart, buf, batch.size);
+
+	mutex_unlock(&apart->mlock);
+out:
+	kvfree(buf);
+	return ret;
+}
+
 /**
  * aie_part_create_event_bitmap() - create event bitmap for all modules in a
  *				    given partition.
@@ -526,6 +741,10 @@ static int aie_part_release(struct inode *inode, struct file *filp)
 	struct aie_partition *apart = filp->private_data;
 	int ret;
 
+	/* The automatic gating work and devfreq take the partition lock */
+	cancel_delayed_work_sync(&apart->autogate_work);
+	aie_part_devfreq_exit(apart);
+
 	/* some reset bits in NPI are global, we need to lock adev */
 	ret = mutex_lock_interruptible(&apart->adev->mlock);
 	if (ret)
@@ -536,6 +755,7 @@ static int aie_part_release(struct inode *inode, struct file *filp)
 		return ret;
 
 	aie_part_release_dmabufs(apart);
+	aie_part_release_dma_notifiers(apart);
 	/* aie_part_clean() will do hardware reset */
 	aie_part_clean(apart);
 	mutex_unlock(&apart->adev->mlock);
@@ -673,6 +893,10 @@ static long aie_part_ioctl(struct file *fp, unsigned int cmd, unsigned long arg)
 		return aie_part_teardown(apart);
 	case AIE_PARTITION_CLR_CONTEXT_IOCTL:
 		return aie_part_clear_context(apart);
+	case AIE_PARTITION_FAST_CLEAN_IOCTL:
+		return aie_part_fast_clean(apart);
+	case AIE_SET_AUTO_GATE_IOCTL:
+		return aie_part_set_auto_gate_from_user(apart, argp);
 	case AIE_REG_IOCTL:
 	{
 		struct aie_reg_args raccess;
@@ -690,6 +914,8 @@ static long aie_part_ioctl(struct file *fp, unsigned int cmd, unsigned long arg)
 	}
 	case AIE_GET_MEM_IOCTL:
 		return aie_mem_get_info(apart, arg);
+	case AIE_LOAD_MEM_IOCTL:
+		return aie_mem_load_from_user(apart, argp);
 	case AIE_ATTACH_DMABUF_IOCTL:
 		return aie_part_attach_dmabuf_req(apart, argp);
 	case AIE_DETACH_DMABUF_IOCTL:
@@ -698,12 +924,22 @@ static long aie_part_ioctl(struct file *fp, unsigned int cmd, unsigned long arg)
 		return aie_part_set_bd_from_user(apart, argp);
 	case AIE_SET_SHIMDMA_DMABUF_BD_IOCTL:
 		return aie_part_set_dmabuf_bd_from_user(apart, argp);
+	case AIE_REARM_SHIMDMA_DMABUF_BD_IOCTL:
+		return aie_part_rearm_dmabuf_bd_from_user(apart, argp);
+	case AIE_SET_DMA_ND_BD_IOCTL:
+		return aie_part_set_nd_bd_from_user(apart, argp);
+	case AIE_SET_DMA_NOTIFY_IOCTL:
+		return aie_part_set_dma_notify_from_user(apart, argp);
+	case AIE_PERF_SAMPLER_IOCTL:
+		return aie_part_perf_sampler_from_user(apart, argp);
 	case AIE_REQUEST_TILES_IOCTL:
 		return aie_part_request_tiles_from_user(apart, argp);
 	case AIE_RELEASE_TILES_IOCTL:
 		return aie_part_release_tiles_from_user(apart, argp);
 	case AIE_TRANSACTION_IOCTL:
 		return aie_part_execute_transaction_from_user(apart, argp);
+	case AIE_TRANSACTION_BATCH_IOCTL:
+		return aie_part_execute_txn_batch_from_user(apart, argp);
 	case AIE_RSC_REQ_IOCTL:
 		return aie_part_rscmgr_rsc_req(apart, argp);
 	case AIE_RSC_REQ_SPECIFIC_IOCTL:
@@ -720,6 +956,10 @@ static long aie_part_ioctl(struct file *fp, unsigned int cmd, unsigned long arg)
 		return aie_part_rscmgr_get_statistics(apart, argp);
 	case AIE_SET_COLUMN_CLOCK_IOCTL:
 		return aie_part_set_column_clock_from_user(apart, argp);
+	case AIE_LOCK_ACQUIRE_IOCTL:
+		return aie_part_lock_from_user(apart, argp, true, false);
+	case AIE_LOCK_RELEASE_IOCTL:
+		return aie_part_lock_from_user(apart, argp, false, false);
 	default:
 		dev_err(&apart->dev, "Invalid/Unsupported ioctl command %u.\n",
 			cmd);
@@ -730,6 +970,46 @@ static long aie_part_ioctl(struct file *fp, unsigned int cmd, unsigned long arg)
 	return ret;
 }
 
+/**
+ * aie_part_uring_cmd() - io_uring passthrough of the partition hot ioctls
+ * @ioucmd: io_uring command, the sqe cmd area holds a struct aie_uring_cmd
+ * @issue_flags: io_uring issue flags
+ * @return: return value of the ioctl, posted as the cqe result
+ *
+ * Register, buffer descriptor and transaction commands only program
+ * registers, they complete inline. Submitting them through io_uring lets
+ * applications queue many of them with a single syscall and reap the
+ * results in batches. A lock which isn't available at nonblocking issue is
+ * retried from io_uring's worker, which may sleep for it.
+ */
+static int aie_part_uring_cmd(struct io_uring_cmd *ioucmd,
+			      unsigned int issue_flags)
+{
+	struct aie_partition *apart = ioucmd->file->private_data;
+	const struct aie_uring_cmd *cmd = ioucmd->cmd;
+	unsigned long arg = READ_ONCE(cmd->arg);
+	bool nonblock = issue_flags & IO_URING_F_NONBLOCK;
+
+	switch (ioucmd->cmd_op) {
+	case AIE_LOCK_ACQUIRE_IOCTL:
+		return aie_part_lock_from_user(apart, (void __user *)arg, true,
+					       nonblock);
+	case AIE_LOCK_RELEASE_IOCTL:
+		return aie_part_lock_from_user(apart, (void __user *)arg,
+					       false, nonblock);
+	case AIE_REG_IOCTL:
+	case AIE_SET_SHIMDMA_BD_IOCTL:
+	case AIE_SET_SHIMDMA_DMABUF_BD_IOCTL:
+	case AIE_REARM_SHIMDMA_DMABUF_BD_IOCTL:
+	case AIE_SET_DMA_ND_BD_IOCTL:
+	case AIE_TRANSACTION_IOCTL:
+	case AIE_TRANSACTION_BATCH_IOCTL:
+		return aie_part_ioctl(ioucmd->file, ioucmd->cmd_op, arg);
+	default:
+		return -EOPNOTSUPP;
+	}
+}
+
 const struct file_operations aie_part_fops = {
 	.owner		= THIS_MODULE,
 	.release	= aie_part_release,
@@ -737,6 +1017,7 @@ const struct file_operations aie_part_fops = {
 	.write_iter	= aie_part_write_iter,
 	.mmap		= aie_part_mmap,
 	.unlocked_ioctl	= aie_part_ioctl,
+	.uring_cmd	= aie_part_uring_cmd,
 };
 
 /**
@@ -775,6 +1056,11 @@ int aie_part_open(struct aie_partition *apart, void *rsc_metadata)
 	if (aie_part_has_error(apart))
 		schedule_work(&apart->aperture->backtrack);
 
+	/* The partition runs at its requested frequency without devfreq */
+	ret = aie_part_devfreq_init(apart);
+	if (ret)
+		dev_warn(&apart->dev, "failed to add devfreq: %d.\n", ret);
+
 	apart->status = XAIE_PART_STATUS_INUSE;
 
 	return 0;
@@ -861,16 +1147,49 @@ static int aie_part_create_mems_info(struct aie_partition *apart)
 }
 
 /**
- * aie_create_tiles() - create AI engine tile devices
+ * aie_tile_add_device() - add the device and sysfs of an AI engine tile
+ * @atile: AI engine tile
+ * @return: 0 for success, error code on failure
+ */
+static int aie_tile_add_device(struct aie_tile *atile)
+{
+	struct device *tdev = &atile->dev;
+	int ret;
+
+	device_initialize(tdev);
+	tdev->parent = &atile->apart->dev;
+	dev_set_drvdata(tdev, atile);
+	dev_set_name(tdev, "%u_%u", atile->loc.col, atile->loc.row);
+	tdev->release = aie_tile_release_device;
+	ret = device_add(tdev);
+	if (ret) {
+		dev_err(tdev, "tile device_add failed: %d\n", ret);
+		put_device(tdev);
+		return ret;
+	}
+	ret = aie_tile_sysfs_create_entries(atile);
+	if (ret) {
+		dev_err(tdev, "failed to create tile sysfs: %d\n", ret);
+		device_del(tdev);
+		put_device(tdev);
+		return ret;
+	}
+	return 0;
+}
+
+/**
+ * aie_create_tiles() - create AI engine tiles
  * @apart: AI engine partition
  * @return: 0 for success, error code on failure
  *
- * This function creates AI engine child tile devices for a given partition.
+ * This function creates AI engine tiles for a given partition, and their
+ * child tile devices unless the tile_sysfs module parameter is cleared.
  */
 static int aie_create_tiles(struct aie_partition *apart)
 {
 	struct aie_tile *atile;
 	u32 row, col, numtiles;
+	bool add_devices = READ_ONCE(tile_sysfs);
 	int ret = 0;
 
 	numtiles = apart->range.size.col * apart->range.size.row;
@@ -882,34 +1201,13 @@ static int aie_create_tiles(struct aie_partition *apart)
 	apart->atiles = atile;
 	for (col = 0; col < apart->range.size.col; col++) {
 		for (row = 0; row < apart->range.size.row; row++) {
-			struct device *tdev = &atile->dev;
-			char tdevname[10];
-
 			atile->apart = apart;
 			atile->loc.col = apart->range.start.col + col;
 			atile->loc.row = apart->range.start.row + row;
-			device_initialize(tdev);
-			tdev->parent = &apart->dev;
-			dev_set_drvdata(tdev, atile);
-			snprintf(tdevname, sizeof(tdevname) - 1, "%d_%d",
-				 apart->range.start.col + col,
-				 apart->range.start.row + row);
-			dev_set_name(tdev, tdevname);
-			tdev->release = aie_tile_release_device;
-			ret = device_add(tdev);
-			if (ret) {
-				dev_err(tdev, "tile device_add failed: %d\n",
-					ret);
-				put_device(tdev);
-				return ret;
-			}
-			ret = aie_tile_sysfs_create_entries(atile);
-			if (ret) {
-				dev_err(tdev, "failed to create tile sysfs: %d\n",
-					ret);
-				device_del(tdev);
-				put_device(tdev);
-				return ret;
+			if (add_devices) {
+				ret = aie_tile_add_device(atile);
+				if (ret)
+					return ret;
 			}
 			atile++;
 		}
@@ -944,6 +1242,8 @@ struct aie_partition *aie_create_partition(struct aie_aperture *aperture,
 	apart->adev = aperture->adev;
 	apart->partition_id = partition_id;
 	INIT_LIST_HEAD(&apart->dbufs);
+	INIT_LIST_HEAD(&apart->dma_notifiers);
+	INIT_DELAYED_WORK(&apart->autogate_work, aie_part_autogate_work);
 	mutex_init(&apart->mlock);
 	apart->range.start.col = aie_part_id_get_start_col(partition_id);
 	apart->range.size.col = aie_part_id_get_num_cols(partition_id);
@@ -1038,6 +1338,9 @@ struct aie_partition *aie_create_partition(struct aie_aperture *aperture,
  */
 static void aie_tile_remove(struct aie_tile *atile)
 {
+	if (!device_is_registered(&atile->dev))
+		return;
+
 	aie_tile_sysfs_remove_entries(atile);
 	device_del(&atile->dev);
 	put_device(&atile->dev);
@@ -0,0 +1,303 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Xilinx AI Engine performance sampler
+ *
+ * Copyright (C) 2020 Xilinx, Inc.
+ */
+
+#include <linux/anon_inodes.h>
+#include <linux/file.h>
+#include <linux/hrtimer.h>
+#include <linux/log2.h>
+#include <linux/mm.h>
+#include <linux/overflow.h>
+#include <linux/sizes.h>
+#include <linux/slab.h>
+#include <linux/uaccess.h>
+#include <linux/vmalloc.h>
+#include <linux/workqueue.h>
+#include <uapi/linux/xlnx-ai-engine.h>
+
+#include "ai-engine-internal.h"
+
+#define AIE_PERF_MAX_REGS		1024U
+#define AIE_PERF_MAX_RING_SIZE		SZ_64M
+#define AIE_PERF_MIN_PERIOD_NS		(10 * NSEC_PER_USEC)
+
+/**
+ * struct aie_perf_sampler - AI engine performance sampler
+ * @timer: sampling timer
+ * @work: work reading the registers of a sample
+ * @apart: AI engine partition
+ * @part_file: partition file, it keeps the partition while sampling
+ * @regs: mapped addresses of the sampled registers
+ * @locs: absolute locations of the tiles of the sampled registers
+ * @hdr: ring buffer header, at the start of the ring buffer memory
+ * @data: first record of the ring buffer
+ * @period: sampling period
+ * @num_regs: number of sampled registers
+ * @record_size: size of a record in bytes
+ * @mask: mask to get the index of a record from the ring buffer head
+ */
+struct aie_perf_sampler {
+	struct hrtimer timer;
+	struct work_struct work;
+	struct aie_partition *apart;
+	struct file *part_file;
+	void __iomem **regs;
+	struct aie_location *locs;
+	struct aie_perf_ring_hdr *hdr;
+	void *data;
+	ktime_t period;
+	u32 num_regs;
+	u32 record_size;
+	u32 mask;
+};
+
+/**
+ * aie_perf_sample_work() - take a sample
+ * @work: sampler work
+ *
+ * This function writes the next record of the ring buffer and publishes it
+ * by updating the ring buffer head. It is the only writer of the ring buffer.
+ * The partition lock is held so that no tile gets gated while it is read.
+ */
+static void aie_perf_sample_work(struct work_struct *work)
+{
+	struct aie_perf_sampler *sampler =
+		container_of(work, struct aie_perf_sampler, work);
+	struct aie_perf_ring_hdr *hdr = sampler->hdr;
+	u64 head = hdr->head;
+	void *record;
+	u32 i, *vals;
+
+	record = sampler->data + (head & sampler->mask) * sampler->record_size;
+	mutex_lock(&sampler->apart->mlock);
+	*(u64 *)record = ktime_get_ns();
+	vals = record + sizeof(u64);
+	for (i = 0; i < sampler->num_regs; i++) {
+		/* Accessing gated tiles can cause decode errors */
+		if (aie_part_check_clk_enable_loc(sampler->apart,
+						  &sampler->locs[i]))
+			vals[i] = ioread32(sampler->regs[i]);
+		else
+			vals[i] = U32_MAX;
+	}
+	mutex_unlock(&sampler->apart->mlock);
+
+	/* Make the record visible before the head moves past it */
+	smp_wmb();
+	WRITE_ONCE(hdr->head, head + 1);
+}
+
+/**
+ * aie_perf_sample() - sampling timer callback
+ * @timer: sampling timer
+ * @return: HRTIMER_RESTART
+ *
+ * A sample still waiting for the partition lock covers this period too.
+ */
+static enum hrtimer_restart aie_perf_sample(struct hrtimer *timer)
+{
+	struct aie_perf_sampler *sampler =
+		container_of(timer, struct aie_perf_sampler, timer);
+
+	queue_work(system_highpri_wq, &sampler->work);
+
+	hrtimer_forward_now(timer, sampler->period);
+	return HRTIMER_RESTART;
+}
+
+static int aie_perf_mmap(struct file *fp, struct vm_area_struct *vma)
+{
+	struct aie_perf_sampler *sampler = fp->private_data;
+
+	/* Only the kernel writes the ring buffer */
+	if (vma->vm_flags & VM_WRITE)
+		return -EINVAL;
+	vma->vm_flags &= ~VM_MAYWRITE;
+
+	return remap_vmalloc_range(vma, sampler->hdr, vma->vm_pgoff);
+}
+
+static void aie_perf_sampler_free(struct aie_perf_sampler *sampler)
+{
+	vfree(sampler->hdr);
+	kfree(sampler->locs);
+	kfree(sampler->regs);
+	kfree(sampler);
+}
+
+static int aie_perf_release(struct inode *inode, struct file *fp)
+{
+	struct aie_perf_sampler *sampler = fp->private_data;
+	struct file *part_file = sampler->part_file;
+
+	hrtimer_cancel(&sampler->timer);
+	cancel_work_sync(&sampler->work);
+	aie_perf_sampler_free(sampler);
+	fput(part_file);
+
+	return 0;
+}
+
+static const struct file_operations aie_perf_fops = {
+	.owner		= THIS_MODULE,
+	.release	= aie_perf_release,
+	.mmap		= aie_perf_mmap,
+};
+
+/**
+ * aie_perf_sampler_set_regs() - validate and map the sampled registers
+ * @apart: AI engine partition
+ * @sampler: AI engine performance sampler
+ * @offs: register offsets relative to the start of the partition
+ * @return: 0 for success, negative value for failure
+ *
+ * It is called with the partition lock held.
+ */
+static int aie_perf_sampler_set_regs(struct aie_partition *apart,
+				     struct aie_perf_sampler *sampler,
+				     const u32 *offs)
+{
+	struct aie_aperture *aperture = apart->aperture;
+	struct aie_device *adev = apart->adev;
+	void __iomem *base;
+	u32 i;
+
+	base = aperture->base + aie_aperture_cal_regoff(aperture,
+							apart->range.start, 0);
+	for (i = 0; i < sampler->num_regs; i++) {
+		struct aie_location *loc = &sampler->locs[i];
+		int ret;
+
+		ret = aie_part_reg_validation(apart, offs[i], sizeof(u32), 0);
+		if (ret)
+			return ret;
+
+		loc->col = (u32)aie_tile_reg_field_get(aie_col_mask(adev),
+						       adev->col_shift, offs[i]);
+		loc->row = (u32)aie_tile_reg_field_get(aie_row_mask(adev),
+						       adev->row_shift, offs[i]);
+		loc->col += apart->range.start.col;
+		sampler->regs[i] = base + offs[i];
+	}
+
+	return 0;
+}
+
+/**
+ * aie_part_perf_sampler_from_user() - start an AI engine performance sampler
+ * @apart: AI engine partition
+ * @user_args: user AI engine performance sampler arguments
+ * @return: file descriptor of the sampler for success, negative value for
+ *	    failure
+ *
+ * This function allocates the ring buffer of the sampler and starts the
+ * sampling timer. The timer queues a work item which reads the registers
+ * with the partition lock held, user space reads the records from the
+ * mapped ring buffer without any system call.
+ */
+long aie_part_perf_sampler_from_user(struct aie_partition *apart,
+				     void __user *user_args)
+{
+	struct aie_perf_sampler_args args;
+	struct aie_perf_sampler *sampler;
+	u32 data_offset, *offs;
+	size_t size;
+	int ret, fd;
+
+	if (copy_from_user(&args, user_args, sizeof(args)))
+		return -EFAULT;
+
+	if (!args.num_regs || args.num_regs > AIE_PERF_MAX_REGS ||
+	    !is_power_of_2(args.num_records) ||
+	    args.period_ns < AIE_PERF_MIN_PERIOD_NS) {
+		dev_err(&apart->dev,
+			"invalid perf sampler, %u regs, %u records, %llu ns.\n",
+			args.num_regs, args.num_records, args.period_ns);
+		return -EINVAL;
+	}
+
+	sampler = kzalloc(sizeof(*sampler), GFP_KERNEL);
+	if (!sampler)
+		return -ENOMEM;
+
+	sampler->apart = apart;
+	sampler->num_regs = args.num_regs;
+	sampler->record_size = ALIGN(sizeof(u64) + args.num_regs * sizeof(u32),
+				     sizeof(u64));
+	sampler->mask = args.num_records - 1;
+	sampler->period = ns_to_ktime(args.period_ns);
+
+	data_offset = ALIGN(sizeof(*sampler->hdr), SMP_CACHE_BYTES);
+	if (check_mul_overflow((size_t)args.num_records,
+			       (size_t)sampler->record_size, &size) ||
+	    check_add_overflow(size, (size_t)data_offset, &size) ||
+	    size > AIE_PERF_MAX_RING_SIZE) {
+		dev_err(&apart->dev, "perf sampler ring buffer too large.\n");
+		ret = -EINVAL;
+		goto free_sampler;
+	}
+
+	sampler->regs = kcalloc(args.num_regs, sizeof(*sampler->regs),
+				GFP_KERNEL);
+	sampler->locs = kcalloc(args.num_regs, sizeof(*sampler->locs),
+				GFP_KERNEL);
+	sampler->hdr = vmalloc_user(PAGE_ALIGN(size));
+	if (!sampler->regs || !sampler->locs || !sampler->hdr) {
+		ret = -ENOMEM;
+		goto free_sampler;
+	}
+
+	sampler->hdr->num_records = args.num_records;
+	sampler->hdr->num_regs = args.num_regs;
+	sampler->hdr->record_size = sampler->record_size;
+	sampler->hdr->data_offset = data_offset;
+	sampler->data = (void *)sampler->hdr + data_offset;
+
+	offs = memdup_user(u64_to_user_ptr(args.regsptr),
+			   array_size(args.num_regs, sizeof(*offs)));
+	if (IS_ERR(offs)) {
+		ret = PTR_ERR(offs);
+		goto free_sampler;
+	}
+
+	ret = mutex_lock_interruptible(&apart->mlock);
+	if (ret) {
+		kfree(offs);
+		goto free_sampler;
+	}
+
+	ret = aie_perf_sampler_set_regs(apart, sampler, offs);
+	mutex_unlock(&apart->mlock);
+	kfree(offs);
+	if (ret)
+		goto free_sampler;
+
+	sampler->part_file = get_file(apart->filep);
+
+	/*
+	 * Start sampling before the file descriptor is installed, once it is
+	 * installed user space can close it at any time.
+	 */
+	INIT_WORK(&sampler->work, aie_perf_sample_work);
+	hrtimer_init(&sampler->timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL_SOFT);
+	sampler->timer.function = aie_perf_sample;
+	hrtimer_start(&sampler->timer, sampler->period, HRTIMER_MODE_REL_SOFT);
+
+	fd = anon_inode_getfd("aie-perf", &aie_perf_fops, sampler,
+			      O_RDONLY | O_CLOEXEC);
+	if (fd < 0) {
+		hrtimer_cancel(&sampler->timer);
+		cancel_work_sync(&sampler->work);
+		fput(sampler->part_file);
+		aie_perf_sampler_free(sampler);
+	}
+
+	return fd;
+
+free_sampler:
+	aie_perf_sampler_free(sampler);
+	return ret;
+}
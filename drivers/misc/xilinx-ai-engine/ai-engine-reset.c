@@ -162,6 +162,113 @@ int aie_part_clear_context(struct aie_partition *apart)
 	return ret;
 }
 
+/**
+ * aie_part_clear_inuse_mems() - clear memories of the tiles in use
+ * @apart: AI engine partition
+ */
+static void aie_part_clear_inuse_mems(struct aie_partition *apart)
+{
+	struct aie_device *adev = apart->adev;
+	struct aie_part_mem *pmems = apart->pmems;
+	u32 i, num_mems;
+
+	num_mems = adev->ops->get_mem_info(adev, &apart->range, NULL);
+	for (i = 0; i < num_mems; i++) {
+		struct aie_mem *mem = &pmems[i].mem;
+		struct aie_range *range = &mem->range;
+		u32 c, r;
+
+		for (c = range->start.col;
+		     c < range->start.col + range->size.col; c++) {
+			for (r = range->start.row;
+			     r < range->start.row + range->size.row; r++) {
+				struct aie_location loc;
+				u32 memoff;
+
+				loc.col = c;
+				loc.row = r;
+				if (!aie_part_check_tile_inuse_loc(apart, &loc) ||
+				    !aie_part_check_clk_enable_loc(apart, &loc))
+					continue;
+
+				memoff = aie_cal_regoff(adev, loc, mem->offset);
+				memset_io(apart->aperture->base + memoff, 0,
+					  mem->size);
+			}
+		}
+	}
+}
+
+/**
+ * aie_part_fast_clean() - clean AI engine partition for the next user
+ * @apart: AI engine partition
+ * @return: 0 for success and negative value for failure
+ *
+ * This function will:
+ * - reset AI engine partition columns and shims
+ * - ungate the tiles in use again
+ * - clear memories and core registers of the tiles in use
+ * - setup axi mm to raise events, partition isolation and L2 interrupt
+ * - reset the partition resources and the dmabuf and DMA notification
+ *   states which the reset made stale
+ *
+ * Unlike aie_part_clear_context() and aie_part_teardown(), it doesn't
+ * zeroize the memories of the whole partition and it keeps the tiles in use
+ * requested with their clocks on. It is meant for switching the partition
+ * between applications which use the same tiles.
+ */
+int aie_part_fast_clean(struct aie_partition *apart)
+{
+	u32 node_id = apart->adev->pm_node_id;
+	int ret;
+
+	ret = mutex_lock_interruptible(&apart->mlock);
+	if (ret)
+		return ret;
+
+	/* The column reset gates the tiles */
+	aie_resource_clear_all(&apart->cores_clk_state);
+	ret = zynqmp_pm_aie_operation(node_id, apart->range.start.col,
+				      apart->range.size.col,
+				      XILINX_AIE_OPS_COL_RST |
+				      XILINX_AIE_OPS_SHIM_RST);
+	if (ret < 0)
+		goto exit;
+
+	ret = apart->adev->ops->set_part_clocks(apart);
+	if (ret < 0)
+		goto exit;
+
+	aie_part_clear_inuse_mems(apart);
+	aie_part_clear_core_regs(apart);
+
+	ret = zynqmp_pm_aie_operation(node_id, apart->range.start.col,
+				      apart->range.size.col,
+				      XILINX_AIE_OPS_ENB_AXI_MM_ERR_EVENT);
+	if (ret < 0)
+		goto exit;
+
+	ret = aie_part_init_isolation(apart);
+	if (ret < 0)
+		goto exit;
+
+	ret = zynqmp_pm_aie_operation(node_id, apart->range.start.col,
+				      apart->range.size.col,
+				      XILINX_AIE_OPS_SET_L2_CTRL_NPI_INTR);
+	if (ret < 0)
+		goto exit;
+
+	/* The shim reset cleared the BDs and the interrupt routing */
+	aie_part_release_dmabuf_bds(apart, NULL);
+	aie_part_release_dma_notifiers(apart);
+	aie_part_clear_cached_events(apart);
+	aie_part_rscmgr_reset(apart);
+
+exit:
+	mutex_unlock(&apart->mlock);
+	return ret;
+}
+
 /**
  * aie_part_clean() - reset and clear AI engine partition
  * @apart: AI engine partition
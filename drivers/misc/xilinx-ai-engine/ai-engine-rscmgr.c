@@ -1450,6 +1450,58 @@ static int aie_part_rscmgr_check_avail(struct aie_rsc_stat *rstat,
 					       sbit, total);
 }
 
+/**
+ * aie_part_rscmgr_tile_in_use() - check if any resource of a tile is used
+ *
+ * @apart: AI engine partition
+ * @loc: absolute tile location
+ *
+ * @return: true if a resource of the tile is statically allocated or has been
+ *	    requested, false otherwise
+ *
+ * Broadcast channels are not checked, as the channels reserved for the
+ * interrupts are allocated in every tile. This function expect caller to
+ * lock the partition before calling this function.
+ */
+bool aie_part_rscmgr_tile_in_use(struct aie_partition *apart,
+				 struct aie_location loc)
+{
+	u32 ttype = apart->adev->ops->get_tile_type(apart->adev, &loc);
+	struct aie_tile_attr *tattr;
+	u32 m, r;
+
+	if (ttype >= AIE_TILE_TYPE_MAX)
+		return false;
+
+	tattr = aie_dev_get_tile_attr(apart->adev, ttype);
+	for (m = 0; m < tattr->num_mods; m++) {
+		for (r = AIE_RSCTYPE_PERF; r < AIE_RSCTYPE_MAX; r++) {
+			struct aie_rsc_stat *rstat;
+			int max_rscs, start_bit;
+
+			if (r == AIE_RSCTYPE_BROADCAST)
+				continue;
+
+			rstat = aie_part_get_rsc_bitmaps(apart, loc,
+							 tattr->mods[m], r);
+			start_bit = aie_part_get_rsc_startbit(apart, loc,
+							      tattr->mods[m],
+							      r);
+			max_rscs = aie_part_get_mod_num_rscs(apart, loc,
+							     tattr->mods[m],
+							     r);
+			if (!rstat || start_bit < 0 || !max_rscs)
+				continue;
+
+			if (aie_part_rscmgr_check_avail(rstat, start_bit,
+							max_rscs) != max_rscs)
+				return true;
+		}
+	}
+
+	return false;
+}
+
 /**
  * aie_part_rscmgr_get_statistics() - get resource statistics based on user
  *				      request
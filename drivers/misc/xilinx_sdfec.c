@@ -21,6 +21,9 @@
 #include <linux/clk.h>
 #include <linux/compat.h>
 #include <linux/highmem.h>
+#include <linux/bitmap.h>
+#include <linux/mm.h>
+#include <linux/mutex.h>
 
 #include <uapi/misc/xilinx_sdfec.h>
 
@@ -164,6 +167,21 @@ static DEFINE_IDA(dev_nrs);
 /* The maximum number of pinned pages */
 #define MAX_NUM_PAGES ((XSDFEC_QC_TABLE_DEPTH / PAGE_SIZE) + 1)
 
+/* Number of LDPC code slots */
+#define XSDFEC_LDPC_MAX_CODES                                                  \
+	((XSDFEC_LDPC_CODE_REG0_ADDR_HIGH - XSDFEC_LDPC_CODE_REG0_ADDR_BASE) /  \
+	 XSDFEC_LDPC_REG_JUMP + 1)
+
+/* Shadow of the LDPC code registers followed by the SC, LA and QC tables */
+#define XSDFEC_SHADOW_SC_IDX                                                   \
+	(XSDFEC_LDPC_MAX_CODES * XSDFEC_LDPC_REG_JUMP / XSDFEC_REG_WIDTH_JUMP)
+#define XSDFEC_SHADOW_LA_IDX                                                   \
+	(XSDFEC_SHADOW_SC_IDX + XSDFEC_SC_TABLE_DEPTH / XSDFEC_REG_WIDTH_JUMP)
+#define XSDFEC_SHADOW_QC_IDX                                                   \
+	(XSDFEC_SHADOW_LA_IDX + XSDFEC_LA_TABLE_DEPTH / XSDFEC_REG_WIDTH_JUMP)
+#define XSDFEC_SHADOW_WORDS                                                    \
+	(XSDFEC_SHADOW_QC_IDX + XSDFEC_QC_TABLE_DEPTH / XSDFEC_REG_WIDTH_JUMP)
+
 /**
  * struct xsdfec_clks - For managing SD-FEC clocks
  * @core_clk: Main processing clock for core
@@ -206,6 +224,10 @@ struct xsdfec_clks {
  * @state_updated: indicates State updated by interrupt handler
  * @stats_updated: indicates Stats updated by interrupt handler
  * @intr_enabled: indicates IRQ enabled
+ * @ldpc_lock: Protects the LDPC code shadow
+ * @ldpc_shadow: Values written to the LDPC code registers and tables
+ * @ldpc_valid: Bitmap of the @ldpc_shadow words known to match the hardware
+ * @stats_page: Page mapped read-only by user space to read the stats
  *
  * This structure contains necessary state for SDFEC driver to operate
  */
@@ -229,6 +251,11 @@ struct xsdfec_dev {
 	bool state_updated;
 	bool stats_updated;
 	bool intr_enabled;
+	/* Mutex to protect the LDPC code shadow */
+	struct mutex ldpc_lock;
+	u32 *ldpc_shadow;
+	unsigned long *ldpc_valid;
+	struct page *stats_page;
 };
 
 static inline void xsdfec_regwrite(struct xsdfec_dev *xsdfec, u32 addr,
@@ -455,6 +482,58 @@ static int xsdfec_get_turbo(struct xsdfec_dev *xsdfec, void __user *arg)
 	return err;
 }
 
+static int xsdfec_ldpc_shadow_idx(u32 addr)
+{
+	if (addr >= XSDFEC_LDPC_CODE_REG0_ADDR_BASE &&
+	    addr <= XSDFEC_LDPC_CODE_REG3_ADDR_HIGH)
+		return (addr - XSDFEC_LDPC_CODE_REG0_ADDR_BASE) /
+		       XSDFEC_REG_WIDTH_JUMP;
+	if (addr >= XSDFEC_LDPC_SC_TABLE_ADDR_BASE &&
+	    addr < XSDFEC_LDPC_SC_TABLE_ADDR_HIGH)
+		return XSDFEC_SHADOW_SC_IDX +
+		       (addr - XSDFEC_LDPC_SC_TABLE_ADDR_BASE) /
+		       XSDFEC_REG_WIDTH_JUMP;
+	if (addr >= XSDFEC_LDPC_LA_TABLE_ADDR_BASE &&
+	    addr < XSDFEC_LDPC_LA_TABLE_ADDR_HIGH)
+		return XSDFEC_SHADOW_LA_IDX +
+		       (addr - XSDFEC_LDPC_LA_TABLE_ADDR_BASE) /
+		       XSDFEC_REG_WIDTH_JUMP;
+	if (addr >= XSDFEC_LDPC_QC_TABLE_ADDR_BASE &&
+	    addr < XSDFEC_LDPC_QC_TABLE_ADDR_HIGH)
+		return XSDFEC_SHADOW_QC_IDX +
+		       (addr - XSDFEC_LDPC_QC_TABLE_ADDR_BASE) /
+		       XSDFEC_REG_WIDTH_JUMP;
+
+	return -EINVAL;
+}
+
+/*
+ * Write an LDPC code register or table word, skipping the write if the
+ * hardware already holds the value. Called with ldpc_lock held.
+ */
+static void xsdfec_ldpc_write(struct xsdfec_dev *xsdfec, u32 addr, u32 value)
+{
+	int idx = xsdfec_ldpc_shadow_idx(addr);
+
+	if (WARN_ON_ONCE(idx < 0))
+		return;
+
+	if (test_bit(idx, xsdfec->ldpc_valid) &&
+	    xsdfec->ldpc_shadow[idx] == value)
+		return;
+
+	xsdfec_regwrite(xsdfec, addr, value);
+	xsdfec->ldpc_shadow[idx] = value;
+	__set_bit(idx, xsdfec->ldpc_valid);
+}
+
+static void xsdfec_ldpc_invalidate(struct xsdfec_dev *xsdfec)
+{
+	mutex_lock(&xsdfec->ldpc_lock);
+	bitmap_zero(xsdfec->ldpc_valid, XSDFEC_SHADOW_WORDS);
+	mutex_unlock(&xsdfec->ldpc_lock);
+}
+
 static int xsdfec_reg0_write(struct xsdfec_dev *xsdfec, u32 n, u32 k, u32 psize,
 			     u32 offset)
 {
@@ -482,10 +561,10 @@ static int xsdfec_reg0_write(struct xsdfec_dev *xsdfec, u32 n, u32 k, u32 psize,
 				(offset * XSDFEC_LDPC_REG_JUMP));
 		return -EINVAL;
 	}
-	xsdfec_regwrite(xsdfec,
-			XSDFEC_LDPC_CODE_REG0_ADDR_BASE +
+	xsdfec_ldpc_write(xsdfec,
+			  XSDFEC_LDPC_CODE_REG0_ADDR_BASE +
 				(offset * XSDFEC_LDPC_REG_JUMP),
-			wdata);
+			  wdata);
 	return 0;
 }
 
@@ -516,10 +595,10 @@ static int xsdfec_reg1_write(struct xsdfec_dev *xsdfec, u32 psize,
 				(offset * XSDFEC_LDPC_REG_JUMP));
 		return -EINVAL;
 	}
-	xsdfec_regwrite(xsdfec,
-			XSDFEC_LDPC_CODE_REG1_ADDR_BASE +
+	xsdfec_ldpc_write(xsdfec,
+			  XSDFEC_LDPC_CODE_REG1_ADDR_BASE +
 				(offset * XSDFEC_LDPC_REG_JUMP),
-			wdata);
+			  wdata);
 	return 0;
 }
 
@@ -569,10 +648,10 @@ static int xsdfec_reg2_write(struct xsdfec_dev *xsdfec, u32 nlayers, u32 nmqc,
 				(offset * XSDFEC_LDPC_REG_JUMP));
 		return -EINVAL;
 	}
-	xsdfec_regwrite(xsdfec,
-			XSDFEC_LDPC_CODE_REG2_ADDR_BASE +
+	xsdfec_ldpc_write(xsdfec,
+			  XSDFEC_LDPC_CODE_REG2_ADDR_BASE +
 				(offset * XSDFEC_LDPC_REG_JUMP),
-			wdata);
+			  wdata);
 	return 0;
 }
 
@@ -590,23 +669,16 @@ static int xsdfec_reg3_write(struct xsdfec_dev *xsdfec, u8 sc_off, u8 la_off,
 				(offset * XSDFEC_LDPC_REG_JUMP));
 		return -EINVAL;
 	}
-	xsdfec_regwrite(xsdfec,
-			XSDFEC_LDPC_CODE_REG3_ADDR_BASE +
+	xsdfec_ldpc_write(xsdfec,
+			  XSDFEC_LDPC_CODE_REG3_ADDR_BASE +
 				(offset * XSDFEC_LDPC_REG_JUMP),
-			wdata);
+			  wdata);
 	return 0;
 }
 
-static int xsdfec_table_write(struct xsdfec_dev *xsdfec, u32 offset,
-			      u32 *src_ptr, u32 len, const u32 base_addr,
+static int xsdfec_table_check(struct xsdfec_dev *xsdfec, u32 offset, u32 len,
 			      const u32 depth)
 {
-	u32 reg = 0;
-	int res, i, nr_pages;
-	u32 n;
-	u32 *addr = NULL;
-	struct page *pages[MAX_NUM_PAGES];
-
 	/*
 	 * Writes that go beyond the length of
 	 * Shared Scale(SC) table should fail
@@ -618,6 +690,23 @@ static int xsdfec_table_write(struct xsdfec_dev *xsdfec, u32 offset,
 		return -EINVAL;
 	}
 
+	return 0;
+}
+
+static int xsdfec_table_write(struct xsdfec_dev *xsdfec, u32 offset,
+			      u32 *src_ptr, u32 len, const u32 base_addr,
+			      const u32 depth)
+{
+	u32 reg = 0;
+	int res, i, nr_pages;
+	u32 n;
+	u32 *addr = NULL;
+	struct page *pages[MAX_NUM_PAGES];
+
+	res = xsdfec_table_check(xsdfec, offset, len, depth);
+	if (res)
+		return res;
+
 	n = (len * XSDFEC_REG_WIDTH_JUMP) / PAGE_SIZE;
 	if ((len * XSDFEC_REG_WIDTH_JUMP) % PAGE_SIZE)
 		n += 1;
@@ -638,10 +727,11 @@ static int xsdfec_table_write(struct xsdfec_dev *xsdfec, u32 offset,
 	for (i = 0; i < nr_pages; i++) {
 		addr = kmap_local_page(pages[i]);
 		do {
-			xsdfec_regwrite(xsdfec,
-					base_addr + ((offset + reg) *
-						     XSDFEC_REG_WIDTH_JUMP),
-					addr[reg]);
+			xsdfec_ldpc_write(xsdfec,
+					  base_addr + ((offset + reg) *
+						       XSDFEC_REG_WIDTH_JUMP),
+					  addr[reg % (PAGE_SIZE /
+						      XSDFEC_REG_WIDTH_JUMP)]);
 			reg++;
 		} while ((reg < len) &&
 			 ((reg * XSDFEC_REG_WIDTH_JUMP) % PAGE_SIZE));
@@ -651,42 +741,56 @@ static int xsdfec_table_write(struct xsdfec_dev *xsdfec, u32 offset,
 	return 0;
 }
 
-static int xsdfec_add_ldpc(struct xsdfec_dev *xsdfec, void __user *arg)
+static int xsdfec_table_load(struct xsdfec_dev *xsdfec, u32 offset,
+			     const u32 *src, u32 len, const u32 base_addr,
+			     const u32 depth)
 {
-	struct xsdfec_ldpc_params *ldpc;
-	int ret, n;
+	u32 reg;
+	int ret;
 
-	ldpc = memdup_user(arg, sizeof(*ldpc));
-	if (IS_ERR(ldpc))
-		return PTR_ERR(ldpc);
+	ret = xsdfec_table_check(xsdfec, offset, len, depth);
+	if (ret)
+		return ret;
 
-	if (xsdfec->config.code == XSDFEC_TURBO_CODE) {
-		ret = -EIO;
-		goto err_out;
-	}
+	for (reg = 0; reg < len; reg++)
+		xsdfec_ldpc_write(xsdfec,
+				  base_addr + ((offset + reg) *
+					       XSDFEC_REG_WIDTH_JUMP),
+				  src[reg]);
+	return 0;
+}
+
+static int xsdfec_ldpc_writable(struct xsdfec_dev *xsdfec)
+{
+	if (xsdfec->config.code == XSDFEC_TURBO_CODE)
+		return -EIO;
 
 	/* Verify Device has not started */
-	if (xsdfec->state == XSDFEC_STARTED) {
-		ret = -EIO;
-		goto err_out;
-	}
+	if (xsdfec->state == XSDFEC_STARTED)
+		return -EIO;
 
-	if (xsdfec->config.code_wr_protect) {
-		ret = -EIO;
-		goto err_out;
-	}
+	if (xsdfec->config.code_wr_protect)
+		return -EIO;
+
+	return 0;
+}
+
+static int xsdfec_ldpc_regs_write(struct xsdfec_dev *xsdfec,
+				  const struct xsdfec_ldpc_params *ldpc)
+{
+	int ret;
 
 	/* Write Reg 0 */
 	ret = xsdfec_reg0_write(xsdfec, ldpc->n, ldpc->k, ldpc->psize,
 				ldpc->code_id);
 	if (ret)
-		goto err_out;
+		return ret;
 
 	/* Write Reg 1 */
 	ret = xsdfec_reg1_write(xsdfec, ldpc->psize, ldpc->no_packing, ldpc->nm,
 				ldpc->code_id);
 	if (ret)
-		goto err_out;
+		return ret;
 
 	/* Write Reg 2 */
 	ret = xsdfec_reg2_write(xsdfec, ldpc->nlayers, ldpc->nmqc,
@@ -694,14 +798,31 @@ static int xsdfec_add_ldpc(struct xsdfec_dev *xsdfec, void __user *arg)
 				ldpc->no_final_parity, ldpc->max_schedule,
 				ldpc->code_id);
 	if (ret)
-		goto err_out;
+		return ret;
 
 	/* Write Reg 3 */
-	ret = xsdfec_reg3_write(xsdfec, ldpc->sc_off, ldpc->la_off,
-				ldpc->qc_off, ldpc->code_id);
+	return xsdfec_reg3_write(xsdfec, ldpc->sc_off, ldpc->la_off,
+				 ldpc->qc_off, ldpc->code_id);
+}
+
+static int xsdfec_add_ldpc(struct xsdfec_dev *xsdfec, void __user *arg)
+{
+	struct xsdfec_ldpc_params *ldpc;
+	int ret, n;
+
+	ldpc = memdup_user(arg, sizeof(*ldpc));
+	if (IS_ERR(ldpc))
+		return PTR_ERR(ldpc);
+
+	ret = xsdfec_ldpc_writable(xsdfec);
 	if (ret)
 		goto err_out;
 
+	mutex_lock(&xsdfec->ldpc_lock);
+	ret = xsdfec_ldpc_regs_write(xsdfec, ldpc);
+	if (ret)
+		goto err_unlock;
+
 	/* Write Shared Codes */
 	n = ldpc->nlayers / 4;
 	if (ldpc->nlayers % 4)
@@ -711,22 +832,129 @@ static int xsdfec_add_ldpc(struct xsdfec_dev *xsdfec, void __user *arg)
 				 XSDFEC_LDPC_SC_TABLE_ADDR_BASE,
 				 XSDFEC_SC_TABLE_DEPTH);
 	if (ret < 0)
-		goto err_out;
+		goto err_unlock;
 
 	ret = xsdfec_table_write(xsdfec, 4 * ldpc->la_off, ldpc->la_table,
 				 ldpc->nlayers, XSDFEC_LDPC_LA_TABLE_ADDR_BASE,
 				 XSDFEC_LA_TABLE_DEPTH);
 	if (ret < 0)
-		goto err_out;
+		goto err_unlock;
 
 	ret = xsdfec_table_write(xsdfec, 4 * ldpc->qc_off, ldpc->qc_table,
 				 ldpc->nqc, XSDFEC_LDPC_QC_TABLE_ADDR_BASE,
 				 XSDFEC_QC_TABLE_DEPTH);
+err_unlock:
+	mutex_unlock(&xsdfec->ldpc_lock);
 err_out:
 	kfree(ldpc);
 	return ret;
 }
 
+static int xsdfec_load_ldpc_code(struct xsdfec_dev *xsdfec,
+				 const struct xsdfec_ldpc_code *code,
+				 const u32 *words, u32 num_words)
+{
+	struct xsdfec_ldpc_params ldpc = {
+		.n = code->n,
+		.k = code->k,
+		.psize = code->psize,
+		.nlayers = code->nlayers,
+		.nqc = code->nqc,
+		.nmqc = code->nmqc,
+		.nm = code->nm,
+		.norm_type = code->norm_type,
+		.no_packing = code->no_packing,
+		.special_qc = code->special_qc,
+		.no_final_parity = code->no_final_parity,
+		.max_schedule = code->max_schedule,
+		.sc_off = code->sc_off,
+		.la_off = code->la_off,
+		.qc_off = code->qc_off,
+		.code_id = code->code_id,
+	};
+	u32 n;
+	int ret;
+
+	n = ldpc.nlayers / 4;
+	if (ldpc.nlayers % 4)
+		n++;
+
+	/* All tables of the code have to be within the table words */
+	if (code->reserved || code->sc_idx > num_words ||
+	    n > num_words - code->sc_idx || code->la_idx > num_words ||
+	    ldpc.nlayers > num_words - code->la_idx ||
+	    code->qc_idx > num_words || ldpc.nqc > num_words - code->qc_idx)
+		return -EINVAL;
+
+	ret = xsdfec_ldpc_regs_write(xsdfec, &ldpc);
+	if (ret)
+		return ret;
+
+	ret = xsdfec_table_load(xsdfec, ldpc.sc_off, words + code->sc_idx, n,
+				XSDFEC_LDPC_SC_TABLE_ADDR_BASE,
+				XSDFEC_SC_TABLE_DEPTH);
+	if (ret)
+		return ret;
+
+	ret = xsdfec_table_load(xsdfec, 4 * ldpc.la_off, words + code->la_idx,
+				ldpc.nlayers, XSDFEC_LDPC_LA_TABLE_ADDR_BASE,
+				XSDFEC_LA_TABLE_DEPTH);
+	if (ret)
+		return ret;
+
+	return xsdfec_table_load(xsdfec, 4 * ldpc.qc_off, words + code->qc_idx,
+				 ldpc.nqc, XSDFEC_LDPC_QC_TABLE_ADDR_BASE,
+				 XSDFEC_QC_TABLE_DEPTH);
+}
+
+static int xsdfec_add_ldpc_table(struct xsdfec_dev *xsdfec, void __user *arg)
+{
+	struct xsdfec_ldpc_code *codes;
+	struct xsdfec_ldpc_table table;
+	u32 *words;
+	u32 i;
+	int ret;
+
+	if (copy_from_user(&table, arg, sizeof(table)))
+		return -EFAULT;
+
+	ret = xsdfec_ldpc_writable(xsdfec);
+	if (ret)
+		return ret;
+
+	if (!table.num_codes || table.num_codes > XSDFEC_LDPC_MAX_CODES ||
+	    table.num_words > XSDFEC_SHADOW_WORDS)
+		return -EINVAL;
+
+	codes = memdup_user(u64_to_user_ptr(table.codes),
+			    array_size(table.num_codes, sizeof(*codes)));
+	if (IS_ERR(codes))
+		return PTR_ERR(codes);
+
+	words = vmemdup_user(u64_to_user_ptr(table.words),
+			     array_size(table.num_words, sizeof(*words)));
+	if (IS_ERR(words)) {
+		ret = PTR_ERR(words);
+		goto err_codes;
+	}
+
+	mutex_lock(&xsdfec->ldpc_lock);
+	for (i = 0; i < table.num_codes; i++) {
+		ret = xsdfec_load_ldpc_code(xsdfec, &codes[i], words,
+					    table.num_words);
+		if (ret) {
+			dev_dbg(xsdfec->dev, "LDPC code %u of table invalid", i);
+			break;
+		}
+	}
+	mutex_unlock(&xsdfec->ldpc_lock);
+
+	kvfree(words);
+err_codes:
+	kfree(codes);
+	return ret;
+}
+
 static int xsdfec_set_order(struct xsdfec_dev *xsdfec, void __user *arg)
 {
 	bool order_invalid;
@@ -901,12 +1129,31 @@ static int xsdfec_stop(struct xsdfec_dev *xsdfec)
 	return 0;
 }
 
+/*
+ * Publish the counts to the stats page, this must be called with
+ * error_data_lock held so that the seq count has a single writer.
+ */
+static void xsdfec_update_stats_page(struct xsdfec_dev *xsdfec)
+{
+	struct xsdfec_stats_page *page = page_address(xsdfec->stats_page);
+	u32 seq = page->seq;
+
+	WRITE_ONCE(page->seq, seq + 1);
+	smp_wmb();
+	page->stats.isr_err_count = xsdfec->isr_err_count;
+	page->stats.cecc_count = xsdfec->cecc_count;
+	page->stats.uecc_count = xsdfec->uecc_count;
+	smp_wmb();
+	WRITE_ONCE(page->seq, seq + 2);
+}
+
 static int xsdfec_clear_stats(struct xsdfec_dev *xsdfec)
 {
 	spin_lock_irqsave(&xsdfec->error_data_lock, xsdfec->flags);
 	xsdfec->isr_err_count = 0;
 	xsdfec->uecc_count = 0;
 	xsdfec->cecc_count = 0;
+	xsdfec_update_stats_page(xsdfec);
 	spin_unlock_irqrestore(&xsdfec->error_data_lock, xsdfec->flags);
 
 	return 0;
@@ -933,6 +1180,9 @@ static int xsdfec_get_stats(struct xsdfec_dev *xsdfec, void __user *arg)
 
 static int xsdfec_set_default_config(struct xsdfec_dev *xsdfec)
 {
+	/* The LDPC codes may have been lost by the reset */
+	xsdfec_ldpc_invalidate(xsdfec);
+
 	/* Ensure registers are aligned with core configuration */
 	xsdfec_regwrite(xsdfec, XSDFEC_FEC_CODE_ADDR, xsdfec->config.code);
 	xsdfec_cfg_axi_streams(xsdfec);
@@ -991,6 +1241,9 @@ static long xsdfec_dev_ioctl(struct file *fptr, unsigned int cmd,
 	case XSDFEC_ADD_LDPC_CODE_PARAMS:
 		rval = xsdfec_add_ldpc(xsdfec, arg);
 		break;
+	case XSDFEC_ADD_LDPC_CODE_TABLE:
+		rval = xsdfec_add_ldpc_table(xsdfec, arg);
+		break;
 	case XSDFEC_SET_ORDER:
 		rval = xsdfec_set_order(xsdfec, arg);
 		break;
@@ -1028,12 +1281,33 @@ static __poll_t xsdfec_poll(struct file *file, poll_table *wait)
 	return mask;
 }
 
+static int xsdfec_mmap(struct file *file, struct vm_area_struct *vma)
+{
+	struct xsdfec_dev *xsdfec;
+
+	xsdfec = container_of(file->private_data, struct xsdfec_dev, miscdev);
+
+	/* Only the stats page can be mapped, and only for reading */
+	if (vma->vm_pgoff || vma->vm_end - vma->vm_start != PAGE_SIZE)
+		return -EINVAL;
+
+	if (vma->vm_flags & VM_WRITE)
+		return -EPERM;
+
+	vma->vm_flags &= ~VM_MAYWRITE;
+	vma->vm_flags |= VM_DONTEXPAND | VM_DONTDUMP;
+
+	/* The mapping holds a reference on the page past the device removal */
+	return vm_insert_page(vma, vma->vm_start, xsdfec->stats_page);
+}
+
 static const struct file_operations xsdfec_fops = {
 	.owner = THIS_MODULE,
 	.open = xsdfec_dev_open,
 	.release = xsdfec_dev_release,
 	.unlocked_ioctl = xsdfec_dev_ioctl,
 	.poll = xsdfec_poll,
+	.mmap = xsdfec_mmap,
 	.compat_ioctl = compat_ptr_ioctl,
 };
 
@@ -1185,6 +1459,9 @@ static irqreturn_t xsdfec_irq_thread(int irq, void *dev_id)
 		xsdfec->state_updated = true;
 	}
 
+	if (uecc_count || cecc_count || isr_err_count)
+		xsdfec_update_stats_page(xsdfec);
+
 	spin_unlock_irqrestore(&xsdfec->error_data_lock, xsdfec->flags);
 	dev_dbg(xsdfec->dev, "state=%x, stats=%x", xsdfec->state_updated,
 		xsdfec->stats_updated);
@@ -1369,11 +1646,26 @@ static int xsdfec_probe(struct platform_device *pdev)
 
 	xsdfec->dev = &pdev->dev;
 	spin_lock_init(&xsdfec->error_data_lock);
+	mutex_init(&xsdfec->ldpc_lock);
+
+	xsdfec->ldpc_shadow = devm_kcalloc(&pdev->dev, XSDFEC_SHADOW_WORDS,
+					   sizeof(*xsdfec->ldpc_shadow),
+					   GFP_KERNEL);
+	xsdfec->ldpc_valid = devm_bitmap_zalloc(&pdev->dev, XSDFEC_SHADOW_WORDS,
+						GFP_KERNEL);
+	if (!xsdfec->ldpc_shadow || !xsdfec->ldpc_valid)
+		return -ENOMEM;
 
 	err = xsdfec_clk_init(pdev, &xsdfec->clks);
 	if (err)
 		return err;
 
+	xsdfec->stats_page = alloc_page(GFP_KERNEL | __GFP_ZERO);
+	if (!xsdfec->stats_page) {
+		err = -ENOMEM;
+		goto err_xsdfec_clks;
+	}
+
 	dev = xsdfec->dev;
 	res = platform_get_resource(pdev, IORESOURCE_MEM, 0);
 	xsdfec->regs = devm_ioremap_resource(dev, res);
@@ -1429,6 +1721,8 @@ static int xsdfec_probe(struct platform_device *pdev)
 err_xsdfec_ida:
 	ida_free(&dev_nrs, xsdfec->dev_id);
 err_xsdfec_dev:
+	put_page(xsdfec->stats_page);
+err_xsdfec_clks:
 	xsdfec_disable_all_clks(&xsdfec->clks);
 	return err;
 }
@@ -1441,6 +1735,7 @@ static int xsdfec_remove(struct platform_device *pdev)
 	misc_deregister(&xsdfec->miscdev);
 	ida_free(&dev_nrs, xsdfec->dev_id);
 	xsdfec_disable_all_clks(&xsdfec->clks);
+	put_page(xsdfec->stats_page);
 	return 0;
 }
 
@@ -12,9 +12,12 @@
  */
 
 #include <asm/xilinx_mb_manager.h>
+#include <linux/bitfield.h>
 #include <linux/module.h>
 #include <linux/of_device.h>
 
+#include "xilinx_tmr_trace.h"
+
 /* TMR Inject Register offsets */
 #define XTMR_INJECT_CR_OFFSET		0x0
 #define XTMR_INJECT_AIR_OFFSET		0x4
@@ -24,6 +27,7 @@
 
 /* Register Bitmasks/shifts */
 #define XTMR_INJECT_CR_CPUID_SHIFT	8
+#define XTMR_INJECT_CR_CPUID_MASK	GENMASK(9, 8)
 #define XTMR_INJECT_CR_IE_SHIFT		10
 #define XTMR_INJECT_IIR_ADDR_MASK	GENMASK(31, 16)
 
@@ -59,6 +63,7 @@ static ssize_t inject_err_store(struct device *dev,
 				struct device_attribute *attr, const char *buf,
 				size_t size)
 {
+	struct xtmr_inject_dev *xtmr_inject = dev_get_drvdata(dev);
 	int ret;
 	long value;
 
@@ -69,6 +74,8 @@ static ssize_t inject_err_store(struct device *dev,
 	if (value > 1)
 		return -EINVAL;
 
+	trace_xtmr_inject_err(dev, FIELD_GET(XTMR_INJECT_CR_CPUID_MASK,
+					     xtmr_inject->cr_val));
 	xmb_inject_err();
 
 	return size;
@@ -12,13 +12,17 @@
  * its internal state provides soft error detection, correction and
  * recovery. Error detection feature is provided through sysfs
  * entries which allow the user to observer the TMR microblaze
- * status.
+ * status. Every recovery is also reported through the
+ * xilinx_tmr:xtmr_manager_recovery tracepoint.
  */
 
 #include <asm/xilinx_mb_manager.h>
 #include <linux/module.h>
 #include <linux/of_device.h>
 
+#define CREATE_TRACE_POINTS
+#include "xilinx_tmr_trace.h"
+
 /* TMR Manager Register offsets */
 #define XTMR_MANAGER_CR_OFFSET		0x0
 #define XTMR_MANAGER_FFR_OFFSET		0x4
@@ -86,6 +90,17 @@ static void xtmr_manager_unblock_break(struct xtmr_manager_dev *xtmr_manager)
 static void xmb_manager_reset_handler(void *priv)
 {
 	struct xtmr_manager_dev *xtmr_manager = (struct xtmr_manager_dev *)priv;
+
+	/*
+	 * The break callback runs with the MMU off and can only count,
+	 * report the event here once the processors are back in sync.
+	 */
+	if (trace_xtmr_manager_recovery_enabled())
+		trace_xtmr_manager_recovery(xtmr_manager->dev,
+					    xtmr_manager_read(xtmr_manager,
+							      XTMR_MANAGER_FFR_OFFSET),
+					    xtmr_manager->err_cnt);
+
 	/*
 	 * Clear the FFR Register contents as a part of recovery process.
 	 */
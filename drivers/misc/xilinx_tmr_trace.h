@@ -0,0 +1,66 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/*
+ * Xilinx TMR Subsystem trace support
+ *
+ * Copyright (C) 2023 Xilinx, Inc.
+ */
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM xilinx_tmr
+
+#if !defined(_XILINX_TMR_TRACE_H) || defined(TRACE_HEADER_MULTI_READ)
+#define _XILINX_TMR_TRACE_H
+
+#include <linux/device.h>
+#include <linux/tracepoint.h>
+
+TRACE_EVENT(xtmr_manager_recovery,
+	TP_PROTO(struct device *dev, u32 ffr, u32 err_cnt),
+
+	TP_ARGS(dev, ffr, err_cnt),
+
+	TP_STRUCT__entry(
+		__string(dev, dev_name(dev))
+		__field(u32, ffr)
+		__field(u32, err_cnt)
+	),
+
+	TP_fast_assign(
+		__assign_str(dev, dev_name(dev));
+		__entry->ffr = ffr;
+		__entry->err_cnt = err_cnt;
+	),
+
+	TP_printk("%s: ffr=0x%x %s err_cnt=%u",
+		  __get_str(dev), __entry->ffr,
+		  __print_flags(__entry->ffr & 0x7, "|",
+				{ BIT(0), "LM12" },
+				{ BIT(1), "LM13" },
+				{ BIT(2), "LM23" }),
+		  __entry->err_cnt)
+);
+
+TRACE_EVENT(xtmr_inject_err,
+	TP_PROTO(struct device *dev, u32 cpuid),
+
+	TP_ARGS(dev, cpuid),
+
+	TP_STRUCT__entry(
+		__string(dev, dev_name(dev))
+		__field(u32, cpuid)
+	),
+
+	TP_fast_assign(
+		__assign_str(dev, dev_name(dev));
+		__entry->cpuid = cpuid;
+	),
+
+	TP_printk("%s: cpuid=%u", __get_str(dev), __entry->cpuid)
+);
+#endif /* _XILINX_TMR_TRACE_H */
+
+/* This part must be outside protection */
+#undef TRACE_INCLUDE_PATH
+#undef TRACE_INCLUDE_FILE
+#define TRACE_INCLUDE_PATH .
+#define TRACE_INCLUDE_FILE xilinx_tmr_trace
+#include <trace/define_trace.h>
@@ -16,13 +16,19 @@
 #include <linux/of_reserved_mem.h>
 #include <linux/miscdevice.h>
 #include <linux/interrupt.h>
+#include <linux/dma-buf.h>
 #include <linux/io-64-nonatomic-lo-hi.h>
 #include <linux/iopoll.h>
+#include <linux/io_uring.h>
 #include <linux/clk.h>
 #include <linux/dma-mapping.h>
 #include <linux/nospec.h>
 #include <linux/slab.h>
 #include <linux/iommu.h>
+#include <linux/poll.h>
+#include <linux/spinlock.h>
+#include <linux/timer.h>
+#include <linux/wait.h>
 #ifdef CONFIG_DEBUG_FS
 #include <linux/debugfs.h>
 #endif
@@ -53,15 +59,22 @@ static bool force_contig;
 module_param(force_contig, bool, 0444);
 MODULE_PARM_DESC(force_contig, "buffer is forced to be contiguous, default 0");
 
+struct xdpu_dev;
+struct xdpu_job;
+
 /**
  * struct cu - Computer Unit (cu) structure
- * @mutex: protects from simultaneous access
- * @done: completion of cu
+ * @mutex: protects from simultaneous access in polling mode
+ * @xdpu: pointer to dpu structure
+ * @job: job running on the cu, NULL if the cu is idle
+ * @timer: fires if the running job doesn't complete in time
  * @irq: indicates cu IRQ number
  */
 struct cu {
 	struct mutex	mutex; /* protects from simultaneous accesses */
-	struct completion	done;
+	struct xdpu_dev	*xdpu;
+	struct xdpu_job	*job;
+	struct timer_list	timer;
 	int	irq;
 };
 
@@ -77,6 +90,9 @@ struct cu {
  * @mutex: protect client
  * @root: debugfs dentry
  * @client_list: indicates how many dpu clients link to xdpu
+ * @sched_lock: protects the job queue, the cu jobs and the client jobs
+ * @queue: jobs waiting for an idle cu
+ * @idle: bitmap of the idle cus
  * @dpu_cnt: indicates how many dpu core/cu enabled in IP, up to 4
  * @sfm_cnt: indicates softmax core enabled or not
  */
@@ -93,6 +109,9 @@ struct xdpu_dev {
 	struct dentry	*root;
 	struct list_head	client_list;
 #endif
+	spinlock_t	sched_lock; /* guards queue, cu jobs and client jobs */
+	struct list_head	queue;
+	unsigned long	idle;
 	u8	dpu_cnt;
 	u8	sfm_cnt;
 };
@@ -102,11 +121,43 @@ struct xdpu_dev {
  * @dev: pointer to dpu device struct
  * @head: indicates dma memory pool list head
  * @node: client node
+ * @jobs: asynchronous jobs which haven't been collected yet
+ * @wq: wait queue for completed jobs
+ * @seqno: fence of the last submitted job
+ * @nr_jobs: number of jobs in @jobs
+ * @nr_done: number of completed jobs in @jobs
  */
 struct xdpu_client {
 	struct xdpu_dev	*dev;
 	struct list_head	head;
 	struct list_head	node;
+	struct list_head	jobs;
+	wait_queue_head_t	wq;
+	u64	seqno;
+	u32	nr_jobs;
+	u32	nr_done;
+};
+
+/**
+ * struct xdpu_job - DPU job
+ * @node: node in the job queue, empty once dispatched to a cu
+ * @cnode: node in the client jobs, empty for synchronous jobs
+ * @client: submitting client, NULL if the client has been closed
+ * @status: 0 if the job completed; otherwise -errno
+ * @done: the job has completed
+ * @ioucmd: io_uring command completed by the job, NULL for ioctl jobs
+ * @uarg: user argument of @ioucmd, the dpu run results are copied to it
+ * @desc: job descriptor, the dpu run results are updated in place
+ */
+struct xdpu_job {
+	struct list_head	node;
+	struct list_head	cnode;
+	struct xdpu_client	*client;
+	int	status;
+	bool	done;
+	struct io_uring_cmd	*ioucmd;
+	void __user	*uarg;
+	struct ioc_job_t	desc;
 };
 
 /**
@@ -117,6 +168,9 @@ struct xdpu_client {
  * @phy_addr: physical address of the blocks memory
  * @size: total size of the block in bytes
  * @attrs: dma buffer attributes
+ * @cached: the block is cacheable and needs explicit syncs
+ * @attach: dma-buf attachment of an imported block
+ * @sgt: mapped scatter list of an imported block
  */
 struct dpu_buffer_block {
 	struct list_head	head;
@@ -125,6 +179,9 @@ struct dpu_buffer_block {
 	phys_addr_t	phy_addr;
 	size_t	size;
 	unsigned long	attrs;
+	bool	cached;
+	struct dma_buf_attachment	*attach;
+	struct sg_table	*sgt;
 };
 
 #ifdef CONFIG_DEBUG_FS
@@ -261,17 +318,12 @@ static void xlnx_sfm_int_clear(struct xdpu_dev *xdpu)
 }
 
 /**
- * xlnx_dpu_softmax - softmax calculation acceleration using softmax IP
+ * xlnx_sfm_start - program and start the softmax IP
  * @xdpu:	dpu structure
  * @p :	softmax pmeter structure
- *
- * Return:	0 if successful; otherwise -errno
  */
-static int xlnx_dpu_softmax(struct xdpu_dev *xdpu, struct ioc_softmax_t *p)
+static void xlnx_sfm_start(struct xdpu_dev *xdpu, struct ioc_softmax_t *p)
 {
-	int ret = -ETIMEDOUT;
-	int val;
-
 	iowrite32(p->width, xdpu->regs + DPU_SFM_CMD_XLEN);
 	iowrite32(p->height, xdpu->regs + DPU_SFM_CMD_YLEN);
 
@@ -288,23 +340,34 @@ static int xlnx_dpu_softmax(struct xdpu_dev *xdpu, struct ioc_softmax_t *p)
 
 	iowrite32(1, xdpu->regs + DPU_SFM_START);
 	iowrite32(0, xdpu->regs + DPU_SFM_START);
+}
 
-	if (!force_poll) {
-		if (!wait_for_completion_timeout(&xdpu->cu[xdpu->dpu_cnt].done,
-						 TIMEOUT))
-			goto err_out;
-	} else {
-		ret = readx_poll_timeout(ioread32,
-					 xdpu->regs + DPU_SFM_INT_DONE,
-					 val,
-					 val & 0x1,
-					 POLL_PERIOD_US,
-					 TIMEOUT_US);
-		if (ret < 0)
-			goto err_out;
+/**
+ * xlnx_dpu_softmax - softmax calculation acceleration using softmax IP
+ * @xdpu:	dpu structure
+ * @p :	softmax pmeter structure
+ *
+ * Polling mode only, in interrupt mode softmax goes through the job queue.
+ *
+ * Return:	0 if successful; otherwise -errno
+ */
+static int xlnx_dpu_softmax(struct xdpu_dev *xdpu, struct ioc_softmax_t *p)
+{
+	int ret;
+	int val;
 
-		xlnx_sfm_int_clear(xdpu);
-	}
+	xlnx_sfm_start(xdpu, p);
+
+	ret = readx_poll_timeout(ioread32,
+				 xdpu->regs + DPU_SFM_INT_DONE,
+				 val,
+				 val & 0x1,
+				 POLL_PERIOD_US,
+				 TIMEOUT_US);
+	if (ret < 0)
+		goto err_out;
+
+	xlnx_sfm_int_clear(xdpu);
 
 	dev_dbg(xdpu->dev, "%s: PID=%d CPU=%d\n",
 		__func__, current->pid, raw_smp_processor_id());
@@ -319,18 +382,14 @@ static int xlnx_dpu_softmax(struct xdpu_dev *xdpu, struct ioc_softmax_t *p)
 }
 
 /**
- * xlnx_dpu_run - run dpu
+ * xlnx_dpu_start - program and start a dpu cu
  * @xdpu:	dpu structure
  * @p:	dpu run struct, contains the necessary address info
  * @id:	indicates which cu is running
- *
- * Return:	0 if successful; otherwise -errno
  */
-static inline int xlnx_dpu_run(struct xdpu_dev *xdpu,
-			       struct ioc_kernel_run_t *p, int id)
+static void xlnx_dpu_start(struct xdpu_dev *xdpu,
+			   struct ioc_kernel_run_t *p, int id)
 {
-	int val, ret;
-
 	iowrite32(p->addr_code >> DPU_INSTR_OFFSET,
 		  xdpu->regs + DPU_INSADDR(id));
 
@@ -358,24 +417,17 @@ static inline int xlnx_dpu_run(struct xdpu_dev *xdpu,
 	iowrite32(1, xdpu->regs + DPU_IPSTART(id));
 
 	p->time_start = ktime_get();
+}
 
-	if (!force_poll) {
-		if (!wait_for_completion_timeout(&xdpu->cu[id].done,
-						 TIMEOUT))
-			goto err_out;
-	} else {
-		ret = readx_poll_timeout(ioread32,
-					 xdpu->regs + DPU_INT_RAW,
-					 val,
-					 val & BIT(id),
-					 POLL_PERIOD_US,
-					 TIMEOUT_US);
-		if (ret < 0)
-			goto err_out;
-
-		xlnx_dpu_int_clear(xdpu, id);
-	}
-
+/**
+ * xlnx_dpu_get_result - read back the counters of a finished dpu cu
+ * @xdpu:	dpu structure
+ * @p:	dpu run struct to be updated
+ * @id:	indicates which cu has finished
+ */
+static void xlnx_dpu_get_result(struct xdpu_dev *xdpu,
+				struct ioc_kernel_run_t *p, int id)
+{
 	p->time_end = ktime_get();
 	p->core_id = id;
 	p->pend_cnt = ioread32(xdpu->regs + DPU_P_END_C(id));
@@ -387,6 +439,36 @@ static inline int xlnx_dpu_run(struct xdpu_dev *xdpu,
 	p->sstart_cnt = ioread32(xdpu->regs + DPU_S_STA_C(id));
 	p->lstart_cnt = ioread32(xdpu->regs + DPU_L_STA_C(id));
 	p->counter = lo_hi_readq(xdpu->regs + DPU_CYCLE_L(id));
+}
+
+/**
+ * xlnx_dpu_run - run dpu
+ * @xdpu:	dpu structure
+ * @p:	dpu run struct, contains the necessary address info
+ * @id:	indicates which cu is running
+ *
+ * Polling mode only, in interrupt mode jobs go through the job queue.
+ *
+ * Return:	0 if successful; otherwise -errno
+ */
+static inline int xlnx_dpu_run(struct xdpu_dev *xdpu,
+			       struct ioc_kernel_run_t *p, int id)
+{
+	int val, ret;
+
+	xlnx_dpu_start(xdpu, p, id);
+
+	ret = readx_poll_timeout(ioread32,
+				 xdpu->regs + DPU_INT_RAW,
+				 val,
+				 val & BIT(id),
+				 POLL_PERIOD_US,
+				 TIMEOUT_US);
+	if (ret < 0)
+		goto err_out;
+
+	xlnx_dpu_int_clear(xdpu, id);
+	xlnx_dpu_get_result(xdpu, p, id);
 
 	dev_dbg(xdpu->dev,
 		"%s: PID=%d DPU=%d CPU=%d TIME=%lldus complete!\n",
@@ -402,6 +484,362 @@ static inline int xlnx_dpu_run(struct xdpu_dev *xdpu,
 	return -ETIMEDOUT;
 }
 
+/**
+ * xlnx_dpu_pick_cu - pick an idle cu for a job
+ * @xdpu:	dpu structure
+ * @job:	job to be dispatched
+ *
+ * Called with sched_lock held.
+ *
+ * Return:	cu id if successful; otherwise -EBUSY
+ */
+static int xlnx_dpu_pick_cu(struct xdpu_dev *xdpu, struct xdpu_job *job)
+{
+	int id;
+
+	if (job->desc.type == DPU_JOB_SOFTMAX)
+		id = xdpu->dpu_cnt;
+	else if (job->desc.run.core_id == DPU_CORE_ANY)
+		id = find_first_bit(&xdpu->idle, xdpu->dpu_cnt);
+	else
+		id = job->desc.run.core_id;
+
+	if (id >= xdpu->dpu_cnt + xdpu->sfm_cnt || !test_bit(id, &xdpu->idle))
+		return -EBUSY;
+
+	return id;
+}
+
+/**
+ * xlnx_dpu_schedule - dispatch queued jobs to idle cus
+ * @xdpu:	dpu structure
+ *
+ * Jobs are dispatched in submission order, a job bound to a busy cu doesn't
+ * hold back the jobs queued behind it. Called with sched_lock held.
+ */
+static void xlnx_dpu_schedule(struct xdpu_dev *xdpu)
+{
+	struct xdpu_job *job, *n;
+	int id;
+
+	list_for_each_entry_safe(job, n, &xdpu->queue, node) {
+		if (!xdpu->idle)
+			break;
+
+		id = xlnx_dpu_pick_cu(xdpu, job);
+		if (id < 0)
+			continue;
+
+		list_del_init(&job->node);
+		__clear_bit(id, &xdpu->idle);
+		xdpu->cu[id].job = job;
+
+		if (job->desc.type == DPU_JOB_SOFTMAX)
+			xlnx_sfm_start(xdpu, &job->desc.softmax);
+		else
+			xlnx_dpu_start(xdpu, &job->desc.run, id);
+
+		mod_timer(&xdpu->cu[id].timer, jiffies + TIMEOUT);
+	}
+}
+
+/**
+ * xlnx_dpu_uring_cmd_done - post the completion of an io_uring job
+ * @ioucmd:	io_uring command of the job
+ *
+ * Runs in the context of the submitting task, so the results can be copied
+ * to the user argument.
+ */
+static void xlnx_dpu_uring_cmd_done(struct io_uring_cmd *ioucmd)
+{
+	struct xdpu_job *job = *(struct xdpu_job **)ioucmd->pdu;
+	int ret = job->status;
+
+	if (job->desc.type == DPU_JOB_RUN &&
+	    copy_to_user(job->uarg, &job->desc.run, sizeof(job->desc.run)) &&
+	    !ret)
+		ret = -EFAULT;
+
+	kfree(job);
+	io_uring_cmd_done(ioucmd, ret, 0);
+}
+
+/**
+ * xlnx_dpu_complete - retire the running job of a cu and refill the cu
+ * @xdpu:	dpu structure
+ * @id:	indicates which cu has finished
+ * @status:	0 if the job completed; otherwise -errno
+ *
+ * Called with sched_lock held.
+ */
+static void xlnx_dpu_complete(struct xdpu_dev *xdpu, int id, int status)
+{
+	struct cu *cu = &xdpu->cu[id];
+	struct xdpu_job *job = cu->job;
+	struct xdpu_client *client = job->client;
+
+	del_timer(&cu->timer);
+	cu->job = NULL;
+	__set_bit(id, &xdpu->idle);
+
+	if (job->desc.type == DPU_JOB_RUN)
+		xlnx_dpu_get_result(xdpu, &job->desc.run, id);
+
+	dev_dbg(xdpu->dev, "%s: CU=%d status=%d\n", __func__, id, status);
+
+	if (!client) {
+		/* the client has been closed, nobody collects the job */
+		kfree(job);
+	} else if (job->ioucmd) {
+		job->status = status;
+		io_uring_cmd_complete_in_task(job->ioucmd,
+					      xlnx_dpu_uring_cmd_done);
+	} else {
+		job->status = status;
+		if (!list_empty(&job->cnode))
+			client->nr_done++;
+		/* pairs with the acquire in the synchronous waiter */
+		smp_store_release(&job->done, true);
+		wake_up(&client->wq);
+	}
+
+	xlnx_dpu_schedule(xdpu);
+}
+
+/**
+ * xlnx_dpu_timeout - fail the running job of a cu which didn't complete
+ * @t:	timer of the cu
+ */
+static void xlnx_dpu_timeout(struct timer_list *t)
+{
+	struct cu *cu = from_timer(cu, t, timer);
+	struct xdpu_dev *xdpu = cu->xdpu;
+	int id = cu - xdpu->cu;
+	unsigned long flags;
+
+	spin_lock_irqsave(&xdpu->sched_lock, flags);
+	/* the job has completed, or the timer is re-armed for the next job */
+	if (cu->job && !timer_pending(&cu->timer)) {
+		dev_warn(xdpu->dev, "cu[%d] timeout", id);
+		xlnx_dpu_dump_regs(xdpu);
+		if (id == xdpu->dpu_cnt)
+			xlnx_sfm_int_clear(xdpu);
+		else
+			xlnx_dpu_int_clear(xdpu, id);
+		xlnx_dpu_complete(xdpu, id, -ETIMEDOUT);
+	}
+	spin_unlock_irqrestore(&xdpu->sched_lock, flags);
+}
+
+/**
+ * xlnx_dpu_job_alloc - allocate a job from a job descriptor
+ * @xdpu:	dpu structure
+ * @desc:	job descriptor
+ *
+ * Return:	job if successful; otherwise ERR_PTR(-errno)
+ */
+static struct xdpu_job *xlnx_dpu_job_alloc(struct xdpu_dev *xdpu,
+					   const struct ioc_job_t *desc)
+{
+	struct xdpu_job *job;
+
+	switch (desc->type) {
+	case DPU_JOB_RUN:
+		if (desc->run.core_id != DPU_CORE_ANY &&
+		    (desc->run.core_id < 0 ||
+		     desc->run.core_id >= xdpu->dpu_cnt))
+			return ERR_PTR(-EINVAL);
+		break;
+	case DPU_JOB_SOFTMAX:
+		if (!xdpu->sfm_cnt)
+			return ERR_PTR(-ENODEV);
+		break;
+	default:
+		return ERR_PTR(-EINVAL);
+	}
+
+	job = kzalloc(sizeof(*job), GFP_KERNEL);
+	if (!job)
+		return ERR_PTR(-ENOMEM);
+
+	INIT_LIST_HEAD(&job->node);
+	INIT_LIST_HEAD(&job->cnode);
+	job->desc = *desc;
+
+	return job;
+}
+
+/**
+ * xlnx_dpu_submit - queue a job and kick the scheduler
+ * @client:	dpu client
+ * @job:	job to be queued
+ * @seqno:	returns the fence of an asynchronous job, which is collected
+ *		with DPUIOC_WAIT; NULL for a synchronous job
+ *
+ * Return:	0 if successful; otherwise -errno
+ */
+static int xlnx_dpu_submit(struct xdpu_client *client, struct xdpu_job *job,
+			   u64 *seqno)
+{
+	struct xdpu_dev *xdpu = client->dev;
+	unsigned long flags;
+
+	spin_lock_irqsave(&xdpu->sched_lock, flags);
+	if (seqno) {
+		if (client->nr_jobs >= DPU_MAX_JOBS) {
+			spin_unlock_irqrestore(&xdpu->sched_lock, flags);
+			return -EBUSY;
+		}
+		list_add_tail(&job->cnode, &client->jobs);
+		client->nr_jobs++;
+	}
+	job->client = client;
+	job->desc.seqno = ++client->seqno;
+	if (seqno)
+		*seqno = job->desc.seqno;
+	list_add_tail(&job->node, &xdpu->queue);
+	xlnx_dpu_schedule(xdpu);
+	spin_unlock_irqrestore(&xdpu->sched_lock, flags);
+
+	return 0;
+}
+
+/**
+ * xlnx_dpu_run_sync - run a job through the job queue and wait for it
+ * @client:	dpu client
+ * @desc:	job descriptor, updated with the job results
+ *
+ * The wait is bounded by the cu timer once the job is dispatched.
+ *
+ * Return:	0 if successful; otherwise -errno
+ */
+static int xlnx_dpu_run_sync(struct xdpu_client *client,
+			     struct ioc_job_t *desc)
+{
+	struct xdpu_job *job;
+	int ret;
+
+	job = xlnx_dpu_job_alloc(client->dev, desc);
+	if (IS_ERR(job))
+		return PTR_ERR(job);
+
+	xlnx_dpu_submit(client, job, NULL);
+	wait_event(client->wq, smp_load_acquire(&job->done));
+
+	*desc = job->desc;
+	ret = job->status;
+	kfree(job);
+
+	return ret;
+}
+
+/**
+ * xlnx_dpu_submit_job - submit an asynchronous job
+ * @client:	dpu client
+ * @req:	ioc_job_t struct, the fence of the job is returned in seqno
+ *
+ * Return:	0 if successful; otherwise -errno
+ */
+static long xlnx_dpu_submit_job(struct xdpu_client *client,
+				struct ioc_job_t __user *req)
+{
+	struct xdpu_job *job;
+	struct ioc_job_t desc;
+	u64 seqno;
+	int ret;
+
+	if (copy_from_user(&desc, req, sizeof(desc)))
+		return -EFAULT;
+
+	job = xlnx_dpu_job_alloc(client->dev, &desc);
+	if (IS_ERR(job))
+		return PTR_ERR(job);
+
+	/* the job may be collected by another thread once it is queued */
+	ret = xlnx_dpu_submit(client, job, &seqno);
+	if (ret) {
+		kfree(job);
+		return ret;
+	}
+
+	return put_user(seqno, &req->seqno);
+}
+
+/**
+ * xlnx_dpu_reap - collect a completed asynchronous job
+ * @client:	dpu client
+ * @seqno:	fence of the job, 0 for any job
+ *
+ * Return:	the job if it has completed, NULL if it is still pending;
+ *		otherwise ERR_PTR(-ENOENT) if there is no such job
+ */
+static struct xdpu_job *xlnx_dpu_reap(struct xdpu_client *client, u64 seqno)
+{
+	struct xdpu_dev *xdpu = client->dev;
+	struct xdpu_job *job, *ret = ERR_PTR(-ENOENT);
+	unsigned long flags;
+
+	spin_lock_irqsave(&xdpu->sched_lock, flags);
+	list_for_each_entry(job, &client->jobs, cnode) {
+		if (seqno && job->desc.seqno != seqno)
+			continue;
+
+		if (job->done) {
+			list_del_init(&job->cnode);
+			client->nr_jobs--;
+			client->nr_done--;
+			ret = job;
+			break;
+		}
+
+		ret = NULL;
+		if (seqno)
+			break;
+	}
+	spin_unlock_irqrestore(&xdpu->sched_lock, flags);
+
+	return ret;
+}
+
+/**
+ * xlnx_dpu_wait - wait for an asynchronous job
+ * @client:	dpu client
+ * @req:	ioc_wait_t struct, contains the request info
+ *
+ * Return:	0 if successful; otherwise -errno
+ */
+static long xlnx_dpu_wait(struct xdpu_client *client,
+			  struct ioc_wait_t __user *req)
+{
+	struct xdpu_job *job = NULL;
+	struct ioc_wait_t w;
+	long ret;
+
+	if (copy_from_user(&w, req, sizeof(w)))
+		return -EFAULT;
+
+	ret = wait_event_interruptible_timeout(client->wq,
+					       (job = xlnx_dpu_reap(client,
+								    w.seqno)),
+					       msecs_to_jiffies(w.timeout_ms));
+	if (ret < 0)
+		return ret;
+	if (!job)
+		return -ETIMEDOUT;
+	if (IS_ERR(job))
+		return PTR_ERR(job);
+
+	w.seqno = job->desc.seqno;
+	w.status = job->status;
+	w.job = job->desc;
+	kfree(job);
+
+	if (copy_to_user(req, &w, sizeof(w)))
+		return -EFAULT;
+
+	return 0;
+}
+
 static inline phys_addr_t get_pa(void *addr)
 {
 	if (likely(is_vmalloc_addr(addr)))
@@ -410,15 +848,44 @@ static inline phys_addr_t get_pa(void *addr)
 	return __pa(addr);
 }
 
+/**
+ * xlnx_dpu_free_block - free the memory of a buffer block
+ * @xdpu:	dpu structure
+ * @h:	buffer block, removed from its list and freed
+ *
+ * Called with xdpu->mutex held.
+ */
+static void xlnx_dpu_free_block(struct xdpu_dev *xdpu,
+				struct dpu_buffer_block *h)
+{
+	if (h->attach) {
+		struct dma_buf *dmabuf = h->attach->dmabuf;
+
+		dma_buf_unmap_attachment(h->attach, h->sgt, DMA_BIDIRECTIONAL);
+		dma_buf_detach(dmabuf, h->attach);
+		dma_buf_put(dmabuf);
+	} else if (h->cached) {
+		dma_free_noncoherent(xdpu->dev, h->size, h->cpu_addr,
+				     h->dma_addr, DMA_BIDIRECTIONAL);
+	} else {
+		dma_free_attrs(xdpu->dev, h->size, h->cpu_addr, h->dma_addr,
+			       h->attrs);
+	}
+	list_del(&h->head);
+	kfree(h);
+}
+
 /**
  * xlnx_dpu_alloc_bo - alloc contiguous physical memory for dpu
  * @client:	dpu client
  * @req:	dpcma_req_alloc struct, contains the request info
+ * @cached:	allocate cacheable memory, the CPU accesses have to be
+ *		bracketed with DPUIOC_SYNC_BO of the accessed range
  *
  * Return:	0 if successful; otherwise -errno
  */
 static long xlnx_dpu_alloc_bo(struct xdpu_client *client,
-			      struct dpcma_req_alloc __user *req)
+			      struct dpcma_req_alloc __user *req, bool cached)
 {
 	struct dpu_buffer_block *pb;
 	size_t size;
@@ -442,8 +909,18 @@ static long xlnx_dpu_alloc_bo(struct xdpu_client *client,
 	if (iommu_present(xdpu->dev->bus) && force_contig)
 		pb->attrs = DMA_ATTR_FORCE_CONTIGUOUS;
 
-	pb->cpu_addr = dma_alloc_attrs(xdpu->dev, pb->size, &pb->dma_addr,
-				       GFP_KERNEL | __GFP_ZERO, pb->attrs);
+	/* physically contiguous pages, the memory is zeroed by the allocator */
+	pb->cached = cached;
+	if (cached)
+		pb->cpu_addr = dma_alloc_noncoherent(xdpu->dev, pb->size,
+						     &pb->dma_addr,
+						     DMA_BIDIRECTIONAL,
+						     GFP_KERNEL);
+	else
+		pb->cpu_addr = dma_alloc_attrs(xdpu->dev, pb->size,
+					       &pb->dma_addr,
+					       GFP_KERNEL | __GFP_ZERO,
+					       pb->attrs);
 	if (!pb->cpu_addr)
 		goto err_pb;
 
@@ -461,13 +938,105 @@ static long xlnx_dpu_alloc_bo(struct xdpu_client *client,
 
 	return 0;
 err_out:
-	dma_free_attrs(xdpu->dev, pb->size, pb->cpu_addr, pb->dma_addr,
-		       pb->attrs);
+	if (cached)
+		dma_free_noncoherent(xdpu->dev, pb->size, pb->cpu_addr,
+				     pb->dma_addr, DMA_BIDIRECTIONAL);
+	else
+		dma_free_attrs(xdpu->dev, pb->size, pb->cpu_addr,
+			       pb->dma_addr, pb->attrs);
 err_pb:
 	kfree(pb);
 	return -EFAULT;
 }
 
+/**
+ * xlnx_dpu_import_bo - import a dma-buf as a dpu buffer block
+ * @client:	dpu client
+ * @req:	dpcma_req_import struct, contains the request info
+ *
+ * The dpu takes a single base address per buffer, so the dma-buf has to be
+ * contiguous in the dpu address space. The CPU accesses the buffer through
+ * the exporter, the block can't be mapped from the dpu device.
+ *
+ * Return:	0 if successful; otherwise -errno
+ */
+static long xlnx_dpu_import_bo(struct xdpu_client *client,
+			       struct dpcma_req_import __user *req)
+{
+	struct xdpu_dev *xdpu = client->dev;
+	struct dpu_buffer_block *pb;
+	struct dma_buf *dmabuf;
+	struct scatterlist *sg;
+	dma_addr_t next;
+	int fd, i;
+	long ret;
+
+	if (get_user(fd, &req->fd))
+		return -EFAULT;
+
+	pb = kzalloc(sizeof(*pb), GFP_KERNEL);
+	if (!pb)
+		return -ENOMEM;
+
+	dmabuf = dma_buf_get(fd);
+	if (IS_ERR(dmabuf)) {
+		ret = PTR_ERR(dmabuf);
+		goto err_pb;
+	}
+
+	pb->attach = dma_buf_attach(dmabuf, xdpu->dev);
+	if (IS_ERR(pb->attach)) {
+		ret = PTR_ERR(pb->attach);
+		goto err_put;
+	}
+
+	pb->sgt = dma_buf_map_attachment(pb->attach, DMA_BIDIRECTIONAL);
+	if (IS_ERR(pb->sgt)) {
+		ret = PTR_ERR(pb->sgt);
+		goto err_detach;
+	}
+
+	pb->dma_addr = sg_dma_address(pb->sgt->sgl);
+	next = pb->dma_addr;
+	for_each_sgtable_dma_sg(pb->sgt, sg, i) {
+		if (sg_dma_address(sg) != next) {
+			dev_err(xdpu->dev, "dma-buf %d is not contiguous\n", fd);
+			ret = -EINVAL;
+			goto err_unmap;
+		}
+		next += sg_dma_len(sg);
+	}
+	pb->size = next - pb->dma_addr;
+	pb->cached = true;
+
+	if (!(iommu_present(xdpu->dev->bus)))
+		pb->phy_addr = pb->dma_addr;
+	else
+		pb->phy_addr = sg_phys(pb->sgt->sgl);
+
+	if (put_user(pb->dma_addr, &req->dma_addr) ||
+	    put_user(pb->size, &req->capacity)) {
+		ret = -EFAULT;
+		goto err_unmap;
+	}
+
+	mutex_lock(&xdpu->mutex);
+	list_add(&pb->head, &client->head);
+	mutex_unlock(&xdpu->mutex);
+
+	return 0;
+
+err_unmap:
+	dma_buf_unmap_attachment(pb->attach, pb->sgt, DMA_BIDIRECTIONAL);
+err_detach:
+	dma_buf_detach(dmabuf, pb->attach);
+err_put:
+	dma_buf_put(dmabuf);
+err_pb:
+	kfree(pb);
+	return ret;
+}
+
 /**
  * xlnx_dpu_free_bo - free contiguous physical memory allocated
  * @client:	dpu client
@@ -487,12 +1056,8 @@ static long xlnx_dpu_free_bo(struct xdpu_client *client,
 
 	mutex_lock(&xdpu->mutex);
 	list_for_each_entry_safe(h, n, &client->head, head) {
-		if (in_range(dma_addr, h->dma_addr, h->size)) {
-			dma_free_attrs(xdpu->dev, h->size, h->cpu_addr,
-				       h->dma_addr, h->attrs);
-			list_del(&h->head);
-			kfree(h);
-		}
+		if (in_range(dma_addr, h->dma_addr, h->size))
+			xlnx_dpu_free_block(xdpu, h);
 	}
 	mutex_unlock(&xdpu->mutex);
 
@@ -504,6 +1069,10 @@ static long xlnx_dpu_free_bo(struct xdpu_client *client,
  * @client:	dpu client
  * @req:	dpcma_req_sync struct, contains the request info
  *
+ * Only the range [dma_addr, dma_addr + size) is synced, clamped to the end
+ * of the block. Imported blocks are synced as a whole, coherent blocks don't
+ * need any sync.
+ *
  * Return:	0 if successful; otherwise -errno
  */
 static inline long xlnx_dpu_sync_bo(struct xdpu_client *client,
@@ -527,16 +1096,35 @@ static inline long xlnx_dpu_sync_bo(struct xdpu_client *client,
 	mutex_lock(&xdpu->mutex);
 	list_for_each_entry_safe(h, n, &client->head, head) {
 		if (in_range(dma_addr, h->dma_addr, h->size)) {
+			unsigned long off = dma_addr - h->dma_addr;
+
+			if (!h->cached)
+				break;
+
+			/* the pages may be scattered behind the IOMMU */
+			if (h->attach) {
+				if (dir == DPU_TO_CPU)
+					dma_sync_sgtable_for_cpu(xdpu->dev,
+								 h->sgt,
+								 DMA_FROM_DEVICE);
+				else
+					dma_sync_sgtable_for_device(xdpu->dev,
+								    h->sgt,
+								    DMA_TO_DEVICE);
+				break;
+			}
+
+			size = min(size, h->size - off);
 			if (dir == DPU_TO_CPU)
-				dma_sync_single_for_cpu(xdpu->dev,
-							h->phy_addr,
-							size,
-							DMA_FROM_DEVICE);
+				dma_sync_single_range_for_cpu(xdpu->dev,
+							      h->dma_addr,
+							      off, size,
+							      DMA_FROM_DEVICE);
 			else
-				dma_sync_single_for_device(xdpu->dev,
-							   h->phy_addr,
-							   size,
-							   DMA_TO_DEVICE);
+				dma_sync_single_range_for_device(xdpu->dev,
+								 h->dma_addr,
+								 off, size,
+								 DMA_TO_DEVICE);
 			break;
 		}
 	}
@@ -583,21 +1171,32 @@ static long xlnx_dpu_ioctl(struct file *file, unsigned int cmd,
 		}
 
 		id = t.core_id;
-		if (id >= xdpu->dpu_cnt)
-			return -EINVAL;
 
 		dev_dbg(xdpu->dev,
 			"%s: PID=%d DPU=%d CPU=%d Comm=%.20s waiting",
 			__func__, current->pid, id, raw_smp_processor_id(),
 			current->comm);
 
-		id = array_index_nospec(id, xdpu->dpu_cnt);
-		/* Allows one process to run the cu by using a mutex */
-		mutex_lock(&xdpu->cu[id].mutex);
+		if (!force_poll) {
+			struct ioc_job_t job = {
+				.type = DPU_JOB_RUN,
+				.run = t,
+			};
+
+			ret = xlnx_dpu_run_sync(client, &job);
+			t = job.run;
+		} else {
+			if (id < 0 || id >= xdpu->dpu_cnt)
+				return -EINVAL;
 
-		ret = xlnx_dpu_run(xdpu, &t, id);
+			id = array_index_nospec(id, xdpu->dpu_cnt);
+			/* Allows one process to run the cu by using a mutex */
+			mutex_lock(&xdpu->cu[id].mutex);
 
-		mutex_unlock(&xdpu->cu[id].mutex);
+			ret = xlnx_dpu_run(xdpu, &t, id);
+
+			mutex_unlock(&xdpu->cu[id].mutex);
+		}
 
 		if (copy_to_user(data, &t, sizeof(struct ioc_kernel_run_t)))
 			return -EINVAL;
@@ -606,7 +1205,15 @@ static long xlnx_dpu_ioctl(struct file *file, unsigned int cmd,
 	}
 	case DPUIOC_CREATE_BO:
 		return xlnx_dpu_alloc_bo(client,
-					 (struct dpcma_req_alloc __user *)arg);
+					 (struct dpcma_req_alloc __user *)arg,
+					 false);
+	case DPUIOC_CREATE_CACHED_BO:
+		return xlnx_dpu_alloc_bo(client,
+					 (struct dpcma_req_alloc __user *)arg,
+					 true);
+	case DPUIOC_IMPORT_BO:
+		return xlnx_dpu_import_bo(client,
+					  (struct dpcma_req_import __user *)arg);
 	case DPUIOC_FREE_BO:
 		return xlnx_dpu_free_bo(client,
 					(struct dpcma_req_free __user *)arg);
@@ -638,6 +1245,16 @@ static long xlnx_dpu_ioctl(struct file *file, unsigned int cmd,
 			return -EINVAL;
 		}
 
+		if (!force_poll) {
+			struct ioc_job_t job = {
+				.type = DPU_JOB_SOFTMAX,
+				.softmax = t,
+			};
+
+			ret = xlnx_dpu_run_sync(client, &job);
+			break;
+		}
+
 		mutex_lock(&xdpu->cu[xdpu->dpu_cnt].mutex);
 
 		ret = xlnx_dpu_softmax(xdpu, &t);
@@ -646,6 +1263,16 @@ static long xlnx_dpu_ioctl(struct file *file, unsigned int cmd,
 
 		break;
 	}
+	case DPUIOC_SUBMIT:
+		/* completions are reported by the cu interrupts */
+		if (force_poll)
+			return -EOPNOTSUPP;
+		return xlnx_dpu_submit_job(client,
+					   (struct ioc_job_t __user *)arg);
+	case DPUIOC_WAIT:
+		if (force_poll)
+			return -EOPNOTSUPP;
+		return xlnx_dpu_wait(client, (struct ioc_wait_t __user *)arg);
 	case DPUIOC_REG_READ:
 	{
 		u32 val = 0;
@@ -669,6 +1296,58 @@ static long xlnx_dpu_ioctl(struct file *file, unsigned int cmd,
 	return ret;
 }
 
+/**
+ * xlnx_dpu_uring_cmd - io_uring passthrough of the run ioctls
+ * @ioucmd:	io_uring command, cmd_op is DPUIOC_RUN or DPUIOC_RUN_SOFTMAX
+ *		and the sqe cmd area holds a struct dpu_uring_cmd
+ * @issue_flags:	io_uring issue flags
+ *
+ * The job is queued like an ioctl job, but the submitter doesn't wait for
+ * it: the cqe is posted once the cu completes the job, so batches of runs
+ * are submitted and reaped without a syscall per job.
+ *
+ * Return:	-EIOCBQUEUED if the job is queued; otherwise -errno
+ */
+static int xlnx_dpu_uring_cmd(struct io_uring_cmd *ioucmd,
+			      unsigned int issue_flags)
+{
+	struct xdpu_client *client = ioucmd->file->private_data;
+	const struct dpu_uring_cmd *cmd = ioucmd->cmd;
+	void __user *data = u64_to_user_ptr(READ_ONCE(cmd->arg));
+	struct ioc_job_t desc = { };
+	struct xdpu_job *job;
+
+	/* completions are reported by the cu interrupts */
+	if (force_poll)
+		return -EOPNOTSUPP;
+
+	switch (ioucmd->cmd_op) {
+	case DPUIOC_RUN:
+		desc.type = DPU_JOB_RUN;
+		if (copy_from_user(&desc.run, data, sizeof(desc.run)))
+			return -EFAULT;
+		break;
+	case DPUIOC_RUN_SOFTMAX:
+		desc.type = DPU_JOB_SOFTMAX;
+		if (copy_from_user(&desc.softmax, data, sizeof(desc.softmax)))
+			return -EFAULT;
+		break;
+	default:
+		return -EOPNOTSUPP;
+	}
+
+	job = xlnx_dpu_job_alloc(client->dev, &desc);
+	if (IS_ERR(job))
+		return PTR_ERR(job);
+
+	job->ioucmd = ioucmd;
+	job->uarg = data;
+	*(struct xdpu_job **)ioucmd->pdu = job;
+	xlnx_dpu_submit(client, job, NULL);
+
+	return -EIOCBQUEUED;
+}
+
 /**
  * xlnx_dpu_isr - interrupt handler for DPU.
  * @irq:	Interrupt number.
@@ -681,24 +1360,47 @@ static irqreturn_t xlnx_dpu_isr(int irq, void *data)
 	struct xdpu_dev *xdpu = data;
 	int i;
 
+	spin_lock(&xdpu->sched_lock);
 	for (i = 0; i < xdpu->dpu_cnt; i++) {
 		if (irq == xdpu->cu[i].irq) {
 			xlnx_dpu_int_clear(xdpu, i);
 			dev_dbg(xdpu->dev, "%s: DPU=%d IRQ=%d",
 				__func__, i, irq);
-			complete(&xdpu->cu[i].done);
+			if (xdpu->cu[i].job)
+				xlnx_dpu_complete(xdpu, i, 0);
 		}
 	}
 
 	if (irq == xdpu->cu[xdpu->dpu_cnt].irq) {
 		xlnx_sfm_int_clear(xdpu);
 		dev_dbg(xdpu->dev, "%s: softmax IRQ=%d", __func__, irq);
-		complete(&xdpu->cu[xdpu->dpu_cnt].done);
+		if (xdpu->cu[xdpu->dpu_cnt].job)
+			xlnx_dpu_complete(xdpu, xdpu->dpu_cnt, 0);
 	}
+	spin_unlock(&xdpu->sched_lock);
 
 	return IRQ_HANDLED;
 }
 
+/**
+ * xlnx_dpu_poll - poll for completed asynchronous jobs
+ * @file:	file handle of the DPU device
+ * @wait:	poll table
+ *
+ * Return:	EPOLLIN if a completed job can be collected with DPUIOC_WAIT
+ */
+static __poll_t xlnx_dpu_poll(struct file *file, poll_table *wait)
+{
+	struct xdpu_client *client = file->private_data;
+
+	poll_wait(file, &client->wq, wait);
+
+	if (READ_ONCE(client->nr_done))
+		return EPOLLIN | EPOLLRDNORM;
+
+	return 0;
+}
+
 /**
  * xlnx_dpu_mmap - maps cma ranges into userspace
  * @file:	file structure for the device
@@ -733,12 +1435,17 @@ static int xlnx_dpu_mmap(struct file *file, struct vm_area_struct *vma)
 	}
 	mutex_unlock(&xdpu->mutex);
 
-	if (!found)
+	/* imported blocks are mapped through their exporter */
+	if (!found || h->attach)
 		return -EINVAL;
 
 	/* map the whole buffer */
 	vma->vm_pgoff = 0;
 
+	if (h->cached)
+		return dma_mmap_pages(xdpu->dev, vma, h->size,
+				      virt_to_page(h->cpu_addr));
+
 	return dma_mmap_attrs(xdpu->dev, vma, h->cpu_addr, h->dma_addr,
 			size, 0);
 }
@@ -761,6 +1468,8 @@ static int xlnx_dpu_open(struct inode *inode, struct file *filp)
 	xdpu = container_of(filp->private_data, struct xdpu_dev, miscdev);
 	client->dev = xdpu;
 	INIT_LIST_HEAD(&client->head);
+	INIT_LIST_HEAD(&client->jobs);
+	init_waitqueue_head(&client->wq);
 
 	filp->private_data = client;
 
@@ -784,22 +1493,30 @@ static int xlnx_dpu_release(struct inode *inode, struct file *filp)
 	struct xdpu_client *client = filp->private_data;
 	struct xdpu_dev *xdpu = client->dev;
 	struct dpu_buffer_block *h = NULL, *n = NULL;
+	struct xdpu_job *job, *tmp;
+	unsigned long flags;
 #ifdef CONFIG_DEBUG_FS
 	struct xdpu_client *p = NULL, *t = NULL;
 #endif
 
+	spin_lock_irqsave(&xdpu->sched_lock, flags);
+	list_for_each_entry_safe(job, tmp, &client->jobs, cnode) {
+		list_del_init(&job->cnode);
+		if (!job->done && list_empty(&job->node)) {
+			/* running on a cu, freed once it completes */
+			job->client = NULL;
+			continue;
+		}
+		list_del(&job->node);
+		kfree(job);
+	}
+	spin_unlock_irqrestore(&xdpu->sched_lock, flags);
+
 	mutex_lock(&xdpu->mutex);
 	/* Drain the remaining buffer entries when abnormal close */
 	if (!list_empty(&client->head)) {
-		list_for_each_entry_safe(h, n, &client->head, head) {
-			dma_free_attrs(xdpu->dev,
-				       h->size,
-				       h->cpu_addr,
-				       h->dma_addr,
-				       h->attrs);
-			list_del(&h->head);
-			kfree(h);
-		};
+		list_for_each_entry_safe(h, n, &client->head, head)
+			xlnx_dpu_free_block(xdpu, h);
 	}
 
 #ifdef CONFIG_DEBUG_FS
@@ -820,7 +1537,9 @@ static const struct file_operations dev_fops = {
 	.owner = THIS_MODULE,
 	.open = xlnx_dpu_open,
 	.mmap = xlnx_dpu_mmap,
+	.poll = xlnx_dpu_poll,
 	.unlocked_ioctl = xlnx_dpu_ioctl,
+	.uring_cmd = xlnx_dpu_uring_cmd,
 	.release = xlnx_dpu_release,
 };
 
@@ -965,6 +1684,17 @@ static int xlnx_dpu_probe(struct platform_device *pdev)
 	dev_dbg(dev, "found %d dpu core @%ldMHz and %d softmax core",
 		xdpu->dpu_cnt, DPU_FREQ(val), xdpu->sfm_cnt);
 
+	/* the scheduler must be ready before the cu interrupts are requested */
+	spin_lock_init(&xdpu->sched_lock);
+	INIT_LIST_HEAD(&xdpu->queue);
+
+	for (i = 0; i < xdpu->dpu_cnt + xdpu->sfm_cnt; i++) {
+		mutex_init(&xdpu->cu[i].mutex);
+		xdpu->cu[i].xdpu = xdpu;
+		timer_setup(&xdpu->cu[i].timer, xlnx_dpu_timeout, 0);
+		__set_bit(i, &xdpu->idle);
+	}
+
 	if (get_irq(pdev, xdpu))
 		goto err_out;
 
@@ -981,11 +1711,6 @@ static int xlnx_dpu_probe(struct platform_device *pdev)
 
 	mutex_init(&xdpu->mutex);
 
-	for (i = 0; i < xdpu->dpu_cnt + xdpu->sfm_cnt; i++) {
-		init_completion(&xdpu->cu[i].done);
-		mutex_init(&xdpu->cu[i].mutex);
-	}
-
 	xdpu->miscdev.minor = MISC_DYNAMIC_MINOR;
 	xdpu->miscdev.name = DEVICE_NAME;
 	xdpu->miscdev.fops = &dev_fops;
@@ -1047,6 +1772,9 @@ static int xlnx_dpu_remove(struct platform_device *pdev)
 	platform_set_drvdata(pdev, NULL);
 	misc_deregister(&xdpu->miscdev);
 
+	for (i = 0; i < xdpu->dpu_cnt + xdpu->sfm_cnt; i++)
+		del_timer_sync(&xdpu->cu[i].timer);
+
 	dev_dbg(xdpu->dev, "%s: device /dev/dpu unregistered\n", __func__);
 	return 0;
 }
@@ -1366,3 +2094,4 @@ static int dpu_debugfs_init(struct xdpu_dev *xdpu)
 MODULE_DESCRIPTION(DRIVER_DESC);
 MODULE_AUTHOR("Ye Yang <ye.yang@xilinx.com>");
 MODULE_LICENSE("GPL v2");
+MODULE_IMPORT_NS(DMA_BUF);
@@ -17,6 +17,8 @@
 #define TIMEOUT			(timeout * CONFIG_HZ)
 #define TIMEOUT_US		(timeout * 1000000)
 #define POLL_PERIOD_US		(2000)
+/* outstanding asynchronous jobs per client */
+#define DPU_MAX_JOBS		(256)
 
 #define in_range(b, start, len) (		\
 {						\
@@ -115,6 +117,12 @@ struct dpcma_req_alloc {
 	size_t capacity;
 };
 
+struct dpcma_req_import {
+	int fd;
+	u64 dma_addr;
+	size_t capacity;
+};
+
 struct dpcma_req_sync {
 	u64 dma_addr;
 	size_t size;
@@ -187,6 +195,52 @@ struct ioc_softmax_t {
 	u32 offset;
 };
 
+enum DPU_JOB_TYPE {
+	DPU_JOB_RUN = 0,
+	DPU_JOB_SOFTMAX = 1
+};
+
+/* let the scheduler pick any idle dpu core */
+#define DPU_CORE_ANY		(-1)
+
+/**
+ * struct  ioc_job_t - describe structure for each asynchronous dpu job
+ * @type:	DPU_JOB_RUN or DPU_JOB_SOFTMAX
+ * @seqno:	fence of the job returned by DPUIOC_SUBMIT
+ * @run:	dpu run struct for DPU_JOB_RUN, core_id may be DPU_CORE_ANY
+ * @softmax:	softmax struct for DPU_JOB_SOFTMAX
+ */
+struct ioc_job_t {
+	u32 type;
+	u64 seqno;
+	union {
+		struct ioc_kernel_run_t run;
+		struct ioc_softmax_t softmax;
+	};
+};
+
+/**
+ * struct  ioc_wait_t - describe structure for each dpu wait ioctl
+ * @seqno:	fence of the job to wait for, 0 waits for any job
+ * @timeout_ms:	time to wait in ms, 0 returns immediately
+ * @status:	0 if the job completed; otherwise -errno of the job
+ * @job:	the completed job, including the dpu run results
+ */
+struct ioc_wait_t {
+	u64 seqno;
+	u32 timeout_ms;
+	int status;
+	struct ioc_job_t job;
+};
+
+/**
+ * struct  dpu_uring_cmd - io_uring command payload in the sqe cmd area
+ * @arg:	user address of the argument of the ioctl in the sqe cmd_op
+ */
+struct dpu_uring_cmd {
+	u64 arg;
+};
+
 #define DPU_IOC_MAGIC 'D'
 
 #define DPUIOC_CREATE_BO _IOWR(DPU_IOC_MAGIC, 1, struct dpcma_req_alloc*)
@@ -197,5 +251,9 @@ struct ioc_softmax_t {
 #define DPUIOC_RUN _IOWR(DPU_IOC_MAGIC, 6, struct ioc_kernel_run_t*)
 #define DPUIOC_RUN_SOFTMAX _IOWR(DPU_IOC_MAGIC, 7, struct ioc_softmax_t*)
 #define DPUIOC_REG_READ _IOR(DPU_IOC_MAGIC, 8, u32)
+#define DPUIOC_SUBMIT _IOWR(DPU_IOC_MAGIC, 9, struct ioc_job_t*)
+#define DPUIOC_WAIT _IOWR(DPU_IOC_MAGIC, 10, struct ioc_wait_t*)
+#define DPUIOC_CREATE_CACHED_BO _IOWR(DPU_IOC_MAGIC, 11, struct dpcma_req_alloc*)
+#define DPUIOC_IMPORT_BO _IOWR(DPU_IOC_MAGIC, 12, struct dpcma_req_import*)
 
 #endif /* _DPU_UAPI_H_ */
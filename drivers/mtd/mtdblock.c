@@ -14,21 +14,48 @@
 #include <linux/slab.h>
 #include <linux/types.h>
 #include <linux/vmalloc.h>
+#include <linux/workqueue.h>
 
 #include <linux/mtd/mtd.h>
 #include <linux/mtd/blktrans.h>
 #include <linux/mutex.h>
 #include <linux/major.h>
 
+static unsigned int cache_blocks = 1;
+module_param(cache_blocks, uint, 0444);
+MODULE_PARM_DESC(cache_blocks, "Number of erase blocks cached for writing (default 1)");
+
+static unsigned int flush_delay_ms = 5000;
+module_param(flush_delay_ms, uint, 0644);
+MODULE_PARM_DESC(flush_delay_ms, "Write back dirty cached blocks this long after they are first written, 0 to wait for sync (default 5000)");
+
+static unsigned int readahead_kb = 32;
+module_param(readahead_kb, uint, 0444);
+MODULE_PARM_DESC(readahead_kb, "Read-ahead size in KiB for sequential reads, 0 to disable (default 32)");
+
+#define MTDBLK_MAX_CACHE_BLOCKS	64
+
+struct mtdblk_cache {
+	struct list_head list;
+	unsigned char *data;
+	unsigned long offset;
+	enum { STATE_EMPTY, STATE_CLEAN, STATE_DIRTY } state;
+};
 
 struct mtdblk_dev {
 	struct mtd_blktrans_dev mbd;
 	int count;
 	struct mutex cache_mutex;
-	unsigned char *cache_data;
-	unsigned long cache_offset;
+	struct mtdblk_cache *caches;
+	unsigned int nr_caches;
+	struct list_head lru;
 	unsigned int cache_size;
-	enum { STATE_EMPTY, STATE_CLEAN, STATE_DIRTY } cache_state;
+	struct delayed_work flush_work;
+	unsigned char *ra_data;
+	unsigned long ra_offset;
+	unsigned int ra_len;
+	unsigned int ra_size;
+	unsigned long ra_next;
 };
 
 /*
@@ -37,10 +64,24 @@ struct mtdblk_dev {
  * Since typical flash erasable sectors are much larger than what Linux's
  * buffer cache can handle, we must implement read-modify-write on flash
  * sectors for each block write requests.  To avoid over-erasing flash sectors
- * and to speed things up, we locally cache a whole flash sector while it is
- * being written to until a different sector is required.
+ * and to speed things up, we locally cache whole flash sectors while they are
+ * being written to, until the least recently used one has to make room for
+ * another sector, the cache is flushed, or they have been dirty for
+ * flush_delay_ms.
+ *
+ * Reads are served from the cached sectors first. Sequential reads that
+ * miss them are read ahead in readahead_kb chunks, as mtdblock is fed one
+ * 512 byte sector at a time and per-sector reads are slow on serial flash.
  */
 
+static void mtdblock_ra_invalidate(struct mtdblk_dev *mtdblk,
+				   unsigned long pos, unsigned int len)
+{
+	if (mtdblk->ra_len && pos < mtdblk->ra_offset + mtdblk->ra_len &&
+	    mtdblk->ra_offset < pos + len)
+		mtdblk->ra_len = 0;
+}
+
 static int erase_write (struct mtd_info *mtd, unsigned long pos,
 			unsigned int len, const char *buf)
 {
@@ -75,20 +116,21 @@ static int erase_write (struct mtd_info *mtd, unsigned long pos,
 }
 
 
-static int write_cached_data (struct mtdblk_dev *mtdblk)
+static int write_cache(struct mtdblk_dev *mtdblk, struct mtdblk_cache *cache)
 {
 	struct mtd_info *mtd = mtdblk->mbd.mtd;
 	int ret;
 
-	if (mtdblk->cache_state != STATE_DIRTY)
+	if (cache->state != STATE_DIRTY)
 		return 0;
 
 	pr_debug("mtdblock: writing cached data for \"%s\" "
 			"at 0x%lx, size 0x%x\n", mtd->name,
-			mtdblk->cache_offset, mtdblk->cache_size);
+			cache->offset, mtdblk->cache_size);
 
-	ret = erase_write (mtd, mtdblk->cache_offset,
-			   mtdblk->cache_size, mtdblk->cache_data);
+	mtdblock_ra_invalidate(mtdblk, cache->offset, mtdblk->cache_size);
+	ret = erase_write (mtd, cache->offset,
+			   mtdblk->cache_size, cache->data);
 
 	/*
 	 * Here we could arguably set the cache state to STATE_CLEAN.
@@ -102,24 +144,108 @@ static int write_cached_data (struct mtdblk_dev *mtdblk)
 	 * bad blocks repeatedly.
 	 */
 	if (ret == 0 || ret == -EIO)
-		mtdblk->cache_state = STATE_EMPTY;
+		cache->state = STATE_EMPTY;
+	return ret;
+}
+
+static int write_cached_data (struct mtdblk_dev *mtdblk)
+{
+	unsigned int i;
+	int ret = 0, err;
+
+	for (i = 0; i < mtdblk->nr_caches; i++) {
+		err = write_cache(mtdblk, &mtdblk->caches[i]);
+		if (err && !ret)
+			ret = err;
+	}
+
 	return ret;
 }
 
+static struct mtdblk_cache *find_cache(struct mtdblk_dev *mtdblk,
+				       unsigned long sect_start)
+{
+	struct mtdblk_cache *cache;
+
+	list_for_each_entry(cache, &mtdblk->lru, list) {
+		if (cache->state != STATE_EMPTY && cache->offset == sect_start) {
+			list_move(&cache->list, &mtdblk->lru);
+			return cache;
+		}
+	}
+
+	return NULL;
+}
+
+/*
+ * Return the cached copy of a sector, reading it in place of an empty or
+ * else the least recently used cached sector.
+ */
+static struct mtdblk_cache *get_cache(struct mtdblk_dev *mtdblk,
+				      unsigned long sect_start)
+{
+	struct mtd_info *mtd = mtdblk->mbd.mtd;
+	unsigned int sect_size = mtdblk->cache_size;
+	struct mtdblk_cache *cache;
+	size_t retlen;
+	int ret;
+
+	cache = find_cache(mtdblk, sect_start);
+	if (cache)
+		return cache;
+
+	list_for_each_entry_reverse(cache, &mtdblk->lru, list)
+		if (cache->state == STATE_EMPTY)
+			break;
+	if (list_entry_is_head(cache, &mtdblk->lru, list)) {
+		cache = list_last_entry(&mtdblk->lru, struct mtdblk_cache, list);
+		ret = write_cache(mtdblk, cache);
+		if (ret)
+			return ERR_PTR(ret);
+	}
+
+	if (unlikely(!cache->data)) {
+		cache->data = vmalloc(sect_size);
+		if (!cache->data)
+			return ERR_PTR(-EINTR);
+		/* -EINTR is not really correct, but it is the best match
+		 * documented in man 2 write for all cases.  We could also
+		 * return -EAGAIN sometimes, but why bother?
+		 */
+	}
+
+	/* fill the cache with the current sector */
+	cache->state = STATE_EMPTY;
+	ret = mtd_read(mtd, sect_start, sect_size, &retlen, cache->data);
+	if (ret)
+		return ERR_PTR(ret);
+	if (retlen != sect_size)
+		return ERR_PTR(-EIO);
+
+	cache->offset = sect_start;
+	cache->state = STATE_CLEAN;
+	list_move(&cache->list, &mtdblk->lru);
+
+	return cache;
+}
+
 
 static int do_cached_write (struct mtdblk_dev *mtdblk, unsigned long pos,
 			    int len, const char *buf)
 {
 	struct mtd_info *mtd = mtdblk->mbd.mtd;
 	unsigned int sect_size = mtdblk->cache_size;
+	struct mtdblk_cache *cache;
 	size_t retlen;
 	int ret;
 
 	pr_debug("mtdblock: write on \"%s\" at 0x%lx, size 0x%x\n",
 		mtd->name, pos, len);
 
-	if (!sect_size)
+	if (!sect_size) {
+		mtdblock_ra_invalidate(mtdblk, pos, len);
 		return mtd_write(mtd, pos, len, &retlen, buf);
+	}
 
 	while (len > 0) {
 		unsigned long sect_start = (pos/sect_size)*sect_size;
@@ -132,40 +258,30 @@ static int do_cached_write (struct mtdblk_dev *mtdblk, unsigned long pos,
 			/*
 			 * We are covering a whole sector.  Thus there is no
 			 * need to bother with the cache while it may still be
-			 * useful for other partial writes.
+			 * useful for other partial writes. A cached copy of
+			 * the sector is outdated now, drop it.
 			 */
+			cache = find_cache(mtdblk, sect_start);
+			if (cache)
+				cache->state = STATE_EMPTY;
+
+			mtdblock_ra_invalidate(mtdblk, pos, size);
 			ret = erase_write (mtd, pos, size, buf);
 			if (ret)
 				return ret;
 		} else {
 			/* Partial sector: need to use the cache */
-
-			if (mtdblk->cache_state == STATE_DIRTY &&
-			    mtdblk->cache_offset != sect_start) {
-				ret = write_cached_data(mtdblk);
-				if (ret)
-					return ret;
-			}
-
-			if (mtdblk->cache_state == STATE_EMPTY ||
-			    mtdblk->cache_offset != sect_start) {
-				/* fill the cache with the current sector */
-				mtdblk->cache_state = STATE_EMPTY;
-				ret = mtd_read(mtd, sect_start, sect_size,
-					       &retlen, mtdblk->cache_data);
-				if (ret)
-					return ret;
-				if (retlen != sect_size)
-					return -EIO;
-
-				mtdblk->cache_offset = sect_start;
-				mtdblk->cache_size = sect_size;
-				mtdblk->cache_state = STATE_CLEAN;
-			}
+			cache = get_cache(mtdblk, sect_start);
+			if (IS_ERR(cache))
+				return PTR_ERR(cache);
 
 			/* write data to our local cache */
-			memcpy (mtdblk->cache_data + offset, buf, size);
-			mtdblk->cache_state = STATE_DIRTY;
+			memcpy (cache->data + offset, buf, size);
+			mtdblock_ra_invalidate(mtdblk, pos, size);
+			if (cache->state != STATE_DIRTY && flush_delay_ms)
+				schedule_delayed_work(&mtdblk->flush_work,
+						      msecs_to_jiffies(flush_delay_ms));
+			cache->state = STATE_DIRTY;
 		}
 
 		buf += size;
@@ -177,19 +293,58 @@ static int do_cached_write (struct mtdblk_dev *mtdblk, unsigned long pos,
 }
 
 
+static int do_readahead_read(struct mtdblk_dev *mtdblk, unsigned long pos,
+			     unsigned int len, char *buf)
+{
+	struct mtd_info *mtd = mtdblk->mbd.mtd;
+	bool sequential = pos == mtdblk->ra_next;
+	size_t retlen;
+	int ret;
+
+	mtdblk->ra_next = pos + len;
+
+	if (mtdblk->ra_len && pos >= mtdblk->ra_offset &&
+	    pos + len <= mtdblk->ra_offset + mtdblk->ra_len) {
+		memcpy(buf, mtdblk->ra_data + pos - mtdblk->ra_offset, len);
+		return 0;
+	}
+
+	if (sequential && mtdblk->ra_data && len < mtdblk->ra_size) {
+		unsigned int ra_len = min_t(u64, mtdblk->ra_size, mtd->size - pos);
+
+		mtdblk->ra_len = 0;
+		ret = mtd_read(mtd, pos, ra_len, &retlen, mtdblk->ra_data);
+		if (!ret && retlen == ra_len) {
+			mtdblk->ra_offset = pos;
+			mtdblk->ra_len = ra_len;
+			memcpy(buf, mtdblk->ra_data, len);
+			return 0;
+		}
+		/* Don't fail on data beyond what was asked for */
+	}
+
+	ret = mtd_read(mtd, pos, len, &retlen, buf);
+	if (ret)
+		return ret;
+	if (retlen != len)
+		return -EIO;
+
+	return 0;
+}
+
 static int do_cached_read (struct mtdblk_dev *mtdblk, unsigned long pos,
 			   int len, char *buf)
 {
 	struct mtd_info *mtd = mtdblk->mbd.mtd;
 	unsigned int sect_size = mtdblk->cache_size;
-	size_t retlen;
+	struct mtdblk_cache *cache;
 	int ret;
 
 	pr_debug("mtdblock: read on \"%s\" at 0x%lx, size 0x%x\n",
 			mtd->name, pos, len);
 
 	if (!sect_size)
-		return mtd_read(mtd, pos, len, &retlen, buf);
+		return do_readahead_read(mtdblk, pos, len, buf);
 
 	while (len > 0) {
 		unsigned long sect_start = (pos/sect_size)*sect_size;
@@ -201,18 +356,16 @@ static int do_cached_read (struct mtdblk_dev *mtdblk, unsigned long pos,
 		/*
 		 * Check if the requested data is already cached
 		 * Read the requested amount of data from our internal cache if it
-		 * contains what we want, otherwise we read the data directly
-		 * from flash.
+		 * contains what we want, otherwise we read the data from flash,
+		 * possibly ahead.
 		 */
-		if (mtdblk->cache_state != STATE_EMPTY &&
-		    mtdblk->cache_offset == sect_start) {
-			memcpy (buf, mtdblk->cache_data + offset, size);
+		cache = find_cache(mtdblk, sect_start);
+		if (cache) {
+			memcpy (buf, cache->data + offset, size);
 		} else {
-			ret = mtd_read(mtd, pos, size, &retlen, buf);
+			ret = do_readahead_read(mtdblk, pos, size, buf);
 			if (ret)
 				return ret;
-			if (retlen != size)
-				return -EIO;
 		}
 
 		buf += size;
@@ -227,23 +380,49 @@ static int mtdblock_readsect(struct mtd_blktrans_dev *dev,
 			      unsigned long block, char *buf)
 {
 	struct mtdblk_dev *mtdblk = container_of(dev, struct mtdblk_dev, mbd);
-	return do_cached_read(mtdblk, block<<9, 512, buf);
+	int ret;
+
+	mutex_lock(&mtdblk->cache_mutex);
+	ret = do_cached_read(mtdblk, block<<9, 512, buf);
+	mutex_unlock(&mtdblk->cache_mutex);
+
+	return ret;
 }
 
 static int mtdblock_writesect(struct mtd_blktrans_dev *dev,
 			      unsigned long block, char *buf)
 {
 	struct mtdblk_dev *mtdblk = container_of(dev, struct mtdblk_dev, mbd);
-	if (unlikely(!mtdblk->cache_data && mtdblk->cache_size)) {
-		mtdblk->cache_data = vmalloc(mtdblk->mbd.mtd->erasesize);
-		if (!mtdblk->cache_data)
-			return -EINTR;
-		/* -EINTR is not really correct, but it is the best match
-		 * documented in man 2 write for all cases.  We could also
-		 * return -EAGAIN sometimes, but why bother?
-		 */
-	}
-	return do_cached_write(mtdblk, block<<9, 512, buf);
+	int ret;
+
+	mutex_lock(&mtdblk->cache_mutex);
+	ret = do_cached_write(mtdblk, block<<9, 512, buf);
+	mutex_unlock(&mtdblk->cache_mutex);
+
+	return ret;
+}
+
+static void mtdblock_flush_work(struct work_struct *work)
+{
+	struct mtdblk_dev *mtdblk = container_of(to_delayed_work(work),
+						 struct mtdblk_dev, flush_work);
+
+	mutex_lock(&mtdblk->cache_mutex);
+	write_cached_data(mtdblk);
+	mutex_unlock(&mtdblk->cache_mutex);
+}
+
+static void mtdblock_free_cache(struct mtdblk_dev *mtdblk)
+{
+	unsigned int i;
+
+	for (i = 0; i < mtdblk->nr_caches; i++)
+		vfree(mtdblk->caches[i].data);
+	kfree(mtdblk->caches);
+	mtdblk->caches = NULL;
+	mtdblk->nr_caches = 0;
+	vfree(mtdblk->ra_data);
+	mtdblk->ra_data = NULL;
 }
 
 static int mtdblock_open(struct mtd_blktrans_dev *mbd)
@@ -262,14 +441,37 @@ static int mtdblock_open(struct mtd_blktrans_dev *mbd)
 			mbd->tr->name, mbd->mtd->name);
 
 	/* OK, it's not open. Create cache info for it */
-	mtdblk->count = 1;
 	mutex_init(&mtdblk->cache_mutex);
-	mtdblk->cache_state = STATE_EMPTY;
+	INIT_LIST_HEAD(&mtdblk->lru);
+	INIT_DELAYED_WORK(&mtdblk->flush_work, mtdblock_flush_work);
+	mtdblk->cache_size = 0;
 	if (!(mbd->mtd->flags & MTD_NO_ERASE) && mbd->mtd->erasesize) {
+		unsigned int i;
+
+		mtdblk->nr_caches = clamp(cache_blocks, 1U,
+					  MTDBLK_MAX_CACHE_BLOCKS);
+		mtdblk->caches = kcalloc(mtdblk->nr_caches,
+					 sizeof(*mtdblk->caches), GFP_KERNEL);
+		if (!mtdblk->caches)
+			return -ENOMEM;
+
+		/* Cache buffers are allocated on the first write */
+		for (i = 0; i < mtdblk->nr_caches; i++) {
+			mtdblk->caches[i].state = STATE_EMPTY;
+			list_add_tail(&mtdblk->caches[i].list, &mtdblk->lru);
+		}
 		mtdblk->cache_size = mbd->mtd->erasesize;
-		mtdblk->cache_data = NULL;
 	}
 
+	mtdblk->ra_len = 0;
+	mtdblk->ra_next = ULONG_MAX;
+	mtdblk->ra_size = min_t(u64, (u64)readahead_kb * 1024, mbd->mtd->size);
+	if (mtdblk->ra_size > 512)
+		mtdblk->ra_data = vmalloc(mtdblk->ra_size);
+	/* Without read-ahead buffer we just read what is asked for */
+
+	mtdblk->count = 1;
+
 	pr_debug("ok\n");
 
 	return 0;
@@ -290,9 +492,10 @@ static void mtdblock_release(struct mtd_blktrans_dev *mbd)
 		 * It was the last usage. Free the cache, but only sync if
 		 * opened for writing.
 		 */
+		cancel_delayed_work_sync(&mtdblk->flush_work);
 		if (mbd->file_mode & FMODE_WRITE)
 			mtd_sync(mbd->mtd);
-		vfree(mtdblk->cache_data);
+		mtdblock_free_cache(mtdblk);
 	}
 
 	pr_debug("ok\n");
@@ -303,6 +506,7 @@ static int mtdblock_flush(struct mtd_blktrans_dev *dev)
 	struct mtdblk_dev *mtdblk = container_of(dev, struct mtdblk_dev, mbd);
 	int ret;
 
+	cancel_delayed_work(&mtdblk->flush_work);
 	mutex_lock(&mtdblk->cache_mutex);
 	ret = write_cached_data(mtdblk);
 	mutex_unlock(&mtdblk->cache_mutex);
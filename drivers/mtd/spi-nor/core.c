@@ -583,6 +583,31 @@ static int spansion_set_4byte_addr_mode(struct spi_nor *nor, bool enable)
 	return ret;
 }
 
+/**
+ * spi_nor_ear_is_current() - Check whether @addr needs a new EAR value.
+ * @nor:	pointer to 'struct spi_nor'.
+ * @addr:	address about to be accessed in 3-byte address mode.
+ *
+ * Return: true if the Extended Address Register already selects the
+ * segment of @addr, or if the flash has no such register.
+ */
+static bool spi_nor_ear_is_current(struct spi_nor *nor, u32 addr)
+{
+	struct mtd_info *mtd = &nor->mtd;
+
+	if (!(nor->flags & SNOR_F_HAS_PARALLEL) && mtd->size <= 0x1000000)
+		return true;
+	else if (mtd->size <= 0x2000000)
+		return true;
+
+	if (!(nor->flags & SNOR_F_HAS_PARALLEL) || !(nor->flags & SNOR_F_HAS_STACKED))
+		addr = addr % (u32)mtd->size;
+	else
+		addr = addr % (u32)(mtd->size >> 0x1);
+
+	return !(nor->flags & SNOR_F_HAS_STACKED) && (addr >> 24) == nor->curbank;
+}
+
 /**
  * spi_nor_write_ear() - Write Extended Address Register.
  * @nor:	pointer to 'struct spi_nor'.
@@ -1985,6 +2010,7 @@ static int spi_nor_read(struct mtd_info *mtd, loff_t from, size_t len,
 	u32 cur_cs_num = 0, rem_bank_len = 0, bank_size;
 	u_char *readbuf;
 	bool is_ofst_odd = false;
+	bool wait_ready = true;
 	loff_t addr;
 	u64 sz = 0;
 
@@ -2089,7 +2115,11 @@ static int spi_nor_read(struct mtd_info *mtd, loff_t from, size_t len,
 					rem_bank_len = mtd->size - addr;
 			}
 		}
-		if (nor->addr_nbytes == 3) {
+		/*
+		 * Reads are split at controller transfer size boundaries, only
+		 * talk to the EAR when the segment actually changes.
+		 */
+		if (nor->addr_nbytes == 3 && !spi_nor_ear_is_current(nor, addr)) {
 			ret = spi_nor_write_enable(nor);
 			if (ret)
 				goto read_err;
@@ -2098,16 +2128,24 @@ static int spi_nor_read(struct mtd_info *mtd, loff_t from, size_t len,
 				dev_err(nor->dev, "While writing ear register\n");
 				goto read_err;
 			}
+			wait_ready = true;
 		}
 		if (len < rem_bank_len)
 			read_len = len;
 		else
 			read_len = rem_bank_len;
 
-		/* Wait till previous write/erase is done. */
-		ret = spi_nor_wait_till_ready(nor);
-		if (ret)
-			goto read_err;
+		/*
+		 * Wait till previous write/erase is done. Program and erase
+		 * wait for completion and reads never make the flash busy, so
+		 * polling once per flash and EAR update is enough.
+		 */
+		if (wait_ready) {
+			ret = spi_nor_wait_till_ready(nor);
+			if (ret)
+				goto read_err;
+			wait_ready = false;
+		}
 
 		addr = spi_nor_convert_addr(nor, addr);
 
@@ -2146,6 +2184,7 @@ static int spi_nor_read(struct mtd_info *mtd, loff_t from, size_t len,
 			cur_cs_num++;
 			params = spi_nor_get_params(nor, cur_cs_num);
 			sz += params->size;
+			wait_ready = true;
 		}
 
 	}
@@ -28,6 +28,7 @@
 #include <linux/types.h>
 #include <linux/can/dev.h>
 #include <linux/can/error.h>
+#include <linux/can/rx-offload.h>
 #include <linux/pm_runtime.h>
 
 #define DRIVER_NAME	"xilinx_can"
@@ -189,7 +190,8 @@ struct xcan_devtype_data {
  * @tx_head:			Tx CAN packets ready to send on the queue
  * @tx_tail:			Tx CAN packets successfully sended on the queue
  * @tx_max:			Maximum number packets the driver can send
- * @napi:			NAPI structure
+ * @offload:			RX offload, delivers the frames read in the ISR
+ * @rx_max:			Number of RX FIFO buffers
  * @read_reg:			For reading data from CAN registers
  * @write_reg:			For writing data to CAN registers
  * @dev:			Network device data structure
@@ -205,7 +207,8 @@ struct xcan_priv {
 	unsigned int tx_head;
 	unsigned int tx_tail;
 	unsigned int tx_max;
-	struct napi_struct napi;
+	struct can_rx_offload offload;
+	unsigned int rx_max;
 	u32 (*read_reg)(const struct xcan_priv *priv, enum xcan_reg reg);
 	void (*write_reg)(const struct xcan_priv *priv, enum xcan_reg reg,
 			  u32 val);
@@ -766,12 +769,11 @@ static netdev_tx_t xcan_start_xmit(struct sk_buff *skb, struct net_device *ndev)
  * @ndev:	Pointer to net_device structure
  * @frame_base:	Register offset to the frame to be read
  *
- * This function is invoked from the CAN isr(poll) to process the Rx frames. It
- * does minimal processing and invokes "netif_receive_skb" to complete further
- * processing.
- * Return: 1 on success and 0 on failure.
+ * This function is invoked from the CAN isr to read a Rx frame. It does
+ * minimal processing, the frame is handed to the stack by the RX offload.
+ * Return: the frame on success and NULL on failure.
  */
-static int xcan_rx(struct net_device *ndev, int frame_base)
+static struct sk_buff *xcan_rx(struct net_device *ndev, int frame_base)
 {
 	struct xcan_priv *priv = netdev_priv(ndev);
 	struct net_device_stats *stats = &ndev->stats;
@@ -779,17 +781,21 @@ static int xcan_rx(struct net_device *ndev, int frame_base)
 	struct sk_buff *skb;
 	u32 id_xcan, dlc, data[2] = {0, 0};
 
-	skb = alloc_can_skb(ndev, &cf);
-	if (unlikely(!skb)) {
-		stats->rx_dropped++;
-		return 0;
-	}
-
 	/* Read a frame from Xilinx zynq CANPS */
 	id_xcan = priv->read_reg(priv, XCAN_FRAME_ID_OFFSET(frame_base));
 	dlc = priv->read_reg(priv, XCAN_FRAME_DLC_OFFSET(frame_base)) >>
 				   XCAN_DLCR_DLC_SHIFT;
 
+	/* DW1/DW2 must always be read to remove message from RXFIFO */
+	data[0] = priv->read_reg(priv, XCAN_FRAME_DW1_OFFSET(frame_base));
+	data[1] = priv->read_reg(priv, XCAN_FRAME_DW2_OFFSET(frame_base));
+
+	skb = alloc_can_skb(ndev, &cf);
+	if (unlikely(!skb)) {
+		stats->rx_dropped++;
+		return NULL;
+	}
+
 	/* Change Xilinx CAN data length format to socketCAN data format */
 	cf->len = can_cc_dlc2len(dlc);
 
@@ -810,24 +816,15 @@ static int xcan_rx(struct net_device *ndev, int frame_base)
 			cf->can_id |= CAN_RTR_FLAG;
 	}
 
-	/* DW1/DW2 must always be read to remove message from RXFIFO */
-	data[0] = priv->read_reg(priv, XCAN_FRAME_DW1_OFFSET(frame_base));
-	data[1] = priv->read_reg(priv, XCAN_FRAME_DW2_OFFSET(frame_base));
-
 	if (!(cf->can_id & CAN_RTR_FLAG)) {
 		/* Change Xilinx CAN data format to socketCAN data format */
 		if (cf->len > 0)
 			*(__be32 *)(cf->data) = cpu_to_be32(data[0]);
 		if (cf->len > 4)
 			*(__be32 *)(cf->data + 4) = cpu_to_be32(data[1]);
-
-		stats->rx_bytes += cf->len;
 	}
-	stats->rx_packets++;
-
-	netif_receive_skb(skb);
 
-	return 1;
+	return skb;
 }
 
 /**
@@ -836,12 +833,11 @@ static int xcan_rx(struct net_device *ndev, int frame_base)
  * @ndev:	Pointer to net_device structure
  * @frame_base:	Register offset to the frame to be read
  *
- * This function is invoked from the CAN isr(poll) to process the Rx frames. It
- * does minimal processing and invokes "netif_receive_skb" to complete further
- * processing.
- * Return: 1 on success and 0 on failure.
+ * This function is invoked from the CAN isr to read a Rx frame. It does
+ * minimal processing, the frame is handed to the stack by the RX offload.
+ * Return: the frame on success and NULL on failure.
  */
-static int xcanfd_rx(struct net_device *ndev, int frame_base)
+static struct sk_buff *xcanfd_rx(struct net_device *ndev, int frame_base)
 {
 	struct xcan_priv *priv = netdev_priv(ndev);
 	struct net_device_stats *stats = &ndev->stats;
@@ -858,7 +854,7 @@ static int xcanfd_rx(struct net_device *ndev, int frame_base)
 
 	if (unlikely(!skb)) {
 		stats->rx_dropped++;
-		return 0;
+		return NULL;
 	}
 
 	/* Change Xilinx CANFD data length format to socketCAN data
@@ -906,13 +902,7 @@ static int xcanfd_rx(struct net_device *ndev, int frame_base)
 		}
 	}
 
-	if (!(cf->can_id & CAN_RTR_FLAG))
-		stats->rx_bytes += cf->len;
-	stats->rx_packets++;
-
-	netif_receive_skb(skb);
-
-	return 1;
+	return skb;
 }
 
 /**
@@ -1003,8 +993,8 @@ static void xcan_update_error_state_after_rxtx(struct net_device *ndev)
 
 		xcan_set_error_state(ndev, new_state, skb ? cf : NULL);
 
-		if (skb)
-			netif_rx(skb);
+		if (skb && can_rx_offload_queue_tail(&priv->offload, skb))
+			ndev->stats.rx_fifo_errors++;
 	}
 }
 
@@ -1128,7 +1118,8 @@ static void xcan_err_interrupt(struct net_device *ndev, u32 isr)
 		if (skb) {
 			skb_cf->can_id |= cf.can_id;
 			memcpy(skb_cf->data, cf.data, CAN_ERR_DLC);
-			netif_rx(skb);
+			if (can_rx_offload_queue_tail(&priv->offload, skb))
+				stats->rx_fifo_errors++;
 		}
 	}
 
@@ -1158,102 +1149,126 @@ static void xcan_state_interrupt(struct net_device *ndev, u32 isr)
 }
 
 /**
- * xcan_rx_fifo_get_next_frame - Get register offset of next RX frame
+ * xcan_rx_queue - Hand a received frame to the RX offload
  * @priv:	Driver private data structure
+ * @skb:	Received frame or NULL
+ *
+ * Return: 1 if a frame was queued, 0 otherwise.
+ */
+static int xcan_rx_queue(struct xcan_priv *priv, struct sk_buff *skb)
+{
+	if (!skb)
+		return 0;
+
+	if (can_rx_offload_queue_tail(&priv->offload, skb)) {
+		priv->offload.dev->stats.rx_fifo_errors++;
+		return 0;
+	}
+
+	return 1;
+}
+
+/**
+ * xcan_rx_fifo_multi - Read all frames from the RX message space
+ * @ndev:	Pointer to net_device structure
  *
- * Return: Register offset of the next frame in RX FIFO.
+ * The fill level and read index are read once for every batch of frames
+ * instead of once per frame, the read index then simply follows the
+ * increments done for each frame.
+ *
+ * Return: number of frames queued to the RX offload.
  */
-static int xcan_rx_fifo_get_next_frame(struct xcan_priv *priv)
+static int xcan_rx_fifo_multi(struct net_device *ndev)
 {
+	struct xcan_priv *priv = netdev_priv(ndev);
+	u32 fsr, fl_mask, ri_mask;
+	unsigned int fl, ri;
+	int received = 0;
 	int offset;
 
-	if (priv->devtype.flags & XCAN_FLAG_RX_FIFO_MULTI) {
-		u32 fsr, mask;
+	if (priv->devtype.flags & XCAN_FLAG_CANFD_2) {
+		fl_mask = XCAN_2_FSR_FL_MASK;
+		ri_mask = XCAN_2_FSR_RI_MASK;
+	} else {
+		fl_mask = XCAN_FSR_FL_MASK;
+		ri_mask = XCAN_FSR_RI_MASK;
+	}
 
+	for (;;) {
 		/* clear RXOK before the is-empty check so that any newly
 		 * received frame will reassert it without a race
 		 */
 		priv->write_reg(priv, XCAN_ICR_OFFSET, XCAN_IXR_RXOK_MASK);
 
 		fsr = priv->read_reg(priv, XCAN_FSR_OFFSET);
+		fl = FIELD_GET(fl_mask, fsr);
+		if (!fl)
+			break;
+
+		ri = fsr & ri_mask;
+		while (fl--) {
+			if (priv->devtype.flags & XCAN_FLAG_CANFD_2)
+				offset = XCAN_RXMSG_2_FRAME_OFFSET(ri);
+			else
+				offset = XCAN_RXMSG_FRAME_OFFSET(ri);
+
+			received += xcan_rx_queue(priv,
+						  xcanfd_rx(ndev, offset));
 
-		/* check if RX FIFO is empty */
-		if (priv->devtype.flags & XCAN_FLAG_CANFD_2)
-			mask = XCAN_2_FSR_FL_MASK;
-		else
-			mask = XCAN_FSR_FL_MASK;
+			/* increment read index */
+			priv->write_reg(priv, XCAN_FSR_OFFSET,
+					XCAN_FSR_IRI_MASK);
+			if (++ri == priv->rx_max)
+				ri = 0;
+		}
+	}
 
-		if (!(fsr & mask))
-			return -ENOENT;
+	return received;
+}
 
-		if (priv->devtype.flags & XCAN_FLAG_CANFD_2)
-			offset =
-			  XCAN_RXMSG_2_FRAME_OFFSET(fsr & XCAN_2_FSR_RI_MASK);
-		else
-			offset =
-			  XCAN_RXMSG_FRAME_OFFSET(fsr & XCAN_FSR_RI_MASK);
+/**
+ * xcan_rx_fifo - Read all frames from the RX FIFO
+ * @ndev:	Pointer to net_device structure
+ *
+ * Return: number of frames queued to the RX offload.
+ */
+static int xcan_rx_fifo(struct net_device *ndev)
+{
+	struct xcan_priv *priv = netdev_priv(ndev);
+	int received = 0;
 
-	} else {
-		/* check if RX FIFO is empty */
-		if (!(priv->read_reg(priv, XCAN_ISR_OFFSET) &
-		      XCAN_IXR_RXNEMP_MASK))
-			return -ENOENT;
+	/* frames are read from a static offset */
+	while (priv->read_reg(priv, XCAN_ISR_OFFSET) & XCAN_IXR_RXNEMP_MASK) {
+		received += xcan_rx_queue(priv,
+					  xcan_rx(ndev, XCAN_RXFIFO_OFFSET));
 
-		/* frames are read from a static offset */
-		offset = XCAN_RXFIFO_OFFSET;
+		/* clear rx-not-empty (will actually clear only if empty) */
+		priv->write_reg(priv, XCAN_ICR_OFFSET, XCAN_IXR_RXNEMP_MASK);
 	}
 
-	return offset;
+	return received;
 }
 
 /**
- * xcan_rx_poll - Poll routine for rx packets (NAPI)
- * @napi:	napi structure pointer
- * @quota:	Max number of rx packets to be processed.
- *
- * This is the poll routine for rx part.
- * It will process the packets maximux quota value.
+ * xcan_rx_interrupt - Rx Isr
+ * @ndev:	net_device pointer
  *
- * Return: number of packets received
+ * Drains the whole RX FIFO in one go. The frames are queued to the RX
+ * offload in FIFO order, along with the error frames raised by the same
+ * interrupt, and delivered to the stack from its NAPI.
  */
-static int xcan_rx_poll(struct napi_struct *napi, int quota)
+static void xcan_rx_interrupt(struct net_device *ndev)
 {
-	struct net_device *ndev = napi->dev;
 	struct xcan_priv *priv = netdev_priv(ndev);
-	u32 ier;
-	int work_done = 0;
-	int frame_offset;
-
-	while ((frame_offset = xcan_rx_fifo_get_next_frame(priv)) >= 0 &&
-	       (work_done < quota)) {
-		if (xcan_rx_int_mask(priv) & XCAN_IXR_RXOK_MASK)
-			work_done += xcanfd_rx(ndev, frame_offset);
-		else
-			work_done += xcan_rx(ndev, frame_offset);
+	int received;
 
-		if (priv->devtype.flags & XCAN_FLAG_RX_FIFO_MULTI)
-			/* increment read index */
-			priv->write_reg(priv, XCAN_FSR_OFFSET,
-					XCAN_FSR_IRI_MASK);
-		else
-			/* clear rx-not-empty (will actually clear only if
-			 * empty)
-			 */
-			priv->write_reg(priv, XCAN_ICR_OFFSET,
-					XCAN_IXR_RXNEMP_MASK);
-	}
+	if (priv->devtype.flags & XCAN_FLAG_RX_FIFO_MULTI)
+		received = xcan_rx_fifo_multi(ndev);
+	else
+		received = xcan_rx_fifo(ndev);
 
-	if (work_done)
+	if (received)
 		xcan_update_error_state_after_rxtx(ndev);
-
-	if (work_done < quota) {
-		if (napi_complete_done(napi, work_done)) {
-			ier = priv->read_reg(priv, XCAN_IER_OFFSET);
-			ier |= xcan_rx_int_mask(priv);
-			priv->write_reg(priv, XCAN_IER_OFFSET, ier);
-		}
-	}
-	return work_done;
 }
 
 /**
@@ -1348,7 +1363,7 @@ static irqreturn_t xcan_interrupt(int irq, void *dev_id)
 {
 	struct net_device *ndev = (struct net_device *)dev_id;
 	struct xcan_priv *priv = netdev_priv(ndev);
-	u32 isr, ier;
+	u32 isr;
 	u32 isr_errors;
 	u32 rx_int_mask = xcan_rx_int_mask(priv);
 
@@ -1378,12 +1393,11 @@ static irqreturn_t xcan_interrupt(int irq, void *dev_id)
 	}
 
 	/* Check for the type of receive interrupt and Processing it */
-	if (isr & rx_int_mask) {
-		ier = priv->read_reg(priv, XCAN_IER_OFFSET);
-		ier &= ~rx_int_mask;
-		priv->write_reg(priv, XCAN_IER_OFFSET, ier);
-		napi_schedule(&priv->napi);
-	}
+	if (isr & rx_int_mask)
+		xcan_rx_interrupt(ndev);
+
+	can_rx_offload_irq_finish(&priv->offload);
+
 	return IRQ_HANDLED;
 }
 
@@ -1445,18 +1459,19 @@ static int xcan_open(struct net_device *ndev)
 	if (ret)
 		goto err_irq;
 
+	can_rx_offload_enable(&priv->offload);
 	ret = xcan_chip_start(ndev);
 	if (ret < 0) {
 		netdev_err(ndev, "xcan_chip_start failed!\n");
-		goto err_candev;
+		goto err_offload;
 	}
 
-	napi_enable(&priv->napi);
 	netif_start_queue(ndev);
 
 	return 0;
 
-err_candev:
+err_offload:
+	can_rx_offload_disable(&priv->offload);
 	close_candev(ndev);
 err_irq:
 	free_irq(ndev->irq, ndev);
@@ -1477,7 +1492,7 @@ static int xcan_close(struct net_device *ndev)
 	struct xcan_priv *priv = netdev_priv(ndev);
 
 	netif_stop_queue(ndev);
-	napi_disable(&priv->napi);
+	can_rx_offload_disable(&priv->offload);
 	xcan_chip_stop(ndev);
 	free_irq(ndev->irq, ndev);
 	close_candev(ndev);
@@ -1811,6 +1826,7 @@ static int xcan_probe(struct platform_device *pdev)
 
 	priv->reg_base = addr;
 	priv->tx_max = tx_max;
+	priv->rx_max = rx_max;
 	priv->devtype = *devtype;
 	spin_lock_init(&priv->tx_lock);
 
@@ -1861,12 +1877,14 @@ static int xcan_probe(struct platform_device *pdev)
 
 	priv->can.clock.freq = clk_get_rate(priv->can_clk);
 
-	netif_napi_add_weight(ndev, &priv->napi, xcan_rx_poll, rx_max);
+	ret = can_rx_offload_add_manual(ndev, &priv->offload, rx_max);
+	if (ret)
+		goto err_disableclks;
 
 	ret = register_candev(ndev);
 	if (ret) {
 		dev_err(&pdev->dev, "fail to register failed (err=%d)\n", ret);
-		goto err_disableclks;
+		goto err_offload;
 	}
 
 	pm_runtime_put(&pdev->dev);
@@ -1882,6 +1900,8 @@ static int xcan_probe(struct platform_device *pdev)
 
 	return 0;
 
+err_offload:
+	can_rx_offload_del(&priv->offload);
 err_disableclks:
 	pm_runtime_put(priv->dev);
 	pm_runtime_disable(&pdev->dev);
@@ -1901,8 +1921,10 @@ static int xcan_probe(struct platform_device *pdev)
 static int xcan_remove(struct platform_device *pdev)
 {
 	struct net_device *ndev = platform_get_drvdata(pdev);
+	struct xcan_priv *priv = netdev_priv(ndev);
 
 	unregister_candev(ndev);
+	can_rx_offload_del(&priv->offload);
 	pm_runtime_disable(&pdev->dev);
 	free_candev(ndev);
 
@@ -13,6 +13,7 @@
 #include <linux/net_tstamp.h>
 #include <linux/interrupt.h>
 #include <linux/phy/phy.h>
+#include <net/xdp.h>
 
 #if defined(CONFIG_ARCH_DMA_ADDR_T_64BIT) || defined(CONFIG_MACB_USE_HWSTAMP)
 #define MACB_EXT_DESC
@@ -85,6 +86,7 @@
 #define GEM_PBUFRXCUT		0x0044 /* RX Partial Store and Forward */
 #define GEM_JML			0x0048 /* Jumbo Max Length */
 #define GEM_HS_MAC_CONFIG	0x0050 /* GEM high speed config */
+#define GEM_IMOD		0x005C /* Interrupt Moderation */
 #define GEM_HRB			0x0080 /* Hash Bottom */
 #define GEM_HRT			0x0084 /* Hash Top */
 #define GEM_SA1B		0x0088 /* Specific1 Bottom */
@@ -189,6 +191,9 @@
 #define GEM_TXBDCTRL	0x04cc /* TX Buffer Descriptor control register */
 #define GEM_RXBDCTRL	0x04d0 /* RX Buffer Descriptor control register */
 
+/* Screener Type 1 match registers */
+#define GEM_SCRT1		0x500
+
 /* Screener Type 2 match registers */
 #define GEM_SCRT2		0x540
 
@@ -347,6 +352,12 @@
 #define GEM_ADDR64_OFFSET	30 /* Address bus width - 64b or 32b */
 #define GEM_ADDR64_SIZE		1
 
+/* Bitfields in IMOD */
+#define GEM_RXMOD_OFFSET	0 /* RX interrupt moderation, 800ns units */
+#define GEM_RXMOD_SIZE		8
+#define GEM_TXMOD_OFFSET	16 /* TX interrupt moderation, 800ns units */
+#define GEM_TXMOD_SIZE		8
+
 /* Bitfields in PBUFRXCUT */
 #define GEM_WTRMRK_OFFSET	0 /* Watermark value offset */
 #define GEM_WTRMRK_SIZE		12
@@ -600,6 +611,16 @@
 #define GEM_RXTSMODE_OFFSET			4 /* RX Descriptor Timestamp Insertion mode */
 #define GEM_RXTSMODE_SIZE			2
 
+/* Bitfields in SCRT1, the queue number uses the SCRT2 field */
+#define GEM_DSTCM_OFFSET			4 /* IPv4 DS / IPv6 TC match */
+#define GEM_DSTCM_SIZE				8
+#define GEM_UDPM_OFFSET				12 /* UDP destination port match */
+#define GEM_UDPM_SIZE				16
+#define GEM_DSTCE_OFFSET			28 /* DS / TC match enable */
+#define GEM_DSTCE_SIZE				1
+#define GEM_UDPE_OFFSET				29 /* UDP port match enable */
+#define GEM_UDPE_SIZE				1
+
 /* Bitfields in SCRT2 */
 #define GEM_QUEUE_OFFSET			0 /* Queue Number */
 #define GEM_QUEUE_SIZE				4
@@ -738,6 +759,7 @@
 #define MACB_CAPS_CLK_HW_CHG			0x04000000
 #define MACB_CAPS_MACB_IS_EMAC			0x08000000
 #define MACB_CAPS_QUEUE_DISABLE			0x00002000
+#define MACB_CAPS_INT_MODERATION		0x00004000
 #define MACB_CAPS_FIFO_MODE			0x10000000
 #define MACB_CAPS_GIGABIT_MODE_AVAILABLE	0x20000000
 #define MACB_CAPS_SG_DISABLED			0x40000000
@@ -1236,7 +1258,9 @@ struct macb_queue {
 	unsigned int		rx_tail;
 	unsigned int		rx_prepared_head;
 	struct macb_dma_desc	*rx_ring;
-	struct sk_buff		**rx_skbuff;
+	struct page		**rx_page;
+	struct page_pool	*page_pool;
+	struct xdp_rxq_info	xdp_rxq;
 	void			*rx_buffers;
 	struct napi_struct	napi_rx;
 	struct queue_stats stats;
@@ -1268,6 +1292,7 @@ struct macb {
 
 	struct macb_dma_desc	*rx_ring_tieoff;
 	size_t			rx_buffer_size;
+	struct bpf_prog		*xdp_prog;
 
 	unsigned int		rx_ring_size;
 	unsigned int		tx_ring_size;
@@ -1336,6 +1361,11 @@ struct macb {
 	struct ethtool_rx_fs_list rx_fs_list;
 	spinlock_t rx_fs_lock;
 	unsigned int max_tuples;
+	/* type 1 screener rules follow the max_tuples type 2 locations */
+	unsigned int max_t1_tuples;
+
+	/* GEM_IMOD value, restored by macb_init_hw() */
+	u32 intr_mod;
 
 	struct tasklet_struct	hresp_err_tasklet;
 
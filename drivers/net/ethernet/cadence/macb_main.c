@@ -41,6 +41,10 @@
 #include <linux/firmware/xlnx-zynqmp.h>
 #include <linux/crc32.h>
 #include <linux/inetdevice.h>
+#include <linux/bpf_trace.h>
+#include <linux/filter.h>
+#include <net/page_pool.h>
+#include <asm/unaligned.h>
 #include "macb.h"
 
 /* This structure is only used for MACB on SiFive FU540 devices */
@@ -53,6 +57,11 @@ struct sifive_fu540_macb_mgmt {
 #define MACB_RX_BUFFER_SIZE	128
 #define RX_BUFFER_MULTIPLE	64  /* bytes */
 
+/* GEM Rx buffers are page pool pages, the frame is written behind the
+ * headroom so that XDP programs and build_skb() can use it in place.
+ */
+#define GEM_RX_HEADROOM		XDP_PACKET_HEADROOM
+
 #define DEFAULT_RX_RING_SIZE	512 /* must be power of 2 */
 #define MIN_RX_RING_SIZE	64
 #define MAX_RX_RING_SIZE	8192
@@ -1286,7 +1295,7 @@ static int macb_tx_complete(struct macb_queue *queue, int budget)
 static void gem_rx_refill(struct macb_queue *queue)
 {
 	unsigned int		entry;
-	struct sk_buff		*skb;
+	struct page		*page;
 	dma_addr_t		paddr;
 	struct macb *bp = queue->bp;
 	struct macb_dma_desc *desc;
@@ -1300,25 +1309,18 @@ static void gem_rx_refill(struct macb_queue *queue)
 
 		desc = macb_rx_desc(queue, entry);
 
-		if (!queue->rx_skbuff[entry]) {
-			/* allocate sk_buff for this free entry in ring */
-			skb = netdev_alloc_skb(bp->dev, bp->rx_buffer_size);
-			if (unlikely(!skb)) {
+		if (!queue->rx_page[entry]) {
+			/* get a mapped page for this free entry in ring */
+			page = page_pool_dev_alloc_pages(queue->page_pool);
+			if (unlikely(!page)) {
 				netdev_err(bp->dev,
-					   "Unable to allocate sk_buff\n");
+					   "Unable to allocate Rx page\n");
 				break;
 			}
 
 			/* now fill corresponding descriptor entry */
-			paddr = dma_map_single(&bp->pdev->dev, skb->data,
-					       bp->rx_buffer_size,
-					       DMA_FROM_DEVICE);
-			if (dma_mapping_error(&bp->pdev->dev, paddr)) {
-				dev_kfree_skb(skb);
-				break;
-			}
-
-			queue->rx_skbuff[entry] = skb;
+			paddr = page_pool_get_dma_addr(page) + GEM_RX_HEADROOM;
+			queue->rx_page[entry] = page;
 
 			if (entry == bp->rx_ring_size - 1)
 				paddr |= MACB_BIT(RX_WRAP);
@@ -1328,9 +1330,6 @@ static void gem_rx_refill(struct macb_queue *queue)
 			 */
 			dma_wmb();
 			macb_set_addr(bp, desc, paddr);
-
-			/* properly align Ethernet header */
-			skb_reserve(skb, NET_IP_ALIGN);
 		} else {
 			desc->ctrl = 0;
 			dma_wmb();
@@ -1367,15 +1366,57 @@ static void discard_partial_frame(struct macb_queue *queue, unsigned int begin,
 	 */
 }
 
-static int macb_validate_hw_csum(struct sk_buff *skb)
+static int macb_validate_fcs(const u8 *data, unsigned int len)
 {
-	u32 pkt_csum = *((u32 *)&skb->data[skb->len - ETH_FCS_LEN]);
-	u32 csum  = ~crc32_le(~0, skb_mac_header(skb),
-			skb->len + ETH_HLEN - ETH_FCS_LEN);
+	u32 pkt_csum = get_unaligned((u32 *)&data[len - ETH_FCS_LEN]);
+	u32 csum  = ~crc32_le(~0, data, len - ETH_FCS_LEN);
 
 	return (pkt_csum != csum);
 }
 
+static int macb_validate_hw_csum(struct sk_buff *skb)
+{
+	return macb_validate_fcs(skb_mac_header(skb), skb->len + ETH_HLEN);
+}
+
+/* gem_run_xdp() verdicts */
+#define MACB_XDP_PASS		0
+#define MACB_XDP_CONSUMED	BIT(0)
+#define MACB_XDP_REDIR		BIT(1)
+
+/* Frames that do not pass are redirected or returned to the page pool here.
+ * XDP_TX is not supported, the Tx ring only carries mapped skbs.
+ */
+static u32 gem_run_xdp(struct macb_queue *queue, struct bpf_prog *prog,
+		       struct xdp_buff *xdp)
+{
+	struct net_device *dev = queue->bp->dev;
+	u32 act;
+
+	act = bpf_prog_run_xdp(prog, xdp);
+	switch (act) {
+	case XDP_PASS:
+		return MACB_XDP_PASS;
+	case XDP_REDIRECT:
+		if (unlikely(xdp_do_redirect(dev, xdp, prog)))
+			goto out_failure;
+		return MACB_XDP_REDIR;
+	default:
+		bpf_warn_invalid_xdp_action(dev, prog, act);
+		fallthrough;
+	case XDP_ABORTED:
+out_failure:
+		trace_xdp_exception(dev, prog, act);
+		fallthrough;
+	case XDP_DROP:
+		break;
+	}
+
+	page_pool_recycle_direct(queue->page_pool,
+				 virt_to_head_page(xdp->data));
+	return MACB_XDP_CONSUMED;
+}
+
 static int gem_rx(struct macb_queue *queue, struct napi_struct *napi,
 		  int budget)
 {
@@ -1383,12 +1424,15 @@ static int gem_rx(struct macb_queue *queue, struct napi_struct *napi,
 	unsigned int		len;
 	unsigned int		entry;
 	struct sk_buff		*skb;
+	struct page		*page;
 	struct macb_dma_desc	*desc;
+	struct bpf_prog		*xdp_prog;
+	struct xdp_buff		xdp;
+	u32			xdp_res, xdp_status = 0;
 	int			count = 0;
 
 	while (count < budget) {
 		u32 ctrl;
-		dma_addr_t addr;
 		bool rxused;
 
 		entry = macb_rx_ring_wrap(bp, queue->rx_tail);
@@ -1398,7 +1442,6 @@ static int gem_rx(struct macb_queue *queue, struct napi_struct *napi,
 		rmb();
 
 		rxused = (desc->addr & MACB_BIT(RX_USED)) ? true : false;
-		addr = macb_get_addr(bp, desc);
 
 		if (!rxused)
 			break;
@@ -1418,8 +1461,8 @@ static int gem_rx(struct macb_queue *queue, struct napi_struct *napi,
 			queue->stats.rx_dropped++;
 			break;
 		}
-		skb = queue->rx_skbuff[entry];
-		if (unlikely(!skb)) {
+		page = queue->rx_page[entry];
+		if (unlikely(!page)) {
 			netdev_err(bp->dev,
 				   "inconsistent Rx descriptor chain\n");
 			bp->dev->stats.rx_dropped++;
@@ -1427,26 +1470,56 @@ static int gem_rx(struct macb_queue *queue, struct napi_struct *napi,
 			break;
 		}
 		/* now everything is ready for receiving packet */
-		queue->rx_skbuff[entry] = NULL;
+		queue->rx_page[entry] = NULL;
 		len = ctrl & bp->rx_frm_len_mask;
 
 		netdev_vdbg(bp->dev, "gem_rx %u (len %u)\n", entry, len);
 
-		skb_put(skb, len);
-		dma_unmap_single(&bp->pdev->dev, addr,
-				 bp->rx_buffer_size, DMA_FROM_DEVICE);
+		/* The frame starts NET_IP_ALIGN bytes into the buffer (RBOF) */
+		dma_sync_single_for_cpu(&bp->pdev->dev,
+					page_pool_get_dma_addr(page) +
+					GEM_RX_HEADROOM, NET_IP_ALIGN + len,
+					page_pool_get_dma_dir(queue->page_pool));
 
-		skb->protocol = eth_type_trans(skb, bp->dev);
+		xdp_init_buff(&xdp, PAGE_SIZE << queue->page_pool->p.order,
+			      &queue->xdp_rxq);
+		xdp_prepare_buff(&xdp, page_address(page),
+				 GEM_RX_HEADROOM + NET_IP_ALIGN, len, false);
 
 		/* Validate MAC fcs if RX checsum offload disabled */
 		if (!(bp->dev->features & NETIF_F_RXCSUM)) {
-			if (macb_validate_hw_csum(skb)) {
+			if (macb_validate_fcs(xdp.data, len)) {
 				netdev_err(bp->dev, "incorrect FCS\n");
 				bp->dev->stats.rx_dropped++;
-				break;
+				queue->stats.rx_dropped++;
+				page_pool_recycle_direct(queue->page_pool,
+							 page);
+				continue;
+			}
+		}
+
+		xdp_prog = READ_ONCE(bp->xdp_prog);
+		if (xdp_prog) {
+			xdp_res = gem_run_xdp(queue, xdp_prog, &xdp);
+			if (xdp_res != MACB_XDP_PASS) {
+				xdp_status |= xdp_res;
+				continue;
 			}
 		}
 
+		skb = napi_build_skb(xdp.data_hard_start, xdp.frame_sz);
+		if (unlikely(!skb)) {
+			page_pool_recycle_direct(queue->page_pool, page);
+			bp->dev->stats.rx_dropped++;
+			queue->stats.rx_dropped++;
+			continue;
+		}
+		skb_mark_for_recycle(skb);
+		skb_reserve(skb, xdp.data - xdp.data_hard_start);
+		skb_put(skb, xdp.data_end - xdp.data);
+
+		skb->protocol = eth_type_trans(skb, bp->dev);
+
 		skb_checksum_none_assert(skb);
 		if (bp->dev->features & NETIF_F_RXCSUM &&
 		    !(bp->dev->flags & IFF_PROMISC) &&
@@ -1472,6 +1545,9 @@ static int gem_rx(struct macb_queue *queue, struct napi_struct *napi,
 		napi_gro_receive(napi, skb);
 	}
 
+	if (xdp_status & MACB_XDP_REDIR)
+		xdp_do_flush();
+
 	gem_rx_refill(queue);
 
 	return count;
@@ -2391,34 +2467,32 @@ static void macb_init_rx_buffer_size(struct macb *bp, size_t size)
 
 static void gem_free_rx_buffers(struct macb *bp)
 {
-	struct sk_buff		*skb;
-	struct macb_dma_desc	*desc;
+	struct page		*page;
 	struct macb_queue *queue;
-	dma_addr_t		addr;
 	unsigned int q;
 	int i;
 
 	for (q = 0, queue = bp->queues; q < bp->num_queues; ++q, ++queue) {
-		if (!queue->rx_skbuff)
-			continue;
-
-		for (i = 0; i < bp->rx_ring_size; i++) {
-			skb = queue->rx_skbuff[i];
+		if (queue->rx_page) {
+			for (i = 0; i < bp->rx_ring_size; i++) {
+				page = queue->rx_page[i];
 
-			if (!skb)
-				continue;
+				if (!page)
+					continue;
 
-			desc = macb_rx_desc(queue, i);
-			addr = macb_get_addr(bp, desc);
+				page_pool_put_full_page(queue->page_pool, page,
+							false);
+			}
 
-			dma_unmap_single(&bp->pdev->dev, addr, bp->rx_buffer_size,
-					DMA_FROM_DEVICE);
-			dev_kfree_skb_any(skb);
-			skb = NULL;
+			kfree(queue->rx_page);
+			queue->rx_page = NULL;
 		}
 
-		kfree(queue->rx_skbuff);
-		queue->rx_skbuff = NULL;
+		if (queue->page_pool) {
+			xdp_rxq_info_unreg(&queue->xdp_rxq);
+			page_pool_destroy(queue->page_pool);
+			queue->page_pool = NULL;
+		}
 	}
 }
 
@@ -2466,6 +2540,56 @@ static void macb_free_consistent(struct macb *bp)
 	}
 }
 
+/* Each page pool page holds one Rx buffer behind GEM_RX_HEADROOM, followed
+ * by room for the skb_shared_info. The pages stay DMA mapped while they are
+ * recycled, and the pool is the memory model of the queue's XDP Rx queue.
+ */
+static int gem_create_page_pool(struct macb_queue *queue, unsigned int q)
+{
+	struct page_pool_params pp_params = { 0 };
+	struct macb *bp = queue->bp;
+	unsigned int len;
+	int err;
+
+	len = SKB_DATA_ALIGN(GEM_RX_HEADROOM + bp->rx_buffer_size) +
+	      SKB_DATA_ALIGN(sizeof(struct skb_shared_info));
+
+	pp_params.flags = PP_FLAG_DMA_MAP | PP_FLAG_DMA_SYNC_DEV;
+	pp_params.order = get_order(len);
+	pp_params.pool_size = bp->rx_ring_size;
+	pp_params.nid = dev_to_node(&bp->pdev->dev);
+	pp_params.dev = &bp->pdev->dev;
+	pp_params.dma_dir = DMA_FROM_DEVICE;
+	pp_params.offset = GEM_RX_HEADROOM;
+	pp_params.max_len = bp->rx_buffer_size;
+
+	queue->page_pool = page_pool_create(&pp_params);
+	if (IS_ERR(queue->page_pool)) {
+		err = PTR_ERR(queue->page_pool);
+		queue->page_pool = NULL;
+		return err;
+	}
+
+	err = xdp_rxq_info_reg(&queue->xdp_rxq, bp->dev, q,
+			       queue->napi_rx.napi_id);
+	if (err)
+		goto err_destroy_pool;
+
+	err = xdp_rxq_info_reg_mem_model(&queue->xdp_rxq, MEM_TYPE_PAGE_POOL,
+					 queue->page_pool);
+	if (err)
+		goto err_unreg_rxq;
+
+	return 0;
+
+err_unreg_rxq:
+	xdp_rxq_info_unreg(&queue->xdp_rxq);
+err_destroy_pool:
+	page_pool_destroy(queue->page_pool);
+	queue->page_pool = NULL;
+	return err;
+}
+
 static int gem_alloc_rx_buffers(struct macb *bp)
 {
 	struct macb_queue *queue;
@@ -2473,14 +2597,17 @@ static int gem_alloc_rx_buffers(struct macb *bp)
 	int size;
 
 	for (q = 0, queue = bp->queues; q < bp->num_queues; ++q, ++queue) {
-		size = bp->rx_ring_size * sizeof(struct sk_buff *);
-		queue->rx_skbuff = kzalloc(size, GFP_KERNEL);
-		if (!queue->rx_skbuff)
+		size = bp->rx_ring_size * sizeof(struct page *);
+		queue->rx_page = kzalloc(size, GFP_KERNEL);
+		if (!queue->rx_page)
 			return -ENOMEM;
 		else
 			netdev_dbg(bp->dev,
-				   "Allocated %d RX struct sk_buff entries at %p\n",
-				   bp->rx_ring_size, queue->rx_skbuff);
+				   "Allocated %d RX page entries at %p\n",
+				   bp->rx_ring_size, queue->rx_page);
+
+		if (gem_create_page_pool(queue, q))
+			return -ENOMEM;
 	}
 	return 0;
 }
@@ -2804,6 +2931,8 @@ static void macb_init_hw(struct macb *bp)
 			   GEM_BIT(ENCUTTHRU));
 	}
 
+	if (bp->caps & MACB_CAPS_INT_MODERATION)
+		gem_writel(bp, IMOD, bp->intr_mod);
 }
 
 /* The hash address register is 64 bits long and takes up two
@@ -2925,6 +3054,28 @@ static void macb_set_rx_mode(struct net_device *dev)
 	macb_writel(bp, NCFGR, cfg);
 }
 
+/* Spread the queue interrupts over the CPUs close to the device, so that
+ * the traffic steered to a queue is handled on a CPU of its own. Queues
+ * sharing an interrupt line keep the affinity of the first one.
+ */
+static void macb_set_irq_affinity(struct macb *bp, bool spread)
+{
+	int node = dev_to_node(&bp->pdev->dev);
+	struct macb_queue *queue;
+	unsigned int q;
+
+	for (q = 0, queue = bp->queues; q < bp->num_queues; ++q, ++queue) {
+		if (q && queue->irq == queue[-1].irq)
+			continue;
+
+		if (spread)
+			irq_set_affinity_and_hint(queue->irq,
+						  cpumask_of(cpumask_local_spread(q, node)));
+		else
+			irq_update_affinity_hint(queue->irq, NULL);
+	}
+}
+
 static int macb_open(struct net_device *dev)
 {
 	size_t bufsz = dev->mtu + ETH_HLEN + ETH_FCS_LEN + NET_IP_ALIGN;
@@ -2964,6 +3115,8 @@ static int macb_open(struct net_device *dev)
 	if (err)
 		goto phy_off;
 
+	macb_set_irq_affinity(bp, true);
+
 	netif_tx_start_all_queues(dev);
 
 	if (bp->ptp_info)
@@ -3000,6 +3153,8 @@ static int macb_close(struct net_device *dev)
 		napi_disable(&queue->napi_tx);
 	}
 
+	macb_set_irq_affinity(bp, false);
+
 	phylink_stop(bp->phylink);
 	phylink_disconnect_phy(bp->phylink);
 
@@ -3020,16 +3175,62 @@ static int macb_close(struct net_device *dev)
 	return 0;
 }
 
+/* XDP programs see the whole Rx buffer of a frame, it has to fit in one
+ * page pool page together with the headroom and the skb_shared_info.
+ */
+static bool gem_xdp_mtu_ok(int mtu)
+{
+	size_t bufsz = roundup(mtu + ETH_HLEN + ETH_FCS_LEN + NET_IP_ALIGN,
+			       RX_BUFFER_MULTIPLE);
+
+	return SKB_DATA_ALIGN(GEM_RX_HEADROOM + bufsz) +
+	       SKB_DATA_ALIGN(sizeof(struct skb_shared_info)) <= PAGE_SIZE;
+}
+
 static int macb_change_mtu(struct net_device *dev, int new_mtu)
 {
+	struct macb *bp = netdev_priv(dev);
+
 	if (netif_running(dev))
 		return -EBUSY;
 
+	if (bp->xdp_prog && !gem_xdp_mtu_ok(new_mtu)) {
+		netdev_err(dev, "MTU %d too large for XDP\n", new_mtu);
+		return -EINVAL;
+	}
+
 	dev->mtu = new_mtu;
 
 	return 0;
 }
 
+/* Rx buffers always have the XDP headroom and are only read by the CPU for
+ * the supported actions, so a program is swapped without restarting.
+ */
+static int gem_bpf(struct net_device *dev, struct netdev_bpf *bpf)
+{
+	struct macb *bp = netdev_priv(dev);
+	struct bpf_prog *old_prog;
+
+	if (!macb_is_gem(bp))
+		return -EOPNOTSUPP;
+
+	switch (bpf->command) {
+	case XDP_SETUP_PROG:
+		if (bpf->prog && !gem_xdp_mtu_ok(dev->mtu)) {
+			NL_SET_ERR_MSG_MOD(bpf->extack,
+					   "MTU too large for XDP");
+			return -EOPNOTSUPP;
+		}
+		old_prog = xchg(&bp->xdp_prog, bpf->prog);
+		if (old_prog)
+			bpf_prog_put(old_prog);
+		return 0;
+	default:
+		return -EINVAL;
+	}
+}
+
 static void gem_update_stats(struct macb *bp)
 {
 	struct macb_queue *queue;
@@ -3335,6 +3536,59 @@ static int macb_set_ringparam(struct net_device *netdev,
 	return 0;
 }
 
+/* The moderation timers count in 800ns units and are shared by all the
+ * queues, there is no per queue setting in the hardware.
+ */
+#define GEM_IMOD_UNIT_NS	800
+
+static int gem_get_coalesce(struct net_device *netdev,
+			    struct ethtool_coalesce *ec,
+			    struct kernel_ethtool_coalesce *kernel_coal,
+			    struct netlink_ext_ack *extack)
+{
+	struct macb *bp = netdev_priv(netdev);
+
+	if (!(bp->caps & MACB_CAPS_INT_MODERATION))
+		return -EOPNOTSUPP;
+
+	ec->rx_coalesce_usecs = GEM_BFEXT(RXMOD, bp->intr_mod) *
+				GEM_IMOD_UNIT_NS / NSEC_PER_USEC;
+	ec->tx_coalesce_usecs = GEM_BFEXT(TXMOD, bp->intr_mod) *
+				GEM_IMOD_UNIT_NS / NSEC_PER_USEC;
+
+	return 0;
+}
+
+static int gem_set_coalesce(struct net_device *netdev,
+			    struct ethtool_coalesce *ec,
+			    struct kernel_ethtool_coalesce *kernel_coal,
+			    struct netlink_ext_ack *extack)
+{
+	struct macb *bp = netdev_priv(netdev);
+	u32 rx_mod, tx_mod;
+
+	if (!(bp->caps & MACB_CAPS_INT_MODERATION))
+		return -EOPNOTSUPP;
+
+	rx_mod = DIV_ROUND_UP(ec->rx_coalesce_usecs * NSEC_PER_USEC,
+			      GEM_IMOD_UNIT_NS);
+	tx_mod = DIV_ROUND_UP(ec->tx_coalesce_usecs * NSEC_PER_USEC,
+			      GEM_IMOD_UNIT_NS);
+	if (rx_mod > GENMASK(GEM_RXMOD_SIZE - 1, 0) ||
+	    tx_mod > GENMASK(GEM_TXMOD_SIZE - 1, 0)) {
+		NL_SET_ERR_MSG_MOD(extack, "coalesce usecs out of range");
+		return -EINVAL;
+	}
+
+	bp->intr_mod = GEM_BF(RXMOD, rx_mod) | GEM_BF(TXMOD, tx_mod);
+
+	/* registers are not accessible while the device is suspended */
+	if (netif_running(netdev))
+		gem_writel(bp, IMOD, bp->intr_mod);
+
+	return 0;
+}
+
 #ifdef CONFIG_MACB_USE_HWSTAMP
 static unsigned int gem_get_tsu_rate(struct macb *bp)
 {
@@ -3410,6 +3664,59 @@ static int macb_get_ts_info(struct net_device *netdev,
 	return ethtool_op_get_ts_info(netdev, info);
 }
 
+/* Type 1 screeners match the IPv4 DS field and/or the UDP destination port
+ * of a frame, nothing else. Rules in the locations behind the type 2
+ * screeners must fit in one.
+ */
+static bool gem_flow_fits_t1(struct ethtool_rx_flow_spec *fs)
+{
+	struct ethtool_usrip4_spec *usr_m = &fs->m_u.usr_ip4_spec;
+	struct ethtool_tcpip4_spec *tp4sp_m = &fs->m_u.tcp_ip4_spec;
+
+	if (fs->flow_type & (FLOW_EXT | FLOW_MAC_EXT))
+		return false;
+
+	switch (fs->flow_type) {
+	case IP_USER_FLOW:
+		return !usr_m->ip4src && !usr_m->ip4dst &&
+		       !usr_m->l4_4_bytes && !usr_m->ip_ver &&
+		       !usr_m->proto && usr_m->tos == 0xFF;
+	case UDP_V4_FLOW:
+		return !tp4sp_m->ip4src && !tp4sp_m->ip4dst &&
+		       !tp4sp_m->psrc && tp4sp_m->pdst == 0xFFFF &&
+		       (!tp4sp_m->tos || tp4sp_m->tos == 0xFF);
+	default:
+		return false;
+	}
+}
+
+static void gem_prog_t1_scr(struct macb *bp, struct ethtool_rx_flow_spec *fs,
+			    bool enable)
+{
+	u32 t1_scr = 0;
+	u8 tos_m, tos;
+
+	t1_scr = GEM_BFINS(QUEUE, (fs->ring_cookie) & 0xFF, t1_scr);
+
+	if (fs->flow_type == IP_USER_FLOW) {
+		tos = fs->h_u.usr_ip4_spec.tos;
+		tos_m = fs->m_u.usr_ip4_spec.tos;
+	} else {
+		tos = fs->h_u.udp_ip4_spec.tos;
+		tos_m = fs->m_u.udp_ip4_spec.tos;
+		t1_scr = GEM_BFINS(UDPM, be16_to_cpu(fs->h_u.udp_ip4_spec.pdst),
+				   t1_scr);
+		t1_scr = GEM_BFINS(UDPE, enable, t1_scr);
+	}
+
+	if (tos_m) {
+		t1_scr = GEM_BFINS(DSTCM, tos, t1_scr);
+		t1_scr = GEM_BFINS(DSTCE, enable, t1_scr);
+	}
+
+	gem_writel_n(bp, SCRT1, fs->location - bp->max_tuples, t1_scr);
+}
+
 static void gem_enable_flow_filters(struct macb *bp, bool enable)
 {
 	struct net_device *netdev = bp->dev;
@@ -3426,6 +3733,11 @@ static void gem_enable_flow_filters(struct macb *bp, bool enable)
 		struct ethtool_rx_flow_spec *fs = &item->fs;
 		struct ethtool_tcpip4_spec *tp4sp_m;
 
+		if (fs->location >= bp->max_tuples) {
+			gem_prog_t1_scr(bp, fs, enable);
+			continue;
+		}
+
 		if (fs->location >= num_t2_scr)
 			continue;
 
@@ -3468,6 +3780,12 @@ static void gem_prog_cmp_regs(struct macb *bp, struct ethtool_rx_flow_spec *fs)
 	if (!macb_is_gem(bp))
 		return;
 
+	/* type 1 screeners are armed by gem_enable_flow_filters() */
+	if (index >= bp->max_tuples) {
+		gem_prog_t1_scr(bp, fs, false);
+		return;
+	}
+
 	tp4sp_v = &(fs->h_u.tcp_ip4_spec);
 	tp4sp_m = &(fs->m_u.tcp_ip4_spec);
 
@@ -3616,7 +3934,11 @@ static int gem_del_flow_filter(struct net_device *netdev,
 					be16_to_cpu(fs->h_u.tcp_ip4_spec.psrc),
 					be16_to_cpu(fs->h_u.tcp_ip4_spec.pdst));
 
-			gem_writel_n(bp, SCRT2, fs->location, 0);
+			if (fs->location >= bp->max_tuples)
+				gem_writel_n(bp, SCRT1,
+					     fs->location - bp->max_tuples, 0);
+			else
+				gem_writel_n(bp, SCRT2, fs->location, 0);
 
 			list_del(&item->list);
 			bp->rx_fs_list.count--;
@@ -3658,7 +3980,7 @@ static int gem_get_all_flow_entries(struct net_device *netdev,
 		rule_locs[cnt] = item->fs.location;
 		cnt++;
 	}
-	cmd->data = bp->max_tuples;
+	cmd->data = bp->max_tuples + bp->max_t1_tuples;
 	cmd->rule_cnt = cnt;
 
 	return 0;
@@ -3699,11 +4021,19 @@ static int gem_set_rxnfc(struct net_device *netdev, struct ethtool_rxnfc *cmd)
 
 	switch (cmd->cmd) {
 	case ETHTOOL_SRXCLSRLINS:
-		if ((cmd->fs.location >= bp->max_tuples)
+		if ((cmd->fs.location >= bp->max_tuples + bp->max_t1_tuples)
 				|| (cmd->fs.ring_cookie >= bp->num_queues)) {
 			ret = -EINVAL;
 			break;
 		}
+		if (cmd->fs.location >= bp->max_tuples &&
+		    !gem_flow_fits_t1(&cmd->fs)) {
+			netdev_err(netdev,
+				   "Rule at location %u may only match the DS field or the UDP destination port\n",
+				   cmd->fs.location);
+			ret = -EINVAL;
+			break;
+		}
 		ret = gem_add_flow_filter(netdev, cmd);
 		break;
 	case ETHTOOL_SRXCLSRLDEL:
@@ -3730,6 +4060,7 @@ static const struct ethtool_ops macb_ethtool_ops = {
 };
 
 static const struct ethtool_ops gem_ethtool_ops = {
+	.supported_coalesce_params = ETHTOOL_COALESCE_USECS,
 	.get_regs_len		= macb_get_regs_len,
 	.get_regs		= macb_get_regs,
 	.get_link		= ethtool_op_get_link,
@@ -3741,6 +4072,8 @@ static const struct ethtool_ops gem_ethtool_ops = {
 	.set_link_ksettings     = macb_set_link_ksettings,
 	.get_ringparam		= macb_get_ringparam,
 	.set_ringparam		= macb_set_ringparam,
+	.get_coalesce		= gem_get_coalesce,
+	.set_coalesce		= gem_set_coalesce,
 	.get_rxnfc			= gem_get_rxnfc,
 	.set_rxnfc			= gem_set_rxnfc,
 	.get_wol		= macb_get_wol,
@@ -3859,6 +4192,7 @@ static const struct net_device_ops macb_netdev_ops = {
 	.ndo_eth_ioctl		= macb_ioctl,
 	.ndo_validate_addr	= eth_validate_addr,
 	.ndo_change_mtu		= macb_change_mtu,
+	.ndo_bpf		= gem_bpf,
 	.ndo_set_mac_address	= eth_mac_addr,
 #ifdef CONFIG_NET_POLL_CONTROLLER
 	.ndo_poll_controller	= macb_poll_controller,
@@ -4164,7 +4498,12 @@ static int macb_init(struct platform_device *pdev)
 	reg = gem_readl(bp, DCFG8);
 	bp->max_tuples = min((GEM_BFEXT(SCR2CMP, reg) / 3),
 			GEM_BFEXT(T2SCR, reg));
+	/* DS field and UDP port rules only need a type 1 screener */
+	bp->max_t1_tuples = macb_is_gem(bp) ? GEM_BFEXT(T1SCR, reg) : 0;
 	INIT_LIST_HEAD(&bp->rx_fs_list.list);
+	/* init Rx flow definitions */
+	bp->rx_fs_list.count = 0;
+	spin_lock_init(&bp->rx_fs_lock);
 	if (bp->max_tuples > 0) {
 		/* also needs one ethtype match to check IPv4 */
 		if (GEM_BFEXT(SCR2ETH, reg) > 0) {
@@ -4172,14 +4511,12 @@ static int macb_init(struct platform_device *pdev)
 			reg = 0;
 			reg = GEM_BFINS(ETHTCMP, (uint16_t)ETH_P_IP, reg);
 			gem_writel_n(bp, ETHT, SCRT2_ETHT, reg);
-			/* Filtering is supported in hw but don't enable it in kernel now */
-			dev->hw_features |= NETIF_F_NTUPLE;
-			/* init Rx flow definitions */
-			bp->rx_fs_list.count = 0;
-			spin_lock_init(&bp->rx_fs_lock);
 		} else
 			bp->max_tuples = 0;
 	}
+	/* Filtering is supported in hw but don't enable it in kernel now */
+	if (bp->max_tuples + bp->max_t1_tuples > 0)
+		dev->hw_features |= NETIF_F_NTUPLE;
 
 	if (!(bp->caps & MACB_CAPS_USRIO_DISABLED)) {
 		val = 0;
@@ -4846,7 +5183,8 @@ static const struct macb_config zynqmp_config = {
 	.caps = MACB_CAPS_GIGABIT_MODE_AVAILABLE |
 		MACB_CAPS_JUMBO |
 		MACB_CAPS_GEM_HAS_PTP | MACB_CAPS_BD_RD_PREFETCH |
-		MACB_CAPS_PARTIAL_STORE_FORWARD | MACB_CAPS_WOL,
+		MACB_CAPS_PARTIAL_STORE_FORWARD | MACB_CAPS_WOL |
+		MACB_CAPS_INT_MODERATION,
 	.dma_burst_length = 16,
 	.clk_init = macb_clk_init,
 	.init = init_reset_optional,
@@ -4896,7 +5234,8 @@ static const struct macb_config versal_config = {
 	.caps = MACB_CAPS_GIGABIT_MODE_AVAILABLE | MACB_CAPS_JUMBO |
 		MACB_CAPS_GEM_HAS_PTP | MACB_CAPS_BD_RD_PREFETCH | 
 		MACB_CAPS_NEED_TSUCLK | MACB_CAPS_PARTIAL_STORE_FORWARD |
-		MACB_CAPS_WOL | MACB_CAPS_QUEUE_DISABLE,
+		MACB_CAPS_WOL | MACB_CAPS_QUEUE_DISABLE |
+		MACB_CAPS_INT_MODERATION,
 	.dma_burst_length = 16,
 	.clk_init = macb_clk_init,
 	.init = init_reset_optional,
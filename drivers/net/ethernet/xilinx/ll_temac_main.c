@@ -967,21 +967,19 @@ static int ll_temac_recv_buffers_available(struct temac_local *lp)
 	return available;
 }
 
-static void ll_temac_recv(struct net_device *ndev)
+static int ll_temac_recv(struct net_device *ndev, int budget)
 {
 	struct temac_local *lp = netdev_priv(ndev);
-	unsigned long flags;
 	int rx_bd;
+	int work_done = 0;
 	bool update_tail = false;
 
-	spin_lock_irqsave(&lp->rx_lock, flags);
-
-	/* Process all received buffers, passing them on network
+	/* Process up to budget received buffers, passing them on network
 	 * stack.  After this, the buffer descriptors will be in an
 	 * un-allocated stage, where no skb is allocated for it, and
 	 * they are therefore not available for TEMAC/DMA.
 	 */
-	do {
+	while (work_done < budget) {
 		struct cdmac_bd *bd = &lp->rx_bd_v[lp->rx_bd_ci];
 		struct sk_buff *skb = lp->rx_skb[lp->rx_bd_ci];
 		unsigned int bdstat = be32_to_cpu(bd->app0);
@@ -1023,17 +1021,20 @@ static void ll_temac_recv(struct net_device *ndev)
 		}
 
 		if (!skb_defer_rx_timestamp(skb))
-			netif_rx(skb);
+			napi_gro_receive(&lp->napi, skb);
 		/* The skb buffer is now owned by network stack above */
 		lp->rx_skb[lp->rx_bd_ci] = NULL;
 
 		ndev->stats.rx_packets++;
 		ndev->stats.rx_bytes += length;
+		work_done++;
 
 		rx_bd = lp->rx_bd_ci;
 		if (++lp->rx_bd_ci >= lp->rx_bd_num)
 			lp->rx_bd_ci = 0;
-	} while (rx_bd != lp->rx_bd_tail);
+		if (rx_bd == lp->rx_bd_tail)
+			break;
+	}
 
 	/* DMA operations will halt when the last buffer descriptor is
 	 * processed (ie. the one pointed to by RX_TAILDESC_PTR).
@@ -1041,7 +1042,7 @@ static void ll_temac_recv(struct net_device *ndev)
 	 * generated.  No IRQ_COAL or IRQ_DLY, and not even an
 	 * IRQ_ERR.  To avoid stalling, we schedule a delayed work
 	 * when there is a potential risk of that happening.  The work
-	 * will call this function, and thus re-schedule itself until
+	 * will schedule NAPI, and thus re-schedule itself until
 	 * enough buffers are available again.
 	 */
 	if (ll_temac_recv_buffers_available(lp) < lp->coalesce_count_rx)
@@ -1051,7 +1052,7 @@ static void ll_temac_recv(struct net_device *ndev)
 	 * passed to network stack.  Note that GFP_ATOMIC allocations
 	 * can fail (e.g. when a larger burst of GFP_ATOMIC
 	 * allocations occurs), so while we try to allocate all
-	 * buffers in the same interrupt where they were processed, we
+	 * buffers in the same poll where they were processed, we
 	 * continue with what we could get in case of allocation
 	 * failure.  Allocation of remaining buffers will be retried
 	 * in following calls.
@@ -1069,7 +1070,7 @@ static void ll_temac_recv(struct net_device *ndev)
 		if (bd->phys)
 			break;	/* All skb's allocated */
 
-		skb = netdev_alloc_skb_ip_align(ndev, XTE_MAX_JUMBO_FRAME_SIZE);
+		skb = napi_alloc_skb(&lp->napi, XTE_MAX_JUMBO_FRAME_SIZE);
 		if (!skb) {
 			dev_warn(&ndev->dev, "skb alloc failed\n");
 			break;
@@ -1099,7 +1100,31 @@ static void ll_temac_recv(struct net_device *ndev)
 			lp->rx_bd_p + sizeof(*lp->rx_bd_v) * lp->rx_bd_tail);
 	}
 
-	spin_unlock_irqrestore(&lp->rx_lock, flags);
+	return work_done;
+}
+
+/* The RX interrupt stays disabled while NAPI is scheduled, every
+ * successful schedule is balanced by the enable_irq() in ll_temac_poll().
+ */
+static void ll_temac_rx_schedule(struct temac_local *lp)
+{
+	if (napi_schedule_prep(&lp->napi)) {
+		disable_irq_nosync(lp->rx_irq);
+		__napi_schedule(&lp->napi);
+	}
+}
+
+static int ll_temac_poll(struct napi_struct *napi, int budget)
+{
+	struct temac_local *lp = container_of(napi, struct temac_local, napi);
+	int work_done;
+
+	work_done = ll_temac_recv(lp->ndev, budget);
+
+	if (work_done < budget && napi_complete_done(napi, work_done))
+		enable_irq(lp->rx_irq);
+
+	return work_done;
 }
 
 /* Function scheduled to ensure a restart in case of DMA halt
@@ -1109,9 +1134,10 @@ static void ll_temac_restart_work_func(struct work_struct *work)
 {
 	struct temac_local *lp = container_of(work, struct temac_local,
 					      restart_work.work);
-	struct net_device *ndev = lp->ndev;
 
-	ll_temac_recv(ndev);
+	local_bh_disable();
+	ll_temac_rx_schedule(lp);
+	local_bh_enable();
 }
 
 static irqreturn_t ll_temac_tx_irq(int irq, void *_ndev)
@@ -1144,7 +1170,7 @@ static irqreturn_t ll_temac_rx_irq(int irq, void *_ndev)
 	lp->dma_out(lp, RX_IRQ_REG, status);
 
 	if (status & (IRQ_COAL | IRQ_DLY))
-		ll_temac_recv(lp->ndev);
+		ll_temac_rx_schedule(lp);
 	if (status & (IRQ_ERR | IRQ_DMAERR))
 		dev_err_ratelimited(&ndev->dev,
 				    "RX error 0x%x RX_CHNL_STS=0x%08x\n",
@@ -1181,6 +1207,8 @@ static int temac_open(struct net_device *ndev)
 
 	temac_device_reset(ndev);
 
+	napi_enable(&lp->napi);
+
 	rc = request_irq(lp->tx_irq, ll_temac_tx_irq, 0, ndev->name, ndev);
 	if (rc)
 		goto err_tx_irq;
@@ -1193,6 +1221,7 @@ static int temac_open(struct net_device *ndev)
  err_rx_irq:
 	free_irq(lp->tx_irq, ndev);
  err_tx_irq:
+	napi_disable(&lp->napi);
 	if (phydev)
 		phy_disconnect(phydev);
 	dev_err(lp->dev, "request_irq() failed\n");
@@ -1206,6 +1235,8 @@ static int temac_stop(struct net_device *ndev)
 
 	dev_dbg(&ndev->dev, "temac_close()\n");
 
+	/* NAPI may still re-arm the restart work, stop it first */
+	napi_disable(&lp->napi);
 	cancel_delayed_work_sync(&lp->restart_work);
 
 	free_irq(lp->tx_irq, ndev);
@@ -1424,7 +1455,7 @@ static int temac_probe(struct platform_device *pdev)
 	lp->options = XTE_OPTION_DEFAULTS;
 	lp->rx_bd_num = RX_BD_NUM_DEFAULT;
 	lp->tx_bd_num = TX_BD_NUM_DEFAULT;
-	spin_lock_init(&lp->rx_lock);
+	netif_napi_add(ndev, &lp->napi, ll_temac_poll);
 	INIT_DELAYED_WORK(&lp->restart_work, ll_temac_restart_work_func);
 
 	/* Setup mutex for synchronization of indirect register access */
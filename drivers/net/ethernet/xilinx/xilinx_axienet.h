@@ -18,6 +18,11 @@
 #include <linux/phylink.h>
 #include <linux/net_tstamp.h>
 #include <linux/of_platform.h>
+#include <linux/bpf.h>
+#include <linux/dim.h>
+#include <net/page_pool.h>
+#include <net/xdp.h>
+#include <net/xdp_sock_drv.h>
 
 /* Packet size info */
 #define XAE_HDR_SIZE			14 /* Size of Ethernet header */
@@ -29,6 +34,11 @@
 #define XAE_MAX_VLAN_FRAME_SIZE  (XAE_MTU + VLAN_ETH_HLEN + XAE_TRL_SIZE)
 #define XAE_MAX_JUMBO_FRAME_SIZE (XAE_JUMBO_MTU + XAE_HDR_SIZE + XAE_TRL_SIZE)
 
+/* Headroom reserved in front of each page pool Rx buffer, large enough for
+ * an XDP program to push headers.
+ */
+#define XAE_RX_HEADROOM		XDP_PACKET_HEADROOM
+
 /* DMA address width min and max range */
 #define XAE_DMA_MASK_MIN	32
 #define XAE_DMA_MASK_MAX	64
@@ -673,12 +683,22 @@ struct aximcdma_bd {
 #define XAE_NUM_MISC_CLOCKS 3
 #define DESC_DMA_MAP_SINGLE 0
 #define DESC_DMA_MAP_PAGE 1
+/* XDP_TX of a page pool buffer; tx_skb holds the xdp_frame, no unmap needed */
+#define DESC_DMA_MAP_XDP_TX 2
+/* ndo_xdp_xmit frame; tx_skb holds the xdp_frame, mapped with dma_map_single */
+#define DESC_DMA_MAP_XDP_NDO 3
+/* AF_XDP zero-copy Tx descriptor, completed through the XSK pool */
+#define DESC_DMA_MAP_XSK 4
 
 #if defined(CONFIG_AXIENET_HAS_MCDMA)
 #define XAE_MAX_QUEUES		16
 #else
 #define XAE_MAX_QUEUES		1
 #endif
+
+/* Latency histograms: bucket 0 is below 1us, each following one doubles */
+#define AXIENET_LAT_BUCKETS	16
+#define AXIENET_LAT_MIN_NS	1024
 /**
  * struct axienet_local - axienet private per device data
  * @ndev:	Pointer for net_device to which it will be attached.
@@ -697,6 +717,7 @@ struct aximcdma_bd {
  * @regs:	Base address for the axienet_local device address space
  * @mcdma_regs:	Base address for the aximcdma device address space
  * @napi:	Napi Structure array for all dma queues
+ * @napi_tx:	Napi Structure array for Tx completion of all dma queues
  * @num_tx_queues: Total number of Tx DMA queues
  * @num_rx_queues: Total number of Rx DMA queues
  * @dq:		DMA queues data
@@ -725,6 +746,8 @@ struct aximcdma_bd {
  * @rx_ts_regs:	  Base address for the rx axififo device address space.
  * @tstamp_config: Hardware timestamp config structure.
  * @tx_ptpheader: Stores the tx ptp header.
+ * @ptp_txq: Skbs waiting for their tx timestamp to be read from the FIFO.
+ * @ptp_txts_timer: Retries reading the tx timestamps still pending.
  * @aclk: AXI4-Lite clock for ethernet and dma.
  * @eth_sclk: AXI4-Stream interface clock.
  * @eth_refclk: Stable clock used by signal delay primitives and transceivers.
@@ -736,6 +759,8 @@ struct aximcdma_bd {
  * @chan_num: MCDMA Channel number to be operate on.
  * @chan_id:  MCMDA Channel id used in conjunction with weight parameter.
  * @weight:   MCDMA Channel weight value to be configured for.
+ * @tx_weight_saved: MCDMA Tx weight registers from before mqprio offload.
+ * @tx_weight_offload: Tx weights are programmed by an offloaded mqprio.
  * @dma_mask: Specify the width of the DMA address space.
  * @usxgmii_rate: USXGMII PHY speed.
  * @mrmac_rate: MRMAC speed.
@@ -745,6 +770,8 @@ struct aximcdma_bd {
  * @gt_lane: MRMAC GT lane index used.
  * @ptp_os_cf: CF TS of PTP PDelay req for one step usage.
  * @xxv_ip_version: XXV IP version
+ * @xdp_prog: XDP program attached to the interface, NULL if none.
+ * @debugfs_dir: debugfs directory holding the latency histograms.
  */
 struct axienet_local {
 	struct net_device *ndev;
@@ -770,6 +797,7 @@ struct axienet_local {
 
 	struct tasklet_struct dma_err_tasklet[XAE_MAX_QUEUES];
 	struct napi_struct napi[XAE_MAX_QUEUES];	/* NAPI Structure */
+	struct napi_struct napi_tx[XAE_MAX_QUEUES];	/* Tx NAPI Structure */
 
 	u16    num_tx_queues;	/* Number of TX DMA queues */
 	u16    num_rx_queues;	/* Number of RX DMA queues */
@@ -804,6 +832,8 @@ struct axienet_local {
 	void __iomem *rx_ts_regs;
 	struct hwtstamp_config tstamp_config;
 	u8 *tx_ptpheader;
+	struct sk_buff_head ptp_txq;
+	struct timer_list ptp_txts_timer;
 #endif
 	struct clk *aclk;
 	struct clk *eth_sclk;
@@ -819,6 +849,8 @@ struct axienet_local {
 	/* WRR Fields */
 	u16 chan_id;
 	u16 weight;
+	u32 tx_weight_saved[2];
+	bool tx_weight_offload;
 
 	u8 dma_mask;
 	u32 usxgmii_rate;
@@ -830,6 +862,11 @@ struct axienet_local {
 	u32 gt_lane;		/* MRMAC GT lane index used */
 	u64 ptp_os_cf;		/* CF TS of PTP PDelay req for one step usage */
 	u32 xxv_ip_version;
+
+	struct bpf_prog *xdp_prog;
+#ifdef CONFIG_XILINX_AXI_EMAC_LAT_HIST
+	struct dentry *debugfs_dir;
+#endif
 };
 
 /**
@@ -857,14 +894,41 @@ struct axienet_local {
  *		completed.
  * @rx_bd_ci:	Stores the index of the Rx buffer descriptor in the ring being
  *		accessed currently.
+ * @tx_tail_pending: Tx BDs were queued with netdev_xmit_more() set and the
+ *		tail pointer has not been written for them yet.
+ * @page_pool:	Page pool backing the Rx buffers of this queue. Pages are
+ *		kept DMA mapped and recycled through build_skb().
+ * @xdp_rxq:	XDP Rx queue info registered against @page_pool, or against
+ *		@xsk_pool in AF_XDP zero-copy mode.
  * @chan_id:    MCDMA channel to operate on.
  * @rx_offset:	MCDMA S2MM channel starting offset.
  * @txq_bd_v:	Virtual address of the MCDMA TX buffer descriptor ring
  * @rxq_bd_v:	Virtual address of the MCDMA RX buffer descriptor ring
+ * @xsk_pool:	AF_XDP buffer pool bound to this MCDMA channel, NULL if none.
+ * @rx_bd_tail:	Index of the next Rx BD to refill from @xsk_pool. BDs from
+ *		@rx_bd_ci up to here are owned by the hardware.
+ * @rx_dim:	DIM state of the Rx channel.
+ * @tx_dim:	DIM state of the Tx channel.
+ * @rx_dim_enabled: Adaptive Rx interrupt moderation is enabled.
+ * @tx_dim_enabled: Adaptive Tx interrupt moderation is enabled.
+ * @rx_dim_events: Rx NAPI completions, sampled by DIM.
+ * @tx_dim_events: Tx NAPI completions, sampled by DIM.
+ * @rx_coalesce_cr: Coalesce count and delay timer fields written to the Rx
+ *		channel control register whenever NAPI re-enables its irqs.
+ * @tx_coalesce_cr: Same as @rx_coalesce_cr for the Tx channel.
  * @tx_packets: Number of transmit packets processed by the dma queue.
  * @tx_bytes:   Number of transmit bytes processed by the dma queue.
  * @rx_packets: Number of receive packets processed by the dma queue.
  * @rx_bytes:	Number of receive bytes processed by the dma queue.
+ * @rx_alloc_fail: Rx polls stopped early because no buffer could be
+ *		allocated to refill the ring.
+ * @tx_ring_full: Transmissions that found the Tx BD ring full.
+ * @rx_napi_full: Rx polls that used up their whole NAPI budget.
+ * @rx_irq_ns:	Time of the last Rx interrupt, 0 once NAPI has run.
+ * @rx_poll_ns:	Start time of the current Rx NAPI poll.
+ * @irq_napi_hist: Log2 histogram of Rx interrupt to NAPI poll latency.
+ * @napi_rx_hist: Log2 histogram of NAPI poll start to stack hand-off
+ *		latency, per frame.
  */
 struct axienet_dma_q {
 	struct axienet_local	*lp; /* parent */
@@ -890,20 +954,46 @@ struct axienet_dma_q {
 	u32 tx_bd_ci;
 	u32 rx_bd_ci;
 	u32 tx_bd_tail;
+	bool tx_tail_pending;
+
+	struct page_pool *page_pool;
+	struct xdp_rxq_info xdp_rxq;
 
 	/* MCDMA fields */
 	u16 chan_id;
 	u32 rx_offset;
 	struct aximcdma_bd *txq_bd_v;
 	struct aximcdma_bd *rxq_bd_v;
+	struct xsk_buff_pool *xsk_pool;
+	u32 rx_bd_tail;
+
+	struct dim rx_dim;
+	struct dim tx_dim;
+	bool rx_dim_enabled;
+	bool tx_dim_enabled;
+	u16 rx_dim_events;
+	u16 tx_dim_events;
+	u32 rx_coalesce_cr;
+	u32 tx_coalesce_cr;
 
 	unsigned long tx_packets;
 	unsigned long tx_bytes;
 	unsigned long rx_packets;
 	unsigned long rx_bytes;
+	unsigned long rx_alloc_fail;
+	unsigned long tx_ring_full;
+	unsigned long rx_napi_full;
+
+#ifdef CONFIG_XILINX_AXI_EMAC_LAT_HIST
+	u64 rx_irq_ns;
+	u64 rx_poll_ns;
+	u32 irq_napi_hist[AXIENET_LAT_BUCKETS];
+	u32 napi_rx_hist[AXIENET_LAT_BUCKETS];
+#endif
 };
 
 #define AXIENET_ETHTOOLS_SSTATS_LEN 6
+#define AXIENET_QUEUE_SSTATS_LEN 3
 #define AXIENET_TX_SSTATS_LEN(lp) ((lp)->num_tx_queues * 2)
 #define AXIENET_RX_SSTATS_LEN(lp) ((lp)->num_rx_queues * 2)
 
@@ -1136,6 +1226,76 @@ static inline void axienet_dma_bdout(struct axienet_dma_q *q,
 #endif
 }
 
+/**
+ * axienet_dma_txq - Get the netdev Tx queue served by a DMA queue
+ * @q:		Pointer to DMA queue structure
+ *
+ * Return: The netdev_queue used for BQL accounting of @q.
+ */
+static inline struct netdev_queue *axienet_dma_txq(struct axienet_dma_q *q)
+{
+	struct axienet_local *lp = q->lp;
+	int i;
+
+	for_each_tx_dma_queue(lp, i)
+		if (lp->dq[i] == q)
+			break;
+
+	return netdev_get_tx_queue(lp->ndev, i);
+}
+
+#ifdef CONFIG_XILINX_AXI_EMAC_LAT_HIST
+static inline void axienet_lat_record(u32 *hist, u64 start, u64 now)
+{
+	u64 delta = now - start;
+	unsigned int bucket = 0;
+
+	if (delta >= AXIENET_LAT_MIN_NS)
+		bucket = min_t(unsigned int,
+			       ilog2(delta) - ilog2(AXIENET_LAT_MIN_NS) + 1,
+			       AXIENET_LAT_BUCKETS - 1);
+	hist[bucket]++;
+}
+
+/**
+ * axienet_lat_rx_irq - Stamp an Rx interrupt
+ * @q:		Pointer to DMA queue structure
+ */
+static inline void axienet_lat_rx_irq(struct axienet_dma_q *q)
+{
+	q->rx_irq_ns = ktime_get_ns();
+}
+
+/**
+ * axienet_lat_rx_poll - Account the interrupt to NAPI latency
+ * @q:		Pointer to DMA queue structure
+ *
+ * Repolls without a new interrupt only restart the per-frame clock.
+ */
+static inline void axienet_lat_rx_poll(struct axienet_dma_q *q)
+{
+	q->rx_poll_ns = ktime_get_ns();
+	if (q->rx_irq_ns) {
+		axienet_lat_record(q->irq_napi_hist, q->rx_irq_ns,
+				   q->rx_poll_ns);
+		q->rx_irq_ns = 0;
+	}
+}
+
+/**
+ * axienet_lat_rx_frame - Account the NAPI to stack hand-off latency
+ * @q:		Pointer to DMA queue structure
+ */
+static inline void axienet_lat_rx_frame(struct axienet_dma_q *q)
+{
+	axienet_lat_record(q->napi_rx_hist, q->rx_poll_ns, ktime_get_ns());
+}
+#else
+static inline void axienet_lat_rx_irq(struct axienet_dma_q *q) { }
+static inline void axienet_lat_rx_poll(struct axienet_dma_q *q) { }
+static inline void axienet_lat_rx_frame(struct axienet_dma_q *q) { }
+#endif
+
 /* Function prototypes visible in xilinx_axienet_mdio.c for other files */
 int axienet_mdio_enable(struct axienet_local *lp);
 void axienet_mdio_disable(struct axienet_local *lp);
@@ -1143,17 +1303,24 @@ int axienet_mdio_setup(struct axienet_local *lp);
 void axienet_mdio_teardown(struct axienet_local *lp);
 void __maybe_unused axienet_bd_free(struct net_device *ndev,
 				    struct axienet_dma_q *q);
+int axienet_rx_page_pool_create(struct net_device *ndev,
+				struct axienet_dma_q *q);
+void axienet_rx_page_pool_destroy(struct axienet_dma_q *q);
+struct page *axienet_rx_alloc_page(struct axienet_dma_q *q,
+				   dma_addr_t *dma);
 int __maybe_unused axienet_dma_q_init(struct net_device *ndev,
 				      struct axienet_dma_q *q);
 void axienet_dma_err_handler(unsigned long data);
 irqreturn_t __maybe_unused axienet_tx_irq(int irq, void *_ndev);
 irqreturn_t __maybe_unused axienet_rx_irq(int irq, void *_ndev);
-void axienet_start_xmit_done(struct net_device *ndev, struct axienet_dma_q *q);
+void axienet_start_xmit_done(struct net_device *ndev, struct axienet_dma_q *q,
+			     struct netdev_queue *txq, int budget);
 void axienet_dma_bd_release(struct net_device *ndev);
 void __axienet_device_reset(struct axienet_dma_q *q);
 void axienet_set_mac_address(struct net_device *ndev, const void *address);
 void axienet_set_multicast_list(struct net_device *ndev);
 int xaxienet_rx_poll(struct napi_struct *napi, int quota);
+int axienet_tx_poll(struct napi_struct *napi, int budget);
 
 #if defined(CONFIG_AXIENET_HAS_MCDMA)
 int __maybe_unused axienet_mcdma_rx_q_init(struct net_device *ndev,
@@ -1180,15 +1347,32 @@ int __maybe_unused axienet_mcdma_tx_probe(struct platform_device *pdev,
 int __maybe_unused axienet_mcdma_rx_probe(struct platform_device *pdev,
 					  struct axienet_local *lp,
 					  struct net_device *ndev);
+int axienet_mcdma_xsk_pool_enable(struct net_device *ndev,
+				  struct xsk_buff_pool *pool, u16 qid);
+int axienet_mcdma_xsk_pool_disable(struct net_device *ndev, u16 qid);
+int axienet_mcdma_xsk_recv(struct napi_struct *napi, int budget,
+			   struct axienet_dma_q *q);
+bool axienet_mcdma_xsk_xmit(struct axienet_dma_q *q, int budget);
+int axienet_mcdma_xsk_wakeup(struct net_device *ndev, u32 qid, u32 flags);
+struct tc_mqprio_qopt_offload;
+int axienet_mcdma_setup_mqprio(struct net_device *ndev,
+			       struct tc_mqprio_qopt_offload *mqprio);
 #endif
+int axienet_xdp_xmit_frame(struct axienet_local *lp, struct axienet_dma_q *q,
+			   struct xdp_frame *xdpf, bool dma_map);
 
 #ifdef CONFIG_AXIENET_HAS_MCDMA
 void axienet_tx_hwtstamp(struct axienet_local *lp,
 			 struct aximcdma_bd *cur_p);
+void axienet_tx_bd_free_buf(struct net_device *ndev,
+			    struct aximcdma_bd *cur_p, int budget);
 #else
 void axienet_tx_hwtstamp(struct axienet_local *lp,
 			 struct axidma_bd *cur_p);
+void axienet_tx_bd_free_buf(struct net_device *ndev,
+			    struct axidma_bd *cur_p, int budget);
 #endif
+void axienet_tx_hwtstamp_drain(struct axienet_local *lp);
 u32 axienet_usec_to_timer(struct axienet_local *lp, u32 coalesce_usec);
 
 #endif /* XILINX_AXI_ENET_H */
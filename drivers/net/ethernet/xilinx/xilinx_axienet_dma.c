@@ -30,32 +30,135 @@ void __maybe_unused axienet_bd_free(struct net_device *ndev,
 	int i;
 	struct axienet_local *lp = netdev_priv(ndev);
 
-	for (i = 0; i < lp->rx_bd_num; i++) {
-		if (q->rx_bd_v[i].phys)
-			dma_unmap_single(ndev->dev.parent, q->rx_bd_v[i].phys,
-					 lp->max_frm_size, DMA_FROM_DEVICE);
-		dev_kfree_skb((struct sk_buff *)
-			      (q->rx_bd_v[i].sw_id_offset));
-	}
-
 	if (q->rx_bd_v) {
+		for (i = 0; i < lp->rx_bd_num; i++) {
+			struct page *page;
+
+			page = (struct page *)q->rx_bd_v[i].sw_id_offset;
+			if (page)
+				page_pool_put_full_page(q->page_pool, page,
+							false);
+		}
+
 		dma_free_coherent(ndev->dev.parent,
 				  sizeof(*q->rx_bd_v) * lp->rx_bd_num,
 				  q->rx_bd_v,
 				  q->rx_bd_p);
+		q->rx_bd_v = NULL;
 	}
+	axienet_rx_page_pool_destroy(q);
 	if (q->tx_bd_v) {
 		dma_free_coherent(ndev->dev.parent,
 				  sizeof(*q->tx_bd_v) * lp->tx_bd_num,
 				  q->tx_bd_v,
 				  q->tx_bd_p);
+		q->tx_bd_v = NULL;
 	}
 	if (q->tx_bufs) {
 		dma_free_coherent(ndev->dev.parent,
 				  XAE_MAX_PKT_LEN * lp->tx_bd_num,
 				  q->tx_bufs,
 				  q->tx_bufs_dma);
+		q->tx_bufs = NULL;
+	}
+}
+
+/**
+ * axienet_rx_page_pool_create - Create the Rx page pool of a DMA queue
+ * @ndev:	Pointer to the net_device structure
+ * @q:		Pointer to DMA queue structure
+ *
+ * Return: 0, on success -errno, on failure
+ *
+ * The pool hands out pages that stay DMA mapped for their whole lifetime.
+ * Each page holds one frame of up to max_frm_size bytes behind
+ * XAE_RX_HEADROOM, followed by room for the skb_shared_info so that the
+ * receive path can wrap it with build_skb(). Larger pages are used for
+ * jumbo frames. The pool is also registered as the memory model of the
+ * queue's XDP Rx queue info so that XDP frames find their way back to it.
+ */
+int axienet_rx_page_pool_create(struct net_device *ndev,
+				struct axienet_dma_q *q)
+{
+	struct axienet_local *lp = netdev_priv(ndev);
+	struct page_pool_params pp_params = { 0 };
+	unsigned int len;
+	int ret, i;
+
+	len = SKB_DATA_ALIGN(XAE_RX_HEADROOM + lp->max_frm_size) +
+	      SKB_DATA_ALIGN(sizeof(struct skb_shared_info));
+
+	pp_params.flags = PP_FLAG_DMA_MAP | PP_FLAG_DMA_SYNC_DEV;
+	pp_params.order = get_order(len);
+	pp_params.pool_size = lp->rx_bd_num;
+	pp_params.nid = dev_to_node(ndev->dev.parent);
+	pp_params.dev = ndev->dev.parent;
+	/* XDP_TX sends Rx pages back out through the same mapping */
+	pp_params.dma_dir = lp->xdp_prog ? DMA_BIDIRECTIONAL : DMA_FROM_DEVICE;
+	pp_params.offset = XAE_RX_HEADROOM;
+	pp_params.max_len = lp->max_frm_size;
+
+	q->page_pool = page_pool_create(&pp_params);
+	if (IS_ERR(q->page_pool)) {
+		ret = PTR_ERR(q->page_pool);
+		q->page_pool = NULL;
+		return ret;
 	}
+
+	for_each_rx_dma_queue(lp, i)
+		if (lp->dq[i] == q)
+			break;
+
+	ret = xdp_rxq_info_reg(&q->xdp_rxq, ndev, i, 0);
+	if (ret)
+		goto err_destroy_pool;
+
+	ret = xdp_rxq_info_reg_mem_model(&q->xdp_rxq, MEM_TYPE_PAGE_POOL,
+					 q->page_pool);
+	if (ret)
+		goto err_unreg_rxq;
+
+	return 0;
+
+err_unreg_rxq:
+	xdp_rxq_info_unreg(&q->xdp_rxq);
+err_destroy_pool:
+	page_pool_destroy(q->page_pool);
+	q->page_pool = NULL;
+	return ret;
+}
+
+/**
+ * axienet_rx_page_pool_destroy - Release the Rx page pool of a DMA queue
+ * @q:		Pointer to DMA queue structure
+ *
+ * All pages must have been returned to the pool before calling this.
+ */
+void axienet_rx_page_pool_destroy(struct axienet_dma_q *q)
+{
+	xdp_rxq_info_unreg(&q->xdp_rxq);
+	page_pool_destroy(q->page_pool);
+	q->page_pool = NULL;
+}
+
+/**
+ * axienet_rx_alloc_page - Get a pre-mapped Rx buffer from the page pool
+ * @q:		Pointer to DMA queue structure
+ * @dma:	Returns the bus address the DMA engine should write to
+ *
+ * Return: The page, or NULL if the pool is exhausted.
+ */
+struct page *axienet_rx_alloc_page(struct axienet_dma_q *q, dma_addr_t *dma)
+{
+	struct page *page;
+
+	page = page_pool_dev_alloc_pages(q->page_pool);
+	if (unlikely(!page))
+		return NULL;
+
+	*dma = page_pool_get_dma_addr(page) + XAE_RX_HEADROOM;
+
+	return page;
 }
 
 /**
@@ -143,7 +246,8 @@ static int __dma_rxq_init(struct net_device *ndev,
 {
 	int i;
 	u32 cr;
-	struct sk_buff *skb;
+	struct page *page;
+	dma_addr_t mapping;
 	struct axienet_local *lp = netdev_priv(ndev);
 	/* Reset the indexes which are used for accessing the BDs */
 	q->rx_bd_ci = 0;
@@ -155,30 +259,22 @@ static int __dma_rxq_init(struct net_device *ndev,
 	if (!q->rx_bd_v)
 		goto out;
 
+	if (axienet_rx_page_pool_create(ndev, q)) {
+		dev_err(&ndev->dev, "axidma page pool creation failed\n");
+		goto out;
+	}
+
 	for (i = 0; i < lp->rx_bd_num; i++) {
 		q->rx_bd_v[i].next = q->rx_bd_p +
 				     sizeof(*q->rx_bd_v) *
 				     ((i + 1) % lp->rx_bd_num);
 
-		skb = netdev_alloc_skb(ndev, lp->max_frm_size);
-		if (!skb)
+		page = axienet_rx_alloc_page(q, &mapping);
+		if (!page)
 			goto out;
 
-		/* Ensure that the skb is completely updated
-		 * prio to mapping the DMA
-		 */
-		wmb();
-
-		q->rx_bd_v[i].sw_id_offset = (phys_addr_t)skb;
-		q->rx_bd_v[i].phys = dma_map_single(ndev->dev.parent,
-						    skb->data,
-						    lp->max_frm_size,
-						    DMA_FROM_DEVICE);
-		if (unlikely(dma_mapping_error(ndev->dev.parent, q->rx_bd_v[i].phys))) {
-			q->rx_bd_v[i].phys = 0;
-			dev_err(&ndev->dev, "axidma map error\n");
-			goto out;
-		}
+		q->rx_bd_v[i].sw_id_offset = (phys_addr_t)page;
+		q->rx_bd_v[i].phys = mapping;
 		q->rx_bd_v[i].cntrl = lp->max_frm_size;
 	}
 
@@ -265,7 +361,8 @@ static int map_dma_q_irq(int irq, struct axienet_local *lp)
  *
  * Return: IRQ_HANDLED if device generated a TX interrupt, IRQ_NONE otherwise.
  *
- * This is the Axi DMA Tx done Isr. It invokes "axienet_start_xmit_done"
+ * This is the Axi DMA Tx done Isr. It masks further Tx completion
+ * interrupts and schedules the Tx NAPI, which calls "axienet_start_xmit_done"
  * to complete the BD processing.
  */
 irqreturn_t __maybe_unused axienet_tx_irq(int irq, void *_ndev)
@@ -285,7 +382,10 @@ irqreturn_t __maybe_unused axienet_tx_irq(int irq, void *_ndev)
 	status = axienet_dma_in32(q, XAXIDMA_TX_SR_OFFSET);
 	if (status & (XAXIDMA_IRQ_IOC_MASK | XAXIDMA_IRQ_DELAY_MASK)) {
 		axienet_dma_out32(q, XAXIDMA_TX_SR_OFFSET, status);
-		axienet_start_xmit_done(lp->ndev, q);
+		cr = axienet_dma_in32(q, XAXIDMA_TX_CR_OFFSET);
+		cr &= ~(XAXIDMA_IRQ_IOC_MASK | XAXIDMA_IRQ_DELAY_MASK);
+		axienet_dma_out32(q, XAXIDMA_TX_CR_OFFSET, cr);
+		napi_schedule(&lp->napi_tx[i]);
 		goto out;
 	}
 
@@ -345,6 +445,7 @@ irqreturn_t __maybe_unused axienet_rx_irq(int irq, void *_ndev)
 		cr = axienet_dma_in32(q, XAXIDMA_RX_CR_OFFSET);
 		cr &= ~(XAXIDMA_IRQ_IOC_MASK | XAXIDMA_IRQ_DELAY_MASK);
 		axienet_dma_out32(q, XAXIDMA_RX_CR_OFFSET, cr);
+		axienet_lat_rx_irq(q);
 		napi_schedule(&lp->napi[i]);
 	}
 
@@ -403,13 +504,7 @@ void __maybe_unused axienet_dma_err_handler(unsigned long data)
 
 	for (i = 0; i < lp->tx_bd_num; i++) {
 		cur_p = &q->tx_bd_v[i];
-		if (cur_p->phys)
-			dma_unmap_single(ndev->dev.parent, cur_p->phys,
-					 (cur_p->cntrl &
-					  XAXIDMA_BD_CTRL_LENGTH_MASK),
-					 DMA_TO_DEVICE);
-		if (cur_p->tx_skb)
-			dev_kfree_skb_irq((struct sk_buff *)cur_p->tx_skb);
+		axienet_tx_bd_free_buf(ndev, cur_p, 0);
 		cur_p->phys = 0;
 		cur_p->cntrl = 0;
 		cur_p->status = 0;
@@ -421,6 +516,8 @@ void __maybe_unused axienet_dma_err_handler(unsigned long data)
 		cur_p->sw_id_offset = 0;
 		cur_p->tx_skb = 0;
 	}
+	netdev_tx_reset_queue(axienet_dma_txq(q));
+	q->tx_tail_pending = false;
 
 	for (i = 0; i < lp->rx_bd_num; i++) {
 		cur_p = &q->rx_bd_v[i];
@@ -43,6 +43,9 @@
 #include <linux/ptp_classify.h>
 #include <linux/net_tstamp.h>
 #include <linux/random.h>
+#include <linux/bpf_trace.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
 #include <net/sock.h>
 #include <linux/xilinx_phy.h>
 #include <linux/clk.h>
@@ -55,6 +58,7 @@
 #define RX_BD_NUM_DEFAULT		128
 #define TX_BD_NUM_MIN			(MAX_SKB_FRAGS + 1)
 #define TX_BD_NUM_MAX			4096
+#define RX_BD_NUM_MIN			16
 #define RX_BD_NUM_MAX			4096
 
 /* Must be shorter than length of ethtool_drvinfo.driver field to fit */
@@ -206,6 +210,12 @@ static struct axienet_ethtools_stat axienet_get_ethtools_strings_stats[] = {
 	{ "rx_errors" },
 };
 
+static struct axienet_ethtools_stat axienet_get_queue_strings_stats[] = {
+	{ "rxq%d_alloc_fail" },
+	{ "txq%d_ring_full" },
+	{ "rxq%d_napi_full" },
+};
+
 /**
  * axienet_dma_bd_release - Release buffer descriptor rings
  * @ndev:	Pointer to the net_device structure
@@ -255,6 +265,116 @@ u32 axienet_usec_to_timer(struct axienet_local *lp, u32 coalesce_usec)
 	return result;
 }
 
+/**
+ * axienet_coalesce_cr - Build the coalesce fields of a DMA channel CR
+ * @lp:		Pointer to axienet local structure
+ * @count:	Interrupt coalesce count
+ * @usec:	Interrupt delay, only used when @count is above one
+ *
+ * Return: Coalesce count and delay timer fields, which sit at the same
+ * place in the AXI DMA and MCDMA control registers.
+ */
+static u32 axienet_coalesce_cr(struct axienet_local *lp, u32 count, u32 usec)
+{
+	u32 cr;
+
+	count = clamp_t(u32, count, 1, 255);
+	cr = count << XAXIDMA_COALESCE_SHIFT;
+	if (count > 1)
+		cr |= axienet_usec_to_timer(lp, usec) << XAXIDMA_DELAY_SHIFT;
+
+	return cr;
+}
+
+/**
+ * axienet_rx_dim_work - Apply the Rx moderation chosen by DIM
+ * @work:	Work item embedded in the queue's struct dim
+ *
+ * The new setting is picked up by the Rx NAPI the next time it re-enables
+ * the channel interrupts.
+ */
+static void axienet_rx_dim_work(struct work_struct *work)
+{
+	struct dim *dim = container_of(work, struct dim, work);
+	struct axienet_dma_q *q = container_of(dim, struct axienet_dma_q,
+					       rx_dim);
+	struct dim_cq_moder moder;
+
+	moder = net_dim_get_rx_moderation(dim->mode, dim->profile_ix);
+	if (READ_ONCE(q->rx_dim_enabled))
+		WRITE_ONCE(q->rx_coalesce_cr,
+			   axienet_coalesce_cr(q->lp, moder.pkts, moder.usec));
+	dim->state = DIM_START_MEASURE;
+}
+
+/**
+ * axienet_tx_dim_work - Apply the Tx moderation chosen by DIM
+ * @work:	Work item embedded in the queue's struct dim
+ */
+static void axienet_tx_dim_work(struct work_struct *work)
+{
+	struct dim *dim = container_of(work, struct dim, work);
+	struct axienet_dma_q *q = container_of(dim, struct axienet_dma_q,
+					       tx_dim);
+	struct dim_cq_moder moder;
+
+	moder = net_dim_get_tx_moderation(dim->mode, dim->profile_ix);
+	if (READ_ONCE(q->tx_dim_enabled))
+		WRITE_ONCE(q->tx_coalesce_cr,
+			   axienet_coalesce_cr(q->lp, moder.pkts, moder.usec));
+	dim->state = DIM_START_MEASURE;
+}
+
+/**
+ * axienet_rx_dim_set - Turn adaptive Rx moderation of a queue on or off
+ * @ndev:	Pointer to the net_device structure
+ * @q:		Pointer to DMA queue structure
+ * @enable:	New state
+ *
+ * Turning it off goes back to the ethtool coalesce settings.
+ */
+static void axienet_rx_dim_set(struct net_device *ndev,
+			       struct axienet_dma_q *q, bool enable)
+{
+	struct axienet_local *lp = netdev_priv(ndev);
+
+	if (q->rx_dim_enabled == enable)
+		return;
+
+	WRITE_ONCE(q->rx_dim_enabled, enable);
+	if (enable || !netif_running(ndev))
+		return;
+
+	cancel_work_sync(&q->rx_dim.work);
+	WRITE_ONCE(q->rx_coalesce_cr,
+		   axienet_coalesce_cr(lp, lp->coalesce_count_rx,
+				       lp->coalesce_usec_rx));
+}
+
+/**
+ * axienet_tx_dim_set - Turn adaptive Tx moderation of a queue on or off
+ * @ndev:	Pointer to the net_device structure
+ * @q:		Pointer to DMA queue structure
+ * @enable:	New state
+ */
+static void axienet_tx_dim_set(struct net_device *ndev,
+			       struct axienet_dma_q *q, bool enable)
+{
+	struct axienet_local *lp = netdev_priv(ndev);
+
+	if (q->tx_dim_enabled == enable)
+		return;
+
+	WRITE_ONCE(q->tx_dim_enabled, enable);
+	if (enable || !netif_running(ndev))
+		return;
+
+	cancel_work_sync(&q->tx_dim.work);
+	WRITE_ONCE(q->tx_coalesce_cr,
+		   axienet_coalesce_cr(lp, lp->coalesce_count_tx,
+				       lp->coalesce_usec_tx));
+}
+
 /**
  * axienet_dma_bd_init - Setup buffer descriptor rings for Axi DMA
  * @ndev:	Pointer to the net_device structure
@@ -270,6 +390,19 @@ static int axienet_dma_bd_init(struct net_device *ndev)
 	int i, ret = -EINVAL;
 	struct axienet_local *lp = netdev_priv(ndev);
 
+	/* DIM starts over from the ethtool settings */
+	for_each_rx_dma_queue(lp, i)
+		lp->dq[i]->rx_coalesce_cr =
+			axienet_coalesce_cr(lp, lp->coalesce_count_rx,
+					    lp->coalesce_usec_rx);
+	for_each_tx_dma_queue(lp, i) {
+		lp->dq[i]->tx_coalesce_cr =
+			axienet_coalesce_cr(lp, lp->coalesce_count_tx,
+					    lp->coalesce_usec_tx);
+		lp->dq[i]->tx_tail_pending = false;
+		netdev_tx_reset_queue(netdev_get_tx_queue(ndev, i));
+	}
+
 #ifdef CONFIG_AXIENET_HAS_MCDMA
 	for_each_tx_dma_queue(lp, i) {
 		ret = axienet_mcdma_tx_q_init(ndev, lp->dq[i]);
@@ -737,10 +870,31 @@ static int axienet_device_reset(struct net_device *ndev)
 
 #ifdef CONFIG_XILINX_AXI_EMAC_HWTSTAMP
 /**
- * axienet_tx_hwtstamp - Read tx timestamp from hw and update it to the skbuff
+ * struct axienet_txts_cb - Pending tx timestamp request, kept in skb->cb
+ * @expires:	Jiffies after which the timestamp is given up on
+ * @tag:	Tag the MAC reports along with the timestamp
+ */
+struct axienet_txts_cb {
+	unsigned long expires;
+	u32 tag;
+};
+
+#define AXIENET_TXTS_CB(skb)	((struct axienet_txts_cb *)(skb)->cb)
+
+/* Same as the worst case the per packet register polling used to allow */
+#define AXIENET_TXTS_TIMEOUT	HZ
+/* A short cut-through FIFO wait, longer waits are left to the retry timer */
+#define AXIENET_TXTS_POLL_US	10
+
+/**
+ * axienet_tx_hwtstamp - Queue a tx timestamp request of a completed bd
  * @lp:		Pointer to axienet local structure
  * @cur_p:	Pointer to the axi_dma/axi_mcdma current bd
  *
+ * The skb waiting for its timestamp is moved from the bd to the pending
+ * queue, the timestamps are read from the FIFO in one go by
+ * axienet_tx_hwtstamp_drain() once the whole completion batch is done.
+ *
  * Return:	None.
  */
 #ifdef CONFIG_AXIENET_HAS_MCDMA
@@ -751,81 +905,117 @@ void axienet_tx_hwtstamp(struct axienet_local *lp,
 			 struct axidma_bd *cur_p)
 #endif
 {
-	u32 sec = 0, nsec = 0, val;
-	u64 time64;
-	int err = 0;
-	u32 count, len = lp->axienet_config->tx_ptplen;
-	struct skb_shared_hwtstamps *shhwtstamps =
-		skb_hwtstamps((struct sk_buff *)cur_p->ptp_tx_skb);
+	struct sk_buff *skb = (struct sk_buff *)cur_p->ptp_tx_skb;
 
-	val = axienet_txts_ior(lp, XAXIFIFO_TXTS_ISR);
-	if (unlikely(!(val & XAXIFIFO_TXTS_INT_RC_MASK)))
-		dev_info(lp->dev, "Did't get FIFO tx interrupt %d\n", val);
+	AXIENET_TXTS_CB(skb)->tag = cur_p->ptp_tx_ts_tag;
+	AXIENET_TXTS_CB(skb)->expires = jiffies + AXIENET_TXTS_TIMEOUT;
+	skb_queue_tail(&lp->ptp_txq, skb);
+	cur_p->ptp_tx_skb = 0;
+}
 
-	/* Ensure to read Occupany register before accessing Length register */
-	if (!axienet_txts_ior(lp, XAXIFIFO_TXTS_RFO)) {
-		netdev_err(lp->ndev, "%s: TX Timestamp FIFO is empty", __func__);
-		goto skb_exit;
-	}
+/**
+ * axienet_tx_hwtstamp_drain - Deliver the tx timestamps available in the FIFO
+ * @lp:		Pointer to axienet local structure
+ *
+ * Reads every complete timestamp entry from the FIFO and hands it to the
+ * pending skb carrying the same tag. Requests that timed out are dropped
+ * without a timestamp. If requests are still pending when the FIFO runs
+ * dry the drain is retried from a timer, so that the Tx NAPI never busy
+ * waits for the MAC.
+ *
+ * Return:	None.
+ */
+void axienet_tx_hwtstamp_drain(struct axienet_local *lp)
+{
+	u32 sec, nsec, tag, val, len = lp->axienet_config->tx_ptplen;
+	struct skb_shared_hwtstamps *shhwtstamps;
+	struct sk_buff *skb, *tmp;
+	struct sk_buff_head done;
+	unsigned long flags;
+	int err;
 
-	/* If FIFO is configured in cut through Mode we will get Rx complete
-	 * interrupt even one byte is there in the fifo wait for the full packet
-	 */
-	err = readl_poll_timeout_atomic(lp->tx_ts_regs + XAXIFIFO_TXTS_RLR, val,
-					((val & XAXIFIFO_TXTS_RXFD_MASK) >=
-					len), 0, 1000000);
-	if (err) {
-		netdev_err(lp->ndev, "%s: Didn't get the full timestamp packet",
-			   __func__);
-		goto skb_exit;
-	}
+	__skb_queue_head_init(&done);
 
-	nsec = axienet_txts_ior(lp, XAXIFIFO_TXTS_RXFD);
-	sec  = axienet_txts_ior(lp, XAXIFIFO_TXTS_RXFD);
-	val = axienet_txts_ior(lp, XAXIFIFO_TXTS_RXFD);
-	val = ((val & XAXIFIFO_TXTS_TAG_MASK) >> XAXIFIFO_TXTS_TAG_SHIFT);
-	dev_dbg(lp->dev, "tx_stamp:[%04x] %04x %u %9u\n",
-		cur_p->ptp_tx_ts_tag, val, sec, nsec);
+	spin_lock_irqsave(&lp->ptp_txq.lock, flags);
+	while (!skb_queue_empty(&lp->ptp_txq)) {
+		/* Ensure to read Occupany register before accessing Length
+		 * register
+		 */
+		if (!axienet_txts_ior(lp, XAXIFIFO_TXTS_RFO))
+			break;
+
+		/* If FIFO is configured in cut through Mode we will get Rx
+		 * complete interrupt even one byte is there in the fifo wait
+		 * for the full packet
+		 */
+		err = readl_poll_timeout_atomic(lp->tx_ts_regs +
+						XAXIFIFO_TXTS_RLR, val,
+						((val & XAXIFIFO_TXTS_RXFD_MASK)
+						 >= len), 0,
+						AXIENET_TXTS_POLL_US);
+		if (err)
+			break;
 
-	if (val != cur_p->ptp_tx_ts_tag) {
-		count = axienet_txts_ior(lp, XAXIFIFO_TXTS_RFO);
-		while (count) {
-			nsec = axienet_txts_ior(lp, XAXIFIFO_TXTS_RXFD);
-			sec  = axienet_txts_ior(lp, XAXIFIFO_TXTS_RXFD);
+		nsec = axienet_txts_ior(lp, XAXIFIFO_TXTS_RXFD);
+		sec  = axienet_txts_ior(lp, XAXIFIFO_TXTS_RXFD);
+		val = axienet_txts_ior(lp, XAXIFIFO_TXTS_RXFD);
+		tag = ((val & XAXIFIFO_TXTS_TAG_MASK) >>
+		       XAXIFIFO_TXTS_TAG_SHIFT);
+		if (lp->axienet_config->mactype != XAXIENET_10G_25G &&
+		    lp->axienet_config->mactype != XAXIENET_MRMAC)
 			val = axienet_txts_ior(lp, XAXIFIFO_TXTS_RXFD);
-			val = ((val & XAXIFIFO_TXTS_TAG_MASK) >>
-				XAXIFIFO_TXTS_TAG_SHIFT);
 
-			dev_dbg(lp->dev, "tx_stamp:[%04x] %04x %u %9u\n",
-				cur_p->ptp_tx_ts_tag, val, sec, nsec);
-			if (val == cur_p->ptp_tx_ts_tag)
-				break;
-			count = axienet_txts_ior(lp, XAXIFIFO_TXTS_RFO);
-		}
-		if (val != cur_p->ptp_tx_ts_tag) {
-			dev_info(lp->dev, "Mismatching 2-step tag. Got %x",
-				 val);
-			dev_info(lp->dev, "Expected %x\n",
-				 cur_p->ptp_tx_ts_tag);
+		dev_dbg(lp->dev, "tx_stamp:[%04x] %u %9u\n", tag, sec, nsec);
+
+		skb_queue_walk_safe(&lp->ptp_txq, skb, tmp) {
+			if (AXIENET_TXTS_CB(skb)->tag != tag)
+				continue;
+			__skb_unlink(skb, &lp->ptp_txq);
+			shhwtstamps = skb_hwtstamps(skb);
+			memset(shhwtstamps, 0, sizeof(*shhwtstamps));
+			shhwtstamps->hwtstamp =
+				ns_to_ktime((u64)sec * NS_PER_SEC + nsec);
+			__skb_queue_tail(&done, skb);
+			break;
 		}
+		if (skb == (struct sk_buff *)&lp->ptp_txq)
+			dev_dbg(lp->dev, "No request for 2-step tag %x\n",
+				tag);
 	}
 
-	if (lp->axienet_config->mactype != XAXIENET_10G_25G &&
-	    lp->axienet_config->mactype != XAXIENET_MRMAC)
-		val = axienet_txts_ior(lp, XAXIFIFO_TXTS_RXFD);
+	skb_queue_walk_safe(&lp->ptp_txq, skb, tmp) {
+		if (time_before(jiffies, AXIENET_TXTS_CB(skb)->expires))
+			break;
+		__skb_unlink(skb, &lp->ptp_txq);
+		netdev_warn_once(lp->ndev, "Timed out waiting for 2-step tag %x\n",
+				 AXIENET_TXTS_CB(skb)->tag);
+		dev_kfree_skb_any(skb);
+	}
 
-skb_exit:
-	time64 = sec * NS_PER_SEC + nsec;
-	memset(shhwtstamps, 0, sizeof(struct skb_shared_hwtstamps));
-	shhwtstamps->hwtstamp = ns_to_ktime(time64);
-	if (lp->axienet_config->mactype != XAXIENET_10G_25G &&
-	    lp->axienet_config->mactype != XAXIENET_MRMAC)
-		skb_pull((struct sk_buff *)cur_p->ptp_tx_skb,
-			 AXIENET_TS_HEADER_LEN);
+	if (!skb_queue_empty(&lp->ptp_txq))
+		mod_timer(&lp->ptp_txts_timer, jiffies + 1);
+	spin_unlock_irqrestore(&lp->ptp_txq.lock, flags);
 
-	skb_tstamp_tx((struct sk_buff *)cur_p->ptp_tx_skb, shhwtstamps);
-	dev_kfree_skb_any((struct sk_buff *)cur_p->ptp_tx_skb);
-	cur_p->ptp_tx_skb = 0;
+	while ((skb = __skb_dequeue(&done))) {
+		if (lp->axienet_config->mactype != XAXIENET_10G_25G &&
+		    lp->axienet_config->mactype != XAXIENET_MRMAC)
+			skb_pull(skb, AXIENET_TS_HEADER_LEN);
+		skb_tstamp_tx(skb, skb_hwtstamps(skb));
+		dev_kfree_skb_any(skb);
+	}
+}
+
+/**
+ * axienet_tx_hwtstamp_timer - Retry the tx timestamp drain
+ * @t:		Pointer to the timer of the pending tx timestamp requests
+ *
+ * Return:	None.
+ */
+static void axienet_tx_hwtstamp_timer(struct timer_list *t)
+{
+	struct axienet_local *lp = from_timer(lp, t, ptp_txts_timer);
+
+	axienet_tx_hwtstamp_drain(lp);
 }
 
 static inline bool is_ptp_os_pdelay_req(struct sk_buff *skb,
@@ -841,7 +1031,8 @@ static inline bool is_ptp_os_pdelay_req(struct sk_buff *skb,
 /**
  * axienet_rx_hwtstamp - Read rx timestamp from hw and update it to the skbuff
  * @lp:		Pointer to axienet local structure
- * @skb:	Pointer to the sk_buff structure
+ * @skb:	Pointer to the sk_buff structure. NULL drops the timestamp of a
+ *		frame consumed by XDP so that the FIFO stays in step.
  *
  * Return:	None.
  */
@@ -851,7 +1042,6 @@ static void axienet_rx_hwtstamp(struct axienet_local *lp,
 	u32 sec = 0, nsec = 0, val;
 	u64 time64;
 	int err = 0;
-	struct skb_shared_hwtstamps *shhwtstamps = skb_hwtstamps(skb);
 
 	val = axienet_rxts_ior(lp, XAXIFIFO_TXTS_ISR);
 	if (unlikely(!(val & XAXIFIFO_TXTS_INT_RC_MASK))) {
@@ -879,6 +1069,9 @@ static void axienet_rx_hwtstamp(struct axienet_local *lp,
 	sec  = axienet_rxts_ior(lp, XAXIFIFO_TXTS_RXFD);
 	val = axienet_rxts_ior(lp, XAXIFIFO_TXTS_RXFD);
 
+	if (!skb)
+		return;
+
 	if (is_ptp_os_pdelay_req(skb, lp)) {
 		/* Need to save PDelay resp RX time for HW 1 step
 		 * timestamping on PDelay Response.
@@ -890,27 +1083,83 @@ static void axienet_rx_hwtstamp(struct axienet_local *lp,
 
 	if (lp->tstamp_config.rx_filter == HWTSTAMP_FILTER_ALL) {
 		time64 = sec * NS_PER_SEC + nsec;
-		shhwtstamps->hwtstamp = ns_to_ktime(time64);
+		skb_hwtstamps(skb)->hwtstamp = ns_to_ktime(time64);
 	}
 }
 #endif
 
+/**
+ * axienet_tx_bd_free_buf - Unmap and release the buffer attached to a Tx BD
+ * @ndev:	Pointer to the net_device structure
+ * @cur_p:	Pointer to the axi_dma/axi_mcdma Tx bd
+ * @budget:	NAPI budget of a completing Tx poll, 0 when the buffer is
+ *		dropped instead
+ *
+ * The buffer is either an sk_buff or, for XDP transmissions, an xdp_frame.
+ * tx_desc_mapping tells which one and how it was mapped. Completed skbs
+ * are batched into the per-CPU NAPI free cache.
+ */
+#ifdef CONFIG_AXIENET_HAS_MCDMA
+void axienet_tx_bd_free_buf(struct net_device *ndev,
+			    struct aximcdma_bd *cur_p, int budget)
+#else
+void axienet_tx_bd_free_buf(struct net_device *ndev,
+			    struct axidma_bd *cur_p, int budget)
+#endif
+{
+	u32 len = cur_p->cntrl & XAXIDMA_BD_CTRL_LENGTH_MASK;
+
+	if (cur_p->phys) {
+		switch (cur_p->tx_desc_mapping) {
+		case DESC_DMA_MAP_PAGE:
+			dma_unmap_page(ndev->dev.parent, cur_p->phys, len,
+				       DMA_TO_DEVICE);
+			break;
+		case DESC_DMA_MAP_XDP_TX:
+		case DESC_DMA_MAP_XSK:
+			/* Still owned by the page pool or XSK pool mapping */
+			break;
+		default:
+			dma_unmap_single(ndev->dev.parent, cur_p->phys, len,
+					 DMA_TO_DEVICE);
+			break;
+		}
+	}
+
+	if (!cur_p->tx_skb)
+		return;
+
+	if (cur_p->tx_desc_mapping == DESC_DMA_MAP_XDP_TX ||
+	    cur_p->tx_desc_mapping == DESC_DMA_MAP_XDP_NDO)
+		xdp_return_frame((struct xdp_frame *)cur_p->tx_skb);
+	else if (budget)
+		napi_consume_skb((struct sk_buff *)cur_p->tx_skb, budget);
+	else
+		dev_kfree_skb_any((struct sk_buff *)cur_p->tx_skb);
+}
+
 /**
  * axienet_start_xmit_done - Invoked once a transmit is completed by the
  * Axi DMA Tx channel.
  * @ndev:	Pointer to the net_device structure
  * @q:		Pointer to DMA queue structure
+ * @txq:	Netdev Tx queue of @q, completed skbs are reported to its BQL
+ * @budget:	NAPI budget of the Tx poll
  *
- * This function is invoked from the Axi DMA Tx isr to notify the completion
+ * This function is invoked from the Tx NAPI poll to notify the completion
  * of transmit operation. It clears fields in the corresponding Tx BDs and
  * unmaps the corresponding buffer so that CPU can regain ownership of the
  * buffer. It finally invokes "netif_wake_queue" to restart transmission if
  * required.
  */
 void axienet_start_xmit_done(struct net_device *ndev,
-			     struct axienet_dma_q *q)
+			     struct axienet_dma_q *q,
+			     struct netdev_queue *txq, int budget)
 {
 	struct axienet_local *lp = netdev_priv(ndev);
+	u32 xsk_frames = 0;
+	u32 bql_bytes = 0;
+	u32 bql_pkts = 0;
 	u32 packets = 0;
 	u32 size = 0;
 
@@ -933,18 +1182,15 @@ void axienet_start_xmit_done(struct net_device *ndev,
 		if (cur_p->ptp_tx_skb)
 			axienet_tx_hwtstamp(lp, cur_p);
 #endif
-		if (cur_p->tx_desc_mapping == DESC_DMA_MAP_PAGE)
-			dma_unmap_page(ndev->dev.parent, cur_p->phys,
-				       cur_p->cntrl &
-				       XAXIDMA_BD_CTRL_LENGTH_MASK,
-				       DMA_TO_DEVICE);
+		if (cur_p->tx_skb &&
+		    cur_p->tx_desc_mapping <= DESC_DMA_MAP_PAGE) {
+			bql_bytes += ((struct sk_buff *)cur_p->tx_skb)->len;
+			bql_pkts++;
+		}
+		if (cur_p->tx_desc_mapping == DESC_DMA_MAP_XSK)
+			xsk_frames++;
 		else
-			dma_unmap_single(ndev->dev.parent, cur_p->phys,
-					 cur_p->cntrl &
-					 XAXIDMA_BD_CTRL_LENGTH_MASK,
-					 DMA_TO_DEVICE);
-		if (cur_p->tx_skb)
-			dev_kfree_skb_irq((struct sk_buff *)cur_p->tx_skb);
+			axienet_tx_bd_free_buf(ndev, cur_p, budget);
 		/*cur_p->phys = 0;*/
 		cur_p->app0 = 0;
 		cur_p->app1 = 0;
@@ -970,11 +1216,21 @@ void axienet_start_xmit_done(struct net_device *ndev,
 #endif
 	}
 
+#ifdef CONFIG_XILINX_AXI_EMAC_HWTSTAMP
+	if (!skb_queue_empty_lockless(&lp->ptp_txq))
+		axienet_tx_hwtstamp_drain(lp);
+#endif
+
 	ndev->stats.tx_packets += packets;
 	ndev->stats.tx_bytes += size;
 	q->tx_packets += packets;
 	q->tx_bytes += size;
 
+	if (xsk_frames)
+		xsk_tx_completed(q->xsk_pool, xsk_frames);
+
+	netdev_tx_completed_queue(txq, bql_pkts, bql_bytes);
+
 	/* Matches barrier in axienet_start_xmit */
 	smp_mb();
 
@@ -1247,6 +1503,95 @@ static int axienet_skb_tstsmp(struct sk_buff **__skb, struct axienet_dma_q *q,
 }
 #endif
 
+/**
+ * axienet_tx_unwind - Release the BDs of a partially queued frame
+ * @ndev:	Pointer to net_device structure
+ * @q:		Pointer to DMA queue structure
+ * @nr_bds:	Number of BDs already filled in before tx_bd_tail
+ *
+ * Unmaps the head and fragment buffers and moves tx_bd_tail back to the
+ * first BD of the frame. Must be called with the queue tx_lock held.
+ */
+static void axienet_tx_unwind(struct net_device *ndev, struct axienet_dma_q *q,
+			      u32 nr_bds)
+{
+	struct axienet_local *lp = netdev_priv(ndev);
+#ifdef CONFIG_AXIENET_HAS_MCDMA
+	struct aximcdma_bd *cur_p;
+#else
+	struct axidma_bd *cur_p;
+#endif
+
+	while (nr_bds--) {
+		q->tx_bd_tail = q->tx_bd_tail ? q->tx_bd_tail - 1 :
+						lp->tx_bd_num - 1;
+#ifdef CONFIG_AXIENET_HAS_MCDMA
+		cur_p = &q->txq_bd_v[q->tx_bd_tail];
+#else
+		cur_p = &q->tx_bd_v[q->tx_bd_tail];
+#endif
+		axienet_tx_bd_free_buf(ndev, cur_p, 0);
+		cur_p->phys = 0;
+		cur_p->cntrl = 0;
+		cur_p->app0 = 0;
+		cur_p->app1 = 0;
+	}
+}
+
+/**
+ * axienet_tx_kick - Write the Tx tail pointer held back by xmit_more
+ * @q:		Pointer to DMA queue structure
+ *
+ * Must be called with the queue tx_lock held before giving up on a frame,
+ * otherwise the BDs queued so far would not be processed.
+ */
+static void axienet_tx_kick(struct axienet_dma_q *q)
+{
+	struct axienet_local *lp = q->lp;
+	dma_addr_t tail_p;
+	u32 last;
+
+	if (!q->tx_tail_pending)
+		return;
+
+	q->tx_tail_pending = false;
+	last = q->tx_bd_tail ? q->tx_bd_tail - 1 : lp->tx_bd_num - 1;
+	/* Ensure BD write before starting transfer */
+	wmb();
+#ifdef CONFIG_AXIENET_HAS_MCDMA
+	tail_p = q->tx_bd_p + sizeof(*q->txq_bd_v) * last;
+	axienet_dma_bdout(q, XMCDMA_CHAN_TAILDESC_OFFSET(q->chan_id),
+			  tail_p);
+#else
+	tail_p = q->tx_bd_p + sizeof(*q->tx_bd_v) * last;
+	axienet_dma_bdout(q, XAXIDMA_TX_TDESC_OFFSET, tail_p);
+#endif
+}
+
+/**
+ * axienet_tx_skb_aligned - Check that all buffers of an skb are word aligned
+ * @skb:	sk_buff to transmit
+ *
+ * Without DRE the DMA can only fetch from word aligned addresses. When
+ * the head and every fragment start aligned, they are handed to the DMA
+ * as they are, one BD each, instead of being copied to the bounce buffer.
+ *
+ * Return: true if the skb can be transmitted without a copy.
+ */
+static bool axienet_tx_skb_aligned(struct sk_buff *skb)
+{
+	int i;
+
+	if ((uintptr_t)skb->data & 0x3)
+		return false;
+
+	for (i = 0; i < skb_shinfo(skb)->nr_frags; i++)
+		if (skb_frag_off(&skb_shinfo(skb)->frags[i]) & 0x3)
+			return false;
+
+	return true;
+}
+
 static int axienet_queue_xmit(struct sk_buff *skb,
 			      struct net_device *ndev, u16 map)
 {
@@ -1290,7 +1635,9 @@ static int axienet_queue_xmit(struct sk_buff *skb,
 
 	spin_lock_irqsave(&q->tx_lock, flags);
 	if (axienet_check_tx_bd_space(q, num_frag)) {
+		q->tx_ring_full++;
 		if (netif_queue_stopped(ndev)) {
+			axienet_tx_kick(q);
 			spin_unlock_irqrestore(&q->tx_lock, flags);
 			return NETDEV_TX_BUSY;
 		}
@@ -1302,6 +1649,7 @@ static int axienet_queue_xmit(struct sk_buff *skb,
 
 		/* Space might have just been freed - check again */
 		if (axienet_check_tx_bd_space(q, num_frag)) {
+			axienet_tx_kick(q);
 			spin_unlock_irqrestore(&q->tx_lock, flags);
 			return NETDEV_TX_BUSY;
 		}
@@ -1311,6 +1659,7 @@ static int axienet_queue_xmit(struct sk_buff *skb,
 
 #ifdef CONFIG_XILINX_AXI_EMAC_HWTSTAMP
 	if (axienet_skb_tstsmp(&skb, q, ndev)) {
+		axienet_tx_kick(q);
 		spin_unlock_irqrestore(&q->tx_lock, flags);
 		return NETDEV_TX_BUSY;
 	}
@@ -1340,9 +1689,12 @@ static int axienet_queue_xmit(struct sk_buff *skb,
 	cur_p->cntrl = (skb_headlen(skb) | XAXIDMA_BD_CTRL_TXSOF_MASK);
 #endif
 
-	if (!q->eth_hasdre &&
-	    (((phys_addr_t)skb->data & 0x3) || num_frag > 0)) {
+	if (!q->eth_hasdre && !axienet_tx_skb_aligned(skb)) {
 		skb_copy_and_csum_dev(skb, q->tx_buf[q->tx_bd_tail]);
+		/* The frags are no longer needed, tell MSG_ZEROCOPY senders
+		 * that their data was copied.
+		 */
+		skb_zcopy_clear(skb, false);
 
 		cur_p->phys = q->tx_bufs_dma +
 			      (q->tx_buf[q->tx_bd_tail] - q->tx_bufs);
@@ -1352,12 +1704,14 @@ static int axienet_queue_xmit(struct sk_buff *skb,
 #else
 		cur_p->cntrl = skb_pagelen(skb) | XAXIDMA_BD_CTRL_TXSOF_MASK;
 #endif
+		cur_p->tx_desc_mapping = DESC_DMA_MAP_SINGLE;
 		goto out;
 	} else {
 		cur_p->phys = dma_map_single(ndev->dev.parent, skb->data,
 					     skb_headlen(skb), DMA_TO_DEVICE);
 		if (unlikely(dma_mapping_error(ndev->dev.parent, cur_p->phys))) {
 			cur_p->phys = 0;
+			axienet_tx_kick(q);
 			spin_unlock_irqrestore(&q->tx_lock, flags);
 			dev_err(&ndev->dev, "TX buffer map failed\n");
 			return NETDEV_TX_BUSY;
@@ -1381,6 +1735,17 @@ static int axienet_queue_xmit(struct sk_buff *skb,
 		len = skb_frag_size(frag);
 		cur_p->phys = skb_frag_dma_map(ndev->dev.parent, frag, 0, len,
 					       DMA_TO_DEVICE);
+		if (unlikely(dma_mapping_error(ndev->dev.parent, cur_p->phys))) {
+			cur_p->phys = 0;
+			axienet_tx_unwind(ndev, q, ii + 1);
+			axienet_tx_kick(q);
+			spin_unlock_irqrestore(&q->tx_lock, flags);
+			if (net_ratelimit())
+				netdev_err(ndev, "TX frag map failed\n");
+			dev_kfree_skb_any(skb);
+			ndev->stats.tx_dropped++;
+			return NETDEV_TX_OK;
+		}
 		cur_p->cntrl = len;
 		cur_p->tx_desc_mapping = DESC_DMA_MAP_PAGE;
 	}
@@ -1394,19 +1759,26 @@ static int axienet_queue_xmit(struct sk_buff *skb,
 	tail_p = q->tx_bd_p + sizeof(*q->tx_bd_v) * q->tx_bd_tail;
 #endif
 	cur_p->tx_skb = (phys_addr_t)skb;
-	cur_p->tx_skb = (phys_addr_t)skb;
 
-	tail_p = q->tx_bd_p + sizeof(*q->tx_bd_v) * q->tx_bd_tail;
-	/* Ensure BD write before starting transfer */
-	wmb();
+	/* Leave the tail pointer alone while the stack has more frames
+	 * coming, one MMIO write then starts the whole batch.
+	 */
+	if (__netdev_tx_sent_queue(netdev_get_tx_queue(ndev, map), skb->len,
+				   netdev_xmit_more())) {
+		/* Ensure BD write before starting transfer */
+		wmb();
 
-	/* Start the transfer */
+		/* Start the transfer */
 #ifdef CONFIG_AXIENET_HAS_MCDMA
-	axienet_dma_bdout(q, XMCDMA_CHAN_TAILDESC_OFFSET(q->chan_id),
-			  tail_p);
+		axienet_dma_bdout(q, XMCDMA_CHAN_TAILDESC_OFFSET(q->chan_id),
+				  tail_p);
 #else
-	axienet_dma_bdout(q, XAXIDMA_TX_TDESC_OFFSET, tail_p);
+		axienet_dma_bdout(q, XAXIDMA_TX_TDESC_OFFSET, tail_p);
 #endif
+		q->tx_tail_pending = false;
+	} else {
+		q->tx_tail_pending = true;
+	}
 	if (++q->tx_bd_tail >= lp->tx_bd_num)
 		q->tx_bd_tail = 0;
 
@@ -1435,28 +1807,269 @@ static int axienet_start_xmit(struct sk_buff *skb, struct net_device *ndev)
 	return axienet_queue_xmit(skb, ndev, map);
 }
 
+/**
+ * axienet_xdp_mtu_ok - Check that a frame fits in a single XDP buffer
+ * @mtu:	MTU to check
+ *
+ * Return: true if a frame of @mtu plus the XDP headroom and the
+ * skb_shared_info fit in one page.
+ */
+static inline bool axienet_xdp_mtu_ok(int mtu)
+{
+	return SKB_DATA_ALIGN(XAE_RX_HEADROOM + mtu + VLAN_ETH_HLEN +
+			      XAE_TRL_SIZE) +
+	       SKB_DATA_ALIGN(sizeof(struct skb_shared_info)) <= PAGE_SIZE;
+}
+
+/**
+ * axienet_xdp_tx_queue - Pick the Tx DMA queue used for XDP transmissions
+ * @lp:		Pointer to axienet local structure
+ *
+ * Return: Pointer to the DMA queue.
+ */
+static inline struct axienet_dma_q *
+axienet_xdp_tx_queue(struct axienet_local *lp)
+{
+	return lp->dq[smp_processor_id() % lp->num_tx_queues];
+}
+
+/**
+ * axienet_xdp_xmit_frame - Queue an XDP frame on a Tx DMA queue
+ * @lp:		Pointer to axienet local structure
+ * @q:		Pointer to DMA queue structure
+ * @xdpf:	Frame to transmit
+ * @dma_map:	True for ndo_xdp_xmit frames, which need their own mapping.
+ *		XDP_TX frames reuse the page pool mapping of the Rx buffer.
+ *
+ * Return: 0, on success. A negative errno if the frame could not be queued,
+ * in which case the caller still owns @xdpf.
+ */
+int axienet_xdp_xmit_frame(struct axienet_local *lp, struct axienet_dma_q *q,
+			   struct xdp_frame *xdpf, bool dma_map)
+{
+	struct net_device *ndev = lp->ndev;
+	u32 mapping = dma_map ? DESC_DMA_MAP_XDP_NDO : DESC_DMA_MAP_XDP_TX;
+	u32 len = xdpf->len;
+	void *data = xdpf->data;
+	bool copied = false;
+	unsigned long flags;
+	dma_addr_t tail_p;
+	dma_addr_t phys;
+	u32 tailroom;
+#ifdef CONFIG_AXIENET_HAS_MCDMA
+	struct aximcdma_bd *cur_p;
+#else
+	struct axidma_bd *cur_p;
+#endif
+
+	spin_lock_irqsave(&q->tx_lock, flags);
+	if (axienet_check_tx_bd_space(q, 0)) {
+		spin_unlock_irqrestore(&q->tx_lock, flags);
+		return -ENOSPC;
+	}
+
+#ifdef CONFIG_AXIENET_HAS_MCDMA
+	cur_p = &q->txq_bd_v[q->tx_bd_tail];
+#else
+	cur_p = &q->tx_bd_v[q->tx_bd_tail];
+#endif
+
+#ifdef CONFIG_XILINX_AXI_EMAC_HWTSTAMP
+	if (((lp->tstamp_config.tx_type == HWTSTAMP_TX_ONESTEP_SYNC ||
+	      lp->tstamp_config.tx_type == HWTSTAMP_TX_ON) ||
+	     lp->eth_hasptp) && lp->axienet_config->mactype !=
+	    XAXIENET_10G_25G &&
+	    lp->axienet_config->mactype != XAXIENET_MRMAC) {
+		/* In-band timestamp header, all zero as no stamp is wanted */
+		if (xdpf->headroom < AXIENET_TS_HEADER_LEN)
+			goto out_inval;
+		data -= AXIENET_TS_HEADER_LEN;
+		len += AXIENET_TS_HEADER_LEN;
+		memset(data, 0, AXIENET_TS_HEADER_LEN);
+	}
+#endif
+
+	if (lp->axienet_config->mactype == XAXIENET_10G_25G ||
+	    lp->axienet_config->mactype == XAXIENET_MRMAC) {
+		/* The XXV MAC does not pad short frames, see
+		 * axienet_queue_xmit().
+		 */
+		if (len < ETH_ZLEN) {
+			tailroom = xdpf->frame_sz - sizeof(*xdpf) -
+				   xdpf->headroom - xdpf->len;
+			if (tailroom < ETH_ZLEN - len)
+				goto out_inval;
+			memset(data + len, 0, ETH_ZLEN - len);
+			len = ETH_ZLEN;
+		}
+	}
+
+	if (!q->eth_hasdre && ((phys_addr_t)data & 0x3)) {
+		if (len > XAE_MAX_PKT_LEN)
+			goto out_inval;
+		memcpy(q->tx_buf[q->tx_bd_tail], data, len);
+		phys = q->tx_bufs_dma +
+		       (q->tx_buf[q->tx_bd_tail] - q->tx_bufs);
+		mapping = DESC_DMA_MAP_XDP_TX;
+		copied = true;
+	} else if (dma_map) {
+		phys = dma_map_single(ndev->dev.parent, data, len,
+				      DMA_TO_DEVICE);
+		if (unlikely(dma_mapping_error(ndev->dev.parent, phys))) {
+			spin_unlock_irqrestore(&q->tx_lock, flags);
+			return -ENOMEM;
+		}
+	} else {
+		struct page *page = virt_to_head_page(data);
+
+		phys = page_pool_get_dma_addr(page) +
+		       (data - page_address(page));
+		dma_sync_single_for_device(ndev->dev.parent, phys, len,
+					   DMA_BIDIRECTIONAL);
+	}
+
+#ifdef CONFIG_XILINX_AXI_EMAC_HWTSTAMP
+	if (lp->axienet_config->mactype == XAXIENET_10G_25G ||
+	    lp->axienet_config->mactype == XAXIENET_MRMAC) {
+		if (axienet_create_tsheader(lp->tx_ptpheader,
+					    TX_TS_OP_NOOP, q)) {
+			if (mapping == DESC_DMA_MAP_XDP_NDO)
+				dma_unmap_single(ndev->dev.parent, phys, len,
+						 DMA_TO_DEVICE);
+			spin_unlock_irqrestore(&q->tx_lock, flags);
+			return -EBUSY;
+		}
+	}
+#endif
+
+	cur_p->phys = phys;
+#ifdef CONFIG_AXIENET_HAS_MCDMA
+	cur_p->cntrl = len | XMCDMA_BD_CTRL_TXSOF_MASK |
+		       XMCDMA_BD_CTRL_TXEOF_MASK;
+	tail_p = q->tx_bd_p + sizeof(*q->txq_bd_v) * q->tx_bd_tail;
+#else
+	cur_p->cntrl = len | XAXIDMA_BD_CTRL_TXSOF_MASK |
+		       XAXIDMA_BD_CTRL_TXEOF_MASK;
+	tail_p = q->tx_bd_p + sizeof(*q->tx_bd_v) * q->tx_bd_tail;
+#endif
+	cur_p->tx_desc_mapping = mapping;
+	cur_p->tx_skb = copied ? 0 : (phys_addr_t)xdpf;
+
+	/* Ensure BD write before starting transfer */
+	wmb();
+
+	/* Start the transfer, this also covers BDs held back by xmit_more */
+#ifdef CONFIG_AXIENET_HAS_MCDMA
+	axienet_dma_bdout(q, XMCDMA_CHAN_TAILDESC_OFFSET(q->chan_id),
+			  tail_p);
+#else
+	axienet_dma_bdout(q, XAXIDMA_TX_TDESC_OFFSET, tail_p);
+#endif
+	q->tx_tail_pending = false;
+	if (++q->tx_bd_tail >= lp->tx_bd_num)
+		q->tx_bd_tail = 0;
+
+	spin_unlock_irqrestore(&q->tx_lock, flags);
+
+	/* The data now lives in the Tx bounce buffer */
+	if (copied)
+		xdp_return_frame(xdpf);
+
+	return 0;
+
+out_inval:
+	spin_unlock_irqrestore(&q->tx_lock, flags);
+	return -EINVAL;
+}
+
+/* axienet_run_xdp() verdicts */
+#define AXIENET_XDP_PASS	0
+#define AXIENET_XDP_CONSUMED	BIT(0)
+#define AXIENET_XDP_TX		BIT(1)
+#define AXIENET_XDP_REDIR	BIT(2)
+
+/**
+ * axienet_run_xdp - Run the XDP program on a received frame
+ * @lp:		Pointer to axienet local structure
+ * @q:		Pointer to the Rx DMA queue structure
+ * @prog:	XDP program to run
+ * @xdp:	Frame to run the program on
+ *
+ * Frames that do not pass are transmitted, redirected or returned to the
+ * page pool here.
+ *
+ * Return: AXIENET_XDP_PASS if the frame should go up the stack, otherwise
+ * the action taken.
+ */
+static u32 axienet_run_xdp(struct axienet_local *lp, struct axienet_dma_q *q,
+			   struct bpf_prog *prog, struct xdp_buff *xdp)
+{
+	struct xdp_frame *xdpf;
+	u32 act;
+
+	act = bpf_prog_run_xdp(prog, xdp);
+	switch (act) {
+	case XDP_PASS:
+		return AXIENET_XDP_PASS;
+	case XDP_TX:
+		xdpf = xdp_convert_buff_to_frame(xdp);
+		if (unlikely(!xdpf) ||
+		    axienet_xdp_xmit_frame(lp, axienet_xdp_tx_queue(lp), xdpf,
+					   false))
+			goto out_failure;
+		return AXIENET_XDP_TX;
+	case XDP_REDIRECT:
+		if (unlikely(xdp_do_redirect(lp->ndev, xdp, prog)))
+			goto out_failure;
+		return AXIENET_XDP_REDIR;
+	default:
+		bpf_warn_invalid_xdp_action(lp->ndev, prog, act);
+		fallthrough;
+	case XDP_ABORTED:
+out_failure:
+		trace_xdp_exception(lp->ndev, prog, act);
+		fallthrough;
+	case XDP_DROP:
+		break;
+	}
+
+	page_pool_recycle_direct(q->page_pool, virt_to_head_page(xdp->data));
+	return AXIENET_XDP_CONSUMED;
+}
+
 /**
  * axienet_recv - Is called from Axi DMA Rx Isr to complete the received
  *		  BD processing.
- * @ndev:	Pointer to net_device structure.
+ * @napi:	Pointer to the Rx NAPI of the queue
  * @budget:	NAPI budget
  * @q:		Pointer to axienet DMA queue structure
  *
  * This function is invoked from the Axi DMA Rx isr(poll) to process the Rx BDs
- * It does minimal processing and invokes "netif_receive_skb" to complete
- * further processing.
+ * It does minimal processing, runs the attached XDP program if any and
+ * invokes "napi_gro_receive" to complete further processing.
  * Return: Number of BD's processed.
  */
-static int axienet_recv(struct net_device *ndev, int budget,
+static int axienet_recv(struct napi_struct *napi, int budget,
 			struct axienet_dma_q *q)
 {
+	struct net_device *ndev = napi->dev;
 	u32 length;
 	u32 csumstatus;
 	u32 size = 0;
 	u32 packets = 0;
 	dma_addr_t tail_p = 0;
+	dma_addr_t mapping;
 	struct axienet_local *lp = netdev_priv(ndev);
-	struct sk_buff *skb, *new_skb;
+	struct page *page, *new_page;
+	struct sk_buff *skb;
+	struct bpf_prog *xdp_prog;
+	struct xdp_buff xdp;
+	unsigned int headroom;
+	u32 xdp_res, xdp_status = 0;
+#ifdef CONFIG_XILINX_AXI_EMAC_HWTSTAMP
+	bool rx_ts;
+	u64 time64 = 0;
+#endif
 #ifdef CONFIG_AXIENET_HAS_MCDMA
 	struct aximcdma_bd *cur_p;
 #else
@@ -1474,9 +2087,14 @@ static int axienet_recv(struct net_device *ndev, int budget,
 
 	while ((numbdfree < budget) &&
 	       (cur_p->status & XAXIDMA_BD_STS_COMPLETE_MASK)) {
-		new_skb = netdev_alloc_skb(ndev, lp->max_frm_size);
-		if (!new_skb)
+		/* Get the replacement buffer first so that a pool exhaustion
+		 * leaves the completed frame in place for the next poll.
+		 */
+		new_page = axienet_rx_alloc_page(q, &mapping);
+		if (!new_page) {
+			q->rx_alloc_fail++;
 			break;
+		}
 
 #ifdef CONFIG_AXIENET_HAS_MCDMA
 		tail_p = q->rx_bd_p + sizeof(*q->rxq_bd_v) * q->rx_bd_ci;
@@ -1484,65 +2102,103 @@ static int axienet_recv(struct net_device *ndev, int budget,
 		tail_p = q->rx_bd_p + sizeof(*q->rx_bd_v) * q->rx_bd_ci;
 #endif
 
-		dma_unmap_single(ndev->dev.parent, cur_p->phys,
-				 lp->max_frm_size,
-				 DMA_FROM_DEVICE);
-
-		skb = (struct sk_buff *)(cur_p->sw_id_offset);
+		page = (struct page *)(cur_p->sw_id_offset);
 
-		/* skb could be NULL if a previous pass already received the
+		/* page could be NULL if a previous pass already received the
 		 * packet for this slot in the ring, but failed to refill it
 		 * with a newly allocated buffer. In this case, don't try to
 		 * receive it again.
 		 */
-		if (likely(skb)) {
+		if (likely(page)) {
 			if (lp->eth_hasnobuf ||
 			    lp->axienet_config->mactype != XAXIENET_1G)
 				length = cur_p->status & XAXIDMA_BD_STS_ACTUAL_LEN_MASK;
 			else
 				length = cur_p->app4 & 0x0000FFFF;
 
-			skb_put(skb, length);
+			size += length;
+			packets++;
+
+			dma_sync_single_for_cpu(ndev->dev.parent,
+						page_pool_get_dma_addr(page) +
+						XAE_RX_HEADROOM, length,
+						page_pool_get_dma_dir(q->page_pool));
 
+			headroom = XAE_RX_HEADROOM;
 #ifdef CONFIG_XILINX_AXI_EMAC_HWTSTAMP
+			rx_ts = false;
 			if ((lp->tstamp_config.rx_filter == HWTSTAMP_FILTER_ALL ||
 			     lp->eth_hasptp) &&
 			    lp->axienet_config->mactype != XAXIENET_10G_25G &&
 			    lp->axienet_config->mactype != XAXIENET_MRMAC) {
+				u8 *data = page_address(page) + headroom;
 				u32 sec, nsec;
-				u64 time64;
-				struct skb_shared_hwtstamps *shhwtstamps;
 
 				if (lp->axienet_config->mactype == XAXIENET_1G ||
 				    lp->axienet_config->mactype == XAXIENET_2_5G) {
 					/* The first 8 bytes will be the timestamp */
-					memcpy(&sec, &skb->data[0], 4);
-					memcpy(&nsec, &skb->data[4], 4);
+					memcpy(&sec, &data[0], 4);
+					memcpy(&nsec, &data[4], 4);
 
 					sec = cpu_to_be32(sec);
 					nsec = cpu_to_be32(nsec);
 				} else {
 					/* The first 8 bytes will be the timestamp */
-					memcpy(&nsec, &skb->data[0], 4);
-					memcpy(&sec, &skb->data[4], 4);
+					memcpy(&nsec, &data[0], 4);
+					memcpy(&sec, &data[4], 4);
 				}
 
 				/* Remove these 8 bytes from the buffer */
-				skb_pull(skb, 8);
+				headroom += 8;
+				length -= 8;
 				time64 = sec * NS_PER_SEC + nsec;
-				shhwtstamps = skb_hwtstamps(skb);
-				shhwtstamps->hwtstamp = ns_to_ktime(time64);
-			} else if (lp->axienet_config->mactype == XAXIENET_10G_25G ||
-				   lp->axienet_config->mactype == XAXIENET_MRMAC) {
-				axienet_rx_hwtstamp(lp, skb);
+				rx_ts = true;
 			}
+#endif
+			xdp_init_buff(&xdp, PAGE_SIZE << q->page_pool->p.order,
+				      &q->xdp_rxq);
+			xdp_prepare_buff(&xdp, page_address(page), headroom,
+					 length, false);
+
+			xdp_prog = READ_ONCE(lp->xdp_prog);
+			if (xdp_prog) {
+				xdp_res = axienet_run_xdp(lp, q, xdp_prog, &xdp);
+				if (xdp_res != AXIENET_XDP_PASS) {
+					xdp_status |= xdp_res;
+#ifdef CONFIG_XILINX_AXI_EMAC_HWTSTAMP
+					if (lp->axienet_config->mactype == XAXIENET_10G_25G ||
+					    lp->axienet_config->mactype == XAXIENET_MRMAC)
+						axienet_rx_hwtstamp(lp, NULL);
+#endif
+					goto refill;
+				}
+			}
+
+			skb = napi_build_skb(xdp.data_hard_start, xdp.frame_sz);
+			if (unlikely(!skb)) {
+				page_pool_recycle_direct(q->page_pool, page);
+				ndev->stats.rx_dropped++;
+				goto refill;
+			}
+			skb_mark_for_recycle(skb);
+			skb_reserve(skb, xdp.data - xdp.data_hard_start);
+			skb_put(skb, xdp.data_end - xdp.data);
+
+#ifdef CONFIG_XILINX_AXI_EMAC_HWTSTAMP
+			if (rx_ts)
+				skb_hwtstamps(skb)->hwtstamp = ns_to_ktime(time64);
+			else if (lp->axienet_config->mactype == XAXIENET_10G_25G ||
+				 lp->axienet_config->mactype == XAXIENET_MRMAC)
+				axienet_rx_hwtstamp(lp, skb);
 #endif
 			skb->protocol = eth_type_trans(skb, ndev);
+			skb_record_rx_queue(skb, q->xdp_rxq.queue_index);
 			/*skb_checksum_none_assert(skb);*/
 			skb->ip_summed = CHECKSUM_NONE;
 
 			/* if we're doing Rx csum offload, set it up */
-			if (lp->features & XAE_FEATURE_FULL_RX_CSUM &&
+			if ((ndev->features & NETIF_F_RXCSUM) &&
+			    lp->features & XAE_FEATURE_FULL_RX_CSUM &&
 			    lp->axienet_config->mactype == XAXIENET_1G &&
 			    !lp->eth_hasnobuf) {
 				csumstatus = (cur_p->app2 &
@@ -1551,7 +2207,8 @@ static int axienet_recv(struct net_device *ndev, int budget,
 				    csumstatus == XAE_IP_UDP_CSUM_VALIDATED) {
 					skb->ip_summed = CHECKSUM_UNNECESSARY;
 				}
-			} else if ((lp->features & XAE_FEATURE_PARTIAL_RX_CSUM) != 0 &&
+			} else if ((ndev->features & NETIF_F_RXCSUM) &&
+				   (lp->features & XAE_FEATURE_PARTIAL_RX_CSUM) != 0 &&
 				   skb->protocol == htons(ETH_P_IP) &&
 				   skb->len > 64 && !lp->eth_hasnobuf &&
 				   lp->axienet_config->mactype == XAXIENET_1G) {
@@ -1559,29 +2216,15 @@ static int axienet_recv(struct net_device *ndev, int budget,
 				skb->ip_summed = CHECKSUM_COMPLETE;
 			}
 
-		netif_receive_skb(skb);
-
-			size += length;
-			packets++;
+		axienet_lat_rx_frame(q);
+		napi_gro_receive(napi, skb);
 		}
 
-		/* Ensure that the skb is completely updated
-		 * prio to mapping the DMA
-		 */
-		wmb();
-
-		cur_p->phys = dma_map_single(ndev->dev.parent, new_skb->data,
-					     lp->max_frm_size,
-					     DMA_FROM_DEVICE);
-		if (unlikely(dma_mapping_error(ndev->dev.parent, cur_p->phys))) {
-			cur_p->phys = 0;
-			dev_kfree_skb(new_skb);
-			dev_err(lp->dev, "RX buffer map failed\n");
-			break;
-		}
+refill:
+		cur_p->phys = mapping;
 		cur_p->cntrl = lp->max_frm_size;
 		cur_p->status = 0;
-		cur_p->sw_id_offset = (phys_addr_t)new_skb;
+		cur_p->sw_id_offset = (phys_addr_t)new_page;
 
 		if (++q->rx_bd_ci >= lp->rx_bd_num)
 			q->rx_bd_ci = 0;
@@ -1601,6 +2244,9 @@ static int axienet_recv(struct net_device *ndev, int budget,
 	q->rx_packets += packets;
 	q->rx_bytes += size;
 
+	if (xdp_status & AXIENET_XDP_REDIR)
+		xdp_do_flush();
+
 	if (tail_p) {
 #ifdef CONFIG_AXIENET_HAS_MCDMA
 		axienet_dma_bdout(q, XMCDMA_CHAN_TAILDESC_OFFSET(q->chan_id) +
@@ -1633,10 +2279,19 @@ int xaxienet_rx_poll(struct napi_struct *napi, int quota)
 
 	struct axienet_dma_q *q = lp->dq[map];
 
+	axienet_lat_rx_poll(q);
+
 #ifdef CONFIG_AXIENET_HAS_MCDMA
 	spin_lock(&q->rx_lock);
 	status = axienet_dma_in32(q, XMCDMA_CHAN_SR_OFFSET(q->chan_id) +
 				  q->rx_offset);
+	if (q->xsk_pool) {
+		/* Always run so that an XSK wakeup refills an empty ring */
+		axienet_dma_out32(q, XMCDMA_CHAN_SR_OFFSET(q->chan_id) +
+				  q->rx_offset, status);
+		work_done = axienet_mcdma_xsk_recv(napi, quota, q);
+		status = 0;
+	}
 	while ((status & (XMCDMA_IRQ_IOC_MASK | XMCDMA_IRQ_DELAY_MASK)) &&
 	       (work_done < quota)) {
 		axienet_dma_out32(q, XMCDMA_CHAN_SR_OFFSET(q->chan_id) +
@@ -1645,7 +2300,7 @@ int xaxienet_rx_poll(struct napi_struct *napi, int quota)
 			dev_err(lp->dev, "Rx error 0x%x\n\r", status);
 			break;
 		}
-		work_done += axienet_recv(lp->ndev, quota - work_done, q);
+		work_done += axienet_recv(napi, quota - work_done, q);
 		status = axienet_dma_in32(q, XMCDMA_CHAN_SR_OFFSET(q->chan_id) +
 					  q->rx_offset);
 	}
@@ -1661,32 +2316,104 @@ int xaxienet_rx_poll(struct napi_struct *napi, int quota)
 			dev_err(lp->dev, "Rx error 0x%x\n\r", status);
 			break;
 		}
-		work_done += axienet_recv(lp->ndev, quota - work_done, q);
+		work_done += axienet_recv(napi, quota - work_done, q);
 		status = axienet_dma_in32(q, XAXIDMA_RX_SR_OFFSET);
 	}
 	spin_unlock(&q->rx_lock);
 #endif
 
 	if (work_done < quota) {
-		napi_complete(napi);
+		if (READ_ONCE(q->rx_dim_enabled)) {
+			struct dim_sample sample = {};
+
+			dim_update_sample(q->rx_dim_events++, q->rx_packets,
+					  q->rx_bytes, &sample);
+			net_dim(&q->rx_dim, sample);
+		}
+
+		napi_complete_done(napi, work_done);
 #ifdef CONFIG_AXIENET_HAS_MCDMA
 		/* Enable the interrupts again */
 		cr = axienet_dma_in32(q, XMCDMA_CHAN_CR_OFFSET(q->chan_id) +
 				      XMCDMA_RX_OFFSET);
+		cr &= ~(XMCDMA_COALESCE_MASK | XMCDMA_DELAY_MASK);
+		cr |= READ_ONCE(q->rx_coalesce_cr);
 		cr |= (XMCDMA_IRQ_IOC_MASK | XMCDMA_IRQ_DELAY_MASK);
 		axienet_dma_out32(q, XMCDMA_CHAN_CR_OFFSET(q->chan_id) +
 				  XMCDMA_RX_OFFSET, cr);
 #else
 		/* Enable the interrupts again */
 		cr = axienet_dma_in32(q, XAXIDMA_RX_CR_OFFSET);
+		cr &= ~(XAXIDMA_COALESCE_MASK | XAXIDMA_DELAY_MASK);
+		cr |= READ_ONCE(q->rx_coalesce_cr);
 		cr |= (XAXIDMA_IRQ_IOC_MASK | XAXIDMA_IRQ_DELAY_MASK);
 		axienet_dma_out32(q, XAXIDMA_RX_CR_OFFSET, cr);
 #endif
+	} else {
+		q->rx_napi_full++;
 	}
 
 	return work_done;
 }
 
+/**
+ * axienet_tx_poll - Poll routine for tx completions (NAPI)
+ * @napi:	napi structure pointer
+ * @budget:	NAPI budget
+ *
+ * Reclaims all completed Tx BDs and re-enables the Tx completion
+ * interrupts that the Tx isr masked. Running this outside hard irq
+ * context lets XDP frames be returned to their page pool. Queues bound to
+ * an AF_XDP socket also pick up to @budget new frames from its Tx ring.
+ *
+ * Return: 0 when done, @budget if AF_XDP frames are still pending.
+ */
+int axienet_tx_poll(struct napi_struct *napi, int budget)
+{
+	struct net_device *ndev = napi->dev;
+	struct axienet_local *lp = netdev_priv(ndev);
+	struct axienet_dma_q *q = lp->dq[napi - lp->napi_tx];
+	u32 cr;
+
+	axienet_start_xmit_done(ndev, q,
+				netdev_get_tx_queue(ndev, napi - lp->napi_tx),
+				budget);
+
+#ifdef CONFIG_AXIENET_HAS_MCDMA
+	if (q->xsk_pool) {
+		if (!axienet_mcdma_xsk_xmit(q, budget))
+			return budget;
+		if (xsk_uses_need_wakeup(q->xsk_pool))
+			xsk_set_tx_need_wakeup(q->xsk_pool);
+	}
+#endif
+
+	if (READ_ONCE(q->tx_dim_enabled)) {
+		struct dim_sample sample = {};
+
+		dim_update_sample(q->tx_dim_events++, q->tx_packets,
+				  q->tx_bytes, &sample);
+		net_dim(&q->tx_dim, sample);
+	}
+
+	napi_complete(napi);
+#ifdef CONFIG_AXIENET_HAS_MCDMA
+	cr = axienet_dma_in32(q, XMCDMA_CHAN_CR_OFFSET(q->chan_id));
+	cr &= ~(XMCDMA_COALESCE_MASK | XMCDMA_DELAY_MASK);
+	cr |= READ_ONCE(q->tx_coalesce_cr);
+	cr |= (XMCDMA_IRQ_IOC_MASK | XMCDMA_IRQ_DELAY_MASK);
+	axienet_dma_out32(q, XMCDMA_CHAN_CR_OFFSET(q->chan_id), cr);
+#else
+	cr = axienet_dma_in32(q, XAXIDMA_TX_CR_OFFSET);
+	cr &= ~(XAXIDMA_COALESCE_MASK | XAXIDMA_DELAY_MASK);
+	cr |= READ_ONCE(q->tx_coalesce_cr);
+	cr |= (XAXIDMA_IRQ_IOC_MASK | XAXIDMA_IRQ_DELAY_MASK);
+	axienet_dma_out32(q, XAXIDMA_TX_CR_OFFSET, cr);
+#endif
+
+	return 0;
+}
+
 /**
  * axienet_eth_irq - Ethernet core Isr.
  * @irq:	irq number
@@ -1716,6 +2443,35 @@ static irqreturn_t axienet_eth_irq(int irq, void *_ndev)
 	return IRQ_HANDLED;
 }
 
+/**
+ * axienet_set_irq_affinity - Spread the DMA channel irqs across CPUs
+ * @ndev:	Pointer to net_device structure
+ * @set:	Set the hints when true, drop them when false
+ *
+ * The Rx and Tx irqs of a queue get the same CPU so that the NAPI
+ * instances of a channel run together, and channels are handed out to
+ * CPUs close to the device first. The hints must be dropped before the
+ * irqs are freed.
+ */
+static void axienet_set_irq_affinity(struct net_device *ndev, bool set)
+{
+	struct axienet_local *lp = netdev_priv(ndev);
+	const struct cpumask *mask = NULL;
+	int i;
+
+	if (lp->num_rx_queues < 2)
+		return;
+
+	for_each_rx_dma_queue(lp, i) {
+		if (set)
+			mask = cpumask_of(cpumask_local_spread(i,
+							       dev_to_node(lp->dev)));
+		irq_set_affinity_and_hint(lp->dq[i]->rx_irq, mask);
+		if (i < lp->num_tx_queues)
+			irq_set_affinity_and_hint(lp->dq[i]->tx_irq, mask);
+	}
+}
+
 /**
  * axienet_open - Driver open routine.
  * @ndev:	Pointer to net_device structure
@@ -1778,8 +2534,17 @@ static int axienet_open(struct net_device *ndev)
 		 * If NAPI scheduling is (still) disabled at that time, no more RX IRQs
 		 * will be processed as only the NAPI function re-enables them!
 		 */
+		memset(&lp->dq[i]->rx_dim, 0, sizeof(lp->dq[i]->rx_dim));
+		INIT_WORK(&lp->dq[i]->rx_dim.work, axienet_rx_dim_work);
+		lp->dq[i]->rx_dim.mode = DIM_CQ_PERIOD_MODE_START_FROM_EQE;
 		napi_enable(&lp->napi[i]);
 	}
+	for_each_tx_dma_queue(lp, i) {
+		memset(&lp->dq[i]->tx_dim, 0, sizeof(lp->dq[i]->tx_dim));
+		INIT_WORK(&lp->dq[i]->tx_dim.work, axienet_tx_dim_work);
+		lp->dq[i]->tx_dim.mode = DIM_CQ_PERIOD_MODE_START_FROM_EQE;
+		napi_enable(&lp->napi_tx[i]);
+	}
 	for_each_tx_dma_queue(lp, i) {
 		struct axienet_dma_q *q = lp->dq[i];
 #ifdef CONFIG_AXIENET_HAS_MCDMA
@@ -1814,6 +2579,8 @@ static int axienet_open(struct net_device *ndev)
 #endif
 	}
 
+	axienet_set_irq_affinity(ndev, true);
+
 	if (lp->phy_mode == PHY_INTERFACE_MODE_USXGMII) {
 		netdev_dbg(ndev, "RX reg: 0x%x\n",
 			   axienet_ior(lp, XXV_RCW1_OFFSET));
@@ -1935,6 +2702,7 @@ static int axienet_open(struct net_device *ndev)
 	return 0;
 
 err_eth_irq:
+	axienet_set_irq_affinity(ndev, false);
 	while (i--) {
 		q = lp->dq[i];
 		free_irq(q->rx_irq, ndev);
@@ -1946,6 +2714,8 @@ static int axienet_open(struct net_device *ndev)
 		free_irq(q->tx_irq, ndev);
 	}
 err_tx_irq:
+	for_each_tx_dma_queue(lp, i)
+		napi_disable(&lp->napi_tx[i]);
 	for_each_rx_dma_queue(lp, i)
 		napi_disable(&lp->napi[i]);
 	if (lp->phylink) {
@@ -1986,6 +2756,8 @@ static int axienet_stop(struct net_device *ndev)
 	lp->axienet_config->setoptions(ndev, lp->options &
 			   ~(XAE_OPTION_TXEN | XAE_OPTION_RXEN));
 
+	axienet_set_irq_affinity(ndev, false);
+
 	for_each_tx_dma_queue(lp, i) {
 		q = lp->dq[i];
 		cr = axienet_dma_in32(q, XAXIDMA_RX_CR_OFFSET);
@@ -2016,16 +2788,24 @@ static int axienet_stop(struct net_device *ndev)
 		__axienet_device_reset(q);
 		axienet_unlock_mii(lp);
 		free_irq(q->tx_irq, ndev);
+		napi_disable(&lp->napi_tx[i]);
+		cancel_work_sync(&q->tx_dim.work);
 	}
 
 	for_each_rx_dma_queue(lp, i) {
 		q = lp->dq[i];
 		netif_stop_queue(ndev);
 		napi_disable(&lp->napi[i]);
+		cancel_work_sync(&q->rx_dim.work);
 		tasklet_kill(&lp->dma_err_tasklet[i]);
 		free_irq(q->rx_irq, ndev);
 	}
 
+#ifdef CONFIG_XILINX_AXI_EMAC_HWTSTAMP
+	del_timer_sync(&lp->ptp_txts_timer);
+	skb_queue_purge(&lp->ptp_txq);
+#endif
+
 	if (lp->axienet_config->mactype == XAXIENET_1G && !lp->eth_hasnobuf)
 		free_irq(lp->eth_irq, ndev);
 
@@ -2055,11 +2835,147 @@ static int axienet_change_mtu(struct net_device *ndev, int new_mtu)
 		XAE_TRL_SIZE) > lp->rxmem)
 		return -EINVAL;
 
+	if (lp->xdp_prog && !axienet_xdp_mtu_ok(new_mtu)) {
+		netdev_err(ndev, "MTU %d too large for XDP\n", new_mtu);
+		return -EINVAL;
+	}
+
 	ndev->mtu = new_mtu;
 
 	return 0;
 }
 
+/**
+ * axienet_xdp_setup - Attach or detach an XDP program
+ * @ndev:	Pointer to net_device structure
+ * @prog:	New XDP program, NULL to detach
+ * @extack:	Netlink extended ack for error reporting
+ *
+ * The Rx page pools are mapped bidirectionally while a program is attached
+ * so that XDP_TX can reuse them, hence a running interface is restarted
+ * when a program is added or removed.
+ *
+ * Return: 0, on success. Non-zero error value on failure.
+ */
+static int axienet_xdp_setup(struct net_device *ndev, struct bpf_prog *prog,
+			     struct netlink_ext_ack *extack)
+{
+	struct axienet_local *lp = netdev_priv(ndev);
+	bool need_reset = !!lp->xdp_prog != !!prog;
+	bool running = netif_running(ndev);
+	struct bpf_prog *old_prog;
+
+	if (prog && !axienet_xdp_mtu_ok(ndev->mtu)) {
+		NL_SET_ERR_MSG_MOD(extack, "MTU too large for XDP");
+		return -EOPNOTSUPP;
+	}
+
+	if (running && need_reset)
+		axienet_stop(ndev);
+
+	old_prog = xchg(&lp->xdp_prog, prog);
+	if (old_prog)
+		bpf_prog_put(old_prog);
+
+	if (running && need_reset)
+		return axienet_open(ndev);
+
+	return 0;
+}
+
+#ifdef CONFIG_AXIENET_HAS_MCDMA
+/**
+ * axienet_xsk_pool_setup - Bind or unbind an AF_XDP pool to an MCDMA queue
+ * @ndev:	Pointer to net_device structure
+ * @pool:	XSK buffer pool, NULL to unbind
+ * @qid:	Queue the pool is bound to
+ *
+ * The Rx ring of the queue is rebuilt from the new buffer source, so a
+ * running interface is restarted.
+ *
+ * Return: 0, on success. Non-zero error value on failure.
+ */
+static int axienet_xsk_pool_setup(struct net_device *ndev,
+				  struct xsk_buff_pool *pool, u16 qid)
+{
+	bool running = netif_running(ndev);
+	int ret, err;
+
+	if (running)
+		axienet_stop(ndev);
+
+	if (pool)
+		ret = axienet_mcdma_xsk_pool_enable(ndev, pool, qid);
+	else
+		ret = axienet_mcdma_xsk_pool_disable(ndev, qid);
+
+	if (running) {
+		err = axienet_open(ndev);
+		if (!ret)
+			ret = err;
+	}
+
+	return ret;
+}
+#endif
+
+/**
+ * axienet_bpf - ndo_bpf handler
+ * @ndev:	Pointer to net_device structure
+ * @bpf:	BPF command
+ *
+ * Return: 0, on success. Non-zero error value on failure.
+ */
+static int axienet_bpf(struct net_device *ndev, struct netdev_bpf *bpf)
+{
+	switch (bpf->command) {
+	case XDP_SETUP_PROG:
+		return axienet_xdp_setup(ndev, bpf->prog, bpf->extack);
+#ifdef CONFIG_AXIENET_HAS_MCDMA
+	case XDP_SETUP_XSK_POOL:
+		return axienet_xsk_pool_setup(ndev, bpf->xsk.pool,
+					      bpf->xsk.queue_id);
+#endif
+	default:
+		return -EINVAL;
+	}
+}
+
+/**
+ * axienet_xdp_xmit - ndo_xdp_xmit handler
+ * @ndev:	Pointer to net_device structure
+ * @n:		Number of frames
+ * @frames:	Frames to transmit
+ * @flags:	XDP_XMIT_* flags
+ *
+ * The Tx tail pointer is moved for every frame, so XDP_XMIT_FLUSH needs no
+ * extra work.
+ *
+ * Return: Number of frames queued, or a negative errno.
+ */
+static int axienet_xdp_xmit(struct net_device *ndev, int n,
+			    struct xdp_frame **frames, u32 flags)
+{
+	struct axienet_local *lp = netdev_priv(ndev);
+	struct axienet_dma_q *q;
+	int i, nxmit = 0;
+
+	if (unlikely(flags & ~XDP_XMIT_FLAGS_MASK))
+		return -EINVAL;
+
+	if (unlikely(!netif_running(ndev) || !netif_carrier_ok(ndev)))
+		return -ENETDOWN;
+
+	q = axienet_xdp_tx_queue(lp);
+	for (i = 0; i < n; i++) {
+		if (axienet_xdp_xmit_frame(lp, q, frames[i], true))
+			break;
+		nxmit++;
+	}
+
+	return nxmit;
+}
+
 #ifdef CONFIG_NET_POLL_CONTROLLER
 /**
  * axienet_poll_controller - Axi Ethernet poll mechanism.
@@ -2245,6 +3161,19 @@ static int axienet_ioctl(struct net_device *dev, struct ifreq *rq, int cmd)
 	}
 }
 
+static int axienet_setup_tc(struct net_device *ndev, enum tc_setup_type type,
+			    void *type_data)
+{
+	switch (type) {
+#ifdef CONFIG_AXIENET_HAS_MCDMA
+	case TC_SETUP_QDISC_MQPRIO:
+		return axienet_mcdma_setup_mqprio(ndev, type_data);
+#endif
+	default:
+		return -EOPNOTSUPP;
+	}
+}
+
 static const struct net_device_ops axienet_netdev_ops = {
 	.ndo_open = axienet_open,
 	.ndo_stop = axienet_stop,
@@ -2257,6 +3186,12 @@ static const struct net_device_ops axienet_netdev_ops = {
 	.ndo_do_ioctl = axienet_ioctl,
 #ifdef CONFIG_NET_POLL_CONTROLLER
 	.ndo_poll_controller = axienet_poll_controller,
+#endif
+	.ndo_bpf = axienet_bpf,
+	.ndo_xdp_xmit = axienet_xdp_xmit,
+	.ndo_setup_tc = axienet_setup_tc,
+#ifdef CONFIG_AXIENET_HAS_MCDMA
+	.ndo_xsk_wakeup = axienet_mcdma_xsk_wakeup,
 #endif
 };
 
@@ -2372,6 +3307,60 @@ axienet_ethtools_get_ringparam(struct net_device *ndev,
 	ering->tx_pending = lp->tx_bd_num;
 }
 
+static void
+axienet_ethtools_get_channels(struct net_device *ndev,
+			      struct ethtool_channels *ch)
+{
+	struct axienet_local *lp = netdev_priv(ndev);
+
+	ch->max_rx = lp->num_rx_queues;
+	ch->max_tx = lp->num_tx_queues;
+	ch->rx_count = lp->num_rx_queues;
+	ch->tx_count = lp->num_tx_queues;
+}
+
+/**
+ * axienet_ethtools_get_rxnfc - Get Rx flow classification information.
+ * @ndev:	Pointer to net_device structure
+ * @cmd:	Pointer to ethtool_rxnfc structure
+ * @rule_locs:	Unused, no classification rules are kept by the driver
+ *
+ * The Rx channel of a frame is picked by the TDEST the stream logic in
+ * front of the DMA drives, so only the number of rings can be reported.
+ * Issue "ethtool -n ethX" under linux prompt to execute this function.
+ *
+ * Return: 0, on success, Non-zero error value on failure.
+ */
+static int
+axienet_ethtools_get_rxnfc(struct net_device *ndev, struct ethtool_rxnfc *cmd,
+			   u32 *rule_locs)
+{
+	struct axienet_local *lp = netdev_priv(ndev);
+
+	switch (cmd->cmd) {
+	case ETHTOOL_GRXRINGS:
+		cmd->data = lp->num_rx_queues;
+		return 0;
+	default:
+		return -EOPNOTSUPP;
+	}
+}
+
+/**
+ * axienet_ethtools_set_ringparam - Set the Rx and Tx BD ring sizes.
+ * @ndev:	Pointer to net_device structure
+ * @ering:	Pointer to ethtool_ringparam structure
+ * @kernel_ering: ethtool ring parameter extensions, unused
+ * @extack:	extack for reporting error messages
+ *
+ * A running interface is stopped, its rings are released and allocated
+ * again with the new size on restart. If that fails the previous sizes
+ * are restored. MCDMA rings are indexed with CIRC_SPACE() and must be a
+ * power of two. Issue "ethtool -G ethX rx 512 tx 512" under linux prompt
+ * to execute this function.
+ *
+ * Return: 0, on success, Non-zero error value on failure.
+ */
 static int
 axienet_ethtools_set_ringparam(struct net_device *ndev,
 			       struct ethtool_ringparam *ering,
@@ -2379,20 +3368,51 @@ axienet_ethtools_set_ringparam(struct net_device *ndev,
 			       struct netlink_ext_ack *extack)
 {
 	struct axienet_local *lp = netdev_priv(ndev);
+	u32 old_rx = lp->rx_bd_num;
+	u32 old_tx = lp->tx_bd_num;
+	int ret;
 
-	if (ering->rx_pending > RX_BD_NUM_MAX ||
+	if (ering->rx_pending < RX_BD_NUM_MIN ||
+	    ering->rx_pending > RX_BD_NUM_MAX ||
 	    ering->rx_mini_pending ||
 	    ering->rx_jumbo_pending ||
 	    ering->tx_pending < TX_BD_NUM_MIN ||
 	    ering->tx_pending > TX_BD_NUM_MAX)
 		return -EINVAL;
 
-	if (netif_running(ndev))
-		return -EBUSY;
+#ifdef CONFIG_AXIENET_HAS_MCDMA
+	if (!is_power_of_2(ering->rx_pending) ||
+	    !is_power_of_2(ering->tx_pending)) {
+		NL_SET_ERR_MSG_MOD(extack,
+				   "MCDMA ring sizes must be a power of two");
+		return -EINVAL;
+	}
+#endif
+
+	if (ering->rx_pending == old_rx && ering->tx_pending == old_tx)
+		return 0;
+
+	if (!netif_running(ndev)) {
+		lp->rx_bd_num = ering->rx_pending;
+		lp->tx_bd_num = ering->tx_pending;
+		return 0;
+	}
 
+	axienet_stop(ndev);
 	lp->rx_bd_num = ering->rx_pending;
 	lp->tx_bd_num = ering->tx_pending;
-	return 0;
+	ret = axienet_open(ndev);
+	if (!ret)
+		return 0;
+
+	netdev_err(ndev, "ring resize failed (%d), restoring %u/%u BDs\n",
+		   ret, old_rx, old_tx);
+	lp->rx_bd_num = old_rx;
+	lp->tx_bd_num = old_tx;
+	if (axienet_open(ndev))
+		netdev_err(ndev, "failed to restart with the previous rings\n");
+
+	return ret;
 }
 
 /**
@@ -2447,7 +3467,8 @@ axienet_ethtools_set_pauseparam(struct net_device *ndev,
  *
  * This implements ethtool command for getting the DMA interrupt coalescing
  * count on Tx and Rx paths. Issue "ethtool -c ethX" under linux prompt to
- * execute this function.
+ * execute this function. The configured values are reported, DIM may be
+ * running the channels with different ones.
  *
  * Return: 0 always
  */
@@ -2457,31 +3478,39 @@ axienet_ethtools_get_coalesce(struct net_device *ndev,
 			      struct kernel_ethtool_coalesce *kernel_coal,
 			      struct netlink_ext_ack *extack)
 {
-	u32 regval = 0;
 	struct axienet_local *lp = netdev_priv(ndev);
-	struct axienet_dma_q *q;
-	int i;
 
-	for_each_rx_dma_queue(lp, i) {
-		q = lp->dq[i];
+	ecoalesce->rx_max_coalesced_frames = lp->coalesce_count_rx;
+	ecoalesce->rx_coalesce_usecs = lp->coalesce_usec_rx;
+	ecoalesce->tx_max_coalesced_frames = lp->coalesce_count_tx;
+	ecoalesce->tx_coalesce_usecs = lp->coalesce_usec_tx;
+	ecoalesce->use_adaptive_rx_coalesce = lp->dq[0]->rx_dim_enabled;
+	ecoalesce->use_adaptive_tx_coalesce = lp->dq[0]->tx_dim_enabled;
 
-		regval = axienet_dma_in32(q, XAXIDMA_RX_CR_OFFSET);
-		ecoalesce->rx_max_coalesced_frames +=
-						(regval & XAXIDMA_COALESCE_MASK)
-						     >> XAXIDMA_COALESCE_SHIFT;
-		ecoalesce->rx_coalesce_usecs = lp->coalesce_usec_rx;
-	}
-	for_each_tx_dma_queue(lp, i) {
-		q = lp->dq[i];
-		regval = axienet_dma_in32(q, XAXIDMA_TX_CR_OFFSET);
-		ecoalesce->tx_max_coalesced_frames +=
-						(regval & XAXIDMA_COALESCE_MASK)
-						     >> XAXIDMA_COALESCE_SHIFT;
-		ecoalesce->tx_coalesce_usecs = lp->coalesce_usec_tx;
-	}
 	return 0;
 }
 
+/**
+ * axienet_coalesce_changed - Check for new static coalesce settings
+ * @lp:		Pointer to axienet local structure
+ * @ecoalesce:	Pointer to ethtool_coalesce structure
+ *
+ * Return: true if @ecoalesce carries a count or delay different from the
+ * current configuration.
+ */
+static bool axienet_coalesce_changed(struct axienet_local *lp,
+				     const struct ethtool_coalesce *ecoalesce)
+{
+	return (ecoalesce->rx_max_coalesced_frames &&
+		ecoalesce->rx_max_coalesced_frames != lp->coalesce_count_rx) ||
+	       (ecoalesce->rx_coalesce_usecs &&
+		ecoalesce->rx_coalesce_usecs != lp->coalesce_usec_rx) ||
+	       (ecoalesce->tx_max_coalesced_frames &&
+		ecoalesce->tx_max_coalesced_frames != lp->coalesce_count_tx) ||
+	       (ecoalesce->tx_coalesce_usecs &&
+		ecoalesce->tx_coalesce_usecs != lp->coalesce_usec_tx);
+}
+
 /**
  * axienet_ethtools_set_coalesce - Set DMA interrupt coalescing count.
  * @ndev:	Pointer to net_device structure
@@ -2491,7 +3520,8 @@ axienet_ethtools_get_coalesce(struct net_device *ndev,
  *
  * This implements ethtool command for setting the DMA interrupt coalescing
  * count on Tx and Rx paths. Issue "ethtool -C ethX rx-frames 5" under linux
- * prompt to execute this function.
+ * prompt to execute this function. Adaptive moderation can be switched with
+ * "ethtool -C ethX adaptive-rx on" at any time.
  *
  * Return: 0, on success, Non-zero error value on failure.
  */
@@ -2502,13 +3532,21 @@ axienet_ethtools_set_coalesce(struct net_device *ndev,
 			      struct netlink_ext_ack *extack)
 {
 	struct axienet_local *lp = netdev_priv(ndev);
+	int i;
 
-	if (netif_running(ndev)) {
+	if (netif_running(ndev) && axienet_coalesce_changed(lp, ecoalesce)) {
 		netdev_err(ndev,
 			   "Please stop netif before applying configuration\n");
 		return -EFAULT;
 	}
 
+	for_each_rx_dma_queue(lp, i)
+		axienet_rx_dim_set(ndev, lp->dq[i],
+				   ecoalesce->use_adaptive_rx_coalesce);
+	for_each_tx_dma_queue(lp, i)
+		axienet_tx_dim_set(ndev, lp->dq[i],
+				   ecoalesce->use_adaptive_tx_coalesce);
+
 	if (ecoalesce->rx_max_coalesced_frames)
 		lp->coalesce_count_rx = ecoalesce->rx_max_coalesced_frames;
 	if (ecoalesce->rx_coalesce_usecs)
@@ -2521,6 +3559,77 @@ axienet_ethtools_set_coalesce(struct net_device *ndev,
 	return 0;
 }
 
+/**
+ * axienet_ethtools_get_per_queue_coalesce - Get coalescing of one queue
+ * @ndev:	Pointer to net_device structure
+ * @queue:	Queue index
+ * @ecoalesce:	Pointer to ethtool_coalesce structure
+ *
+ * Issue "ethtool --per-queue ethX queue_mask 0x1 --show-coalesce" under linux
+ * prompt to execute this function.
+ *
+ * Return: 0, on success, Non-zero error value on failure.
+ */
+static int
+axienet_ethtools_get_per_queue_coalesce(struct net_device *ndev, u32 queue,
+					struct ethtool_coalesce *ecoalesce)
+{
+	struct axienet_local *lp = netdev_priv(ndev);
+
+	if (queue >= max(lp->num_rx_queues, lp->num_tx_queues))
+		return -EINVAL;
+
+	ecoalesce->rx_max_coalesced_frames = lp->coalesce_count_rx;
+	ecoalesce->rx_coalesce_usecs = lp->coalesce_usec_rx;
+	ecoalesce->tx_max_coalesced_frames = lp->coalesce_count_tx;
+	ecoalesce->tx_coalesce_usecs = lp->coalesce_usec_tx;
+	if (queue < lp->num_rx_queues)
+		ecoalesce->use_adaptive_rx_coalesce =
+			lp->dq[queue]->rx_dim_enabled;
+	if (queue < lp->num_tx_queues)
+		ecoalesce->use_adaptive_tx_coalesce =
+			lp->dq[queue]->tx_dim_enabled;
+
+	return 0;
+}
+
+/**
+ * axienet_ethtools_set_per_queue_coalesce - Set coalescing of one queue
+ * @ndev:	Pointer to net_device structure
+ * @queue:	Queue index
+ * @ecoalesce:	Pointer to ethtool_coalesce structure
+ *
+ * Only adaptive moderation is per queue, the static count and delay are
+ * shared by all channels. Issue "ethtool --per-queue ethX queue_mask 0x2
+ * --coalesce adaptive-rx on" under linux prompt to execute this function.
+ *
+ * Return: 0, on success, Non-zero error value on failure.
+ */
+static int
+axienet_ethtools_set_per_queue_coalesce(struct net_device *ndev, u32 queue,
+					struct ethtool_coalesce *ecoalesce)
+{
+	struct axienet_local *lp = netdev_priv(ndev);
+
+	if (queue >= max(lp->num_rx_queues, lp->num_tx_queues))
+		return -EINVAL;
+
+	if (axienet_coalesce_changed(lp, ecoalesce)) {
+		netdev_err(ndev,
+			   "Only adaptive coalescing can be set per queue\n");
+		return -EOPNOTSUPP;
+	}
+
+	if (queue < lp->num_rx_queues)
+		axienet_rx_dim_set(ndev, lp->dq[queue],
+				   ecoalesce->use_adaptive_rx_coalesce);
+	if (queue < lp->num_tx_queues)
+		axienet_tx_dim_set(ndev, lp->dq[queue],
+				   ecoalesce->use_adaptive_tx_coalesce);
+
+	return 0;
+}
+
 static int
 axienet_ethtools_get_link_ksettings(struct net_device *ndev,
 				    struct ethtool_link_ksettings *cmd)
@@ -2601,6 +3710,22 @@ static int axienet_ethtools_get_ts_info(struct net_device *ndev,
 }
 #endif
 
+/**
+ * axienet_dma_sset_count - Get the number of statistics in front of the
+ *			    per-queue ones
+ * @ndev:	Pointer to net_device structure
+ *
+ * Return: number of global and DMA specific statistics.
+ */
+static int axienet_dma_sset_count(struct net_device *ndev)
+{
+#ifdef CONFIG_AXIENET_HAS_MCDMA
+	return axienet_sset_count(ndev, ETH_SS_STATS);
+#else
+	return AXIENET_ETHTOOLS_SSTATS_LEN;
+#endif
+}
+
 /**
  * axienet_ethtools_sset_count - Get number of strings that
  *				 get_strings will write.
@@ -2612,13 +3737,12 @@ static int axienet_ethtools_get_ts_info(struct net_device *ndev,
  */
 int axienet_ethtools_sset_count(struct net_device *ndev, int sset)
 {
+	struct axienet_local *lp = netdev_priv(ndev);
+
 	switch (sset) {
 	case ETH_SS_STATS:
-#ifdef CONFIG_AXIENET_HAS_MCDMA
-		return axienet_sset_count(ndev, sset);
-#else
-		return AXIENET_ETHTOOLS_SSTATS_LEN;
-#endif
+		return axienet_dma_sset_count(ndev) +
+		       lp->num_rx_queues * AXIENET_QUEUE_SSTATS_LEN;
 	default:
 		return -EOPNOTSUPP;
 	}
@@ -2637,7 +3761,10 @@ void axienet_ethtools_get_stats(struct net_device *ndev,
 				struct ethtool_stats *stats,
 				u64 *data)
 {
+	struct axienet_local *lp = netdev_priv(ndev);
+	struct axienet_dma_q *q;
 	unsigned int i = 0;
+	int j;
 
 	data[i++] = ndev->stats.tx_packets;
 	data[i++] = ndev->stats.rx_packets;
@@ -2649,6 +3776,14 @@ void axienet_ethtools_get_stats(struct net_device *ndev,
 #ifdef CONFIG_AXIENET_HAS_MCDMA
 	axienet_get_stats(ndev, stats, data);
 #endif
+
+	i = axienet_dma_sset_count(ndev);
+	for_each_rx_dma_queue(lp, j) {
+		q = lp->dq[j];
+		data[i++] = q->rx_alloc_fail;
+		data[i++] = q->tx_ring_full;
+		data[i++] = q->rx_napi_full;
+	}
 }
 
 /**
@@ -2662,7 +3797,8 @@ void axienet_ethtools_get_stats(struct net_device *ndev,
  */
 void axienet_ethtools_strings(struct net_device *ndev, u32 sset, u8 *data)
 {
-	int i;
+	struct axienet_local *lp = netdev_priv(ndev);
+	int i, j, k;
 
 	for (i = 0; i < AXIENET_ETHTOOLS_SSTATS_LEN; i++) {
 		if (sset == ETH_SS_STATS)
@@ -2673,21 +3809,36 @@ void axienet_ethtools_strings(struct net_device *ndev, u32 sset, u8 *data)
 #ifdef CONFIG_AXIENET_HAS_MCDMA
 	axienet_strings(ndev, sset, data);
 #endif
+
+	if (sset != ETH_SS_STATS)
+		return;
+
+	i = axienet_dma_sset_count(ndev);
+	for_each_rx_dma_queue(lp, j) {
+		for (k = 0; k < AXIENET_QUEUE_SSTATS_LEN; k++, i++)
+			snprintf(data + i * ETH_GSTRING_LEN, ETH_GSTRING_LEN,
+				 axienet_get_queue_strings_stats[k].name, j);
+	}
 }
 
 static const struct ethtool_ops axienet_ethtool_ops = {
 	.supported_coalesce_params = ETHTOOL_COALESCE_MAX_FRAMES |
-				     ETHTOOL_COALESCE_USECS,
+				     ETHTOOL_COALESCE_USECS |
+				     ETHTOOL_COALESCE_USE_ADAPTIVE,
 	.get_drvinfo    = axienet_ethtools_get_drvinfo,
 	.get_regs_len   = axienet_ethtools_get_regs_len,
 	.get_regs       = axienet_ethtools_get_regs,
 	.get_link       = ethtool_op_get_link,
 	.get_ringparam	= axienet_ethtools_get_ringparam,
 	.set_ringparam	= axienet_ethtools_set_ringparam,
+	.get_channels	= axienet_ethtools_get_channels,
+	.get_rxnfc	= axienet_ethtools_get_rxnfc,
 	.get_pauseparam = axienet_ethtools_get_pauseparam,
 	.set_pauseparam = axienet_ethtools_set_pauseparam,
 	.get_coalesce   = axienet_ethtools_get_coalesce,
 	.set_coalesce   = axienet_ethtools_set_coalesce,
+	.get_per_queue_coalesce = axienet_ethtools_get_per_queue_coalesce,
+	.set_per_queue_coalesce = axienet_ethtools_set_per_queue_coalesce,
 #ifdef CONFIG_XILINX_AXI_EMAC_HWTSTAMP
 	.get_ts_info    = axienet_ethtools_get_ts_info,
 #endif
@@ -2830,6 +3981,9 @@ static int __maybe_unused axienet_dma_probe(struct platform_device *pdev,
 		netif_napi_add(ndev, &lp->napi[i], xaxienet_rx_poll);
 	}
 
+	for_each_tx_dma_queue(lp, i)
+		netif_napi_add_tx(ndev, &lp->napi_tx[i], axienet_tx_poll);
+
 	return 0;
 }
 
@@ -3276,6 +4430,80 @@ static const struct of_device_id axienet_of_match[] = {
 
 MODULE_DEVICE_TABLE(of, axienet_of_match);
 
+#ifdef CONFIG_XILINX_AXI_EMAC_LAT_HIST
+static void axienet_lat_show_hist(struct seq_file *s, const char *name,
+				  const u32 *hist)
+{
+	int i;
+
+	seq_printf(s, "  %s:\n", name);
+	seq_printf(s, "    %10s  %u\n", "<1us", hist[0]);
+	for (i = 1; i < AXIENET_LAT_BUCKETS; i++)
+		seq_printf(s, "    >=%6lluns  %u\n",
+			   (u64)AXIENET_LAT_MIN_NS << (i - 1), hist[i]);
+}
+
+static int axienet_lat_show(struct seq_file *s, void *unused)
+{
+	struct axienet_local *lp = s->private;
+	int i;
+
+	for_each_rx_dma_queue(lp, i) {
+		seq_printf(s, "queue %d:\n", i);
+		axienet_lat_show_hist(s, "irq to napi", lp->dq[i]->irq_napi_hist);
+		axienet_lat_show_hist(s, "napi to stack",
+				      lp->dq[i]->napi_rx_hist);
+	}
+
+	return 0;
+}
+
+static int axienet_lat_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, axienet_lat_show, inode->i_private);
+}
+
+static ssize_t axienet_lat_write(struct file *file, const char __user *buf,
+				 size_t count, loff_t *ppos)
+{
+	struct axienet_local *lp = ((struct seq_file *)file->private_data)->private;
+	int i;
+
+	for_each_rx_dma_queue(lp, i) {
+		memset(lp->dq[i]->irq_napi_hist, 0,
+		       sizeof(lp->dq[i]->irq_napi_hist));
+		memset(lp->dq[i]->napi_rx_hist, 0,
+		       sizeof(lp->dq[i]->napi_rx_hist));
+	}
+
+	return count;
+}
+
+static const struct file_operations axienet_lat_fops = {
+	.owner = THIS_MODULE,
+	.open = axienet_lat_open,
+	.read = seq_read,
+	.write = axienet_lat_write,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
+static void axienet_debugfs_init(struct axienet_local *lp)
+{
+	lp->debugfs_dir = debugfs_create_dir(dev_name(lp->dev), NULL);
+	debugfs_create_file("latency", 0600, lp->debugfs_dir, lp,
+			    &axienet_lat_fops);
+}
+
+static void axienet_debugfs_exit(struct axienet_local *lp)
+{
+	debugfs_remove_recursive(lp->debugfs_dir);
+}
+#else
+static void axienet_debugfs_init(struct axienet_local *lp) { }
+static void axienet_debugfs_exit(struct axienet_local *lp) { }
+#endif
+
 /**
  * axienet_probe - Axi Ethernet probe function.
  * @pdev:	Pointer to platform device structure.
@@ -3421,16 +4649,24 @@ static int axienet_probe(struct platform_device *pdev)
 			lp->csum_offload_on_rx_path =
 				XAE_FEATURE_PARTIAL_RX_CSUM;
 			lp->features |= XAE_FEATURE_PARTIAL_RX_CSUM;
+			ndev->features |= NETIF_F_RXCSUM;
 			break;
 		case 2:
 			lp->csum_offload_on_rx_path =
 				XAE_FEATURE_FULL_RX_CSUM;
 			lp->features |= XAE_FEATURE_FULL_RX_CSUM;
+			ndev->features |= NETIF_F_RXCSUM;
 			break;
 		default:
 			lp->csum_offload_on_rx_path = XAE_NO_CSUM_OFFLOAD;
 		}
 	}
+
+	/* Large sends are segmented by the stack's GSO into skbs whose
+	 * fragments are queued on separate BDs, let ethtool toggle them.
+	 */
+	ndev->hw_features = ndev->features;
+
 	/* For supporting jumbo frames, the Axi Ethernet hardware must have
 	 * a larger Rx/Tx Memory. Typically, the size must be large so that
 	 * we can enable jumbo option and start supporting jumbo frames.
@@ -3598,6 +4834,8 @@ static int axienet_probe(struct platform_device *pdev)
 		ret = PTR_ERR(lp->tx_ts_regs);
 		goto cleanup_clk;
 	}
+	skb_queue_head_init(&lp->ptp_txq);
+	timer_setup(&lp->ptp_txts_timer, axienet_tx_hwtstamp_timer, 0);
 
 		if (lp->axienet_config->mactype == XAXIENET_10G_25G ||
 		    lp->axienet_config->mactype == XAXIENET_MRMAC) {
@@ -3764,6 +5002,8 @@ static int axienet_probe(struct platform_device *pdev)
 		goto cleanup_phylink;
 	}
 
+	axienet_debugfs_init(lp);
+
 	return 0;
 
 cleanup_phylink:
@@ -3795,6 +5035,9 @@ static int axienet_remove(struct platform_device *pdev)
 
 	for_each_rx_dma_queue(lp, i)
 		netif_napi_del(&lp->napi[i]);
+	for_each_tx_dma_queue(lp, i)
+		netif_napi_del(&lp->napi_tx[i]);
+	axienet_debugfs_exit(lp);
 	unregister_netdev(ndev);
 	axienet_clk_disable(pdev);
 
@@ -14,12 +14,15 @@
  * This file contains helper functions for AXI MCDMA TX and RX programming.
  */
 
+#include <linux/bpf_trace.h>
+#include <linux/circ_buf.h>
 #include <linux/module.h>
 #include <linux/of_mdio.h>
 #include <linux/of_platform.h>
 #include <linux/of_irq.h>
 #include <linux/of_address.h>
 #include <linux/of_net.h>
+#include <net/pkt_cls.h>
 
 #include "xilinx_axienet.h"
 
@@ -142,11 +145,19 @@ void __maybe_unused axienet_mcdma_rx_bd_free(struct net_device *ndev,
 		return;
 
 	for (i = 0; i < lp->rx_bd_num; i++) {
-		if (q->rxq_bd_v[i].phys)
-			dma_unmap_single(ndev->dev.parent, q->rxq_bd_v[i].phys,
-					 lp->max_frm_size, DMA_FROM_DEVICE);
-		dev_kfree_skb((struct sk_buff *)
-			      (q->rxq_bd_v[i].sw_id_offset));
+		struct page *page;
+
+		if (!q->rxq_bd_v[i].sw_id_offset)
+			continue;
+
+		if (q->xsk_pool) {
+			xsk_buff_free((struct xdp_buff *)
+				      q->rxq_bd_v[i].sw_id_offset);
+			continue;
+		}
+
+		page = (struct page *)q->rxq_bd_v[i].sw_id_offset;
+		page_pool_put_full_page(q->page_pool, page, false);
 	}
 
 	dma_free_coherent(ndev->dev.parent,
@@ -154,6 +165,7 @@ void __maybe_unused axienet_mcdma_rx_bd_free(struct net_device *ndev,
 			  q->rxq_bd_v,
 			  q->rx_bd_p);
 	q->rxq_bd_v = NULL;
+	axienet_rx_page_pool_destroy(q);
 }
 
 /**
@@ -240,6 +252,97 @@ int __maybe_unused axienet_mcdma_tx_q_init(struct net_device *ndev,
 	return -ENOMEM;
 }
 
+/**
+ * axienet_mcdma_xsk_rxq_init - Prepare an MCDMA Rx queue for AF_XDP
+ * @ndev:	Pointer to the net_device structure
+ * @q:		Pointer to DMA queue structure
+ *
+ * Registers the XDP Rx queue info against the XSK buffer pool instead of a
+ * page pool. The ring itself is filled by axienet_mcdma_xsk_rx_refill().
+ *
+ * Return: 0, on success. Non-zero error value on failure.
+ */
+static int axienet_mcdma_xsk_rxq_init(struct net_device *ndev,
+				      struct axienet_dma_q *q)
+{
+	struct axienet_local *lp = netdev_priv(ndev);
+	int ret, i;
+
+	for_each_rx_dma_queue(lp, i)
+		if (lp->dq[i] == q)
+			break;
+
+	ret = xdp_rxq_info_reg(&q->xdp_rxq, ndev, i, 0);
+	if (ret)
+		return ret;
+
+	ret = xdp_rxq_info_reg_mem_model(&q->xdp_rxq, MEM_TYPE_XSK_BUFF_POOL,
+					 NULL);
+	if (ret) {
+		xdp_rxq_info_unreg(&q->xdp_rxq);
+		return ret;
+	}
+
+	xsk_pool_set_rxq_info(q->xsk_pool, &q->xdp_rxq);
+	q->rx_bd_tail = 0;
+
+	return 0;
+}
+
+/**
+ * axienet_mcdma_xsk_rx_refill - Hand XSK fill queue buffers to the Rx ring
+ * @q:		Pointer to DMA queue structure
+ *
+ * Unlike the page pool mode the ring can run partially empty when user
+ * space does not keep the fill queue stocked, so one BD is always left
+ * unused to tell a full ring from an empty one. The tail pointer is moved
+ * to the last refilled BD.
+ *
+ * Return: true if the ring is full again.
+ */
+static bool axienet_mcdma_xsk_rx_refill(struct axienet_dma_q *q)
+{
+	struct axienet_local *lp = q->lp;
+	struct aximcdma_bd *cur_p;
+	struct xdp_buff *xdp;
+	dma_addr_t tail_p = 0;
+	bool full = true;
+
+	while (CIRC_SPACE(q->rx_bd_tail, q->rx_bd_ci, lp->rx_bd_num)) {
+		xdp = xsk_buff_alloc(q->xsk_pool);
+		if (!xdp) {
+			full = false;
+			break;
+		}
+
+		cur_p = &q->rxq_bd_v[q->rx_bd_tail];
+		cur_p->phys = xsk_buff_xdp_get_dma(xdp);
+		cur_p->cntrl = lp->max_frm_size;
+		cur_p->status = 0;
+		cur_p->sw_id_offset = (phys_addr_t)xdp;
+
+		tail_p = q->rx_bd_p + sizeof(*q->rxq_bd_v) * q->rx_bd_tail;
+		if (++q->rx_bd_tail >= lp->rx_bd_num)
+			q->rx_bd_tail = 0;
+	}
+
+	if (tail_p) {
+		/* Ensure BD write before handing them to the hardware */
+		wmb();
+		axienet_dma_bdout(q, XMCDMA_CHAN_TAILDESC_OFFSET(q->chan_id) +
+				  q->rx_offset, tail_p);
+	}
+
+	if (xsk_uses_need_wakeup(q->xsk_pool)) {
+		if (full)
+			xsk_clear_rx_need_wakeup(q->xsk_pool);
+		else
+			xsk_set_rx_need_wakeup(q->xsk_pool);
+	}
+
+	return full;
+}
+
 /**
  * axienet_mcdma_rx_q_init - Setup buffer descriptor rings for individual Axi
  * MCDMA-Rx
@@ -255,7 +358,7 @@ int __maybe_unused axienet_mcdma_rx_q_init(struct net_device *ndev,
 {
 	u32 cr, chan_en;
 	int i;
-	struct sk_buff *skb;
+	struct page *page;
 	struct axienet_local *lp = netdev_priv(ndev);
 	dma_addr_t mapping;
 
@@ -268,34 +371,35 @@ int __maybe_unused axienet_mcdma_rx_q_init(struct net_device *ndev,
 	if (!q->rxq_bd_v)
 		goto out;
 
-	for (i = 0; i < lp->rx_bd_num; i++) {
+	for (i = 0; i < lp->rx_bd_num; i++)
 		q->rxq_bd_v[i].next = q->rx_bd_p +
 				      sizeof(*q->rxq_bd_v) *
 				      ((i + 1) % lp->rx_bd_num);
 
-		skb = netdev_alloc_skb(ndev, lp->max_frm_size);
-		if (!skb)
+	if (q->xsk_pool) {
+		if (axienet_mcdma_xsk_rxq_init(ndev, q)) {
+			dev_err(&ndev->dev, "mcdma xsk rxq init failed\n");
 			goto out;
+		}
+		goto start;
+	}
 
-		/* Ensure that the skb is completely updated
-		 * prio to mapping the DMA
-		 */
-		wmb();
+	if (axienet_rx_page_pool_create(ndev, q)) {
+		dev_err(&ndev->dev, "mcdma page pool creation failed\n");
+		goto out;
+	}
 
-		q->rxq_bd_v[i].sw_id_offset = (phys_addr_t)skb;
-		mapping = dma_map_single(ndev->dev.parent,
-					 skb->data,
-					 lp->max_frm_size,
-					 DMA_FROM_DEVICE);
-		if (unlikely(dma_mapping_error(ndev->dev.parent, mapping))) {
-			dev_err(&ndev->dev, "mcdma map error\n");
+	for (i = 0; i < lp->rx_bd_num; i++) {
+		page = axienet_rx_alloc_page(q, &mapping);
+		if (!page)
 			goto out;
-		}
 
+		q->rxq_bd_v[i].sw_id_offset = (phys_addr_t)page;
 		q->rxq_bd_v[i].phys = mapping;
 		q->rxq_bd_v[i].cntrl = lp->max_frm_size;
 	}
 
+start:
 	/* Start updating the Rx channel control register */
 	cr = axienet_dma_in32(q, XMCDMA_CHAN_CR_OFFSET(q->chan_id) +
 			      q->rx_offset);
@@ -326,9 +430,12 @@ int __maybe_unused axienet_mcdma_rx_q_init(struct net_device *ndev,
 				q->rx_offset);
 	axienet_dma_out32(q, XMCDMA_CHAN_CR_OFFSET(q->chan_id) + q->rx_offset,
 			  cr | XMCDMA_CR_RUNSTOP_MASK);
-	axienet_dma_bdout(q, XMCDMA_CHAN_TAILDESC_OFFSET(q->chan_id) +
-			    q->rx_offset, q->rx_bd_p + (sizeof(*q->rxq_bd_v) *
-			    (lp->rx_bd_num - 1)));
+	if (q->xsk_pool)
+		axienet_mcdma_xsk_rx_refill(q);
+	else
+		axienet_dma_bdout(q, XMCDMA_CHAN_TAILDESC_OFFSET(q->chan_id) +
+				  q->rx_offset, q->rx_bd_p +
+				  (sizeof(*q->rxq_bd_v) * (lp->rx_bd_num - 1)));
 	chan_en = axienet_dma_in32(q, XMCDMA_CHEN_OFFSET + q->rx_offset);
 	chan_en |= (1 << (q->chan_id - 1));
 	axienet_dma_out32(q, XMCDMA_CHEN_OFFSET + q->rx_offset, chan_en);
@@ -401,7 +508,10 @@ irqreturn_t __maybe_unused axienet_mcdma_tx_irq(int irq, void *_ndev)
 	status = axienet_dma_in32(q, XMCDMA_CHAN_SR_OFFSET(q->chan_id));
 	if (status & (XMCDMA_IRQ_IOC_MASK | XMCDMA_IRQ_DELAY_MASK)) {
 		axienet_dma_out32(q, XMCDMA_CHAN_SR_OFFSET(q->chan_id), status);
-		axienet_start_xmit_done(lp->ndev, q);
+		cr = axienet_dma_in32(q, XMCDMA_CHAN_CR_OFFSET(q->chan_id));
+		cr &= ~(XMCDMA_IRQ_IOC_MASK | XMCDMA_IRQ_DELAY_MASK);
+		axienet_dma_out32(q, XMCDMA_CHAN_CR_OFFSET(q->chan_id), cr);
+		napi_schedule(&lp->napi_tx[i]);
 		goto out;
 	}
 	if (!(status & XMCDMA_IRQ_ALL_MASK))
@@ -474,6 +584,7 @@ irqreturn_t __maybe_unused axienet_mcdma_rx_irq(int irq, void *_ndev)
 		cr &= ~(XMCDMA_IRQ_IOC_MASK | XMCDMA_IRQ_DELAY_MASK);
 		axienet_dma_out32(q, XMCDMA_CHAN_CR_OFFSET(q->chan_id) +
 				  q->rx_offset, cr);
+		axienet_lat_rx_irq(q);
 		napi_schedule(&lp->napi[i]);
 	}
 
@@ -617,13 +728,7 @@ void __maybe_unused axienet_mcdma_err_handler(unsigned long data)
 
 	for (i = 0; i < lp->tx_bd_num; i++) {
 		cur_p = &q->txq_bd_v[i];
-		if (cur_p->phys)
-			dma_unmap_single(ndev->dev.parent, cur_p->phys,
-					 (cur_p->cntrl &
-					  XAXIDMA_BD_CTRL_LENGTH_MASK),
-					 DMA_TO_DEVICE);
-		if (cur_p->tx_skb)
-			dev_kfree_skb_irq((struct sk_buff *)cur_p->tx_skb);
+		axienet_tx_bd_free_buf(ndev, cur_p, 0);
 		cur_p->phys = 0;
 		cur_p->cntrl = 0;
 		cur_p->status = 0;
@@ -635,6 +740,8 @@ void __maybe_unused axienet_mcdma_err_handler(unsigned long data)
 		cur_p->sw_id_offset = 0;
 		cur_p->tx_skb = 0;
 	}
+	netdev_tx_reset_queue(axienet_dma_txq(q));
+	q->tx_tail_pending = false;
 
 	for (i = 0; i < lp->rx_bd_num; i++) {
 		cur_p = &q->rxq_bd_v[i];
@@ -646,6 +753,18 @@ void __maybe_unused axienet_mcdma_err_handler(unsigned long data)
 		cur_p->app4 = 0;
 	}
 
+	if (q->xsk_pool) {
+		/* Start the zero-copy ring over with fresh buffers */
+		for (i = 0; i < lp->rx_bd_num; i++) {
+			cur_p = &q->rxq_bd_v[i];
+			if (cur_p->sw_id_offset)
+				xsk_buff_free((struct xdp_buff *)
+					      cur_p->sw_id_offset);
+			cur_p->sw_id_offset = 0;
+		}
+		q->rx_bd_tail = 0;
+	}
+
 	q->tx_bd_ci = 0;
 	q->tx_bd_tail = 0;
 	q->rx_bd_ci = 0;
@@ -696,9 +815,12 @@ void __maybe_unused axienet_mcdma_err_handler(unsigned long data)
 				q->rx_offset);
 	axienet_dma_out32(q, XMCDMA_CHAN_CR_OFFSET(q->chan_id) + q->rx_offset,
 			  cr | XMCDMA_CR_RUNSTOP_MASK);
-	axienet_dma_bdout(q, XMCDMA_CHAN_TAILDESC_OFFSET(q->chan_id) +
-			    q->rx_offset, q->rx_bd_p + (sizeof(*q->rxq_bd_v) *
-			    (lp->rx_bd_num - 1)));
+	if (q->xsk_pool)
+		axienet_mcdma_xsk_rx_refill(q);
+	else
+		axienet_dma_bdout(q, XMCDMA_CHAN_TAILDESC_OFFSET(q->chan_id) +
+				  q->rx_offset, q->rx_bd_p +
+				  (sizeof(*q->rxq_bd_v) * (lp->rx_bd_num - 1)));
 	chan_en = axienet_dma_in32(q, XMCDMA_CHEN_OFFSET + q->rx_offset);
 	chan_en |= (1 << (q->chan_id - 1));
 	axienet_dma_out32(q, XMCDMA_CHEN_OFFSET + q->rx_offset, chan_en);
@@ -776,6 +898,8 @@ int __maybe_unused axienet_mcdma_tx_probe(struct platform_device *pdev,
 		q->eth_hasdre = of_property_read_bool(np,
 						      "xlnx,include-dre");
 		spin_lock_init(&q->tx_lock);
+
+		netif_napi_add_tx(lp->ndev, &lp->napi_tx[i], axienet_tx_poll);
 	}
 	of_node_put(np);
 
@@ -807,6 +931,295 @@ int __maybe_unused axienet_mcdma_rx_probe(struct platform_device *pdev,
 	return 0;
 }
 
+/**
+ * axienet_mcdma_xsk_pool_enable - Bind an AF_XDP buffer pool to a queue
+ * @ndev:	Pointer to the net_device structure
+ * @pool:	XSK buffer pool
+ * @qid:	Queue index, used for both the Rx and the Tx channel
+ *
+ * Must be called with the interface down, the rings are built from the
+ * pool on the next open.
+ *
+ * Return: 0, on success. Non-zero error value on failure.
+ */
+int axienet_mcdma_xsk_pool_enable(struct net_device *ndev,
+				  struct xsk_buff_pool *pool, u16 qid)
+{
+	struct axienet_local *lp = netdev_priv(ndev);
+	u32 frame_size;
+	int ret;
+
+	if (qid >= lp->num_rx_queues || qid >= lp->num_tx_queues)
+		return -EINVAL;
+
+	/* Every frame would need a timestamp command header in front */
+	if (IS_ENABLED(CONFIG_XILINX_AXI_EMAC_HWTSTAMP)) {
+		netdev_err(ndev, "AF_XDP zero-copy is not supported with hardware timestamping\n");
+		return -EOPNOTSUPP;
+	}
+
+	/* A frame must not be split over several BDs */
+	frame_size = max_t(u32, XAE_MAX_VLAN_FRAME_SIZE,
+			   ndev->mtu + VLAN_ETH_HLEN + XAE_TRL_SIZE);
+	if (xsk_pool_get_rx_frame_size(pool) < frame_size) {
+		netdev_err(ndev, "XSK frame size too small for MTU %d\n",
+			   ndev->mtu);
+		return -EINVAL;
+	}
+
+	ret = xsk_pool_dma_map(pool, ndev->dev.parent, 0);
+	if (ret)
+		return ret;
+
+	lp->dq[qid]->xsk_pool = pool;
+
+	return 0;
+}
+
+/**
+ * axienet_mcdma_xsk_pool_disable - Unbind the AF_XDP buffer pool of a queue
+ * @ndev:	Pointer to the net_device structure
+ * @qid:	Queue index
+ *
+ * Must be called with the interface down.
+ *
+ * Return: 0, on success. -EINVAL if no pool is bound to @qid.
+ */
+int axienet_mcdma_xsk_pool_disable(struct net_device *ndev, u16 qid)
+{
+	struct axienet_local *lp = netdev_priv(ndev);
+	struct axienet_dma_q *q;
+
+	if (qid >= lp->num_rx_queues)
+		return -EINVAL;
+
+	q = lp->dq[qid];
+	if (!q->xsk_pool)
+		return -EINVAL;
+
+	xsk_pool_dma_unmap(q->xsk_pool, 0);
+	q->xsk_pool = NULL;
+
+	return 0;
+}
+
+/**
+ * axienet_mcdma_xsk_recv - Process received frames of an AF_XDP queue
+ * @napi:	Rx NAPI of the queue
+ * @budget:	NAPI budget
+ * @q:		Pointer to DMA queue structure
+ *
+ * Frames stay in the UMEM when the XDP program redirects them to the
+ * socket. Frames passed to the stack are copied into an skb so that the
+ * UMEM buffer can be recycled right away.
+ *
+ * Return: Number of BD's processed.
+ */
+int axienet_mcdma_xsk_recv(struct napi_struct *napi, int budget,
+			   struct axienet_dma_q *q)
+{
+	struct net_device *ndev = napi->dev;
+	struct axienet_local *lp = netdev_priv(ndev);
+	struct bpf_prog *xdp_prog = READ_ONCE(lp->xdp_prog);
+	struct aximcdma_bd *cur_p;
+	struct xdp_frame *xdpf;
+	struct xdp_buff *xdp;
+	struct sk_buff *skb;
+	bool redirect = false;
+	u32 length, act;
+	u32 packets = 0;
+	u32 size = 0;
+	int count = 0;
+
+	while (count < budget && q->rx_bd_ci != q->rx_bd_tail) {
+		cur_p = &q->rxq_bd_v[q->rx_bd_ci];
+		if (!(cur_p->status & XAXIDMA_BD_STS_COMPLETE_MASK))
+			break;
+
+		/* Read the rest of the BD only after its status */
+		rmb();
+		xdp = (struct xdp_buff *)cur_p->sw_id_offset;
+		if (lp->eth_hasnobuf ||
+		    lp->axienet_config->mactype != XAXIENET_1G)
+			length = cur_p->status & XAXIDMA_BD_STS_ACTUAL_LEN_MASK;
+		else
+			length = cur_p->app4 & 0x0000FFFF;
+
+		cur_p->sw_id_offset = 0;
+		cur_p->status = 0;
+		if (++q->rx_bd_ci >= lp->rx_bd_num)
+			q->rx_bd_ci = 0;
+		count++;
+
+		size += length;
+		packets++;
+
+		xsk_buff_set_size(xdp, length);
+		xsk_buff_dma_sync_for_cpu(xdp, q->xsk_pool);
+
+		act = xdp_prog ? bpf_prog_run_xdp(xdp_prog, xdp) : XDP_PASS;
+		switch (act) {
+		case XDP_REDIRECT:
+			if (likely(!xdp_do_redirect(ndev, xdp, xdp_prog))) {
+				redirect = true;
+				continue;
+			}
+			trace_xdp_exception(ndev, xdp_prog, act);
+			break;
+		case XDP_PASS:
+			length = xdp->data_end - xdp->data;
+			skb = napi_alloc_skb(napi, length);
+			if (likely(skb)) {
+				skb_put_data(skb, xdp->data, length);
+				skb->protocol = eth_type_trans(skb, ndev);
+				skb_record_rx_queue(skb,
+						    q->xdp_rxq.queue_index);
+				axienet_lat_rx_frame(q);
+				napi_gro_receive(napi, skb);
+			} else {
+				ndev->stats.rx_dropped++;
+			}
+			break;
+		case XDP_TX:
+			/* Copies the frame out and frees the XSK buffer */
+			xdpf = xdp_convert_buff_to_frame(xdp);
+			if (likely(xdpf)) {
+				if (axienet_xdp_xmit_frame(lp, q, xdpf, true))
+					xdp_return_frame(xdpf);
+				continue;
+			}
+			trace_xdp_exception(ndev, xdp_prog, act);
+			break;
+		default:
+			bpf_warn_invalid_xdp_action(ndev, xdp_prog, act);
+			fallthrough;
+		case XDP_ABORTED:
+			trace_xdp_exception(ndev, xdp_prog, act);
+			fallthrough;
+		case XDP_DROP:
+			break;
+		}
+
+		xsk_buff_free(xdp);
+	}
+
+	if (redirect)
+		xdp_do_flush();
+
+	ndev->stats.rx_packets += packets;
+	ndev->stats.rx_bytes += size;
+	q->rx_packets += packets;
+	q->rx_bytes += size;
+
+	axienet_mcdma_xsk_rx_refill(q);
+
+	return count;
+}
+
+/**
+ * axienet_mcdma_xsk_xmit - Queue frames from the AF_XDP Tx ring
+ * @q:		Pointer to DMA queue structure
+ * @budget:	Max number of frames to queue
+ *
+ * The UMEM buffers are handed to the MCDMA channel as they are, their
+ * completion is reported back by axienet_start_xmit_done().
+ *
+ * Return: true if the Tx ring was drained or the BD ring is full, false if
+ * @budget ran out first.
+ */
+bool axienet_mcdma_xsk_xmit(struct axienet_dma_q *q, int budget)
+{
+	struct xsk_buff_pool *pool = q->xsk_pool;
+	struct axienet_local *lp = q->lp;
+	struct aximcdma_bd *cur_p;
+	struct xdp_desc desc;
+	dma_addr_t tail_p = 0;
+	unsigned long flags;
+	dma_addr_t dma;
+	int sent = 0;
+	u32 len;
+
+	spin_lock_irqsave(&q->tx_lock, flags);
+	while (sent < budget) {
+		if (!CIRC_SPACE(q->tx_bd_tail, q->tx_bd_ci, lp->tx_bd_num))
+			break;
+
+		cur_p = &q->txq_bd_v[q->tx_bd_tail];
+		if (cur_p->sband_stats & XMCDMA_BD_STS_ALL_MASK)
+			break;
+
+		if (!xsk_tx_peek_desc(pool, &desc))
+			break;
+
+		dma = xsk_buff_raw_get_dma(pool, desc.addr);
+		len = desc.len;
+		/* The XXV MAC does not pad short frames. Pad them with the
+		 * bytes that follow in the UMEM chunk instead of copying.
+		 */
+		if ((lp->axienet_config->mactype == XAXIENET_10G_25G ||
+		     lp->axienet_config->mactype == XAXIENET_MRMAC) &&
+		    len < ETH_ZLEN)
+			len = ETH_ZLEN;
+		xsk_buff_raw_dma_sync_for_device(pool, dma, len);
+
+		cur_p->phys = dma;
+		cur_p->cntrl = len | XMCDMA_BD_CTRL_TXSOF_MASK |
+			       XMCDMA_BD_CTRL_TXEOF_MASK;
+		cur_p->tx_desc_mapping = DESC_DMA_MAP_XSK;
+		cur_p->tx_skb = 0;
+
+		tail_p = q->tx_bd_p + sizeof(*q->txq_bd_v) * q->tx_bd_tail;
+		if (++q->tx_bd_tail >= lp->tx_bd_num)
+			q->tx_bd_tail = 0;
+		sent++;
+	}
+
+	if (tail_p) {
+		/* Ensure BD write before starting transfer */
+		wmb();
+		axienet_dma_bdout(q, XMCDMA_CHAN_TAILDESC_OFFSET(q->chan_id),
+				  tail_p);
+		q->tx_tail_pending = false;
+		xsk_tx_release(pool);
+	}
+	spin_unlock_irqrestore(&q->tx_lock, flags);
+
+	return sent < budget;
+}
+
+static void axienet_mcdma_xsk_kick(struct napi_struct *napi)
+{
+	if (!napi_if_scheduled_mark_missed(napi))
+		napi_schedule(napi);
+}
+
+/**
+ * axienet_mcdma_xsk_wakeup - ndo_xsk_wakeup handler
+ * @ndev:	Pointer to the net_device structure
+ * @qid:	Queue index
+ * @flags:	XDP_WAKEUP_RX and/or XDP_WAKEUP_TX
+ *
+ * Return: 0, on success. Non-zero error value on failure.
+ */
+int axienet_mcdma_xsk_wakeup(struct net_device *ndev, u32 qid, u32 flags)
+{
+	struct axienet_local *lp = netdev_priv(ndev);
+
+	if (!netif_running(ndev))
+		return -ENETDOWN;
+
+	if (qid >= lp->num_rx_queues || qid >= lp->num_tx_queues ||
+	    !lp->dq[qid]->xsk_pool)
+		return -EINVAL;
+
+	if (flags & XDP_WAKEUP_RX)
+		axienet_mcdma_xsk_kick(&lp->napi[qid]);
+	if (flags & XDP_WAKEUP_TX)
+		axienet_mcdma_xsk_kick(&lp->napi_tx[qid]);
+
+	return 0;
+}
+
 static ssize_t rxch_obs1_show(struct device *dev,
 			      struct device_attribute *attr, char *buf)
 {
@@ -975,6 +1388,104 @@ static ssize_t txch_obs6_show(struct device *dev,
 		       reg);
 }
 
+/* Set the 4-bit WRR weight of Tx channel @idx, counting from 0 */
+static void axienet_mcdma_set_tx_weight(struct axienet_dma_q *q, u16 idx,
+					u16 weight)
+{
+	u32 offset = idx < 8 ? XMCDMA_TXWEIGHT0_OFFSET : XMCDMA_TXWEIGHT1_OFFSET;
+	u32 val;
+
+	idx %= 8;
+	val = axienet_dma_in32(q, offset);
+	val &= ~XMCDMA_TXWEIGHT_CH_MASK(idx);
+	val |= (weight & 0x0F) << XMCDMA_TXWEIGHT_CH_SHIFT(idx);
+	axienet_dma_out32(q, offset, val);
+}
+
+/**
+ * axienet_mcdma_setup_mqprio - Offload an mqprio qdisc to the MCDMA
+ * @ndev:	Pointer to the net_device structure
+ * @mqprio:	mqprio offload request, num_tc of 0 removes the offload
+ *
+ * Traffic classes map to Tx queues, that is Tx channels, through the stack's
+ * usual priority to queue selection. In channel mode with a bandwidth
+ * shaper, the min_rate of each class sets the weight its channels get from
+ * the MM2S round robin arbiter, scaled so the largest rate gets the top
+ * weight. Without a shaper all channels get the same weight.
+ *
+ * Return: 0 on success, negative errno otherwise.
+ */
+int axienet_mcdma_setup_mqprio(struct net_device *ndev,
+			       struct tc_mqprio_qopt_offload *mqprio)
+{
+	struct axienet_local *lp = netdev_priv(ndev);
+	struct tc_mqprio_qopt *qopt = &mqprio->qopt;
+	struct axienet_dma_q *q = lp->dq[0];
+	bool rates = false;
+	u64 max_rate = 0;
+	int tc, i;
+
+	if (!qopt->num_tc) {
+		netdev_reset_tc(ndev);
+		if (lp->tx_weight_offload) {
+			axienet_dma_out32(q, XMCDMA_TXWEIGHT0_OFFSET,
+					  lp->tx_weight_saved[0]);
+			axienet_dma_out32(q, XMCDMA_TXWEIGHT1_OFFSET,
+					  lp->tx_weight_saved[1]);
+			lp->tx_weight_offload = false;
+		}
+		return 0;
+	}
+
+	if (mqprio->mode == TC_MQPRIO_MODE_CHANNEL &&
+	    mqprio->shaper == TC_MQPRIO_SHAPER_BW_RATE) {
+		for (tc = 0; tc < qopt->num_tc; tc++) {
+			if (mqprio->max_rate[tc])
+				return -EOPNOTSUPP;
+			max_rate = max(max_rate, mqprio->min_rate[tc]);
+		}
+		rates = max_rate != 0;
+	} else if (mqprio->mode != TC_MQPRIO_MODE_DCB &&
+		   mqprio->mode != TC_MQPRIO_MODE_CHANNEL) {
+		return -EOPNOTSUPP;
+	}
+
+	if (netdev_set_num_tc(ndev, qopt->num_tc))
+		return -EINVAL;
+
+	for (tc = 0; tc < qopt->num_tc; tc++)
+		netdev_set_tc_queue(ndev, tc, qopt->count[tc], qopt->offset[tc]);
+	for (i = 0; i <= TC_BITMASK; i++)
+		netdev_set_prio_tc_map(ndev, i, qopt->prio_tc_map[i]);
+
+	if (!lp->tx_weight_offload) {
+		lp->tx_weight_saved[0] =
+			axienet_dma_in32(q, XMCDMA_TXWEIGHT0_OFFSET);
+		lp->tx_weight_saved[1] =
+			axienet_dma_in32(q, XMCDMA_TXWEIGHT1_OFFSET);
+		lp->tx_weight_offload = true;
+	}
+
+	for (tc = 0; tc < qopt->num_tc; tc++) {
+		u64 weight = 0x0F;
+
+		if (rates) {
+			weight = DIV64_U64_ROUND_CLOSEST(mqprio->min_rate[tc] *
+							 0x0F, max_rate);
+			weight = clamp_t(u64, weight, 1, 0x0F);
+		}
+
+		for (i = qopt->offset[tc];
+		     i < qopt->offset[tc] + qopt->count[tc]; i++)
+			axienet_mcdma_set_tx_weight(q, lp->dq[i]->chan_id - 1,
+						    weight);
+	}
+
+	qopt->hw = TC_MQPRIO_HW_OFFLOAD_TCS;
+
+	return 0;
+}
+
 static ssize_t chan_weight_show(struct device *dev,
 				struct device_attribute *attr, char *buf)
 {
@@ -993,8 +1504,7 @@ static ssize_t chan_weight_store(struct device *dev,
 	struct axienet_local *lp = netdev_priv(ndev);
 	struct axienet_dma_q *q = lp->dq[0];
 	int ret;
-	u16 flags, chan_id;
-	u32 val;
+	u16 flags;
 
 	ret = kstrtou16(buf, 16, &flags);
 	if (ret)
@@ -1003,23 +1513,7 @@ static ssize_t chan_weight_store(struct device *dev,
 	lp->chan_id = (flags & 0xF0) >> 4;
 	lp->weight = flags & 0x0F;
 
-	if (lp->chan_id < 8)
-		val = axienet_dma_in32(q, XMCDMA_TXWEIGHT0_OFFSET);
-	else
-		val = axienet_dma_in32(q, XMCDMA_TXWEIGHT1_OFFSET);
-
-	if (lp->chan_id > 7)
-		chan_id = lp->chan_id - 8;
-	else
-		chan_id = lp->chan_id;
-
-	val &= ~XMCDMA_TXWEIGHT_CH_MASK(chan_id);
-	val |= lp->weight << XMCDMA_TXWEIGHT_CH_SHIFT(chan_id);
-
-	if (lp->chan_id < 8)
-		axienet_dma_out32(q, XMCDMA_TXWEIGHT0_OFFSET, val);
-	else
-		axienet_dma_out32(q, XMCDMA_TXWEIGHT1_OFFSET, val);
+	axienet_mcdma_set_tx_weight(q, lp->chan_id, lp->weight);
 
 	return count;
 }
@@ -103,12 +103,15 @@
 /**
  * struct net_local - Our private per device data
  * @ndev:		instance of the network device
+ * @napi:		NAPI context for Rx
+ * @rx_oom_timer:	polls again after an Rx skb allocation failed
  * @tx_ping_pong:	indicates whether Tx Pong buffer is configured in HW
  * @rx_ping_pong:	indicates whether Rx Pong buffer is configured in HW
  * @next_tx_buf_to_use:	next Tx buffer to write to
  * @next_rx_buf_to_use:	next Rx buffer to read from
  * @base_addr:		base address of the Emaclite device
- * @reset_lock:		lock to serialize xmit and tx_timeout execution
+ * @reset_lock:		lock to serialize xmit, Tx completion and tx_timeout
+ *			execution
  * @deferred_skb:	holds an skb (for transmission at a later time) when the
  *			Tx buffer is not free
  * @phy_dev:		pointer to the PHY device
@@ -118,6 +121,8 @@
  */
 struct net_local {
 	struct net_device *ndev;
+	struct napi_struct napi;
+	struct timer_list rx_oom_timer;
 
 	bool tx_ping_pong;
 	bool rx_ping_pong;
@@ -125,7 +130,7 @@ struct net_local {
 	u32 next_rx_buf_to_use;
 	void __iomem *base_addr;
 
-	spinlock_t reset_lock; /* serialize xmit and tx_timeout execution */
+	spinlock_t reset_lock; /* serialize xmit, Tx completion and tx_timeout */
 	struct sk_buff *deferred_skb;
 
 	struct phy_device *phy_dev;
@@ -188,6 +193,63 @@ static void xemaclite_disable_interrupts(struct net_local *drvdata)
 			 drvdata->base_addr + XEL_RSR_OFFSET);
 }
 
+/**
+ * xemaclite_rx_irq_enable - Enable or disable the Rx interrupt
+ * @drvdata:	Pointer to the Emaclite device private data
+ * @enable:	Whether the Rx interrupt is to be enabled
+ *
+ * The Rx interrupt is masked while NAPI polls the receive buffers. Only the
+ * IE bit is written, a read-modify-write could write back a RECV_DONE bit
+ * changed in between.
+ */
+static void xemaclite_rx_irq_enable(struct net_local *drvdata, bool enable)
+{
+	xemaclite_writel(enable ? XEL_RSR_RECV_IE_MASK : 0,
+			 drvdata->base_addr + XEL_RSR_OFFSET);
+}
+
+/**
+ * xemaclite_rx_pending - Check whether a received frame is waiting
+ * @drvdata:	Pointer to the Emaclite device private data
+ *
+ * Return:	true if the ping or the pong Rx buffer holds a frame
+ */
+static bool xemaclite_rx_pending(struct net_local *drvdata)
+{
+	void __iomem *base_addr = drvdata->base_addr;
+
+	if (xemaclite_readl(base_addr + XEL_RSR_OFFSET) &
+	    XEL_RSR_RECV_DONE_MASK)
+		return true;
+
+	return drvdata->rx_ping_pong &&
+	       (xemaclite_readl(base_addr + XEL_BUFFER_OFFSET + XEL_RSR_OFFSET) &
+		XEL_RSR_RECV_DONE_MASK);
+}
+
+/**
+ * xemaclite_tx_buf_free - Check whether a Tx buffer can take a frame
+ * @drvdata:	Pointer to the Emaclite device private data
+ *
+ * Return:	true if the ping or, when configured, the pong Tx buffer is
+ *		free
+ */
+static bool xemaclite_tx_buf_free(struct net_local *drvdata)
+{
+	void __iomem *addr = drvdata->base_addr + drvdata->next_tx_buf_to_use;
+	u32 busy = XEL_TSR_XMIT_BUSY_MASK | XEL_TSR_XMIT_ACTIVE_MASK;
+
+	if (!(xemaclite_readl(addr + XEL_TSR_OFFSET) & busy))
+		return true;
+
+	if (!drvdata->tx_ping_pong)
+		return false;
+
+	addr = (void __iomem __force *)((uintptr_t __force)addr ^
+					 XEL_BUFFER_OFFSET);
+	return !(xemaclite_readl(addr + XEL_TSR_OFFSET) & busy);
+}
+
 /**
  * xemaclite_aligned_write - Write from 16-bit aligned to 32-bit aligned address
  * @src_ptr:	Void pointer to the 16-bit aligned source address
@@ -285,7 +347,7 @@ static void xemaclite_aligned_read(u32 *src_ptr, u8 *dest_ptr,
 
 		/* Read the remaining data */
 		for (; length > 0; length--)
-			*to_u8_ptr = *from_u8_ptr;
+			*to_u8_ptr++ = *from_u8_ptr++;
 	}
 }
 
@@ -556,18 +618,23 @@ static void xemaclite_tx_timeout(struct net_device *dev, unsigned int txqueue)
 /**
  * xemaclite_tx_handler - Interrupt handler for frames sent
  * @dev:	Pointer to the network device
+ * @sent:	Number of Tx buffers found completed
  *
  * This function updates the number of packets transmitted and handles the
- * deferred skb, if there is one.
+ * deferred skb, if there is one. Otherwise the queue stopped because both
+ * Tx buffers were busy is woken up, a buffer is free again. It is called
+ * with the reset_lock held.
  */
-static void xemaclite_tx_handler(struct net_device *dev)
+static void xemaclite_tx_handler(struct net_device *dev, unsigned int sent)
 {
 	struct net_local *lp = netdev_priv(dev);
 
-	dev->stats.tx_packets++;
+	dev->stats.tx_packets += sent;
 
-	if (!lp->deferred_skb)
+	if (!lp->deferred_skb) {
+		netif_wake_queue(dev);
 		return;
+	}
 
 	if (xemaclite_send_data(lp, (u8 *)lp->deferred_skb->data,
 				lp->deferred_skb->len))
@@ -581,35 +648,31 @@ static void xemaclite_tx_handler(struct net_device *dev)
 }
 
 /**
- * xemaclite_rx_handler- Interrupt handler for frames received
+ * xemaclite_rx_handler- Receive a frame from the NAPI poll
  * @dev:	Pointer to the network device
  *
  * This function allocates memory for a socket buffer, fills it with data
  * received and hands it over to the TCP/IP stack.
+ *
+ * Return:	1 if a frame was taken out of an Rx buffer, 0 if none was
+ *		received, -ENOMEM if the frame was left in its buffer
  */
-static void xemaclite_rx_handler(struct net_device *dev)
+static int xemaclite_rx_handler(struct net_device *dev)
 {
 	struct net_local *lp = netdev_priv(dev);
 	struct sk_buff *skb;
 	u32 len;
 
 	len = ETH_FRAME_LEN + ETH_FCS_LEN;
-	skb = netdev_alloc_skb(dev, len + NET_IP_ALIGN);
-	if (!skb) {
-		/* Couldn't get memory. */
-		dev->stats.rx_dropped++;
-		dev_err(&lp->ndev->dev, "Could not allocate receive buffer\n");
-		return;
-	}
-
-	skb_reserve(skb, NET_IP_ALIGN);
+	skb = napi_alloc_skb(&lp->napi, len);
+	if (!skb)
+		return -ENOMEM;
 
 	len = xemaclite_recv_data(lp, (u8 *)skb->data, len);
 
 	if (!len) {
-		dev->stats.rx_errors++;
-		dev_kfree_skb_irq(skb);
-		return;
+		napi_consume_skb(skb, 1);
+		return 0;
 	}
 
 	skb_put(skb, len);	/* Tell the skb how much data we got */
@@ -621,7 +684,65 @@ static void xemaclite_rx_handler(struct net_device *dev)
 	dev->stats.rx_bytes += len;
 
 	if (!skb_defer_rx_timestamp(skb))
-		netif_rx(skb);	/* Send the packet upstream */
+		napi_gro_receive(&lp->napi, skb); /* Send the packet upstream */
+
+	return 1;
+}
+
+/**
+ * xemaclite_rx_poll - NAPI poll routine for received frames
+ * @napi:	Pointer to the NAPI context
+ * @budget:	Maximum number of frames to receive
+ *
+ * Empties the ping and pong Rx buffers alternately, the Rx interrupt stays
+ * masked until both are empty. Without memory for an skb the frame is left
+ * in its buffer and the poll is retried a jiffy later.
+ *
+ * Return:	Number of frames received
+ */
+static int xemaclite_rx_poll(struct napi_struct *napi, int budget)
+{
+	struct net_local *lp = container_of(napi, struct net_local, napi);
+	int work_done = 0;
+	int ret = 0;
+
+	while (work_done < budget) {
+		ret = xemaclite_rx_handler(lp->ndev);
+		if (ret <= 0)
+			break;
+		work_done++;
+	}
+
+	if (ret == -ENOMEM) {
+		if (napi_complete_done(napi, work_done))
+			mod_timer(&lp->rx_oom_timer, jiffies + 1);
+		return work_done;
+	}
+
+	if (work_done < budget && napi_complete_done(napi, work_done)) {
+		xemaclite_rx_irq_enable(lp, true);
+
+		/* A frame completed before the interrupt was unmasked does
+		 * not raise it anymore
+		 */
+		if (xemaclite_rx_pending(lp) && napi_schedule_prep(napi)) {
+			xemaclite_rx_irq_enable(lp, false);
+			__napi_schedule(napi);
+		}
+	}
+
+	return work_done;
+}
+
+/**
+ * xemaclite_rx_oom_timer - Poll again after an Rx skb allocation failed
+ * @t:		Pointer to the Rx retry timer
+ */
+static void xemaclite_rx_oom_timer(struct timer_list *t)
+{
+	struct net_local *lp = from_timer(lp, t, rx_oom_timer);
+
+	napi_schedule(&lp->napi);
 }
 
 /**
@@ -636,19 +757,19 @@ static void xemaclite_rx_handler(struct net_device *dev)
  */
 static irqreturn_t xemaclite_interrupt(int irq, void *dev_id)
 {
-	bool tx_complete = false;
+	unsigned int tx_complete = 0;
 	struct net_device *dev = dev_id;
 	struct net_local *lp = netdev_priv(dev);
 	void __iomem *base_addr = lp->base_addr;
 	u32 tx_status;
 
-	/* Check if there is Rx Data available */
-	if ((xemaclite_readl(base_addr + XEL_RSR_OFFSET) &
-			 XEL_RSR_RECV_DONE_MASK) ||
-	    (xemaclite_readl(base_addr + XEL_BUFFER_OFFSET + XEL_RSR_OFFSET)
-			 & XEL_RSR_RECV_DONE_MASK))
+	/* Check if there is Rx Data available, NAPI takes it from here */
+	if (xemaclite_rx_pending(lp) && napi_schedule_prep(&lp->napi)) {
+		xemaclite_rx_irq_enable(lp, false);
+		__napi_schedule(&lp->napi);
+	}
 
-		xemaclite_rx_handler(dev);
+	spin_lock(&lp->reset_lock);
 
 	/* Check if the Transmission for the first buffer is completed */
 	tx_status = xemaclite_readl(base_addr + XEL_TSR_OFFSET);
@@ -657,7 +778,7 @@ static irqreturn_t xemaclite_interrupt(int irq, void *dev_id)
 		tx_status &= ~XEL_TSR_XMIT_ACTIVE_MASK;
 		xemaclite_writel(tx_status, base_addr + XEL_TSR_OFFSET);
 
-		tx_complete = true;
+		tx_complete++;
 	}
 
 	/* Check if the Transmission for the second buffer is completed */
@@ -668,12 +789,14 @@ static irqreturn_t xemaclite_interrupt(int irq, void *dev_id)
 		xemaclite_writel(tx_status, base_addr + XEL_BUFFER_OFFSET +
 				 XEL_TSR_OFFSET);
 
-		tx_complete = true;
+		tx_complete++;
 	}
 
 	/* If there was a Tx interrupt, call the Tx Handler */
-	if (tx_complete != 0)
-		xemaclite_tx_handler(dev);
+	if (tx_complete)
+		xemaclite_tx_handler(dev, tx_complete);
+
+	spin_unlock(&lp->reset_lock);
 
 	return IRQ_HANDLED;
 }
@@ -944,6 +1067,8 @@ static int xemaclite_open(struct net_device *dev)
 		return retval;
 	}
 
+	napi_enable(&lp->napi);
+
 	/* Enable Interrupts */
 	xemaclite_enable_interrupts(lp);
 
@@ -968,6 +1093,8 @@ static int xemaclite_close(struct net_device *dev)
 	struct net_local *lp = netdev_priv(dev);
 
 	netif_stop_queue(dev);
+	napi_disable(&lp->napi);
+	del_timer_sync(&lp->rx_oom_timer);
 	xemaclite_disable_interrupts(lp);
 	free_irq(dev->irq, dev);
 
@@ -986,9 +1113,11 @@ static int xemaclite_close(struct net_device *dev)
  * This function checks if the Tx buffer of the Emaclite device is free to send
  * data. If so, it fills the Tx buffer with data from socket buffer data,
  * updates the stats and frees the socket buffer. The Tx completion is signaled
- * by an interrupt. If the Tx buffer isn't free, then the socket buffer is
- * deferred and the Tx queue is stopped so that the deferred socket buffer can
- * be transmitted when the Emaclite device is free to transmit data.
+ * by an interrupt. With the ping and pong buffers one frame is sent while the
+ * next one is written, the Tx queue is stopped once both buffers are in use.
+ * If the Tx buffer isn't free anyway, then the socket buffer is deferred and
+ * the Tx queue is stopped so that the deferred socket buffer can be
+ * transmitted when the Emaclite device is free to transmit data.
  *
  * Return:	NETDEV_TX_OK, always.
  */
@@ -1017,6 +1146,10 @@ xemaclite_send(struct sk_buff *orig_skb, struct net_device *dev)
 		spin_unlock_irqrestore(&lp->reset_lock, flags);
 		return NETDEV_TX_OK;
 	}
+
+	/* Woken up by the Tx completion of either buffer */
+	if (!xemaclite_tx_buf_free(lp))
+		netif_stop_queue(dev);
 	spin_unlock_irqrestore(&lp->reset_lock, flags);
 
 	skb_tx_timestamp(new_skb);
@@ -1152,6 +1285,8 @@ static int xemaclite_of_probe(struct platform_device *ofdev)
 	ndev->ethtool_ops = &xemaclite_ethtool_ops;
 	ndev->flags &= ~IFF_MULTICAST;
 	ndev->watchdog_timeo = TX_TIMEOUT;
+	netif_napi_add(ndev, &lp->napi, xemaclite_rx_poll);
+	timer_setup(&lp->rx_oom_timer, xemaclite_rx_oom_timer, 0);
 
 	/* Finally, register the device */
 	rc = register_netdev(ndev);
@@ -392,6 +392,7 @@ void nvme_complete_rq(struct request *req)
 	struct nvme_ctrl *ctrl = nvme_req(req)->ctrl;
 
 	trace_nvme_complete_rq(req);
+	nvme_mpath_end_request(req);
 	nvme_cleanup_cmd(req);
 
 	if (ctrl->kas)
@@ -422,6 +423,7 @@ EXPORT_SYMBOL_GPL(nvme_complete_rq);
 void nvme_complete_batch_req(struct request *req)
 {
 	trace_nvme_complete_rq(req);
+	nvme_mpath_end_request(req);
 	nvme_cleanup_cmd(req);
 	nvme_end_req_zoned(req);
 }
@@ -927,6 +929,8 @@ static inline blk_status_t nvme_setup_rw(struct nvme_ns *ns,
 
 void nvme_cleanup_cmd(struct request *req)
 {
+	nvme_mpath_put_request(req);
+
 	if (req->rq_flags & RQF_SPECIAL_PAYLOAD) {
 		struct nvme_ctrl *ctrl = nvme_req(req)->ctrl;
 
@@ -989,6 +993,8 @@ blk_status_t nvme_setup_cmd(struct nvme_ns *ns, struct request *req)
 
 	cmd->common.command_id = nvme_cid(req);
 	trace_nvme_setup_cmd(req, cmd);
+	if (!ret && (req->cmd_flags & REQ_NVME_MPATH))
+		nvme_mpath_start_request(req);
 	return ret;
 }
 EXPORT_SYMBOL_GPL(nvme_setup_cmd);
@@ -3450,6 +3456,8 @@ static struct attribute *nvme_ns_id_attrs[] = {
 #ifdef CONFIG_NVME_MULTIPATH
 	&dev_attr_ana_grpid.attr,
 	&dev_attr_ana_state.attr,
+	&dev_attr_queue_depth.attr,
+	&dev_attr_io_latency_us.attr,
 #endif
 	NULL,
 };
@@ -3480,6 +3488,11 @@ static umode_t nvme_ns_id_attrs_are_visible(struct kobject *kobj,
 		if (!nvme_ctrl_use_ana(nvme_get_ns_from_dev(dev)->ctrl))
 			return 0;
 	}
+	if (a == &dev_attr_queue_depth.attr ||
+	    a == &dev_attr_io_latency_us.attr) {
+		if (dev_to_disk(dev)->fops != &nvme_bdev_ops) /* per-path attr */
+			return 0;
+	}
 #endif
 	return a->mode;
 }
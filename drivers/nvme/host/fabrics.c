@@ -594,6 +594,7 @@ static const match_table_t opt_tokens = {
 	{ NVMF_OPT_DISCOVERY,		"discovery"		},
 	{ NVMF_OPT_DHCHAP_SECRET,	"dhchap_secret=%s"	},
 	{ NVMF_OPT_DHCHAP_CTRL_SECRET,	"dhchap_ctrl_secret=%s"	},
+	{ NVMF_OPT_IO_CPUS,		"io_cpus=%s"		},
 	{ NVMF_OPT_ERR,			NULL			}
 };
 
@@ -805,6 +806,30 @@ static int nvmf_parse_options(struct nvmf_ctrl_options *opts,
 			kfree(opts->host_iface);
 			opts->host_iface = p;
 			break;
+		case NVMF_OPT_IO_CPUS:
+			p = match_strdup(args);
+			if (!p) {
+				ret = -ENOMEM;
+				goto out;
+			}
+			if (!opts->io_cpus)
+				opts->io_cpus = kzalloc(cpumask_size(),
+							GFP_KERNEL);
+			if (!opts->io_cpus) {
+				kfree(p);
+				ret = -ENOMEM;
+				goto out;
+			}
+			if (cpulist_parse(p, opts->io_cpus) ||
+			    !cpumask_intersects(opts->io_cpus,
+						cpu_online_mask)) {
+				pr_err("Invalid io_cpus %s\n", p);
+				kfree(p);
+				ret = -EINVAL;
+				goto out;
+			}
+			kfree(p);
+			break;
 		case NVMF_OPT_HOST_ID:
 			p = match_strdup(args);
 			if (!p) {
@@ -1036,6 +1061,7 @@ void nvmf_free_options(struct nvmf_ctrl_options *opts)
 	kfree(opts->host_iface);
 	kfree(opts->dhchap_secret);
 	kfree(opts->dhchap_ctrl_secret);
+	kfree(opts->io_cpus);
 	kfree(opts);
 }
 EXPORT_SYMBOL_GPL(nvmf_free_options);
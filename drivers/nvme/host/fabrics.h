@@ -70,6 +70,7 @@ enum {
 	NVMF_OPT_DISCOVERY	= 1 << 22,
 	NVMF_OPT_DHCHAP_SECRET	= 1 << 23,
 	NVMF_OPT_DHCHAP_CTRL_SECRET = 1 << 24,
+	NVMF_OPT_IO_CPUS	= 1 << 25,
 };
 
 /**
@@ -109,6 +110,7 @@ enum {
  * @nr_poll_queues: number of queues for polling I/O
  * @tos: type of service
  * @fast_io_fail_tmo: Fast I/O fail timeout in seconds
+ * @io_cpus: CPUs the transport may process I/O on, NULL for all (TCP)
  */
 struct nvmf_ctrl_options {
 	unsigned		mask;
@@ -135,6 +137,7 @@ struct nvmf_ctrl_options {
 	unsigned int		nr_poll_queues;
 	int			tos;
 	int			fast_io_fail_tmo;
+	struct cpumask		*io_cpus;
 };
 
 /*
@@ -17,6 +17,8 @@ MODULE_PARM_DESC(multipath,
 static const char *nvme_iopolicy_names[] = {
 	[NVME_IOPOLICY_NUMA]	= "numa",
 	[NVME_IOPOLICY_RR]	= "round-robin",
+	[NVME_IOPOLICY_QD]	= "queue-depth",
+	[NVME_IOPOLICY_LAT]	= "latency",
 };
 
 static int iopolicy = NVME_IOPOLICY_NUMA;
@@ -29,6 +31,10 @@ static int nvme_set_iopolicy(const char *val, const struct kernel_param *kp)
 		iopolicy = NVME_IOPOLICY_NUMA;
 	else if (!strncmp(val, "round-robin", 11))
 		iopolicy = NVME_IOPOLICY_RR;
+	else if (!strncmp(val, "queue-depth", 11))
+		iopolicy = NVME_IOPOLICY_QD;
+	else if (!strncmp(val, "latency", 7))
+		iopolicy = NVME_IOPOLICY_LAT;
 	else
 		return -EINVAL;
 
@@ -43,7 +49,7 @@ static int nvme_get_iopolicy(char *buf, const struct kernel_param *kp)
 module_param_call(iopolicy, nvme_set_iopolicy, nvme_get_iopolicy,
 	&iopolicy, 0644);
 MODULE_PARM_DESC(iopolicy,
-	"Default multipath I/O policy; 'numa' (default) or 'round-robin'");
+	"Default multipath I/O policy; 'numa' (default), 'round-robin', 'queue-depth' or 'latency'");
 
 void nvme_mpath_default_iopolicy(struct nvme_subsystem *subsys)
 {
@@ -296,6 +302,111 @@ static struct nvme_ns *nvme_round_robin_path(struct nvme_ns_head *head,
 	return found;
 }
 
+/*
+ * The latency estimate of a path is an EWMA of the completion latency with a
+ * weight of 1/8 for new samples. A path that had no completion for a second
+ * is treated as idle so that it is probed again, otherwise a path that was
+ * once congested would never get the I/O that refreshes its estimate.
+ */
+#define NVME_MPATH_LAT_EWMA_SHIFT	3
+#define NVME_MPATH_LAT_STALE		HZ
+
+static inline bool nvme_iopolicy_is_adaptive(int iopolicy)
+{
+	return iopolicy == NVME_IOPOLICY_QD || iopolicy == NVME_IOPOLICY_LAT;
+}
+
+void nvme_mpath_start_request(struct request *rq)
+{
+	struct nvme_ns *ns = rq->q->queuedata;
+
+	if (!nvme_iopolicy_is_adaptive(READ_ONCE(ns->head->subsys->iopolicy)) ||
+	    (nvme_req(rq)->flags & NVME_MPATH_CNT_ACTIVE))
+		return;
+
+	atomic_inc(&ns->ctrl->nr_active);
+	nvme_req(rq)->flags |= NVME_MPATH_CNT_ACTIVE;
+	nvme_req(rq)->start_time = ktime_get_ns();
+}
+
+void nvme_mpath_end_request(struct request *rq)
+{
+	struct nvme_ctrl *ctrl = nvme_req(rq)->ctrl;
+	u64 lat, ewma;
+
+	if (!(nvme_req(rq)->flags & NVME_MPATH_CNT_ACTIVE))
+		return;
+
+	/* Failed commands say nothing about the latency of a path */
+	if (!nvme_req(rq)->status) {
+		lat = ktime_get_ns() - nvme_req(rq)->start_time;
+		ewma = READ_ONCE(ctrl->io_latency_ns);
+		if (ewma)
+			ewma += (lat >> NVME_MPATH_LAT_EWMA_SHIFT) -
+				(ewma >> NVME_MPATH_LAT_EWMA_SHIFT);
+		else
+			ewma = lat;
+		/* Concurrent completions may lose a sample, that's fine */
+		WRITE_ONCE(ctrl->io_latency_ns, ewma);
+		WRITE_ONCE(ctrl->io_latency_stamp, jiffies);
+	}
+
+	nvme_mpath_put_request(rq);
+}
+
+static u64 nvme_path_cost(struct nvme_ns *ns, bool latency)
+{
+	struct nvme_ctrl *ctrl = ns->ctrl;
+	u64 depth = atomic_read(&ctrl->nr_active);
+
+	if (!latency)
+		return depth;
+	if (time_after(jiffies, READ_ONCE(ctrl->io_latency_stamp) +
+			NVME_MPATH_LAT_STALE))
+		return depth;
+	return READ_ONCE(ctrl->io_latency_ns) * (depth + 1);
+}
+
+/*
+ * Pick the usable path with the fewest outstanding commands, or with the
+ * lowest expected latency for a new command when @latency is set. Paths are
+ * compared on every I/O, so there is no cached current path.
+ */
+static struct nvme_ns *nvme_adaptive_path(struct nvme_ns_head *head,
+		bool latency)
+{
+	struct nvme_ns *best_opt = NULL, *best_nonopt = NULL, *ns;
+	u64 min_opt = U64_MAX, min_nonopt = U64_MAX, cost;
+
+	list_for_each_entry_rcu(ns, &head->list, siblings) {
+		if (nvme_path_is_disabled(ns))
+			continue;
+
+		cost = nvme_path_cost(ns, latency);
+		switch (ns->ana_state) {
+		case NVME_ANA_OPTIMIZED:
+			if (cost < min_opt) {
+				min_opt = cost;
+				best_opt = ns;
+			}
+			break;
+		case NVME_ANA_NONOPTIMIZED:
+			if (cost < min_nonopt) {
+				min_nonopt = cost;
+				best_nonopt = ns;
+			}
+			break;
+		default:
+			break;
+		}
+
+		if (!min_opt)
+			break;
+	}
+
+	return best_opt ? best_opt : best_nonopt;
+}
+
 static inline bool nvme_path_is_optimized(struct nvme_ns *ns)
 {
 	return ns->ctrl->state == NVME_CTRL_LIVE &&
@@ -304,14 +415,18 @@ static inline bool nvme_path_is_optimized(struct nvme_ns *ns)
 
 inline struct nvme_ns *nvme_find_path(struct nvme_ns_head *head)
 {
+	int iopolicy = READ_ONCE(head->subsys->iopolicy);
 	int node = numa_node_id();
 	struct nvme_ns *ns;
 
+	if (nvme_iopolicy_is_adaptive(iopolicy))
+		return nvme_adaptive_path(head, iopolicy == NVME_IOPOLICY_LAT);
+
 	ns = srcu_dereference(head->current_path[node], &head->srcu);
 	if (unlikely(!ns))
 		return __nvme_find_path(head, node);
 
-	if (READ_ONCE(head->subsys->iopolicy) == NVME_IOPOLICY_RR)
+	if (iopolicy == NVME_IOPOLICY_RR)
 		return nvme_round_robin_path(head, node, ns);
 	if (unlikely(!nvme_path_is_optimized(ns)))
 		return __nvme_find_path(head, node);
@@ -795,6 +910,26 @@ static ssize_t ana_state_show(struct device *dev, struct device_attribute *attr,
 }
 DEVICE_ATTR_RO(ana_state);
 
+static ssize_t queue_depth_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	struct nvme_ns *ns = nvme_get_ns_from_dev(dev);
+
+	return sysfs_emit(buf, "%d\n", atomic_read(&ns->ctrl->nr_active));
+}
+DEVICE_ATTR_RO(queue_depth);
+
+static ssize_t io_latency_us_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	struct nvme_ns *ns = nvme_get_ns_from_dev(dev);
+
+	return sysfs_emit(buf, "%llu\n",
+			  div_u64(READ_ONCE(ns->ctrl->io_latency_ns),
+				  NSEC_PER_USEC));
+}
+DEVICE_ATTR_RO(io_latency_us);
+
 static int nvme_lookup_ana_group_desc(struct nvme_ctrl *ctrl,
 		struct nvme_ana_group_desc *desc, void *data)
 {
@@ -866,6 +1001,7 @@ void nvme_mpath_remove_disk(struct nvme_ns_head *head)
 void nvme_mpath_init_ctrl(struct nvme_ctrl *ctrl)
 {
 	mutex_init(&ctrl->ana_lock);
+	atomic_set(&ctrl->nr_active, 0);
 	timer_setup(&ctrl->anatt_timer, nvme_anatt_timeout, 0);
 	INIT_WORK(&ctrl->ana_work, nvme_ana_work);
 }
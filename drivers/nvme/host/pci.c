@@ -15,6 +15,7 @@
 #include <linux/init.h>
 #include <linux/interrupt.h>
 #include <linux/io.h>
+#include <linux/irq_poll.h>
 #include <linux/memremap.h>
 #include <linux/mm.h>
 #include <linux/module.h>
@@ -51,6 +52,11 @@ static bool use_cmb_sqes = true;
 module_param(use_cmb_sqes, bool, 0444);
 MODULE_PARM_DESC(use_cmb_sqes, "use controller's memory buffer for I/O SQes");
 
+static bool use_p2pmem_sqes;
+module_param(use_p2pmem_sqes, bool, 0444);
+MODULE_PARM_DESC(use_p2pmem_sqes,
+	"use published peer-to-peer memory for I/O SQes without a CMB");
+
 static unsigned int max_host_mem_size_mb = 128;
 module_param(max_host_mem_size_mb, uint, 0444);
 MODULE_PARM_DESC(max_host_mem_size_mb,
@@ -100,6 +106,16 @@ static unsigned int poll_queues;
 module_param_cb(poll_queues, &io_queue_count_ops, &poll_queues, 0644);
 MODULE_PARM_DESC(poll_queues, "Number of queues to use for polled IO.");
 
+static unsigned int irq_poll_weight;
+module_param(irq_poll_weight, uint, 0444);
+MODULE_PARM_DESC(irq_poll_weight,
+	"completions reaped per softirq poll round of a busy interrupt driven queue, 0 to disable");
+
+static unsigned int irq_poll_thresh = 4;
+module_param(irq_poll_thresh, uint, 0644);
+MODULE_PARM_DESC(irq_poll_thresh,
+	"completions reaped by one interrupt that switch the queue to polling");
+
 static bool noacpi;
 module_param(noacpi, bool, 0444);
 MODULE_PARM_DESC(noacpi, "disable acpi bios quirks");
@@ -137,6 +153,7 @@ struct nvme_dev {
 	bool cmb_use_sqes;
 	u32 cmbsz;
 	u32 cmbloc;
+	struct pci_dev *sq_p2pmem;
 	struct nvme_ctrl ctrl;
 	u32 last_ps;
 	bool hmb;
@@ -210,6 +227,10 @@ struct nvme_queue {
 #define NVMEQ_SQ_CMB		1
 #define NVMEQ_DELETE_ERROR	2
 #define NVMEQ_POLLED		3
+#define NVMEQ_IRQ_POLL		4
+#define NVMEQ_IRQ_POLLING	5
+#define NVMEQ_SQ_P2PMEM		6
+	struct irq_poll iop;
 	__le32 *dbbuf_sq_db;
 	__le32 *dbbuf_cq_db;
 	__le32 *dbbuf_sq_ei;
@@ -1111,12 +1132,12 @@ static inline void nvme_update_cq_head(struct nvme_queue *nvmeq)
 	}
 }
 
-static inline int nvme_poll_cq(struct nvme_queue *nvmeq,
-			       struct io_comp_batch *iob)
+static inline int nvme_poll_cq_budget(struct nvme_queue *nvmeq,
+				      struct io_comp_batch *iob, int budget)
 {
 	int found = 0;
 
-	while (nvme_cqe_pending(nvmeq)) {
+	while (found < budget && nvme_cqe_pending(nvmeq)) {
 		found++;
 		/*
 		 * load-load control dependency between phase and the rest of
@@ -1132,17 +1153,80 @@ static inline int nvme_poll_cq(struct nvme_queue *nvmeq,
 	return found;
 }
 
+static inline int nvme_poll_cq(struct nvme_queue *nvmeq,
+			       struct io_comp_batch *iob)
+{
+	return nvme_poll_cq_budget(nvmeq, iob, INT_MAX);
+}
+
+/*
+ * A busy interrupt driven queue is switched to softirq polling, like NAPI
+ * does for network devices: its vector stays disabled as long as every poll
+ * round finds a full budget of completions, and it goes back to interrupts
+ * as soon as the queue drains. Lightly loaded queues keep the latency of a
+ * plain interrupt per completion.
+ */
+static int nvme_irq_poll(struct irq_poll *iop, int budget)
+{
+	struct nvme_queue *nvmeq = container_of(iop, struct nvme_queue, iop);
+	DEFINE_IO_COMP_BATCH(iob);
+	int found;
+
+	found = nvme_poll_cq_budget(nvmeq, &iob, budget);
+	if (!rq_list_empty(iob.req_list))
+		nvme_pci_complete_batch(&iob);
+
+	if (found < budget) {
+		/* Must not reschedule before the vector is enabled again */
+		irq_poll_complete(iop);
+		clear_bit(NVMEQ_IRQ_POLLING, &nvmeq->flags);
+		enable_irq(pci_irq_vector(to_pci_dev(nvmeq->dev->dev),
+					  nvmeq->cq_vector));
+	}
+
+	return found;
+}
+
+/*
+ * Wait for a running poll round and keep new ones from being scheduled. It
+ * balances the vector if a pending round was dropped while the queue was in
+ * polling mode.
+ */
+static void nvme_irq_poll_disable(struct nvme_queue *nvmeq)
+{
+	irq_poll_disable(&nvmeq->iop);
+	if (test_and_clear_bit(NVMEQ_IRQ_POLLING, &nvmeq->flags))
+		enable_irq(pci_irq_vector(to_pci_dev(nvmeq->dev->dev),
+					  nvmeq->cq_vector));
+}
+
 static irqreturn_t nvme_irq(int irq, void *data)
 {
 	struct nvme_queue *nvmeq = data;
 	DEFINE_IO_COMP_BATCH(iob);
+	int found;
+
+	found = nvme_poll_cq(nvmeq, &iob);
+	if (!found)
+		return IRQ_NONE;
+
+	if (!rq_list_empty(iob.req_list))
+		nvme_pci_complete_batch(&iob);
 
-	if (nvme_poll_cq(nvmeq, &iob)) {
-		if (!rq_list_empty(iob.req_list))
-			nvme_pci_complete_batch(&iob);
-		return IRQ_HANDLED;
+	/*
+	 * The vector is only disabled when the poll round is really going to
+	 * run, as that round is what enables it again. irq_poll_sched() does
+	 * nothing on a disabled poller, and nvme_poll_irqdisable() keeps the
+	 * vector disabled for as long as its poller is.
+	 */
+	if (found >= irq_poll_thresh &&
+	    test_bit(NVMEQ_IRQ_POLL, &nvmeq->flags) &&
+	    !test_bit(IRQ_POLL_F_DISABLE, &nvmeq->iop.state) &&
+	    !test_and_set_bit(NVMEQ_IRQ_POLLING, &nvmeq->flags)) {
+		disable_irq_nosync(irq);
+		irq_poll_sched(&nvmeq->iop);
 	}
-	return IRQ_NONE;
+	return IRQ_HANDLED;
 }
 
 static irqreturn_t nvme_irq_check(int irq, void *data)
@@ -1164,8 +1248,17 @@ static void nvme_poll_irqdisable(struct nvme_queue *nvmeq)
 
 	WARN_ON_ONCE(test_bit(NVMEQ_POLLED, &nvmeq->flags));
 
+	/*
+	 * The vector is disabled first so that nvme_irq() can't switch to
+	 * polling while the poller is disabled, and it is enabled last for
+	 * the same reason.
+	 */
 	disable_irq(pci_irq_vector(pdev, nvmeq->cq_vector));
+	if (test_bit(NVMEQ_IRQ_POLL, &nvmeq->flags))
+		nvme_irq_poll_disable(nvmeq);
 	nvme_poll_cq(nvmeq, NULL);
+	if (test_bit(NVMEQ_IRQ_POLL, &nvmeq->flags))
+		irq_poll_enable(&nvmeq->iop);
 	enable_irq(pci_irq_vector(pdev, nvmeq->cq_vector));
 }
 
@@ -1459,6 +1552,9 @@ static void nvme_free_queue(struct nvme_queue *nvmeq)
 	if (test_and_clear_bit(NVMEQ_SQ_CMB, &nvmeq->flags)) {
 		pci_free_p2pmem(to_pci_dev(nvmeq->dev->dev),
 				nvmeq->sq_cmds, SQ_SIZE(nvmeq));
+	} else if (test_and_clear_bit(NVMEQ_SQ_P2PMEM, &nvmeq->flags)) {
+		pci_free_p2pmem(nvmeq->dev->sq_p2pmem,
+				nvmeq->sq_cmds, SQ_SIZE(nvmeq));
 	} else {
 		dma_free_coherent(nvmeq->dev->dev, SQ_SIZE(nvmeq),
 				nvmeq->sq_cmds, nvmeq->sq_dma_addr);
@@ -1490,6 +1586,8 @@ static int nvme_suspend_queue(struct nvme_queue *nvmeq)
 	nvmeq->dev->online_queues--;
 	if (!nvmeq->qid && nvmeq->dev->ctrl.admin_q)
 		nvme_stop_admin_queue(&nvmeq->dev->ctrl);
+	if (test_and_clear_bit(NVMEQ_IRQ_POLL, &nvmeq->flags))
+		nvme_irq_poll_disable(nvmeq);
 	if (!test_and_clear_bit(NVMEQ_POLLED, &nvmeq->flags))
 		pci_free_irq(to_pci_dev(nvmeq->dev->dev), nvmeq->cq_vector, nvmeq);
 	return 0;
@@ -1574,6 +1672,20 @@ static int nvme_alloc_sq_cmds(struct nvme_dev *dev, struct nvme_queue *nvmeq,
 
 			pci_free_p2pmem(pdev, nvmeq->sq_cmds, SQ_SIZE(nvmeq));
 		}
+	} else if (qid && dev->sq_p2pmem) {
+		nvmeq->sq_cmds = pci_alloc_p2pmem(dev->sq_p2pmem,
+						  SQ_SIZE(nvmeq));
+		if (nvmeq->sq_cmds) {
+			nvmeq->sq_dma_addr = pci_p2pmem_virt_to_bus(
+					dev->sq_p2pmem, nvmeq->sq_cmds);
+			if (nvmeq->sq_dma_addr) {
+				set_bit(NVMEQ_SQ_P2PMEM, &nvmeq->flags);
+				return 0;
+			}
+
+			pci_free_p2pmem(dev->sq_p2pmem, nvmeq->sq_cmds,
+					SQ_SIZE(nvmeq));
+		}
 	}
 
 	nvmeq->sq_cmds = dma_alloc_coherent(dev->dev, SQ_SIZE(nvmeq),
@@ -1703,9 +1815,21 @@ static int nvme_create_queue(struct nvme_queue *nvmeq, int qid, bool polled)
 		return result;
 	nvme_init_queue(nvmeq, qid);
 	if (!polled) {
+		/*
+		 * Polling disables the vector, so it is only used for vectors
+		 * that are not shared with the admin queue.
+		 */
+		if (irq_poll_weight && !use_threaded_interrupts &&
+		    dev->num_vecs > 1) {
+			irq_poll_init(&nvmeq->iop, irq_poll_weight,
+				      nvme_irq_poll);
+			set_bit(NVMEQ_IRQ_POLL, &nvmeq->flags);
+		}
 		result = queue_request_irq(nvmeq);
-		if (result < 0)
+		if (result < 0) {
+			clear_bit(NVMEQ_IRQ_POLL, &nvmeq->flags);
 			goto release_sq;
+		}
 	}
 
 	set_bit(NVMEQ_ENABLED, &nvmeq->flags);
@@ -1971,6 +2095,31 @@ static void nvme_map_cmb(struct nvme_dev *dev)
 		pci_p2pmem_publish(pdev, true);
 }
 
+/*
+ * Without a CMB for the SQes, look for peer-to-peer memory another device
+ * published close to the controller, e.g. FPGA memory behind the same root
+ * port. pci_p2pmem_find() only returns providers the controller can reach
+ * with peer-to-peer transactions. The queues for which it runs out fall
+ * back to host memory.
+ */
+static void nvme_map_p2pmem_sqes(struct nvme_dev *dev)
+{
+	if (!use_p2pmem_sqes || dev->cmb_use_sqes || dev->sq_p2pmem)
+		return;
+
+	dev->sq_p2pmem = pci_p2pmem_find(dev->dev);
+
+	/* Our own CMB is published too, it is only used through cmb_use_sqes */
+	if (dev->sq_p2pmem == to_pci_dev(dev->dev)) {
+		pci_dev_put(dev->sq_p2pmem);
+		dev->sq_p2pmem = NULL;
+	}
+
+	if (dev->sq_p2pmem)
+		dev_info(dev->ctrl.device, "I/O SQes in p2pmem of %s\n",
+			 pci_name(dev->sq_p2pmem));
+}
+
 static int nvme_set_host_mem(struct nvme_dev *dev, u32 bits)
 {
 	u32 host_mem_size = dev->host_mem_size >> NVME_CTRL_PAGE_SHIFT;
@@ -2645,6 +2794,7 @@ static int nvme_pci_enable(struct nvme_dev *dev)
 
 
 	nvme_map_cmb(dev);
+	nvme_map_p2pmem_sqes(dev);
 
 	pci_enable_pcie_error_reporting(pdev);
 	pci_save_state(pdev);
@@ -2780,6 +2930,7 @@ static void nvme_pci_free_ctrl(struct nvme_ctrl *ctrl)
 		blk_put_queue(dev->ctrl.admin_q);
 	free_opal_dev(dev->ctrl.opal_dev);
 	mempool_destroy(dev->iod_mempool);
+	pci_dev_put(dev->sq_p2pmem);
 	put_device(dev->dev);
 	kfree(dev->queues);
 	kfree(dev);
@@ -12,6 +12,8 @@
 #include <net/sock.h>
 #include <net/tcp.h>
 #include <linux/blk-mq.h>
+#include <linux/crc32c.h>
+#include <linux/highmem.h>
 #include <crypto/hash.h>
 #include <net/busy_poll.h>
 
@@ -30,6 +32,16 @@ static int so_priority;
 module_param(so_priority, int, 0644);
 MODULE_PARM_DESC(so_priority, "nvme tcp socket optimize priority");
 
+/*
+ * Move the io_work of a queue to the CPU that processes its received
+ * packets, so it follows the NIC interrupt affinity or RPS configuration.
+ * The io_cpus connect option still limits the CPUs it may move to.
+ */
+static bool io_cpu_follow_rx;
+module_param(io_cpu_follow_rx, bool, 0644);
+MODULE_PARM_DESC(io_cpu_follow_rx,
+		 "run nvme tcp io_work on the CPU receiving the queue's packets");
+
 #ifdef CONFIG_DEBUG_LOCK_ALLOC
 /* lockdep can detect a circular dependency of the form
  *   sk_lock -> mmap_lock (page fault) -> fs locks -> sk_lock
@@ -91,6 +103,7 @@ struct nvme_tcp_request {
 	__le32			ddgst;
 
 	struct bio		*curr_bio;
+	struct bio_vec		*bvec;	/* request wide table of multi bio reads */
 	struct iov_iter		iter;
 
 	/* send state */
@@ -142,7 +155,7 @@ struct nvme_tcp_queue {
 	bool			hdr_digest;
 	bool			data_digest;
 	struct ahash_request	*rcv_hash;
-	struct ahash_request	*snd_hash;
+	u32			snd_crc;
 	__le32			exp_ddgst;
 	__le32			recv_ddgst;
 
@@ -292,6 +305,45 @@ static void nvme_tcp_init_iter(struct nvme_tcp_request *req,
 	req->iter.iov_offset = offset;
 }
 
+/*
+ * Reads spanning several bios are received into one iterator over all of
+ * them, so the data of an skb is copied with a single call instead of one
+ * call per bio. If the table can't be allocated we fall back to per bio
+ * iterators.
+ */
+static bool nvme_tcp_init_rq_iter(struct nvme_tcp_request *req)
+{
+	struct request *rq = blk_mq_rq_from_pdu(req);
+	struct req_iterator rq_iter;
+	struct bio_vec bv, *bvec;
+	unsigned int nr_bvec = 0;
+
+	rq_for_each_bvec(bv, rq, rq_iter)
+		nr_bvec++;
+
+	bvec = kmalloc_array(nr_bvec, sizeof(*bvec), GFP_ATOMIC | __GFP_NOWARN);
+	if (!bvec)
+		return false;
+
+	req->bvec = bvec;
+	rq_for_each_bvec(bv, rq, rq_iter)
+		*bvec++ = bv;
+
+	iov_iter_bvec(&req->iter, READ, req->bvec, nr_bvec, req->data_len);
+	/* there is no further bio to move to once the iterator is exhausted */
+	req->curr_bio = rq->biotail;
+	return true;
+}
+
+static void nvme_tcp_complete_rq(struct request *rq)
+{
+	struct nvme_tcp_request *req = blk_mq_rq_to_pdu(rq);
+
+	kfree(req->bvec);
+	req->bvec = NULL;
+	nvme_complete_rq(rq);
+}
+
 static inline void nvme_tcp_advance_req(struct nvme_tcp_request *req,
 		int len)
 {
@@ -382,25 +434,40 @@ static inline void nvme_tcp_ddgst_final(struct ahash_request *hash,
 	crypto_ahash_final(hash);
 }
 
-static inline void nvme_tcp_ddgst_update(struct ahash_request *hash,
-		struct page *page, off_t off, size_t len)
+/*
+ * Digests computed from linear buffers use the crc32c library directly, it
+ * resolves to the CPU's crc32c instructions without building a scatterlist
+ * and going through the crypto API for every PDU. Received data stays on
+ * the ahash so it is hashed while it is copied out of the skb.
+ */
+#define NVME_TCP_CRC_SEED	(~0)
+
+static inline void nvme_tcp_ddgst_update(u32 *crcp,
+		struct page *page, size_t off, size_t len)
 {
-	struct scatterlist sg;
+	page += off / PAGE_SIZE;
+	off %= PAGE_SIZE;
+	while (len) {
+		const void *vaddr = kmap_local_page(page);
+		size_t n = min_t(size_t, len, PAGE_SIZE - off);
 
-	sg_init_table(&sg, 1);
-	sg_set_page(&sg, page, len, off);
-	ahash_request_set_crypt(hash, &sg, NULL, len);
-	crypto_ahash_update(hash);
+		*crcp = crc32c(*crcp, vaddr + off, n);
+		kunmap_local(vaddr);
+		page++;
+		off = 0;
+		len -= n;
+	}
 }
 
-static inline void nvme_tcp_hdgst(struct ahash_request *hash,
-		void *pdu, size_t len)
+static inline __le32 nvme_tcp_ddgst_final_crc(u32 crc)
 {
-	struct scatterlist sg;
+	return cpu_to_le32(~crc);
+}
 
-	sg_init_one(&sg, pdu, len);
-	ahash_request_set_crypt(hash, &sg, pdu + len, len);
-	crypto_ahash_digest(hash);
+static inline void nvme_tcp_hdgst(void *pdu, size_t len)
+{
+	*(__le32 *)(pdu + len) =
+		cpu_to_le32(~crc32c(NVME_TCP_CRC_SEED, pdu, len));
 }
 
 static int nvme_tcp_verify_hdgst(struct nvme_tcp_queue *queue,
@@ -418,7 +485,7 @@ static int nvme_tcp_verify_hdgst(struct nvme_tcp_queue *queue,
 	}
 
 	recv_digest = *(__le32 *)(pdu + hdr->hlen);
-	nvme_tcp_hdgst(queue->rcv_hash, pdu, pdu_len);
+	nvme_tcp_hdgst(pdu, pdu_len);
 	exp_digest = *(__le32 *)(pdu + hdr->hlen);
 	if (recv_digest != exp_digest) {
 		dev_err(queue->ctrl->ctrl.device,
@@ -549,7 +616,7 @@ static int nvme_tcp_process_nvme_cqe(struct nvme_tcp_queue *queue,
 		req->status = cqe->status;
 
 	if (!nvme_try_complete_req(rq, req->status, cqe->result))
-		nvme_complete_rq(rq);
+		nvme_tcp_complete_rq(rq);
 	queue->nr_cqe++;
 
 	return 0;
@@ -749,7 +816,7 @@ static inline void nvme_tcp_end_request(struct request *rq, u16 status)
 	union nvme_result res = {};
 
 	if (!nvme_try_complete_req(rq, cpu_to_le16(status << 1), res))
-		nvme_complete_rq(rq);
+		nvme_tcp_complete_rq(rq);
 }
 
 static int nvme_tcp_recv_data(struct nvme_tcp_queue *queue, struct sk_buff *skb,
@@ -901,6 +968,18 @@ static int nvme_tcp_recv_skb(read_descriptor_t *desc, struct sk_buff *skb,
 	return consumed;
 }
 
+static void nvme_tcp_follow_rx_cpu(struct nvme_tcp_queue *queue)
+{
+	const struct cpumask *io_cpus = queue->ctrl->ctrl.opts->io_cpus;
+	int cpu = smp_processor_id();
+
+	if (cpu == READ_ONCE(queue->io_cpu))
+		return;
+	if (io_cpus && !cpumask_test_cpu(cpu, io_cpus))
+		return;
+	WRITE_ONCE(queue->io_cpu, cpu);
+}
+
 static void nvme_tcp_data_ready(struct sock *sk)
 {
 	struct nvme_tcp_queue *queue;
@@ -908,8 +987,11 @@ static void nvme_tcp_data_ready(struct sock *sk)
 	read_lock_bh(&sk->sk_callback_lock);
 	queue = sk->sk_user_data;
 	if (likely(queue && queue->rd_enabled) &&
-	    !test_bit(NVME_TCP_Q_POLLING, &queue->flags))
+	    !test_bit(NVME_TCP_Q_POLLING, &queue->flags)) {
+		if (io_cpu_follow_rx)
+			nvme_tcp_follow_rx_cpu(queue);
 		queue_work_on(queue->io_cpu, nvme_tcp_wq, &queue->io_work);
+	}
 	read_unlock_bh(&sk->sk_callback_lock);
 }
 
@@ -1002,7 +1084,7 @@ static int nvme_tcp_try_send_data(struct nvme_tcp_request *req)
 			return ret;
 
 		if (queue->data_digest)
-			nvme_tcp_ddgst_update(queue->snd_hash, page,
+			nvme_tcp_ddgst_update(&queue->snd_crc, page,
 					offset, ret);
 
 		/*
@@ -1016,8 +1098,8 @@ static int nvme_tcp_try_send_data(struct nvme_tcp_request *req)
 		/* fully successful last send in current PDU */
 		if (last && ret == len) {
 			if (queue->data_digest) {
-				nvme_tcp_ddgst_final(queue->snd_hash,
-					&req->ddgst);
+				req->ddgst =
+					nvme_tcp_ddgst_final_crc(queue->snd_crc);
 				req->state = NVME_TCP_SEND_DDGST;
 				req->offset = 0;
 			} else {
@@ -1048,7 +1130,7 @@ static int nvme_tcp_try_send_cmd_pdu(struct nvme_tcp_request *req)
 		flags |= MSG_EOR;
 
 	if (queue->hdr_digest && !req->offset)
-		nvme_tcp_hdgst(queue->snd_hash, pdu, sizeof(*pdu));
+		nvme_tcp_hdgst(pdu, sizeof(*pdu));
 
 	ret = kernel_sendpage(queue->sock, virt_to_page(pdu),
 			offset_in_page(pdu) + req->offset, len,  flags);
@@ -1060,7 +1142,7 @@ static int nvme_tcp_try_send_cmd_pdu(struct nvme_tcp_request *req)
 		if (inline_data) {
 			req->state = NVME_TCP_SEND_DATA;
 			if (queue->data_digest)
-				crypto_ahash_init(queue->snd_hash);
+				queue->snd_crc = NVME_TCP_CRC_SEED;
 		} else {
 			nvme_tcp_done_send_req(queue);
 		}
@@ -1080,7 +1162,7 @@ static int nvme_tcp_try_send_data_pdu(struct nvme_tcp_request *req)
 	int ret;
 
 	if (queue->hdr_digest && !req->offset)
-		nvme_tcp_hdgst(queue->snd_hash, pdu, sizeof(*pdu));
+		nvme_tcp_hdgst(pdu, sizeof(*pdu));
 
 	if (!req->h2cdata_left)
 		ret = kernel_sendpage(queue->sock, virt_to_page(pdu),
@@ -1097,7 +1179,7 @@ static int nvme_tcp_try_send_data_pdu(struct nvme_tcp_request *req)
 	if (!len) {
 		req->state = NVME_TCP_SEND_DATA;
 		if (queue->data_digest)
-			crypto_ahash_init(queue->snd_hash);
+			queue->snd_crc = NVME_TCP_CRC_SEED;
 		return 1;
 	}
 	req->offset += ret;
@@ -1242,7 +1324,6 @@ static void nvme_tcp_free_crypto(struct nvme_tcp_queue *queue)
 	struct crypto_ahash *tfm = crypto_ahash_reqtfm(queue->rcv_hash);
 
 	ahash_request_free(queue->rcv_hash);
-	ahash_request_free(queue->snd_hash);
 	crypto_free_ahash(tfm);
 }
 
@@ -1254,19 +1335,12 @@ static int nvme_tcp_alloc_crypto(struct nvme_tcp_queue *queue)
 	if (IS_ERR(tfm))
 		return PTR_ERR(tfm);
 
-	queue->snd_hash = ahash_request_alloc(tfm, GFP_KERNEL);
-	if (!queue->snd_hash)
-		goto free_tfm;
-	ahash_request_set_callback(queue->snd_hash, 0, NULL, NULL);
-
 	queue->rcv_hash = ahash_request_alloc(tfm, GFP_KERNEL);
 	if (!queue->rcv_hash)
-		goto free_snd_hash;
+		goto free_tfm;
 	ahash_request_set_callback(queue->rcv_hash, 0, NULL, NULL);
 
 	return 0;
-free_snd_hash:
-	ahash_request_free(queue->snd_hash);
 free_tfm:
 	crypto_free_ahash(tfm);
 	return -ENOMEM;
@@ -1471,8 +1545,9 @@ static bool nvme_tcp_poll_queue(struct nvme_tcp_queue *queue)
 static void nvme_tcp_set_queue_io_cpu(struct nvme_tcp_queue *queue)
 {
 	struct nvme_tcp_ctrl *ctrl = queue->ctrl;
+	const struct cpumask *io_cpus = ctrl->ctrl.opts->io_cpus;
 	int qid = nvme_tcp_queue_id(queue);
-	int n = 0;
+	int n = 0, cpu, nr = 0;
 
 	if (nvme_tcp_default_queue(queue))
 		n = qid - 1;
@@ -1481,6 +1556,21 @@ static void nvme_tcp_set_queue_io_cpu(struct nvme_tcp_queue *queue)
 	else if (nvme_tcp_poll_queue(queue))
 		n = qid - ctrl->io_queues[HCTX_TYPE_DEFAULT] -
 				ctrl->io_queues[HCTX_TYPE_READ] - 1;
+
+	/* Spread the queues of each type over the online CPUs in io_cpus */
+	if (io_cpus) {
+		for_each_cpu_and(cpu, io_cpus, cpu_online_mask)
+			nr++;
+		if (nr) {
+			n %= nr;
+			for_each_cpu_and(cpu, io_cpus, cpu_online_mask) {
+				if (!n--) {
+					queue->io_cpu = cpu;
+					return;
+				}
+			}
+		}
+	}
 	queue->io_cpu = cpumask_next_wrap(n - 1, cpu_online_mask, -1, false);
 }
 
@@ -2359,8 +2449,11 @@ static blk_status_t nvme_tcp_setup_cmd_pdu(struct nvme_ns *ns,
 	req->data_len = blk_rq_nr_phys_segments(rq) ?
 				blk_rq_payload_bytes(rq) : 0;
 	req->curr_bio = rq->bio;
-	if (req->curr_bio && req->data_len)
-		nvme_tcp_init_iter(req, rq_data_dir(rq));
+	if (req->curr_bio && req->data_len) {
+		if (rq_data_dir(rq) == WRITE || rq->bio == rq->biotail ||
+		    !nvme_tcp_init_rq_iter(req))
+			nvme_tcp_init_iter(req, rq_data_dir(rq));
+	}
 
 	if (rq_data_dir(rq) == WRITE &&
 	    req->data_len <= nvme_tcp_inline_data_size(req))
@@ -2381,6 +2474,8 @@ static blk_status_t nvme_tcp_setup_cmd_pdu(struct nvme_ns *ns,
 
 	ret = nvme_tcp_map_data(queue, rq);
 	if (unlikely(ret)) {
+		kfree(req->bvec);
+		req->bvec = NULL;
 		nvme_cleanup_cmd(rq);
 		dev_err(queue->ctrl->ctrl.device,
 			"Failed to map data (%d)\n", ret);
@@ -2503,7 +2598,7 @@ static int nvme_tcp_get_address(struct nvme_ctrl *ctrl, char *buf, int size)
 static const struct blk_mq_ops nvme_tcp_mq_ops = {
 	.queue_rq	= nvme_tcp_queue_rq,
 	.commit_rqs	= nvme_tcp_commit_rqs,
-	.complete	= nvme_complete_rq,
+	.complete	= nvme_tcp_complete_rq,
 	.init_request	= nvme_tcp_init_request,
 	.exit_request	= nvme_tcp_exit_request,
 	.init_hctx	= nvme_tcp_init_hctx,
@@ -2514,7 +2609,7 @@ static const struct blk_mq_ops nvme_tcp_mq_ops = {
 
 static const struct blk_mq_ops nvme_tcp_admin_mq_ops = {
 	.queue_rq	= nvme_tcp_queue_rq,
-	.complete	= nvme_complete_rq,
+	.complete	= nvme_tcp_complete_rq,
 	.init_request	= nvme_tcp_init_request,
 	.exit_request	= nvme_tcp_exit_request,
 	.init_hctx	= nvme_tcp_init_admin_hctx,
@@ -2667,7 +2762,7 @@ static struct nvmf_transport_ops nvme_tcp_transport = {
 			  NVMF_OPT_HOST_TRADDR | NVMF_OPT_CTRL_LOSS_TMO |
 			  NVMF_OPT_HDR_DIGEST | NVMF_OPT_DATA_DIGEST |
 			  NVMF_OPT_NR_WRITE_QUEUES | NVMF_OPT_NR_POLL_QUEUES |
-			  NVMF_OPT_TOS | NVMF_OPT_HOST_IFACE,
+			  NVMF_OPT_TOS | NVMF_OPT_HOST_IFACE | NVMF_OPT_IO_CPUS,
 	.create_ctrl	= nvme_tcp_create_ctrl,
 };
 
@@ -3,8 +3,10 @@
  * Copyright (C) 2017 - 2021 Xilinx, Inc.
  */
 
+#include <linux/bitmap.h>
 #include <linux/dma-mapping.h>
 #include <linux/module.h>
+#include <linux/mutex.h>
 #include <linux/nvmem-provider.h>
 #include <linux/of.h>
 #include <linux/platform_device.h>
@@ -28,6 +30,30 @@
 #define EFUSE_NOT_ENABLED	(29)
 #define EFUSE_READ		(0)
 #define EFUSE_WRITE		(1)
+#define EFUSE_CACHE_WORDS	((EFUSE_PUF_START_OFFSET - EFUSE_START_OFFSET) / \
+				 WORD_INBYTES)
+
+/**
+ * struct zynqmp_nvmem_data - driver private data
+ * @dev:	device pointer
+ * @lock:	protects the cached values
+ * @soc_ver:	cached silicon revision
+ * @soc_ver_valid: @soc_ver has been read from the firmware
+ * @efuse:	cached non-PUF eFuse words, from EFUSE_START_OFFSET
+ * @efuse_valid: words of @efuse read from the firmware
+ *
+ * eFuses don't change unless programmed through this driver, so reads
+ * are served from memory once a word has been fetched, and the whole
+ * non-PUF range is fetched in a single firmware call on the first miss.
+ */
+struct zynqmp_nvmem_data {
+	struct device *dev;
+	struct mutex lock;
+	u32 soc_ver;
+	bool soc_ver_valid;
+	u32 efuse[EFUSE_CACHE_WORDS];
+	DECLARE_BITMAP(efuse_valid, EFUSE_CACHE_WORDS);
+};
 
 /**
  * struct xilinx_efuse - the basic structure
@@ -49,12 +75,11 @@ struct xilinx_efuse {
 	u32 pufuserfuse;
 };
 
-static int zynqmp_efuse_access(void *context, unsigned int offset,
+static int zynqmp_efuse_access(struct device *dev, unsigned int offset,
 			       void *val, size_t bytes, unsigned int flag,
 			       unsigned int pufflag)
 {
 	size_t words = bytes / WORD_INBYTES;
-	struct device *dev = context;
 	dma_addr_t dma_addr, dma_buf;
 	struct xilinx_efuse *efuse;
 	char *data;
@@ -91,8 +116,7 @@ static int zynqmp_efuse_access(void *context, unsigned int offset,
 	if (!efuse)
 		return -ENOMEM;
 
-	data = dma_alloc_coherent(dev, sizeof(bytes),
-				  &dma_buf, GFP_KERNEL);
+	data = dma_alloc_coherent(dev, bytes, &dma_buf, GFP_KERNEL);
 	if (!data) {
 		dma_free_coherent(dev, sizeof(struct xilinx_efuse),
 				  efuse, dma_addr);
@@ -129,14 +153,52 @@ static int zynqmp_efuse_access(void *context, unsigned int offset,
 
 	dma_free_coherent(dev, sizeof(struct xilinx_efuse),
 			  efuse, dma_addr);
-	dma_free_coherent(dev, sizeof(bytes),
-			  data, dma_buf);
+	dma_free_coherent(dev, bytes, data, dma_buf);
+
+	return ret;
+}
+
+static int zynqmp_efuse_cached_read(struct zynqmp_nvmem_data *priv,
+				    unsigned int offset, void *val,
+				    size_t bytes)
+{
+	unsigned int first = (offset - EFUSE_START_OFFSET) / WORD_INBYTES;
+	unsigned int nwords = bytes / WORD_INBYTES;
+	unsigned int start, end;
+	int ret = 0;
+
+	mutex_lock(&priv->lock);
+
+	if (bitmap_empty(priv->efuse_valid, EFUSE_CACHE_WORDS) &&
+	    !zynqmp_efuse_access(priv->dev, EFUSE_START_OFFSET, priv->efuse,
+				 sizeof(priv->efuse), EFUSE_READ, 0))
+		bitmap_fill(priv->efuse_valid, EFUSE_CACHE_WORDS);
+
+	/* Fetch what the bulk read didn't get, one call per missing run */
+	start = first;
+	for_each_clear_bitrange_from(start, end, priv->efuse_valid,
+				     first + nwords) {
+		ret = zynqmp_efuse_access(priv->dev,
+					  EFUSE_START_OFFSET +
+					  start * WORD_INBYTES,
+					  &priv->efuse[start],
+					  (end - start) * WORD_INBYTES,
+					  EFUSE_READ, 0);
+		if (ret)
+			goto unlock;
+		bitmap_set(priv->efuse_valid, start, end - start);
+	}
+
+	memcpy(val, &priv->efuse[first], bytes);
+unlock:
+	mutex_unlock(&priv->lock);
 
 	return ret;
 }
 
 static int zynqmp_nvmem_read(void *context, unsigned int offset, void *val, size_t bytes)
 {
+	struct zynqmp_nvmem_data *priv = context;
 	int ret, pufflag = 0;
 	int idcode, version;
 
@@ -149,17 +211,34 @@ static int zynqmp_nvmem_read(void *context, unsigned int offset, void *val, size
 		if (bytes != SOC_VER_SIZE)
 			return -EOPNOTSUPP;
 
-		ret = zynqmp_pm_get_chipid((u32 *)&idcode, (u32 *)&version);
-		if (ret < 0)
-			return ret;
-
-		pr_debug("Read chipid val %x %x\n", idcode, version);
-		*(int *)val = version & SILICON_REVISION_MASK;
+		mutex_lock(&priv->lock);
+		if (!priv->soc_ver_valid) {
+			ret = zynqmp_pm_get_chipid((u32 *)&idcode,
+						   (u32 *)&version);
+			if (ret < 0) {
+				mutex_unlock(&priv->lock);
+				return ret;
+			}
+
+			pr_debug("Read chipid val %x %x\n", idcode, version);
+			priv->soc_ver = version & SILICON_REVISION_MASK;
+			priv->soc_ver_valid = true;
+		}
+		*(int *)val = priv->soc_ver;
+		mutex_unlock(&priv->lock);
+		ret = 0;
 		break;
 	/* Efuse offset starts from 0xc */
 	case EFUSE_START_OFFSET ... EFUSE_END_OFFSET:
+		if (!(offset % WORD_INBYTES) && !(bytes % WORD_INBYTES) &&
+		    offset + bytes <= EFUSE_PUF_START_OFFSET) {
+			ret = zynqmp_efuse_cached_read(priv, offset, val,
+						       bytes);
+			break;
+		}
+		fallthrough;
 	case EFUSE_PUF_START_OFFSET ... EFUSE_PUF_END_OFFSET:
-		ret = zynqmp_efuse_access(context, offset, val,
+		ret = zynqmp_efuse_access(priv->dev, offset, val,
 					  bytes, EFUSE_READ, pufflag);
 		break;
 	default:
@@ -174,7 +253,9 @@ static int zynqmp_nvmem_read(void *context, unsigned int offset, void *val, size
 static int zynqmp_nvmem_write(void *context,
 			      unsigned int offset, void *val, size_t bytes)
 {
+	struct zynqmp_nvmem_data *priv = context;
 	int pufflag = 0;
+	int ret;
 
 	if (offset < EFUSE_START_OFFSET || offset > EFUSE_PUF_END_OFFSET)
 		return -EOPNOTSUPP;
@@ -182,8 +263,14 @@ static int zynqmp_nvmem_write(void *context,
 	if (offset >= EFUSE_PUF_START_OFFSET && offset <= EFUSE_PUF_END_OFFSET)
 		pufflag = 1;
 
-	return zynqmp_efuse_access(context, offset,
-				   val, bytes, EFUSE_WRITE, pufflag);
+	/* Programming may also change control and security words */
+	mutex_lock(&priv->lock);
+	ret = zynqmp_efuse_access(priv->dev, offset,
+				  val, bytes, EFUSE_WRITE, pufflag);
+	bitmap_zero(priv->efuse_valid, EFUSE_CACHE_WORDS);
+	mutex_unlock(&priv->lock);
+
+	return ret;
 }
 
 static struct nvmem_config econfig = {
@@ -201,10 +288,18 @@ MODULE_DEVICE_TABLE(of, zynqmp_nvmem_match);
 
 static int zynqmp_nvmem_probe(struct platform_device *pdev)
 {
+	struct zynqmp_nvmem_data *priv;
 	struct nvmem_device *nvmem;
 
+	priv = devm_kzalloc(&pdev->dev, sizeof(*priv), GFP_KERNEL);
+	if (!priv)
+		return -ENOMEM;
+
+	priv->dev = &pdev->dev;
+	mutex_init(&priv->lock);
+
 	econfig.dev = &pdev->dev;
-	econfig.priv = &pdev->dev;
+	econfig.priv = priv;
 	econfig.reg_read = zynqmp_nvmem_read;
 	econfig.reg_write = zynqmp_nvmem_write;
 
@@ -127,6 +127,7 @@ struct xilinx_cpm_variant {
  * @irq: Error interrupt number
  * @lock: lock protecting shared register access
  * @variant: CPM version check pointer
+ * @events: Number of occurrences of each interrupt cause
  */
 struct xilinx_cpm_pcie {
 	struct device			*dev;
@@ -139,6 +140,7 @@ struct xilinx_cpm_pcie {
 	int				irq;
 	raw_spinlock_t			lock;
 	const struct xilinx_cpm_variant   *variant;
+	unsigned long			events[32];
 };
 
 static u32 pcie_read(struct xilinx_cpm_pcie *port, u32 reg)
@@ -358,6 +360,7 @@ static irqreturn_t xilinx_cpm_pcie_intr_handler(int irq, void *dev_id)
 	struct irq_data *d;
 
 	d = irq_domain_get_irq_data(port->cpm_domain, irq);
+	port->events[d->hwirq]++;
 
 	switch (d->hwirq) {
 	case XILINX_CPM_PCIE_INTR_CORRECTABLE:
@@ -368,7 +371,8 @@ static irqreturn_t xilinx_cpm_pcie_intr_handler(int irq, void *dev_id)
 
 	default:
 		if (intr_cause[d->hwirq].str)
-			dev_warn(dev, "%s\n", intr_cause[d->hwirq].str);
+			dev_warn_ratelimited(dev, "%s\n",
+					     intr_cause[d->hwirq].str);
 		else
 			dev_warn(dev, "Unknown IRQ %ld\n", d->hwirq);
 	}
@@ -587,6 +591,7 @@ static int xilinx_cpm_pcie_probe(struct platform_device *pdev)
 		return -ENODEV;
 
 	port = pci_host_bridge_priv(bridge);
+	platform_set_drvdata(pdev, port);
 
 	port->dev = dev;
 
@@ -617,6 +622,16 @@ static int xilinx_cpm_pcie_probe(struct platform_device *pdev)
 	bridge->sysdata = port->cfg;
 	bridge->ops = (struct pci_ops *)&pci_generic_ecam_ops.pci_ops;
 
+	/*
+	 * MSI and MSI-X are translated by the GIC ITS, each vector is an
+	 * LPI with its own affinity. The bridge does not decode them, so
+	 * without an msi-map or msi-parent only INTx is available.
+	 */
+	bridge->msi_domain = true;
+	if (!of_find_property(dev->of_node, "msi-map", NULL) &&
+	    !of_find_property(dev->of_node, "msi-parent", NULL))
+		dev_warn(dev, "no msi-map or msi-parent, MSI is disabled\n");
+
 	err = pci_host_probe(bridge);
 	if (err < 0)
 		goto err_host_bridge;
@@ -652,11 +667,84 @@ static const struct of_device_id xilinx_cpm_pcie_of_match[] = {
 	{}
 };
 
+/*
+ * Event counters, one per interrupt cause. Each cause has its own interrupt,
+ * so every counter has a single writer and is read without locking.
+ */
+static ssize_t xilinx_cpm_pcie_event_show(struct device *dev,
+					  struct device_attribute *attr,
+					  char *buf)
+{
+	struct dev_ext_attribute *ea = container_of(attr,
+						    struct dev_ext_attribute,
+						    attr);
+	struct xilinx_cpm_pcie *port = dev_get_drvdata(dev);
+	unsigned long cause = (unsigned long)ea->var;
+
+	return sysfs_emit(buf, "%lu\n", READ_ONCE(port->events[cause]));
+}
+
+#define CPM_EVENT_ATTR(_name, x)					\
+	static struct dev_ext_attribute cpm_event_##_name = {	\
+		__ATTR(_name, 0444, xilinx_cpm_pcie_event_show, NULL),	\
+		(void *)XILINX_CPM_PCIE_INTR_ ## x			\
+	}
+
+CPM_EVENT_ATTR(link_down, LINK_DOWN);
+CPM_EVENT_ATTR(hot_reset, HOT_RESET);
+CPM_EVENT_ATTR(cfg_timeout, CFG_TIMEOUT);
+CPM_EVENT_ATTR(err_correctable, CORRECTABLE);
+CPM_EVENT_ATTR(err_nonfatal, NONFATAL);
+CPM_EVENT_ATTR(err_fatal, FATAL);
+CPM_EVENT_ATTR(slv_unsupp, SLV_UNSUPP);
+CPM_EVENT_ATTR(slv_unexp, SLV_UNEXP);
+CPM_EVENT_ATTR(slv_compl_timeout, SLV_COMPL);
+CPM_EVENT_ATTR(slv_err_poison, SLV_ERRP);
+CPM_EVENT_ATTR(slv_compl_abort, SLV_CMPABT);
+CPM_EVENT_ATTR(slv_illegal_burst, SLV_ILLBUR);
+CPM_EVENT_ATTR(mst_decerr, MST_DECERR);
+CPM_EVENT_ATTR(mst_slverr, MST_SLVERR);
+CPM_EVENT_ATTR(cfg_pcie_timeout, CFG_PCIE_TIMEOUT);
+CPM_EVENT_ATTR(cfg_err_poison, CFG_ERR_POISON);
+CPM_EVENT_ATTR(slv_pcie_timeout, SLV_PCIE_TIMEOUT);
+
+static struct attribute *xilinx_cpm_pcie_event_attrs[] = {
+	&cpm_event_link_down.attr.attr,
+	&cpm_event_hot_reset.attr.attr,
+	&cpm_event_cfg_timeout.attr.attr,
+	&cpm_event_err_correctable.attr.attr,
+	&cpm_event_err_nonfatal.attr.attr,
+	&cpm_event_err_fatal.attr.attr,
+	&cpm_event_slv_unsupp.attr.attr,
+	&cpm_event_slv_unexp.attr.attr,
+	&cpm_event_slv_compl_timeout.attr.attr,
+	&cpm_event_slv_err_poison.attr.attr,
+	&cpm_event_slv_compl_abort.attr.attr,
+	&cpm_event_slv_illegal_burst.attr.attr,
+	&cpm_event_mst_decerr.attr.attr,
+	&cpm_event_mst_slverr.attr.attr,
+	&cpm_event_cfg_pcie_timeout.attr.attr,
+	&cpm_event_cfg_err_poison.attr.attr,
+	&cpm_event_slv_pcie_timeout.attr.attr,
+	NULL
+};
+
+static const struct attribute_group xilinx_cpm_pcie_event_group = {
+	.name = "events",
+	.attrs = xilinx_cpm_pcie_event_attrs,
+};
+
+static const struct attribute_group *xilinx_cpm_pcie_groups[] = {
+	&xilinx_cpm_pcie_event_group,
+	NULL
+};
+
 static struct platform_driver xilinx_cpm_pcie_driver = {
 	.driver = {
 		.name = "xilinx-cpm-pcie",
 		.of_match_table = xilinx_cpm_pcie_of_match,
 		.suppress_bind_attrs = true,
+		.dev_groups = xilinx_cpm_pcie_groups,
 	},
 	.probe = xilinx_cpm_pcie_probe,
 };
@@ -133,6 +133,8 @@
 #define CFG_PCIE_CACHE			GENMASK(7, 0)
 
 #define INT_PCI_MSI_NR			(2 * 32)
+/* MSI vectors 0 - 31 are signalled on msi0, 32 - 63 on msi1 */
+#define NWL_MSI_BANK_SIZE		32
 
 /* Readin the PS_LINKUP */
 #define PS_LINKUP_OFFSET		0x00000238
@@ -172,6 +174,7 @@ struct nwl_pcie {
 	struct irq_domain *legacy_irq_domain;
 	struct clk *clk;
 	raw_spinlock_t leg_mask_lock;
+	unsigned long events[32];	/* MSGF_MISC_STATUS bit counters */
 };
 
 static inline u32 nwl_bridge_readl(struct nwl_pcie *pcie, u32 off)
@@ -261,7 +264,8 @@ static irqreturn_t nwl_pcie_misc_handler(int irq, void *data)
 {
 	struct nwl_pcie *pcie = data;
 	struct device *dev = pcie->dev;
-	u32 misc_stat;
+	unsigned long misc_stat;
+	unsigned int bit;
 
 	/* Checking for misc interrupts */
 	misc_stat = nwl_bridge_readl(pcie, MSGF_MISC_STATUS) &
@@ -269,6 +273,9 @@ static irqreturn_t nwl_pcie_misc_handler(int irq, void *data)
 	if (!misc_stat)
 		return IRQ_NONE;
 
+	for_each_set_bit(bit, &misc_stat, ARRAY_SIZE(pcie->events))
+		pcie->events[bit]++;
+
 	if (misc_stat & MSGF_MISC_SR_RXMSG_OVER)
 		dev_err(dev, "Received Message FIFO Overflow\n");
 
@@ -291,7 +298,7 @@ static irqreturn_t nwl_pcie_misc_handler(int irq, void *data)
 		dev_err(dev, "Non-Fatal Error in AER Capability\n");
 
 	if (misc_stat & MSGF_MISC_SR_CORR_AER)
-		dev_err(dev, "Correctable Error in AER Capability\n");
+		dev_err_ratelimited(dev, "Correctable Error in AER Capability\n");
 
 	if (misc_stat & MSGF_MISC_SR_UR_DETECT)
 		dev_err(dev, "Unsupported request Detected\n");
@@ -303,10 +310,10 @@ static irqreturn_t nwl_pcie_misc_handler(int irq, void *data)
 		dev_err(dev, "Fatal Error Detected\n");
 
 	if (misc_stat & MSGF_MSIC_SR_LINK_AUTO_BWIDTH)
-		dev_info(dev, "Link Autonomous Bandwidth Management Status bit set\n");
+		dev_info_ratelimited(dev, "Link Autonomous Bandwidth Management Status bit set\n");
 
 	if (misc_stat & MSGF_MSIC_SR_LINK_BWIDTH)
-		dev_info(dev, "Link Bandwidth Management Status bit set\n");
+		dev_info_ratelimited(dev, "Link Bandwidth Management Status bit set\n");
 
 	/* Clear misc interrupt status */
 	nwl_bridge_writel(pcie, misc_stat, MSGF_MISC_STATUS);
@@ -333,17 +340,18 @@ static void nwl_pcie_leg_handler(struct irq_desc *desc)
 	chained_irq_exit(chip, desc);
 }
 
-static void nwl_pcie_handle_msi_irq(struct nwl_pcie *pcie, u32 status_reg)
+static void nwl_pcie_handle_msi_irq(struct nwl_pcie *pcie, u32 status_reg,
+				    irq_hw_number_t base)
 {
 	struct nwl_msi *msi = &pcie->msi;
 	unsigned long status;
 	u32 bit;
 
 	while ((status = nwl_bridge_readl(pcie, status_reg)) != 0) {
-		for_each_set_bit(bit, &status, 32) {
-			nwl_bridge_writel(pcie, 1 << bit, status_reg);
-			generic_handle_domain_irq(msi->dev_domain, bit);
-		}
+		/* Acknowledge the whole batch before handling it */
+		nwl_bridge_writel(pcie, status, status_reg);
+		for_each_set_bit(bit, &status, NWL_MSI_BANK_SIZE)
+			generic_handle_domain_irq(msi->dev_domain, base + bit);
 	}
 }
 
@@ -353,7 +361,7 @@ static void nwl_pcie_msi_handler_high(struct irq_desc *desc)
 	struct nwl_pcie *pcie = irq_desc_get_handler_data(desc);
 
 	chained_irq_enter(chip, desc);
-	nwl_pcie_handle_msi_irq(pcie, MSGF_MSI_STATUS_HI);
+	nwl_pcie_handle_msi_irq(pcie, MSGF_MSI_STATUS_HI, NWL_MSI_BANK_SIZE);
 	chained_irq_exit(chip, desc);
 }
 
@@ -363,7 +371,7 @@ static void nwl_pcie_msi_handler_low(struct irq_desc *desc)
 	struct nwl_pcie *pcie = irq_desc_get_handler_data(desc);
 
 	chained_irq_enter(chip, desc);
-	nwl_pcie_handle_msi_irq(pcie, MSGF_MSI_STATUS_LO);
+	nwl_pcie_handle_msi_irq(pcie, MSGF_MSI_STATUS_LO, 0);
 	chained_irq_exit(chip, desc);
 }
 
@@ -444,10 +452,28 @@ static void nwl_compose_msi_msg(struct irq_data *data, struct msi_msg *msg)
 	msg->data = data->hwirq;
 }
 
+/* The vectors of a bank are demultiplexed on the CPU of its chained IRQ */
+static unsigned int nwl_msi_bank_cpu(struct nwl_msi *msi, unsigned int bank)
+{
+	int irq = bank ? msi->irq_msi1 : msi->irq_msi0;
+
+	return cpumask_first(irq_get_effective_affinity_mask(irq));
+}
+
 static int nwl_msi_set_affinity(struct irq_data *irq_data,
 				const struct cpumask *mask, bool force)
 {
-	return -EINVAL;
+	struct nwl_pcie *pcie = irq_data_get_irq_chip_data(irq_data);
+	unsigned int cpu;
+
+	cpu = nwl_msi_bank_cpu(&pcie->msi,
+			       irq_data->hwirq / NWL_MSI_BANK_SIZE);
+	if (!cpumask_test_cpu(cpu, mask))
+		return -EINVAL;
+
+	irq_data_update_effective_affinity(irq_data, cpumask_of(cpu));
+
+	return IRQ_SET_MASK_OK_DONE;
 }
 
 static struct irq_chip nwl_irq_chip = {
@@ -456,17 +482,58 @@ static struct irq_chip nwl_irq_chip = {
 	.irq_set_affinity = nwl_msi_set_affinity,
 };
 
+/*
+ * Pick the bank handled on a CPU of a managed affinity mask, otherwise
+ * the one with the fewest vectors so that the two banks share the load.
+ */
+static unsigned int nwl_msi_pick_bank(struct nwl_msi *msi, unsigned int virq)
+{
+	struct irq_data *data = irq_get_irq_data(virq);
+	unsigned int bank, lo;
+
+	if (irqd_affinity_is_managed(data)) {
+		for (bank = 0; bank < INT_PCI_MSI_NR / NWL_MSI_BANK_SIZE; bank++)
+			if (cpumask_test_cpu(nwl_msi_bank_cpu(msi, bank),
+					     irq_data_get_affinity_mask(data)))
+				return bank;
+	}
+
+	lo = bitmap_weight(msi->bitmap, NWL_MSI_BANK_SIZE);
+
+	return bitmap_weight(msi->bitmap, INT_PCI_MSI_NR) - lo < lo;
+}
+
+static int nwl_msi_alloc_region(struct nwl_msi *msi, unsigned int bank,
+				unsigned int nr)
+{
+	unsigned long start = bank * NWL_MSI_BANK_SIZE;
+	unsigned long bit;
+
+	bit = bitmap_find_next_zero_area(msi->bitmap,
+					 start + NWL_MSI_BANK_SIZE, start, nr,
+					 nr - 1);
+	if (bit >= start + NWL_MSI_BANK_SIZE)
+		return -ENOSPC;
+
+	bitmap_set(msi->bitmap, bit, nr);
+
+	return bit;
+}
+
 static int nwl_irq_domain_alloc(struct irq_domain *domain, unsigned int virq,
 				unsigned int nr_irqs, void *args)
 {
 	struct nwl_pcie *pcie = domain->host_data;
 	struct nwl_msi *msi = &pcie->msi;
+	unsigned int bank, nr = 1 << get_count_order(nr_irqs);
 	int bit;
 	int i;
 
 	mutex_lock(&msi->lock);
-	bit = bitmap_find_free_region(msi->bitmap, INT_PCI_MSI_NR,
-				      get_count_order(nr_irqs));
+	bank = nwl_msi_pick_bank(msi, virq);
+	bit = nwl_msi_alloc_region(msi, bank, nr);
+	if (bit < 0)
+		bit = nwl_msi_alloc_region(msi, !bank, nr);
 	if (bit < 0) {
 		mutex_unlock(&msi->lock);
 		return -ENOSPC;
@@ -577,6 +644,12 @@ static int nwl_pcie_enable_msi(struct nwl_pcie *pcie)
 	irq_set_chained_handler_and_data(msi->irq_msi0,
 					 nwl_pcie_msi_handler_low, pcie);
 
+	/* Demultiplex the two banks on different CPUs */
+	irq_set_affinity(msi->irq_msi0,
+			 cpumask_of(cpumask_local_spread(0, dev_to_node(dev))));
+	irq_set_affinity(msi->irq_msi1,
+			 cpumask_of(cpumask_local_spread(1, dev_to_node(dev))));
+
 	/* Check for msii_present bit */
 	ret = nwl_bridge_readl(pcie, I_MSII_CAPABILITIES) & MSII_PRESENT;
 	if (!ret) {
@@ -791,6 +864,7 @@ static int nwl_pcie_probe(struct platform_device *pdev)
 		return -ENODEV;
 
 	pcie = pci_host_bridge_priv(bridge);
+	platform_set_drvdata(pdev, pcie);
 
 	pcie->dev = dev;
 	pcie->ecam_value = NWL_ECAM_VALUE_DEFAULT;
@@ -837,11 +911,77 @@ static int nwl_pcie_probe(struct platform_device *pdev)
 	return pci_host_probe(bridge);
 }
 
+/*
+ * Event counters, one per MSGF_MISC_STATUS cause. They are only written by
+ * the misc interrupt handler, so reading them costs nothing on the fast path.
+ */
+static ssize_t nwl_pcie_event_show(struct device *dev,
+				   struct device_attribute *attr, char *buf)
+{
+	struct dev_ext_attribute *ea = container_of(attr,
+						    struct dev_ext_attribute,
+						    attr);
+	struct nwl_pcie *pcie = dev_get_drvdata(dev);
+	unsigned int bit = __ffs((unsigned long)ea->var);
+
+	return sysfs_emit(buf, "%lu\n", READ_ONCE(pcie->events[bit]));
+}
+
+#define NWL_PCIE_EVENT_ATTR(_name, _mask)				\
+	static struct dev_ext_attribute nwl_pcie_event_##_name = {	\
+		__ATTR(_name, 0444, nwl_pcie_event_show, NULL),		\
+		(void *)(_mask)						\
+	}
+
+NWL_PCIE_EVENT_ATTR(rxmsg_overflow, MSGF_MISC_SR_RXMSG_OVER);
+NWL_PCIE_EVENT_ATTR(slave_err, MSGF_MISC_SR_SLAVE_ERR);
+NWL_PCIE_EVENT_ATTR(master_err, MSGF_MISC_SR_MASTER_ERR);
+NWL_PCIE_EVENT_ATTR(ingress_addr_err, MSGF_MISC_SR_I_ADDR_ERR);
+NWL_PCIE_EVENT_ATTR(egress_addr_err, MSGF_MISC_SR_E_ADDR_ERR);
+NWL_PCIE_EVENT_ATTR(aer_fatal, MSGF_MISC_SR_FATAL_AER);
+NWL_PCIE_EVENT_ATTR(aer_nonfatal, MSGF_MISC_SR_NON_FATAL_AER);
+NWL_PCIE_EVENT_ATTR(aer_correctable, MSGF_MISC_SR_CORR_AER);
+NWL_PCIE_EVENT_ATTR(unsupported_req, MSGF_MISC_SR_UR_DETECT);
+NWL_PCIE_EVENT_ATTR(err_nonfatal, MSGF_MISC_SR_NON_FATAL_DEV);
+NWL_PCIE_EVENT_ATTR(err_fatal, MSGF_MISC_SR_FATAL_DEV);
+NWL_PCIE_EVENT_ATTR(link_down, MSGF_MISC_SR_LINK_DOWN);
+NWL_PCIE_EVENT_ATTR(link_auto_bw_change, MSGF_MSIC_SR_LINK_AUTO_BWIDTH);
+NWL_PCIE_EVENT_ATTR(link_bw_change, MSGF_MSIC_SR_LINK_BWIDTH);
+
+static struct attribute *nwl_pcie_event_attrs[] = {
+	&nwl_pcie_event_rxmsg_overflow.attr.attr,
+	&nwl_pcie_event_slave_err.attr.attr,
+	&nwl_pcie_event_master_err.attr.attr,
+	&nwl_pcie_event_ingress_addr_err.attr.attr,
+	&nwl_pcie_event_egress_addr_err.attr.attr,
+	&nwl_pcie_event_aer_fatal.attr.attr,
+	&nwl_pcie_event_aer_nonfatal.attr.attr,
+	&nwl_pcie_event_aer_correctable.attr.attr,
+	&nwl_pcie_event_unsupported_req.attr.attr,
+	&nwl_pcie_event_err_nonfatal.attr.attr,
+	&nwl_pcie_event_err_fatal.attr.attr,
+	&nwl_pcie_event_link_down.attr.attr,
+	&nwl_pcie_event_link_auto_bw_change.attr.attr,
+	&nwl_pcie_event_link_bw_change.attr.attr,
+	NULL
+};
+
+static const struct attribute_group nwl_pcie_event_group = {
+	.name = "events",
+	.attrs = nwl_pcie_event_attrs,
+};
+
+static const struct attribute_group *nwl_pcie_groups[] = {
+	&nwl_pcie_event_group,
+	NULL
+};
+
 static struct platform_driver nwl_pcie_driver = {
 	.driver = {
 		.name = "nwl-pcie",
 		.suppress_bind_attrs = true,
 		.of_match_table = nwl_pcie_of_match,
+		.dev_groups = nwl_pcie_groups,
 	},
 	.probe = nwl_pcie_probe,
 };
@@ -99,6 +99,7 @@
  * @msi_domain: MSI IRQ domain pointer
  * @leg_domain: Legacy IRQ domain pointer
  * @resources: Bus Resources
+ * @events: Number of occurrences of each interrupt decode bit
  */
 struct xilinx_pcie {
 	struct device *dev;
@@ -108,6 +109,7 @@ struct xilinx_pcie {
 	struct irq_domain *msi_domain;
 	struct irq_domain *leg_domain;
 	struct list_head resources;
+	unsigned long events[32];
 };
 
 static inline u32 pcie_read(struct xilinx_pcie *pcie, u32 reg)
@@ -344,7 +346,9 @@ static irqreturn_t xilinx_pcie_intr_handler(int irq, void *data)
 {
 	struct xilinx_pcie *pcie = (struct xilinx_pcie *)data;
 	struct device *dev = pcie->dev;
+	unsigned long events;
 	u32 val, mask, status;
+	unsigned int bit;
 
 	/* Read interrupt decode and mask registers */
 	val = pcie_read(pcie, XILINX_PCIE_REG_IDR);
@@ -354,6 +358,10 @@ static irqreturn_t xilinx_pcie_intr_handler(int irq, void *data)
 	if (!status)
 		return IRQ_NONE;
 
+	events = status & ~(XILINX_PCIE_INTR_INTX | XILINX_PCIE_INTR_MSI);
+	for_each_set_bit(bit, &events, ARRAY_SIZE(pcie->events))
+		pcie->events[bit]++;
+
 	if (status & XILINX_PCIE_INTR_LINK_DOWN)
 		dev_warn(dev, "Link Down\n");
 
@@ -370,7 +378,7 @@ static irqreturn_t xilinx_pcie_intr_handler(int irq, void *data)
 		dev_warn(dev, "ECAM access timeout\n");
 
 	if (status & XILINX_PCIE_INTR_CORRECTABLE) {
-		dev_warn(dev, "Correctable error message\n");
+		dev_warn_ratelimited(dev, "Correctable error message\n");
 		xilinx_pcie_clear_err_interrupts(pcie);
 	}
 
@@ -578,6 +586,7 @@ static int xilinx_pcie_probe(struct platform_device *pdev)
 		return -ENODEV;
 
 	pcie = pci_host_bridge_priv(bridge);
+	platform_set_drvdata(pdev, pcie);
 	mutex_init(&pcie->map_lock);
 	pcie->dev = dev;
 
@@ -610,11 +619,83 @@ static const struct of_device_id xilinx_pcie_of_match[] = {
 	{}
 };
 
+/*
+ * Event counters, one per interrupt decode bit. They are only written by the
+ * interrupt handler and are read without locking.
+ */
+static ssize_t xilinx_pcie_event_show(struct device *dev,
+				      struct device_attribute *attr, char *buf)
+{
+	struct dev_ext_attribute *ea = container_of(attr,
+						    struct dev_ext_attribute,
+						    attr);
+	struct xilinx_pcie *pcie = dev_get_drvdata(dev);
+	unsigned int bit = __ffs((unsigned long)ea->var);
+
+	return sysfs_emit(buf, "%lu\n", READ_ONCE(pcie->events[bit]));
+}
+
+#define XILINX_PCIE_EVENT_ATTR(_name, x)				\
+	static struct dev_ext_attribute xilinx_pcie_event_##_name = {	\
+		__ATTR(_name, 0444, xilinx_pcie_event_show, NULL),	\
+		(void *)XILINX_PCIE_INTR_ ## x				\
+	}
+
+XILINX_PCIE_EVENT_ATTR(link_down, LINK_DOWN);
+XILINX_PCIE_EVENT_ATTR(ecrc_err, ECRC_ERR);
+XILINX_PCIE_EVENT_ATTR(streaming_err, STR_ERR);
+XILINX_PCIE_EVENT_ATTR(hot_reset, HOT_RESET);
+XILINX_PCIE_EVENT_ATTR(cfg_timeout, CFG_TIMEOUT);
+XILINX_PCIE_EVENT_ATTR(err_correctable, CORRECTABLE);
+XILINX_PCIE_EVENT_ATTR(err_nonfatal, NONFATAL);
+XILINX_PCIE_EVENT_ATTR(err_fatal, FATAL);
+XILINX_PCIE_EVENT_ATTR(slv_unsupp, SLV_UNSUPP);
+XILINX_PCIE_EVENT_ATTR(slv_unexp, SLV_UNEXP);
+XILINX_PCIE_EVENT_ATTR(slv_compl_timeout, SLV_COMPL);
+XILINX_PCIE_EVENT_ATTR(slv_err_poison, SLV_ERRP);
+XILINX_PCIE_EVENT_ATTR(slv_compl_abort, SLV_CMPABT);
+XILINX_PCIE_EVENT_ATTR(slv_illegal_burst, SLV_ILLBUR);
+XILINX_PCIE_EVENT_ATTR(mst_decerr, MST_DECERR);
+XILINX_PCIE_EVENT_ATTR(mst_slverr, MST_SLVERR);
+XILINX_PCIE_EVENT_ATTR(mst_err_poison, MST_ERRP);
+
+static struct attribute *xilinx_pcie_event_attrs[] = {
+	&xilinx_pcie_event_link_down.attr.attr,
+	&xilinx_pcie_event_ecrc_err.attr.attr,
+	&xilinx_pcie_event_streaming_err.attr.attr,
+	&xilinx_pcie_event_hot_reset.attr.attr,
+	&xilinx_pcie_event_cfg_timeout.attr.attr,
+	&xilinx_pcie_event_err_correctable.attr.attr,
+	&xilinx_pcie_event_err_nonfatal.attr.attr,
+	&xilinx_pcie_event_err_fatal.attr.attr,
+	&xilinx_pcie_event_slv_unsupp.attr.attr,
+	&xilinx_pcie_event_slv_unexp.attr.attr,
+	&xilinx_pcie_event_slv_compl_timeout.attr.attr,
+	&xilinx_pcie_event_slv_err_poison.attr.attr,
+	&xilinx_pcie_event_slv_compl_abort.attr.attr,
+	&xilinx_pcie_event_slv_illegal_burst.attr.attr,
+	&xilinx_pcie_event_mst_decerr.attr.attr,
+	&xilinx_pcie_event_mst_slverr.attr.attr,
+	&xilinx_pcie_event_mst_err_poison.attr.attr,
+	NULL
+};
+
+static const struct attribute_group xilinx_pcie_event_group = {
+	.name = "events",
+	.attrs = xilinx_pcie_event_attrs,
+};
+
+static const struct attribute_group *xilinx_pcie_groups[] = {
+	&xilinx_pcie_event_group,
+	NULL
+};
+
 static struct platform_driver xilinx_pcie_driver = {
 	.driver = {
 		.name = "xilinx-pcie",
 		.of_match_table = xilinx_pcie_of_match,
 		.suppress_bind_attrs = true,
+		.dev_groups = xilinx_pcie_groups,
 	},
 	.probe = xilinx_pcie_probe,
 };
@@ -0,0 +1,548 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Xilinx AXI Performance Monitor PMU driver
+ *
+ * Copyright (C) 2023 Xilinx, Inc.
+ *
+ * Exposes the metric counters of an AXI Performance Monitor in advanced
+ * mode as perf events. Each event counts one metric of one monitor slot,
+ * the global clock counter is available as a fixed event. The counters
+ * have no overflow interrupt usable by perf, so they are polled often
+ * enough to never lose a wrap around.
+ */
+
+#include <linux/bitfield.h>
+#include <linux/bitops.h>
+#include <linux/clk.h>
+#include <linux/cpuhotplug.h>
+#include <linux/hrtimer.h>
+#include <linux/io.h>
+#include <linux/module.h>
+#include <linux/of.h>
+#include <linux/perf_event.h>
+#include <linux/platform_device.h>
+
+#define DRV_NAME		"xilinx-apm-pmu"
+
+#define XAPM_GCC_HIGH_OFFSET	0x0000	/* Global Clock Counter MSW */
+#define XAPM_GCC_LOW_OFFSET	0x0004	/* Global Clock Counter LSW */
+#define XAPM_MSR_OFFSET(n)	(0x0044 + ((n) / 4) * 4) /* Metric Selector */
+#define XAPM_MC_OFFSET(n)	(0x0100 + (n) * 0x10) /* Metric Counter */
+#define XAPM_CTL_OFFSET		0x0300	/* Control Register */
+
+#define XAPM_CR_MCNTR_ENABLE	BIT(0)
+#define XAPM_CR_MCNTR_RESET	BIT(1)
+#define XAPM_CR_GCC_ENABLE	BIT(16)
+#define XAPM_CR_GCC_RESET	BIT(17)
+
+#define XAPM_MSR_METRIC		GENMASK(4, 0)
+#define XAPM_MSR_SLOT		GENMASK(7, 5)
+#define XAPM_MSR_SHIFT(n)	(((n) % 4) * 8)
+
+#define XAPM_MAX_COUNTERS	10
+#define XAPM_MAX_SLOTS		8
+#define XAPM_MODE_ADVANCED	1
+
+/* Metrics which accumulate, the min/max latencies don't make sense here */
+#define XAPM_METRIC_MAX		11
+
+/* Global clock counter, outside of the metric selector encoding */
+#define XAPM_EVENT_GCC		BIT(8)
+#define XAPM_GCC_IDX		XAPM_MAX_COUNTERS
+
+#define XAPM_CONFIG_METRIC	GENMASK(4, 0)
+#define XAPM_CONFIG_SLOT	GENMASK(7, 5)
+
+/*
+ * A 32-bit byte counter on a 128-bit port at 300MHz wraps in about 0.9s,
+ * poll well within that.
+ */
+static unsigned int xapm_poll_period_ms = 100;
+module_param_named(poll_period_ms, xapm_poll_period_ms, uint, 0644);
+MODULE_PARM_DESC(poll_period_ms, "Counter polling period in milliseconds");
+
+/**
+ * struct xapm_pmu - AXI Performance Monitor PMU
+ * @pmu: perf PMU
+ * @base: IOmapped base address
+ * @dev: device
+ * @cpu: CPU which owns the events
+ * @node: CPU hotplug node
+ * @hrtimer: counter polling timer
+ * @events: events of the metric counters and the global clock counter
+ * @active_events: number of events added
+ * @num_counters: number of metric counters
+ * @num_slots: number of monitor slots
+ * @gcc_mask: mask of the global clock counter width
+ */
+struct xapm_pmu {
+	struct pmu pmu;
+	void __iomem *base;
+	struct device *dev;
+	unsigned int cpu;
+	struct hlist_node node;
+	struct hrtimer hrtimer;
+	struct perf_event *events[XAPM_MAX_COUNTERS + 1];
+	int active_events;
+	u32 num_counters;
+	u32 num_slots;
+	u64 gcc_mask;
+};
+
+#define to_xapm_pmu(p)	container_of(p, struct xapm_pmu, pmu)
+
+static enum cpuhp_state xapm_cpuhp_state;
+
+PMU_EVENT_ATTR_STRING(write_txn, xapm_write_txn, "metric=0x00");
+PMU_EVENT_ATTR_STRING(read_txn, xapm_read_txn, "metric=0x01");
+PMU_EVENT_ATTR_STRING(write_bytes, xapm_write_bytes, "metric=0x02");
+PMU_EVENT_ATTR_STRING(read_bytes, xapm_read_bytes, "metric=0x03");
+PMU_EVENT_ATTR_STRING(write_beats, xapm_write_beats, "metric=0x04");
+PMU_EVENT_ATTR_STRING(read_latency, xapm_read_latency, "metric=0x05");
+PMU_EVENT_ATTR_STRING(write_latency, xapm_write_latency, "metric=0x06");
+PMU_EVENT_ATTR_STRING(slv_wr_idle, xapm_slv_wr_idle, "metric=0x07");
+PMU_EVENT_ATTR_STRING(mst_rd_idle, xapm_mst_rd_idle, "metric=0x08");
+PMU_EVENT_ATTR_STRING(bvalids, xapm_bvalids, "metric=0x09");
+PMU_EVENT_ATTR_STRING(wlasts, xapm_wlasts, "metric=0x0a");
+PMU_EVENT_ATTR_STRING(rlasts, xapm_rlasts, "metric=0x0b");
+PMU_EVENT_ATTR_STRING(clk, xapm_clk, "config=0x100");
+
+static struct attribute *xapm_pmu_events_attrs[] = {
+	&xapm_write_txn.attr.attr,
+	&xapm_read_txn.attr.attr,
+	&xapm_write_bytes.attr.attr,
+	&xapm_read_bytes.attr.attr,
+	&xapm_write_beats.attr.attr,
+	&xapm_read_latency.attr.attr,
+	&xapm_write_latency.attr.attr,
+	&xapm_slv_wr_idle.attr.attr,
+	&xapm_mst_rd_idle.attr.attr,
+	&xapm_bvalids.attr.attr,
+	&xapm_wlasts.attr.attr,
+	&xapm_rlasts.attr.attr,
+	&xapm_clk.attr.attr,
+	NULL,
+};
+
+static const struct attribute_group xapm_pmu_events_attr_group = {
+	.name = "events",
+	.attrs = xapm_pmu_events_attrs,
+};
+
+PMU_FORMAT_ATTR(metric, "config:0-4");
+PMU_FORMAT_ATTR(slot, "config:5-7");
+
+static struct attribute *xapm_pmu_format_attrs[] = {
+	&format_attr_metric.attr,
+	&format_attr_slot.attr,
+	NULL,
+};
+
+static const struct attribute_group xapm_pmu_format_attr_group = {
+	.name = "format",
+	.attrs = xapm_pmu_format_attrs,
+};
+
+static ssize_t xapm_pmu_cpumask_show(struct device *dev,
+				     struct device_attribute *attr, char *buf)
+{
+	struct xapm_pmu *apm = to_xapm_pmu(dev_get_drvdata(dev));
+
+	return cpumap_print_to_pagebuf(true, buf, cpumask_of(apm->cpu));
+}
+
+static struct device_attribute xapm_pmu_cpumask_attr =
+	__ATTR(cpumask, 0444, xapm_pmu_cpumask_show, NULL);
+
+static struct attribute *xapm_pmu_cpumask_attrs[] = {
+	&xapm_pmu_cpumask_attr.attr,
+	NULL,
+};
+
+static const struct attribute_group xapm_pmu_cpumask_attr_group = {
+	.attrs = xapm_pmu_cpumask_attrs,
+};
+
+static const struct attribute_group *xapm_pmu_attr_groups[] = {
+	&xapm_pmu_events_attr_group,
+	&xapm_pmu_format_attr_group,
+	&xapm_pmu_cpumask_attr_group,
+	NULL,
+};
+
+static ktime_t xapm_pmu_timer_period(void)
+{
+	return ms_to_ktime(max(xapm_poll_period_ms, 1U));
+}
+
+static u64 xapm_pmu_read_counter(struct xapm_pmu *apm, int idx)
+{
+	u32 hi, lo;
+
+	if (idx != XAPM_GCC_IDX)
+		return readl(apm->base + XAPM_MC_OFFSET(idx));
+
+	do {
+		hi = readl(apm->base + XAPM_GCC_HIGH_OFFSET);
+		lo = readl(apm->base + XAPM_GCC_LOW_OFFSET);
+	} while (hi != readl(apm->base + XAPM_GCC_HIGH_OFFSET));
+
+	return ((u64)hi << 32 | lo) & apm->gcc_mask;
+}
+
+static void xapm_pmu_event_update(struct perf_event *event)
+{
+	struct xapm_pmu *apm = to_xapm_pmu(event->pmu);
+	struct hw_perf_event *hwc = &event->hw;
+	u64 prev_count, new_count, mask;
+
+	mask = hwc->idx == XAPM_GCC_IDX ? apm->gcc_mask : U32_MAX;
+
+	do {
+		prev_count = local64_read(&hwc->prev_count);
+		new_count = xapm_pmu_read_counter(apm, hwc->idx);
+	} while (local64_xchg(&hwc->prev_count, new_count) != prev_count);
+
+	local64_add((new_count - prev_count) & mask, &event->count);
+}
+
+static void xapm_pmu_group_count(struct perf_event *member,
+				 struct perf_event *event,
+				 int *counters, int *clocks)
+{
+	if (member->pmu != event->pmu)
+		return;
+
+	if (member->attr.config == XAPM_EVENT_GCC)
+		(*clocks)++;
+	else
+		(*counters)++;
+}
+
+static int xapm_pmu_event_init(struct perf_event *event)
+{
+	struct xapm_pmu *apm = to_xapm_pmu(event->pmu);
+	struct hw_perf_event *hwc = &event->hw;
+	u64 config = event->attr.config;
+	struct perf_event *sibling;
+	int counters = 0, clocks = 0;
+
+	if (event->attr.type != event->pmu->type)
+		return -ENOENT;
+
+	if (is_sampling_event(event) || event->attach_state & PERF_ATTACH_TASK)
+		return -EOPNOTSUPP;
+
+	if (event->cpu < 0)
+		return -EINVAL;
+
+	if (config != XAPM_EVENT_GCC &&
+	    (config & ~(XAPM_CONFIG_METRIC | XAPM_CONFIG_SLOT) ||
+	     FIELD_GET(XAPM_CONFIG_METRIC, config) > XAPM_METRIC_MAX ||
+	     FIELD_GET(XAPM_CONFIG_SLOT, config) >= apm->num_slots))
+		return -EINVAL;
+
+	/* We must NOT create groups containing mixed PMUs */
+	if (event->group_leader->pmu != event->pmu &&
+	    !is_software_event(event->group_leader))
+		return -EINVAL;
+
+	for_each_sibling_event(sibling, event->group_leader) {
+		if (sibling->pmu != event->pmu &&
+		    !is_software_event(sibling))
+			return -EINVAL;
+	}
+
+	xapm_pmu_group_count(event->group_leader, event, &counters, &clocks);
+	for_each_sibling_event(sibling, event->group_leader)
+		xapm_pmu_group_count(sibling, event, &counters, &clocks);
+	if (event->group_leader != event)
+		xapm_pmu_group_count(event, event, &counters, &clocks);
+
+	/* A group has to fit in the metric counters and the clock counter */
+	if (counters > apm->num_counters || clocks > 1)
+		return -EINVAL;
+
+	event->cpu = apm->cpu;
+	hwc->idx = -1;
+
+	return 0;
+}
+
+static void xapm_pmu_event_start(struct perf_event *event, int flags)
+{
+	struct xapm_pmu *apm = to_xapm_pmu(event->pmu);
+	struct hw_perf_event *hwc = &event->hw;
+
+	/* The counters run freely, just take a new reference point */
+	local64_set(&hwc->prev_count, xapm_pmu_read_counter(apm, hwc->idx));
+	hwc->state = 0;
+}
+
+static void xapm_pmu_event_stop(struct perf_event *event, int flags)
+{
+	struct hw_perf_event *hwc = &event->hw;
+
+	if (hwc->state & PERF_HES_STOPPED)
+		return;
+
+	xapm_pmu_event_update(event);
+	hwc->state |= PERF_HES_STOPPED | PERF_HES_UPTODATE;
+}
+
+static void xapm_pmu_select_metric(struct xapm_pmu *apm, int idx, u64 config)
+{
+	u32 sel, msr;
+
+	sel = FIELD_PREP(XAPM_MSR_METRIC, FIELD_GET(XAPM_CONFIG_METRIC, config)) |
+	      FIELD_PREP(XAPM_MSR_SLOT, FIELD_GET(XAPM_CONFIG_SLOT, config));
+
+	msr = readl(apm->base + XAPM_MSR_OFFSET(idx));
+	msr &= ~(0xff << XAPM_MSR_SHIFT(idx));
+	msr |= sel << XAPM_MSR_SHIFT(idx);
+	writel(msr, apm->base + XAPM_MSR_OFFSET(idx));
+}
+
+static int xapm_pmu_event_add(struct perf_event *event, int flags)
+{
+	struct xapm_pmu *apm = to_xapm_pmu(event->pmu);
+	struct hw_perf_event *hwc = &event->hw;
+	int idx;
+
+	if (event->attr.config == XAPM_EVENT_GCC) {
+		idx = XAPM_GCC_IDX;
+		if (apm->events[idx])
+			return -EAGAIN;
+	} else {
+		for (idx = 0; idx < apm->num_counters; idx++)
+			if (!apm->events[idx])
+				break;
+		if (idx == apm->num_counters)
+			return -EAGAIN;
+
+		xapm_pmu_select_metric(apm, idx, event->attr.config);
+	}
+
+	apm->events[idx] = event;
+	hwc->idx = idx;
+	hwc->state = PERF_HES_STOPPED | PERF_HES_UPTODATE;
+
+	if (apm->active_events++ == 0)
+		hrtimer_start(&apm->hrtimer, xapm_pmu_timer_period(),
+			      HRTIMER_MODE_REL_PINNED);
+
+	if (flags & PERF_EF_START)
+		xapm_pmu_event_start(event, flags);
+
+	return 0;
+}
+
+static void xapm_pmu_event_del(struct perf_event *event, int flags)
+{
+	struct xapm_pmu *apm = to_xapm_pmu(event->pmu);
+	struct hw_perf_event *hwc = &event->hw;
+
+	xapm_pmu_event_stop(event, PERF_EF_UPDATE);
+
+	apm->events[hwc->idx] = NULL;
+	hwc->idx = -1;
+
+	if (--apm->active_events == 0)
+		hrtimer_cancel(&apm->hrtimer);
+}
+
+static enum hrtimer_restart xapm_pmu_timer_handler(struct hrtimer *hrtimer)
+{
+	struct xapm_pmu *apm = container_of(hrtimer, struct xapm_pmu, hrtimer);
+	unsigned long flags;
+	int i;
+
+	local_irq_save(flags);
+	for (i = 0; i <= XAPM_GCC_IDX; i++) {
+		struct perf_event *event = apm->events[i];
+
+		if (event && !(event->hw.state & PERF_HES_STOPPED))
+			xapm_pmu_event_update(event);
+	}
+	local_irq_restore(flags);
+
+	hrtimer_forward_now(hrtimer, xapm_pmu_timer_period());
+
+	return HRTIMER_RESTART;
+}
+
+static int xapm_pmu_offline_cpu(unsigned int cpu, struct hlist_node *node)
+{
+	struct xapm_pmu *apm = hlist_entry_safe(node, struct xapm_pmu, node);
+	unsigned int target;
+
+	if (cpu != apm->cpu)
+		return 0;
+
+	target = cpumask_any_but(cpu_online_mask, cpu);
+	if (target >= nr_cpu_ids)
+		return 0;
+
+	perf_pmu_migrate_context(&apm->pmu, cpu, target);
+	apm->cpu = target;
+
+	return 0;
+}
+
+static int xapm_pmu_probe(struct platform_device *pdev)
+{
+	struct device_node *node = pdev->dev.of_node;
+	u32 mode = 0, width = 64;
+	struct xapm_pmu *apm;
+	struct resource *res;
+	struct clk *clk;
+	char *name;
+	int ret;
+
+	apm = devm_kzalloc(&pdev->dev, sizeof(*apm), GFP_KERNEL);
+	if (!apm)
+		return -ENOMEM;
+
+	apm->dev = &pdev->dev;
+	platform_set_drvdata(pdev, apm);
+
+	apm->base = devm_platform_get_and_ioremap_resource(pdev, 0, &res);
+	if (IS_ERR(apm->base))
+		return PTR_ERR(apm->base);
+
+	clk = devm_clk_get_enabled(&pdev->dev, NULL);
+	if (IS_ERR(clk))
+		return dev_err_probe(&pdev->dev, PTR_ERR(clk),
+				     "axi clock error\n");
+
+	/* Profile and trace modes have no selectable metric counters */
+	of_property_read_u32(node, "xlnx,enable-profile", &mode);
+	if (!mode)
+		of_property_read_u32(node, "xlnx,enable-trace", &mode);
+	if (mode) {
+		dev_err(&pdev->dev, "only advanced mode is supported\n");
+		return -ENODEV;
+	}
+
+	ret = of_property_read_u32(node, "xlnx,num-monitor-slots",
+				   &apm->num_slots);
+	if (ret < 0) {
+		dev_err(&pdev->dev, "no property xlnx,num-monitor-slots\n");
+		return ret;
+	}
+
+	ret = of_property_read_u32(node, "xlnx,num-of-counters",
+				   &apm->num_counters);
+	if (ret < 0) {
+		dev_err(&pdev->dev, "no property xlnx,num-of-counters\n");
+		return ret;
+	}
+
+	apm->num_slots = min_t(u32, apm->num_slots, XAPM_MAX_SLOTS);
+	apm->num_counters = min_t(u32, apm->num_counters, XAPM_MAX_COUNTERS);
+
+	of_property_read_u32(node, "xlnx,global-count-width", &width);
+	apm->gcc_mask = width < 64 ? GENMASK_ULL(width - 1, 0) : U64_MAX;
+
+	/* Start from a clean state and let everything run freely */
+	writel(XAPM_CR_MCNTR_RESET | XAPM_CR_GCC_RESET,
+	       apm->base + XAPM_CTL_OFFSET);
+	writel(XAPM_CR_MCNTR_ENABLE | XAPM_CR_GCC_ENABLE,
+	       apm->base + XAPM_CTL_OFFSET);
+
+	apm->pmu = (struct pmu) {
+		.module		= THIS_MODULE,
+		.capabilities	= PERF_PMU_CAP_NO_EXCLUDE,
+		.task_ctx_nr	= perf_invalid_context,
+		.attr_groups	= xapm_pmu_attr_groups,
+		.event_init	= xapm_pmu_event_init,
+		.add		= xapm_pmu_event_add,
+		.del		= xapm_pmu_event_del,
+		.start		= xapm_pmu_event_start,
+		.stop		= xapm_pmu_event_stop,
+		.read		= xapm_pmu_event_update,
+	};
+
+	apm->cpu = raw_smp_processor_id();
+
+	name = devm_kasprintf(&pdev->dev, GFP_KERNEL, "xilinx_apm_%llx",
+			      (u64)res->start);
+	if (!name)
+		return -ENOMEM;
+
+	hrtimer_init(&apm->hrtimer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+	apm->hrtimer.function = xapm_pmu_timer_handler;
+
+	ret = cpuhp_state_add_instance_nocalls(xapm_cpuhp_state, &apm->node);
+	if (ret)
+		goto err_disable;
+
+	ret = perf_pmu_register(&apm->pmu, name, -1);
+	if (ret)
+		goto err_cpuhp;
+
+	return 0;
+
+err_cpuhp:
+	cpuhp_state_remove_instance_nocalls(xapm_cpuhp_state, &apm->node);
+err_disable:
+	writel(0, apm->base + XAPM_CTL_OFFSET);
+	return ret;
+}
+
+static int xapm_pmu_remove(struct platform_device *pdev)
+{
+	struct xapm_pmu *apm = platform_get_drvdata(pdev);
+
+	perf_pmu_unregister(&apm->pmu);
+	cpuhp_state_remove_instance_nocalls(xapm_cpuhp_state, &apm->node);
+	writel(0, apm->base + XAPM_CTL_OFFSET);
+
+	return 0;
+}
+
+static const struct of_device_id xapm_pmu_of_match[] = {
+	{ .compatible = "xlnx,axi-perf-monitor", },
+	{ /* end of table */ }
+};
+MODULE_DEVICE_TABLE(of, xapm_pmu_of_match);
+
+static struct platform_driver xapm_pmu_driver = {
+	.driver = {
+		.name = DRV_NAME,
+		.of_match_table = xapm_pmu_of_match,
+		.suppress_bind_attrs = true,
+	},
+	.probe = xapm_pmu_probe,
+	.remove = xapm_pmu_remove,
+};
+
+static int __init xapm_pmu_init(void)
+{
+	int ret;
+
+	ret = cpuhp_setup_state_multi(CPUHP_AP_ONLINE_DYN, "perf/xilinx/apm:online",
+				      NULL, xapm_pmu_offline_cpu);
+	if (ret < 0)
+		return ret;
+	xapm_cpuhp_state = ret;
+
+	ret = platform_driver_register(&xapm_pmu_driver);
+	if (ret)
+		cpuhp_remove_multi_state(xapm_cpuhp_state);
+
+	return ret;
+}
+
+static void __exit xapm_pmu_exit(void)
+{
+	platform_driver_unregister(&xapm_pmu_driver);
+	cpuhp_remove_multi_state(xapm_cpuhp_state);
+}
+
+module_init(xapm_pmu_init);
+module_exit(xapm_pmu_exit);
+
+MODULE_AUTHOR("Xilinx Inc.");
+MODULE_DESCRIPTION("Xilinx AXI Performance Monitor PMU driver");
+MODULE_LICENSE("GPL");
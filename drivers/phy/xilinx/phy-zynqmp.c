@@ -190,6 +190,8 @@ struct xpsgtr_ssc {
  * @skip_phy_init: skip phy_init() if true
  * @dev: pointer to the xpsgtr_dev instance
  * @refclk: reference clock index
+ * @cfg_ssc: settings the lane PLL is programmed with, NULL if none
+ * @cfg_protocol: protocol the lane is programmed for
  */
 struct xpsgtr_phy {
 	struct phy *phy;
@@ -199,6 +201,8 @@ struct xpsgtr_phy {
 	bool skip_phy_init;
 	struct xpsgtr_dev *dev;
 	unsigned int refclk;
+	const struct xpsgtr_ssc *cfg_ssc;
+	u8 cfg_protocol;
 };
 
 /**
@@ -211,6 +215,9 @@ struct xpsgtr_phy {
  * @refclk_sscs: spread spectrum settings for the reference clocks
  * @clk: reference clocks
  * @tx_term_fix: fix for GT issue
+ * @tx_term_done: the fix is applied to the GT
+ * @tx_term_calibrated: @tx_term_nsw holds the result of the fix calibration
+ * @tx_term_nsw: NMOS calibration code found by the fix
  * @saved_icm_cfg0: stored value of ICM CFG0 register
  * @saved_icm_cfg1: stored value of ICM CFG1 register
  */
@@ -223,6 +230,9 @@ struct xpsgtr_dev {
 	const struct xpsgtr_ssc *refclk_sscs[NUM_LANES];
 	struct clk *clk[NUM_LANES];
 	bool tx_term_fix;
+	bool tx_term_done;
+	bool tx_term_calibrated;
+	u32 tx_term_nsw;
 	unsigned int saved_icm_cfg0;
 	unsigned int saved_icm_cfg1;
 };
@@ -496,10 +506,31 @@ static bool xpsgtr_phy_init_required(struct xpsgtr_phy *gtr_phy)
 		return true;
 }
 
+/* Override the NMOS calibration code of the TX termination. */
+static void xpsgtr_phy_tx_term_set_nsw(struct xpsgtr_dev *gtr_dev, u32 nsw)
+{
+	/* Set Test Mode reset */
+	xpsgtr_clr_set(gtr_dev, TM_CMN_RST, TM_CMN_RST_MASK, TM_CMN_RST_EN);
+
+	/* Writing NMOS register values back [5:3] */
+	xpsgtr_write(gtr_dev, L3_TM_CALIB_DIG19, nsw >> L3_NSW_CALIB_SHIFT);
+
+	/* Writing NMOS register value [2:0] */
+	xpsgtr_write(gtr_dev, L3_TM_CALIB_DIG18,
+		     ((nsw & L3_TM_CALIB_DIG19_NSW) << L3_NSW_SHIFT) |
+		     (1 << L3_NSW_PIPE_SHIFT));
+
+	/* Clear Test Mode reset */
+	xpsgtr_clr_set(gtr_dev, TM_CMN_RST, TM_CMN_RST_MASK, TM_CMN_RST_SET);
+}
+
 /*
  * There is a functional issue in the GT. The TX termination resistance can be
  * out of spec due to a issue in the calibration logic. This is the workaround
  * to fix it, required for XCZU9EG silicon.
+ *
+ * The calibration only runs once, the code it finds is written back when the
+ * GT lost it with the FPD power.
  */
 static int xpsgtr_phy_tx_term_fix(struct xpsgtr_phy *gtr_phy)
 {
@@ -510,6 +541,11 @@ static int xpsgtr_phy_tx_term_fix(struct xpsgtr_phy *gtr_phy)
 	/* Enabling Test Mode control for CMN Rest */
 	xpsgtr_clr_set(gtr_dev, TM_CMN_RST, TM_CMN_RST_MASK, TM_CMN_RST_SET);
 
+	if (gtr_dev->tx_term_calibrated) {
+		xpsgtr_phy_tx_term_set_nsw(gtr_dev, gtr_dev->tx_term_nsw);
+		return 0;
+	}
+
 	/* Set Test Mode reset */
 	xpsgtr_clr_set(gtr_dev, TM_CMN_RST, TM_CMN_RST_MASK, TM_CMN_RST_EN);
 
@@ -546,28 +582,44 @@ static int xpsgtr_phy_tx_term_fix(struct xpsgtr_phy *gtr_phy)
 
 	/* Reading NMOS Register Code */
 	nsw = xpsgtr_read(gtr_dev, L0_TXPMA_ST_3) & L0_DN_CALIB_CODE;
+	gtr_dev->tx_term_nsw = nsw;
+	gtr_dev->tx_term_calibrated = true;
 
-	/* Set Test Mode reset */
-	xpsgtr_clr_set(gtr_dev, TM_CMN_RST, TM_CMN_RST_MASK, TM_CMN_RST_EN);
+	xpsgtr_phy_tx_term_set_nsw(gtr_dev, nsw);
 
-	/* Writing NMOS register values back [5:3] */
-	xpsgtr_write(gtr_dev, L3_TM_CALIB_DIG19, nsw >> L3_NSW_CALIB_SHIFT);
+	return 0;
+}
 
-	/* Writing NMOS register value [2:0] */
-	xpsgtr_write(gtr_dev, L3_TM_CALIB_DIG18,
-		     ((nsw & L3_TM_CALIB_DIG19_NSW) << L3_NSW_SHIFT) |
-		     (1 << L3_NSW_PIPE_SHIFT));
+/* Get the SSC settings for the current rate of the lane reference clock. */
+static const struct xpsgtr_ssc *xpsgtr_phy_get_ssc(struct xpsgtr_phy *gtr_phy)
+{
+	struct xpsgtr_dev *gtr_dev = gtr_phy->dev;
+	const struct xpsgtr_ssc *ssc = gtr_dev->refclk_sscs[gtr_phy->refclk];
+	unsigned long rate;
+	unsigned int i;
 
-	/* Clear Test Mode reset */
-	xpsgtr_clr_set(gtr_dev, TM_CMN_RST, TM_CMN_RST_MASK, TM_CMN_RST_SET);
+	rate = clk_get_rate(gtr_dev->clk[gtr_phy->refclk]);
+	if (rate == ssc->refclk_rate)
+		return ssc;
 
-	return 0;
+	for (i = 0; i < ARRAY_SIZE(ssc_lookup); i++) {
+		if (rate == ssc_lookup[i].refclk_rate) {
+			gtr_dev->refclk_sscs[gtr_phy->refclk] = &ssc_lookup[i];
+			return &ssc_lookup[i];
+		}
+	}
+
+	dev_err(gtr_dev->dev, "Invalid rate %lu for reference clock %u\n",
+		rate, gtr_phy->refclk);
+
+	return NULL;
 }
 
 static int xpsgtr_phy_init(struct phy *phy)
 {
 	struct xpsgtr_phy *gtr_phy = phy_get_drvdata(phy);
 	struct xpsgtr_dev *gtr_dev = gtr_phy->dev;
+	const struct xpsgtr_ssc *ssc;
 	int ret = 0;
 
 	mutex_lock(&gtr_dev->gtr_mutex);
@@ -580,14 +632,29 @@ static int xpsgtr_phy_init(struct phy *phy)
 	if (!xpsgtr_phy_init_required(gtr_phy))
 		goto out;
 
-	if (gtr_dev->tx_term_fix) {
+	if (gtr_dev->tx_term_fix && !gtr_dev->tx_term_done) {
 		ret = xpsgtr_phy_tx_term_fix(gtr_phy);
 		if (ret < 0)
 			goto out;
 
-		gtr_dev->tx_term_fix = false;
+		gtr_dev->tx_term_done = true;
+	}
+
+	ssc = xpsgtr_phy_get_ssc(gtr_phy);
+	if (!ssc) {
+		ret = -EINVAL;
+		goto out;
 	}
 
+	/*
+	 * The lane keeps its settings while the FPD is powered. Only program
+	 * it again for another protocol or reference clock rate, reprogramming
+	 * the PLL would make it lock from scratch.
+	 */
+	if (gtr_phy->cfg_ssc == ssc &&
+	    gtr_phy->cfg_protocol == gtr_phy->protocol)
+		goto out;
+
 	/* Enable coarse code saturation limiting logic. */
 	xpsgtr_write_phy(gtr_phy, L0_TM_PLL_DIG_37, L0_TM_COARSE_CODE_LIMIT);
 
@@ -612,6 +679,9 @@ static int xpsgtr_phy_init(struct phy *phy)
 		break;
 	}
 
+	gtr_phy->cfg_ssc = ssc;
+	gtr_phy->cfg_protocol = gtr_phy->protocol;
+
 out:
 	mutex_unlock(&gtr_dev->gtr_mutex);
 	return ret;
@@ -861,9 +931,19 @@ static int __maybe_unused xpsgtr_resume(struct device *dev)
 	else
 		skip_phy_init = false;
 
-	/* Update the skip_phy_init for all gtr_phy instances. */
-	for (i = 0; i < ARRAY_SIZE(gtr_dev->phys); i++)
+	/*
+	 * Update the skip_phy_init for all gtr_phy instances. If the FPD was
+	 * powered off, the lanes and the TX termination fix are programmed
+	 * again.
+	 */
+	for (i = 0; i < ARRAY_SIZE(gtr_dev->phys); i++) {
 		gtr_dev->phys[i].skip_phy_init = skip_phy_init;
+		if (!skip_phy_init)
+			gtr_dev->phys[i].cfg_ssc = NULL;
+	}
+
+	if (!skip_phy_init)
+		gtr_dev->tx_term_done = false;
 
 	return 0;
 }
@@ -121,6 +121,8 @@
 
 /* linerate ranges */
 #define XHDMIPHY_LRATE_3400			3400
+#define XHDMIPHY_PLL_CACHE_SIZE			8
+#define XHDMIPHY_MMCM_CACHE_SIZE		8
 
 /* pll operating ranges */
 #define XHDMIPHY_QPLL0_MIN			9800000000LL
@@ -943,6 +945,40 @@ struct xhdmiphy_mmcm {
 	u16 clkout2_div;
 };
 
+/*
+ * Previously calculated GT PLL divider solution, the search is skipped when
+ * the same line rate is requested again from the same PLL input frequency.
+ */
+struct xhdmiphy_pll_sol {
+	u64 linerate;
+	u32 refclk;
+	u8 chid;
+	u8 m;
+	u8 n1;
+	u8 n2;
+	u8 d;
+	u8 found;
+	u8 valid;
+};
+
+/* Previously calculated MMCM divider solution and the inputs it was for */
+struct xhdmiphy_mmcm_sol {
+	u64 linerate;
+	u32 refclk;
+	u8 dir;
+	u8 ppc;
+	u8 bpc;
+	u8 samplerate;
+	u8 tmdsclock_ratio;
+	u8 found;
+	u8 valid;
+	u16 clkfbout_mult;
+	u16 divclk_divide;
+	u16 clkout0_div;
+	u16 clkout1_div;
+	u16 clkout2_div;
+};
+
 struct quad {
 	union {
 		struct {
@@ -1046,6 +1082,10 @@ struct xhdmiphy_dev {
 	u8 rx_dru_enabled;
 	u8 qpll_present;
 	u8 phy_ready;
+	struct xhdmiphy_pll_sol pll_cache[XHDMIPHY_PLL_CACHE_SIZE];
+	struct xhdmiphy_mmcm_sol mmcm_cache[XHDMIPHY_MMCM_CACHE_SIZE];
+	u8 pll_cache_next;
+	u8 mmcm_cache_next;
 };
 
 void xhdmiphy_set_clr(struct xhdmiphy_dev *inst, u32 addr, u32 reg_val,
@@ -1036,6 +1036,62 @@ u64 xhdmiphy_get_pll_vco_freq(struct xhdmiphy_dev *inst, enum chid chid,
 	return pll_vco_rate;
 }
 
+/**
+ * xhdmiphy_pll_cache_find - This function looks up a previously calculated
+ * PLL divider solution.
+ *
+ * @inst:	inst is a pointer to the xhdmiphy core instance
+ * @chid:	chid is the channel ID of the PLL, all CPLLs share solutions
+ * @refclk:	refclk is the PLL input frequency
+ * @linerate:	linerate is the requested line rate
+ *
+ * @return:	the cached solution, NULL if there is none
+ */
+static struct xhdmiphy_pll_sol *
+xhdmiphy_pll_cache_find(struct xhdmiphy_dev *inst, enum chid chid, u32 refclk,
+			u64 linerate)
+{
+	struct xhdmiphy_pll_sol *sol;
+	u8 i;
+
+	for (i = 0; i < XHDMIPHY_PLL_CACHE_SIZE; i++) {
+		sol = &inst->pll_cache[i];
+		if (sol->valid && sol->chid == chid && sol->refclk == refclk &&
+		    sol->linerate == linerate)
+			return sol;
+	}
+
+	return NULL;
+}
+
+/**
+ * xhdmiphy_pll_cache_add - This function stores a PLL divider search result,
+ * replacing the oldest entry once the cache is full.
+ *
+ * @inst:	inst is a pointer to the xhdmiphy core instance
+ * @chid:	chid is the channel ID of the PLL, all CPLLs share solutions
+ * @refclk:	refclk is the PLL input frequency
+ * @linerate:	linerate is the requested line rate
+ *
+ * @return:	the new cache entry
+ */
+static struct xhdmiphy_pll_sol *
+xhdmiphy_pll_cache_add(struct xhdmiphy_dev *inst, enum chid chid, u32 refclk,
+		       u64 linerate)
+{
+	struct xhdmiphy_pll_sol *sol = &inst->pll_cache[inst->pll_cache_next];
+
+	inst->pll_cache_next = (inst->pll_cache_next + 1) %
+			       XHDMIPHY_PLL_CACHE_SIZE;
+	memset(sol, 0, sizeof(*sol));
+	sol->chid = chid;
+	sol->refclk = refclk;
+	sol->linerate = linerate;
+	sol->valid = 1;
+
+	return sol;
+}
+
 /**
  * xhdmiphy_pll_cal - This function will try to find the necessary PLL divisor
  * values to produce the configured line rate given the specified PLL input
@@ -1051,6 +1107,9 @@ u64 xhdmiphy_get_pll_vco_freq(struct xhdmiphy_dev *inst, enum chid chid,
  *		to ignore what is currently configured in SW, and use a custom
  *		frequency instead.
  *
+ * The results are cached per PLL input frequency and line rate, so switching
+ * between already seen video formats doesn't repeat the divider search.
+ *
  * @return:	- 0 if valid PLL values were found to satisfy the constraints
  *		- 1 otherwise
  */
@@ -1059,6 +1118,8 @@ u32 xhdmiphy_pll_cal(struct xhdmiphy_dev *inst, enum chid chid, enum dir dir,
 {
 	const struct gtpll_divs *gtpll_divs;
 	struct channel *pll_ptr = &inst->quad.plls[XHDMIPHY_CH2IDX(chid)];
+	enum chid cache_chid = xhdmiphy_is_ch(chid) ? XHDMIPHY_CHID_CH1 : chid;
+	struct xhdmiphy_pll_sol *sol;
 	u64 pllclk_out_freq, linerate_freq;
 	u64 pll_clkin_freqin = pll_clkin_freq;
 	u32 status;
@@ -1069,6 +1130,21 @@ u32 xhdmiphy_pll_cal(struct xhdmiphy_dev *inst, enum chid chid, enum dir dir,
 		pll_clkin_freqin =
 			xhdmiphy_get_quad_refclk(inst, pll_ptr->pll_refclk);
 
+	sol = xhdmiphy_pll_cache_find(inst, cache_chid, pll_clkin_freqin,
+				      pll_ptr->linerate);
+	if (sol) {
+		if (!sol->found)
+			return 1;
+		m = &sol->m;
+		n1 = &sol->n1;
+		n2 = &sol->n2;
+		d = &sol->d;
+		goto calc_done;
+	}
+
+	sol = xhdmiphy_pll_cache_add(inst, cache_chid, pll_clkin_freqin,
+				     pll_ptr->linerate);
+
 	/* select PLL value table offsets */
 	if (xhdmiphy_is_ch(chid))
 		gtpll_divs = &inst->gt_adp->cpll_divs;
@@ -1101,6 +1177,14 @@ u32 xhdmiphy_pll_cal(struct xhdmiphy_dev *inst, enum chid chid, enum dir dir,
 	return 1;
 
 calc_done:
+	if (!sol->found) {
+		sol->m = *m;
+		sol->n1 = *n1;
+		sol->n2 = *n2;
+		sol->d = *d;
+		sol->found = 1;
+	}
+
 	/* Found the multiplier and divisor values for requested line rate */
 	pll_ptr->pll_param.m_refclk_div = *m;
 	pll_ptr->pll_param.nfb_div = *n1;
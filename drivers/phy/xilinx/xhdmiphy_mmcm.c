@@ -1128,6 +1128,64 @@ static void xhdmiphy_set_clkout2_div(struct xhdmiphy_dev *inst, enum dir dir,
 	}
 }
 
+/**
+ * xhdmiphy_mmcm_cache_find - This function looks up previously calculated mmcm
+ * parameters.
+ *
+ * @inst:	inst is a pointer to the Hdmiphy core instance
+ * @key:	key holds the inputs of the mmcm parameter calculation
+ *
+ * @return:	the cached parameters, NULL if there are none
+ */
+static struct xhdmiphy_mmcm_sol *
+xhdmiphy_mmcm_cache_find(struct xhdmiphy_dev *inst,
+			 const struct xhdmiphy_mmcm_sol *key)
+{
+	struct xhdmiphy_mmcm_sol *sol;
+	u8 i;
+
+	for (i = 0; i < XHDMIPHY_MMCM_CACHE_SIZE; i++) {
+		sol = &inst->mmcm_cache[i];
+		if (sol->valid && sol->dir == key->dir &&
+		    sol->refclk == key->refclk &&
+		    sol->linerate == key->linerate && sol->ppc == key->ppc &&
+		    sol->bpc == key->bpc &&
+		    sol->samplerate == key->samplerate &&
+		    sol->tmdsclock_ratio == key->tmdsclock_ratio)
+			return sol;
+	}
+
+	return NULL;
+}
+
+/**
+ * xhdmiphy_mmcm_cache_add - This function stores the result of a mmcm
+ * parameter calculation, replacing the oldest entry once the cache is full.
+ *
+ * @inst:	inst is a pointer to the Hdmiphy core instance
+ * @key:	key holds the inputs of the mmcm parameter calculation
+ * @mmcm_ptr:	mmcm_ptr holds the calculated parameters
+ * @found:	found indicates if valid parameters were found
+ */
+static void xhdmiphy_mmcm_cache_add(struct xhdmiphy_dev *inst,
+				    const struct xhdmiphy_mmcm_sol *key,
+				    const struct xhdmiphy_mmcm *mmcm_ptr,
+				    bool found)
+{
+	struct xhdmiphy_mmcm_sol *sol = &inst->mmcm_cache[inst->mmcm_cache_next];
+
+	inst->mmcm_cache_next = (inst->mmcm_cache_next + 1) %
+				XHDMIPHY_MMCM_CACHE_SIZE;
+	*sol = *key;
+	sol->clkfbout_mult = mmcm_ptr->clkfbout_mult;
+	sol->divclk_divide = mmcm_ptr->divclk_divide;
+	sol->clkout0_div = mmcm_ptr->clkout0_div;
+	sol->clkout1_div = mmcm_ptr->clkout1_div;
+	sol->clkout2_div = mmcm_ptr->clkout2_div;
+	sol->found = found;
+	sol->valid = 1;
+}
+
 /**
  * xhdmiphy_cal_mmcm_param - This function calculates the HDMI mmcm parameters.
  *
@@ -1145,12 +1203,17 @@ static void xhdmiphy_set_clkout2_div(struct xhdmiphy_dev *inst, enum dir dir,
  *		- 12 = XVIDC_BPC_12
  *		- 16 = XVIDC_BPC_16
  *
+ * The parameters are cached per reference clock, line rate and video format,
+ * so switching between already seen video formats doesn't repeat the divider
+ * search.
+ *
  * @return:	- 0 if calculated PLL parameters updated successfully
  *		- 1 if parameters not updated
  */
 u32 xhdmiphy_cal_mmcm_param(struct xhdmiphy_dev *inst, enum chid chid,
 			    enum dir dir, enum ppc ppc, enum color_depth bpc)
 {
+	struct xhdmiphy_mmcm_sol key = {}, *sol;
 	struct xhdmiphy_mmcm *mmcm_ptr;
 	enum pll_type pll_type;
 	u64 linerate = 0;
@@ -1180,6 +1243,32 @@ u32 xhdmiphy_cal_mmcm_param(struct xhdmiphy_dev *inst, enum chid chid,
 		return 1;
 	}
 
+	key.dir = dir;
+	key.linerate = linerate;
+	key.ppc = ppc;
+	key.bpc = bpc;
+	if (dir == XHDMIPHY_DIR_RX) {
+		key.refclk = inst->rx_refclk_hz;
+		key.tmdsclock_ratio = inst->rx_tmdsclock_ratio;
+		mmcm_ptr = &inst->quad.rx_mmcm;
+	} else {
+		key.refclk = inst->tx_refclk_hz;
+		key.samplerate = inst->tx_samplerate;
+		mmcm_ptr = &inst->quad.tx_mmcm;
+	}
+
+	sol = xhdmiphy_mmcm_cache_find(inst, &key);
+	if (sol) {
+		if (!sol->found)
+			goto err_out;
+		mmcm_ptr->clkfbout_mult = sol->clkfbout_mult;
+		mmcm_ptr->divclk_divide = sol->divclk_divide;
+		mmcm_ptr->clkout0_div = sol->clkout0_div;
+		mmcm_ptr->clkout1_div = sol->clkout1_div;
+		mmcm_ptr->clkout2_div = sol->clkout2_div;
+		return 0;
+	}
+
 	div = 1;
 	do {
 		if (dir == XHDMIPHY_DIR_RX) {
@@ -1405,9 +1494,11 @@ u32 xhdmiphy_cal_mmcm_param(struct xhdmiphy_dev *inst, enum chid chid,
 		div++;
 	} while (!valid && (div > 0) && (div < 107));
 
+	xhdmiphy_mmcm_cache_add(inst, &key, mmcm_ptr, valid);
 	if (valid)
 		return 0;
 
+err_out:
 	dev_err(inst->dev, "failed to caliculate mmmcm params\n");
 
 	return 1;
@@ -13,10 +13,12 @@
 #include <linux/io.h>
 #include <linux/irq.h>
 #include <linux/kernel.h>
+#include <linux/math64.h>
 #include <linux/module.h>
 #include <linux/ptp_clock_kernel.h>
 #include <linux/platform_device.h>
 #include <linux/of_irq.h>
+#include <linux/timekeeping.h>
 #include <linux/ptp/ptp_xilinx.h>
 
 /* Register offset definitions */
@@ -72,6 +74,9 @@
 
 #define PPM_FRACTION	16
 
+/* Keeps the extrapolation of the cached time base short */
+#define XPTPTIMER_BASE_REFRESH		(HZ / 2)
+
 /* I/O accessors */
 static inline u32 xlnx_ptp_ior(struct xlnx_ptp_timer *timer, off_t reg)
 {
@@ -88,15 +93,18 @@ static inline void xlnx_ptp_iow(struct xlnx_ptp_timer *timer, off_t reg,
  * Inline timer helpers
  */
 static inline void xlnx_tod_read(struct xlnx_ptp_timer *timer,
-				 struct timespec64 *ts)
+				 struct timespec64 *ts,
+				 struct ptp_system_timestamp *sts)
 {
 	u32 sech, secl, nsec;
 
+	ptp_read_system_prets(sts);
 	xlnx_ptp_iow(timer, XPTPTIMER_TOD_SNAPSHOT_OFFSET,
 		     XPTPTIMER_SNAPSHOT_MASK);
 
-	/* use TX port here */
+	/* use TX port here, the read also flushes the snapshot write */
 	nsec = xlnx_ptp_ior(timer, XPTPTIMER_PORT_TX_NS_SNAP_OFFSET);
+	ptp_read_system_postts(sts);
 	secl = xlnx_ptp_ior(timer, XPTPTIMER_PORT_TX_SEC_0_SNAP_OFFSET);
 	sech = xlnx_ptp_ior(timer, XPTPTIMER_PORT_TX_SEC_1_SNAP_OFFSET);
 
@@ -170,19 +178,76 @@ static inline void xlnx_tod_period_write(struct xlnx_ptp_timer *timer, u64 adj)
 	xlnx_ptp_iow(timer, TOD_SYS_PERIOD_1, adjhigh);
 }
 
+/* Called with reg_lock held */
 static inline void xlnx_port_period_write(struct xlnx_ptp_timer *timer, u64 adj)
 {
 	u32 adjhigh = upper_32_bits(adj);
 
 	xlnx_ptp_iow(timer, XPTPTIMER_PORT_TX_PERIOD_0_OFFSET, (u32)(adj));
 	xlnx_ptp_iow(timer, XPTPTIMER_PORT_RX_PERIOD_0_OFFSET, (u32)(adj));
-	spin_lock(&timer->reg_lock);
 	xlnx_ptp_iow(timer, XPTPTIMER_PORT_TX_PERIOD_1_OFFSET, adjhigh);
 	xlnx_ptp_iow(timer, XPTPTIMER_PORT_RX_PERIOD_1_OFFSET, adjhigh);
+	timer->period = adj;
+}
 
-	spin_unlock(&timer->reg_lock);
+/**
+ * xlnx_ptp_base_refresh - Take a new cached time base
+ * @timer: xilinx ptp timer
+ * @scaled_ppm: frequency adjustment in effect from now on
+ *
+ * Called with reg_lock held, which also serializes the writers of the
+ * time base.
+ */
+static void xlnx_ptp_base_refresh(struct xlnx_ptp_timer *timer,
+				  long scaled_ppm)
+{
+	struct timespec64 ts;
+	u64 sys_ns;
+
+	sys_ns = ktime_get_raw_ns();
+	xlnx_tod_read(timer, &ts, NULL);
+
+	write_seqcount_begin(&timer->base_seq);
+	timer->base.hw_ns = timespec64_to_ns(&ts);
+	timer->base.sys_ns = sys_ns;
+	timer->base.scaled_ppm = scaled_ppm;
+	write_seqcount_end(&timer->base_seq);
 }
 
+/**
+ * xlnx_ptp_timer_gettime_cached - Get the timer time without register access
+ * @timer: xilinx ptp timer
+ * @ts: timespec64 filled with the current timer time
+ *
+ * The time is extrapolated from the cached time base with the system raw
+ * clock and the frequency adjustment in effect. It is meant for frequent
+ * in-kernel readers that can live with an error in the order of the servo
+ * residual; PTP time transfer must use the hardware clock instead. The
+ * reader is lockless and never waits for the register lock.
+ */
+void xlnx_ptp_timer_gettime_cached(struct xlnx_ptp_timer *timer,
+				   struct timespec64 *ts)
+{
+	struct xlnx_ptp_base base;
+	unsigned int seq;
+	u64 elapsed, adj;
+	s64 ns;
+
+	do {
+		seq = read_seqcount_begin(&timer->base_seq);
+		base = timer->base;
+	} while (read_seqcount_retry(&timer->base_seq, seq));
+
+	elapsed = ktime_get_raw_ns() - base.sys_ns;
+	adj = mul_u64_u32_div(elapsed, abs(base.scaled_ppm), USEC_PER_SEC);
+	adj >>= PPM_FRACTION;
+	ns = base.hw_ns + elapsed;
+	ns = base.scaled_ppm < 0 ? ns - adj : ns + adj;
+
+	*ts = ns_to_timespec64(ns);
+}
+EXPORT_SYMBOL_GPL(xlnx_ptp_timer_gettime_cached);
+
 /*
  * PTP clock operations
  */
@@ -191,7 +256,9 @@ static inline void xlnx_port_period_write(struct xlnx_ptp_timer *timer, u64 adj)
  * @ptp: ptp clock structure
  * @scaled_ppm: signed scaled parts per million for frequency adjustment.
  * Return: 0 on success
- * TX and RX port periods are reloaded with the adjusted value.
+ * TX and RX port periods are reloaded with the adjusted value. The servo
+ * often asks for the same frequency again, the registers are only written
+ * when the period changes.
  *
  */
 static int xlnx_ptp_adjfine(struct ptp_clock_info *ptp, long scaled_ppm)
@@ -210,7 +277,12 @@ static int xlnx_ptp_adjfine(struct ptp_clock_info *ptp, long scaled_ppm)
 	adj >>= PPM_FRACTION; /* remove fractions */
 	adj = neg_adj ? (timer->incr - adj) : (timer->incr + adj);
 
-	xlnx_port_period_write(timer, adj);
+	spin_lock(&timer->reg_lock);
+	if (adj != timer->period) {
+		xlnx_ptp_base_refresh(timer, neg_adj ? -scaled_ppm : scaled_ppm);
+		xlnx_port_period_write(timer, adj);
+	}
+	spin_unlock(&timer->reg_lock);
 
 	return 0;
 }
@@ -229,10 +301,12 @@ static int xlnx_ptp_adjtime(struct ptp_clock_info *ptp, s64 delta)
 						ptp_clock_info);
 	struct timespec64 offset;
 	u64 sign = 0;
-	s64 cumulative_delta = timer->timeoffset;
+	s64 cumulative_delta;
 
 	spin_lock(&timer->reg_lock);
 
+	cumulative_delta = timer->timeoffset;
+
 	/* Fixed offset between system and port timer */
 	delta += timer->static_delay;
 	cumulative_delta += delta;
@@ -245,6 +319,7 @@ static int xlnx_ptp_adjtime(struct ptp_clock_info *ptp, s64 delta)
 	offset.tv_sec |= sign;
 
 	xlnx_port_offset_write(timer, (const struct timespec64 *)&offset);
+	xlnx_ptp_base_refresh(timer, timer->base.scaled_ppm);
 
 	spin_unlock(&timer->reg_lock);
 
@@ -252,21 +327,23 @@ static int xlnx_ptp_adjtime(struct ptp_clock_info *ptp, s64 delta)
 }
 
 /**
- * xlnx_ptp_gettime - Get the current time on the hardware clock
+ * xlnx_ptp_gettimex - Get the current time on the hardware clock
  * @ptp: ptp clock structure
  * @ts: timespec64 containing the current TX port timer time.
+ * @sts: system timestamps taken around the snapshot, may be NULL
  * Return: 0 on success
  * Since TX and RX ports are initialized and adjusted simultaneously,
  * they should be the same.
  *
  */
-static int xlnx_ptp_gettime(struct ptp_clock_info *ptp, struct timespec64 *ts)
+static int xlnx_ptp_gettimex(struct ptp_clock_info *ptp, struct timespec64 *ts,
+			     struct ptp_system_timestamp *sts)
 {
 	struct xlnx_ptp_timer *timer = container_of(ptp, struct xlnx_ptp_timer,
 						    ptp_clock_info);
 
 	spin_lock(&timer->reg_lock);
-	xlnx_tod_read(timer, ts);
+	xlnx_tod_read(timer, ts, sts);
 	spin_unlock(&timer->reg_lock);
 
 	return 0;
@@ -288,11 +365,33 @@ static int xlnx_ptp_settime(struct ptp_clock_info *ptp,
 
 	spin_lock(&timer->reg_lock);
 	xlnx_tod_load_write(timer, ts);
+	xlnx_ptp_base_refresh(timer, timer->base.scaled_ppm);
 	spin_unlock(&timer->reg_lock);
 
 	return 0;
 }
 
+/**
+ * xlnx_ptp_do_aux_work - Refresh the cached time base
+ * @ptp: ptp clock structure
+ * Return: delay until the next refresh
+ */
+static long xlnx_ptp_do_aux_work(struct ptp_clock_info *ptp)
+{
+	struct xlnx_ptp_timer *timer = container_of(ptp, struct xlnx_ptp_timer,
+						    ptp_clock_info);
+
+	spin_lock(&timer->reg_lock);
+	xlnx_ptp_base_refresh(timer, timer->base.scaled_ppm);
+	spin_unlock(&timer->reg_lock);
+
+	return XPTPTIMER_BASE_REFRESH;
+}
+
+/*
+ * The timer syncer has no external timestamp input nor PPS output, so
+ * there is nothing to enable.
+ */
 static int xlnx_ptp_enable(struct ptp_clock_info *ptp,
 			   struct ptp_clock_request *rq, int on)
 {
@@ -306,9 +405,10 @@ static struct ptp_clock_info xlnx_ptp_clock_info = {
 	.n_ext_ts	= 0,
 	.adjfine	= xlnx_ptp_adjfine,
 	.adjtime	= xlnx_ptp_adjtime,
-	.gettime64	= xlnx_ptp_gettime,
+	.gettimex64	= xlnx_ptp_gettimex,
 	.settime64	= xlnx_ptp_settime,
 	.enable		= xlnx_ptp_enable,
+	.do_aux_work	= xlnx_ptp_do_aux_work,
 };
 
 static int xlnx_ptp_timer_probe(struct platform_device *pdev)
@@ -338,6 +438,7 @@ static int xlnx_ptp_timer_probe(struct platform_device *pdev)
 	}
 
 	spin_lock_init(&timer->reg_lock);
+	seqcount_spinlock_init(&timer->base_seq, &timer->reg_lock);
 
 	timer->ptp_clock_info = xlnx_ptp_clock_info;
 
@@ -358,8 +459,10 @@ static int xlnx_ptp_timer_probe(struct platform_device *pdev)
 	 * so that the initial LOAD triggers everything together.
 	 */
 	timer->incr = ((u64)XPTPTIMER_CLOCK_PERIOD << XPTPTIMER_PERIOD_SHIFT);
+	spin_lock(&timer->reg_lock);
 	xlnx_tod_period_write(timer, timer->incr);
 	xlnx_port_period_write(timer, timer->incr);
+	spin_unlock(&timer->reg_lock);
 
 	/* Initialize current time */
 	ts = ns_to_timespec64(ktime_to_ns(ktime_get_real()));
@@ -390,6 +493,7 @@ static int xlnx_ptp_timer_probe(struct platform_device *pdev)
 	platform_set_drvdata(pdev, timer);
 
 	timer->phc_index = ptp_clock_index(timer->ptp_clock);
+	ptp_schedule_worker(timer->ptp_clock, XPTPTIMER_BASE_REFRESH);
 	dev_info(&pdev->dev, "Xilinx PTP timer driver probed\n");
 
 	return 0;
@@ -6,6 +6,8 @@
  *
  */
 
+#include <linux/elf.h>
+#include <linux/firmware.h>
 #include <linux/firmware/xlnx-zynqmp.h>
 #include <linux/interrupt.h>
 #include <linux/kernel.h>
@@ -13,6 +15,7 @@
 #include <linux/mailbox_client.h>
 #include <linux/mailbox/zynqmp-ipi-message.h>
 #include <linux/module.h>
+#include <linux/mutex.h>
 #include <linux/of_address.h>
 #include <linux/of_platform.h>
 #include <linux/of_reserved_mem.h>
@@ -37,6 +40,14 @@
 #define MAX_BANKS 4U
 #define MAX_BANKS_PER_CORE	3U
 
+/*
+ * In lockstep, the TCM banks of R5 core 1 sit right after those of core 0,
+ * 0x80000 below their split mode addresses and at 0x10000 and 0x30000 for
+ * the R5.
+ */
+#define TCM_LOCKSTEP_OFFSET	0x80000U
+#define TCM_BANK_SIZE		0x10000U
+
 /*
  * NOTE: The resource table size is currently hard-coded to a maximum
  * of 1024 bytes. The most common resource table usage for RPU firmwares
@@ -44,6 +55,18 @@
  */
 #define RSC_TBL_SIZE	0x400
 
+static bool cache_fw = true;
+module_param(cache_fw, bool, 0644);
+MODULE_PARM_DESC(cache_fw, "Keep the firmware in memory to restart crashed cores");
+
+static unsigned int poll_us;
+module_param(poll_us, uint, 0644);
+MODULE_PARM_DESC(poll_us, "Time to poll the virtqueues for more messages after an IPI, 0 disables");
+
+static bool coredump_inline;
+module_param(coredump_inline, bool, 0444);
+MODULE_PARM_DESC(coredump_inline, "Read crash dumps directly from the RPU memories instead of a copy");
+
 enum soc_type_t {
 	SOC_ZYNQMP	= 0,
 	SOC_VERSAL	= 1,
@@ -72,6 +95,21 @@ struct sram_addr_data {
 	enum pm_node_id ids[MAX_BANKS];
 };
 
+/**
+ * struct xlnx_rpu_cluster - Xilinx RPU cluster structure
+ *
+ * @cores: RPU cores of the cluster, linked by their @elem
+ * @core_count: number of RPU cores described for the cluster
+ * @mode: operation mode of the cluster, lockstep or split
+ * @lock: serializes the mode switches and the cluster boots
+ */
+struct xlnx_rpu_cluster {
+	struct list_head cores;
+	int core_count;
+	enum rpu_oper_mode mode;
+	struct mutex lock;
+};
+
 /**
  * struct xlnx_rpu_rproc - Xilinx RPU core structure
  *
@@ -80,6 +118,9 @@ struct sram_addr_data {
  * @rx_mc: rx mailbox client
  * @mbox_work: mbox_work for the RPU remoteproc
  * @tx_mc_skbs: socket buffers for tx mailbox client
+ * @kick_lock: protects @kicks_inflight and @kicks_deferred
+ * @kicks_inflight: number of kicks sent and not yet taken by the remote
+ * @kicks_deferred: bitmap of virtqueue IDs to kick when the kicks are done
  * @dev: device of RPU instance
  * @rproc: rproc handle
  * @tx_chan: tx mailbox channel
@@ -88,8 +129,13 @@ struct sram_addr_data {
  * @pnode_id: RPU CPU power domain id
  * @rsc_pa: device address of resource table
  * @elem: linked list item
+ * @fw_cache: firmware of the running core, kept for crash recovery
  * @versal: flag that if on, denotes this driver is for Versal SoC.
  * @soc_data: SoC-specific feature data for a RPU core.
+ * @cluster: RPU cluster of the core
+ * @boot_work: boots the core along with the other cores of the cluster
+ * @boot_ret: result of @boot_work
+ * @booting: the core is booted by the current cluster boot
  */
 struct xlnx_rpu_rproc {
 	unsigned char rx_mc_buf[RX_MBOX_CLIENT_BUF_MAX];
@@ -97,6 +143,9 @@ struct xlnx_rpu_rproc {
 	struct mbox_client rx_mc;
 	struct work_struct mbox_work;
 	struct sk_buff_head tx_mc_skbs;
+	spinlock_t kick_lock;
+	unsigned int kicks_inflight;
+	unsigned long kicks_deferred;
 	struct device *dev;
 	struct rproc *rproc;
 	struct mbox_chan *tx_chan;
@@ -105,9 +154,32 @@ struct xlnx_rpu_rproc {
 	phys_addr_t rsc_pa;
 	u32 pnode_id;
 	struct list_head elem;
+	const struct firmware *fw_cache;
 	const struct xlnx_rpu_soc_data *soc_data;
+	struct xlnx_rpu_cluster *cluster;
+	struct work_struct boot_work;
+	int boot_ret;
+	bool booting;
 };
 
+/*
+ * xlnx_rpu_lockstep_peer()
+ * @z_rproc: RPU core
+ *
+ * In lockstep, the second core of the cluster runs the code of the first
+ * one and can't be booted on its own.
+ *
+ * Return: true if the core is the second core of a lockstep cluster
+ */
+static bool xlnx_rpu_lockstep_peer(struct xlnx_rpu_rproc *z_rproc)
+{
+	struct xlnx_rpu_cluster *cluster = z_rproc->cluster;
+
+	return cluster->mode == PM_RPU_MODE_LOCKSTEP &&
+	       z_rproc != list_first_entry(&cluster->cores,
+					   struct xlnx_rpu_rproc, elem);
+}
+
 /*
  * rpu_set_mode - set RPU operation mode
  * @z_rproc: Remote processor private data
@@ -265,6 +337,12 @@ static int xlnx_rpu_rproc_stop(struct rproc *rproc)
 {
 	struct xlnx_rpu_rproc *z_rproc = rproc->priv;
 
+	/* Only a crash recovery boots the same firmware again */
+	if (rproc->state != RPROC_CRASHED) {
+		release_firmware(z_rproc->fw_cache);
+		z_rproc->fw_cache = NULL;
+	}
+
 	return zynqmp_pm_force_pwrdwn(z_rproc->pnode_id,
 				     ZYNQMP_PM_REQUEST_ACK_BLOCKING);
 }
@@ -274,7 +352,8 @@ static int xlnx_rpu_rproc_stop(struct rproc *rproc)
  * @rproc: single RPU core's corresponding rproc instance
  * @mem: mem entry to map
  *
- * Callback to map va for memory-region's carveout.
+ * Callback to map va for memory-region's carveout, which is then part of
+ * the crash dumps of the core.
  *
  * return 0 on success, otherwise non-zero value on failure
  */
@@ -289,7 +368,7 @@ static int xlnx_rpu_rproc_mem_alloc(struct rproc *rproc,
 
 	mem->va = va;
 
-	return 0;
+	return rproc_coredump_add_segment(rproc, mem->da, mem->len);
 }
 
 /*
@@ -484,7 +563,8 @@ static int xlnx_rpu_pm_request_sram(struct device *dev,
  *
  * Given SRAM bank entry,
  * this callback will set device address for RPU running on TCM
- * and also setup virtual address for TCM bank remoteproc carveout
+ * and also setup virtual address for TCM bank remoteproc carveout,
+ * which is then part of the crash dumps of the core
  *
  * return 0 on success, otherwise non-zero value on failure
  */
@@ -501,7 +581,7 @@ static int sram_mem_alloc(struct rproc *rproc, struct rproc_mem_entry *mem)
 	 */
 	unsigned int versal_net[4] = { 0xEBA00000, 0x3FFFF, 0xEBAE0000, 0x8000 };
 	unsigned int versal[4] = { 0xFFE00000, 0xFFFFF, 0xFFEB0000, 0x10000 };
-	unsigned int base, mask, high, len, bank, *sram_tbl;
+	unsigned int base, mask, high, len, bank, bank_da, *sram_tbl;
 	struct xlnx_rpu_rproc *z_rproc = rproc->priv;
 	struct device *dev = rproc->dev.parent;
 	void *va;
@@ -549,10 +629,16 @@ static int sram_mem_alloc(struct rproc *rproc, struct rproc_mem_entry *mem)
 			mem->da -= 0x90000;
 		/*
 		 * Check if one of the valid bank base addresses. If not
-		 * report error.
+		 * report error. The banks of core 1 follow those of core 0
+		 * in lockstep.
 		 */
+		bank_da = mem->da;
+		if (z_rproc->soc_data->soc_type != SOC_VERSAL_NET &&
+		    z_rproc->cluster->mode == PM_RPU_MODE_LOCKSTEP)
+			bank_da &= ~TCM_BANK_SIZE;
+
 		for (bank = 0; bank < z_rproc->soc_data->num_tcms; bank++) {
-			if (mem->da == z_rproc->soc_data->tcm_bases[bank])
+			if (bank_da == z_rproc->soc_data->tcm_bases[bank])
 				break;
 		}
 
@@ -563,25 +649,28 @@ static int sram_mem_alloc(struct rproc *rproc, struct rproc_mem_entry *mem)
 		}
 	}
 
-	return 0;
+	return rproc_coredump_add_segment(rproc, mem->da, mem->len);
 }
 
 /*
- * parse_tcm_banks()
+ * parse_tcm_bank_list()
  * @rproc: single RPU core's corresponding rproc instance
+ * @r5_node: RPU node listing the TCM banks
+ * @offset: offset to subtract from the addresses of the banks
  *
- * Given RPU node in remoteproc instance
+ * Given RPU node of the cluster
  * allocate remoteproc carveout for TCM memory
  * needed for firmware to be loaded
  *
  * return 0 on success, otherwise non-zero value on failure
  */
-static int parse_tcm_banks(struct rproc *rproc)
+static int parse_tcm_bank_list(struct rproc *rproc,
+			       struct device_node *r5_node,
+			       resource_size_t offset)
 {
 	int i, num_banks, ret;
 	struct xlnx_rpu_rproc *z_rproc = rproc->priv;
 	struct device *dev = &rproc->dev;
-	struct device_node *r5_node = z_rproc->dev->of_node;
 	struct sram_addr_data *sram_banks;
 
 	/* go through TCM banks for RPU node */
@@ -606,6 +695,7 @@ static int parse_tcm_banks(struct rproc *rproc)
 				return ret;
 
 			size = resource_size(&rsc);
+			rsc.start -= offset;
 
 			/*
 			 * This is used later to power off the banks when
@@ -656,6 +746,43 @@ static int parse_tcm_banks(struct rproc *rproc)
 	return ret;
 }
 
+/*
+ * parse_tcm_banks()
+ * @rproc: single RPU core's corresponding rproc instance
+ *
+ * Allocate the TCM carveouts of the core for the current mode of the
+ * cluster. This runs on every boot, so the carveouts follow the mode
+ * switches of the cluster.
+ *
+ * return 0 on success, otherwise non-zero value on failure
+ */
+static int parse_tcm_banks(struct rproc *rproc)
+{
+	struct xlnx_rpu_rproc *z_rproc = rproc->priv, *peer;
+	struct xlnx_rpu_cluster *cluster = z_rproc->cluster;
+	int ret;
+
+	ret = parse_tcm_bank_list(rproc, z_rproc->dev->of_node, 0);
+	if (ret || cluster->mode != PM_RPU_MODE_LOCKSTEP)
+		return ret;
+
+	/*
+	 * A cluster described in split mode and switched to lockstep also
+	 * runs from the banks of its second core.
+	 */
+	list_for_each_entry(peer, &cluster->cores, elem) {
+		if (peer == z_rproc)
+			continue;
+
+		ret = parse_tcm_bank_list(rproc, peer->dev->of_node,
+					  TCM_LOCKSTEP_OFFSET);
+		if (ret)
+			return ret;
+	}
+
+	return 0;
+}
+
 /*
  * xlnx_rpu_parse_fw()
  * @rproc: single RPU core's corresponding rproc instance
@@ -683,12 +810,53 @@ static int xlnx_rpu_parse_fw(struct rproc *rproc, const struct firmware *fw)
 	return ret;
 }
 
+/*
+ * xlnx_rpu_rproc_load()
+ * @rproc: single RPU core's corresponding rproc instance
+ * @fw: ptr to firmware to be loaded onto RPU core
+ *
+ * Load the firmware segments to TCM and DDR, and keep a reference to the
+ * firmware while the core runs. The request_firmware() of a crash recovery
+ * then finds the firmware still loaded and gets it from memory instead of
+ * reading it from the filesystem again.
+ *
+ * return 0 on success, otherwise non-zero value on failure
+ */
+static int xlnx_rpu_rproc_load(struct rproc *rproc, const struct firmware *fw)
+{
+	struct xlnx_rpu_rproc *z_rproc = rproc->priv;
+	int ret;
+
+	/* A different firmware is booted, e.g. the recovery was disabled */
+	if (z_rproc->fw_cache && z_rproc->fw_cache->data != fw->data) {
+		release_firmware(z_rproc->fw_cache);
+		z_rproc->fw_cache = NULL;
+	}
+
+	ret = rproc_elf_load_segments(rproc, fw);
+	if (ret || !cache_fw || z_rproc->fw_cache)
+		return ret;
+
+	/* The firmware is still loaded, so this only takes a reference */
+	if (request_firmware_direct(&z_rproc->fw_cache, rproc->firmware,
+				    &rproc->dev))
+		dev_dbg(&rproc->dev, "unable to cache firmware %s\n",
+			rproc->firmware);
+
+	return 0;
+}
+
 static int xlnx_rpu_prepare(struct rproc *rproc)
 {
 	struct xlnx_rpu_rproc *z_rproc = rproc->priv;
 	struct device *dev = rproc->dev.parent;
 	int ret;
 
+	if (xlnx_rpu_lockstep_peer(z_rproc)) {
+		dev_err(dev, "RPU core runs in lockstep with core 0\n");
+		return -EBUSY;
+	}
+
 	/*
 	 * In Versal SoC, the Xilinx platform management firmware will power
 	 * off the RPU cores if they are not requested. In this case, this call
@@ -766,51 +934,79 @@ static int xlnx_rpu_rproc_detach(struct rproc *rproc)
 	return 0;
 }
 
+/*
+ * xlnx_rpu_send_kick() - send a kick IPI to the remote
+ * @z_rproc: RPU core's corresponding private data
+ * @vqid: virtqueue ID
+ *
+ * return 0 on success, otherwise non-zero value on failure
+ */
+static int xlnx_rpu_send_kick(struct xlnx_rpu_rproc *z_rproc, int vqid)
+{
+	struct zynqmp_ipi_message *mb_msg;
+	unsigned int skb_len;
+	struct sk_buff *skb;
+	int ret;
+
+	skb_len = (unsigned int)(sizeof(vqid) + sizeof(mb_msg));
+	skb = alloc_skb(skb_len, GFP_ATOMIC);
+	if (!skb)
+		return -ENOMEM;
+
+	mb_msg = (struct zynqmp_ipi_message *)skb_put(skb, skb_len);
+	mb_msg->len = sizeof(vqid);
+	memcpy(mb_msg->data, &vqid, sizeof(vqid));
+
+	skb_queue_tail(&z_rproc->tx_mc_skbs, skb);
+	ret = mbox_send_message(z_rproc->tx_chan, mb_msg);
+	if (ret < 0) {
+		skb_dequeue_tail(&z_rproc->tx_mc_skbs);
+		kfree_skb(skb);
+		return ret;
+	}
+
+	return 0;
+}
+
 /*
  * xlnx_rpu_rproc_kick() - kick a firmware if mbox is provided
  * @rproc: RPU core's corresponding rproc structure
  * @vqid: virtqueue ID
+ *
+ * While a kick is in flight, further kicks are not queued behind it. They
+ * are recorded per virtqueue and sent once the kicks in flight are done, so
+ * a burst of notifications for a virtqueue costs at most two IPIs.
  */
 static void xlnx_rpu_rproc_kick(struct rproc *rproc, int vqid)
 {
-	struct zynqmp_ipi_message *mb_msg = NULL;
-	struct sk_buff *skb = NULL;
-	unsigned int skb_len = 0;
-	int ret;
-
 	struct device *dev = rproc->dev.parent;
 	struct xlnx_rpu_rproc *z_rproc = rproc->priv;
+	unsigned long flags;
 
-	if (of_property_read_bool(dev->of_node, "mboxes")) {
-		skb_len = (unsigned int)(sizeof(vqid) + sizeof(mb_msg));
-		skb = alloc_skb(skb_len, GFP_ATOMIC);
-		if (!skb)
-			return;
-
-		mb_msg = (struct zynqmp_ipi_message *)skb_put(skb, skb_len);
-		mb_msg->len = sizeof(vqid);
-		memcpy(mb_msg->data, &vqid, sizeof(vqid));
+	if (!z_rproc->tx_chan)
+		return;
 
-		skb_queue_tail(&z_rproc->tx_mc_skbs, skb);
-		ret = mbox_send_message(z_rproc->tx_chan, mb_msg);
-		if (ret < 0) {
-			dev_warn(dev, "Failed to kick remote.\n");
-			skb_dequeue_tail(&z_rproc->tx_mc_skbs);
-			kfree_skb(skb);
-		}
-	} else {
-		(void)skb;
-		(void)skb_len;
-		(void)mb_msg;
-		(void)ret;
-		(void)vqid;
+	spin_lock_irqsave(&z_rproc->kick_lock, flags);
+	if (z_rproc->kicks_inflight && vqid >= 0 && vqid < BITS_PER_LONG) {
+		__set_bit(vqid, &z_rproc->kicks_deferred);
+		spin_unlock_irqrestore(&z_rproc->kick_lock, flags);
+		return;
+	}
+	z_rproc->kicks_inflight++;
+	spin_unlock_irqrestore(&z_rproc->kick_lock, flags);
+
+	if (xlnx_rpu_send_kick(z_rproc, vqid)) {
+		dev_warn(dev, "Failed to kick remote.\n");
+		spin_lock_irqsave(&z_rproc->kick_lock, flags);
+		z_rproc->kicks_inflight--;
+		spin_unlock_irqrestore(&z_rproc->kick_lock, flags);
 	}
 }
 
 static struct rproc_ops xlnx_rpu_rproc_ops = {
 	.start		= xlnx_rpu_rproc_start,
 	.stop		= xlnx_rpu_rproc_stop,
-	.load		= rproc_elf_load_segments,
+	.load		= xlnx_rpu_rproc_load,
 	.parse_fw	= xlnx_rpu_parse_fw,
 	.prepare	= xlnx_rpu_prepare,
 	.find_loaded_rsc_table = rproc_elf_find_loaded_rsc_table,
@@ -821,46 +1017,61 @@ static struct rproc_ops xlnx_rpu_rproc_ops = {
 	.kick		= xlnx_rpu_rproc_kick,
 };
 
-/**
- * event_notified_idr_cb() - event notified idr callback
- * @id: idr id
- * @ptr: pointer to idr private data
- * @data: data passed to idr_for_each callback
- *
- * Pass notification to remoteproc virtio
- *
- * Return: 0. having return is to satisfy the idr_for_each() function
- *          pointer input argument requirement.
- **/
-static int event_notified_idr_cb(int id, void *ptr, void *data)
-{
-	struct rproc *rproc = data;
-
-	(void)rproc_vq_interrupt(rproc, id);
-	return 0;
-}
-
 /**
  * handle_event_notified() - remoteproc notification work function
  * @work: pointer to the work structure
  *
  * It checks each registered remoteproc notify IDs.
+ *
+ * With poll_us set, it keeps checking them until no message came for that
+ * long, so the messages following the first one are taken without waiting
+ * for their IPIs. The work is queued again instead of polling for more than
+ * a jiffy, not to hold the workqueue under a constant stream of messages.
  */
 static void handle_event_notified(struct work_struct *work)
 {
 	struct rproc *rproc;
 	struct xlnx_rpu_rproc *z_rproc;
+	struct rproc_vring *rvring;
+	unsigned long budget = jiffies + 1;
+	unsigned int period;
+	ktime_t idle_end;
+	bool handled;
+	int id;
 
 	z_rproc = container_of(work, struct xlnx_rpu_rproc, mbox_work);
 
 	(void)mbox_send_message(z_rproc->rx_chan, NULL);
 	rproc = z_rproc->rproc;
+	period = READ_ONCE(poll_us);
+	idle_end = ktime_add_us(ktime_get(), period);
+
 	/*
 	 * We only use IPI for interrupt. The firmware side may or may
 	 * not write the notifyid when it trigger IPI.
 	 * And thus, we scan through all the registered notifyids.
 	 */
-	idr_for_each(&rproc->notifyids, event_notified_idr_cb, rproc);
+	for (;;) {
+		handled = false;
+		idr_for_each_entry(&rproc->notifyids, rvring, id)
+			if (rproc_vq_interrupt(rproc, id) == IRQ_HANDLED)
+				handled = true;
+
+		if (!period)
+			break;
+
+		if (handled)
+			idle_end = ktime_add_us(ktime_get(), period);
+		else if (ktime_after(ktime_get(), idle_end))
+			break;
+
+		if (time_after(jiffies, budget)) {
+			schedule_work(&z_rproc->mbox_work);
+			break;
+		}
+
+		cond_resched();
+	}
 }
 
 /**
@@ -900,13 +1111,33 @@ static void xlnx_rpu_mb_rx_cb(struct mbox_client *cl, void *msg)
 static void xlnx_rpu_mb_tx_done(struct mbox_client *cl, void *msg, int r)
 {
 	struct xlnx_rpu_rproc *z_rproc;
+	unsigned long flags;
 	struct sk_buff *skb;
+	int vqid;
 
 	if (!msg)
 		return;
 	z_rproc = container_of(cl, struct xlnx_rpu_rproc, tx_mc);
 	skb = skb_dequeue(&z_rproc->tx_mc_skbs);
 	kfree_skb(skb);
+
+	/* Send one of the kicks deferred while kicks were in flight */
+	spin_lock_irqsave(&z_rproc->kick_lock, flags);
+	if (--z_rproc->kicks_inflight || !z_rproc->kicks_deferred) {
+		spin_unlock_irqrestore(&z_rproc->kick_lock, flags);
+		return;
+	}
+	vqid = __ffs(z_rproc->kicks_deferred);
+	__clear_bit(vqid, &z_rproc->kicks_deferred);
+	z_rproc->kicks_inflight++;
+	spin_unlock_irqrestore(&z_rproc->kick_lock, flags);
+
+	if (xlnx_rpu_send_kick(z_rproc, vqid)) {
+		dev_warn(z_rproc->dev, "Failed to kick remote.\n");
+		spin_lock_irqsave(&z_rproc->kick_lock, flags);
+		z_rproc->kicks_inflight--;
+		spin_unlock_irqrestore(&z_rproc->kick_lock, flags);
+	}
 }
 
 /**
@@ -941,6 +1172,8 @@ static int xlnx_rpu_setup_mbox(struct xlnx_rpu_rproc *z_rproc,
 	mclient->knows_txdone = false;
 
 	INIT_WORK(&z_rproc->mbox_work, handle_event_notified);
+	spin_lock_init(&z_rproc->kick_lock);
+	skb_queue_head_init(&z_rproc->tx_mc_skbs);
 
 	/* Request TX and RX channels */
 	z_rproc->tx_chan = mbox_request_channel_byname(&z_rproc->tx_mc, "tx");
@@ -956,11 +1189,215 @@ static int xlnx_rpu_setup_mbox(struct xlnx_rpu_rproc *z_rproc,
 		z_rproc->rx_chan = NULL;
 		return -EINVAL;
 	}
-	skb_queue_head_init(&z_rproc->tx_mc_skbs);
 
 	return 0;
 }
 
+/**
+ * xlnx_rpu_boot_work() - Boot a core of a cluster boot
+ * @work: boot work of the core
+ */
+static void xlnx_rpu_boot_work(struct work_struct *work)
+{
+	struct xlnx_rpu_rproc *z_rproc;
+
+	z_rproc = container_of(work, struct xlnx_rpu_rproc, boot_work);
+	z_rproc->boot_ret = rproc_boot(z_rproc->rproc);
+}
+
+/**
+ * xlnx_rpu_cluster_boot() - Boot the cores of a cluster
+ * @cluster: RPU cluster
+ *
+ * The offline cores of the cluster load and start their firmware in
+ * parallel, so that booting the cluster takes as long as booting its
+ * slowest core. Either all of them boot or none of them stays up.
+ *
+ * Return: 0 for success, negative value for failure.
+ */
+static int xlnx_rpu_cluster_boot(struct xlnx_rpu_cluster *cluster)
+{
+	struct xlnx_rpu_rproc *z_rproc;
+	int ret = 0;
+
+	mutex_lock(&cluster->lock);
+
+	list_for_each_entry(z_rproc, &cluster->cores, elem) {
+		z_rproc->booting = !xlnx_rpu_lockstep_peer(z_rproc) &&
+				   z_rproc->rproc->state == RPROC_OFFLINE;
+		if (z_rproc->booting)
+			queue_work(system_unbound_wq, &z_rproc->boot_work);
+	}
+
+	list_for_each_entry(z_rproc, &cluster->cores, elem) {
+		if (!z_rproc->booting)
+			continue;
+
+		flush_work(&z_rproc->boot_work);
+		if (z_rproc->boot_ret && !ret)
+			ret = z_rproc->boot_ret;
+	}
+
+	if (ret) {
+		list_for_each_entry(z_rproc, &cluster->cores, elem) {
+			if (z_rproc->booting && !z_rproc->boot_ret)
+				rproc_shutdown(z_rproc->rproc);
+		}
+	}
+
+	mutex_unlock(&cluster->lock);
+
+	return ret;
+}
+
+/**
+ * xlnx_rpu_cluster_shutdown() - Shut down the cores of a cluster
+ * @cluster: RPU cluster
+ *
+ * Return: 0 for success, negative value for failure.
+ */
+static int xlnx_rpu_cluster_shutdown(struct xlnx_rpu_cluster *cluster)
+{
+	struct xlnx_rpu_rproc *z_rproc;
+	int err, ret = 0;
+
+	mutex_lock(&cluster->lock);
+
+	list_for_each_entry(z_rproc, &cluster->cores, elem) {
+		if (z_rproc->rproc->state != RPROC_RUNNING &&
+		    z_rproc->rproc->state != RPROC_CRASHED)
+			continue;
+
+		err = rproc_shutdown(z_rproc->rproc);
+		if (err && !ret)
+			ret = err;
+	}
+
+	mutex_unlock(&cluster->lock);
+
+	return ret;
+}
+
+/**
+ * xlnx_rpu_cluster_set_mode() - Switch a cluster between lockstep and split
+ * @cluster: RPU cluster
+ * @mode: new operation mode of the cluster
+ *
+ * The cores of the cluster must be offline. Only the RPU and TCM
+ * configuration are changed here, the TCM carveouts of the cores are
+ * rebuilt for the new mode when they boot, so the switch doesn't need the
+ * cores to be removed and probed again.
+ *
+ * The switch needs the cluster to describe both cores, as the lockstep
+ * core also runs from the TCM banks of the second core. It isn't supported
+ * on Versal-Net, whose TCM layout in lockstep isn't handled.
+ *
+ * Return: 0 for success, negative value for failure.
+ */
+static int xlnx_rpu_cluster_set_mode(struct xlnx_rpu_cluster *cluster,
+				     enum rpu_oper_mode mode)
+{
+	struct xlnx_rpu_rproc *z_rproc, *first;
+	int i = 0, ret = 0;
+
+	first = list_first_entry(&cluster->cores, struct xlnx_rpu_rproc, elem);
+	if (cluster->core_count != MAX_RPROCS ||
+	    first->soc_data->soc_type == SOC_VERSAL_NET)
+		return -EOPNOTSUPP;
+
+	mutex_lock(&cluster->lock);
+
+	if (mode == cluster->mode)
+		goto out;
+
+	/* Keep the cores from booting until the switch is done */
+	list_for_each_entry(z_rproc, &cluster->cores, elem)
+		mutex_lock_nested(&z_rproc->rproc->lock, i++);
+
+	list_for_each_entry(z_rproc, &cluster->cores, elem) {
+		if (z_rproc->rproc->state != RPROC_OFFLINE) {
+			ret = -EBUSY;
+			goto out_unlock;
+		}
+	}
+
+	list_for_each_entry(z_rproc, &cluster->cores, elem) {
+		ret = rpu_set_mode(z_rproc, mode);
+		if (ret || mode == PM_RPU_MODE_LOCKSTEP)
+			break;
+	}
+
+	if (ret) {
+		dev_err(first->dev, "failed to set RPU mode, %d\n", ret);
+		rpu_set_mode(first, cluster->mode);
+	} else {
+		cluster->mode = mode;
+	}
+
+out_unlock:
+	list_for_each_entry(z_rproc, &cluster->cores, elem)
+		mutex_unlock(&z_rproc->rproc->lock);
+out:
+	mutex_unlock(&cluster->lock);
+
+	return ret;
+}
+
+static ssize_t mode_show(struct device *dev, struct device_attribute *attr,
+			 char *buf)
+{
+	struct xlnx_rpu_cluster *cluster = dev_get_drvdata(dev);
+
+	return sysfs_emit(buf, "%s\n",
+			  cluster->mode == PM_RPU_MODE_LOCKSTEP ?
+			  "lockstep" : "split");
+}
+
+static ssize_t mode_store(struct device *dev, struct device_attribute *attr,
+			  const char *buf, size_t count)
+{
+	struct xlnx_rpu_cluster *cluster = dev_get_drvdata(dev);
+	enum rpu_oper_mode mode;
+	int ret;
+
+	if (sysfs_streq(buf, "lockstep"))
+		mode = PM_RPU_MODE_LOCKSTEP;
+	else if (sysfs_streq(buf, "split"))
+		mode = PM_RPU_MODE_SPLIT;
+	else
+		return -EINVAL;
+
+	ret = xlnx_rpu_cluster_set_mode(cluster, mode);
+
+	return ret ? ret : count;
+}
+static DEVICE_ATTR_RW(mode);
+
+static ssize_t state_store(struct device *dev, struct device_attribute *attr,
+			   const char *buf, size_t count)
+{
+	struct xlnx_rpu_cluster *cluster = dev_get_drvdata(dev);
+	int ret;
+
+	if (sysfs_streq(buf, "start"))
+		ret = xlnx_rpu_cluster_boot(cluster);
+	else if (sysfs_streq(buf, "stop"))
+		ret = xlnx_rpu_cluster_shutdown(cluster);
+	else
+		return -EINVAL;
+
+	return ret ? ret : count;
+}
+static DEVICE_ATTR_WO(state);
+
+static struct attribute *xlnx_rpu_cluster_attrs[] = {
+	&dev_attr_mode.attr,
+	&dev_attr_state.attr,
+	NULL
+};
+
+ATTRIBUTE_GROUPS(xlnx_rpu_cluster);
+
 /**
  * xlnx_rpu_probe() - Probes Xilinx RPU processor device node
  *		       this is called for each individual RPU core to
@@ -969,7 +1406,7 @@ static int xlnx_rpu_setup_mbox(struct xlnx_rpu_rproc *z_rproc,
  *
  * @pdev: domain platform device for current RPU core
  * @node: pointer of the device node for current RPU core
- * @rpu_mode: mode to configure RPU, split or lockstep
+ * @cluster: RPU cluster of the core, with the mode to configure it to
  * @data: structure to hold SoC specific data
  * @z_rproc: Xilinx specific remoteproc structure used later to link
  *           in to cluster of cores
@@ -978,7 +1415,7 @@ static int xlnx_rpu_setup_mbox(struct xlnx_rpu_rproc *z_rproc,
  */
 static int xlnx_rpu_probe(struct platform_device *pdev,
 			  struct device_node *node,
-			  enum rpu_oper_mode rpu_mode,
+			  struct xlnx_rpu_cluster *cluster,
 			  const struct xlnx_rpu_soc_data *data,
 			  struct xlnx_rpu_rproc **z_rproc)
 {
@@ -999,9 +1436,14 @@ static int xlnx_rpu_probe(struct platform_device *pdev,
 	}
 
 	rproc->auto_boot = false;
+	rproc_coredump_set_elf_info(rproc, ELFCLASS32, EM_ARM);
+	if (coredump_inline)
+		rproc->dump_conf = RPROC_COREDUMP_INLINE;
 	*z_rproc = rproc->priv;
 	(*z_rproc)->rproc = rproc;
 	(*z_rproc)->dev = dev;
+	(*z_rproc)->cluster = cluster;
+	INIT_WORK(&(*z_rproc)->boot_work, xlnx_rpu_boot_work);
 	/* Set up DMA mask */
 	ret = dma_set_coherent_mask(dev, DMA_BIT_MASK(32));
 	if (ret)
@@ -1090,7 +1532,7 @@ static int xlnx_rpu_probe(struct platform_device *pdev,
 		 * If we are here then we are using the rproc state that is
 		 * set by rproc_alloc (OFFLINE).
 		 */
-		ret = rpu_set_mode(*z_rproc, rpu_mode);
+		ret = rpu_set_mode(*z_rproc, cluster->mode);
 		if (ret)
 			goto error;
 
@@ -1120,7 +1562,7 @@ static int xlnx_rpu_remoteproc_probe(struct platform_device *pdev)
 	struct device *dev = &pdev->dev;
 	struct device_node *nc;
 	enum rpu_oper_mode rpu_mode = PM_RPU_MODE_LOCKSTEP;
-	struct list_head *cluster; /* list to track each core's rproc */
+	struct xlnx_rpu_cluster *cluster; /* tracks each core's rproc */
 	struct xlnx_rpu_rproc *z_rproc = NULL;
 	struct platform_device *child_pdev;
 	struct list_head *pos;
@@ -1150,7 +1592,10 @@ static int xlnx_rpu_remoteproc_probe(struct platform_device *pdev)
 	cluster = devm_kzalloc(dev, sizeof(*cluster), GFP_KERNEL);
 	if (!cluster)
 		return -ENOMEM;
-	INIT_LIST_HEAD(cluster);
+	INIT_LIST_HEAD(&cluster->cores);
+	cluster->core_count = core_count;
+	cluster->mode = rpu_mode;
+	mutex_init(&cluster->lock);
 
 	ret = devm_of_platform_populate(dev);
 	if (ret) {
@@ -1177,7 +1622,7 @@ static int xlnx_rpu_remoteproc_probe(struct platform_device *pdev)
 			ret = -ENODEV;
 			goto out;
 		}
-		ret = xlnx_rpu_probe(child_pdev, nc, rpu_mode, data,
+		ret = xlnx_rpu_probe(child_pdev, nc, cluster, data,
 				     &z_rproc);
 		dev_dbg(dev, "%s to probe rpu %pOF\n",
 			ret ? "Failed" : "Able",
@@ -1189,11 +1634,12 @@ static int xlnx_rpu_remoteproc_probe(struct platform_device *pdev)
 			goto out;
 		}
 
-		list_add_tail(&z_rproc->elem, cluster);
+		list_add_tail(&z_rproc->elem, &cluster->cores);
 		put_device(&child_pdev->dev);
 	}
 	/* wire in so each core can be cleaned up at driver remove */
 	platform_set_drvdata(pdev, cluster);
+
 	return 0;
 out:
 	/*
@@ -1203,8 +1649,8 @@ static int xlnx_rpu_remoteproc_probe(struct platform_device *pdev)
 	 * and ret to non-zero value if error
 	 */
 	if (ret && !z_rproc && rpu_mode == PM_RPU_MODE_SPLIT &&
-	    !list_empty(cluster)) {
-		list_for_each(pos, cluster) {
+	    !list_empty(&cluster->cores)) {
+		list_for_each(pos, &cluster->cores) {
 			z_rproc = list_entry(pos, struct xlnx_rpu_rproc, elem);
 			if (of_property_read_bool(z_rproc->dev->of_node, "mboxes")) {
 				mbox_free_channel(z_rproc->tx_chan);
@@ -1225,11 +1671,11 @@ static int xlnx_rpu_remoteproc_probe(struct platform_device *pdev)
  */
 static int xlnx_rpu_remoteproc_remove(struct platform_device *pdev)
 {
-	struct list_head *pos, *temp, *cluster = (struct list_head *)
-						 platform_get_drvdata(pdev);
+	struct xlnx_rpu_cluster *cluster = platform_get_drvdata(pdev);
 	struct xlnx_rpu_rproc *z_rproc = NULL;
+	struct list_head *pos, *temp;
 
-	list_for_each_safe(pos, temp, cluster) {
+	list_for_each_safe(pos, temp, &cluster->cores) {
 		z_rproc = list_entry(pos, struct xlnx_rpu_rproc, elem);
 
 		/*
@@ -1246,6 +1692,9 @@ static int xlnx_rpu_remoteproc_remove(struct platform_device *pdev)
 			mbox_free_channel(z_rproc->tx_chan);
 			mbox_free_channel(z_rproc->rx_chan);
 		}
+
+		release_firmware(z_rproc->fw_cache);
+		z_rproc->fw_cache = NULL;
 		list_del(pos);
 	}
 	return 0;
@@ -1284,6 +1733,7 @@ static struct platform_driver zynqmp_r5_remoteproc_driver = {
 	.driver = {
 		.name = "zynqmp_r5_remoteproc",
 		.of_match_table = xilinx_r5_of_match,
+		.dev_groups = xlnx_rpu_cluster_groups,
 	},
 };
 module_platform_driver(zynqmp_r5_remoteproc_driver);
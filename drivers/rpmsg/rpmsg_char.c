@@ -148,6 +148,8 @@ static int rpmsg_eptdev_open(struct inode *inode, struct file *filp)
 
 	eptdev->ept = ept;
 	filp->private_data = eptdev;
+	/* Reads and writes honour IOCB_NOWAIT, io_uring can poll instead */
+	filp->f_mode |= FMODE_NOWAIT;
 	mutex_unlock(&eptdev->ept_lock);
 
 	return 0;
@@ -175,39 +177,44 @@ static int rpmsg_eptdev_release(struct inode *inode, struct file *filp)
 	return 0;
 }
 
-static ssize_t rpmsg_eptdev_read_iter(struct kiocb *iocb, struct iov_iter *to)
+/* Wait for data in the queue, or until the endpoint goes away */
+static int rpmsg_eptdev_wait_data(struct rpmsg_eptdev *eptdev, bool nonblock)
 {
-	struct file *filp = iocb->ki_filp;
-	struct rpmsg_eptdev *eptdev = filp->private_data;
-	unsigned long flags;
-	struct sk_buff *skb;
-	int use;
-
 	if (!eptdev->ept)
 		return -EPIPE;
 
-	spin_lock_irqsave(&eptdev->queue_lock, flags);
+	if (!skb_queue_empty(&eptdev->queue))
+		return 0;
 
-	/* Wait for data in the queue */
-	if (skb_queue_empty(&eptdev->queue)) {
-		spin_unlock_irqrestore(&eptdev->queue_lock, flags);
+	if (nonblock)
+		return -EAGAIN;
 
-		if (filp->f_flags & O_NONBLOCK)
-			return -EAGAIN;
+	if (wait_event_interruptible(eptdev->readq,
+				     !skb_queue_empty(&eptdev->queue) ||
+				     !eptdev->ept))
+		return -ERESTARTSYS;
 
-		/* Wait until we get data or the endpoint goes away */
-		if (wait_event_interruptible(eptdev->readq,
-					     !skb_queue_empty(&eptdev->queue) ||
-					     !eptdev->ept))
-			return -ERESTARTSYS;
+	/* We lost the endpoint while waiting */
+	if (!eptdev->ept)
+		return -EPIPE;
 
-		/* We lost the endpoint while waiting */
-		if (!eptdev->ept)
-			return -EPIPE;
+	return 0;
+}
 
-		spin_lock_irqsave(&eptdev->queue_lock, flags);
-	}
+static ssize_t rpmsg_eptdev_read_iter(struct kiocb *iocb, struct iov_iter *to)
+{
+	struct file *filp = iocb->ki_filp;
+	struct rpmsg_eptdev *eptdev = filp->private_data;
+	unsigned long flags;
+	struct sk_buff *skb;
+	int use;
 
+	use = rpmsg_eptdev_wait_data(eptdev, filp->f_flags & O_NONBLOCK ||
+				     iocb->ki_flags & IOCB_NOWAIT);
+	if (use)
+		return use;
+
+	spin_lock_irqsave(&eptdev->queue_lock, flags);
 	skb = skb_dequeue(&eptdev->queue);
 	spin_unlock_irqrestore(&eptdev->queue_lock, flags);
 	if (!skb)
@@ -222,6 +229,65 @@ static ssize_t rpmsg_eptdev_read_iter(struct kiocb *iocb, struct iov_iter *to)
 	return use;
 }
 
+static long rpmsg_eptdev_recv_batch(struct rpmsg_eptdev *eptdev, bool nonblock,
+				    struct rpmsg_recv_batch __user *ubatch)
+{
+	struct rpmsg_recv_batch batch;
+	struct sk_buff_head list;
+	struct sk_buff *skb;
+	u8 __user *buf;
+	u32 __user *lens;
+	unsigned long flags;
+	u32 off = 0, n = 0;
+	long ret;
+
+	if (copy_from_user(&batch, ubatch, sizeof(batch)))
+		return -EFAULT;
+
+	if (!batch.buf_len || !batch.num_msgs)
+		return -EINVAL;
+
+	ret = rpmsg_eptdev_wait_data(eptdev, nonblock);
+	if (ret)
+		return ret;
+
+	/* Take all the messages that fit in a single pass over the queue */
+	__skb_queue_head_init(&list);
+	spin_lock_irqsave(&eptdev->queue_lock, flags);
+	while (n < batch.num_msgs && off < batch.buf_len) {
+		skb = skb_peek(&eptdev->queue);
+		if (!skb || (n && skb->len > batch.buf_len - off))
+			break;
+
+		skb_unlink(skb, &eptdev->queue);
+		__skb_queue_tail(&list, skb);
+		off += min(skb->len, batch.buf_len - off);
+		n++;
+	}
+	spin_unlock_irqrestore(&eptdev->queue_lock, flags);
+
+	buf = u64_to_user_ptr(batch.buf);
+	lens = u64_to_user_ptr(batch.lens);
+	off = 0;
+	n = 0;
+	while ((skb = __skb_dequeue(&list))) {
+		u32 use = min(skb->len, batch.buf_len - off);
+
+		if (copy_to_user(buf + off, skb->data, use) ||
+		    put_user(use, lens + n))
+			ret = -EFAULT;
+
+		off += use;
+		n++;
+		kfree_skb(skb);
+	}
+
+	if (put_user(n, &ubatch->num_msgs))
+		ret = -EFAULT;
+
+	return ret;
+}
+
 static ssize_t rpmsg_eptdev_write_iter(struct kiocb *iocb,
 				       struct iov_iter *from)
 {
@@ -240,7 +306,12 @@ static ssize_t rpmsg_eptdev_write_iter(struct kiocb *iocb,
 		goto free_kbuf;
 	}
 
-	if (mutex_lock_interruptible(&eptdev->ept_lock)) {
+	if (iocb->ki_flags & IOCB_NOWAIT) {
+		if (!mutex_trylock(&eptdev->ept_lock)) {
+			ret = -EAGAIN;
+			goto free_kbuf;
+		}
+	} else if (mutex_lock_interruptible(&eptdev->ept_lock)) {
 		ret = -ERESTARTSYS;
 		goto free_kbuf;
 	}
@@ -250,7 +321,7 @@ static ssize_t rpmsg_eptdev_write_iter(struct kiocb *iocb,
 		goto unlock_eptdev;
 	}
 
-	if (filp->f_flags & O_NONBLOCK) {
+	if (filp->f_flags & O_NONBLOCK || iocb->ki_flags & IOCB_NOWAIT) {
 		ret = rpmsg_trysendto(eptdev->ept, kbuf, len, eptdev->chinfo.dst);
 		if (ret == -ENOMEM)
 			ret = -EAGAIN;
@@ -289,14 +360,19 @@ static long rpmsg_eptdev_ioctl(struct file *fp, unsigned int cmd,
 {
 	struct rpmsg_eptdev *eptdev = fp->private_data;
 
-	if (cmd != RPMSG_DESTROY_EPT_IOCTL)
-		return -EINVAL;
-
-	/* Don't allow to destroy a default endpoint. */
-	if (eptdev->default_ept)
+	switch (cmd) {
+	case RPMSG_DESTROY_EPT_IOCTL:
+		/* Don't allow to destroy a default endpoint. */
+		if (eptdev->default_ept)
+			return -EINVAL;
+
+		return rpmsg_chrdev_eptdev_destroy(&eptdev->dev, NULL);
+	case RPMSG_RECV_BATCH_IOCTL:
+		return rpmsg_eptdev_recv_batch(eptdev, fp->f_flags & O_NONBLOCK,
+					       (void __user *)arg);
+	default:
 		return -EINVAL;
-
-	return rpmsg_chrdev_eptdev_destroy(&eptdev->dev, NULL);
+	}
 }
 
 static const struct file_operations rpmsg_eptdev_fops = {
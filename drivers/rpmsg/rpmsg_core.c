@@ -351,6 +351,115 @@ ssize_t rpmsg_get_mtu(struct rpmsg_endpoint *ept)
 }
 EXPORT_SYMBOL(rpmsg_get_mtu);
 
+/**
+ * rpmsg_get_tx_buffer() - get a transmit buffer to fill in place
+ * @ept: the rpmsg endpoint
+ * @len: filled with the maximum payload length of the buffer
+ * @wait: block until a buffer is available
+ *
+ * This function hands out the payload area of one of the TX buffers that
+ * are shared with the remote processor, the message can then be written to
+ * it directly and sent with rpmsg_sendto_nocopy() without another copy.
+ * A buffer that ends up not being sent must be given back with
+ * rpmsg_release_tx_buffer().
+ *
+ * Can only be called from process context (for now).
+ *
+ * Return: the payload area of the buffer on success and an ERR_PTR() on
+ * failure, -ENOMEM if @wait is false and no buffer is available.
+ */
+void *rpmsg_get_tx_buffer(struct rpmsg_endpoint *ept, unsigned int *len,
+			  bool wait)
+{
+	if (WARN_ON(!ept))
+		return ERR_PTR(-EINVAL);
+	if (!ept->ops->get_tx_buffer)
+		return ERR_PTR(-ENXIO);
+
+	return ept->ops->get_tx_buffer(ept, len, wait);
+}
+EXPORT_SYMBOL(rpmsg_get_tx_buffer);
+
+/**
+ * rpmsg_release_tx_buffer() - give back an unsent transmit buffer
+ * @ept: the rpmsg endpoint
+ * @data: payload area returned by rpmsg_get_tx_buffer()
+ */
+void rpmsg_release_tx_buffer(struct rpmsg_endpoint *ept, void *data)
+{
+	if (WARN_ON(!ept))
+		return;
+	if (ept->ops->release_tx_buffer)
+		ept->ops->release_tx_buffer(ept, data);
+}
+EXPORT_SYMBOL(rpmsg_release_tx_buffer);
+
+/**
+ * rpmsg_sendto_nocopy() - send a message filled in a transmit buffer
+ * @ept: the rpmsg endpoint
+ * @data: payload area returned by rpmsg_get_tx_buffer()
+ * @len: length of payload
+ * @dst: destination address
+ *
+ * This function sends the message written to @data in place to the remote
+ * @dst address and uses @ept's address as the source address. The buffer
+ * belongs to the transport again once the function returns, whether it
+ * succeeds or not.
+ *
+ * Can only be called from process context (for now).
+ *
+ * Return: 0 on success and an appropriate error value on failure.
+ */
+int rpmsg_sendto_nocopy(struct rpmsg_endpoint *ept, void *data, int len,
+			u32 dst)
+{
+	if (WARN_ON(!ept))
+		return -EINVAL;
+	if (!ept->ops->sendto_nocopy)
+		return -ENXIO;
+
+	return ept->ops->sendto_nocopy(ept, data, len, dst);
+}
+EXPORT_SYMBOL(rpmsg_sendto_nocopy);
+
+/**
+ * rpmsg_hold_rx_buffer() - keep a received buffer after the rx callback
+ * @ept: the rpmsg endpoint
+ * @data: message payload passed to the rx callback
+ *
+ * Must be called from the rx callback. The buffer is not handed back to
+ * the remote processor when the callback returns, so the payload can be
+ * processed in place later on. It must be given back with
+ * rpmsg_release_rx_buffer(), held buffers are not available to the remote
+ * for new messages.
+ *
+ * Return: 0 on success and an appropriate error value on failure.
+ */
+int rpmsg_hold_rx_buffer(struct rpmsg_endpoint *ept, void *data)
+{
+	if (WARN_ON(!ept))
+		return -EINVAL;
+	if (!ept->ops->hold_rx_buffer)
+		return -ENXIO;
+
+	return ept->ops->hold_rx_buffer(ept, data);
+}
+EXPORT_SYMBOL(rpmsg_hold_rx_buffer);
+
+/**
+ * rpmsg_release_rx_buffer() - give back a held receive buffer
+ * @ept: the rpmsg endpoint
+ * @data: message payload passed to rpmsg_hold_rx_buffer()
+ */
+void rpmsg_release_rx_buffer(struct rpmsg_endpoint *ept, void *data)
+{
+	if (WARN_ON(!ept))
+		return;
+	if (ept->ops->release_rx_buffer)
+		ept->ops->release_rx_buffer(ept, data);
+}
+EXPORT_SYMBOL(rpmsg_release_rx_buffer);
+
 /*
  * match a rpmsg channel with a channel info struct.
  * this is used to make sure we're not creating rpmsg devices for channels
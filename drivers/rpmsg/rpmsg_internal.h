@@ -56,6 +56,11 @@ struct rpmsg_device_ops {
  * @trysend_offchannel:	see @rpmsg_trysend_offchannel(), optional
  * @poll:		see @rpmsg_poll(), optional
  * @get_mtu:		see @rpmsg_get_mtu(), optional
+ * @get_tx_buffer:	see @rpmsg_get_tx_buffer(), optional
+ * @release_tx_buffer:	see @rpmsg_release_tx_buffer(), optional
+ * @sendto_nocopy:	see @rpmsg_sendto_nocopy(), optional
+ * @hold_rx_buffer:	see @rpmsg_hold_rx_buffer(), optional
+ * @release_rx_buffer:	see @rpmsg_release_rx_buffer(), optional
  *
  * Indirection table for the operations that a rpmsg backend should implement.
  * In addition to @destroy_ept, the backend must at least implement @send and
@@ -76,6 +81,14 @@ struct rpmsg_endpoint_ops {
 	__poll_t (*poll)(struct rpmsg_endpoint *ept, struct file *filp,
 			     poll_table *wait);
 	ssize_t (*get_mtu)(struct rpmsg_endpoint *ept);
+
+	void *(*get_tx_buffer)(struct rpmsg_endpoint *ept, unsigned int *len,
+			       bool wait);
+	void (*release_tx_buffer)(struct rpmsg_endpoint *ept, void *data);
+	int (*sendto_nocopy)(struct rpmsg_endpoint *ept, void *data, int len,
+			     u32 dst);
+	int (*hold_rx_buffer)(struct rpmsg_endpoint *ept, void *data);
+	void (*release_rx_buffer)(struct rpmsg_endpoint *ept, void *data);
 };
 
 struct device *rpmsg_find_device(struct device *parent,
@@ -11,6 +11,7 @@
 
 #define pr_fmt(fmt) "%s: " fmt, __func__
 
+#include <linux/bitmap.h>
 #include <linux/dma-mapping.h>
 #include <linux/idr.h>
 #include <linux/jiffies.h>
@@ -39,12 +40,18 @@
  * @rbufs:	kernel address of rx buffers
  * @sbufs:	kernel address of tx buffers
  * @num_bufs:	total number of buffers for rx and tx
- * @buf_size:   size of one rx or tx buffer
+ * @rbuf_size:	size of one rx buffer
+ * @sbuf_size:	size of one tx buffer
  * @last_sbuf:	index of last tx buffer used
+ * @free_sbufs:	bitmap of the tx buffers handed out for in place sending and
+ *		given back, kept out of the shared buffers
  * @bufs_dma:	dma base addr of the buffers
  * @tx_lock:	protects svq, sbufs and sleepers, to allow concurrent senders.
  *		sending a message might require waking up a dozing remote
  *		processor, which involves sleeping, hence the mutex.
+ * @rx_lock:	protects rvq against the release of held rx buffers
+ * @rx_cur:	rx buffer whose message is being delivered
+ * @rx_held:	the rx callback held @rx_cur
  * @endpoints:	idr of local endpoints, allows fast retrieval
  * @endpoints_lock: lock of the endpoints set
  * @sendq:	wait queue of sending contexts waiting for a tx buffers
@@ -59,10 +66,15 @@ struct virtproc_info {
 	struct virtqueue *rvq, *svq;
 	void *rbufs, *sbufs;
 	unsigned int num_bufs;
-	unsigned int buf_size;
+	unsigned int rbuf_size;
+	unsigned int sbuf_size;
 	int last_sbuf;
+	unsigned long *free_sbufs;
 	dma_addr_t bufs_dma;
 	struct mutex tx_lock;
+	spinlock_t rx_lock;
+	struct rpmsg_hdr *rx_cur;
+	bool rx_held;
 	struct idr endpoints;
 	struct mutex endpoints_lock;
 	wait_queue_head_t sendq;
@@ -71,6 +83,19 @@ struct virtproc_info {
 
 /* The feature bitmap for virtio rpmsg */
 #define VIRTIO_RPMSG_F_NS	0 /* RP supports name service notifications */
+#define VIRTIO_RPMSG_F_BUFSZ	2 /* RP provides the buffer sizes in config */
+
+/**
+ * struct virtio_rpmsg_config - config space of the rpmsg virtio device
+ * @txbuf_size: size of the buffers the remote processor sends to us
+ * @rxbuf_size: size of the buffers the remote processor receives from us
+ *
+ * Only valid with VIRTIO_RPMSG_F_BUFSZ, the sizes include the rpmsg header.
+ */
+struct virtio_rpmsg_config {
+	__virtio32 txbuf_size;
+	__virtio32 rxbuf_size;
+} __packed;
 
 /**
  * struct rpmsg_hdr - common header for all rpmsg messages
@@ -119,9 +144,9 @@ struct virtio_rpmsg_channel {
  * Each buffer will have 16 bytes for the msg header and remaining for
  * the payload.
  *
- * We might also want to add support for user-provided buffers in time.
- * This will allow bigger buffer size flexibility, and can also be used
- * to achieve zero-copy messaging.
+ * A remote processor offering VIRTIO_RPMSG_F_BUFSZ sets the size of the
+ * buffers of each direction instead, large payloads can then be written
+ * and read in place with rpmsg_get_tx_buffer() and rpmsg_hold_rx_buffer().
  *
  * Note that these numbers are purely a decision of this driver - we
  * can change this without changing anything in the firmware of the remote
@@ -135,6 +160,11 @@ struct virtio_rpmsg_channel {
 #define MAX_RPMSG_BUF_SIZE CONFIG_RPMSG_VIRTIO_BUF_SIZE
 #endif
 
+/* Negotiated buffer sizes must fit a name service message and a u16 length */
+#define MIN_RPMSG_BUF_SIZE	(sizeof(struct rpmsg_hdr) + \
+				 sizeof(struct rpmsg_ns_msg))
+#define MAX_RPMSG_NEGOTIATED_BUF_SIZE	(sizeof(struct rpmsg_hdr) + U16_MAX)
+
 /*
  * Local addresses are dynamically allocated on-demand.
  * We do not dynamically assign addresses from the low 1024 range,
@@ -154,6 +184,15 @@ static int virtio_rpmsg_trysendto(struct rpmsg_endpoint *ept, void *data,
 static int virtio_rpmsg_trysend_offchannel(struct rpmsg_endpoint *ept, u32 src,
 					   u32 dst, void *data, int len);
 static ssize_t virtio_rpmsg_get_mtu(struct rpmsg_endpoint *ept);
+static void *virtio_rpmsg_get_tx_buffer(struct rpmsg_endpoint *ept,
+					unsigned int *len, bool wait);
+static void virtio_rpmsg_release_tx_buffer(struct rpmsg_endpoint *ept,
+					   void *data);
+static int virtio_rpmsg_sendto_nocopy(struct rpmsg_endpoint *ept, void *data,
+				      int len, u32 dst);
+static int virtio_rpmsg_hold_rx_buffer(struct rpmsg_endpoint *ept, void *data);
+static void virtio_rpmsg_release_rx_buffer(struct rpmsg_endpoint *ept,
+					   void *data);
 static struct rpmsg_device *__rpmsg_create_channel(struct virtproc_info *vrp,
 						   struct rpmsg_channel_info *chinfo);
 
@@ -166,6 +205,11 @@ static const struct rpmsg_endpoint_ops virtio_endpoint_ops = {
 	.trysendto = virtio_rpmsg_trysendto,
 	.trysend_offchannel = virtio_rpmsg_trysend_offchannel,
 	.get_mtu = virtio_rpmsg_get_mtu,
+	.get_tx_buffer = virtio_rpmsg_get_tx_buffer,
+	.release_tx_buffer = virtio_rpmsg_release_tx_buffer,
+	.sendto_nocopy = virtio_rpmsg_sendto_nocopy,
+	.hold_rx_buffer = virtio_rpmsg_hold_rx_buffer,
+	.release_rx_buffer = virtio_rpmsg_release_rx_buffer,
 };
 
 /**
@@ -440,24 +484,37 @@ static struct rpmsg_device *__rpmsg_create_channel(struct virtproc_info *vrp,
 	return rpdev;
 }
 
+static unsigned int rpmsg_sbuf_index(struct virtproc_info *vrp,
+				     struct rpmsg_hdr *msg)
+{
+	return ((void *)msg - vrp->sbufs) / vrp->sbuf_size;
+}
+
 /* super simple buffer "allocator" that is just enough for now */
 static void *get_a_tx_buf(struct virtproc_info *vrp)
 {
-	unsigned int len;
+	unsigned int len, i;
 	void *ret;
 
 	/* support multiple concurrent senders */
 	mutex_lock(&vrp->tx_lock);
 
+	i = find_first_bit(vrp->free_sbufs, vrp->num_bufs / 2);
+
 	/*
 	 * either pick the next unused tx buffer
 	 * (half of our buffers are used for sending messages)
 	 */
-	if (vrp->last_sbuf < vrp->num_bufs / 2)
-		ret = vrp->sbufs + vrp->buf_size * vrp->last_sbuf++;
+	if (vrp->last_sbuf < vrp->num_bufs / 2) {
+		ret = vrp->sbufs + vrp->sbuf_size * vrp->last_sbuf++;
+	/* or one that was handed out but not sent */
+	} else if (i < vrp->num_bufs / 2) {
+		clear_bit(i, vrp->free_sbufs);
+		ret = vrp->sbufs + vrp->sbuf_size * i;
 	/* or recycle a used one */
-	else
+	} else {
 		ret = virtqueue_get_buf(vrp->svq, &len);
+	}
 
 	mutex_unlock(&vrp->tx_lock);
 
@@ -521,23 +578,11 @@ static void rpmsg_downref_sleepers(struct virtproc_info *vrp)
 }
 
 /**
- * rpmsg_send_offchannel_raw() - send a message across to the remote processor
- * @rpdev: the rpmsg channel
- * @src: source address
- * @dst: destination address
- * @data: payload of message
- * @len: length of payload
+ * rpmsg_get_tx_buf_wait() - grab a tx buffer, waiting for one if needed
+ * @vrp: virtual remote processor state
+ * @dev: device used for error messages
  * @wait: indicates whether caller should block in case no TX buffers available
  *
- * This function is the base implementation for all of the rpmsg sending API.
- *
- * It will send @data of length @len to @dst, and say it's from @src. The
- * message will be sent to the remote processor which the @rpdev channel
- * belongs to.
- *
- * The message is sent using one of the TX buffers that are available for
- * communication with this remote processor.
- *
  * If @wait is true, the caller will be blocked until either a TX buffer is
  * available, or 15 seconds elapses (we don't want callers to
  * sleep indefinitely due to misbehaving remote processors), and in that
@@ -548,48 +593,18 @@ static void rpmsg_downref_sleepers(struct virtproc_info *vrp)
  * Otherwise, if @wait is false, and there are no TX buffers available,
  * the function will immediately fail, and -ENOMEM will be returned.
  *
- * Normally drivers shouldn't use this function directly; instead, drivers
- * should use the appropriate rpmsg_{try}send{to, _offchannel} API
- * (see include/linux/rpmsg.h).
- *
- * Return: 0 on success and an appropriate error value on failure.
+ * Return: the tx buffer on success and an ERR_PTR() on failure.
  */
-static int rpmsg_send_offchannel_raw(struct rpmsg_device *rpdev,
-				     u32 src, u32 dst,
-				     void *data, int len, bool wait)
+static struct rpmsg_hdr *rpmsg_get_tx_buf_wait(struct virtproc_info *vrp,
+					       struct device *dev, bool wait)
 {
-	struct virtio_rpmsg_channel *vch = to_virtio_rpmsg_channel(rpdev);
-	struct virtproc_info *vrp = vch->vrp;
-	struct device *dev = &rpdev->dev;
-	const struct vring *vr;
-	struct scatterlist sg;
 	struct rpmsg_hdr *msg;
 	int err;
 
-	/* bcasting isn't allowed */
-	if (src == RPMSG_ADDR_ANY || dst == RPMSG_ADDR_ANY) {
-		dev_err(dev, "invalid addr (src 0x%x, dst 0x%x)\n", src, dst);
-		return -EINVAL;
-	}
-
-	/*
-	 * We currently use fixed-sized buffers, and therefore the payload
-	 * length is limited.
-	 *
-	 * One of the possible improvements here is either to support
-	 * user-provided buffers (and then we can also support zero-copy
-	 * messaging), or to improve the buffer allocator, to support
-	 * variable-length buffer sizes.
-	 */
-	if (len > vrp->buf_size - sizeof(struct rpmsg_hdr)) {
-		dev_err(dev, "message is too big (%d)\n", len);
-		return -EMSGSIZE;
-	}
-
 	/* grab a buffer */
 	msg = get_a_tx_buf(vrp);
 	if (!msg && !wait)
-		return -ENOMEM;
+		return ERR_PTR(-ENOMEM);
 
 	/* no free buffer ? wait for one (but bail after 15 seconds) */
 	while (!msg) {
@@ -612,16 +627,41 @@ static int rpmsg_send_offchannel_raw(struct rpmsg_device *rpdev,
 		/* timeout ? */
 		if (!err) {
 			dev_err(dev, "timeout waiting for a tx buffer\n");
-			return -ERESTARTSYS;
+			return ERR_PTR(-ERESTARTSYS);
 		}
 	}
 
+	return msg;
+}
+
+/**
+ * rpmsg_send_buf() - send a filled tx buffer to the remote processor
+ * @rpdev: the rpmsg channel
+ * @msg: tx buffer, with the payload already in place
+ * @src: source address
+ * @dst: destination address
+ * @len: length of payload
+ *
+ * A buffer that can't be added to the virtqueue is kept for the next
+ * sender, so it is never lost.
+ *
+ * Return: 0 on success and an appropriate error value on failure.
+ */
+static int rpmsg_send_buf(struct rpmsg_device *rpdev, struct rpmsg_hdr *msg,
+			  u32 src, u32 dst, int len)
+{
+	struct virtio_rpmsg_channel *vch = to_virtio_rpmsg_channel(rpdev);
+	struct virtproc_info *vrp = vch->vrp;
+	struct device *dev = &rpdev->dev;
+	const struct vring *vr;
+	struct scatterlist sg;
+	int err;
+
 	msg->len = cpu_to_rpmsg16(rpdev, len);
 	msg->flags = 0;
 	msg->src = cpu_to_rpmsg32(rpdev, src);
 	msg->dst = cpu_to_rpmsg32(rpdev, dst);
 	msg->reserved = 0;
-	memcpy(msg->data, data, len);
 
 	dev_dbg(dev, "TX From 0x%x, To 0x%x, Len %d, Flags %d, Reserved %d\n",
 		src, dst, len, msg->flags, msg->reserved);
@@ -642,12 +682,9 @@ static int rpmsg_send_offchannel_raw(struct rpmsg_device *rpdev,
 	/* add message to the remote processor's virtqueue */
 	err = virtqueue_add_outbuf(vrp->svq, &sg, 1, msg, GFP_KERNEL);
 	if (err) {
-		/*
-		 * need to reclaim the buffer here, otherwise it's lost
-		 * (memory won't leak, but rpmsg won't use it again for TX).
-		 * this will wait for a buffer management overhaul.
-		 */
+		/* reclaim the buffer here, otherwise rpmsg won't use it again */
 		dev_err(dev, "virtqueue_add_outbuf failed: %d\n", err);
+		set_bit(rpmsg_sbuf_index(vrp, msg), vrp->free_sbufs);
 		goto out;
 	}
 
@@ -658,6 +695,65 @@ static int rpmsg_send_offchannel_raw(struct rpmsg_device *rpdev,
 	return err;
 }
 
+/**
+ * rpmsg_send_offchannel_raw() - send a message across to the remote processor
+ * @rpdev: the rpmsg channel
+ * @src: source address
+ * @dst: destination address
+ * @data: payload of message
+ * @len: length of payload
+ * @wait: indicates whether caller should block in case no TX buffers available
+ *
+ * This function is the base implementation for all of the rpmsg sending API.
+ *
+ * It will send @data of length @len to @dst, and say it's from @src. The
+ * message will be sent to the remote processor which the @rpdev channel
+ * belongs to.
+ *
+ * The message is sent using one of the TX buffers that are available for
+ * communication with this remote processor, see rpmsg_get_tx_buf_wait()
+ * for the handling of @wait.
+ *
+ * Normally drivers shouldn't use this function directly; instead, drivers
+ * should use the appropriate rpmsg_{try}send{to, _offchannel} API
+ * (see include/linux/rpmsg.h).
+ *
+ * Return: 0 on success and an appropriate error value on failure.
+ */
+static int rpmsg_send_offchannel_raw(struct rpmsg_device *rpdev,
+				     u32 src, u32 dst,
+				     void *data, int len, bool wait)
+{
+	struct virtio_rpmsg_channel *vch = to_virtio_rpmsg_channel(rpdev);
+	struct virtproc_info *vrp = vch->vrp;
+	struct device *dev = &rpdev->dev;
+	struct rpmsg_hdr *msg;
+
+	/* bcasting isn't allowed */
+	if (src == RPMSG_ADDR_ANY || dst == RPMSG_ADDR_ANY) {
+		dev_err(dev, "invalid addr (src 0x%x, dst 0x%x)\n", src, dst);
+		return -EINVAL;
+	}
+
+	/*
+	 * We currently use fixed-sized buffers, and therefore the payload
+	 * length is limited. Larger messages need larger buffers negotiated
+	 * with VIRTIO_RPMSG_F_BUFSZ.
+	 */
+	if (len > vrp->sbuf_size - sizeof(struct rpmsg_hdr)) {
+		dev_err(dev, "message is too big (%d)\n", len);
+		return -EMSGSIZE;
+	}
+
+	msg = rpmsg_get_tx_buf_wait(vrp, dev, wait);
+	if (IS_ERR(msg))
+		return PTR_ERR(msg);
+
+	memcpy(msg->data, data, len);
+
+	return rpmsg_send_buf(rpdev, msg, src, dst, len);
+}
+
 static int virtio_rpmsg_send(struct rpmsg_endpoint *ept, void *data, int len)
 {
 	struct rpmsg_device *rpdev = ept->rpdev;
@@ -713,14 +809,143 @@ static ssize_t virtio_rpmsg_get_mtu(struct rpmsg_endpoint *ept)
 	struct rpmsg_device *rpdev = ept->rpdev;
 	struct virtio_rpmsg_channel *vch = to_virtio_rpmsg_channel(rpdev);
 
-	return vch->vrp->buf_size - sizeof(struct rpmsg_hdr);
+	return vch->vrp->sbuf_size - sizeof(struct rpmsg_hdr);
+}
+
+/* Get the tx buffer of a payload handed out by virtio_rpmsg_get_tx_buffer() */
+static struct rpmsg_hdr *rpmsg_tx_buf_of(struct virtproc_info *vrp, void *data)
+{
+	struct rpmsg_hdr *msg = container_of(data, struct rpmsg_hdr, data);
+	size_t off = (void *)msg - vrp->sbufs;
+
+	if ((void *)msg < vrp->sbufs || off % vrp->sbuf_size ||
+	    off / vrp->sbuf_size >= vrp->num_bufs / 2)
+		return NULL;
+
+	return msg;
+}
+
+static void *virtio_rpmsg_get_tx_buffer(struct rpmsg_endpoint *ept,
+					unsigned int *len, bool wait)
+{
+	struct virtio_rpmsg_channel *vch = to_virtio_rpmsg_channel(ept->rpdev);
+	struct virtproc_info *vrp = vch->vrp;
+	struct rpmsg_hdr *msg;
+
+	msg = rpmsg_get_tx_buf_wait(vrp, &ept->rpdev->dev, wait);
+	if (IS_ERR(msg))
+		return msg;
+
+	*len = vrp->sbuf_size - sizeof(*msg);
+	return msg->data;
+}
+
+static void virtio_rpmsg_release_tx_buffer(struct rpmsg_endpoint *ept,
+					   void *data)
+{
+	struct virtio_rpmsg_channel *vch = to_virtio_rpmsg_channel(ept->rpdev);
+	struct virtproc_info *vrp = vch->vrp;
+	struct rpmsg_hdr *msg = rpmsg_tx_buf_of(vrp, data);
+
+	if (WARN_ON(!msg))
+		return;
+
+	mutex_lock(&vrp->tx_lock);
+	set_bit(rpmsg_sbuf_index(vrp, msg), vrp->free_sbufs);
+	mutex_unlock(&vrp->tx_lock);
+
+	/* senders may be waiting for a tx buffer */
+	wake_up_interruptible(&vrp->sendq);
+}
+
+static int virtio_rpmsg_sendto_nocopy(struct rpmsg_endpoint *ept, void *data,
+				      int len, u32 dst)
+{
+	struct rpmsg_device *rpdev = ept->rpdev;
+	struct virtio_rpmsg_channel *vch = to_virtio_rpmsg_channel(rpdev);
+	struct virtproc_info *vrp = vch->vrp;
+	struct rpmsg_hdr *msg = rpmsg_tx_buf_of(vrp, data);
+
+	if (WARN_ON(!msg))
+		return -EINVAL;
+
+	if (ept->addr == RPMSG_ADDR_ANY || dst == RPMSG_ADDR_ANY ||
+	    len < 0 || len > vrp->sbuf_size - sizeof(*msg)) {
+		virtio_rpmsg_release_tx_buffer(ept, data);
+		return -EINVAL;
+	}
+
+	return rpmsg_send_buf(rpdev, msg, ept->addr, dst, len);
+}
+
+static int virtio_rpmsg_hold_rx_buffer(struct rpmsg_endpoint *ept, void *data)
+{
+	struct virtio_rpmsg_channel *vch = to_virtio_rpmsg_channel(ept->rpdev);
+	struct virtproc_info *vrp = vch->vrp;
+
+	/* only the message being delivered can be held */
+	if (!vrp->rx_cur || data != vrp->rx_cur->data)
+		return -EINVAL;
+
+	vrp->rx_held = true;
+	return 0;
+}
+
+/* add an rx buffer back to the remote processor's virtqueue */
+static int rpmsg_add_rx_buf(struct virtproc_info *vrp, struct rpmsg_hdr *msg)
+{
+	struct scatterlist sg;
+	unsigned long flags;
+	int err;
+
+	/* publish the real size of the buffer */
+	rpmsg_sg_init(&sg, msg, vrp->rbuf_size);
+
+	spin_lock_irqsave(&vrp->rx_lock, flags);
+	err = virtqueue_add_inbuf(vrp->rvq, &sg, 1, msg, GFP_ATOMIC);
+	spin_unlock_irqrestore(&vrp->rx_lock, flags);
+
+	return err;
+}
+
+static void virtio_rpmsg_release_rx_buffer(struct rpmsg_endpoint *ept,
+					   void *data)
+{
+	struct virtio_rpmsg_channel *vch = to_virtio_rpmsg_channel(ept->rpdev);
+	struct virtproc_info *vrp = vch->vrp;
+	struct rpmsg_hdr *msg = container_of(data, struct rpmsg_hdr, data);
+	size_t off = (void *)msg - vrp->rbufs;
+	struct scatterlist sg;
+	unsigned long flags;
+	bool notify;
+	int err;
+
+	if (WARN_ON((void *)msg < vrp->rbufs || off % vrp->rbuf_size ||
+		    off / vrp->rbuf_size >= vrp->num_bufs / 2))
+		return;
+
+	rpmsg_sg_init(&sg, msg, vrp->rbuf_size);
+
+	/* the rx callback may add buffers at the same time */
+	spin_lock_irqsave(&vrp->rx_lock, flags);
+	err = virtqueue_add_inbuf(vrp->rvq, &sg, 1, msg, GFP_ATOMIC);
+	notify = !err && virtqueue_kick_prepare(vrp->rvq);
+	spin_unlock_irqrestore(&vrp->rx_lock, flags);
+
+	if (err < 0) {
+		dev_err(&ept->rpdev->dev, "failed to add a virtqueue buffer: %d\n",
+			err);
+		return;
+	}
+
+	if (notify)
+		virtqueue_notify(vrp->rvq);
 }
 
 static int rpmsg_recv_single(struct virtproc_info *vrp, struct device *dev,
 			     struct rpmsg_hdr *msg, unsigned int len)
 {
 	struct rpmsg_endpoint *ept;
-	struct scatterlist sg;
 	bool little_endian = virtio_is_little_endian(vrp->vdev);
 	unsigned int msg_len = __rpmsg16_to_cpu(little_endian, msg->len);
 	const struct vring *vr;
@@ -745,7 +970,7 @@ static int rpmsg_recv_single(struct virtproc_info *vrp, struct device *dev,
 	 * We currently use fixed-sized buffers, so trivially sanitize
 	 * the reported payload length.
 	 */
-	if (len > vrp->buf_size ||
+	if (len > vrp->rbuf_size ||
 	    msg_len > (len - sizeof(struct rpmsg_hdr))) {
 		dev_warn(dev, "inbound msg too big: (%d, %d)\n", len, msg_len);
 		return -EINVAL;
@@ -766,9 +991,11 @@ static int rpmsg_recv_single(struct virtproc_info *vrp, struct device *dev,
 		/* make sure ept->cb doesn't go away while we use it */
 		mutex_lock(&ept->cb_lock);
 
+		vrp->rx_cur = msg;
 		if (ept->cb)
 			ept->cb(ept->rpdev, msg->data, msg_len, ept->priv,
 				__rpmsg32_to_cpu(little_endian, msg->src));
+		vrp->rx_cur = NULL;
 
 		mutex_unlock(&ept->cb_lock);
 
@@ -777,11 +1004,14 @@ static int rpmsg_recv_single(struct virtproc_info *vrp, struct device *dev,
 	} else
 		dev_warn_ratelimited(dev, "msg received with no recipient\n");
 
-	/* publish the real size of the buffer */
-	rpmsg_sg_init(&sg, msg, vrp->buf_size);
+	/* the endpoint gives the buffer back with rpmsg_release_rx_buffer() */
+	if (vrp->rx_held) {
+		vrp->rx_held = false;
+		return 0;
+	}
 
 	/* add the buffer back to the remote processor's virtqueue */
-	err = virtqueue_add_inbuf(vrp->rvq, &sg, 1, msg, GFP_KERNEL);
+	err = rpmsg_add_rx_buf(vrp, msg);
 	if (err < 0) {
 		dev_err(dev, "failed to add a virtqueue buffer: %d\n", err);
 		return err;
@@ -797,9 +1027,13 @@ static void rpmsg_recv_done(struct virtqueue *rvq)
 	struct device *dev = &rvq->vdev->dev;
 	struct rpmsg_hdr *msg;
 	unsigned int len, msgs_received = 0;
+	unsigned long flags;
+	bool notify;
 	int err;
 
+	spin_lock_irqsave(&vrp->rx_lock, flags);
 	msg = virtqueue_get_buf(rvq, &len);
+	spin_unlock_irqrestore(&vrp->rx_lock, flags);
 	if (!msg) {
 		dev_err(dev, "uhm, incoming signal, but no used buffer ?\n");
 		return;
@@ -812,14 +1046,23 @@ static void rpmsg_recv_done(struct virtqueue *rvq)
 
 		msgs_received++;
 
+		spin_lock_irqsave(&vrp->rx_lock, flags);
 		msg = virtqueue_get_buf(rvq, &len);
+		spin_unlock_irqrestore(&vrp->rx_lock, flags);
 	}
 
 	dev_dbg(dev, "Received %u messages\n", msgs_received);
 
+	if (!msgs_received)
+		return;
+
 	/* tell the remote processor we added another available rx buffer */
-	if (msgs_received)
-		virtqueue_kick(vrp->rvq);
+	spin_lock_irqsave(&vrp->rx_lock, flags);
+	notify = virtqueue_kick_prepare(vrp->rvq);
+	spin_unlock_irqrestore(&vrp->rx_lock, flags);
+
+	if (notify)
+		virtqueue_notify(vrp->rvq);
 }
 
 /*
@@ -904,6 +1147,7 @@ static int rpmsg_probe(struct virtio_device *vdev)
 	idr_init(&vrp->endpoints);
 	mutex_init(&vrp->endpoints_lock);
 	mutex_init(&vrp->tx_lock);
+	spin_lock_init(&vrp->rx_lock);
 	init_waitqueue_head(&vrp->sendq);
 
 	/* We expect two virtqueues, rx and tx (and in this order) */
@@ -924,9 +1168,38 @@ static int rpmsg_probe(struct virtio_device *vdev)
 	else
 		vrp->num_bufs = MAX_RPMSG_NUM_BUFS;
 
-	vrp->buf_size = MAX_RPMSG_BUF_SIZE;
+	vrp->rbuf_size = MAX_RPMSG_BUF_SIZE;
+	vrp->sbuf_size = MAX_RPMSG_BUF_SIZE;
+	if (virtio_has_feature(vdev, VIRTIO_RPMSG_F_BUFSZ)) {
+		/* the remote's tx buffers are our rx buffers */
+		virtio_cread(vdev, struct virtio_rpmsg_config, txbuf_size,
+			     &vrp->rbuf_size);
+		virtio_cread(vdev, struct virtio_rpmsg_config, rxbuf_size,
+			     &vrp->sbuf_size);
+		if (vrp->rbuf_size < MIN_RPMSG_BUF_SIZE ||
+		    vrp->rbuf_size > MAX_RPMSG_NEGOTIATED_BUF_SIZE ||
+		    vrp->sbuf_size < MIN_RPMSG_BUF_SIZE ||
+		    vrp->sbuf_size > MAX_RPMSG_NEGOTIATED_BUF_SIZE) {
+			dev_err(&vdev->dev, "invalid buffer sizes rx %u tx %u\n",
+				vrp->rbuf_size, vrp->sbuf_size);
+			err = -EINVAL;
+			goto vqs_del;
+		}
+		/*
+		 * keep the message headers aligned, without sending more
+		 * than the remote's rx buffers hold
+		 */
+		vrp->rbuf_size = ALIGN(vrp->rbuf_size, sizeof(u32));
+		vrp->sbuf_size = ALIGN_DOWN(vrp->sbuf_size, sizeof(u32));
+	}
+
+	vrp->free_sbufs = bitmap_zalloc(vrp->num_bufs / 2, GFP_KERNEL);
+	if (!vrp->free_sbufs) {
+		err = -ENOMEM;
+		goto vqs_del;
+	}
 
-	total_buf_space = vrp->num_bufs * vrp->buf_size;
+	total_buf_space = vrp->num_bufs / 2 * (vrp->rbuf_size + vrp->sbuf_size);
 
 	/* allocate coherent memory for the buffers */
 	bufs_va = dma_alloc_coherent(vdev->dev.parent,
@@ -934,7 +1207,7 @@ static int rpmsg_probe(struct virtio_device *vdev)
 				     GFP_KERNEL);
 	if (!bufs_va) {
 		err = -ENOMEM;
-		goto vqs_del;
+		goto free_bitmap;
 	}
 
 	dev_dbg(&vdev->dev, "buffers: va %pK, dma %pad\n",
@@ -944,14 +1217,14 @@ static int rpmsg_probe(struct virtio_device *vdev)
 	vrp->rbufs = bufs_va;
 
 	/* and half is dedicated for TX */
-	vrp->sbufs = bufs_va + total_buf_space / 2;
+	vrp->sbufs = bufs_va + vrp->num_bufs / 2 * vrp->rbuf_size;
 
 	/* set up the receive buffers */
 	for (i = 0; i < vrp->num_bufs / 2; i++) {
 		struct scatterlist sg;
-		void *cpu_addr = vrp->rbufs + i * vrp->buf_size;
+		void *cpu_addr = vrp->rbufs + i * vrp->rbuf_size;
 
-		rpmsg_sg_init(&sg, cpu_addr, vrp->buf_size);
+		rpmsg_sg_init(&sg, cpu_addr, vrp->rbuf_size);
 
 		err = virtqueue_add_inbuf(vrp->rvq, &sg, 1, cpu_addr,
 					  GFP_KERNEL);
@@ -1020,6 +1293,8 @@ static int rpmsg_probe(struct virtio_device *vdev)
 free_coherent:
 	dma_free_coherent(vdev->dev.parent, total_buf_space,
 			  bufs_va, vrp->bufs_dma);
+free_bitmap:
+	bitmap_free(vrp->free_sbufs);
 vqs_del:
 	vdev->config->del_vqs(vrp->vdev);
 free_vrp:
@@ -1037,7 +1312,8 @@ static int rpmsg_remove_device(struct device *dev, void *data)
 static void rpmsg_remove(struct virtio_device *vdev)
 {
 	struct virtproc_info *vrp = vdev->priv;
-	size_t total_buf_space = vrp->num_bufs * vrp->buf_size;
+	size_t total_buf_space = vrp->num_bufs / 2 *
+				 (vrp->rbuf_size + vrp->sbuf_size);
 	int ret;
 
 	virtio_reset_device(vdev);
@@ -1053,6 +1329,7 @@ static void rpmsg_remove(struct virtio_device *vdev)
 	dma_free_coherent(vdev->dev.parent, total_buf_space,
 			  vrp->rbufs, vrp->bufs_dma);
 
+	bitmap_free(vrp->free_sbufs);
 	kfree(vrp);
 }
 
@@ -1063,6 +1340,7 @@ static struct virtio_device_id id_table[] = {
 
 static unsigned int features[] = {
 	VIRTIO_RPMSG_F_NS,
+	VIRTIO_RPMSG_F_BUFSZ,
 };
 
 static struct virtio_driver virtio_ipc_driver = {
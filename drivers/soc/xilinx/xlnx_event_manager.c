@@ -7,6 +7,7 @@
  *  Abhyuday Godhasara <abhyuday.godhasara@xilinx.com>
  */
 
+#include <linux/bitops.h>
 #include <linux/cpuhotplug.h>
 #include <linux/firmware/xlnx-event-manager.h>
 #include <linux/firmware/xlnx-zynqmp.h>
@@ -14,10 +15,13 @@
 #include <linux/interrupt.h>
 #include <linux/irq.h>
 #include <linux/irqdomain.h>
+#include <linux/jiffies.h>
 #include <linux/module.h>
 #include <linux/of_irq.h>
 #include <linux/platform_device.h>
 #include <linux/slab.h>
+#include <linux/spinlock.h>
+#include <linux/workqueue.h>
 
 static DEFINE_PER_CPU_READ_MOSTLY(int, cpu_number1);
 
@@ -38,10 +42,23 @@ static int event_manager_availability = -EACCES;
 #define REGISTER_NOTIFIER_FIRMWARE_VERSION	(2U)
 
 static DEFINE_HASHTABLE(reg_driver_map, REGISTERED_DRIVER_MAX_ORDER);
+/* Protects reg_driver_map against the SGI handler */
+static DEFINE_SPINLOCK(reg_driver_lock);
+/*
+ * Nests inside reg_driver_lock and is also held to add and remove map
+ * entries, so callbacks can look up event counts without reg_driver_lock.
+ */
+static DEFINE_SPINLOCK(event_count_lock);
 static int sgi_num = XLNX_EVENT_SGI_NUM;
 
+/* Window in which repeated error events are coalesced, 0 disables it */
+static unsigned int error_coalesce_ms;
+
 static bool is_need_to_unregister;
 
+static void xlnx_event_coalesce_flush(struct work_struct *work);
+static DECLARE_DELAYED_WORK(xlnx_coalesce_work, xlnx_event_coalesce_flush);
+
 /**
  * struct agent_cb - Registered callback function and private data.
  * @agent_data:		Data passed back to handler function.
@@ -65,6 +82,10 @@ struct agent_cb {
  * @cb_list_head:	Head of call back data list which contain the information
  *			about registered handler and private data.
  * @hentry:		hlist_node that hooks this entry into hashtable.
+ * @count:		Number of notifications received for the event.
+ * @next_dispatch:	Time before which further error events are coalesced.
+ * @pending:		Error events were coalesced and wait for the flush work.
+ * @payload:		Payload of the last coalesced error event.
  */
 struct registered_event_data {
 	u64 key;
@@ -72,8 +93,96 @@ struct registered_event_data {
 	bool wake;
 	struct list_head cb_list_head;
 	struct hlist_node hentry;
+	u64 count;
+	unsigned long next_dispatch;
+	bool pending;
+	u32 payload[CB_MAX_PAYLOAD_SIZE];
+};
+
+/**
+ * struct xlnx_event_pool - Entries allocated before reg_driver_lock is taken.
+ * @eve_data:		Free event entries, linked by their cb_list_head.
+ * @cb_data:		Free callback entries, linked by their list.
+ */
+struct xlnx_event_pool {
+	struct list_head eve_data;
+	struct list_head cb_data;
 };
 
+static void xlnx_event_pool_free(struct xlnx_event_pool *pool)
+{
+	struct registered_event_data *eve_data, *eve_next;
+	struct agent_cb *cb_data, *cb_next;
+
+	list_for_each_entry_safe(eve_data, eve_next, &pool->eve_data, cb_list_head)
+		kfree(eve_data);
+	list_for_each_entry_safe(cb_data, cb_next, &pool->cb_data, list)
+		kfree(cb_data);
+}
+
+/* Allocate one event and one callback entry for each of @nr events */
+static int xlnx_event_pool_alloc(struct xlnx_event_pool *pool, unsigned int nr)
+{
+	struct registered_event_data *eve_data;
+	struct agent_cb *cb_data;
+
+	INIT_LIST_HEAD(&pool->eve_data);
+	INIT_LIST_HEAD(&pool->cb_data);
+
+	while (nr--) {
+		eve_data = kzalloc(sizeof(*eve_data), GFP_KERNEL);
+		if (!eve_data)
+			goto err_free;
+		list_add(&eve_data->cb_list_head, &pool->eve_data);
+
+		cb_data = kmalloc(sizeof(*cb_data), GFP_KERNEL);
+		if (!cb_data)
+			goto err_free;
+		list_add(&cb_data->list, &pool->cb_data);
+	}
+
+	return 0;
+
+err_free:
+	xlnx_event_pool_free(pool);
+	return -ENOMEM;
+}
+
+static struct registered_event_data *xlnx_event_pool_get_eve(struct xlnx_event_pool *pool)
+{
+	struct registered_event_data *eve_data;
+
+	eve_data = list_first_entry(&pool->eve_data, struct registered_event_data,
+				    cb_list_head);
+	list_del(&eve_data->cb_list_head);
+
+	return eve_data;
+}
+
+static struct agent_cb *xlnx_event_pool_get_cb(struct xlnx_event_pool *pool)
+{
+	struct agent_cb *cb_data;
+
+	cb_data = list_first_entry(&pool->cb_data, struct agent_cb, list);
+	list_del(&cb_data->list);
+
+	return cb_data;
+}
+
+static void xlnx_event_hash_add(struct registered_event_data *eve_data, u64 key)
+{
+	spin_lock(&event_count_lock);
+	hash_add(reg_driver_map, &eve_data->hentry, key);
+	spin_unlock(&event_count_lock);
+}
+
+static void xlnx_event_hash_del(struct registered_event_data *eve_data)
+{
+	spin_lock(&event_count_lock);
+	hash_del(&eve_data->hentry);
+	spin_unlock(&event_count_lock);
+}
+
 static bool xlnx_is_error_event(const u32 node_id)
 {
 	if (node_id == EVENT_ERROR_PMC_ERR1 ||
@@ -86,7 +195,8 @@ static bool xlnx_is_error_event(const u32 node_id)
 }
 
 static int xlnx_add_cb_for_notify_event(const u32 node_id, const u32 event, const bool wake,
-					event_cb_func_t cb_fun,	void *data)
+					event_cb_func_t cb_fun,	void *data,
+					struct xlnx_event_pool *pool)
 {
 	u64 key = 0;
 	bool present_in_hash = false;
@@ -106,19 +216,14 @@ static int xlnx_add_cb_for_notify_event(const u32 node_id, const u32 event, cons
 
 	if (!present_in_hash) {
 		/* Add new entry if not present in HASH table */
-		eve_data = kmalloc(sizeof(*eve_data), GFP_KERNEL);
-		if (!eve_data)
-			return -ENOMEM;
+		eve_data = xlnx_event_pool_get_eve(pool);
 		eve_data->key = key;
 		eve_data->cb_type = PM_NOTIFY_CB;
 		eve_data->wake = wake;
+		eve_data->next_dispatch = jiffies;
 		INIT_LIST_HEAD(&eve_data->cb_list_head);
 
-		cb_data = kmalloc(sizeof(*cb_data), GFP_KERNEL);
-		if (!cb_data) {
-			kfree(eve_data);
-			return -ENOMEM;
-		}
+		cb_data = xlnx_event_pool_get_cb(pool);
 		cb_data->eve_cb = cb_fun;
 		cb_data->agent_data = data;
 
@@ -126,7 +231,7 @@ static int xlnx_add_cb_for_notify_event(const u32 node_id, const u32 event, cons
 		list_add(&cb_data->list, &eve_data->cb_list_head);
 
 		/* Add into HASH table */
-		hash_add(reg_driver_map, &eve_data->hentry, key);
+		xlnx_event_hash_add(eve_data, key);
 	} else {
 		/* Search for callback function and private data in list */
 		list_for_each_entry_safe(cb_pos, cb_next, &eve_data->cb_list_head, list) {
@@ -137,9 +242,7 @@ static int xlnx_add_cb_for_notify_event(const u32 node_id, const u32 event, cons
 		}
 
 		/* Add multiple handler and private data in list */
-		cb_data = kmalloc(sizeof(*cb_data), GFP_KERNEL);
-		if (!cb_data)
-			return -ENOMEM;
+		cb_data = xlnx_event_pool_get_cb(pool);
 		cb_data->eve_cb = cb_fun;
 		cb_data->agent_data = data;
 
@@ -149,7 +252,8 @@ static int xlnx_add_cb_for_notify_event(const u32 node_id, const u32 event, cons
 	return 0;
 }
 
-static int xlnx_add_cb_for_suspend(event_cb_func_t cb_fun, void *data)
+static int xlnx_add_cb_for_suspend(event_cb_func_t cb_fun, void *data,
+				   struct xlnx_event_pool *pool)
 {
 	struct registered_event_data *eve_data;
 	struct agent_cb *cb_data;
@@ -163,24 +267,19 @@ static int xlnx_add_cb_for_suspend(event_cb_func_t cb_fun, void *data)
 	}
 
 	/* Add new entry if not present */
-	eve_data = kmalloc(sizeof(*eve_data), GFP_KERNEL);
-	if (!eve_data)
-		return -ENOMEM;
-
+	eve_data = xlnx_event_pool_get_eve(pool);
 	eve_data->key = 0;
 	eve_data->cb_type = PM_INIT_SUSPEND_CB;
 	INIT_LIST_HEAD(&eve_data->cb_list_head);
 
-	cb_data = kmalloc(sizeof(*cb_data), GFP_KERNEL);
-	if (!cb_data)
-		return -ENOMEM;
+	cb_data = xlnx_event_pool_get_cb(pool);
 	cb_data->eve_cb = cb_fun;
 	cb_data->agent_data = data;
 
 	/* Add into callback list */
 	list_add(&cb_data->list, &eve_data->cb_list_head);
 
-	hash_add(reg_driver_map, &eve_data->hentry, PM_INIT_SUSPEND_CB);
+	xlnx_event_hash_add(eve_data, PM_INIT_SUSPEND_CB);
 
 	return 0;
 }
@@ -206,7 +305,7 @@ static int xlnx_remove_cb_for_suspend(event_cb_func_t cb_fun)
 				}
 			}
 			/* remove an object from a hashtable */
-			hash_del(&eve_data->hentry);
+			xlnx_event_hash_del(eve_data);
 			kfree(eve_data);
 			is_need_to_unregister = true;
 		}
@@ -246,7 +345,7 @@ static int xlnx_remove_cb_for_notify_event(const u32 node_id, const u32 event,
 			/* Remove HASH table if callback list is empty */
 			if (list_empty(&eve_data->cb_list_head)) {
 				/* remove an object from a HASH table */
-				hash_del(&eve_data->hentry);
+				xlnx_event_hash_del(eve_data);
 				kfree(eve_data);
 				is_need_to_unregister = true;
 			}
@@ -278,6 +377,8 @@ static int xlnx_remove_cb_for_notify_event(const u32 node_id, const u32 event,
 int xlnx_register_event(const enum pm_api_cb_id cb_type, const u32 node_id, const u32 event,
 			const bool wake, event_cb_func_t cb_fun, void *data)
 {
+	struct xlnx_event_pool pool;
+	unsigned long flags;
 	int ret = 0;
 	u32 eve;
 	int pos;
@@ -293,12 +394,23 @@ int xlnx_register_event(const enum pm_api_cb_id cb_type, const u32 node_id, cons
 	if (!cb_fun)
 		return -EFAULT;
 
+	/* Error events get an entry per error bit */
+	ret = xlnx_event_pool_alloc(&pool, cb_type == PM_NOTIFY_CB &&
+				    xlnx_is_error_event(node_id) ?
+				    hweight32(event) : 1);
+	if (ret)
+		return ret;
+
+	spin_lock_irqsave(&reg_driver_lock, flags);
 	if (cb_type == PM_INIT_SUSPEND_CB) {
-		ret = xlnx_add_cb_for_suspend(cb_fun, data);
+		ret = xlnx_add_cb_for_suspend(cb_fun, data, &pool);
+		spin_unlock_irqrestore(&reg_driver_lock, flags);
+		xlnx_event_pool_free(&pool);
 	} else {
 		if (!xlnx_is_error_event(node_id)) {
 			/* Add entry for Node-Id/Event in hash table */
-			ret = xlnx_add_cb_for_notify_event(node_id, event, wake, cb_fun, data);
+			ret = xlnx_add_cb_for_notify_event(node_id, event, wake, cb_fun, data,
+							   &pool);
 		} else {
 			/* Add into Hash table */
 			for (pos = 0; pos < MAX_BITS; pos++) {
@@ -308,7 +420,7 @@ int xlnx_register_event(const enum pm_api_cb_id cb_type, const u32 node_id, cons
 
 				/* Add entry for Node-Id/Eve in hash table */
 				ret = xlnx_add_cb_for_notify_event(node_id, eve, wake, cb_fun,
-								   data);
+								   data, &pool);
 				/* Break the loop if got error */
 				if (ret)
 					break;
@@ -325,6 +437,8 @@ int xlnx_register_event(const enum pm_api_cb_id cb_type, const u32 node_id, cons
 				}
 			}
 		}
+		spin_unlock_irqrestore(&reg_driver_lock, flags);
+		xlnx_event_pool_free(&pool);
 
 		if (ret) {
 			pr_err("%s() failed for 0x%x and 0x%x: %d\r\n", __func__, node_id,
@@ -338,6 +452,7 @@ int xlnx_register_event(const enum pm_api_cb_id cb_type, const u32 node_id, cons
 			pr_err("%s() failed for 0x%x and 0x%x: %d\r\n", __func__, node_id,
 			       event, ret);
 			/* Remove already registered event from hash table */
+			spin_lock_irqsave(&reg_driver_lock, flags);
 			if (xlnx_is_error_event(node_id)) {
 				for (pos = 0; pos < MAX_BITS; pos++) {
 					eve = event & (1 << pos);
@@ -348,6 +463,7 @@ int xlnx_register_event(const enum pm_api_cb_id cb_type, const u32 node_id, cons
 			} else {
 				xlnx_remove_cb_for_notify_event(node_id, event, cb_fun, data);
 			}
+			spin_unlock_irqrestore(&reg_driver_lock, flags);
 			return ret;
 		}
 	}
@@ -371,6 +487,7 @@ EXPORT_SYMBOL_GPL(xlnx_register_event);
 int xlnx_unregister_event(const enum pm_api_cb_id cb_type, const u32 node_id, const u32 event,
 			  event_cb_func_t cb_fun, void *data)
 {
+	unsigned long flags;
 	int ret = 0;
 	u32 eve, pos;
 
@@ -387,8 +504,10 @@ int xlnx_unregister_event(const enum pm_api_cb_id cb_type, const u32 node_id, co
 	if (!cb_fun)
 		return -EFAULT;
 
+	spin_lock_irqsave(&reg_driver_lock, flags);
 	if (cb_type == PM_INIT_SUSPEND_CB) {
 		ret = xlnx_remove_cb_for_suspend(cb_fun);
+		spin_unlock_irqrestore(&reg_driver_lock, flags);
 	} else {
 		/* Remove Node-Id/Event from hash table */
 		if (!xlnx_is_error_event(node_id)) {
@@ -402,6 +521,7 @@ int xlnx_unregister_event(const enum pm_api_cb_id cb_type, const u32 node_id, co
 				xlnx_remove_cb_for_notify_event(node_id, eve, cb_fun, data);
 			}
 		}
+		spin_unlock_irqrestore(&reg_driver_lock, flags);
 
 		/* Un-register if list is empty */
 		if (is_need_to_unregister) {
@@ -419,6 +539,43 @@ int xlnx_unregister_event(const enum pm_api_cb_id cb_type, const u32 node_id, co
 }
 EXPORT_SYMBOL_GPL(xlnx_unregister_event);
 
+/**
+ * xlnx_event_get_count() - Get the number of notifications of an event.
+ * @node_id:	Node-Id related to event.
+ * @event:	Event Mask, a single error for the Error Events.
+ * @count:	Number of notifications received since the event was
+ *		registered, including the coalesced ones.
+ *
+ * Callbacks of coalesced error events run once per coalescing window, this
+ * lets them find out how many errors the window covered.
+ *
+ * Return:	Returns 0 on success else error code.
+ */
+int xlnx_event_get_count(const u32 node_id, const u32 event, u64 *count)
+{
+	struct registered_event_data *eve_data;
+	u64 key = ((u64)node_id << 32U) | (u64)event;
+	unsigned long flags;
+	int ret = -EINVAL;
+
+	if (event_manager_availability)
+		return event_manager_availability;
+
+	/* Callbacks run with reg_driver_lock held */
+	spin_lock_irqsave(&event_count_lock, flags);
+	hash_for_each_possible(reg_driver_map, eve_data, hentry, key) {
+		if (eve_data->key == key) {
+			*count = eve_data->count;
+			ret = 0;
+			break;
+		}
+	}
+	spin_unlock_irqrestore(&event_count_lock, flags);
+
+	return ret;
+}
+EXPORT_SYMBOL_GPL(xlnx_event_get_count);
+
 static void xlnx_call_suspend_cb_handler(const u32 *payload)
 {
 	bool is_callback_found = false;
@@ -440,7 +597,73 @@ static void xlnx_call_suspend_cb_handler(const u32 *payload)
 		pr_warn("Didn't find any registered callback for suspend event\n");
 }
 
-static void xlnx_call_notify_cb_handler(const u32 *payload)
+/**
+ * xlnx_coalesce_event() - Check whether an error event is coalesced.
+ * @eve_data:	Registered error event.
+ * @payload:	Payload of the notification.
+ *
+ * The first notification of a window is dispatched right away, the later
+ * ones are dispatched once, with the last payload, by the flush work when
+ * the window ends. It is called with reg_driver_lock held.
+ *
+ * Return:	Returns true if the callbacks must not run now.
+ */
+static bool xlnx_coalesce_event(struct registered_event_data *eve_data,
+				const u32 *payload)
+{
+	unsigned long now = jiffies;
+
+	if (!error_coalesce_ms)
+		return false;
+
+	if (eve_data->pending) {
+		memcpy(eve_data->payload, payload, sizeof(eve_data->payload));
+		return true;
+	}
+
+	if (time_before(now, eve_data->next_dispatch)) {
+		memcpy(eve_data->payload, payload, sizeof(eve_data->payload));
+		eve_data->pending = true;
+		queue_delayed_work(system_unbound_wq, &xlnx_coalesce_work,
+				   eve_data->next_dispatch - now);
+		return true;
+	}
+
+	eve_data->next_dispatch = now + msecs_to_jiffies(error_coalesce_ms);
+	return false;
+}
+
+static void xlnx_event_coalesce_flush(struct work_struct *work)
+{
+	struct registered_event_data *eve_data;
+	unsigned long flags, left, delay = 0;
+	struct agent_cb *cb_pos;
+	int i;
+
+	spin_lock_irqsave(&reg_driver_lock, flags);
+	hash_for_each(reg_driver_map, i, eve_data, hentry) {
+		if (!eve_data->pending)
+			continue;
+
+		/* The work may have been queued for an earlier window */
+		if (time_before(jiffies, eve_data->next_dispatch)) {
+			left = eve_data->next_dispatch - jiffies;
+			if (!delay || left < delay)
+				delay = left;
+			continue;
+		}
+
+		eve_data->pending = false;
+		eve_data->next_dispatch = jiffies + msecs_to_jiffies(error_coalesce_ms);
+		list_for_each_entry(cb_pos, &eve_data->cb_list_head, list)
+			cb_pos->eve_cb(eve_data->payload, cb_pos->agent_data);
+	}
+	if (delay)
+		queue_delayed_work(system_unbound_wq, &xlnx_coalesce_work, delay);
+	spin_unlock_irqrestore(&reg_driver_lock, flags);
+}
+
+static void xlnx_call_notify_cb_handler(const u32 *payload, bool coalesce)
 {
 	bool is_callback_found = false;
 	struct registered_event_data *eve_data;
@@ -452,9 +675,14 @@ static void xlnx_call_notify_cb_handler(const u32 *payload)
 	/* Check for existing entry in hash table for given key id */
 	hash_for_each_possible(reg_driver_map, eve_data, hentry, key) {
 		if (eve_data->key == key) {
-			list_for_each_entry_safe(cb_pos, cb_next, &eve_data->cb_list_head, list) {
-				cb_pos->eve_cb(&payload[0], cb_pos->agent_data);
-				is_callback_found = true;
+			spin_lock(&event_count_lock);
+			eve_data->count++;
+			spin_unlock(&event_count_lock);
+			is_callback_found = true;
+			if (!coalesce || !xlnx_coalesce_event(eve_data, payload)) {
+				list_for_each_entry_safe(cb_pos, cb_next,
+							 &eve_data->cb_list_head, list)
+					cb_pos->eve_cb(&payload[0], cb_pos->agent_data);
 			}
 
 			/* re register with firmware to get future events */
@@ -495,11 +723,12 @@ static irqreturn_t xlnx_event_handler(int irq, void *dev_id)
 	/* First element is callback type, others are callback arguments */
 	cb_type = payload[0];
 
+	spin_lock(&reg_driver_lock);
 	if (cb_type == PM_NOTIFY_CB) {
 		node_id = payload[1];
 		event = payload[2];
 		if (!xlnx_is_error_event(node_id)) {
-			xlnx_call_notify_cb_handler(payload);
+			xlnx_call_notify_cb_handler(payload, false);
 		} else {
 			/*
 			 * Each call back function expecting payload as an input arguments.
@@ -518,7 +747,7 @@ static irqreturn_t xlnx_event_handler(int irq, void *dev_id)
 				if ((0 == (event & (1 << pos))))
 					continue;
 				event_data[2] = (event & (1 << pos));
-				xlnx_call_notify_cb_handler(event_data);
+				xlnx_call_notify_cb_handler(event_data, true);
 			}
 		}
 	} else if (cb_type == PM_INIT_SUSPEND_CB) {
@@ -526,6 +755,7 @@ static irqreturn_t xlnx_event_handler(int irq, void *dev_id)
 	} else {
 		pr_err("%s() Unsupported Callback %d\n", __func__, cb_type);
 	}
+	spin_unlock(&reg_driver_lock);
 
 	return IRQ_HANDLED;
 }
@@ -679,21 +909,25 @@ static int xlnx_event_manager_remove(struct platform_device *pdev)
 	int ret;
 	struct agent_cb *cb_pos;
 	struct agent_cb *cb_next;
+	unsigned long flags;
 
+	spin_lock_irqsave(&reg_driver_lock, flags);
 	hash_for_each_safe(reg_driver_map, i, tmp, eve_data, hentry) {
 		list_for_each_entry_safe(cb_pos, cb_next, &eve_data->cb_list_head, list) {
 			list_del_init(&cb_pos->list);
 			kfree(cb_pos);
 		}
-		hash_del(&eve_data->hentry);
+		xlnx_event_hash_del(eve_data);
 		kfree(eve_data);
 	}
+	spin_unlock_irqrestore(&reg_driver_lock, flags);
 
 	ret = zynqmp_pm_register_sgi(0, 1);
 	if (ret)
 		dev_err(&pdev->dev, "SGI unregistration over TF-A failed with %d\n", ret);
 
 	xlnx_event_cleanup_sgi(pdev);
+	cancel_delayed_work_sync(&xlnx_coalesce_work);
 
 	event_manager_availability = -EACCES;
 
@@ -708,4 +942,7 @@ static struct platform_driver xlnx_event_manager_driver = {
 	},
 };
 module_param(sgi_num, uint, 0);
+module_param(error_coalesce_ms, uint, 0644);
+MODULE_PARM_DESC(error_coalesce_ms,
+		 "Window in ms in which repeated error events run their callbacks once (0 = off)");
 module_platform_driver(xlnx_event_manager_driver);
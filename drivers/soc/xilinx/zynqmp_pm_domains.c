@@ -14,8 +14,10 @@
 #include <linux/module.h>
 #include <linux/of_platform.h>
 #include <linux/platform_device.h>
+#include <linux/pm.h>
 #include <linux/pm_domain.h>
 #include <linux/slab.h>
+#include <linux/workqueue.h>
 
 #include <linux/firmware/xlnx-zynqmp.h>
 
@@ -23,16 +25,36 @@
 
 static int min_capability;
 
+static unsigned int power_off_delay_ms = 10;
+module_param(power_off_delay_ms, uint, 0644);
+MODULE_PARM_DESC(power_off_delay_ms,
+		 "Delay before dropping the requirement of an idle PM node (ms)");
+
+static bool async_suspend;
+module_param(async_suspend, bool, 0444);
+MODULE_PARM_DESC(async_suspend,
+		 "Suspend and resume the devices of the PM domains asynchronously");
+
 /**
  * struct zynqmp_pm_domain - Wrapper around struct generic_pm_domain
  * @gpd:		Generic power domain
  * @node_id:		PM node ID corresponding to device inside PM domain
  * @requested:		The PM node mapped to the PM domain has been requested
+ * @accessible:		The firmware holds the access requirement of the node
+ * @off_caps:		Capabilities to leave the node with once it is idle
+ * @off_work:		Drops the requirement after power_off_delay_ms
+ *
+ * Devices doing runtime PM on bursty traffic power their domain off and
+ * on again within milliseconds. The requirement change of a power off is
+ * delayed, so that a power on within the delay needs no firmware call.
  */
 struct zynqmp_pm_domain {
 	struct generic_pm_domain gpd;
 	u32 node_id;
 	bool requested;
+	bool accessible;
+	u32 off_caps;
+	struct delayed_work off_work;
 };
 
 #define to_zynqmp_pm_domain(pm_domain) \
@@ -75,6 +97,14 @@ static int zynqmp_gpd_power_on(struct generic_pm_domain *domain)
 	struct zynqmp_pm_domain *pd = to_zynqmp_pm_domain(domain);
 	int ret;
 
+	/* Back before the delayed power off reached the firmware */
+	cancel_delayed_work_sync(&pd->off_work);
+	if (pd->accessible) {
+		dev_dbg(&domain->dev, "PM node id %d still accessible\n",
+			pd->node_id);
+		return 0;
+	}
+
 	ret = zynqmp_pm_set_requirement(pd->node_id,
 					ZYNQMP_PM_CAPABILITY_ACCESS,
 					ZYNQMP_PM_MAX_QOS,
@@ -86,12 +116,45 @@ static int zynqmp_gpd_power_on(struct generic_pm_domain *domain)
 		return ret;
 	}
 
+	pd->accessible = true;
+
 	dev_dbg(&domain->dev, "set requirement to 0x%x for PM node id %d\n",
 		ZYNQMP_PM_CAPABILITY_ACCESS, pd->node_id);
 
 	return 0;
 }
 
+static int zynqmp_gpd_set_off_requirement(struct zynqmp_pm_domain *pd)
+{
+	struct generic_pm_domain *domain = &pd->gpd;
+	int ret;
+
+	ret = zynqmp_pm_set_requirement(pd->node_id, pd->off_caps, 0,
+					ZYNQMP_PM_REQUEST_ACK_NO);
+	if (ret) {
+		dev_err(&domain->dev,
+			"failed to set requirement to 0x%x for PM node id %d: %d\n",
+			pd->off_caps, pd->node_id, ret);
+		return ret;
+	}
+
+	pd->accessible = false;
+
+	dev_dbg(&domain->dev, "set requirement to 0x%x for PM node id %d\n",
+		pd->off_caps, pd->node_id);
+
+	return 0;
+}
+
+static void zynqmp_gpd_off_work(struct work_struct *work)
+{
+	struct zynqmp_pm_domain *pd = container_of(to_delayed_work(work),
+						   struct zynqmp_pm_domain,
+						   off_work);
+
+	zynqmp_gpd_set_off_requirement(pd);
+}
+
 /**
  * zynqmp_gpd_power_off() - Power off PM domain
  * @domain:	Generic PM domain
@@ -104,7 +167,6 @@ static int zynqmp_gpd_power_on(struct generic_pm_domain *domain)
 static int zynqmp_gpd_power_off(struct generic_pm_domain *domain)
 {
 	struct zynqmp_pm_domain *pd = to_zynqmp_pm_domain(domain);
-	int ret;
 	struct pm_domain_data *pdd, *tmp;
 	u32 capabilities = min_capability;
 	bool may_wakeup;
@@ -127,17 +189,16 @@ static int zynqmp_gpd_power_off(struct generic_pm_domain *domain)
 		}
 	}
 
-	ret = zynqmp_pm_set_requirement(pd->node_id, capabilities, 0,
-					ZYNQMP_PM_REQUEST_ACK_NO);
-	if (ret) {
-		dev_err(&domain->dev,
-			"failed to set requirement to 0x%x for PM node id %d: %d\n",
-			capabilities, pd->node_id, ret);
-		return ret;
+	pd->off_caps = capabilities;
+
+	/* System suspend needs the wakeup capability set right away */
+	if (!power_off_delay_ms || domain->suspended_count) {
+		cancel_delayed_work_sync(&pd->off_work);
+		return zynqmp_gpd_set_off_requirement(pd);
 	}
 
-	dev_dbg(&domain->dev, "set requirement to 0x%x for PM node id %d\n",
-		capabilities, pd->node_id);
+	mod_delayed_work(system_wq, &pd->off_work,
+			 msecs_to_jiffies(power_off_delay_ms));
 
 	return 0;
 }
@@ -147,6 +208,12 @@ static int zynqmp_gpd_power_off(struct generic_pm_domain *domain)
  * @domain:	Generic PM domain
  * @dev:	Device to attach
  *
+ * With async_suspend set, the device is suspended and resumed in parallel
+ * with the other asynchronous devices, so that the blocking power on of
+ * its PM node overlaps with those of the others. The suspend and resume
+ * order with its parent and with the suppliers its device tree node points
+ * to is kept by the device links the driver core created for them.
+ *
  * Return: 0 on success, error code otherwise
  */
 static int zynqmp_gpd_attach_dev(struct generic_pm_domain *domain,
@@ -161,10 +228,15 @@ static int zynqmp_gpd_attach_dev(struct generic_pm_domain *domain,
 		dev_dbg(&domain->dev, "failed to create device link for %s\n",
 			dev_name(dev));
 
+	if (async_suspend)
+		device_enable_async_suspend(dev);
+
 	/* If this is not the first device to attach there is nothing to do */
 	if (domain->device_count)
 		return 0;
 
+	cancel_delayed_work_sync(&pd->off_work);
+
 	ret = zynqmp_pm_request_node(pd->node_id, 0, 0,
 				     ZYNQMP_PM_REQUEST_ACK_BLOCKING);
 	if (ret) {
@@ -174,6 +246,8 @@ static int zynqmp_gpd_attach_dev(struct generic_pm_domain *domain,
 	}
 
 	pd->requested = true;
+	/* Requested with no capabilities, the first power on sets them */
+	pd->accessible = false;
 
 	dev_dbg(&domain->dev, "%s requested PM node id %d\n",
 		dev_name(dev), pd->node_id);
@@ -196,6 +270,9 @@ static void zynqmp_gpd_detach_dev(struct generic_pm_domain *domain,
 	if (domain->device_count)
 		return;
 
+	/* Releasing the node drops any requirement still pending */
+	cancel_delayed_work_sync(&pd->off_work);
+
 	ret = zynqmp_pm_release_node(pd->node_id);
 	if (ret) {
 		dev_err(&domain->dev, "failed to release PM node id %d: %d\n",
@@ -204,6 +281,7 @@ static void zynqmp_gpd_detach_dev(struct generic_pm_domain *domain,
 	}
 
 	pd->requested = false;
+	pd->accessible = false;
 
 	dev_dbg(&domain->dev, "%s released PM node id %d\n",
 		dev_name(dev), pd->node_id);
@@ -279,6 +357,7 @@ static int zynqmp_gpd_probe(struct platform_device *pdev)
 		pd->gpd.power_on = zynqmp_gpd_power_on;
 		pd->gpd.attach_dev = zynqmp_gpd_attach_dev;
 		pd->gpd.detach_dev = zynqmp_gpd_detach_dev;
+		INIT_DELAYED_WORK(&pd->off_work, zynqmp_gpd_off_work);
 
 		domains[i] = &pd->gpd;
 
@@ -290,13 +369,25 @@ static int zynqmp_gpd_probe(struct platform_device *pdev)
 	zynqmp_pd_data->num_domains = ZYNQMP_NUM_DOMAINS;
 	of_genpd_add_provider_onecell(dev->parent->of_node, zynqmp_pd_data);
 
+	platform_set_drvdata(pdev, zynqmp_pd_data);
+
 	return 0;
 }
 
 static int zynqmp_gpd_remove(struct platform_device *pdev)
 {
+	struct genpd_onecell_data *zynqmp_pd_data = platform_get_drvdata(pdev);
+	struct zynqmp_pm_domain *pd;
+	int i;
+
 	of_genpd_del_provider(pdev->dev.parent->of_node);
 
+	/* Let pending power offs reach the firmware */
+	for (i = 0; i < ZYNQMP_NUM_DOMAINS; i++) {
+		pd = to_zynqmp_pm_domain(zynqmp_pd_data->domains[i]);
+		flush_delayed_work(&pd->off_work);
+	}
+
 	return 0;
 }
 
@@ -45,6 +45,7 @@
 #include <net/sock.h>
 #include <linux/xilinx_phy.h>
 #include <linux/clk.h>
+#include <linux/bpf_trace.h>
 
 #include "xilinx_axienet_tsn.h"
 
@@ -656,6 +657,53 @@ int axienet_queue_xmit_tsn(struct sk_buff *skb,
 	return NETDEV_TX_OK;
 }
 
+/* axienet_run_xdp() verdicts */
+#define AXIENET_XDP_PASS	0
+#define AXIENET_XDP_CONSUMED	BIT(0)
+#define AXIENET_XDP_REDIR	BIT(1)
+
+/**
+ * axienet_run_xdp - Run the XDP program on a received frame
+ * @lp:		Pointer to axienet local structure
+ * @q:		Pointer to the Rx DMA queue structure
+ * @prog:	XDP program to run
+ * @xdp:	Frame to run the program on
+ *
+ * Frames that do not pass are redirected or returned to the page pool here.
+ * XDP_TX is not supported, the Tx side of the endpoint goes through the
+ * traffic class queues and TADMA.
+ *
+ * Return: AXIENET_XDP_PASS if the frame should go up the stack, otherwise
+ * the action taken.
+ */
+static u32 axienet_run_xdp(struct axienet_local *lp, struct axienet_dma_q *q,
+			   struct bpf_prog *prog, struct xdp_buff *xdp)
+{
+	u32 act;
+
+	act = bpf_prog_run_xdp(prog, xdp);
+	switch (act) {
+	case XDP_PASS:
+		return AXIENET_XDP_PASS;
+	case XDP_REDIRECT:
+		if (unlikely(xdp_do_redirect(lp->ndev, xdp, prog)))
+			goto out_failure;
+		return AXIENET_XDP_REDIR;
+	default:
+		bpf_warn_invalid_xdp_action(lp->ndev, prog, act);
+		fallthrough;
+	case XDP_ABORTED:
+out_failure:
+		trace_xdp_exception(lp->ndev, prog, act);
+		fallthrough;
+	case XDP_DROP:
+		break;
+	}
+
+	page_pool_recycle_direct(q->page_pool, virt_to_head_page(xdp->data));
+	return AXIENET_XDP_CONSUMED;
+}
+
 /**
  * axienet_recv - Is called from Axi DMA Rx Isr to complete the received
  *		  BD processing.
@@ -664,8 +712,9 @@ int axienet_queue_xmit_tsn(struct sk_buff *skb,
  * @q:		Pointer to axienet DMA queue structure
  *
  * This function is invoked from the Axi DMA Rx isr(poll) to process the Rx BDs
- * It does minimal processing and invokes "netif_receive_skb" to complete
- * further processing.
+ * It does minimal processing, runs the attached XDP program on the data
+ * channels if any and invokes "netif_receive_skb" to complete further
+ * processing.
  * Return: Number of BD's processed.
  */
 static int axienet_recv(struct net_device *ndev, int budget,
@@ -676,8 +725,13 @@ static int axienet_recv(struct net_device *ndev, int budget,
 	u32 size = 0;
 	u32 packets = 0;
 	dma_addr_t tail_p = 0;
+	dma_addr_t mapping;
 	struct axienet_local *lp = netdev_priv(ndev);
-	struct sk_buff *skb, *new_skb;
+	struct page *page, *new_page;
+	struct sk_buff *skb;
+	struct bpf_prog *xdp_prog;
+	struct xdp_buff xdp;
+	u32 xdp_res, xdp_status = 0;
 	u32 sband_status = 0;
 	struct net_device *temp_ndev = NULL;
 	struct aximcdma_bd *cur_p;
@@ -690,16 +744,17 @@ static int axienet_recv(struct net_device *ndev, int budget,
 
 	while ((numbdfree < budget) &&
 	       (cur_p->status & XAXIDMA_BD_STS_COMPLETE_MASK)) {
-		new_skb = netdev_alloc_skb(ndev, lp->max_frm_size);
-		if (!new_skb)
+		/* Get the replacement buffer first so that a pool exhaustion
+		 * leaves the completed frame in place for the next poll.
+		 */
+		new_page = axienet_rx_alloc_page_tsn(q, &mapping);
+		if (!new_page) {
+			q->rx_alloc_fail++;
 			break;
+		}
 		tail_p = q->rx_bd_p + sizeof(*q->rxq_bd_v) * q->rx_bd_ci;
 
-		dma_unmap_single(ndev->dev.parent, cur_p->phys,
-				 lp->max_frm_size,
-				 DMA_FROM_DEVICE);
-
-		skb = (struct sk_buff *)(cur_p->sw_id_offset);
+		page = (struct page *)(cur_p->sw_id_offset);
 
 		if (lp->eth_hasnobuf ||
 		    lp->axienet_config->mactype != XAXIENET_1G)
@@ -707,7 +762,43 @@ static int axienet_recv(struct net_device *ndev, int budget,
 		else
 			length = cur_p->app4 & 0x0000FFFF;
 
-		skb_put(skb, length);
+		size += length;
+		packets++;
+
+		dma_sync_single_for_cpu(ndev->dev.parent,
+					page_pool_get_dma_addr(page) +
+					XAE_RX_HEADROOM, length,
+					page_pool_get_dma_dir(q->page_pool));
+
+		xdp_init_buff(&xdp, PAGE_SIZE << q->page_pool->p.order,
+			      &q->xdp_rxq);
+		xdp_prepare_buff(&xdp, page_address(page), XAE_RX_HEADROOM,
+				 length, false);
+
+		/* Frames of the management and extended endpoint channels
+		 * belong to other net devices, XDP only sees the data path
+		 * of the endpoint.
+		 */
+		xdp_prog = READ_ONCE(lp->xdp_prog);
+		if (xdp_prog &&
+		    !(q->flags & (MCDMA_MGMT_CHAN | MCDMA_EP_EX_CHAN))) {
+			xdp_res = axienet_run_xdp(lp, q, xdp_prog, &xdp);
+			if (xdp_res != AXIENET_XDP_PASS) {
+				xdp_status |= xdp_res;
+				goto refill;
+			}
+		}
+
+		skb = napi_build_skb(xdp.data_hard_start, xdp.frame_sz);
+		if (unlikely(!skb)) {
+			page_pool_recycle_direct(q->page_pool, page);
+			ndev->stats.rx_dropped++;
+			goto refill;
+		}
+		skb_mark_for_recycle(skb);
+		skb_reserve(skb, xdp.data - xdp.data_hard_start);
+		skb_put(skb, xdp.data_end - xdp.data);
+
 		skb->protocol = eth_type_trans(skb, ndev);
 		/*skb_checksum_none_assert(skb);*/
 		skb->ip_summed = CHECKSUM_NONE;
@@ -751,7 +842,7 @@ static int axienet_recv(struct net_device *ndev, int budget,
 				skb->dev = temp_ndev;
 				netif_receive_skb(skb);
 			} else {
-				kfree(skb); /* dont send up the stack */
+				dev_kfree_skb(skb); /* dont send up the stack */
 			}
 		} else if (unlikely(q->flags & MCDMA_EP_EX_CHAN)) {
 			temp_ndev = lp->ex_ep;
@@ -759,32 +850,17 @@ static int axienet_recv(struct net_device *ndev, int budget,
 				skb->dev = temp_ndev;
 				netif_receive_skb(skb);
 			} else {
-				kfree(skb); /* dont send up the stack */
+				dev_kfree_skb(skb); /* dont send up the stack */
 			}
 		} else {
 			netif_receive_skb(skb); /* send on normal data path */
 		}
 
-		size += length;
-		packets++;
-
-		/* Ensure that the skb is completely updated
-		 * prio to mapping the DMA
-		 */
-		wmb();
-
-		cur_p->phys = dma_map_single(ndev->dev.parent, new_skb->data,
-					     lp->max_frm_size,
-					   DMA_FROM_DEVICE);
-		if (unlikely(dma_mapping_error(ndev->dev.parent, cur_p->phys))) {
-			cur_p->phys = 0;
-			dev_kfree_skb(new_skb);
-			dev_err(lp->dev, "RX buffer map failed\n");
-			break;
-		}
+refill:
+		cur_p->phys = mapping;
 		cur_p->cntrl = lp->max_frm_size;
 		cur_p->status = 0;
-		cur_p->sw_id_offset = (phys_addr_t)new_skb;
+		cur_p->sw_id_offset = (phys_addr_t)new_page;
 
 		if (++q->rx_bd_ci >= lp->rx_bd_num)
 			q->rx_bd_ci = 0;
@@ -800,6 +876,9 @@ static int axienet_recv(struct net_device *ndev, int budget,
 	q->rx_packets += packets;
 	q->rx_bytes += size;
 
+	if (xdp_status & AXIENET_XDP_REDIR)
+		xdp_do_flush();
+
 	if (tail_p) {
 		axienet_dma_bdout(q, XMCDMA_CHAN_TAILDESC_OFFSET(q->chan_id) +
 				  q->rx_offset, tail_p);
@@ -881,11 +960,49 @@ static int axienet_change_mtu(struct net_device *ndev, int new_mtu)
 		XAE_TRL_SIZE) > lp->rxmem)
 		return -EINVAL;
 
+	if (lp->xdp_prog && !axienet_xdp_frame_ok_tsn(new_mtu + VLAN_ETH_HLEN +
+						      XAE_TRL_SIZE)) {
+		netdev_err(ndev, "MTU %d too large for XDP\n", new_mtu);
+		return -EINVAL;
+	}
+
 	ndev->mtu = new_mtu;
 
 	return 0;
 }
 
+/**
+ * axienet_bpf_tsn - ndo_bpf handler
+ * @ndev:	Pointer to net_device structure
+ * @bpf:	BPF command
+ *
+ * The program runs on the data channels of the endpoint. The Rx buffers
+ * only have to be readable by the CPU for the supported actions, so a
+ * program is swapped in without restarting the interface.
+ *
+ * Return: 0, on success. Non-zero error value on failure.
+ */
+int axienet_bpf_tsn(struct net_device *ndev, struct netdev_bpf *bpf)
+{
+	struct axienet_local *lp = netdev_priv(ndev);
+	struct bpf_prog *old_prog;
+
+	switch (bpf->command) {
+	case XDP_SETUP_PROG:
+		if (bpf->prog && !axienet_xdp_frame_ok_tsn(lp->max_frm_size)) {
+			NL_SET_ERR_MSG_MOD(bpf->extack,
+					   "MTU too large for XDP");
+			return -EOPNOTSUPP;
+		}
+		old_prog = xchg(&lp->xdp_prog, bpf->prog);
+		if (old_prog)
+			bpf_prog_put(old_prog);
+		return 0;
+	default:
+		return -EINVAL;
+	}
+}
+
 #ifdef CONFIG_NET_POLL_CONTROLLER
 /**
  * axienet_poll_controller - Axi Ethernet poll mechanism.
@@ -1160,16 +1277,6 @@ static int axienet_ioctl_siocdevprivate(struct net_device *dev,
 		return axienet_tadma_flush_stream(dev, data);
 #endif
 #ifdef CONFIG_XILINX_TSN_QBR
-	case SIOC_PREEMPTION_CFG:
-		return axienet_preemption(dev, data);
-	case SIOC_PREEMPTION_CTRL:
-		return axienet_preemption_ctrl(dev, data);
-	case SIOC_PREEMPTION_STS:
-		return axienet_preemption_sts(dev, data);
-	case SIOC_PREEMPTION_RECEIVE:
-		return axienet_preemption_receive(dev);
-	case SIOC_PREEMPTION_COUNTER:
-		return axienet_preemption_cnt(dev, data);
 #ifdef CONFIG_XILINX_TSN_QBV
 	case SIOC_QBU_USER_OVERRIDE:
 		return axienet_qbu_user_override(dev, data);
@@ -1183,6 +1290,37 @@ static int axienet_ioctl_siocdevprivate(struct net_device *dev,
 	}
 }
 
+#if defined(CONFIG_XILINX_TSN_QBV) || defined(CONFIG_XILINX_TSN_QCI)
+/**
+ * axienet_tsn_setup_tc - ndo_setup_tc handler
+ * @ndev: Pointer to the net_device structure
+ * @type: Type of the offload
+ * @type_data: Offload configuration
+ *
+ * Return: 0 on success, Non-zero error value on failure.
+ *
+ * taprio programs the Qbv gate control list and flower blocks on the switch
+ * ports program the Qci stream filters. There is no credit based shaper in
+ * the TSN IP, so cbs is not offloaded.
+ */
+int axienet_tsn_setup_tc(struct net_device *ndev, enum tc_setup_type type,
+			 void *type_data)
+{
+	switch (type) {
+#ifdef CONFIG_XILINX_TSN_QBV
+	case TC_SETUP_QDISC_TAPRIO:
+		return axienet_setup_taprio(ndev, type_data);
+#endif
+#ifdef CONFIG_XILINX_TSN_QCI
+	case TC_SETUP_BLOCK:
+		return axienet_qci_setup_block(ndev, type_data);
+#endif
+	default:
+		return -EOPNOTSUPP;
+	}
+}
+#endif
+
 static const struct net_device_ops axienet_netdev_ops = {
 	.ndo_open = axienet_tsn_open,
 	.ndo_stop = axienet_tsn_stop,
@@ -1193,6 +1331,10 @@ static const struct net_device_ops axienet_netdev_ops = {
 	.ndo_eth_ioctl = axienet_ioctl,
 	.ndo_siocdevprivate = axienet_ioctl_siocdevprivate,
 	.ndo_set_rx_mode = axienet_set_multicast_list_tsn,
+	.ndo_bpf = axienet_bpf_tsn,
+#if defined(CONFIG_XILINX_TSN_QBV) || defined(CONFIG_XILINX_TSN_QCI)
+	.ndo_setup_tc = axienet_tsn_setup_tc,
+#endif
 #ifdef CONFIG_NET_POLL_CONTROLLER
 	.ndo_poll_controller = axienet_poll_controller,
 #endif
@@ -136,6 +136,91 @@ void __maybe_unused axienet_mcdma_tx_bd_free_tsn(struct net_device *ndev,
 	}
 }
 
+/**
+ * axienet_rx_page_pool_create_tsn - Create the Rx page pool of a DMA queue
+ * @ndev:	Pointer to the net_device structure
+ * @q:		Pointer to DMA queue structure
+ *
+ * Return: 0, on success -errno, on failure
+ *
+ * The pool hands out pages that stay DMA mapped for their whole lifetime.
+ * Each page holds one frame of up to max_frm_size bytes behind
+ * XAE_RX_HEADROOM, followed by room for the skb_shared_info so that the
+ * receive path can wrap it with build_skb(). The pool is also registered as
+ * the memory model of the queue's XDP Rx queue info so that redirected
+ * frames find their way back to it.
+ */
+static int axienet_rx_page_pool_create_tsn(struct net_device *ndev,
+					   struct axienet_dma_q *q)
+{
+	struct axienet_local *lp = netdev_priv(ndev);
+	struct page_pool_params pp_params = { 0 };
+	unsigned int len;
+	int ret, i;
+
+	len = SKB_DATA_ALIGN(XAE_RX_HEADROOM + lp->max_frm_size) +
+	      SKB_DATA_ALIGN(sizeof(struct skb_shared_info));
+
+	pp_params.flags = PP_FLAG_DMA_MAP | PP_FLAG_DMA_SYNC_DEV;
+	pp_params.order = get_order(len);
+	pp_params.pool_size = lp->rx_bd_num;
+	pp_params.nid = dev_to_node(ndev->dev.parent);
+	pp_params.dev = ndev->dev.parent;
+	pp_params.dma_dir = DMA_FROM_DEVICE;
+	pp_params.offset = XAE_RX_HEADROOM;
+	pp_params.max_len = lp->max_frm_size;
+
+	q->page_pool = page_pool_create(&pp_params);
+	if (IS_ERR(q->page_pool)) {
+		ret = PTR_ERR(q->page_pool);
+		q->page_pool = NULL;
+		return ret;
+	}
+
+	for_each_rx_dma_queue(lp, i)
+		if (lp->dq[i] == q)
+			break;
+
+	ret = xdp_rxq_info_reg(&q->xdp_rxq, ndev, i, 0);
+	if (ret)
+		goto err_destroy_pool;
+
+	ret = xdp_rxq_info_reg_mem_model(&q->xdp_rxq, MEM_TYPE_PAGE_POOL,
+					 q->page_pool);
+	if (ret)
+		goto err_unreg_rxq;
+
+	return 0;
+
+err_unreg_rxq:
+	xdp_rxq_info_unreg(&q->xdp_rxq);
+err_destroy_pool:
+	page_pool_destroy(q->page_pool);
+	q->page_pool = NULL;
+	return ret;
+}
+
+/**
+ * axienet_rx_alloc_page_tsn - Get a pre-mapped Rx buffer from the page pool
+ * @q:		Pointer to DMA queue structure
+ * @dma:	Returns the bus address the DMA engine should write to
+ *
+ * Return: The page, or NULL if the pool is exhausted.
+ */
+struct page *axienet_rx_alloc_page_tsn(struct axienet_dma_q *q,
+				       dma_addr_t *dma)
+{
+	struct page *page;
+
+	page = page_pool_dev_alloc_pages(q->page_pool);
+	if (unlikely(!page))
+		return NULL;
+
+	*dma = page_pool_get_dma_addr(page) + XAE_RX_HEADROOM;
+
+	return page;
+}
+
 /**
  * axienet_mcdma_rx_bd_free_tsn - Release MCDMA Rx buffer descriptor rings
  * @ndev:	Pointer to the net_device structure
@@ -150,22 +235,28 @@ void __maybe_unused axienet_mcdma_rx_bd_free_tsn(struct net_device *ndev,
 	int i;
 	struct axienet_local *lp = netdev_priv(ndev);
 
-	if (!q->rxq_bd_v)
-		return;
+	if (q->rxq_bd_v) {
+		for (i = 0; i < lp->rx_bd_num; i++) {
+			struct page *page;
 
-	for (i = 0; i < lp->rx_bd_num; i++) {
-		if (q->rxq_bd_v[i].phys)
-			dma_unmap_single(ndev->dev.parent, q->rxq_bd_v[i].phys,
-					 lp->max_frm_size, DMA_FROM_DEVICE);
-		dev_kfree_skb((struct sk_buff *)
-			      (q->rxq_bd_v[i].sw_id_offset));
+			page = (struct page *)q->rxq_bd_v[i].sw_id_offset;
+			if (page)
+				page_pool_put_full_page(q->page_pool, page,
+							false);
+		}
+
+		dma_free_coherent(ndev->dev.parent,
+				  sizeof(*q->rxq_bd_v) * lp->rx_bd_num,
+				  q->rxq_bd_v,
+				  q->rx_bd_p);
+		q->rxq_bd_v = NULL;
 	}
 
-	dma_free_coherent(ndev->dev.parent,
-			  sizeof(*q->rxq_bd_v) * lp->rx_bd_num,
-			  q->rxq_bd_v,
-			  q->rx_bd_p);
-	q->rxq_bd_v = NULL;
+	if (q->page_pool) {
+		xdp_rxq_info_unreg(&q->xdp_rxq);
+		page_pool_destroy(q->page_pool);
+		q->page_pool = NULL;
+	}
 }
 
 /**
@@ -264,13 +355,16 @@ int __maybe_unused axienet_mcdma_rx_q_init_tsn(struct net_device *ndev,
 {
 	u32 cr, chan_en;
 	int i;
-	struct sk_buff *skb;
+	struct page *page;
 	struct axienet_local *lp = netdev_priv(ndev);
 	dma_addr_t mapping;
 
 	q->rx_bd_ci = 0;
 	q->rx_offset = XMCDMA_CHAN_RX_OFFSET;
 
+	if (axienet_rx_page_pool_create_tsn(ndev, q))
+		goto out;
+
 	q->rxq_bd_v = dma_alloc_coherent(ndev->dev.parent,
 					 sizeof(*q->rxq_bd_v) * lp->rx_bd_num,
 					 &q->rx_bd_p, GFP_KERNEL);
@@ -282,25 +376,13 @@ int __maybe_unused axienet_mcdma_rx_q_init_tsn(struct net_device *ndev,
 				      sizeof(*q->rxq_bd_v) *
 				      ((i + 1) % lp->rx_bd_num);
 
-		skb = netdev_alloc_skb(ndev, lp->max_frm_size);
-		if (!skb)
-			goto out;
-
-		/* Ensure that the skb is completely updated
-		 * prio to mapping the DMA
-		 */
-		wmb();
-
-		q->rxq_bd_v[i].sw_id_offset = (phys_addr_t)skb;
-		mapping = dma_map_single(ndev->dev.parent,
-					 skb->data,
-					 lp->max_frm_size,
-					 DMA_FROM_DEVICE);
-		if (unlikely(dma_mapping_error(ndev->dev.parent, mapping))) {
-			dev_err(&ndev->dev, "mcdma map error\n");
+		page = axienet_rx_alloc_page_tsn(q, &mapping);
+		if (!page) {
+			dev_err(&ndev->dev, "mcdma rx buffer alloc failed\n");
 			goto out;
 		}
 
+		q->rxq_bd_v[i].sw_id_offset = (phys_addr_t)page;
 		q->rxq_bd_v[i].phys = mapping;
 		q->rxq_bd_v[i].cntrl = lp->max_frm_size;
 	}
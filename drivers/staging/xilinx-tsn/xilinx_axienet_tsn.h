@@ -18,6 +18,8 @@
 #include <linux/of_platform.h>
 #include <linux/clk.h>
 #include <linux/io-64-nonatomic-lo-hi.h>
+#include <net/page_pool.h>
+#include <net/xdp.h>
 
 /* Packet size info */
 #define XAE_HDR_SIZE			14 /* Size of Ethernet header */
@@ -29,6 +31,11 @@
 #define XAE_MAX_VLAN_FRAME_SIZE  (XAE_MTU + VLAN_ETH_HLEN + XAE_TRL_SIZE)
 #define XAE_MAX_JUMBO_FRAME_SIZE (XAE_JUMBO_MTU + XAE_HDR_SIZE + XAE_TRL_SIZE)
 
+/* Headroom reserved in front of each page pool Rx buffer, large enough for
+ * an XDP program to push headers.
+ */
+#define XAE_RX_HEADROOM		XDP_PACKET_HEADROOM
+
 /* Queue Numbers of BE, RES, ST and PTP */
 
 #define BE_QUEUE_NUMBER  0
@@ -718,6 +725,7 @@ struct axitadma_bd {
 enum axienet_tsn_ioctl {
 	SIOCCHIOCTL = SIOCDEVPRIVATE,
 	SIOC_GET_SCHED,
+	/* preemption is configured through the ethtool MAC merge operations */
 	SIOC_PREEMPTION_CFG,
 	SIOC_PREEMPTION_CTRL,
 	SIOC_PREEMPTION_STS,
@@ -766,7 +774,6 @@ enum axienet_tsn_ioctl {
  * @ptp_rx_hw_pointer: ptp rx hw pointer
  * @ptp_rx_sw_pointer: ptp rx sw pointer
  * @ptp_txq:	PTP tx queue header
- * @tx_tstamp_work: PTP timestamping work queue
  * @qbv_regs:	pointer to qbv registers base address
  * @tadma_regs: pointer to tadma registers base address
  * @tadma_irq: TADMA IRQ number
@@ -826,6 +833,7 @@ enum axienet_tsn_ioctl {
  * @gt_lane: MRMAC GT lane index used.
  * @ptp_os_cf: CF TS of PTP PDelay req for one step usage.
  * @xxv_ip_version: XXV IP version
+ * @xdp_prog: XDP program run on the endpoint data channels, NULL if none.
  */
 struct axienet_local {
 	struct net_device *ndev;
@@ -871,7 +879,6 @@ struct axienet_local {
 	u8  ptp_rx_hw_pointer;
 	u8  ptp_rx_sw_pointer;
 	struct sk_buff_head ptp_txq;
-	struct work_struct tx_tstamp_work;
 #endif
 #ifdef CONFIG_XILINX_TSN_QBV
 	void __iomem *qbv_regs;
@@ -945,6 +952,7 @@ struct axienet_local {
 	u32 gt_lane;		/* MRMAC GT lane index used */
 	u64 ptp_os_cf;		/* CF TS of PTP PDelay req for one step usage */
 	u32 xxv_ip_version;
+	struct bpf_prog *xdp_prog;
 };
 
 /**
@@ -981,6 +989,10 @@ struct axienet_local {
  * @tx_bytes:   Number of transmit bytes processed by the dma queue.
  * @rx_packets: Number of receive packets processed by the dma queue.
  * @rx_bytes:	Number of receive bytes processed by the dma queue.
+ * @rx_alloc_fail: Number of times the Rx ring could not be refilled.
+ * @page_pool:	Page pool backing the Rx buffers of this queue. Pages are
+ *		kept DMA mapped and recycled through build_skb().
+ * @xdp_rxq:	XDP Rx queue info registered against @page_pool.
  */
 struct axienet_dma_q {
 	struct axienet_local	*lp; /* parent */
@@ -1022,6 +1034,10 @@ struct axienet_dma_q {
 	unsigned long tx_bytes;
 	unsigned long rx_packets;
 	unsigned long rx_bytes;
+	unsigned long rx_alloc_fail;
+
+	struct page_pool *page_pool;
+	struct xdp_rxq_info xdp_rxq;
 };
 
 #define AXIENET_ETHTOOLS_SSTATS_LEN 6
@@ -1258,7 +1274,6 @@ int tsn_data_path_open(struct net_device *ndev);
 int tsn_data_path_close(struct net_device *ndev);
 #ifdef CONFIG_XILINX_TSN_PTP
 void *axienet_ptp_timer_probe(void __iomem *base, struct platform_device *pdev);
-void axienet_tx_tstamp(struct work_struct *work);
 int axienet_ptp_timer_remove(void *priv);
 #endif
 #ifdef CONFIG_XILINX_TSN_QBV
@@ -1266,14 +1281,21 @@ int axienet_qbv_init(struct net_device *ndev);
 void axienet_qbv_remove(struct net_device *ndev);
 int axienet_set_schedule(struct net_device *ndev, void __user *useraddr);
 int axienet_get_schedule(struct net_device *ndev, void __user *useraddr);
+struct tc_taprio_qopt_offload;
+int axienet_setup_taprio(struct net_device *ndev,
+			 struct tc_taprio_qopt_offload *offload);
+#endif
+#ifdef CONFIG_XILINX_TSN_QCI
+struct flow_block_offload;
+int axienet_qci_setup_block(struct net_device *ndev,
+			    struct flow_block_offload *f);
+#endif
+#if defined(CONFIG_XILINX_TSN_QBV) || defined(CONFIG_XILINX_TSN_QCI)
+int axienet_tsn_setup_tc(struct net_device *ndev, enum tc_setup_type type,
+			 void *type_data);
 #endif
 
 #ifdef CONFIG_XILINX_TSN_QBR
-int axienet_preemption(struct net_device *ndev, void __user *useraddr);
-int axienet_preemption_ctrl(struct net_device *ndev, void __user *useraddr);
-int axienet_preemption_sts(struct net_device *ndev, void __user *useraddr);
-int axienet_preemption_receive(struct net_device *ndev);
-int axienet_preemption_cnt(struct net_device *ndev, void __user *useraddr);
 int axienet_preemption_sts_ethtool(struct net_device *ndev, struct ethtool_mm_state *state);
 void axienet_preemption_cnt_ethtool(struct net_device *ndev, struct ethtool_mm_stats *stats);
 int axienet_preemption_ctrl_ethtool(struct net_device *ndev, struct ethtool_mm_cfg *config_data,
@@ -1322,6 +1344,22 @@ void __maybe_unused axienet_mcdma_tx_bd_free_tsn(struct net_device *ndev,
 						 struct axienet_dma_q *q);
 void __maybe_unused axienet_mcdma_rx_bd_free_tsn(struct net_device *ndev,
 						 struct axienet_dma_q *q);
+struct page *axienet_rx_alloc_page_tsn(struct axienet_dma_q *q,
+				       dma_addr_t *dma);
+int axienet_bpf_tsn(struct net_device *ndev, struct netdev_bpf *bpf);
+
+/**
+ * axienet_xdp_frame_ok_tsn - Check that a frame fits in a single XDP buffer
+ * @frame_size:	Largest frame size received, including the FCS
+ *
+ * Return: true if a frame of @frame_size plus the XDP headroom and the
+ * skb_shared_info fit in one page.
+ */
+static inline bool axienet_xdp_frame_ok_tsn(u32 frame_size)
+{
+	return SKB_DATA_ALIGN(XAE_RX_HEADROOM + frame_size) +
+	       SKB_DATA_ALIGN(sizeof(struct skb_shared_info)) <= PAGE_SIZE;
+}
 irqreturn_t __maybe_unused axienet_mcdma_tx_irq_tsn(int irq, void *_ndev);
 irqreturn_t __maybe_unused axienet_mcdma_rx_irq_tsn(int irq, void *_ndev);
 void __maybe_unused axienet_mcdma_err_handler_tsn(unsigned long data);
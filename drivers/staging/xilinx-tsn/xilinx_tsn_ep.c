@@ -357,6 +357,10 @@ static const struct net_device_ops ep_netdev_ops = {
 	.ndo_start_xmit = tsn_ep_xmit,
 	.ndo_set_mac_address = netdev_set_mac_address,
 	.ndo_select_queue = axienet_tsn_ep_select_queue,
+	.ndo_bpf = axienet_bpf_tsn,
+#if defined(CONFIG_XILINX_TSN_QBV) || defined(CONFIG_XILINX_TSN_QCI)
+	.ndo_setup_tc = axienet_tsn_setup_tc,
+#endif
 #if defined(CONFIG_XILINX_TSN_SWITCH)
 	.ndo_get_port_parent_id = tsn_switch_get_port_parent_id,
 #endif
@@ -168,6 +168,11 @@ int axienet_tsn_probe(struct platform_device *pdev,
 		temac_no = XAE_TEMAC1;
 		lp->switch_prt = PORT_MAC1;
 	}
+#ifdef CONFIG_XILINX_TSN_QCI
+	/* flower filters on the switch ports are offloaded to PSFP */
+	ndev->hw_features |= NETIF_F_HW_TC;
+	ndev->features |= NETIF_F_HW_TC;
+#endif
 	lp->current_rx_filter = HWTSTAMP_FILTER_PTP_V2_L2_EVENT;
 	sprintf(irq_name, "interrupt_ptp_rx_%d", temac_no + 1);
 	lp->ptp_rx_irq = platform_get_irq_byname(pdev, irq_name);
@@ -351,7 +356,6 @@ int axienet_tsn_open(struct net_device *ndev)
 			phy_start(phydev);
 	}
 
-	INIT_WORK(&lp->tx_tstamp_work, axienet_tx_tstamp);
 	skb_queue_head_init(&lp->ptp_txq);
 
 	lp->ptp_rx_hw_pointer = 0;
@@ -364,8 +368,8 @@ int axienet_tsn_open(struct net_device *ndev)
 	if (ret)
 		goto err_ptp_rx_irq;
 
-	ret = request_irq(lp->ptp_tx_irq, axienet_ptp_tx_irq,
-			  0, "ptp_tx", ndev);
+	ret = request_threaded_irq(lp->ptp_tx_irq, axienet_ptp_tx_irq,
+				   axienet_ptp_tx_irq_thread, 0, "ptp_tx", ndev);
 	if (ret)
 		goto err_ptp_tx_irq;
 
@@ -19,24 +19,6 @@
 #include "xilinx_axienet_tsn.h"
 #include "xilinx_tsn_preemption.h"
 
-/**
- * axienet_preemption -  Configure Frame Preemption
- * @ndev: Pointer to the net_device structure
- * @useraddr: Value to be programmed
- * Return: 0 on success, Non-zero error value on failure
- */
-int axienet_preemption(struct net_device *ndev, void __user *useraddr)
-{
-	struct axienet_local *lp = netdev_priv(ndev);
-	u8 preemp;
-
-	if (copy_from_user(&preemp, useraddr, sizeof(preemp)))
-		return -EFAULT;
-
-	axienet_iow(lp, PREEMPTION_ENABLE_REG, preemp & PREEMPTION_ENABLE);
-	return 0;
-}
-
 /**
  * axienet_preemption_ctrl_ethtool -  Configure Frame Preemption Control register
  * @ndev: Pointer to the net_device structure
@@ -57,17 +39,18 @@ int axienet_preemption_ctrl_ethtool(struct net_device *ndev, struct ethtool_mm_c
 	if (!preemption_support)
 		return -EOPNOTSUPP;
 
+	/* The pMAC and preemptible Tx share one enable bit */
+	if (config_data->tx_enabled != config_data->pmac_enabled) {
+		NL_SET_ERR_MSG_MOD(extack,
+				   "pMAC and Tx preemption can't be enabled separately");
+		return -EINVAL;
+	}
+
 	err = ethtool_mm_frag_size_min_to_add(config_data->tx_min_frag_size,
 					      &add_frag_size, extack);
 	if (err)
 		return err;
 
-	if (config_data->tx_enabled) {
-		value = axienet_ior(lp, PREEMPTION_ENABLE_REG);
-		value = value | config_data->tx_enabled;
-		axienet_iow(lp, PREEMPTION_ENABLE_REG, value);
-	}
-
 	value = axienet_ior(lp, PREEMPTION_CTRL_STS_REG);
 
 	value &= ~(VERIFY_TIMER_VALUE_MASK << VERIFY_TIMER_VALUE_SHIFT);
@@ -75,39 +58,21 @@ int axienet_preemption_ctrl_ethtool(struct net_device *ndev, struct ethtool_mm_c
 	value &= ~(ADDITIONAL_FRAG_SIZE_MASK << ADDITIONAL_FRAG_SIZE_SHIFT);
 	value |= (add_frag_size << ADDITIONAL_FRAG_SIZE_SHIFT);
 
-	if (!config_data->verify_enabled) {
+	if (config_data->verify_enabled)
 		value &= ~(DISABLE_PREEMPTION_VERIFY);
-		value |= !(config_data->verify_enabled);
-	}
+	else
+		value |= DISABLE_PREEMPTION_VERIFY;
 
 	axienet_iow(lp, PREEMPTION_CTRL_STS_REG, value);
-	return 0;
-}
 
-/**
- * axienet_preemption_ctrl -  Configure Frame Preemption Control register
- * @ndev: Pointer to the net_device structure
- * @useraddr: Value to be programmed
- * Return: 0 on success, Non-zero error value on failure
- */
-int axienet_preemption_ctrl(struct net_device *ndev, void __user *useraddr)
-{
-	struct axienet_local *lp = netdev_priv(ndev);
-	struct preempt_ctrl_sts data;
-	u32 value;
-
-	if (copy_from_user(&data, useraddr, sizeof(struct preempt_ctrl_sts)))
-		return -EFAULT;
-	value = axienet_ior(lp, PREEMPTION_CTRL_STS_REG);
-
-	value &= ~(VERIFY_TIMER_VALUE_MASK << VERIFY_TIMER_VALUE_SHIFT);
-	value |= (data.verify_timer_value << VERIFY_TIMER_VALUE_SHIFT);
-	value &= ~(ADDITIONAL_FRAG_SIZE_MASK << ADDITIONAL_FRAG_SIZE_SHIFT);
-	value |= (data.additional_frag_size << ADDITIONAL_FRAG_SIZE_SHIFT);
-	value &= ~(DISABLE_PREEMPTION_VERIFY);
-	value |= (data.disable_preemp_verify);
+	/* Enable last, so the verify handshake runs with the new settings */
+	value = axienet_ior(lp, PREEMPTION_ENABLE_REG);
+	if (config_data->tx_enabled)
+		value |= PREEMPTION_ENABLE;
+	else
+		value &= ~(PREEMPTION_ENABLE);
+	axienet_iow(lp, PREEMPTION_ENABLE_REG, value);
 
-	axienet_iow(lp, PREEMPTION_CTRL_STS_REG, value);
 	return 0;
 }
 
@@ -123,13 +88,13 @@ int axienet_preemption_sts_ethtool(struct net_device *ndev, struct ethtool_mm_st
 	u32 value;
 
 	value = axienet_ior(lp, XAE_TSN_ABL_OFFSET);
-	state->pmac_enabled = (value & PREEMPTION_SUPPORT) ? 1 : 0;
-	if (!state->pmac_enabled)
+	if (!(value & PREEMPTION_SUPPORT))
 		return -EOPNOTSUPP;
 
 	state->max_verify_time = MAX_VERIFY_TIME;
 	value = axienet_ior(lp, PREEMPTION_ENABLE_REG);
 	state->tx_enabled = value & PREEMPTION_ENABLE;
+	state->pmac_enabled = state->tx_enabled;
 
 	value = axienet_ior(lp, PREEMPTION_CTRL_STS_REG);
 	state->tx_active = (value & TX_PREEMPTION_STS) ? 1 : 0;
@@ -141,81 +106,11 @@ int axienet_preemption_sts_ethtool(struct net_device *ndev, struct ethtool_mm_st
 								   >> ADDITIONAL_FRAG_SIZE_SHIFT)
 								   & ADDITIONAL_FRAG_SIZE_MASK);
 	state->rx_min_frag_size = ETH_ZLEN;
-	state->verify_enabled = ~(value & DISABLE_PREEMPTION_VERIFY);
+	state->verify_enabled = !(value & DISABLE_PREEMPTION_VERIFY);
 
 	return 0;
 }
 
-/**
- * axienet_preemption_sts -  Get Frame Preemption Status
- * @ndev: Pointer to the net_device structure
- * @useraddr: return value, containing Frame Preemption status
- * Return: 0 on success, Non-zero error value on failure
- */
-int axienet_preemption_sts(struct net_device *ndev, void __user *useraddr)
-{
-	struct axienet_local *lp = netdev_priv(ndev);
-	struct preempt_status status;
-	u32 value;
-
-	value = axienet_ior(lp, PREEMPTION_ENABLE_REG);
-	status.preemp_en = value & PREEMPTION_ENABLE;
-	value = axienet_ior(lp, XAE_TSN_ABL_OFFSET);
-	status.preemp_sup = (value & PREEMPTION_SUPPORT) ? 1 : 0;
-
-	value = axienet_ior(lp, PREEMPTION_CTRL_STS_REG);
-	status.ctrl.tx_preemp_sts = (value & TX_PREEMPTION_STS) ? 1 : 0;
-	status.ctrl.mac_tx_verify_sts = (value >> MAC_MERGE_TX_VERIFY_STS_SHIFT)
-					& MAC_MERGE_TX_VERIFY_STS_MASK;
-	status.ctrl.verify_timer_value = (value >> VERIFY_TIMER_VALUE_SHIFT) &
-					VERIFY_TIMER_VALUE_MASK;
-	status.ctrl.additional_frag_size = (value >> ADDITIONAL_FRAG_SIZE_SHIFT)
-						& ADDITIONAL_FRAG_SIZE_MASK;
-	status.ctrl.disable_preemp_verify = value & DISABLE_PREEMPTION_VERIFY;
-
-	if (copy_to_user(useraddr, &status, sizeof(struct preempt_status)))
-		return -EFAULT;
-	return 0;
-}
-
-int axienet_preemption_receive(struct net_device *ndev)
-{
-	struct axienet_local *lp = netdev_priv(ndev);
-	u32 value;
-	u8 preemption_support;
-
-	value = axienet_ior(lp, XAE_TSN_ABL_OFFSET);
-	preemption_support = (value & PREEMPTION_SUPPORT) ? 1 : 0;
-
-	if (!preemption_support)
-		return -EOPNOTSUPP;
-
-	value = axienet_ior(lp, PREEMPTION_ENABLE_REG);
-	value = value | PREEMPTION_ENABLE;
-	axienet_iow(lp, PREEMPTION_ENABLE_REG, value);
-	return 0;
-}
-
-/**
- * statistic_cnts -  Read statistics counter registers
- * @ndev: Pointer to the net_device structure
- * @ptr: Buffer addr to fill the counter values
- * @count: read #count number of registers
- * @addr_off: Register address to be read
- */
-static void statistic_cnts(struct net_device *ndev, void *ptr,
-			   unsigned int count, unsigned int addr_off)
-{
-	struct axienet_local *lp = netdev_priv(ndev);
-	int *buf = (int *)ptr;
-	int i = 0;
-
-	for (i = 0; i < count; i++) {
-		buf[i] = axienet_ior(lp, addr_off);
-		addr_off += 4;
-	}
-}
-
 /**
  * axienet_preemption_cnt_ethtool -  Get Frame Preemption Statistics counter
  * @ndev: Pointer to the net_device structure
@@ -236,36 +131,6 @@ void axienet_preemption_cnt_ethtool(struct net_device *ndev, struct ethtool_mm_s
 	stats->MACMergeHoldCount = axienet_ior64(lp, MAC_MERGE_HOLD_COUNT_REG);
 }
 
-/**
- * axienet_preemption_cnt -  Get Frame Preemption Statistics counter
- * @ndev: Pointer to the net_device structure
- * @useraddr: return value, containing counters value
- * Return: 0 on success, Non-zero error value on failure
- */
-int axienet_preemption_cnt(struct net_device *ndev, void __user *useraddr)
-{
-	struct axienet_local *lp = netdev_priv(ndev);
-	struct emac_pmac_stats stats;
-
-	statistic_cnts(ndev, &stats.emac,
-		       sizeof(struct statistics_counters) / 4,
-		       RX_BYTES_EMAC_REG);
-
-	stats.preemp_en = axienet_ior(lp, PREEMPTION_ENABLE_REG);
-	if (stats.preemp_en) {
-		statistic_cnts(ndev, &stats.pmac.sts,
-			       sizeof(struct statistics_counters) / 4,
-			       RX_BYTES_PMAC_REG);
-		statistic_cnts(ndev, &stats.pmac.merge,
-			       sizeof(struct mac_merge_counters) / 4,
-			       MAC_MERGE_HOLD_COUNT_REG);
-	}
-
-	if (copy_to_user(useraddr, &stats, sizeof(struct emac_pmac_stats)))
-		return -EFAULT;
-	return 0;
-}
-
 /**
  * axienet_qbu_user_override -  Configure QBU user override register
  * @ndev: Pointer to the net_device structure
@@ -62,14 +62,6 @@
 #define REL_TIME_STS_SHIFT			8
 #define PMAC_HOLD_REQ_STS			BIT(0)
 
-struct preempt_ctrl_sts {
-	u8 tx_preemp_sts;
-	u8 mac_tx_verify_sts;
-	u8 verify_timer_value;
-	u8 additional_frag_size;
-	u8 disable_preemp_verify;
-};
-
 struct qbu_prog_override {
 	u8 enable_value:1;
 	u16 user_hold_time:9;
@@ -102,76 +94,4 @@ struct qbu_all_status {
 	struct qbu_core_status core;
 };
 
-struct cnt_64 {
-	unsigned int msb;
-	unsigned int lsb;
-};
-
-union static_cntr {
-	u64 cnt;
-	struct cnt_64 word;
-};
-
-struct mac_merge_counters {
-	union static_cntr tx_hold_cnt;
-	union static_cntr tx_frag_cnt;
-	union static_cntr rx_assembly_ok_cnt;
-	union static_cntr rx_assembly_err_cnt;
-	union static_cntr rx_smd_err_cnt;
-	union static_cntr rx_frag_cnt;
-};
-
-struct statistics_counters {
-	union static_cntr rx_bytes_cnt;
-	union static_cntr tx_bytes_cnt;
-	union static_cntr undersize_frames_cnt;
-	union static_cntr frag_frames_cnt;
-	union static_cntr rx_64_bytes_frames_cnt;
-	union static_cntr rx_65_127_bytes_frames_cnt;
-	union static_cntr rx_128_255_bytes_frames_cnt;
-	union static_cntr rx_256_511_bytes_frames_cnt;
-	union static_cntr rx_512_1023_bytes_frames_cnt;
-	union static_cntr rx_1024_max_frames_cnt;
-	union static_cntr rx_oversize_frames_cnt;
-	union static_cntr tx_64_bytes_frames_cnt;
-	union static_cntr tx_65_127_bytes_frames_cnt;
-	union static_cntr tx_128_255_bytes_frames_cnt;
-	union static_cntr tx_256_511_bytes_frames_cnt;
-	union static_cntr tx_512_1023_bytes_frames_cnt;
-	union static_cntr tx_1024_max_frames_cnt;
-	union static_cntr tx_oversize_frames_cnt;
-	union static_cntr rx_good_frames_cnt;
-	union static_cntr rx_fcs_err_cnt;
-	union static_cntr rx_good_broadcast_frames_cnt;
-	union static_cntr rx_good_multicast_frames_cnt;
-	union static_cntr rx_good_control_frames_cnt;
-	union static_cntr rx_out_of_range_err_cnt;
-	union static_cntr rx_good_vlan_frames_cnt;
-	union static_cntr rx_good_pause_frames_cnt;
-	union static_cntr rx_bad_opcode_frames_cnt;
-	union static_cntr tx_good_frames_cnt;
-	union static_cntr tx_good_broadcast_frames_cnt;
-	union static_cntr tx_good_multicast_frames_cnt;
-	union static_cntr tx_underrun_err_cnt;
-	union static_cntr tx_good_control_frames_cnt;
-	union static_cntr tx_good_vlan_frames_cnt;
-	union static_cntr tx_good_pause_frames_cnt;
-};
-
-struct pmac_counters {
-	struct statistics_counters sts;
-	struct mac_merge_counters merge;
-};
-
-struct emac_pmac_stats {
-	u8 preemp_en;
-	struct statistics_counters emac;
-	struct pmac_counters pmac;
-};
-
-struct preempt_status {
-	u8 preemp_en;
-	u8 preemp_sup;
-	struct preempt_ctrl_sts ctrl;
-};
 #endif /* XILINX_TSN_PREEMPTION_H */
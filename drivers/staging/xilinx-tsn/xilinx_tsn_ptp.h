@@ -85,5 +85,6 @@
 int axienet_ptp_xmit(struct sk_buff *skb, struct net_device *ndev);
 irqreturn_t axienet_ptp_rx_irq(int irq, void *_ndev);
 irqreturn_t axienet_ptp_tx_irq(int irq, void *_ndev);
+irqreturn_t axienet_ptp_tx_irq_thread(int irq, void *_ndev);
 
 #endif
@@ -290,14 +290,13 @@ irqreturn_t axienet_ptp_rx_irq(int irq, void *_ndev)
 
 /**
  * axienet_tx_tstamp - timestamp skb on trasmit path
- * @work:	Pointer to work_struct structure
+ * @lp:		Pointer to axienet local structure
  *
- * This adds TX timestamp to skb
+ * This adds TX timestamp to every skb the hardware is done with, the
+ * transmitted packet count is read once for the whole batch.
  */
-void axienet_tx_tstamp(struct work_struct *work)
+static void axienet_tx_tstamp(struct axienet_local *lp)
 {
-	struct axienet_local *lp = container_of(work, struct axienet_local,
-			tx_tstamp_work);
 	struct net_device *ndev = lp->ndev;
 	struct skb_shared_hwtstamps hwtstamps;
 	struct sk_buff *skb;
@@ -316,15 +315,14 @@ void axienet_tx_tstamp(struct work_struct *work)
 				PTP_TX_PACKET_FIELD_MASK) >>
 				PTP_TX_PACKET_FIELD_SHIFT;
 
-	while ((skb = __skb_dequeue(&lp->ptp_txq)) != NULL) {
+	while ((skb = skb_peek(&lp->ptp_txq)) != NULL) {
 		index = skb->cb[0];
 
-		/* dequeued packet yet to be xmited? */
-		if (index > tx_packet) {
-			/* enqueue it back and break */
-			skb_queue_tail(&lp->ptp_txq, skb);
+		/* packet yet to be xmited? leave it at the head */
+		if (index > tx_packet)
 			break;
-		}
+		__skb_unlink(skb, &lp->ptp_txq);
+
 		/* time stamp reg offset */
 		ts_reg_offset = PTP_TX_BUFFER_OFFSET(index) +
 					PTP_HW_TSTAMP_OFFSET;
@@ -349,7 +347,7 @@ void axienet_tx_tstamp(struct work_struct *work)
  * @irq:		irq number
  * @_ndev:	net_device pointer
  *
- * Return:	IRQ_HANDLED for all cases.
+ * Return:	IRQ_WAKE_THREAD for all cases.
  *
  */
 irqreturn_t axienet_ptp_tx_irq(int irq, void *_ndev)
@@ -362,7 +360,26 @@ irqreturn_t axienet_ptp_tx_irq(int irq, void *_ndev)
 	/* read ctrl register to clear the interrupt */
 	axienet_ior(lp, PTP_TX_CONTROL_OFFSET);
 
-	schedule_work(&lp->tx_tstamp_work);
+	return IRQ_WAKE_THREAD;
+}
+
+/**
+ * axienet_ptp_tx_irq_thread - PTP TX threaded irq handler
+ * @irq:		irq number
+ * @_ndev:	net_device pointer
+ *
+ * Timestamps the transmitted PTP frames right after the interrupt instead
+ * of waiting for the system workqueue, free_irq() also waits for it so no
+ * timestamping is left running once the interface is down.
+ *
+ * Return:	IRQ_HANDLED for all cases.
+ */
+irqreturn_t axienet_ptp_tx_irq_thread(int irq, void *_ndev)
+{
+	struct net_device *ndev = _ndev;
+	struct axienet_local *lp = netdev_priv(ndev);
+
+	axienet_tx_tstamp(lp);
 
 	netif_wake_queue(ndev);
 
@@ -16,6 +16,10 @@
  * GNU General Public License for more details.
  */
 
+#include <linux/etherdevice.h>
+#include <linux/idr.h>
+#include <net/flow_offload.h>
+#include <net/pkt_cls.h>
 #include "xilinx_tsn_switch.h"
 
 #define SMC_MODE_SHIFT				28
@@ -35,6 +39,40 @@
 #define OP_TYPE_SHIFT				1
 #define PSFP_EN_CONTROL_MASK			0x1
 
+/* Write type programming the filter, the meter and the gate of a stream */
+#define PSFP_WR_OP_ALL				0x0
+#define PSFP_OP_WRITE				1
+
+#define PSFP_MAX_STREAMS			256
+/* Meter rates are in kbit/s */
+#define PSFP_METER_RATE_UNIT			(1000 / BITS_PER_BYTE)
+
+/**
+ * struct qci_flow - Stream filter offloaded from tc flower
+ * @list: Entry in qci_flows
+ * @ndev: Ingress port of the stream
+ * @cookie: tc filter cookie
+ * @cam: CAM entry of the stream before the offload
+ * @id: Gate and meter of the stream
+ * @pkts: Passed frames already reported to tc
+ * @drops: Dropped frames already reported to tc
+ */
+struct qci_flow {
+	struct list_head list;
+	struct net_device *ndev;
+	unsigned long cookie;
+	struct cam_struct cam;
+	u8 id;
+	u64 pkts;
+	u64 drops;
+};
+
+static LIST_HEAD(qci_flows);
+static LIST_HEAD(qci_block_cb_list);
+/* Protects qci_flows and the PSFP staging registers */
+static DEFINE_MUTEX(qci_lock);
+static DEFINE_IDA(qci_ida);
+
 /**
  * psfp_control - Configure thr control for PSFP
  * @data:	Value to be programmed
@@ -152,3 +190,363 @@ void get_psfp_static_counter(struct psfp_static_counter *data)
 	data->err_meter.lsb = axienet_ior(&lp, METER_ERR_OFFSET + offset);
 	data->err_meter.msb = axienet_ior(&lp, METER_ERR_OFFSET + offset + 0x4);
 }
+
+static u64 psfp_cntr(struct static_cntr *cntr)
+{
+	return ((u64)cntr->msb << 32) | cntr->lsb;
+}
+
+static void qci_flow_read_stats(struct qci_flow *flow, u64 *pkts, u64 *drops)
+{
+	struct psfp_static_counter cnt = { .num = flow->id };
+
+	get_psfp_static_counter(&cnt);
+	*pkts = psfp_cntr(&cnt.psfp_fr_count);
+	*drops = psfp_cntr(&cnt.err_filter_ins_port) +
+		 psfp_cntr(&cnt.err_filtr_sdu) + psfp_cntr(&cnt.err_meter);
+}
+
+static struct qci_flow *qci_flow_find(struct net_device *ndev,
+				      unsigned long cookie)
+{
+	struct qci_flow *flow;
+
+	list_for_each_entry(flow, &qci_flows, list)
+		if (flow->ndev == ndev && flow->cookie == cookie)
+			return flow;
+
+	return NULL;
+}
+
+static int qci_flower_parse_key(struct axienet_local *port_lp,
+				struct flow_cls_offload *f,
+				struct cam_struct *cam)
+{
+	struct flow_rule *rule = flow_cls_offload_flow_rule(f);
+	struct netlink_ext_ack *extack = f->common.extack;
+	struct flow_match_eth_addrs addrs;
+	struct native_vlan nvl;
+
+	if (rule->match.dissector->used_keys &
+	    ~(BIT(FLOW_DISSECTOR_KEY_CONTROL) |
+	      BIT(FLOW_DISSECTOR_KEY_BASIC) |
+	      BIT(FLOW_DISSECTOR_KEY_ETH_ADDRS) |
+	      BIT(FLOW_DISSECTOR_KEY_VLAN))) {
+		NL_SET_ERR_MSG_MOD(extack,
+				   "Streams are identified by destination MAC and VLAN only");
+		return -EOPNOTSUPP;
+	}
+
+	if (!flow_rule_match_key(rule, FLOW_DISSECTOR_KEY_ETH_ADDRS)) {
+		NL_SET_ERR_MSG_MOD(extack, "Destination MAC must be matched");
+		return -EOPNOTSUPP;
+	}
+
+	flow_rule_match_eth_addrs(rule, &addrs);
+	if (!is_broadcast_ether_addr(addrs.mask->dst) ||
+	    !is_zero_ether_addr(addrs.mask->src)) {
+		NL_SET_ERR_MSG_MOD(extack,
+				   "Only an exact destination MAC can be matched");
+		return -EOPNOTSUPP;
+	}
+
+	memset(cam, 0, sizeof(struct cam_struct));
+	ether_addr_copy(cam->dest_addr, addrs.key->dst);
+
+	if (flow_rule_match_key(rule, FLOW_DISSECTOR_KEY_VLAN)) {
+		struct flow_match_vlan vlan;
+
+		flow_rule_match_vlan(rule, &vlan);
+		if (vlan.mask->vlan_id != VLAN_VID_MASK ||
+		    vlan.mask->vlan_priority) {
+			NL_SET_ERR_MSG_MOD(extack,
+					   "Only an exact VLAN ID can be matched");
+			return -EOPNOTSUPP;
+		}
+		cam->vlanid = vlan.key->vlan_id;
+	} else {
+		/* untagged frames are looked up with the port VLAN */
+		memset(&nvl, 0, sizeof(struct native_vlan));
+		nvl.port_num = port_lp->switch_prt;
+		tsn_switch_pvid_get(&nvl);
+		cam->vlanid = nvl.vlan_id;
+	}
+
+	return 0;
+}
+
+static int qci_flower_parse_actions(struct flow_cls_offload *f,
+				    struct psfp_config *psfp,
+				    struct meter_config *meter,
+				    struct stream_filter *fltr)
+{
+	struct flow_rule *rule = flow_cls_offload_flow_rule(f);
+	struct netlink_ext_ack *extack = f->common.extack;
+	const struct flow_action_entry *act;
+	bool offloaded = false;
+	u64 cir;
+	int i;
+
+	psfp->allow_stream = true;
+	fltr->max_fr_size = MAX_FR_SIZE_MASK;
+
+	flow_action_for_each(i, act, &rule->action) {
+		switch (act->id) {
+		case FLOW_ACTION_GATE:
+			/* PSFP gates have a state but no schedule */
+			if (act->gate.num_entries != 1) {
+				NL_SET_ERR_MSG_MOD(extack,
+						   "Only a gate with a single entry can be offloaded");
+				return -EOPNOTSUPP;
+			}
+			if (act->gate.entries[0].ipv >= 0) {
+				NL_SET_ERR_MSG_MOD(extack,
+						   "Gate internal priority can't be offloaded");
+				return -EOPNOTSUPP;
+			}
+			psfp->allow_stream = act->gate.entries[0].gate_state;
+			if (act->gate.entries[0].maxoctets > 0)
+				fltr->max_fr_size = min_t(u32, fltr->max_fr_size,
+							  act->gate.entries[0].maxoctets);
+			offloaded = true;
+			break;
+		case FLOW_ACTION_POLICE:
+			if (act->police.rate_pkt_ps ||
+			    act->police.peakrate_bytes_ps ||
+			    act->police.avrate || act->police.overhead) {
+				NL_SET_ERR_MSG_MOD(extack,
+						   "Only a byte rate and a burst can be policed");
+				return -EOPNOTSUPP;
+			}
+			if (act->police.exceed.act_id != FLOW_ACTION_DROP ||
+			    (act->police.notexceed.act_id != FLOW_ACTION_PIPE &&
+			     act->police.notexceed.act_id != FLOW_ACTION_ACCEPT)) {
+				NL_SET_ERR_MSG_MOD(extack,
+						   "Police must drop on exceed and pass otherwise");
+				return -EOPNOTSUPP;
+			}
+			cir = div_u64(act->police.rate_bytes_ps,
+				      PSFP_METER_RATE_UNIT);
+			if (cir > U32_MAX || act->police.burst > SMC_CBR_MASK) {
+				NL_SET_ERR_MSG_MOD(extack,
+						   "Police rate or burst is too large");
+				return -EOPNOTSUPP;
+			}
+			meter->cir = cir;
+			meter->cbr = act->police.burst;
+			if (act->police.mtu)
+				fltr->max_fr_size = min_t(u32, fltr->max_fr_size,
+							  act->police.mtu);
+			psfp->en_meter = true;
+			offloaded = true;
+			break;
+		default:
+			NL_SET_ERR_MSG_MOD(extack,
+					   "Only gate and police actions can be offloaded");
+			return -EOPNOTSUPP;
+		}
+	}
+
+	if (!offloaded) {
+		NL_SET_ERR_MSG_MOD(extack, "Gate or police action is required");
+		return -EOPNOTSUPP;
+	}
+
+	return 0;
+}
+
+static void qci_psfp_write(u8 id, struct psfp_config *psfp)
+{
+	psfp->gate_id = id;
+	psfp->meter_id = id;
+	psfp->wr_op_type = PSFP_WR_OP_ALL;
+	psfp->op_type = PSFP_OP_WRITE;
+	psfp_control(*psfp);
+}
+
+static int qci_flower_replace(struct axienet_local *port_lp,
+			      struct flow_cls_offload *f)
+{
+	struct netlink_ext_ack *extack = f->common.extack;
+	struct psfp_config psfp = { 0 };
+	struct meter_config meter = { 0 };
+	struct stream_filter fltr = { 0 };
+	struct qci_flow *flow, *tmp;
+	struct cam_struct cam;
+	int ret, id;
+
+	ret = qci_flower_parse_key(port_lp, f, &cam);
+	if (ret)
+		return ret;
+
+	ret = qci_flower_parse_actions(f, &psfp, &meter, &fltr);
+	if (ret)
+		return ret;
+
+	ret = tsn_switch_cam_get(&cam);
+	if (ret)
+		return ret;
+	if (!(cam.flags & XAS_CAM_VALID)) {
+		NL_SET_ERR_MSG_MOD(extack,
+				   "Stream needs a static fdb entry to be filtered");
+		return -ENOENT;
+	}
+
+	flow = kzalloc(sizeof(*flow), GFP_KERNEL);
+	if (!flow)
+		return -ENOMEM;
+
+	mutex_lock(&qci_lock);
+
+	ret = -EEXIST;
+	if (qci_flow_find(port_lp->ndev, f->cookie))
+		goto err_unlock;
+
+	/* a CAM entry selects a single gate */
+	list_for_each_entry(tmp, &qci_flows, list) {
+		if (ether_addr_equal(tmp->cam.dest_addr, cam.dest_addr) &&
+		    tmp->cam.vlanid == cam.vlanid) {
+			NL_SET_ERR_MSG_MOD(extack,
+					   "Stream is already filtered");
+			ret = -EBUSY;
+			goto err_unlock;
+		}
+	}
+
+	/* gate 0 is used by all CAM entries without a stream filter */
+	id = ida_alloc_range(&qci_ida, 1, PSFP_MAX_STREAMS - 1, GFP_KERNEL);
+	if (id < 0) {
+		NL_SET_ERR_MSG_MOD(extack, "No free stream filter");
+		ret = id;
+		goto err_unlock;
+	}
+
+	fltr.in_pid = __ffs(port_lp->switch_prt);
+	config_stream_filter(fltr);
+	program_meter_reg(meter);
+	psfp.en_psfp = true;
+	qci_psfp_write(id, &psfp);
+
+	flow->ndev = port_lp->ndev;
+	flow->cookie = f->cookie;
+	flow->cam = cam;
+	flow->id = id;
+	qci_flow_read_stats(flow, &flow->pkts, &flow->drops);
+
+	cam.gate_id = id;
+	ret = tsn_switch_cam_set(cam, 1);
+	if (ret) {
+		memset(&psfp, 0, sizeof(struct psfp_config));
+		qci_psfp_write(id, &psfp);
+		ida_free(&qci_ida, id);
+		goto err_unlock;
+	}
+
+	list_add_tail(&flow->list, &qci_flows);
+	mutex_unlock(&qci_lock);
+
+	return 0;
+
+err_unlock:
+	mutex_unlock(&qci_lock);
+	kfree(flow);
+	return ret;
+}
+
+static int qci_flower_destroy(struct axienet_local *port_lp,
+			      struct flow_cls_offload *f)
+{
+	struct psfp_config psfp = { 0 };
+	struct qci_flow *flow;
+
+	mutex_lock(&qci_lock);
+
+	flow = qci_flow_find(port_lp->ndev, f->cookie);
+	if (!flow) {
+		mutex_unlock(&qci_lock);
+		return -ENOENT;
+	}
+
+	/* detach the stream from its gate before the gate is disabled */
+	tsn_switch_cam_set(flow->cam, 1);
+	qci_psfp_write(flow->id, &psfp);
+
+	list_del(&flow->list);
+	ida_free(&qci_ida, flow->id);
+	mutex_unlock(&qci_lock);
+	kfree(flow);
+
+	return 0;
+}
+
+static int qci_flower_stats(struct axienet_local *port_lp,
+			    struct flow_cls_offload *f)
+{
+	struct qci_flow *flow;
+	u64 pkts, drops;
+
+	mutex_lock(&qci_lock);
+
+	flow = qci_flow_find(port_lp->ndev, f->cookie);
+	if (!flow) {
+		mutex_unlock(&qci_lock);
+		return -ENOENT;
+	}
+
+	qci_flow_read_stats(flow, &pkts, &drops);
+	flow_stats_update(&f->stats, 0, pkts - flow->pkts,
+			  drops - flow->drops, jiffies,
+			  FLOW_ACTION_HW_STATS_IMMEDIATE);
+	flow->pkts = pkts;
+	flow->drops = drops;
+
+	mutex_unlock(&qci_lock);
+
+	return 0;
+}
+
+static int qci_setup_tc_block_cb(enum tc_setup_type type, void *type_data,
+				 void *cb_priv)
+{
+	struct net_device *ndev = cb_priv;
+	struct axienet_local *port_lp = netdev_priv(ndev);
+	struct flow_cls_offload *f = type_data;
+
+	if (!tc_can_offload(ndev) || type != TC_SETUP_CLSFLOWER)
+		return -EOPNOTSUPP;
+
+	switch (f->command) {
+	case FLOW_CLS_REPLACE:
+		return qci_flower_replace(port_lp, f);
+	case FLOW_CLS_DESTROY:
+		return qci_flower_destroy(port_lp, f);
+	case FLOW_CLS_STATS:
+		return qci_flower_stats(port_lp, f);
+	default:
+		return -EOPNOTSUPP;
+	}
+}
+
+/**
+ * axienet_qci_setup_block - Bind a tc block to a switch port
+ * @ndev: Switch port
+ * @f: Block offload
+ *
+ * Return: 0 on success, Non-zero error value on failure.
+ *
+ * Flower filters of the block are offloaded to the PSFP stream filters,
+ * a filter matches the CAM entry of a stream and its gate and police
+ * actions program the gate and the meter selected by that CAM entry.
+ */
+int axienet_qci_setup_block(struct net_device *ndev,
+			    struct flow_block_offload *f)
+{
+	struct axienet_local *port_lp = netdev_priv(ndev);
+
+	if (!lp.regs || !(port_lp->switch_prt & (PORT_MAC1 | PORT_MAC2)))
+		return -EOPNOTSUPP;
+
+	return flow_block_cb_setup_simple(f, &qci_block_cb_list,
+					  qci_setup_tc_block_cb,
+					  ndev, ndev, true);
+}
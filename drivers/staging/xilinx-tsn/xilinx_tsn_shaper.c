@@ -16,6 +16,8 @@
  * GNU General Public License for more details.
  */
 
+#include <net/pkt_sched.h>
+
 #include "xilinx_axienet_tsn.h"
 #include "xilinx_tsn_shaper.h"
 
@@ -133,6 +135,99 @@ int axienet_set_schedule(struct net_device *ndev, void __user *useraddr)
 	return ret;
 }
 
+/* Traffic class i of the taprio gate mask is hw queue i, map back to the
+ * fixed gate states used by __axienet_set_schedule()
+ */
+static u32 axienet_map_tc_to_gs(struct axienet_local *lp, u32 gate_mask)
+{
+	u32 gs = 0;
+
+	if (gate_mask & BIT(0))
+		gs |= GS_BE_OPEN;
+	if (lp->num_tc == 2) {
+		if (gate_mask & BIT(1))
+			gs |= GS_ST_OPEN;
+	} else {
+		if (gate_mask & BIT(1))
+			gs |= GS_RE_OPEN;
+		if (gate_mask & BIT(2))
+			gs |= GS_ST_OPEN;
+	}
+
+	return gs;
+}
+
+/**
+ * axienet_setup_taprio - Offload a taprio qdisc
+ * @ndev: Pointer to the net_device structure
+ * @offload: taprio schedule
+ *
+ * Return: 0 on success, Non-zero error value on failure.
+ *
+ * Programs the Qbv gate control list from a taprio qdisc, so the schedule
+ * can be configured with tc instead of the private ioctl.
+ */
+int axienet_setup_taprio(struct net_device *ndev,
+			 struct tc_taprio_qopt_offload *offload)
+{
+	struct axienet_local *lp = netdev_priv(ndev);
+	struct qbv_info *qbv;
+	u32 ns;
+	int ret;
+	size_t i;
+
+	if (!lp->qbv_regs)
+		return -EOPNOTSUPP;
+
+	if (offload->enable) {
+		if (!offload->num_entries ||
+		    offload->num_entries > QBV_MAX_ENTRIES ||
+		    !offload->cycle_time ||
+		    offload->cycle_time > CYCLE_TIME_DENOMINATOR_MASK ||
+		    offload->cycle_time_extension ||
+		    offload->base_time < 0)
+			return -ERANGE;
+
+		for (i = 0; i < offload->num_entries; i++) {
+			struct tc_taprio_sched_entry *entry =
+				&offload->entries[i];
+
+			if (entry->command != TC_TAPRIO_CMD_SET_GATES)
+				return -EOPNOTSUPP;
+			if (entry->gate_mask & ~GENMASK(lp->num_tc - 1, 0) ||
+			    !entry->interval ||
+			    entry->interval > CTRL_LIST_TIME_INTERVAL_MASK)
+				return -ERANGE;
+		}
+	}
+
+	qbv = kzalloc(sizeof(*qbv), GFP_KERNEL);
+	if (!qbv)
+		return -ENOMEM;
+
+	/* a zero cycle time disables the gates */
+	if (offload->enable) {
+		/* replace any running schedule, as tc does */
+		qbv->force = 1;
+		qbv->cycle_time = offload->cycle_time;
+		qbv->ptp_time_sec = div_u64_rem(offload->base_time,
+						NSEC_PER_SEC, &ns);
+		qbv->ptp_time_ns = ns;
+		qbv->list_length = offload->num_entries;
+		for (i = 0; i < offload->num_entries; i++) {
+			qbv->acl_gate_state[i] =
+				axienet_map_tc_to_gs(lp,
+						     offload->entries[i].gate_mask);
+			qbv->acl_gate_time[i] = offload->entries[i].interval;
+		}
+	}
+
+	ret = __axienet_set_schedule(ndev, qbv);
+	kfree(qbv);
+
+	return ret;
+}
+
 static int __axienet_get_schedule(struct net_device *ndev, struct qbv_info *qbv)
 {
 	struct axienet_local *lp = netdev_priv(ndev);
@@ -19,7 +19,12 @@
 #include <linux/of_platform.h>
 #include <linux/module.h>
 #include <linux/miscdevice.h>
+#include <linux/etherdevice.h>
 #include <linux/of_net.h>
+#include <linux/rtnetlink.h>
+#include <linux/sort.h>
+#include <linux/string.h>
+#include <linux/workqueue.h>
 #include "xilinx_tsn_switch.h"
 
 static struct miscdevice switch_dev;
@@ -28,6 +33,30 @@ struct axienet_local lp;
 static struct axienet_local *ep_lp;
 static u8 en_hw_addr_learning;
 static u8 sw_mac_addr[ETH_ALEN];
+/* Serializes the CAM command interface */
+static DEFINE_MUTEX(cam_lock);
+
+/**
+ * struct tsn_fdb_sync_port - Learnt addresses reported for a network port
+ * @np: Device node of the port
+ * @entries: Sorted addresses currently reported to the bridge
+ * @scratch: Buffer the learnt table is read into
+ * @num_entries: Number of valid @entries
+ * @num_learnt: Learnt entry count of the last table walk
+ */
+struct tsn_fdb_sync_port {
+	struct device_node *np;
+	struct mac_learnt *entries;
+	struct mac_learnt *scratch;
+	u16 num_entries;
+	u16 num_learnt;
+};
+
+/* Network ports 1 and 2 of the switch, the learnt tables are per port */
+static struct tsn_fdb_sync_port fdb_sync_port[2];
+static unsigned int fdb_sync_ticks;
+static void tsn_switch_fdb_sync_work(struct work_struct *work);
+static DECLARE_DELAYED_WORK(fdb_sync_work, tsn_switch_fdb_sync_work);
 
 #define DELAY_OF_FIVE_MILLISEC			(5 * DELAY_OF_ONE_MILLISEC)
 
@@ -106,6 +135,13 @@ static u8 sw_mac_addr[ETH_ALEN];
 #define DEFAULT_PVID		1
 #define DEFAULT_FWD_ALL		GENMASK(2, 0)
 
+/* Learnt table sync: the learnt counters are checked every interval,
+ * the tables are walked when a counter moves and every FULL intervals
+ * to catch an address aging out while another one is learnt.
+ */
+#define FDB_SYNC_INTERVAL	msecs_to_jiffies(1000)
+#define FDB_SYNC_FULL		10
+
 /* Match table for of_platform binding */
 static const struct of_device_id tsnswitch_of_match[] = {
 	{ .compatible = "xlnx,tsn-switch", },
@@ -517,7 +553,8 @@ static void get_memory_static_counter(struct switch_data *data)
 							     XAS_MEM_STCNTR_ERR_BE_MAC1_MAC2 + 0x4);
 }
 
-int tsn_switch_cam_set(struct cam_struct data, u8 add)
+/* Must be called with cam_lock held */
+static int __tsn_switch_cam_set(const struct cam_struct *data, u8 add)
 {
 	u32 port_action = 0;
 	u32 tv2 = 0;
@@ -531,12 +568,12 @@ int tsn_switch_cam_set(struct cam_struct data, u8 add)
 		pr_err("CAM init timed out\n");
 		return -ETIMEDOUT;
 	}
-	if (add && ((data.fwd_port & PORT_EX_ONLY) || (data.fwd_port & PORT_EX_EP))) {
+	if (add && ((data->fwd_port & PORT_EX_ONLY) || (data->fwd_port & PORT_EX_EP))) {
 		if (!(ep_lp->ex_ep)) {
 			pr_err("Endpoint extension support is not present in this design\n");
 			return -EINVAL;
-		} else if ((data.fwd_port & PORT_EX_ONLY) &&
-			    (data.fwd_port & PORT_EX_EP)) {
+		} else if ((data->fwd_port & PORT_EX_ONLY) &&
+			    (data->fwd_port & PORT_EX_EP)) {
 			if (!(ep_lp->packet_switch)) {
 				pr_err("Support for forwarding packets from endpoint to extended endpoint or vice versa is not present in this design\n");
 				return -EINVAL;
@@ -545,11 +582,11 @@ int tsn_switch_cam_set(struct cam_struct data, u8 add)
 	}
 	/* mac and vlan */
 	axienet_iow(&lp, XAS_SDL_CAM_KEY1_OFFSET,
-		    (data.dest_addr[0] << 24) | (data.dest_addr[1] << 16) |
-		    (data.dest_addr[2] << 8)  | (data.dest_addr[3]));
+		    (data->dest_addr[0] << 24) | (data->dest_addr[1] << 16) |
+		    (data->dest_addr[2] << 8)  | (data->dest_addr[3]));
 	axienet_iow(&lp, XAS_SDL_CAM_KEY2_OFFSET,
-		    ((data.dest_addr[4] << 8) | data.dest_addr[5]) |
-		    ((data.vlanid & SDL_CAM_VLAN_MASK) << SDL_CAM_VLAN_SHIFT));
+		    ((data->dest_addr[4] << 8) | data->dest_addr[5]) |
+		    ((data->vlanid & SDL_CAM_VLAN_MASK) << SDL_CAM_VLAN_SHIFT));
 
 	/* Introduce wmb to preserve KEY2 and TV1 write order fix possible
 	 * HW hang when KEY2 and TV1 registers are accessed sequentially.
@@ -558,16 +595,16 @@ int tsn_switch_cam_set(struct cam_struct data, u8 add)
 	wmb();
 	/* TV 1 and TV 2 */
 	axienet_iow(&lp, XAS_SDL_CAM_TV1_OFFSET,
-		    (data.src_addr[0] << 24) | (data.src_addr[1] << 16) |
-		    (data.src_addr[2] << 8)  | (data.src_addr[3]));
+		    (data->src_addr[0] << 24) | (data->src_addr[1] << 16) |
+		    (data->src_addr[2] << 8)  | (data->src_addr[3]));
 
-	tv2 = ((data.src_addr[4] << 8) | data.src_addr[5]) |
-	       ((data.tv_vlanid & SDL_CAM_VLAN_MASK) << SDL_CAM_VLAN_SHIFT);
+	tv2 = ((data->src_addr[4] << 8) | data->src_addr[5]) |
+	       ((data->tv_vlanid & SDL_CAM_VLAN_MASK) << SDL_CAM_VLAN_SHIFT);
 
-	if (data.flags & XAS_CAM_IPV_EN)
+	if (data->flags & XAS_CAM_IPV_EN)
 		en_ipv = 1;
 
-	tv2 = tv2 | ((data.ipv & SDL_CAM_IPV_MASK) << SDL_CAM_IPV_SHIFT)
+	tv2 = tv2 | ((data->ipv & SDL_CAM_IPV_MASK) << SDL_CAM_IPV_SHIFT)
 				| (en_ipv << SDL_EN_CAM_IPV_SHIFT);
 
 	axienet_iow(&lp, XAS_SDL_CAM_TV2_OFFSET, tv2);
@@ -577,19 +614,19 @@ int tsn_switch_cam_set(struct cam_struct data, u8 add)
 	 */
 	wmb();
 
-	if (data.fwd_port & PORT_EP)
-		port_action = data.ep_port_act << SDL_CAM_EP_ACTION_LIST_SHIFT;
-	if (data.fwd_port & PORT_MAC1 || data.fwd_port & PORT_MAC2)
-		port_action |= data.mac_port_act <<
+	if (data->fwd_port & PORT_EP)
+		port_action = data->ep_port_act << SDL_CAM_EP_ACTION_LIST_SHIFT;
+	if (data->fwd_port & PORT_MAC1 || data->fwd_port & PORT_MAC2)
+		port_action |= data->mac_port_act <<
 				SDL_CAM_MAC_ACTION_LIST_SHIFT;
 
-	if (data.flags & XAS_CAM_EP_MGMTQ_EN)
+	if (data->flags & XAS_CAM_EP_MGMTQ_EN)
 		port_action |= SDL_CAM_EP_MGMTQ_EN;
 
-	port_action = port_action | (data.fwd_port << SDL_CAM_PORT_LIST_SHIFT);
+	port_action = port_action | (data->fwd_port << SDL_CAM_PORT_LIST_SHIFT);
 
 #if IS_ENABLED(CONFIG_XILINX_TSN_QCI) || IS_ENABLED(CONFIG_XILINX_TSN_CB)
-	port_action = port_action | (data.gate_id << SDL_GATEID_SHIFT);
+	port_action = port_action | (data->gate_id << SDL_GATEID_SHIFT);
 #endif
 
 	/* port action */
@@ -618,12 +655,59 @@ int tsn_switch_cam_set(struct cam_struct data, u8 add)
 	return 0;
 }
 
+int tsn_switch_cam_set(struct cam_struct data, u8 add)
+{
+	int ret;
+
+	mutex_lock(&cam_lock);
+	ret = __tsn_switch_cam_set(&data, add);
+	mutex_unlock(&cam_lock);
+
+	return ret;
+}
+
+/* Program a batch of CAM entries with a single ioctl and a single copy */
+static int set_cam_entries(void __user *arg)
+{
+	struct cam_struct *cams;
+	struct cam_bulk bulk;
+	int ret = 0;
+	u32 i;
+
+	if (copy_from_user(&bulk, arg, sizeof(struct cam_bulk)))
+		return -EFAULT;
+
+	if (!bulk.num_entries || bulk.num_entries > MAX_NUM_CAM_BULK_ENTRIES)
+		return -EINVAL;
+
+	cams = vmemdup_user(u64_to_user_ptr(bulk.entries),
+			    array_size(bulk.num_entries, sizeof(*cams)));
+	if (IS_ERR(cams))
+		return PTR_ERR(cams);
+
+	mutex_lock(&cam_lock);
+	for (i = 0; i < bulk.num_entries; i++) {
+		ret = __tsn_switch_cam_set(&cams[i], bulk.add);
+		if (ret)
+			break;
+	}
+	mutex_unlock(&cam_lock);
+	kvfree(cams);
+
+	bulk.num_done = i;
+	if (copy_to_user(arg, &bulk, sizeof(struct cam_bulk)))
+		return -EFAULT;
+
+	return ret;
+}
+
 static void port_vlan_mem_ctrl(u32 port_vlan_mem)
 {
 		axienet_iow(&lp, XAS_VLAN_MEMB_CTRL_REG, port_vlan_mem);
 }
 
-static int read_cam_entry(struct cam_struct data, void __user *arg)
+/* Must be called with cam_lock held */
+static int __tsn_switch_cam_get(struct cam_struct *data)
 {
 	u32 u_value, reg, err;
 
@@ -638,11 +722,11 @@ static int read_cam_entry(struct cam_struct data, void __user *arg)
 
 	/* mac and vlan */
 	axienet_iow(&lp, XAS_SDL_CAM_KEY1_OFFSET,
-		    (data.dest_addr[0] << 24) | (data.dest_addr[1] << 16) |
-		    (data.dest_addr[2] << 8)  | (data.dest_addr[3]));
+		    (data->dest_addr[0] << 24) | (data->dest_addr[1] << 16) |
+		    (data->dest_addr[2] << 8)  | (data->dest_addr[3]));
 	axienet_iow(&lp, XAS_SDL_CAM_KEY2_OFFSET,
-		    ((data.dest_addr[4] << 8) | data.dest_addr[5]) |
-		    ((data.vlanid & SDL_CAM_VLAN_MASK) << SDL_CAM_VLAN_SHIFT));
+		    ((data->dest_addr[4] << 8) | data->dest_addr[5]) |
+		    ((data->vlanid & SDL_CAM_VLAN_MASK) << SDL_CAM_VLAN_SHIFT));
 	/* Finish writing vlan id and mac address before triggering a read
 	 * from the CAM since read depends on these parameters
 	 * TODO: Check alternatives to barrier.
@@ -660,32 +744,62 @@ static int read_cam_entry(struct cam_struct data, void __user *arg)
 
 	if (u_value & SDL_CAM_FOUND_BIT) {
 		u_value = axienet_ior(&lp, XAS_SDL_CAM_TV1_OFFSET);
-		data.src_addr[0] = (u_value >> 24) & 0xFF;
-		data.src_addr[1] = (u_value >> 16) & 0xFF;
-		data.src_addr[2] = (u_value >> 8) & 0xFF;
-		data.src_addr[3] = (u_value) & 0xFF;
+		data->src_addr[0] = (u_value >> 24) & 0xFF;
+		data->src_addr[1] = (u_value >> 16) & 0xFF;
+		data->src_addr[2] = (u_value >> 8) & 0xFF;
+		data->src_addr[3] = (u_value) & 0xFF;
 		u_value = axienet_ior(&lp, XAS_SDL_CAM_TV2_OFFSET);
-		data.src_addr[4] = (u_value >> 8) & 0xFF;
-		data.src_addr[5] = (u_value) & 0xFF;
-		data.tv_vlanid   = (u_value >> SDL_CAM_VLAN_SHIFT)
+		data->src_addr[4] = (u_value >> 8) & 0xFF;
+		data->src_addr[5] = (u_value) & 0xFF;
+		data->tv_vlanid   = (u_value >> SDL_CAM_VLAN_SHIFT)
 					& SDL_CAM_VLAN_MASK;
-		data.ipv = (u_value >> SDL_CAM_IPV_SHIFT) & SDL_CAM_IPV_MASK;
+		data->ipv = (u_value >> SDL_CAM_IPV_SHIFT) & SDL_CAM_IPV_MASK;
 		if ((u_value >> SDL_EN_CAM_IPV_SHIFT) & 0x1)
-			data.flags |= XAS_CAM_IPV_EN;
+			data->flags |= XAS_CAM_IPV_EN;
 		u_value = axienet_ior(&lp, XAS_SDL_CAM_PORT_ACT_OFFSET);
 		if (ep_lp->ex_ep)
-			data.fwd_port = (u_value >> SDL_CAM_PORT_LIST_SHIFT) & 0x1F;
+			data->fwd_port = (u_value >> SDL_CAM_PORT_LIST_SHIFT) & 0x1F;
 		else
-			data.fwd_port = (u_value >> SDL_CAM_PORT_LIST_SHIFT) & 0x7;
-		data.ep_port_act = (u_value >> SDL_CAM_EP_ACTION_LIST_SHIFT)
+			data->fwd_port = (u_value >> SDL_CAM_PORT_LIST_SHIFT) & 0x7;
+		data->ep_port_act = (u_value >> SDL_CAM_EP_ACTION_LIST_SHIFT)
 					& 0xF;
-		data.mac_port_act = (u_value >> SDL_CAM_MAC_ACTION_LIST_SHIFT)
+		data->mac_port_act = (u_value >> SDL_CAM_MAC_ACTION_LIST_SHIFT)
 					& 0xF;
-		data.gate_id = (u_value >> SDL_GATEID_SHIFT) & 0xFF;
-		data.flags |= XAS_CAM_VALID;
+		data->gate_id = (u_value >> SDL_GATEID_SHIFT) & 0xFF;
+		data->flags |= XAS_CAM_VALID;
 	} else {
-		data.flags &= ~XAS_CAM_VALID;
+		data->flags &= ~XAS_CAM_VALID;
 	}
+
+	return 0;
+}
+
+/**
+ * tsn_switch_cam_get - Look up a CAM entry
+ * @data: CAM entry, dest_addr and vlanid are the key and the rest is
+ *	  filled in, XAS_CAM_VALID is set in flags if the entry exists
+ *
+ * Return: 0 on success, -ETIMEDOUT if the CAM doesn't respond
+ */
+int tsn_switch_cam_get(struct cam_struct *data)
+{
+	int ret;
+
+	mutex_lock(&cam_lock);
+	ret = __tsn_switch_cam_get(data);
+	mutex_unlock(&cam_lock);
+
+	return ret;
+}
+
+static int read_cam_entry(struct cam_struct data, void __user *arg)
+{
+	int ret;
+
+	ret = tsn_switch_cam_get(&data);
+	if (ret)
+		return ret;
+
 	if (copy_to_user(arg, &data, sizeof(struct cam_struct)))
 		return -EFAULT;
 
@@ -749,40 +863,39 @@ static int get_mac_addr_learn(void __user *arg)
 	return 0;
 }
 
-static int get_mac_addr_learnt_list(void __user *arg)
+/**
+ * tsn_switch_read_learnt - Read the hardware learnt address table of a port
+ * @port_num: PORT_MAC1 or PORT_MAC2
+ * @list: Array of MAX_NUM_MAC_ENTRIES entries, entries that are not in use
+ *	  are left untouched
+ * @num_list: Number of learnt entries reported by the hardware
+ *
+ * Must be called with cam_lock held.
+ *
+ * Return: 0 on success, -ETIMEDOUT if the CAM doesn't respond
+ */
+static int tsn_switch_read_learnt(u8 port_num, struct mac_learnt *list,
+				  u16 *num_list)
 {
-	struct mac_addr_list *mac_list;
 	u32 i = 0;
 	u32 u_value, reg, err;
 	u16 read_key_addr = 0;
-	int ret = 0;
-
-	mac_list = kzalloc(sizeof(*mac_list), GFP_KERNEL);
-	if (!mac_list) {
-		ret = -ENOMEM;
-		goto ret_status;
-	}
 
-	if (copy_from_user(mac_list, arg, sizeof(u8))) {
-		ret = -EFAULT;
-		goto free_mac_list;
-	}
 	/* wait for cam init done */
 	err = readl_poll_timeout(lp.regs + XAS_SDL_CAM_STATUS_OFFSET, reg,
 				 (reg & SDL_CAM_WR_ENABLE), 10,
 				 DELAY_OF_FIVE_MILLISEC);
 	if (err) {
 		pr_err("CAM init timed out\n");
-		ret = -ETIMEDOUT;
-		goto free_mac_list;
+		return -ETIMEDOUT;
 	}
 	u_value = axienet_ior(&lp, XAS_SDL_CAM_STATUS_OFFSET);
 
-	if (mac_list->port_num == PORT_MAC1) {
-		mac_list->num_list = (u_value >> SDL_CAM_LEARNT_ENT_MAC1_SHIFT)
+	if (port_num == PORT_MAC1) {
+		*num_list = (u_value >> SDL_CAM_LEARNT_ENT_MAC1_SHIFT)
 					& SDL_CAM_LEARNT_ENT_MASK;
 	} else {
-		mac_list->num_list = (u_value >> SDL_CAM_LEARNT_ENT_MAC2_SHIFT)
+		*num_list = (u_value >> SDL_CAM_LEARNT_ENT_MAC2_SHIFT)
 					& SDL_CAM_LEARNT_ENT_MASK;
 		read_key_addr = 0x800;
 	}
@@ -793,8 +906,7 @@ static int get_mac_addr_learnt_list(void __user *arg)
 					 DELAY_OF_FIVE_MILLISEC);
 		if (err) {
 			pr_err("CAM init timed out\n");
-			ret = -ETIMEDOUT;
-			goto free_mac_list;
+			return -ETIMEDOUT;
 		}
 
 		u_value = ((read_key_addr + i) << SDL_CAM_READ_KEY_ADDR_SHIFT)
@@ -806,23 +918,49 @@ static int get_mac_addr_learnt_list(void __user *arg)
 					 DELAY_OF_FIVE_MILLISEC);
 		if (err) {
 			pr_err("CAM write timed out\n");
-			ret = -ETIMEDOUT;
-			goto free_mac_list;
+			return -ETIMEDOUT;
 		}
 		u_value = axienet_ior(&lp, XAS_SDL_CAM_CTRL_OFFSET);
 
 		if (u_value & SDL_CAM_FOUND_BIT) {
 			u_value = axienet_ior(&lp, XAS_SDL_CAM_KEY1_OFFSET);
-			mac_list->list[i].mac_addr[0] = (u_value >> 24) & 0xFF;
-			mac_list->list[i].mac_addr[1] = (u_value >> 16) & 0xFF;
-			mac_list->list[i].mac_addr[2] = (u_value >> 8) & 0xFF;
-			mac_list->list[i].mac_addr[3] = (u_value) & 0xFF;
+			list[i].mac_addr[0] = (u_value >> 24) & 0xFF;
+			list[i].mac_addr[1] = (u_value >> 16) & 0xFF;
+			list[i].mac_addr[2] = (u_value >> 8) & 0xFF;
+			list[i].mac_addr[3] = (u_value) & 0xFF;
 			u_value = axienet_ior(&lp, XAS_SDL_CAM_KEY2_OFFSET);
-			mac_list->list[i].mac_addr[4] = (u_value >> 8) & 0xFF;
-			mac_list->list[i].mac_addr[5] = (u_value) & 0xFF;
-			mac_list->list[i].vlan_id     = (u_value >> 16) & 0xFFF;
+			list[i].mac_addr[4] = (u_value >> 8) & 0xFF;
+			list[i].mac_addr[5] = (u_value) & 0xFF;
+			list[i].vlan_id     = (u_value >> 16) & 0xFFF;
 		}
 	}
+
+	return 0;
+}
+
+static int get_mac_addr_learnt_list(void __user *arg)
+{
+	struct mac_addr_list *mac_list;
+	int ret = 0;
+
+	mac_list = kzalloc(sizeof(*mac_list), GFP_KERNEL);
+	if (!mac_list) {
+		ret = -ENOMEM;
+		goto ret_status;
+	}
+
+	if (copy_from_user(mac_list, arg, sizeof(u8))) {
+		ret = -EFAULT;
+		goto free_mac_list;
+	}
+
+	mutex_lock(&cam_lock);
+	ret = tsn_switch_read_learnt(mac_list->port_num, mac_list->list,
+				     &mac_list->num_list);
+	mutex_unlock(&cam_lock);
+	if (ret)
+		goto free_mac_list;
+
 	if (copy_to_user(arg, mac_list, sizeof(struct mac_addr_list))) {
 		ret = -EFAULT;
 		goto free_mac_list;
@@ -834,6 +972,130 @@ static int get_mac_addr_learnt_list(void __user *arg)
 	return ret;
 }
 
+static int tsn_switch_mac_learnt_cmp(const void *a, const void *b)
+{
+	const struct mac_learnt *x = a, *y = b;
+	int ret;
+
+	ret = memcmp(x->mac_addr, y->mac_addr, ETH_ALEN);
+	if (ret)
+		return ret;
+
+	return x->vlan_id - y->vlan_id;
+}
+
+/* Report the difference between the previous and the new learnt addresses,
+ * the new sorted addresses of num entries are in sp->scratch.
+ */
+static void tsn_switch_fdb_sync_port(struct tsn_fdb_sync_port *sp, u16 num)
+{
+	struct mac_learnt *old = sp->entries, *new = sp->scratch;
+	struct net_device *ndev;
+	u16 i = 0, j = 0;
+	int cmp;
+
+	ndev = of_find_net_device_by_node(sp->np);
+	if (!ndev)
+		return;
+
+	rtnl_lock();
+	while (i < sp->num_entries || j < num) {
+		if (i == sp->num_entries)
+			cmp = 1;
+		else if (j == num)
+			cmp = -1;
+		else
+			cmp = tsn_switch_mac_learnt_cmp(&old[i], &new[j]);
+
+		if (cmp < 0) {
+			xlnx_switchdev_fdb_learnt(ndev, old[i].mac_addr,
+						  old[i].vlan_id, false);
+			i++;
+		} else if (cmp > 0) {
+			xlnx_switchdev_fdb_learnt(ndev, new[j].mac_addr,
+						  new[j].vlan_id, true);
+			j++;
+		} else {
+			i++;
+			j++;
+		}
+	}
+	rtnl_unlock();
+	dev_put(ndev);
+
+	sp->entries = new;
+	sp->scratch = old;
+	sp->num_entries = num;
+}
+
+static void tsn_switch_fdb_sync_work(struct work_struct *work)
+{
+	bool full = !(++fdb_sync_ticks % FDB_SYNC_FULL);
+	u32 status;
+	int i;
+
+	/* The learnt counters are cheap to read, the tables are not */
+	status = axienet_ior(&lp, XAS_SDL_CAM_STATUS_OFFSET);
+
+	for (i = 0; i < ARRAY_SIZE(fdb_sync_port); i++) {
+		struct tsn_fdb_sync_port *sp = &fdb_sync_port[i];
+		u8 port_num = i ? PORT_MAC2 : PORT_MAC1;
+		u16 num_learnt, num = 0, n;
+		int ret;
+
+		if (!sp->np)
+			continue;
+
+		num_learnt = (status >> (i ? SDL_CAM_LEARNT_ENT_MAC2_SHIFT :
+					 SDL_CAM_LEARNT_ENT_MAC1_SHIFT)) &
+			     SDL_CAM_LEARNT_ENT_MASK;
+		if (num_learnt == sp->num_learnt && !full)
+			continue;
+
+		memset(sp->scratch, 0,
+		       MAX_NUM_MAC_ENTRIES * sizeof(*sp->scratch));
+		mutex_lock(&cam_lock);
+		ret = tsn_switch_read_learnt(port_num, sp->scratch, &num_learnt);
+		mutex_unlock(&cam_lock);
+		if (ret)
+			continue;
+		sp->num_learnt = num_learnt;
+
+		for (n = 0; n < MAX_NUM_MAC_ENTRIES; n++)
+			if (!is_zero_ether_addr(sp->scratch[n].mac_addr))
+				sp->scratch[num++] = sp->scratch[n];
+		sort(sp->scratch, num, sizeof(*sp->scratch),
+		     tsn_switch_mac_learnt_cmp, NULL);
+
+		tsn_switch_fdb_sync_port(sp, num);
+	}
+
+	schedule_delayed_work(&fdb_sync_work, FDB_SYNC_INTERVAL);
+}
+
+static int tsn_switch_fdb_sync_start(struct device *dev)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(fdb_sync_port); i++) {
+		struct tsn_fdb_sync_port *sp = &fdb_sync_port[i];
+
+		if (!sp->np)
+			continue;
+
+		sp->entries = devm_kcalloc(dev, MAX_NUM_MAC_ENTRIES,
+					   sizeof(*sp->entries), GFP_KERNEL);
+		sp->scratch = devm_kcalloc(dev, MAX_NUM_MAC_ENTRIES,
+					   sizeof(*sp->scratch), GFP_KERNEL);
+		if (!sp->entries || !sp->scratch)
+			return -ENOMEM;
+	}
+
+	schedule_delayed_work(&fdb_sync_work, FDB_SYNC_INTERVAL);
+
+	return 0;
+}
+
 int tsn_switch_set_stp_state(struct port_status *port)
 {
 	u32 u_value, reg, err;
@@ -1288,6 +1550,10 @@ static long switch_ioctl(struct file *file, unsigned int cmd,
 		retval = read_cam_entry(data.cam_data, (void __user *)arg);
 		break;
 
+	case SET_CAM_ENTRIES:
+		retval = set_cam_entries((void __user *)arg);
+		break;
+
 	case SET_MAC_ADDR_LEARN_CONFIG:
 		if (!en_hw_addr_learning)
 			return -EPERM;
@@ -1610,6 +1876,8 @@ static int tsn_switch_fdb_init(struct platform_device *pdev)
 			return -EINVAL;
 		}
 		tsn_switch_set_src_mac_filter(mac_addr, port);
+		if (port <= ARRAY_SIZE(fdb_sync_port))
+			fdb_sync_port[port - 1].np = np;
 	}
 
 	/* rest of the mac addr for all ports would be same
@@ -1838,6 +2106,13 @@ static int tsnswitch_probe(struct platform_device *pdev)
 		}
 	}
 
+	/* reflect hardware learnt addresses in the bridge fdb */
+	if (en_hw_addr_learning && !inband_mgmt_tag) {
+		ret = tsn_switch_fdb_sync_start(&pdev->dev);
+		if (ret)
+			goto err;
+	}
+
 	return ret;
 err:
 	if (!inband_mgmt_tag)
@@ -1849,6 +2124,7 @@ static int tsnswitch_probe(struct platform_device *pdev)
 
 static int tsnswitch_remove(struct platform_device *pdev)
 {
+	cancel_delayed_work_sync(&fdb_sync_work);
 	misc_deregister(&switch_dev);
 	xlnx_switchdev_remove();
 	return 0;
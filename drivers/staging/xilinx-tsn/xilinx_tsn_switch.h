@@ -56,6 +56,7 @@
 #define SET_PORT_NATIVE_VLAN			0x3A
 #define GET_PORT_NATIVE_VLAN			0x3B
 #define SET_PMAP_CONFIG				0x3D
+#define SET_CAM_ENTRIES				0x3E
 
 /* Xilinx Axi Switch Offsets*/
 #define XAS_STATUS_OFFSET			0x00000
@@ -352,6 +353,17 @@ struct cam_struct {
 	u8 mac_port_act;
 };
 
+#define MAX_NUM_CAM_BULK_ENTRIES	4096
+
+/* Bulk CAM programming */
+struct cam_bulk {
+	u64 entries;		/* user pointer to an array of struct cam_struct */
+	u32 num_entries;
+	u32 num_done;		/* entries programmed before an error */
+	u8 add;
+	u8 reserved[7];
+};
+
 /*Frame Filtering Type Field Option */
 struct ff_type {
 	u16 type1;
@@ -467,6 +479,7 @@ void get_member_reg(struct frer_memb_config *data);
 void program_member_reg(struct cb data);
 void get_frer_static_counter(struct frer_static_counter *data);
 int tsn_switch_cam_set(struct cam_struct data, u8 add);
+int tsn_switch_cam_get(struct cam_struct *data);
 u8 *tsn_switch_get_id(void);
 int tsn_switch_set_stp_state(struct port_status *port);
 int tsn_switch_vlan_add(struct port_vlan *port, int add);
@@ -475,5 +488,7 @@ int tsn_switch_pvid_add(struct native_vlan *port);
 #ifdef CONFIG_XILINX_TSN_SWITCH
 int xlnx_switchdev_init(void);
 void xlnx_switchdev_remove(void);
+void xlnx_switchdev_fdb_learnt(struct net_device *ndev, const u8 *addr,
+			       u16 vid, bool adding);
 #endif
 #endif /* XILINX_TSN_SWITCH_H */
@@ -72,6 +72,30 @@ static void xlnx_sw_fdb_offload_notify(struct axienet_local *lp,
 				 lp->ndev, &info.info, NULL);
 }
 
+/**
+ * xlnx_switchdev_fdb_learnt - Report a hardware learnt address to the bridge
+ * @ndev: Switch port the address was learnt on
+ * @addr: Learnt MAC address
+ * @vid: VLAN the address was learnt in
+ * @adding: true if the address was learnt, false if it aged out
+ *
+ * Must be called with rtnl held.
+ */
+void xlnx_switchdev_fdb_learnt(struct net_device *ndev, const u8 *addr,
+			       u16 vid, bool adding)
+{
+	struct switchdev_notifier_fdb_info info = {};
+
+	ASSERT_RTNL();
+
+	info.addr = addr;
+	info.vid = vid;
+	info.offloaded = true;
+	call_switchdev_notifiers(adding ? SWITCHDEV_FDB_ADD_TO_BRIDGE :
+				 SWITCHDEV_FDB_DEL_TO_BRIDGE,
+				 ndev, &info.info, NULL);
+}
+
 static int xlnx_sw_port_obj_vlan_add(struct axienet_local *lp,
 				     const struct switchdev_obj_port_vlan *vlan)
 {
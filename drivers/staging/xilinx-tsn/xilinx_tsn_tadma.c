@@ -21,6 +21,7 @@
 #include <linux/of_irq.h>
 #include <linux/list.h>
 #include <linux/hash.h>
+#include <linux/rculist.h>
 #include "xilinx_axienet_tsn.h"
 #include "xilinx_tsn_tadma.h"
 
@@ -44,6 +45,7 @@ struct tadma_stream_entry {
 	u8 macvlan[8];
 	u32 tticks;
 	struct hlist_node hash_link;
+	struct rcu_head rcu;
 	int sid;
 	int sfm;
 	int count;
@@ -80,12 +82,15 @@ static inline bool mac_vlan_equal(const u8 addr1[8],
 	return ret;
 }
 
-static struct tadma_stream_entry *tadma_hash_lookup_stream(struct hlist_head *head,
+/* Called under rcu_read_lock() or with the tadma_cb lock held */
+static struct tadma_stream_entry *tadma_hash_lookup_stream(struct tadma_cb *cb,
+							   u32 idx,
 							   const unsigned char *mac_vlan)
 {
 	struct tadma_stream_entry *entry;
 
-	hlist_for_each_entry(entry, head, hash_link) {
+	hlist_for_each_entry_rcu(entry, &cb->stream_hash[idx], hash_link,
+				 lockdep_is_held(&cb->lock)) {
 		if (mac_vlan_equal(entry->macvlan, mac_vlan))
 			return entry;
 	}
@@ -206,6 +211,7 @@ static int tadma_sfm_hash_init(struct net_device *ndev)
 
 	for (i = 0; i < lp->num_entries; i++)
 		INIT_HLIST_HEAD(&cb->stream_hash[i]);
+	mutex_init(&cb->lock);
 
 	lp->t_cb = cb;
 
@@ -423,10 +429,12 @@ static int tadma_get_strid(struct sk_buff *skb,
 	mac_vlan[7] = (vlan_tci & 0xff);
 
 	idx = tadma_macvlan_hash(mac_vlan);
-	entry = tadma_hash_lookup_stream(&cb->stream_hash[idx],
-					 mac_vlan);
+	/* The stream table is updated without blocking the transmit path */
+	rcu_read_lock();
+	entry = tadma_hash_lookup_stream(cb, idx, mac_vlan);
 	if (entry)
-		return entry->sid;
+		sid = entry->sid;
+	rcu_read_unlock();
 
 	return sid;
 }
@@ -600,6 +608,7 @@ int axienet_tadma_program(struct net_device *ndev, void __user *useraddr)
 	u32 cr, hash = 0;
 	int ret = 0;
 
+	mutex_lock(&cb->lock);
 	for (hash = 0; hash < lp->num_entries; hash++) {
 		bucket = &cb->stream_hash[hash];
 		hlist_for_each_entry_safe(entry, tmp, bucket, hash_link) {
@@ -607,6 +616,7 @@ int axienet_tadma_program(struct net_device *ndev, void __user *useraddr)
 					  entry->tticks, entry->count);
 		}
 	}
+	mutex_unlock(&cb->lock);
 	/* flip memory first so access other sfm bank
 	 * cr = tadma_ior(lp, XTADMA_CR_OFFSET);
 	 * cr |= XTADMA_FLIP_FETCH_MEM;
@@ -648,6 +658,7 @@ int axienet_tadma_flush_stream(struct net_device *ndev, void __user *useraddr)
 	/* set CFG_DONE to 0 */
 	tadma_iow(lp, XTADMA_CR_OFFSET, 0);
 
+	mutex_lock(&cb->lock);
 	for (hash = 0; hash < lp->num_entries; hash++) {
 		offset = sfm_entry_offset(lp, hash);
 		tadma_iow(lp, offset, 0);
@@ -655,10 +666,11 @@ int axienet_tadma_flush_stream(struct net_device *ndev, void __user *useraddr)
 
 		bucket = &cb->stream_hash[hash];
 		hlist_for_each_entry_safe(entry, tmp, bucket, hash_link) {
-			hlist_del(&entry->hash_link);
-			kfree(entry);
+			hlist_del_rcu(&entry->hash_link);
+			kfree_rcu(entry, rcu);
 		}
 	}
+	mutex_unlock(&cb->lock);
 
 	return 0;
 }
@@ -672,7 +684,7 @@ int axienet_tadma_add_stream(struct net_device *ndev, void __user *useraddr)
 	u32 idx, sid;
 	u16 vlan_tci;
 	u8 mac_vlan[8];
-	int st_pcp_val;
+	int st_pcp_val, ret = 0;
 
 	if (copy_from_user(&stream, useraddr, sizeof(struct tadma_stream)))
 		return -EFAULT;
@@ -680,6 +692,7 @@ int axienet_tadma_add_stream(struct net_device *ndev, void __user *useraddr)
 	if (stream.count > MAX_TRIG_COUNT)
 		return -EINVAL;
 
+	mutex_lock(&cb->lock);
 	if (stream.start) {
 		get_sid = 0;
 		get_sfm = 0;
@@ -698,10 +711,11 @@ int axienet_tadma_add_stream(struct net_device *ndev, void __user *useraddr)
 
 	idx = tadma_macvlan_hash(mac_vlan);
 
-	entry = tadma_hash_lookup_stream(&cb->stream_hash[idx], mac_vlan);
+	entry = tadma_hash_lookup_stream(cb, idx, mac_vlan);
 	if (entry && entry->count == stream.count &&
 	    entry->tticks == stream.trigger) {
-		return -EEXIST;	/*same entry*/
+		ret = -EEXIST;	/*same entry*/
+		goto out;
 	}
 
 	if (entry)
@@ -711,16 +725,20 @@ int axienet_tadma_add_stream(struct net_device *ndev, void __user *useraddr)
 
 	if (sid >= lp->num_streams) {
 		pr_err("More no. of streams %d\n", sid);
-		return -EINVAL;
+		ret = -EINVAL;
+		goto out;
 	}
 	if (get_sfm >= lp->num_entries) {
 		pr_err("\nMore no. of entries %d\n", get_sfm + 1);
-		return -EINVAL;
+		ret = -EINVAL;
+		goto out;
 	}
 
 	entry = kzalloc(sizeof(*entry), GFP_KERNEL);
-	if (!entry)
-		return -ENOMEM;
+	if (!entry) {
+		ret = -ENOMEM;
+		goto out;
+	}
 
 	entry->tticks = stream.trigger;
 	entry->count = stream.count;
@@ -729,7 +747,10 @@ int axienet_tadma_add_stream(struct net_device *ndev, void __user *useraddr)
 	entry->sfm = get_sfm++;
 
 	pr_debug("%s sid: %d\n", __func__, sid);
-	hlist_add_head(&entry->hash_link, &cb->stream_hash[idx]);
+	/* Publish the initialized entry to the transmit path */
+	hlist_add_head_rcu(&entry->hash_link, &cb->stream_hash[idx]);
+out:
+	mutex_unlock(&cb->lock);
 
-	return 0;
+	return ret;
 }
@@ -114,7 +114,8 @@ struct sfm_entry {
 };
 
 struct tadma_cb {
-	struct hlist_head *stream_hash;
+	struct hlist_head *stream_hash;	/* RCU protected */
+	struct mutex lock;	/* serializes stream_hash updates */
 	int streams;
 	u32 be_trigger;
 };
@@ -14,11 +14,15 @@
 #include <linux/dma-buf.h>
 #include <linux/interrupt.h>
 #include <linux/io.h>
+#include <linux/log2.h>
+#include <linux/mm.h>
 #include <linux/module.h>
+#include <linux/mutex.h>
 #include <linux/of.h>
 #include <linux/of_irq.h>
 #include <linux/platform_device.h>
 #include <linux/poll.h>
+#include <linux/vmalloc.h>
 #include <uapi/linux/xlnx_mpg2tsmux_interface.h>
 
 #define DRIVER_NAME "mpegtsmux-1.0"
@@ -56,6 +60,9 @@
 #define XTSMUX_STRMBL_FREE		0
 #define XTSMUX_STRMBL_BUSY		1
 
+/* Maximum number of submission ring entries */
+#define XTSMUX_RING_MAX_ENTRIES		4096
+
 /**
  * struct stream_context - struct to enqueue a stream context descriptor
  * @command: stream context type
@@ -244,6 +251,11 @@ struct xlnx_tsmux_dmabufintl {
  * @dst_dmabufintl: array of src DMA buf allocated by user
  * @outbuf_written: size in bytes written in output buffer
  * @stream_count: stream count
+ * @ring_lock: mutex to protect the submission ring
+ * @ring: submission ring shared with user space
+ * @ring_entries: first entry of the submission ring
+ * @ring_mask: mask to get an entry index from a ring index
+ * @ring_tail: driver copy of the submission ring tail
  */
 struct xlnx_tsmux {
 	struct device *dev;
@@ -280,6 +292,12 @@ struct xlnx_tsmux {
 	struct xlnx_tsmux_dmabufintl dst_dmabufintl[XTSMUX_MAXOUT_STRM];
 	s32 outbuf_written;
 	atomic_t stream_count;
+	/* ring_lock serializes the submission ring consumers */
+	struct mutex ring_lock;
+	struct mpg2mux_ring_hdr *ring;
+	struct mpg2mux_ring_entry *ring_entries;
+	u32 ring_mask;
+	u32 ring_tail;
 };
 
 static inline u32 xlnx_tsmux_read(const struct xlnx_tsmux *mpgmuxts,
@@ -685,6 +703,13 @@ static int xlnx_tsmux_enqueue_stream_context(struct xlnx_tsmux *mpgmuxts,
 	unsigned long flags;
 	u32 i;
 
+	if (!stream_data->is_dmabuf &&
+	    stream_data->srcbuf_id >= mpgmuxts->num_inbuf) {
+		dev_err(mpgmuxts->dev, "Invalid src buffer %d",
+			stream_data->srcbuf_id);
+		return -EINVAL;
+	}
+
 	kaddr_strm_node = dma_pool_alloc(mpgmuxts->strm_ctx_pool,
 					 GFP_KERNEL | GFP_DMA32,
 					 &strm_phy_addr);
@@ -730,6 +755,8 @@ static int xlnx_tsmux_enqueue_stream_context(struct xlnx_tsmux *mpgmuxts,
 		if (i == XTSMUX_MAXIN_STRM) {
 			dev_err(mpgmuxts->dev, "No DMA buffer with %d",
 				stream_data->srcbuf_id);
+			dma_pool_free(mpgmuxts->strm_ctx_pool, new_strm_node,
+				      strm_phy_addr);
 			return -ENOMEM;
 		}
 	}
@@ -1014,6 +1041,113 @@ static int xlnx_tsmux_ioctl_set_mux_context(struct xlnx_tsmux *mpgmuxts,
 	return ret;
 }
 
+static void xlnx_tsmux_ring_free(struct xlnx_tsmux *mpgmuxts)
+{
+	/* Pages stay mapped in user space until the ring is unmapped */
+	vfree(mpgmuxts->ring);
+	mpgmuxts->ring = NULL;
+	mpgmuxts->ring_entries = NULL;
+}
+
+static int xlnx_tsmux_ioctl_ring_alloc(struct xlnx_tsmux *mpgmuxts,
+				       void __user *arg)
+{
+	struct mpg2mux_ring_hdr *ring;
+	u32 num_entries, offset;
+	int ret;
+
+	ret = get_user(num_entries, (u32 __user *)arg);
+	if (ret)
+		return -EFAULT;
+
+	if (num_entries && (!is_power_of_2(num_entries) ||
+			    num_entries > XTSMUX_RING_MAX_ENTRIES)) {
+		dev_dbg(mpgmuxts->dev, "Invalid number of ring entries %u",
+			num_entries);
+		return -EINVAL;
+	}
+
+	mutex_lock(&mpgmuxts->ring_lock);
+	xlnx_tsmux_ring_free(mpgmuxts);
+	if (!num_entries)
+		goto unlock;
+
+	offset = ALIGN(sizeof(*ring), SMP_CACHE_BYTES);
+	ring = vmalloc_user(PAGE_ALIGN(offset + num_entries *
+				       sizeof(struct mpg2mux_ring_entry)));
+	if (!ring) {
+		ret = -ENOMEM;
+		goto unlock;
+	}
+
+	ring->num_entries = num_entries;
+	ring->entry_offset = offset;
+	mpgmuxts->ring = ring;
+	mpgmuxts->ring_entries = (void *)ring + offset;
+	mpgmuxts->ring_mask = num_entries - 1;
+	mpgmuxts->ring_tail = 0;
+unlock:
+	mutex_unlock(&mpgmuxts->ring_lock);
+
+	return ret;
+}
+
+static int xlnx_tsmux_ioctl_ring_kick(struct xlnx_tsmux *mpgmuxts)
+{
+	struct mpg2mux_ring_entry entry;
+	u32 head, tail, done = 0;
+	int ret = 0;
+
+	mutex_lock(&mpgmuxts->ring_lock);
+	if (!mpgmuxts->ring) {
+		ret = -ENXIO;
+		goto unlock;
+	}
+
+	head = READ_ONCE(mpgmuxts->ring->head);
+	tail = mpgmuxts->ring_tail;
+	if (head - tail > mpgmuxts->ring_mask + 1) {
+		dev_dbg(mpgmuxts->dev, "Invalid ring head %u, tail %u",
+			head, tail);
+		ret = -EINVAL;
+		goto unlock;
+	}
+	/* Read the entries only after reading the head */
+	smp_rmb();
+
+	while (tail != head) {
+		/* Work on a copy, user space may change the entry meanwhile */
+		memcpy(&entry, &mpgmuxts->ring_entries[tail &
+						       mpgmuxts->ring_mask],
+		       sizeof(entry));
+
+		if (entry.reserved)
+			ret = -EINVAL;
+		else if (entry.type == MPG2MUX_RING_STREAM)
+			ret = xlnx_tsmux_enqueue_stream_context(mpgmuxts,
+								&entry.stream);
+		else if (entry.type == MPG2MUX_RING_MUX)
+			ret = xlnx_tsmux_enqueue_mux_context(mpgmuxts,
+							     &entry.mux);
+		else
+			ret = -EINVAL;
+		if (ret < 0)
+			break;
+
+		tail++;
+		done++;
+	}
+
+	/* Let user space reuse the consumed entries */
+	mpgmuxts->ring_tail = tail;
+	smp_store_release(&mpgmuxts->ring->tail, tail);
+unlock:
+	mutex_unlock(&mpgmuxts->ring_lock);
+
+	/* A failing entry stays at tail and is reported by the next kick */
+	return done ? done : ret;
+}
+
 static int xlnx_tsmux_ioctl_verify_dmabuf(struct xlnx_tsmux *mpgmuxts,
 					  void __user *arg)
 {
@@ -1201,6 +1335,12 @@ static long xlnx_tsmux_ioctl(struct file *fptr,
 	case MPG2MUX_VDBUF:
 		ret = xlnx_tsmux_ioctl_verify_dmabuf(mpgmuxts, arg);
 		break;
+	case MPG2MUX_RINGALLOC:
+		ret = xlnx_tsmux_ioctl_ring_alloc(mpgmuxts, arg);
+		break;
+	case MPG2MUX_RINGKICK:
+		ret = xlnx_tsmux_ioctl_ring_kick(mpgmuxts);
+		break;
 	default:
 		return -EINVAL;
 	}
@@ -1220,6 +1360,18 @@ static int xlnx_tsmux_mmap(struct file *fp, struct vm_area_struct *vma)
 
 	buf_id = vma->vm_pgoff;
 
+	if (buf_id == MPG2MUX_RING_BUFID) {
+		mutex_lock(&mpgmuxts->ring_lock);
+		if (mpgmuxts->ring)
+			ret = remap_vmalloc_range(vma, mpgmuxts->ring, 0);
+		else
+			ret = -EINVAL;
+		mutex_unlock(&mpgmuxts->ring_lock);
+		if (ret)
+			dev_err(mpgmuxts->dev, "mmap fail for ring");
+		return ret;
+	}
+
 	if (buf_id < mpgmuxts->num_inbuf) {
 		if (!mpgmuxts->srcbuf_addrs[buf_id]) {
 			dev_err(mpgmuxts->dev, "Mem not allocated for src %d",
@@ -1407,6 +1559,7 @@ static int xlnx_tsmux_probe(struct platform_device *pdev)
 	}
 
 	/* Initializing variables used in Muxer */
+	mutex_init(&mpgmuxts->ring_lock);
 	spin_lock_irqsave(&mpgmuxts->lock, flags);
 	INIT_LIST_HEAD(&mpgmuxts->strm_node);
 	INIT_LIST_HEAD(&mpgmuxts->mux_node);
@@ -1494,6 +1647,7 @@ static int xlnx_tsmux_remove(struct platform_device *pdev)
 		return -EIO;
 	dma_pool_destroy(mpgmuxts->mux_ctx_pool);
 	dma_pool_destroy(mpgmuxts->strm_ctx_pool);
+	xlnx_tsmux_ring_free(mpgmuxts);
 
 	device_destroy(xlnx_tsmux_class, MKDEV(MAJOR(xlnx_tsmux_devt),
 					       mpgmuxts->id));
@@ -16,6 +16,9 @@
 #include <linux/delay.h>
 #include <linux/device.h>
 #include <linux/dma-buf.h>
+#include <linux/dma-fence.h>
+#include <linux/dma-resv.h>
+#include <linux/file.h>
 #include <linux/interrupt.h>
 #include <linux/io.h>
 #include <linux/ioctl.h>
@@ -24,6 +27,8 @@
 #include <linux/of_irq.h>
 #include <linux/platform_device.h>
 #include <linux/poll.h>
+#include <linux/slab.h>
+#include <linux/sync_file.h>
 #include <linux/uaccess.h>
 #include <linux/xlnxsync.h>
 
@@ -193,6 +198,9 @@ struct xlnxsync_device {
  * @cdiff_err: Chroma buffer diff > 1
  * @err_event: Error event per channel
  * @framedone_event: Framebuffer done event per channel
+ * @fence_ctx: First fence context, one context per framebuffer and io
+ * @fence_seqno: Last fence sequence number per framebuffer and io
+ * @fence: Pending framebuffer done fences, protected by the device irq_lock
  *
  * This structure contains the syncip channel specific parameters
  */
@@ -215,6 +223,19 @@ struct xlnxsync_channel {
 	u8 cdiff_err : 1;
 	u8 err_event : 1;
 	u8 framedone_event : 1;
+	u64 fence_ctx;
+	u64 fence_seqno[XLNXSYNC_BUF_PER_CHAN][XLNXSYNC_IO];
+	struct dma_fence *fence[XLNXSYNC_BUF_PER_CHAN][XLNXSYNC_IO];
+};
+
+/**
+ * struct xlnxsync_fbdone_fence - Framebuffer done fence
+ * @base: Base fence
+ * @lock: Fence lock, the fence can outlive the channel and the device
+ */
+struct xlnxsync_fbdone_fence {
+	struct dma_fence base;
+	spinlock_t lock;
 };
 
 static inline u32 xlnxsync_read(struct xlnxsync_device *dev, u32 chan, u32 reg)
@@ -277,6 +298,50 @@ static bool xlnxsync_is_buf_done(struct xlnxsync_device *dev,
 	return false;
 }
 
+static const char *xlnxsync_fence_get_driver_name(struct dma_fence *fence)
+{
+	return XLNXSYNC_DRIVER_NAME;
+}
+
+static const char *xlnxsync_fence_get_timeline_name(struct dma_fence *fence)
+{
+	return "fbdone";
+}
+
+static const struct dma_fence_ops xlnxsync_fence_ops = {
+	.get_driver_name = xlnxsync_fence_get_driver_name,
+	.get_timeline_name = xlnxsync_fence_get_timeline_name,
+};
+
+/* Must be called with the device irq_lock held */
+static void xlnxsync_fence_signal(struct xlnxsync_channel *channel, u32 buf,
+				  u32 io, int error)
+{
+	struct dma_fence *fence = channel->fence[buf][io];
+
+	if (!fence)
+		return;
+
+	if (error)
+		dma_fence_set_error(fence, error);
+	dma_fence_signal(fence);
+	dma_fence_put(fence);
+	channel->fence[buf][io] = NULL;
+}
+
+static void xlnxsync_fence_cancel(struct xlnxsync_channel *channel)
+{
+	struct xlnxsync_device *dev = channel->dev;
+	unsigned long flags;
+	u32 i, j;
+
+	spin_lock_irqsave(&dev->irq_lock, flags);
+	for (i = 0; i < XLNXSYNC_BUF_PER_CHAN; i++)
+		for (j = 0; j < XLNXSYNC_IO; j++)
+			xlnxsync_fence_signal(channel, i, j, -ECANCELED);
+	spin_unlock_irqrestore(&dev->irq_lock, flags);
+}
+
 static void xlnxsync_reset_chan(struct xlnxsync_device *dev, u32 chan)
 {
 	u8 num_retries = 50;
@@ -683,6 +748,8 @@ static int xlnxsync_chan_enable(struct xlnxsync_channel *channel, bool enable)
 				channel->c_done[i][j] = false;
 			}
 		}
+
+		xlnxsync_fence_cancel(channel);
 	}
 
 	return 0;
@@ -893,6 +960,128 @@ static int xlnxsync_chan_set_int_mask(struct xlnxsync_channel *channel,
 	return ret;
 }
 
+static int xlnxsync_attach_fence(struct xlnxsync_device *dev, int fd,
+				 struct dma_fence *fence, u32 io)
+{
+	struct dma_buf *dbuf;
+	int ret;
+
+	dbuf = dma_buf_get(fd);
+	if (IS_ERR(dbuf)) {
+		dev_err(dev->dev, "%s : Failed to get dma buf\n", __func__);
+		return PTR_ERR(dbuf);
+	}
+
+	ret = dma_resv_lock_interruptible(dbuf->resv, NULL);
+	if (ret)
+		goto put_dbuf;
+
+	ret = dma_resv_reserve_fences(dbuf->resv, 1);
+	if (!ret)
+		dma_resv_add_fence(dbuf->resv, fence, io == XLNXSYNC_PROD ?
+				   DMA_RESV_USAGE_WRITE : DMA_RESV_USAGE_READ);
+	dma_resv_unlock(dbuf->resv);
+
+put_dbuf:
+	dma_buf_put(dbuf);
+
+	return ret;
+}
+
+static int xlnxsync_chan_get_fence(struct xlnxsync_channel *channel,
+				   void __user *arg)
+{
+	struct xlnxsync_device *dev = channel->dev;
+	struct xlnxsync_fbdone_fence *fbdone_fence;
+	struct sync_file *sync_file;
+	struct xlnxsync_fence req;
+	struct dma_fence *fence;
+	unsigned long flags;
+	int ret, fd;
+
+	if (copy_from_user(&req, arg, sizeof(req))) {
+		dev_err(dev->dev, "%s : Failed to copy from user\n", __func__);
+		return -EFAULT;
+	}
+
+	if (req.hdr_ver != XLNXSYNC_IOCTL_HDR_VER) {
+		dev_err(dev->dev, "%s : ioctl version mismatch\n", __func__);
+		dev_err(dev->dev,
+			"ioctl ver = 0x%llx expected ver = 0x%llx\n",
+			req.hdr_ver, (u64)XLNXSYNC_IOCTL_HDR_VER);
+		return -EINVAL;
+	}
+
+	if (req.fb_id >= XLNXSYNC_BUF_PER_CHAN || req.io >= XLNXSYNC_IO ||
+	    req.reserved[0] || req.reserved[1]) {
+		dev_err(dev->dev, "Invalid FB id %d io %d for fence!\n",
+			req.fb_id, req.io);
+		return -EINVAL;
+	}
+
+	fbdone_fence = kzalloc(sizeof(*fbdone_fence), GFP_KERNEL);
+	if (!fbdone_fence)
+		return -ENOMEM;
+	spin_lock_init(&fbdone_fence->lock);
+
+	/* Share the pending fence of the framebuffer if there is one */
+	spin_lock_irqsave(&dev->irq_lock, flags);
+	fence = channel->fence[req.fb_id][req.io];
+	if (fence) {
+		dma_fence_get(fence);
+		kfree(fbdone_fence);
+	} else {
+		/* Wait for the next done, not for the one already reported */
+		channel->l_done[req.fb_id][req.io] = false;
+		channel->c_done[req.fb_id][req.io] = false;
+		fence = &fbdone_fence->base;
+		dma_fence_init(fence, &xlnxsync_fence_ops, &fbdone_fence->lock,
+			       channel->fence_ctx + req.fb_id * XLNXSYNC_IO +
+			       req.io, ++channel->fence_seqno[req.fb_id][req.io]);
+		channel->fence[req.fb_id][req.io] = dma_fence_get(fence);
+	}
+	spin_unlock_irqrestore(&dev->irq_lock, flags);
+
+	if (req.dma_fd >= 0) {
+		ret = xlnxsync_attach_fence(dev, req.dma_fd, fence, req.io);
+		if (ret)
+			goto put_fence;
+	}
+
+	fd = get_unused_fd_flags(O_CLOEXEC);
+	if (fd < 0) {
+		ret = fd;
+		goto put_fence;
+	}
+
+	sync_file = sync_file_create(fence);
+	if (!sync_file) {
+		ret = -ENOMEM;
+		goto put_fd;
+	}
+
+	req.fence_fd = fd;
+	if (copy_to_user(arg, &req, sizeof(req))) {
+		dev_err(dev->dev, "%s: failed to copy result data to user\n",
+			__func__);
+		fput(sync_file->file);
+		ret = -EFAULT;
+		goto put_fd;
+	}
+
+	fd_install(fd, sync_file->file);
+	dma_fence_put(fence);
+
+	return 0;
+
+put_fd:
+	put_unused_fd(fd);
+put_fence:
+	dma_fence_put(fence);
+
+	return ret;
+}
+
 static long xlnxsync_ioctl(struct file *fptr, unsigned int cmd,
 			   unsigned long data)
 {
@@ -970,6 +1159,12 @@ static long xlnxsync_ioctl(struct file *fptr, unsigned int cmd,
 		ret = xlnxsync_reset_slot(channel);
 		mutex_unlock(&channel->mutex);
 		break;
+	case XLNXSYNC_CHAN_GET_FENCE:
+		if (mutex_lock_interruptible(&channel->mutex))
+			return -ERESTARTSYS;
+		ret = xlnxsync_chan_get_fence(channel, arg);
+		mutex_unlock(&channel->mutex);
+		break;
 	}
 
 	return ret;
@@ -1057,6 +1252,8 @@ static int xlnxsync_open(struct inode *iptr, struct file *fptr)
 	mutex_init(&chan->mutex);
 	init_waitqueue_head(&chan->wq_fbdone);
 	init_waitqueue_head(&chan->wq_error);
+	chan->fence_ctx = dma_fence_context_alloc(XLNXSYNC_BUF_PER_CHAN *
+						  XLNXSYNC_IO);
 	dev->chan_count++;
 	atomic_inc(&dev->user_count);
 	dev_dbg(dev->dev, "%s: tid=%d Opened with user count = %d\n",
@@ -1096,6 +1293,7 @@ static int xlnxsync_release(struct inode *iptr, struct file *fptr)
 	dev->chan_count--;
 	list_del(&channel->channel);
 	mutex_unlock(&dev->sync_mutex);
+	xlnxsync_fence_cancel(channel);
 	devm_kfree(dev->dev, channel);
 
 	if (atomic_dec_and_test(&dev->user_count)) {
@@ -1192,8 +1390,10 @@ static irqreturn_t xlnxsync_irq_handler(int irq, void *data)
 		for (i = 0; i < XLNXSYNC_BUF_PER_CHAN; i++) {
 			for (j = 0; j < XLNXSYNC_IO; j++) {
 				if (chan->l_done[i][j] &&
-				    chan->c_done[i][j])
+				    chan->c_done[i][j]) {
 					chan->framedone_event = true;
+					xlnxsync_fence_signal(chan, i, j, 0);
+				}
 			}
 		}
 
@@ -1491,4 +1691,5 @@ module_exit(xlnxsync_cleanup_mod);
 MODULE_AUTHOR("Vishal Sagar");
 MODULE_DESCRIPTION("Xilinx Synchronizer IP Driver");
 MODULE_LICENSE("GPL v2");
+MODULE_IMPORT_NS(DMA_BUF);
 MODULE_VERSION(XLNXSYNC_DRIVER_VERSION);
@@ -21,6 +21,7 @@
 struct of_serial_info {
 	struct clk *clk;
 	struct reset_control *rst;
+	struct uart_8250_dma dma;
 	int type;
 	int line;
 };
@@ -182,6 +183,15 @@ static int of_platform_serial_setup(struct platform_device *ofdev,
 		port->has_sysrq = IS_ENABLED(CONFIG_SERIAL_8250_CONSOLE);
 	}
 
+	/*
+	 * Use the DMA channels of the node, the port falls back to PIO if
+	 * they can't be requested when it is opened.
+	 */
+	if (IS_ENABLED(CONFIG_SERIAL_8250_DMA) &&
+	    of_property_match_string(np, "dma-names", "rx") >= 0 &&
+	    of_property_match_string(np, "dma-names", "tx") >= 0)
+		up->dma = &info->dma;
+
 	return 0;
 err_unprepare:
 	clk_disable_unprepare(info->clk);
@@ -1548,6 +1548,7 @@ static void dwc3_get_properties(struct dwc3 *dwc)
 	u8			tx_thr_num_pkt_prd = 0;
 	u8			tx_max_burst_prd = 0;
 	u8			tx_fifo_resize_max_num;
+	u32			imod_interval_ns = 0;
 	const char		*usb_psy_name;
 	int			ret;
 
@@ -1672,6 +1673,8 @@ static void dwc3_get_properties(struct dwc3 *dwc)
 				 &dwc->fladj);
 	device_property_read_u32(dev, "snps,ref-clock-period-ns",
 				 &dwc->ref_clk_per);
+	device_property_read_u32(dev, "snps,imod-interval-ns",
+				 &imod_interval_ns);
 
 	dwc->enable_guctl1_ipd_quirk = device_property_read_bool(dev,
 				"snps,enable_guctl1_ipd_quirk");
@@ -1692,7 +1695,12 @@ static void dwc3_get_properties(struct dwc3 *dwc)
 	dwc->tx_thr_num_pkt_prd = tx_thr_num_pkt_prd;
 	dwc->tx_max_burst_prd = tx_max_burst_prd;
 
-	dwc->imod_interval = 0;
+	/*
+	 * Moderating the device event interrupt lets a burst of completions
+	 * be handled from one interrupt, the counter has a 250ns resolution.
+	 */
+	dwc->imod_interval = min_t(u32, DIV_ROUND_UP(imod_interval_ns, 250),
+				   U16_MAX);
 
 	dwc->tx_fifo_resize_max_num = tx_fifo_resize_max_num;
 }
@@ -703,7 +703,11 @@ struct dwc3_event_buffer {
 #define DWC3_EP_DIRECTION_TX	true
 #define DWC3_EP_DIRECTION_RX	false
 
+#ifdef CONFIG_USB_DWC3_TRB_NUM
+#define DWC3_TRB_NUM		CONFIG_USB_DWC3_TRB_NUM
+#else
 #define DWC3_TRB_NUM		256
+#endif
 
 /**
  * struct dwc3_ep - device side endpoint representation
@@ -773,8 +777,8 @@ struct dwc3_ep {
 	 * By using u8 types we ensure that our % operator when incrementing
 	 * enqueue and dequeue get optimized away by the compiler.
 	 */
-	u8			trb_enqueue;
-	u8			trb_dequeue;
+	u16			trb_enqueue;
+	u16			trb_dequeue;
 
 	u8			number;
 	u8			type;
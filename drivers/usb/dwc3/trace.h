@@ -299,8 +299,8 @@ DECLARE_EVENT_CLASS(dwc3_log_ep,
 		__field(unsigned int, maxburst)
 		__field(unsigned int, flags)
 		__field(unsigned int, direction)
-		__field(u8, trb_enqueue)
-		__field(u8, trb_dequeue)
+		__field(u16, trb_enqueue)
+		__field(u16, trb_dequeue)
 	),
 	TP_fast_assign(
 		__assign_str(name, dep->name);
@@ -11,6 +11,7 @@
 #include <linux/iommu.h>
 #include <linux/module.h>
 #include <linux/mutex.h>
+#include <linux/of_address.h>
 #include <linux/pm_runtime.h>
 #include <linux/slab.h>
 #include <linux/types.h>
@@ -134,14 +135,57 @@ static void vfio_platform_put_reset(struct vfio_platform_device *vdev)
 		module_put(vdev->reset_module);
 }
 
+static int vfio_platform_mem_count(struct vfio_platform_device *vdev)
+{
+	int cnt;
+
+	cnt = of_count_phandle_with_args(vdev->device->of_node,
+					 "memory-region", NULL);
+
+	return cnt > 0 ? cnt : 0;
+}
+
+/*
+ * Reserved memory the device works on, e.g. buffers shared with a PL
+ * accelerator, follows the device's own resources. It is exposed as
+ * plain memory so user space drivers can poll it through a mapping.
+ */
+static int vfio_platform_mem_init(struct vfio_platform_device *vdev,
+				  struct vfio_platform_region *reg, int i)
+{
+	struct device_node *np;
+	struct resource res;
+	int ret;
+
+	np = of_parse_phandle(vdev->device->of_node, "memory-region", i);
+	if (!np)
+		return -EINVAL;
+
+	ret = of_address_to_resource(np, 0, &res);
+	of_node_put(np);
+	if (ret)
+		return ret;
+
+	reg->addr = res.start;
+	reg->size = resource_size(&res);
+	reg->type = VFIO_PLATFORM_REGION_TYPE_MEM;
+	reg->flags = VFIO_REGION_INFO_FLAG_READ | VFIO_REGION_INFO_FLAG_WRITE;
+	if (!(reg->addr & ~PAGE_MASK) && !(reg->size & ~PAGE_MASK))
+		reg->flags |= VFIO_REGION_INFO_FLAG_MMAP;
+
+	return 0;
+}
+
 static int vfio_platform_regions_init(struct vfio_platform_device *vdev)
 {
-	int cnt = 0, i;
+	int cnt = 0, nmem, i;
 
 	while (vdev->get_resource(vdev, cnt))
 		cnt++;
 
-	vdev->regions = kcalloc(cnt, sizeof(struct vfio_platform_region),
+	nmem = vfio_platform_mem_count(vdev);
+
+	vdev->regions = kcalloc(cnt + nmem, sizeof(struct vfio_platform_region),
 				GFP_KERNEL);
 	if (!vdev->regions)
 		return -ENOMEM;
@@ -183,7 +227,11 @@ static int vfio_platform_regions_init(struct vfio_platform_device *vdev)
 		}
 	}
 
-	vdev->num_regions = cnt;
+	for (i = 0; i < nmem; i++)
+		if (vfio_platform_mem_init(vdev, &vdev->regions[cnt + i], i))
+			goto err;
+
+	vdev->num_regions = cnt + nmem;
 
 	return 0;
 err:
@@ -195,8 +243,11 @@ static void vfio_platform_regions_cleanup(struct vfio_platform_device *vdev)
 {
 	int i;
 
-	for (i = 0; i < vdev->num_regions; i++)
+	for (i = 0; i < vdev->num_regions; i++) {
 		iounmap(vdev->regions[i].ioaddr);
+		if (vdev->regions[i].kaddr)
+			memunmap(vdev->regions[i].kaddr);
+	}
 
 	vdev->num_regions = 0;
 	kfree(vdev->regions);
@@ -440,6 +491,40 @@ static ssize_t vfio_platform_read_mmio(struct vfio_platform_region *reg,
 	return -EFAULT;
 }
 
+static bool vfio_platform_mem_coherent(struct vfio_platform_device *vdev)
+{
+	return of_dma_is_coherent(vdev->device->of_node);
+}
+
+static ssize_t vfio_platform_rw_mem(struct vfio_platform_device *vdev,
+				    struct vfio_platform_region *reg,
+				    char __user *buf, size_t count,
+				    loff_t off, bool iswrite)
+{
+	if (off >= reg->size)
+		return -EINVAL;
+
+	count = min_t(size_t, count, reg->size - off);
+
+	if (!reg->kaddr) {
+		reg->kaddr = memremap(reg->addr, reg->size,
+				      vfio_platform_mem_coherent(vdev) ?
+				      MEMREMAP_WB : MEMREMAP_WC);
+		if (!reg->kaddr)
+			return -ENOMEM;
+	}
+
+	if (iswrite) {
+		if (copy_from_user(reg->kaddr + off, buf, count))
+			return -EFAULT;
+	} else {
+		if (copy_to_user(buf, reg->kaddr + off, count))
+			return -EFAULT;
+	}
+
+	return count;
+}
+
 ssize_t vfio_platform_read(struct vfio_device *core_vdev,
 			   char __user *buf, size_t count, loff_t *ppos)
 {
@@ -457,6 +542,9 @@ ssize_t vfio_platform_read(struct vfio_device *core_vdev,
 	if (vdev->regions[index].type & VFIO_PLATFORM_REGION_TYPE_MMIO)
 		return vfio_platform_read_mmio(&vdev->regions[index],
 							buf, count, off);
+	else if (vdev->regions[index].type & VFIO_PLATFORM_REGION_TYPE_MEM)
+		return vfio_platform_rw_mem(vdev, &vdev->regions[index],
+					    buf, count, off, false);
 	else if (vdev->regions[index].type & VFIO_PLATFORM_REGION_TYPE_PIO)
 		return -EINVAL; /* not implemented */
 
@@ -535,6 +623,10 @@ ssize_t vfio_platform_write(struct vfio_device *core_vdev, const char __user *bu
 	if (vdev->regions[index].type & VFIO_PLATFORM_REGION_TYPE_MMIO)
 		return vfio_platform_write_mmio(&vdev->regions[index],
 							buf, count, off);
+	else if (vdev->regions[index].type & VFIO_PLATFORM_REGION_TYPE_MEM)
+		return vfio_platform_rw_mem(vdev, &vdev->regions[index],
+					    (char __user *)buf, count, off,
+					    true);
 	else if (vdev->regions[index].type & VFIO_PLATFORM_REGION_TYPE_PIO)
 		return -EINVAL; /* not implemented */
 
@@ -562,6 +654,29 @@ static int vfio_platform_mmap_mmio(struct vfio_platform_region region,
 			       req_len, vma->vm_page_prot);
 }
 
+static int vfio_platform_mmap_mem(struct vfio_platform_device *vdev,
+				  struct vfio_platform_region region,
+				  struct vm_area_struct *vma)
+{
+	u64 req_len, pgoff, req_start;
+
+	req_len = vma->vm_end - vma->vm_start;
+	pgoff = vma->vm_pgoff &
+		((1U << (VFIO_PLATFORM_OFFSET_SHIFT - PAGE_SHIFT)) - 1);
+	req_start = pgoff << PAGE_SHIFT;
+
+	if (region.size < PAGE_SIZE || req_start + req_len > region.size)
+		return -EINVAL;
+
+	/* Match what the device sees when it doesn't snoop the caches. */
+	if (!vfio_platform_mem_coherent(vdev))
+		vma->vm_page_prot = pgprot_writecombine(vma->vm_page_prot);
+	vma->vm_pgoff = (region.addr >> PAGE_SHIFT) + pgoff;
+
+	return remap_pfn_range(vma, vma->vm_start, vma->vm_pgoff,
+			       req_len, vma->vm_page_prot);
+}
+
 int vfio_platform_mmap(struct vfio_device *core_vdev, struct vm_area_struct *vma)
 {
 	struct vfio_platform_device *vdev =
@@ -597,6 +712,9 @@ int vfio_platform_mmap(struct vfio_device *core_vdev, struct vm_area_struct *vma
 	if (vdev->regions[index].type & VFIO_PLATFORM_REGION_TYPE_MMIO)
 		return vfio_platform_mmap_mmio(vdev->regions[index], vma);
 
+	else if (vdev->regions[index].type & VFIO_PLATFORM_REGION_TYPE_MEM)
+		return vfio_platform_mmap_mem(vdev, vdev->regions[index], vma);
+
 	else if (vdev->regions[index].type & VFIO_PLATFORM_REGION_TYPE_PIO)
 		return -EINVAL; /* not implemented */
 
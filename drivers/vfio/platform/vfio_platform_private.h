@@ -39,7 +39,9 @@ struct vfio_platform_region {
 	u32			type;
 #define VFIO_PLATFORM_REGION_TYPE_MMIO	1
 #define VFIO_PLATFORM_REGION_TYPE_PIO	2
+#define VFIO_PLATFORM_REGION_TYPE_MEM	4
 	void __iomem		*ioaddr;
+	void			*kaddr;
 };
 
 struct vfio_platform_device {
@@ -40,6 +40,11 @@ module_param(experimental_zcopytx, int, 0444);
 MODULE_PARM_DESC(experimental_zcopytx, "Enable Zero Copy TX;"
 		                       " 1 -Enable; 0 - Disable");
 
+static bool per_vq_workers;
+module_param(per_vq_workers, bool, 0644);
+MODULE_PARM_DESC(per_vq_workers, "Serve RX and TX rings from separate "
+		 "vhost-<pid>-<vq> threads, for devices opened afterwards");
+
 /* Max number of bytes transferred before requeueing the job.
  * Using this limit prevents one virtqueue from starving others. */
 #define VHOST_NET_WEIGHT 0x80000
@@ -545,7 +550,7 @@ static void vhost_net_busy_poll(struct vhost_net *net,
 	endtime = busy_clock() + busyloop_timeout;
 
 	while (vhost_can_busy_poll(endtime)) {
-		if (vhost_has_work(&net->dev)) {
+		if (vhost_vq_has_work(poll_rx ? rvq : tvq)) {
 			*busyloop_intr = true;
 			break;
 		}
@@ -1341,8 +1346,13 @@ static int vhost_net_open(struct inode *inode, struct file *f)
 		       VHOST_NET_PKT_WEIGHT, VHOST_NET_WEIGHT, true,
 		       NULL);
 
+	dev->vq_workers = per_vq_workers;
+
 	vhost_poll_init(n->poll + VHOST_NET_VQ_TX, handle_tx_net, EPOLLOUT, dev);
 	vhost_poll_init(n->poll + VHOST_NET_VQ_RX, handle_rx_net, EPOLLIN, dev);
+	/* socket readiness runs on the worker of the matching ring */
+	n->poll[VHOST_NET_VQ_TX].vq = &n->vqs[VHOST_NET_VQ_TX].vq;
+	n->poll[VHOST_NET_VQ_RX].vq = &n->vqs[VHOST_NET_VQ_RX].vq;
 
 	f->private_data = n;
 	n->page_frag.page = NULL;
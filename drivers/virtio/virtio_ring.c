@@ -70,6 +70,7 @@
 struct vring_desc_state_split {
 	void *data;			/* Data for callback. */
 	struct vring_desc *indir_desc;	/* Indirect descriptor, if any. */
+	u32 total_in_len;		/* Device-writable length. */
 };
 
 struct vring_desc_state_packed {
@@ -99,6 +100,13 @@ struct vring_virtqueue_split {
 	 */
 	u16 avail_idx_shadow;
 
+	/*
+	 * With VIRTIO_F_IN_ORDER, the used entry of the batch being
+	 * returned to the driver, batch_last_id is UINT_MAX if none.
+	 */
+	u32 batch_last_id;
+	u32 batch_last_len;
+
 	/* Per-descriptor state. */
 	struct vring_desc_state_split *desc_state;
 	struct vring_desc_extra *desc_extra;
@@ -172,6 +180,9 @@ struct vring_virtqueue {
 	/* Host publishes avail event idx */
 	bool event;
 
+	/* Host uses buffers in the order they were made available */
+	bool in_order;
+
 	/* Head of free buffer list. */
 	unsigned int free_head;
 	/* Number we've added since last sync. */
@@ -527,6 +538,7 @@ static inline int virtqueue_add_split(struct virtqueue *_vq,
 	struct scatterlist *sg;
 	struct vring_desc *desc;
 	unsigned int i, n, avail, descs_used, prev, err_idx;
+	u32 in_len = 0;
 	int head;
 	bool indirect;
 
@@ -602,6 +614,7 @@ static inline int virtqueue_add_split(struct virtqueue *_vq,
 				goto unmap_release;
 
 			prev = i;
+			in_len += sg->length;
 			/* Note that we trust indirect descriptor
 			 * table since it use stream DMA mapping.
 			 */
@@ -644,6 +657,7 @@ static inline int virtqueue_add_split(struct virtqueue *_vq,
 
 	/* Store token and indirect buffer state. */
 	vq->split.desc_state[head].data = data;
+	vq->split.desc_state[head].total_in_len = in_len;
 	if (indirect)
 		vq->split.desc_state[head].indir_desc = desc;
 	else
@@ -747,8 +761,14 @@ static void detach_buf_split(struct vring_virtqueue *vq, unsigned int head,
 	}
 
 	vring_unmap_one_split(vq, i);
-	vq->split.desc_extra[i].next = vq->free_head;
-	vq->free_head = head;
+	/*
+	 * In order buffers are freed in the order they were added, so the
+	 * free list stays in ring order as long as the chain isn't moved.
+	 */
+	if (!vq->in_order) {
+		vq->split.desc_extra[i].next = vq->free_head;
+		vq->free_head = head;
+	}
 
 	/* Plus final descriptor */
 	vq->vq.num_free++;
@@ -790,7 +810,7 @@ static void *virtqueue_get_buf_ctx_split(struct virtqueue *_vq,
 {
 	struct vring_virtqueue *vq = to_vvq(_vq);
 	void *ret;
-	unsigned int i;
+	unsigned int i, id;
 	u16 last_used;
 
 	START_USE(vq);
@@ -810,15 +830,41 @@ static void *virtqueue_get_buf_ctx_split(struct virtqueue *_vq,
 	virtio_rmb(vq->weak_barriers);
 
 	last_used = (vq->last_used_idx & (vq->split.vring.num - 1));
-	i = virtio32_to_cpu(_vq->vdev,
-			vq->split.vring.used->ring[last_used].id);
-	*len = virtio32_to_cpu(_vq->vdev,
-			vq->split.vring.used->ring[last_used].len);
+	if (vq->in_order && vq->split.batch_last_id != UINT_MAX) {
+		i = vq->split.batch_last_id;
+		*len = vq->split.batch_last_len;
+	} else {
+		i = virtio32_to_cpu(_vq->vdev,
+				vq->split.vring.used->ring[last_used].id);
+		*len = virtio32_to_cpu(_vq->vdev,
+				vq->split.vring.used->ring[last_used].len);
+	}
 
 	if (unlikely(i >= vq->split.vring.num)) {
 		BAD_RING(vq, "id %u out of range\n", i);
 		return NULL;
 	}
+
+	if (vq->in_order) {
+		/*
+		 * The device may write a single used entry for a batch of
+		 * buffers, naming the last of them, and move the used index
+		 * past the whole batch. Buffers are used in the order they
+		 * were made available, so the oldest one is in the avail
+		 * ring at the used index. Keep the entry until its own
+		 * buffer is returned, the slots after it aren't written.
+		 */
+		id = i;
+		i = virtio16_to_cpu(_vq->vdev,
+				    vq->split.vring.avail->ring[last_used]);
+		if (i != id) {
+			vq->split.batch_last_id = id;
+			vq->split.batch_last_len = *len;
+			*len = vq->split.desc_state[i].total_in_len;
+		} else {
+			vq->split.batch_last_id = UINT_MAX;
+		}
+	}
 	if (unlikely(!vq->split.desc_state[i].data)) {
 		BAD_RING(vq, "id %u is not a head!\n", i);
 		return NULL;
@@ -963,6 +1009,7 @@ static void virtqueue_vring_init_split(struct vring_virtqueue_split *vring_split
 
 	vring_split->avail_flags_shadow = 0;
 	vring_split->avail_idx_shadow = 0;
+	vring_split->batch_last_id = UINT_MAX;
 
 	/* No callback?  Tell other side not to bother us. */
 	if (!vq->vq.callback) {
@@ -993,6 +1040,10 @@ static void virtqueue_reinit_split(struct vring_virtqueue *vq)
 
 	virtqueue_init(vq, num);
 
+	/* In order descriptors start over at the beginning of the table */
+	if (vq->in_order)
+		vq->free_head = 0;
+
 	virtqueue_vring_init_split(&vq->split, vq);
 }
 
@@ -2019,6 +2070,7 @@ static struct virtqueue *vring_create_virtqueue_packed(
 	vq->indirect = virtio_has_feature(vdev, VIRTIO_RING_F_INDIRECT_DESC) &&
 		!context;
 	vq->event = virtio_has_feature(vdev, VIRTIO_RING_F_EVENT_IDX);
+	vq->in_order = false;
 
 	if (virtio_has_feature(vdev, VIRTIO_F_ORDER_PLATFORM))
 		vq->weak_barriers = false;
@@ -2512,6 +2564,7 @@ static struct virtqueue *__vring_new_virtqueue(unsigned int index,
 	vq->indirect = virtio_has_feature(vdev, VIRTIO_RING_F_INDIRECT_DESC) &&
 		!context;
 	vq->event = virtio_has_feature(vdev, VIRTIO_RING_F_EVENT_IDX);
+	vq->in_order = virtio_has_feature(vdev, VIRTIO_F_IN_ORDER);
 
 	if (virtio_has_feature(vdev, VIRTIO_F_ORDER_PLATFORM))
 		vq->weak_barriers = false;
@@ -2718,6 +2771,11 @@ void vring_transport_features(struct virtio_device *vdev)
 			break;
 		case VIRTIO_F_ORDER_PLATFORM:
 			break;
+		case VIRTIO_F_IN_ORDER:
+			/* Only split rings handle in-order batches. */
+			if (virtio_has_feature(vdev, VIRTIO_F_RING_PACKED))
+				__virtio_clear_bit(vdev, i);
+			break;
 		default:
 			/* We don't understand this bit. */
 			__virtio_clear_bit(vdev, i);
@@ -246,6 +246,40 @@ struct dma_buf_ops {
 	 */
 	int (*end_cpu_access)(struct dma_buf *, enum dma_data_direction);
 
+	/**
+	 * @begin_cpu_access_partial:
+	 *
+	 * This is called from dma_buf_begin_cpu_access_partial() and works
+	 * like @begin_cpu_access, except that only the given range of the
+	 * buffer needs to be made coherent for cpu access. The range has been
+	 * checked against the buffer size.
+	 *
+	 * This callback is optional, @begin_cpu_access is used without it.
+	 *
+	 * Returns:
+	 *
+	 * 0 on success or a negative error code on failure.
+	 */
+	int (*begin_cpu_access_partial)(struct dma_buf *,
+					enum dma_data_direction,
+					size_t offset, size_t len);
+
+	/**
+	 * @end_cpu_access_partial:
+	 *
+	 * This is called from dma_buf_end_cpu_access_partial() and works like
+	 * @end_cpu_access for the given range of the buffer.
+	 *
+	 * This callback is optional, @end_cpu_access is used without it.
+	 *
+	 * Returns:
+	 *
+	 * 0 on success or a negative error code on failure.
+	 */
+	int (*end_cpu_access_partial)(struct dma_buf *,
+				      enum dma_data_direction,
+				      size_t offset, size_t len);
+
 	/**
 	 * @mmap:
 	 *
@@ -627,6 +661,12 @@ int dma_buf_begin_cpu_access(struct dma_buf *dma_buf,
 			     enum dma_data_direction dir);
 int dma_buf_end_cpu_access(struct dma_buf *dma_buf,
 			   enum dma_data_direction dir);
+int dma_buf_begin_cpu_access_partial(struct dma_buf *dma_buf,
+				     enum dma_data_direction dir,
+				     size_t offset, size_t len);
+int dma_buf_end_cpu_access_partial(struct dma_buf *dma_buf,
+				   enum dma_data_direction dir,
+				   size_t offset, size_t len);
 
 int dma_buf_mmap(struct dma_buf *, struct vm_area_struct *,
 		 unsigned long);
@@ -10,9 +10,12 @@
 #define _DMA_HEAPS_H
 
 #include <linux/cdev.h>
+#include <linux/dma-direction.h>
 #include <linux/types.h>
 
 struct dma_heap;
+struct device;
+struct sg_table;
 
 /**
  * struct dma_heap_ops - ops to operate on a given heap
@@ -65,4 +68,17 @@ const char *dma_heap_get_name(struct dma_heap *heap);
  */
 struct dma_heap *dma_heap_add(const struct dma_heap_export_info *exp_info);
 
+/**
+ * dma_heap_sync_sgtable_range - sync part of a DMA mapped buffer
+ * @dev:	device the table is mapped for
+ * @sgt:	DMA mapped table of the whole buffer
+ * @offset:	offset of the range in the buffer
+ * @len:	length of the range
+ * @dir:	DMA direction
+ * @for_cpu:	true to sync for the CPU, false to sync for the device
+ */
+void dma_heap_sync_sgtable_range(struct device *dev, struct sg_table *sgt,
+				 size_t offset, size_t len,
+				 enum dma_data_direction dir, bool for_cpu);
+
 #endif /* _DMA_HEAPS_H */
@@ -10,6 +10,11 @@
 
 #include <linux/dma-mapping.h>
 #include <linux/dmaengine.h>
+#include <linux/err.h>
+
+struct dma_buf_attachment;
+struct dma_fence;
+struct sg_table;
 
 /**
  * struct xilinx_vdma_config - VDMA Configuration structure
@@ -24,6 +29,8 @@
  * @reset: Reset Channel
  * @ext_fsync: External Frame Sync source
  * @vflip_en:  Vertical Flip enable
+ * @drop_oldest: S2MM overwrites its oldest frame instead of stalling when
+ *		 no buffer is pending, see xilinx_vdma_channel_get_dropped()
  */
 struct xilinx_vdma_config {
 	int frm_dly;
@@ -37,9 +44,33 @@ struct xilinx_vdma_config {
 	int reset;
 	int ext_fsync;
 	bool vflip_en;
+	bool drop_oldest;
 };
 
 int xilinx_vdma_channel_set_config(struct dma_chan *dchan,
 					struct xilinx_vdma_config *cfg);
+int xilinx_vdma_channel_get_dropped(struct dma_chan *dchan, u64 *dropped);
+int xilinx_dma_channel_set_polled(struct dma_chan *dchan, bool polled);
+int xilinx_dma_cyclic_get_period(struct dma_chan *dchan, unsigned int *period);
+
+#if IS_REACHABLE(CONFIG_DMA_SHARED_BUFFER)
+struct dma_fence *xilinx_dma_submit_dmabuf(struct dma_chan *dchan,
+					   struct dma_buf_attachment *attach,
+					   struct sg_table *sgt,
+					   enum dma_transfer_direction direction,
+					   dma_async_tx_callback_result callback,
+					   void *callback_param);
+#else
+static inline struct dma_fence *
+xilinx_dma_submit_dmabuf(struct dma_chan *dchan,
+			 struct dma_buf_attachment *attach,
+			 struct sg_table *sgt,
+			 enum dma_transfer_direction direction,
+			 dma_async_tx_callback_result callback,
+			 void *callback_param)
+{
+	return ERR_PTR(-EOPNOTSUPP);
+}
+#endif
 
 #endif
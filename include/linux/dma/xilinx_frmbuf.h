@@ -39,6 +39,21 @@ enum operation_mode {
 	AUTO_RESTART = BIT(7),
 };
 
+/**
+ * struct xilinx_frmbuf_metadata - Completion metadata of a frame
+ * @timestamp: CLOCK_MONOTONIC time of the frame done interrupt, in ns
+ * @sequence: Frame done count of the channel, gaps mean dropped frames
+ * @fid: Field ID of the frame
+ *
+ * Available through dmaengine_desc_get_metadata_ptr() from the descriptor
+ * callback, the channel supports DESC_METADATA_ENGINE mode.
+ */
+struct xilinx_frmbuf_metadata {
+	u64 timestamp;
+	u32 sequence;
+	u32 fid;
+};
+
 /**
  * enum fid_modes - FB IP fid mode register settings to select mode
  * @FID_MODE_0: carries the fid value shared by application
@@ -197,6 +212,18 @@ int xilinx_xdma_set_earlycb(struct dma_chan *chan,
  */
 int xilinx_xdma_get_width_align(struct dma_chan *chan, u32 *width_align);
 
+/**
+ * xilinx_xdma_get_dropped_frames - Get the number of dropped frames
+ *
+ * @chan: dma channel instance
+ * @dropped: Output param - Frames the IP restarted into an already active
+ *	     buffer because no new buffer had been queued in time
+ *
+ * Return: 0 on success, -ENODEV in case no framebuffer device found
+ */
+int xilinx_xdma_get_dropped_frames(struct dma_chan *chan,
+				   unsigned long *dropped);
+
 #else
 static inline void xilinx_xdma_set_mode(struct dma_chan *chan,
 					enum operation_mode mode)
@@ -253,6 +280,12 @@ static inline int xilinx_xdma_get_width_align(struct dma_chan *chan, u32 *width_
 {
 	return -ENODEV;
 }
+
+static inline int xilinx_xdma_get_dropped_frames(struct dma_chan *chan,
+						 unsigned long *dropped)
+{
+	return -ENODEV;
+}
 #endif
 
 #endif /*__XILINX_FRMBUF_DMA_H*/
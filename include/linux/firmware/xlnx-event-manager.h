@@ -18,6 +18,8 @@ int xlnx_register_event(const enum pm_api_cb_id cb_type, const u32 node_id,
 
 int xlnx_unregister_event(const enum pm_api_cb_id cb_type, const u32 node_id,
 			  const u32 event, event_cb_func_t cb_fun, void *data);
+
+int xlnx_event_get_count(const u32 node_id, const u32 event, u64 *count);
 #else
 static inline int xlnx_register_event(const enum pm_api_cb_id cb_type, const u32 node_id,
 				      const u32 event, const bool wake,
@@ -31,6 +33,11 @@ static inline int xlnx_unregister_event(const enum pm_api_cb_id cb_type, const u
 {
 	return -ENODEV;
 }
+
+static inline int xlnx_event_get_count(const u32 node_id, const u32 event, u64 *count)
+{
+	return -ENODEV;
+}
 #endif
 
 #endif /* _FIRMWARE_XLNX_EVENT_MANAGER_H_ */
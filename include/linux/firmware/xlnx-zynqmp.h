@@ -667,8 +667,22 @@ struct xlnx_feature {
 	void *data;
 };
 
+/**
+ * struct zynqmp_pm_call - PM API call of a batch
+ * @pm_api_id:		Requested PM-API call
+ * @args:		Arguments of the PM-API call
+ * @ret_payload:	Returned value array, can be NULL
+ */
+struct zynqmp_pm_call {
+	u32 pm_api_id;
+	u32 args[5];
+	u32 *ret_payload;
+};
+
 int zynqmp_pm_invoke_fn(u32 pm_api_id, u32 arg0, u32 arg1,
 			u32 arg2, u32 arg3, u32 arg4, u32 *ret_payload);
+int zynqmp_pm_invoke_batch(const struct zynqmp_pm_call *calls,
+			   unsigned int num_calls);
 
 #if IS_REACHABLE(CONFIG_ZYNQMP_FIRMWARE)
 int zynqmp_pm_get_api_version(u32 *version);
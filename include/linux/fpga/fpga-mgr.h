@@ -14,6 +14,7 @@
 
 #define ENCRYPTED_KEY_LEN	64 /* Bytes */
 
+struct firmware;
 struct fpga_manager;
 struct sg_table;
 
@@ -111,6 +112,7 @@ enum fpga_mgr_states {
  * @region_id: id of target region
  * @dev: device that owns this
  * @overlay: Device Tree overlay
+ * @fw: image of @firmware_name read ahead by fpga_mgr_preload()
  */
 struct fpga_image_info {
 	u32 flags;
@@ -129,6 +131,7 @@ struct fpga_image_info {
 #ifdef CONFIG_OF
 	struct device_node *overlay;
 #endif
+	const struct firmware *fw;
 };
 
 /**
@@ -178,6 +181,9 @@ struct fpga_manager_info {
  * @write_sg: write the scatter list of configuration data to the FPGA
  * @write_complete: set FPGA to operating state after writing is done
  * @read: optional: read FPGA configuration information
+ * @read_size: optional: size of the output of @read, so that the debugfs
+ *	       buffer is allocated once instead of retrying @read with a
+ *	       growing buffer
  * @fpga_remove: optional: Set FPGA into a specific state during driver remove
  * @groups: optional attribute groups.
  *
@@ -201,6 +207,7 @@ struct fpga_manager_ops {
 	int (*write_complete)(struct fpga_manager *mgr,
 			      struct fpga_image_info *info);
 	int (*read)(struct fpga_manager *mgr, struct seq_file *s);
+	size_t (*read_size)(struct fpga_manager *mgr);
 	void (*fpga_remove)(struct fpga_manager *mgr);
 	const struct attribute_group **groups;
 };
@@ -259,6 +266,9 @@ struct fpga_image_info *fpga_image_info_alloc(struct device *dev);
 void fpga_image_info_free(struct fpga_image_info *info);
 
 int fpga_mgr_load(struct fpga_manager *mgr, struct fpga_image_info *info);
+int fpga_mgr_preload(struct fpga_manager *mgr, struct fpga_image_info *info);
+
+int fpga_mgr_buf_to_sgt(const char *buf, size_t count, struct sg_table *sgt);
 
 int fpga_mgr_lock(struct fpga_manager *mgr);
 void fpga_mgr_unlock(struct fpga_manager *mgr);
@@ -0,0 +1,64 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+
+#ifndef _FPGA_REGION_PERF_H
+#define _FPGA_REGION_PERF_H
+
+#include <linux/device.h>
+#include <linux/types.h>
+
+struct fpga_region_perf;
+struct module;
+
+/**
+ * struct fpga_region_perf_counter - a free running counter of a region
+ * @name: perf event name, a valid sysfs file name
+ * @width: counter width in bits, narrower counters are polled for wraps
+ */
+struct fpga_region_perf_counter {
+	const char *name;
+	u32 width;
+};
+
+/**
+ * struct fpga_region_perf_ops - ops for region counter providers
+ * @read_counter: return the current value of counter @idx. Called with
+ *		  interrupts disabled, must not sleep.
+ * @event_init: optional, prepare counter @idx for a new event
+ * @event_destroy: optional, release what @event_init set up
+ */
+struct fpga_region_perf_ops {
+	u64 (*read_counter)(struct fpga_region_perf *perf, unsigned int idx);
+	int (*event_init)(struct fpga_region_perf *perf, unsigned int idx);
+	void (*event_destroy)(struct fpga_region_perf *perf, unsigned int idx);
+};
+
+/**
+ * struct fpga_region_perf_info - parameters of a region counter provider
+ * @name: provider name, appended to the region name to name the PMU
+ * @counters: counter descriptions, indexed by perf event id
+ * @num_counters: number of entries in @counters
+ * @ops: pointer to structure of provider ops
+ * @priv: provider private data
+ * @owner: module providing @ops, pinned while the PMU has events
+ */
+struct fpga_region_perf_info {
+	const char *name;
+	const struct fpga_region_perf_counter *counters;
+	unsigned int num_counters;
+	const struct fpga_region_perf_ops *ops;
+	void *priv;
+	struct module *owner;
+};
+
+void *fpga_region_perf_priv(struct fpga_region_perf *perf);
+
+struct fpga_region_perf *
+fpga_region_perf_register(struct device *dev,
+			  const struct fpga_region_perf_info *info);
+void fpga_region_perf_unregister(struct fpga_region_perf *perf);
+
+struct fpga_region_perf *
+devm_fpga_region_perf_register(struct device *dev,
+			       const struct fpga_region_perf_info *info);
+
+#endif /* _FPGA_REGION_PERF_H */
@@ -57,6 +57,8 @@ fpga_region_class_find(struct device *start, const void *data,
 		       int (*match)(struct device *, const void *));
 
 int fpga_region_program_fpga(struct fpga_region *region);
+int fpga_region_preload(struct fpga_region *region,
+			struct fpga_image_info *info);
 
 struct fpga_region *
 fpga_region_register_full(struct device *parent, const struct fpga_region_info *info);
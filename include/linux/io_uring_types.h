@@ -170,6 +170,8 @@ struct io_submit_state {
 	/* batch completion logic */
 	struct io_wq_work_list	compl_reqs;
 	struct io_submit_link	link;
+	/* notification shared by the zerocopy sends of the submission */
+	struct io_kiocb		*zc_notif;
 
 	bool			plug_started;
 	bool			need_plug;
@@ -190,6 +192,20 @@ struct io_alloc_cache {
 	unsigned int		nr_cached;
 };
 
+/* reasons for handing a request to io-wq, see io_uring_show_fdinfo() */
+enum {
+	/* IOSQE_ASYNC, set on the request or on its link head */
+	IO_IOWQ_PUNT_FORCE,
+	/* -EAGAIN and the opcode or file can't be polled */
+	IO_IOWQ_PUNT_NOPOLL,
+	/* -EAGAIN again after a trip through async poll */
+	IO_IOWQ_PUNT_POLLED,
+	/* -EAGAIN and arming async poll failed */
+	IO_IOWQ_PUNT_OTHER,
+
+	IO_IOWQ_PUNT_NR,
+};
+
 struct io_ring_ctx {
 	/* const or read-mostly hot data */
 	struct {
@@ -351,6 +367,10 @@ struct io_ring_ctx {
 	u32				iowq_limits[2];
 	bool				iowq_limits_set;
 
+	/* io-wq punt statistics, protected by ->uring_lock */
+	unsigned long			iowq_punts[IORING_OP_LAST][IO_IOWQ_PUNT_NR];
+	unsigned long			apoll_repolls;
+
 	struct list_head		defer_list;
 	unsigned			sq_thread_idle;
 	/* protected by ->completion_lock */
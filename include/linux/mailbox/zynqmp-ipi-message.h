@@ -3,6 +3,8 @@
 #ifndef _LINUX_ZYNQMP_IPI_MESSAGE_H_
 #define _LINUX_ZYNQMP_IPI_MESSAGE_H_
 
+#include <linux/types.h>
+
 /**
  * struct zynqmp_ipi_message - ZynqMP IPI message structure
  * @len:  Length of message
@@ -10,11 +12,41 @@
  *
  * This is the structure for data used in mbox_send_message
  * the maximum length of data buffer is fixed to 12 bytes.
- * Client is supposed to be aware of this.
+ * Client is supposed to be aware of this. With a shared memory ring the
+ * maximum length is the ring slot size minus 4 bytes.
  */
 struct zynqmp_ipi_message {
 	size_t len;
 	u8 data[];
 };
 
+/* Offset of the first slot from the start of a ring */
+#define ZYNQMP_IPI_RING_HDR_SIZE	64
+
+/**
+ * struct zynqmp_ipi_ring_hdr - ZynqMP IPI shared memory ring header
+ * @head:      free running index of the next slot to write, producer owned
+ * @tail:      free running index of the next slot to read, consumer owned
+ * @idle:      set by the consumer when it stops reading the ring, the
+ *             producer only rings the doorbell while it is set
+ * @wait:      set by the producer when the ring is full, the consumer rings
+ *             the doorbell once it has freed a slot
+ * @num_slots: number of slots, power of 2
+ * @slot_size: size of a slot in bytes
+ *
+ * A mailbox with a shared memory region has one ring per direction, the
+ * local to remote ring in the first half of the region and the remote to
+ * local ring in the second half. Slots start ZYNQMP_IPI_RING_HDR_SIZE bytes
+ * after the header, each slot is a 32-bit payload length followed by the
+ * payload. The rings are reset when the mailbox is opened.
+ */
+struct zynqmp_ipi_ring_hdr {
+	u32 head;
+	u32 tail;
+	u32 idle;
+	u32 wait;
+	u32 num_slots;
+	u32 slot_size;
+};
+
 #endif /* _LINUX_ZYNQMP_IPI_MESSAGE_H_ */
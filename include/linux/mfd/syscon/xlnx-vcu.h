@@ -36,6 +36,9 @@
 #define VCU_GASKET_INIT			0x74
 #define VCU_GASKET_VALUE		0x03
 
+/* vcu_slcr PLL and clock control registers saved across runtime suspend */
+#define VCU_SLCR_CTX_NUM_REGS		6
+
 /**
  * struct xvcu_device - Xilinx VCU init device structure
  * @dev: Platform device
@@ -47,6 +50,7 @@
  * @pll: handle for the VCU PLL
  * @pll_post: handle for the VCU PLL post divider
  * @clk_data: clocks provided by the vcu clock provider
+ * @slcr_ctx: vcu_slcr clock registers saved across runtime suspend
  */
 struct xvcu_device {
 	struct device *dev;
@@ -58,6 +62,7 @@ struct xvcu_device {
 	struct clk_hw *pll;
 	struct clk_hw *pll_post;
 	struct clk_hw_onecell_data *clk_data;
+	u32 slcr_ctx[VCU_SLCR_CTX_NUM_REGS];
 };
 
 u32 xvcu_get_color_depth(struct xvcu_device *xvcu);
@@ -0,0 +1,21 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+/*
+ * Copyright (C) 2023 Xilinx, Inc.
+ */
+
+#ifndef __CPUIDLE_ZYNQ_H
+#define __CPUIDLE_ZYNQ_H
+
+/**
+ * struct cpuidle_zynq_data - platform hooks for the CPU1 off idle state
+ * @cpu1_powerdown:	called on CPU1, saves its context and waits to be
+ *			put into reset. Returns 0 once it has resumed.
+ * @cpu0_enter:		called on CPU0, puts CPU1 into reset, idles and
+ *			restarts CPU1 before returning
+ */
+struct cpuidle_zynq_data {
+	int (*cpu1_powerdown)(void);
+	int (*cpu0_enter)(void);
+};
+
+#endif
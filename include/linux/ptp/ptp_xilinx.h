@@ -9,6 +9,19 @@
 #define __PTP_PTP_XILINX_H__
 
 #include <linux/ptp_clock_kernel.h>
+#include <linux/seqlock.h>
+
+/**
+ * struct xlnx_ptp_base - Time base to extrapolate the timer from
+ * @hw_ns:	Timer time at @sys_ns
+ * @sys_ns:	CLOCK_MONOTONIC_RAW time the timer was read at
+ * @scaled_ppm:	Frequency adjustment in effect since then
+ */
+struct xlnx_ptp_base {
+	s64			hw_ns;
+	u64			sys_ns;
+	long			scaled_ppm;
+};
 
 struct xlnx_ptp_timer {
 	struct device		*dev;
@@ -20,6 +33,20 @@ struct xlnx_ptp_timer {
 	s64			timeoffset;
 	s32			static_delay;
 	int			phc_index;
+	u64			period;
+	struct xlnx_ptp_base	base;
+	seqcount_spinlock_t	base_seq; /* Writers hold reg_lock */
 };
 
+#if IS_REACHABLE(CONFIG_PTP_1588_CLOCK_XILINX)
+void xlnx_ptp_timer_gettime_cached(struct xlnx_ptp_timer *timer,
+				   struct timespec64 *ts);
+#else
+static inline void xlnx_ptp_timer_gettime_cached(struct xlnx_ptp_timer *timer,
+						 struct timespec64 *ts)
+{
+	*ts = (struct timespec64){ 0 };
+}
+#endif
+
 #endif /* __PTP_PTP_XILINX_H__ */
@@ -192,6 +192,14 @@ __poll_t rpmsg_poll(struct rpmsg_endpoint *ept, struct file *filp,
 
 ssize_t rpmsg_get_mtu(struct rpmsg_endpoint *ept);
 
+void *rpmsg_get_tx_buffer(struct rpmsg_endpoint *ept, unsigned int *len,
+			  bool wait);
+void rpmsg_release_tx_buffer(struct rpmsg_endpoint *ept, void *data);
+int rpmsg_sendto_nocopy(struct rpmsg_endpoint *ept, void *data, int len,
+			u32 dst);
+int rpmsg_hold_rx_buffer(struct rpmsg_endpoint *ept, void *data);
+void rpmsg_release_rx_buffer(struct rpmsg_endpoint *ept, void *data);
+
 #else
 
 static inline int rpmsg_register_device_override(struct rpmsg_device *rpdev,
@@ -316,6 +324,46 @@ static inline ssize_t rpmsg_get_mtu(struct rpmsg_endpoint *ept)
 	return -ENXIO;
 }
 
+static inline void *rpmsg_get_tx_buffer(struct rpmsg_endpoint *ept,
+					unsigned int *len, bool wait)
+{
+	/* This shouldn't be possible */
+	WARN_ON(1);
+
+	return ERR_PTR(-ENXIO);
+}
+
+static inline void rpmsg_release_tx_buffer(struct rpmsg_endpoint *ept,
+					   void *data)
+{
+	/* This shouldn't be possible */
+	WARN_ON(1);
+}
+
+static inline int rpmsg_sendto_nocopy(struct rpmsg_endpoint *ept, void *data,
+				      int len, u32 dst)
+{
+	/* This shouldn't be possible */
+	WARN_ON(1);
+
+	return -ENXIO;
+}
+
+static inline int rpmsg_hold_rx_buffer(struct rpmsg_endpoint *ept, void *data)
+{
+	/* This shouldn't be possible */
+	WARN_ON(1);
+
+	return -ENXIO;
+}
+
+static inline void rpmsg_release_rx_buffer(struct rpmsg_endpoint *ept,
+					   void *data)
+{
+	/* This shouldn't be possible */
+	WARN_ON(1);
+}
+
 #endif /* IS_ENABLED(CONFIG_RPMSG) */
 
 /* use a macro to avoid include chaining to get THIS_MODULE */
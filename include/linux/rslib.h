@@ -22,6 +22,8 @@
  * @alpha_to:	log lookup table
  * @index_of:	Antilog lookup table
  * @genpoly:	Generator polynomial
+ * @syn_mul:	Multiplication tables for the roots of @genpoly, NULL if
+ *		the field is too large for them
  * @nroots:	Number of generator roots = number of parity symbols
  * @fcr:	First consecutive root, index form
  * @prim:	Primitive element, index form
@@ -37,6 +39,7 @@ struct rs_codec {
 	uint16_t	*alpha_to;
 	uint16_t	*index_of;
 	uint16_t	*genpoly;
+	uint16_t	*syn_mul;
 	int		nroots;
 	int		fcr;
 	int		prim;
@@ -180,6 +180,28 @@ zstd_cctx *zstd_init_cctx(void *workspace, size_t workspace_size);
 size_t zstd_compress_cctx(zstd_cctx *cctx, void *dst, size_t dst_capacity,
 	const void *src, size_t src_size, const zstd_parameters *parameters);
 
+/**
+ * zstd_compress_parallel() - compress src into dst using all online CPUs
+ * @dst:          The buffer to compress src into.
+ * @dst_capacity: The size of the destination buffer.
+ * @src:          The data to compress.
+ * @src_size:     The size of the data to compress.
+ * @parameters:   The compression parameters to be used.
+ * @chunk_size:   The size of the independently compressed chunks of src, or 0
+ *                to derive it from the window size.
+ *
+ * src is split into chunks that are compressed as independent frames from a
+ * workqueue, dst receives the frames concatenated in order. The result can be
+ * decompressed with zstd_decompress_dctx() like a single frame, at the cost of
+ * a slightly worse ratio as no match can cross a chunk. Workspaces are
+ * allocated internally, so it must be called from process context.
+ *
+ * Return:        The compressed size or an error, which can be checked using
+ *                zstd_is_error().
+ */
+size_t zstd_compress_parallel(void *dst, size_t dst_capacity, const void *src,
+	size_t src_size, const zstd_parameters *parameters, size_t chunk_size);
+
 /* ======   Single-pass Decompression   ====== */
 
 typedef ZSTD_DCtx zstd_dctx;
@@ -167,6 +167,23 @@ struct dma_buf_import_sync_file {
 	__s32 fd;
 };
 
+/**
+ * struct dma_buf_sync_partial - Synchronize a range with CPU access.
+ *
+ * Like &dma_buf_sync, but only the bytes from @offset to @offset + @len
+ * are made coherent. Exporters that can't sync a range sync the whole
+ * buffer instead. Start and end of an access session should use the
+ * same range.
+ */
+struct dma_buf_sync_partial {
+	/** @flags: Set of access flags, same as &dma_buf_sync.flags */
+	__u64 flags;
+	/** @offset: Start of the range, in bytes from the buffer start */
+	__u64 offset;
+	/** @len: Length of the range in bytes, must not be 0 */
+	__u64 len;
+};
+
 #define DMA_BUF_BASE		'b'
 #define DMA_BUF_IOCTL_SYNC	_IOW(DMA_BUF_BASE, 0, struct dma_buf_sync)
 
@@ -178,5 +195,6 @@ struct dma_buf_import_sync_file {
 #define DMA_BUF_SET_NAME_B	_IOW(DMA_BUF_BASE, 1, __u64)
 #define DMA_BUF_IOCTL_EXPORT_SYNC_FILE	_IOWR(DMA_BUF_BASE, 2, struct dma_buf_export_sync_file)
 #define DMA_BUF_IOCTL_IMPORT_SYNC_FILE	_IOW(DMA_BUF_BASE, 3, struct dma_buf_import_sync_file)
+#define DMA_BUF_IOCTL_SYNC_PARTIAL	_IOW(DMA_BUF_BASE, 4, struct dma_buf_sync_partial)
 
 #endif
@@ -215,6 +215,7 @@ enum io_uring_op {
 	IORING_OP_URING_CMD,
 	IORING_OP_SEND_ZC,
 	IORING_OP_SENDMSG_ZC,
+	IORING_OP_READ_MULTISHOT,
 
 	/* this goes last, obviously */
 	IORING_OP_LAST,
@@ -304,11 +305,21 @@ enum io_uring_op {
  *				0 is reported if zerocopy was actually possible.
  *				IORING_NOTIF_USAGE_ZC_COPIED if data was copied
  *				(at least partially).
+ *
+ * IORING_SEND_ZC_BATCH_NOTIF
+ *				If set, SEND[MSG]_ZC requests submitted by
+ *				the same io_uring_enter() share one
+ *				IORING_CQE_F_NOTIF cqe, posted with the
+ *				user_data of the first of them once all of
+ *				them released their buffers. Its cqe.res
+ *				holds the number of requests it covers in
+ *				the bits below IORING_NOTIF_USAGE_ZC_COPIED.
  */
 #define IORING_RECVSEND_POLL_FIRST	(1U << 0)
 #define IORING_RECV_MULTISHOT		(1U << 1)
 #define IORING_RECVSEND_FIXED_BUF	(1U << 2)
 #define IORING_SEND_ZC_REPORT_USAGE	(1U << 3)
+#define IORING_SEND_ZC_BATCH_NOTIF	(1U << 4)
 
 /*
  * cqe.res for IORING_CQE_F_NOTIF if
@@ -330,6 +341,16 @@ enum io_uring_op {
 enum {
 	IORING_MSG_DATA,	/* pass sqe->len as 'res' and off as user_data */
 	IORING_MSG_SEND_FD,	/* send a registered fd to another ring */
+	IORING_MSG_DATA_BATCH,	/* pass sqe->len io_uring_msg_data at off */
+};
+
+/*
+ * IORING_MSG_DATA_BATCH entry, posted as a CQE to the target ring
+ */
+struct io_uring_msg_data {
+	__u64	user_data;
+	__s32	res;
+	__u32	resv;
 };
 
 /*
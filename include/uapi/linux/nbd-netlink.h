@@ -69,8 +69,12 @@ enum {
  * [NBD_ATTR_SOCKETS]
  *   [NBD_SOCK_ITEM]
  *     [NBD_SOCK_FD]
+ *     [NBD_SOCK_CPU]	(optional)
  *   [NBD_SOCK_ITEM]
  *     [NBD_SOCK_FD]
+ *
+ * NBD_SOCK_CPU pins the receive worker of the connection to that CPU,
+ * typically the one handling the NIC queue the connection is hashed to.
  */
 enum {
 	NBD_SOCK_ITEM_UNSPEC,
@@ -82,6 +86,7 @@ enum {
 enum {
 	NBD_SOCK_UNSPEC,
 	NBD_SOCK_FD,
+	NBD_SOCK_CPU,
 	__NBD_SOCK_MAX,
 };
 #define NBD_SOCK_MAX (__NBD_SOCK_MAX - 1)
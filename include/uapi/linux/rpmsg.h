@@ -23,6 +23,23 @@ struct rpmsg_endpoint_info {
 	__u32 dst;
 };
 
+/**
+ * struct rpmsg_recv_batch - batched receive on a rpmsg char device endpoint
+ * @buf: user buffer the messages are copied to, back to back
+ * @lens: user array of __u32, the length of each message copied to @buf
+ * @buf_len: size of @buf in bytes
+ * @num_msgs: in: number of entries of @lens, out: number of messages read
+ *
+ * A message bigger than @buf is truncated if it is the first one, otherwise
+ * it is left in the queue for the next read.
+ */
+struct rpmsg_recv_batch {
+	__u64 buf;
+	__u64 lens;
+	__u32 buf_len;
+	__u32 num_msgs;
+};
+
 /**
  * Instantiate a new rmpsg char device endpoint.
  */
@@ -43,4 +60,10 @@ struct rpmsg_endpoint_info {
  */
 #define RPMSG_RELEASE_DEV_IOCTL	_IOW(0xb5, 0x4, struct rpmsg_endpoint_info)
 
+/**
+ * Read all the queued messages of a rpmsg char device endpoint that fit in
+ * the buffer, blocking until there is at least one unless O_NONBLOCK is set.
+ */
+#define RPMSG_RECV_BATCH_IOCTL	_IOWR(0xb5, 0x5, struct rpmsg_recv_batch)
+
 #endif
@@ -54,6 +54,29 @@
 /* tag bit is 12bit, so at most 4096 IOs for each queue */
 #define UBLK_MAX_QUEUE_DEPTH	4096
 
+/*
+ * With UBLK_F_USER_COPY, the request buffer of (q_id, tag) is accessed
+ * with pread()/pwrite() on /dev/ublkcN at offset UBLKSRV_IO_BUF_OFFSET +
+ * (q_id << UBLK_QID_OFF | tag << UBLK_TAG_OFF | offset in buffer).
+ */
+/* single IO buffer max size is 32MB */
+#define UBLK_IO_BUF_OFF		0
+#define UBLK_IO_BUF_BITS	25
+#define UBLK_IO_BUF_BITS_MASK	((1ULL << UBLK_IO_BUF_BITS) - 1)
+
+/* so at most 64K IOs for each queue */
+#define UBLK_TAG_OFF		UBLK_IO_BUF_BITS
+#define UBLK_TAG_BITS		16
+#define UBLK_TAG_BITS_MASK	((1ULL << UBLK_TAG_BITS) - 1)
+
+/* max 4096 queues */
+#define UBLK_QID_OFF		(UBLK_TAG_OFF + UBLK_TAG_BITS)
+#define UBLK_QID_BITS		12
+#define UBLK_QID_BITS_MASK	((1ULL << UBLK_QID_BITS) - 1)
+
+#define UBLKSRV_IO_BUF_TOTAL_BITS	(UBLK_QID_OFF + UBLK_QID_BITS)
+#define UBLKSRV_IO_BUF_TOTAL_SIZE	(1ULL << UBLKSRV_IO_BUF_TOTAL_BITS)
+
 /*
  * zero copy requires 4k block size, and can remap ublk driver's io
  * request into ublksrv's vm space
@@ -79,6 +102,18 @@
 
 #define UBLK_F_USER_RECOVERY_REISSUE	(1UL << 4)
 
+/*
+ * Copy data between the ublk server and request pages with
+ * pread()/pwrite() (or io_uring read/write, including the fixed buffer
+ * variants) on /dev/ublkcN instead of through the io buffer passed in
+ * FETCH_REQ/COMMIT_AND_FETCH_REQ. The server then moves data straight
+ * into or out of its own, possibly registered, buffers as it handles each
+ * request, and io->addr is not needed.
+ *
+ * UBLK_F_NEED_GET_DATA is meaningless in this mode and is cleared.
+ */
+#define UBLK_F_USER_COPY	(1UL << 7)
+
 /* device state */
 #define UBLK_S_DEV_DEAD	0
 #define UBLK_S_DEV_LIVE	1
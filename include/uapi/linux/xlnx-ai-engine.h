@@ -299,6 +299,152 @@ struct aie_dmabuf_bd_args {
 	__u32 bd_id;
 };
 
+/* Maximum number of dimensions of a generic DMA buffer descriptor */
+#define AIE_DMA_MAX_DIMS		4U
+
+/* Flags of a generic DMA buffer descriptor */
+#define AIE_DMA_BD_USE_NEXT		(1U << 0)
+#define AIE_DMA_BD_LOCK_ACQ		(1U << 1)
+#define AIE_DMA_BD_LOCK_REL		(1U << 2)
+#define AIE_DMA_BD_TLAST_SUPPRESS	(1U << 3)
+
+/**
+ * struct aie_dma_dim - AIE DMA access pattern dimension
+ * @stepsize: distance between two elements of the dimension in 32bit words
+ * @wrap: number of elements of the dimension before stepping the next one.
+ *	  It is derived from the transfer length for the outermost dimension,
+ *	  0 or the derived value are accepted there.
+ */
+struct aie_dma_dim {
+	__u32 stepsize;
+	__u32 wrap;
+};
+
+/**
+ * struct aie_dma_nd_bd_args - AIE generic N-dimensional buffer descriptor
+ * @loc: SHIM NOC or memory tile location relative to the start of a
+ *	 partition
+ * @bd_id: buffer descriptor id
+ * @buf_fd: attached dmabuf the SHIM NOC DMA accesses, unused for memory tiles
+ * @addr: byte offset in @buf_fd for SHIM NOC tiles, byte address in the
+ *	  memory tile address space for memory tiles
+ * @len: transfer length in bytes, a multiple of 4
+ * @num_dims: number of entries of @dims in use, 0 for a linear transfer
+ * @dims: access pattern dimensions, dims[0] is the innermost one
+ * @iter_stepsize: step applied to the address every time the buffer
+ *		   descriptor is executed again, in 32bit words
+ * @iter_wrap: number of executions before the address steps back to @addr,
+ *	       0 to not step
+ * @next_bd: buffer descriptor to chain when AIE_DMA_BD_USE_NEXT is set
+ * @flags: AIE_DMA_BD_* flags
+ * @lock_acq_id: lock to acquire before the transfer with AIE_DMA_BD_LOCK_ACQ
+ * @lock_acq_val: value to acquire the lock with
+ * @lock_rel_id: lock to release after the transfer with AIE_DMA_BD_LOCK_REL
+ * @lock_rel_val: value to release the lock with
+ *
+ * The driver encodes the descriptor in the buffer descriptor format of the
+ * device generation, applications don't pack the registers themselves.
+ */
+struct aie_dma_nd_bd_args {
+	struct aie_location loc;
+	__u32 bd_id;
+	__s32 buf_fd;
+	__u64 addr;
+	__u32 len;
+	__u32 num_dims;
+	struct aie_dma_dim dims[AIE_DMA_MAX_DIMS];
+	__u32 iter_stepsize;
+	__u32 iter_wrap;
+	__u32 next_bd;
+	__u32 flags;
+	__u32 lock_acq_id;
+	__s32 lock_acq_val;
+	__u32 lock_rel_id;
+	__s32 lock_rel_val;
+};
+
+/**
+ * enum aie_dma_dir - AIE DMA channel direction
+ * @AIE_DMA_S2MM: stream to memory map channel
+ * @AIE_DMA_MM2S: memory map to stream channel
+ */
+enum aie_dma_dir {
+	AIE_DMA_S2MM,
+	AIE_DMA_MM2S,
+};
+
+/**
+ * struct aie_dma_notify_args - AIE SHIM DMA channel completion notification
+ *				information
+ * @loc: SHIM NOC tile location relative to the start of a partition
+ * @dir: DMA channel direction, enum aie_dma_dir
+ * @chan: DMA channel id
+ * @eventfd: eventfd to signal every time the channel finishes a buffer
+ *	     descriptor, or -1 to stop notifying the channel
+ */
+struct aie_dma_notify_args {
+	struct aie_location loc;
+	__u32 dir;
+	__u32 chan;
+	__s32 eventfd;
+};
+
+/**
+ * struct aie_perf_sampler_args - AIE performance sampler arguments
+ * @regsptr: pointer to the array of __u32 register offsets relative to the
+ *	     start of the partition to sample, e.g. performance counters and
+ *	     event status registers
+ * @period_ns: sampling period in nanoseconds
+ * @num_regs: number of registers of @regsptr
+ * @num_records: number of records of the ring buffer, it has to be a power
+ *		 of 2
+ */
+struct aie_perf_sampler_args {
+	__u64 regsptr;
+	__u64 period_ns;
+	__u32 num_regs;
+	__u32 num_records;
+};
+
+/**
+ * struct aie_perf_ring_hdr - AIE performance sampler ring buffer header
+ * @head: number of records written since the sampler started, record n is
+ *	  at index n % @num_records. It is updated after the record is
+ *	  written, readers check it again after copying records to detect
+ *	  the ones overwritten meanwhile.
+ * @num_records: number of records of the ring buffer
+ * @num_regs: number of register values of a record
+ * @record_size: size of a record in bytes
+ * @data_offset: offset of the first record from the start of the header
+ *
+ * The ring buffer header is at the start of the sampler mapping. A record
+ * is a __u64 CLOCK_MONOTONIC timestamp in nanoseconds followed by @num_regs
+ * __u32 register values, in the order of the sampler registers. Registers
+ * of clock gated tiles are not read and reported as 0xffffffff.
+ */
+struct aie_perf_ring_hdr {
+	__u64 head;
+	__u32 num_records;
+	__u32 num_regs;
+	__u32 record_size;
+	__u32 data_offset;
+};
+
+/**
+ * struct aie_dmabuf_bd_rearm_args - AIE dmabuf buffer descriptor re-arm
+ *				     information
+ * @off: offset to the start of the dmabuf the buffer descriptor was set with
+ * @loc: Tile location relative to the start of a partition
+ * @bd_id: buffer descriptor id
+ * @len: buffer length, in the unit of the buffer descriptor length field
+ */
+struct aie_dmabuf_bd_rearm_args {
+	__u64 off;
+	struct aie_location loc;
+	__u32 bd_id;
+	__u32 len;
+};
+
 /**
  * struct aie_tiles_array - AIE tiles array
  * @locs: tiles locations array
@@ -309,6 +455,18 @@ struct aie_tiles_array {
 	__u32 num_tiles;
 };
 
+/**
+ * struct aie_auto_gate_args - AIE automatic column clock gating args
+ * @period_ms: period of the columns activity check in milliseconds, 0 to
+ *	       stop the automatic gating
+ * @idle_periods: number of consecutive checks a column has to be found idle
+ *		  before it gets gated
+ */
+struct aie_auto_gate_args {
+	__u32 period_ms;
+	__u32 idle_periods;
+};
+
 /**
  * struct aie_column_args - AIE columns args
  * @start_col : start column
@@ -331,6 +489,99 @@ struct aie_txn_inst {
 	__u64 cmdsptr;
 };
 
+/**
+ * struct aie_mem_load_seg - AIE memory load segment
+ * @offset: offset of the tile memory to the start of the AI engine partition
+ * @dataptr: pointer to the data to load
+ * @len: length of the data in bytes
+ */
+struct aie_mem_load_seg {
+	__u64 offset;
+	__u64 dataptr;
+	__u32 len;
+};
+
+/**
+ * struct aie_mem_load_args - AIE memory load arguments
+ * @num_segs: number of segments
+ * @segsptr: pointer to the array of struct aie_mem_load_seg
+ */
+struct aie_mem_load_args {
+	__u32 num_segs;
+	__u64 segsptr;
+};
+
+/**
+ * enum aie_txn_op_type - operations of a batched transaction
+ * @AIE_TXN_OP_WRITE: write one word, data is the value
+ * @AIE_TXN_OP_MASKWRITE: mask write one word, data is the value and the mask
+ * @AIE_TXN_OP_BLOCKWRITE: write @len consecutive words taken from data
+ * @AIE_TXN_OP_MASKPOLL: wait until the masked register equals the value,
+ *			 data is the value, the mask and a timeout in
+ *			 microseconds
+ */
+enum aie_txn_op_type {
+	AIE_TXN_OP_WRITE,
+	AIE_TXN_OP_MASKWRITE,
+	AIE_TXN_OP_BLOCKWRITE,
+	AIE_TXN_OP_MASKPOLL,
+};
+
+/**
+ * struct aie_txn_op - header of an operation in a batched transaction
+ * @op: operation type, one of enum aie_txn_op_type
+ * @len: number of 32bit data words following this header
+ * @offset: register offset to the start of the AI engine partition
+ *
+ * The data words of the operation directly follow the header, the next
+ * header starts right after them.
+ */
+struct aie_txn_op {
+	__u16 op;
+	__u16 len;
+	__u32 offset;
+};
+
+/**
+ * struct aie_txn_batch - AIE batched transaction
+ * @bufptr: pointer to the buffer of packed operations
+ * @size: size of the buffer in bytes
+ */
+struct aie_txn_batch {
+	__u64 bufptr;
+	__u32 size;
+};
+
+/**
+ * struct aie_lock_args - AIE lock acquire or release request
+ * @loc: tile location relative to the start of a partition
+ * @lock_id: lock id within the tile
+ * @lock_val: value to acquire or release the lock with. AIE locks take 0
+ *	      or 1, AIE-ML semaphore locks take a signed 7 bit value.
+ * @timeout_us: time to wait for the lock in us, 0 tries only once
+ */
+struct aie_lock_args {
+	struct aie_location loc;
+	__u32 lock_id;
+	__s32 lock_val;
+	__u32 timeout_us;
+};
+
+/**
+ * struct aie_uring_cmd - io_uring command payload in the sqe cmd area
+ * @arg: user address of the argument of the ioctl given as sqe cmd_op
+ *
+ * The partition fd accepts AIE_REG_IOCTL, AIE_SET_SHIMDMA_BD_IOCTL,
+ * AIE_SET_SHIMDMA_DMABUF_BD_IOCTL, AIE_REARM_SHIMDMA_DMABUF_BD_IOCTL,
+ * AIE_SET_DMA_ND_BD_IOCTL, AIE_TRANSACTION_IOCTL,
+ * AIE_TRANSACTION_BATCH_IOCTL, AIE_LOCK_ACQUIRE_IOCTL and
+ * AIE_LOCK_RELEASE_IOCTL as IORING_OP_URING_CMD, the cqe res is the return
+ * value of the ioctl.
+ */
+struct aie_uring_cmd {
+	__u64 arg;
+};
+
 /**
  * struct aie_rsc_req - AIE resource request
  * @loc: tile location
@@ -669,4 +920,129 @@ struct aie_rsc_user_stat_array {
  */
 #define AIE_SET_COLUMN_CLOCK_IOCTL	_IOW(AIE_IOCTL_BASE, 0x1b, \
 					struct aie_tiles_array)
+
+/**
+ * DOC: AIE_TRANSACTION_BATCH_IOCTL - execute a batch of packed register
+ *				      operations on AIE partition
+ *
+ * This ioctl takes a buffer of struct aie_txn_op headers, each followed by
+ * its data words. The whole buffer is validated before the first operation
+ * is applied, if any operation is invalid nothing is written. Consecutive
+ * single word writes to contiguous registers are applied as one burst.
+ */
+#define AIE_TRANSACTION_BATCH_IOCTL	_IOW(AIE_IOCTL_BASE, 0x1c, \
+					struct aie_txn_batch)
+
+/**
+ * DOC: AIE_LOAD_MEM_IOCTL - load data into AIE tile memories
+ *
+ * This ioctl is used to load program and data memories of the partition
+ * tiles, e.g. from the sections of the tile ELF files. Large segments are
+ * copied with a DMA memcpy channel when one is available in the system,
+ * smaller ones, or all of them without a channel, with CPU writes.
+ */
+#define AIE_LOAD_MEM_IOCTL		_IOW(AIE_IOCTL_BASE, 0x1d, \
+					struct aie_mem_load_args)
+
+/**
+ * DOC: AIE_REARM_SHIMDMA_DMABUF_BD_IOCTL - re-arm a dmabuf SHIM DMA buffer
+ *					   descriptor
+ *
+ * This ioctl reuses a buffer descriptor previously set with
+ * AIE_SET_SHIMDMA_DMABUF_BD_IOCTL. Only its address and length are updated,
+ * the dmabuf is the one the buffer descriptor was set with and it must still
+ * be attached to the partition.
+ */
+#define AIE_REARM_SHIMDMA_DMABUF_BD_IOCTL	_IOW(AIE_IOCTL_BASE, 0x1e, \
+					struct aie_dmabuf_bd_rearm_args)
+
+/**
+ * DOC: AIE_SET_DMA_NOTIFY_IOCTL - notify SHIM DMA channel completions
+ *
+ * This ioctl routes the finished buffer descriptor event of a SHIM DMA
+ * channel to the AI engine interrupt and signals the eventfd of the channel
+ * when the event occurs. Applications can sleep on the eventfd with read(),
+ * poll() or epoll instead of polling the DMA status registers.
+ */
+#define AIE_SET_DMA_NOTIFY_IOCTL	_IOW(AIE_IOCTL_BASE, 0x1f, \
+					struct aie_dma_notify_args)
+
+/**
+ * DOC: AIE_PERF_SAMPLER_IOCTL - start sampling AIE registers periodically
+ *
+ * This ioctl returns a file descriptor of a sampler which reads the
+ * specified partition registers every period into a ring buffer. The ring
+ * buffer, starting with struct aie_perf_ring_hdr, is mapped read only with
+ * mmap() of the file descriptor. Sampling stops when the file descriptor is
+ * closed, the partition is not released before then.
+ */
+#define AIE_PERF_SAMPLER_IOCTL		_IOW(AIE_IOCTL_BASE, 0x20, \
+					struct aie_perf_sampler_args)
+
+/**
+ * DOC: AIE_PARTITION_FAST_CLEAN_IOCTL - clean AI engine partition for the
+ *					 next application
+ *
+ * This ioctl is used to switch a partition between applications using the
+ * same tiles. It does the following steps:
+ * - Reset AI engine partition columns and shim tiles
+ * - Ungate the tiles in use
+ * - Zeroize memories and core registers of the tiles in use only
+ * - Setup axi mm to raise events
+ * - Setup partition isolation
+ * - Setup L2 intrupt
+ * - Release the partition resources, dmabuf buffer descriptors records and
+ *   DMA notifications
+ * The tiles in use stay requested, the memories of the other tiles are not
+ * touched.
+ */
+#define AIE_PARTITION_FAST_CLEAN_IOCTL	_IO(AIE_IOCTL_BASE, 0x21)
+
+/**
+ * DOC: AIE_SET_AUTO_GATE_IOCTL - gate idle columns automatically
+ *
+ * This ioctl is used to let the driver release the tiles of the columns
+ * which stay idle, that is none of their tiles has resources allocated, and
+ * no core of them or of their neighbour columns is enabled. The released
+ * tiles are clock gated, applications need to request them again with
+ * AIE_REQUEST_TILES_IOCTL before using them.
+ */
+#define AIE_SET_AUTO_GATE_IOCTL		_IOW(AIE_IOCTL_BASE, 0x22, \
+					struct aie_auto_gate_args)
+
+/**
+ * DOC: AIE_LOCK_ACQUIRE_IOCTL - acquire an AIE lock
+ *
+ * This ioctl acquires a lock of a tile in use with the given value. If the
+ * lock isn't available, the driver retries with a growing sleep until the
+ * timeout expires, and returns -ETIMEDOUT, or -EBUSY with no timeout. The
+ * tile must hold resources allocated by the resource manager.
+ */
+#define AIE_LOCK_ACQUIRE_IOCTL		_IOW(AIE_IOCTL_BASE, 0x23, \
+					struct aie_lock_args)
+
+/**
+ * DOC: AIE_LOCK_RELEASE_IOCTL - release an AIE lock
+ *
+ * This ioctl releases a lock of a tile in use with the given value, with the
+ * same retry and ownership rules as AIE_LOCK_ACQUIRE_IOCTL.
+ */
+#define AIE_LOCK_RELEASE_IOCTL		_IOW(AIE_IOCTL_BASE, 0x24, \
+					struct aie_lock_args)
+
+/**
+ * DOC: AIE_SET_DMA_ND_BD_IOCTL - set a generic N-dimensional buffer
+ *				  descriptor to a SHIM NOC or memory tile DMA
+ *
+ * This ioctl sets a buffer descriptor from a device independent description
+ * of a multi-dimensional access pattern, so that tiled tensors are moved
+ * without reformatting them on the host. SHIM NOC descriptors access an
+ * attached dmabuf and the whole footprint of the pattern has to be within
+ * the dmabuf. As re-arming only updates the address and the length, these
+ * descriptors cannot be re-armed with AIE_REARM_SHIMDMA_DMABUF_BD_IOCTL,
+ * they are set again instead. -EOPNOTSUPP is returned by the devices without
+ * multi-dimensional DMAs.
+ */
+#define AIE_SET_DMA_ND_BD_IOCTL		_IOW(AIE_IOCTL_BASE, 0x25, \
+					struct aie_dma_nd_bd_args)
 #endif
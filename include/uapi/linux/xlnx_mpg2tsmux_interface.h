@@ -174,6 +174,53 @@ struct xlnx_tsmux_dmabuf_info {
 	enum xlnx_tsmux_dmabuf_flags flags;
 };
 
+/**
+ * enum mpg2mux_ring_type - type of a submission ring entry
+ * @MPG2MUX_RING_STREAM: stream context, same as MPG2MUX_SETSTRM
+ * @MPG2MUX_RING_MUX: mux context, same as MPG2MUX_SETMUX
+ */
+enum mpg2mux_ring_type {
+	MPG2MUX_RING_STREAM = 0,
+	MPG2MUX_RING_MUX,
+};
+
+/**
+ * struct mpg2mux_ring_entry - submission ring entry
+ * @type: entry type, one of enum mpg2mux_ring_type
+ * @reserved: must be zero
+ * @stream: stream context descriptor for MPG2MUX_RING_STREAM
+ * @mux: mux context descriptor for MPG2MUX_RING_MUX
+ */
+struct mpg2mux_ring_entry {
+	__u32 type;
+	__u32 reserved;
+	union {
+		struct stream_context_in stream;
+		struct muxer_context_in mux;
+	};
+};
+
+/**
+ * struct mpg2mux_ring_hdr - submission ring header
+ * @head: free running index of the next entry written by user space
+ * @tail: free running index of the next entry consumed by the driver
+ * @num_entries: number of entries in the ring, power of 2
+ * @entry_offset: offset of the first entry from the start of the ring
+ *
+ * The header is at the start of the ring mapping. User space fills the
+ * entries from head, then advances head and rings the doorbell with
+ * MPG2MUX_RINGKICK. Only the driver updates tail.
+ */
+struct mpg2mux_ring_hdr {
+	__u32 head;
+	__u32 tail;
+	__u32 num_entries;
+	__u32 entry_offset;
+};
+
+/* mmap buffer id of the submission ring */
+#define MPG2MUX_RING_BUFID	0x8000
+
 /* MPG2MUX IOCTL CALL LIST */
 
 #define MPG2MUX_MAGIC 'M'
@@ -250,4 +297,16 @@ struct xlnx_tsmux_dmabuf_info {
  */
 #define MPG2MUX_VDBUF _IOWR(MPG2MUX_MAGIC, 14, struct xlnx_tsmux_dmabuf_info *)
 
+/**
+ * MPG2MUX_RINGALLOC - allocates the submission ring with the given number
+ *		of entries, zero frees the ring
+ */
+#define MPG2MUX_RINGALLOC _IOW(MPG2MUX_MAGIC, 15, unsigned int *)
+
+/**
+ * MPG2MUX_RINGKICK - enqueues the submission ring entries up to head,
+ *		returns the number of entries consumed
+ */
+#define MPG2MUX_RINGKICK _IO(MPG2MUX_MAGIC, 16)
+
 #endif
@@ -145,6 +145,29 @@ struct xlnxsync_stat {
 	struct xlnxsync_err_intr err;
 };
 
+/**
+ * struct xlnxsync_fence - Framebuffer done fence request
+ * @hdr_ver: IOCTL header version
+ * @fb_id: Framebuffer index. Valid values 0/1/2
+ * @io: XLNXSYNC_PROD or XLNXSYNC_CONS
+ * @reserved: Must be zero
+ * @dma_fd: dma-buf to attach the fence to, or -1 for no dma-buf
+ * @fence_fd: Returned sync_file file descriptor of the fence
+ *
+ * The fence signals the next time both the luma and chroma buffers of the
+ * framebuffer are done for the producer or the consumer. A producer fence
+ * is attached to the dma-buf as a write fence, a consumer fence as a read
+ * fence. Pending fences signal with -ECANCELED when the channel is disabled.
+ */
+struct xlnxsync_fence {
+	__u64 hdr_ver;
+	__u8 fb_id;
+	__u8 io;
+	__u8 reserved[2];
+	__s32 dma_fd;
+	__s32 fence_fd;
+};
+
 #define XLNXSYNC_MAGIC			'X'
 
 /*
@@ -176,4 +199,7 @@ struct xlnxsync_stat {
 					     struct xlnxsync_intr *)
 /* This is used to reset the last programmed slot */
 #define XLNXSYNC_RESET_SLOT		_IO(XLNXSYNC_MAGIC, 10)
+/* This is used to get a fence signalled on framebuffer done */
+#define XLNXSYNC_CHAN_GET_FENCE		_IOWR(XLNXSYNC_MAGIC, 11,\
+					      struct xlnxsync_fence *)
 #endif
@@ -189,6 +189,73 @@ struct xsdfec_ldpc_params {
 	__u16 code_id;
 };
 
+/**
+ * struct xsdfec_ldpc_code - LDPC code parameters in an LDPC code table.
+ * @n: Number of code word bits
+ * @k: Number of information bits
+ * @psize: Size of sub-matrix
+ * @nlayers: Number of layers in code
+ * @nqc: Quasi Cyclic Number
+ * @nmqc: Number of M-sized QC operations in parity check matrix
+ * @nm: Number of M-size vectors in N
+ * @norm_type: Normalization required or not
+ * @no_packing: Determines if multiple QC ops should be performed
+ * @special_qc: Sub-Matrix property for Circulant weight > 0
+ * @no_final_parity: Decide if final parity check needs to be performed
+ * @max_schedule: Experimental code word scheduling limit
+ * @sc_off: SC offset
+ * @la_off: LA offset
+ * @qc_off: QC offset
+ * @sc_idx: Index of the SC Table in the table words
+ * @la_idx: Index of the LA Table in the table words
+ * @qc_idx: Index of the QC Table in the table words
+ * @code_id: LDPC Code
+ * @reserved: Must be zero
+ *
+ * This structure describes an LDPC code of &struct xsdfec_ldpc_table, it
+ * matches &struct xsdfec_ldpc_params with the tables taken from the table
+ * words instead of separate user buffers.
+ */
+struct xsdfec_ldpc_code {
+	__u32 n;
+	__u32 k;
+	__u32 psize;
+	__u32 nlayers;
+	__u32 nqc;
+	__u32 nmqc;
+	__u32 nm;
+	__u32 norm_type;
+	__u32 no_packing;
+	__u32 special_qc;
+	__u32 no_final_parity;
+	__u32 max_schedule;
+	__u32 sc_off;
+	__u32 la_off;
+	__u32 qc_off;
+	__u32 sc_idx;
+	__u32 la_idx;
+	__u32 qc_idx;
+	__u16 code_id;
+	__u16 reserved;
+};
+
+/**
+ * struct xsdfec_ldpc_table - Precompiled LDPC code table.
+ * @num_codes: Number of codes in @codes
+ * @num_words: Number of table words in @words
+ * @codes: Pointer to an array of &struct xsdfec_ldpc_code
+ * @words: Pointer to the SC, LA and QC table words of all codes
+ *
+ * This structure describes a set of LDPC codes which are loaded by a single
+ * ioctl call.
+ */
+struct xsdfec_ldpc_table {
+	__u32 num_codes;
+	__u32 num_words;
+	__u64 codes;
+	__u64 words;
+};
+
 /**
  * struct xsdfec_status - Status of SD-FEC core.
  * @state: State of the SD-FEC core
@@ -248,6 +315,22 @@ struct xsdfec_stats {
 	__u32 uecc_count;
 };
 
+/**
+ * struct xsdfec_stats_page - Stats page mapped read-only by mmap() on the
+ *			      SD-FEC device at offset 0.
+ * @seq: Sequence count, odd while the driver updates @stats
+ * @stats: Stats with the same counts as returned by XSDFEC_GET_STATS
+ *
+ * The driver updates the page when the interrupt handler counts new errors
+ * and when the stats are cleared. A reader takes a consistent copy of
+ * @stats by retrying until @seq is even and unchanged across the copy,
+ * with read barriers between the reads of @seq and the copy.
+ */
+struct xsdfec_stats_page {
+	__u32 seq;
+	struct xsdfec_stats stats;
+};
+
 /**
  * struct xsdfec_ldpc_param_table_sizes - Used to store sizes of SD-FEC table
  *					  entries for an individual LPDC code
@@ -444,5 +527,31 @@ struct xsdfec_ldpc_param_table_sizes {
  * This can only be used when the driver is in the XSDFEC_STOPPED state
  */
 #define XSDFEC_SET_DEFAULT_CONFIG _IO(XSDFEC_MAGIC, 13)
+/**
+ * DOC: XSDFEC_ADD_LDPC_CODE_TABLE
+ * @Parameters
+ *
+ * @struct xsdfec_ldpc_table *
+ *	Pointer to the &struct xsdfec_ldpc_table that contains the LDPC codes
+ *	to be added to the SD-FEC Block
+ *
+ * @Description
+ * ioctl to add a precompiled table of LDPC codes to the SD-FEC LDPC codes
+ *
+ * The driver keeps track of the code registers and shared tables written
+ * to the SD-FEC Block, words which already hold the requested value are not
+ * written again. Reloading codes which are already loaded is therefore
+ * cheap. If a code is invalid the codes before it remain loaded.
+ *
+ * This can only be used when:
+ *
+ * - Driver is in the XSDFEC_STOPPED state
+ *
+ * - SD-FEC core is configured as LPDC
+ *
+ * - SD-FEC Code Write Protection is disabled
+ */
+#define XSDFEC_ADD_LDPC_CODE_TABLE                                             \
+	_IOW(XSDFEC_MAGIC, 14, struct xsdfec_ldpc_table)
 
 #endif /* __XILINX_SDFEC_H__ */
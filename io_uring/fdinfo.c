@@ -173,6 +173,20 @@ static __cold void __io_uring_show_fdinfo(struct io_ring_ctx *ctx,
 	if (has_lock)
 		mutex_unlock(&ctx->uring_lock);
 
+	seq_puts(m, "IowqPunts:\n");
+	for (i = 0; i < IORING_OP_LAST; i++) {
+		unsigned long *punts = ctx->iowq_punts[i];
+
+		if (!punts[IO_IOWQ_PUNT_FORCE] && !punts[IO_IOWQ_PUNT_NOPOLL] &&
+		    !punts[IO_IOWQ_PUNT_POLLED] && !punts[IO_IOWQ_PUNT_OTHER])
+			continue;
+		seq_printf(m, "  %s: force=%lu, nopoll=%lu, polled=%lu, other=%lu\n",
+			   io_uring_get_opcode(i), punts[IO_IOWQ_PUNT_FORCE],
+			   punts[IO_IOWQ_PUNT_NOPOLL], punts[IO_IOWQ_PUNT_POLLED],
+			   punts[IO_IOWQ_PUNT_OTHER]);
+	}
+	seq_printf(m, "ApollRepolls:\t%lu\n", ctx->apoll_repolls);
+
 	seq_puts(m, "PollList:\n");
 	for (i = 0; i < (1U << ctx->cancel_table.hash_bits); i++) {
 		struct io_hash_bucket *hb = &ctx->cancel_table.hbs[i];
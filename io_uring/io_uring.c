@@ -1885,6 +1885,23 @@ struct file *io_file_get_normal(struct io_kiocb *req, int fd)
 	return file;
 }
 
+static void io_account_punt(struct io_kiocb *req, unsigned int reason)
+	__must_hold(&req->ctx->uring_lock)
+{
+	req->ctx->iowq_punts[req->opcode][reason]++;
+}
+
+static unsigned int io_punt_reason(struct io_kiocb *req)
+{
+	const struct io_op_def *def = &io_op_defs[req->opcode];
+
+	if ((!def->pollin && !def->pollout) || !file_can_poll(req->file))
+		return IO_IOWQ_PUNT_NOPOLL;
+	if (req->flags & REQ_F_POLLED)
+		return IO_IOWQ_PUNT_POLLED;
+	return IO_IOWQ_PUNT_OTHER;
+}
+
 static void io_queue_async(struct io_kiocb *req, int ret)
 	__must_hold(&req->ctx->uring_lock)
 {
@@ -1904,6 +1921,7 @@ static void io_queue_async(struct io_kiocb *req, int ret)
 		break;
 	case IO_APOLL_ABORTED:
 		io_kbuf_recycle(req, 0);
+		io_account_punt(req, io_punt_reason(req));
 		io_queue_iowq(req, NULL);
 		break;
 	case IO_APOLL_OK:
@@ -1947,10 +1965,12 @@ static void io_queue_sqe_fallback(struct io_kiocb *req)
 	} else {
 		int ret = io_req_prep_async(req);
 
-		if (unlikely(ret))
+		if (unlikely(ret)) {
 			io_req_complete_failed(req, ret);
-		else
+		} else {
+			io_account_punt(req, IO_IOWQ_PUNT_FORCE);
 			io_queue_iowq(req, NULL);
+		}
 	}
 }
 
@@ -2192,6 +2212,7 @@ static void io_submit_state_end(struct io_ring_ctx *ctx)
 		io_queue_sqe_fallback(state->link.head);
 	/* flush only after queuing links as they can generate completions */
 	io_submit_flush_completions(ctx);
+	io_notif_batch_flush(ctx);
 	if (state->plug_started)
 		blk_finish_plug(&state->plug);
 }
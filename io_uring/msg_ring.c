@@ -13,6 +13,9 @@
 #include "filetable.h"
 #include "msg_ring.h"
 
+/* Maximum number of CQEs an IORING_MSG_DATA_BATCH request posts */
+#define IO_MSG_DATA_BATCH_MAX	128U
+
 struct io_msg {
 	struct file			*file;
 	u64 user_data;
@@ -37,6 +40,50 @@ static int io_msg_ring_data(struct io_kiocb *req)
 	return -EOVERFLOW;
 }
 
+/*
+ * All the CQEs of the batch are posted under one completion lock and with
+ * one wakeup of the target. Returns the number of CQEs posted, the target
+ * overflowed if it's less than requested.
+ */
+static int io_msg_ring_data_batch(struct io_kiocb *req)
+{
+	struct io_ring_ctx *target_ctx = req->file->private_data;
+	struct io_msg *msg = io_kiocb_to_cmd(req, struct io_msg);
+	struct io_uring_msg_data *data;
+	unsigned int i;
+	int ret;
+
+	if (msg->src_fd || msg->dst_fd || msg->flags)
+		return -EINVAL;
+	if (!msg->len || msg->len > IO_MSG_DATA_BATCH_MAX)
+		return -EINVAL;
+
+	data = memdup_user(u64_to_user_ptr(msg->user_data),
+			   array_size(msg->len, sizeof(*data)));
+	if (IS_ERR(data))
+		return PTR_ERR(data);
+
+	for (i = 0; i < msg->len; i++) {
+		if (data[i].resv) {
+			ret = -EINVAL;
+			goto out;
+		}
+	}
+
+	io_cq_lock(target_ctx);
+	for (i = 0; i < msg->len; i++) {
+		if (!io_fill_cqe_aux(target_ctx, data[i].user_data,
+				     data[i].res, 0, true))
+			break;
+	}
+	io_cq_unlock_post(target_ctx);
+
+	ret = i ? i : -EOVERFLOW;
+out:
+	kfree(data);
+	return ret;
+}
+
 static void io_double_unlock_ctx(struct io_ring_ctx *ctx,
 				 struct io_ring_ctx *octx,
 				 unsigned int issue_flags)
@@ -158,6 +205,9 @@ int io_msg_ring(struct io_kiocb *req, unsigned int issue_flags)
 	case IORING_MSG_SEND_FD:
 		ret = io_msg_send_fd(req, issue_flags);
 		break;
+	case IORING_MSG_DATA_BATCH:
+		ret = io_msg_ring_data_batch(req);
+		break;
 	default:
 		ret = -EINVAL;
 		break;
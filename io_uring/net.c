@@ -939,14 +939,21 @@ int io_send_zc_prep(struct io_kiocb *req, const struct io_uring_sqe *sqe)
 	zc->flags = READ_ONCE(sqe->ioprio);
 	if (zc->flags & ~(IORING_RECVSEND_POLL_FIRST |
 			  IORING_RECVSEND_FIXED_BUF |
-			  IORING_SEND_ZC_REPORT_USAGE))
+			  IORING_SEND_ZC_REPORT_USAGE |
+			  IORING_SEND_ZC_BATCH_NOTIF))
 		return -EINVAL;
-	notif = zc->notif = io_alloc_notif(ctx);
-	if (!notif)
-		return -ENOMEM;
-	notif->cqe.user_data = req->cqe.user_data;
-	notif->cqe.res = 0;
-	notif->cqe.flags = IORING_CQE_F_NOTIF;
+	if (zc->flags & IORING_SEND_ZC_BATCH_NOTIF) {
+		notif = zc->notif = io_alloc_notif_batch(req);
+		if (!notif)
+			return -ENOMEM;
+	} else {
+		notif = zc->notif = io_alloc_notif(ctx);
+		if (!notif)
+			return -ENOMEM;
+		notif->cqe.user_data = req->cqe.user_data;
+		notif->cqe.res = 0;
+		notif->cqe.flags = IORING_CQE_F_NOTIF;
+	}
 	req->flags |= REQ_F_NEED_CLEANUP;
 	if (zc->flags & IORING_RECVSEND_FIXED_BUF) {
 		unsigned idx = READ_ONCE(sqe->buf_index);
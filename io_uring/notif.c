@@ -13,11 +13,10 @@ static void __io_notif_complete_tw(struct io_kiocb *notif, bool *locked)
 {
 	struct io_notif_data *nd = io_notif_to_data(notif);
 	struct io_ring_ctx *ctx = notif->ctx;
+	unsigned long account_pages = atomic_long_xchg(&nd->account_pages, 0);
 
-	if (nd->account_pages && ctx->user) {
-		__io_unaccount_mem(ctx->user, nd->account_pages);
-		nd->account_pages = 0;
-	}
+	if (account_pages && ctx->user)
+		__io_unaccount_mem(ctx->user, account_pages);
 
 	if (nd->zc_report && (nd->zc_copied || !nd->zc_used))
 		notif->cqe.res |= IORING_NOTIF_USAGE_ZC_COPIED;
@@ -63,7 +62,7 @@ struct io_kiocb *io_alloc_notif(struct io_ring_ctx *ctx)
 	io_req_set_rsrc_node(notif, ctx, 0);
 
 	nd = io_notif_to_data(notif);
-	nd->account_pages = 0;
+	atomic_long_set(&nd->account_pages, 0);
 	nd->uarg.flags = SKBFL_ZEROCOPY_FRAG | SKBFL_DONT_ORPHAN;
 	nd->uarg.callback = io_uring_tx_zerocopy_callback;
 	nd->zc_report = nd->zc_used = nd->zc_copied = false;
@@ -71,6 +70,50 @@ struct io_kiocb *io_alloc_notif(struct io_ring_ctx *ctx)
 	return notif;
 }
 
+/*
+ * Zerocopy sends of one submission with IORING_SEND_ZC_BATCH_NOTIF share a
+ * notification, which holds an extra reference until the end of the
+ * submission. The notification is posted once all of them released their
+ * buffers and cqe.res counts them. A change of the registered resources
+ * starts a new batch, the notification pins the node of its buffers.
+ */
+struct io_kiocb *io_alloc_notif_batch(struct io_kiocb *req)
+	__must_hold(&req->ctx->uring_lock)
+{
+	struct io_ring_ctx *ctx = req->ctx;
+	struct io_submit_state *state = &ctx->submit_state;
+	struct io_kiocb *notif = state->zc_notif;
+
+	if (notif && notif->rsrc_node == ctx->rsrc_node) {
+		refcount_inc(&io_notif_to_data(notif)->uarg.refcnt);
+		notif->cqe.res++;
+		return notif;
+	}
+
+	io_notif_batch_flush(ctx);
+	notif = io_alloc_notif(ctx);
+	if (!notif)
+		return NULL;
+	notif->cqe.user_data = req->cqe.user_data;
+	notif->cqe.res = 1;
+	notif->cqe.flags = IORING_CQE_F_NOTIF;
+	/* batch's ref, dropped by io_notif_batch_flush() */
+	refcount_inc(&io_notif_to_data(notif)->uarg.refcnt);
+	state->zc_notif = notif;
+	return notif;
+}
+
+void io_notif_batch_flush(struct io_ring_ctx *ctx)
+	__must_hold(&ctx->uring_lock)
+{
+	struct io_submit_state *state = &ctx->submit_state;
+
+	if (state->zc_notif) {
+		io_notif_flush(state->zc_notif);
+		state->zc_notif = NULL;
+	}
+}
+
 void io_notif_flush(struct io_kiocb *notif)
 	__must_hold(&slot->notif->ctx->uring_lock)
 {
@@ -12,7 +12,8 @@
 struct io_notif_data {
 	struct file		*file;
 	struct ubuf_info	uarg;
-	unsigned long		account_pages;
+	/* zerocopy sends of a batch may account from io-wq concurrently */
+	atomic_long_t		account_pages;
 	bool			zc_report;
 	bool			zc_used;
 	bool			zc_copied;
@@ -20,6 +21,8 @@ struct io_notif_data {
 
 void io_notif_flush(struct io_kiocb *notif);
 struct io_kiocb *io_alloc_notif(struct io_ring_ctx *ctx);
+struct io_kiocb *io_alloc_notif_batch(struct io_kiocb *req);
+void io_notif_batch_flush(struct io_ring_ctx *ctx);
 
 static inline struct io_notif_data *io_notif_to_data(struct io_kiocb *notif)
 {
@@ -37,7 +40,7 @@ static inline int io_notif_account_mem(struct io_kiocb *notif, unsigned len)
 		ret = __io_account_mem(ctx->user, nr_pages);
 		if (ret)
 			return ret;
-		nd->account_pages += nr_pages;
+		atomic_long_add(nr_pages, &nd->account_pages);
 	}
 	return 0;
 }
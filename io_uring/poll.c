@@ -51,6 +51,9 @@ struct io_poll_table {
 
 #define IO_WQE_F_DOUBLE		1
 
+/* spurious wakeups a read may take before it's punted to io-wq */
+#define IO_APOLL_MAX_REPOLLS	4
+
 static inline struct io_kiocb *wqe_to_req(struct wait_queue_entry *wqe)
 {
 	unsigned long priv = (unsigned long)wqe->private;
@@ -659,16 +662,38 @@ static struct async_poll *io_req_alloc_apoll(struct io_kiocb *req,
 	} else if (!(issue_flags & IO_URING_F_UNLOCKED) &&
 		   (entry = io_alloc_cache_get(&ctx->apoll_cache)) != NULL) {
 		apoll = container_of(entry, struct async_poll, cache);
+		apoll->nr_repolls = 0;
 	} else {
 		apoll = kmalloc(sizeof(*apoll), GFP_ATOMIC);
 		if (unlikely(!apoll))
 			return NULL;
+		apoll->nr_repolls = 0;
 	}
 	apoll->double_poll = NULL;
 	req->apoll = apoll;
 	return apoll;
 }
 
+/*
+ * A read that got -EAGAIN after its poll fired normally lost the data to
+ * another reader, e.g. several rings sharing a pipe. Waiting for the next
+ * wakeup is much cheaper than blocking an io-wq worker on it, so give it a
+ * few more trips through poll before punting. Only done inline, a request
+ * already running in io-wq has paid for the punt.
+ */
+static bool io_apoll_can_repoll(struct io_kiocb *req, unsigned issue_flags)
+{
+	const struct io_op_def *def = &io_op_defs[req->opcode];
+
+	if (!def->pollin || (issue_flags & IO_URING_F_UNLOCKED))
+		return false;
+	if (req->apoll->nr_repolls >= IO_APOLL_MAX_REPOLLS)
+		return false;
+	req->apoll->nr_repolls++;
+	req->ctx->apoll_repolls++;
+	return true;
+}
+
 int io_arm_poll_handler(struct io_kiocb *req, unsigned issue_flags)
 {
 	const struct io_op_def *def = &io_op_defs[req->opcode];
@@ -687,7 +712,8 @@ int io_arm_poll_handler(struct io_kiocb *req, unsigned issue_flags)
 		return IO_APOLL_ABORTED;
 	if (!file_can_poll(req->file))
 		return IO_APOLL_ABORTED;
-	if ((req->flags & (REQ_F_POLLED|REQ_F_PARTIAL_IO)) == REQ_F_POLLED)
+	if ((req->flags & (REQ_F_POLLED|REQ_F_PARTIAL_IO)) == REQ_F_POLLED &&
+	    !io_apoll_can_repoll(req, issue_flags))
 		return IO_APOLL_ABORTED;
 	if (!(req->flags & REQ_F_APOLL_MULTISHOT))
 		mask |= EPOLLONESHOT;
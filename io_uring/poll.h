@@ -21,6 +21,8 @@ struct async_poll {
 		struct io_cache_entry	cache;
 	};
 	struct io_poll		*double_poll;
+	/* extra trips through poll after a spurious wakeup */
+	unsigned int		nr_repolls;
 };
 
 int io_poll_add_prep(struct io_kiocb *req, const struct io_uring_sqe *sqe);
@@ -1310,6 +1310,8 @@ int io_import_fixed(int ddir, struct iov_iter *iter,
 			   struct io_mapped_ubuf *imu,
 			   u64 buf_addr, size_t len)
 {
+	const struct bio_vec *bvec;
+	unsigned long seg, nr_segs;
 	u64 buf_end;
 	size_t offset;
 
@@ -1322,46 +1324,39 @@ int io_import_fixed(int ddir, struct iov_iter *iter,
 		return -EFAULT;
 
 	/*
-	 * May not be a start of buffer, set size appropriately
-	 * and advance us to the beginning.
+	 * May not be a start of buffer, find the segment holding buf_addr.
+	 *
+	 * Don't use iov_iter_advance() here, as it's really slow for using the
+	 * latter parts of a big fixed buffer - it iterates over each segment
+	 * manually. We can cheat a bit here, because we know that:
+	 *
+	 * 1) it's a BVEC iter, we set it up
+	 * 2) all bvecs are PAGE_SIZE in size, except potentially the
+	 *    first and last bvec
+	 *
+	 * So just find our index, and start the iterator there.
 	 */
 	offset = buf_addr - imu->ubuf;
-	iov_iter_bvec(iter, ddir, imu->bvec, imu->nr_bvecs, offset + len);
-
-	if (offset) {
-		/*
-		 * Don't use iov_iter_advance() here, as it's really slow for
-		 * using the latter parts of a big fixed buffer - it iterates
-		 * over each segment manually. We can cheat a bit here, because
-		 * we know that:
-		 *
-		 * 1) it's a BVEC iter, we set it up
-		 * 2) all bvecs are PAGE_SIZE in size, except potentially the
-		 *    first and last bvec
-		 *
-		 * So just find our index, and adjust the iterator afterwards.
-		 * If the offset is within the first bvec (or the whole first
-		 * bvec, just use iov_iter_advance(). This makes it easier
-		 * since we can just skip the first segment, which may not
-		 * be PAGE_SIZE aligned.
-		 */
-		const struct bio_vec *bvec = imu->bvec;
-
-		if (offset <= bvec->bv_len) {
-			iov_iter_advance(iter, offset);
-		} else {
-			unsigned long seg_skip;
+	bvec = imu->bvec;
+	if (offset < bvec->bv_len) {
+		seg = 0;
+	} else {
+		/* skip first vec */
+		offset -= bvec->bv_len;
+		seg = 1 + (offset >> PAGE_SHIFT);
+		offset &= ~PAGE_MASK;
+	}
 
-			/* skip first vec */
-			offset -= bvec->bv_len;
-			seg_skip = 1 + (offset >> PAGE_SHIFT);
+	/*
+	 * Small I/O usually fits in a single segment, hand out a one segment
+	 * iterator so the layers below don't walk the rest of the buffer.
+	 */
+	nr_segs = imu->nr_bvecs - seg;
+	if (nr_segs && offset + len <= bvec[seg].bv_len)
+		nr_segs = 1;
 
-			iter->bvec = bvec + seg_skip;
-			iter->nr_segs -= seg_skip;
-			iter->count -= bvec->bv_len + offset;
-			iter->iov_offset = offset & ~PAGE_MASK;
-		}
-	}
+	iov_iter_bvec(iter, ddir, bvec + seg, nr_segs, len);
+	iter->iov_offset = offset;
 
 	return 0;
 }
@@ -280,7 +280,7 @@ static FORCE_INLINE int LZ4_decompress_generic(
 				break;
 		} else {
 			/* may overwrite up to WILDCOPYLENGTH beyond cpy */
-			LZ4_wildCopy(op, ip, cpy);
+			LZ4_wildCopy16(op, ip, cpy);
 			ip += length;
 			op = cpy;
 		}
@@ -435,6 +435,9 @@ static FORCE_INLINE int LZ4_decompress_generic(
 			}
 			while (op < cpy)
 				*op++ = *match++;
+		} else if (op - match >= 16) {
+			/* no overlap within a 16-byte step */
+			LZ4_wildCopy16(op, match, cpy);
 		} else {
 			LZ4_copy8(op, match);
 			if (length > 16)
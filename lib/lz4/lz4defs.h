@@ -183,6 +183,52 @@ static FORCE_INLINE void LZ4_wildCopy(void *dstPtr,
 	} while (d < e);
 }
 
+/*
+ * copy 16 bytes, all loads are done before any store so that it stays correct
+ * when dst is below src, as in in-place decompression
+ */
+static FORCE_INLINE void LZ4_copy16(void *dst, const void *src)
+{
+#if LZ4_ARCH64
+	U64 a = get_unaligned((const U64 *)src);
+	U64 b = get_unaligned((const U64 *)src + 1);
+
+	put_unaligned(a, (U64 *)dst);
+	put_unaligned(b, (U64 *)dst + 1);
+#else
+	U32 a = get_unaligned((const U32 *)src);
+	U32 b = get_unaligned((const U32 *)src + 1);
+	U32 c = get_unaligned((const U32 *)src + 2);
+	U32 d = get_unaligned((const U32 *)src + 3);
+
+	put_unaligned(a, (U32 *)dst);
+	put_unaligned(b, (U32 *)dst + 1);
+	put_unaligned(c, (U32 *)dst + 2);
+	put_unaligned(d, (U32 *)dst + 3);
+#endif
+}
+
+/*
+ * variant of LZ4_wildCopy() moving 16 bytes per iteration,
+ * which can overwrite up to 7 bytes beyond dstEnd as well.
+ * src must not be within 16 bytes below dst.
+ */
+static FORCE_INLINE void LZ4_wildCopy16(void *dstPtr,
+	const void *srcPtr, void *dstEnd)
+{
+	BYTE *d = (BYTE *)dstPtr;
+	const BYTE *s = (const BYTE *)srcPtr;
+	BYTE *const e = (BYTE *)dstEnd;
+
+	while (e - d > 8) {
+		LZ4_copy16(d, s);
+		d += 16;
+		s += 16;
+	}
+	if (d < e)
+		LZ4_copy8(d, s);
+}
+
 static FORCE_INLINE unsigned int LZ4_NbCommonBytes(register size_t val)
 {
 #if LZ4_LITTLE_ENDIAN
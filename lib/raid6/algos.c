@@ -105,11 +105,29 @@ const struct raid6_recov_calls *const raid6_recov_algos[] = {
 #endif
 #if defined(CONFIG_KERNEL_MODE_NEON)
 	&raid6_recov_neon,
+	&raid6_recov_neonx2,
 #endif
 	&raid6_recov_intx1,
 	NULL
 };
 
+#ifdef __KERNEL__
+/*
+ * Use the named algorithm instead of benchmarking at boot, e.g. the one
+ * reported by an earlier boot with raid6_pq.gen=neonx4 raid6_pq.recov=neon.
+ */
+static char raid6_gen_name[16];
+module_param_string(gen, raid6_gen_name, sizeof(raid6_gen_name), 0444);
+MODULE_PARM_DESC(gen, "gen_syndrome algorithm to use, skips the benchmark");
+
+static char raid6_recov_name[16];
+module_param_string(recov, raid6_recov_name, sizeof(raid6_recov_name), 0444);
+MODULE_PARM_DESC(recov, "recovery algorithm to use, skips the benchmark");
+#else
+static char raid6_gen_name[1];
+static char raid6_recov_name[1];
+#endif
+
 #ifdef __KERNEL__
 #define RAID6_TIME_JIFFIES_LG2	4
 #else
@@ -121,15 +139,83 @@ const struct raid6_recov_calls *const raid6_recov_algos[] = {
 #define RAID6_TEST_DISKS	8
 #define RAID6_TEST_DISKS_ORDER	3
 
-static inline const struct raid6_recov_calls *raid6_choose_recov(void)
+static const struct raid6_recov_calls *raid6_find_recov(const char *name)
 {
 	const struct raid6_recov_calls *const *algo;
-	const struct raid6_recov_calls *best;
 
-	for (best = NULL, algo = raid6_recov_algos; *algo; algo++)
-		if (!best || (*algo)->priority > best->priority)
-			if (!(*algo)->valid || (*algo)->valid())
-				best = *algo;
+	for (algo = raid6_recov_algos; *algo; algo++)
+		if (!strcmp((*algo)->name, name) &&
+		    (!(*algo)->valid || (*algo)->valid()))
+			return *algo;
+
+	pr_warn("raid6: recovery algorithm %s not available\n", name);
+	return NULL;
+}
+
+/* Benchmark the recovery algorithms with the same priority as @best */
+static const struct raid6_recov_calls *raid6_bench_recov(
+	const struct raid6_recov_calls *best,
+	void *(*const dptrs)[RAID6_TEST_DISKS], const int disks)
+{
+	const struct raid6_recov_calls *const *algo;
+	unsigned long perf, bestperf = 0, j0, j1;
+	int nr = 0;
+
+	for (algo = raid6_recov_algos; *algo; algo++)
+		if ((*algo)->priority == best->priority &&
+		    (!(*algo)->valid || (*algo)->valid()))
+			nr++;
+	if (nr < 2)
+		return best;
+
+	for (algo = raid6_recov_algos; *algo; algo++) {
+		if ((*algo)->priority != best->priority ||
+		    ((*algo)->valid && !(*algo)->valid()))
+			continue;
+
+		perf = 0;
+
+		preempt_disable();
+		j0 = jiffies;
+		while ((j1 = jiffies) == j0)
+			cpu_relax();
+		while (time_before(jiffies,
+				   j1 + (1 << RAID6_TIME_JIFFIES_LG2))) {
+			(*algo)->data2(disks, PAGE_SIZE, 0, 1, *dptrs);
+			perf++;
+		}
+		preempt_enable();
+
+		if (perf > bestperf) {
+			bestperf = perf;
+			best = *algo;
+		}
+		pr_info("raid6: %-8s recov() %5ld MB/s\n", (*algo)->name,
+			(perf * HZ * (disks - 2)) >>
+			(20 - PAGE_SHIFT + RAID6_TIME_JIFFIES_LG2));
+	}
+
+	return best;
+}
+
+static inline const struct raid6_recov_calls *raid6_choose_recov(
+	void *(*const dptrs)[RAID6_TEST_DISKS], const int disks)
+{
+	const struct raid6_recov_calls *const *algo;
+	const struct raid6_recov_calls *best = NULL;
+
+	if (raid6_recov_name[0])
+		best = raid6_find_recov(raid6_recov_name);
+
+	if (!best) {
+		for (algo = raid6_recov_algos; *algo; algo++)
+			if (!best || (*algo)->priority > best->priority)
+				if (!(*algo)->valid || (*algo)->valid())
+					best = *algo;
+
+		if (best && IS_ENABLED(CONFIG_RAID6_PQ_BENCHMARK))
+			best = raid6_bench_recov(best, dptrs, disks);
+	}
 
 	if (best) {
 		raid6_2data_recov = best->data2;
@@ -142,6 +228,19 @@ static inline const struct raid6_recov_calls *raid6_choose_recov(void)
 	return best;
 }
 
+static const struct raid6_calls *raid6_find_gen(const char *name)
+{
+	const struct raid6_calls *const *algo;
+
+	for (algo = raid6_algos; *algo; algo++)
+		if (!strcmp((*algo)->name, name) &&
+		    (!(*algo)->valid || (*algo)->valid()))
+			return *algo;
+
+	pr_warn("raid6: algorithm %s not available\n", name);
+	return NULL;
+}
+
 static inline const struct raid6_calls *raid6_choose_gen(
 	void *(*const dptrs)[RAID6_TEST_DISKS], const int disks)
 {
@@ -150,6 +249,16 @@ static inline const struct raid6_calls *raid6_choose_gen(
 	const struct raid6_calls *const *algo;
 	const struct raid6_calls *best;
 
+	if (raid6_gen_name[0]) {
+		best = raid6_find_gen(raid6_gen_name);
+		if (best) {
+			raid6_call = *best;
+			pr_info("raid6: skipped pq benchmark and selected %s\n",
+				best->name);
+			return best;
+		}
+	}
+
 	for (bestgenperf = 0, best = NULL, algo = raid6_algos; *algo; algo++) {
 		if (!best || (*algo)->priority >= best->priority) {
 			if ((*algo)->valid && !(*algo)->valid())
@@ -262,8 +371,8 @@ int __init raid6_select_algo(void)
 	/* select raid gen_syndrome function */
 	gen_best = raid6_choose_gen(&dptrs, disks);
 
-	/* select raid recover functions */
-	rec_best = raid6_choose_recov();
+	/* select raid recover functions, the benchmark relies on gen */
+	rec_best = gen_best ? raid6_choose_recov(&dptrs, disks) : NULL;
 
 	free_pages((unsigned long)disk_ptr, RAID6_TEST_DISKS_ORDER);
 
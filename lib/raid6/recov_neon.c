@@ -26,8 +26,21 @@ void __raid6_2data_recov_neon(int bytes, uint8_t *p, uint8_t *q, uint8_t *dp,
 void __raid6_datap_recov_neon(int bytes, uint8_t *p, uint8_t *q, uint8_t *dq,
 			      const uint8_t *qmul);
 
-static void raid6_2data_recov_neon(int disks, size_t bytes, int faila,
-		int failb, void **ptrs)
+void __raid6_2data_recov_neon2(int bytes, uint8_t *p, uint8_t *q, uint8_t *dp,
+			       uint8_t *dq, const uint8_t *pbmul,
+			       const uint8_t *qmul);
+
+void __raid6_datap_recov_neon2(int bytes, uint8_t *p, uint8_t *q, uint8_t *dq,
+			       const uint8_t *qmul);
+
+typedef void (*raid6_2data_recov_fn)(int, uint8_t *, uint8_t *, uint8_t *,
+				     uint8_t *, const uint8_t *,
+				     const uint8_t *);
+typedef void (*raid6_datap_recov_fn)(int, uint8_t *, uint8_t *, uint8_t *,
+				     const uint8_t *);
+
+static void raid6_2data_recov_common(int disks, size_t bytes, int faila,
+		int failb, void **ptrs, raid6_2data_recov_fn recov)
 {
 	u8 *p, *q, *dp, *dq;
 	const u8 *pbmul;	/* P multiplier table for B data */
@@ -62,12 +75,12 @@ static void raid6_2data_recov_neon(int disks, size_t bytes, int faila,
 					 raid6_gfexp[failb]]];
 
 	kernel_neon_begin();
-	__raid6_2data_recov_neon(bytes, p, q, dp, dq, pbmul, qmul);
+	recov(bytes, p, q, dp, dq, pbmul, qmul);
 	kernel_neon_end();
 }
 
-static void raid6_datap_recov_neon(int disks, size_t bytes, int faila,
-		void **ptrs)
+static void raid6_datap_recov_common(int disks, size_t bytes, int faila,
+		void **ptrs, raid6_datap_recov_fn recov)
 {
 	u8 *p, *q, *dq;
 	const u8 *qmul;		/* Q multiplier table */
@@ -93,10 +106,24 @@ static void raid6_datap_recov_neon(int disks, size_t bytes, int faila,
 	qmul = raid6_vgfmul[raid6_gfinv[raid6_gfexp[faila]]];
 
 	kernel_neon_begin();
-	__raid6_datap_recov_neon(bytes, p, q, dq, qmul);
+	recov(bytes, p, q, dq, qmul);
 	kernel_neon_end();
 }
 
+static void raid6_2data_recov_neon(int disks, size_t bytes, int faila,
+		int failb, void **ptrs)
+{
+	raid6_2data_recov_common(disks, bytes, faila, failb, ptrs,
+				 __raid6_2data_recov_neon);
+}
+
+static void raid6_datap_recov_neon(int disks, size_t bytes, int faila,
+		void **ptrs)
+{
+	raid6_datap_recov_common(disks, bytes, faila, ptrs,
+				 __raid6_datap_recov_neon);
+}
+
 const struct raid6_recov_calls raid6_recov_neon = {
 	.data2		= raid6_2data_recov_neon,
 	.datap		= raid6_datap_recov_neon,
@@ -104,3 +131,26 @@ const struct raid6_recov_calls raid6_recov_neon = {
 	.name		= "neon",
 	.priority	= 10,
 };
+
+static void raid6_2data_recov_neon2(int disks, size_t bytes, int faila,
+		int failb, void **ptrs)
+{
+	raid6_2data_recov_common(disks, bytes, faila, failb, ptrs,
+				 __raid6_2data_recov_neon2);
+}
+
+static void raid6_datap_recov_neon2(int disks, size_t bytes, int faila,
+		void **ptrs)
+{
+	raid6_datap_recov_common(disks, bytes, faila, ptrs,
+				 __raid6_datap_recov_neon2);
+}
+
+/* Interleaves two vectors, for in-order cores, picked by the benchmark */
+const struct raid6_recov_calls raid6_recov_neonx2 = {
+	.data2		= raid6_2data_recov_neon2,
+	.datap		= raid6_datap_recov_neon2,
+	.valid		= raid6_has_neon,
+	.name		= "neonx2",
+	.priority	= 10,
+};
@@ -108,3 +108,89 @@ void __raid6_datap_recov_neon(int bytes, uint8_t *p, uint8_t *q, uint8_t *dq,
 		dq += 16;
 	}
 }
+
+/*
+ * The variants below work on two independent 16 byte vectors per iteration.
+ * In-order cores like the Cortex-A53 can't look past the dependency chain
+ * of a single table lookup, interleaving a second chain hides its latency.
+ * All loads of an iteration are issued before any store, as the buffers may
+ * alias and the compiler could not reorder them otherwise.
+ */
+static inline uint8x16_t raid6_neon_gfmul(uint8x16_t v, uint8x16_t m0,
+					  uint8x16_t m1, uint8x16_t x0f)
+{
+	return veorq_u8(vqtbl1q_u8(m0, vandq_u8(v, x0f)),
+			vqtbl1q_u8(m1, vshrq_n_u8(v, 4)));
+}
+
+void __raid6_2data_recov_neon2(int bytes, uint8_t *p, uint8_t *q, uint8_t *dp,
+			       uint8_t *dq, const uint8_t *pbmul,
+			       const uint8_t *qmul)
+{
+	uint8x16_t pm0 = vld1q_u8(pbmul);
+	uint8x16_t pm1 = vld1q_u8(pbmul + 16);
+	uint8x16_t qm0 = vld1q_u8(qmul);
+	uint8x16_t qm1 = vld1q_u8(qmul + 16);
+	uint8x16_t x0f = vdupq_n_u8(0x0f);
+
+	while (bytes >= 32) {
+		uint8x16_t px0, px1, qx0, qx1, db0, db1;
+
+		px0 = veorq_u8(vld1q_u8(p), vld1q_u8(dp));
+		px1 = veorq_u8(vld1q_u8(p + 16), vld1q_u8(dp + 16));
+		qx0 = veorq_u8(vld1q_u8(q), vld1q_u8(dq));
+		qx1 = veorq_u8(vld1q_u8(q + 16), vld1q_u8(dq + 16));
+
+		qx0 = raid6_neon_gfmul(qx0, qm0, qm1, x0f);
+		qx1 = raid6_neon_gfmul(qx1, qm0, qm1, x0f);
+		db0 = veorq_u8(raid6_neon_gfmul(px0, pm0, pm1, x0f), qx0);
+		db1 = veorq_u8(raid6_neon_gfmul(px1, pm0, pm1, x0f), qx1);
+
+		vst1q_u8(dq, db0);
+		vst1q_u8(dq + 16, db1);
+		vst1q_u8(dp, veorq_u8(db0, px0));
+		vst1q_u8(dp + 16, veorq_u8(db1, px1));
+
+		bytes -= 32;
+		p += 32;
+		q += 32;
+		dp += 32;
+		dq += 32;
+	}
+
+	if (bytes)
+		__raid6_2data_recov_neon(bytes, p, q, dp, dq, pbmul, qmul);
+}
+
+void __raid6_datap_recov_neon2(int bytes, uint8_t *p, uint8_t *q, uint8_t *dq,
+			       const uint8_t *qmul)
+{
+	uint8x16_t qm0 = vld1q_u8(qmul);
+	uint8x16_t qm1 = vld1q_u8(qmul + 16);
+	uint8x16_t x0f = vdupq_n_u8(0x0f);
+
+	while (bytes >= 32) {
+		uint8x16_t vx0, vx1, p0, p1;
+
+		vx0 = veorq_u8(vld1q_u8(q), vld1q_u8(dq));
+		vx1 = veorq_u8(vld1q_u8(q + 16), vld1q_u8(dq + 16));
+		p0 = vld1q_u8(p);
+		p1 = vld1q_u8(p + 16);
+
+		vx0 = raid6_neon_gfmul(vx0, qm0, qm1, x0f);
+		vx1 = raid6_neon_gfmul(vx1, qm0, qm1, x0f);
+
+		vst1q_u8(dq, vx0);
+		vst1q_u8(dq + 16, vx1);
+		vst1q_u8(p, veorq_u8(vx0, p0));
+		vst1q_u8(p + 16, veorq_u8(vx1, p1));
+
+		bytes -= 32;
+		p += 32;
+		q += 32;
+		dq += 32;
+	}
+
+	if (bytes)
+		__raid6_datap_recov_neon(bytes, p, q, dq, qmul);
+}
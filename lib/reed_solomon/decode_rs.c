@@ -61,28 +61,45 @@
 	for (i = 0; i < nroots; i++)
 		syn[i] = (((uint16_t) data[0]) ^ invmsk) & msk;
 
-	for (j = 1; j < len; j++) {
-		for (i = 0; i < nroots; i++) {
-			if (syn[i] == 0) {
-				syn[i] = (((uint16_t) data[j]) ^
-					  invmsk) & msk;
-			} else {
-				syn[i] = ((((uint16_t) data[j]) ^
-					   invmsk) & msk) ^
-					alpha_to[rs_modnn(rs, index_of[syn[i]] +
-						       (fcr + i) * prim)];
+	if (rs->syn_mul) {
+		/* Multiply by the roots with one table lookup each */
+		int tsize = nn + 1;
+
+		for (j = 1; j < len; j++) {
+			u = (((uint16_t) data[j]) ^ invmsk) & msk;
+			for (i = 0; i < nroots; i++)
+				syn[i] = u ^ rs->syn_mul[i * tsize + syn[i]];
+		}
+
+		for (j = 0; j < nroots; j++) {
+			u = ((uint16_t) par[j]) & msk;
+			for (i = 0; i < nroots; i++)
+				syn[i] = u ^ rs->syn_mul[i * tsize + syn[i]];
+		}
+	} else {
+		for (j = 1; j < len; j++) {
+			for (i = 0; i < nroots; i++) {
+				if (syn[i] == 0) {
+					syn[i] = (((uint16_t) data[j]) ^
+						  invmsk) & msk;
+				} else {
+					syn[i] = ((((uint16_t) data[j]) ^
+						   invmsk) & msk) ^
+						alpha_to[rs_modnn(rs, index_of[syn[i]] +
+							       (fcr + i) * prim)];
+				}
 			}
 		}
-	}
 
-	for (j = 0; j < nroots; j++) {
-		for (i = 0; i < nroots; i++) {
-			if (syn[i] == 0) {
-				syn[i] = ((uint16_t) par[j]) & msk;
-			} else {
-				syn[i] = (((uint16_t) par[j]) & msk) ^
-					alpha_to[rs_modnn(rs, index_of[syn[i]] +
-						       (fcr+i)*prim)];
+		for (j = 0; j < nroots; j++) {
+			for (i = 0; i < nroots; i++) {
+				if (syn[i] == 0) {
+					syn[i] = ((uint16_t) par[j]) & msk;
+				} else {
+					syn[i] = (((uint16_t) par[j]) & msk) ^
+						alpha_to[rs_modnn(rs, index_of[syn[i]] +
+							       (fcr+i)*prim)];
+				}
 			}
 		}
 	}
@@ -201,8 +218,13 @@
 		q = 1;		/* lambda[0] is always 0 */
 		for (j = deg_lambda; j > 0; j--) {
 			if (reg[j] != nn) {
-				reg[j] = rs_modnn(rs, reg[j] + j);
-				q ^= alpha_to[reg[j]];
+				/* reg[j] < nn and j <= nroots < nn */
+				int x = reg[j] + j;
+
+				if (x >= nn)
+					x -= nn;
+				reg[j] = x;
+				q ^= alpha_to[x];
 			}
 		}
 		if (q != 0)
@@ -51,6 +51,9 @@ enum {
 
 /* This list holds all currently allocated rs codec structures */
 static LIST_HEAD(codec_list);
+
+/* Largest number of root multiplication table entries of a codec */
+#define RS_SYN_MUL_MAX		16384
 /* Protection for the list */
 static DEFINE_MUTEX(rslistlock);
 
@@ -152,11 +155,36 @@ static struct rs_codec *codec_init(int symsize, int gfpoly, int (*gffunc)(int),
 	for (i = 0; i <= nroots; i++)
 		rs->genpoly[i] = rs->index_of[rs->genpoly[i]];
 
+	/*
+	 * Tables to multiply a symbol in poly form by each root of the
+	 * generator polynomial, which saves the syndrome calculation two
+	 * lookups and a reduction per root and symbol. Large fields don't
+	 * get them, the tables would not stay in the cache anyway.
+	 */
+	if (nroots * (rs->nn + 1) <= RS_SYN_MUL_MAX) {
+		uint16_t *tab;
+
+		rs->syn_mul = kmalloc_array(nroots * (rs->nn + 1),
+					    sizeof(uint16_t), gfp);
+		if (!rs->syn_mul)
+			goto err;
+
+		for (i = 0, tab = rs->syn_mul; i < nroots; i++) {
+			root = rs_modnn(rs, (fcr + i) * prim);
+			tab[0] = 0;
+			for (j = 1; j <= rs->nn; j++)
+				tab[j] = rs->alpha_to[rs_modnn(rs,
+						rs->index_of[j] + root)];
+			tab += rs->nn + 1;
+		}
+	}
+
 	rs->users = 1;
 	list_add(&rs->list, &codec_list);
 	return rs;
 
 err:
+	kfree(rs->syn_mul);
 	kfree(rs->genpoly);
 	kfree(rs->index_of);
 	kfree(rs->alpha_to);
@@ -188,6 +216,7 @@ void free_rs(struct rs_control *rs)
 		kfree(cd->alpha_to);
 		kfree(cd->index_of);
 		kfree(cd->genpoly);
+		kfree(cd->syn_mul);
 		kfree(cd);
 	}
 	mutex_unlock(&rslistlock);
@@ -7,6 +7,8 @@
  */
 #include <linux/rslib.h>
 #include <linux/kernel.h>
+#include <linux/ktime.h>
+#include <linux/math64.h>
 #include <linux/module.h>
 #include <linux/moduleparam.h>
 #include <linux/random.h>
@@ -32,6 +34,7 @@ enum method {
 __param(int, v, V_PROGRESS, "Verbosity level");
 __param(int, ewsc, 1, "Erasures without symbol corruption");
 __param(int, bc, 1, "Test for correct behaviour beyond error correction capacity");
+__param(int, bench, 0, "Measure the decoding time of error free words");
 
 struct etab {
 	int	symsize;
@@ -439,6 +442,25 @@ static int exercise_rs_bc(struct rs_control *rs, struct wspace *ws,
 	return stat.noncw;
 }
 
+/* Time the common case of a word without errors */
+static void bench_rs(struct rs_control *rs, struct wspace *ws,
+		     int len, int trials)
+{
+	int dlen = len - rs->codec->nroots;
+	uint16_t *r = ws->r;
+	u64 start, ns;
+	int j;
+
+	get_rcw_we(rs, ws, len, 0, 0);
+
+	start = ktime_get_ns();
+	for (j = 0; j < trials; j++)
+		decode_rs16(rs, r, r + dlen, dlen, NULL, 0, NULL, 0, NULL);
+	ns = ktime_get_ns() - start;
+
+	pr_info("  error free decode: %llu ns/word\n", div_u64(ns, trials));
+}
+
 static int run_exercise(struct etab *e)
 {
 	int nn = (1 << e->symsize) - 1;
@@ -475,6 +497,8 @@ static int run_exercise(struct etab *e)
 		retval |= exercise_rs(rsc, ws, len, e->ntrials);
 		if (bc)
 			retval |= exercise_rs_bc(rsc, ws, len, e->ntrials);
+		if (bench)
+			bench_rs(rsc, ws, len, e->ntrials);
 	}
 
 	free_ws(ws);
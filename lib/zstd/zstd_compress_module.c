@@ -9,9 +9,15 @@
  * You may select, at your option, one of the above-listed licenses.
  */
 
+#include <linux/cpumask.h>
 #include <linux/kernel.h>
+#include <linux/mm.h>
 #include <linux/module.h>
+#include <linux/sizes.h>
+#include <linux/slab.h>
 #include <linux/string.h>
+#include <linux/wait.h>
+#include <linux/workqueue.h>
 #include <linux/zstd.h>
 
 #include "common/zstd_deps.h"
@@ -101,6 +107,136 @@ size_t zstd_compress_cctx(zstd_cctx *cctx, void *dst, size_t dst_capacity,
 }
 EXPORT_SYMBOL(zstd_compress_cctx);
 
+/* State shared by the workers of one zstd_compress_parallel() call */
+struct zstd_parallel {
+	const void *src;
+	size_t src_size;
+	size_t chunk_size;
+	unsigned int nr_chunks;
+	const zstd_parameters *parameters;
+	size_t workspace_size;
+	size_t out_size;
+	/* next chunk to be compressed */
+	atomic_t next_chunk;
+	/* next chunk to be copied to dst, and where */
+	unsigned int next_write;
+	void *dst;
+	size_t dst_capacity;
+	size_t dst_pos;
+	/* first error hit by any worker */
+	size_t err;
+	wait_queue_head_t wait;
+};
+
+struct zstd_parallel_worker {
+	struct work_struct work;
+	struct zstd_parallel *zp;
+};
+
+/*
+ * Each worker claims chunks in order, compresses them into its own buffer and
+ * then waits for its turn to append them to dst. The worker holding the oldest
+ * chunk never waits, so this always makes progress.
+ */
+static void zstd_parallel_run(struct zstd_parallel *zp)
+{
+	void *workspace, *out;
+	zstd_cctx *cctx;
+	unsigned int i;
+	size_t ret;
+
+	workspace = kvmalloc(zp->workspace_size, GFP_KERNEL);
+	out = kvmalloc(zp->out_size, GFP_KERNEL);
+	cctx = zstd_init_cctx(workspace, zp->workspace_size);
+
+	while ((i = atomic_inc_return(&zp->next_chunk) - 1) < zp->nr_chunks) {
+		size_t off = (size_t)i * zp->chunk_size;
+		size_t len = min(zp->chunk_size, zp->src_size - off);
+
+		if (!cctx || !out)
+			ret = ERROR(memory_allocation);
+		else
+			ret = zstd_compress_cctx(cctx, out, zp->out_size,
+						 zp->src + off, len,
+						 zp->parameters);
+
+		wait_event(zp->wait, smp_load_acquire(&zp->next_write) == i ||
+			   READ_ONCE(zp->err));
+		if (READ_ONCE(zp->err))
+			break;
+
+		if (!ZSTD_isError(ret) &&
+		    ret > zp->dst_capacity - zp->dst_pos)
+			ret = ERROR(dstSize_tooSmall);
+		if (ZSTD_isError(ret)) {
+			WRITE_ONCE(zp->err, ret);
+		} else {
+			memcpy(zp->dst + zp->dst_pos, out, ret);
+			zp->dst_pos += ret;
+			/* publish dst_pos before handing over to the next */
+			smp_store_release(&zp->next_write, i + 1);
+		}
+		wake_up_all(&zp->wait);
+	}
+
+	kvfree(out);
+	kvfree(workspace);
+}
+
+static void zstd_parallel_work(struct work_struct *work)
+{
+	struct zstd_parallel_worker *worker =
+		container_of(work, struct zstd_parallel_worker, work);
+
+	zstd_parallel_run(worker->zp);
+}
+
+size_t zstd_compress_parallel(void *dst, size_t dst_capacity, const void *src,
+	size_t src_size, const zstd_parameters *parameters, size_t chunk_size)
+{
+	struct zstd_parallel_worker *workers;
+	struct zstd_parallel zp = {
+		.src = src,
+		.src_size = src_size,
+		.parameters = parameters,
+		.dst = dst,
+		.dst_capacity = dst_capacity,
+		.next_chunk = ATOMIC_INIT(0),
+	};
+	unsigned int nr_workers, i;
+
+	/* Like zstdmt, jobs of a few windows keep the ratio close */
+	if (!chunk_size)
+		chunk_size = max_t(size_t,
+				   4ULL << parameters->cParams.windowLog, SZ_1M);
+	zp.chunk_size = min(chunk_size, max_t(size_t, src_size, 1));
+	zp.nr_chunks = max_t(size_t, DIV_ROUND_UP(src_size, zp.chunk_size), 1);
+	zp.workspace_size = zstd_cctx_workspace_bound(&parameters->cParams);
+	zp.out_size = zstd_compress_bound(zp.chunk_size);
+	init_waitqueue_head(&zp.wait);
+
+	nr_workers = min(num_online_cpus(), zp.nr_chunks);
+	workers = nr_workers > 1 ?
+		kcalloc(nr_workers, sizeof(*workers), GFP_KERNEL) : NULL;
+	if (!workers) {
+		/* A single chunk, or no memory to spread it, do it here */
+		zstd_parallel_run(&zp);
+		return zp.err ?: zp.dst_pos;
+	}
+
+	for (i = 0; i < nr_workers; i++) {
+		INIT_WORK(&workers[i].work, zstd_parallel_work);
+		workers[i].zp = &zp;
+		queue_work(system_unbound_wq, &workers[i].work);
+	}
+	for (i = 0; i < nr_workers; i++)
+		flush_work(&workers[i].work);
+	kfree(workers);
+
+	return zp.err ?: zp.dst_pos;
+}
+EXPORT_SYMBOL(zstd_compress_parallel);
+
 size_t zstd_cstream_workspace_bound(const zstd_compression_parameters *cparams)
 {
 	return ZSTD_estimateCStreamSize_usingCParams(*cparams);
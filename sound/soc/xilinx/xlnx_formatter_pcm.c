@@ -67,6 +67,14 @@
 #define AUD_CTRL_ACTIVE_CH_SHIFT	19
 #define PERIOD_CFG_PERIODS_SHIFT	16
 
+/*
+ * The formatter raises one interrupt per period, there is no coalescing.
+ * With the smallest period of 192 bytes, which is 1 ms of 48 kHz stereo
+ * S16_LE, and two periods the buffering latency of a stream is 2 ms plus
+ * the interrupt latency. Streams opened without period wakeups run with
+ * the period interrupt disabled and are scheduled from a timer by the
+ * application, the pointer is read from the transfer count register.
+ */
 #define PERIODS_MIN		2
 #define PERIODS_MAX		6
 #define PERIOD_BYTES_MIN	192
@@ -105,6 +113,8 @@ struct xlnx_pcm_drv_data {
  * @xfer_mode: data formatting mode during transfer
  * @ch_limit: Maximum channels supported
  * @buffer_size: stream ring buffer size
+ * @periods: number of periods completed since the stream started
+ * @period_tstamp: system time of the last period completion
  */
 struct xlnx_pcm_stream_param {
 	void __iomem *mmio;
@@ -112,12 +122,16 @@ struct xlnx_pcm_stream_param {
 	u32 xfer_mode;
 	u32 ch_limit;
 	u64 buffer_size;
+	u64 periods;
+	struct timespec64 period_tstamp;
 };
 
 static const struct snd_pcm_hardware xlnx_pcm_hardware = {
 	.info = SNDRV_PCM_INFO_INTERLEAVED | SNDRV_PCM_INFO_BLOCK_TRANSFER |
 		SNDRV_PCM_INFO_BATCH | SNDRV_PCM_INFO_PAUSE |
-		SNDRV_PCM_INFO_RESUME,
+		SNDRV_PCM_INFO_RESUME | SNDRV_PCM_INFO_MMAP |
+		SNDRV_PCM_INFO_MMAP_VALID | SNDRV_PCM_INFO_HAS_LINK_ATIME |
+		SNDRV_PCM_INFO_NO_PERIOD_WAKEUP,
 	.formats = SNDRV_PCM_FMTBIT_S8 | SNDRV_PCM_FMTBIT_S16_LE |
 		   SNDRV_PCM_FMTBIT_S24_LE,
 	.channels_min = 2,
@@ -288,6 +302,27 @@ static void xlnx_formatter_disable_irqs(void __iomem *mmio_base, int stream)
 	iowrite32(val, mmio_base + XLNX_AUD_CTRL);
 }
 
+/*
+ * Account a completed period and timestamp it, the timestamp pairs the
+ * system time with the exact stream position at a period boundary.
+ */
+static void xlnx_formatter_period_elapsed(struct snd_pcm_substream *substream)
+{
+	struct snd_pcm_runtime *runtime;
+	struct xlnx_pcm_stream_param *stream_data;
+	unsigned long flags;
+
+	snd_pcm_stream_lock_irqsave(substream, flags);
+	runtime = substream->runtime;
+	if (runtime && runtime->private_data) {
+		stream_data = runtime->private_data;
+		snd_pcm_gettime(runtime, &stream_data->period_tstamp);
+		stream_data->periods++;
+	}
+	snd_pcm_period_elapsed_under_stream_lock(substream);
+	snd_pcm_stream_unlock_irqrestore(substream, flags);
+}
+
 static irqreturn_t xlnx_mm2s_irq_handler(int irq, void *arg)
 {
 	u32 val;
@@ -300,7 +335,7 @@ static irqreturn_t xlnx_mm2s_irq_handler(int irq, void *arg)
 	if (val & AUD_STS_IOC_IRQ_MASK) {
 		iowrite32(val & AUD_STS_IOC_IRQ_MASK, reg);
 		if (adata->play_stream)
-			snd_pcm_period_elapsed(adata->play_stream);
+			xlnx_formatter_period_elapsed(adata->play_stream);
 		return IRQ_HANDLED;
 	}
 
@@ -319,7 +354,7 @@ static irqreturn_t xlnx_s2mm_irq_handler(int irq, void *arg)
 	if (val & AUD_STS_IOC_IRQ_MASK) {
 		iowrite32(val & AUD_STS_IOC_IRQ_MASK, reg);
 		if (adata->capture_stream)
-			snd_pcm_period_elapsed(adata->capture_stream);
+			xlnx_formatter_period_elapsed(adata->capture_stream);
 		return IRQ_HANDLED;
 	}
 
@@ -472,6 +507,38 @@ xlnx_formatter_pcm_pointer(struct snd_soc_component *component,
 	return bytes_to_frames(runtime, pos);
 }
 
+static int
+xlnx_formatter_pcm_get_time_info(struct snd_soc_component *component,
+				 struct snd_pcm_substream *substream,
+				 struct timespec64 *system_ts,
+				 struct timespec64 *audio_ts,
+				 struct snd_pcm_audio_tstamp_config *audio_tstamp_config,
+				 struct snd_pcm_audio_tstamp_report *audio_tstamp_report)
+{
+	struct snd_pcm_runtime *runtime = substream->runtime;
+	struct xlnx_pcm_stream_param *stream_data = runtime->private_data;
+	u64 frames;
+	u32 rem;
+
+	if (audio_tstamp_config->type_requested !=
+	    SNDRV_PCM_AUDIO_TSTAMP_TYPE_LINK || !stream_data->periods) {
+		audio_tstamp_report->actual_type =
+			SNDRV_PCM_AUDIO_TSTAMP_TYPE_DEFAULT;
+		return 0;
+	}
+
+	/* Report the position and time of the last period boundary */
+	frames = stream_data->periods * runtime->period_size;
+	audio_ts->tv_sec = div_u64_rem(frames, runtime->rate, &rem);
+	audio_ts->tv_nsec = div_u64((u64)rem * NSEC_PER_SEC, runtime->rate);
+	*system_ts = stream_data->period_tstamp;
+
+	audio_tstamp_report->actual_type = SNDRV_PCM_AUDIO_TSTAMP_TYPE_LINK;
+	audio_tstamp_report->accuracy_report = 0;
+
+	return 0;
+}
+
 static int xlnx_formatter_pcm_hw_params(struct snd_soc_component *component,
 					struct snd_pcm_substream *substream,
 					struct snd_pcm_hw_params *params)
@@ -596,6 +663,14 @@ static int xlnx_formatter_pcm_trigger(struct snd_soc_component *component,
 
 	switch (cmd) {
 	case SNDRV_PCM_TRIGGER_START:
+		stream_data->periods = 0;
+		val = ioread32(stream_data->mmio + XLNX_AUD_CTRL);
+		if (substream->runtime->no_period_wakeup)
+			val &= ~AUD_CTRL_IOC_IRQ_MASK;
+		else
+			val |= AUD_CTRL_IOC_IRQ_MASK;
+		iowrite32(val, stream_data->mmio + XLNX_AUD_CTRL);
+		fallthrough;
 	case SNDRV_PCM_TRIGGER_PAUSE_RELEASE:
 	case SNDRV_PCM_TRIGGER_RESUME:
 		val = ioread32(stream_data->mmio + XLNX_AUD_CTRL);
@@ -637,6 +712,7 @@ static const struct snd_soc_component_driver xlnx_asoc_component = {
 	.hw_free	= xlnx_formatter_pcm_hw_free,
 	.trigger	= xlnx_formatter_pcm_trigger,
 	.pointer	= xlnx_formatter_pcm_pointer,
+	.get_time_info	= xlnx_formatter_pcm_get_time_info,
 	.pcm_construct	= xlnx_formatter_pcm_new,
 };
 